@@ -0,0 +1,440 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "adcBuffer.h"
+
+#ifndef ZYBO_BOARD
+#include <pthread.h>
+#include <sched.h>
+
+#include "benchmark.h"
+#endif
+
+// Returns the smallest power of two that is >= value.
+static uint32_t adcBuffer_roundUpToPowerOfTwo(uint32_t value) {
+  uint32_t powerOfTwo = 1;
+  while (powerOfTwo < value)
+    powerOfTwo <<= 1;
+  return powerOfTwo;
+}
+
+// Returns the base-2 logarithm of a power of two.
+static uint32_t adcBuffer_log2(uint32_t powerOfTwo) {
+  uint32_t log2 = 0;
+  while (powerOfTwo >>= 1)
+    log2++;
+  return log2;
+}
+
+// Allocates storage for at least size values (rounded up to a power of two),
+// empties the buffer, clears the statistics and removes the watermark.
+void adcBuffer_init(adcBuffer_t *b, uint32_t size) {
+  uint32_t storageSize = adcBuffer_roundUpToPowerOfTwo(size);
+  b->data = (isr_AdcValue_t *)malloc(storageSize * sizeof(isr_AdcValue_t));
+  if (b->data == NULL) {
+    printf("adcBuffer_init(): malloc() failed.\n");
+    assert(false);
+  }
+  b->mask = storageSize - 1;
+  atomic_init(&b->head, 0);
+  atomic_init(&b->tail, 0);
+  // Small buffers get one bin per value, the rest bins of equal width.
+  uint32_t storageLog2 = adcBuffer_log2(storageSize);
+  uint32_t binLog2 = adcBuffer_log2(ADC_BUFFER_OCCUPANCY_BIN_COUNT);
+  b->occupancyShift = storageLog2 > binLog2 ? storageLog2 - binLog2 : 0;
+  adcBuffer_resetStatistics(b);
+  adcBuffer_setWatermark(b, 0, NULL);
+}
+
+// Producer only. Counts the occupancy the push found (count, before the push)
+// and whether it was dropped, raises the high-water mark and calls the
+// watermark callback on a crossing. The counters are only written here, so
+// relaxed loads and stores are enough.
+static void adcBuffer_recordPush(adcBuffer_t *b, uint32_t count,
+                                 bool dropped) {
+  uint32_t bin = count >> b->occupancyShift;
+  if (bin >= ADC_BUFFER_OCCUPANCY_BIN_COUNT) // Full.
+    bin = ADC_BUFFER_OCCUPANCY_BIN_COUNT - 1;
+  atomic_store_explicit(
+      &b->occupancyTicks[bin],
+      atomic_load_explicit(&b->occupancyTicks[bin], memory_order_relaxed) + 1,
+      memory_order_relaxed);
+  if (dropped)
+    atomic_store_explicit(
+        &b->droppedCount,
+        atomic_load_explicit(&b->droppedCount, memory_order_relaxed) + 1,
+        memory_order_relaxed);
+  else
+    count++; // The value just pushed.
+  if (count > atomic_load_explicit(&b->highWaterMark, memory_order_relaxed))
+    atomic_store_explicit(&b->highWaterMark, count, memory_order_relaxed);
+  if (b->watermark) {
+    bool above = count >= b->watermark;
+    if (above != b->aboveWatermark) {
+      b->aboveWatermark = above;
+      b->watermarkCallback(above);
+    }
+  }
+}
+
+// Producer only. The value is written before head is published (release), so
+// the consumer never sees the new head without the value.
+bool adcBuffer_push(adcBuffer_t *b, isr_AdcValue_t value) {
+  uint32_t head = atomic_load_explicit(&b->head, memory_order_relaxed);
+  uint32_t tail = atomic_load_explicit(&b->tail, memory_order_acquire);
+  if (head - tail > b->mask) { // Full.
+    adcBuffer_recordPush(b, head - tail, true);
+    return false;
+  }
+  b->data[head & b->mask] = value;
+  atomic_store_explicit(&b->head, head + 1, memory_order_release);
+  adcBuffer_recordPush(b, head - tail, false);
+  return true;
+}
+
+// Consumer only. The value is read before tail is published (release), so the
+// producer never overwrites a slot that is still being read.
+bool adcBuffer_pop(adcBuffer_t *b, isr_AdcValue_t *value) {
+  uint32_t tail = atomic_load_explicit(&b->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+  if (head == tail) // Empty.
+    return false;
+  *value = b->data[tail & b->mask];
+  atomic_store_explicit(&b->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+// Consumer only. The values up to the end of the storage are copied first,
+// then the rest from the start. tail is published once, after both copies.
+uint32_t adcBuffer_popN(adcBuffer_t *b, isr_AdcValue_t values[],
+                        uint32_t maxCount) {
+  uint32_t tail = atomic_load_explicit(&b->tail, memory_order_relaxed);
+  uint32_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+  uint32_t count = head - tail;
+  if (count > maxCount)
+    count = maxCount;
+  if (count == 0)
+    return 0;
+  uint32_t start = tail & b->mask;
+  uint32_t lengthToEnd = b->mask + 1 - start;
+  uint32_t firstCount = (count < lengthToEnd) ? count : lengthToEnd;
+  memcpy(values, &b->data[start], firstCount * sizeof(isr_AdcValue_t));
+  memcpy(&values[firstCount], b->data,
+         (count - firstCount) * sizeof(isr_AdcValue_t));
+  atomic_store_explicit(&b->tail, tail + count, memory_order_release);
+  return count;
+}
+
+// Returns the number of values in the buffer.
+uint32_t adcBuffer_elementCount(adcBuffer_t *b) {
+  uint32_t tail = atomic_load_explicit(&b->tail, memory_order_acquire);
+  uint32_t head = atomic_load_explicit(&b->head, memory_order_acquire);
+  return head - tail;
+}
+
+// Returns the capacity of the buffer.
+uint32_t adcBuffer_size(adcBuffer_t *b) { return b->mask + 1; }
+
+// Returns the most values that were ever in the buffer.
+uint32_t adcBuffer_getHighWaterMark(adcBuffer_t *b) {
+  return atomic_load_explicit(&b->highWaterMark, memory_order_relaxed);
+}
+
+// Returns the number of values dropped because the buffer was full.
+uint32_t adcBuffer_getDroppedCount(adcBuffer_t *b) {
+  return atomic_load_explicit(&b->droppedCount, memory_order_relaxed);
+}
+
+// Returns the number of pushes that found the occupancy in bin.
+uint32_t adcBuffer_getOccupancyTicks(adcBuffer_t *b, uint16_t bin) {
+  return atomic_load_explicit(&b->occupancyTicks[bin], memory_order_relaxed);
+}
+
+// Clears the high-water mark, the dropped count and the occupancy histogram.
+void adcBuffer_resetStatistics(adcBuffer_t *b) {
+  atomic_store(&b->highWaterMark, 0);
+  atomic_store(&b->droppedCount, 0);
+  for (uint16_t bin = 0; bin < ADC_BUFFER_OCCUPANCY_BIN_COUNT; bin++)
+    atomic_store(&b->occupancyTicks[bin], 0);
+}
+
+// Installs or removes the watermark callback.
+void adcBuffer_setWatermark(adcBuffer_t *b, uint32_t watermark,
+                            adcBuffer_watermarkCallback_t callback) {
+  b->watermark = callback != NULL ? watermark : 0;
+  b->watermarkCallback = callback;
+  b->aboveWatermark = false;
+}
+
+// Frees the storage allocated by adcBuffer_init().
+void adcBuffer_garbageCollect(adcBuffer_t *b) {
+  free(b->data);
+  b->data = NULL;
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define ADC_BUFFER_TEST_SIZE 100 // Rounded up to 128.
+#define ADC_BUFFER_TEST_POPN_PUSH_COUNT 37 // Not a divisor of 128, so it wraps.
+#define ADC_BUFFER_TEST_POPN_ROUND_COUNT 10
+#define ADC_BUFFER_TEST_WRAP_START                                             \
+  (UINT32_MAX - 10) // Counters start here so they wrap during the test.
+
+// Single-threaded checks: capacity, full/empty, ordering, and that the
+// element count is correct while the head/tail counters wrap past 2^32.
+static bool adcBuffer_basicTest() {
+  bool testResult = true;
+  adcBuffer_t b;
+  adcBuffer_init(&b, ADC_BUFFER_TEST_SIZE);
+  atomic_store(&b.head, ADC_BUFFER_TEST_WRAP_START);
+  atomic_store(&b.tail, ADC_BUFFER_TEST_WRAP_START);
+  isr_AdcValue_t value;
+  if (adcBuffer_pop(&b, &value)) {
+    printf("* Error: adcBuffer_pop() succeeded on an empty buffer.\n");
+    testResult = false;
+  }
+  uint32_t size = adcBuffer_size(&b);
+  for (uint32_t i = 0; i < size; i++) {
+    if (!adcBuffer_push(&b, i) || adcBuffer_elementCount(&b) != i + 1) {
+      printf("* Error: adcBuffer_push(%u) failed or count is wrong.\n", i);
+      testResult = false;
+    }
+  }
+  if (adcBuffer_push(&b, size)) {
+    printf("* Error: adcBuffer_push() succeeded on a full buffer.\n");
+    testResult = false;
+  }
+  for (uint32_t i = 0; i < size; i++) {
+    if (!adcBuffer_pop(&b, &value) || value != i) {
+      printf("* Error: adcBuffer_pop() returned %u, should be %u.\n", value,
+             i);
+      testResult = false;
+      break;
+    }
+  }
+  // Bulk pops that wrap around the end of the storage.
+  isr_AdcValue_t values[ADC_BUFFER_TEST_SIZE];
+  uint32_t next = 0; // Next value expected from adcBuffer_popN().
+  for (uint32_t round = 0; round < ADC_BUFFER_TEST_POPN_ROUND_COUNT; round++) {
+    for (uint32_t i = 0; i < ADC_BUFFER_TEST_POPN_PUSH_COUNT; i++)
+      adcBuffer_push(&b, next + i);
+    uint32_t count = adcBuffer_popN(&b, values, ADC_BUFFER_TEST_SIZE);
+    if (count != ADC_BUFFER_TEST_POPN_PUSH_COUNT) {
+      printf("* Error: adcBuffer_popN() returned %u values, should be %u.\n",
+             count, ADC_BUFFER_TEST_POPN_PUSH_COUNT);
+      testResult = false;
+      break;
+    }
+    for (uint32_t i = 0; i < count; i++, next++) {
+      if (values[i] != next) {
+        printf("* Error: adcBuffer_popN() value %u is %u, should be %u.\n", i,
+               values[i], next);
+        testResult = false;
+      }
+    }
+  }
+  if (adcBuffer_popN(&b, values, ADC_BUFFER_TEST_SIZE) != 0) {
+    printf("* Error: adcBuffer_popN() returned values from an empty buffer.\n");
+    testResult = false;
+  }
+  if (adcBuffer_elementCount(&b) != 0) {
+    printf("* Error: adcBuffer_elementCount() is %u, should be 0.\n",
+           adcBuffer_elementCount(&b));
+    testResult = false;
+  }
+  adcBuffer_garbageCollect(&b);
+  return testResult;
+}
+
+#define ADC_BUFFER_TEST_DROP_COUNT 3 // Pushes into the full buffer.
+#define ADC_BUFFER_TEST_WATERMARK 64 // Half of 128.
+#define ADC_BUFFER_TEST_POP_COUNT 100
+#define ADC_BUFFER_TEST_MAX_CROSSING_COUNT 4
+
+// Crossings reported to adcBuffer_testWatermarkCallback().
+static bool adcBuffer_testCrossings[ADC_BUFFER_TEST_MAX_CROSSING_COUNT];
+static uint32_t adcBuffer_testCrossingCount;
+
+static void adcBuffer_testWatermarkCallback(bool above) {
+  if (adcBuffer_testCrossingCount < ADC_BUFFER_TEST_MAX_CROSSING_COUNT)
+    adcBuffer_testCrossings[adcBuffer_testCrossingCount] = above;
+  adcBuffer_testCrossingCount++;
+}
+
+// Fills the buffer, pushes ADC_BUFFER_TEST_DROP_COUNT more values that are
+// dropped, then drains it below the watermark. Checks the high-water mark,
+// the dropped count, the occupancy histogram (each bin of 16 counted once per
+// occupancy in it, plus the drops in the last bin) and that the watermark
+// callback saw exactly one rising and one falling crossing.
+static bool adcBuffer_statisticsTest() {
+  bool testResult = true;
+  adcBuffer_t b;
+  adcBuffer_init(&b, ADC_BUFFER_TEST_SIZE);
+  adcBuffer_testCrossingCount = 0;
+  adcBuffer_setWatermark(&b, ADC_BUFFER_TEST_WATERMARK,
+                         adcBuffer_testWatermarkCallback);
+  uint32_t size = adcBuffer_size(&b);
+  for (uint32_t i = 0; i < size + ADC_BUFFER_TEST_DROP_COUNT; i++)
+    adcBuffer_push(&b, i);
+  isr_AdcValue_t values[ADC_BUFFER_TEST_POP_COUNT];
+  adcBuffer_popN(&b, values, ADC_BUFFER_TEST_POP_COUNT);
+  adcBuffer_push(&b, 0); // Finds the buffer below the watermark.
+  if (adcBuffer_getHighWaterMark(&b) != size ||
+      adcBuffer_getDroppedCount(&b) != ADC_BUFFER_TEST_DROP_COUNT) {
+    printf("* Error: high-water mark %u and dropped count %u, should be %u "
+           "and %u.\n",
+           adcBuffer_getHighWaterMark(&b), adcBuffer_getDroppedCount(&b), size,
+           ADC_BUFFER_TEST_DROP_COUNT);
+    testResult = false;
+  }
+  uint32_t binWidth = size / ADC_BUFFER_OCCUPANCY_BIN_COUNT;
+  for (uint16_t bin = 0; bin < ADC_BUFFER_OCCUPANCY_BIN_COUNT; bin++) {
+    uint32_t expected = binWidth;
+    if (bin == ADC_BUFFER_OCCUPANCY_BIN_COUNT - 1)
+      expected += ADC_BUFFER_TEST_DROP_COUNT;
+    else if (bin == (size - ADC_BUFFER_TEST_POP_COUNT) / binWidth)
+      expected++; // The last push.
+    if (adcBuffer_getOccupancyTicks(&b, bin) != expected) {
+      printf("* Error: occupancy bin %u has %u ticks, should be %u.\n", bin,
+             adcBuffer_getOccupancyTicks(&b, bin), expected);
+      testResult = false;
+    }
+  }
+  if (adcBuffer_testCrossingCount != 2 || !adcBuffer_testCrossings[0] ||
+      adcBuffer_testCrossings[1]) {
+    printf("* Error: the watermark callback was called %u times, should be 2 "
+           "(above, then below).\n",
+           adcBuffer_testCrossingCount);
+    testResult = false;
+  }
+  adcBuffer_resetStatistics(&b);
+  if (adcBuffer_getHighWaterMark(&b) || adcBuffer_getDroppedCount(&b) ||
+      adcBuffer_getOccupancyTicks(&b, 0)) {
+    printf("* Error: adcBuffer_resetStatistics() did not clear them.\n");
+    testResult = false;
+  }
+  adcBuffer_garbageCollect(&b);
+  return testResult;
+}
+
+#ifndef ZYBO_BOARD
+#define ADC_BUFFER_STRESS_TEST_SIZE 1000 // Same order as the detector buffer.
+#define ADC_BUFFER_STRESS_TEST_VALUE_COUNT 100000 // One second of samples.
+#define ADC_BUFFER_STRESS_TEST_BATCH_SIZE 64 // Values per pop round.
+#define ADC_BUFFER_STRESS_TEST_SAMPLE_PERIOD_NS                                \
+  10000.0 // 100 kHz, the ISR rate.
+
+// Shared between the producer thread and the consumer.
+static adcBuffer_t adcBuffer_stressBuffer;
+static _Atomic uint32_t adcBuffer_stressDroppedCount; // Buffer was full.
+static _Atomic bool adcBuffer_stressProducerDone; // Producer has finished.
+
+// Producer thread: pushes 0, 1, 2, ... at a fixed rate, like isr_function().
+// The next push time is computed from the start time so rate errors do not
+// accumulate.
+static void *adcBuffer_stressProducer(void *arg) {
+  (void)arg;
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t i = 0; i < ADC_BUFFER_STRESS_TEST_VALUE_COUNT; i++) {
+    double due = i * ADC_BUFFER_STRESS_TEST_SAMPLE_PERIOD_NS;
+    while (benchmark_elapsedNanoseconds(start, benchmark_now()) < due)
+      sched_yield(); // Let the consumer run if there is only one core.
+    if (!adcBuffer_push(&adcBuffer_stressBuffer, i))
+      atomic_fetch_add(&adcBuffer_stressDroppedCount, 1);
+  }
+  atomic_store(&adcBuffer_stressProducerDone, true);
+  return NULL;
+}
+
+// Runs the producer thread against a consumer on this thread. Every popped
+// value (single or bulk pop) must be exactly one more than the previous one
+// (no loss, duplicate or reordering) and the producer must never find the
+// buffer full.
+static bool adcBuffer_stressTest() {
+  bool testResult = true;
+  adcBuffer_init(&adcBuffer_stressBuffer, ADC_BUFFER_STRESS_TEST_SIZE);
+  atomic_store(&adcBuffer_stressDroppedCount, 0);
+  atomic_store(&adcBuffer_stressProducerDone, false);
+  pthread_t producer;
+  if (pthread_create(&producer, NULL, adcBuffer_stressProducer, NULL)) {
+    printf("* Error: pthread_create() failed.\n");
+    adcBuffer_garbageCollect(&adcBuffer_stressBuffer);
+    return false;
+  }
+  uint32_t expected = 0;
+  uint32_t maxElementCount = 0;
+  uint32_t iteration = 0;
+  // Stop once the producer is done and everything it pushed has been popped.
+  while (!atomic_load(&adcBuffer_stressProducerDone) ||
+         adcBuffer_elementCount(&adcBuffer_stressBuffer)) {
+    uint32_t count = adcBuffer_elementCount(&adcBuffer_stressBuffer);
+    maxElementCount = (count > maxElementCount) ? count : maxElementCount;
+    // Alternate between single pops and bulk pops.
+    isr_AdcValue_t values[ADC_BUFFER_STRESS_TEST_BATCH_SIZE];
+    uint32_t popCount = 0;
+    if (iteration++ & 1)
+      popCount = adcBuffer_popN(&adcBuffer_stressBuffer, values,
+                             ADC_BUFFER_STRESS_TEST_BATCH_SIZE);
+    else
+      while (popCount < ADC_BUFFER_STRESS_TEST_BATCH_SIZE &&
+             adcBuffer_pop(&adcBuffer_stressBuffer, &values[popCount]))
+        popCount++;
+    for (uint32_t i = 0; i < popCount; i++) {
+      if (values[i] != expected) {
+        printf("* Error: adcBuffer_pop() returned %u, should be %u.\n",
+               values[i], expected);
+        testResult = false;
+      }
+      expected = values[i] + 1;
+    }
+    if (popCount < ADC_BUFFER_STRESS_TEST_BATCH_SIZE)
+      sched_yield(); // Buffer is empty, let the producer run.
+  }
+  pthread_join(producer, NULL);
+  if (atomic_load(&adcBuffer_stressDroppedCount)) {
+    printf("* Error: the producer dropped %u values (buffer full).\n",
+           atomic_load(&adcBuffer_stressDroppedCount));
+    testResult = false;
+  }
+  if (expected != ADC_BUFFER_STRESS_TEST_VALUE_COUNT) {
+    printf("* Error: consumer received %u values, should be %u.\n", expected,
+           ADC_BUFFER_STRESS_TEST_VALUE_COUNT);
+    testResult = false;
+  }
+  printf("=== ADC buffer stress test: %u values, max element count %u.\n",
+         expected, maxElementCount);
+  adcBuffer_garbageCollect(&adcBuffer_stressBuffer);
+  return testResult;
+}
+#endif
+
+// Runs the single-threaded tests and, on the host, the pthread stress test.
+bool adcBuffer_runTest() {
+  bool testResult = true;
+  bool tempResult = adcBuffer_basicTest();
+  printf("=== ADC buffer basic test %s.\n", tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  tempResult = adcBuffer_statisticsTest();
+  printf("=== ADC buffer statistics test %s.\n",
+         tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+#ifndef ZYBO_BOARD
+  tempResult = adcBuffer_stressTest();
+  printf("=== ADC buffer stress test %s.\n", tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+#endif
+  return testResult;
+}
@@ -0,0 +1,128 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef ADCBUFFER_H_
+#define ADCBUFFER_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "isr.h" // isr_AdcValue_t
+
+// A wait-free single-producer/single-consumer ring buffer for ADC values.
+// isr_function() (the producer) calls adcBuffer_push() and detector() (the
+// consumer) calls adcBuffer_pop(). Neither side ever blocks or needs to
+// disable interrupts: the producer only writes head, the consumer only writes
+// tail, and each side publishes its counter with a release store that the
+// other side reads with an acquire load.
+//
+// head and tail are free-running counts of the values pushed and popped. They
+// are never wrapped, so head - tail is the element count (also across the
+// 2^32 wrap-around) and every value has a unique sequence number.
+//
+// Only one context may push and only one context may pop. All other functions
+// may be called from either side.
+//
+// The producer also keeps statistics, so a backlog shows up while it builds
+// rather than as a single number at the end of a run: the high-water mark,
+// the number of values dropped because the buffer was full, and an occupancy
+// histogram. Each push counts one tick in the bin of the occupancy it found,
+// so at 100 kHz the bins tell how long the buffer spent at each fill level.
+// The bins split the capacity into ADC_BUFFER_OCCUPANCY_BIN_COUNT equal
+// ranges; a full buffer counts in the last bin. Only the producer writes the
+// statistics, with relaxed atomic loads and stores (no read-modify-write), so
+// they cost no locking either and the consumer never reads a torn value.
+//
+// adcBuffer_setWatermark() installs a callback that the producer calls when
+// the occupancy reaches the watermark and again when a push finds it below.
+// It runs in the producer's context (the ISR), so it should only set a flag
+// that the main loop acts on, e.g., to skip a histogram redraw and catch up.
+
+#define ADC_BUFFER_OCCUPANCY_BIN_COUNT 8 // 0-12.5%, 12.5-25%, ... 87.5-100%.
+
+// Called by the producer when the occupancy crosses the watermark; above is
+// true when it reached the watermark and false when it fell below again.
+typedef void (*adcBuffer_watermarkCallback_t)(bool above);
+
+typedef struct adcBuffer {
+  _Atomic uint32_t head; // Number of values pushed so far (producer writes).
+  _Atomic uint32_t tail; // Number of values popped so far (consumer writes).
+  uint32_t mask;         // Storage size - 1, the storage is a power of two.
+  isr_AdcValue_t *data;  // Storage for the values.
+  // Statistics, written only by the producer.
+  _Atomic uint32_t highWaterMark; // Most values ever in the buffer.
+  _Atomic uint32_t droppedCount;  // Values dropped because it was full.
+  _Atomic uint32_t occupancyTicks[ADC_BUFFER_OCCUPANCY_BIN_COUNT];
+  uint32_t occupancyShift; // Occupancy >> occupancyShift is the bin.
+  uint32_t watermark;      // 0 means no watermark.
+  bool aboveWatermark;
+  adcBuffer_watermarkCallback_t watermarkCallback;
+} adcBuffer_t;
+
+// Allocates storage for at least size values (rounded up to a power of two),
+// empties the buffer, clears the statistics and removes the watermark. Prints
+// an error message and calls assert(false) if malloc() fails. Not thread-safe;
+// call before the ISR starts.
+void adcBuffer_init(adcBuffer_t *b, uint32_t size);
+
+// Producer only. Adds value to the buffer. Returns false (and drops value) if
+// the buffer is full. Updates the statistics and calls the watermark callback
+// if the occupancy crossed the watermark.
+bool adcBuffer_push(adcBuffer_t *b, isr_AdcValue_t value);
+
+// Consumer only. Removes the oldest value and stores it in *value. Returns
+// false (and leaves *value alone) if the buffer is empty.
+bool adcBuffer_pop(adcBuffer_t *b, isr_AdcValue_t *value);
+
+// Consumer only. Removes up to maxCount of the oldest values and copies them to
+// values, oldest first, with at most two memcpy() calls and a single release
+// of tail. Returns the number of values copied (0 if the buffer is empty).
+uint32_t adcBuffer_popN(adcBuffer_t *b, isr_AdcValue_t values[],
+                        uint32_t maxCount);
+
+// Returns the number of values in the buffer. The result is exact when called
+// from the producer or consumer, and a snapshot when called from elsewhere.
+uint32_t adcBuffer_elementCount(adcBuffer_t *b);
+
+// Returns the capacity of the buffer.
+uint32_t adcBuffer_size(adcBuffer_t *b);
+
+// Returns the most values that were ever in the buffer.
+uint32_t adcBuffer_getHighWaterMark(adcBuffer_t *b);
+
+// Returns the number of values dropped because the buffer was full.
+uint32_t adcBuffer_getDroppedCount(adcBuffer_t *b);
+
+// Returns the number of pushes that found the occupancy in bin, i.e., between
+// bin and bin + 1 times adcBuffer_size() / ADC_BUFFER_OCCUPANCY_BIN_COUNT.
+uint32_t adcBuffer_getOccupancyTicks(adcBuffer_t *b, uint16_t bin);
+
+// Clears the high-water mark, the dropped count and the occupancy histogram.
+// Call it while the producer is stopped, or a push may be lost from the
+// statistics.
+void adcBuffer_resetStatistics(adcBuffer_t *b);
+
+// Calls callback when the occupancy reaches watermark values and when it falls
+// below again (see above). A watermark of 0 or a NULL callback removes it. Not
+// thread-safe; call while the producer is stopped.
+void adcBuffer_setWatermark(adcBuffer_t *b, uint32_t watermark,
+                            adcBuffer_watermarkCallback_t callback);
+
+// Frees the storage allocated by adcBuffer_init().
+void adcBuffer_garbageCollect(adcBuffer_t *b);
+
+// Checks push/pop, popN, full/empty, counter wrap-around, the statistics and
+// the watermark callback. On the host (emulator) build it also runs a pthread
+// stress test: a producer thread pushes sequence numbers at a fixed rate while
+// the consumer drains them, and the test checks that no value is lost,
+// duplicated or reordered. Returns true if all tests pass.
+bool adcBuffer_runTest();
+
+#endif /* ADCBUFFER_H_ */
@@ -0,0 +1,225 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "adcCapture.h"
+
+#define ADC_CAPTURE_TEST_MAX_COUNT 64 // Every count up to this one is tested.
+#define ADC_CAPTURE_TEST_SAMPLE_RATE 100000
+#define ADC_CAPTURE_TEST_FIRST_SAMPLE_INDEX 0x123456789ULL // Needs > 32 bits.
+#define ADC_CAPTURE_TEST_TIMESTAMP 0xFEDCBA987ULL
+
+// Writes count bytes of value, least-significant byte first.
+static void adcCapture_putLittleEndian(uint8_t bytes[], uint64_t value,
+                                       uint8_t count) {
+  for (uint8_t i = 0; i < count; i++)
+    bytes[i] = (uint8_t)(value >> (8 * i));
+}
+
+// Reads count bytes, least-significant byte first.
+static uint64_t adcCapture_getLittleEndian(const uint8_t bytes[],
+                                           uint8_t count) {
+  uint64_t value = 0;
+  for (uint8_t i = 0; i < count; i++)
+    value |= (uint64_t)bytes[i] << (8 * i);
+  return value;
+}
+
+// Packs the low 12 bits of count values, two values per three bytes.
+uint32_t adcCapture_pack(const isr_AdcValue_t values[], uint32_t count,
+                         uint8_t bytes[]) {
+  uint32_t i = 0;
+  uint8_t *out = bytes;
+  for (; i + 1 < count; i += 2) {
+    uint32_t first = values[i] & ADC_CAPTURE_SAMPLE_MASK;
+    uint32_t second = values[i + 1] & ADC_CAPTURE_SAMPLE_MASK;
+    *out++ = (uint8_t)first;
+    *out++ = (uint8_t)((first >> 8) | (second << 4));
+    *out++ = (uint8_t)(second >> 4);
+  }
+  if (i < count) { // Odd last value.
+    uint32_t last = values[i] & ADC_CAPTURE_SAMPLE_MASK;
+    *out++ = (uint8_t)last;
+    *out++ = (uint8_t)(last >> 8);
+  }
+  return (uint32_t)(out - bytes);
+}
+
+// Unpacks count values packed by adcCapture_pack().
+void adcCapture_unpack(const uint8_t bytes[], uint32_t count,
+                       isr_AdcValue_t values[]) {
+  uint32_t i = 0;
+  const uint8_t *in = bytes;
+  for (; i + 1 < count; i += 2, in += 3) {
+    values[i] = in[0] | ((in[1] & 0x0F) << 8);
+    values[i + 1] = (in[1] >> 4) | (in[2] << 4);
+  }
+  if (i < count)
+    values[i] = in[0] | ((in[1] & 0x0F) << 8);
+}
+
+// Writes the magic, the sample rate and the sample width.
+uint32_t adcCapture_encodeHeader(uint8_t bytes[], uint32_t sampleRateHz) {
+  memcpy(bytes, ADC_CAPTURE_MAGIC, ADC_CAPTURE_MAGIC_LENGTH);
+  adcCapture_putLittleEndian(&bytes[8], sampleRateHz, 4);
+  adcCapture_putLittleEndian(&bytes[12], ADC_CAPTURE_SAMPLE_BITS, 4);
+  return ADC_CAPTURE_HEADER_LENGTH;
+}
+
+// Checks the magic and the sample width, then returns the sample rate.
+bool adcCapture_decodeHeader(const uint8_t bytes[], uint32_t *sampleRateHz) {
+  if (memcmp(bytes, ADC_CAPTURE_MAGIC, ADC_CAPTURE_MAGIC_LENGTH) != 0 ||
+      adcCapture_getLittleEndian(&bytes[12], 4) != ADC_CAPTURE_SAMPLE_BITS)
+    return false;
+  *sampleRateHz = (uint32_t)adcCapture_getLittleEndian(&bytes[8], 4);
+  return true;
+}
+
+// Writes the block header followed by the packed samples.
+uint32_t adcCapture_encodeBlock(uint8_t bytes[],
+                                const adcCapture_block_t *block) {
+  adcCapture_putLittleEndian(&bytes[0], block->firstSampleIndex, 8);
+  adcCapture_putLittleEndian(&bytes[8], block->timestampMicroseconds, 8);
+  adcCapture_putLittleEndian(&bytes[16], block->sampleCount, 2);
+  return ADC_CAPTURE_BLOCK_HEADER_LENGTH +
+         adcCapture_pack(block->samples, block->sampleCount,
+                         &bytes[ADC_CAPTURE_BLOCK_HEADER_LENGTH]);
+}
+
+// Reads the block header, checks the sample count and unpacks the samples.
+bool adcCapture_decodeBlock(const uint8_t bytes[], adcCapture_block_t *block) {
+  block->firstSampleIndex = adcCapture_getLittleEndian(&bytes[0], 8);
+  block->timestampMicroseconds = adcCapture_getLittleEndian(&bytes[8], 8);
+  block->sampleCount = (uint16_t)adcCapture_getLittleEndian(&bytes[16], 2);
+  if (block->sampleCount > ADC_CAPTURE_BLOCK_MAX_SAMPLES)
+    return false;
+  adcCapture_unpack(&bytes[ADC_CAPTURE_BLOCK_HEADER_LENGTH], block->sampleCount,
+                    block->samples);
+  return true;
+}
+
+// Slides over the file one byte at a time until the magic is found, then reads
+// and checks the rest of the header.
+bool adcCapture_readHeader(FILE *file, uint32_t *sampleRateHz) {
+  uint8_t bytes[ADC_CAPTURE_HEADER_LENGTH];
+  if (fread(bytes, 1, ADC_CAPTURE_MAGIC_LENGTH, file) !=
+      ADC_CAPTURE_MAGIC_LENGTH)
+    return false;
+  while (memcmp(bytes, ADC_CAPTURE_MAGIC, ADC_CAPTURE_MAGIC_LENGTH) != 0) {
+    int c = fgetc(file);
+    if (c == EOF)
+      return false;
+    memmove(bytes, &bytes[1], ADC_CAPTURE_MAGIC_LENGTH - 1);
+    bytes[ADC_CAPTURE_MAGIC_LENGTH - 1] = (uint8_t)c;
+  }
+  uint32_t restLength = ADC_CAPTURE_HEADER_LENGTH - ADC_CAPTURE_MAGIC_LENGTH;
+  if (fread(&bytes[ADC_CAPTURE_MAGIC_LENGTH], 1, restLength, file) !=
+      restLength)
+    return false;
+  return adcCapture_decodeHeader(bytes, sampleRateHz);
+}
+
+// Reads the block header first to learn how many packed bytes follow.
+bool adcCapture_readBlock(FILE *file, adcCapture_block_t *block) {
+  static uint8_t bytes[ADC_CAPTURE_BLOCK_MAX_LENGTH];
+  if (fread(bytes, 1, ADC_CAPTURE_BLOCK_HEADER_LENGTH, file) !=
+      ADC_CAPTURE_BLOCK_HEADER_LENGTH)
+    return false;
+  uint32_t sampleCount = (uint32_t)adcCapture_getLittleEndian(&bytes[16], 2);
+  if (sampleCount > ADC_CAPTURE_BLOCK_MAX_SAMPLES)
+    return false;
+  uint32_t packedLength = adcCapture_packedLength(sampleCount);
+  if (fread(&bytes[ADC_CAPTURE_BLOCK_HEADER_LENGTH], 1, packedLength, file) !=
+      packedLength)
+    return false;
+  return adcCapture_decodeBlock(bytes, block);
+}
+
+// Packs and unpacks random 12-bit values for every count up to
+// ADC_CAPTURE_TEST_MAX_COUNT, checking the packed length and that the bytes
+// after it are untouched.
+static bool adcCapture_packTest() {
+  isr_AdcValue_t values[ADC_CAPTURE_TEST_MAX_COUNT];
+  isr_AdcValue_t unpacked[ADC_CAPTURE_TEST_MAX_COUNT];
+  uint8_t bytes[(3 * ADC_CAPTURE_TEST_MAX_COUNT + 1) / 2 + 1];
+  for (uint32_t count = 0; count <= ADC_CAPTURE_TEST_MAX_COUNT; count++) {
+    for (uint32_t i = 0; i < count; i++)
+      values[i] = rand() & ADC_CAPTURE_SAMPLE_MASK;
+    memset(bytes, 0xA5, sizeof(bytes));
+    uint32_t length = adcCapture_pack(values, count, bytes);
+    if (length != adcCapture_packedLength(count) || bytes[length] != 0xA5) {
+      printf("* Error: %u values packed into %u bytes, should be %u.\n", count,
+             length, adcCapture_packedLength(count));
+      return false;
+    }
+    adcCapture_unpack(bytes, count, unpacked);
+    for (uint32_t i = 0; i < count; i++)
+      if (unpacked[i] != values[i]) {
+        printf("* Error: unpacked value %u of %u is %u, should be %u.\n", i,
+               count, unpacked[i], values[i]);
+        return false;
+      }
+  }
+  return true;
+}
+
+// Encodes and decodes a header and a full block. Bits above the 12th must be
+// dropped.
+static bool adcCapture_encodeTest() {
+  static adcCapture_block_t block, decoded;
+  static uint8_t bytes[ADC_CAPTURE_BLOCK_MAX_LENGTH];
+  uint32_t sampleRateHz = 0;
+  if (adcCapture_encodeHeader(bytes, ADC_CAPTURE_TEST_SAMPLE_RATE) !=
+          ADC_CAPTURE_HEADER_LENGTH ||
+      !adcCapture_decodeHeader(bytes, &sampleRateHz) ||
+      sampleRateHz != ADC_CAPTURE_TEST_SAMPLE_RATE) {
+    printf("* Error: the header did not round-trip.\n");
+    return false;
+  }
+  bytes[0] ^= 1;
+  if (adcCapture_decodeHeader(bytes, &sampleRateHz)) {
+    printf("* Error: a header with a bad magic was accepted.\n");
+    return false;
+  }
+  block.firstSampleIndex = ADC_CAPTURE_TEST_FIRST_SAMPLE_INDEX;
+  block.timestampMicroseconds = ADC_CAPTURE_TEST_TIMESTAMP;
+  block.sampleCount = ADC_CAPTURE_BLOCK_MAX_SAMPLES;
+  for (uint32_t i = 0; i < ADC_CAPTURE_BLOCK_MAX_SAMPLES; i++)
+    block.samples[i] = (isr_AdcValue_t)rand();
+  if (adcCapture_encodeBlock(bytes, &block) !=
+          adcCapture_blockLength(ADC_CAPTURE_BLOCK_MAX_SAMPLES) ||
+      !adcCapture_decodeBlock(bytes, &decoded) ||
+      decoded.firstSampleIndex != block.firstSampleIndex ||
+      decoded.timestampMicroseconds != block.timestampMicroseconds ||
+      decoded.sampleCount != block.sampleCount) {
+    printf("* Error: the block header did not round-trip.\n");
+    return false;
+  }
+  for (uint32_t i = 0; i < ADC_CAPTURE_BLOCK_MAX_SAMPLES; i++)
+    if (decoded.samples[i] != (block.samples[i] & ADC_CAPTURE_SAMPLE_MASK)) {
+      printf("* Error: decoded sample %u is %u, should be %u.\n", i,
+             decoded.samples[i], block.samples[i] & ADC_CAPTURE_SAMPLE_MASK);
+      return false;
+    }
+  return true;
+}
+
+// Runs all of the capture-format tests.
+bool adcCapture_runTest() {
+  bool testResult = true;
+  bool tempResult = adcCapture_packTest();
+  printf("=== ADC capture pack test %s.\n", tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  tempResult = adcCapture_encodeTest();
+  printf("=== ADC capture encode test %s.\n", tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  return testResult;
+}
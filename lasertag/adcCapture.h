@@ -0,0 +1,106 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef ADCCAPTURE_H_
+#define ADCCAPTURE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "isr.h" // isr_AdcValue_t
+
+// Compact binary format for recorded ADC samples, written by
+// runningModes_captureAdcValues() and read by the host replay harness
+// (lasertag/replay). All multi-byte fields are little-endian.
+//
+// File header (ADC_CAPTURE_HEADER_LENGTH bytes):
+//   magic "ADCCAP01" (8), sample rate in Hz (uint32), bits per sample (uint32).
+// Followed by any number of blocks, each one:
+//   index of the first sample since the start of the capture (uint64),
+//   time-stamp of the block in microseconds since the start (uint64),
+//   sample count (uint16), then the samples packed 12 bits each: two samples
+//   in three bytes (low byte of s0, high nibble of s0 | low nibble of s1 << 4,
+//   high byte of s1). An odd last sample takes two bytes.
+// A gap in the sample indices means samples were lost during the capture. At
+// 100 kHz, the packed samples take 150 kB/s instead of 400 kB/s as
+// isr_AdcValue_t.
+// On the board, the capture is sent over the UART byte for byte with
+// outbyte(), not with the stdio functions: the standalone BSP's write() adds a
+// '\r' before every 0x0A byte, and a block cannot be resynchronized once a
+// byte has been added. The header magic is found even if console text comes
+// first, so the serial log can be saved to a file and replayed as is.
+
+#define ADC_CAPTURE_MAGIC "ADCCAP01"
+#define ADC_CAPTURE_MAGIC_LENGTH 8
+#define ADC_CAPTURE_HEADER_LENGTH 16
+#define ADC_CAPTURE_BLOCK_HEADER_LENGTH 18
+#define ADC_CAPTURE_SAMPLE_BITS 12
+#define ADC_CAPTURE_SAMPLE_MASK 0xFFF // Higher bits are not recorded.
+#define ADC_CAPTURE_BLOCK_MAX_SAMPLES 1024
+#define ADC_CAPTURE_BLOCK_MAX_LENGTH                                           \
+  (ADC_CAPTURE_BLOCK_HEADER_LENGTH +                                           \
+   (3 * ADC_CAPTURE_BLOCK_MAX_SAMPLES + 1) / 2)
+
+typedef struct {
+  uint64_t firstSampleIndex;      // Samples since the start of the capture.
+  uint64_t timestampMicroseconds; // Time since the start of the capture.
+  uint16_t sampleCount;
+  isr_AdcValue_t samples[ADC_CAPTURE_BLOCK_MAX_SAMPLES];
+} adcCapture_block_t;
+
+// Returns the number of bytes that sampleCount packed samples take.
+static inline uint32_t adcCapture_packedLength(uint32_t sampleCount) {
+  return (3 * sampleCount + 1) / 2;
+}
+
+// Returns the number of bytes of a block with sampleCount samples.
+static inline uint32_t adcCapture_blockLength(uint32_t sampleCount) {
+  return ADC_CAPTURE_BLOCK_HEADER_LENGTH + adcCapture_packedLength(sampleCount);
+}
+
+// Packs the low 12 bits of count values into bytes and returns the number of
+// bytes written (adcCapture_packedLength(count)).
+uint32_t adcCapture_pack(const isr_AdcValue_t values[], uint32_t count,
+                         uint8_t bytes[]);
+
+// Unpacks count values from bytes.
+void adcCapture_unpack(const uint8_t bytes[], uint32_t count,
+                       isr_AdcValue_t values[]);
+
+// Writes the file header into bytes and returns ADC_CAPTURE_HEADER_LENGTH.
+uint32_t adcCapture_encodeHeader(uint8_t bytes[], uint32_t sampleRateHz);
+
+// Checks the magic and sample width of a file header and returns the sample
+// rate through sampleRateHz. Returns false if it is not a capture header.
+bool adcCapture_decodeHeader(const uint8_t bytes[], uint32_t *sampleRateHz);
+
+// Writes a block into bytes and returns the number of bytes written
+// (adcCapture_blockLength(block->sampleCount)).
+uint32_t adcCapture_encodeBlock(uint8_t bytes[],
+                                const adcCapture_block_t *block);
+
+// Reads a block from bytes. Returns false if the sample count is larger than
+// ADC_CAPTURE_BLOCK_MAX_SAMPLES.
+bool adcCapture_decodeBlock(const uint8_t bytes[], adcCapture_block_t *block);
+
+// Reads and checks the file header. Bytes before the magic (e.g., console text
+// at the start of a serial log) are skipped. Returns false if there is no
+// valid header in the file.
+bool adcCapture_readHeader(FILE *file, uint32_t *sampleRateHz);
+
+// Reads the next block. Returns false at the end of the file or if the block
+// is truncated or malformed.
+bool adcCapture_readBlock(FILE *file, adcCapture_block_t *block);
+
+// Packs and unpacks random values for short odd and even counts and
+// round-trips a header and a full block. Prints the results to the console.
+bool adcCapture_runTest();
+
+#endif /* ADCCAPTURE_H_ */
@@ -0,0 +1,52 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include "benchmark.h"
+
+#ifdef ZYBO_BOARD
+#include "xparameters.h"
+#include "xtime_l.h"
+#define BENCHMARK_TICKS_PER_SECOND ((double)COUNTS_PER_SECOND)
+#else
+#include <time.h>
+#define BENCHMARK_TICKS_PER_SECOND 1.0E9 // clock_gettime() is in nanoseconds.
+#endif
+
+#define NANOSECONDS_PER_SECOND 1.0E9
+
+// Returns the current time-stamp.
+benchmark_timestamp_t benchmark_now() {
+#ifdef ZYBO_BOARD
+  XTime now; // The global timer is 64 bits and runs at half the CPU clock.
+  XTime_GetTime(&now);
+  return now;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((benchmark_timestamp_t)now.tv_sec * NANOSECONDS_PER_SECOND) +
+         now.tv_nsec;
+#endif
+}
+
+// Converts the difference between two time-stamps to nanoseconds.
+double benchmark_elapsedNanoseconds(benchmark_timestamp_t start,
+                                    benchmark_timestamp_t stop) {
+  return (double)(stop - start) *
+         (NANOSECONDS_PER_SECOND / BENCHMARK_TICKS_PER_SECOND);
+}
+
+#ifdef ZYBO_BOARD
+// Converts the difference between two time-stamps to CPU clock cycles.
+double benchmark_elapsedCycles(benchmark_timestamp_t start,
+                               benchmark_timestamp_t stop) {
+  return (double)(stop - start) *
+         ((double)XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ /
+          BENCHMARK_TICKS_PER_SECOND);
+}
+#endif
@@ -0,0 +1,36 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdint.h>
+
+// Light-weight time-stamps for micro-benchmarks. Unlike the interval timers,
+// these do not need to be initialized, do not consume a hardware timer and
+// work the same way on the board and on the host (emulator) build.
+// On the board, time-stamps come from the Cortex-A9 global timer.
+// On the host, time-stamps come from clock_gettime(CLOCK_MONOTONIC).
+
+typedef uint64_t benchmark_timestamp_t;
+
+// Returns the current time-stamp.
+benchmark_timestamp_t benchmark_now();
+
+// Converts the difference between two time-stamps to nanoseconds.
+double benchmark_elapsedNanoseconds(benchmark_timestamp_t start,
+                                    benchmark_timestamp_t stop);
+
+#ifdef ZYBO_BOARD
+// Converts the difference between two time-stamps to CPU clock cycles.
+double benchmark_elapsedCycles(benchmark_timestamp_t start,
+                               benchmark_timestamp_t stop);
+#endif
+
+#endif /* BENCHMARK_H_ */
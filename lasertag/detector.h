@@ -31,12 +31,22 @@ void detector_init(bool ignoredFrequencies[]);
 // 1. disable interrupts.
 // 2. pop the value from the ADC buffer.
 // 3. re-enable interrupts.
+// If the ADC buffer is an adcBuffer_t (see adcBuffer.h), steps 1 and 3 are not
+// needed: the buffer is wait-free for one producer and one consumer, so the
+// detector can drain it while interrupts are running.
 // Ignore hits that are detected on the frequencies specified during
 // detector_init(). Your own frequency (based on the switches) is a good choice
 // to ignore. Assumption: draining the ADC buffer occurs faster than it can
 // fill.
 void detector(bool interruptsCurrentlyEnabled);
 
+// Runs hit detection on the current filter powers: the part of detector() that
+// runs after each decimated sample, once the powers are updated. Used by
+// detectorBatch_run() (see detectorBatch.h), which does the filtering for a
+// whole batch of ADC values itself. Ignored frequencies, ignoreAllHits, the
+// lockout timer and the hit counts apply as in detector().
+void detector_runHitDetection();
+
 // Returns true if a hit was detected.
 bool detector_hitDetected();
 
@@ -56,6 +66,10 @@ void detector_ignoreAllHits(bool flagValue);
 // using a for-loop.
 void detector_getHitCounts(detector_hitCount_t hitArray[]);
 
+// Hit detection compares the maximum band power against the median power
+// times the fudge factor. powerRank.h keeps the band powers sorted between
+// decimated samples (powerRank_updateAll()), so the median and maximum can be
+// read without a full sort each time.
 // Allows the fudge-factor index to be set externally from the detector.
 // The actual values for fudge-factors is stored in an array found in detector.c
 void detector_setFudgeFactorIndex(uint32_t factor);
@@ -0,0 +1,78 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdbool.h>
+
+#include "detector.h"
+#include "detectorBatch.h"
+#include "filter.h"
+#include "isr.h"
+#include "latencyTrace.h"
+#include "profiler.h"
+
+static isr_AdcValue_t detectorBatch_samples[DETECTOR_BATCH_MAX_SIZE];
+static uint16_t detectorBatch_decimationCount; // Samples since the last output.
+static uint64_t detectorBatch_sampleCount;     // Samples since init.
+
+// Resets the decimation count and the sample count.
+void detectorBatch_init() {
+  detectorBatch_decimationCount = 0;
+  detectorBatch_sampleCount = 0;
+}
+
+// Runs the FIR, all IIR filters and all powers for one decimated sample.
+static void detectorBatch_runDecimatedSample() {
+  PROFILER_START(firStart);
+  filter_firFilter();
+  PROFILER_STOP(PROFILER_STAGE_FIR, firStart);
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    PROFILER_START(iirStart);
+    filter_iirFilter(i);
+    PROFILER_STOP(PROFILER_STAGE_IIR_0 + i, iirStart);
+  }
+  PROFILER_START(powerStart);
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    filter_computePower(i, false, false);
+  PROFILER_STOP(PROFILER_STAGE_POWER, powerStart);
+}
+
+// Keeps copying until a copy comes back short of a full batch, i.e., the
+// buffer was drained. The inner loop only scales and adds inputs except at
+// decimation boundaries.
+uint32_t detectorBatch_run(detectorBatch_decimationCallback_t
+                               decimationCallback) {
+  uint32_t total = 0;
+  uint32_t count;
+  do {
+    PROFILER_START(drainStart);
+    count = isr_removeDataFromAdcBufferN(detectorBatch_samples,
+                                         DETECTOR_BATCH_MAX_SIZE);
+    PROFILER_STOP(PROFILER_STAGE_ADC_DRAIN, drainStart);
+    for (uint32_t i = 0; i < count; i++) {
+      filter_addNewInput(detector_getScaledAdcValue(detectorBatch_samples[i]));
+      if (++detectorBatch_decimationCount < FILTER_FIR_DECIMATION_FACTOR)
+        continue;
+      detectorBatch_decimationCount = 0;
+      detectorBatch_runDecimatedSample();
+      PROFILER_START(hitStart);
+      decimationCallback();
+      PROFILER_STOP(PROFILER_STAGE_HIT_DECISION, hitStart);
+#ifdef LATENCY_TRACE_ENABLED
+      if (detector_hitDetected()) // This sample completed the hit.
+        LATENCY_TRACE_HIT_SAMPLE(detectorBatch_sampleCount + total + i);
+#endif
+    }
+    total += count;
+  } while (count == DETECTOR_BATCH_MAX_SIZE);
+  detectorBatch_sampleCount += total;
+  return total;
+}
+
+// Returns the number of samples processed since detectorBatch_init().
+uint64_t detectorBatch_getSampleCount() { return detectorBatch_sampleCount; }
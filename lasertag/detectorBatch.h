@@ -0,0 +1,48 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef DETECTORBATCH_H_
+#define DETECTORBATCH_H_
+
+#include <stdint.h>
+
+// Batched version of the detector's per-sample work. Instead of popping one
+// ADC value per call, detectorBatch_run() copies everything pending in the ADC
+// buffer with isr_removeDataFromAdcBufferN() and runs
+//   scale -> filter_addNewInput() -> (every FILTER_FIR_DECIMATION_FACTOR-th
+//   sample) filter_firFilter() -> filter_iirFilter() -> filter_computePower()
+// over the whole batch in one loop. Hit detection only runs at decimation
+// boundaries, through the callback, so the per-call overhead (function calls,
+// buffer index updates, interrupt handling) is paid once per batch instead of
+// once per sample.
+//
+// No interrupts need to be disabled: the ADC buffer is an adcBuffer_t, so the
+// bulk copy is safe while isr_function() keeps pushing.
+
+#define DETECTOR_BATCH_MAX_SIZE                                                \
+  1024 // Values per bulk copy, about 10 ms of samples.
+
+// Called after the powers are updated at each decimation boundary, e.g.,
+// detector_runHitDetection().
+typedef void (*detectorBatch_decimationCallback_t)();
+
+// Resets the decimation count and the sample count.
+void detectorBatch_init();
+
+// Processes all values that are pending in the ADC buffer, copying up to
+// DETECTOR_BATCH_MAX_SIZE at a time until the buffer is drained. Calls
+// decimationCallback at every decimation boundary. Returns the number of
+// samples processed.
+uint32_t detectorBatch_run(detectorBatch_decimationCallback_t
+                               decimationCallback);
+
+// Returns the number of samples processed since detectorBatch_init().
+uint64_t detectorBatch_getSampleCount();
+
+#endif /* DETECTORBATCH_H_ */
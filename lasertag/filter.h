@@ -36,6 +36,34 @@ static const uint16_t filter_frequencyTickTable[FILTER_FREQUENCY_COUNT] = {
 // 2. The output from the decimating FIR filter is passed through a bank of 10
 // IIR filters. The characteristics of the IIR filter are fixed.
 
+// Uncomment to run the decimating FIR as a polyphase filter (firDecimator.h).
+// filter_addNewInput() then calls firDecimator_addInput() instead of pushing
+// onto xQueue, and filter_firFilter() pushes firDecimator_getOutput() onto
+// yQueue and returns it. The work is spread evenly across inputs instead of
+// all landing on every FILTER_FIR_DECIMATION_FACTOR-th input. filterTest then
+// skips the FIR alignment and arithmetic tests, which need an output after
+// every input.
+//#define FILTER_POLYPHASE_FIR
+
+// Uncomment to run the whole chain (FIR, IIR bank and power) in Q15/Q31
+// fixed point with saturating arithmetic (filterFixed.h). The detector then
+// passes each 12-bit ADC value through filterFixed_adcToQ15() to
+// filterFixed_addNewInput() instead of detector_getScaledAdcValue() and
+// filter_addNewInput(), and reads powers with filterFixed_getPower().
+// filterTest_runFixedPointErrorAnalysis() reports the power error against the
+// double version.
+//#define FILTER_FIXED_POINT
+
+// Uncomment to replace the FIR, the IIR filters and the power computation with
+// a Goertzel filter per player frequency (goertzelBank.h). filter_addNewInput()
+// then calls goertzelBank_addInput(), and the detector runs hit detection each
+// time it returns true (every GOERTZEL_BANK_BLOCK_LENGTH inputs) instead of
+// every FILTER_FIR_DECIMATION_FACTOR inputs. filter_getCurrentPowerValue() and
+// filter_getCurrentPowerValues() return goertzelBank_getPower() and
+// goertzelBank_getPowers(), so detector_hitDetected() and the fudge factors
+// are unchanged. filterTest_runGoertzelTest() compares both back ends.
+//#define FILTER_GOERTZEL
+
 /*******************************************************************************
 ***** Main Filter Functions
 *******************************************************************************/
@@ -54,10 +82,14 @@ void filter_fillQueue(queue_t *q, double fillValue);
 
 // Invokes the FIR-filter. Input is contents of xQueue.
 // Output is returned and is also pushed on to yQueue.
+// Tip: queue_newestSpans() returns xQueue as (at most) two plain arrays so
+// the multiply-accumulate loop does not need queue_readElementAt().
 double filter_firFilter();
 
 // Use this to invoke a single iir filter. Input comes from yQueue.
 // Output is returned and is also pushed onto zQueue[filterNumber].
+// queue_newestSpans() works for the yQueue and zQueue loops as well.
+// To run all 10 filters in one call, see iirBank.h.
 double filter_iirFilter(uint16_t filterNumber);
 
 // Use this to compute the power for values contained in an outputQueue.
@@ -73,6 +105,8 @@ double filter_iirFilter(uint16_t filterNumber);
 // 4. Compute new power as: prev-power - (oldest-value * oldest-value) +
 // (newest-value * newest-value). Note that this function will probably need an
 // array to keep track of these values for each of the 10 output queues.
+// runningPower.h provides an O(1) per-sample accumulator for each band that
+// does the incremental computation and bounds its rounding drift.
 double filter_computePower(uint16_t filterNumber, bool forceComputeFromScratch,
                            bool debugPrint);
 
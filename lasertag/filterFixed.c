@@ -0,0 +1,190 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "filterFixed.h"
+
+#define FILTER_FIXED_Q15_FRACTIONAL_BITS 15
+#define FILTER_FIXED_Q31_FRACTIONAL_BITS 31
+#define FILTER_FIXED_MAX_COEFFICIENT_SHIFT 62 // Keeps 1 << shift in int64_t.
+#define FILTER_FIXED_POWER_SHIFT                                               \
+  (FILTER_FIXED_STATE_FRACTIONAL_BITS -                                        \
+   FILTER_FIXED_POWER_FRACTIONAL_BITS / 2) // Q3.28 to Q2.14.
+#define FILTER_FIXED_POWER_MAX_MAGNITUDE UINT16_MAX // Saturate before squaring.
+#define FILTER_FIXED_POWER_QUEUE_NAME "fixedPowerQ"
+
+// Converts a double in [-1.0, 1.0] to Q15, rounding and saturating.
+filterFixed_q15_t filterFixed_doubleToQ15(double value) {
+  return filterFixed_saturateQ15(
+      (int32_t)lround(value * (1 << FILTER_FIXED_Q15_FRACTIONAL_BITS)));
+}
+
+// Returns the number of fractional bits for a set of coefficients. The sum of
+// the magnitudes is kept below 2^31 so that a full multiply-accumulate against
+// Q3.28 state (|state| < 2^31) stays below 2^62 and cannot overflow int64_t.
+static uint8_t filterFixed_coefficientShift(const double *coefficients,
+                                            uint16_t count) {
+  double magnitudeSum = 0.0;
+  for (uint16_t k = 0; k < count; k++)
+    magnitudeSum += fabs(coefficients[k]);
+  uint8_t shift = 0;
+  while (shift < FILTER_FIXED_MAX_COEFFICIENT_SHIFT &&
+         magnitudeSum * ldexp(1.0, shift + 1) < (double)INT32_MAX)
+    shift++;
+  return shift;
+}
+
+// Quantizes count coefficients with shift fractional bits.
+static void filterFixed_quantize(filterFixed_q31_t *quantized,
+                                 const double *coefficients, uint16_t count,
+                                 uint8_t shift) {
+  for (uint16_t k = 0; k < count; k++)
+    quantized[k] = filterFixed_saturateQ31(
+        (int64_t)llround(ldexp(coefficients[k], shift)));
+}
+
+// Quantizes the coefficients and allocates the FIR history and power windows.
+void filterFixed_init(filterFixed_t *f, const double *firCoefficients,
+                      uint32_t tapCount, uint16_t decimationFactor,
+                      const double *bCoefficients[FILTER_FREQUENCY_COUNT],
+                      const double *aCoefficients[FILTER_FREQUENCY_COUNT],
+                      queue_size_t powerWindowLength) {
+  f->tapCount = tapCount;
+  f->firCoefficients =
+      (filterFixed_q31_t *)malloc(tapCount * sizeof(filterFixed_q31_t));
+  f->firHistory =
+      (filterFixed_q15_t *)calloc(2 * tapCount, sizeof(filterFixed_q15_t));
+  if (f->firCoefficients == NULL || f->firHistory == NULL) {
+    printf("filterFixed_init(): malloc() failed.\n");
+    assert(false);
+  }
+  filterFixed_quantize(f->firCoefficients, firCoefficients, tapCount,
+                       FILTER_FIXED_Q31_FRACTIONAL_BITS);
+  f->firNewest = 0;
+  f->decimationFactor = decimationFactor;
+  f->decimationCount = 0;
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    f->iirBShift[band] = filterFixed_coefficientShift(
+        bCoefficients[band], FILTER_FIXED_IIR_B_COEFFICIENT_COUNT);
+    f->iirAShift[band] = filterFixed_coefficientShift(
+        aCoefficients[band], FILTER_FIXED_IIR_A_COEFFICIENT_COUNT);
+    filterFixed_quantize(f->iirB[band], bCoefficients[band],
+                         FILTER_FIXED_IIR_B_COEFFICIENT_COUNT,
+                         f->iirBShift[band]);
+    filterFixed_quantize(f->iirA[band], aCoefficients[band],
+                         FILTER_FIXED_IIR_A_COEFFICIENT_COUNT,
+                         f->iirAShift[band]);
+    // Quantize what the first word missed with FILTER_FIXED_IIR_A_LOW_BITS more
+    // fractional bits.
+    for (uint16_t k = 0; k < FILTER_FIXED_IIR_A_COEFFICIENT_COUNT; k++)
+      f->iirALow[band][k] = (filterFixed_q31_t)llround(ldexp(
+          aCoefficients[band][k] - ldexp(f->iirA[band][k], -f->iirAShift[band]),
+          f->iirAShift[band] + FILTER_FIXED_IIR_A_LOW_BITS));
+    for (uint16_t k = 0; k < 2 * FILTER_FIXED_IIR_A_COEFFICIENT_COUNT; k++)
+      f->z[band][k] = 0;
+    queue_u32_init(&f->powerWindow[band], powerWindowLength,
+                   FILTER_FIXED_POWER_QUEUE_NAME);
+    f->power[band] = 0;
+  }
+  for (uint16_t k = 0; k < 2 * FILTER_FIXED_IIR_B_COEFFICIENT_COUNT; k++)
+    f->y[k] = 0;
+  f->yNewest = 0;
+  f->zNewest = 0;
+}
+
+// Runs the FIR over the newest tapCount inputs. Q31 * Q15 = Q46, rounded to
+// Q3.28.
+static filterFixed_q31_t filterFixed_firFilter(filterFixed_t *f) {
+  const filterFixed_q15_t *x = &f->firHistory[f->firNewest]; // x[k]: newest-k.
+  int64_t sum = 0;
+  for (uint32_t k = 0; k < f->tapCount; k++)
+    sum += (int64_t)f->firCoefficients[k] * x[k];
+  return filterFixed_saturateQ31(filterFixed_roundingShift(
+      sum, FILTER_FIXED_Q31_FRACTIONAL_BITS + FILTER_FIXED_Q15_FRACTIONAL_BITS -
+               FILTER_FIXED_STATE_FRACTIONAL_BITS));
+}
+
+// Updates the power window of a band with the square of output (Q3.28).
+static void filterFixed_updatePower(filterFixed_t *f, uint16_t band,
+                                    filterFixed_q31_t output) {
+  int64_t magnitude =
+      filterFixed_roundingShift(output, FILTER_FIXED_POWER_SHIFT);
+  magnitude = (magnitude < 0) ? -magnitude : magnitude;
+  if (magnitude > FILTER_FIXED_POWER_MAX_MAGNITUDE)
+    magnitude = FILTER_FIXED_POWER_MAX_MAGNITUDE;
+  uint32_t square = (uint32_t)(magnitude * magnitude);
+  queue_u32_t *window = &f->powerWindow[band];
+  if (queue_u32_full(window))
+    f->power[band] -= queue_u32_readElementAt(window, 0);
+  queue_u32_overwritePush(window, square);
+  f->power[band] += square;
+}
+
+// Adds a new Q15 input; every decimationFactor-th input runs everything else.
+bool filterFixed_addNewInput(filterFixed_t *f, filterFixed_q15_t x) {
+  f->firNewest = f->firNewest ? f->firNewest - 1 : f->tapCount - 1;
+  f->firHistory[f->firNewest] = x;
+  f->firHistory[f->firNewest + f->tapCount] = x;
+  if (++f->decimationCount < f->decimationFactor)
+    return false;
+  f->decimationCount = 0;
+  f->yNewest =
+      f->yNewest ? f->yNewest - 1 : FILTER_FIXED_IIR_B_COEFFICIENT_COUNT - 1;
+  f->y[f->yNewest] = f->y[f->yNewest + FILTER_FIXED_IIR_B_COEFFICIENT_COUNT] =
+      filterFixed_firFilter(f);
+  const filterFixed_q31_t *y = &f->y[f->yNewest]; // y[k]: newest - k.
+  uint16_t zPast = f->zNewest; // z[band][zPast + k]: newest - k.
+  f->zNewest =
+      f->zNewest ? f->zNewest - 1 : FILTER_FIXED_IIR_A_COEFFICIENT_COUNT - 1;
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    int64_t sumB = 0; // Q(28 + iirBShift).
+    for (uint16_t k = 0; k < FILTER_FIXED_IIR_B_COEFFICIENT_COUNT; k++)
+      sumB += (int64_t)f->iirB[band][k] * y[k];
+    int64_t sumA = 0; // Q(28 + iirAShift).
+    int64_t sumALow = 0; // Q(28 + iirAShift + FILTER_FIXED_IIR_A_LOW_BITS).
+    for (uint16_t k = 0; k < FILTER_FIXED_IIR_A_COEFFICIENT_COUNT; k++) {
+      sumA += (int64_t)f->iirA[band][k] * f->z[band][zPast + k];
+      sumALow += (int64_t)f->iirALow[band][k] * f->z[band][zPast + k];
+    }
+    sumA += filterFixed_roundingShift(sumALow, FILTER_FIXED_IIR_A_LOW_BITS);
+    filterFixed_q31_t z = filterFixed_saturateQ31(
+        filterFixed_roundingShift(sumB, f->iirBShift[band]) -
+        filterFixed_roundingShift(sumA, f->iirAShift[band]));
+    f->z[band][f->zNewest] = z;
+    f->z[band][f->zNewest + FILTER_FIXED_IIR_A_COEFFICIENT_COUNT] = z;
+    filterFixed_updatePower(f, band, z);
+  }
+  return true;
+}
+
+// Returns the current power of a band as the sum of squares of the outputs.
+double filterFixed_getPower(filterFixed_t *f, uint16_t filterNumber) {
+  return ldexp((double)f->power[filterNumber],
+               -FILTER_FIXED_POWER_FRACTIONAL_BITS);
+}
+
+// Returns the newest IIR output of a band as a double.
+double filterFixed_getIirOutput(filterFixed_t *f, uint16_t filterNumber) {
+  return ldexp((double)f->z[filterNumber][f->zNewest],
+               -FILTER_FIXED_STATE_FRACTIONAL_BITS);
+}
+
+// Frees the storage allocated by filterFixed_init().
+void filterFixed_garbageCollect(filterFixed_t *f) {
+  free(f->firCoefficients);
+  free(f->firHistory);
+  f->firCoefficients = NULL;
+  f->firHistory = NULL;
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    queue_u32_garbageCollect(&f->powerWindow[band]);
+}
@@ -0,0 +1,152 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef FILTERFIXED_H_
+#define FILTERFIXED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "filter.h" // FILTER_FREQUENCY_COUNT
+#include "isr.h"    // isr_AdcValue_t
+#include "queueTyped.h"
+
+// Fixed-point version of the filter chain: decimating FIR, the bank of IIR
+// bandpass filters and windowed power, with saturating integer arithmetic and
+// no floating point per sample. Selected by FILTER_FIXED_POINT (filter.h).
+//
+// Number formats (Qm.n has m integer bits and n fractional bits):
+// - Input: Q15 (int16_t), full scale is -1.0 to 1.0. 12-bit ADC values are
+//   converted with filterFixed_adcToQ15(), a subtract and a shift.
+// - FIR coefficients: Q31 (int32_t, |h| < 1.0). Products and sums are int64.
+// - FIR output and IIR state: Q3.28 (int32_t), range -8.0 to 8.0, which leaves
+//   headroom for the filter gain.
+// - IIR coefficients: int32_t with a per-filter, per-polynomial number of
+//   fractional bits, chosen by filterFixed_init() so that the sum of the
+//   coefficient magnitudes fits: a whole multiply-accumulate then cannot
+//   overflow int64_t. The A coefficients of a 10th-order bandpass reach ~150
+//   and the B coefficients are ~1e-7, so a single format would lose one or the
+//   other.
+// - The poles of a narrow 10th-order bandpass in direct form are so sensitive
+//   that ~20-bit A coefficients make the filters unstable. Each A coefficient
+//   therefore has a second int32_t word with FILTER_FIXED_IIR_A_LOW_BITS more
+//   fractional bits (~47 bits in total), at the cost of 10 extra multiplies.
+// - Power: each IIR output is rounded to Q2.14, saturated to 16 bits and
+//   squared (uint32_t, Q28). The window sum is uint64_t and is updated by
+//   adding the newest square and subtracting the oldest, which is exact: the
+//   running power never drifts.
+
+#define FILTER_FIXED_Q15_ONE 32768 // 1.0 in Q15 (not representable).
+#define FILTER_FIXED_Q15_MAX INT16_MAX
+#define FILTER_FIXED_Q15_MIN INT16_MIN
+#define FILTER_FIXED_Q31_MAX INT32_MAX
+#define FILTER_FIXED_Q31_MIN INT32_MIN
+#define FILTER_FIXED_STATE_FRACTIONAL_BITS 28 // Q3.28.
+#define FILTER_FIXED_POWER_FRACTIONAL_BITS 28 // Squares of Q2.14 values.
+#define FILTER_FIXED_ADC_BITS 12              // The XADC delivers 12 bits.
+#define FILTER_FIXED_IIR_B_COEFFICIENT_COUNT 11
+#define FILTER_FIXED_IIR_A_COEFFICIENT_COUNT 10 // Without the leading 1.
+#define FILTER_FIXED_IIR_A_LOW_BITS 27 // 10 * 2^27 * 2^31 < 2^63.
+
+typedef int16_t filterFixed_q15_t;
+typedef int32_t filterFixed_q31_t;
+
+// Saturates a value to the Q15 range.
+static inline filterFixed_q15_t filterFixed_saturateQ15(int32_t value) {
+  if (value > FILTER_FIXED_Q15_MAX)
+    return FILTER_FIXED_Q15_MAX;
+  if (value < FILTER_FIXED_Q15_MIN)
+    return FILTER_FIXED_Q15_MIN;
+  return (filterFixed_q15_t)value;
+}
+
+// Saturates a value to the Q31 (int32_t) range.
+static inline filterFixed_q31_t filterFixed_saturateQ31(int64_t value) {
+  if (value > FILTER_FIXED_Q31_MAX)
+    return FILTER_FIXED_Q31_MAX;
+  if (value < FILTER_FIXED_Q31_MIN)
+    return FILTER_FIXED_Q31_MIN;
+  return (filterFixed_q31_t)value;
+}
+
+// Shifts value right by shift bits, rounding to nearest. Returns value
+// unchanged if shift is 0 (e.g., an iirBShift of 0), since there is nothing to
+// round and 1 << (shift - 1) would be undefined.
+static inline int64_t filterFixed_roundingShift(int64_t value, uint8_t shift) {
+  if (shift == 0)
+    return value;
+  return (value + ((int64_t)1 << (shift - 1))) >> shift;
+}
+
+// Converts a 12-bit ADC value (0 to 4095, mid-scale 2048) to Q15 without any
+// floating point.
+static inline filterFixed_q15_t filterFixed_adcToQ15(isr_AdcValue_t adcValue) {
+  return filterFixed_saturateQ15(
+      ((int32_t)adcValue - (1 << (FILTER_FIXED_ADC_BITS - 1)))
+      << (16 - FILTER_FIXED_ADC_BITS));
+}
+
+// Converts a double in [-1.0, 1.0] to Q15, rounding and saturating.
+filterFixed_q15_t filterFixed_doubleToQ15(double value);
+
+typedef struct {
+  // FIR: Q31 taps and Q15 input history stored twice (newest first), so the
+  // newest tapCount inputs are always contiguous.
+  filterFixed_q31_t *firCoefficients;
+  filterFixed_q15_t *firHistory;
+  uint32_t tapCount;
+  uint32_t firNewest;        // Index of the newest input in firHistory.
+  uint16_t decimationFactor; // Inputs per FIR output.
+  uint16_t decimationCount;  // Inputs since the last FIR output.
+  // IIR bank, coefficient k of band f is iirB[f][k] / 2^iirBShift[f].
+  filterFixed_q31_t iirB[FILTER_FREQUENCY_COUNT]
+                        [FILTER_FIXED_IIR_B_COEFFICIENT_COUNT];
+  filterFixed_q31_t iirA[FILTER_FREQUENCY_COUNT]
+                        [FILTER_FIXED_IIR_A_COEFFICIENT_COUNT];
+  // Remainder of the A coefficients, iirALow[f][k] / 2^(iirAShift[f] + 27).
+  filterFixed_q31_t iirALow[FILTER_FREQUENCY_COUNT]
+                           [FILTER_FIXED_IIR_A_COEFFICIENT_COUNT];
+  uint8_t iirBShift[FILTER_FREQUENCY_COUNT];
+  uint8_t iirAShift[FILTER_FREQUENCY_COUNT];
+  // FIR outputs (Q3.28) and IIR outputs (Q3.28), newest first, stored twice.
+  filterFixed_q31_t y[2 * FILTER_FIXED_IIR_B_COEFFICIENT_COUNT];
+  filterFixed_q31_t z[FILTER_FREQUENCY_COUNT]
+                     [2 * FILTER_FIXED_IIR_A_COEFFICIENT_COUNT];
+  uint16_t yNewest;
+  uint16_t zNewest;
+  // Power: window of squared outputs per band and its exact running sum.
+  queue_u32_t powerWindow[FILTER_FREQUENCY_COUNT];
+  uint64_t power[FILTER_FREQUENCY_COUNT];
+} filterFixed_t;
+
+// Quantizes the coefficients (same layout as filter_getFirCoefficientArray(),
+// filter_getIirBCoefficientArray() and filter_getIirACoefficientArray()
+// without the leading 1) and allocates the FIR history and power windows.
+// Prints an error message and calls assert(false) if malloc() fails.
+void filterFixed_init(filterFixed_t *f, const double *firCoefficients,
+                      uint32_t tapCount, uint16_t decimationFactor,
+                      const double *bCoefficients[FILTER_FREQUENCY_COUNT],
+                      const double *aCoefficients[FILTER_FREQUENCY_COUNT],
+                      queue_size_t powerWindowLength);
+
+// Adds a new Q15 input. On every decimationFactor-th input, runs the FIR, all
+// IIR filters and updates all powers, then returns true.
+bool filterFixed_addNewInput(filterFixed_t *f, filterFixed_q15_t x);
+
+// Returns the current power of a band, scaled to match the double version
+// (sum of squares of the IIR outputs over the window).
+double filterFixed_getPower(filterFixed_t *f, uint16_t filterNumber);
+
+// Returns the newest IIR output of a band as a double (for error analysis).
+double filterFixed_getIirOutput(filterFixed_t *f, uint16_t filterNumber);
+
+// Frees the storage allocated by filterFixed_init().
+void filterFixed_garbageCollect(filterFixed_t *f);
+
+#endif /* FILTERFIXED_H_ */
@@ -24,8 +24,14 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "isr.h"
 #endif
 
+#include "benchmark.h"
 #include "filter.h"
+#include "filterFixed.h"
+#include "firDecimator.h"
+#include "goertzelBank.h"
 #include "histogram.h"
+#include "iirBank.h"
+#include "runningPower.h"
 #include "utils.h"
 
 /****************************************************************************************************
@@ -947,6 +953,421 @@ bool filterTest_runPowerTest() {
   return firstComputeStatus & incrementalComputeStatus;
 }
 
+#define POLYPHASE_FIR_TEST_INPUT_COUNT                                         \
+  100000 // One second of inputs at 100 kHz.
+// Checks the polyphase decimating FIR (see firDecimator.h) against:
+// 1. a direct-form FIR computed here from filter_getFirCoefficientArray() and
+//    a queue holding the newest inputs, and
+// 2. the filter code itself: filter_addNewInput() on every input and
+//    filter_firFilter() on every decimation-th input (via
+//    filterTest_decimatingFirFilter()), reading the output back from yQueue.
+// Random inputs are used. The summation order differs between the two
+// structures so outputs are compared with filterTest_floatingPointEqual().
+bool filterTest_runPolyphaseFirTest(bool printMessageFlag) {
+  if (!filterTest_initFlag) {
+    printf("Must call filterTest_init() before running any filter tests.\n");
+    return false;
+  }
+  bool success = true; // Be optimistic.
+  filter_init();       // Start the filter code from all zeros.
+  firDecimationCount = 0;
+  const double *coefficients = filter_getFirCoefficientArray();
+  uint32_t tapCount = filter_getFirCoefficientCount();
+  firDecimator_t decimator;
+  firDecimator_init(&decimator, coefficients, tapCount,
+                    filterTest_getDecimationValue());
+  queue_t directQ; // Newest inputs for the direct-form reference.
+  queue_init(&directQ, tapCount, "polyphaseDirectQ");
+  filter_fillQueue(&directQ, 0.0);
+  for (uint32_t i = 0; i < POLYPHASE_FIR_TEST_INPUT_COUNT && success; i++) {
+    double x = filterTest_randomValue0To1();
+    queue_overwritePush(&directQ, x);
+    filter_addNewInput(x);
+    bool filterOutputReady = filterTest_decimatingFirFilter();
+    if (firDecimator_addInput(&decimator, x) != filterOutputReady) {
+      printf("filterTest_runPolyphaseFirTest: decimator and filter do not "
+             "produce outputs on the same input (%u).\n",
+             i);
+      success = false;
+      break;
+    }
+    if (!filterOutputReady)
+      continue;
+    double directOutput = 0.0; // y = sum of h[k] * x[newest - k].
+    for (uint32_t k = 0; k < tapCount; k++)
+      directOutput +=
+          coefficients[k] * queue_readElementAt(&directQ, tapCount - 1 - k);
+    double polyphaseOutput = firDecimator_getOutput(&decimator);
+    double filterOutput =
+        filterTest_readMostRecentValueFromQueue(filter_getYQueue());
+    if (!filterTest_floatingPointEqual(polyphaseOutput, directOutput) ||
+        !filterTest_floatingPointEqual(polyphaseOutput, filterOutput)) {
+      printf("filterTest_runPolyphaseFirTest: polyphase output (%24.20le) "
+             "does not match direct-form (%24.20le) or filter_firFilter() "
+             "(%24.20le) at input %u.\n",
+             polyphaseOutput, directOutput, filterOutput, i);
+      success = false;
+    }
+  }
+  queue_garbageCollect(&directQ);
+  firDecimator_garbageCollect(&decimator);
+  if (printMessageFlag) {
+    printf("filterTest_runPolyphaseFirTest ");
+    if (success)
+      printf("passed.\n");
+    else
+      printf("failed.\n");
+  }
+  return success;
+}
+
+#define RUNNING_POWER_TEST_SAMPLE_COUNT                                        \
+  1000 // Decimated samples per band for the benchmark.
+#define RUNNING_POWER_TEST_LONG_RUN_COUNT                                      \
+  1000000 // Decimated samples for the drift check (100 s of detector time).
+// Benchmarks the power computation for all 10 bands per decimated sample:
+// "before" pushes the new IIR output and sums the squares of the whole output
+// queue (filterTest_computeGoldenPowerValue(), the from-scratch path of
+// filter_computePower()); "after" calls runningPower_addSample(). Then checks
+// that a windowed runningPower_t still matches the golden value after a long
+// run. Returns true if the check passes.
+bool filterTest_runRunningPowerBenchmark() {
+  printf("===== Starting filterTest_runRunningPowerBenchmark() =====\n");
+  bool success = true; // Be optimistic.
+  queue_t queues[FILTER_FREQUENCY_COUNT];
+  runningPower_t powers[FILTER_FREQUENCY_COUNT];
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    queue_init(&queues[i], OUTPUT_QUEUE_SIZE, "runningPowerQ");
+    filterTest_fillQueueWithRandomValues(&queues[i]);
+  }
+  // Before: from-scratch sum of squares.
+  volatile double sink = 0.0; // Keeps the computation from being optimized out.
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t n = 0; n < RUNNING_POWER_TEST_SAMPLE_COUNT; n++) {
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+      queue_overwritePush(&queues[i], filterTest_randomValue0To1());
+      sink = filterTest_computeGoldenPowerValue(&queues[i]);
+    }
+  }
+  benchmark_timestamp_t stop = benchmark_now();
+  double beforeTime = benchmark_elapsedNanoseconds(start, stop);
+#ifdef ZYBO_BOARD
+  double beforeCycles = benchmark_elapsedCycles(start, stop);
+#endif
+  // After: running accumulators, renormalized once per window length.
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    runningPower_initWindowed(&powers[i], &queues[i], OUTPUT_QUEUE_SIZE);
+  start = benchmark_now();
+  for (uint32_t n = 0; n < RUNNING_POWER_TEST_SAMPLE_COUNT; n++) {
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+      runningPower_addSample(&powers[i], filterTest_randomValue0To1());
+      sink = runningPower_getPower(&powers[i]);
+    }
+  }
+  stop = benchmark_now();
+  (void)sink;
+  double afterTime = benchmark_elapsedNanoseconds(start, stop);
+  printf("10-band power per decimated sample: from scratch %.1lf ns, running "
+         "%.1lf ns.\n",
+         beforeTime / RUNNING_POWER_TEST_SAMPLE_COUNT,
+         afterTime / RUNNING_POWER_TEST_SAMPLE_COUNT);
+#ifdef ZYBO_BOARD
+  printf("In CPU cycles: from scratch %.0lf, running %.0lf.\n",
+         beforeCycles / RUNNING_POWER_TEST_SAMPLE_COUNT,
+         benchmark_elapsedCycles(start, stop) /
+             RUNNING_POWER_TEST_SAMPLE_COUNT);
+#endif
+  // Drift check: one band, many samples, no renormalization, Kahan only.
+  runningPower_initWindowed(&powers[0], &queues[0], 0);
+  for (uint32_t n = 0; n < RUNNING_POWER_TEST_LONG_RUN_COUNT; n++)
+    runningPower_addSample(&powers[0], filterTest_randomValue0To1());
+  double goldenValue = filterTest_computeGoldenPowerValue(&queues[0]);
+  double testValue = runningPower_getPower(&powers[0]);
+  if (fabs(testValue - goldenValue) > TEST_PASS_EPSILON) {
+    printf("Running power drifted: golden value %20.24le, running value "
+           "%20.24le.\n",
+           goldenValue, testValue);
+    success = false;
+  } else {
+    printf("Running power matches the golden value after %d samples.\n",
+           RUNNING_POWER_TEST_LONG_RUN_COUNT);
+  }
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    queue_garbageCollect(&queues[i]);
+  printf("+++++ Exiting filterTest_runRunningPowerBenchmark +++++\n");
+  return success;
+}
+
+#define IIR_BANK_TEST_INPUT_COUNT                                              \
+  10000 // Decimated samples (one second of detector time).
+// Runs the same random FIR outputs through filter_iirFilter() (for every filter
+// number) and through iirBank_filter() and checks that all outputs match.
+// Also reports the time taken by both per decimated sample.
+bool filterTest_runIirBankTest(bool printMessageFlag) {
+  if (!filterTest_initFlag) {
+    printf("Must call filterTest_init() before running any filter tests.\n");
+    return false;
+  }
+  bool success = true; // Be optimistic.
+  filter_init();       // Start the filter code from all zeros.
+  const double *bCoefficients[FILTER_FREQUENCY_COUNT];
+  const double *aCoefficients[FILTER_FREQUENCY_COUNT];
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    bCoefficients[i] = filter_getIirBCoefficientArray(i);
+    aCoefficients[i] = filter_getIirACoefficientArray(i) +
+                       filterTest_getIirACoefficientArrayStartingIndex();
+  }
+  iirBank_t bank;
+  iirBank_init(&bank, bCoefficients, aCoefficients);
+  double filterTime = 0.0; // Nanoseconds spent in filter_iirFilter().
+  double bankTime = 0.0;   // Nanoseconds spent in iirBank_filter().
+  for (uint32_t n = 0; n < IIR_BANK_TEST_INPUT_COUNT && success; n++) {
+    double firOutput = filterTest_randomValue0To1();
+    double filterOutputs[FILTER_FREQUENCY_COUNT];
+    double bankOutputs[FILTER_FREQUENCY_COUNT];
+    queue_overwritePush(filter_getYQueue(), firOutput);
+    benchmark_timestamp_t start = benchmark_now();
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+      filterOutputs[i] = filter_iirFilter(i);
+    benchmark_timestamp_t stop = benchmark_now();
+    filterTime += benchmark_elapsedNanoseconds(start, stop);
+    start = benchmark_now();
+    iirBank_filter(&bank, firOutput, bankOutputs);
+    stop = benchmark_now();
+    bankTime += benchmark_elapsedNanoseconds(start, stop);
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+      if (!filterTest_floatingPointEqual(filterOutputs[i], bankOutputs[i])) {
+        printf("filterTest_runIirBankTest: Output from IIR bank[%d](%24.20le) "
+               "does not match IIR Filter[%d](%24.20le) at sample(%u).\n",
+               i, bankOutputs[i], i, filterOutputs[i], n);
+        success = false;
+      }
+    }
+  }
+  if (printMessageFlag) {
+    printf("All 10 IIR filters per decimated sample: filter_iirFilter() %.1lf "
+           "ns, iirBank_filter() %.1lf ns.\n",
+           filterTime / IIR_BANK_TEST_INPUT_COUNT,
+           bankTime / IIR_BANK_TEST_INPUT_COUNT);
+    printf("filterTest_runIirBankTest ");
+    if (success)
+      printf("passed.\n");
+    else
+      printf("failed.\n");
+  }
+  return success;
+}
+
+// Runs FILTER_TEST_PULSE_WIDTH_LENGTH inputs of a square wave with the given
+// period through the double filter chain the way the detector does: the
+// decimating FIR, the IIR bank and a window of OUTPUT_QUEUE_SIZE outputs per
+// band. Copies the final band powers into powerValues and returns the time
+// taken in nanoseconds. Used as the reference for the alternative back ends.
+static double filterTest_computeReferencePowers(uint16_t periodTickCount,
+                                                double powerValues[]) {
+  const double *bCoefficients[FILTER_FREQUENCY_COUNT];
+  const double *aCoefficients[FILTER_FREQUENCY_COUNT];
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    bCoefficients[i] = filter_getIirBCoefficientArray(i);
+    aCoefficients[i] = filter_getIirACoefficientArray(i) +
+                       filterTest_getIirACoefficientArrayStartingIndex();
+  }
+  firDecimator_t decimator;
+  firDecimator_init(&decimator, filter_getFirCoefficientArray(),
+                    filter_getFirCoefficientCount(),
+                    filterTest_getDecimationValue());
+  iirBank_t bank;
+  iirBank_init(&bank, bCoefficients, aCoefficients);
+  queue_t outputQueues[FILTER_FREQUENCY_COUNT];
+  runningPower_t powers[FILTER_FREQUENCY_COUNT];
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    queue_init(&outputQueues[i], OUTPUT_QUEUE_SIZE, "referencePowerQ");
+    runningPower_initWindowed(&powers[i], &outputQueues[i], OUTPUT_QUEUE_SIZE);
+  }
+  uint16_t freqTick = 0;
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t n = 0; n < FILTER_TEST_PULSE_WIDTH_LENGTH; n++) {
+    double x = computeFilterInput(freqTick, periodTickCount);
+    freqTick = (freqTick + 1) % periodTickCount;
+    if (firDecimator_addInput(&decimator, x)) {
+      double outputs[FILTER_FREQUENCY_COUNT];
+      iirBank_filter(&bank, firDecimator_getOutput(&decimator), outputs);
+      for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+        runningPower_addSample(&powers[i], outputs[i]);
+    }
+  }
+  benchmark_timestamp_t stop = benchmark_now();
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    powerValues[i] = runningPower_getPower(&powers[i]);
+    queue_garbageCollect(&outputQueues[i]);
+  }
+  firDecimator_garbageCollect(&decimator);
+  return benchmark_elapsedNanoseconds(start, stop);
+}
+
+// Returns the band with the largest power and the ratio of the largest power to
+// the second largest (how clearly that band stands out) in margin.
+static uint16_t filterTest_findStrongestBand(double powerValues[],
+                                             double *margin) {
+  uint16_t strongest = 0;
+  for (uint16_t i = 1; i < FILTER_FREQUENCY_COUNT; i++)
+    if (powerValues[i] > powerValues[strongest])
+      strongest = i;
+  double second = 0.0;
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+    if (i != strongest && powerValues[i] > second)
+      second = powerValues[i];
+  *margin = (second > 0.0) ? powerValues[strongest] / second : INFINITY;
+  return strongest;
+}
+
+#define FIXED_POINT_TEST_MAX_ERROR                                             \
+  2.0E-2 // Power error allowed, relative to the largest band power.
+// Compares the fixed-point filter chain (see filterFixed.h) against the double
+// implementation for a square wave at each of the 10 player frequencies. For
+// each frequency, prints the error of every band relative to the largest band
+// power (the detector only compares powers to each other) and checks that the
+// fixed-point version still finds the player's band as the strongest.
+bool filterTest_runFixedPointErrorAnalysis(bool printMessageFlag) {
+  if (!filterTest_initFlag) {
+    printf("Must call filterTest_init() before running any filter tests.\n");
+    return false;
+  }
+  bool success = true; // Be optimistic.
+  const double *bCoefficients[FILTER_FREQUENCY_COUNT];
+  const double *aCoefficients[FILTER_FREQUENCY_COUNT];
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    bCoefficients[i] = filter_getIirBCoefficientArray(i);
+    aCoefficients[i] = filter_getIirACoefficientArray(i) +
+                       filterTest_getIirACoefficientArrayStartingIndex();
+  }
+  double worstError = 0.0;
+  for (uint16_t player = 0; player < FILTER_FREQUENCY_COUNT; player++) {
+    uint16_t periodTickCount = filter_frequencyTickTable[player];
+    double referencePowers[FILTER_FREQUENCY_COUNT];
+    filterTest_computeReferencePowers(periodTickCount, referencePowers);
+    filterFixed_t fixed;
+    filterFixed_init(&fixed, filter_getFirCoefficientArray(),
+                     filter_getFirCoefficientCount(),
+                     filterTest_getDecimationValue(), bCoefficients,
+                     aCoefficients, OUTPUT_QUEUE_SIZE);
+    uint16_t freqTick = 0;
+    for (uint32_t n = 0; n < FILTER_TEST_PULSE_WIDTH_LENGTH; n++) {
+      double x = computeFilterInput(freqTick, periodTickCount);
+      freqTick = (freqTick + 1) % periodTickCount;
+      filterFixed_addNewInput(&fixed, filterFixed_doubleToQ15(x));
+    }
+    double fixedPowers[FILTER_FREQUENCY_COUNT];
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++)
+      fixedPowers[i] = filterFixed_getPower(&fixed, i);
+    filterFixed_garbageCollect(&fixed);
+    double margin;
+    double maxPower = referencePowers[filterTest_findStrongestBand(
+        referencePowers, &margin)];
+    if (printMessageFlag)
+      printf("Player %d relative power error per band:", player);
+    for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+      double error = fabs(fixedPowers[i] - referencePowers[i]) / maxPower;
+      if (printMessageFlag)
+        printf(" %.1le", error);
+      if (error > worstError)
+        worstError = error;
+    }
+    if (printMessageFlag)
+      printf("\n");
+    uint16_t fixedStrongest =
+        filterTest_findStrongestBand(fixedPowers, &margin);
+    if (fixedStrongest != player) {
+      printf("filterTest_runFixedPointErrorAnalysis: fixed-point band %d is "
+             "the strongest for player %d.\n",
+             fixedStrongest, player);
+      success = false;
+    }
+  }
+  if (worstError > FIXED_POINT_TEST_MAX_ERROR) {
+    printf("filterTest_runFixedPointErrorAnalysis: worst relative power error "
+           "%le is larger than %le.\n",
+           worstError, FIXED_POINT_TEST_MAX_ERROR);
+    success = false;
+  }
+  if (printMessageFlag) {
+    printf("Worst fixed-point relative power error: %le.\n", worstError);
+    printf("filterTest_runFixedPointErrorAnalysis ");
+    if (success)
+      printf("passed.\n");
+    else
+      printf("failed.\n");
+  }
+  return success;
+}
+
+// Compares the Goertzel back end (see goertzelBank.h) with the filter chain on
+// the square waves of all FIR test frequencies (the 10 player frequencies and
+// the out-of-band ones). For each, prints the strongest band of both back ends
+// and its margin over the second strongest band. Checks that both find the
+// player's band for the player frequencies. Also reports the time per input of
+// both back ends.
+bool filterTest_runGoertzelTest(bool printMessageFlag) {
+  if (!filterTest_initFlag) {
+    printf("Must call filterTest_init() before running any filter tests.\n");
+    return false;
+  }
+  bool success = true; // Be optimistic.
+  goertzelBank_t goertzel;
+  goertzelBank_init(&goertzel, filter_frequencyTickTable,
+                    GOERTZEL_BANK_BLOCK_LENGTH, GOERTZEL_BANK_WINDOW_BLOCK_COUNT,
+                    filterTest_getDecimationValue());
+  double referenceTime = 0.0; // Nanoseconds spent in the filter chain.
+  double goertzelTime = 0.0;  // Nanoseconds spent in goertzelBank_addInput().
+  for (uint16_t t = 0; t < FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT; t++) {
+    uint16_t periodTickCount = filterTest_firTestTickCounts[t];
+    double referencePowers[FILTER_FREQUENCY_COUNT];
+    referenceTime +=
+        filterTest_computeReferencePowers(periodTickCount, referencePowers);
+    goertzelBank_reset(&goertzel);
+    uint16_t freqTick = 0;
+    benchmark_timestamp_t start = benchmark_now();
+    for (uint32_t n = 0; n < FILTER_TEST_PULSE_WIDTH_LENGTH; n++) {
+      goertzelBank_addInput(&goertzel,
+                            computeFilterInput(freqTick, periodTickCount));
+      freqTick = (freqTick + 1) % periodTickCount;
+    }
+    benchmark_timestamp_t stop = benchmark_now();
+    goertzelTime += benchmark_elapsedNanoseconds(start, stop);
+    double goertzelPowers[FILTER_FREQUENCY_COUNT];
+    goertzelBank_getPowers(&goertzel, goertzelPowers);
+    double referenceMargin, goertzelMargin;
+    uint16_t referenceStrongest =
+        filterTest_findStrongestBand(referencePowers, &referenceMargin);
+    uint16_t goertzelStrongest =
+        filterTest_findStrongestBand(goertzelPowers, &goertzelMargin);
+    if (printMessageFlag)
+      printf("Period %2d ticks: filter chain band %d (margin %9.1lf), "
+             "Goertzel band %d (margin %9.1lf).\n",
+             periodTickCount, referenceStrongest, referenceMargin,
+             goertzelStrongest, goertzelMargin);
+    if (t < FILTER_FREQUENCY_COUNT && goertzelStrongest != t) {
+      printf("filterTest_runGoertzelTest: Goertzel band %d is the strongest "
+             "for player %d.\n",
+             goertzelStrongest, t);
+      success = false;
+    }
+  }
+  goertzelBank_garbageCollect(&goertzel);
+  if (printMessageFlag) {
+    uint32_t inputCount = FILTER_TEST_FIR_POWER_TEST_PERIOD_COUNT *
+                          FILTER_TEST_PULSE_WIDTH_LENGTH;
+    printf("Per input: filter chain %.1lf ns, Goertzel %.1lf ns.\n",
+           referenceTime / inputCount, goertzelTime / inputCount);
+    printf("filterTest_runGoertzelTest ");
+    if (success)
+      printf("passed.\n");
+    else
+      printf("failed.\n");
+  }
+  return success;
+}
+
 // Copies powerValues to currentPowerValues, the same array
 // that is used to hold the values after power has been computed
 // by filter_computePower().
@@ -966,7 +1387,11 @@ bool filterTest_runPowerTest() {
 // Performs several tests of the filter code.
 // 1. Test alignment of FIR constants with input.
 // 2. Test the arithmetic performed by the FIR filter.
-// 3. Test alignment of the IIR A and B coefficients.
+// 2a. Test the polyphase decimating FIR against the direct-form FIR.
+// 3. Test alignment of the IIR A and B coefficients, test the IIR bank.
+// 3a. Test the power computation, benchmark the running power accumulator.
+// 3b. Compare the fixed-point filter chain against the double version.
+// 3c. Compare the Goertzel back end against the filter chain.
 // 4. Plots the frequency response of the FIR filter on the TFT display.
 // 5. Plots the frequency response of each of the IIR bandpass filters on the
 // TFT display. Returns true if all tests passed, false otherwise. Various
@@ -976,11 +1401,15 @@ bool filterTest_runTest() {
   bool success = true; // Be optimistic.
   filter_init();       // Always must init stuff.
   filterTest_init();   // More init stuff.
+#ifndef FILTER_POLYPHASE_FIR // These need an FIR output after every input.
   // Confirm that the FIR coefficients are properly aligned with the incoming
   // data.
   success &= filterTest_runFirAlignmentTest(PRINT_INFO_MESSAGES);
   // Confirm that the FIR properly computes its output.
   success &= filterTest_runFirArithmeticTest(PRINT_INFO_MESSAGES);
+#endif
+  // Confirm that the polyphase FIR matches the direct-form FIR.
+  success &= filterTest_runPolyphaseFirTest(PRINT_INFO_MESSAGES);
   // Confirm that the IIR A coefficients are properly aligned with the incoming
   // data.
   success &= filterTest_runIirAAlignmentTest(TEST_IIR_FILTER_NUMBER,
@@ -989,8 +1418,16 @@ bool filterTest_runTest() {
   // data.
   success &= filterTest_runIirBAlignmentTest(TEST_IIR_FILTER_NUMBER,
                                              PRINT_INFO_MESSAGES);
+  // Confirm that the IIR bank matches the individual IIR filters.
+  success &= filterTest_runIirBankTest(PRINT_INFO_MESSAGES);
   // Verifies correct functionality of the power computation.
   success &= filterTest_runPowerTest();
+  // Compares from-scratch and running power computation.
+  success &= filterTest_runRunningPowerBenchmark();
+  // Compares the fixed-point filter chain against the double version.
+  success &= filterTest_runFixedPointErrorAnalysis(PRINT_INFO_MESSAGES);
+  // Compares the Goertzel back end against the filter chain.
+  success &= filterTest_runGoertzelTest(PRINT_INFO_MESSAGES);
   // Plots the frequency response of the FIR filter against all user and other
   // test frequencies. All frequencies are expressed as a square wave.
   filterTest_runSquareWaveFirPowerTest(PRINT_INFO_MESSAGES, PLOT_INPUT);
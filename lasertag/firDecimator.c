@@ -0,0 +1,81 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "firDecimator.h"
+
+// Allocates storage and re-orders the coefficients so that the taps of phase r,
+// h[r], h[r + D], h[r + 2D], ..., are contiguous. Taps past the end of the
+// coefficient array are stored as 0.0 so every phase has sumCount taps.
+void firDecimator_init(firDecimator_t *d, const double *coefficients,
+                       uint32_t tapCount, uint16_t decimationFactor) {
+  d->decimationFactor = decimationFactor;
+  d->sumCount = (tapCount + decimationFactor - 1) / decimationFactor;
+  d->phaseCoefficients = (double *)malloc((size_t)decimationFactor *
+                                          d->sumCount * sizeof(double));
+  d->sums = (double *)malloc(d->sumCount * sizeof(double));
+  if (d->phaseCoefficients == NULL || d->sums == NULL) {
+    printf("firDecimator_init(): malloc() failed.\n");
+    assert(false);
+  }
+  for (uint16_t r = 0; r < decimationFactor; r++) {
+    for (uint32_t j = 0; j < d->sumCount; j++) {
+      uint32_t k = r + j * decimationFactor; // Tap index in the direct form.
+      d->phaseCoefficients[r * d->sumCount + j] =
+          (k < tapCount) ? coefficients[k] : 0.0;
+    }
+  }
+  firDecimator_reset(d);
+}
+
+// Zeroes all partial sums, equivalent to filling xQueue with 0.0.
+void firDecimator_reset(firDecimator_t *d) {
+  for (uint32_t j = 0; j < d->sumCount; j++)
+    d->sums[j] = 0.0;
+  d->phase = d->decimationFactor - 1;
+  d->oldestSum = 0;
+  d->output = 0.0;
+}
+
+// An input with phase r is r inputs before the next output, so it is x[newest
+// - (r + jD)] for the j-th output from now and gets multiplied by h[r + jD].
+// sums[oldestSum + j] (wrapped) holds the partial sum of the j-th output.
+bool firDecimator_addInput(firDecimator_t *d, double x) {
+  const double *h = &d->phaseCoefficients[d->phase * d->sumCount];
+  uint32_t lengthToEnd = d->sumCount - d->oldestSum; // Sums before the wrap.
+  double *sums = &d->sums[d->oldestSum];
+  for (uint32_t j = 0; j < lengthToEnd; j++)
+    sums[j] += h[j] * x;
+  for (uint32_t j = lengthToEnd; j < d->sumCount; j++)
+    d->sums[j - lengthToEnd] += h[j] * x;
+  if (d->phase) { // Not the last input of this decimation period.
+    d->phase--;
+    return false;
+  }
+  // The oldest partial sum is complete. Its slot starts the newest output.
+  d->output = d->sums[d->oldestSum];
+  d->sums[d->oldestSum] = 0.0;
+  d->oldestSum = (d->oldestSum + 1 == d->sumCount) ? 0 : d->oldestSum + 1;
+  d->phase = d->decimationFactor - 1;
+  return true;
+}
+
+// Returns the most recently completed output.
+double firDecimator_getOutput(firDecimator_t *d) { return d->output; }
+
+// Frees the storage allocated by firDecimator_init().
+void firDecimator_garbageCollect(firDecimator_t *d) {
+  free(d->phaseCoefficients);
+  free(d->sums);
+  d->phaseCoefficients = NULL;
+  d->sums = NULL;
+}
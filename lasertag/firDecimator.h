@@ -0,0 +1,62 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef FIRDECIMATOR_H_
+#define FIRDECIMATOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A polyphase decimating FIR filter. It computes the same outputs as pushing
+// every input into xQueue and running the direct-form FIR,
+//   y = sum over k of h[k] * x[newest - k],
+// on every decimationFactor-th input, but spreads the work evenly: each input
+// is multiplied by the taps of its phase (h[r], h[r + D], h[r + 2D], ...) and
+// added to the partial sums of the outputs it contributes to. When the last
+// input of a decimation period arrives, the oldest partial sum is complete and
+// becomes the output. With 81 taps and D = 10 that is at most 9
+// multiply-accumulates per input instead of 81 on every 10th input.
+//
+// Outputs are produced on the same inputs as filterTest_decimatingFirFilter(),
+// i.e., on the decimationFactor-th, 2*decimationFactor-th, ... input after
+// firDecimator_init() or firDecimator_reset(). The summation order differs
+// from the direct form, so outputs match to floating-point rounding, not
+// bit-for-bit.
+
+typedef struct {
+  uint16_t decimationFactor; // D, inputs per output.
+  uint16_t phase;            // Phase of the next input, counts D-1 down to 0.
+  uint32_t sumCount;         // Number of partial sums (ceil(tapCount / D)).
+  uint32_t oldestSum;        // Index in sums of the next output.
+  double *phaseCoefficients; // sumCount taps per phase, phase-major.
+  double *sums;              // Partial sums, oldest at oldestSum.
+  double output;             // Most recent output.
+} firDecimator_t;
+
+// Allocates storage and re-orders the tapCount coefficients into phases.
+// coefficients are in the same order as filter_getFirCoefficientArray().
+// Prints an error message and calls assert(false) if malloc() fails.
+void firDecimator_init(firDecimator_t *d, const double *coefficients,
+                       uint32_t tapCount, uint16_t decimationFactor);
+
+// Zeroes all partial sums, equivalent to filling xQueue with 0.0.
+void firDecimator_reset(firDecimator_t *d);
+
+// Adds an input. Returns true if it completed an output (every
+// decimationFactor-th input), which can then be read with
+// firDecimator_getOutput().
+bool firDecimator_addInput(firDecimator_t *d, double x);
+
+// Returns the most recently completed output.
+double firDecimator_getOutput(firDecimator_t *d);
+
+// Frees the storage allocated by firDecimator_init().
+void firDecimator_garbageCollect(firDecimator_t *d);
+
+#endif /* FIRDECIMATOR_H_ */
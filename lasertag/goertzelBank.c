@@ -0,0 +1,107 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "goertzelBank.h"
+
+#define GOERTZEL_BANK_PI 3.14159265358979323846
+
+// Allocates the block energies and computes 2cos(w), w = 2pi / period.
+// A sinusoid of amplitude A at the band frequency gives a block energy of
+// (blockLength * A / 2)^2. The IIR back end would sum A^2 / 2 over the
+// blockLength / decimationFactor decimated samples of the block, hence scale.
+void goertzelBank_init(goertzelBank_t *g,
+                       const uint16_t periodTickCounts[FILTER_FREQUENCY_COUNT],
+                       uint32_t blockLength, uint16_t windowBlockCount,
+                       uint16_t decimationFactor) {
+  g->blockLength = blockLength;
+  g->windowBlockCount = windowBlockCount;
+  g->scale = 2.0 / ((double)blockLength * decimationFactor);
+  g->blockEnergies = (double *)malloc((size_t)windowBlockCount *
+                                      FILTER_FREQUENCY_COUNT * sizeof(double));
+  if (g->blockEnergies == NULL) {
+    printf("goertzelBank_init(): malloc() failed.\n");
+    assert(false);
+  }
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    g->coefficients[band] =
+        2.0 * cos(2.0 * GOERTZEL_BANK_PI / periodTickCounts[band]);
+  goertzelBank_reset(g);
+}
+
+// Zeroes the resonators, the block energies and the powers.
+void goertzelBank_reset(goertzelBank_t *g) {
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    g->s1[band] = 0.0;
+    g->s2[band] = 0.0;
+    g->power[band] = 0.0;
+  }
+  uint32_t energyCount = (uint32_t)g->windowBlockCount * FILTER_FREQUENCY_COUNT;
+  for (uint32_t i = 0; i < energyCount; i++)
+    g->blockEnergies[i] = 0.0;
+  g->inputCount = 0;
+  g->newestBlock = 0;
+}
+
+// Stores the energy of the block that just ended for every band, restarts the
+// resonators and re-sums the window. Summing from scratch once per block is
+// cheap (windowBlockCount adds per band) and cannot drift.
+static void goertzelBank_endBlock(goertzelBank_t *g) {
+  g->newestBlock = (g->newestBlock + 1) % g->windowBlockCount;
+  double *energies =
+      &g->blockEnergies[g->newestBlock * FILTER_FREQUENCY_COUNT];
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    double s1 = g->s1[band];
+    double s2 = g->s2[band];
+    energies[band] = s1 * s1 + s2 * s2 - g->coefficients[band] * s1 * s2;
+    g->s1[band] = 0.0;
+    g->s2[band] = 0.0;
+  }
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    double sum = 0.0;
+    for (uint16_t block = 0; block < g->windowBlockCount; block++)
+      sum += g->blockEnergies[block * FILTER_FREQUENCY_COUNT + band];
+    g->power[band] = g->scale * sum;
+  }
+}
+
+// Runs every resonator on the input. Returns true when a block ends.
+bool goertzelBank_addInput(goertzelBank_t *g, double x) {
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    double s = x + g->coefficients[band] * g->s1[band] - g->s2[band];
+    g->s2[band] = g->s1[band];
+    g->s1[band] = s;
+  }
+  if (++g->inputCount < g->blockLength)
+    return false;
+  g->inputCount = 0;
+  goertzelBank_endBlock(g);
+  return true;
+}
+
+// Returns the power of a band over the newest windowBlockCount blocks.
+double goertzelBank_getPower(goertzelBank_t *g, uint16_t filterNumber) {
+  return g->power[filterNumber];
+}
+
+// Copies the powers of all bands into powerValues.
+void goertzelBank_getPowers(goertzelBank_t *g, double powerValues[]) {
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    powerValues[band] = g->power[band];
+}
+
+// Frees the storage allocated by goertzelBank_init().
+void goertzelBank_garbageCollect(goertzelBank_t *g) {
+  free(g->blockEnergies);
+  g->blockEnergies = NULL;
+}
@@ -0,0 +1,83 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef GOERTZELBANK_H_
+#define GOERTZELBANK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "filter.h" // FILTER_FREQUENCY_COUNT
+
+// Alternative detector back end: measures the energy at the 10 player
+// frequencies directly with one Goertzel filter per frequency instead of the
+// decimating FIR and the 10 IIR bandpass filters. Each Goertzel filter is a
+// 2nd-order resonator run on the raw 100 kHz input,
+//   s = x + 2cos(w) * s1 - s2,
+// one multiply per frequency per input. After blockLength inputs, the energy
+// of the block at that frequency is
+//   s1 * s1 + s2 * s2 - 2cos(w) * s1 * s2
+// and the resonators restart. The power of a band is the sum of the energies
+// of the newest windowBlockCount blocks, so it slides along one block at a
+// time. With the defaults below the window is 200 ms, the same as the
+// FILTER_INPUT_PULSE_WIDTH decimated samples the IIR back end sums over, and
+// the powers are refreshed every 10 ms instead of every decimated sample.
+//
+// Cost per input: 10 multiply-adds, vs ~8 (FIR) + 21 (10 IIRs, per decimated
+// sample) + power for the filter chain. Powers are scaled so that a sinusoid
+// at a player frequency gives about the same power as the IIR back end (whose
+// passband gain is 1), so the detector fudge factors still apply.
+//
+// A block of 1000 inputs gives bins that are 100 Hz wide; the closest player
+// frequencies (26 and 24 ticks) are 320 Hz apart.
+
+#define GOERTZEL_BANK_BLOCK_LENGTH 1000 // Inputs per block (10 ms at 100 kHz).
+#define GOERTZEL_BANK_WINDOW_BLOCK_COUNT                                       \
+  20 // Blocks per power window (200 ms).
+
+typedef struct {
+  double coefficients[FILTER_FREQUENCY_COUNT]; // 2cos(w) per band.
+  double s1[FILTER_FREQUENCY_COUNT];           // Newest resonator state.
+  double s2[FILTER_FREQUENCY_COUNT];           // Resonator state before s1.
+  double power[FILTER_FREQUENCY_COUNT];        // Power over the window.
+  double scale;         // Block energy to IIR-equivalent power.
+  double *blockEnergies; // windowBlockCount x FILTER_FREQUENCY_COUNT.
+  uint32_t blockLength;  // Inputs per block.
+  uint32_t inputCount;   // Inputs in the current block.
+  uint16_t windowBlockCount; // Blocks per window.
+  uint16_t newestBlock;      // Row of blockEnergies written last.
+} goertzelBank_t;
+
+// Allocates the block energies and computes the coefficients for the given
+// period tick counts (filter_frequencyTickTable). decimationFactor is that of
+// the FIR in the IIR back end and is only used to scale the powers. Prints an
+// error message and calls assert(false) if malloc() fails.
+void goertzelBank_init(goertzelBank_t *g,
+                       const uint16_t periodTickCounts[FILTER_FREQUENCY_COUNT],
+                       uint32_t blockLength, uint16_t windowBlockCount,
+                       uint16_t decimationFactor);
+
+// Zeroes the resonators, the block energies and the powers.
+void goertzelBank_reset(goertzelBank_t *g);
+
+// Adds an input. Returns true if it completed a block, in which case the
+// powers have been updated.
+bool goertzelBank_addInput(goertzelBank_t *g, double x);
+
+// Returns the power of a band over the newest windowBlockCount blocks.
+double goertzelBank_getPower(goertzelBank_t *g, uint16_t filterNumber);
+
+// Copies the powers of all bands into powerValues (same layout as
+// filter_getCurrentPowerValues()).
+void goertzelBank_getPowers(goertzelBank_t *g, double powerValues[]);
+
+// Frees the storage allocated by goertzelBank_init().
+void goertzelBank_garbageCollect(goertzelBank_t *g);
+
+#endif /* GOERTZELBANK_H_ */
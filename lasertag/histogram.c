@@ -7,6 +7,8 @@ source code for personal or educational use.
 For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 */
 
+#include <float.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,19 +28,22 @@ static uint16_t topLabelMaxWidthInChars; // How many chars will be printed.
 static histogram_data_t
     currentBarData[HISTOGRAM_MAX_BAR_COUNT]; // Current histogram data.
 static histogram_data_t
-    previousBarData[HISTOGRAM_MAX_BAR_COUNT]; // Keep the old stuff around so
-                                              // you can erase things properly.
+    previousBarData[HISTOGRAM_MAX_BAR_COUNT]; // What is on the TFT, so only
+                                              // the difference is redrawn.
 static char
     topLabel[HISTOGRAM_MAX_BAR_COUNT]
             [HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS]; // Labels at top of
                                                           // histogram bars.
 static char
     oldTopLabel[HISTOGRAM_MAX_BAR_COUNT]
-               [HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS]; // Old label so you
-                                                             // only update as
+               [HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS]; // Label on the TFT
+                                                             // so you only
+                                                             // update as
                                                              // necessary.
+static bool histogram_dirty; // Some bar or top label differs from the TFT.
 
 #define ONE_HALF(x) ((x) / 2) // Integer divide by 2.
+#define HISTOGRAM_LABEL_DIGIT_BUFFER_SIZE 10 // Digits of the largest uint32_t.
 
 static bool initFlag =
     false; // Keep track whether histogram_init() has been called.
@@ -120,6 +125,7 @@ void histogram_init(uint16_t barCount) {
     topLabel[i][0] = 0;    // Start out with empty strings.
     oldTopLabel[i][0] = 0; // Start out with empty strings.
   }
+  histogram_dirty = false;
   for (int i = 0; i < HISTOGRAM_MAX_BAR_COUNT; i++) {
     strncpy(histogram_label[i], histogram_defaultLabel[i],
             HISTOGRAM_MAX_BAR_LABEL_WIDTH);
@@ -168,27 +174,21 @@ bool histogram_setBarData(histogram_index_t barIndex, histogram_data_t data,
     return false;
   }
   // If it has changed, update the data in the array but don't render anything
-  // on the display.
+  // on the display. previousBarData[] keeps what is on the TFT until
+  // histogram_updateDisplay() draws the change, so calling this several times
+  // between updates is fine.
   if (data !=
       currentBarData[barIndex]) { // Only modify the data if it has changed.
-    previousBarData[barIndex] =
-        currentBarData[barIndex]; // Save the old data so you render things
-                                  // properly.
-    // Copy the old string so that you can render things properly.
     currentBarData[barIndex] = data; // Store the data because it changed.
+    histogram_dirty = true;
   }
-  // If the label has changed, move the previous data to old, new data to
-  // current. Labels are handled separately from data because the label may
-  // change even if the underlying bar data does not. This allows the top label
-  // to change and to be redrawn even if the bars stay the same height.
-  if (strncmp(barTopLabel, topLabel[barIndex],
-              HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS)) {
-    // If you get here, the new label is different from the last one.
-    strncpy(oldTopLabel[barIndex], topLabel[barIndex],
-            HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
-    // Copy the current label to become the new old label.
-    strncpy(topLabel[barIndex], barTopLabel,
-            HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
+  // Labels are handled separately from data because the label may change even
+  // if the underlying bar data does not. This allows the top label to change
+  // and to be redrawn even if the bars stay the same height. oldTopLabel[]
+  // keeps the label that is on the TFT.
+  // Only the characters that fit are kept, so only those are compared.
+  if (strncmp(barTopLabel, topLabel[barIndex], topLabelMaxWidthInChars)) {
+    histogram_dirty = true;
     // Copy the new label to become the current label.
     uint16_t barTopLabelLength =
         strlen(barTopLabel); // Get the length of the label.
@@ -233,9 +233,71 @@ void histogram_drawTopLabel(uint16_t barIndex, histogram_data_t data,
   display_print(topLabel);                    // Draw the label.
 }
 
+// Returns the y-coordinate of the top row of a bar with height data. The bar
+// fills the rows from there down to histogram_barBottom() - 1 and its top label
+// sits in the DISPLAY_CHAR_HEIGHT rows above it, one blank row up.
+static int16_t histogram_barTop(histogram_data_t data) {
+  return display_height() - HISTOGRAM_BAR_Y_GAP - data;
+}
+
+// Returns the y-coordinate of the row just below the lowest bar row.
+static int16_t histogram_barBottom() {
+  return display_height() - HISTOGRAM_BAR_Y_GAP - 1;
+}
+
+// Rows top to bottom - 1 of a bar; empty if bottom <= top.
+typedef struct {
+  int16_t top;
+  int16_t bottom;
+} histogram_rowSpan_t;
+
+// Computes what changes between the bar height on the TFT (oldData) and data.
+// A taller bar erases the old top label where the bar does not cover it and
+// fills the added rows. A shorter bar erases from the old top label down to
+// the new top and fills nothing. Either way, the rows where the new top label
+// goes are black afterwards.
+static void histogram_getBarChange(histogram_data_t oldData,
+                                   histogram_data_t data,
+                                   histogram_rowSpan_t *erased,
+                                   histogram_rowSpan_t *filled) {
+  int16_t oldTop = histogram_barTop(oldData);
+  int16_t newTop = histogram_barTop(data);
+  // No label is drawn over an empty bar.
+  int16_t oldLabelTop = oldData ? oldTop - DISPLAY_CHAR_HEIGHT - 1 : oldTop;
+  int16_t bottom = histogram_barBottom();
+  erased->top = oldLabelTop;
+  if (data > oldData) {
+    erased->bottom = newTop; // Part of the old label may be above the new top.
+    filled->top = newTop;
+    filled->bottom = oldTop < bottom ? oldTop : bottom;
+  } else {
+    erased->bottom = newTop < bottom ? newTop : bottom;
+    filled->top = filled->bottom = newTop;
+  }
+}
+
+// Redraws only the rows that changed between the bar height on the TFT
+// (oldData) and data, see histogram_getBarChange().
+static void histogram_drawBarChange(uint16_t barIndex,
+                                    histogram_data_t oldData,
+                                    histogram_data_t data) {
+  int16_t x = barIndex * (histogram_barWidth + HISTOGRAM_BAR_X_GAP);
+  histogram_rowSpan_t erased, filled;
+  histogram_getBarChange(oldData, data, &erased, &filled);
+  if (erased.bottom > erased.top)
+    display_fillRect(x, erased.top, histogram_barWidth,
+                     erased.bottom - erased.top, DISPLAY_BLACK);
+  if (filled.bottom > filled.top)
+    display_fillRect(x, filled.top, histogram_barWidth,
+                     filled.bottom - filled.top,
+                     histogram_barColors[barIndex]);
+}
+
 // This updates the display.
-// It loops across all bars, checking:
-// If the height of the bar has changed, redraw both the bar and the top label.
+// Returns right away unless histogram_setBarData() changed something since the
+// last update. Otherwise it loops across all bars, checking:
+// If the height of the bar has changed, redraw only the rows that changed and
+// the top label.
 // If the height of the bar has not changed, but the top label has changed,
 // update the label.
 void histogram_updateDisplay() {
@@ -244,33 +306,23 @@ void histogram_updateDisplay() {
            "before calling this function.\n");
     return;
   }
+  if (!histogram_dirty) // Nothing moved by a pixel and no label changed.
+    return;
   for (int i = 0; i < histogram_barCount; i++) {
     histogram_data_t oldData = previousBarData[i]; // Get the previous data.
     histogram_data_t data = currentBarData[i];     // Get the current bar data.
     if (oldData !=
         data) { // If the are not equal, redraw the bar and the top-label.
-      // Erase the old bar and extend the erase rectangle to include the
-      // top-label so that everything is erased at once. Also, redraw the top
-      // label.
-      display_fillRect(i * (histogram_barWidth + HISTOGRAM_BAR_X_GAP),
-                       display_height() - oldData - HISTOGRAM_BAR_Y_GAP -
-                           DISPLAY_CHAR_HEIGHT - 1,
-                       histogram_barWidth, oldData + DISPLAY_CHAR_HEIGHT + 1,
-                       DISPLAY_BLACK);
-      // Draw the new bar.
-      display_fillRect(i * (histogram_barWidth + HISTOGRAM_BAR_X_GAP),
-                       display_height() - data - HISTOGRAM_BAR_Y_GAP,
-                       histogram_barWidth, data - 1, histogram_barColors[i]);
-      if (data != 0) { // Only draw the top label if the bar-data != 0.
+      histogram_drawBarChange(i, oldData, data);
+      if (data != 0) // Only draw the top label if the bar-data != 0.
         histogram_drawTopLabel(i, data, topLabel[i],
-                               false); // false means that the old label does
-                                       // not need to be erased.
-        previousBarData[i] = currentBarData[i]; // Old data and new data are the
-                                                // same after the update.
-        // Old label and new label are the same after the update.
-        strncpy(oldTopLabel[i], topLabel[i],
-                HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
-      }
+                               false); // false means that the old label was
+                                       // already erased.
+      previousBarData[i] = data; // Old data and new data are the same after
+                                 // the update.
+      // Old label and new label are the same after the update.
+      strncpy(oldTopLabel[i], topLabel[i],
+              HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
     } else if ((data != 0) &&
                strncmp(topLabel[i], oldTopLabel[i],
                        HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS)) {
@@ -283,6 +335,7 @@ void histogram_updateDisplay() {
               HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS);
     }
   }
+  histogram_dirty = false;
 }
 
 // Set the bar-color for each bar. This overwrites the defaults. Call
@@ -354,6 +407,98 @@ void trimLabel(char label[]) {
   }
 }
 
+// Writes the decimal digits of value backwards from end (exclusive) and
+// returns a pointer to the first one. At least minDigitCount digits are
+// written, padding with leading zeros.
+static char *histogram_formatDigits(char *end, uint32_t value,
+                                    uint16_t minDigitCount) {
+  uint16_t digitCount = 0;
+  do {
+    *--end = '0' + value % 10;
+    value /= 10;
+    digitCount++;
+  } while (value || digitCount < minDigitCount);
+  return end;
+}
+
+// Writes the label with snprintf("%0.0e") and trimLabel().
+static void histogram_printPowerLabel(double value, char label[]) {
+  char buffer[HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS];
+  snprintf(buffer, sizeof(buffer), "%0.0e", value);
+  trimLabel(buffer);
+  strcpy(label, buffer);
+}
+
+// Scaling by 10 rounds at every step, so the scaled value is within about
+// 4e-13 of the exact one (at most 308 steps of half an ulp each). Closer to a
+// rounding tie than this, the digit is left to printf().
+#define HISTOGRAM_LABEL_TIE_MARGIN 1e-12
+
+// Same text as snprintf("%0.0e") followed by trimLabel(), without going
+// through printf(): newlib's floating-point conversion allocates from the heap
+// and is slow, and this runs for every bar of every frame. The digit is found
+// by scaling to [1, 10), which is inexact, so the rare values whose digit is
+// within HISTOGRAM_LABEL_TIE_MARGIN of a tie, and subnormal values (which lose
+// bits when scaled), go through histogram_printPowerLabel() instead. Near a
+// power of ten, an exponent that is off by one still gives the same label.
+void histogram_formatPowerLabel(double value, char label[]) {
+  char *next = label;
+  if (isnan(value) || isinf(value)) { // Just like printf().
+    strcpy(label, isnan(value) ? "nan" : value < 0 ? "-inf" : "inf");
+    return;
+  }
+  if (value != 0 && fabs(value) < DBL_MIN) {
+    histogram_printPowerLabel(value, label);
+    return;
+  }
+  double magnitude = fabs(value);
+  int16_t exponent = 0;
+  if (magnitude != 0) {
+    // Scale to [1, 10).
+    while (magnitude >= 10) {
+      magnitude /= 10;
+      exponent++;
+    }
+    while (magnitude < 1) {
+      magnitude *= 10;
+      exponent--;
+    }
+  }
+  uint16_t digit = magnitude;
+  double fraction = magnitude - digit;
+  if (fabs(fraction - 0.5) < HISTOGRAM_LABEL_TIE_MARGIN) {
+    histogram_printPowerLabel(value, label);
+    return;
+  }
+  if (signbit(value)) // Also "-0" for -0.0, just like printf().
+    *next++ = '-';
+  if (fraction > 0.5) // Round to a single digit.
+    digit++;
+  if (digit == 10) { // 10 is 1 with the next exponent.
+    digit = 1;
+    exponent++;
+  }
+  *next++ = '0' + digit;
+  *next++ = exponent < 0 ? '-' : '+';
+  char digits[HISTOGRAM_LABEL_DIGIT_BUFFER_SIZE];
+  char *end = digits + HISTOGRAM_LABEL_DIGIT_BUFFER_SIZE;
+  char *first =
+      histogram_formatDigits(end, exponent < 0 ? -exponent : exponent, 2);
+  while (first < end)
+    *next++ = *first++;
+  *next = 0;
+}
+
+// Same text as snprintf("%u"), without going through printf().
+void histogram_formatCountLabel(uint32_t count, char label[]) {
+  char digits[HISTOGRAM_LABEL_DIGIT_BUFFER_SIZE];
+  char *end = digits + HISTOGRAM_LABEL_DIGIT_BUFFER_SIZE;
+  char *first = histogram_formatDigits(end, count, 1);
+  while (first < end)
+    *label++ = *first++;
+  *label = 0;
+}
+
 // Used to normalize values prior to plotting.
 void histogram_normalizePowerValues(double normalizedValues[],
                                     double origValues[], uint16_t size) {
@@ -383,12 +528,9 @@ void histogram_plotUserFrequencyPower(double powerValues[]) {
     // You can have a dynamic label at the top of the bar.
     char label[HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS]; // Get a buffer for
                                                             // the label.
-    // Create the label, based upon the actual power value.
-    if (snprintf(label, HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS, "%0.0e",
-                 powerValues[i]) == -1)
-      printf("Error: snprintf encountered an error during conversion.\n");
-    // Pull out the 'e' from the exponent to make better use of your characters.
-    trimLabel(label);
+    // Create the label, based upon the actual power value. The 'e' of the
+    // exponent is left out to make better use of your characters.
+    histogram_formatPowerLabel(powerValues[i], label);
     // Have the bar value and the label, send the data to the histogram.
     if (!histogram_setBarData(i, histogramBarValue, label)) {
       // If returns false, histogram_setBarData() is not happy. Print out some
@@ -436,14 +578,12 @@ void histogram_plotUserHits(uint16_t hitCounts[]) {
        i++) { // Iterate through the results for each channel.
     char label[HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS]; // Get a buffer for
                                                             // the label.
-    // Create the label, based upon the actual power value.
-    if (snprintf(label, HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS, "%d",
-                 hitCounts[i]) == -1)
-      printf("Error: snprintf encountered an error during conversion.\n");
+    // Create the label, based upon the hit count.
+    histogram_formatCountLabel(hitCounts[i], label);
     histogram_setBarData(
         i, normalizedHitValues[i] * HISTOGRAM_MAX_BAR_DATA_IN_PIXELS, label);
-    histogram_updateDisplay(); // Redraw the histogram.
   }
+  histogram_updateDisplay(); // Redraw the bars that changed, if any.
 }
 
 // Normalizes the values in the array argument.
@@ -460,3 +600,125 @@ void histogram_normalizeArrayValues(double *array, uint16_t size) {
   for (int i = 0; i < size; i++)
     array[i] = array[i] / maxPowerValue;
 }
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define HISTOGRAM_TEST_RANDOM_LABEL_COUNT 100000
+#define HISTOGRAM_TEST_MAX_EXPONENT 300
+#define HISTOGRAM_TEST_TIE_EXPONENT 30 // Ties from 0.5e-30 to 9.5e30.
+#define HISTOGRAM_TEST_BLACK 0
+#define HISTOGRAM_TEST_BAR 1
+#define HISTOGRAM_TEST_LABEL 2
+
+// Values that have printed differently: exact halves, near halves, signed
+// zeros, powers of ten and the ends of the double range.
+static const double histogram_testLabelValues[] = {
+    0.5,     1.5,     2.5,     3.5,     4.5,     5.5,     6.5,
+    7.5,     8.5,     9.5,     0.25,    0.125,   25,      250,
+    3.5e-6,  9.5e-19, -2.5,    -9.5,    0.0,     -0.0,    1.0,
+    10.0,    1e-5,    9.99e4,  9.5e307, DBL_MAX, DBL_MIN, 4.9e-324};
+#define HISTOGRAM_TEST_LABEL_VALUE_COUNT                                       \
+  (sizeof(histogram_testLabelValues) / sizeof(histogram_testLabelValues[0]))
+
+// Returns false and prints an error if histogram_formatPowerLabel() and
+// snprintf("%0.0e") with trimLabel() give different labels for value.
+static bool histogram_testPowerLabel(double value) {
+  char label[HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS];
+  char expected[HISTOGRAM_BAR_TOP_MAX_LABEL_WIDTH_IN_CHARS];
+  histogram_formatPowerLabel(value, label);
+  histogram_printPowerLabel(value, expected);
+  if (strcmp(label, expected)) {
+    printf("* Error: histogram_formatPowerLabel(%.17g) is %s, should be %s.\n",
+           value, label, expected);
+    return false;
+  }
+  return true;
+}
+
+// Checks histogram_formatPowerLabel() against snprintf() for the values above,
+// for every half-way value d.5 * 10^e and its neighbors, and for random values.
+static bool histogram_labelTest() {
+  bool testResult = true;
+  for (uint16_t i = 0; i < HISTOGRAM_TEST_LABEL_VALUE_COUNT; i++)
+    testResult &= histogram_testPowerLabel(histogram_testLabelValues[i]);
+  for (int16_t e = -HISTOGRAM_TEST_TIE_EXPONENT;
+       e <= HISTOGRAM_TEST_TIE_EXPONENT; e++) {
+    for (uint16_t d = 0; d < 10; d++) {
+      double tie = (d + 0.5) * pow(10, e);
+      testResult &= histogram_testPowerLabel(tie);
+      testResult &= histogram_testPowerLabel(nextafter(tie, 0));
+      testResult &= histogram_testPowerLabel(nextafter(tie, DBL_MAX));
+    }
+  }
+  for (uint32_t i = 0; i < HISTOGRAM_TEST_RANDOM_LABEL_COUNT; i++) {
+    double mantissa = (double)rand() / RAND_MAX * 10;
+    int16_t exponent = rand() % (2 * HISTOGRAM_TEST_MAX_EXPONENT + 1) -
+                       HISTOGRAM_TEST_MAX_EXPONENT;
+    testResult &= histogram_testPowerLabel(mantissa * pow(10, exponent));
+  }
+  return testResult;
+}
+
+// Draws a bar of height data and its top label into column, one entry per
+// row, the way histogram_updateDisplay() does from an empty bar.
+static void histogram_testDrawBar(uint8_t column[], histogram_data_t data) {
+  int16_t top = histogram_barTop(data);
+  for (int16_t y = top; y < histogram_barBottom(); y++)
+    column[y] = HISTOGRAM_TEST_BAR;
+  if (data) // The label is drawn one blank row above the bar.
+    for (int16_t y = top - DISPLAY_CHAR_HEIGHT - 1; y < top - 1; y++)
+      column[y] = HISTOGRAM_TEST_LABEL;
+}
+
+// For every pair of bar heights, draws the old bar and its label into a pixel
+// column, applies the spans of histogram_getBarChange() and checks that the
+// column then holds the new bar and nothing else: no rows of the old bar or
+// label are left and no rows of the new bar are missing.
+static bool histogram_barChangeTest() {
+  uint8_t column[DISPLAY_HEIGHT];
+  uint8_t expected[DISPLAY_HEIGHT];
+  for (histogram_data_t oldData = 0;
+       oldData < HISTOGRAM_MAX_BAR_DATA_IN_PIXELS; oldData++) {
+    for (histogram_data_t data = 0; data < HISTOGRAM_MAX_BAR_DATA_IN_PIXELS;
+         data++) {
+      if (data == oldData) // histogram_updateDisplay() draws nothing then.
+        continue;
+      memset(column, HISTOGRAM_TEST_BLACK, sizeof(column));
+      histogram_testDrawBar(column, oldData);
+      histogram_rowSpan_t erased, filled;
+      histogram_getBarChange(oldData, data, &erased, &filled);
+      for (int16_t y = erased.top; y < erased.bottom; y++)
+        column[y] = HISTOGRAM_TEST_BLACK;
+      for (int16_t y = filled.top; y < filled.bottom; y++)
+        column[y] = HISTOGRAM_TEST_BAR;
+      memset(expected, HISTOGRAM_TEST_BLACK, sizeof(expected));
+      histogram_testDrawBar(expected, data);
+      for (int16_t y = histogram_barTop(data) - DISPLAY_CHAR_HEIGHT - 1;
+           y < histogram_barTop(data) - 1; y++)
+        expected[y] = HISTOGRAM_TEST_BLACK; // Not drawn yet.
+      if (memcmp(column, expected, sizeof(column))) {
+        printf("* Error: redrawing a bar from %u to %u pixels leaves the "
+               "wrong rows.\n",
+               oldData, data);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Checks the top labels and the bar redraw. Does not draw on the TFT.
+bool histogram_runSelfTest() {
+  bool testResult = true;
+  bool tempResult = histogram_labelTest();
+  printf("=== histogram power-label test %s.\n",
+         tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  tempResult = histogram_barChangeTest();
+  printf("=== histogram bar-redraw test %s.\n",
+         tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  return testResult;
+}
@@ -107,6 +107,22 @@ void histogram_plotFirFrequencyResponse(double powerValues[]);
 // Runs a simple test.
 void histogram_runTest();
 
+// Checks histogram_formatPowerLabel() against snprintf() (exact halves,
+// values next to them and random values) and checks that the partial redraw
+// of a bar leaves exactly the new bar for every pair of heights. Does not draw
+// on the TFT. Returns true if the test passes.
+bool histogram_runSelfTest();
+
+// Writes a top label for a power value: one rounded digit, the sign of the
+// exponent and at least two exponent digits, e.g., "3-05" for 3.2e-5. This is
+// what snprintf("%0.0e") followed by trimLabel() gives, without printf().
+// label must hold at least HISTOGRAM_POWER_LABEL_MAX_LENGTH + 1 characters.
+#define HISTOGRAM_POWER_LABEL_MAX_LENGTH 6 // e.g., "-1-308"
+void histogram_formatPowerLabel(double value, char label[]);
+
+// Writes a hit count as a decimal top label, without printf().
+void histogram_formatCountLabel(uint32_t count, char label[]);
+
 // Handy function that shortens a label by removing the "e" part of the
 // exponent. Can be used to create a shortened top-label that is drawn above the
 // histogram bar.
@@ -31,7 +31,8 @@ void hitLedTimer_start();
 // Returns true if the timer is currently running.
 bool hitLedTimer_running();
 
-// Turns the gun's hit-LED on.
+// Turns the gun's hit-LED on. To trace hit latencies, also call
+// LATENCY_TRACE_REACTION(LATENCY_TRACE_REACTION_LED) here (see latencyTrace.h).
 void hitLedTimer_turnLedOn();
 
 // Turns the gun's hit-LED off.
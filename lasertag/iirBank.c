@@ -0,0 +1,109 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdbool.h>
+
+#include "iirBank.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define IIR_BANK_VECTOR_WIDTH 4 // Doubles per vector register.
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define IIR_BANK_VECTOR_WIDTH 2
+#endif
+
+// Copies the coefficients into the bank and zeroes the state.
+void iirBank_init(iirBank_t *bank,
+                  const double *bCoefficients[FILTER_FREQUENCY_COUNT],
+                  const double *aCoefficients[FILTER_FREQUENCY_COUNT]) {
+  for (uint16_t lane = 0; lane < IIR_BANK_LANE_COUNT; lane++) {
+    bool used = lane < FILTER_FREQUENCY_COUNT; // Padding lanes stay at 0.0.
+    for (uint16_t k = 0; k < IIR_BANK_B_COEFFICIENT_COUNT; k++)
+      bank->b[k][lane] = used ? bCoefficients[lane][k] : 0.0;
+    for (uint16_t k = 0; k < IIR_BANK_A_COEFFICIENT_COUNT; k++)
+      bank->a[k][lane] = used ? aCoefficients[lane][k] : 0.0;
+  }
+  iirBank_reset(bank);
+}
+
+// Zeroes the state.
+void iirBank_reset(iirBank_t *bank) {
+  for (uint16_t k = 0; k < 2 * IIR_BANK_A_COEFFICIENT_COUNT; k++)
+    for (uint16_t lane = 0; lane < IIR_BANK_LANE_COUNT; lane++)
+      bank->z[k][lane] = 0.0;
+  for (uint16_t k = 0; k < 2 * IIR_BANK_B_COEFFICIENT_COUNT; k++)
+    bank->y[k] = 0.0;
+  bank->yNewest = 0;
+  bank->zNewest = 0;
+}
+
+// Adds a new FIR output and runs every filter. History is stored newest first,
+// so the newest value moves down one slot each time (wrapping at the top) and
+// is written to both copies.
+void iirBank_filter(iirBank_t *bank, double firOutput,
+                    double outputs[FILTER_FREQUENCY_COUNT]) {
+  bank->yNewest =
+      bank->yNewest ? bank->yNewest - 1 : IIR_BANK_B_COEFFICIENT_COUNT - 1;
+  bank->y[bank->yNewest] = firOutput;
+  bank->y[bank->yNewest + IIR_BANK_B_COEFFICIENT_COUNT] = firOutput;
+  const double *y = &bank->y[bank->yNewest]; // y[k] = y[newest - k].
+  double(*zPast)[IIR_BANK_LANE_COUNT] = &bank->z[bank->zNewest];
+  bank->zNewest =
+      bank->zNewest ? bank->zNewest - 1 : IIR_BANK_A_COEFFICIENT_COUNT - 1;
+  double *zNew = bank->z[bank->zNewest];
+  double *zNewMirror = bank->z[bank->zNewest + IIR_BANK_A_COEFFICIENT_COUNT];
+#ifdef IIR_BANK_VECTOR_WIDTH
+  for (uint16_t lane = 0; lane < IIR_BANK_LANE_COUNT;
+       lane += IIR_BANK_VECTOR_WIDTH) {
+#if IIR_BANK_VECTOR_WIDTH == 4
+    __m256d sumB = _mm256_setzero_pd();
+    __m256d sumA = _mm256_setzero_pd();
+    for (uint16_t k = 0; k < IIR_BANK_B_COEFFICIENT_COUNT; k++)
+      sumB = _mm256_add_pd(sumB,
+                           _mm256_mul_pd(_mm256_loadu_pd(&bank->b[k][lane]),
+                                         _mm256_set1_pd(y[k])));
+    for (uint16_t k = 0; k < IIR_BANK_A_COEFFICIENT_COUNT; k++)
+      sumA = _mm256_add_pd(sumA,
+                           _mm256_mul_pd(_mm256_loadu_pd(&bank->a[k][lane]),
+                                         _mm256_loadu_pd(&zPast[k][lane])));
+    __m256d z = _mm256_sub_pd(sumB, sumA);
+    _mm256_storeu_pd(&zNew[lane], z);
+    _mm256_storeu_pd(&zNewMirror[lane], z);
+#else
+    __m128d sumB = _mm_setzero_pd();
+    __m128d sumA = _mm_setzero_pd();
+    for (uint16_t k = 0; k < IIR_BANK_B_COEFFICIENT_COUNT; k++)
+      sumB = _mm_add_pd(
+          sumB, _mm_mul_pd(_mm_loadu_pd(&bank->b[k][lane]), _mm_set1_pd(y[k])));
+    for (uint16_t k = 0; k < IIR_BANK_A_COEFFICIENT_COUNT; k++)
+      sumA = _mm_add_pd(sumA, _mm_mul_pd(_mm_loadu_pd(&bank->a[k][lane]),
+                                         _mm_loadu_pd(&zPast[k][lane])));
+    __m128d z = _mm_sub_pd(sumB, sumA);
+    _mm_storeu_pd(&zNew[lane], z);
+    _mm_storeu_pd(&zNewMirror[lane], z);
+#endif
+  }
+#else
+  double sumB[IIR_BANK_LANE_COUNT] = {0.0};
+  double sumA[IIR_BANK_LANE_COUNT] = {0.0};
+  for (uint16_t k = 0; k < IIR_BANK_B_COEFFICIENT_COUNT; k++)
+    for (uint16_t lane = 0; lane < IIR_BANK_LANE_COUNT; lane++)
+      sumB[lane] += bank->b[k][lane] * y[k];
+  for (uint16_t k = 0; k < IIR_BANK_A_COEFFICIENT_COUNT; k++)
+    for (uint16_t lane = 0; lane < IIR_BANK_LANE_COUNT; lane++)
+      sumA[lane] += bank->a[k][lane] * zPast[k][lane];
+  for (uint16_t lane = 0; lane < IIR_BANK_LANE_COUNT; lane++) {
+    zNew[lane] = sumB[lane] - sumA[lane];
+    zNewMirror[lane] = zNew[lane];
+  }
+#endif
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    outputs[band] = zNew[band];
+}
@@ -0,0 +1,70 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef IIRBANK_H_
+#define IIRBANK_H_
+
+#include <stdint.h>
+
+#include "filter.h" // FILTER_FREQUENCY_COUNT
+
+// Runs all FILTER_FREQUENCY_COUNT IIR bandpass filters in lockstep. It
+// computes the same outputs as calling filter_iirFilter() for every filter
+// number after each new FIR output:
+//   z = sum over k of b[k] * y[newest - k] - sum over k of a[k] * z[newest - k]
+// (a without the leading 1), but the state is stored as a structure of arrays:
+// coefficient k of every band is contiguous, as is output k of every band. One
+// pass over k then updates all bands at once and maps directly onto vector
+// registers: SSE2 (2 bands per instruction) or AVX (4 bands) on the host.
+// NEON on the Cortex-A9 has no double-precision lanes, so the board runs the
+// same structure-of-arrays loop in scalar code, which still saves the 20 queue
+// walks of the per-filter version.
+//
+// Each band is computed with the same operations in the same order as the
+// scalar code, so outputs match filter_iirFilter() to floating-point rounding.
+
+#define IIR_BANK_B_COEFFICIENT_COUNT 11 // Taps on the FIR output (yQueue).
+#define IIR_BANK_A_COEFFICIENT_COUNT 10 // Taps on past outputs (zQueue).
+#define IIR_BANK_LANE_COUNT                                                    \
+  12 // FILTER_FREQUENCY_COUNT rounded up to a multiple of 4 (AVX width).
+
+typedef struct {
+  // b[k][band] and a[k][band]. Lanes past FILTER_FREQUENCY_COUNT are 0.0.
+  double b[IIR_BANK_B_COEFFICIENT_COUNT][IIR_BANK_LANE_COUNT]
+      __attribute__((aligned(32)));
+  double a[IIR_BANK_A_COEFFICIENT_COUNT][IIR_BANK_LANE_COUNT]
+      __attribute__((aligned(32)));
+  // Past outputs, stored twice so z[newest - k] is z[zNewest + k][band]
+  // without wrapping.
+  double z[2 * IIR_BANK_A_COEFFICIENT_COUNT][IIR_BANK_LANE_COUNT]
+      __attribute__((aligned(32)));
+  // Past FIR outputs (shared by all bands), also stored twice.
+  double y[2 * IIR_BANK_B_COEFFICIENT_COUNT];
+  uint16_t yNewest; // Index of the newest FIR output in y.
+  uint16_t zNewest; // Index of the newest outputs in z.
+} iirBank_t;
+
+// Copies the coefficients into the bank and zeroes the state.
+// bCoefficients[band] has IIR_BANK_B_COEFFICIENT_COUNT values and
+// aCoefficients[band] has IIR_BANK_A_COEFFICIENT_COUNT values, without the
+// leading 1 (i.e., filter_getIirACoefficientArray(band) +
+// filterTest_getIirACoefficientArrayStartingIndex()).
+void iirBank_init(iirBank_t *bank,
+                  const double *bCoefficients[FILTER_FREQUENCY_COUNT],
+                  const double *aCoefficients[FILTER_FREQUENCY_COUNT]);
+
+// Zeroes the state, equivalent to filling yQueue and every zQueue with 0.0.
+void iirBank_reset(iirBank_t *bank);
+
+// Adds a new FIR output and runs every filter. outputs[band] receives the
+// same value filter_iirFilter(band) would return.
+void iirBank_filter(iirBank_t *bank, double firOutput,
+                    double outputs[FILTER_FREQUENCY_COUNT]);
+
+#endif /* IIRBANK_H_ */
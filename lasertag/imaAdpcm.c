@@ -0,0 +1,209 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <math.h>
+#include <stdio.h>
+
+#include "benchmark.h"
+#include "imaAdpcm.h"
+
+#define IMA_ADPCM_STEP_COUNT 89
+#define IMA_ADPCM_SIGN_BIT 0x8
+#define IMA_ADPCM_NIBBLE_BITS 4
+#define IMA_ADPCM_NIBBLE_MASK 0xf
+
+// Step sizes of the IMA standard.
+static const int16_t imaAdpcm_steps[IMA_ADPCM_STEP_COUNT] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,
+    19,    21,    23,    25,    28,    31,    34,    37,    41,    45,
+    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,
+    337,   371,   408,   449,   494,   544,   598,   658,   724,   796,
+    876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,
+    5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+// Step index change for each magnitude (the low 3 bits of a nibble).
+static const int8_t imaAdpcm_stepIndexChanges[IMA_ADPCM_SIGN_BIT] = {
+    -1, -1, -1, -1, 2, 4, 6, 8};
+
+// Returns the number of bytes of data for sampleCount samples.
+uint32_t imaAdpcm_getDataSize(uint32_t sampleCount) {
+  return (sampleCount + 1) / 2;
+}
+
+// Returns the number of index entries for sampleCount samples.
+uint32_t imaAdpcm_getIndexCount(uint32_t sampleCount) {
+  return (sampleCount + IMA_ADPCM_INDEX_INTERVAL - 1) /
+         IMA_ADPCM_INDEX_INTERVAL;
+}
+
+// Decodes one nibble, updates state and returns the sample. The encoder
+// calls it too, so both keep the same state.
+static int16_t imaAdpcm_decodeNibble(imaAdpcm_state_t *state, uint8_t nibble) {
+  int32_t step = imaAdpcm_steps[state->stepIndex];
+  int32_t difference = step >> 3;
+  if (nibble & 4)
+    difference += step;
+  if (nibble & 2)
+    difference += step >> 1;
+  if (nibble & 1)
+    difference += step >> 2;
+  int32_t sample = state->predictor;
+  sample += (nibble & IMA_ADPCM_SIGN_BIT) ? -difference : difference;
+  if (sample > INT16_MAX)
+    sample = INT16_MAX;
+  else if (sample < INT16_MIN)
+    sample = INT16_MIN;
+  int32_t stepIndex = state->stepIndex +
+                      imaAdpcm_stepIndexChanges[nibble & ~IMA_ADPCM_SIGN_BIT];
+  if (stepIndex < 0)
+    stepIndex = 0;
+  else if (stepIndex >= IMA_ADPCM_STEP_COUNT)
+    stepIndex = IMA_ADPCM_STEP_COUNT - 1;
+  state->predictor = sample;
+  state->stepIndex = stepIndex;
+  return sample;
+}
+
+// Returns the nibble that brings the predictor closest to sample.
+static uint8_t imaAdpcm_encodeSample(const imaAdpcm_state_t *state,
+                                     int16_t sample) {
+  int32_t step = imaAdpcm_steps[state->stepIndex];
+  int32_t difference = sample - state->predictor;
+  uint8_t nibble = 0;
+  if (difference < 0) {
+    nibble = IMA_ADPCM_SIGN_BIT;
+    difference = -difference;
+  }
+  for (uint8_t bit = 4; bit; bit >>= 1) {
+    if (difference >= step) {
+      nibble |= bit;
+      difference -= step;
+    }
+    step >>= 1;
+  }
+  return nibble;
+}
+
+// Encodes the samples and records the state every IMA_ADPCM_INDEX_INTERVAL
+// samples.
+void imaAdpcm_encode(const int16_t samples[], uint32_t sampleCount,
+                     uint8_t data[], imaAdpcm_state_t index[]) {
+  imaAdpcm_state_t state = {samples[0], 0}; // sampleCount is at least 1.
+  for (uint32_t i = 0; i < sampleCount; i++) {
+    if (i % IMA_ADPCM_INDEX_INTERVAL == 0)
+      index[i / IMA_ADPCM_INDEX_INTERVAL] = state;
+    uint8_t nibble = imaAdpcm_encodeSample(&state, samples[i]);
+    imaAdpcm_decodeNibble(&state, nibble);
+    if (i % 2 == 0)
+      data[i / 2] = nibble;
+    else
+      data[i / 2] |= nibble << IMA_ADPCM_NIBBLE_BITS;
+  }
+}
+
+// Decodes count samples starting at position.
+void imaAdpcm_decode(const imaAdpcm_clip_t *clip, uint32_t position,
+                     imaAdpcm_state_t *state, int16_t samples[],
+                     uint32_t count) {
+  imaAdpcm_state_t local = *state; // Kept in registers in the loop.
+  for (uint32_t i = 0; i < count; i++, position++) {
+    uint8_t nibble = (clip->data[position / 2] >>
+                      (position % 2 * IMA_ADPCM_NIBBLE_BITS)) &
+                     IMA_ADPCM_NIBBLE_MASK;
+    int16_t sample = imaAdpcm_decodeNibble(&local, nibble);
+    if (samples != NULL)
+      samples[i] = sample;
+  }
+  *state = local;
+}
+
+// Starts from the index entry at or before position and decodes up to it.
+void imaAdpcm_seek(const imaAdpcm_clip_t *clip, uint32_t position,
+                   imaAdpcm_state_t *state) {
+  uint32_t entry = position / IMA_ADPCM_INDEX_INTERVAL;
+  *state = clip->index[entry];
+  uint32_t start = entry * IMA_ADPCM_INDEX_INTERVAL;
+  imaAdpcm_decode(clip, start, state, NULL, position - start);
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define IMA_ADPCM_TEST_SAMPLE_COUNT 48000 // One second at 48 kHz.
+#define IMA_ADPCM_TEST_AMPLITUDE 20000
+#define IMA_ADPCM_TEST_MIN_SNR_DB 20.0
+#define IMA_ADPCM_TEST_PIECE_SIZE 37 // Not a divisor of the index interval.
+#define IMA_ADPCM_TEST_SEEK_POSITION (3 * IMA_ADPCM_INDEX_INTERVAL + 501)
+
+static int16_t imaAdpcm_testSamples[IMA_ADPCM_TEST_SAMPLE_COUNT];
+static int16_t imaAdpcm_testDecoded[IMA_ADPCM_TEST_SAMPLE_COUNT];
+static uint8_t imaAdpcm_testData[(IMA_ADPCM_TEST_SAMPLE_COUNT + 1) / 2];
+static imaAdpcm_state_t
+    imaAdpcm_testIndex[(IMA_ADPCM_TEST_SAMPLE_COUNT +
+                        IMA_ADPCM_INDEX_INTERVAL - 1) /
+                       IMA_ADPCM_INDEX_INTERVAL];
+
+// Encodes a sweep from 100 Hz to 8 kHz (at 48 kHz), decodes it in pieces of
+// IMA_ADPCM_TEST_PIECE_SIZE samples, checks the signal-to-noise ratio and
+// that decoding after a seek gives the same samples.
+bool imaAdpcm_runTest() {
+  const double sampleRate = 48000.0;
+  const double startHz = 100.0, endHz = 8000.0;
+  double phase = 0.0;
+  for (uint32_t i = 0; i < IMA_ADPCM_TEST_SAMPLE_COUNT; i++) {
+    double hz = startHz + (endHz - startHz) * i / IMA_ADPCM_TEST_SAMPLE_COUNT;
+    phase += 2.0 * M_PI * hz / sampleRate;
+    imaAdpcm_testSamples[i] = IMA_ADPCM_TEST_AMPLITUDE * sin(phase);
+  }
+  imaAdpcm_encode(imaAdpcm_testSamples, IMA_ADPCM_TEST_SAMPLE_COUNT,
+                  imaAdpcm_testData, imaAdpcm_testIndex);
+  imaAdpcm_clip_t clip = {imaAdpcm_testData, imaAdpcm_testIndex,
+                          IMA_ADPCM_TEST_SAMPLE_COUNT};
+  imaAdpcm_state_t state = clip.index[0];
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t i = 0; i < IMA_ADPCM_TEST_SAMPLE_COUNT;
+       i += IMA_ADPCM_TEST_PIECE_SIZE) {
+    uint32_t count = IMA_ADPCM_TEST_SAMPLE_COUNT - i;
+    if (count > IMA_ADPCM_TEST_PIECE_SIZE)
+      count = IMA_ADPCM_TEST_PIECE_SIZE;
+    imaAdpcm_decode(&clip, i, &state, &imaAdpcm_testDecoded[i], count);
+  }
+  double nanoseconds = benchmark_elapsedNanoseconds(start, benchmark_now());
+  double signal = 0.0, noise = 0.0;
+  for (uint32_t i = 0; i < IMA_ADPCM_TEST_SAMPLE_COUNT; i++) {
+    double error = imaAdpcm_testDecoded[i] - imaAdpcm_testSamples[i];
+    signal += (double)imaAdpcm_testSamples[i] * imaAdpcm_testSamples[i];
+    noise += error * error;
+  }
+  double snr = 10.0 * log10(signal / noise);
+  bool success = true;
+  if (snr < IMA_ADPCM_TEST_MIN_SNR_DB) {
+    printf("* Error: signal-to-noise ratio is %.1lf dB, should be at least "
+           "%.1lf dB.\n",
+           snr, IMA_ADPCM_TEST_MIN_SNR_DB);
+    success = false;
+  }
+  int16_t sample;
+  imaAdpcm_seek(&clip, IMA_ADPCM_TEST_SEEK_POSITION, &state);
+  imaAdpcm_decode(&clip, IMA_ADPCM_TEST_SEEK_POSITION, &state, &sample, 1);
+  if (sample != imaAdpcm_testDecoded[IMA_ADPCM_TEST_SEEK_POSITION]) {
+    printf("* Error: sample %u is %d after a seek, should be %d.\n",
+           IMA_ADPCM_TEST_SEEK_POSITION, sample,
+           imaAdpcm_testDecoded[IMA_ADPCM_TEST_SEEK_POSITION]);
+    success = false;
+  }
+  printf("Signal-to-noise ratio %.1lf dB, %.2lf ns per decoded sample.\n", snr,
+         nanoseconds / IMA_ADPCM_TEST_SAMPLE_COUNT);
+  printf("=== IMA-ADPCM test %s.\n", success ? "passed" : "failed");
+  return success;
+}
@@ -0,0 +1,74 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef IMAADPCM_H_
+#define IMAADPCM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// IMA-ADPCM coding of the sound clips: 4 bits per sample instead of 16, so a
+// clip takes a quarter of the memory of the arrays wav2c writes by default
+// (see wav2c -a). Samples are signed 16-bit PCM, as in the WAV file.
+//
+// The data holds two samples per byte, the first in the low nibble. Decoding
+// a sample needs the predictor and step index left by the previous one, so an
+// index table stores that state every IMA_ADPCM_INDEX_INTERVAL samples. A
+// clip can then be decoded from any of those points, e.g., to skip ahead,
+// without decoding it from the start. Playback decodes in order from the
+// first entry and only needs the state it carries along.
+//
+// Decoding a sample takes a table lookup, a few shifts and adds and a clamp;
+// imaAdpcm_runTest() prints the time per sample.
+
+#define IMA_ADPCM_INDEX_INTERVAL 1024 // Samples per index entry, even.
+
+// Decoder state before a sample.
+typedef struct {
+  int16_t predictor; // The previous sample.
+  uint8_t stepIndex; // Index into the step size table.
+} imaAdpcm_state_t;
+
+// An encoded clip, as written by wav2c -a.
+typedef struct {
+  const uint8_t *data;           // Two samples per byte, low nibble first.
+  const imaAdpcm_state_t *index; // State before every INDEX_INTERVAL samples.
+  uint32_t sampleCount;
+} imaAdpcm_clip_t;
+
+// Returns the number of bytes of data for sampleCount samples.
+uint32_t imaAdpcm_getDataSize(uint32_t sampleCount);
+
+// Returns the number of index entries for sampleCount samples.
+uint32_t imaAdpcm_getIndexCount(uint32_t sampleCount);
+
+// Encodes sampleCount samples into data and index, sized with
+// imaAdpcm_getDataSize() and imaAdpcm_getIndexCount().
+void imaAdpcm_encode(const int16_t samples[], uint32_t sampleCount,
+                     uint8_t data[], imaAdpcm_state_t index[]);
+
+// Sets state to the state before sample position of clip: starts from the
+// index entry at or before position and decodes up to it.
+void imaAdpcm_seek(const imaAdpcm_clip_t *clip, uint32_t position,
+                   imaAdpcm_state_t *state);
+
+// Decodes count samples of clip, starting at sample position, into samples.
+// state must be the state before position (from the index, imaAdpcm_seek() or
+// the previous call) and is left at the state after the last sample. samples
+// may be NULL to only advance state.
+void imaAdpcm_decode(const imaAdpcm_clip_t *clip, uint32_t position,
+                     imaAdpcm_state_t *state, int16_t samples[],
+                     uint32_t count);
+
+// Encodes a sweep, checks the signal-to-noise ratio of the decoded samples,
+// decoding in pieces and after seeking, and prints the decoding time per
+// sample. Returns true if the test passes.
+bool imaAdpcm_runTest();
+
+#endif /* IMAADPCM_H_ */
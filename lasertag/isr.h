@@ -19,6 +19,16 @@ typedef uint32_t
 // accurate timing. A buffer for storing values from the Analog to Digital
 // Converter (ADC) is implemented in isr.c Values are added to this buffer by
 // the code in isr.c. Values are removed from this buffer by code in detector.c
+// Implement the buffer with adcBuffer_t (see adcBuffer.h): isr_function() is
+// its only producer and detector() its only consumer, so neither side needs
+// to disable interrupts to access it.
+// To trace hit latencies (see latencyTrace.h), call
+// LATENCY_TRACE_STAMP_SAMPLE() in isr_function() after each successful
+// adcBuffer_push().
+// To call the state machines only when they are due (see tickDispatcher.h),
+// call tickDispatcher_init() first in isr_init() and tickDispatcher_tick() in
+// isr_function() instead of the _tick() functions of the modules that arm
+// themselves.
 
 // Performs inits for anything in isr.c
 void isr_init();
@@ -32,7 +42,16 @@ void isr_addDataToAdcBuffer(isr_AdcValue_t value);
 // This removes a value from the ADC buffer.
 isr_AdcValue_t isr_removeDataFromAdcBuffer();
 
+// This removes up to maxCount values from the ADC buffer in one bulk copy
+// (adcBuffer_popN()), oldest first, and returns how many were removed.
+uint32_t isr_removeDataFromAdcBufferN(isr_AdcValue_t values[],
+                                      uint32_t maxCount);
+
 // This returns the number of values in the ADC buffer.
 uint32_t isr_adcBufferElementCount();
 
+// This returns the ADC buffer itself, for its statistics and watermark (see
+// adcBuffer.h). The buffer must not be pushed or popped through it.
+struct adcBuffer *isr_getAdcBuffer();
+
 #endif /* ISR_H_ */
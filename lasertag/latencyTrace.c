@@ -0,0 +1,244 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "latencyTrace.h"
+
+#ifdef ZYBO_BOARD
+#include "xparameters.h"
+#define LATENCY_TRACE_TICKS_PER_MICROSECOND                                    \
+  (XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 1.0E6) // profiler_now() is cycles.
+#else
+#define LATENCY_TRACE_TICKS_PER_MICROSECOND 1.0E3 // profiler_now() is ns.
+#endif
+
+#define LATENCY_TRACE_SAMPLE_STAMP_MASK (LATENCY_TRACE_SAMPLE_STAMP_COUNT - 1)
+#define LATENCY_TRACE_PERCENTILE_COUNT 3
+#define LATENCY_TRACE_TEST_HIT_COUNT (LATENCY_TRACE_RECORD_COUNT + 10)
+#define LATENCY_TRACE_TEST_SAMPLES_PER_HIT 100
+
+static const double latencyTrace_percentiles[LATENCY_TRACE_PERCENTILE_COUNT] = {
+    0.5, 0.9, 0.99};
+
+// Indexed by latencyTrace_reaction_t.
+static const char *latencyTrace_reactionNames[LATENCY_TRACE_REACTION_COUNT] = {
+    "LED", "sound", "display"};
+
+// Written only by the ISR. The count is written after the time-stamp, so the
+// time-stamp of every sequence number below the count is valid.
+static volatile profiler_time_t
+    latencyTrace_sampleStamps[LATENCY_TRACE_SAMPLE_STAMP_COUNT];
+static volatile uint32_t latencyTrace_sampleCount;
+
+static bool latencyTrace_hitSamplePending; // Set until the next detection.
+static uint32_t latencyTrace_hitSample;
+
+static latencyTrace_record_t latencyTrace_records[LATENCY_TRACE_RECORD_COUNT];
+static uint32_t latencyTrace_recordTotal; // Records ever added.
+
+// Clears the sample sequence, the pending hit sample and all records.
+void latencyTrace_init() {
+  latencyTrace_sampleCount = 0;
+  latencyTrace_hitSamplePending = false;
+  latencyTrace_recordTotal = 0;
+}
+
+// Time-stamps the next sample sequence number.
+void latencyTrace_stampSample() {
+  uint32_t sequence = latencyTrace_sampleCount;
+  latencyTrace_sampleStamps[sequence & LATENCY_TRACE_SAMPLE_STAMP_MASK] =
+      profiler_now();
+  latencyTrace_sampleCount = sequence + 1;
+}
+
+// Returns the number of samples stamped so far.
+uint32_t latencyTrace_getSampleCount() { return latencyTrace_sampleCount; }
+
+// Keeps the first hit sample named after each detection.
+void latencyTrace_setHitSample(uint32_t sequence) {
+  if (latencyTrace_hitSamplePending)
+    return;
+  latencyTrace_hitSample = sequence;
+  latencyTrace_hitSamplePending = true;
+}
+
+// Adds a record for the pending hit sample, or the newest popped sample.
+void latencyTrace_recordDetection(uint16_t frequencyNumber,
+                                  uint32_t unconsumedSampleCount) {
+  profiler_time_t now = profiler_now();
+  uint32_t sequence =
+      latencyTrace_hitSamplePending
+          ? latencyTrace_hitSample
+          : latencyTrace_sampleCount - unconsumedSampleCount - 1;
+  latencyTrace_hitSamplePending = false;
+  latencyTrace_record_t *record =
+      &latencyTrace_records[latencyTrace_recordTotal %
+                            LATENCY_TRACE_RECORD_COUNT];
+  record->sampleSequence = sequence;
+  record->frequencyNumber = frequencyNumber;
+  record->sampleTime =
+      latencyTrace_sampleStamps[sequence & LATENCY_TRACE_SAMPLE_STAMP_MASK];
+  record->detectionTime = now;
+  record->reactionMask = 0;
+  latencyTrace_recordTotal++;
+}
+
+// Stamps the newest record with the first reaction of each kind.
+void latencyTrace_recordReaction(latencyTrace_reaction_t reaction) {
+  if (latencyTrace_recordTotal == 0)
+    return;
+  latencyTrace_record_t *record =
+      &latencyTrace_records[(latencyTrace_recordTotal - 1) %
+                            LATENCY_TRACE_RECORD_COUNT];
+  if (record->reactionMask & (1 << reaction))
+    return;
+  record->reactionTime[reaction] = profiler_now();
+  record->reactionMask |= 1 << reaction;
+}
+
+// Returns the number of records in the ring.
+uint32_t latencyTrace_getRecordCount() {
+  return latencyTrace_recordTotal < LATENCY_TRACE_RECORD_COUNT
+             ? latencyTrace_recordTotal
+             : LATENCY_TRACE_RECORD_COUNT;
+}
+
+// Returns record index, 0 being the oldest one still in the ring.
+const latencyTrace_record_t *latencyTrace_getRecord(uint32_t index) {
+  uint32_t oldest = latencyTrace_recordTotal - latencyTrace_getRecordCount();
+  return &latencyTrace_records[(oldest + index) % LATENCY_TRACE_RECORD_COUNT];
+}
+
+// Converts a latency in profiler_now() units to microseconds.
+static double latencyTrace_toMicroseconds(profiler_time_t latency) {
+  return latency / LATENCY_TRACE_TICKS_PER_MICROSECOND;
+}
+
+// Used by qsort() to sort latencies.
+static int latencyTrace_compare(const void *a, const void *b) {
+  profiler_time_t left = *(const profiler_time_t *)a;
+  profiler_time_t right = *(const profiler_time_t *)b;
+  return (left > right) - (left < right);
+}
+
+// Prints min, percentiles and max of count latencies, which are sorted first.
+static void latencyTrace_printDistribution(const char *name,
+                                           profiler_time_t latencies[],
+                                           uint32_t count) {
+  if (count == 0) {
+    printf("%-10s %5u\n", name, count);
+    return;
+  }
+  qsort(latencies, count, sizeof(profiler_time_t), latencyTrace_compare);
+  printf("%-10s %5u %9.1lf", name, count,
+         latencyTrace_toMicroseconds(latencies[0]));
+  for (uint16_t p = 0; p < LATENCY_TRACE_PERCENTILE_COUNT; p++) {
+    uint32_t rank = (uint32_t)ceil(latencyTrace_percentiles[p] * count);
+    printf(" %9.1lf", latencyTrace_toMicroseconds(latencies[rank - 1]));
+  }
+  printf(" %9.1lf\n", latencyTrace_toMicroseconds(latencies[count - 1]));
+}
+
+// Prints the records oldest first, then the distributions. Latencies are
+// measured from the sample time-stamp; reactions a record did not get are
+// left empty.
+void latencyTrace_print() {
+  static profiler_time_t latencies[LATENCY_TRACE_RECORD_COUNT];
+  uint32_t recordCount = latencyTrace_getRecordCount();
+  printf("Hit latencies in microseconds after the sample (%u hits, last %u "
+         "kept):\n",
+         latencyTrace_recordTotal, recordCount);
+  printf("sample,frequency,detection");
+  for (uint16_t r = 0; r < LATENCY_TRACE_REACTION_COUNT; r++)
+    printf(",%s", latencyTrace_reactionNames[r]);
+  printf("\n");
+  for (uint32_t i = 0; i < recordCount; i++) {
+    const latencyTrace_record_t *record = latencyTrace_getRecord(i);
+    printf("%u,%u,%.1lf", record->sampleSequence, record->frequencyNumber,
+           latencyTrace_toMicroseconds(record->detectionTime -
+                                       record->sampleTime));
+    for (uint16_t r = 0; r < LATENCY_TRACE_REACTION_COUNT; r++)
+      if (record->reactionMask & (1 << r))
+        printf(",%.1lf", latencyTrace_toMicroseconds(record->reactionTime[r] -
+                                                     record->sampleTime));
+      else
+        printf(",");
+    printf("\n");
+  }
+  printf("%-10s %5s %9s %9s %9s %9s %9s\n", "Latency", "count", "min", "p50",
+         "p90", "p99", "max");
+  for (uint32_t i = 0; i < recordCount; i++) {
+    const latencyTrace_record_t *record = latencyTrace_getRecord(i);
+    latencies[i] = record->detectionTime - record->sampleTime;
+  }
+  latencyTrace_printDistribution("detection", latencies, recordCount);
+  for (uint16_t r = 0; r < LATENCY_TRACE_REACTION_COUNT; r++) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < recordCount; i++) {
+      const latencyTrace_record_t *record = latencyTrace_getRecord(i);
+      if (record->reactionMask & (1 << r))
+        latencies[count++] = record->reactionTime[r] - record->sampleTime;
+    }
+    latencyTrace_printDistribution(latencyTrace_reactionNames[r], latencies,
+                                   count);
+  }
+}
+
+// Stamps samples and detects a hit every LATENCY_TRACE_TEST_SAMPLES_PER_HIT
+// samples, alternating between a named hit sample and the newest-popped
+// fallback, with reactions on every other hit. Then checks that the ring kept
+// the newest records in order, with the right samples, and that sample,
+// detection and reaction time-stamps are in order.
+bool latencyTrace_runTest() {
+  profiler_time_t start = profiler_now(); // Time-stamps are compared to this.
+  latencyTrace_init();
+  for (uint32_t hit = 0; hit < LATENCY_TRACE_TEST_HIT_COUNT; hit++) {
+    for (uint32_t i = 0; i < LATENCY_TRACE_TEST_SAMPLES_PER_HIT; i++)
+      latencyTrace_stampSample();
+    uint32_t newest = latencyTrace_getSampleCount() - 1;
+    if (hit % 2) {
+      latencyTrace_setHitSample(newest - 10);
+      latencyTrace_setHitSample(newest - 5); // Ignored, not the first.
+      latencyTrace_recordDetection(hit % FILTER_FREQUENCY_COUNT, 0);
+      latencyTrace_recordReaction(LATENCY_TRACE_REACTION_DISPLAY);
+      latencyTrace_recordReaction(LATENCY_TRACE_REACTION_LED);
+      latencyTrace_recordReaction(LATENCY_TRACE_REACTION_DISPLAY); // Ignored.
+    } else {
+      latencyTrace_recordDetection(hit % FILTER_FREQUENCY_COUNT, 20);
+    }
+  }
+  bool success = latencyTrace_getRecordCount() == LATENCY_TRACE_RECORD_COUNT;
+  uint32_t firstHit = LATENCY_TRACE_TEST_HIT_COUNT - LATENCY_TRACE_RECORD_COUNT;
+  for (uint32_t i = 0; success && i < LATENCY_TRACE_RECORD_COUNT; i++) {
+    const latencyTrace_record_t *record = latencyTrace_getRecord(i);
+    uint32_t hit = firstHit + i;
+    uint32_t newest = (hit + 1) * LATENCY_TRACE_TEST_SAMPLES_PER_HIT - 1;
+    uint32_t sequence = (hit % 2) ? newest - 10 : newest - 20;
+    uint8_t reactionMask = (hit % 2) ? (1 << LATENCY_TRACE_REACTION_DISPLAY |
+                                        1 << LATENCY_TRACE_REACTION_LED)
+                                     : 0;
+    if (record->sampleSequence != sequence ||
+        record->frequencyNumber != hit % FILTER_FREQUENCY_COUNT ||
+        record->reactionMask != reactionMask ||
+        record->sampleTime - start > record->detectionTime - start ||
+        ((hit % 2) && record->detectionTime - start >
+                          record->reactionTime[LATENCY_TRACE_REACTION_LED] -
+                              start)) {
+      printf("* Error: latency record %u (sample %u, frequency %u) is wrong.\n",
+             i, record->sampleSequence, record->frequencyNumber);
+      success = false;
+    }
+  }
+  printf("=== Latency trace test %s.\n", success ? "passed" : "failed");
+  latencyTrace_init();
+  return success;
+}
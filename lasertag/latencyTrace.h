@@ -0,0 +1,125 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef LATENCYTRACE_H_
+#define LATENCYTRACE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "profiler.h" // profiler_now(), profiler_time_t
+
+// Traces the latency from the ADC sample that completes a hit to the hit being
+// seen by the game (detector_hitDetected() returning true in the main loop)
+// and to the reactions that follow it (hit LED, sound, histogram redraw).
+//
+// - isr_function() calls LATENCY_TRACE_STAMP_SAMPLE() after each successful
+//   adcBuffer_push(). Every pushed sample gets a sequence number (0, 1, 2, ...
+//   in push order, the same order in which the detector pops them) and a
+//   time-stamp in a ring of LATENCY_TRACE_SAMPLE_STAMP_COUNT entries.
+// - When the pipeline decides a hit, it names the sample it was processing
+//   with LATENCY_TRACE_HIT_SAMPLE(). detectorBatch_run() does this; its sample
+//   count and the sequence numbers both start at 0 if detectorBatch_init() and
+//   latencyTrace_init() are called before interrupts start. Without it, the
+//   newest sample popped so far is used, which hides the time the detector
+//   spent draining the buffer after the hit.
+// - runningModes_shooter() calls LATENCY_TRACE_DETECTION() when
+//   detector_hitDetected() returns true, which adds a record to a ring of
+//   LATENCY_TRACE_RECORD_COUNT records.
+// - LATENCY_TRACE_REACTION() stamps the newest record with the first reaction
+//   of each kind after the detection: sound_tick() when a sound starts, the
+//   shooter loop after the histogram redraw, and hitLedTimer_turnLedOn() (your
+//   hitLedTimer.c) for the LED. A shot fired right after a hit also plays a
+//   sound, so the sound latency is an upper bound.
+//
+// latencyTrace_print() writes the records and the latency distribution to the
+// console (the UART on the board) at the end of the run. Time-stamps come from
+// profiler_now(), so profiler_init() must be called first on the board to
+// start the cycle counter. Unless LATENCY_TRACE_ENABLED is defined, the macros
+// expand to nothing.
+
+// Uncomment to trace hit latencies.
+//#define LATENCY_TRACE_ENABLED
+
+// Must be a power of two, larger than the most samples that can wait in the
+// ADC buffer, so a sample's time-stamp is still there when its hit is seen.
+#define LATENCY_TRACE_SAMPLE_STAMP_COUNT 8192
+#define LATENCY_TRACE_RECORD_COUNT 256 // The oldest records are overwritten.
+
+// Reactions to a hit, in addition to the detection itself.
+typedef enum {
+  LATENCY_TRACE_REACTION_LED,     // Hit LED turned on.
+  LATENCY_TRACE_REACTION_SOUND,   // sound_tick() started playing a sound.
+  LATENCY_TRACE_REACTION_DISPLAY, // Hit counts redrawn on the TFT.
+  LATENCY_TRACE_REACTION_COUNT
+} latencyTrace_reaction_t;
+
+typedef struct {
+  uint32_t sampleSequence; // Sequence number of the sample that completed it.
+  uint16_t frequencyNumber;
+  profiler_time_t sampleTime;    // When the sample was pushed.
+  profiler_time_t detectionTime; // When the main loop saw the hit.
+  profiler_time_t reactionTime[LATENCY_TRACE_REACTION_COUNT];
+  uint8_t reactionMask; // Bit r is set once reactionTime[r] is valid.
+} latencyTrace_record_t;
+
+#ifdef LATENCY_TRACE_ENABLED
+#define LATENCY_TRACE_STAMP_SAMPLE() latencyTrace_stampSample()
+#define LATENCY_TRACE_HIT_SAMPLE(sequence) latencyTrace_setHitSample(sequence)
+#define LATENCY_TRACE_DETECTION(frequencyNumber, unconsumedSampleCount)        \
+  latencyTrace_recordDetection((frequencyNumber), (unconsumedSampleCount))
+#define LATENCY_TRACE_REACTION(reaction) latencyTrace_recordReaction(reaction)
+#else
+#define LATENCY_TRACE_STAMP_SAMPLE()
+#define LATENCY_TRACE_HIT_SAMPLE(sequence)
+#define LATENCY_TRACE_DETECTION(frequencyNumber, unconsumedSampleCount)
+#define LATENCY_TRACE_REACTION(reaction)
+#endif
+
+// Clears the sample sequence, the pending hit sample and all records. Call
+// before interrupts start.
+void latencyTrace_init();
+
+// ISR only. Time-stamps the next sample sequence number.
+void latencyTrace_stampSample();
+
+// Returns the number of samples stamped so far (the next sequence number).
+uint32_t latencyTrace_getSampleCount();
+
+// Names the sample that completed a hit. Only the first call after each
+// detection counts, so it can be called at every decimated sample for which
+// detector_hitDetected() is true.
+void latencyTrace_setHitSample(uint32_t sequence);
+
+// Adds a record for a hit seen now. If no hit sample was set, the newest
+// popped sample is used: latencyTrace_getSampleCount() minus
+// unconsumedSampleCount (isr_adcBufferElementCount()) minus 1.
+void latencyTrace_recordDetection(uint16_t frequencyNumber,
+                                  uint32_t unconsumedSampleCount);
+
+// Stamps the newest record with a reaction, unless it already has one of this
+// kind. Does nothing before the first detection.
+void latencyTrace_recordReaction(latencyTrace_reaction_t reaction);
+
+// Returns the number of records in the ring (at most
+// LATENCY_TRACE_RECORD_COUNT).
+uint32_t latencyTrace_getRecordCount();
+
+// Returns record index, 0 being the oldest one still in the ring.
+const latencyTrace_record_t *latencyTrace_getRecord(uint32_t index);
+
+// Prints one CSV line per record (latencies in microseconds after the sample)
+// and, for the detection and each reaction, min, p50, p90, p99 and max.
+void latencyTrace_print();
+
+// Feeds synthetic samples, hits and reactions through the tracer and checks
+// the records, including ring wrap-around. Returns true if the test passes.
+bool latencyTrace_runTest();
+
+#endif /* LATENCYTRACE_H_ */
@@ -19,22 +19,37 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // Uncomment to run two-player mode, Milestone 5
 // #define RUNNING_MODE_M5
 
+// Uncomment to record raw ADC samples for the host replay harness (replay/)
+// #define RUNNING_MODE_CAPTURE
+
 #include <assert.h>
 #include <stdio.h>
 
+#include "adcBuffer.h"
+#include "adcCapture.h"
 #include "buttons.h"
 #include "detector.h"
 #include "filter.h"
 #include "filterTest.h"
 #include "hitLedTimer.h"
+#include "imaAdpcm.h"
 #include "interrupts.h"
 #include "isr.h"
+#include "latencyTrace.h"
 #include "leds.h"
 #include "lockoutTimer.h"
+#include "metrics.h"
 #include "mio.h"
+#include "powerRank.h"
+#include "profiler.h"
 #include "runningModes.h"
+#include "scheduler.h"
 #include "sound.h"
+#include "soundBank.h"
+#include "soundMixer.h"
+#include "soundResampler.h"
 #include "switches.h"
+#include "tickDispatcher.h"
 #include "transmitter.h"
 #include "trigger.h"
 
@@ -47,6 +62,22 @@ int main() {
 #ifdef RUNNING_MODE_TESTS
   // interrupts not needed for these tests
   queue_runTest(); // M1
+  // queue_runBenchmark(); // Masked vs. general queue read access.
+  // queue_runBatchBenchmark(); // Batched vs. per-element queue throughput.
+  // adcBuffer_runTest(); // Lock-free ADC buffer.
+  // adcCapture_runTest(); // Capture-file format for the replay harness.
+  // powerRank_runTest(); // Incremental power ordering for hit detection.
+  // profiler_runTest(); // Per-stage profiling histograms.
+  // latencyTrace_runTest(); // Hit latency records.
+  // metrics_runTest(); // Metrics sampling ring.
+  // scheduler_runTest(); // Main-loop scheduler.
+  // histogram_runSelfTest(); // Top labels and partial bar redraws.
+  // tickDispatcher_runTest(); // Event-driven state machine ticks.
+  // tickDispatcher_runBenchmark(); // Idle tick cost, with and without it.
+  // soundMixer_runTest(); // Multi-voice sound mixing.
+  // imaAdpcm_runTest(); // Compressed sound clips.
+  // soundBank_runTest(); // Sound clips loaded at run time.
+  // soundResampler_runTest(); // Sample-rate conversion and its cache.
   // filterTest_runTest(); // M3 T1
   // transmitter_runTest(); // M3 T2
   // detector_runTest(); // M3 T3
@@ -91,5 +122,10 @@ int main() {
   runningModes_twoTeams();
 #endif
 
+#ifdef RUNNING_MODE_CAPTURE
+  // Nothing is printed first: on the board the capture goes to stdout.
+  runningModes_captureAdcValues();
+#endif
+
   return 0;
 }
@@ -0,0 +1,214 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+
+#include "metrics.h"
+
+#define METRICS_LINE_PREFIX "M"
+#define METRICS_TEST_SAMPLE_COUNT (METRICS_RING_SAMPLE_COUNT + 5)
+#define METRICS_TEST_PERIOD_INVOCATIONS 250
+
+#define METRICS_HIT_NAME_PREFIX "hits"
+#define METRICS_HIT_NAME_SIZE 12 // "hits" + up to 7 digits + '\0'.
+
+// Indexed by metrics_id_t, up to the hit counters.
+static const char *metrics_names[METRICS_HITS_0] = {
+    "detectorCalls", "samples", "dropped", "isrPermille", "adcPeak"};
+
+// Names of the hit counters, "hits0" to "hits<FILTER_FREQUENCY_COUNT - 1>",
+// filled in by metrics_init().
+static char metrics_hitNames[FILTER_FREQUENCY_COUNT][METRICS_HIT_NAME_SIZE];
+
+// Metric values since the previous sample (counters and peaks) or latest
+// values (gauges).
+static metrics_value_t metrics_values[METRICS_COUNT];
+
+static metrics_sample_t metrics_ring[METRICS_RING_SAMPLE_COUNT];
+static uint32_t metrics_takenCount; // Samples ever taken.
+static uint32_t metrics_takeIndex;  // Sequence number of the next to print.
+static uint32_t metrics_nextTick;   // When the next sample is due.
+static metrics_updateFunction_t metrics_update;
+
+// Returns the kind of a metric.
+metrics_kind_t metrics_getKind(metrics_id_t id) {
+  switch (id) {
+  case METRICS_ISR_TIME_PERMILLE:
+    return METRICS_KIND_GAUGE;
+  case METRICS_ADC_QUEUE_PEAK:
+    return METRICS_KIND_PEAK;
+  default:
+    return METRICS_KIND_COUNTER;
+  }
+}
+
+// Returns the CSV column name of a metric.
+const char *metrics_getName(metrics_id_t id) {
+  if (id < METRICS_HITS_0)
+    return metrics_names[id];
+  return metrics_hitNames[id - METRICS_HITS_0];
+}
+
+// Prints the CSV header.
+static void metrics_printHeader() {
+  printf(METRICS_LINE_PREFIX ",sequence,tick");
+  for (uint16_t id = 0; id < METRICS_COUNT; id++)
+    printf(",%s", metrics_getName(id));
+  printf("\n");
+}
+
+// Clears all metrics and the ring, and prints the CSV header.
+void metrics_init(uint32_t now, metrics_updateFunction_t update) {
+  for (uint16_t f = 0; f < FILTER_FREQUENCY_COUNT; f++)
+    snprintf(metrics_hitNames[f], METRICS_HIT_NAME_SIZE,
+             METRICS_HIT_NAME_PREFIX "%u", f);
+  for (uint16_t id = 0; id < METRICS_COUNT; id++)
+    metrics_values[id] = 0;
+  metrics_takenCount = 0;
+  metrics_takeIndex = 0;
+  metrics_nextTick = now + METRICS_SAMPLE_PERIOD_TICKS;
+  metrics_update = update;
+  metrics_printHeader();
+}
+
+// Adds amount to a counter.
+void metrics_add(metrics_id_t id, metrics_value_t amount) {
+  metrics_values[id] += amount;
+}
+
+// Sets a gauge.
+void metrics_set(metrics_id_t id, metrics_value_t value) {
+  metrics_values[id] = value;
+}
+
+// Raises a peak to value if value is larger.
+void metrics_raise(metrics_id_t id, metrics_value_t value) {
+  if (value > metrics_values[id])
+    metrics_values[id] = value;
+}
+
+// Copies all metrics into the ring, overwriting the oldest sample if it is
+// full, and starts the next period of the counters and peaks.
+static void metrics_takeRingSample(uint32_t now) {
+  if (metrics_update != NULL)
+    metrics_update();
+  metrics_sample_t *sample =
+      &metrics_ring[metrics_takenCount % METRICS_RING_SAMPLE_COUNT];
+  sample->sequence = metrics_takenCount;
+  sample->tick = now;
+  for (uint16_t id = 0; id < METRICS_COUNT; id++) {
+    sample->values[id] = metrics_values[id];
+    if (metrics_getKind(id) != METRICS_KIND_GAUGE)
+      metrics_values[id] = 0;
+  }
+  metrics_takenCount++;
+  if (metrics_takenCount - metrics_takeIndex > METRICS_RING_SAMPLE_COUNT)
+    metrics_takeIndex = metrics_takenCount - METRICS_RING_SAMPLE_COUNT;
+}
+
+// Returns the number of samples waiting to be printed.
+uint32_t metrics_getPendingCount() {
+  return metrics_takenCount - metrics_takeIndex;
+}
+
+// Returns and removes the oldest sample waiting to be printed.
+const metrics_sample_t *metrics_takeSample() {
+  if (metrics_getPendingCount() == 0)
+    return NULL;
+  return &metrics_ring[metrics_takeIndex++ % METRICS_RING_SAMPLE_COUNT];
+}
+
+// Prints one sample as a CSV line.
+static void metrics_printSample(const metrics_sample_t *sample) {
+  printf(METRICS_LINE_PREFIX ",%u,%u", sample->sequence, sample->tick);
+  for (uint16_t id = 0; id < METRICS_COUNT; id++)
+    printf(",%u", sample->values[id]);
+  printf("\n");
+}
+
+// Takes a sample if one is due at now. The comparison is done on the
+// difference so that it keeps working when the clock wraps around.
+static bool metrics_sampleIfDue(uint32_t now) {
+  if ((int32_t)(now - metrics_nextTick) < 0)
+    return false;
+  metrics_takeRingSample(now);
+  metrics_nextTick += METRICS_SAMPLE_PERIOD_TICKS;
+  // After a stall, start over from now instead of sampling to catch up.
+  if ((int32_t)(now - metrics_nextTick) >= 0)
+    metrics_nextTick = now + METRICS_SAMPLE_PERIOD_TICKS;
+  return true;
+}
+
+// Samples when due, then prints at most one sample.
+bool metrics_poll(uint32_t now) {
+  bool sampled = metrics_sampleIfDue(now);
+  const metrics_sample_t *sample = metrics_takeSample();
+  if (sample != NULL)
+    metrics_printSample(sample);
+  return sampled;
+}
+
+// Prints all samples not yet printed.
+void metrics_flush() {
+  const metrics_sample_t *sample;
+  while ((sample = metrics_takeSample()) != NULL)
+    metrics_printSample(sample);
+}
+
+// Used by metrics_runTest() as the update function.
+static uint32_t metrics_testUpdateCount;
+static void metrics_testUpdate() {
+  metrics_testUpdateCount++;
+  metrics_set(METRICS_ISR_TIME_PERMILLE, metrics_testUpdateCount);
+}
+
+// Takes METRICS_TEST_SAMPLE_COUNT samples, polling every 1000 ticks with
+// METRICS_TEST_PERIOD_INVOCATIONS detector calls and a rising ADC queue
+// between polls, but takes samples out of the ring only at the end. Checks
+// that the oldest samples were overwritten and that the counters, gauges and
+// peaks of the others are right. The clock starts close to wrapping around.
+bool metrics_runTest() {
+  const uint32_t pollTicks = 1000;
+  const uint32_t pollsPerSample = METRICS_SAMPLE_PERIOD_TICKS / pollTicks;
+  uint32_t now = UINT32_MAX - 10 * pollTicks;
+  metrics_testUpdateCount = 0;
+  metrics_init(now, metrics_testUpdate);
+  uint32_t takenCount = 0;
+  for (uint32_t poll = 1; takenCount < METRICS_TEST_SAMPLE_COUNT; poll++) {
+    metrics_add(METRICS_DETECTOR_INVOCATIONS,
+                METRICS_TEST_PERIOD_INVOCATIONS / pollsPerSample);
+    metrics_add(METRICS_HITS_0 + poll % FILTER_FREQUENCY_COUNT, 1);
+    metrics_raise(METRICS_ADC_QUEUE_PEAK, poll % pollsPerSample);
+    now += pollTicks;
+    if (metrics_sampleIfDue(now)) // Nothing is printed, so the ring overruns.
+      takenCount++;
+  }
+  bool success = metrics_getPendingCount() == METRICS_RING_SAMPLE_COUNT &&
+                 metrics_testUpdateCount == METRICS_TEST_SAMPLE_COUNT;
+  uint32_t expectedSequence =
+      METRICS_TEST_SAMPLE_COUNT - METRICS_RING_SAMPLE_COUNT;
+  const metrics_sample_t *sample;
+  while (success && (sample = metrics_takeSample()) != NULL) {
+    metrics_value_t hitTotal = 0;
+    for (uint16_t f = 0; f < FILTER_FREQUENCY_COUNT; f++)
+      hitTotal += sample->values[METRICS_HITS_0 + f];
+    if (sample->sequence != expectedSequence ||
+        sample->values[METRICS_DETECTOR_INVOCATIONS] !=
+            METRICS_TEST_PERIOD_INVOCATIONS / pollsPerSample * pollsPerSample ||
+        hitTotal != pollsPerSample ||
+        sample->values[METRICS_ISR_TIME_PERMILLE] != expectedSequence + 1 ||
+        sample->values[METRICS_ADC_QUEUE_PEAK] != pollsPerSample - 1) {
+      printf("* Error: metrics sample %u is wrong.\n", sample->sequence);
+      success = false;
+    }
+    expectedSequence++;
+  }
+  printf("=== Metrics test %s.\n", success ? "passed" : "failed");
+  return success;
+}
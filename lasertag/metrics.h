@@ -0,0 +1,128 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "filter.h" // FILTER_FREQUENCY_COUNT
+
+// Run-time metrics streamed as CSV over stdout (the UART on the board) while
+// the game runs, so long sessions can be trended and regressions caught
+// without watching the TFT. runningModes_printRunTimeStatistics() still shows
+// the totals at the end.
+//
+// Each metric is one of:
+// - a counter: metrics_add() adds to it, and each sample holds what was added
+//   since the previous sample (e.g., detector invocations per period).
+// - a gauge: metrics_set() sets it, and each sample holds the latest value.
+// - a peak: metrics_raise() keeps the largest value since the previous
+//   sample, and each sample holds that maximum (e.g., the ADC queue
+//   high-water mark).
+//
+// The main loop calls METRICS_POLL(now) with the ISR invocation count as the
+// clock. Every METRICS_SAMPLE_PERIOD_TICKS ticks it calls the update function
+// given to metrics_init() (to refresh gauges that are costly to keep current)
+// and copies all metrics into a ring of METRICS_RING_SAMPLE_COUNT samples.
+// Each poll prints at most one sample, so printing never stalls the loop for
+// more than one line; if printing falls behind, the oldest samples are
+// overwritten and the gap shows in the sequence numbers.
+//
+// Lines start with "M," so they can be picked out of other console output:
+//   M,sequence,tick,detectorCalls,samples,dropped,isrPermille,adcPeak,hits0,...
+// Unless METRICS_ENABLED is defined, the macros expand to nothing.
+
+// Uncomment to stream metrics while the game runs.
+//#define METRICS_ENABLED
+
+#define METRICS_SAMPLE_PERIOD_TICKS 100000 // 1 s of isr_function() at 100 kHz.
+#define METRICS_RING_SAMPLE_COUNT 32
+
+// The metrics. The hit counters of the FILTER_FREQUENCY_COUNT frequencies are
+// METRICS_HITS_0 + frequencyNumber.
+typedef enum {
+  METRICS_DETECTOR_INVOCATIONS, // Counter: detector calls in the main loop.
+  METRICS_SAMPLES_PROCESSED,    // Counter: ADC samples taken by the detector.
+  METRICS_DROPPED_SAMPLES,      // Counter: samples lost to a full ADC buffer.
+  METRICS_ISR_TIME_PERMILLE,    // Gauge: ISR share of the run time, in 0.1%.
+  METRICS_ADC_QUEUE_PEAK,       // Peak: most samples waiting in the buffer.
+  METRICS_HITS_0,               // Counters: hits per frequency.
+  METRICS_COUNT = METRICS_HITS_0 + FILTER_FREQUENCY_COUNT
+} metrics_id_t;
+
+typedef enum {
+  METRICS_KIND_COUNTER,
+  METRICS_KIND_GAUGE,
+  METRICS_KIND_PEAK
+} metrics_kind_t;
+
+typedef uint32_t metrics_value_t;
+
+typedef struct {
+  uint32_t sequence; // Samples taken before this one.
+  uint32_t tick;     // Clock value passed to metrics_poll().
+  metrics_value_t values[METRICS_COUNT];
+} metrics_sample_t;
+
+// Called just before each sample is taken.
+typedef void (*metrics_updateFunction_t)();
+
+#ifdef METRICS_ENABLED
+#define METRICS_ADD(id, amount) metrics_add((id), (amount))
+#define METRICS_SET(id, value) metrics_set((id), (value))
+#define METRICS_RAISE(id, value) metrics_raise((id), (value))
+#define METRICS_POLL(now) metrics_poll(now)
+#else
+#define METRICS_ADD(id, amount)
+#define METRICS_SET(id, value)
+#define METRICS_RAISE(id, value)
+#define METRICS_POLL(now)
+#endif
+
+// Clears all metrics and the ring, and prints the CSV header. The first
+// sample is taken METRICS_SAMPLE_PERIOD_TICKS after now. update may be NULL.
+void metrics_init(uint32_t now, metrics_updateFunction_t update);
+
+// Adds amount to a counter.
+void metrics_add(metrics_id_t id, metrics_value_t amount);
+
+// Sets a gauge.
+void metrics_set(metrics_id_t id, metrics_value_t value);
+
+// Raises a peak to value if value is larger.
+void metrics_raise(metrics_id_t id, metrics_value_t value);
+
+// Takes a sample if one is due at now, then prints the oldest sample not yet
+// printed, if any. Returns true if a sample was taken.
+bool metrics_poll(uint32_t now);
+
+// Prints all samples not yet printed. Call at the end of a run.
+void metrics_flush();
+
+// Returns the number of samples waiting to be printed.
+uint32_t metrics_getPendingCount();
+
+// Returns the oldest sample waiting to be printed and removes it from the
+// ring, or returns NULL if there is none.
+const metrics_sample_t *metrics_takeSample();
+
+// Returns the kind of a metric.
+metrics_kind_t metrics_getKind(metrics_id_t id);
+
+// Returns the CSV column name of a metric, e.g., "hits3". The hit counter
+// names are filled in by metrics_init().
+const char *metrics_getName(metrics_id_t id);
+
+// Drives the metrics with a synthetic clock and checks the samples, including
+// ring overrun. Returns true if the test passes.
+bool metrics_runTest();
+
+#endif /* METRICS_H_ */
@@ -0,0 +1,210 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "powerRank.h"
+
+// Sets all powers to 0.0, with the bands in numerical order.
+void powerRank_init(powerRank_t *r) {
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++) {
+    r->power[band] = 0.0;
+    r->order[band] = band;
+    r->rank[band] = band;
+  }
+}
+
+// Swaps the bands at positions i and i + 1.
+static inline void powerRank_swapWithNext(powerRank_t *r, uint16_t i) {
+  uint16_t band = r->order[i];
+  r->order[i] = r->order[i + 1];
+  r->order[i + 1] = band;
+  r->rank[r->order[i]] = i;
+  r->rank[band] = i + 1;
+}
+
+// Moves the band up while it is above its neighbor, or down while it is below.
+void powerRank_update(powerRank_t *r, uint16_t band, double power) {
+  r->power[band] = power;
+  uint16_t i = r->rank[band];
+  while (i + 1 < FILTER_FREQUENCY_COUNT && power > r->power[r->order[i + 1]])
+    powerRank_swapWithNext(r, i++);
+  while (i > 0 && power < r->power[r->order[i - 1]])
+    powerRank_swapWithNext(r, --i);
+}
+
+// Insertion sort of order[] starting from the previous order.
+void powerRank_updateAll(powerRank_t *r, const double powerValues[]) {
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    r->power[band] = powerValues[band];
+  for (uint16_t i = 1; i < FILTER_FREQUENCY_COUNT; i++) {
+    uint16_t band = r->order[i];
+    double power = r->power[band];
+    uint16_t j = i;
+    for (; j > 0 && r->power[r->order[j - 1]] > power; j--) {
+      r->order[j] = r->order[j - 1];
+      r->rank[r->order[j]] = j;
+    }
+    r->order[j] = band;
+    r->rank[band] = j;
+  }
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define POWER_RANK_TEST_STEP_COUNT 100000 // Ten seconds of decimated samples.
+#define POWER_RANK_TEST_DRIFT 0.001 // Relative change per step (slow case).
+
+// Returns a random value in [0.0, 1.0].
+static double powerRank_randomValue() { return (double)rand() / RAND_MAX; }
+
+// Returns the next set of test powers: all new random values, or each power
+// changed by at most POWER_RANK_TEST_DRIFT, like the windowed band powers.
+static void powerRank_nextPowers(double powerValues[], bool slowlyChanging) {
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    if (slowlyChanging)
+      powerValues[band] *=
+          1.0 + POWER_RANK_TEST_DRIFT * (2.0 * powerRank_randomValue() - 1.0);
+    else
+      powerValues[band] = powerRank_randomValue();
+}
+
+// qsort() comparison function for doubles.
+static int powerRank_compareDoubles(const void *a, const void *b) {
+  double x = *(const double *)a;
+  double y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+// Sorts count values in place with a plain insertion sort.
+static void powerRank_insertionSort(double values[], uint16_t count) {
+  for (uint16_t i = 1; i < count; i++) {
+    double value = values[i];
+    uint16_t j = i;
+    for (; j > 0 && values[j - 1] > value; j--)
+      values[j] = values[j - 1];
+    values[j] = value;
+  }
+}
+
+// Checks every position of r against a qsort() of the same powers and that
+// rank[] is the inverse of order[].
+static bool powerRank_checkOrder(powerRank_t *r) {
+  double sorted[FILTER_FREQUENCY_COUNT];
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    sorted[band] = r->power[band];
+  qsort(sorted, FILTER_FREQUENCY_COUNT, sizeof(double),
+        powerRank_compareDoubles);
+  for (uint16_t i = 0; i < FILTER_FREQUENCY_COUNT; i++) {
+    if (r->power[r->order[i]] != sorted[i] || r->rank[r->order[i]] != i) {
+      printf("* Error: powerRank position %d holds band %d (%le), should "
+             "hold %le.\n",
+             i, r->order[i], r->power[r->order[i]], sorted[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks powerRank_updateAll() and powerRank_update() against qsort().
+static bool powerRank_orderTest(bool slowlyChanging) {
+  powerRank_t all, single;
+  powerRank_init(&all);
+  powerRank_init(&single);
+  double powerValues[FILTER_FREQUENCY_COUNT];
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    powerValues[band] = powerRank_randomValue();
+  for (uint32_t n = 0; n < POWER_RANK_TEST_STEP_COUNT; n++) {
+    powerRank_nextPowers(powerValues, slowlyChanging);
+    powerRank_updateAll(&all, powerValues);
+    for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+      powerRank_update(&single, band, powerValues[band]);
+    if (!powerRank_checkOrder(&all) || !powerRank_checkOrder(&single))
+      return false;
+  }
+  return true;
+}
+
+// Times finding the median and the maximum of POWER_RANK_TEST_STEP_COUNT sets
+// of powers with qsort(), a fresh insertion sort and powerRank_updateAll().
+// The powers are generated up front so only the sorting is timed.
+static void powerRank_benchmark(bool slowlyChanging) {
+  double *powerSets = (double *)malloc((size_t)POWER_RANK_TEST_STEP_COUNT *
+                                       FILTER_FREQUENCY_COUNT * sizeof(double));
+  if (powerSets == NULL) {
+    printf("powerRank_benchmark(): malloc() failed.\n");
+    return;
+  }
+  double powerValues[FILTER_FREQUENCY_COUNT];
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    powerValues[band] = powerRank_randomValue();
+  for (uint32_t n = 0; n < POWER_RANK_TEST_STEP_COUNT; n++) {
+    powerRank_nextPowers(powerValues, slowlyChanging);
+    for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+      powerSets[n * FILTER_FREQUENCY_COUNT + band] = powerValues[band];
+  }
+  volatile double sink = 0.0; // Keeps the work from being optimized out.
+  double sorted[FILTER_FREQUENCY_COUNT];
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t n = 0; n < POWER_RANK_TEST_STEP_COUNT; n++) {
+    for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+      sorted[band] = powerSets[n * FILTER_FREQUENCY_COUNT + band];
+    qsort(sorted, FILTER_FREQUENCY_COUNT, sizeof(double),
+          powerRank_compareDoubles);
+    sink = sorted[FILTER_FREQUENCY_COUNT - 1] -
+           sorted[POWER_RANK_MEDIAN_POSITION];
+  }
+  double qsortTime = benchmark_elapsedNanoseconds(start, benchmark_now());
+  start = benchmark_now();
+  for (uint32_t n = 0; n < POWER_RANK_TEST_STEP_COUNT; n++) {
+    for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+      sorted[band] = powerSets[n * FILTER_FREQUENCY_COUNT + band];
+    powerRank_insertionSort(sorted, FILTER_FREQUENCY_COUNT);
+    sink = sorted[FILTER_FREQUENCY_COUNT - 1] -
+           sorted[POWER_RANK_MEDIAN_POSITION];
+  }
+  double insertionTime = benchmark_elapsedNanoseconds(start, benchmark_now());
+  powerRank_t r;
+  powerRank_init(&r);
+  start = benchmark_now();
+  for (uint32_t n = 0; n < POWER_RANK_TEST_STEP_COUNT; n++) {
+    powerRank_updateAll(&r, &powerSets[n * FILTER_FREQUENCY_COUNT]);
+    sink = powerRank_getMax(&r) - powerRank_getMedian(&r);
+  }
+  double rankTime = benchmark_elapsedNanoseconds(start, benchmark_now());
+  (void)sink;
+  printf("=== Median and max of %d powers, %s: qsort %.1lf ns, insertion sort "
+         "%.1lf ns, powerRank %.1lf ns.\n",
+         FILTER_FREQUENCY_COUNT, slowlyChanging ? "slowly changing" : "random",
+         qsortTime / POWER_RANK_TEST_STEP_COUNT,
+         insertionTime / POWER_RANK_TEST_STEP_COUNT,
+         rankTime / POWER_RANK_TEST_STEP_COUNT);
+  free(powerSets);
+}
+
+// Runs the order tests and the benchmark for random and slowly-changing
+// powers.
+bool powerRank_runTest() {
+  bool testResult = true;
+  bool tempResult = powerRank_orderTest(false);
+  printf("=== powerRank random order test %s.\n",
+         tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  tempResult = powerRank_orderTest(true);
+  printf("=== powerRank slowly-changing order test %s.\n",
+         tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  powerRank_benchmark(false);
+  powerRank_benchmark(true);
+  return testResult;
+}
@@ -0,0 +1,77 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef POWERRANK_H_
+#define POWERRANK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "filter.h" // FILTER_FREQUENCY_COUNT
+
+// Keeps the FILTER_FREQUENCY_COUNT band powers in sorted order as they change,
+// so hit detection can read the median and the maximum directly instead of
+// sorting all powers after every decimated sample.
+//
+// The band powers are windowed sums over 2000 outputs, so they change very
+// little from one decimated sample to the next and their order almost never
+// changes. The order is kept between updates and repaired with insertion sort,
+// which costs one comparison per band when nothing moved and one extra
+// comparison and swap per position a band moves.
+//
+// order[] lists the bands from the lowest to the highest power; rank[] is the
+// inverse (position of each band in order[]). Equal powers keep their previous
+// relative order.
+
+#define POWER_RANK_MEDIAN_POSITION                                             \
+  ((FILTER_FREQUENCY_COUNT - 1) / 2) // Lower median, sorted position 4 of 10.
+
+typedef struct {
+  double power[FILTER_FREQUENCY_COUNT];   // Indexed by band.
+  uint16_t order[FILTER_FREQUENCY_COUNT]; // Bands, lowest power first.
+  uint16_t rank[FILTER_FREQUENCY_COUNT];  // Position of each band in order.
+} powerRank_t;
+
+// Sets all powers to 0.0, with the bands in numerical order.
+void powerRank_init(powerRank_t *r);
+
+// Changes the power of one band and moves it to its new position.
+void powerRank_update(powerRank_t *r, uint16_t band, double power);
+
+// Changes the power of every band (same layout as
+// filter_getCurrentPowerValues()) and repairs the order.
+void powerRank_updateAll(powerRank_t *r, const double powerValues[]);
+
+// Returns the band at a sorted position (0 is the lowest power).
+static inline uint16_t powerRank_getBandAt(const powerRank_t *r,
+                                           uint16_t position) {
+  return r->order[position];
+}
+
+// Returns the band with the highest power.
+static inline uint16_t powerRank_getMaxBand(const powerRank_t *r) {
+  return r->order[FILTER_FREQUENCY_COUNT - 1];
+}
+
+// Returns the highest power.
+static inline double powerRank_getMax(const powerRank_t *r) {
+  return r->power[r->order[FILTER_FREQUENCY_COUNT - 1]];
+}
+
+// Returns the median power (the lower median, at POWER_RANK_MEDIAN_POSITION).
+static inline double powerRank_getMedian(const powerRank_t *r) {
+  return r->power[r->order[POWER_RANK_MEDIAN_POSITION]];
+}
+
+// Checks the order against qsort() for random and slowly-changing powers, then
+// benchmarks finding the median and maximum with qsort(), a fresh insertion
+// sort and powerRank_updateAll(). Returns true if the order is always correct.
+bool powerRank_runTest();
+
+#endif /* POWERRANK_H_ */
@@ -0,0 +1,190 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+
+#include "profiler.h"
+
+#define PROFILER_SUB_BUCKET_BITS 3 // 8 buckets per power of two.
+#define PROFILER_SUB_BUCKET_COUNT (1 << PROFILER_SUB_BUCKET_BITS)
+#define PROFILER_BUCKET_COUNT                                                  \
+  ((32 - PROFILER_SUB_BUCKET_BITS + 1) * PROFILER_SUB_BUCKET_COUNT)
+
+#ifdef ZYBO_BOARD
+#define PROFILER_PMCR_ENABLE 0x1              // PMCR.E: enable all counters.
+#define PROFILER_PMCR_CYCLE_COUNTER_RESET 0x4 // PMCR.C: reset CCNT.
+#define PROFILER_CYCLE_COUNTER_ENABLE 0x80000000 // PMCNTENSET bit 31: CCNT.
+#endif
+
+typedef struct {
+  uint32_t buckets[PROFILER_BUCKET_COUNT];
+  uint32_t count;
+  profiler_time_t max;
+} profiler_histogram_t;
+
+static profiler_histogram_t profiler_histograms[PROFILER_STAGE_COUNT];
+
+// Indexed by profiler_stage_t.
+static const char *profiler_stageNames[PROFILER_STAGE_COUNT] = {
+    "ADC drain", "FIR", "IIR 0", "IIR 1", "IIR 2", "IIR 3", "IIR 4", "IIR 5",
+    "IIR 6", "IIR 7", "IIR 8", "IIR 9", "Power", "Hit decision", "Histogram"};
+
+// Enables the cycle counter (board) and clears all histograms.
+void profiler_init() {
+#ifdef ZYBO_BOARD
+  uint32_t control = mfcp(XREG_CP15_PERF_MONITOR_CTRL);
+  mtcp(XREG_CP15_PERF_MONITOR_CTRL, control | PROFILER_PMCR_ENABLE |
+                                        PROFILER_PMCR_CYCLE_COUNTER_RESET);
+  mtcp(XREG_CP15_COUNT_ENABLE_SET, PROFILER_CYCLE_COUNTER_ENABLE);
+#endif
+  profiler_reset();
+}
+
+// Clears all histograms.
+void profiler_reset() {
+  for (uint16_t stage = 0; stage < PROFILER_STAGE_COUNT; stage++) {
+    for (uint16_t b = 0; b < PROFILER_BUCKET_COUNT; b++)
+      profiler_histograms[stage].buckets[b] = 0;
+    profiler_histograms[stage].count = 0;
+    profiler_histograms[stage].max = 0;
+  }
+}
+
+// Values below 8 have a bucket each. Above, the bucket is chosen by the
+// position of the highest set bit and the 3 bits below it.
+static uint16_t profiler_bucketIndex(profiler_time_t value) {
+  if (value < PROFILER_SUB_BUCKET_COUNT)
+    return value;
+  uint16_t highestBit = 31 - __builtin_clz(value);
+  uint16_t shift = highestBit - PROFILER_SUB_BUCKET_BITS;
+  return (shift + 1) * PROFILER_SUB_BUCKET_COUNT +
+         ((value >> shift) & (PROFILER_SUB_BUCKET_COUNT - 1));
+}
+
+// Returns the largest value that falls in bucket.
+static profiler_time_t profiler_bucketUpperBound(uint16_t bucket) {
+  if (bucket < PROFILER_SUB_BUCKET_COUNT)
+    return bucket;
+  uint16_t shift = bucket / PROFILER_SUB_BUCKET_COUNT - 1;
+  uint32_t subBucket = bucket % PROFILER_SUB_BUCKET_COUNT;
+  uint64_t lower = (uint64_t)(PROFILER_SUB_BUCKET_COUNT + subBucket) << shift;
+  return (profiler_time_t)(lower + ((uint64_t)1 << shift) - 1);
+}
+
+// Adds a duration to the histogram of stage.
+void profiler_record(profiler_stage_t stage, profiler_time_t duration) {
+  profiler_histogram_t *h = &profiler_histograms[stage];
+  h->buckets[profiler_bucketIndex(duration)]++;
+  h->count++;
+  if (duration > h->max)
+    h->max = duration;
+}
+
+// Returns the number of durations recorded for stage.
+uint32_t profiler_getCount(profiler_stage_t stage) {
+  return profiler_histograms[stage].count;
+}
+
+// Returns the largest duration recorded for stage.
+profiler_time_t profiler_getMax(profiler_stage_t stage) {
+  return profiler_histograms[stage].max;
+}
+
+// Walks the buckets until fraction of the durations have been passed.
+profiler_time_t profiler_getPercentile(profiler_stage_t stage,
+                                       double fraction) {
+  profiler_histogram_t *h = &profiler_histograms[stage];
+  if (h->count == 0)
+    return 0;
+  uint32_t target = (uint32_t)(fraction * h->count);
+  target = (target < 1) ? 1 : target;
+  uint32_t seen = 0;
+  for (uint16_t b = 0; b < PROFILER_BUCKET_COUNT; b++) {
+    seen += h->buckets[b];
+    if (seen >= target) {
+      profiler_time_t bound = profiler_bucketUpperBound(b);
+      return (bound < h->max) ? bound : h->max;
+    }
+  }
+  return h->max;
+}
+
+// Returns a short name for stage.
+const char *profiler_getStageName(profiler_stage_t stage) {
+  return profiler_stageNames[stage];
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define PROFILER_TEST_VALUE_COUNT 1000
+#define PROFILER_TEST_MAX_RELATIVE_ERROR                                       \
+  0.125 // One bucket, with 8 buckets per power of two.
+
+// Checks that every value falls in a bucket whose range contains it.
+static bool profiler_bucketTest() {
+  profiler_time_t values[] = {0, 1, 7, 8, 9, 15, 16, 17, 1000, 65535,
+                              65536, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF};
+  for (uint16_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    uint16_t bucket = profiler_bucketIndex(values[i]);
+    profiler_time_t upper = profiler_bucketUpperBound(bucket);
+    profiler_time_t lower =
+        bucket ? profiler_bucketUpperBound(bucket - 1) + 1 : 0;
+    if (bucket >= PROFILER_BUCKET_COUNT || values[i] < lower ||
+        values[i] > upper) {
+      printf("* Error: profiler value %u is in bucket %d (%u to %u).\n",
+             values[i], bucket, lower, upper);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Records 1, 2, ..., PROFILER_TEST_VALUE_COUNT and checks p50, p99 and max.
+static bool profiler_percentileTest() {
+  profiler_reset();
+  for (profiler_time_t v = 1; v <= PROFILER_TEST_VALUE_COUNT; v++)
+    profiler_record(PROFILER_STAGE_FIR, v);
+  double fractions[] = {0.5, 0.99};
+  bool testResult = true;
+  for (uint16_t i = 0; i < sizeof(fractions) / sizeof(fractions[0]); i++) {
+    double expected = fractions[i] * PROFILER_TEST_VALUE_COUNT;
+    profiler_time_t p =
+        profiler_getPercentile(PROFILER_STAGE_FIR, fractions[i]);
+    if (p < expected ||
+        p > expected * (1.0 + PROFILER_TEST_MAX_RELATIVE_ERROR)) {
+      printf("* Error: profiler percentile %.2lf is %u, should be about "
+             "%.0lf.\n",
+             fractions[i], p, expected);
+      testResult = false;
+    }
+  }
+  if (profiler_getMax(PROFILER_STAGE_FIR) != PROFILER_TEST_VALUE_COUNT ||
+      profiler_getCount(PROFILER_STAGE_FIR) != PROFILER_TEST_VALUE_COUNT ||
+      profiler_getCount(PROFILER_STAGE_IIR_0) != 0) {
+    printf("* Error: profiler max or count is wrong.\n");
+    testResult = false;
+  }
+  profiler_reset();
+  return testResult;
+}
+
+// Runs the bucket and percentile tests.
+bool profiler_runTest() {
+  bool testResult = true;
+  bool tempResult = profiler_bucketTest();
+  printf("=== Profiler bucket test %s.\n", tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  tempResult = profiler_percentileTest();
+  printf("=== Profiler percentile test %s.\n",
+         tempResult ? "passed" : "failed");
+  testResult = tempResult ? testResult : false;
+  return testResult;
+}
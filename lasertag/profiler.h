@@ -0,0 +1,113 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "filter.h" // FILTER_FREQUENCY_COUNT
+
+// Per-stage profiling of the detector pipeline. Each stage has a histogram of
+// its durations, from which profiler_getPercentile() returns p50, p99, etc.
+// The interval timers in runningModes.c only give the total time.
+//
+// On the board, durations are CPU clock cycles from the Cortex-A9 PMU cycle
+// counter (CCNT, read with one mrc instruction). The Xilinx xpm_counter.h API
+// only drives the six event counters, so the cycle counter is enabled directly
+// through the CP15 registers in xreg_cortexa9.h. On the host (emulator),
+// durations are nanoseconds from clock_gettime().
+//
+// detectorBatch.c (ADC drain, FIR, each IIR, power and hit decision) and the
+// histogram redraw in runningModes.c are instrumented with PROFILER_START()
+// and PROFILER_STOP(), and runningModes_printRunTimeStatistics() shows the
+// results on a second screen. Unless PROFILER_ENABLED is defined, both macros
+// expand to nothing, so the instrumentation costs nothing in normal builds.
+//
+// The histograms have 8 buckets per power of two, so percentiles are exact
+// below 8 and within 12.5% above. The maximum is exact.
+
+// Uncomment to record stage durations.
+//#define PROFILER_ENABLED
+
+#ifdef ZYBO_BOARD
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#define PROFILER_UNIT_NAME "cycles"
+#else
+#include <time.h>
+#define PROFILER_UNIT_NAME "ns"
+#endif
+
+// Stages of the pipeline. The 10 IIR filters are PROFILER_STAGE_IIR_0 +
+// filterNumber.
+typedef enum {
+  PROFILER_STAGE_ADC_DRAIN, // Copying values out of the ADC buffer.
+  PROFILER_STAGE_FIR,       // filter_firFilter().
+  PROFILER_STAGE_IIR_0,     // filter_iirFilter(0) to filter_iirFilter(9).
+  PROFILER_STAGE_POWER = PROFILER_STAGE_IIR_0 + FILTER_FREQUENCY_COUNT,
+  PROFILER_STAGE_HIT_DECISION, // Hit detection after a decimated sample.
+  PROFILER_STAGE_HISTOGRAM,    // Histogram redraw.
+  PROFILER_STAGE_COUNT
+} profiler_stage_t;
+
+typedef uint32_t profiler_time_t; // Cycles (board) or nanoseconds (host).
+
+// Returns the current time. Differences are valid across counter wrap-around
+// for durations up to 2^32 units (6.6 s of cycles on the board).
+static inline profiler_time_t profiler_now() {
+#ifdef ZYBO_BOARD
+  return mfcp(XREG_CP15_PERF_CYCLE_COUNTER);
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (profiler_time_t)((uint64_t)now.tv_sec * 1000000000 + now.tv_nsec);
+#endif
+}
+
+#ifdef PROFILER_ENABLED
+// Declares start and sets it to the current time.
+#define PROFILER_START(start) profiler_time_t start = profiler_now()
+// Records the time since start for stage.
+#define PROFILER_STOP(stage, start)                                            \
+  profiler_record((stage), profiler_now() - (start))
+#else
+#define PROFILER_START(start)
+#define PROFILER_STOP(stage, start)
+#endif
+
+// Enables the cycle counter (board) and clears all histograms.
+void profiler_init();
+
+// Clears all histograms.
+void profiler_reset();
+
+// Adds a duration to the histogram of stage.
+void profiler_record(profiler_stage_t stage, profiler_time_t duration);
+
+// Returns the number of durations recorded for stage.
+uint32_t profiler_getCount(profiler_stage_t stage);
+
+// Returns the largest duration recorded for stage.
+profiler_time_t profiler_getMax(profiler_stage_t stage);
+
+// Returns the duration that fraction (e.g., 0.5 or 0.99) of the recorded
+// durations of stage do not exceed, rounded up to the end of its histogram
+// bucket (and never above the maximum). Returns 0 if nothing was recorded.
+profiler_time_t profiler_getPercentile(profiler_stage_t stage, double fraction);
+
+// Returns a short name for stage, e.g., "IIR 3".
+const char *profiler_getStageName(profiler_stage_t stage);
+
+// Checks the histogram bucketing and percentiles against known durations.
+// Returns true if the test passes.
+bool profiler_runTest();
+
+#endif /* PROFILER_H_ */
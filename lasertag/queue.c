@@ -0,0 +1,16 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+// The queue_t functions (see queue.h). The code is in queueCore.inc, which
+// queueTyped.c also includes for the typed queues.
+
+#include "queue.h"
+
+#define QUEUE_CORE_PREFIX queue
+#include "queueCore.inc"
@@ -29,6 +29,15 @@ typedef double queue_data_t;
 // Not sure we need something different from the index type.
 typedef uint32_t queue_size_t;
 
+// A contiguous run of queue elements, oldest element first.
+typedef struct {
+  const queue_data_t *data; // Points to the oldest element of the run.
+  queue_size_t length;      // Number of elements in the run.
+} queue_span_t;
+
+// The newest elements of a queue occupy at most this many spans.
+#define QUEUE_MAX_SPAN_COUNT 2
+
 // The queue struct with elementCount to speed up computations to determine
 // element count. Queue will use the empty location and pointer arithmetic to
 // determine full and empty.
@@ -40,11 +49,19 @@ typedef struct {
   queue_index_t indexOut;
   // Keep track of the number of elements currently in queue.
   queue_size_t elementCount;
-  // This is the size of the data array. Actual queue
-  // capacity is one less.
+  // The capacity of the queue. All size slots can be used; full and empty
+  // are told apart by elementCount. The data array holds size elements, or
+  // twice the next power of two for mirrored queues.
   queue_size_t size;
   // Points to a dynamically-allocated array.
   queue_data_t *data;
+  // True for queues created with queue_initPowerOfTwo(): the storage is
+  // rounded up to a power of two, indices wrap with (index & mask) and data
+  // is mirrored at data[i] and data[i + mask + 1]. False for queues created
+  // with queue_init(), whose indices wrap by comparing against size.
+  bool mirrored;
+  // Storage size - 1 if mirrored, unused otherwise.
+  queue_index_t mask;
   // True if queue_pop() is called on an empty queue. Reset
   // to false after queue_push() is called.
   bool underflowFlag;
@@ -60,6 +77,13 @@ typedef struct {
 // and calls assert(false) to print-out line-number information and die.
 void queue_init(queue_t *q, queue_size_t size, const char *name);
 
+// Same as queue_init() but the storage is rounded up to the next power of two
+// so that all index arithmetic is done with a mask instead of a modulo. The
+// storage is also mirrored (each element is written twice) so that the newest
+// elements can always be read as a single contiguous array, see
+// queue_newestWindow(). The capacity (queue_size()) is still size.
+void queue_initPowerOfTwo(queue_t *q, queue_size_t size, const char *name);
+
 // Get the user-assigned name for the queue.
 const char *queue_name(queue_t *);
 
@@ -86,12 +110,49 @@ queue_data_t queue_pop(queue_t *q);
 // If the queue is not full, just call queue_push().
 void queue_overwritePush(queue_t *q, queue_data_t value);
 
+// Pushes up to n values (values[0] first) with at most two segment copies and
+// a single update of the indices, count and flags. Returns the number of
+// values that were pushed. If there is not room for all n values, pushes as
+// many as fit, sets the overflowFlag and prints an error message, exactly as
+// n calls to queue_push() would.
+queue_size_t queue_pushN(queue_t *q, const queue_data_t *values,
+                         queue_size_t n);
+
+// Pops up to n values into values (oldest first) with at most two segment
+// copies. Returns the number of values that were popped. If the queue contains
+// fewer than n elements, pops all of them, sets the underflowFlag and prints
+// an error message, exactly as n calls to queue_pop() would.
+queue_size_t queue_popN(queue_t *q, queue_data_t *values, queue_size_t n);
+
+// Same result as n calls to queue_overwritePush() (values[0] first), but the
+// values are copied with at most two segment copies.
+void queue_overwritePushN(queue_t *q, const queue_data_t *values,
+                          queue_size_t n);
+
 // Provides random-access read capability to the queue.
 // Low-valued indexes access older queue elements while higher-value indexes
 // access newer elements (according to the order that they were added). Print a
 // meaningful error message if an error condition is detected.
 queue_data_t queue_readElementAt(queue_t *q, queue_index_t index);
 
+// Only works for queues created with queue_initPowerOfTwo().
+// Returns a pointer to the oldest of the newest n elements. The n elements
+// can be read as a plain array, oldest first: window[0] ... window[n-1].
+// Returns NULL (and prints an error message) if the queue is not mirrored or
+// contains fewer than n elements. The pointer is invalidated by the next push.
+const queue_data_t *queue_newestWindow(queue_t *q, queue_size_t n);
+
+// Returns the newest n elements as one or two contiguous spans so that
+// convolution kernels can run tight loops over raw queue_data_t pointers
+// instead of calling queue_readElementAt() for every tap. The spans are in
+// oldest-first order: spans[0] holds the oldest of the n elements and the
+// last element of the last span is the newest element in the queue. Returns
+// the number of spans that were filled in (always 1 for queues created with
+// queue_initPowerOfTwo()). Returns 0 (and prints an error message) if the
+// queue contains fewer than n elements. Spans are invalidated by the next push.
+uint16_t queue_newestSpans(queue_t *q, queue_size_t n,
+                           queue_span_t spans[QUEUE_MAX_SPAN_COUNT]);
+
 // Returns a count of the elements currently contained in the queue.
 queue_size_t queue_elementCount(queue_t *q);
 
@@ -117,4 +178,15 @@ void queue_print(queue_t *q);
 // during the test.
 bool queue_runTest();
 
+// Compares the access time (ns/element) of queues created with queue_init()
+// against queues created with queue_initPowerOfTwo() for the queue sizes used
+// by the filter. Prints the results to the console.
+void queue_runBenchmark();
+
+// Compares the throughput (ns/element) of queue_overwritePush()/queue_pop()
+// against queue_overwritePushN()/queue_popN() for 1K to 100K element queues.
+// Moves 10M elements per queue size, so it is kept out of queue_runTest().
+// Prints the results to the console.
+void queue_runBatchBenchmark();
+
 #endif /* QUEUE_H_ */
\ No newline at end of file
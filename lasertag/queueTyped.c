@@ -0,0 +1,24 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+// The typed queue functions (see queueTyped.h). The code is in queueCore.inc,
+// the same code as the queue_t functions in queue.c. Elements are printed by
+// queue_<suffix>_print() as doubles, which represents every float, int16_t and
+// uint32_t value exactly.
+
+#include "queueTyped.h"
+
+#define QUEUE_CORE_PREFIX queue_f32
+#include "queueCore.inc"
+
+#define QUEUE_CORE_PREFIX queue_i16
+#include "queueCore.inc"
+
+#define QUEUE_CORE_PREFIX queue_u32
+#include "queueCore.inc"
@@ -0,0 +1,99 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef QUEUETYPED_H_
+#define QUEUETYPED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "queue.h" // queue_index_t, queue_size_t, QUEUE_MAX_NAME_SIZE.
+
+// A family of queues with the same semantics as queue_t (see queue.h) but
+// with a different element type. queue_t is hard-wired to double, which costs
+// 8 bytes per sample and double-precision arithmetic. These queues let the
+// filter delay lines run in float (queue_f32_t) or Q15 (queue_i16_t), and the
+// ADC/telemetry paths in uint32_t (queue_u32_t).
+//
+// Every function of queue.h exists for each type, with the type suffix added
+// to the prefix, e.g., queue_f32_init(), queue_f32_overwritePush(),
+// queue_f32_readElementAt(), queue_i16_newestSpans(), and so forth.
+//
+// To add another type, add a QUEUE_TYPED_DECLARE() line below and include
+// queueCore.inc for it in queueTyped.c.
+
+// Declares the types and functions for a queue holding elements of type.
+#define QUEUE_TYPED_DECLARE(suffix, type)                                      \
+  typedef type queue_##suffix##_data_t;                                        \
+                                                                               \
+  /* Same fields and meaning as queue_t. */                                    \
+  typedef struct {                                                             \
+    queue_index_t indexIn;                                                     \
+    queue_index_t indexOut;                                                    \
+    queue_size_t elementCount;                                                 \
+    queue_size_t size;                                                         \
+    queue_##suffix##_data_t *data;                                             \
+    bool mirrored;                                                             \
+    queue_index_t mask;                                                        \
+    bool underflowFlag;                                                        \
+    bool overflowFlag;                                                         \
+    char name[QUEUE_MAX_NAME_SIZE];                                            \
+  } queue_##suffix##_t;                                                        \
+                                                                               \
+  /* A contiguous run of elements, oldest element first. */                    \
+  typedef struct {                                                             \
+    const queue_##suffix##_data_t *data;                                       \
+    queue_size_t length;                                                       \
+  } queue_##suffix##_span_t;                                                   \
+                                                                               \
+  void queue_##suffix##_init(queue_##suffix##_t *q, queue_size_t size,         \
+                             const char *name);                                \
+  void queue_##suffix##_initPowerOfTwo(queue_##suffix##_t *q,                  \
+                                       queue_size_t size, const char *name);   \
+  const char *queue_##suffix##_name(queue_##suffix##_t *q);                    \
+  queue_size_t queue_##suffix##_size(queue_##suffix##_t *q);                   \
+  bool queue_##suffix##_full(queue_##suffix##_t *q);                           \
+  bool queue_##suffix##_empty(queue_##suffix##_t *q);                          \
+  void queue_##suffix##_push(queue_##suffix##_t *q,                            \
+                             queue_##suffix##_data_t value);                   \
+  queue_##suffix##_data_t queue_##suffix##_pop(queue_##suffix##_t *q);         \
+  void queue_##suffix##_overwritePush(queue_##suffix##_t *q,                   \
+                                      queue_##suffix##_data_t value);          \
+  queue_size_t queue_##suffix##_pushN(queue_##suffix##_t *q,                   \
+                                      const queue_##suffix##_data_t *values,   \
+                                      queue_size_t n);                         \
+  queue_size_t queue_##suffix##_popN(queue_##suffix##_t *q,                    \
+                                     queue_##suffix##_data_t *values,          \
+                                     queue_size_t n);                          \
+  void queue_##suffix##_overwritePushN(queue_##suffix##_t *q,                  \
+                                       const queue_##suffix##_data_t *values,  \
+                                       queue_size_t n);                        \
+  queue_##suffix##_data_t queue_##suffix##_readElementAt(                      \
+      queue_##suffix##_t *q, queue_index_t index);                             \
+  const queue_##suffix##_data_t *queue_##suffix##_newestWindow(                \
+      queue_##suffix##_t *q, queue_size_t n);                                  \
+  uint16_t queue_##suffix##_newestSpans(                                       \
+      queue_##suffix##_t *q, queue_size_t n,                                   \
+      queue_##suffix##_span_t spans[QUEUE_MAX_SPAN_COUNT]);                    \
+  queue_size_t queue_##suffix##_elementCount(queue_##suffix##_t *q);           \
+  bool queue_##suffix##_underflow(queue_##suffix##_t *q);                      \
+  bool queue_##suffix##_overflow(queue_##suffix##_t *q);                       \
+  void queue_##suffix##_garbageCollect(queue_##suffix##_t *q);                 \
+  void queue_##suffix##_print(queue_##suffix##_t *q);
+
+QUEUE_TYPED_DECLARE(f32, float)    // Single-precision filter delay lines.
+QUEUE_TYPED_DECLARE(i16, int16_t)  // Q15 filter delay lines, 12-bit ADC data.
+QUEUE_TYPED_DECLARE(u32, uint32_t) // Raw ADC values, counters, telemetry.
+
+// Runs push/pop, wrap-around and overwritePush tests on every typed queue,
+// for both queue_init() and queue_initPowerOfTwo() storage. Returns false if
+// any test fails, true otherwise. Called by queue_runTest().
+bool queueTyped_runTest();
+
+#endif /* QUEUETYPED_H_ */
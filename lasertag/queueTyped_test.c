@@ -0,0 +1,99 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+
+#include "queueTyped.h"
+
+// 5 is not a power of two, so queue_initPowerOfTwo() rounds the storage up
+// and the two init functions wrap differently.
+#define QUEUE_TYPED_TEST_SIZE 5
+#define QUEUE_TYPED_TEST_POP_COUNT 3 // Pops before pushing across the wrap.
+#define QUEUE_TYPED_TEST_QUEUE_NAME "typed_test_queue"
+
+// Defines queueTyped_<suffix>_test(). The queue is pushed the consecutive
+// values first, first + 1, ..., which every type represents exactly, so the
+// element at index i must be (first + i). The test:
+// 1. fills the queue with push() and checks the contents and full().
+// 2. pops a few elements, then pushes across the end of the storage (wrap).
+// 3. overwritePushes two queues' worth; only the newest size values remain.
+// 4. pops everything and checks that one more pop sets the underflow flag.
+#define QUEUE_TYPED_TEST_DEFINE(suffix, type)                                  \
+  /* Returns true if q holds the values first, first + 1, ... in order. */     \
+  static bool queueTyped_##suffix##_checkContents(queue_##suffix##_t *q,       \
+                                                  uint32_t first) {            \
+    for (queue_index_t i = 0; i < queue_##suffix##_elementCount(q); i++) {     \
+      type value = queue_##suffix##_readElementAt(q, i);                       \
+      if (value != (type)(first + i)) {                                        \
+        printf("* Error: %s element %d is %lf, should be %d.\n", q->name, i,   \
+               (double)value, first + i);                                      \
+        return false;                                                          \
+      }                                                                        \
+    }                                                                          \
+    return true;                                                               \
+  }                                                                            \
+                                                                               \
+  /* Runs tests 1 to 4 on a queue created with init() or initPowerOfTwo(). */  \
+  static bool queueTyped_##suffix##_test(bool powerOfTwo) {                    \
+    queue_##suffix##_t q;                                                      \
+    if (powerOfTwo)                                                            \
+      queue_##suffix##_initPowerOfTwo(&q, QUEUE_TYPED_TEST_SIZE,               \
+                                      QUEUE_TYPED_TEST_QUEUE_NAME);            \
+    else                                                                       \
+      queue_##suffix##_init(&q, QUEUE_TYPED_TEST_SIZE,                         \
+                            QUEUE_TYPED_TEST_QUEUE_NAME);                      \
+    bool testResult = true;                                                    \
+    uint32_t first = 0; /* Value of the oldest element. */                     \
+    uint32_t next = 0;  /* Value of the next element to push. */               \
+    while (!queue_##suffix##_full(&q))                                         \
+      queue_##suffix##_push(&q, (type)next++);                                 \
+    testResult = (next == QUEUE_TYPED_TEST_SIZE) ? testResult : false;         \
+    testResult = queueTyped_##suffix##_checkContents(&q, first) ? testResult   \
+                                                                : false;       \
+    for (uint32_t i = 0; i < QUEUE_TYPED_TEST_POP_COUNT; i++)                  \
+      testResult =                                                             \
+          (queue_##suffix##_pop(&q) == (type)first++) ? testResult : false;    \
+    for (uint32_t i = 0; i < QUEUE_TYPED_TEST_POP_COUNT; i++)                  \
+      queue_##suffix##_push(&q, (type)next++);                                 \
+    testResult = queueTyped_##suffix##_checkContents(&q, first) ? testResult   \
+                                                                : false;       \
+    for (uint32_t i = 0; i < 2 * QUEUE_TYPED_TEST_SIZE; i++)                   \
+      queue_##suffix##_overwritePush(&q, (type)next++);                        \
+    first = next - QUEUE_TYPED_TEST_SIZE;                                      \
+    testResult = queue_##suffix##_full(&q) ? testResult : false;               \
+    testResult = queueTyped_##suffix##_checkContents(&q, first) ? testResult   \
+                                                                : false;       \
+    while (!queue_##suffix##_empty(&q))                                        \
+      testResult =                                                             \
+          (queue_##suffix##_pop(&q) == (type)first++) ? testResult : false;    \
+    testResult = (first == next) ? testResult : false;                         \
+    printf("Expect an underflow message:\n");                                  \
+    queue_##suffix##_pop(&q);                                                  \
+    testResult = queue_##suffix##_underflow(&q) ? testResult : false;          \
+    queue_##suffix##_garbageCollect(&q);                                       \
+    printf("=== queue_" #suffix "_t %s test %s.\n",                            \
+           powerOfTwo ? "initPowerOfTwo()" : "init()",                         \
+           testResult ? "passed" : "failed");                                  \
+    return testResult;                                                         \
+  }
+
+QUEUE_TYPED_TEST_DEFINE(f32, float)
+QUEUE_TYPED_TEST_DEFINE(i16, int16_t)
+QUEUE_TYPED_TEST_DEFINE(u32, uint32_t)
+
+// Runs the typed queue tests for both kinds of storage.
+bool queueTyped_runTest() {
+  bool testResult = true;
+  for (uint16_t powerOfTwo = 0; powerOfTwo <= 1; powerOfTwo++) {
+    testResult = queueTyped_f32_test(powerOfTwo) ? testResult : false;
+    testResult = queueTyped_i16_test(powerOfTwo) ? testResult : false;
+    testResult = queueTyped_u32_test(powerOfTwo) ? testResult : false;
+  }
+  return testResult;
+}
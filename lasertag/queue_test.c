@@ -10,7 +10,9 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "benchmark.h"
 #include "queue.h"
+#include "queueTyped.h"
 
 #define SMALL_QUEUE_SIZE 1000
 #define SMALL_QUEUE_COUNT 10
@@ -512,6 +514,290 @@ bool queue_overwritePushTest() {
   return testResult;
 }
 
+#define POWER_OF_TWO_TEST_SIZE_COUNT 2
+// 100 is rounded up to 128 internally. A size of 1 has a mask of 0 but must
+// still use the mirrored code path.
+static const queue_size_t
+    queue_powerOfTwoTestSizes[POWER_OF_TWO_TEST_SIZE_COUNT] = {100, 1};
+#define POWER_OF_TWO_TEST_ITERATION_COUNT 1000
+#define POWER_OF_TWO_TEST_QUEUE_NAME "powerOfTwoQ"
+#define POWER_OF_TWO_TEST_REFERENCE_QUEUE_NAME "referenceQ"
+// Checks that a queue of the given size created with queue_initPowerOfTwo()
+// behaves exactly like a queue created with queue_init(). A random mix of
+// pushes, pops and overwritePushes is applied to both queues and the contents
+// are compared with queue_readElementAt() and queue_newestWindow().
+static bool queue_powerOfTwoTestSize(queue_size_t size) {
+  bool testResult = true;
+  queue_t testQ, referenceQ;
+  queue_initPowerOfTwo(&testQ, size, POWER_OF_TWO_TEST_QUEUE_NAME);
+  queue_init(&referenceQ, size, POWER_OF_TWO_TEST_REFERENCE_QUEUE_NAME);
+  if (queue_size(&testQ) != size) {
+    printf("* Error: queue_size(%s) is %u, should be %u.\n",
+           queue_name(&testQ), queue_size(&testQ), size);
+    testResult = false;
+  }
+  for (uint32_t i = 0; i < POWER_OF_TWO_TEST_ITERATION_COUNT && testResult;
+       i++) {
+    double value = (double)rand();
+    switch (rand() % 3) { // Pick one of the three ways to change the queue.
+    case 0:
+      if (!queue_full(&referenceQ)) {
+        queue_push(&testQ, value);
+        queue_push(&referenceQ, value);
+      }
+      break;
+    case 1:
+      if (!queue_empty(&referenceQ) &&
+          queue_pop(&testQ) != queue_pop(&referenceQ)) {
+        printf("* Error: queue_pop(%s) returned the wrong value.\n",
+               queue_name(&testQ));
+        testResult = false;
+      }
+      break;
+    default:
+      queue_overwritePush(&testQ, value);
+      queue_overwritePush(&referenceQ, value);
+      break;
+    }
+    queue_size_t count = queue_elementCount(&referenceQ);
+    if (queue_elementCount(&testQ) != count) {
+      printf("* Error: queue_elementCount(%s) is %u, should be %u.\n",
+             queue_name(&testQ), queue_elementCount(&testQ), count);
+      testResult = false;
+      break;
+    }
+    const queue_data_t *window = queue_newestWindow(&testQ, count);
+    for (queue_index_t j = 0; j < count; j++) {
+      double expected = queue_readElementAt(&referenceQ, j);
+      if (queue_readElementAt(&testQ, j) != expected ||
+          window[j] != expected) {
+        printf("* Error: %s(%u) does not match %s(%u).\n",
+               queue_name(&testQ), j, queue_name(&referenceQ), j);
+        testResult = false;
+        break;
+      }
+    }
+  }
+  queue_garbageCollect(&testQ);
+  queue_garbageCollect(&referenceQ);
+  return testResult;
+}
+
+// Runs queue_powerOfTwoTestSize() for every size in
+// queue_powerOfTwoTestSizes.
+bool queue_powerOfTwoTest() {
+  bool testResult = true;
+  for (uint16_t i = 0; i < POWER_OF_TWO_TEST_SIZE_COUNT && testResult; i++)
+    testResult = queue_powerOfTwoTestSize(queue_powerOfTwoTestSizes[i]);
+  return testResult;
+}
+
+#define SPAN_TEST_QUEUE_SIZE 81 // Same size as the FIR xQueue.
+#define SPAN_TEST_ITERATION_COUNT 500
+#define SPAN_TEST_QUEUE_NAME "spanQ"
+// Checks one queue: the spans returned by queue_newestSpans() must contain
+// the same values, in the same order, as queue_readElementAt() for every
+// window length from 0 to the element count.
+static bool queue_checkSpans(queue_t *q) {
+  queue_size_t count = queue_elementCount(q);
+  for (queue_size_t n = 0; n <= count; n++) {
+    queue_span_t spans[QUEUE_MAX_SPAN_COUNT];
+    uint16_t spanCount = queue_newestSpans(q, n, spans);
+    queue_index_t readIndex = count - n; // Oldest of the newest n elements.
+    for (uint16_t s = 0; s < spanCount; s++) {
+      for (queue_size_t i = 0; i < spans[s].length; i++) {
+        if (spans[s].data[i] != queue_readElementAt(q, readIndex)) {
+          printf("* Error: queue_newestSpans(%s, %u) span[%u][%u] does not "
+                 "match queue_readElementAt(%u).\n",
+                 queue_name(q), n, s, i, readIndex);
+          return false;
+        }
+        readIndex++;
+      }
+    }
+    if (spanCount == 0 || readIndex != count) {
+      printf("* Error: queue_newestSpans(%s, %u) returned %u spans that "
+             "cover %u elements.\n",
+             queue_name(q), n, spanCount, readIndex - (count - n));
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks queue_newestSpans() against queue_readElementAt() on a general queue
+// and on a power-of-two queue while the indices wrap around the end of the
+// data array. The queues are filled part-way first so that the wrap-around
+// point moves on every iteration.
+bool queue_spanTest() {
+  bool testResult = true;
+  queue_t generalQ, powerOfTwoQ;
+  queue_init(&generalQ, SPAN_TEST_QUEUE_SIZE, SPAN_TEST_QUEUE_NAME);
+  queue_initPowerOfTwo(&powerOfTwoQ, SPAN_TEST_QUEUE_SIZE,
+                       SPAN_TEST_QUEUE_NAME);
+  for (uint32_t i = 0; i < SPAN_TEST_ITERATION_COUNT && testResult; i++) {
+    double value = (double)rand();
+    queue_overwritePush(&generalQ, value);
+    queue_overwritePush(&powerOfTwoQ, value);
+    if (rand() % 4 == 0) { // Occasionally pop so the queues are not full.
+      queue_pop(&generalQ);
+      queue_pop(&powerOfTwoQ);
+    }
+    testResult = queue_checkSpans(&generalQ) && queue_checkSpans(&powerOfTwoQ);
+  }
+  queue_garbageCollect(&generalQ);
+  queue_garbageCollect(&powerOfTwoQ);
+  return testResult;
+}
+
+#define BATCH_TEST_QUEUE_SIZE 100 // Rounded up to 128 for the mirrored queue.
+#define BATCH_TEST_ITERATION_COUNT 200
+#define BATCH_TEST_MAX_BATCH_SIZE 50 // Max elements per batch.
+#define BATCH_TEST_QUEUE_NAME "batchQ"
+#define BATCH_TEST_REFERENCE_QUEUE_NAME "referenceQ"
+// Applies the same random operation to testQ (batched) and to referenceQ (one
+// element at a time) and checks that both queues end up with the same
+// contents and flags. Returns false if they do not match.
+static bool queue_batchStep(queue_t *testQ, queue_t *referenceQ) {
+  queue_data_t values[BATCH_TEST_MAX_BATCH_SIZE];
+  queue_data_t referenceValues[BATCH_TEST_MAX_BATCH_SIZE];
+  queue_size_t n = rand() % BATCH_TEST_MAX_BATCH_SIZE;
+  for (queue_size_t i = 0; i < n; i++)
+    values[i] = (double)rand();
+  queue_size_t count, referenceCount = 0;
+  // Pick one of the three batched operations. Pops are picked twice as often
+  // so the queue does not sit at full (and overflow) most of the time.
+  switch (rand() % 4) {
+  case 0:
+    count = queue_pushN(testQ, values, n);
+    // Stop after the first overflow, further pushes change nothing.
+    for (queue_size_t i = 0; i < n && !queue_overflow(referenceQ); i++) {
+      referenceCount += queue_full(referenceQ) ? 0 : 1;
+      queue_push(referenceQ, values[i]);
+    }
+    break;
+  case 1:
+  case 2:
+    count = queue_popN(testQ, values, n);
+    // Stop after the first underflow, further pops change nothing.
+    for (queue_size_t i = 0; i < n && !queue_underflow(referenceQ); i++) {
+      referenceCount += queue_empty(referenceQ) ? 0 : 1;
+      referenceValues[i] = queue_pop(referenceQ);
+    }
+    for (queue_size_t i = 0; i < count; i++) {
+      if (values[i] != referenceValues[i]) {
+        printf("* Error: queue_popN(%s) value %u is incorrect.\n",
+               queue_name(testQ), i);
+        return false;
+      }
+    }
+    break;
+  default:
+    queue_overwritePushN(testQ, values, n);
+    for (queue_size_t i = 0; i < n; i++)
+      queue_overwritePush(referenceQ, values[i]);
+    count = referenceCount = n;
+    break;
+  }
+  if (count != referenceCount ||
+      queue_elementCount(testQ) != queue_elementCount(referenceQ) ||
+      queue_overflow(testQ) != queue_overflow(referenceQ) ||
+      queue_underflow(testQ) != queue_underflow(referenceQ)) {
+    printf("* Error: %s count or flags do not match %s after a batch of %u.\n",
+           queue_name(testQ), queue_name(referenceQ), n);
+    return false;
+  }
+  for (queue_index_t i = 0; i < queue_elementCount(referenceQ); i++) {
+    if (queue_readElementAt(testQ, i) != queue_readElementAt(referenceQ, i)) {
+      printf("* Error: %s(%u) does not match %s(%u).\n", queue_name(testQ), i,
+             queue_name(referenceQ), i);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks queue_pushN(), queue_popN() and queue_overwritePushN() against the
+// per-element functions on a general queue and on a power-of-two queue.
+// The overflow/underflow paths are exercised too (expect some error
+// messages).
+bool queue_batchTest() {
+  bool testResult = true;
+  queue_t generalQ, powerOfTwoQ, referenceQ1, referenceQ2;
+  queue_init(&generalQ, BATCH_TEST_QUEUE_SIZE, BATCH_TEST_QUEUE_NAME);
+  queue_initPowerOfTwo(&powerOfTwoQ, BATCH_TEST_QUEUE_SIZE,
+                       BATCH_TEST_QUEUE_NAME);
+  queue_init(&referenceQ1, BATCH_TEST_QUEUE_SIZE,
+             BATCH_TEST_REFERENCE_QUEUE_NAME);
+  queue_init(&referenceQ2, BATCH_TEST_QUEUE_SIZE,
+             BATCH_TEST_REFERENCE_QUEUE_NAME);
+  for (uint32_t i = 0; i < BATCH_TEST_ITERATION_COUNT && testResult; i++) {
+    testResult = queue_batchStep(&generalQ, &referenceQ1) &&
+                 queue_batchStep(&powerOfTwoQ, &referenceQ2);
+  }
+  queue_garbageCollect(&generalQ);
+  queue_garbageCollect(&powerOfTwoQ);
+  queue_garbageCollect(&referenceQ1);
+  queue_garbageCollect(&referenceQ2);
+  return testResult;
+}
+
+#define BATCH_BENCHMARK_SIZE_COUNT 3
+static const queue_size_t
+    queue_batchBenchmarkSizes[BATCH_BENCHMARK_SIZE_COUNT] = {1000, 10000,
+                                                             100000};
+#define BATCH_BENCHMARK_ELEMENTS_PER_SIZE                                      \
+  10000000 // Move at least this many elements per measurement.
+#define BATCH_BENCHMARK_QUEUE_NAME "batchBenchmarkQ"
+
+// Moves the contents of buffer through q (overwritePush everything, then pop
+// everything) until BATCH_BENCHMARK_ELEMENTS_PER_SIZE elements have gone
+// through. Returns the average time per element in nanoseconds.
+static double queue_batchThroughput(queue_t *q, queue_data_t *buffer,
+                                    bool batched) {
+  queue_size_t size = queue_size(q);
+  uint32_t passCount = BATCH_BENCHMARK_ELEMENTS_PER_SIZE / size;
+  // Offset the indices so the batches have to wrap around.
+  queue_pushN(q, buffer, size / 2);
+  queue_popN(q, buffer, size / 2);
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t pass = 0; pass < passCount; pass++) {
+    if (batched) {
+      queue_overwritePushN(q, buffer, size);
+      queue_popN(q, buffer, size);
+    } else {
+      for (queue_size_t i = 0; i < size; i++)
+        queue_overwritePush(q, buffer[i]);
+      for (queue_size_t i = 0; i < size; i++)
+        buffer[i] = queue_pop(q);
+    }
+  }
+  benchmark_timestamp_t stop = benchmark_now();
+  return benchmark_elapsedNanoseconds(start, stop) /
+         ((double)passCount * size);
+}
+
+// Compares the throughput (ns/element) of the per-element and batched
+// functions for 1K to 100K element queues. Prints the results to the console.
+void queue_runBatchBenchmark() {
+  printf("=== Queue batch benchmark (ns/element): overwritePush + pop ===\n");
+  printf("%8s %12s %12s %12s\n", "size", "element", "batched", "speedup");
+  for (uint16_t i = 0; i < BATCH_BENCHMARK_SIZE_COUNT; i++) {
+    queue_size_t size = queue_batchBenchmarkSizes[i];
+    queue_data_t *buffer = (queue_data_t *)malloc(size * sizeof(queue_data_t));
+    for (queue_size_t j = 0; j < size; j++)
+      buffer[j] = (queue_data_t)j;
+    queue_t q;
+    queue_init(&q, size, BATCH_BENCHMARK_QUEUE_NAME);
+    double elementTime = queue_batchThroughput(&q, buffer, false);
+    double batchedTime = queue_batchThroughput(&q, buffer, true);
+    printf("%8u %12.3lf %12.3lf %12.2lf\n", size, elementTime, batchedTime,
+           elementTime / batchedTime);
+    queue_garbageCollect(&q);
+    free(buffer);
+  }
+}
+
 #define QUEUE_TEST_MAX_QUEUE_SIZE 100 // Used for the fill/empty tests.
 #define QUEUE_TEST_MAX_LOOP_COUNT                                              \
   10 // All tests will be invoked this many times.
@@ -613,6 +899,38 @@ bool queue_runTest() {
     } else {
       printf("=== Queue: %s failed overwritePush test.\n", queue_name(&testQ));
     }
+    testResult = tempResult
+                     ? testResult
+                     : false; // Logical AND of testResult and tempResult.
+    printf("=== Commencing power-of-two queue test === \n");
+    tempResult = queue_powerOfTwoTest();
+    if (tempResult) {
+      printf("=== Queue: %s passed power-of-two test.\n",
+             POWER_OF_TWO_TEST_QUEUE_NAME);
+    } else {
+      printf("=== Queue: %s failed power-of-two test.\n",
+             POWER_OF_TWO_TEST_QUEUE_NAME);
+    }
+    testResult = tempResult
+                     ? testResult
+                     : false; // Logical AND of testResult and tempResult.
+    printf("=== Commencing span test === \n");
+    tempResult = queue_spanTest();
+    if (tempResult) {
+      printf("=== Queue: %s passed span test.\n", SPAN_TEST_QUEUE_NAME);
+    } else {
+      printf("=== Queue: %s failed span test.\n", SPAN_TEST_QUEUE_NAME);
+    }
+    testResult = tempResult
+                     ? testResult
+                     : false; // Logical AND of testResult and tempResult.
+    printf("=== Commencing batch push/pop test === \n");
+    tempResult = queue_batchTest();
+    if (tempResult) {
+      printf("=== Queue: %s passed batch test.\n", BATCH_TEST_QUEUE_NAME);
+    } else {
+      printf("=== Queue: %s failed batch test.\n", BATCH_TEST_QUEUE_NAME);
+    }
     testResult = tempResult
                      ? testResult
                      : false; // Logical AND of testResult and tempResult.
@@ -626,5 +944,89 @@ bool queue_runTest() {
     queue_garbageCollect(&testQ);
     free(dataArray);
   }
+  // Run the typed queue tests (see queueTyped_test.c).
+  testResult = queueTyped_runTest() ? testResult : false;
   return testResult;
 }
+
+#define QUEUE_BENCHMARK_SIZE_COUNT 4
+// Sizes of the queues used by the filter: xQueue (FIR taps), yQueue (IIR
+// B-coefficient taps), zQueue (IIR A-coefficient taps) and the IIR output
+// queues used to compute power.
+static const queue_size_t
+    queue_benchmarkSizes[QUEUE_BENCHMARK_SIZE_COUNT] = {81, 11, 10, 2000};
+#define QUEUE_BENCHMARK_READS_PER_SIZE                                         \
+  2000000 // Read at least this many elements per measurement.
+#define QUEUE_BENCHMARK_QUEUE_NAME "benchmarkQ"
+
+// How queue_benchmarkReadAccess() reads the elements of the queue.
+typedef enum {
+  queue_benchmarkReadElementAt_e, // queue_readElementAt().
+  queue_benchmarkModulo_e,        // data[(indexOut + i) % size], a real modulo.
+  queue_benchmarkWindow_e         // queue_newestWindow().
+} queue_benchmarkAccess_t;
+
+// Emulates the way the FIR/IIR filters use a queue: push a new value and then
+// read every element in the queue, as selected by access. Returns the average
+// time to read one element in nanoseconds.
+static double queue_benchmarkReadAccess(queue_t *q,
+                                        queue_benchmarkAccess_t access) {
+  queue_size_t size = queue_size(q);
+  uint32_t passCount = QUEUE_BENCHMARK_READS_PER_SIZE / size;
+  volatile queue_data_t sink = 0.0; // Keeps the reads from being optimized out.
+  for (queue_size_t i = 0; i < size; i++) // Start with a full queue.
+    queue_overwritePush(q, (queue_data_t)i);
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t pass = 0; pass < passCount; pass++) {
+    queue_overwritePush(q, (queue_data_t)pass);
+    queue_data_t sum = 0.0;
+    if (access == queue_benchmarkWindow_e) {
+      const queue_data_t *window = queue_newestWindow(q, size);
+      for (queue_size_t i = 0; i < size; i++)
+        sum += window[i];
+    } else if (access == queue_benchmarkModulo_e) {
+      for (queue_size_t i = 0; i < size; i++)
+        sum += q->data[(q->indexOut + i) % size];
+    } else {
+      for (queue_size_t i = 0; i < size; i++)
+        sum += queue_readElementAt(q, i);
+    }
+    sink = sum;
+  }
+  benchmark_timestamp_t stop = benchmark_now();
+  (void)sink;
+  return benchmark_elapsedNanoseconds(start, stop) /
+         ((double)passCount * size);
+}
+
+// Compares the access time (ns/element) of queues created with queue_init()
+// against queues created with queue_initPowerOfTwo() for the queue sizes used
+// by the filter. Prints the results to the console. The columns are:
+// compare: queue_readElementAt(), which wraps with a compare and subtract.
+// modulo: the same queue read inline with data[(indexOut + i) % size], so it
+// also skips the call and bounds check of queue_readElementAt().
+// mask: queue_readElementAt() on a power-of-two queue, which wraps with a mask.
+// window: queue_newestWindow() on a power-of-two queue, no wrap at all.
+void queue_runBenchmark() {
+  printf("=== Queue benchmark (ns/element): push + read all elements ===\n");
+  printf("%8s %12s %12s %12s %12s\n", "size", "compare", "modulo", "mask",
+         "window");
+  for (uint16_t i = 0; i < QUEUE_BENCHMARK_SIZE_COUNT; i++) {
+    queue_t generalQ, powerOfTwoQ;
+    queue_init(&generalQ, queue_benchmarkSizes[i], QUEUE_BENCHMARK_QUEUE_NAME);
+    queue_initPowerOfTwo(&powerOfTwoQ, queue_benchmarkSizes[i],
+                         QUEUE_BENCHMARK_QUEUE_NAME);
+    double compareTime =
+        queue_benchmarkReadAccess(&generalQ, queue_benchmarkReadElementAt_e);
+    double moduloTime =
+        queue_benchmarkReadAccess(&generalQ, queue_benchmarkModulo_e);
+    double maskTime =
+        queue_benchmarkReadAccess(&powerOfTwoQ, queue_benchmarkReadElementAt_e);
+    double windowTime =
+        queue_benchmarkReadAccess(&powerOfTwoQ, queue_benchmarkWindow_e);
+    printf("%8u %12.3lf %12.3lf %12.3lf %12.3lf\n", queue_benchmarkSizes[i],
+           compareTime, moduloTime, maskTime, windowTime);
+    queue_garbageCollect(&generalQ);
+    queue_garbageCollect(&powerOfTwoQ);
+  }
+}
@@ -0,0 +1,183 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+// Renders a mix of the lasertag sounds with soundMixer.c to a 48 kHz, 16-bit
+// mono WAV file, so the mixer can be checked by ear or in a wave editor
+// without the board. Sounds start at the given times (rounded to the next
+// block of SOUND_MIXER_BLOCK_SIZE samples) with the priorities sound.c gives
+// them (see soundPriorities.h); the file ends when the last voice stops.
+// Prints the time spent mixing per block.
+//
+// Usage: mixwav [-o file] sound@milliseconds...
+//   -o file     Output file (default mix.wav).
+// e.g. mixwav hit@0 gunFire@100 gunFire@250 loseLife@300
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+#include "soundMixer.h"
+#include "soundPriorities.h"
+#include "sounds/bcfire01_48k.wav.h"
+#include "sounds/gameBoyStartup.wav.h"
+#include "sounds/gameOver48k.wav.h"
+#include "sounds/gunEmpty48k.wav.h"
+#include "sounds/ouch48k.wav.h"
+#include "sounds/pacmanDeath.wav.h"
+#include "sounds/powerUp48k.wav.h"
+#include "sounds/screamAndDie48k.wav.h"
+
+#define MIX_WAV_DEFAULT_FILE_NAME "mix.wav"
+#define MIX_WAV_SAMPLE_RATE SOUND_RESAMPLER_OUTPUT_RATE
+#define MIX_WAV_BITS_PER_SAMPLE 16
+#define MIX_WAV_HEADER_SIZE 44
+#define MIX_WAV_MAX_EVENT_COUNT 64
+
+typedef struct {
+  const char *name;
+  const imaAdpcm_clip_t *clip; // At MIX_WAV_SAMPLE_RATE, as wav2c -a wrote it.
+  sound_sounds_t sound;        // Index into soundPriorities_table.
+} mixWav_sound_t;
+
+static const mixWav_sound_t mixWav_sounds[] = {
+    {"gameStart", &gameBoyStartup_wav_clip, sound_gameStart_e},
+    {"gunFire", &bcfire01_48k_wav_clip, sound_gunFire_e},
+    {"hit", &ouch48k_wav_clip, sound_hit_e},
+    {"gunClick", &gunEmpty48k_wav_clip, sound_gunClick_e},
+    {"gunReload", &powerUp48k_wav_clip, sound_gunReload_e},
+    {"loseLife", &screamAndDie48k_wav_clip, sound_loseLife_e},
+    {"gameOver", &pacmanDeath_wav_clip, sound_gameOver_e},
+    {"returnToBase", &gameOver48k_wav_clip, sound_returnToBase_e}};
+#define MIX_WAV_SOUND_COUNT (sizeof(mixWav_sounds) / sizeof(mixWav_sounds[0]))
+
+typedef struct {
+  const mixWav_sound_t *sound;
+  uint32_t startSample;
+} mixWav_event_t;
+
+// Writes a little-endian value of byteCount bytes.
+static void mixWav_writeLittleEndian(FILE *file, uint32_t value,
+                                     uint16_t byteCount) {
+  for (uint16_t i = 0; i < byteCount; i++)
+    fputc((value >> (8 * i)) & 0xff, file);
+}
+
+// Writes a PCM WAV header for sampleCount mono samples.
+static void mixWav_writeHeader(FILE *file, uint32_t sampleCount) {
+  uint32_t dataSize = sampleCount * MIX_WAV_BITS_PER_SAMPLE / 8;
+  fwrite("RIFF", 4, 1, file);
+  mixWav_writeLittleEndian(file, MIX_WAV_HEADER_SIZE - 8 + dataSize, 4);
+  fwrite("WAVEfmt ", 8, 1, file);
+  mixWav_writeLittleEndian(file, 16, 4); // Size of the PCM format chunk.
+  mixWav_writeLittleEndian(file, 1, 2);  // PCM.
+  mixWav_writeLittleEndian(file, 1, 2);  // Mono.
+  mixWav_writeLittleEndian(file, MIX_WAV_SAMPLE_RATE, 4);
+  mixWav_writeLittleEndian(file,
+                           MIX_WAV_SAMPLE_RATE * MIX_WAV_BITS_PER_SAMPLE / 8, 4);
+  mixWav_writeLittleEndian(file, MIX_WAV_BITS_PER_SAMPLE / 8, 2);
+  mixWav_writeLittleEndian(file, MIX_WAV_BITS_PER_SAMPLE, 2);
+  fwrite("data", 4, 1, file);
+  mixWav_writeLittleEndian(file, dataSize, 4);
+}
+
+// Parses "name@milliseconds". Returns false if it is not a known sound.
+static bool mixWav_parseEvent(const char *argument, mixWav_event_t *event) {
+  const char *at = strchr(argument, '@');
+  if (at == NULL)
+    return false;
+  for (uint16_t i = 0; i < MIX_WAV_SOUND_COUNT; i++)
+    if (strlen(mixWav_sounds[i].name) == (size_t)(at - argument) &&
+        !strncmp(mixWav_sounds[i].name, argument, at - argument)) {
+      event->sound = &mixWav_sounds[i];
+      event->startSample = strtoul(at + 1, NULL, 0) * MIX_WAV_SAMPLE_RATE / 1000;
+      return true;
+    }
+  return false;
+}
+
+// Orders events by start time.
+static int mixWav_compareEvents(const void *a, const void *b) {
+  uint32_t startA = ((const mixWav_event_t *)a)->startSample;
+  uint32_t startB = ((const mixWav_event_t *)b)->startSample;
+  return (startA > startB) - (startA < startB);
+}
+
+// Prints the usage message and the sound names, and returns the exit status
+// for a usage error.
+static int mixWav_usage(const char *programName) {
+  fprintf(stderr, "Usage: %s [-o file] sound@milliseconds...\nSounds:",
+          programName);
+  for (uint16_t i = 0; i < MIX_WAV_SOUND_COUNT; i++)
+    fprintf(stderr, " %s", mixWav_sounds[i].name);
+  fprintf(stderr, "\n");
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+  const char *fileName = MIX_WAV_DEFAULT_FILE_NAME;
+  int option;
+  while ((option = getopt(argc, argv, "o:")) != -1) {
+    if (option != 'o')
+      return mixWav_usage(argv[0]);
+    fileName = optarg;
+  }
+  static mixWav_event_t events[MIX_WAV_MAX_EVENT_COUNT];
+  uint32_t eventCount = argc - optind;
+  if (eventCount == 0 || eventCount > MIX_WAV_MAX_EVENT_COUNT)
+    return mixWav_usage(argv[0]);
+  for (uint32_t i = 0; i < eventCount; i++)
+    if (!mixWav_parseEvent(argv[optind + i], &events[i])) {
+      fprintf(stderr, "Unknown sound: %s\n", argv[optind + i]);
+      return mixWav_usage(argv[0]);
+    }
+  qsort(events, eventCount, sizeof(events[0]), mixWav_compareEvents);
+  FILE *file = fopen(fileName, "wb");
+  if (file == NULL) {
+    perror(fileName);
+    return EXIT_FAILURE;
+  }
+  mixWav_writeHeader(file, 0); // Rewritten with the size at the end.
+
+  soundMixer_init();
+  uint32_t sampleCount = 0;
+  uint32_t blockCount = 0;
+  uint32_t nextEvent = 0;
+  double mixNanoseconds = 0;
+  while (nextEvent < eventCount || soundMixer_getActiveCount() > 0) {
+    for (; nextEvent < eventCount &&
+           events[nextEvent].startSample <= sampleCount;
+         nextEvent++) {
+      const mixWav_sound_t *sound = events[nextEvent].sound;
+      if (soundMixer_playAdpcm(sound->clip, SOUND_MIXER_UNITY_GAIN,
+                               soundPriorities_table[sound->sound]) < 0)
+        printf("%s at %u ms: no voice.\n", sound->name,
+               sampleCount * 1000 / MIX_WAV_SAMPLE_RATE);
+    }
+    uint16_t block[SOUND_MIXER_BLOCK_SIZE];
+    benchmark_timestamp_t start = benchmark_now();
+    soundMixer_mix(block, SOUND_MIXER_BLOCK_SIZE);
+    mixNanoseconds += benchmark_elapsedNanoseconds(start, benchmark_now());
+    for (uint16_t i = 0; i < SOUND_MIXER_BLOCK_SIZE; i++)
+      mixWav_writeLittleEndian(file, (int16_t)(block[i] - INT16_MAX),
+                               MIX_WAV_BITS_PER_SAMPLE / 8);
+    sampleCount += SOUND_MIXER_BLOCK_SIZE;
+    blockCount++;
+  }
+  rewind(file);
+  mixWav_writeHeader(file, sampleCount);
+  fclose(file);
+  printf("%s: %u samples (%.3lf s), %.1lf ns per block of %d.\n", fileName,
+         sampleCount, (double)sampleCount / MIX_WAV_SAMPLE_RATE,
+         mixNanoseconds / blockCount, SOUND_MIXER_BLOCK_SIZE);
+  return EXIT_SUCCESS;
+}
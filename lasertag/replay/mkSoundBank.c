@@ -0,0 +1,222 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+// Writes a sound bank (see soundBank.h) from 16-bit mono WAV files, so sounds
+// can be changed without running wav2c and rebuilding the game. The id of a
+// clip is the sound_sounds_t value sound_setSound() looks it up by. With -g,
+// the bank starts with the compiled-in game sounds, decoded from IMA-ADPCM,
+// and the WAV files replace those with the same id. Write the bank to the SD
+// card raw, e.g.
+//   dd if=sounds.bank of=/dev/sdX seek=<first sector>
+// or map it with soundBank_mapFile() on the host.
+//
+// Usage: mksoundbank [-g] [-o file] id:file.wav...
+//   -g          Include the compiled-in game sounds.
+//   -o file     Output file (default sounds.bank).
+// e.g. mksoundbank -g -o sounds.bank 2:myOuch.wav
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "soundBank.h"
+#include "sounds/bcfire01_48k.wav.h"
+#include "sounds/gameBoyStartup.wav.h"
+#include "sounds/gameOver48k.wav.h"
+#include "sounds/gunEmpty48k.wav.h"
+#include "sounds/ouch48k.wav.h"
+#include "sounds/pacmanDeath.wav.h"
+#include "sounds/powerUp48k.wav.h"
+#include "sounds/screamAndDie48k.wav.h"
+
+#define MK_SOUND_BANK_DEFAULT_FILE_NAME "sounds.bank"
+#define MK_SOUND_BANK_MAX_CLIP_COUNT 64
+#define MK_SOUND_BANK_CHUNK_HEADER_SIZE 8
+#define MK_SOUND_BANK_FORMAT_SIZE 16 // Of a PCM "fmt " chunk.
+#define MK_SOUND_BANK_PCM 1
+#define MK_SOUND_BANK_BITS_PER_SAMPLE 16
+
+// The compiled-in sounds, in sound_sounds_t order, so the index is the id.
+// They are IMA-ADPCM clips at 48 kHz; the bank holds them decoded.
+static const imaAdpcm_clip_t *const mkSoundBank_gameSounds[] = {
+    &gameBoyStartup_wav_clip, &bcfire01_48k_wav_clip, &ouch48k_wav_clip,
+    &gunEmpty48k_wav_clip,    &powerUp48k_wav_clip,   &screamAndDie48k_wav_clip,
+    &pacmanDeath_wav_clip,    &gameOver48k_wav_clip};
+#define MK_SOUND_BANK_GAME_SOUND_RATE 48000
+#define MK_SOUND_BANK_GAME_SOUND_COUNT                                         \
+  (sizeof(mkSoundBank_gameSounds) / sizeof(mkSoundBank_gameSounds[0]))
+
+static soundBank_clip_t mkSoundBank_clips[MK_SOUND_BANK_MAX_CLIP_COUNT];
+static uint32_t mkSoundBank_clipCount;
+
+// Reads a little-endian value of byteCount bytes from data.
+static uint32_t mkSoundBank_readLittleEndian(const uint8_t *data,
+                                             uint16_t byteCount) {
+  uint32_t value = 0;
+  for (uint16_t i = 0; i < byteCount; i++)
+    value |= (uint32_t)data[i] << (8 * i);
+  return value;
+}
+
+// Reads the samples of a 16-bit mono PCM WAV file into clip and converts them
+// the way wav2c does. Walks the chunks, so files with chunks other than
+// "fmt " and "data" (e.g., "LIST") are read too. Returns false on an error.
+static bool mkSoundBank_readWav(const char *fileName, soundBank_clip_t *clip) {
+  FILE *file = fopen(fileName, "rb");
+  if (file == NULL) {
+    perror(fileName);
+    return false;
+  }
+  uint8_t header[MK_SOUND_BANK_FORMAT_SIZE];
+  bool haveFormat = false;
+  uint16_t *samples = NULL;
+  if (fread(header, 12, 1, file) != 1 || memcmp(header, "RIFF", 4) ||
+      memcmp(header + 8, "WAVE", 4)) {
+    fprintf(stderr, "%s: not a WAV file.\n", fileName);
+    fclose(file);
+    return false;
+  }
+  while (samples == NULL &&
+         fread(header, MK_SOUND_BANK_CHUNK_HEADER_SIZE, 1, file) == 1) {
+    uint32_t size = mkSoundBank_readLittleEndian(header + 4, 4);
+    if (!memcmp(header, "fmt ", 4) && size >= MK_SOUND_BANK_FORMAT_SIZE) {
+      if (fread(header, MK_SOUND_BANK_FORMAT_SIZE, 1, file) != 1)
+        break;
+      if (mkSoundBank_readLittleEndian(header, 2) != MK_SOUND_BANK_PCM ||
+          mkSoundBank_readLittleEndian(header + 2, 2) != 1 ||
+          mkSoundBank_readLittleEndian(header + 14, 2) !=
+              MK_SOUND_BANK_BITS_PER_SAMPLE) {
+        fprintf(stderr, "%s: only 16-bit mono PCM is supported.\n", fileName);
+        break;
+      }
+      clip->sampleRate = mkSoundBank_readLittleEndian(header + 4, 4);
+      haveFormat = true;
+      size -= MK_SOUND_BANK_FORMAT_SIZE;
+    } else if (!memcmp(header, "data", 4) && haveFormat) {
+      clip->sampleCount = size / sizeof(int16_t);
+      samples = malloc(clip->sampleCount * sizeof(uint16_t));
+      if (samples == NULL ||
+          fread(samples, sizeof(int16_t), clip->sampleCount, file) !=
+              clip->sampleCount) {
+        fprintf(stderr, "%s: cannot read the samples.\n", fileName);
+        free(samples);
+        samples = NULL;
+        break;
+      }
+      for (uint32_t i = 0; i < clip->sampleCount; i++)
+        samples[i] = (int16_t)samples[i] + INT16_MAX; // As wav2c does.
+      clip->samples = samples;
+      size = 0;
+    }
+    if (fseek(file, size + size % 2, SEEK_CUR)) // Chunks are 2-byte aligned.
+      break;
+  }
+  fclose(file);
+  if (samples == NULL && haveFormat)
+    fprintf(stderr, "%s: no data chunk.\n", fileName);
+  return samples != NULL;
+}
+
+// Decodes a compiled-in sound into clip, in the format of the sound arrays.
+// Returns false if there is no memory for the samples.
+static bool mkSoundBank_decodeGameSound(uint32_t id, soundBank_clip_t *clip) {
+  const imaAdpcm_clip_t *adpcm = mkSoundBank_gameSounds[id];
+  int16_t *decoded = malloc(adpcm->sampleCount * sizeof(int16_t));
+  if (decoded == NULL) {
+    fprintf(stderr, "Cannot decode sound %u.\n", id);
+    return false;
+  }
+  imaAdpcm_state_t state = adpcm->index[0];
+  imaAdpcm_decode(adpcm, 0, &state, decoded, adpcm->sampleCount);
+  uint16_t *samples = (uint16_t *)decoded; // Converted in place.
+  for (uint32_t i = 0; i < adpcm->sampleCount; i++)
+    samples[i] = decoded[i] + INT16_MAX; // As wav2c does.
+  clip->id = id;
+  clip->sampleRate = MK_SOUND_BANK_GAME_SOUND_RATE;
+  clip->samples = samples;
+  clip->sampleCount = adpcm->sampleCount;
+  return true;
+}
+
+// Adds a clip, replacing one with the same id. Returns false if the bank is
+// full.
+static bool mkSoundBank_addClip(const soundBank_clip_t *clip) {
+  uint32_t i = 0;
+  while (i < mkSoundBank_clipCount && mkSoundBank_clips[i].id != clip->id)
+    i++;
+  if (i == MK_SOUND_BANK_MAX_CLIP_COUNT)
+    return false;
+  mkSoundBank_clips[i] = *clip;
+  if (i == mkSoundBank_clipCount)
+    mkSoundBank_clipCount++;
+  return true;
+}
+
+// Prints the usage message and returns the exit status for a usage error.
+static int mkSoundBank_usage(const char *programName) {
+  fprintf(stderr, "Usage: %s [-g] [-o file] id:file.wav...\n", programName);
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+  const char *fileName = MK_SOUND_BANK_DEFAULT_FILE_NAME;
+  bool gameSounds = false;
+  int option;
+  while ((option = getopt(argc, argv, "go:")) != -1) {
+    if (option == 'g')
+      gameSounds = true;
+    else if (option == 'o')
+      fileName = optarg;
+    else
+      return mkSoundBank_usage(argv[0]);
+  }
+  if (!gameSounds && optind == argc)
+    return mkSoundBank_usage(argv[0]);
+  for (uint32_t i = 0; gameSounds && i < MK_SOUND_BANK_GAME_SOUND_COUNT; i++) {
+    soundBank_clip_t clip;
+    if (!mkSoundBank_decodeGameSound(i, &clip))
+      return EXIT_FAILURE;
+    mkSoundBank_addClip(&clip);
+  }
+  for (int i = optind; i < argc; i++) {
+    char *end;
+    soundBank_clip_t clip;
+    clip.id = strtoul(argv[i], &end, 0);
+    if (end == argv[i] || *end != ':')
+      return mkSoundBank_usage(argv[0]);
+    if (!mkSoundBank_readWav(end + 1, &clip))
+      return EXIT_FAILURE;
+    if (!mkSoundBank_addClip(&clip)) {
+      fprintf(stderr, "At most %d clips.\n", MK_SOUND_BANK_MAX_CLIP_COUNT);
+      return EXIT_FAILURE;
+    }
+  }
+  uint32_t size = soundBank_getImageSize(mkSoundBank_clips,
+                                         mkSoundBank_clipCount);
+  uint32_t *image = malloc(size); // 4-byte aligned.
+  if (image == NULL) {
+    fprintf(stderr, "Cannot allocate %u bytes.\n", size);
+    return EXIT_FAILURE;
+  }
+  soundBank_build(image, mkSoundBank_clips, mkSoundBank_clipCount);
+  FILE *file = fopen(fileName, "wb");
+  if (file == NULL || fwrite(image, size, 1, file) != 1) {
+    perror(fileName);
+    return EXIT_FAILURE;
+  }
+  fclose(file);
+  printf("%s: %u clips, %u bytes (%u sectors of %d bytes).\n", fileName,
+         mkSoundBank_clipCount, size,
+         (size + SOUND_BANK_SD_BLOCK_SIZE - 1) / SOUND_BANK_SD_BLOCK_SIZE,
+         SOUND_BANK_SD_BLOCK_SIZE);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+// Replays a capture written by runningModes_captureAdcValues() through the
+// whole detector pipeline (filter_addNewInput(), the filters, the powers and
+// hit detection) as fast as the host can run it. Prints the hits as they are
+// detected and the sustained sample rate at the end, and optionally writes the
+// power of every band after each chunk to a CSV file. Only the time spent in
+// the detector is measured: reading and unpacking the file are excluded.
+//
+// Usage: replay [options] capture.bin
+//   -b          Use detectorBatch_run() instead of detector().
+//   -c count    Samples pushed into the ADC buffer per detector call (default
+//               100, i.e., 1 ms). This is also the resolution of the hit
+//               time-stamps and the power trace.
+//   -f index    Fudge-factor index (detector_setFudgeFactorIndex()).
+//   -i band     Ignore hits on a band; may be repeated.
+//   -t file     Write "seconds,power0,...,power9" lines after every chunk.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "adcCapture.h"
+#include "benchmark.h"
+#include "detector.h"
+#include "detectorBatch.h"
+#include "filter.h"
+#include "isr.h"
+#include "profiler.h"
+#include "replay.h"
+
+#define REPLAY_DEFAULT_CHUNK_SIZE 100 // 1 ms at 100 kHz.
+#define REPLAY_NANOSECONDS_PER_SECOND 1e9
+
+static uint64_t replay_sampleIndex; // Next sample to be pushed.
+static uint32_t replay_sampleRateHz;
+static bool replay_batched;
+static FILE *replay_traceFile;
+static uint32_t replay_hitCount;
+static double replay_detectorNanoseconds; // Time spent in the detector.
+
+// Returns the index of the next sample to be pushed into the ADC buffer.
+uint64_t replay_getSampleIndex() { return replay_sampleIndex; }
+
+// Converts a sample index to seconds since the start of the capture.
+static double replay_toSeconds(uint64_t sampleIndex) {
+  return (double)sampleIndex / replay_sampleRateHz;
+}
+
+// Runs the detector until the ADC buffer is empty (detector() may pop a single
+// value per call), then reports a hit and appends a line to the power trace.
+static void replay_runDetector() {
+  benchmark_timestamp_t start = benchmark_now();
+  if (replay_batched)
+    detectorBatch_run(detector_runHitDetection);
+  else
+    do
+      detector(false);
+    while (isr_adcBufferElementCount() > 0);
+  replay_detectorNanoseconds +=
+      benchmark_elapsedNanoseconds(start, benchmark_now());
+  if (detector_hitDetected()) {
+    replay_hitCount++;
+    printf("hit: %.4lf s, frequency %d\n", replay_toSeconds(replay_sampleIndex),
+           detector_getFrequencyNumberOfLastHit());
+    detector_clearHit();
+  }
+  if (replay_traceFile != NULL) {
+    double powerValues[FILTER_FREQUENCY_COUNT];
+    filter_getCurrentPowerValues(powerValues);
+    fprintf(replay_traceFile, "%.5lf", replay_toSeconds(replay_sampleIndex));
+    for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+      fprintf(replay_traceFile, ",%le", powerValues[band]);
+    fprintf(replay_traceFile, "\n");
+  }
+}
+
+// Pushes the samples of a block into the ADC buffer chunkSize at a time and
+// runs the detector after each chunk.
+static void replay_runBlock(const adcCapture_block_t *block,
+                            uint32_t chunkSize) {
+  for (uint32_t i = 0; i < block->sampleCount;) {
+    uint32_t end = i + chunkSize < block->sampleCount ? i + chunkSize
+                                                      : block->sampleCount;
+    for (; i < end; i++) {
+      isr_addDataToAdcBuffer(block->samples[i]);
+      replay_sampleIndex++;
+    }
+    replay_runDetector();
+  }
+}
+
+#ifdef PROFILER_ENABLED
+// Prints p50, p99 and the maximum duration of each profiled stage that ran.
+static void replay_printProfilerStatistics() {
+  printf("Stage durations in %s:\n", PROFILER_UNIT_NAME);
+  printf("%-12s %9s %7s %7s %8s\n", "Stage", "count", "p50", "p99", "max");
+  for (uint16_t stage = 0; stage < PROFILER_STAGE_COUNT; stage++) {
+    if (profiler_getCount(stage) == 0)
+      continue;
+    printf("%-12s %9u %7u %7u %8u\n", profiler_getStageName(stage),
+           profiler_getCount(stage), profiler_getPercentile(stage, 0.5),
+           profiler_getPercentile(stage, 0.99), profiler_getMax(stage));
+  }
+}
+#endif
+
+// Prints the usage message and returns the exit status for a usage error.
+static int replay_usage(const char *programName) {
+  fprintf(stderr,
+          "Usage: %s [-b] [-c count] [-f index] [-i band]... [-t file] "
+          "capture.bin\n",
+          programName);
+  return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
+  uint32_t chunkSize = REPLAY_DEFAULT_CHUNK_SIZE;
+  bool ignoredFrequencies[FILTER_FREQUENCY_COUNT] = {false};
+  int32_t fudgeFactorIndex = -1; // Keep detector.c's default.
+  const char *traceFileName = NULL;
+  int option;
+  while ((option = getopt(argc, argv, "bc:f:i:t:")) != -1) {
+    switch (option) {
+    case 'b':
+      replay_batched = true;
+      break;
+    case 'c':
+      chunkSize = strtoul(optarg, NULL, 0);
+      if (chunkSize == 0 || chunkSize > REPLAY_MAX_CHUNK_SIZE) {
+        fprintf(stderr, "The chunk size must be 1 to %d.\n",
+                REPLAY_MAX_CHUNK_SIZE);
+        return EXIT_FAILURE;
+      }
+      break;
+    case 'f':
+      fudgeFactorIndex = strtol(optarg, NULL, 0);
+      break;
+    case 'i': {
+      uint32_t band = strtoul(optarg, NULL, 0);
+      if (band >= FILTER_FREQUENCY_COUNT) {
+        fprintf(stderr, "Bands are 0 to %d.\n", FILTER_FREQUENCY_COUNT - 1);
+        return EXIT_FAILURE;
+      }
+      ignoredFrequencies[band] = true;
+      break;
+    }
+    case 't':
+      traceFileName = optarg;
+      break;
+    default:
+      return replay_usage(argv[0]);
+    }
+  }
+  if (optind != argc - 1)
+    return replay_usage(argv[0]);
+  FILE *captureFile = fopen(argv[optind], "rb");
+  if (captureFile == NULL) {
+    perror(argv[optind]);
+    return EXIT_FAILURE;
+  }
+  if (!adcCapture_readHeader(captureFile, &replay_sampleRateHz) ||
+      replay_sampleRateHz == 0) {
+    fprintf(stderr, "%s is not an ADC capture.\n", argv[optind]);
+    return EXIT_FAILURE;
+  }
+  if (traceFileName != NULL &&
+      (replay_traceFile = fopen(traceFileName, "w")) == NULL) {
+    perror(traceFileName);
+    return EXIT_FAILURE;
+  }
+
+  filter_init();
+  isr_init();
+  detector_init(ignoredFrequencies);
+  if (fudgeFactorIndex >= 0)
+    detector_setFudgeFactorIndex(fudgeFactorIndex);
+  detectorBatch_init();
+  profiler_init();
+  static adcCapture_block_t block;
+  uint64_t lostSampleCount = 0;
+  while (adcCapture_readBlock(captureFile, &block)) {
+    if (block.firstSampleIndex > replay_sampleIndex) {
+      printf("gap: %.4lf s, %llu samples lost\n",
+             replay_toSeconds(replay_sampleIndex),
+             (unsigned long long)(block.firstSampleIndex - replay_sampleIndex));
+      lostSampleCount += block.firstSampleIndex - replay_sampleIndex;
+      replay_sampleIndex = block.firstSampleIndex; // Keep time-stamps aligned.
+    }
+    replay_runBlock(&block, chunkSize);
+  }
+  fclose(captureFile);
+  if (replay_traceFile != NULL)
+    fclose(replay_traceFile);
+
+  uint64_t replayedSampleCount = replay_sampleIndex - lostSampleCount;
+  double detectorSeconds =
+      replay_detectorNanoseconds / REPLAY_NANOSECONDS_PER_SECOND;
+  printf("Replayed %llu samples (%.2lf s of capture) with %s in %.3lf s.\n",
+         (unsigned long long)replayedSampleCount,
+         replay_toSeconds(replay_sampleIndex),
+         replay_batched ? "detectorBatch_run()" : "detector()",
+         detectorSeconds);
+  printf("Samples processed per second: %.0lf (%.1lfx real time).\n",
+         replayedSampleCount / detectorSeconds,
+         replayedSampleCount / detectorSeconds / replay_sampleRateHz);
+  detector_hitCount_t hitCounts[FILTER_FREQUENCY_COUNT];
+  detector_getHitCounts(hitCounts);
+  printf("Hits: %u. Hit counts per frequency:", replay_hitCount);
+  for (uint16_t band = 0; band < FILTER_FREQUENCY_COUNT; band++)
+    printf(" %u", hitCounts[band]);
+  printf("\n");
+#ifdef PROFILER_ENABLED
+  replay_printProfilerStatistics();
+#endif
+  return EXIT_SUCCESS;
+}
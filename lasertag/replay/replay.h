@@ -0,0 +1,27 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include <stdint.h>
+
+// The replay harness runs the lasertag detector on the host, without the
+// board or the emulator: replay.c feeds a capture file (see adcCapture.h) into
+// the ADC buffer and runs detector() or detectorBatch_run() as fast as it can.
+// replayStubs.c stands in for the parts of the game that need hardware (the
+// ISR, the lockout and hit-LED timers and the interrupt controls).
+
+#define REPLAY_MAX_CHUNK_SIZE 4096 // Most samples pushed per detector call.
+
+// Returns the index of the next sample to be pushed into the ADC buffer, i.e.,
+// the replay's notion of time in 100 kHz ticks. The stand-in timers run on it.
+uint64_t replay_getSampleIndex();
+
+#endif /* REPLAY_H_ */
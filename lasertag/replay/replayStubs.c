@@ -0,0 +1,100 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "adcBuffer.h"
+#include "hitLedTimer.h"
+#include "interrupts.h"
+#include "isr.h"
+#include "lockoutTimer.h"
+#include "replay.h"
+
+static adcBuffer_t replayStubs_adcBuffer;
+
+// The ISR: the same ADC buffer as isr.c, filled by replay.c instead of the
+// timer interrupt.
+void isr_init() {
+  adcBuffer_init(&replayStubs_adcBuffer, REPLAY_MAX_CHUNK_SIZE);
+}
+
+void isr_function() {}
+
+void isr_addDataToAdcBuffer(isr_AdcValue_t value) {
+  adcBuffer_push(&replayStubs_adcBuffer, value);
+}
+
+isr_AdcValue_t isr_removeDataFromAdcBuffer() {
+  isr_AdcValue_t value = 0;
+  adcBuffer_pop(&replayStubs_adcBuffer, &value);
+  return value;
+}
+
+uint32_t isr_removeDataFromAdcBufferN(isr_AdcValue_t values[],
+                                      uint32_t maxCount) {
+  return adcBuffer_popN(&replayStubs_adcBuffer, values, maxCount);
+}
+
+uint32_t isr_adcBufferElementCount() {
+  return adcBuffer_elementCount(&replayStubs_adcBuffer);
+}
+
+adcBuffer_t *isr_getAdcBuffer() { return &replayStubs_adcBuffer; }
+
+// The timers count replayed samples instead of timer ticks, so a lockout lasts
+// LOCKOUT_TIMER_EXPIRE_VALUE samples of the capture however fast it replays.
+static bool replayStubs_lockoutStarted;
+static uint64_t replayStubs_lockoutStartIndex;
+static bool replayStubs_hitLedStarted;
+static uint64_t replayStubs_hitLedStartIndex;
+
+void lockoutTimer_init() { replayStubs_lockoutStarted = false; }
+
+void lockoutTimer_tick() {}
+
+void lockoutTimer_start() {
+  replayStubs_lockoutStarted = true;
+  replayStubs_lockoutStartIndex = replay_getSampleIndex();
+}
+
+bool lockoutTimer_running() {
+  return replayStubs_lockoutStarted &&
+         replay_getSampleIndex() - replayStubs_lockoutStartIndex <
+             LOCKOUT_TIMER_EXPIRE_VALUE;
+}
+
+void hitLedTimer_init() { replayStubs_hitLedStarted = false; }
+
+void hitLedTimer_tick() {}
+
+void hitLedTimer_start() {
+  replayStubs_hitLedStarted = true;
+  replayStubs_hitLedStartIndex = replay_getSampleIndex();
+}
+
+bool hitLedTimer_running() {
+  return replayStubs_hitLedStarted &&
+         replay_getSampleIndex() - replayStubs_hitLedStartIndex <
+             HIT_LED_TIMER_EXPIRE_VALUE;
+}
+
+void hitLedTimer_turnLedOn() {}
+
+void hitLedTimer_turnLedOff() {}
+
+void hitLedTimer_disable() {}
+
+void hitLedTimer_enable() {}
+
+// Nothing interrupts the replay, so detector(true) behaves like
+// detector(false).
+int interrupts_enableArmInts() { return 0; }
+
+int interrupts_disableArmInts() { return 0; }
@@ -7,14 +7,19 @@ source code for personal or educational use.
 For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 */
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "adcBuffer.h"
+#include "adcCapture.h"
+#include "benchmark.h"
 #include "buttons.h"
 #include "detector.h"
+#include "detectorBatch.h"
 #include "display.h"
 #include "filter.h"
 #include "histogram.h"
@@ -22,14 +27,22 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "interrupts.h"
 #include "intervalTimer.h"
 #include "isr.h"
+#include "latencyTrace.h"
 #include "lockoutTimer.h"
+#include "metrics.h"
+#include "profiler.h"
 #include "runningModes.h"
+#include "scheduler.h"
 #include "switches.h"
 #include "transmitter.h"
 #include "trigger.h"
 #include "utils.h"
 #include "xparameters.h"
 
+#ifdef ZYBO_BOARD
+#include "xil_printf.h" // outbyte()
+#endif
+
 // Uncomment this code so that the code in the various modes will
 // ignore your own frequency. You still must properly implement
 // the ability to ignore frequencies in detector.c
@@ -51,8 +64,14 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #define MAIN_CUMULATIVE_TIMER                                                  \
   INTERVAL_TIMER_TIMER_2 // Used to compute cumulative run-time in main.
 
+// Periods of the main-loop tasks (see runningModes_initScheduler()), in ticks
+// of the 100 kHz timer interrupt.
 #define SYSTEM_TICKS_PER_HISTOGRAM_UPDATE                                      \
   30000 // Update the histogram about 3 times per second.
+#define RUNNING_MODES_HIT_PERIOD_TICKS 100            // 1 ms.
+#define RUNNING_MODES_BUTTONS_PERIOD_TICKS 1000       // 10 ms.
+#define RUNNING_MODES_SWITCHES_PERIOD_TICKS 10000     // 100 ms.
+#define RUNNING_MODES_HIT_HISTOGRAM_PERIOD_TICKS 1000 // 10 ms.
 
 #define RUNNING_MODE_WARNING_TEXT_SIZE 2 // Upsize the text for visibility.
 #define RUNNING_MODE_WARNING_TEXT_COLOR DISPLAY_RED // Red for more visibility.
@@ -66,19 +85,235 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 // ADC queue should have no more than this number of unprocessed elements for
 // good performance.
 #define SUGGESTED_REMAINING_ELEMENT_COUNT 500
+// The scheduler holds back the UI tasks (switches, TFT) while the ADC queue
+// holds at least this many elements, and the game tasks (hits, buttons) above
+// twice as many, so the detector can catch up.
+#define RUNNING_MODES_UI_BACKLOG_LIMIT SUGGESTED_REMAINING_ELEMENT_COUNT
+#define RUNNING_MODES_GAME_BACKLOG_LIMIT (2 * SUGGESTED_REMAINING_ELEMENT_COUNT)
+// A game task held back this long runs anyway, so btn3 still stops the mode
+// and hits are still counted if the backlog never drains.
+#define RUNNING_MODES_GAME_MAX_LATENESS_TICKS 10000 // 100 ms.
 
 // Defined to make things more readable.
 #define INTERRUPTS_CURRENTLY_ENABLED true
 #define INTERRUPTS_CURRENTLY_DISABLE false
 
+// Uncomment to drain the whole ADC buffer with detectorBatch_run() on each
+// main-loop iteration instead of calling detector(), which pops one value.
+//#define RUNNING_MODES_BATCHED_DETECTOR
+
+// runningModes_captureAdcValues() stops after this many samples (10 seconds,
+// about 1.5 MB packed) if btn3 is not pressed first.
+#define RUNNING_MODES_CAPTURE_MAX_SAMPLE_COUNT 1000000
+#define RUNNING_MODES_CAPTURE_SAMPLE_RATE 100000 // isr_function() rate in Hz.
+#define RUNNING_MODES_CAPTURE_FILE_NAME "adcCapture.bin" // Emulator only.
+
 // Keep track of detector invocations.
 uint32_t detectorInvocationCount = 0;
 
+// Shared by the main-loop tasks of the running modes.
+static bool runningModes_stopRequested; // Set to end the main loop.
+static uint32_t runningModes_hitCount;
+static bool runningModes_hitCountsChanged; // Hit histogram needs a redraw.
+
+// Runs the detector once: a single call to detector(), or a batch that drains
+// the ADC buffer and runs hit detection at each decimation boundary.
+static void runningModes_runDetector() {
+#ifdef RUNNING_MODES_BATCHED_DETECTOR
+  detectorBatch_run(detector_runHitDetection);
+#else
+  detector(INTERRUPTS_CURRENTLY_ENABLED); // Interrupts are currently enabled.
+#endif
+}
+
+// Returns the number of ADC samples the detector has taken so far. Each
+// interrupt adds one sample, so without batching the samples processed are the
+// interrupts minus what is still waiting in the ADC queue.
+static uint32_t runningModes_getProcessedSampleCount() {
+#ifdef RUNNING_MODES_BATCHED_DETECTOR
+  return detectorBatch_getSampleCount();
+#else
+  return interrupts_isrInvocationCount() - isr_adcBufferElementCount();
+#endif
+}
+
+#ifdef METRICS_ENABLED
+#define RUNNING_MODES_PERMILLE 1000
+// Called by metrics_poll() before each sample. Sets the metrics that cost too
+// much to keep current in the main loop: the samples processed, the samples
+// dropped and the share of the run time spent in the ISR, all since the
+// previous sample.
+static void runningModes_updateMetrics() {
+  static uint32_t lastSampleCount, lastDroppedCount;
+  static double lastIsrSeconds, lastRunningSeconds;
+  uint32_t sampleCount = runningModes_getProcessedSampleCount();
+  uint32_t droppedCount = adcBuffer_getDroppedCount(isr_getAdcBuffer());
+  double isrSeconds =
+      intervalTimer_getTotalDurationInSeconds(ISR_CUMULATIVE_TIMER);
+  double runningSeconds =
+      intervalTimer_getTotalDurationInSeconds(TOTAL_RUNTIME_TIMER);
+  // The timers and the sample count start over with each running mode.
+  if (runningSeconds < lastRunningSeconds || sampleCount < lastSampleCount ||
+      droppedCount < lastDroppedCount) {
+    lastSampleCount = lastDroppedCount = 0;
+    lastIsrSeconds = lastRunningSeconds = 0;
+  }
+  metrics_add(METRICS_SAMPLES_PROCESSED, sampleCount - lastSampleCount);
+  metrics_add(METRICS_DROPPED_SAMPLES, droppedCount - lastDroppedCount);
+  if (runningSeconds > lastRunningSeconds)
+    metrics_set(METRICS_ISR_TIME_PERMILLE,
+                (isrSeconds - lastIsrSeconds) /
+                    (runningSeconds - lastRunningSeconds) *
+                    RUNNING_MODES_PERMILLE);
+  lastSampleCount = sampleCount;
+  lastDroppedCount = droppedCount;
+  lastIsrSeconds = isrSeconds;
+  lastRunningSeconds = runningSeconds;
+}
+#endif
+
+// Counts a detector invocation for the run-time statistics and the metrics,
+// and streams the metrics when they are due.
+static void runningModes_countDetectorInvocation() {
+  detectorInvocationCount++;
+  METRICS_ADD(METRICS_DETECTOR_INVOCATIONS, 1);
+  METRICS_RAISE(METRICS_ADC_QUEUE_PEAK, isr_adcBufferElementCount());
+  METRICS_POLL(interrupts_isrInvocationCount());
+}
+
+// DSP task: runs filters, computes power, etc.
+static void runningModes_detectorTask() {
+  intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
+                                              // doing something.
+  runningModes_countDetectorInvocation(); // Used for run-time statistics.
+  runningModes_runDetector();             // Interrupts are currently enabled.
+  intervalTimer_stop(MAIN_CUMULATIVE_TIMER);
+}
+
+// Game task: ends the main loop when btn3 is pressed.
+static void runningModes_buttonsTask() {
+  if (buttons_read() & BUTTONS_BTN3_MASK)
+    runningModes_stopRequested = true;
+}
+
+// UI task: reads the switches and switches frequency as required.
+static void runningModes_switchesTask() {
+  transmitter_setFrequencyNumber(runningModes_getFrequencySetting());
+}
+
+// UI task of runningModes_continuous(): plots the received power for each
+// channel on the TFT.
+static void runningModes_powerHistogramTask() {
+  double powerValues[FILTER_FREQUENCY_COUNT]; // Copy the current power
+                                              // values to here.
+  filter_getCurrentPowerValues(powerValues);  // Copy the current power values.
+  PROFILER_START(histogramStart);
+  histogram_plotUserFrequencyPower(
+      powerValues); // Plot the power values on the TFT.
+  PROFILER_STOP(PROFILER_STAGE_HISTOGRAM, histogramStart);
+}
+
+// Game task of runningModes_shooter(): counts and clears a detected hit and
+// ends the main loop after MAX_HIT_COUNT hits.
+static void runningModes_hitTask() {
+  if (!detector_hitDetected())
+    return;
+  LATENCY_TRACE_DETECTION(detector_getFrequencyNumberOfLastHit(),
+                          isr_adcBufferElementCount());
+  runningModes_hitCount++; // increment the hit count.
+  METRICS_ADD(METRICS_HITS_0 + detector_getFrequencyNumberOfLastHit(), 1);
+  detector_clearHit(); // Clear the hit.
+  runningModes_hitCountsChanged = true;
+  if (runningModes_hitCount >= MAX_HIT_COUNT)
+    runningModes_stopRequested = true;
+}
+
+// UI task of runningModes_shooter(): plots the hit counts on the TFT after a
+// hit.
+static void runningModes_hitHistogramTask() {
+  if (!runningModes_hitCountsChanged)
+    return;
+  runningModes_hitCountsChanged = false;
+  detector_hitCount_t
+      hitCounts[DETECTOR_HIT_ARRAY_SIZE]; // Store the hit-counts here.
+  detector_getHitCounts(hitCounts);       // Get the current hit counts.
+  histogram_plotUserHits(hitCounts);      // Plot the hit counts on the TFT.
+  LATENCY_TRACE_REACTION(LATENCY_TRACE_REACTION_DISPLAY);
+}
+
+// Sets up the scheduler with the tasks that all modes share: the detector,
+// btn3 and the switches. The time is the timer interrupt count and the
+// back-pressure is the ADC queue.
+static void runningModes_initScheduler() {
+  runningModes_stopRequested = false;
+  scheduler_init(interrupts_isrInvocationCount, isr_adcBufferElementCount);
+  scheduler_setBacklogLimit(SCHEDULER_PRIORITY_GAME,
+                            RUNNING_MODES_GAME_BACKLOG_LIMIT);
+  scheduler_setBacklogLimit(SCHEDULER_PRIORITY_UI,
+                            RUNNING_MODES_UI_BACKLOG_LIMIT);
+  scheduler_setMaxLateness(SCHEDULER_PRIORITY_GAME,
+                           RUNNING_MODES_GAME_MAX_LATENESS_TICKS);
+  scheduler_addTask("detector", SCHEDULER_PRIORITY_DSP, 0,
+                    runningModes_detectorTask);
+  scheduler_addTask("buttons", SCHEDULER_PRIORITY_GAME,
+                    RUNNING_MODES_BUTTONS_PERIOD_TICKS,
+                    runningModes_buttonsTask);
+  scheduler_addTask("switches", SCHEDULER_PRIORITY_UI,
+                    RUNNING_MODES_SWITCHES_PERIOD_TICKS,
+                    runningModes_switchesTask);
+}
+
 // This array is indexed by frequency number. If array-element[freq_no] == true,
 // the frequency is ignored, e.g., no hit will ever occur at that frequency.
 // static bool ignoredFrequenciesArray[FILTER_FREQUENCY_COUNT] =
 //  {false, false, false, false, false, false, false, false, false, false};
 
+#ifdef PROFILER_ENABLED
+#define PROFILER_SCREEN_DELAY_MS 10000 // Time to read the run-time statistics.
+// Prints p50, p99 and the maximum duration of each profiled stage on the TFT
+// display (and the console), one line per stage that ran.
+static void runningModes_printProfilerStatistics() {
+  char sprintfBuffer[MAX_BUFFER_SIZE]; // Generic message buffer.
+  display_setTextSize(RUNNING_MODE_NORMAL_TEXT_SIZE);
+  display_setTextColor(RUNNING_MODE_NORMAL_TEXT_COLOR);
+  display_setCursor(RUNNING_MODE_SCREEN_X_ORIGIN, RUNNING_MODE_SCREEN_Y_ORIGIN);
+  display_fillScreen(DISPLAY_BLACK);
+  sprintf(sprintfBuffer, "Stage durations in %s:", PROFILER_UNIT_NAME);
+  display_println(sprintfBuffer);
+  printf("%s\n", sprintfBuffer);
+  sprintf(sprintfBuffer, "%-12s %7s %7s %7s %8s", "Stage", "count", "p50",
+          "p99", "max");
+  display_println(sprintfBuffer);
+  printf("%s\n", sprintfBuffer);
+  for (uint16_t stage = 0; stage < PROFILER_STAGE_COUNT; stage++) {
+    if (profiler_getCount(stage) == 0)
+      continue;
+    sprintf(sprintfBuffer, "%-12s %7u %7u %7u %8u",
+            profiler_getStageName(stage), profiler_getCount(stage),
+            profiler_getPercentile(stage, 0.5),
+            profiler_getPercentile(stage, 0.99), profiler_getMax(stage));
+    display_println(sprintfBuffer);
+    printf("%s\n", sprintfBuffer);
+  }
+}
+#endif
+
+// Prints how long the ADC queue spent at each fill level to the console, as a
+// percentage of the pushes, one bin of the capacity per line.
+static void runningModes_printAdcOccupancy(adcBuffer_t *adcBuffer) {
+  uint32_t totalTicks = 0;
+  for (uint16_t bin = 0; bin < ADC_BUFFER_OCCUPANCY_BIN_COUNT; bin++)
+    totalTicks += adcBuffer_getOccupancyTicks(adcBuffer, bin);
+  if (totalTicks == 0)
+    return;
+  uint32_t binWidth =
+      adcBuffer_size(adcBuffer) / ADC_BUFFER_OCCUPANCY_BIN_COUNT;
+  printf("ADC queue occupancy (capacity %u):\n", adcBuffer_size(adcBuffer));
+  for (uint16_t bin = 0; bin < ADC_BUFFER_OCCUPANCY_BIN_COUNT; bin++)
+    printf("%5u-%5u: %6.2f%%\n", bin * binWidth, (bin + 1) * binWidth,
+           100.0 * adcBuffer_getOccupancyTicks(adcBuffer, bin) / totalTicks);
+}
+
 // Prints out various run-time statistics on the TFT display.
 // Assumes the following:
 // detected interrupts is retrieved with interrupts_isrInvocationCount(),
@@ -103,7 +338,13 @@ void runningModes_printRunTimeStatistics() {
   display_print("Unprocessed elements in ADC queue:");
   uint32_t remainingElementCount = isr_adcBufferElementCount();
   display_printlnDecimalInt(remainingElementCount);
+  adcBuffer_t *adcBuffer = isr_getAdcBuffer();
+  display_print("ADC queue high-water mark:         ");
+  display_printlnDecimalInt(adcBuffer_getHighWaterMark(adcBuffer));
+  display_print("Samples dropped (ADC queue full):  ");
+  display_printlnDecimalInt(adcBuffer_getDroppedCount(adcBuffer));
   display_printChar('\n');
+  runningModes_printAdcOccupancy(adcBuffer);
   double runningSeconds, isrRunningSeconds, mainLoopRunningSeconds;
   runningSeconds = intervalTimer_getTotalDurationInSeconds(TOTAL_RUNTIME_TIMER);
   // Print out total running time in seconds.
@@ -149,6 +390,13 @@ void runningModes_printRunTimeStatistics() {
   display_print(sprintfBuffer);
   display_printChar('\n');
   display_printChar('\n');
+  // Print out the sustained sample rate.
+  double processedSampleCount = runningModes_getProcessedSampleCount();
+  display_print("Samples processed per second: ");
+  sprintf(sprintfBuffer, "%5.2f", processedSampleCount / runningSeconds);
+  display_print(sprintfBuffer);
+  display_printChar('\n');
+  display_printChar('\n');
   // If the detector invocation rate is too low, inform the user.
   if (detectorInvocationCount / runningSeconds <
       SUGGESTED_DETECTOR_INVOCATIONS_PER_SECOND) {
@@ -168,6 +416,10 @@ void runningModes_printRunTimeStatistics() {
     display_printDecimalInt(SUGGESTED_REMAINING_ELEMENT_COUNT);
     display_println(" elements.");
   }
+#ifdef PROFILER_ENABLED
+  utils_msDelay(PROFILER_SCREEN_DELAY_MS);
+  runningModes_printProfilerStatistics();
+#endif
 }
 
 // Group all of the inits together to reduce visual clutter.
@@ -205,6 +457,8 @@ void runningModes_continuous() {
   ignoredFrequenciesArray[runningModes_getFrequencySetting()] = true;
 #endif
   detector_init(ignoredFrequenciesArray);
+  detectorBatch_init();
+  profiler_init();
 
   // Prints an error message if an internal failure occurs because the argument
   // = true.
@@ -214,8 +468,6 @@ void runningModes_continuous() {
   interrupts_enableTimerGlobalInts(); // Allows the timer to generate
                                       // interrupts.
   interrupts_startArmPrivateTimer();  // Start the private ARM timer running.
-  uint16_t histogramSystemTicks =
-      0; // Only update the histogram display every so many ticks.
   intervalTimer_reset(
       ISR_CUMULATIVE_TIMER); // Used to measure ISR execution time.
   intervalTimer_reset(
@@ -225,35 +477,26 @@ void runningModes_continuous() {
   intervalTimer_start(
       TOTAL_RUNTIME_TIMER);            // Start measuring total execution time.
   transmitter_setContinuousMode(true); // Run the transmitter continuously.
+  adcBuffer_resetStatistics(isr_getAdcBuffer());
+  runningModes_initScheduler();
+  scheduler_addTask("histogram", SCHEDULER_PRIORITY_UI,
+                    SYSTEM_TICKS_PER_HISTOGRAM_UPDATE,
+                    runningModes_powerHistogramTask);
   interrupts_enableArmInts();  // The ARM will start seeing interrupts after
                                // this.
   transmitter_run();           // Start the transmitter.
   detectorInvocationCount = 0; // Keep track of detector invocations.
-  while (!(buttons_read() &
-           BUTTONS_BTN3_MASK)) { // Run until you detect btn3 pressed.
-    transmitter_setFrequencyNumber(runningModes_getFrequencySetting());
-    detectorInvocationCount++; // Used for run-time statistics.
-    histogramSystemTicks++;    // Keep track of ticks so you know when to update
-                               // the histogram.
-    // Run filters, compute power, etc.
-    intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
-                                                // doing something.
-    detector(INTERRUPTS_CURRENTLY_ENABLED); // Interrupts are currently enabled.
-    intervalTimer_stop(MAIN_CUMULATIVE_TIMER);
-    // If enough ticks have transpired, update the histogram.
-    if (histogramSystemTicks >= SYSTEM_TICKS_PER_HISTOGRAM_UPDATE) {
-      double powerValues[FILTER_FREQUENCY_COUNT]; // Copy the current power
-                                                  // values to here.
-      filter_getCurrentPowerValues(
-          powerValues); // Copy the current power values.
-      histogram_plotUserFrequencyPower(
-          powerValues); // Plot the power values on the TFT.
-      histogramSystemTicks =
-          0; // Reset the tick count and wait for the next update time.
-    }
-  }
-  interrupts_disableArmInts();           // Stop interrupts.
+#ifdef METRICS_ENABLED
+  metrics_init(interrupts_isrInvocationCount(), runningModes_updateMetrics);
+#endif
+  while (!runningModes_stopRequested) // Run until you detect btn3 pressed.
+    scheduler_runOnce();
+  interrupts_disableArmInts(); // Stop interrupts.
+#ifdef METRICS_ENABLED
+  metrics_flush(); // Print the samples that were still waiting.
+#endif
   runningModes_printRunTimeStatistics(); // Print the run-time statistics.
+  scheduler_printStatistics();           // To the console.
 }
 
 // This mode runs continuously until btn3 is pressed.
@@ -272,7 +515,11 @@ void runningModes_shooter() {
   ignoredFrequencies[runningModes_getFrequencySetting()] = true;
 #endif
   detector_init(ignoredFrequencies);
-  uint16_t hitCount = 0;
+  detectorBatch_init();
+  profiler_init();
+  latencyTrace_init(); // Sample sequence numbers start with detectorBatch's.
+  runningModes_hitCount = 0;
+  runningModes_hitCountsChanged = false;
   detectorInvocationCount = 0; // Keep track of detector invocations.
   trigger_enable();         // Makes the trigger state machine responsive to the
                             // trigger.
@@ -280,8 +527,6 @@ void runningModes_shooter() {
   interrupts_enableTimerGlobalInts(); // Allows the timer to generate
                                       // interrupts.
   interrupts_startArmPrivateTimer();  // Start the private ARM timer running.
-  uint16_t histogramSystemTicks =
-      0; // Only update the histogram display every so many ticks.
   intervalTimer_reset(
       ISR_CUMULATIVE_TIMER); // Used to measure ISR execution time.
   intervalTimer_reset(
@@ -290,38 +535,36 @@ void runningModes_shooter() {
       MAIN_CUMULATIVE_TIMER); // Used to measure main-loop execution time.
   intervalTimer_start(
       TOTAL_RUNTIME_TIMER);   // Start measuring total execution time.
+  adcBuffer_resetStatistics(isr_getAdcBuffer());
+  runningModes_initScheduler();
+  scheduler_addTask("hits", SCHEDULER_PRIORITY_GAME,
+                    RUNNING_MODES_HIT_PERIOD_TICKS, runningModes_hitTask);
+  scheduler_addTask("histogram", SCHEDULER_PRIORITY_UI,
+                    RUNNING_MODES_HIT_HISTOGRAM_PERIOD_TICKS,
+                    runningModes_hitHistogramTask);
   interrupts_enableArmInts(); // The ARM will start seeing interrupts after
                               // this.
   lockoutTimer_start(); // Ignore erroneous hits at startup (when all power
                         // values are essentially 0).
-  while ((!(buttons_read() & BUTTONS_BTN3_MASK)) &&
-         hitCount < MAX_HIT_COUNT) { // Run until you detect btn3 pressed.
-    transmitter_setFrequencyNumber(
-        runningModes_getFrequencySetting());    // Read the switches and switch
-                                                // frequency as required.
-    intervalTimer_start(MAIN_CUMULATIVE_TIMER); // Measure run-time when you are
-                                                // doing something.
-    histogramSystemTicks++; // Keep track of ticks so you know when to update
-                            // the histogram.
-    // Run filters, compute power, run hit-detection.
-    detectorInvocationCount++;              // Used for run-time statistics.
-    detector(INTERRUPTS_CURRENTLY_ENABLED); // Interrupts are currently enabled.
-    if (detector_hitDetected()) {           // Hit detected
-      hitCount++;                           // increment the hit count.
-      detector_clearHit();                  // Clear the hit.
-      detector_hitCount_t
-          hitCounts[DETECTOR_HIT_ARRAY_SIZE]; // Store the hit-counts here.
-      detector_getHitCounts(hitCounts);       // Get the current hit counts.
-      histogram_plotUserHits(hitCounts);      // Plot the hit counts on the TFT.
-    }
-    intervalTimer_stop(
-        MAIN_CUMULATIVE_TIMER); // All done with actual processing.
-  }
+#ifdef METRICS_ENABLED
+  metrics_init(interrupts_isrInvocationCount(), runningModes_updateMetrics);
+#endif
+  // Run until you detect btn3 pressed or MAX_HIT_COUNT hits.
+  while (!runningModes_stopRequested)
+    scheduler_runOnce();
   interrupts_disableArmInts(); // Done with loop, disable the interrupts.
   hitLedTimer_turnLedOff();    // Save power :-)
+#ifdef METRICS_ENABLED
+  metrics_flush(); // Print the samples that were still waiting.
+#endif
   runningModes_printRunTimeStatistics(); // Print the run-time statistics to the
                                          // TFT.
-  printf("Shooter mode terminated after detecting %d shots.\n", hitCount);
+  scheduler_printStatistics();           // To the console.
+  printf("Shooter mode terminated after detecting %u shots.\n",
+         runningModes_hitCount);
+#ifdef LATENCY_TRACE_ENABLED
+  latencyTrace_print(); // Over the UART on the board.
+#endif
 }
 
 // This mode simply dumps raw ADC values to the console.
@@ -342,3 +585,82 @@ void runningModes_dumpRawAdcValues() {
     printf("raw ADC value: %d\n", signExtendedValue);
   }
 }
+
+// Records raw ADC samples in the adcCapture.h format until btn3 is pressed or
+// RUNNING_MODES_CAPTURE_MAX_SAMPLE_COUNT samples are captured. Samples come
+// from the ADC buffer, so they are spaced exactly like the samples detector()
+// sees. The trigger is enabled so that shots can be recorded too. The capture
+// is packed into memory while running (the UART is far too slow to keep up)
+// and written out afterwards: to stdout on the board (log the serial port to a
+// file in raw mode) and to RUNNING_MODES_CAPTURE_FILE_NAME on the emulator.
+// Replay the file on the host with lasertag/replay.
+void runningModes_captureAdcValues() {
+  runningModes_initAll();
+  static adcCapture_block_t block;
+  uint32_t maxLength =
+      ADC_CAPTURE_HEADER_LENGTH +
+      (RUNNING_MODES_CAPTURE_MAX_SAMPLE_COUNT / ADC_CAPTURE_BLOCK_MAX_SAMPLES +
+       1) * ADC_CAPTURE_BLOCK_MAX_LENGTH;
+  uint8_t *capture = (uint8_t *)malloc(maxLength);
+  if (capture == NULL) {
+    printf("runningModes_captureAdcValues(): malloc() failed.\n");
+    assert(false);
+  }
+  uint32_t length =
+      adcCapture_encodeHeader(capture, RUNNING_MODES_CAPTURE_SAMPLE_RATE);
+  uint64_t sampleCount = 0;
+  block.firstSampleIndex = 0;
+  block.sampleCount = 0;
+  display_fillScreen(DISPLAY_BLACK);
+  display_setTextSize(RUNNING_MODE_NORMAL_TEXT_SIZE);
+  display_setTextColor(RUNNING_MODE_NORMAL_TEXT_COLOR);
+  display_setCursor(RUNNING_MODE_SCREEN_X_ORIGIN, RUNNING_MODE_SCREEN_Y_ORIGIN);
+  display_println("Capturing ADC samples, press BTN3 to stop.");
+  trigger_enable(); // Shots go out like in shooter mode.
+  interrupts_initAll(true);
+  interrupts_enableTimerGlobalInts();
+  interrupts_startArmPrivateTimer();
+  benchmark_timestamp_t start = benchmark_now();
+  interrupts_enableArmInts(); // isr_function() starts filling the ADC buffer.
+  while (!(buttons_read() & BUTTONS_BTN3_MASK) &&
+         sampleCount < RUNNING_MODES_CAPTURE_MAX_SAMPLE_COUNT) {
+    if (block.sampleCount == 0) // Time-stamp the block when it is started.
+      block.timestampMicroseconds =
+          benchmark_elapsedNanoseconds(start, benchmark_now()) / 1000;
+    uint32_t maxCount = ADC_CAPTURE_BLOCK_MAX_SAMPLES - block.sampleCount;
+    if (maxCount > RUNNING_MODES_CAPTURE_MAX_SAMPLE_COUNT - sampleCount)
+      maxCount = RUNNING_MODES_CAPTURE_MAX_SAMPLE_COUNT - sampleCount;
+    uint32_t count = isr_removeDataFromAdcBufferN(
+        &block.samples[block.sampleCount], maxCount);
+    block.sampleCount += count;
+    sampleCount += count;
+    if (block.sampleCount == ADC_CAPTURE_BLOCK_MAX_SAMPLES) {
+      length += adcCapture_encodeBlock(&capture[length], &block);
+      block.firstSampleIndex = sampleCount;
+      block.sampleCount = 0;
+    }
+  }
+  interrupts_disableArmInts();
+  if (block.sampleCount > 0)
+    length += adcCapture_encodeBlock(&capture[length], &block);
+  char sprintfBuffer[MAX_BUFFER_SIZE]; // Generic message buffer.
+  sprintf(sprintfBuffer, "Captured %lu samples (%lu bytes).",
+          (unsigned long)sampleCount, (unsigned long)length);
+  display_println(sprintfBuffer);
+#ifdef ZYBO_BOARD
+  // Not fwrite(): the BSP's write() puts a '\r' before every 0x0A byte, which
+  // would corrupt the binary capture. outbyte() sends each byte as is.
+  fflush(stdout); // Console text goes out before the capture.
+  for (uint32_t i = 0; i < length; i++)
+    outbyte(capture[i]);
+#else
+  FILE *file = fopen(RUNNING_MODES_CAPTURE_FILE_NAME, "wb");
+  if (file == NULL || fwrite(capture, 1, length, file) != length)
+    display_println("Could not write " RUNNING_MODES_CAPTURE_FILE_NAME ".");
+  else
+    display_println("Wrote " RUNNING_MODES_CAPTURE_FILE_NAME ".");
+  if (file != NULL)
+    fclose(file);
+#endif
+  free(capture);
+}
@@ -68,4 +68,10 @@ void runningModes_creative();
 // Will loop forever. Stop the program with an external reset or Ctl-C.
 void runningModes_dumpRawAdcValues();
 
+// Records raw ADC samples (see adcCapture.h) until btn3 is pressed, then
+// writes them to stdout on the board or to a file on the emulator. Unlike
+// runningModes_dumpRawAdcValues(), the samples come from the ADC buffer at
+// the interrupt rate and can be replayed on the host with lasertag/replay.
+void runningModes_captureAdcValues();
+
 #endif /* RUNNINGMODES_H_ */
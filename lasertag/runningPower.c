@@ -0,0 +1,95 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stddef.h>
+
+#include "runningPower.h"
+
+// Adds term to the power with Kahan summation: compensation keeps the
+// low-order bits that were lost by the previous addition.
+static inline void runningPower_kahanAdd(runningPower_t *p, double term) {
+  double correctedTerm = term - p->compensation;
+  double newPower = p->power + correctedTerm;
+  p->compensation = (newPower - p->power) - correctedTerm;
+  p->power = newPower;
+}
+
+// Initializes a windowed accumulator and computes the power of window.
+void runningPower_initWindowed(runningPower_t *p, queue_t *window,
+                               uint32_t renormalizeInterval) {
+  p->mode = RUNNING_POWER_WINDOWED;
+  p->window = window;
+  p->renormalizeInterval = renormalizeInterval;
+  if (renormalizeInterval && renormalizeInterval < queue_size(window))
+    p->renormalizeInterval = queue_size(window);
+  p->decay = 0.0;
+  runningPower_renormalize(p);
+}
+
+// Initializes an exponentially-decaying accumulator.
+void runningPower_initExponential(runningPower_t *p, double decay) {
+  p->mode = RUNNING_POWER_EXPONENTIAL;
+  p->window = NULL;
+  p->renormalizeInterval = 0;
+  p->samplesSinceRenormalize = 0;
+  p->freshPower = 0.0;
+  p->decay = decay;
+  p->power = 0.0;
+  p->compensation = 0.0;
+}
+
+// Adds a new sample and updates the power in O(1), renormalizing
+// incrementally.
+void runningPower_addSample(runningPower_t *p, double value) {
+  if (p->mode == RUNNING_POWER_EXPONENTIAL) {
+    p->power = p->decay * p->power + value * value;
+    return;
+  }
+  double oldest = 0.0; // Nothing falls out until the window is full.
+  if (queue_full(p->window))
+    oldest = queue_readElementAt(p->window, 0);
+  queue_overwritePush(p->window, value);
+  runningPower_kahanAdd(p, value * value - oldest * oldest);
+  if (!p->renormalizeInterval)
+    return;
+  // The last queue_size() samples before the interval is up are the window
+  // when it is up, so their sum of squares replaces the running sum then.
+  p->samplesSinceRenormalize++;
+  if (p->samplesSinceRenormalize + queue_size(p->window) >
+      p->renormalizeInterval)
+    p->freshPower += value * value;
+  if (p->samplesSinceRenormalize >= p->renormalizeInterval) {
+    if (queue_full(p->window)) { // Else it is not the last queue_size().
+      p->power = p->freshPower;
+      p->compensation = 0.0;
+    }
+    p->samplesSinceRenormalize = 0;
+    p->freshPower = 0.0;
+  }
+}
+
+// Returns the current power.
+double runningPower_getPower(runningPower_t *p) { return p->power; }
+
+// Recomputes the power from the window and clears the compensation.
+void runningPower_renormalize(runningPower_t *p) {
+  p->samplesSinceRenormalize = 0;
+  p->freshPower = 0.0;
+  if (p->mode != RUNNING_POWER_WINDOWED)
+    return;
+  queue_span_t spans[QUEUE_MAX_SPAN_COUNT];
+  uint16_t spanCount =
+      queue_newestSpans(p->window, queue_elementCount(p->window), spans);
+  double power = 0.0;
+  for (uint16_t s = 0; s < spanCount; s++)
+    for (queue_size_t i = 0; i < spans[s].length; i++)
+      power += spans[s].data[i] * spans[s].data[i];
+  p->power = power;
+  p->compensation = 0.0;
+}
@@ -0,0 +1,78 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef RUNNINGPOWER_H_
+#define RUNNINGPOWER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "queue.h"
+
+// Running energy (power) accumulator for one band (IIR filter output).
+// filter_computePower() computes the power of an output queue from scratch
+// (O(window length)) or incrementally by hand. runningPower_t keeps the power
+// current in O(1) per decimated sample, in one of two modes:
+//
+// Windowed: the power is the sum of the squares of the values in a window
+// queue (the IIR output queue). runningPower_addSample() pushes the new value,
+// adds its square and subtracts the square of the value that fell out of the
+// window. The running sum uses Kahan (compensated) summation and is replaced
+// by a fresh sum every renormalizeInterval samples, so rounding errors cannot
+// accumulate no matter how long the detector runs. The fresh sum is built up
+// over the last window-length samples before each renormalization, one square
+// per runningPower_addSample(), since those samples are exactly the window at
+// that point. So every update is O(1) in the worst case, not just on average.
+//
+// Exponential: power = decay * power + value * value. There is no window queue
+// and no subtraction, so there is nothing to drift. A decay of
+// 1 - 1/windowLength weights samples over roughly the same time span as a
+// window of windowLength samples.
+
+typedef enum {
+  RUNNING_POWER_WINDOWED,   // Sum of squares over the window queue.
+  RUNNING_POWER_EXPONENTIAL // Exponentially-decaying sum of squares.
+} runningPower_mode_t;
+
+typedef struct {
+  runningPower_mode_t mode;
+  queue_t *window;              // Windowed mode only, owned by the caller.
+  uint32_t renormalizeInterval; // Windowed mode, 0 never recomputes.
+  uint32_t samplesSinceRenormalize;
+  double freshPower; // Sum of squares of the newest samples, see above.
+  double decay;        // Exponential mode only.
+  double power;        // The running sum.
+  double compensation; // Kahan compensation for power (low-order bits lost).
+} runningPower_t;
+
+// Initializes a windowed accumulator over window, which is usually one of the
+// IIR output queues. The power is computed from the current contents of
+// window. The queue must stay valid for the life of the accumulator and must
+// only be pushed through runningPower_addSample(). A renormalizeInterval
+// shorter than the window length is raised to the window length.
+void runningPower_initWindowed(runningPower_t *p, queue_t *window,
+                               uint32_t renormalizeInterval);
+
+// Initializes an exponentially-decaying accumulator. 0.0 <= decay < 1.0.
+void runningPower_initExponential(runningPower_t *p, double decay);
+
+// Adds a new sample (a new IIR output) and updates the power in O(1). In
+// windowed mode the sample is also pushed onto the window queue with
+// queue_overwritePush().
+void runningPower_addSample(runningPower_t *p, double value);
+
+// Returns the current power.
+double runningPower_getPower(runningPower_t *p);
+
+// Windowed mode: recomputes the power from the window (O(window length)) and
+// clears the compensation. runningPower_addSample() does not call it, it
+// renormalizes incrementally. Exponential mode: does nothing.
+void runningPower_renormalize(runningPower_t *p);
+
+#endif /* RUNNINGPOWER_H_ */
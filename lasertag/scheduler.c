@@ -0,0 +1,300 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+
+#include "profiler.h" // profiler_now()
+#include "scheduler.h"
+
+typedef struct {
+  const char *name;
+  scheduler_priority_t priority;
+  uint32_t periodTicks;
+  scheduler_taskFunction_t function;
+  uint32_t nextTick; // When it is due next.
+  bool deferred;     // Held back since it was last due.
+  uint32_t runCount;
+  uint32_t deferredCount;
+  uint32_t maxLatenessTicks;
+  profiler_time_t maxDuration;
+} scheduler_task_t;
+
+// Indexed by scheduler_priority_t.
+static const char *scheduler_priorityNames[SCHEDULER_PRIORITY_COUNT] = {
+    "DSP", "game", "UI"};
+
+static scheduler_task_t scheduler_tasks[SCHEDULER_MAX_TASK_COUNT];
+static uint16_t scheduler_taskCount;
+static uint32_t scheduler_backlogLimits[SCHEDULER_PRIORITY_COUNT];
+static uint32_t scheduler_maxLatenessTicks[SCHEDULER_PRIORITY_COUNT];
+static scheduler_clockFunction_t scheduler_clock;
+static scheduler_backlogFunction_t scheduler_backlog;
+static uint32_t scheduler_passCount;
+static uint32_t scheduler_maxBacklog;
+
+// Removes all tasks and clears the statistics.
+void scheduler_init(scheduler_clockFunction_t clock,
+                    scheduler_backlogFunction_t backlog) {
+  scheduler_clock = clock;
+  scheduler_backlog = backlog;
+  scheduler_taskCount = 0;
+  for (uint16_t p = 0; p < SCHEDULER_PRIORITY_COUNT; p++) {
+    scheduler_backlogLimits[p] = SCHEDULER_NO_BACKLOG_LIMIT;
+    scheduler_maxLatenessTicks[p] = SCHEDULER_NO_MAX_LATENESS;
+  }
+  scheduler_passCount = 0;
+  scheduler_maxBacklog = 0;
+}
+
+// Holds back the tasks of priority while the backlog is at or above limit.
+void scheduler_setBacklogLimit(scheduler_priority_t priority, uint32_t limit) {
+  scheduler_backlogLimits[priority] = limit;
+}
+
+// Runs a due task of priority regardless of the backlog once it is
+// maxLatenessTicks late.
+void scheduler_setMaxLateness(scheduler_priority_t priority,
+                              uint32_t maxLatenessTicks) {
+  scheduler_maxLatenessTicks[priority] = maxLatenessTicks;
+}
+
+// Adds a task that is due right away.
+scheduler_taskId_t scheduler_addTask(const char *name,
+                                     scheduler_priority_t priority,
+                                     uint32_t periodTicks,
+                                     scheduler_taskFunction_t function) {
+  if (scheduler_taskCount >= SCHEDULER_MAX_TASK_COUNT) {
+    printf("scheduler_addTask(): no room for task %s.\n", name);
+    return -1;
+  }
+  scheduler_task_t *task = &scheduler_tasks[scheduler_taskCount];
+  task->name = name;
+  task->priority = priority;
+  task->periodTicks = periodTicks;
+  task->function = function;
+  task->nextTick = scheduler_clock();
+  task->deferred = false;
+  task->runCount = 0;
+  task->deferredCount = 0;
+  task->maxLatenessTicks = 0;
+  task->maxDuration = 0;
+  return scheduler_taskCount++;
+}
+
+// Runs a task and updates its run count and longest run.
+static void scheduler_runTask(scheduler_task_t *task) {
+  profiler_time_t start = profiler_now();
+  task->function();
+  profiler_time_t duration = profiler_now() - start;
+  if (duration > task->maxDuration)
+    task->maxDuration = duration;
+  task->runCount++;
+}
+
+// Returns true if task is due at now. The comparison is done on the
+// difference so that it keeps working when the clock wraps around.
+static bool scheduler_isDue(scheduler_task_t *task, uint32_t now) {
+  return (int32_t)(now - task->nextTick) >= 0;
+}
+
+// Runs a due game or UI task and schedules its next run. After a long delay it
+// is scheduled a period from now rather than run repeatedly to catch up.
+static void scheduler_runPeriodicTask(scheduler_task_t *task, uint32_t now) {
+  uint32_t lateness = now - task->nextTick;
+  if (lateness > task->maxLatenessTicks)
+    task->maxLatenessTicks = lateness;
+  task->deferred = false;
+  scheduler_runTask(task);
+  task->nextTick += task->periodTicks;
+  if (scheduler_isDue(task, now))
+    task->nextTick = now + task->periodTicks;
+}
+
+// Runs the DSP tasks, then the first due game or UI task whose class is under
+// its backlog limit or that has reached the maximum lateness of its class. Due
+// tasks that are held back count a deferral once until they run.
+void scheduler_runOnce() {
+  scheduler_passCount++;
+  for (uint16_t i = 0; i < scheduler_taskCount; i++)
+    if (scheduler_tasks[i].priority == SCHEDULER_PRIORITY_DSP)
+      scheduler_runTask(&scheduler_tasks[i]);
+  uint32_t backlog = scheduler_backlog();
+  if (backlog > scheduler_maxBacklog)
+    scheduler_maxBacklog = backlog;
+  uint32_t now = scheduler_clock();
+  for (uint16_t p = SCHEDULER_PRIORITY_GAME; p < SCHEDULER_PRIORITY_COUNT;
+       p++) {
+    for (uint16_t i = 0; i < scheduler_taskCount; i++) {
+      scheduler_task_t *task = &scheduler_tasks[i];
+      if (task->priority != p || !scheduler_isDue(task, now))
+        continue;
+      if (backlog < scheduler_backlogLimits[p] ||
+          now - task->nextTick >= scheduler_maxLatenessTicks[p]) {
+        scheduler_runPeriodicTask(task, now);
+        return; // One task per pass, then back to the detector.
+      }
+      if (!task->deferred) {
+        task->deferred = true;
+        task->deferredCount++;
+      }
+    }
+  }
+}
+
+// Returns the number of passes.
+uint32_t scheduler_getPassCount() { return scheduler_passCount; }
+
+// Returns how many times a task ran.
+uint32_t scheduler_getRunCount(scheduler_taskId_t task) {
+  return scheduler_tasks[task].runCount;
+}
+
+// Returns how many times a task was due but held back by the backlog.
+uint32_t scheduler_getDeferredCount(scheduler_taskId_t task) {
+  return scheduler_tasks[task].deferredCount;
+}
+
+// Returns the most ticks a task ran after it was due.
+uint32_t scheduler_getMaxLatenessTicks(scheduler_taskId_t task) {
+  return scheduler_tasks[task].maxLatenessTicks;
+}
+
+// Prints a line per task with its statistics and the largest backlog seen.
+void scheduler_printStatistics() {
+  printf("Scheduler: %u passes, largest backlog %u.\n", scheduler_passCount,
+         scheduler_maxBacklog);
+  printf("%-10s %-5s %9s %8s %10s %10s\n", "Task", "class", "runs", "deferred",
+         "late ticks", "max " PROFILER_UNIT_NAME);
+  for (uint16_t i = 0; i < scheduler_taskCount; i++) {
+    scheduler_task_t *task = &scheduler_tasks[i];
+    printf("%-10s %-5s %9u %8u %10u %10u\n", task->name,
+           scheduler_priorityNames[task->priority], task->runCount,
+           task->deferredCount, task->maxLatenessTicks, task->maxDuration);
+  }
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define SCHEDULER_TEST_TICKS_PER_PASS 10 // The detector task takes 10 ticks.
+#define SCHEDULER_TEST_GAME_PERIOD 100
+#define SCHEDULER_TEST_UI_PERIOD 300
+#define SCHEDULER_TEST_UI_LIMIT 500
+#define SCHEDULER_TEST_GAME_LIMIT 1000
+#define SCHEDULER_TEST_GAME_MAX_LATENESS 500
+#define SCHEDULER_TEST_PASS_COUNT 300 // 3000 ticks.
+
+static uint32_t scheduler_testClock;
+static uint32_t scheduler_testBacklog;
+static bool scheduler_testLastWasDsp; // Last task run was the DSP task.
+static bool scheduler_testDspStarved; // Two other tasks ran back to back.
+
+static uint32_t scheduler_testGetClock() { return scheduler_testClock; }
+
+static uint32_t scheduler_testGetBacklog() { return scheduler_testBacklog; }
+
+static void scheduler_testDspTask() {
+  scheduler_testClock += SCHEDULER_TEST_TICKS_PER_PASS;
+  scheduler_testLastWasDsp = true;
+}
+
+static void scheduler_testOtherTask() {
+  if (!scheduler_testLastWasDsp)
+    scheduler_testDspStarved = true;
+  scheduler_testLastWasDsp = false;
+}
+
+// Runs SCHEDULER_TEST_PASS_COUNT passes at the given backlog.
+static void scheduler_testRun(uint32_t backlog) {
+  scheduler_testBacklog = backlog;
+  for (uint32_t pass = 0; pass < SCHEDULER_TEST_PASS_COUNT; pass++)
+    scheduler_runOnce();
+}
+
+// Returns true if value is within 1 of expected and prints an error otherwise.
+static bool scheduler_testCount(const char *what, uint32_t value,
+                                uint32_t expected) {
+  if (value + 1 >= expected && value <= expected + 1)
+    return true;
+  printf("* Error: %s is %u, should be %u.\n", what, value, expected);
+  return false;
+}
+
+// Runs a DSP, a game and a UI task for 3000 ticks without backlog, then with
+// a backlog between the UI and game limits, then above both. Checks that the
+// game and UI tasks run at their periods and are held back by the right
+// limits, and that the DSP task runs on every pass and between any two other
+// tasks. Last, checks that a game task held back by a backlog that does not
+// drain still runs once it reaches the maximum lateness of its class.
+bool scheduler_runTest() {
+  scheduler_testClock = UINT32_MAX - 1000; // Wraps around during the test.
+  scheduler_testLastWasDsp = true;
+  scheduler_testDspStarved = false;
+  scheduler_init(scheduler_testGetClock, scheduler_testGetBacklog);
+  scheduler_setBacklogLimit(SCHEDULER_PRIORITY_GAME, SCHEDULER_TEST_GAME_LIMIT);
+  scheduler_setBacklogLimit(SCHEDULER_PRIORITY_UI, SCHEDULER_TEST_UI_LIMIT);
+  scheduler_taskId_t dsp = scheduler_addTask("dsp", SCHEDULER_PRIORITY_DSP, 0,
+                                             scheduler_testDspTask);
+  scheduler_taskId_t game =
+      scheduler_addTask("game", SCHEDULER_PRIORITY_GAME,
+                        SCHEDULER_TEST_GAME_PERIOD, scheduler_testOtherTask);
+  scheduler_taskId_t ui =
+      scheduler_addTask("ui", SCHEDULER_PRIORITY_UI, SCHEDULER_TEST_UI_PERIOD,
+                        scheduler_testOtherTask);
+  uint32_t runTicks = SCHEDULER_TEST_PASS_COUNT * SCHEDULER_TEST_TICKS_PER_PASS;
+  uint32_t gameRuns = runTicks / SCHEDULER_TEST_GAME_PERIOD;
+  uint32_t uiRuns = runTicks / SCHEDULER_TEST_UI_PERIOD;
+  bool success = true;
+  scheduler_testRun(0);
+  success &= scheduler_testCount("game runs", scheduler_getRunCount(game),
+                                 gameRuns);
+  success &= scheduler_testCount("UI runs", scheduler_getRunCount(ui), uiRuns);
+  // The UI task is held back, the game task is not.
+  scheduler_testRun(SCHEDULER_TEST_UI_LIMIT);
+  success &= scheduler_testCount("game runs with backlog",
+                                 scheduler_getRunCount(game), 2 * gameRuns);
+  success &= scheduler_testCount("UI runs with backlog",
+                                 scheduler_getRunCount(ui), uiRuns);
+  success &= scheduler_testCount("UI deferrals with backlog",
+                                 scheduler_getDeferredCount(ui), 1);
+  // Both are held back.
+  scheduler_testRun(SCHEDULER_TEST_GAME_LIMIT);
+  success &= scheduler_testCount("game runs with large backlog",
+                                 scheduler_getRunCount(game), 2 * gameRuns);
+  success &= scheduler_testCount("game deferrals with large backlog",
+                                 scheduler_getDeferredCount(game), 1);
+  // Without backlog, both run right away, but only once each.
+  scheduler_testRun(0);
+  success &= scheduler_testCount("UI runs after backlog",
+                                 scheduler_getRunCount(ui), 2 * uiRuns + 1);
+  if (scheduler_getMaxLatenessTicks(ui) < runTicks) {
+    printf("* Error: UI lateness is %u ticks, should be at least %u.\n",
+           scheduler_getMaxLatenessTicks(ui), runTicks);
+    success = false;
+  }
+  // Held back until it is the maximum lateness late, then the next period
+  // starts: one run per lateness plus period.
+  scheduler_setMaxLateness(SCHEDULER_PRIORITY_GAME,
+                           SCHEDULER_TEST_GAME_MAX_LATENESS);
+  uint32_t gameRunsBefore = scheduler_getRunCount(game);
+  scheduler_testRun(SCHEDULER_TEST_GAME_LIMIT);
+  success &= scheduler_testCount(
+      "game runs past the maximum lateness",
+      scheduler_getRunCount(game) - gameRunsBefore,
+      runTicks /
+          (SCHEDULER_TEST_GAME_MAX_LATENESS + SCHEDULER_TEST_GAME_PERIOD));
+  if (scheduler_getRunCount(dsp) != scheduler_getPassCount() ||
+      scheduler_testDspStarved) {
+    printf("* Error: the DSP task did not run on every pass.\n");
+    success = false;
+  }
+  printf("=== Scheduler test %s.\n", success ? "passed" : "failed");
+  return success;
+}
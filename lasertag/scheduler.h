@@ -0,0 +1,105 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A small cooperative scheduler for the main loop of the running modes. Tasks
+// are functions that run to completion and belong to one of three priority
+// classes:
+// - DSP tasks (the detector) run on every pass.
+// - Game tasks (hits, buttons) and UI tasks (switches, TFT redraws) run when
+//   their period has elapsed, but only while the ADC buffer holds fewer values
+//   than the backlog limit of their class. UI tasks get a lower limit, so the
+//   TFT is the first thing to wait when the detector falls behind.
+//
+// Each pass runs the DSP tasks, then at most one game or UI task: the first
+// due one, game tasks first, in the order they were added. So the detector
+// runs at least once between any two other tasks, and while the ADC buffer is
+// over a limit it gets every pass to itself until the backlog drains. Non-DSP
+// tasks need a period, or the first one would run on every pass and starve
+// the others. A class can also get a maximum lateness: a task of the class
+// that has been held back that long runs anyway, so a backlog that does not
+// drain cannot lock out, e.g., the button that stops the running mode.
+//
+// Times are ticks of the clock function (the ISR invocation count in the
+// running modes, i.e., 10 us). Statistics are kept for every task: runs,
+// deferrals (times it was due but held back by the backlog), the largest
+// lateness and the longest run in profiler_now() units.
+
+#define SCHEDULER_MAX_TASK_COUNT 8
+#define SCHEDULER_NO_BACKLOG_LIMIT UINT32_MAX // Never held back.
+#define SCHEDULER_NO_MAX_LATENESS UINT32_MAX  // Held back without a bound.
+
+typedef enum {
+  SCHEDULER_PRIORITY_DSP,  // Every pass.
+  SCHEDULER_PRIORITY_GAME, // Held back over the game backlog limit.
+  SCHEDULER_PRIORITY_UI,   // Held back over the UI backlog limit.
+  SCHEDULER_PRIORITY_COUNT
+} scheduler_priority_t;
+
+typedef int16_t scheduler_taskId_t; // -1 if a task could not be added.
+
+typedef void (*scheduler_taskFunction_t)();
+typedef uint32_t (*scheduler_clockFunction_t)();   // Returns the time in ticks.
+typedef uint32_t (*scheduler_backlogFunction_t)(); // Values in the ADC buffer.
+
+// Removes all tasks and clears the statistics. Both limits start out as
+// SCHEDULER_NO_BACKLOG_LIMIT and both maximum latenesses as
+// SCHEDULER_NO_MAX_LATENESS.
+void scheduler_init(scheduler_clockFunction_t clock,
+                    scheduler_backlogFunction_t backlog);
+
+// Holds back the tasks of priority (game or UI) while the backlog is at or
+// above limit.
+void scheduler_setBacklogLimit(scheduler_priority_t priority, uint32_t limit);
+
+// Runs a due task of priority (game or UI) regardless of the backlog once it
+// is maxLatenessTicks late. It still waits for its turn: one game or UI task
+// per pass, after the DSP tasks.
+void scheduler_setMaxLateness(scheduler_priority_t priority,
+                              uint32_t maxLatenessTicks);
+
+// Adds a task that is due right away and then every periodTicks (ignored for
+// DSP tasks). Returns its id, or -1 if SCHEDULER_MAX_TASK_COUNT tasks were
+// already added.
+scheduler_taskId_t scheduler_addTask(const char *name,
+                                     scheduler_priority_t priority,
+                                     uint32_t periodTicks,
+                                     scheduler_taskFunction_t function);
+
+// Runs one pass: the DSP tasks, then at most one due game or UI task whose
+// class is under its backlog limit or that has reached the maximum lateness of
+// its class.
+void scheduler_runOnce();
+
+// Returns the number of passes.
+uint32_t scheduler_getPassCount();
+
+// Returns how many times a task ran.
+uint32_t scheduler_getRunCount(scheduler_taskId_t task);
+
+// Returns how many times a task was due but held back by the backlog.
+uint32_t scheduler_getDeferredCount(scheduler_taskId_t task);
+
+// Returns the most ticks a task ran after it was due.
+uint32_t scheduler_getMaxLatenessTicks(scheduler_taskId_t task);
+
+// Prints a line per task with its statistics and the largest backlog seen.
+void scheduler_printStatistics();
+
+// Runs DSP, game and UI tasks against a synthetic clock and backlog, and
+// checks periods, priorities, deferrals, the maximum lateness and the detector
+// guarantee. Returns true if the test passes.
+bool scheduler_runTest();
+
+#endif /* SCHEDULER_H_ */
@@ -10,7 +10,11 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdio.h>
 
 #include "interrupts.h" // Just for sound_runTest().
+#include "latencyTrace.h"
 #include "sound.h"
+#include "soundBank.h"
+#include "soundMixer.h"
+#include "soundPriorities.h"
 #include "sounds/bcfire01_48k.wav.h"
 #include "sounds/gameBoyStartup.wav.h"
 #include "sounds/gameOver48k.wav.h"
@@ -19,6 +23,7 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include "sounds/pacmanDeath.wav.h"
 #include "sounds/powerUp48k.wav.h"
 #include "sounds/screamAndDie48k.wav.h"
+#include "tickDispatcher.h"
 #include "timer_ps.h"
 #include "xiicps.h"
 #include "xil_printf.h"
@@ -52,10 +57,15 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 
 #define SOUND_MULTIPLIER INT16_MAX / 3 // Primitive volume control.
 
-#define NO_SOUND 0 // A zero generates no sound.
+#define SOUND_SAMPLE_RATE                                                      \
+  SOUND_RESAMPLER_OUTPUT_RATE // Hz, set up by AudioInitialize().
 #define ONE_SECOND_OF_SOUND_ARRAY_SIZE                                         \
-  48000 // The sample rate is 48k so that is 1 second's worth.
-uint16_t soundOfSilence[ONE_SECOND_OF_SOUND_ARRAY_SIZE];
+  SOUND_SAMPLE_RATE // The sample rate is 48k so that is 1 second's worth.
+
+#define SOUND_TICK_RATE 100000 // Hz, the rate of isr_function().
+// Once the FIFO is full, sound_tick() sleeps until half of it has drained, so
+// it never runs dry between calls.
+#define SOUND_REARM_DRAIN_DIVISOR 2
 
 // Declared below the sound state-machine code.
 static int AudioInitialize(u16 timerID, u16 iicID, u32 i2sAddr);
@@ -67,16 +77,34 @@ static int AudioInitialize(u16 timerID, u16 iicID, u32 i2sAddr);
 volatile static bool sound_initFlag = false;
 
 // True if a sound should be played, false otherwise.
-// Note that the state-machine sets this back to false once it has completed
-// playing a sound.
+// Note that the state-machine sets this back to false once all voices of the
+// mixer have completed playing.
 volatile static bool sound_playSoundFlag = false;
 
-// Keep track of the base pointer to the sound array with current sample-rate
-// and sample count.
-volatile static uint16_t *sound_array; // Base pointer to the sound array.
+// Keep track of the current sound with its sample-rate and sample count.
+// sound_startSound() plays it on a mixer voice. The compiled-in sounds are
+// IMA-ADPCM clips (written by wav2c -a at 48 kHz), const and in a read-only
+// section (see sounds/CMakeLists.txt); the mixer decodes them as they play.
+// Sounds from the bank are 16-bit arrays. If both are NULL, it plays silence.
+static const imaAdpcm_clip_t *sound_clip; // Compiled-in sound, or NULL.
+static const uint16_t *sound_array;       // Base pointer to a bank sound.
 
-// static uint32_t sound_sampleRate;  // Sample rate for this sound.
+static uint32_t sound_sampleRate;           // Sample rate of a bank sound.
 volatile static uint32_t sound_sampleCount; // Number of samples in this sound.
+volatile static sound_sounds_t sound_currentSound; // Set by sound_setSound().
+
+// Bank that sound_setSound() looks sounds up in first, or NULL.
+static const soundBank_t *sound_bank;
+
+// Block of mixed samples being sent to the FIFO.
+static uint16_t sound_block[SOUND_MIXER_BLOCK_SIZE];
+static uint32_t sound_blockIndex; // Next sample of sound_block to send.
+
+// Samples queued since the TX FIFO was last reset, until it first fills up.
+static uint32_t sound_fillCount;
+// Samples the TX FIFO holds when full: sound_fillCount when it first filled
+// up. 0 until then.
+static uint32_t sound_fifoDepth;
 
 // Keep track of the current volume setting.
 volatile static sound_volume_t sound_currentVolume = sound_minimumVolume_e;
@@ -90,6 +118,9 @@ typedef enum {
 
 volatile static sound_st_t currentState = sound_init_st;
 
+// Id of sound_tick() with the tick dispatcher.
+static tickDispatcher_id_t sound_tickId = -1;
+
 // Reset the TX FIFO.
 static void sound_resetTxFifo() {
   Xil_Out32(AUDIO_CTRL_BASEADDR + I2S_RESET_REG, 0b010); // Reset TX Fifo
@@ -119,10 +150,10 @@ sound_status_t sound_init() {
   // Setup the audio CODEC.
   AudioInitialize(SCU_TIMER_ID, AUDIO_IIC_ID, AUDIO_CTRL_BASEADDR);
   sound_initFlag = true;
-  // Initialize the silence array.
-  for (uint32_t i = 0; i < ONE_SECOND_OF_SOUND_ARRAY_SIZE; i++)
-    soundOfSilence[i] = NO_SOUND;
   sound_setVolume(sound_minimumVolume_e); // Init the volume level.
+  soundMixer_init();
+  sound_tickId = tickDispatcher_register("sound", sound_tick);
+  tickDispatcher_arm(sound_tickId, 1); // Leaves the init state.
   return SOUND_STATUS_OK;
 }
 
@@ -158,7 +189,8 @@ static void debugStatePrint() {
 // Standard tick function.
 void sound_tick() {
   //  debugStatePrint();
-  static uint32_t arrayIndex = 0;
+  bool mixed = false;   // Mix at most one block per tick.
+  bool fifoFull = true; // False if the loop below left room in the FIFO.
   // Action switch statement.
   switch (currentState) {
   case sound_init_st:
@@ -180,36 +212,59 @@ void sound_tick() {
     break;
   case sound_wait_st:
     if (sound_playSoundFlag) {
-      arrayIndex = 0;
+      sound_blockIndex = SOUND_MIXER_BLOCK_SIZE; // No block mixed yet.
+      sound_fillCount = 0;
       currentState = sound_play_st;
       sound_resetTxFifo();  // Reset the TX FIFO.
       sound_enableTxFifo(); // Enable the TX FIFO, disable mute.
+      LATENCY_TRACE_REACTION(LATENCY_TRACE_REACTION_SOUND);
     }
     break;
   case sound_play_st:
     // Each time you enter this state, add as many samples as will fit in the
     // FIFO.
-    if (sound_array == NULL) {
-      printf("ERROR, sound_tick: sound array has not been set.\n");
-      return;
-    }
     // This while-loop continues to load sound-data into the FIFOs until it is
-    // full or the sound data are exhausted.
+    // full, the mixer has no voice left, or the next block would have to be
+    // mixed in the same tick.
     while (!(Xil_In32(AUDIO_CTRL_BASEADDR + I2S_FIFO_STS_REG) &
              0b0010)) { // while room in FIFO.
-      uint32_t sampleValue =
-          sound_array[arrayIndex] * sound_currentVolume; // Scale by volume.
+      if (sound_blockIndex == SOUND_MIXER_BLOCK_SIZE) { // Block sent?
+        if (soundMixer_getActiveCount() == 0) {         // All done?
+          sound_playSoundFlag = false;                  // Yes.
+          sound_disableTxFifo();        // Disable the TX FIFO.
+          currentState = sound_wait_st; // Go back to the wait state.
+          break;
+        }
+        if (mixed) { // Finish filling the FIFO next tick.
+          fifoFull = false;
+          break;
+        }
+        soundMixer_mix(sound_block, SOUND_MIXER_BLOCK_SIZE);
+        sound_blockIndex = 0;
+        mixed = true;
+      }
+      uint32_t sampleValue = sound_block[sound_blockIndex++] *
+                             sound_currentVolume; // Scale by volume.
       sound_sendDataToBothChannels(
           sampleValue); // Send the sound data to the left and right channels.
-      arrayIndex++;     // Go to next sample.
-      if (arrayIndex == sound_sampleCount) { // All done?
-        sound_playSoundFlag = false;         // Yes.
-        sound_disableTxFifo();               // Disable the TX FIFO.
-        currentState = sound_wait_st;        // Go back to the wait state.
-      }
+      if (sound_fifoDepth == 0)
+        sound_fillCount++;
     }
     break;
   }
+  // Only sound_startSound() wakes up the wait state. In the play state, come
+  // back next tick while the FIFO still has room. Once it is full, come back
+  // when half of it has played (about 2 ticks per sample at 48 kHz).
+  if (currentState != sound_wait_st) {
+    uint32_t delayTicks = 1;
+    if (currentState == sound_play_st && fifoFull) {
+      if (sound_fifoDepth == 0)
+        sound_fifoDepth = sound_fillCount;
+      delayTicks = (sound_fifoDepth * SOUND_TICK_RATE) /
+                   (SOUND_SAMPLE_RATE * SOUND_REARM_DRAIN_DIVISOR);
+    }
+    tickDispatcher_arm(sound_tickId, delayTicks ? delayTicks : 1);
+  }
 }
 
 // Sets the sound and starts playing it immediately.
@@ -218,7 +273,7 @@ void sound_playSound(sound_sounds_t sound) {
   sound_startSound();    // Start playing the sound.
 }
 
-// Returns true if the sound is still playing.
+// Returns true if any sound is still playing.
 bool sound_isBusy() {
   return (sound_playSoundFlag); // Busy if NOT in the wait state.
 }
@@ -227,50 +282,59 @@ bool sound_isBusy() {
 bool sound_isSoundComplete() { return (!sound_isBusy()); }
 
 // Use this to set the base address for the array containing sound data.
-// Allow sounds to be interrupted.
+// Sounds that are playing keep playing.
 void sound_setSound(sound_sounds_t sound) {
-  if (sound_isBusy()) { // You are currently playing some sound.
-    sound_stopSound(); // Stop the sound and reset the state-machine, FIFO, etc.
+  sound_currentSound = sound;
+  sound_clip = NULL;
+  sound_array = NULL;
+  sound_sampleCount = 0; // So you can detect it never being set.
+  sound_sampleRate = SOUND_SAMPLE_RATE;
+  soundBank_clip_t clip;
+  if (sound_bank != NULL && soundBank_getClip(sound_bank, sound, &clip)) {
+    sound_array = clip.samples;
+    sound_sampleCount = clip.sampleCount;
+    sound_sampleRate = clip.sampleRate; // Resampled by the mixer.
+    return;
   }
-  sound_array =
-      NULL; // Set the pointer to NULL so you can detect it never being set.
   switch (sound) {
+#ifndef SOUND_BANK_ONLY
   case sound_gameStart_e:
-    sound_array = gameBoyStartup_wav; // Set the array holding the data.
+    sound_clip = &gameBoyStartup_wav_clip; // Set the clip holding the data.
     sound_sampleCount =
-        GAMEBOYSTARTUP_WAV_NUMBER_OF_SAMPLES; // Size of the array.
+        GAMEBOYSTARTUP_WAV_NUMBER_OF_SAMPLES; // Size of the clip.
     break;
   case sound_gunFire_e:
-    sound_array = bcfire01_48k_wav; // Set the array holding the data.
+    sound_clip = &bcfire01_48k_wav_clip; // Set the clip holding the data.
     sound_sampleCount =
-        BCFIRE01_48K_WAV_NUMBER_OF_SAMPLES; // Size of the array.
+        BCFIRE01_48K_WAV_NUMBER_OF_SAMPLES; // Size of the clip.
     break;
   case sound_hit_e:
-    sound_array = ouch48k_wav; // You get the idea...
+    sound_clip = &ouch48k_wav_clip; // You get the idea...
     sound_sampleCount = OUCH48K_WAV_NUMBER_OF_SAMPLES;
     break;
   case sound_gunClick_e:
-    sound_array = gunEmpty48k_wav;
+    sound_clip = &gunEmpty48k_wav_clip;
     sound_sampleCount = GUNEMPTY48K_WAV_NUMBER_OF_SAMPLES;
     break;
   case sound_gunReload_e:
-    sound_array = powerUp48k_wav;
+    sound_clip = &powerUp48k_wav_clip;
     sound_sampleCount = POWERUP48K_WAV_NUMBER_OF_SAMPLES;
     break;
   case sound_loseLife_e:
-    sound_array = screamAndDie48k_wav;
+    sound_clip = &screamAndDie48k_wav_clip;
     sound_sampleCount = SCREAMANDDIE48K_WAV_NUMBER_OF_SAMPLES;
     break;
   case sound_gameOver_e:
-    sound_array = pacmanDeath_wav;
+    sound_clip = &pacmanDeath_wav_clip;
     sound_sampleCount = PACMANDEATH_WAV_NUMBER_OF_SAMPLES;
     break;
   case sound_returnToBase_e:
-    sound_array = gameOver48k_wav;
+    sound_clip = &gameOver48k_wav_clip;
     sound_sampleCount = GAMEOVER48K_WAV_NUMBER_OF_SAMPLES;
     break;
+#endif
   case sound_oneSecondSilence_e:
-    sound_array = soundOfSilence;
+    sound_array = NULL; // A voice without samples is silent.
     sound_sampleCount = ONE_SECOND_OF_SOUND_ARRAY_SIZE;
     break;
   default:
@@ -278,14 +342,35 @@ void sound_setSound(sound_sounds_t sound) {
   }
 }
 
+// Sets the bank that sound_setSound() looks sounds up in first.
+void sound_setBank(const soundBank_t *bank) { sound_bank = bank; }
+
 // Used to set the volume. Use one of the provided values.
 void sound_setVolume(sound_volume_t volume) { sound_currentVolume = volume; }
 
-// Tell the state machine to start playing the sound.
-void sound_startSound() { sound_playSoundFlag = true; }
+// Tell the state machine to start playing the sound, mixed with the sounds
+// that are already playing.
+void sound_startSound() {
+  if (sound_sampleCount == 0) {
+    printf("ERROR, sound_startSound: sound array has not been set.\n");
+    return;
+  }
+  // Start the voice first, so the state machine cannot see the flag and find
+  // no voice playing.
+  if (sound_clip != NULL)
+    soundMixer_playAdpcm(sound_clip, SOUND_MIXER_UNITY_GAIN,
+                         soundPriorities_table[sound_currentSound]);
+  else
+    soundMixer_playAtRate(sound_array, sound_sampleCount, sound_sampleRate,
+                          SOUND_MIXER_UNITY_GAIN,
+                          soundPriorities_table[sound_currentSound]);
+  sound_playSoundFlag = true;
+  tickDispatcher_arm(sound_tickId, 1);
+}
 
-// Stops playing the sound and resets the state-machine to the wait state.
+// Stops playing all sounds and resets the state-machine to the wait state.
 void sound_stopSound() {
+  soundMixer_stopAll();
   sound_playSoundFlag = false; // disable the state-machine.
   currentState =
       sound_wait_st; // Force the state-machine back to the wait state.
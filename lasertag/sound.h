@@ -13,6 +13,12 @@ For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "soundBank.h"
+
+// Define this to leave the compiled-in sound clips out of the ELF: the sounds
+// then only come from the bank set with sound_setBank().
+//#define SOUND_BANK_ONLY
+
 typedef uint32_t sound_status_t;
 #define SOUND_STATUS_OK 0
 #define SOUND_STATUS_FAIL 1
@@ -48,29 +54,42 @@ typedef enum {
 // Must be called before using the sound state machine.
 sound_status_t sound_init();
 
-// Standard tick function.
+// Standard tick function. It also arms itself with the tick dispatcher (see
+// tickDispatcher.h) while it is playing, so it can be called from
+// tickDispatcher_tick() or on every tick.
 void sound_tick();
 
 // Sets the sound and starts playing it immediately.
 void sound_playSound(sound_sounds_t sound);
 
-// Returns true if the sound is still playing.
+// Returns true if any sound is still playing.
 bool sound_isBusy();
 
 // Returns true if the sound has finished playing.
 bool sound_isSoundComplete();
 
 // Use this to set the base address for the array containing sound data.
-// Allow sounds to be interrupted.
+// The sound is looked up by its sound_sounds_t value as the clip id in the
+// bank set with sound_setBank(), if any, then in the compiled-in IMA-ADPCM
+// clips.
+// Sounds that are playing keep playing.
 void sound_setSound(sound_sounds_t sound);
 
+// Sets the bank that sound_setSound() looks sounds up in first, e.g., one
+// loaded with soundBank_loadFromSd() (see soundBank.h); NULL for none. The
+// bank must stay loaded while its sounds play. Clips at rates other than 48
+// kHz are resampled as they play (see soundResampler.h).
+void sound_setBank(const soundBank_t *bank);
+
 // Used to set the volume. Use one of the provided values.
 void sound_setVolume(sound_volume_t);
 
-// Tell the state machine to start playing the sound.
+// Tell the state machine to start playing the sound. Up to
+// SOUND_MIXER_VOICE_COUNT sounds play at once (see soundMixer.h); beyond that,
+// the sound replaces the least important one if it is at least as important.
 void sound_startSound();
 
-// Stops playing the sound and resets the state-machine to the wait state.
+// Stops playing all sounds and resets the state-machine to the wait state.
 void sound_stopSound();
 
 // Plays several sounds.
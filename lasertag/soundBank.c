@@ -0,0 +1,278 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "soundBank.h"
+
+#ifdef ZYBO_BOARD
+#include "xparameters.h"
+#include "xsdps.h"
+#include "xstatus.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define SOUND_BANK_SIZE_FIELD 2  // uint32 index of the image size.
+#define SOUND_BANK_COUNT_FIELD 3 // uint32 index of the clip count.
+#define SOUND_BANK_ALIGNMENT 4
+
+// Rounds a size up to SOUND_BANK_ALIGNMENT.
+static uint32_t soundBank_align(uint32_t size) {
+  return (size + SOUND_BANK_ALIGNMENT - 1) & ~(SOUND_BANK_ALIGNMENT - 1);
+}
+
+// Returns the offset of the payload for clipCount clips.
+static uint32_t soundBank_getPayloadOffset(uint32_t clipCount) {
+  return SOUND_BANK_HEADER_LENGTH + clipCount * sizeof(soundBank_entry_t);
+}
+
+// Checks the image and sets up bank to use it in place.
+bool soundBank_open(soundBank_t *bank, const void *image, uint32_t size) {
+  const uint32_t *header = image;
+  if (size < SOUND_BANK_HEADER_LENGTH ||
+      memcmp(image, SOUND_BANK_MAGIC, SOUND_BANK_MAGIC_LENGTH)) {
+    printf("soundBank_open(): not a sound bank.\n");
+    return false;
+  }
+  uint32_t clipCount = header[SOUND_BANK_COUNT_FIELD];
+  if (header[SOUND_BANK_SIZE_FIELD] != size ||
+      clipCount > (size - SOUND_BANK_HEADER_LENGTH) /
+                      sizeof(soundBank_entry_t)) {
+    printf("soundBank_open(): the bank is %u bytes, its header says %u bytes "
+           "with %u clips.\n",
+           size, header[SOUND_BANK_SIZE_FIELD], clipCount);
+    return false;
+  }
+  const soundBank_entry_t *directory =
+      (const soundBank_entry_t *)((const uint8_t *)image +
+                                  SOUND_BANK_HEADER_LENGTH);
+  for (uint32_t i = 0; i < clipCount; i++) {
+    const soundBank_entry_t *entry = &directory[i];
+    if (entry->offset % SOUND_BANK_ALIGNMENT ||
+        entry->offset < soundBank_getPayloadOffset(clipCount) ||
+        entry->offset > size ||
+        entry->sampleCount > (size - entry->offset) / sizeof(uint16_t)) {
+      printf("soundBank_open(): clip %u is outside the bank.\n", entry->id);
+      return false;
+    }
+  }
+  bank->image = image;
+  bank->size = size;
+  bank->clipCount = clipCount;
+  bank->directory = directory;
+  bank->allocation = NULL;
+  bank->mapped = false;
+  return true;
+}
+
+// Looks up a clip by id in the directory.
+bool soundBank_getClip(const soundBank_t *bank, uint32_t id,
+                       soundBank_clip_t *clip) {
+  for (uint32_t i = 0; i < bank->clipCount; i++) {
+    const soundBank_entry_t *entry = &bank->directory[i];
+    if (entry->id == id) {
+      clip->id = id;
+      clip->sampleRate = entry->sampleRate;
+      clip->samples = (const uint16_t *)(bank->image + entry->offset);
+      clip->sampleCount = entry->sampleCount;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the size of the image for clipCount clips.
+uint32_t soundBank_getImageSize(const soundBank_clip_t clips[],
+                                uint32_t clipCount) {
+  uint32_t size = soundBank_getPayloadOffset(clipCount);
+  for (uint32_t i = 0; i < clipCount; i++)
+    size += soundBank_align(clips[i].sampleCount * sizeof(uint16_t));
+  return size;
+}
+
+// Writes the header, the directory and the payload.
+void soundBank_build(void *image, const soundBank_clip_t clips[],
+                     uint32_t clipCount) {
+  uint32_t size = soundBank_getImageSize(clips, clipCount);
+  memset(image, 0, size); // Also the padding.
+  uint32_t *header = image;
+  memcpy(image, SOUND_BANK_MAGIC, SOUND_BANK_MAGIC_LENGTH);
+  header[SOUND_BANK_SIZE_FIELD] = size;
+  header[SOUND_BANK_COUNT_FIELD] = clipCount;
+  soundBank_entry_t *directory =
+      (soundBank_entry_t *)((uint8_t *)image + SOUND_BANK_HEADER_LENGTH);
+  uint32_t offset = soundBank_getPayloadOffset(clipCount);
+  for (uint32_t i = 0; i < clipCount; i++) {
+    directory[i].id = clips[i].id;
+    directory[i].sampleRate = clips[i].sampleRate;
+    directory[i].sampleCount = clips[i].sampleCount;
+    directory[i].offset = offset;
+    memcpy((uint8_t *)image + offset, clips[i].samples,
+           clips[i].sampleCount * sizeof(uint16_t));
+    offset += soundBank_align(clips[i].sampleCount * sizeof(uint16_t));
+  }
+}
+
+#ifdef ZYBO_BOARD
+static XSdPs soundBank_sd;
+
+// Initializes the SD controller and the card.
+static bool soundBank_initSd() {
+  XSdPs_Config *config = XSdPs_LookupConfig(XPAR_XSDPS_0_DEVICE_ID);
+  return config != NULL &&
+         XSdPs_CfgInitialize(&soundBank_sd, config, config->BaseAddress) ==
+             XST_SUCCESS &&
+         XSdPs_CardInitialize(&soundBank_sd) == XST_SUCCESS;
+}
+
+// Reads blockCount blocks from sector on. Standard-capacity cards are
+// addressed in bytes, high-capacity cards in blocks.
+static bool soundBank_readSd(uint32_t sector, uint32_t blockCount,
+                             uint8_t *buffer) {
+  uint32_t address =
+      soundBank_sd.HCS ? sector : sector * SOUND_BANK_SD_BLOCK_SIZE;
+  return XSdPs_ReadPolled(&soundBank_sd, address, blockCount, buffer) ==
+         XST_SUCCESS;
+}
+
+// Reads the first block for the size, then the whole bank.
+bool soundBank_loadFromSd(soundBank_t *bank, uint32_t firstSector) {
+  static uint8_t block[SOUND_BANK_SD_BLOCK_SIZE]
+      __attribute__((aligned(SOUND_BANK_ALIGNMENT)));
+  if (!soundBank_initSd() || !soundBank_readSd(firstSector, 1, block)) {
+    printf("soundBank_loadFromSd(): cannot read the SD card.\n");
+    return false;
+  }
+  uint32_t size = ((uint32_t *)block)[SOUND_BANK_SIZE_FIELD];
+  uint32_t blockCount =
+      (size + SOUND_BANK_SD_BLOCK_SIZE - 1) / SOUND_BANK_SD_BLOCK_SIZE;
+  if (memcmp(block, SOUND_BANK_MAGIC, SOUND_BANK_MAGIC_LENGTH)) {
+    printf("soundBank_loadFromSd(): no sound bank at sector %u.\n",
+           firstSector);
+    return false;
+  }
+  uint8_t *image = malloc(blockCount * SOUND_BANK_SD_BLOCK_SIZE);
+  if (image == NULL || !soundBank_readSd(firstSector, blockCount, image) ||
+      !soundBank_open(bank, image, size)) {
+    printf("soundBank_loadFromSd(): cannot load the %u-byte bank.\n", size);
+    free(image);
+    return false;
+  }
+  bank->allocation = image;
+  return true;
+}
+#else
+// Maps the whole file read-only.
+bool soundBank_mapFile(soundBank_t *bank, const char *fileName) {
+  int file = open(fileName, O_RDONLY);
+  if (file < 0) {
+    perror(fileName);
+    return false;
+  }
+  struct stat status;
+  void *image = MAP_FAILED;
+  if (fstat(file, &status) == 0 && status.st_size > 0)
+    image = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file); // The mapping stays valid.
+  if (image == MAP_FAILED) {
+    perror(fileName);
+    return false;
+  }
+  if (!soundBank_open(bank, image, status.st_size)) {
+    munmap(image, status.st_size);
+    return false;
+  }
+  bank->allocation = image;
+  bank->mapped = true;
+  return true;
+}
+#endif
+
+// Releases the memory of a loaded or mapped bank.
+void soundBank_unload(soundBank_t *bank) {
+#ifndef ZYBO_BOARD
+  if (bank->mapped)
+    munmap(bank->allocation, bank->size);
+  else
+#endif
+    free(bank->allocation);
+  bank->allocation = NULL;
+  bank->mapped = false;
+  bank->clipCount = 0;
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define SOUND_BANK_TEST_CLIP_COUNT 3
+#define SOUND_BANK_TEST_IMAGE_SIZE 256 // Bytes, enough for the test clips.
+#define SOUND_BANK_TEST_MISSING_ID 99
+
+static const uint16_t soundBank_testSamples0[] = {1, 2, 3};
+static const uint16_t soundBank_testSamples1[] = {40000, 50000};
+static const uint16_t soundBank_testSamples2[] = {7, 8, 9, 10, 11};
+
+// Returns true if a clip of bank has the samples of expected.
+static bool soundBank_testClip(const soundBank_t *bank,
+                               const soundBank_clip_t *expected) {
+  soundBank_clip_t clip;
+  if (!soundBank_getClip(bank, expected->id, &clip) ||
+      clip.sampleRate != expected->sampleRate ||
+      clip.sampleCount != expected->sampleCount ||
+      memcmp(clip.samples, expected->samples,
+             clip.sampleCount * sizeof(uint16_t))) {
+    printf("* Error: clip %u is wrong.\n", expected->id);
+    return false;
+  }
+  return true;
+}
+
+// Builds a bank with clips of odd and even lengths, opens it and checks every
+// clip and a missing id. Then checks that a truncated image and one with a
+// clip past its end are rejected.
+bool soundBank_runTest() {
+  static uint32_t image[SOUND_BANK_TEST_IMAGE_SIZE / sizeof(uint32_t)];
+  const soundBank_clip_t clips[SOUND_BANK_TEST_CLIP_COUNT] = {
+      {0, 48000, soundBank_testSamples0, 3},
+      {5, 22050, soundBank_testSamples1, 2},
+      {2, 48000, soundBank_testSamples2, 5}};
+  uint32_t size = soundBank_getImageSize(clips, SOUND_BANK_TEST_CLIP_COUNT);
+  soundBank_build(image, clips, SOUND_BANK_TEST_CLIP_COUNT);
+  soundBank_t bank;
+  bool success = soundBank_open(&bank, image, size);
+  for (uint16_t i = 0; success && i < SOUND_BANK_TEST_CLIP_COUNT; i++)
+    success &= soundBank_testClip(&bank, &clips[i]);
+  soundBank_clip_t clip;
+  if (success && soundBank_getClip(&bank, SOUND_BANK_TEST_MISSING_ID, &clip)) {
+    printf("* Error: found a clip that is not in the bank.\n");
+    success = false;
+  }
+  printf("Two errors should follow:\n");
+  if (soundBank_open(&bank, image, size - SOUND_BANK_ALIGNMENT)) {
+    printf("* Error: a truncated bank was accepted.\n");
+    success = false;
+  }
+  soundBank_entry_t *directory =
+      (soundBank_entry_t *)((uint8_t *)image + SOUND_BANK_HEADER_LENGTH);
+  directory[SOUND_BANK_TEST_CLIP_COUNT - 1].sampleCount += // Past the end.
+      SOUND_BANK_ALIGNMENT;
+  if (soundBank_open(&bank, image, size)) {
+    printf("* Error: a clip past the end of the bank was accepted.\n");
+    success = false;
+  }
+  printf("=== Sound bank test %s.\n", success ? "passed" : "failed");
+  return success;
+}
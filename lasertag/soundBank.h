@@ -0,0 +1,100 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef SOUNDBANK_H_
+#define SOUNDBANK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A sound bank holds the sound clips in one binary image that is loaded at
+// run time instead of being compiled in, so sounds can be added or changed
+// without running wav2c and relinking. replay/mksoundbank writes banks from
+// WAV files (and the compiled-in game sounds). On the host and the emulator a
+// bank file is mapped with mmap(); on the board it is read from the SD card,
+// where it is written raw (e.g., with dd) starting at a given sector.
+//
+// Format (all fields uint32, little-endian; everything is 4-byte aligned):
+//   Header (SOUND_BANK_HEADER_LENGTH bytes): magic "SNDBNK01" (8), size of
+//   the whole image in bytes, clip count.
+//   Directory: one entry per clip: id, sample rate in Hz, sample count,
+//   offset of the samples from the start of the image.
+//   Payload: the samples of each clip, 16-bit in the format wav2c writes
+//   (PCM offset by INT16_MAX to unsigned), each clip 4-byte aligned.
+// Both the board and the host are little-endian, so a bank is used in place:
+// a clip is a pointer into the image.
+
+#define SOUND_BANK_MAGIC "SNDBNK01"
+#define SOUND_BANK_MAGIC_LENGTH 8
+#define SOUND_BANK_HEADER_LENGTH 16
+#define SOUND_BANK_SD_BLOCK_SIZE 512
+
+typedef struct {
+  uint32_t id;
+  uint32_t sampleRate;
+  uint32_t sampleCount;
+  uint32_t offset; // Of the samples, from the start of the image.
+} soundBank_entry_t;
+
+typedef struct {
+  const uint8_t *image;
+  uint32_t size;
+  uint32_t clipCount;
+  const soundBank_entry_t *directory;
+  void *allocation; // What soundBank_unload() releases, or NULL.
+  bool mapped;      // allocation was mapped with mmap().
+} soundBank_t;
+
+// A clip in a bank, or one to put in a bank.
+typedef struct {
+  uint32_t id;
+  uint32_t sampleRate;
+  const uint16_t *samples;
+  uint32_t sampleCount;
+} soundBank_clip_t;
+
+// Checks the header and that every clip lies inside the image, and sets up
+// bank to use the image in place. image must be 4-byte aligned and stay
+// valid while the bank is used. Prints an error and returns false if it is
+// not a valid bank.
+bool soundBank_open(soundBank_t *bank, const void *image, uint32_t size);
+
+// Looks up a clip by id. Returns false if the bank has no such clip.
+bool soundBank_getClip(const soundBank_t *bank, uint32_t id,
+                       soundBank_clip_t *clip);
+
+// Returns the size of the image for clipCount clips.
+uint32_t soundBank_getImageSize(const soundBank_clip_t clips[],
+                                uint32_t clipCount);
+
+// Writes the image for clipCount clips into image, which must be 4-byte
+// aligned and soundBank_getImageSize() bytes long.
+void soundBank_build(void *image, const soundBank_clip_t clips[],
+                     uint32_t clipCount);
+
+#ifdef ZYBO_BOARD
+// Reads a bank written raw to the SD card from sector firstSector on into
+// memory from malloc() and opens it. Returns false if the card cannot be
+// read or holds no valid bank there.
+bool soundBank_loadFromSd(soundBank_t *bank, uint32_t firstSector);
+#else
+// Maps a bank file into memory read-only and opens it. Returns false if the
+// file cannot be mapped or is not a valid bank.
+bool soundBank_mapFile(soundBank_t *bank, const char *fileName);
+#endif
+
+// Releases the memory of a loaded or mapped bank.
+void soundBank_unload(soundBank_t *bank);
+
+// Builds a bank with a few clips in memory, checks the lookups and that
+// images with a wrong size or a clip out of bounds are rejected. Returns true
+// if the test passes.
+bool soundBank_runTest();
+
+#endif /* SOUNDBANK_H_ */
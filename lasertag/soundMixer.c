@@ -0,0 +1,410 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "soundMixer.h"
+
+#define SOUND_MIXER_GAIN_SHIFT 15 // Q15 gains.
+#define SOUND_MIXER_MIN -INT16_MAX // Signed range of the offset samples.
+#define SOUND_MIXER_MAX (UINT16_MAX - INT16_MAX)
+
+// The main loop sets up a voice while it is inactive and then sets active
+// with a release store; the ISR reads active with an acquire load, so it
+// never sees a voice that is set up only in part.
+typedef struct {
+  _Atomic bool active;          // Set last by soundMixer_play(), cleared first.
+  const uint16_t *samples;      // NULL for an ADPCM clip or silence.
+  const imaAdpcm_clip_t *adpcm; // NULL for 16-bit samples.
+  imaAdpcm_state_t adpcmState;  // Before the sample at position.
+  bool resampling;              // samples are at another rate.
+  soundResampler_t resampler;   // Next input while resampling.
+  uint16_t *cacheOutput;        // Cache slot being filled, or NULL.
+  soundResampler_slot_t slot;   // Cache slot held, or NO_SLOT.
+  uint32_t sampleCount;         // At the output rate.
+  uint32_t position;            // Next sample to mix.
+  uint16_t gain;
+  uint8_t priority;
+} soundMixer_voiceState_t;
+
+static soundMixer_voiceState_t soundMixer_voices[SOUND_MIXER_VOICE_COUNT];
+
+// Stops all voices without releasing their cache slots, then empties the
+// cache.
+void soundMixer_init() {
+  for (soundMixer_voice_t v = 0; v < SOUND_MIXER_VOICE_COUNT; v++) {
+    atomic_init(&soundMixer_voices[v].active, false);
+    soundMixer_voices[v].slot = SOUND_RESAMPLER_NO_SLOT;
+  }
+  soundResampler_init();
+}
+
+// Returns a free voice, or else the lowest-priority voice whose priority is
+// not above priority, preferring the one that has played longest. Returns -1
+// if there is none.
+static soundMixer_voice_t soundMixer_findVoice(uint8_t priority) {
+  soundMixer_voice_t found = -1;
+  for (soundMixer_voice_t v = 0; v < SOUND_MIXER_VOICE_COUNT; v++) {
+    soundMixer_voiceState_t *voice = &soundMixer_voices[v];
+    if (!atomic_load_explicit(&voice->active, memory_order_acquire))
+      return v;
+    if (voice->priority > priority)
+      continue;
+    if (found < 0 || voice->priority < soundMixer_voices[found].priority ||
+        (voice->priority == soundMixer_voices[found].priority &&
+         voice->position > soundMixer_voices[found].position))
+      found = v;
+  }
+  return found;
+}
+
+// Stops a free or stolen voice and sets it up for sampleCount samples of
+// silence. The caller sets what it plays and then marks it active. Returns
+// -1 if there is no voice for priority.
+static soundMixer_voice_t soundMixer_claim(uint32_t sampleCount, uint16_t gain,
+                                           uint8_t priority) {
+  soundMixer_voice_t v = soundMixer_findVoice(priority);
+  if (v < 0 || sampleCount == 0)
+    return -1;
+  soundMixer_stop(v); // The ISR skips it while it is changed.
+  soundMixer_voiceState_t *voice = &soundMixer_voices[v];
+  voice->samples = NULL;
+  voice->adpcm = NULL;
+  voice->resampling = false;
+  voice->cacheOutput = NULL;
+  voice->sampleCount = sampleCount;
+  voice->position = 0;
+  voice->gain = gain;
+  voice->priority = priority;
+  return v;
+}
+
+// Starts a sound on a free or stolen voice.
+soundMixer_voice_t soundMixer_play(const uint16_t *samples,
+                                   uint32_t sampleCount, uint16_t gain,
+                                   uint8_t priority) {
+  soundMixer_voice_t v = soundMixer_claim(sampleCount, gain, priority);
+  if (v >= 0) {
+    soundMixer_voices[v].samples = samples;
+    atomic_store_explicit(&soundMixer_voices[v].active, true,
+                          memory_order_release);
+  }
+  return v;
+}
+
+// Starts an ADPCM clip on a free or stolen voice.
+soundMixer_voice_t soundMixer_playAdpcm(const imaAdpcm_clip_t *clip,
+                                        uint16_t gain, uint8_t priority) {
+  soundMixer_voice_t v = soundMixer_claim(clip->sampleCount, gain, priority);
+  if (v >= 0) {
+    soundMixer_voices[v].adpcm = clip;
+    soundMixer_voices[v].adpcmState = clip->index[0];
+    atomic_store_explicit(&soundMixer_voices[v].active, true,
+                          memory_order_release);
+  }
+  return v;
+}
+
+// Plays the resampled clip from the cache, or else resamples it while it
+// plays and caches it if a slot can be had.
+soundMixer_voice_t soundMixer_playAtRate(const uint16_t *samples,
+                                         uint32_t sampleCount,
+                                         uint32_t sampleRate, uint16_t gain,
+                                         uint8_t priority) {
+  if (sampleRate == SOUND_RESAMPLER_OUTPUT_RATE)
+    return soundMixer_play(samples, sampleCount, gain, priority);
+  if (!soundResampler_isRateSupported(sampleRate)) {
+    printf("soundMixer_playAtRate(): cannot play %u Hz.\n", sampleRate);
+    return -1;
+  }
+  uint32_t outputCount =
+      soundResampler_getOutputCount(sampleCount, sampleRate);
+  if (samples == NULL) // Silence needs no resampling.
+    return soundMixer_play(NULL, outputCount, gain, priority);
+  soundMixer_voice_t v = soundMixer_claim(outputCount, gain, priority);
+  if (v < 0)
+    return -1;
+  soundMixer_voiceState_t *voice = &soundMixer_voices[v];
+  voice->samples = soundResampler_getCached(samples, &voice->slot);
+  if (voice->samples == NULL) {
+    voice->samples = samples;
+    voice->resampling = true;
+    soundResampler_start(&voice->resampler, samples, sampleCount, sampleRate);
+    voice->cacheOutput =
+        soundResampler_reserve(samples, outputCount, &voice->slot);
+  }
+  atomic_store_explicit(&voice->active, true, memory_order_release);
+  return v;
+}
+
+// Stops a voice and releases its cache slot. A slot it was filling is
+// emptied. The sequentially consistent store keeps the changes that follow
+// from being made before the ISR can see that the voice is inactive.
+void soundMixer_stop(soundMixer_voice_t voice) {
+  atomic_store(&soundMixer_voices[voice].active, false);
+  soundResampler_release(soundMixer_voices[voice].slot, false);
+  soundMixer_voices[voice].slot = SOUND_RESAMPLER_NO_SLOT;
+}
+
+// Stops all voices.
+void soundMixer_stopAll() {
+  for (soundMixer_voice_t v = 0; v < SOUND_MIXER_VOICE_COUNT; v++)
+    soundMixer_stop(v);
+}
+
+// Returns true if a voice is playing.
+bool soundMixer_isVoiceActive(soundMixer_voice_t voice) {
+  return atomic_load_explicit(&soundMixer_voices[voice].active,
+                              memory_order_acquire);
+}
+
+// Returns the number of voices playing.
+uint16_t soundMixer_getActiveCount() {
+  uint16_t count = 0;
+  for (soundMixer_voice_t v = 0; v < SOUND_MIXER_VOICE_COUNT; v++)
+    count += atomic_load_explicit(&soundMixer_voices[v].active,
+                                  memory_order_acquire);
+  return count;
+}
+
+// Adds count samples of a voice, scaled by its gain, to mix. ADPCM clips are
+// decoded and clips at other rates resampled just for the block; resampled
+// samples also go to the cache slot, if any. Returns false when the voice has
+// reached its end.
+static bool soundMixer_addVoice(soundMixer_voiceState_t *voice, int32_t mix[],
+                                uint32_t count) {
+  uint32_t left = voice->sampleCount - voice->position;
+  if (count > left)
+    count = left;
+  int32_t gain = voice->gain;
+  if (voice->adpcm != NULL) {
+    int16_t decoded[SOUND_MIXER_BLOCK_SIZE];
+    imaAdpcm_decode(voice->adpcm, voice->position, &voice->adpcmState, decoded,
+                    count);
+    for (uint32_t i = 0; i < count; i++)
+      mix[i] += (decoded[i] * gain) >> SOUND_MIXER_GAIN_SHIFT;
+  } else if (voice->resampling) {
+    int16_t resampled[SOUND_MIXER_BLOCK_SIZE];
+    soundResampler_process(&voice->resampler, resampled, count);
+    for (uint32_t i = 0; i < count; i++)
+      mix[i] += (resampled[i] * gain) >> SOUND_MIXER_GAIN_SHIFT;
+    if (voice->cacheOutput != NULL)
+      for (uint32_t i = 0; i < count; i++)
+        voice->cacheOutput[voice->position + i] = resampled[i] + INT16_MAX;
+  } else if (voice->samples != NULL) {
+    const uint16_t *samples = voice->samples + voice->position;
+    for (uint32_t i = 0; i < count; i++)
+      mix[i] += (((int32_t)samples[i] - INT16_MAX) * gain) >>
+                SOUND_MIXER_GAIN_SHIFT;
+  }
+  voice->position += count;
+  return voice->position < voice->sampleCount;
+}
+
+// Sums the active voices into a block and saturates it.
+void soundMixer_mix(uint16_t block[], uint32_t count) {
+  while (count) {
+    int32_t mix[SOUND_MIXER_BLOCK_SIZE] = {0};
+    uint32_t length =
+        count < SOUND_MIXER_BLOCK_SIZE ? count : SOUND_MIXER_BLOCK_SIZE;
+    for (soundMixer_voice_t v = 0; v < SOUND_MIXER_VOICE_COUNT; v++) {
+      soundMixer_voiceState_t *voice = &soundMixer_voices[v];
+      if (atomic_load_explicit(&voice->active, memory_order_acquire) &&
+          !soundMixer_addVoice(voice, mix, length)) {
+        soundResampler_release(voice->slot, true); // Filled to the end.
+        voice->slot = SOUND_RESAMPLER_NO_SLOT;
+        atomic_store_explicit(&voice->active, false, memory_order_release);
+      }
+    }
+    for (uint32_t i = 0; i < length; i++) {
+      int32_t value = mix[i];
+      if (value > SOUND_MIXER_MAX)
+        value = SOUND_MIXER_MAX;
+      else if (value < SOUND_MIXER_MIN)
+        value = SOUND_MIXER_MIN;
+      block[i] = value + INT16_MAX;
+    }
+    block += length;
+    count -= length;
+  }
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define SOUND_MIXER_TEST_SAMPLE_COUNT 100 // Not a multiple of the block size.
+#define SOUND_MIXER_TEST_LOW_PRIORITY 1
+#define SOUND_MIXER_TEST_HIGH_PRIORITY 2
+#define SOUND_MIXER_TEST_RATE (SOUND_RESAMPLER_OUTPUT_RATE / 2)
+#define SOUND_MIXER_TEST_RESAMPLED_COUNT (2 * SOUND_MIXER_TEST_SAMPLE_COUNT)
+#define SOUND_MIXER_TEST_MAX_RESAMPLING_ERROR 2
+
+static uint16_t soundMixer_testRamp[SOUND_MIXER_TEST_SAMPLE_COUNT];
+static uint16_t soundMixer_testLoud[SOUND_MIXER_TEST_SAMPLE_COUNT];
+static int16_t soundMixer_testDecoded[SOUND_MIXER_TEST_SAMPLE_COUNT];
+
+// Mixes count samples and checks them against expected(i). Returns false and
+// prints an error at the first mismatch.
+static bool soundMixer_testBlock(const char *what, uint32_t count,
+                                 int32_t (*expected)(uint32_t i)) {
+  uint16_t block[SOUND_MIXER_TEST_SAMPLE_COUNT + SOUND_MIXER_BLOCK_SIZE];
+  soundMixer_mix(block, count);
+  for (uint32_t i = 0; i < count; i++)
+    if (block[i] != expected(i)) {
+      printf("* Error: %s: sample %u is %u, should be %d.\n", what, i,
+             block[i], expected(i));
+      return false;
+    }
+  return true;
+}
+
+// The ramp alone, then silence.
+static int32_t soundMixer_testExpectRamp(uint32_t i) {
+  return i < SOUND_MIXER_TEST_SAMPLE_COUNT ? soundMixer_testRamp[i]
+                                           : SOUND_MIXER_SILENCE;
+}
+
+// The ramp at half gain plus the loud sound, saturated.
+static int32_t soundMixer_testExpectSum(uint32_t i) {
+  int32_t value = (((int32_t)soundMixer_testRamp[i] - INT16_MAX) >> 1) +
+                  (int32_t)soundMixer_testLoud[i] - INT16_MAX;
+  if (value > SOUND_MIXER_MAX)
+    value = SOUND_MIXER_MAX;
+  return value + INT16_MAX;
+}
+
+// The ramp, encoded as ADPCM and decoded.
+static int32_t soundMixer_testExpectDecoded(uint32_t i) {
+  return soundMixer_testDecoded[i] + INT16_MAX;
+}
+
+// Silence at every sample.
+static int32_t soundMixer_testExpectSilence(uint32_t i) {
+  (void)i;
+  return SOUND_MIXER_SILENCE;
+}
+
+// Plays a ramp at half the output rate, so every other output falls on an
+// input, and checks those against the ramp away from its ends. Plays it again
+// and checks that it comes from the cache, unchanged. Returns false on an
+// error.
+static bool soundMixer_testResampling() {
+  static uint16_t first[SOUND_MIXER_TEST_RESAMPLED_COUNT];
+  static uint16_t second[SOUND_MIXER_TEST_RESAMPLED_COUNT];
+  soundMixer_playAtRate(soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                        SOUND_MIXER_TEST_RATE, SOUND_MIXER_UNITY_GAIN,
+                        SOUND_MIXER_TEST_LOW_PRIORITY);
+  soundMixer_mix(first, SOUND_MIXER_TEST_RESAMPLED_COUNT);
+  for (uint32_t i = SOUND_RESAMPLER_TAP_COUNT;
+       i < SOUND_MIXER_TEST_SAMPLE_COUNT - SOUND_RESAMPLER_TAP_COUNT; i++) {
+    int32_t error = (int32_t)first[2 * i] - soundMixer_testRamp[i];
+    if (error > SOUND_MIXER_TEST_MAX_RESAMPLING_ERROR ||
+        error < -SOUND_MIXER_TEST_MAX_RESAMPLING_ERROR) {
+      printf("* Error: resampled sample %u is %u, should be %u.\n", 2 * i,
+             first[2 * i], soundMixer_testRamp[i]);
+      return false;
+    }
+  }
+  soundResampler_slot_t slot;
+  if (soundMixer_getActiveCount() != 0 ||
+      soundResampler_getCached(soundMixer_testRamp, &slot) == NULL) {
+    printf("* Error: the resampled voice is not in the cache.\n");
+    return false;
+  }
+  soundResampler_release(slot, true);
+  soundMixer_playAtRate(soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                        SOUND_MIXER_TEST_RATE, SOUND_MIXER_UNITY_GAIN,
+                        SOUND_MIXER_TEST_LOW_PRIORITY);
+  soundMixer_mix(second, SOUND_MIXER_TEST_RESAMPLED_COUNT);
+  if (memcmp(first, second, sizeof(first))) {
+    printf("* Error: the cached voice differs from the resampled one.\n");
+    return false;
+  }
+  return true;
+}
+
+// Plays a ramp alone and checks that it comes out unchanged, followed by
+// silence. Plays it as an ADPCM clip and checks it against the decoder, and
+// resampled (see soundMixer_testResampling()). Plays it at half gain with a
+// loud sound that saturates. Fills all voices, two of them with low priority,
+// and checks that a lower-priority sound cannot steal one, that a
+// high-priority one steals the low-priority voice that has played longest,
+// and that stopping all voices gives silence.
+bool soundMixer_runTest() {
+  for (uint32_t i = 0; i < SOUND_MIXER_TEST_SAMPLE_COUNT; i++) {
+    soundMixer_testRamp[i] = INT16_MAX - 5000 + 100 * i;
+    soundMixer_testLoud[i] = UINT16_MAX - 1000;
+  }
+  soundMixer_init();
+  bool success = true;
+  soundMixer_play(soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                  SOUND_MIXER_UNITY_GAIN, SOUND_MIXER_TEST_LOW_PRIORITY);
+  success &= soundMixer_testBlock("single voice",
+                                  SOUND_MIXER_TEST_SAMPLE_COUNT +
+                                      SOUND_MIXER_BLOCK_SIZE,
+                                  soundMixer_testExpectRamp);
+  if (soundMixer_getActiveCount() != 0) {
+    printf("* Error: the voice did not stop at its end.\n");
+    success = false;
+  }
+  int16_t signedRamp[SOUND_MIXER_TEST_SAMPLE_COUNT];
+  for (uint32_t i = 0; i < SOUND_MIXER_TEST_SAMPLE_COUNT; i++)
+    signedRamp[i] = soundMixer_testRamp[i] - INT16_MAX;
+  uint8_t data[(SOUND_MIXER_TEST_SAMPLE_COUNT + 1) / 2];
+  imaAdpcm_state_t index[1]; // The test is shorter than an index interval.
+  imaAdpcm_encode(signedRamp, SOUND_MIXER_TEST_SAMPLE_COUNT, data, index);
+  imaAdpcm_clip_t clip = {data, index, SOUND_MIXER_TEST_SAMPLE_COUNT};
+  imaAdpcm_state_t state = index[0];
+  imaAdpcm_decode(&clip, 0, &state, soundMixer_testDecoded,
+                  SOUND_MIXER_TEST_SAMPLE_COUNT);
+  soundMixer_playAdpcm(&clip, SOUND_MIXER_UNITY_GAIN,
+                       SOUND_MIXER_TEST_LOW_PRIORITY);
+  success &= soundMixer_testBlock("ADPCM voice", SOUND_MIXER_TEST_SAMPLE_COUNT,
+                                  soundMixer_testExpectDecoded);
+  success &= soundMixer_testResampling();
+  soundMixer_play(soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                  SOUND_MIXER_UNITY_GAIN / 2, SOUND_MIXER_TEST_LOW_PRIORITY);
+  soundMixer_play(soundMixer_testLoud, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                  SOUND_MIXER_UNITY_GAIN, SOUND_MIXER_TEST_LOW_PRIORITY);
+  success &= soundMixer_testBlock("two voices", SOUND_MIXER_TEST_SAMPLE_COUNT,
+                                  soundMixer_testExpectSum);
+  soundMixer_voice_t oldest = -1;
+  for (soundMixer_voice_t v = 0; v < SOUND_MIXER_VOICE_COUNT; v++) {
+    soundMixer_voice_t voice = soundMixer_play(
+        soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+        SOUND_MIXER_UNITY_GAIN,
+        v < 2 ? SOUND_MIXER_TEST_LOW_PRIORITY : SOUND_MIXER_TEST_HIGH_PRIORITY);
+    if (v == 0)
+      oldest = voice;
+    uint16_t block[1];
+    soundMixer_mix(block, 1); // Voice 0 has played longest.
+  }
+  if (soundMixer_play(soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                      SOUND_MIXER_UNITY_GAIN, 0) != -1) {
+    printf("* Error: a low-priority sound took over a voice.\n");
+    success = false;
+  }
+  if (soundMixer_play(soundMixer_testRamp, SOUND_MIXER_TEST_SAMPLE_COUNT,
+                      SOUND_MIXER_UNITY_GAIN,
+                      SOUND_MIXER_TEST_HIGH_PRIORITY) != oldest) {
+    printf("* Error: a high-priority sound did not take over voice %d.\n",
+           oldest);
+    success = false;
+  }
+  soundMixer_stopAll();
+  success &= soundMixer_testBlock("stopped", SOUND_MIXER_TEST_SAMPLE_COUNT,
+                                  soundMixer_testExpectSilence);
+  soundMixer_init(); // Forget the ramp in the cache.
+  printf("=== Sound mixer test %s.\n", success ? "passed" : "failed");
+  return success;
+}
@@ -0,0 +1,101 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef SOUNDMIXER_H_
+#define SOUNDMIXER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "imaAdpcm.h"
+#include "soundResampler.h"
+
+// Mixes up to SOUND_MIXER_VOICE_COUNT sounds at once, so that, e.g., a gun
+// shot no longer cuts off the sound of a hit. sound.c starts sounds on voices
+// and streams the mix into the I2S TX FIFO; it only depends on the sound
+// arrays, so the replay directory also builds it into mixwav, which renders a
+// mix to a WAV file on the host.
+//
+// Samples are in the format written by wav2c: 16-bit PCM offset by INT16_MAX
+// to unsigned. Each voice has its own position, gain and priority. The mix is
+// the sum of the voices in signed form, scaled by their gains and saturated to
+// 16 bits, then offset back, so a single voice at SOUND_MIXER_UNITY_GAIN
+// comes out unchanged. With no voice playing, the mix is silence (INT16_MAX).
+// A voice can also play an IMA-ADPCM clip (see imaAdpcm.h). It is decoded a
+// block at a time as it is mixed, so only the samples the FIFO needs are
+// decoded, and a clip needs no buffer beyond the block. A voice can also play
+// a clip at a rate other than SOUND_RESAMPLER_OUTPUT_RATE, resampled a block
+// at a time the first time it plays and from the cache after that (see
+// soundResampler.h).
+//
+// soundMixer_mix() renders a block of samples at a time. sound_tick() mixes at
+// most one block of SOUND_MIXER_BLOCK_SIZE samples per tick, so the cost of a
+// tick stays under SOUND_MIXER_BLOCK_SIZE * SOUND_MIXER_VOICE_COUNT
+// multiply-adds (and decoded samples) however many samples the FIFO has room
+// for. At 48 kHz, a block of 16 samples lasts 33 ticks.
+//
+// soundMixer_play() and soundMixer_stop() are called from the main loop while
+// the ISR mixes. They mark a voice inactive before changing it and active
+// again after, and the mix skips inactive voices, so the ISR never sees a
+// voice that is half set up.
+
+#define SOUND_MIXER_VOICE_COUNT 4
+#define SOUND_MIXER_BLOCK_SIZE 16
+#define SOUND_MIXER_UNITY_GAIN 32768 // Gains are Q15: 32768 is 1.0.
+#define SOUND_MIXER_SILENCE INT16_MAX
+
+typedef int16_t soundMixer_voice_t; // -1 if a sound could not be started.
+
+// Stops all voices and empties the resampling cache.
+void soundMixer_init();
+
+// Starts playing sampleCount samples on a free voice with the given gain and
+// priority. samples may be NULL for sampleCount samples of silence. If all
+// voices are busy, takes over the lowest-priority voice whose priority is not
+// above priority (the one that has played longest among equals). Returns the
+// voice, or -1 if all voices play more important sounds.
+soundMixer_voice_t soundMixer_play(const uint16_t *samples,
+                                   uint32_t sampleCount, uint16_t gain,
+                                   uint8_t priority);
+
+// Same as soundMixer_play() for sampleCount samples at sampleRate, which are
+// resampled to SOUND_RESAMPLER_OUTPUT_RATE as they play. Returns -1 also if
+// the rate is not supported.
+soundMixer_voice_t soundMixer_playAtRate(const uint16_t *samples,
+                                         uint32_t sampleCount,
+                                         uint32_t sampleRate, uint16_t gain,
+                                         uint8_t priority);
+
+// Same as soundMixer_play() for an IMA-ADPCM clip.
+soundMixer_voice_t soundMixer_playAdpcm(const imaAdpcm_clip_t *clip,
+                                        uint16_t gain, uint8_t priority);
+
+// Stops a voice.
+void soundMixer_stop(soundMixer_voice_t voice);
+
+// Stops all voices.
+void soundMixer_stopAll();
+
+// Returns true if a voice is playing.
+bool soundMixer_isVoiceActive(soundMixer_voice_t voice);
+
+// Returns the number of voices playing.
+uint16_t soundMixer_getActiveCount();
+
+// Renders the next count samples of the mix into block and advances the
+// voices. Voices that reach their end stop.
+void soundMixer_mix(uint16_t block[], uint32_t count);
+
+// Checks a single voice against its samples, an ADPCM voice against its
+// decoded samples, a resampled voice against its samples and against itself
+// played from the cache, the sum and saturation of two voices, voice stealing
+// by priority, and stopping. Returns true if the test passes.
+bool soundMixer_runTest();
+
+#endif /* SOUNDMIXER_H_ */
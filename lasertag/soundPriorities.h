@@ -0,0 +1,33 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef SOUNDPRIORITIES_H_
+#define SOUNDPRIORITIES_H_
+
+#include <stdint.h>
+
+#include "sound.h" // sound_sounds_t.
+
+// Mixer priority of each sound, indexed by sound_sounds_t. When all voices
+// are busy, a sound takes over the voice of a sound with lower or equal
+// priority, so, e.g., a gun shot never cuts off losing a life. Used by sound.c
+// and by replay/mixWav.c, so the rendered mixes match the board.
+static const uint8_t soundPriorities_table[] = {
+    [sound_gameStart_e] = 1,
+    [sound_gunFire_e] = 1,
+    [sound_hit_e] = 2,
+    [sound_gunClick_e] = 0,
+    [sound_gunReload_e] = 1,
+    [sound_loseLife_e] = 3,
+    [sound_gameOver_e] = 3,
+    [sound_returnToBase_e] = 2,
+    [sound_oneSecondSilence_e] = 0,
+};
+
+#endif /* SOUNDPRIORITIES_H_ */
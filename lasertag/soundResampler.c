@@ -0,0 +1,373 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "soundResampler.h"
+
+#define SOUND_RESAMPLER_PI 3.14159265358979323846
+#define SOUND_RESAMPLER_CUTOFF 0.9 // Of the Nyquist frequency of the input.
+#define SOUND_RESAMPLER_FRACTION_BITS 16
+#define SOUND_RESAMPLER_FRACTION_MASK ((1 << SOUND_RESAMPLER_FRACTION_BITS) - 1)
+#define SOUND_RESAMPLER_COEFFICIENT_BITS 14 // Q14, so 1.0 fits in an int16_t.
+#define SOUND_RESAMPLER_CENTER (SOUND_RESAMPLER_TAP_COUNT / 2 - 1) // At index.
+
+// Taps of each phase p, for the outputs that fall between p / PHASE_COUNT and
+// (p + 1) / PHASE_COUNT of an input sample after index.
+static int16_t soundResampler_coefficients[SOUND_RESAMPLER_PHASE_COUNT]
+                                          [SOUND_RESAMPLER_TAP_COUNT];
+
+typedef struct {
+  const uint16_t *input; // Key of the slot, NULL if it is empty.
+  uint16_t *buffer;      // malloc()ed when first reserved, else NULL.
+  uint32_t capacity;     // Samples the buffer holds.
+  uint32_t lastUsed;     // Value of soundResampler_useCount when last taken.
+  volatile bool filled;  // Holds the whole clip.
+  volatile uint8_t userCount;
+} soundResampler_cacheSlot_t;
+
+static soundResampler_cacheSlot_t
+    soundResampler_slots[SOUND_RESAMPLER_CACHE_SLOT_COUNT];
+static uint32_t soundResampler_useCount; // Orders the slots by last use.
+
+// Computes the taps of each phase at the middle of its fractions: a sinc
+// that cuts off at SOUND_RESAMPLER_CUTOFF, under a Blackman window. Each
+// phase is scaled to a gain of exactly 1.0 at DC, so silence stays silence.
+static void soundResampler_computeCoefficients() {
+  for (uint16_t p = 0; p < SOUND_RESAMPLER_PHASE_COUNT; p++) {
+    double fraction = (p + 0.5) / SOUND_RESAMPLER_PHASE_COUNT;
+    double taps[SOUND_RESAMPLER_TAP_COUNT];
+    double sum = 0.0;
+    for (uint16_t k = 0; k < SOUND_RESAMPLER_TAP_COUNT; k++) {
+      double t = k - SOUND_RESAMPLER_CENTER - fraction; // In input samples.
+      double x = SOUND_RESAMPLER_PI * SOUND_RESAMPLER_CUTOFF * t;
+      double window = 2.0 * SOUND_RESAMPLER_PI * t / SOUND_RESAMPLER_TAP_COUNT;
+      // t is never 0: fraction is between two multiples of 1 / PHASE_COUNT.
+      taps[k] = sin(x) / x *
+                (0.42 + 0.5 * cos(window) + 0.08 * cos(2.0 * window));
+      sum += taps[k];
+    }
+    int32_t total = 0;
+    for (uint16_t k = 0; k < SOUND_RESAMPLER_TAP_COUNT; k++) {
+      soundResampler_coefficients[p][k] =
+          lround(taps[k] / sum * (1 << SOUND_RESAMPLER_COEFFICIENT_BITS));
+      total += soundResampler_coefficients[p][k];
+    }
+    // The rounding error goes to the largest tap.
+    uint16_t largest = fraction < 0.5 ? SOUND_RESAMPLER_CENTER
+                                      : SOUND_RESAMPLER_CENTER + 1;
+    soundResampler_coefficients[p][largest] +=
+        (1 << SOUND_RESAMPLER_COEFFICIENT_BITS) - total;
+  }
+}
+
+// Computes the filter, empties the cache and frees its buffers.
+void soundResampler_init() {
+  soundResampler_computeCoefficients();
+  for (soundResampler_slot_t s = 0; s < SOUND_RESAMPLER_CACHE_SLOT_COUNT; s++) {
+    soundResampler_slots[s].input = NULL;
+    free(soundResampler_slots[s].buffer);
+    soundResampler_slots[s].buffer = NULL;
+    soundResampler_slots[s].capacity = 0;
+    soundResampler_slots[s].lastUsed = 0;
+    soundResampler_slots[s].filled = false;
+    soundResampler_slots[s].userCount = 0;
+  }
+  soundResampler_useCount = 0;
+}
+
+// The filter only upsamples.
+bool soundResampler_isRateSupported(uint32_t inputRate) {
+  return inputRate > 0 && inputRate <= SOUND_RESAMPLER_OUTPUT_RATE;
+}
+
+// Returns the number of output samples, rounded up.
+uint32_t soundResampler_getOutputCount(uint32_t inputCount,
+                                       uint32_t inputRate) {
+  return ((uint64_t)inputCount * SOUND_RESAMPLER_OUTPUT_RATE + inputRate - 1) /
+         inputRate;
+}
+
+// Starts at the first input sample.
+void soundResampler_start(soundResampler_t *resampler, const uint16_t *input,
+                          uint32_t inputCount, uint32_t inputRate) {
+  resampler->input = input;
+  resampler->inputCount = inputCount;
+  resampler->step = (((uint64_t)inputRate << SOUND_RESAMPLER_FRACTION_BITS) +
+                     SOUND_RESAMPLER_OUTPUT_RATE / 2) /
+                    SOUND_RESAMPLER_OUTPUT_RATE;
+  resampler->index = 0;
+  resampler->fraction = 0;
+}
+
+// Filters the inputs around each output with the phase of its fraction. Near
+// the ends of the clip, the inputs outside it are skipped; index - CENTER
+// wraps around below 0, so those are skipped too.
+void soundResampler_process(soundResampler_t *resampler, int16_t output[],
+                            uint32_t count) {
+  const uint16_t *input = resampler->input;
+  uint32_t inputCount = resampler->inputCount;
+  uint32_t index = resampler->index;
+  uint32_t fraction = resampler->fraction;
+  for (uint32_t i = 0; i < count; i++) {
+    const int16_t *taps =
+        soundResampler_coefficients[(fraction * SOUND_RESAMPLER_PHASE_COUNT) >>
+                                    SOUND_RESAMPLER_FRACTION_BITS];
+    uint32_t first = index - SOUND_RESAMPLER_CENTER;
+    int32_t sum = 0;
+    if (index >= SOUND_RESAMPLER_CENTER &&
+        first + SOUND_RESAMPLER_TAP_COUNT <= inputCount) {
+      for (uint16_t k = 0; k < SOUND_RESAMPLER_TAP_COUNT; k++)
+        sum += taps[k] * ((int32_t)input[first + k] - INT16_MAX);
+    } else {
+      for (uint16_t k = 0; k < SOUND_RESAMPLER_TAP_COUNT; k++)
+        if (first + k < inputCount)
+          sum += taps[k] * ((int32_t)input[first + k] - INT16_MAX);
+    }
+    sum = (sum + (1 << (SOUND_RESAMPLER_COEFFICIENT_BITS - 1))) >>
+          SOUND_RESAMPLER_COEFFICIENT_BITS;
+    if (sum > INT16_MAX)
+      sum = INT16_MAX;
+    else if (sum < INT16_MIN)
+      sum = INT16_MIN;
+    output[i] = sum;
+    fraction += resampler->step;
+    index += fraction >> SOUND_RESAMPLER_FRACTION_BITS;
+    fraction &= SOUND_RESAMPLER_FRACTION_MASK;
+  }
+  resampler->index = index;
+  resampler->fraction = fraction;
+}
+
+// Makes a slot the most recently used and counts one more user.
+static void soundResampler_take(soundResampler_slot_t slot) {
+  soundResampler_slots[slot].lastUsed = ++soundResampler_useCount;
+  __atomic_fetch_add(&soundResampler_slots[slot].userCount, 1,
+                     __ATOMIC_SEQ_CST);
+}
+
+// Looks for a filled slot with the samples of input.
+const uint16_t *soundResampler_getCached(const uint16_t *input,
+                                         soundResampler_slot_t *slot) {
+  for (soundResampler_slot_t s = 0; s < SOUND_RESAMPLER_CACHE_SLOT_COUNT; s++)
+    if (soundResampler_slots[s].filled &&
+        soundResampler_slots[s].input == input) {
+      soundResampler_take(s);
+      *slot = s;
+      return soundResampler_slots[s].buffer;
+    }
+  *slot = SOUND_RESAMPLER_NO_SLOT;
+  return NULL;
+}
+
+// Makes the buffer of a slot no voice uses hold at least outputCount samples.
+// Returns false if there is no memory for it.
+static bool soundResampler_allocate(soundResampler_cacheSlot_t *cacheSlot,
+                                    uint32_t outputCount) {
+  if (cacheSlot->capacity >= outputCount)
+    return true;
+  free(cacheSlot->buffer);
+  cacheSlot->buffer = malloc(outputCount * sizeof(uint16_t));
+  cacheSlot->capacity = cacheSlot->buffer != NULL ? outputCount : 0;
+  return cacheSlot->buffer != NULL;
+}
+
+// Takes an empty slot, or else the least recently used one no voice uses.
+uint16_t *soundResampler_reserve(const uint16_t *input, uint32_t outputCount,
+                                 soundResampler_slot_t *slot) {
+  *slot = SOUND_RESAMPLER_NO_SLOT;
+  if (outputCount > SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE)
+    return NULL;
+  soundResampler_slot_t found = SOUND_RESAMPLER_NO_SLOT;
+  for (soundResampler_slot_t s = 0; s < SOUND_RESAMPLER_CACHE_SLOT_COUNT; s++) {
+    const soundResampler_cacheSlot_t *candidate = &soundResampler_slots[s];
+    if (candidate->input == input)
+      return NULL; // Being filled by another voice.
+    if (candidate->userCount > 0)
+      continue;
+    if (found == SOUND_RESAMPLER_NO_SLOT || candidate->input == NULL ||
+        (soundResampler_slots[found].input != NULL &&
+         candidate->lastUsed < soundResampler_slots[found].lastUsed))
+      found = s;
+  }
+  if (found == SOUND_RESAMPLER_NO_SLOT)
+    return NULL;
+  soundResampler_cacheSlot_t *cacheSlot = &soundResampler_slots[found];
+  cacheSlot->filled = false;
+  cacheSlot->input = NULL;
+  if (!soundResampler_allocate(cacheSlot, outputCount)) {
+    printf("soundResampler_reserve(): no memory to cache %u samples.\n",
+           outputCount);
+    return NULL;
+  }
+  cacheSlot->input = input;
+  soundResampler_take(found);
+  *slot = found;
+  return cacheSlot->buffer;
+}
+
+// Marks a reserved slot filled or empties it, then counts one user less.
+void soundResampler_release(soundResampler_slot_t slot, bool filled) {
+  if (slot == SOUND_RESAMPLER_NO_SLOT)
+    return;
+  soundResampler_cacheSlot_t *cacheSlot = &soundResampler_slots[slot];
+  if (!cacheSlot->filled) {
+    if (filled)
+      cacheSlot->filled = true;
+    else
+      cacheSlot->input = NULL;
+  }
+  __atomic_fetch_sub(&cacheSlot->userCount, 1, __ATOMIC_SEQ_CST);
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define SOUND_RESAMPLER_TEST_INPUT_RATE 22050
+#define SOUND_RESAMPLER_TEST_INPUT_COUNT 22050 // One second.
+#define SOUND_RESAMPLER_TEST_OUTPUT_COUNT SOUND_RESAMPLER_OUTPUT_RATE
+#define SOUND_RESAMPLER_TEST_HZ 4000.0
+#define SOUND_RESAMPLER_TEST_AMPLITUDE 20000
+#define SOUND_RESAMPLER_TEST_MIN_SNR_DB 40.0
+#define SOUND_RESAMPLER_TEST_EDGE_COUNT 16 // Outputs next to the ends.
+#define SOUND_RESAMPLER_TEST_PIECE_SIZE 16 // As the mixer asks for them.
+#define SOUND_RESAMPLER_TEST_KEY_COUNT (SOUND_RESAMPLER_CACHE_SLOT_COUNT + 1)
+
+static uint16_t soundResampler_testInput[SOUND_RESAMPLER_TEST_INPUT_COUNT];
+static int16_t soundResampler_testOutput[SOUND_RESAMPLER_TEST_OUTPUT_COUNT];
+static const uint16_t soundResampler_testKeys[SOUND_RESAMPLER_TEST_KEY_COUNT]
+                                             [1];
+
+// Resamples a sine and compares each output with the sine at the position
+// the resampler put it, so the test measures the filter and not the rounding
+// of the step. Returns the signal-to-noise ratio in dB.
+static double soundResampler_testSine(double *nanosecondsPerSample) {
+  double radiansPerInput =
+      2.0 * SOUND_RESAMPLER_PI * SOUND_RESAMPLER_TEST_HZ /
+      SOUND_RESAMPLER_TEST_INPUT_RATE;
+  for (uint32_t i = 0; i < SOUND_RESAMPLER_TEST_INPUT_COUNT; i++)
+    soundResampler_testInput[i] =
+        INT16_MAX +
+        lround(SOUND_RESAMPLER_TEST_AMPLITUDE * sin(radiansPerInput * i));
+  soundResampler_t resampler;
+  soundResampler_start(&resampler, soundResampler_testInput,
+                       SOUND_RESAMPLER_TEST_INPUT_COUNT,
+                       SOUND_RESAMPLER_TEST_INPUT_RATE);
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t i = 0; i < SOUND_RESAMPLER_TEST_OUTPUT_COUNT;
+       i += SOUND_RESAMPLER_TEST_PIECE_SIZE)
+    soundResampler_process(&resampler, &soundResampler_testOutput[i],
+                           SOUND_RESAMPLER_TEST_PIECE_SIZE);
+  *nanosecondsPerSample =
+      benchmark_elapsedNanoseconds(start, benchmark_now()) /
+      SOUND_RESAMPLER_TEST_OUTPUT_COUNT;
+  double signal = 0.0, noise = 0.0;
+  for (uint32_t i = SOUND_RESAMPLER_TEST_EDGE_COUNT;
+       i < SOUND_RESAMPLER_TEST_OUTPUT_COUNT - SOUND_RESAMPLER_TEST_EDGE_COUNT;
+       i++) {
+    double position = (double)i * resampler.step /
+                      (1 << SOUND_RESAMPLER_FRACTION_BITS);
+    double expected =
+        SOUND_RESAMPLER_TEST_AMPLITUDE * sin(radiansPerInput * position);
+    double error = soundResampler_testOutput[i] - expected;
+    signal += expected * expected;
+    noise += error * error;
+  }
+  return 10.0 * log10(signal / noise);
+}
+
+// Fills every slot, then checks that a filled slot is found, that the least
+// recently used slot is reused, that slots in use are not, that a slot that
+// was not filled to the end is emptied, that a clip longer than
+// SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE is not cached, and that a slot with a
+// short buffer grows for a clip of the maximum length.
+static bool soundResampler_testCache() {
+  const uint16_t *keys[SOUND_RESAMPLER_TEST_KEY_COUNT];
+  soundResampler_slot_t slots[SOUND_RESAMPLER_TEST_KEY_COUNT];
+  for (uint16_t i = 0; i < SOUND_RESAMPLER_TEST_KEY_COUNT; i++)
+    keys[i] = soundResampler_testKeys[i];
+  soundResampler_init();
+  bool success = true;
+  for (uint16_t i = 0; i < SOUND_RESAMPLER_CACHE_SLOT_COUNT; i++) {
+    success &= soundResampler_reserve(keys[i], 1, &slots[i]) != NULL;
+    soundResampler_release(slots[i], true);
+  }
+  success &= soundResampler_getCached(keys[0], &slots[0]) != NULL;
+  soundResampler_release(slots[0], true); // Keys[1] is now the oldest.
+  success &= soundResampler_reserve(keys[SOUND_RESAMPLER_CACHE_SLOT_COUNT], 1,
+                                    &slots[1]) != NULL;
+  soundResampler_release(slots[1], true);
+  if (!success || soundResampler_getCached(keys[1], &slots[1]) != NULL) {
+    printf("* Error: the cache did not reuse the least recently used slot.\n");
+    return false;
+  }
+  for (uint16_t i = 0; i < SOUND_RESAMPLER_CACHE_SLOT_COUNT; i++) // All.
+    soundResampler_getCached(
+        keys[i == 1 ? SOUND_RESAMPLER_CACHE_SLOT_COUNT : i], &slots[i]);
+  soundResampler_slot_t slot;
+  if (soundResampler_reserve(keys[1], 1, &slot) != NULL) {
+    printf("* Error: the cache reused a slot in use.\n");
+    success = false;
+  }
+  for (uint16_t i = 0; i < SOUND_RESAMPLER_CACHE_SLOT_COUNT; i++)
+    soundResampler_release(slots[i], true);
+  soundResampler_reserve(keys[1], 1, &slots[1]);
+  soundResampler_release(slots[1], false);
+  if (soundResampler_getCached(keys[1], &slots[1]) != NULL) {
+    printf("* Error: a slot that was not filled is in the cache.\n");
+    success = false;
+  }
+  if (soundResampler_reserve(keys[1], SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE + 1,
+                             &slots[1]) != NULL) {
+    printf("* Error: a clip longer than a slot was cached.\n");
+    success = false;
+  }
+  uint16_t *buffer = soundResampler_reserve(
+      keys[1], SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE, &slots[1]);
+  if (buffer == NULL) {
+    printf("* Error: a slot did not grow to the longest clip.\n");
+    success = false;
+  } else { // The whole buffer can be written.
+    buffer[SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE - 1] = INT16_MAX; // Silence.
+    soundResampler_release(slots[1], true);
+  }
+  soundResampler_init(); // Forget the test keys.
+  return success;
+}
+
+// Resamples a 4 kHz sine from 22.05 kHz, checks its signal-to-noise ratio and
+// the output count, and tests the cache.
+bool soundResampler_runTest() {
+  soundResampler_init();
+  bool success = true;
+  double nanosecondsPerSample;
+  double snr = soundResampler_testSine(&nanosecondsPerSample);
+  if (snr < SOUND_RESAMPLER_TEST_MIN_SNR_DB) {
+    printf("* Error: signal-to-noise ratio is %.1lf dB, should be at least "
+           "%.1lf dB.\n",
+           snr, SOUND_RESAMPLER_TEST_MIN_SNR_DB);
+    success = false;
+  }
+  if (soundResampler_getOutputCount(SOUND_RESAMPLER_TEST_INPUT_COUNT,
+                                    SOUND_RESAMPLER_TEST_INPUT_RATE) !=
+      SOUND_RESAMPLER_TEST_OUTPUT_COUNT) {
+    printf("* Error: one second of input is not one second of output.\n");
+    success = false;
+  }
+  success &= soundResampler_testCache();
+  printf("Signal-to-noise ratio %.1lf dB, %.2lf ns per output sample.\n", snr,
+         nanosecondsPerSample);
+  printf("=== Sound resampler test %s.\n", success ? "passed" : "failed");
+  return success;
+}
@@ -0,0 +1,113 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef SOUNDRESAMPLER_H_
+#define SOUNDRESAMPLER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Converts sound clips to the rate of the codec while they play, so clips can
+// be kept at their native rate (which wav2c records in <NAME>_SAMPLE_RATE)
+// instead of as pre-converted copies. soundMixer_playAtRate() uses it.
+//
+// The resampler is a polyphase FIR filter: a windowed-sinc lowpass with
+// SOUND_RESAMPLER_TAP_COUNT taps, split into SOUND_RESAMPLER_PHASE_COUNT
+// phases, one for each fraction of an input sample an output can fall at.
+// An output sample takes SOUND_RESAMPLER_TAP_COUNT multiply-adds with the
+// phase nearest to its position, which follows the input in Q16 steps of
+// inputRate / SOUND_RESAMPLER_OUTPUT_RATE. The filter cuts off just below the
+// Nyquist frequency of the input, so it only upsamples: clips above the
+// output rate must be converted offline.
+//
+// Resampling costs about as much as mixing SOUND_RESAMPLER_TAP_COUNT voices,
+// so the output is also kept in a cache of SOUND_RESAMPLER_CACHE_SLOT_COUNT
+// slots. The first time a clip plays, the mixer writes the resampled samples
+// into a free slot as well; once the clip has played to its end the slot
+// holds the whole clip, and the next time it plays from there at the cost of
+// a plain voice. When no slot is free, the slot used least recently is
+// reused, unless a voice is still playing from it.
+//
+// A slot has no buffer until a clip that needs resampling is reserved in it;
+// the buffer is then malloc()ed to the resampled length of the clip, and
+// grown only when a longer clip reuses the slot. Clips at the output rate
+// (all of the compiled-in sounds) never cost any cache memory. The longest
+// clip a slot holds is SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE resampled samples,
+// so the cache never takes more than SLOT_COUNT * MAX_CLIP_SIZE * 2 bytes
+// (512 KB). A longer clip, or one for which there is no memory, is not
+// cached: it is resampled while it plays, every time it plays.
+//
+// Slots are taken in the main loop (soundMixer_playAtRate()) and released by
+// the ISR when a voice ends, so the count of voices using a slot is changed
+// atomically, and only the main loop reuses slots and allocates their
+// buffers.
+
+#define SOUND_RESAMPLER_OUTPUT_RATE 48000 // Hz, the rate of the codec.
+#define SOUND_RESAMPLER_TAP_COUNT 8
+#define SOUND_RESAMPLER_PHASE_COUNT 128
+#define SOUND_RESAMPLER_CACHE_SLOT_COUNT 4
+#define SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE 65536 // Samples, 1.37 s at 48 kHz.
+#define SOUND_RESAMPLER_NO_SLOT -1
+
+// Position of the resampler in a clip. Samples are in the format of the sound
+// arrays (see soundMixer.h).
+typedef struct {
+  const uint16_t *input;
+  uint32_t inputCount;
+  uint32_t step;     // Input samples per output sample, Q16.
+  uint32_t index;    // Input sample at or before the next output.
+  uint32_t fraction; // Q16 position of the next output after index.
+} soundResampler_t;
+
+typedef int8_t soundResampler_slot_t; // SOUND_RESAMPLER_NO_SLOT for none.
+
+// Computes the filter, empties the cache and frees its buffers.
+void soundResampler_init();
+
+// Returns true if clips at inputRate can be resampled.
+bool soundResampler_isRateSupported(uint32_t inputRate);
+
+// Returns the number of output samples for inputCount samples at inputRate.
+uint32_t soundResampler_getOutputCount(uint32_t inputCount, uint32_t inputRate);
+
+// Starts resampling inputCount samples at inputRate from the first one.
+void soundResampler_start(soundResampler_t *resampler, const uint16_t *input,
+                          uint32_t inputCount, uint32_t inputRate);
+
+// Computes the next count output samples, signed, and advances. Inputs
+// before the start or past the end of the clip count as silence.
+void soundResampler_process(soundResampler_t *resampler, int16_t output[],
+                            uint32_t count);
+
+// Returns the resampled samples of input if a slot holds all of them, and
+// takes the slot, which makes it the most recently used. Returns NULL
+// otherwise.
+const uint16_t *soundResampler_getCached(const uint16_t *input,
+                                         soundResampler_slot_t *slot);
+
+// Takes a free or the least recently used slot for the outputCount resampled
+// samples of input, and returns its buffer to fill, allocating or growing it
+// as needed. Returns NULL if the clip is longer than
+// SOUND_RESAMPLER_CACHE_MAX_CLIP_SIZE, is already being cached, every slot is
+// in use, or there is no memory for the buffer.
+uint16_t *soundResampler_reserve(const uint16_t *input, uint32_t outputCount,
+                                 soundResampler_slot_t *slot);
+
+// Releases a slot taken by soundResampler_getCached() or
+// soundResampler_reserve(). filled tells whether a reserved slot was filled
+// to the end; if not, it is emptied. Called from the main loop or the ISR.
+void soundResampler_release(soundResampler_slot_t slot, bool filled);
+
+// Resamples a sine from 22.05 kHz and checks its signal-to-noise ratio, prints
+// the time per output sample, and checks that the cache finds filled slots,
+// reuses the least recently used one and never one in use. Returns true if
+// the test passes.
+bool soundResampler_runTest();
+
+#endif /* SOUNDRESAMPLER_H_ */
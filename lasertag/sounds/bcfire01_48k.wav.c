@@ -1,53644 +1,1741 @@
-// This file was generated by executing this statement: wav2c bcfire01_48k.wav
+// This file was generated by executing this statement: wav2c -a bcfire01_48k.wav
 
-#include <stdint.h>
+#include "bcfire01_48k.wav.h"
 
-uint16_t bcfire01_48k_wav[53638] = {
-32767,
-32765,
-32766,
-32773,
-32760,
-32773,
-32760,
-32770,
-32769,
-32767,
-32766,
-32768,
-32765,
-32771,
-32763,
-32771,
-32761,
-32775,
-32759,
-32773,
-32763,
-32768,
-32771,
-32761,
-32770,
-32764,
-32770,
-32767,
-32766,
-32770,
-32761,
-32775,
-32756,
-32776,
-32762,
-32771,
-32765,
-32765,
-32765,
-32770,
-32770,
-32763,
-32771,
-32756,
-32777,
-32763,
-32772,
-32763,
-32767,
-32765,
-32769,
-32767,
-32766,
-32771,
-32765,
-32767,
-32766,
-32768,
-32770,
-32767,
-32762,
-32767,
-32769,
-32767,
-32772,
-32758,
-32773,
-32763,
-32777,
-32754,
-32762,
-32747,
-32762,
-32763,
-32774,
-32769,
-32770,
-32770,
-32764,
-32774,
-32757,
-32776,
-32773,
-32808,
-32818,
-32828,
-32824,
-32813,
-32820,
-32817,
-32821,
-32808,
-32800,
-32798,
-32794,
-32791,
-32772,
-32768,
-32759,
-32773,
-32768,
-32773,
-32759,
-32761,
-32756,
-32747,
-32731,
-32728,
-32729,
-32757,
-32769,
-32787,
-32779,
-32777,
-32776,
-32779,
-32778,
-32772,
-32763,
-32757,
-32762,
-32759,
-32754,
-32754,
-32741,
-32755,
-32750,
-32763,
-32747,
-32749,
-32722,
-32722,
-32710,
-32719,
-32714,
-32721,
-32720,
-32723,
-32740,
-32730,
-32752,
-32753,
-32766,
-32766,
-32761,
-32771,
-32795,
-32825,
-32830,
-32855,
-32878,
-32970,
-33074,
-33253,
-33441,
-33601,
-33510,
-32980,
-32005,
-30867,
-29975,
-29535,
-29336,
-29200,
-29411,
-30946,
-34504,
-39175,
-42128,
-40275,
-33348,
-25243,
-21874,
-26145,
-34828,
-40706,
-39006,
-32073,
-27409,
-30374,
-38635,
-44203,
-41119,
-31176,
-22125,
-20383,
-25908,
-33460,
-37951,
-37881,
-34737,
-30516,
-26992,
-25888,
-28215,
-32542,
-35238,
-33787,
-29816,
-27737,
-29729,
-32953,
-33103,
-30126,
-29183,
-34335,
-42795,
-46901,
-42759,
-35106,
-32226,
-36290,
-40685,
-37956,
-29121,
-23001,
-26252,
-35300,
-40225,
-35642,
-26540,
-22514,
-27308,
-35567,
-39207,
-36001,
-30711,
-29158,
-32287,
-36353,
-37615,
-35835,
-33535,
-32915,
-33904,
-34823,
-34164,
-31878,
-29353,
-28409,
-29850,
-32670,
-34779,
-34679,
-33058,
-32050,
-33325,
-36152,
-38181,
-37400,
-34310,
-31295,
-30625,
-32313,
-34255,
-34188,
-31900,
-29433,
-29215,
-31734,
-35005,
-36399,
-34869,
-31687,
-28875,
-27480,
-27245,
-27680,
-28891,
-31023,
-33349,
-34460,
-33822,
-32588,
-32829,
-35265,
-38453,
-39807,
-37939,
-33659,
-29236,
-26704,
-26941,
-29594,
-33581,
-37313,
-39159,
-38205,
-34972,
-31312,
-29315,
-29852,
-31992,
-33630,
-33016,
-30007,
-26330,
-24447,
-25999,
-30545,
-35845,
-39177,
-39134,
-36311,
-32819,
-30636,
-30411,
-31199,
-31512,
-30677,
-29397,
-29086,
-30516,
-33099,
-35397,
-36395,
-36183,
-35524,
-34959,
-34269,
-33086,
-31348,
-29636,
-28528,
-28364,
-29057,
-30324,
-31778,
-32913,
-33427,
-33433,
-33435,
-33839,
-34377,
-34307,
-33145,
-31219,
-29670,
-29345,
-30268,
-31557,
-32346,
-32445,
-32419,
-32795,
-33580,
-34087,
-33789,
-32754,
-31759,
-31526,
-32045,
-32575,
-32283,
-31081,
-29728,
-29271,
-30155,
-31971,
-33753,
-34731,
-34825,
-34430,
-34084,
-33954,
-33860,
-33584,
-33137,
-32721,
-32625,
-32704,
-32717,
-32403,
-31915,
-31703,
-32059,
-32788,
-33267,
-33010,
-32134,
-31317,
-31222,
-31941,
-32947,
-33531,
-33314,
-32435,
-31431,
-30861,
-31166,
-32343,
-34007,
-35410,
-35897,
-35225,
-33805,
-32338,
-31425,
-31188,
-31338,
-31464,
-31364,
-31137,
-31037,
-31295,
-31910,
-32657,
-33224,
-33317,
-32904,
-32206,
-31664,
-31634,
-32145,
-32781,
-33077,
-32816,
-32268,
-31818,
-31667,
-31566,
-31386,
-31158,
-31282,
-31907,
-32769,
-33304,
-33148,
-32405,
-31547,
-31091,
-31244,
-31944,
-32740,
-33215,
-33057,
-32520,
-32177,
-32499,
-33448,
-34419,
-34881,
-34704,
-34198,
-33567,
-32856,
-32028,
-31396,
-31331,
-31820,
-32247,
-32002,
-31012,
-30106,
-29981,
-30766,
-31760,
-32332,
-32347,
-32216,
-32155,
-32187,
-32161,
-32317,
-32920,
-33893,
-34618,
-34417,
-33272,
-31891,
-31212,
-31588,
-32588,
-33438,
-33614,
-33124,
-32399,
-31748,
-31340,
-31058,
-30840,
-30777,
-31045,
-31762,
-32774,
-33736,
-34243,
-34122,
-33478,
-32737,
-32384,
-32787,
-33789,
-34823,
-35088,
-34243,
-32648,
-31164,
-30533,
-30793,
-31468,
-31962,
-32119,
-32050,
-31965,
-31880,
-31779,
-31758,
-31937,
-32328,
-32718,
-32900,
-32883,
-32862,
-33022,
-33293,
-33476,
-33418,
-33186,
-32951,
-32822,
-32755,
-32705,
-32663,
-32668,
-32693,
-32587,
-32290,
-31880,
-31630,
-31660,
-31887,
-32046,
-32060,
-32122,
-32507,
-33234,
-33929,
-34156,
-33800,
-33121,
-32563,
-32331,
-32374,
-32531,
-32652,
-32678,
-32515,
-32153,
-31788,
-31669,
-31978,
-32478,
-32755,
-32537,
-31947,
-31426,
-31315,
-31680,
-32298,
-32937,
-33397,
-33564,
-33381,
-32975,
-32678,
-32808,
-33353,
-33910,
-33965,
-33403,
-32624,
-32187,
-32292,
-32584,
-32558,
-32040,
-31405,
-31193,
-31694,
-32723,
-33871,
-34714,
-35002,
-34612,
-33624,
-32402,
-31516,
-31487,
-32348,
-33686,
-34736,
-34955,
-34166,
-32671,
-31157,
-30379,
-30910,
-32624,
-34778,
-36340,
-36692,
-35981,
-34816,
-33728,
-32812,
-31995,
-31308,
-31026,
-31270,
-31836,
-32291,
-32479,
-32562,
-32847,
-33341,
-33807,
-34043,
-34205,
-34446,
-34735,
-34660,
-34005,
-33037,
-32447,
-32663,
-33525,
-34333,
-34555,
-33978,
-32908,
-31655,
-30687,
-30435,
-31151,
-32599,
-33875,
-34096,
-32926,
-31063,
-29658,
-29596,
-30990,
-33248,
-35484,
-36814,
-36721,
-35175,
-32929,
-31118,
-30748,
-31994,
-34077,
-35841,
-36409,
-35732,
-34380,
-33038,
-32061,
-31332,
-30612,
-29912,
-29541,
-29824,
-30696,
-31675,
-32243,
-32251,
-31974,
-31808,
-32023,
-32679,
-33752,
-35027,
-36136,
-36557,
-36083,
-34887,
-33481,
-32271,
-31409,
-30910,
-30813,
-31080,
-31525,
-31830,
-31884,
-31801,
-31793,
-31894,
-32073,
-32481,
-33353,
-34677,
-35919,
-36345,
-35643,
-34112,
-32444,
-31109,
-30394,
-30328,
-30923,
-31863,
-32598,
-32705,
-32205,
-31752,
-31983,
-33275,
-35353,
-37473,
-38552,
-37624,
-34472,
-30066,
-26217,
-24606,
-25604,
-28285,
-30953,
-32452,
-32580,
-32143,
-32159,
-33182,
-34629,
-35125,
-33583,
-30273,
-27173,
-26336,
-28332,
-31580,
-33890,
-34362,
-33899,
-33800,
-34108,
-33687,
-31868,
-29574,
-28441,
-28974,
-29969,
-30167,
-29914,
-30686,
-32863,
-34608,
-33645,
-30029,
-26524,
-26004,
-28630,
-32037,
-33813,
-33502,
-32026,
-30187,
-28333,
-27079,
-27430,
-29550,
-31932,
-32483,
-30583,
-27801,
-26343,
-27252,
-29816,
-32562,
-34001,
-33280,
-30489,
-27294,
-26121,
-28101,
-31591,
-33211,
-31117,
-26992,
-24563,
-25949,
-29651,
-32171,
-31427,
-28523,
-26297,
-26475,
-28381,
-29951,
-30156,
-29534,
-29208,
-29161,
-28421,
-26800,
-25771,
-27056,
-30175,
-32294,
-31125,
-27645,
-25370,
-26517,
-29705,
-31759,
-31189,
-29386,
-28117,
-27484,
-26460,
-25213,
-25181,
-27101,
-29532,
-30471,
-29434,
-27744,
-26419,
-25284,
-24213,
-24253,
-26483,
-29817,
-31451,
-29982,
-27466,
-27250,
-29938,
-32367,
-31291,
-27159,
-23887,
-24491,
-28134,
-31298,
-31651,
-29803,
-27917,
-27173,
-27151,
-27203,
-27343,
-27958,
-28842,
-29289,
-28964,
-28367,
-28184,
-28476,
-28723,
-28559,
-28204,
-27988,
-27913,
-27760,
-27696,
-28058,
-28654,
-28712,
-27908,
-27310,
-28384,
-30901,
-32508,
-31106,
-27667,
-25469,
-26549,
-29111,
-29888,
-28112,
-26492,
-27464,
-29883,
-30553,
-28665,
-27005,
-28266,
-31073,
-31657,
-28867,
-25932,
-26448,
-29613,
-31453,
-30009,
-27898,
-28332,
-30591,
-30866,
-27744,
-24535,
-25242,
-29311,
-32329,
-31491,
-28680,
-27168,
-27155,
-26213,
-23914,
-23353,
-26889,
-31855,
-32727,
-27865,
-22199,
-21958,
-27450,
-32733,
-32361,
-27244,
-23038,
-23713,
-27848,
-31150,
-31100,
-28618,
-26088,
-24812,
-24677,
-25078,
-25708,
-26419,
-26977,
-26945,
-25961,
-24396,
-23427,
-24417,
-27044,
-28894,
-27584,
-23762,
-21227,
-23050,
-27864,
-31028,
-29750,
-26070,
-24036,
-24854,
-26005,
-25327,
-24046,
-24647,
-26912,
-27760,
-25527,
-22598,
-22516,
-25430,
-27840,
-27058,
-24275,
-22562,
-22895,
-23889,
-24509,
-25471,
-27016,
-27246,
-24515,
-20796,
-20526,
-25083,
-30071,
-29766,
-24092,
-19058,
-20005,
-25477,
-29381,
-28098,
-24007,
-21636,
-22334,
-23952,
-24659,
-25000,
-25890,
-26314,
-24788,
-22057,
-21172,
-23676,
-27386,
-28423,
-25397,
-20900,
-18877,
-21188,
-26246,
-30349,
-29989,
-24535,
-17654,
-15365,
-20878,
-30515,
-35891,
-31817,
-21639,
-14133,
-14761,
-21205,
-27177,
-29237,
-28395,
-26314,
-23111,
-19323,
-18068,
-22055,
-28699,
-31317,
-26250,
-18320,
-15991,
-22107,
-30410,
-32620,
-27144,
-19764,
-16648,
-18793,
-23250,
-27186,
-29252,
-28194,
-23604,
-18142,
-17058,
-22804,
-30833,
-33117,
-26569,
-17113,
-13867,
-19882,
-29326,
-33779,
-30064,
-22119,
-16562,
-17308,
-23584,
-30952,
-34031,
-30126,
-21648,
-15276,
-16688,
-25277,
-34147,
-35989,
-29538,
-20358,
-15938,
-19564,
-28281,
-35410,
-35507,
-28314,
-19263,
-15681,
-20891,
-31008,
-37803,
-35683,
-26549,
-18040,
-16907,
-23650,
-32617,
-36736,
-32958,
-24341,
-17982,
-19398,
-27855,
-36350,
-37491,
-30304,
-21310,
-18505,
-23938,
-32385,
-36782,
-34280,
-27711,
-22030,
-20827,
-24591,
-30892,
-35396,
-34387,
-28043,
-21369,
-20310,
-26234,
-34272,
-37893,
-34860,
-28703,
-24649,
-25115,
-28636,
-32192,
-33450,
-32034,
-29256,
-27618,
-28579,
-30972,
-31480,
-28276,
-23457,
-21649,
-24965,
-30593,
-33326,
-30662,
-25087,
-21292,
-22126,
-26559,
-31089,
-32273,
-28991,
-23422,
-19984,
-22165,
-29125,
-35533,
-35680,
-28693,
-19665,
-15613,
-19694,
-28866,
-36480,
-37107,
-30252,
-20531,
-14678,
-16987,
-25970,
-35144,
-37683,
-31761,
-21999,
-15647,
-17012,
-24584,
-32871,
-36546,
-33673,
-26221,
-18719,
-15681,
-19118,
-26776,
-33289,
-33983,
-29021,
-23459,
-22535,
-26230,
-29176,
-26650,
-20563,
-18056,
-23644,
-33111,
-36815,
-29720,
-17232,
-10490,
-15479,
-27607,
-36440,
-35412,
-26471,
-16965,
-13368,
-17514,
-26709,
-35635,
-38721,
-33567,
-23270,
-15335,
-16169,
-25614,
-36605,
-40879,
-35490,
-24833,
-16700,
-16480,
-23574,
-32382,
-36450,
-32984,
-24964,
-18793,
-19469,
-26236,
-33217,
-34242,
-28656,
-21990,
-21253,
-28011,
-36489,
-38656,
-31938,
-22120,
-17940,
-22823,
-31991,
-37481,
-35619,
-29045,
-22772,
-19590,
-19588,
-21935,
-25706,
-28888,
-29356,
-27239,
-25484,
-26254,
-27689,
-26019,
-21438,
-19503,
-24983,
-34851,
-40046,
-34896,
-23528,
-15720,
-17224,
-25370,
-33529,
-37281,
-35875,
-29935,
-21024,
-12993,
-11196,
-17820,
-28832,
-36967,
-37942,
-33174,
-26712,
-21293,
-18015,
-17962,
-22156,
-29329,
-35895,
-38661,
-37400,
-33741,
-28809,
-22937,
-17983,
-17321,
-22695,
-31206,
-37118,
-36686,
-30940,
-23613,
-17793,
-14956,
-16030,
-21423,
-29346,
-35502,
-35770,
-29618,
-20733,
-14285,
-13487,
-18171,
-25237,
-30638,
-31716,
-29043,
-25677,
-24218,
-24170,
-23304,
-21057,
-20173,
-23336,
-29300,
-33030,
-30920,
-24646,
-19711,
-19865,
-23965,
-27756,
-27997,
-24868,
-21035,
-19695,
-22457,
-28134,
-32819,
-32615,
-27234,
-21163,
-19925,
-24740,
-31162,
-33532,
-30505,
-26058,
-25004,
-28344,
-32850,
-34527,
-31914,
-26787,
-22273,
-20968,
-23389,
-27810,
-31332,
-31995,
-30302,
-28306,
-27478,
-27098,
-25743,
-23331,
-21905,
-23598,
-28467,
-34197,
-37652,
-37003,
-32398,
-25947,
-20737,
-19215,
-21639,
-25843,
-29096,
-30501,
-31284,
-32683,
-33808,
-32373,
-27515,
-21721,
-19151,
-22132,
-29106,
-35816,
-38585,
-36528,
-31714,
-27318,
-25582,
-26364,
-27680,
-27466,
-25744,
-24673,
-26436,
-30761,
-34669,
-35106,
-31654,
-26925,
-24257,
-25058,
-28156,
-31118,
-32203,
-31302,
-29872,
-29664,
-31609,
-34747,
-36932,
-36298,
-32844,
-28460,
-25306,
-24398,
-25166,
-26570,
-28072,
-29882,
-32306,
-35108,
-37087,
-36712,
-33038,
-27016,
-21430,
-19642,
-23116,
-30396,
-37914,
-42375,
-42537,
-39276,
-34373,
-29379,
-25259,
-22528,
-21693,
-23184,
-27200,
-33043,
-38711,
-41564,
-39892,
-34524,
-28551,
-25167,
-25327,
-27413,
-29037,
-29292,
-29192,
-30247,
-32809,
-35519,
-36575,
-34994,
-31495,
-27794,
-25598,
-25449,
-26672,
-28022,
-28744,
-29140,
-30050,
-31991,
-34392,
-35965,
-35642,
-33344,
-30121,
-27227,
-25655,
-25661,
-27182,
-29835,
-32881,
-35275,
-36100,
-35221,
-33360,
-31607,
-30761,
-31185,
-32865,
-35263,
-37118,
-36914,
-34116,
-30074,
-27344,
-27759,
-31169,
-35840,
-39957,
-42310,
-42026,
-38475,
-31877,
-24199,
-18246,
-15963,
-17368,
-21137,
-26266,
-32155,
-37955,
-41908,
-42213,
-38453,
-31972,
-25043,
-19748,
-17383,
-18384,
-22169,
-27290,
-32231,
-36244,
-39374,
-41497,
-41515,
-38224,
-31737,
-24276,
-18719,
-16581,
-17118,
-18747,
-20880,
-24572,
-30726,
-38329,
-44181,
-45253,
-41063,
-34101,
-27592,
-23128,
-20220,
-17975,
-16666,
-17457,
-21026,
-26626,
-32724,
-37921,
-41376,
-42577,
-41141,
-37145,
-31132,
-24077,
-17340,
-12620,
-11542,
-14410,
-19874,
-25841,
-31475,
-37150,
-42856,
-46236,
-44186,
-35882,
-24652,
-15478,
-11093,
-10668,
-12091,
-15021,
-20630,
-29189,
-38411,
-44941,
-46861,
-44661,
-39729,
-33150,
-25661,
-18564,
-13556,
-11535,
-12261,
-15027,
-19815,
-26811,
-35104,
-42209,
-45626,
-44534,
-40133,
-34039,
-27011,
-19649,
-13290,
-9987,
-10522,
-13561,
-17138,
-20842,
-25990,
-32960,
-39466,
-42029,
-39452,
-33941,
-28474,
-23802,
-18613,
-12592,
-7716,
-6355,
-8655,
-12918,
-18287,
-25479,
-34503,
-42652,
-46242,
-44536,
-40534,
-37364,
-34668,
-29698,
-21711,
-13975,
-10423,
-11520,
-14277,
-16482,
-19439,
-25747,
-35159,
-43868,
-48021,
-47290,
-44174,
-40707,
-36544,
-30522,
-23113,
-16521,
-12771,
-12224,
-14357,
-19115,
-26720,
-36168,
-44597,
-48955,
-48458,
-44883,
-40410,
-35507,
-29093,
-21201,
-13919,
-10097,
-10546,
-13805,
-18335,
-24297,
-32387,
-41361,
-47888,
-49504,
-47045,
-43252,
-39246,
-33507,
-24916,
-15783,
-10517,
-11218,
-15679,
-20450,
-24875,
-30970,
-39489,
-47619,
-51552,
-50596,
-47283,
-43701,
-38935,
-31263,
-21868,
-14842,
-13167,
-15627,
-18864,
-21421,
-25161,
-31962,
-40585,
-47436,
-50181,
-49569,
-47505,
-44267,
-38544,
-29995,
-20867,
-14396,
-12008,
-12428,
-13795,
-15948,
-20446,
-28123,
-37282,
-44399,
-46903,
-45261,
-42038,
-39362,
-37060,
-33605,
-28641,
-24158,
-22920,
-25916,
-31142,
-35437,
-36806,
-35533,
-33137,
-30833,
-28984,
-27369,
-25934,
-25050,
-25668,
-28776,
-34420,
-40829,
-45206,
-45799,
-43586,
-41272,
-40481,
-40046,
-37516,
-32166,
-26123,
-22308,
-21609,
-22564,
-23449,
-24266,
-26328,
-30427,
-35998,
-41676,
-46416,
-49436,
-50053,
-47829,
-43374,
-38087,
-33186,
-28729,
-24228,
-19785,
-16550,
-15742,
-17552,
-21161,
-25572,
-30307,
-35155,
-39724,
-43334,
-45318,
-45384,
-43596,
-40410,
-36330,
-31656,
-26314,
-20361,
-14655,
-10848,
-10250,
-12679,
-16534,
-20244,
-23525,
-27094,
-31472,
-36058,
-39595,
-41163,
-40628,
-38655,
-36255,
-34418,
-33527,
-32996,
-31629,
-28746,
-24855,
-21147,
-18480,
-16844,
-16214,
-17000,
-19772,
-24224,
-29189,
-33531,
-37140,
-40374,
-43190,
-44831,
-44724,
-43344,
-41717,
-40439,
-39134,
-37101,
-34070,
-30326,
-26286,
-22476,
-19782,
-19455,
-22236,
-27582,
-33772,
-39015,
-42560,
-44655,
-45903,
-46542,
-46519,
-45617,
-43688,
-40383,
-35701,
-30268,
-25535,
-22813,
-22241,
-22702,
-23023,
-23261,
-24706,
-28401,
-33903,
-39434,
-43288,
-45049,
-45375,
-45171,
-44710,
-43607,
-41211,
-37075,
-31663,
-26281,
-22557,
-21037,
-20854,
-20624,
-20174,
-20770,
-23663,
-28469,
-33386,
-37188,
-40232,
-43716,
-47679,
-50649,
-51057,
-48661,
-44591,
-40085,
-35679,
-31424,
-27315,
-23502,
-20271,
-18324,
-18715,
-22026,
-27502,
-33088,
-37036,
-39179,
-40766,
-42959,
-45726,
-47946,
-48522,
-46997,
-43673,
-39235,
-34400,
-29628,
-25120,
-21238,
-18755,
-18424,
-20141,
-22720,
-25049,
-27169,
-29855,
-33257,
-36193,
-37685,
-38242,
-39356,
-41188,
-41834,
-39336,
-34269,
-29412,
-27030,
-26624,
-26247,
-24895,
-23392,
-22881,
-23434,
-24561,
-26208,
-28537,
-31009,
-32649,
-33479,
-34947,
-37949,
-41177,
-41944,
-39324,
-35484,
-33333,
-33665,
-34686,
-34862,
-34493,
-34728,
-35373,
-35027,
-33139,
-30953,
-30011,
-30113,
-29632,
-27528,
-24506,
-21970,
-20655,
-20553,
-21914,
-24958,
-28928,
-31674,
-31452,
-28667,
-25787,
-25018,
-26541,
-28679,
-29607,
-28585,
-25872,
-22421,
-19285,
-17574,
-17706,
-19392,
-21857,
-24632,
-27634,
-30823,
-33808,
-36066,
-37243,
-37186,
-35948,
-33803,
-31546,
-30056,
-29632,
-29791,
-29917,
-30044,
-30685,
-31876,
-32866,
-32886,
-32209,
-31935,
-32773,
-34101,
-34625,
-33730,
-32128,
-31224,
-31759,
-33385,
-34802,
-34943,
-33640,
-31899,
-31146,
-31870,
-33017,
-32777,
-30402,
-27064,
-24740,
-24083,
-23849,
-22528,
-20538,
-20176,
-23315,
-29254,
-35167,
-38815,
-40157,
-40589,
-40561,
-38859,
-34356,
-27954,
-22465,
-20103,
-20516,
-21420,
-20882,
-19091,
-17515,
-17346,
-18280,
-19293,
-19442,
-18796,
-18214,
-19149,
-22657,
-28534,
-34974,
-39848,
-42320,
-43421,
-44431,
-45235,
-44371,
-41032,
-36392,
-32663,
-31069,
-31085,
-31732,
-32782,
-34468,
-36247,
-36866,
-35708,
-33684,
-32267,
-31779,
-31301,
-30148,
-29030,
-29387,
-31660,
-34957,
-38070,
-40641,
-42860,
-44439,
-44535,
-42528,
-38823,
-34361,
-29806,
-25272,
-20862,
-17029,
-14172,
-12396,
-11560,
-11876,
-13656,
-16641,
-19649,
-21494,
-22194,
-23255,
-26284,
-31511,
-37469,
-42408,
-45464,
-46924,
-47179,
-46251,
-44127,
-41433,
-39156,
-37542,
-35653,
-32145,
-26858,
-21171,
-16720,
-14041,
-12403,
-11222,
-10936,
-12365,
-15412,
-18847,
-21682,
-24328,
-28127,
-33387,
-38570,
-41359,
-40966,
-38887,
-37723,
-38804,
-41655,
-44522,
-46191,
-46447,
-45779,
-44724,
-43500,
-42142,
-40461,
-38252,
-35370,
-32059,
-28795,
-25820,
-22900,
-19734,
-16736,
-15242,
-16359,
-19719,
-23346,
-25305,
-25491,
-25742,
-27913,
-31974,
-35944,
-37560,
-36082,
-32322,
-27958,
-24519,
-23287,
-24734,
-28105,
-31354,
-32652,
-31801,
-30338,
-29767,
-29939,
-29517,
-27700,
-25252,
-23462,
-22640,
-21954,
-20805,
-19632,
-19349,
-20109,
-21449,
-23110,
-25537,
-28830,
-31859,
-32937,
-31619,
-29409,
-28447,
-29365,
-30970,
-31747,
-31656,
-31974,
-33744,
-36469,
-38770,
-39710,
-39865,
-40312,
-41423,
-42110,
-41038,
-37924,
-34160,
-31465,
-30371,
-29805,
-28480,
-26407,
-24994,
-25667,
-28334,
-31501,
-33544,
-33919,
-33290,
-32713,
-32949,
-34166,
-36123,
-38339,
-40217,
-41217,
-40928,
-39348,
-37057,
-35078,
-34124,
-33753,
-32496,
-29132,
-24199,
-19694,
-17416,
-17380,
-18185,
-18761,
-19230,
-20240,
-21737,
-23093,
-24082,
-25320,
-27387,
-29988,
-32378,
-34348,
-36429,
-38816,
-40833,
-41551,
-40914,
-39752,
-38569,
-37173,
-35129,
-32944,
-31611,
-31637,
-32553,
-33453,
-33894,
-33715,
-32622,
-30482,
-27869,
-26144,
-26207,
-27584,
-28952,
-29558,
-29997,
-31357,
-33918,
-37044,
-39763,
-41783,
-43122,
-43965,
-44312,
-44339,
-44266,
-44193,
-43888,
-43026,
-41408,
-39135,
-36347,
-33342,
-30444,
-28308,
-27597,
-28852,
-31711,
-34817,
-36266,
-35023,
-31850,
-28782,
-27213,
-26769,
-25894,
-23875,
-21531,
-20117,
-19991,
-20484,
-21415,
-23324,
-26614,
-30435,
-33367,
-35042,
-36534,
-38882,
-41772,
-44031,
-45266,
-46317,
-47837,
-49090,
-48547,
-45667,
-41457,
-37265,
-33556,
-29925,
-26274,
-22931,
-20232,
-18031,
-16400,
-15960,
-17230,
-19603,
-21516,
-22090,
-22103,
-23170,
-25951,
-29486,
-32487,
-34474,
-35749,
-36357,
-35898,
-34625,
-33981,
-35715,
-40139,
-45523,
-49520,
-50930,
-50248,
-48765,
-47202,
-45469,
-42831,
-38739,
-33046,
-26363,
-19916,
-14893,
-11918,
-10634,
-10357,
-10597,
-11337,
-12574,
-14185,
-15953,
-17957,
-20356,
-23130,
-25999,
-28738,
-31379,
-33960,
-36181,
-37662,
-38275,
-38414,
-38292,
-37644,
-36099,
-33863,
-31887,
-30981,
-31145,
-31927,
-33172,
-35036,
-37083,
-37796,
-35784,
-31255,
-26299,
-23049,
-21965,
-21920,
-21830,
-21798,
-22325,
-23266,
-23595,
-22803,
-21621,
-21341,
-22447,
-24065,
-24815,
-24028,
-22101,
-20137,
-19417,
-20744,
-24175,
-28597,
-32468,
-34702,
-35639,
-36578,
-38561,
-41541,
-44406,
-46030,
-45809,
-43796,
-40291,
-35976,
-31849,
-29237,
-28977,
-30750,
-33033,
-34053,
-33140,
-31221,
-29992,
-30309,
-31365,
-31408,
-29390,
-25745,
-21930,
-18919,
-16736,
-14909,
-13416,
-12863,
-13926,
-16772,
-20963,
-25705,
-30097,
-33441,
-35537,
-36831,
-38013,
-39190,
-39665,
-38613,
-36089,
-33482,
-32369,
-33344,
-35399,
-36936,
-37149,
-36613,
-36696,
-38156,
-40549,
-42524,
-42944,
-41567,
-38880,
-35544,
-31981,
-28474,
-25337,
-22796,
-20819,
-19409,
-18982,
-20341,
-23871,
-28768,
-33352,
-36330,
-37782,
-38777,
-40079,
-41336,
-41500,
-39992,
-37161,
-34019,
-31395,
-29726,
-28844,
-28344,
-27531,
-26021,
-23908,
-21836,
-20552,
-20462,
-21553,
-23441,
-25535,
-27097,
-27754,
-27839,
-28316,
-29907,
-32454,
-35077,
-37200,
-39108,
-41388,
-44083,
-46496,
-48019,
-48809,
-49502,
-50359,
-51000,
-51031,
-50668,
-50600,
-51189,
-52016,
-52273,
-51398,
-49367,
-46484,
-43267,
-40192,
-37734,
-35838,
-34059,
-31869,
-29241,
-26615,
-24483,
-22987,
-22200,
-22377,
-23858,
-26508,
-29541,
-32189,
-34229,
-36111,
-37986,
-39445,
-39760,
-38820,
-37239,
-35826,
-34972,
-34729,
-35266,
-36914,
-39866,
-43669,
-47479,
-50517,
-52380,
-53122,
-53003,
-52327,
-51247,
-49533,
-46845,
-43250,
-39433,
-36369,
-34363,
-32879,
-31205,
-29377,
-28164,
-28252,
-29371,
-30589,
-30963,
-30254,
-28696,
-26954,
-25642,
-25241,
-25402,
-25260,
-24137,
-22655,
-22367,
-24244,
-27458,
-30188,
-31567,
-32764,
-35653,
-40640,
-46207,
-50318,
-52375,
-53156,
-53618,
-53819,
-53425,
-52487,
-51736,
-51820,
-52866,
-54342,
-55478,
-55476,
-54113,
-51887,
-49891,
-48459,
-46682,
-43095,
-37659,
-32175,
-28646,
-27117,
-25819,
-23642,
-21586,
-21477,
-23140,
-24353,
-23396,
-21527,
-21619,
-24638,
-28407,
-29980,
-28877,
-27216,
-26855,
-27745,
-28961,
-30751,
-34147,
-39062,
-43484,
-45544,
-45456,
-45110,
-45639,
-46395,
-46242,
-45263,
-44300,
-43593,
-42266,
-39876,
-37073,
-34918,
-33252,
-31260,
-28781,
-27095,
-27280,
-28913,
-30435,
-31115,
-31588,
-32765,
-34471,
-35881,
-36754,
-37573,
-38457,
-38598,
-37246,
-35003,
-33448,
-33485,
-34425,
-34889,
-34332,
-33465,
-33384,
-34615,
-36943,
-39546,
-41212,
-40841,
-38224,
-34421,
-31084,
-29048,
-28079,
-27550,
-27442,
-28026,
-29162,
-30218,
-30871,
-31656,
-33046,
-34638,
-35233,
-34251,
-32356,
-30810,
-30094,
-29843,
-29703,
-29945,
-31036,
-32782,
-34428,
-35461,
-36140,
-36965,
-38090,
-39098,
-39479,
-38880,
-37046,
-34036,
-30515,
-27792,
-26911,
-27717,
-29030,
-29959,
-31040,
-33531,
-37780,
-42160,
-44236,
-42855,
-39066,
-35156,
-32454,
-30753,
-28904,
-26535,
-24326,
-23320,
-23803,
-24935,
-25528,
-25017,
-23960,
-23775,
-25453,
-28845,
-32404,
-34481,
-34422,
-32959,
-31272,
-30027,
-29435,
-29843,
-31956,
-35755,
-39932,
-42523,
-42859,
-42228,
-42625,
-44579,
-46692,
-47194,
-45584,
-42834,
-40187,
-38486,
-38337,
-40174,
-43530,
-46608,
-47282,
-45001,
-41325,
-38398,
-36875,
-35792,
-34081,
-31890,
-29965,
-28421,
-26397,
-23451,
-20291,
-18488,
-18799,
-20590,
-22445,
-23413,
-23695,
-24199,
-25700,
-28060,
-30196,
-30920,
-29893,
-28062,
-26852,
-26953,
-27843,
-28383,
-27822,
-26204,
-24235,
-22765,
-22739,
-24628,
-28185,
-32478,
-36342,
-39064,
-40294,
-39959,
-38447,
-36759,
-35979,
-36025,
-35445,
-32808,
-28641,
-25259,
-24746,
-26964,
-30294,
-33496,
-36534,
-39359,
-40910,
-40095,
-37450,
-34991,
-34157,
-34288,
-33718,
-31727,
-29061,
-26634,
-24771,
-23940,
-25427,
-30061,
-36319,
-40668,
-40481,
-36662,
-32623,
-31184,
-32333,
-34275,
-35530,
-35736,
-35010,
-33496,
-31870,
-31457,
-33253,
-36590,
-39478,
-40174,
-38469,
-35304,
-31744,
-28380,
-25741,
-24278,
-24096,
-24477,
-24608,
-24306,
-24327,
-25559,
-28137,
-31293,
-34002,
-35741,
-36774,
-37680,
-38781,
-39602,
-39435,
-37989,
-35948,
-34374,
-33742,
-33686,
-33583,
-33484,
-33896,
-35016,
-36424,
-37521,
-38330,
-39140,
-39809,
-39640,
-38169,
-35886,
-33716,
-32034,
-30469,
-28808,
-27840,
-28632,
-31380,
-34717,
-36890,
-36871,
-34855,
-31596,
-27933,
-24761,
-22938,
-22891,
-24173,
-25699,
-26697,
-27015,
-27112,
-27375,
-28142,
-29468,
-31094,
-32151,
-31681,
-29649,
-27330,
-26521,
-28041,
-31132,
-34201,
-36100,
-36680,
-36385,
-35892,
-35810,
-36535,
-37762,
-38471,
-37673,
-35532,
-33519,
-33162,
-34770,
-37215,
-39097,
-39714,
-39088,
-37214,
-34082,
-30001,
-26001,
-23213,
-22011,
-21987,
-22495,
-23322,
-24513,
-25972,
-27552,
-29449,
-32172,
-35737,
-39016,
-40393,
-39098,
-35947,
-32474,
-29513,
-27056,
-25160,
-24604,
-26070,
-28905,
-31408,
-32624,
-33451,
-35452,
-38578,
-40691,
-39738,
-36037,
-32112,
-30056,
-29856,
-30080,
-29895,
-29662,
-29878,
-30265,
-30396,
-30596,
-31635,
-33541,
-35158,
-35323,
-33878,
-31544,
-28921,
-26521,
-25245,
-26237,
-29392,
-32707,
-33705,
-32145,
-30141,
-29934,
-31211,
-31852,
-30790,
-29600,
-30683,
-34238,
-37570,
-37777,
-34510,
-30469,
-28997,
-31622,
-37228,
-43088,
-46829,
-47616,
-46569,
-45496,
-45579,
-46571,
-47518,
-47611,
-46765,
-44936,
-42160,
-38649,
-35359,
-33380,
-33339,
-34950,
-37623,
-40586,
-42892,
-43382,
-41506,
-38068,
-34638,
-32069,
-29760,
-26764,
-23426,
-21246,
-21295,
-22789,
-24076,
-24433,
-24727,
-26132,
-28619,
-30930,
-31870,
-31244,
-29791,
-28382,
-27632,
-27610,
-28072,
-28670,
-29525,
-31142,
-33745,
-36371,
-37425,
-36186,
-33958,
-33111,
-34853,
-38050,
-40336,
-40250,
-38242,
-35826,
-33992,
-32804,
-31747,
-30773,
-30430,
-31413,
-33703,
-36153,
-37139,
-36062,
-34110,
-33472,
-35222,
-38330,
-40783,
-41587,
-41457,
-41315,
-41101,
-40183,
-38899,
-38750,
-40555,
-43275,
-44778,
-44300,
-43043,
-42635,
-43235,
-43908,
-44366,
-45580,
-48219,
-51120,
-52128,
-50486,
-47879,
-46665,
-47261,
-47934,
-46973,
-44819,
-43599,
-44742,
-47416,
-49301,
-48598,
-45310,
-40781,
-36502,
-33398,
-31654,
-31023,
-31004,
-31125,
-31234,
-31495,
-32028,
-32671,
-33028,
-32795,
-31989,
-30821,
-29719,
-29272,
-29921,
-31305,
-31958,
-30359,
-26540,
-22773,
-21945,
-25146,
-30716,
-35810,
-38713,
-39585,
-39457,
-39108,
-38993,
-39575,
-40955,
-42261,
-42260,
-40587,
-38391,
-36913,
-36065,
-34820,
-32970,
-31874,
-32705,
-34883,
-36558,
-37016,
-37283,
-38252,
-38913,
-37475,
-34126,
-31701,
-32615,
-36244,
-39438,
-40060,
-38680,
-37059,
-35906,
-34982,
-34733,
-36406,
-39917,
-42920,
-42653,
-39142,
-35298,
-34087,
-35764,
-38449,
-40431,
-41546,
-42304,
-43011,
-43674,
-44531,
-45447,
-45699,
-44578,
-42676,
-41718,
-42684,
-44639,
-45523,
-44193,
-40901,
-36536,
-31974,
-28741,
-28841,
-33005,
-38896,
-42491,
-41627,
-38067,
-35191,
-34306,
-33846,
-32275,
-30389,
-30394,
-32769,
-35861,
-37738,
-38280,
-38254,
-37797,
-36452,
-34747,
-34426,
-36418,
-39486,
-41495,
-42059,
-42721,
-44377,
-45352,
-43055,
-37445,
-31886,
-30166,
-32876,
-37286,
-40318,
-41217,
-41104,
-40915,
-40526,
-39577,
-38678,
-38756,
-39942,
-41283,
-42166,
-43255,
-45744,
-49308,
-51640,
-50394,
-45863,
-41332,
-40149,
-42906,
-47127,
-50094,
-51112,
-51164,
-50990,
-50168,
-48309,
-45885,
-43655,
-41229,
-37683,
-33324,
-30676,
-32203,
-37606,
-43614,
-46801,
-46660,
-45101,
-44097,
-43654,
-42659,
-40654,
-38621,
-38048,
-39604,
-42677,
-45587,
-46520,
-44417,
-39932,
-35183,
-32658,
-33405,
-36517,
-39674,
-40789,
-39125,
-35659,
-32186,
-29940,
-28622,
-27216,
-25510,
-24955,
-26964,
-30821,
-33759,
-33894,
-32647,
-33318,
-37151,
-41461,
-42364,
-38995,
-34294,
-31496,
-31098,
-31280,
-31026,
-31202,
-32829,
-35185,
-36441,
-35863,
-34257,
-32787,
-31744,
-31242,
-32048,
-34712,
-38209,
-40037,
-38753,
-35491,
-32786,
-31850,
-31622,
-30826,
-29774,
-30102,
-32370,
-35187,
-36492,
-35556,
-33439,
-31802,
-31735,
-33431,
-36233,
-38610,
-38671,
-35402,
-29918,
-25058,
-23316,
-25010,
-28195,
-30526,
-30971,
-30209,
-29760,
-30864,
-33894,
-38265,
-42600,
-45251,
-45199,
-42615,
-39001,
-36110,
-34899,
-34950,
-35240,
-35167,
-35326,
-36716,
-39597,
-43003,
-45406,
-46090,
-45356,
-43847,
-41669,
-38614,
-35101,
-32290,
-31239,
-31724,
-32562,
-32927,
-33283,
-34631,
-36836,
-38074,
-36228,
-31203,
-25699,
-23570,
-26544,
-32604,
-37110,
-36727,
-32060,
-27207,
-25793,
-27789,
-29884,
-29351,
-26884,
-25852,
-28398,
-33398,
-37857,
-40141,
-40978,
-41531,
-41511,
-39602,
-35618,
-31106,
-27938,
-26607,
-26518,
-27343,
-29299,
-32271,
-35150,
-36975,
-37790,
-38014,
-36957,
-33070,
-26390,
-19863,
-17363,
-19867,
-24412,
-27201,
-27277,
-26694,
-27425,
-29240,
-30862,
-32233,
-34310,
-37030,
-38435,
-36757,
-32687,
-28949,
-27589,
-28532,
-30610,
-33129,
-35825,
-37880,
-38380,
-37852,
-38225,
-40526,
-42995,
-42605,
-38862,
-34889,
-34530,
-38142,
-42250,
-42979,
-39456,
-34040,
-30004,
-29437,
-32407,
-36894,
-39605,
-38311,
-34204,
-31732,
-34358,
-40631,
-44733,
-42000,
-33564,
-25167,
-21787,
-23563,
-27054,
-28832,
-28065,
-25975,
-24552,
-25475,
-28975,
-32967,
-33892,
-30015,
-24013,
-21391,
-25157,
-32336,
-36412,
-33763,
-27167,
-23075,
-25347,
-31996,
-37459,
-37736,
-33504,
-29233,
-29337,
-34486,
-40928,
-43084,
-38594,
-30734,
-26274,
-29350,
-37094,
-41829,
-37870,
-27233,
-18052,
-17619,
-26212,
-37097,
-42379,
-39057,
-30723,
-24281,
-24441,
-30579,
-37361,
-39140,
-34491,
-27521,
-24540,
-28243,
-35119,
-38219,
-33801,
-25180,
-20015,
-23329,
-32684,
-40415,
-40428,
-33524,
-26240,
-24996,
-30716,
-38529,
-42071,
-38659,
-31295,
-26199,
-27776,
-35035,
-42285,
-43917,
-39429,
-33843,
-33251,
-38920,
-45864,
-47136,
-40079,
-28940,
-21541,
-23066,
-31976,
-41372,
-44430,
-39695,
-32155,
-28984,
-33494,
-42130,
-47563,
-45013,
-36481,
-28661,
-26909,
-30745,
-35187,
-35930,
-33569,
-32662,
-37257,
-46807,
-56164,
-59414,
-54507,
-44957,
-37217,
-35814,
-39665,
-43463,
-42430,
-36914,
-31987,
-32543,
-38358,
-44281,
-45161,
-40924,
-36394,
-36385,
-40990,
-45656,
-45786,
-41094,
-35611,
-34143,
-38136,
-44912,
-49632,
-48552,
-41468,
-31993,
-25628,
-25947,
-31778,
-37715,
-38530,
-33832,
-28378,
-27571,
-32092,
-37277,
-37601,
-32101,
-25347,
-23443,
-28732,
-37783,
-44123,
-42993,
-35208,
-26590,
-24060,
-30247,
-41360,
-49886,
-50561,
-44456,
-37809,
-36461,
-41089,
-46981,
-48297,
-43110,
-34822,
-29594,
-31443,
-39110,
-46957,
-49392,
-45334,
-38967,
-35996,
-38637,
-43895,
-46176,
-42232,
-33781,
-26465,
-25966,
-33944,
-46362,
-55438,
-54859,
-44728,
-32312,
-26573,
-31017,
-40793,
-47314,
-45656,
-38351,
-32254,
-32513,
-38998,
-47133,
-51372,
-48518,
-39614,
-29865,
-25877,
-30808,
-41557,
-50410,
-51279,
-44280,
-35040,
-29516,
-29786,
-34059,
-39223,
-42625,
-42490,
-38455,
-32935,
-30657,
-35189,
-44915,
-52965,
-52429,
-42086,
-27769,
-17722,
-16762,
-23481,
-32336,
-37790,
-37913,
-35056,
-33775,
-36949,
-43157,
-47238,
-44651,
-35393,
-24660,
-18910,
-21222,
-29532,
-38470,
-42966,
-40847,
-33776,
-26434,
-23863,
-28252,
-36680,
-43082,
-42735,
-36500,
-29892,
-28309,
-32239,
-37310,
-38543,
-34699,
-28739,
-24661,
-24304,
-26770,
-30275,
-33829,
-37088,
-39341,
-39328,
-36420,
-31883,
-28235,
-27240,
-28333,
-29186,
-28052,
-25492,
-23831,
-25161,
-29421,
-34421,
-37320,
-36375,
-31897,
-26153,
-22035,
-21567,
-24793,
-29961,
-34861,
-37961,
-38629,
-36835,
-33011,
-28689,
-26230,
-27526,
-32194,
-37437,
-40262,
-40140,
-39418,
-40962,
-45061,
-48848,
-48862,
-44268,
-37665,
-32710,
-30969,
-31246,
-31730,
-32482,
-35279,
-41021,
-47609,
-51137,
-49302,
-43581,
-38056,
-35743,
-36726,
-38834,
-40354,
-41281,
-42537,
-44422,
-46011,
-45834,
-43163,
-38280,
-32488,
-27371,
-24377,
-24519,
-27934,
-33875,
-40552,
-45877,
-48403,
-48139,
-46461,
-44845,
-43805,
-42609,
-40305,
-36678,
-32799,
-30492,
-31319,
-35320,
-40286,
-42919,
-41539,
-38183,
-37288,
-41236,
-47316,
-49838,
-46089,
-39529,
-36411,
-38997,
-43163,
-43023,
-37358,
-30794,
-28662,
-32023,
-37678,
-42354,
-45298,
-47405,
-49005,
-49656,
-49101,
-47622,
-45016,
-40781,
-35610,
-32049,
-32480,
-36469,
-40887,
-43176,
-43757,
-44531,
-45786,
-45660,
-43034,
-39925,
-39487,
-42399,
-45622,
-46116,
-44220,
-43337,
-45598,
-49267,
-50269,
-46320,
-39020,
-32509,
-30272,
-33047,
-38480,
-42717,
-42921,
-39560,
-36340,
-37049,
-41914,
-47121,
-48491,
-45448,
-40891,
-37547,
-35126,
-31866,
-27982,
-26473,
-29661,
-36149,
-41454,
-42350,
-39419,
-35539,
-32674,
-30727,
-29335,
-29230,
-31122,
-33600,
-33410,
-28636,
-21427,
-17158,
-20188,
-30046,
-41386,
-47763,
-46282,
-39564,
-33675,
-33361,
-38462,
-44133,
-44932,
-39107,
-29589,
-21206,
-17360,
-18833,
-24909,
-34060,
-43678,
-50094,
-50653,
-45970,
-39925,
-36089,
-34955,
-34056,
-31399,
-27407,
-23834,
-21385,
-19380,
-17966,
-19397,
-26407,
-38698,
-51602,
-58155,
-53876,
-39911,
-23129,
-12103,
-11826,
-20263,
-30146,
-34730,
-33013,
-29615,
-29627,
-34043,
-40091,
-45035,
-48654,
-51461,
-52510,
-49915,
-43928,
-37785,
-34935,
-35760,
-37958,
-39749,
-41523,
-44102,
-46482,
-46567,
-44101,
-41419,
-40908,
-42176,
-42678,
-41074,
-38661,
-37693,
-38519,
-39548,
-39532,
-38832,
-38276,
-37395,
-34864,
-30828,
-27806,
-28729,
-33807,
-39751,
-42416,
-40327,
-35927,
-33253,
-34616,
-38883,
-43071,
-44946,
-44394,
-42146,
-38124,
-31504,
-22770,
-15013,
-12325,
-16557,
-25667,
-35588,
-43089,
-46868,
-46278,
-40735,
-31216,
-21838,
-18175,
-22547,
-31269,
-37238,
-36273,
-30633,
-26379,
-27428,
-32478,
-37385,
-39315,
-38258,
-35096,
-29896,
-22758,
-15585,
-11683,
-13119,
-18904,
-26354,
-33403,
-39166,
-42333,
-40543,
-32800,
-21935,
-13612,
-11871,
-15814,
-21020,
-23928,
-24344,
-24305,
-25457,
-28376,
-32814,
-37821,
-41133,
-40401,
-35822,
-30852,
-29255,
-31007,
-32519,
-31026,
-28051,
-27127,
-28845,
-29644,
-26340,
-20606,
-17727,
-20769,
-27606,
-33695,
-36962,
-38486,
-39482,
-38841,
-35148,
-29271,
-24394,
-22731,
-23784,
-25391,
-26208,
-26025,
-24785,
-22496,
-20321,
-20680,
-24938,
-31115,
-34915,
-33614,
-28785,
-24772,
-24426,
-26794,
-28814,
-28915,
-28460,
-29658,
-32682,
-35229,
-35048,
-32686,
-31121,
-32727,
-36627,
-39666,
-39828,
-38382,
-38095,
-39863,
-41523,
-40639,
-37383,
-34371,
-33374,
-33386,
-32182,
-29402,
-27299,
-28286,
-32366,
-37317,
-40944,
-42705,
-43454,
-43898,
-44072,
-43311,
-41080,
-37674,
-34716,
-34377,
-37306,
-40885,
-40641,
-34265,
-24766,
-19027,
-22088,
-32906,
-44898,
-51293,
-49888,
-43861,
-38352,
-36199,
-36312,
-35583,
-32985,
-31489,
-35653,
-46163,
-57445,
-61593,
-56091,
-46635,
-41810,
-44589,
-49987,
-51381,
-47703,
-43672,
-43241,
-44992,
-44569,
-40820,
-37410,
-38614,
-44212,
-49542,
-49860,
-43997,
-34604,
-25970,
-21806,
-23664,
-29932,
-36896,
-41605,
-44459,
-48006,
-52764,
-55436,
-51847,
-42550,
-33353,
-30344,
-33939,
-39119,
-40824,
-38735,
-36266,
-36263,
-38296,
-40170,
-40812,
-41111,
-42501,
-45040,
-47237,
-47123,
-44095,
-39791,
-37547,
-39896,
-46223,
-52753,
-55683,
-54191,
-50862,
-48514,
-47808,
-47512,
-46571,
-45195,
-43656,
-41424,
-37881,
-33713,
-30681,
-29946,
-31041,
-32786,
-34627,
-36847,
-39721,
-43069,
-46430,
-48700,
-47876,
-42315,
-33425,
-26635,
-27435,
-35790,
-44964,
-47475,
-42466,
-35861,
-33640,
-35387,
-35954,
-32324,
-27235,
-25605,
-28728,
-33232,
-35291,
-34338,
-32434,
-31637,
-32640,
-35397,
-39031,
-41287,
-39769,
-35111,
-31676,
-33637,
-39558,
-42856,
-38802,
-30316,
-25698,
-29677,
-38225,
-42402,
-37124,
-25305,
-14298,
-9658,
-12334,
-20073,
-29410,
-36859,
-39976,
-39071,
-36818,
-35580,
-34583,
-31404,
-25954,
-21952,
-23106,
-28094,
-31508,
-29670,
-25246,
-24070,
-28340,
-34076,
-35945,
-33545,
-31273,
-32831,
-36874,
-39196,
-37824,
-34858,
-33341,
-34096,
-36035,
-38777,
-42931,
-47987,
-50811,
-48056,
-39551,
-29161,
-21683,
-19572,
-22010,
-26518,
-30471,
-31977,
-30777,
-28913,
-29795,
-35012,
-42094,
-46037,
-44141,
-39070,
-36493,
-39452,
-45237,
-48174,
-45242,
-38457,
-32159,
-28477,
-26283,
-24171,
-23423,
-26952,
-35268,
-44362,
-48573,
-46152,
-41445,
-41126,
-47911,
-58129,
-65375,
-65533,
-63003,
-59207,
-56827,
-54712,
-51241,
-46690,
-42735,
-40555,
-39776,
-39442,
-39111,
-39019,
-39653,
-41235,
-43615,
-45864,
-46414,
-44542,
-41865,
-41786,
-46275,
-52848,
-55964,
-52109,
-43723,
-37577,
-38655,
-45700,
-52740,
-54372,
-49902,
-42819,
-37390,
-35943,
-38316,
-42545,
-46143,
-47222,
-45875,
-44200,
-44550,
-47280,
-50052,
-50209,
-47445,
-44488,
-44472,
-47781,
-51497,
-52047,
-48591,
-43594,
-40320,
-39551,
-39143,
-36849,
-33354,
-32287,
-36715,
-45380,
-52586,
-52255,
-42983,
-29945,
-21769,
-24305,
-36114,
-49027,
-54249,
-49133,
-39106,
-32545,
-33426,
-38481,
-41598,
-40297,
-37236,
-35778,
-35441,
-33145,
-28149,
-24295,
-25759,
-31751,
-36586,
-35941,
-31929,
-31082,
-37308,
-47319,
-53557,
-51057,
-41557,
-31339,
-25794,
-25693,
-28130,
-29770,
-29628,
-28753,
-28180,
-27549,
-26077,
-24679,
-26173,
-32459,
-41128,
-46095,
-42496,
-31837,
-21634,
-19080,
-24871,
-32667,
-35190,
-30519,
-23172,
-19255,
-21083,
-26052,
-30179,
-32031,
-32938,
-34167,
-34607,
-32254,
-27497,
-24048,
-25592,
-31686,
-37652,
-39254,
-36834,
-34528,
-35331,
-37857,
-38287,
-34755,
-29225,
-25139,
-24209,
-25709,
-28007,
-29899,
-30737,
-30413,
-29487,
-28853,
-28211,
-26142,
-22194,
-19182,
-21277,
-28777,
-35506,
-33764,
-22668,
-10633,
-7850,
-16121,
-27255,
-31816,
-28628,
-24668,
-26273,
-32107,
-35435,
-32088,
-24634,
-18822,
-17316,
-18090,
-18242,
-17796,
-19538,
-25438,
-34378,
-43000,
-47943,
-47672,
-42408,
-33921,
-24766,
-17429,
-13449,
-12972,
-15389,
-19775,
-24979,
-29476,
-31739,
-31324,
-29011,
-26350,
-24335,
-23386,
-23827,
-26315,
-31110,
-36999,
-41362,
-41819,
-38169,
-32849,
-29027,
-28106,
-28704,
-28196,
-25449,
-21887,
-20017,
-20852,
-23207,
-25295,
-26657,
-27966,
-29407,
-30158,
-30115,
-31311,
-36468,
-45471,
-54246,
-57879,
-55449,
-50700,
-48068,
-48045,
-47334,
-43028,
-36182,
-30767,
-29732,
-32475,
-35883,
-37429,
-36931,
-36212,
-36975,
-39229,
-40940,
-39899,
-36420,
-34340,
-38315,
-48918,
-60305,
-64110,
-56878,
-44074,
-35881,
-38185,
-47160,
-53248,
-50337,
-41554,
-35533,
-37459,
-43843,
-46521,
-41449,
-33085,
-29713,
-34867,
-43846,
-49125,
-48269,
-46100,
-48697,
-56502,
-63467,
-63211,
-55076,
-44459,
-37931,
-38124,
-42586,
-46415,
-45781,
-40530,
-33813,
-29717,
-29650,
-31373,
-31402,
-29075,
-27386,
-29692,
-35641,
-41351,
-43369,
-41765,
-38973,
-36337,
-33359,
-29699,
-26914,
-26606,
-28054,
-28848,
-28480,
-29681,
-35052,
-42612,
-46481,
-42638,
-33525,
-25887,
-24026,
-26304,
-27985,
-27134,
-26235,
-28988,
-36008,
-44401,
-50214,
-50815,
-45693,
-36735,
-28464,
-26261,
-32276,
-42182,
-47457,
-42683,
-31014,
-21721,
-21664,
-28936,
-35575,
-35666,
-30614,
-26408,
-26855,
-30374,
-32909,
-32603,
-31024,
-30519,
-31599,
-33234,
-34406,
-34315,
-31722,
-25300,
-16471,
-10351,
-12648,
-23548,
-35793,
-40216,
-34544,
-26338,
-26011,
-36602,
-50446,
-56684,
-51395,
-40248,
-31921,
-29779,
-30819,
-30898,
-29680,
-29905,
-33629,
-40046,
-46563,
-50307,
-48712,
-40533,
-28391,
-19172,
-19908,
-30856,
-44070,
-50083,
-46924,
-41483,
-41428,
-46920,
-51127,
-48720,
-41714,
-36356,
-35352,
-35509,
-32920,
-28784,
-27962,
-32362,
-37851,
-38767,
-34772,
-31086,
-32010,
-35692,
-36913,
-34470,
-33458,
-39149,
-49394,
-55643,
-52156,
-43077,
-38699,
-44307,
-54210,
-57673,
-49974,
-36978,
-28380,
-28271,
-32560,
-34716,
-32269,
-27665,
-24681,
-25261,
-29109,
-34018,
-36337,
-32636,
-23566,
-15464,
-16054,
-26597,
-39052,
-42951,
-35921,
-26105,
-23567,
-29425,
-35472,
-34014,
-26535,
-21124,
-22047,
-24736,
-21592,
-11910,
-3298,
-3554,
-12635,
-23889,
-31592,
-35385,
-37016,
-36039,
-30946,
-24051,
-21776,
-28050,
-38668,
-44447,
-41098,
-33936,
-31973,
-37535,
-43800,
-42318,
-31876,
-18912,
-10361,
-7848,
-8669,
-10579,
-13891,
-19631,
-27216,
-34697,
-40018,
-41352,
-36933,
-26759,
-15031,
-9570,
-16268,
-32768,
-48254,
-51315,
-39733,
-22997,
-14491,
-20076,
-33261,
-41725,
-38629,
-28344,
-21033,
-22600,
-29472,
-33586,
-30615,
-23511,
-18407,
-18728,
-23602,
-30235,
-36106,
-39067,
-37577,
-32825,
-29753,
-33987,
-45870,
-58742,
-63938,
-58449,
-46906,
-36479,
-30335,
-26778,
-23219,
-19896,
-18960,
-21595,
-26528,
-31569,
-34794,
-34880,
-31117,
-24777,
-20088,
-21795,
-30254,
-38978,
-38782,
-26555,
-10059,
-3218,
-14232,
-37431,
-56878,
-59241,
-44695,
-25716,
-15800,
-18768,
-28090,
-34863,
-35495,
-32337,
-29186,
-27778,
-28114,
-30133,
-33756,
-37887,
-40868,
-41972,
-41793,
-40406,
-36513,
-29502,
-22335,
-20653,
-27334,
-38593,
-46252,
-45320,
-38586,
-33549,
-34965,
-40751,
-45020,
-44106,
-39133,
-33448,
-29017,
-25876,
-24276,
-25848,
-31572,
-39335,
-44321,
-43013,
-36805,
-31049,
-30246,
-34003,
-38039,
-39009,
-37814,
-37852,
-40807,
-44875,
-47834,
-50119,
-54083,
-59561,
-62059,
-56650,
-44048,
-31634,
-27648,
-34128,
-45761,
-55299,
-59566,
-60429,
-61091,
-62265,
-61850,
-57217,
-47857,
-36359,
-27614,
-26289,
-33595,
-45672,
-55734,
-58904,
-55976,
-51895,
-50849,
-52147,
-51648,
-46454,
-38433,
-32641,
-32580,
-36894,
-40845,
-41036,
-38915,
-39499,
-46133,
-56223,
-62149,
-57537,
-43146,
-27373,
-20210,
-25991,
-40735,
-55645,
-63354,
-62037,
-55431,
-49414,
-48181,
-51331,
-54520,
-52560,
-43906,
-32274,
-24285,
-24601,
-32860,
-44623,
-54942,
-61236,
-63514,
-62839,
-59893,
-54674,
-47232,
-38612,
-31264,
-28385,
-32012,
-41136,
-51600,
-58369,
-59046,
-55760,
-53558,
-56199,
-62154,
-65020,
-58306,
-42030,
-24330,
-16209,
-22447,
-37315,
-49382,
-51536,
-46552,
-42965,
-45797,
-51820,
-53918,
-49211,
-42165,
-39635,
-43794,
-50239,
-52964,
-50380,
-46449,
-46339,
-51419,
-58343,
-62376,
-61218,
-55994,
-49170,
-42420,
-36105,
-30503,
-26416,
-24888,
-26409,
-30778,
-37217,
-44008,
-48502,
-48427,
-44158,
-39085,
-36803,
-37443,
-37723,
-35156,
-31761,
-32188,
-37865,
-44085,
-44142,
-36577,
-27126,
-23232,
-26681,
-32376,
-33752,
-28740,
-20792,
-15214,
-15261,
-20859,
-29259,
-36528,
-39477,
-37679,
-33971,
-32295,
-34036,
-37000,
-37458,
-34025,
-28650,
-24820,
-24526,
-27191,
-30520,
-32243,
-31296,
-28201,
-24550,
-21886,
-20809,
-21089,
-22548,
-25293,
-29021,
-32357,
-33767,
-33160,
-32066,
-31722,
-31553,
-30169,
-28015,
-27747,
-31075,
-35458,
-35084,
-26335,
-12197,
-800,
-6,
-7364,
-19430,
-27818,
-29264,
-25934,
-23026,
-24255,
-29388,
-34618,
-35748,
-31415,
-24098,
-18154,
-16832,
-20562,
-27232,
-33755,
-37651,
-38365,
-37779,
-38773,
-42312,
-45464,
-43380,
-34069,
-21349,
-11928,
-9526,
-12046,
-15039,
-17090,
-20641,
-27840,
-36678,
-42371,
-42025,
-36935,
-30591,
-25722,
-23798,
-25916,
-32185,
-39508,
-42143,
-36086,
-23815,
-13323,
-11808,
-19557,
-30123,
-35842,
-33562,
-26118,
-19307,
-18046,
-23371,
-32545,
-41073,
-45877,
-46749,
-45368,
-42890,
-39354,
-35051,
-31863,
-31953,
-35106,
-38102,
-37461,
-33000,
-28179,
-27175,
-31225,
-37767,
-42421,
-42150,
-37346,
-31766,
-29807,
-33144,
-38964,
-42457,
-41153,
-37151,
-34629,
-35193,
-36553,
-35562,
-32206,
-29583,
-29965,
-31708,
-30467,
-23809,
-14506,
-9195,
-13547,
-27386,
-43960,
-54208,
-53353,
-44614,
-36446,
-35220,
-39951,
-44257,
-43170,
-37864,
-33326,
-32529,
-33850,
-34163,
-32878,
-32057,
-32833,
-33829,
-33425,
-32763,
-35006,
-41280,
-48631,
-52367,
-50656,
-45976,
-42780,
-43802,
-48523,
-53898,
-56022,
-52168,
-42793,
-31977,
-25136,
-24661,
-27933,
-29952,
-28488,
-26408,
-28835,
-37840,
-50025,
-58836,
-59348,
-51805,
-41268,
-34225,
-33743,
-37199,
-38556,
-34107,
-26575,
-23171,
-28885,
-41634,
-53932,
-59139,
-56188,
-48969,
-42821,
-41536,
-45956,
-53428,
-58410,
-55982,
-46298,
-35295,
-29620,
-30343,
-32732,
-32355,
-30409,
-32000,
-39680,
-50567,
-59593,
-64493,
-65532,
-64675,
-59727,
-51300,
-42255,
-35681,
-31236,
-25993,
-19332,
-15860,
-21251,
-35528,
-51311,
-59576,
-56837,
-46831,
-35974,
-28186,
-23334,
-19406,
-15158,
-11401,
-10396,
-13874,
-21096,
-28588,
-33001,
-34383,
-36457,
-42588,
-51600,
-58149,
-57599,
-50355,
-41010,
-34208,
-31622,
-32426,
-35201,
-38069,
-38605,
-35076,
-28940,
-24803,
-26479,
-32853,
-38694,
-40021,
-38495,
-39310,
-44908,
-51080,
-50336,
-39022,
-21494,
-7118,
-3192,
-9993,
-21843,
-32322,
-38835,
-42918,
-47254,
-52560,
-57327,
-59378,
-57151,
-49788,
-37259,
-21747,
-8259,
-2348,
-5561,
-13723,
-20249,
-22329,
-22624,
-25465,
-31792,
-38739,
-43576,
-46127,
-47263,
-46414,
-42449,
-36659,
-32985,
-34244,
-39068,
-43600,
-45955,
-47490,
-49607,
-50743,
-47773,
-39838,
-29602,
-20560,
-14430,
-11459,
-12168,
-17221,
-25728,
-34754,
-41346,
-44301,
-44354,
-42972,
-42152,
-43662,
-47351,
-49482,
-45070,
-33119,
-19183,
-11425,
-13455,
-21937,
-30991,
-37411,
-41226,
-42345,
-39710,
-33671,
-27404,
-23967,
-22793,
-20959,
-17785,
-16577,
-20300,
-27128,
-31634,
-30837,
-27215,
-25625,
-28382,
-34316,
-41488,
-48583,
-53634,
-53729,
-47755,
-39185,
-33876,
-34405,
-37375,
-36799,
-30213,
-20266,
-11685,
-7063,
-6096,
-7051,
-8360,
-9404,
-11161,
-15973,
-25093,
-35934,
-42523,
-40380,
-31124,
-21453,
-17014,
-17998,
-20394,
-21149,
-20317,
-19608,
-19933,
-21848,
-26174,
-32759,
-38125,
-37269,
-28899,
-18664,
-14737,
-19628,
-27271,
-29309,
-23891,
-17187,
-16592,
-23217,
-31784,
-36310,
-35008,
-30225,
-25721,
-24809,
-29261,
-38076,
-46566,
-49209,
-44551,
-37492,
-35176,
-40105,
-47640,
-50417,
-44934,
-33617,
-22128,
-14946,
-13789,
-17301,
-22070,
-24439,
-23471,
-22326,
-25214,
-32560,
-39549,
-40871,
-36426,
-31448,
-30768,
-34176,
-37612,
-37943,
-35015,
-29768,
-22712,
-15168,
-10536,
-11741,
-17182,
-21166,
-19874,
-16226,
-17370,
-26811,
-40372,
-50198,
-52158,
-48366,
-43340,
-39055,
-34478,
-28308,
-21119,
-14862,
-11513,
-12425,
-17916,
-26007,
-32242,
-31823,
-23886,
-13656,
-9715,
-17744,
-35362,
-52795,
-59210,
-50378,
-31634,
-13682,
-4619,
-4936,
-9383,
-12875,
-14344,
-15284,
-16370,
-16638,
-15736,
-15476,
-17995,
-23023,
-27807,
-29932,
-29440,
-28114,
-27356,
-27744,
-29728,
-33489,
-37491,
-38246,
-33092,
-23339,
-14150,
-10469,
-13116,
-18635,
-22731,
-23756,
-23517,
-25541,
-32164,
-42138,
-50509,
-51601,
-43620,
-30753,
-20044,
-15451,
-15241,
-15242,
-14265,
-15200,
-20762,
-29251,
-35408,
-35082,
-28750,
-20271,
-13857,
-11864,
-14539,
-19882,
-24339,
-25179,
-23633,
-24553,
-31409,
-41470,
-47226,
-43812,
-34354,
-27171,
-27701,
-34148,
-40591,
-43093,
-41694,
-38317,
-34878,
-33864,
-38099,
-47664,
-57407,
-60057,
-53197,
-42226,
-35174,
-34934,
-37609,
-38491,
-37649,
-38541,
-42351,
-45599,
-44258,
-38694,
-33666,
-33706,
-39186,
-46713,
-51760,
-51398,
-45472,
-37260,
-32235,
-34680,
-44199,
-55371,
-61805,
-60519,
-53362,
-44383,
-37248,
-33585,
-33384,
-35120,
-36862,
-37688,
-38574,
-41046,
-44985,
-48113,
-48397,
-46460,
-45328,
-47633,
-53354,
-60009,
-64477,
-64744,
-61040,
-56044,
-53598,
-55680,
-60191,
-62433,
-59417,
-52750,
-46498,
-42691,
-39862,
-36052,
-32108,
-31014,
-34419,
-41204,
-49302,
-57462,
-64124,
-65534,
-59851,
-47215,
-35049,
-30733,
-35530,
-43988,
-49754,
-51199,
-50877,
-51064,
-51274,
-50183,
-48036,
-45761,
-42800,
-37518,
-30744,
-26915,
-30500,
-40460,
-50190,
-53085,
-48866,
-43096,
-41615,
-45292,
-50522,
-53417,
-52789,
-49846,
-46221,
-43185,
-41896,
-43245,
-46943,
-51130,
-53374,
-52052,
-47142,
-39981,
-32723,
-27843,
-26883,
-29703,
-34222,
-37812,
-38497,
-35425,
-29114,
-21835,
-17962,
-21717,
-33547,
-48183,
-57549,
-56633,
-47054,
-34990,
-26475,
-23925,
-26587,
-31745,
-35994,
-36306,
-32124,
-26084,
-21794,
-20246,
-19317,
-17549,
-17138,
-22122,
-32948,
-44643,
-51072,
-50551,
-46597,
-43505,
-42960,
-44486,
-47384,
-50269,
-49839,
-42913,
-30772,
-20286,
-18146,
-24342,
-32018,
-34776,
-32609,
-30282,
-30618,
-31329,
-28395,
-21260,
-13931,
-11456,
-16461,
-27810,
-41051,
-49823,
-48887,
-38287,
-24740,
-17352,
-20467,
-30320,
-38637,
-39515,
-33154,
-24506,
-19295,
-21014,
-28861,
-37927,
-41808,
-37968,
-30525,
-27122,
-31343,
-38904,
-42028,
-37375,
-28982,
-23191,
-22489,
-24661,
-27221,
-29991,
-33589,
-36681,
-36776,
-33432,
-28934,
-25772,
-24219,
-23113,
-22536,
-23590,
-26148,
-27349,
-24023,
-16161,
-7656,
-3402,
-5780,
-13566,
-22936,
-29835,
-31880,
-29861,
-27085,
-26584,
-28236,
-28882,
-25764,
-20010,
-16083,
-18210,
-26583,
-37077,
-43521,
-41185,
-29746,
-14373,
-3615,
-3844,
-14484,
-28433,
-37972,
-40551,
-38686,
-35309,
-30833,
-25045,
-20460,
-21071,
-27761,
-35869,
-39251,
-35923,
-29501,
-24696,
-23144,
-23765,
-25866,
-30033,
-35540,
-38768,
-35794,
-26900,
-17587,
-14488,
-20159,
-31595,
-43163,
-50186,
-50650,
-44960,
-35436,
-25936,
-20071,
-19171,
-21414,
-24034,
-26255,
-29821,
-35942,
-42485,
-44850,
-40518,
-32222,
-26046,
-26165,
-31527,
-37622,
-40827,
-40612,
-38501,
-36144,
-34919,
-36408,
-41394,
-48194,
-52728,
-51454,
-44473,
-35426,
-28149,
-23783,
-21030,
-19025,
-18942,
-23015,
-31241,
-39887,
-42949,
-37037,
-25003,
-15388,
-15901,
-26977,
-40536,
-47118,
-43687,
-35860,
-31639,
-34318,
-40779,
-45700,
-45935,
-41213,
-32926,
-23530,
-16633,
-15028,
-18041,
-21470,
-21939,
-20872,
-23165,
-31493,
-42613,
-50232,
-51048,
-47428,
-44265,
-44286,
-46541,
-48707,
-49666,
-49752,
-49594,
-48925,
-46884,
-42694,
-36767,
-31035,
-28170,
-29644,
-34057,
-37646,
-36907,
-31277,
-23824,
-19051,
-20017,
-26116,
-33739,
-39144,
-41621,
-43960,
-49104,
-56151,
-60242,
-57076,
-47633,
-37584,
-32189,
-32023,
-34101,
-35700,
-36410,
-36800,
-36879,
-36704,
-36871,
-37284,
-35960,
-31147,
-25433,
-25660,
-36560,
-54084,
-65531,
-65530,
-54675,
-41203,
-36142,
-41607,
-52494,
-61541,
-63931,
-58926,
-49967,
-42771,
-41493,
-45079,
-48382,
-47598,
-44504,
-43808,
-46954,
-49741,
-47038,
-38695,
-29564,
-24659,
-25300,
-30233,
-37686,
-45482,
-50186,
-49325,
-44749,
-42012,
-44556,
-49134,
-48930,
-41365,
-31692,
-27850,
-32578,
-41327,
-47321,
-47507,
-43677,
-39698,
-38354,
-39994,
-42295,
-41553,
-35952,
-28467,
-25920,
-33111,
-47482,
-60351,
-63809,
-57401,
-47783,
-43089,
-46589,
-54616,
-59233,
-53994,
-39547,
-24784,
-20869,
-31856,
-50063,
-62229,
-60967,
-50769,
-42109,
-40744,
-43143,
-42204,
-35439,
-27385,
-24519,
-29599,
-39859,
-49443,
-52927,
-48446,
-39345,
-32884,
-35121,
-45622,
-56940,
-60571,
-53981,
-42165,
-32989,
-31008,
-35561,
-42825,
-48953,
-51706,
-50756,
-47329,
-43123,
-39142,
-35361,
-32189,
-31263,
-34322,
-40652,
-46513,
-48029,
-44575,
-39151,
-35463,
-34782,
-35882,
-36823,
-36581,
-35108,
-33020,
-31366,
-31063,
-31896,
-32285,
-30887,
-28530,
-27841,
-30401,
-34122,
-34496,
-28708,
-19082,
-11934,
-12566,
-20506,
-29222,
-30954,
-23244,
-11481,
-5057,
-9637,
-22301,
-33991,
-37125,
-31311,
-22501,
-17219,
-17928,
-22793,
-28259,
-31414,
-31079,
-28491,
-26873,
-28986,
-33647,
-35670,
-30809,
-21243,
-15130,
-18960,
-30823,
-41622,
-43679,
-37078,
-27977,
-21630,
-18715,
-17669,
-18415,
-21896,
-26712,
-28461,
-23728,
-14503,
-7126,
-6985,
-13793,
-22641,
-28208,
-28525,
-24937,
-20362,
-17356,
-17226,
-19528,
-22470,
-24096,
-23865,
-22902,
-22746,
-23806,
-24816,
-23733,
-19185,
-11802,
-4752,
-2497,
-7786,
-18868,
-29968,
-35533,
-34711,
-31516,
-30609,
-33253,
-37105,
-39450,
-38990,
-35664,
-29727,
-22711,
-17761,
-17256,
-19423,
-19073,
-13106,
-5063,
-2390,
-8501,
-18732,
-24917,
-23528,
-18220,
-14725,
-15348,
-18888,
-24154,
-30895,
-37383,
-39644,
-35386,
-27777,
-23308,
-25077,
-29607,
-30807,
-26564,
-19565,
-13038,
-7345,
-2073,
-2,
-2641,
-12291,
-23284,
-29261,
-27823,
-21605,
-14776,
-10388,
-10329,
-16139,
-27125,
-38818,
-44889,
-42495,
-35210,
-30000,
-31307,
-38035,
-45606,
-49744,
-48378,
-41635,
-31560,
-21637,
-15037,
-12227,
-10967,
-9012,
-7006,
-7551,
-11857,
-17553,
-20927,
-20465,
-18383,
-18562,
-23656,
-33516,
-44885,
-52234,
-49949,
-36350,
-16788,
-1956,
-1109,
-15172,
-35440,
-49460,
-49173,
-35420,
-16512,
-2684,
-185,
-8429,
-21133,
-30940,
-34085,
-32001,
-28687,
-27011,
-26890,
-27003,
-27072,
-28528,
-32897,
-39654,
-45872,
-47646,
-43055,
-34178,
-26502,
-25074,
-30221,
-36855,
-38859,
-34592,
-27989,
-23972,
-23333,
-22776,
-19628,
-15506,
-14433,
-17951,
-23282,
-26397,
-26412,
-26260,
-29501,
-37032,
-46565,
-54169,
-56093,
-50549,
-39169,
-27348,
-21304,
-23590,
-30914,
-36870,
-37342,
-32791,
-26371,
-20435,
-15813,
-13162,
-13328,
-15877,
-18586,
-20201,
-23017,
-31345,
-45668,
-59528,
-64043,
-56545,
-44235,
-38076,
-42837,
-53266,
-59806,
-56977,
-46454,
-33328,
-21707,
-14086,
-12758,
-18995,
-30205,
-39442,
-40241,
-32048,
-20862,
-13376,
-11664,
-13507,
-17090,
-23643,
-34463,
-47074,
-55567,
-55880,
-49210,
-40317,
-32925,
-28074,
-26297,
-29014,
-36372,
-44337,
-46527,
-40119,
-29450,
-22413,
-23138,
-28751,
-33503,
-34731,
-34275,
-34472,
-34735,
-32646,
-27827,
-23335,
-23302,
-29181,
-38742,
-47528,
-51514,
-48883,
-41193,
-32942,
-29481,
-33426,
-42464,
-50548,
-52108,
-45790,
-35187,
-26040,
-22700,
-26059,
-33893,
-42590,
-48879,
-50701,
-47478,
-40133,
-30851,
-22176,
-15860,
-12653,
-13354,
-19589,
-31874,
-46616,
-55702,
-52349,
-38165,
-24013,
-21378,
-31864,
-46071,
-52992,
-50336,
-44387,
-41194,
-40053,
-36891,
-31633,
-29636,
-34744,
-43849,
-49694,
-48793,
-44129,
-40249,
-37699,
-34371,
-30488,
-29885,
-35001,
-42873,
-47710,
-46749,
-42325,
-37753,
-34165,
-31560,
-31757,
-36710,
-44452,
-48664,
-44938,
-36183,
-30308,
-32274,
-39915,
-47699,
-52706,
-55122,
-54494,
-48612,
-37312,
-25330,
-18968,
-20097,
-25045,
-29527,
-32807,
-36104,
-38902,
-39229,
-37607,
-37753,
-41872,
-46706,
-46566,
-40624,
-34826,
-35496,
-42089,
-47793,
-46956,
-40529,
-33853,
-31298,
-33499,
-39052,
-45900,
-51362,
-52398,
-48101,
-41234,
-36066,
-34417,
-34779,
-35563,
-37771,
-43071,
-49964,
-53720,
-51301,
-45202,
-41253,
-42258,
-45014,
-44059,
-37783,
-30247,
-26929,
-29721,
-35823,
-41032,
-43011,
-41934,
-39047,
-35634,
-32933,
-32065,
-33057,
-34281,
-33422,
-29784,
-25384,
-23524,
-25843,
-30728,
-34716,
-35431,
-33315,
-30665,
-29401,
-29813,
-31308,
-33574,
-36661,
-39826,
-41115,
-38877,
-34134,
-30667,
-32140,
-38055,
-43500,
-43038,
-35683,
-25557,
-17955,
-14839,
-14697,
-15518,
-17431,
-21565,
-27946,
-34904,
-40487,
-43208,
-41755,
-35175,
-25016,
-16022,
-13513,
-18529,
-26635,
-31851,
-31707,
-27804,
-22655,
-17422,
-13338,
-12968,
-18032,
-26009,
-31080,
-29708,
-24582,
-21612,
-23379,
-26814,
-27505,
-24830,
-21831,
-20796,
-21279,
-22011,
-23621,
-27214,
-31534,
-33192,
-30651,
-26890,
-26833,
-32147,
-39309,
-43204,
-41997,
-38457,
-36896,
-39314,
-44267,
-48499,
-49557,
-47115,
-42663,
-37901,
-33722,
-30315,
-28245,
-28558,
-31550,
-35288,
-36662,
-33695,
-27658,
-21712,
-18376,
-17986,
-19649,
-22778,
-27207,
-32356,
-37120,
-40794,
-43445,
-45195,
-45214,
-42547,
-37523,
-32210,
-28803,
-27961,
-28767,
-29899,
-30441,
-29690,
-27338,
-24228,
-22575,
-24374,
-29431,
-35519,
-40392,
-43397,
-44394,
-42545,
-37302,
-30974,
-28336,
-32112,
-38800,
-41013,
-34862,
-24489,
-18205,
-20325,
-28045,
-36105,
-42514,
-48173,
-51991,
-49760,
-39330,
-25507,
-16911,
-17389,
-22232,
-24037,
-21426,
-20046,
-24821,
-33621,
-39746,
-40228,
-39126,
-42233,
-49687,
-55462,
-53956,
-45539,
-35570,
-28535,
-25025,
-23426,
-23481,
-26279,
-31585,
-36109,
-35742,
-29462,
-20486,
-13721,
-11758,
-13917,
-18149,
-23659,
-30984,
-40157,
-49278,
-55372,
-56247,
-51983,
-44656,
-37637,
-34289,
-36227,
-41625,
-45511,
-43242,
-34684,
-25156,
-21242,
-25367,
-34065,
-41418,
-43654,
-40941,
-35459,
-29543,
-24939,
-23154,
-24714,
-28368,
-31489,
-32089,
-30250,
-27944,
-27327,
-29601,
-34261,
-39314,
-41933,
-40412,
-36143,
-33071,
-34687,
-40675,
-47346,
-51287,
-52332,
-52411,
-52236,
-50145,
-44835,
-38203,
-34424,
-35681,
-39811,
-42266,
-40356,
-35021,
-29120,
-25231,
-25141,
-30163,
-39724,
-49942,
-54814,
-51111,
-42030,
-35053,
-35616,
-42811,
-51426,
-57276,
-59541,
-58869,
-55051,
-48134,
-40558,
-36628,
-38389,
-43601,
-47556,
-47406,
-43351,
-37013,
-29921,
-24282,
-23083,
-28014,
-36899,
-45179,
-50018,
-52325,
-53590,
-52384,
-45744,
-34332,
-24147,
-21890,
-28745,
-40042,
-50218,
-56704,
-59175,
-57388,
-51862,
-45874,
-43949,
-47204,
-51305,
-50498,
-43463,
-34364,
-28580,
-28424,
-33079,
-40198,
-46535,
-48452,
-44405,
-37703,
-34579,
-38013,
-44349,
-47339,
-45450,
-42980,
-44055,
-47348,
-48521,
-46541,
-45004,
-46822,
-50127,
-51130,
-49670,
-49496,
-52593,
-55803,
-54243,
-47323,
-39202,
-34119,
-32742,
-33862,
-37240,
-42962,
-48869,
-51120,
-48127,
-42626,
-38230,
-35288,
-31475,
-26737,
-25018,
-30064,
-40027,
-48611,
-51407,
-50091,
-49358,
-50800,
-51585,
-48830,
-44021,
-41635,
-43780,
-47649,
-48343,
-44215,
-38271,
-34920,
-35465,
-37454,
-37783,
-36227,
-35426,
-37772,
-42513,
-46217,
-45979,
-42158,
-38056,
-37211,
-40806,
-47066,
-52478,
-53624,
-48927,
-39874,
-30697,
-26198,
-28469,
-35077,
-40518,
-40098,
-33649,
-25770,
-22512,
-26326,
-33516,
-36892,
-31903,
-21432,
-13639,
-14512,
-22033,
-28382,
-28067,
-23411,
-21315,
-25326,
-31882,
-34677,
-31414,
-25387,
-21159,
-20326,
-21984,
-25617,
-31514,
-38286,
-41845,
-38328,
-28423,
-17756,
-12605,
-15132,
-22126,
-28359,
-30361,
-28692,
-26647,
-27360,
-31043,
-34874,
-35825,
-33801,
-31596,
-31501,
-32306,
-30716,
-25668,
-20378,
-19357,
-23474,
-29248,
-32525,
-32362,
-30597,
-28688,
-26525,
-23982,
-22321,
-22314,
-22123,
-18481,
-11019,
-4222,
-3691,
-10421,
-19657,
-25833,
-27979,
-29551,
-33248,
-37365,
-37271,
-30387,
-18917,
-8414,
-4205,
-8716,
-20423,
-34382,
-44136,
-45244,
-38197,
-28012,
-20390,
-17638,
-18360,
-20307,
-23068,
-27689,
-34455,
-41803,
-47404,
-49820,
-48857,
-45032,
-39142,
-32640,
-27427,
-24840,
-24544,
-24840,
-24335,
-23666,
-25349,
-31357,
-40424,
-47232,
-45778,
-34057,
-16955,
-3347,
-111,
-7506,
-20126,
-31533,
-37999,
-39101,
-36125,
-31529,
-28668,
-30279,
-36085,
-41907,
-42638,
-36254,
-25195,
-14178,
-7225,
-6919,
-14624,
-29488,
-46706,
-58303,
-58074,
-46794,
-32258,
-23427,
-23790,
-30157,
-36666,
-39805,
-39121,
-35406,
-29046,
-21074,
-14244,
-11706,
-14173,
-18843,
-22045,
-22680,
-22875,
-25090,
-29722,
-35452,
-41664,
-48536,
-54903,
-57042,
-51488,
-39190,
-25934,
-17673,
-15787,
-17335,
-19296,
-21401,
-24720,
-28807,
-31704,
-32066,
-30347,
-27470,
-24050,
-21217,
-21032,
-24222,
-27606,
-26174,
-18929,
-11641,
-11695,
-20114,
-30048,
-34283,
-32655,
-30977,
-33098,
-36464,
-36070,
-31030,
-25389,
-22691,
-22350,
-21733,
-20606,
-21453,
-25778,
-31814,
-36468,
-38327,
-37688,
-34522,
-28161,
-19542,
-12244,
-10102,
-13793,
-20505,
-27112,
-32180,
-35416,
-35801,
-32461,
-26787,
-22331,
-21467,
-22703,
-22593,
-20479,
-20118,
-25519,
-35284,
-42203,
-39323,
-26642,
-11471,
-2470,
-3258,
-11237,
-21569,
-31041,
-38561,
-43060,
-42687,
-36505,
-26638,
-17816,
-14098,
-16044,
-20693,
-24344,
-25099,
-23194,
-19678,
-15545,
-11974,
-10613,
-12636,
-17478,
-22857,
-26577,
-27939,
-27355,
-24920,
-20459,
-15122,
-12032,
-13922,
-19800,
-25248,
-26489,
-24461,
-23246,
-25236,
-28389,
-29368,
-27864,
-26534,
-26440,
-24820,
-18607,
-9700,
-4250,
-6517,
-14205,
-21627,
-25988,
-29088,
-32454,
-33394,
-28044,
-17775,
-10045,
-11290,
-19754,
-26589,
-24537,
-14330,
-3354,
-3,
-2019,
-10775,
-20301,
-26568,
-27439,
-23387,
-17217,
-11916,
-8375,
-5981,
-5198,
-8731,
-18500,
-31741,
-41392,
-41924,
-34831,
-27780,
-27696,
-34308,
-40734,
-40157,
-32274,
-23277,
-19768,
-22619,
-26877,
-27439,
-24219,
-21261,
-20833,
-20110,
-14712,
-5472,
-65535,
-2476,
-13236,
-23439,
-27503,
-28205,
-32486,
-42244,
-51374,
-52261,
-43570,
-30506,
-18999,
-11601,
-9036,
-12476,
-21736,
-32181,
-36397,
-30661,
-19048,
-9755,
-7808,
-12158,
-18857,
-25387,
-30868,
-34314,
-34797,
-33418,
-33051,
-35332,
-38634,
-40356,
-40264,
-40218,
-40495,
-38664,
-33088,
-26836,
-25732,
-32141,
-41736,
-47530,
-46359,
-40694,
-34612,
-29723,
-25619,
-22707,
-22896,
-27011,
-33044,
-37680,
-39349,
-39075,
-38644,
-38895,
-40186,
-43375,
-49373,
-56615,
-60510,
-56054,
-42563,
-25886,
-15099,
-16173,
-27422,
-40976,
-48835,
-48152,
-41733,
-34186,
-28323,
-24925,
-24652,
-29055,
-38653,
-50926,
-60629,
-63276,
-58763,
-51641,
-47759,
-49411,
-53664,
-55117,
-51135,
-44443,
-40538,
-42350,
-47821,
-52569,
-54380,
-54261,
-53567,
-51611,
-47076,
-40859,
-36048,
-34344,
-34159,
-32767,
-30246,
-29540,
-32831,
-39040,
-45561,
-51356,
-56790,
-60827,
-60810,
-55889,
-49832,
-47611,
-49686,
-50738,
-45944,
-37178,
-31452,
-33215,
-39466,
-43435,
-41672,
-36396,
-31289,
-27747,
-25711,
-27044,
-34534,
-47360,
-58819,
-61151,
-53037,
-41665,
-36649,
-41665,
-51759,
-58157,
-55387,
-44766,
-32492,
-24915,
-24882,
-30926,
-39349,
-46997,
-52623,
-55999,
-56316,
-52269,
-43764,
-33336,
-24982,
-21437,
-22534,
-25974,
-29116,
-30256,
-28644,
-24933,
-21037,
-19393,
-21206,
-25938,
-32425,
-40095,
-48253,
-54376,
-55062,
-49300,
-41149,
-36964,
-39924,
-47247,
-53134,
-53972,
-49702,
-41576,
-30399,
-17929,
-8480,
-6521,
-12409,
-21358,
-28104,
-31729,
-35370,
-40906,
-46154,
-47224,
-43726,
-39437,
-38556,
-41526,
-45678,
-48495,
-49601,
-49285,
-46663,
-40496,
-31969,
-25409,
-25482,
-32710,
-42388,
-47741,
-45032,
-35593,
-23855,
-13878,
-8094,
-8170,
-15423,
-28881,
-43860,
-53902,
-55505,
-50531,
-43870,
-38806,
-36271,
-37098,
-43295,
-54408,
-64105,
-63082,
-47856,
-26067,
-11550,
-12971,
-27473,
-44740,
-56164,
-59709,
-57758,
-52963,
-46706,
-40080,
-34066,
-28962,
-24580,
-21571,
-21801,
-26362,
-33811,
-40861,
-45136,
-46780,
-47434,
-48277,
-49292,
-49963,
-49830,
-48745,
-47107,
-46072,
-46857,
-49106,
-50741,
-49908,
-47469,
-46635,
-49594,
-54748,
-57801,
-55828,
-49804,
-43126,
-37888,
-33098,
-26776,
-19259,
-14337,
-16313,
-26227,
-40340,
-52787,
-59536,
-59837,
-54877,
-45965,
-35170,
-26910,
-26145,
-33786,
-43531,
-46252,
-38632,
-27378,
-23566,
-31862,
-46123,
-55257,
-53308,
-43380,
-33021,
-27465,
-26927,
-28851,
-30565,
-30745,
-29893,
-30633,
-36096,
-46625,
-57670,
-62644,
-58730,
-49983,
-44192,
-46204,
-54457,
-62905,
-65534,
-61226,
-50320,
-37429,
-28274,
-27894,
-37225,
-51479,
-62295,
-63411,
-54898,
-42481,
-32387,
-26765,
-23535,
-20326,
-18057,
-20296,
-29285,
-42546,
-53750,
-57146,
-51646,
-41687,
-34228,
-34655,
-43170,
-54175,
-58974,
-51945,
-35865,
-21676,
-20755,
-35379,
-55942,
-65533,
-65532,
-53152,
-41834,
-39456,
-44346,
-48899,
-47098,
-39064,
-29634,
-23935,
-23963,
-28448,
-34627,
-40150,
-43915,
-46011,
-47377,
-49435,
-53175,
-58192,
-62199,
-62228,
-57092,
-48483,
-40055,
-34430,
-31981,
-31480,
-32143,
-33824,
-36023,
-37269,
-36101,
-32589,
-28404,
-25681,
-25857,
-29208,
-34430,
-38606,
-38492,
-33571,
-27791,
-27135,
-34020,
-43632,
-47068,
-38630,
-21472,
-6003,
-2653,
-14858,
-36630,
-56415,
-63931,
-56338,
-39635,
-24098,
-17234,
-19463,
-25980,
-32136,
-36690,
-40526,
-43490,
-43729,
-39975,
-33406,
-26867,
-22460,
-20628,
-20950,
-22832,
-25218,
-26217,
-24471,
-20850,
-18269,
-19341,
-24021,
-29794,
-34092,
-36086,
-36680,
-37080,
-37719,
-38120,
-37294,
-34409,
-29896,
-26001,
-26011,
-31364,
-39391,
-43974,
-39899,
-27489,
-13282,
-5713,
-8937,
-19858,
-30720,
-34776,
-30989,
-23856,
-19809,
-22297,
-29901,
-37582,
-40519,
-37317,
-30807,
-25571,
-24347,
-25794,
-25945,
-22004,
-15411,
-11175,
-13904,
-24028,
-37082,
-46768,
-48553,
-41868,
-29922,
-18009,
-11205,
-11856,
-18278,
-25885,
-30554,
-31254,
-29934,
-28621,
-27481,
-25344,
-21900,
-18489,
-16972,
-18357,
-22684,
-29153,
-35958,
-40038,
-38999,
-33609,
-27757,
-24728,
-23658,
-20911,
-15505,
-11888,
-15728,
-26981,
-38065,
-40440,
-32223,
-19429,
-9839,
-6893,
-9130,
-13654,
-18512,
-22295,
-23463,
-21745,
-19480,
-20073,
-24801,
-31122,
-35236,
-35499,
-33779,
-33321,
-36097,
-41274,
-45890,
-46207,
-40243,
-29929,
-21121,
-20341,
-29471,
-43501,
-53513,
-53318,
-43861,
-31995,
-24692,
-23917,
-26358,
-27431,
-25823,
-24056,
-25007,
-27918,
-28292,
-22186,
-10861,
-1157,
-694,
-12058,
-30389,
-46486,
-52324,
-45820,
-31972,
-19839,
-17038,
-24505,
-35828,
-41951,
-38270,
-28036,
-19111,
-17081,
-21017,
-25452,
-26009,
-23051,
-20700,
-22534,
-28795,
-36608,
-42588,
-44780,
-42826,
-37265,
-29611,
-23010,
-21752,
-28523,
-41283,
-53660,
-59274,
-56909,
-50748,
-45858,
-43603,
-41850,
-39118,
-36683,
-36421,
-37357,
-36290,
-31678,
-25917,
-22516,
-21970,
-21316,
-18041,
-13173,
-10158,
-11368,
-16724,
-24939,
-34353,
-42212,
-44505,
-38755,
-27326,
-16936,
-13761,
-18976,
-28587,
-37083,
-40642,
-38191,
-31437,
-24867,
-23873,
-30879,
-42167,
-49820,
-47989,
-37633,
-25085,
-16279,
-12428,
-10956,
-9120,
-6722,
-6015,
-9793,
-19312,
-32404,
-43782,
-47966,
-43630,
-34997,
-28567,
-27769,
-31015,
-34350,
-35183,
-33123,
-28493,
-21789,
-15259,
-13050,
-18446,
-29764,
-40458,
-43740,
-37779,
-26536,
-15921,
-9737,
-8466,
-10725,
-14958,
-19864,
-24213,
-26921,
-27126,
-24566,
-19867,
-15307,
-14345,
-19727,
-30569,
-41638,
-46408,
-42083,
-32426,
-24865,
-24566,
-29998,
-34769,
-33559,
-26908,
-20626,
-20579,
-27925,
-38331,
-45138,
-43550,
-33381,
-19364,
-8918,
-8061,
-17505,
-31878,
-43470,
-47307,
-43603,
-35609,
-26365,
-17695,
-11667,
-10884,
-16525,
-26371,
-36116,
-42872,
-46548,
-48121,
-46980,
-41888,
-33808,
-26729,
-24768,
-28440,
-34727,
-39940,
-42142,
-40783,
-35772,
-27965,
-19895,
-14545,
-12720,
-13214,
-15633,
-22655,
-36554,
-54033,
-65516,
-62669,
-46412,
-27272,
-16771,
-18851,
-29006,
-40024,
-47066,
-48094,
-42741,
-32839,
-23534,
-20751,
-26123,
-34905,
-40332,
-39941,
-36985,
-35305,
-34568,
-31249,
-23853,
-15564,
-11276,
-13051,
-19329,
-27570,
-36328,
-44051,
-47832,
-45058,
-36903,
-29074,
-27987,
-35606,
-48278,
-59703,
-65121,
-62900,
-53824,
-40372,
-26384,
-16557,
-14422,
-20379,
-31243,
-41684,
-46514,
-42957,
-32056,
-18904,
-10356,
-10933,
-19568,
-30372,
-36887,
-36724,
-32438,
-28634,
-28509,
-31999,
-36481,
-38410,
-35340,
-27964,
-20427,
-17953,
-22645,
-31339,
-37944,
-38383,
-33201,
-26042,
-20412,
-18606,
-22311,
-31787,
-43519,
-50016,
-45134,
-30419,
-15519,
-10095,
-15430,
-24086,
-28497,
-28107,
-28207,
-32207,
-37373,
-38273,
-33282,
-26321,
-22646,
-24298,
-29550,
-35611,
-40431,
-42533,
-41249,
-37552,
-34282,
-33765,
-35069,
-34835,
-30841,
-25192,
-22752,
-26489,
-34417,
-40698,
-39961,
-30857,
-16824,
-4093,
-3,
-1747,
-11692,
-22742,
-30175,
-32476,
-31298,
-29210,
-27861,
-27828,
-28965,
-30734,
-32089,
-32309,
-31900,
-32334,
-34266,
-36245,
-35990,
-33093,
-30364,
-31466,
-37342,
-44876,
-49473,
-48883,
-44558,
-39644,
-36008,
-33160,
-29808,
-25845,
-22947,
-23287,
-27562,
-34072,
-39599,
-41595,
-40132,
-37565,
-36226,
-35961,
-34659,
-31177,
-27742,
-28144,
-33338,
-39168,
-39798,
-33604,
-25414,
-21965,
-25411,
-31540,
-34229,
-31120,
-24974,
-20266,
-19823,
-23409,
-28731,
-32181,
-30720,
-24330,
-17567,
-16974,
-25487,
-39388,
-51095,
-55520,
-53267,
-48262,
-43675,
-40616,
-39458,
-40426,
-42336,
-42634,
-40061,
-36919,
-37196,
-41992,
-47956,
-50883,
-50039,
-47726,
-45046,
-40187,
-31697,
-22352,
-17619,
-20186,
-27127,
-33558,
-37803,
-41837,
-47044,
-51486,
-52515,
-50986,
-50545,
-52725,
-53677,
-47872,
-34673,
-20468,
-13365,
-16241,
-25043,
-33461,
-38148,
-39646,
-39559,
-38716,
-37960,
-39463,
-45067,
-53278,
-58897,
-57196,
-48898,
-40282,
-37679,
-41761,
-47461,
-49157,
-45674,
-39838,
-34623,
-30559,
-26979,
-24499,
-24740,
-28027,
-32266,
-34893,
-35673,
-36788,
-40326,
-46419,
-53367,
-59422,
-63063,
-62816,
-57805,
-49398,
-41648,
-38782,
-41751,
-47470,
-51411,
-51199,
-47231,
-41223,
-34491,
-28059,
-23293,
-21363,
-22639,
-26337,
-31581,
-37173,
-41004,
-40207,
-33775,
-25008,
-20450,
-24596,
-35631,
-46682,
-51902,
-51129,
-48379,
-46632,
-44861,
-40603,
-34240,
-29786,
-31081,
-37871,
-45860,
-50335,
-49288,
-43415,
-34488,
-24406,
-15619,
-11234,
-13345,
-21435,
-32145,
-41496,
-46832,
-47543,
-44140,
-37608,
-29579,
-22500,
-19000,
-20235,
-25174,
-31196,
-35834,
-38127,
-38479,
-37912,
-37200,
-36993,
-37736,
-39330,
-40534,
-39428,
-35465,
-31088,
-30690,
-36612,
-45441,
-49397,
-42465,
-26464,
-10546,
-4148,
-9508,
-20882,
-30242,
-33795,
-33162,
-32038,
-32485,
-34634,
-37871,
-41676,
-44884,
-45835,
-43558,
-38904,
-34146,
-31363,
-31486,
-34346,
-38969,
-43669,
-46374,
-45640,
-41545,
-35596,
-29589,
-25069,
-23017,
-23907,
-26771,
-29453,
-29670,
-27268,
-24410,
-24113,
-27795,
-34443,
-41281,
-45274,
-44920,
-41462,
-38837,
-40906,
-48048,
-56279,
-60775,
-60260,
-57221,
-53909,
-49003,
-40089,
-28340,
-19629,
-19133,
-26037,
-34405,
-39384,
-40879,
-41297,
-40777,
-37401,
-31027,
-25417,
-24563,
-28154,
-32307,
-34739,
-37510,
-42994,
-48587,
-47459,
-36201,
-20553,
-12250,
-18988,
-37801,
-57381,
-65527,
-62062,
-46300,
-26249,
-8913,
-259,
-3818,
-18657,
-38677,
-55169,
-61807,
-58191,
-49159,
-40620,
-35479,
-32842,
-30162,
-26196,
-21986,
-20055,
-22501,
-29929,
-40870,
-52076,
-59282,
-58800,
-49610,
-34508,
-19472,
-10837,
-12129,
-22220,
-36163,
-47865,
-53124,
-51029,
-43531,
-33883,
-25414,
-20878,
-22050,
-28640,
-37721,
-44486,
-44994,
-38569,
-28353,
-18847,
-13316,
-12414,
-14922,
-18976,
-22901,
-25797,
-28064,
-31220,
-36486,
-42713,
-46275,
-43321,
-33197,
-19684,
-8822,
-5171,
-9157,
-17450,
-25531,
-30470,
-32111,
-32082,
-31695,
-31149,
-30484,
-31252,
-35717,
-43866,
-51396,
-52230,
-44081,
-31324,
-21424,
-18475,
-20544,
-23406,
-25946,
-30330,
-37903,
-45916,
-49621,
-46698,
-38800,
-29086,
-19885,
-12970,
-10679,
-14664,
-23124,
-31046,
-33943,
-31733,
-27714,
-24522,
-21821,
-18279,
-14610,
-13448,
-16319,
-21703,
-26417,
-28281,
-27360,
-25092,
-23298,
-23473,
-26086,
-29645,
-31362,
-29473,
-25139,
-21520,
-20856,
-22590,
-24537,
-25044,
-23828,
-21443,
-18952,
-18044,
-20428,
-25933,
-31893,
-35200,
-35099,
-33594,
-32669,
-32340,
-31531,
-30417,
-30499,
-32396,
-34885,
-36411,
-36914,
-36688,
-34247,
-27238,
-16280,
-6826,
-4817,
-10687,
-18410,
-21932,
-21128,
-20857,
-24352,
-29444,
-31626,
-29791,
-26855,
-25687,
-25535,
-23955,
-20782,
-19180,
-21905,
-28167,
-34149,
-36609,
-35169,
-31533,
-27649,
-25071,
-25271,
-28934,
-34501,
-37660,
-34092,
-23514,
-11382,
-5719,
-11145,
-25254,
-40582,
-50187,
-51539,
-45890,
-35438,
-22538,
-11268,
-7639,
-15877,
-33852,
-53331,
-65533,
-65530,
-59918,
-47296,
-32358,
-18956,
-12703,
-17715,
-31945,
-47095,
-54852,
-52955,
-45466,
-37477,
-31101,
-25870,
-21643,
-19334,
-19757,
-22732,
-27814,
-34777,
-42579,
-48809,
-50885,
-48013,
-41321,
-32283,
-22354,
-14427,
-13229,
-21938,
-37662,
-51786,
-56348,
-50926,
-42509,
-38510,
-40234,
-43165,
-42956,
-39975,
-37963,
-39353,
-42532,
-43971,
-41903,
-37838,
-34537,
-33251,
-33174,
-32942,
-32363,
-32079,
-32414,
-33097,
-34373,
-37791,
-44715,
-54224,
-62379,
-64926,
-60288,
-50644,
-39978,
-31991,
-28978,
-31829,
-39433,
-48303,
-54242,
-55063,
-52195,
-48785,
-46218,
-43089,
-37334,
-29318,
-21944,
-18154,
-18475,
-21067,
-23714,
-25477,
-27020,
-29659,
-34190,
-40039,
-45260,
-47487,
-45530,
-40127,
-33879,
-29946,
-30816,
-36949,
-46169,
-54512,
-58358,
-56450,
-49725,
-39615,
-27357,
-15474,
-8762,
-11817,
-24458,
-40519,
-52491,
-57404,
-57257,
-54075,
-46600,
-33647,
-19342,
-12320,
-17641,
-31277,
-43834,
-50108,
-52771,
-56675,
-61372,
-61777,
-55169,
-45421,
-38513,
-35851,
-33855,
-29904,
-26744,
-29275,
-38355,
-48775,
-53800,
-50553,
-41317,
-31098,
-24764,
-25429,
-32931,
-43111,
-49581,
-48214,
-40480,
-31991,
-27580,
-27585,
-28972,
-28902,
-27006,
-24701,
-23477,
-24067,
-26527,
-30203,
-33763,
-35931,
-36523,
-36458,
-36790,
-37562,
-38202,
-38220,
-37774,
-37254,
-37311,
-38922,
-42860,
-48265,
-52159,
-51376,
-45716,
-38867,
-35437,
-36923,
-40586,
-42506,
-41107,
-37703,
-34144,
-30724,
-26991,
-23538,
-22667,
-26565,
-35046,
-44764,
-50582,
-48216,
-37173,
-22077,
-10994,
-10455,
-20686,
-35016,
-44953,
-46662,
-42933,
-39348,
-38532,
-38308,
-34887,
-27187,
-18340,
-13456,
-15915,
-25220,
-36871,
-44984,
-45465,
-38748,
-28895,
-20362,
-14650,
-10460,
-6971,
-6155,
-11504,
-23832,
-39034,
-50161,
-52529,
-46992,
-38887,
-33356,
-31432,
-29966,
-25353,
-17507,
-10078,
-6894,
-8394,
-11987,
-15776,
-20730,
-28586,
-38015,
-44638,
-45543,
-42780,
-41210,
-42500,
-43193,
-38976,
-30619,
-23690,
-22804,
-27210,
-32777,
-37122,
-41143,
-45610,
-48387,
-46143,
-38676,
-29758,
-23652,
-21471,
-21395,
-21552,
-21650,
-21916,
-22085,
-21585,
-20578,
-19439,
-18036,
-16040,
-14407,
-15191,
-19345,
-24960,
-28880,
-30246,
-31567,
-35586,
-41398,
-44316,
-40151,
-29154,
-16135,
-6987,
-5432,
-11766,
-23469,
-36079,
-44801,
-46625,
-42040,
-34096,
-25936,
-18777,
-13117,
-10631,
-14100,
-24331,
-37543,
-47204,
-48903,
-43719,
-36264,
-30028,
-25001,
-19923,
-15273,
-12846,
-12710,
-12276,
-9726,
-7774,
-11883,
-24077,
-38851,
-47029,
-43666,
-32181,
-20578,
-14835,
-15997,
-22113,
-30424,
-37478,
-39158,
-33566,
-23825,
-16536,
-15972,
-20089,
-23352,
-22543,
-19394,
-16981,
-16102,
-15575,
-15623,
-18263,
-23947,
-29264,
-29503,
-23613,
-15475,
-10176,
-9677,
-12536,
-16684,
-21377,
-26549,
-31563,
-35297,
-36901,
-36145,
-33442,
-30300,
-29446,
-32852,
-39301,
-44108,
-42817,
-34982,
-24433,
-15635,
-10692,
-9552,
-11785,
-17041,
-23961,
-30110,
-33711,
-34767,
-34330,
-32997,
-31100,
-29725,
-30402,
-33156,
-35951,
-36562,
-34750,
-31510,
-27086,
-21144,
-15546,
-14908,
-22426,
-35326,
-46283,
-50348,
-49326,
-48113,
-47814,
-44518,
-35288,
-23054,
-14064,
-11219,
-12285,
-14699,
-19345,
-27884,
-37155,
-39983,
-32606,
-20246,
-13144,
-16941,
-27956,
-37971,
-42311,
-42628,
-42780,
-44060,
-44602,
-42340,
-37232,
-31320,
-27282,
-27455,
-32694,
-41465,
-50019,
-54442,
-53177,
-47969,
-42153,
-38071,
-35779,
-33727,
-30573,
-26375,
-22562,
-20968,
-22707,
-27750,
-34884,
-42023,
-46701,
-47224,
-43707,
-38070,
-32161,
-26272,
-19894,
-14599,
-14700,
-23700,
-39254,
-53056,
-57296,
-51479,
-42356,
-36747,
-35442,
-34238,
-30248,
-25256,
-23274,
-25842,
-31194,
-36539,
-40217,
-41085,
-38198,
-32057,
-25880,
-23691,
-26845,
-33035,
-39199,
-44638,
-50240,
-55395,
-57168,
-53288,
-45145,
-36849,
-31434,
-28922,
-27800,
-27620,
-29180,
-32974,
-38228,
-43358,
-46586,
-45949,
-40103,
-30005,
-19735,
-14002,
-14352,
-18078,
-21498,
-23802,
-26988,
-32009,
-36158,
-35182,
-27884,
-18269,
-12631,
-14749,
-23275,
-33353,
-40226,
-42196,
-40616,
-37902,
-35185,
-32222,
-29222,
-28264,
-31662,
-38469,
-43617,
-41696,
-32640,
-22643,
-18961,
-23539,
-31963,
-38173,
-39372,
-36347,
-30792,
-23780,
-16706,
-12061,
-11830,
-15703,
-21860,
-29172,
-37648,
-45839,
-49416,
-44046,
-30522,
-16056,
-9254,
-13291,
-24080,
-34481,
-40255,
-41711,
-41475,
-41228,
-40765,
-39058,
-35470,
-30600,
-26259,
-24672,
-26954,
-31729,
-35716,
-35832,
-31431,
-24207,
-16791,
-10950,
-7603,
-7086,
-9415,
-13933,
-19650,
-25757,
-31952,
-37351,
-39812,
-36722,
-27622,
-16026,
-8125,
-8631,
-16906,
-27055,
-32181,
-29658,
-23154,
-19349,
-22635,
-31389,
-39519,
-41239,
-35374,
-25853,
-18192,
-15295,
-15737,
-15722,
-12945,
-8920,
-7812,
-12754,
-22804,
-33420,
-39866,
-40406,
-36552,
-30931,
-25330,
-20695,
-17886,
-17455,
-18795,
-20270,
-20942,
-21685,
-23909,
-27065,
-28402,
-25653,
-20078,
-15779,
-16185,
-21308,
-28508,
-35345,
-40510,
-42982,
-41105,
-34057,
-23612,
-13613,
-7392,
-5836,
-7997,
-12993,
-20130,
-27909,
-33475,
-34425,
-31024,
-26525,
-25127,
-29198,
-37627,
-46177,
-49544,
-44758,
-33820,
-23049,
-18604,
-21509,
-27144,
-29675,
-27602,
-24370,
-24624,
-29864,
-38023,
-45862,
-50899,
-51677,
-47604,
-39875,
-31792,
-27029,
-26755,
-28750,
-29808,
-28751,
-27129,
-26941,
-28506,
-30531,
-31951,
-33245,
-35706,
-39645,
-43391,
-44068,
-40047,
-32528,
-25325,
-22013,
-23699,
-28637,
-34388,
-39220,
-41984,
-41388,
-36994,
-31197,
-28509,
-31871,
-39012,
-44076,
-43232,
-38297,
-34295,
-33605,
-33770,
-30907,
-24618,
-18644,
-17339,
-21945,
-30172,
-37885,
-41304,
-38656,
-31644,
-25183,
-24517,
-31166,
-41655,
-50346,
-53813,
-52317,
-48079,
-42868,
-37172,
-31005,
-24726,
-19921,
-19622,
-26804,
-40935,
-55867,
-62792,
-57278,
-43341,
-30113,
-23925,
-24593,
-28674,
-34593,
-42589,
-50906,
-54628,
-50186,
-39908,
-30267,
-25325,
-23294,
-19853,
-14276,
-10428,
-12583,
-20890,
-31667,
-40803,
-46304,
-47949,
-46173,
-41951,
-37232,
-34823,
-36875,
-43482,
-52322,
-59597,
-62217,
-59368,
-52418,
-43280,
-33155,
-23395,
-16980,
-17148,
-23774,
-31059,
-31700,
-23936,
-14555,
-13045,
-22381,
-35749,
-42722,
-38411,
-26761,
-15950,
-11477,
-13420,
-18631,
-24369,
-29990,
-36193,
-43257,
-49634,
-52218,
-48430,
-38975,
-28433,
-22626,
-24213,
-30825,
-37189,
-39437,
-37685,
-34705,
-32856,
-32000,
-30456,
-27440,
-24227,
-23065,
-24646,
-27400,
-29288,
-30151,
-31614,
-34308,
-35800,
-32366,
-23321,
-13060,
-8267,
-12763,
-24974,
-39998,
-52827,
-60260,
-60759,
-54875,
-45515,
-36828,
-31273,
-28488,
-27303,
-28864,
-35563,
-46787,
-56489,
-57395,
-47838,
-33623,
-22495,
-17249,
-15381,
-14271,
-14921,
-19553,
-27223,
-33758,
-36460,
-36943,
-38249,
-39974,
-38183,
-30595,
-20769,
-15622,
-19030,
-28216,
-36752,
-40056,
-38351,
-35064,
-33539,
-34732,
-36733,
-36002,
-30375,
-21802,
-16390,
-19744,
-31557,
-44837,
-51440,
-48879,
-41597,
-35941,
-34242,
-33956,
-31346,
-25319,
-18002,
-12964,
-13298,
-20410,
-32654,
-45175,
-52081,
-50649,
-43471,
-36196,
-32278,
-30495,
-27207,
-21050,
-14714,
-12501,
-16579,
-25476,
-35340,
-42213,
-43451,
-38756,
-30371,
-22254,
-17912,
-18576,
-23311,
-30664,
-39567,
-48679,
-55349,
-56558,
-51170,
-41081,
-29907,
-20722,
-15189,
-13988,
-17087,
-22766,
-27852,
-29780,
-29446,
-30696,
-36863,
-46882,
-55748,
-58211,
-52364,
-40061,
-25213,
-12306,
-5693,
-8271,
-19371,
-34006,
-45191,
-48308,
-43743,
-36004,
-30223,
-28871,
-30756,
-32336,
-30628,
-25713,
-20816,
-19474,
-22032,
-25310,
-26029,
-24303,
-23182,
-24405,
-26001,
-24329,
-18902,
-13316,
-11918,
-15489,
-21131,
-25570,
-27569,
-27649,
-26879,
-26871,
-29851,
-36717,
-44735,
-48529,
-44891,
-36452,
-29557,
-28217,
-31030,
-34021,
-35432,
-36491,
-37899,
-37987,
-34758,
-29338,
-25235,
-24862,
-27483,
-31448,
-36281,
-42006,
-46564,
-46880,
-42404,
-36593,
-32986,
-30588,
-25450,
-16425,
-7980,
-5170,
-7494,
-10032,
-10678,
-13718,
-23652,
-37279,
-44744,
-39874,
-27410,
-18127,
-17854,
-23264,
-28314,
-31572,
-35187,
-38895,
-38517,
-31863,
-22964,
-18286,
-19215,
-20889,
-18958,
-14964,
-13944,
-17528,
-22340,
-24593,
-24372,
-23939,
-24181,
-24407,
-25711,
-30797,
-39777,
-47534,
-48081,
-41306,
-33625,
-31142,
-33650,
-36637,
-37683,
-38591,
-41091,
-43026,
-40871,
-35036,
-30218,
-29897,
-32289,
-32996,
-30759,
-28569,
-29127,
-31042,
-30741,
-27000,
-22032,
-18136,
-15243,
-12400,
-10478,
-11674,
-16371,
-22427,
-27972,
-33925,
-41809,
-49884,
-52808,
-47254,
-36281,
-27664,
-26791,
-32358,
-38952,
-42805,
-44442,
-45763,
-46970,
-46415,
-43256,
-38286,
-32446,
-25358,
-16835,
-9018,
-6121,
-10747,
-20973,
-31328,
-37042,
-37198,
-34007,
-30034,
-26548,
-24065,
-23162,
-24016,
-25679,
-26959,
-28291,
-31939,
-39479,
-49092,
-56063,
-56439,
-50057,
-40129,
-30479,
-23842,
-21947,
-25541,
-33305,
-41451,
-46182,
-46694,
-45386,
-44324,
-42746,
-38632,
-32375,
-26817,
-23747,
-21339,
-17227,
-12766,
-12971,
-20654,
-32684,
-42560,
-46517,
-45466,
-41778,
-36368,
-30224,
-26706,
-29425,
-37630,
-45652,
-48548,
-47030,
-45447,
-45756,
-45669,
-43358,
-40953,
-41916,
-45454,
-47018,
-44257,
-40456,
-39721,
-40716,
-37727,
-28719,
-19347,
-17119,
-22561,
-28598,
-29008,
-25303,
-24283,
-29943,
-39760,
-48271,
-52328,
-52141,
-49264,
-45339,
-42292,
-41504,
-41913,
-40368,
-35029,
-28046,
-23552,
-23258,
-25287,
-27790,
-32035,
-40313,
-51036,
-57800,
-54675,
-41782,
-25373,
-12375,
-6117,
-6472,
-12519,
-23226,
-36044,
-46657,
-51119,
-48802,
-41879,
-33187,
-24029,
-15168,
-8432,
-6845,
-12395,
-23979,
-37628,
-48996,
-55645,
-57242,
-54027,
-45918,
-33188,
-18390,
-6163,
-1145,
-4976,
-15694,
-29458,
-42675,
-52524,
-56859,
-54604,
-47148,
-37979,
-30630,
-26330,
-24436,
-24304,
-26019,
-28721,
-29611,
-26084,
-19278,
-14271,
-15633,
-23212,
-32612,
-39917,
-44383,
-46427,
-44757,
-37253,
-25434,
-15746,
-14917,
-23546,
-35279,
-42404,
-42102,
-36922,
-30701,
-25201,
-20691,
-18105,
-19150,
-24384,
-32119,
-39655,
-45077,
-47513,
-46034,
-39571,
-28356,
-15314,
-5342,
-2421,
-6988,
-15615,
-23339,
-26973,
-26825,
-25810,
-26474,
-28870,
-30805,
-30445,
-28189,
-26233,
-26183,
-27541,
-28272,
-26869,
-23275,
-18714,
-14578,
-12304,
-13281,
-18386,
-26893,
-35847,
-41187,
-40108,
-33252,
-24491,
-18707,
-18471,
-22814,
-28416,
-32232,
-33001,
-30872,
-26440,
-20653,
-15453,
-13511,
-16443,
-23333,
-31006,
-36325,
-37795,
-35977,
-32439,
-29223,
-28306,
-30553,
-34850,
-38374,
-38843,
-36362,
-33161,
-31397,
-31518,
-32624,
-33880,
-34930,
-35355,
-34345,
-31358,
-26935,
-22463,
-19327,
-18356,
-19778,
-23029,
-26431,
-27694,
-25441,
-20693,
-16461,
-15463,
-18317,
-23310,
-28228,
-31777,
-33913,
-34956,
-34755,
-32675,
-28510,
-23276,
-19039,
-17591,
-18858,
-21455,
-24098,
-27124,
-31529,
-37104,
-42007,
-44309,
-43764,
-41416,
-38107,
-34246,
-31022,
-30625,
-33906,
-38173,
-38702,
-33359,
-25137,
-19323,
-18143,
-19283,
-19556,
-18943,
-19768,
-22333,
-23275,
-19191,
-11436,
-6055,
-8272,
-17819,
-29565,
-38649,
-43746,
-46028,
-45622,
-40834,
-30759,
-18345,
-9914,
-10891,
-21514,
-36157,
-47205,
-50145,
-46150,
-40016,
-35704,
-33289,
-29951,
-23890,
-16950,
-13122,
-14276,
-17652,
-18287,
-14104,
-8436,
-6780,
-11545,
-19826,
-27002,
-31006,
-33141,
-34882,
-35708,
-34628,
-32789,
-32898,
-35784,
-38780,
-38380,
-34339,
-29537,
-26566,
-25141,
-24152,
-24483,
-28292,
-35084,
-40518,
-40245,
-34859,
-29217,
-27274,
-28161,
-28427,
-26468,
-23830,
-22218,
-21292,
-20148,
-19724,
-22052,
-27181,
-32062,
-33549,
-31316,
-27459,
-23486,
-19364,
-15301,
-13072,
-14287,
-18094,
-22031,
-25299,
-29667,
-36457,
-43188,
-45151,
-40378,
-32278,
-26516,
-25849,
-28631,
-31913,
-34660,
-37548,
-40647,
-42529,
-41805,
-38831,
-35453,
-33306,
-32651,
-32140,
-30062,
-25799,
-21150,
-19668,
-23711,
-31718,
-38996,
-42025,
-41837,
-42247,
-44810,
-46573,
-43411,
-34978,
-25198,
-18185,
-14994,
-15084,
-19171,
-28628,
-41676,
-52293,
-54935,
-50219,
-44563,
-43478,
-46127,
-47117,
-43035,
-35770,
-29590,
-26527,
-25749,
-26538,
-29646,
-35097,
-40003,
-40538,
-36073,
-30300,
-27521,
-28628,
-31715,
-35634,
-41403,
-49000,
-54918,
-54353,
-46905,
-37821,
-32958,
-32729,
-32666,
-29837,
-26761,
-28389,
-35619,
-44471,
-51095,
-55893,
-61139,
-65532,
-64205,
-54409,
-40372,
-29901,
-26919,
-28881,
-31552,
-34650,
-40668,
-49566,
-56566,
-56836,
-50617,
-42584,
-36776,
-33626,
-32369,
-33934,
-39741,
-47958,
-53379,
-51914,
-44919,
-37540,
-33648,
-32663,
-32092,
-31266,
-32116,
-36509,
-43813,
-51418,
-56811,
-58856,
-57848,
-55076,
-52203,
-50174,
-47978,
-43350,
-35061,
-25039,
-17248,
-14542,
-16411,
-20346,
-24781,
-30232,
-37407,
-44827,
-49247,
-48551,
-43945,
-39040,
-36771,
-37420,
-39422,
-41091,
-41822,
-41321,
-39616,
-37192,
-35582,
-36211,
-39049,
-42505,
-45032,
-46529,
-47795,
-48878,
-48662,
-46364,
-42778,
-39756,
-38019,
-36537,
-33583,
-28654,
-22876,
-18149,
-16083,
-17339,
-21204,
-25757,
-29038,
-30645,
-31955,
-34051,
-36060,
-35772,
-32485,
-28379,
-26590,
-28368,
-32196,
-35624,
-36759,
-34804,
-30352,
-26366,
-27447,
-35798,
-47535,
-54158,
-49840,
-36913,
-23453,
-15595,
-13286,
-13570,
-15959,
-22322,
-32302,
-41066,
-43438,
-39227,
-33253,
-30243,
-30874,
-32740,
-33686,
-33199,
-31893,
-31051,
-32737,
-38043,
-44663,
-47091,
-41326,
-29538,
-18895,
-15396,
-19166,
-25861,
-31737,
-35927,
-39076,
-41131,
-41590,
-40498,
-37990,
-33415,
-26117,
-17474,
-11059,
-9781,
-13425,
-19334,
-25150,
-29901,
-32684,
-32097,
-27931,
-22843,
-20741,
-22929,
-26813,
-28700,
-27523,
-25247,
-24111,
-24599,
-26308,
-29243,
-33500,
-37506,
-38210,
-33624,
-25321,
-17705,
-14792,
-17524,
-23715,
-30338,
-35268,
-37550,
-36589,
-31999,
-24673,
-17470,
-14174,
-16530,
-22338,
-26744,
-26097,
-20823,
-14647,
-11419,
-12887,
-18879,
-28334,
-39330,
-48588,
-52386,
-48709,
-38739,
-26007,
-14439,
-6906,
-4994,
-8639,
-16025,
-24139,
-30310,
-33309,
-33061,
-30013,
-25292,
-21050,
-19450,
-20710,
-22673,
-23006,
-21449,
-19553,
-18292,
-17207,
-16120,
-16507,
-20021,
-25806,
-30544,
-31658,
-29591,
-26479,
-23580,
-21044,
-20098,
-23183,
-30797,
-39029,
-41613,
-35352,
-22777,
-9813,
-1171,
-10,
-2602,
-11438,
-22740,
-32766,
-38482,
-39340,
-36754,
-32365,
-27136,
-22109,
-18515,
-16601,
-15238,
-13437,
-12308,
-14272,
-20097,
-27513,
-33039,
-35068,
-34099,
-31042,
-26214,
-20629,
-16749,
-16721,
-19891,
-23088,
-23953,
-23005,
-22435,
-22952,
-23118,
-21311,
-17653,
-13563,
-10448,
-9261,
-10980,
-16012,
-22781,
-27967,
-29076,
-27005,
-25371,
-26771,
-30302,
-32480,
-30788,
-25711,
-19684,
-14625,
-10677,
-7098,
-4270,
-4132,
-8669,
-17133,
-25094,
-27169,
-21805,
-13493,
-9418,
-13021,
-20979,
-26674,
-26276,
-21084,
-14407,
-8039,
-2795,
-823,
-5271,
-16319,
-29190,
-37839,
-40462,
-40069,
-39617,
-38151,
-33246,
-26079,
-21565,
-22837,
-27016,
-28342,
-24653,
-19446,
-17120,
-18356,
-20980,
-24118,
-28853,
-34901,
-38743,
-37213,
-31885,
-28331,
-30403,
-36544,
-42259,
-44689,
-43751,
-39605,
-31625,
-20459,
-10012,
-5055,
-7286,
-14538,
-23648,
-33216,
-42408,
-49242,
-51157,
-47897,
-42030,
-36212,
-30990,
-25983,
-22703,
-23977,
-30330,
-37786,
-40746,
-37008,
-29366,
-22834,
-20611,
-23053,
-28680,
-35112,
-39373,
-38952,
-33502,
-25463,
-18163,
-13894,
-13714,
-18559,
-28775,
-41755,
-51341,
-51527,
-42177,
-30311,
-24902,
-29298,
-39226,
-47616,
-51193,
-51676,
-51704,
-51019,
-47847,
-42909,
-40160,
-42454,
-47041,
-47523,
-40506,
-30001,
-23533,
-24489,
-29010,
-31117,
-29602,
-28674,
-31999,
-37994,
-42088,
-42645,
-42835,
-45762,
-49581,
-48734,
-40530,
-28987,
-21412,
-21801,
-28081,
-35513,
-41313,
-45275,
-47769,
-48394,
-47765,
-48164,
-51280,
-54959,
-54016,
-45547,
-33040,
-24179,
-23839,
-29716,
-35022,
-35110,
-31044,
-27133,
-26217,
-27856,
-30146,
-32089,
-33830,
-35692,
-37761,
-40336,
-43904,
-48358,
-52512,
-54673,
-53619,
-49286,
-42651,
-35807,
-30835,
-28727,
-28297,
-27750,
-27297,
-29866,
-38073,
-50091,
-59483,
-60147,
-51557,
-39250,
-29902,
-26512,
-27609,
-30191,
-32421,
-34137,
-35664,
-37101,
-38076,
-38103,
-37199,
-36382,
-37519,
-41578,
-47141,
-50899,
-50376,
-46247,
-41822,
-40346,
-42925,
-48475,
-54555,
-58004,
-55494,
-45583,
-30793,
-17301,
-11397,
-15349,
-26580,
-40141,
-51808,
-58787,
-59353,
-53205,
-42895,
-33685,
-30285,
-33203,
-38197,
-40290,
-37913,
-33807,
-31575,
-32500,
-35204,
-38111,
-40819,
-43635,
-46018,
-47096,
-46756,
-46074,
-45836,
-45231,
-43058,
-39313,
-35766,
-33810,
-32972,
-31622,
-29067,
-26250,
-24477,
-24424,
-26697,
-32141,
-40510,
-48571,
-51626,
-47831,
-40754,
-36141,
-36029,
-37145,
-35525,
-31918,
-30619,
-33706,
-37632,
-37146,
-31565,
-25798,
-25247,
-30799,
-39398,
-48114,
-56057,
-62488,
-65117,
-61506,
-51788,
-38949,
-26599,
-17305,
-12962,
-14938,
-22443,
-31295,
-36292,
-35815,
-33514,
-34411,
-39726,
-46029,
-49278,
-48384,
-44451,
-38322,
-30307,
-22614,
-19327,
-22970,
-31099,
-38126,
-40532,
-39664,
-38748,
-38651,
-37519,
-34413,
-31475,
-31750,
-35758,
-41329,
-46425,
-50569,
-53377,
-52820,
-46932,
-36730,
-26385,
-19619,
-16663,
-15581,
-15990,
-20084,
-29428,
-41558,
-50823,
-52852,
-47917,
-39818,
-32242,
-26397,
-21715,
-17888,
-15691,
-15992,
-18460,
-21669,
-24364,
-26721,
-29570,
-32598,
-33677,
-31109,
-26683,
-25540,
-31390,
-41605,
-47997,
-43750,
-29906,
-14771,
-6849,
-8793,
-17349,
-27722,
-36751,
-42784,
-45051,
-44117,
-42337,
-41936,
-42557,
-41675,
-37871,
-32828,
-29196,
-27035,
-23880,
-18421,
-13036,
-11437,
-14518,
-19605,
-24148,
-28501,
-34407,
-41239,
-45562,
-44682,
-39852,
-34966,
-32584,
-31845,
-30339,
-26695,
-21262,
-14811,
-8277,
-3449,
-3103,
-9154,
-20645,
-34023,
-45240,
-51643,
-51942,
-45749,
-33840,
-19065,
-6150,
-65535,
-1921,
-11706,
-24671,
-34865,
-37286,
-30879,
-19862,
-11239,
-9957,
-15542,
-23609,
-30028,
-33448,
-33842,
-30764,
-24243,
-17317,
-15214,
-20282,
-28123,
-30549,
-23543,
-11861,
-4923,
-8277,
-19540,
-32084,
-41114,
-45685,
-46253,
-42884,
-36436,
-29783,
-25969,
-24799,
-22694,
-16592,
-7718,
-858,
-206,
-6394,
-17100,
-29036,
-38917,
-43615,
-41247,
-33098,
-23324,
-16117,
-12639,
-11219,
-10075,
-9396,
-10251,
-12741,
-15602,
-17744,
-19299,
-20667,
-21639,
-21681,
-21260,
-21672,
-23426,
-25496,
-26844,
-28398,
-31975,
-37151,
-39734,
-35300,
-24524,
-13862,
-10275,
-14722,
-22052,
-26555,
-27083,
-25787,
-23727,
-19581,
-13219,
-8429,
-9702,
-16447,
-22350,
-21941,
-16736,
-13485,
-16311,
-22581,
-27037,
-28496,
-30358,
-34701,
-39020,
-39535,
-37014,
-36097,
-38974,
-41962,
-39674,
-31990,
-24299,
-21348,
-22296,
-23237,
-22714,
-22738,
-24409,
-25259,
-22405,
-17228,
-14636,
-17403,
-22706,
-25723,
-25039,
-23515,
-23450,
-23480,
-20728,
-15610,
-11889,
-12429,
-15665,
-17725,
-17156,
-16539,
-19375,
-26108,
-33990,
-39704,
-41612,
-39564,
-33789,
-25133,
-15585,
-8226,
-5478,
-7826,
-13692,
-20487,
-25759,
-28150,
-28068,
-27445,
-28390,
-30977,
-32894,
-31188,
-25398,
-18808,
-16437,
-21393,
-32271,
-43732,
-49726,
-47073,
-37285,
-25548,
-17610,
-16620,
-21864,
-29725,
-35932,
-37090,
-31954,
-21972,
-11835,
-7732,
-13726,
-27892,
-42487,
-48865,
-43807,
-31426,
-19373,
-12651,
-11165,
-12282,
-14503,
-18437,
-24397,
-30565,
-34215,
-34433,
-32960,
-32106,
-32130,
-31221,
-27783,
-22571,
-18100,
-16839,
-19415,
-24982,
-31750,
-37542,
-39861,
-37047,
-29693,
-21453,
-17256,
-20113,
-28651,
-37714,
-41686,
-38323,
-29909,
-21433,
-17119,
-18366,
-24010,
-31700,
-38835,
-42690,
-41215,
-34772,
-27050,
-23121,
-25648,
-32509,
-38735,
-40487,
-37595,
-32363,
-27147,
-23386,
-22062,
-23531,
-26262,
-26848,
-22884,
-16039,
-11599,
-14014,
-22784,
-33177,
-40307,
-42481,
-40795,
-36942,
-32146,
-27725,
-25001,
-24340,
-24519,
-23935,
-22345,
-21312,
-22823,
-28019,
-36561,
-46470,
-54093,
-55190,
-47617,
-33814,
-20039,
-12808,
-14656,
-23317,
-33598,
-40240,
-40117,
-33284,
-23235,
-15270,
-13532,
-18403,
-26630,
-33602,
-35927,
-32568,
-25054,
-17171,
-13689,
-17729,
-28432,
-41346,
-51293,
-55284,
-53188,
-46709,
-38725,
-32699,
-31083,
-33146,
-35085,
-33691,
-30144,
-29643,
-36162,
-48183,
-59304,
-63711,
-60030,
-51152,
-40712,
-30890,
-22799,
-17959,
-18439,
-24967,
-35028,
-43339,
-45045,
-39869,
-32551,
-28895,
-30565,
-33921,
-34262,
-30315,
-24417,
-19023,
-15076,
-13788,
-17951,
-28784,
-41780,
-48368,
-43606,
-31814,
-22645,
-21897,
-27141,
-32674,
-36532,
-40837,
-46439,
-50082,
-48099,
-41465,
-35211,
-33111,
-34133,
-34371,
-31241,
-25199,
-18784,
-15098,
-16588,
-23442,
-32041,
-36746,
-34194,
-26608,
-19992,
-19288,
-25312,
-35609,
-46567,
-54374,
-55522,
-48875,
-37540,
-27650,
-24039,
-27056,
-33411,
-39407,
-42742,
-42502,
-39158,
-35241,
-34185,
-37525,
-43087,
-47422,
-49223,
-49513,
-48194,
-42885,
-32668,
-22139,
-18894,
-25587,
-35824,
-39546,
-32748,
-20841,
-12714,
-12656,
-18434,
-25437,
-30730,
-33244,
-32737,
-30138,
-28729,
-32477,
-42415,
-54560,
-62381,
-61431,
-51977,
-37697,
-23082,
-11772,
-6971,
-10949,
-23710,
-40886,
-54906,
-59213,
-53234,
-42888,
-35535,
-33707,
-33930,
-31716,
-26858,
-23265,
-23997,
-28225,
-33443,
-38789,
-44748,
-49540,
-49017,
-41315,
-30685,
-24324,
-25237,
-29859,
-33185,
-34584,
-36385,
-38155,
-35483,
-26137,
-15453,
-12709,
-21485,
-35699,
-45540,
-46730,
-42339,
-37341,
-33577,
-30754,
-29604,
-31859,
-37183,
-42562,
-45179,
-45375,
-45063,
-44416,
-41218,
-33835,
-23861,
-15422,
-12175,
-15533,
-24463,
-36073,
-46612,
-52954,
-54297,
-51308,
-44310,
-33043,
-19616,
-10265,
-11354,
-22552,
-34939,
-38600,
-31589,
-21001,
-14868,
-15072,
-18917,
-24927,
-33981,
-44565,
-50603,
-47234,
-37628,
-30915,
-32336,
-37319,
-37482,
-30842,
-23887,
-23113,
-27560,
-31250,
-31454,
-31547,
-35465,
-41819,
-45365,
-43007,
-36448,
-29262,
-23783,
-21588,
-24859,
-34342,
-46189,
-53148,
-50811,
-41883,
-33261,
-29142,
-27943,
-26001,
-22403,
-19369,
-19229,
-22170,
-27269,
-33554,
-39739,
-43768,
-44435,
-42824,
-41290,
-40178,
-37076,
-30133,
-21675,
-17321,
-20807,
-30385,
-40351,
-46139,
-47126,
-45932,
-45351,
-46616,
-48786,
-49375,
-45603,
-36611,
-25081,
-16092,
-13834,
-18350,
-25744,
-30882,
-31098,
-27442,
-23793,
-23820,
-28170,
-33750,
-36331,
-34440,
-30792,
-29328,
-30814,
-32092,
-30028,
-25800,
-24196,
-28485,
-36525,
-42645,
-43025,
-38938,
-34654,
-33270,
-34658,
-37304,
-40138,
-42864,
-44356,
-42841,
-37539,
-30389,
-24750,
-22652,
-23110,
-23799,
-23784,
-24208,
-26107,
-28162,
-27957,
-25037,
-22372,
-23544,
-28902,
-35112,
-38882,
-40205,
-41443,
-43560,
-44428,
-41322,
-34116,
-25553,
-18639,
-15116,
-16041,
-22544,
-33935,
-45892,
-52000,
-48825,
-39422,
-30785,
-27889,
-29543,
-30660,
-27347,
-20430,
-14534,
-14492,
-21930,
-33898,
-44242,
-47239,
-41551,
-31282,
-22832,
-19948,
-21451,
-23666,
-24620,
-25725,
-29524,
-36149,
-42686,
-45412,
-43234,
-38427,
-34687,
-34182,
-36111,
-38169,
-38595,
-37302,
-34914,
-31796,
-28544,
-27064,
-29912,
-37585,
-46717,
-52051,
-50764,
-44376,
-36396,
-28518,
-20495,
-13102,
-9593,
-12944,
-21893,
-31488,
-37642,
-40573,
-42786,
-44843,
-44516,
-40304,
-34095,
-29393,
-27359,
-26323,
-25245,
-25650,
-29203,
-33732,
-34232,
-28642,
-21602,
-20607,
-28346,
-39421,
-45756,
-44323,
-39267,
-36385,
-37377,
-39276,
-39304,
-37869,
-37328,
-38237,
-38645,
-36470,
-32116,
-27970,
-26344,
-28295,
-33859,
-42172,
-50354,
-53799,
-48917,
-36897,
-23666,
-15779,
-15482,
-20441,
-27150,
-33887,
-40004,
-43612,
-42155,
-35317,
-26606,
-20803,
-20073,
-23008,
-27457,
-32398,
-37344,
-40388,
-39402,
-34930,
-30913,
-31038,
-34560,
-36928,
-34508,
-28644,
-24150,
-24622,
-29403,
-34660,
-36528,
-33488,
-26744,
-19850,
-16853,
-19777,
-26513,
-31871,
-31607,
-25813,
-18848,
-15448,
-17468,
-23012,
-28325,
-30327,
-28177,
-23988,
-21200,
-21950,
-25155,
-27882,
-28862,
-30047,
-33805,
-38926,
-40477,
-34734,
-23594,
-13645,
-10710,
-15709,
-25576,
-36558,
-45859,
-51116,
-50171,
-43065,
-33234,
-25946,
-24506,
-28160,
-33368,
-36682,
-36649,
-33663,
-29144,
-24657,
-21388,
-19636,
-19148,
-19505,
-20474,
-21687,
-22440,
-22415,
-21989,
-22138,
-23314,
-25429,
-28284,
-31763,
-35065,
-36550,
-35030,
-31391,
-27599,
-24277,
-19802,
-13496,
-8384,
-9681,
-18781,
-30507,
-37419,
-37257,
-34496,
-34268,
-35764,
-33537,
-24766,
-13636,
-7508,
-9708,
-17384,
-25896,
-33471,
-40766,
-47171,
-49789,
-46346,
-38138,
-29037,
-21984,
-17562,
-15098,
-14684,
-16463,
-19604,
-22316,
-23844,
-25044,
-26921,
-28826,
-28828,
-26358,
-23517,
-23644,
-28348,
-35881,
-42521,
-44923,
-42001,
-35206,
-27577,
-22415,
-21416,
-23867,
-27002,
-27821,
-24906,
-18978,
-12541,
-8555,
-9007,
-13265,
-17864,
-18727,
-14851,
-10087,
-10427,
-18402,
-30280,
-38651,
-38734,
-31750,
-23069,
-17166,
-14861,
-14244,
-13476,
-12221,
-11365,
-12040,
-15047,
-20389,
-26985,
-33191,
-37826,
-40944,
-42978,
-43536,
-41035,
-34377,
-24649,
-15227,
-9890,
-10504,
-16036,
-23355,
-29180,
-31741,
-31618,
-30953,
-31962,
-35642,
-41230,
-46746,
-49661,
-48042,
-41566,
-31954,
-22157,
-14686,
-10987,
-11845,
-18048,
-28889,
-40710,
-47681,
-46257,
-38592,
-30984,
-28079,
-29358,
-31651,
-34096,
-38659,
-45385,
-49300,
-44320,
-30927,
-17696,
-13816,
-20320,
-29701,
-34457,
-34085,
-33557,
-35674,
-37708,
-35526,
-29515,
-24898,
-25916,
-31462,
-36377,
-36708,
-32458,
-26370,
-20833,
-17011,
-15509,
-16948,
-21174,
-26506,
-30166,
-29938,
-25758,
-20307,
-17801,
-21428,
-30586,
-40848,
-46917,
-46636,
-41959,
-35996,
-29588,
-21411,
-11365,
-2916,
-1142,
-8383,
-22089,
-36921,
-48440,
-54773,
-55905,
-52293,
-44809,
-35002,
-25023,
-17218,
-13688,
-15754,
-22901,
-32475,
-40962,
-46463,
-48985,
-48792,
-44590,
-35238,
-22813,
-12899,
-10242,
-14566,
-21388,
-26928,
-30881,
-34015,
-34959,
-31577,
-25508,
-22867,
-28195,
-38435,
-44492,
-39796,
-26341,
-12197,
-4366,
-4906,
-12532,
-24663,
-37279,
-45317,
-46288,
-43657,
-43861,
-48579,
-51851,
-46541,
-33779,
-23068,
-22433,
-29870,
-36327,
-36033,
-31534,
-28476,
-28026,
-27014,
-23860,
-21578,
-23225,
-26956,
-27821,
-24342,
-21054,
-23567,
-32327,
-42351,
-48409,
-48829,
-44658,
-37257,
-28404,
-21533,
-20594,
-26636,
-36446,
-45497,
-51843,
-56238,
-59115,
-58832,
-53799,
-45278,
-36907,
-31239,
-27771,
-24478,
-20763,
-17962,
-17483,
-19438,
-22997,
-27566,
-32368,
-35819,
-35981,
-32429,
-26933,
-22053,
-18901,
-17196,
-16827,
-19163,
-25770,
-36181,
-47050,
-53747,
-52894,
-44454,
-31899,
-21000,
-16433,
-19004,
-25160,
-30552,
-34422,
-39658,
-48307,
-57112,
-59435,
-52119,
-39631,
-30168,
-27490,
-28018,
-26158,
-21422,
-18746,
-22067,
-29365,
-35050,
-36009,
-34003,
-32237,
-31431,
-30226,
-27940,
-25306,
-22580,
-18722,
-13778,
-10613,
-12938,
-21127,
-31260,
-38765,
-41954,
-41939,
-39931,
-36688,
-33882,
-33972,
-37078,
-39308,
-36339,
-28938,
-23307,
-24630,
-31138,
-36040,
-35221,
-31203,
-29194,
-30264,
-30505,
-26241,
-18508,
-11645,
-8788,
-10137,
-15052,
-23450,
-34421,
-44273,
-48101,
-43912,
-34687,
-26095,
-22188,
-23283,
-26983,
-30297,
-30978,
-28221,
-23162,
-18556,
-16997,
-18984,
-22534,
-25170,
-26092,
-26406,
-27650,
-30175,
-33003,
-34812,
-34647,
-32288,
-28315,
-24149,
-21621,
-21763,
-24028,
-26730,
-28588,
-29522,
-29961,
-29475,
-27049,
-22985,
-19997,
-21608,
-28679,
-37847,
-43825,
-43402,
-37524,
-29842,
-24133,
-22511,
-25052,
-29674,
-32633,
-30872,
-24681,
-18190,
-15835,
-18439,
-23047,
-26569,
-29144,
-32706,
-37481,
-40611,
-38882,
-32279,
-23869,
-17293,
-14404,
-15400,
-19685,
-25832,
-31541,
-34741,
-35181,
-34547,
-34658,
-35782,
-37022,
-37577,
-37388,
-36515,
-34884,
-32835,
-31536,
-32138,
-34599,
-37687,
-40099,
-41353,
-41407,
-40076,
-37036,
-32692,
-28204,
-25040,
-24133,
-25741,
-29481,
-34614,
-39983,
-44632,
-47610,
-48152,
-45492,
-39625,
-31965,
-24880,
-20593,
-19903,
-22589,
-27794,
-34225,
-39910,
-43075,
-43482,
-42777,
-42652,
-43174,
-43086,
-41810,
-40001,
-38062,
-34792,
-29073,
-22468,
-19184,
-22242,
-30350,
-38917,
-44281,
-45895,
-44560,
-40274,
-32803,
-24386,
-19828,
-22547,
-31248,
-40678,
-46485,
-48165,
-47694,
-46242,
-43411,
-39587,
-37342,
-39456,
-45316,
-50629,
-51230,
-47116,
-42179,
-39864,
-39856,
-39234,
-36423,
-32918,
-31258,
-31823,
-32786,
-32510,
-31221,
-30093,
-29595,
-29837,
-31583,
-35763,
-41465,
-45683,
-46280,
-44417,
-42739,
-41167,
-36152,
-25848,
-14607,
-10564,
-17587,
-31097,
-42790,
-48567,
-50609,
-51892,
-51685,
-47417,
-40085,
-34696,
-34998,
-39041,
-41413,
-39283,
-34989,
-33076,
-35702,
-41523,
-47549,
-51244,
-51682,
-49904,
-48405,
-48722,
-48972,
-44987,
-35207,
-24224,
-19774,
-25203,
-35868,
-43275,
-43046,
-37696,
-32700,
-31079,
-32356,
-34887,
-37640,
-39599,
-39477,
-37164,
-34621,
-34331,
-36551,
-39027,
-39683,
-38881,
-38678,
-40237,
-42798,
-44879,
-45581,
-44567,
-41508,
-36465,
-30860,
-27025,
-26634,
-29516,
-34083,
-38507,
-41399,
-41716,
-39207,
-34664,
-29470,
-24383,
-19309,
-14516,
-11711,
-12773,
-17455,
-23077,
-27207,
-30344,
-34895,
-41589,
-47644,
-49337,
-45837,
-39803,
-34034,
-28826,
-22782,
-15886,
-10204,
-7940,
-9490,
-14495,
-23254,
-35907,
-49497,
-57610,
-54839,
-41939,
-26049,
-14949,
-11263,
-12240,
-14218,
-16195,
-19146,
-23566,
-28745,
-34139,
-39347,
-42856,
-41759,
-34891,
-25770,
-20629,
-22586,
-28298,
-31747,
-31220,
-30620,
-33886,
-38849,
-39203,
-31846,
-20863,
-12875,
-9787,
-7945,
-4338,
-1406,
-3934,
-12463,
-21551,
-25848,
-25731,
-25907,
-28706,
-30865,
-27381,
-17763,
-6995,
-1093,
-2541,
-9685,
-19087,
-27208,
-31379,
-30952,
-28234,
-27076,
-29155,
-32210,
-32460,
-28936,
-24343,
-21438,
-19663,
-16220,
-10147,
-4005,
-1286,
-2837,
-6632,
-10562,
-14156,
-18022,
-21924,
-24598,
-24741,
-21906,
-17008,
-12360,
-11265,
-15575,
-23469,
-29670,
-29954,
-25155,
-20284,
-19093,
-20173,
-19239,
-14854,
-10699,
-11871,
-19611,
-30301,
-38970,
-42951,
-42428,
-38821,
-33752,
-28650,
-23990,
-19019,
-12600,
-5667,
-1238,
-1733,
-5991,
-10344,
-12777,
-15091,
-19988,
-26570,
-30378,
-28357,
-23008,
-20133,
-22670,
-27825,
-30720,
-30292,
-29995,
-32966,
-37370,
-37749,
-30963,
-19939,
-11343,
-9797,
-14766,
-22690,
-30805,
-38378,
-44581,
-46964,
-43113,
-33923,
-24143,
-18945,
-19949,
-24740,
-29978,
-34049,
-36714,
-37202,
-34195,
-27890,
-20849,
-15966,
-13750,
-12435,
-11119,
-11159,
-14177,
-19008,
-22077,
-21559,
-19940,
-21739,
-28486,
-36810,
-41453,
-39972,
-34070,
-27298,
-22306,
-20117,
-20822,
-24109,
-28992,
-34152,
-38686,
-42691,
-46583,
-50043,
-51467,
-48716,
-40773,
-29258,
-18457,
-13131,
-15227,
-22568,
-30992,
-38140,
-44494,
-50458,
-53485,
-49443,
-37709,
-23836,
-15749,
-17067,
-24402,
-31513,
-35165,
-36622,
-38299,
-40315,
-41024,
-39611,
-37349,
-36111,
-36532,
-37779,
-38431,
-37413,
-34313,
-30059,
-26843,
-26985,
-30797,
-35989,
-39305,
-39464,
-37695,
-36149,
-35454,
-34483,
-32079,
-28808,
-26678,
-27227,
-29882,
-32377,
-33029,
-32601,
-33632,
-37409,
-42034,
-43909,
-41802,
-38502,
-37829,
-39967,
-40838,
-36890,
-29633,
-24441,
-24778,
-28893,
-32660,
-34668,
-36569,
-39033,
-39158,
-33913,
-25207,
-19507,
-21737,
-30289,
-39231,
-44536,
-46710,
-47753,
-47310,
-43501,
-36661,
-30134,
-26997,
-26978,
-27632,
-27831,
-28617,
-30777,
-33313,
-35007,
-36936,
-41171,
-47268,
-50856,
-47583,
-37967,
-27825,
-23530,
-26983,
-35158,
-43285,
-48138,
-48786,
-45756,
-40376,
-34183,
-28494,
-23934,
-20856,
-20046,
-22487,
-28150,
-35066,
-40003,
-40629,
-37076,
-32102,
-29357,
-31151,
-36848,
-43071,
-45961,
-43765,
-37966,
-31883,
-28462,
-29098,
-33664,
-40682,
-47276,
-50163,
-48133,
-43615,
-41012,
-42535,
-46156,
-48091,
-46991,
-44871,
-43569,
-41728,
-36328,
-27078,
-18117,
-14342,
-16880,
-22503,
-27451,
-30693,
-33355,
-36058,
-37995,
-38469,
-38240,
-38565,
-39384,
-39241,
-36995,
-33492,
-30796,
-30436,
-31910,
-33253,
-32617,
-29913,
-27179,
-27215,
-31528,
-38800,
-45866,
-49724,
-49289,
-45234,
-39013,
-32473,
-27602,
-25669,
-25868,
-25564,
-22781,
-18325,
-14984,
-14300,
-15259,
-16349,
-18166,
-22454,
-28464,
-31959,
-29234,
-22039,
-16895,
-19149,
-27780,
-36966,
-41710,
-41350,
-37837,
-32475,
-25397,
-17603,
-11656,
-9899,
-12368,
-17459,
-23914,
-31829,
-41127,
-50224,
-56373,
-57445,
-53291,
-45389,
-35998,
-27029,
-19656,
-14210,
-10864,
-10320,
-13683,
-21297,
-31629,
-41623,
-48309,
-50174,
-47491,
-41664,
-34581,
-28022,
-23107,
-20173,
-19251,
-20470,
-23497,
-26656,
-27471,
-25021,
-21448,
-20718,
-24799,
-32090,
-39010,
-43303,
-44720,
-43502,
-39310,
-32533,
-25558,
-21465,
-21195,
-22874,
-24102,
-24318,
-24302,
-24334,
-24041,
-24303,
-27104,
-33039,
-38778,
-39742,
-34824,
-28206,
-24852,
-25382,
-26189,
-24763,
-22829,
-23598,
-26593,
-27569,
-23894,
-18454,
-17035,
-21714,
-28587,
-32390,
-32401,
-32788,
-37108,
-43928,
-48333,
-47110,
-41507,
-35076,
-29876,
-25973,
-23495,
-24182,
-29304,
-36960,
-42415,
-42170,
-37592,
-33851,
-34769,
-38976,
-41211,
-37699,
-29800,
-22431,
-19172,
-19403,
-20046,
-19451,
-18705,
-19456,
-21345,
-22380,
-21713,
-21120,
-23262,
-28895,
-36102,
-42187,
-45649,
-45942,
-42621,
-35326,
-25408,
-16250,
-11264,
-11448,
-14774,
-18516,
-21382,
-23833,
-26782,
-30431,
-34145,
-36849,
-37313,
-34920,
-30255,
-25093,
-21021,
-18512,
-17425,
-18325,
-22459,
-29765,
-37607,
-42200,
-41580,
-36809,
-30294,
-23686,
-17852,
-14017,
-13657,
-17006,
-22538,
-28518,
-34268,
-39314,
-41745,
-39342,
-32704,
-26263,
-24682,
-28343,
-33323,
-35812,
-35433,
-33851,
-31822,
-29127,
-27433,
-30290,
-39235,
-50271,
-56504,
-54130,
-45596,
-36072,
-28602,
-23103,
-19197,
-17773,
-19672,
-23917,
-28864,
-33706,
-38377,
-41658,
-41724,
-38458,
-34633,
-33188,
-34026,
-34647,
-33366,
-30964,
-28244,
-24079,
-17249,
-9785,
-6401,
-9699,
-17059,
-23576,
-27199,
-29660,
-32455,
-34016,
-31933,
-26935,
-22489,
-20849,
-20980,
-21581,
-24083,
-30897,
-40444,
-46399,
-43245,
-32298,
-20839,
-15540,
-17126,
-21516,
-24573,
-24889,
-23373,
-21753,
-21941,
-25164,
-30128,
-32991,
-30093,
-21972,
-13362,
-9280,
-11103,
-17174,
-25760,
-36028,
-45714,
-49742,
-43635,
-28652,
-12592,
-4415,
-7492,
-18078,
-29402,
-36678,
-38967,
-37845,
-35631,
-33818,
-32204,
-28969,
-22852,
-15662,
-11847,
-14301,
-20775,
-25525,
-25335,
-22960,
-23611,
-28305,
-31944,
-28826,
-19064,
-8785,
-3918,
-5210,
-8994,
-12089,
-14201,
-16524,
-19331,
-22251,
-25493,
-29891,
-35098,
-38953,
-39305,
-35750,
-29686,
-22517,
-15523,
-10605,
-10616,
-16935,
-27391,
-37107,
-42177,
-42164,
-39004,
-34233,
-28183,
-21566,
-16412,
-14614,
-15817,
-18156,
-20892,
-25627,
-33423,
-41598,
-44243,
-37506,
-23803,
-10602,
-4295,
-5826,
-11567,
-18013,
-24531,
-31944,
-39591,
-44871,
-45823,
-43347,
-40429,
-38968,
-37897,
-34513,
-27630,
-19384,
-13883,
-13856,
-18575,
-24558,
-28719,
-30925,
-33470,
-38216,
-43890,
-46877,
-44692,
-38665,
-32884,
-30360,
-30381,
-29835,
-26724,
-21945,
-17975,
-16227,
-16342,
-17388,
-18881,
-20603,
-22095,
-23180,
-24859,
-28723,
-35268,
-42986,
-49414,
-52993,
-53168,
-49660,
-42283,
-32569,
-24250,
-21098,
-23498,
-27987,
-30662,
-30906,
-31224,
-33650,
-37662,
-41489,
-44914,
-48921,
-52894,
-53755,
-49164,
-41323,
-36115,
-37574,
-43622,
-48075,
-46553,
-40084,
-32957,
-28191,
-25988,
-25539,
-27042,
-30863,
-35761,
-39354,
-40472,
-40732,
-42875,
-47901,
-53945,
-57822,
-57241,
-51903,
-43427,
-34654,
-28456,
-26022,
-26146,
-26732,
-27563,
-30767,
-38180,
-47901,
-54903,
-55378,
-50399,
-45053,
-43708,
-46911,
-51792,
-54921,
-53880,
-47737,
-37481,
-26328,
-18673,
-16811,
-19301,
-22445,
-24203,
-25554,
-28524,
-33217,
-37952,
-41578,
-44763,
-48623,
-52767,
-55473,
-55496,
-52864,
-48226,
-41974,
-34712,
-27826,
-22895,
-20557,
-20726,
-23634,
-29949,
-39056,
-47945,
-53082,
-53669,
-52369,
-52099,
-52626,
-51053,
-45613,
-38135,
-32051,
-28940,
-27753,
-27532,
-29496,
-35537,
-44685,
-52417,
-53801,
-47895,
-38535,
-31343,
-29656,
-32922,
-37960,
-41369,
-41231,
-37624,
-32064,
-26642,
-23092,
-22231,
-24028,
-27507,
-31098,
-32947,
-32086,
-29323,
-26867,
-26766,
-29308,
-33329,
-37725,
-42554,
-47998,
-52886,
-54770,
-52020,
-45688,
-38546,
-32596,
-27649,
-22808,
-18591,
-16838,
-18458,
-21884,
-24487,
-25217,
-25277,
-26163,
-27651,
-28492,
-28653,
-29900,
-33696,
-38759,
-41666,
-40102,
-35123,
-30115,
-27583,
-27264,
-27525,
-27482,
-27696,
-28629,
-29557,
-29433,
-28750,
-29796,
-34234,
-40941,
-46035,
-46238,
-41369,
-34399,
-28508,
-24968,
-23164,
-22149,
-21480,
-20776,
-19402,
-17083,
-14593,
-13182,
-13341,
-14404,
-15803,
-17988,
-21679,
-26136,
-28943,
-28091,
-24281,
-20621,
-20042,
-23026,
-27907,
-32765,
-36531,
-38379,
-36856,
-30691,
-20574,
-10137,
-4233,
-6015,
-14878,
-27195,
-38674,
-46460,
-49356,
-47255,
-40707,
-31434,
-22157,
-15402,
-11958,
-10961,
-11201,
-12471,
-14686,
-16970,
-17726,
-16684,
-15636,
-16914,
-20855,
-25623,
-29404,
-32089,
-34156,
-34779,
-32025,
-25482,
-17749,
-12706,
-12549,
-16937,
-24228,
-32500,
-39088,
-40708,
-36095,
-27921,
-21440,
-19674,
-21101,
-22231,
-22035,
-22600,
-25628,
-29888,
-32855,
-34103,
-35146,
-36425,
-35714,
-30978,
-23671,
-18160,
-17548,
-21145,
-26412,
-31764,
-36837,
-40208,
-39191,
-32489,
-22679,
-14588,
-11426,
-12679,
-15782,
-18780,
-21165,
-22870,
-23751,
-24088,
-24777,
-26580,
-29173,
-31718,
-33789,
-35721,
-37617,
-38831,
-38175,
-35140,
-30241,
-25043,
-21406,
-20571,
-22313,
-24933,
-26696,
-27372,
-27908,
-28790,
-28820,
-26804,
-23698,
-22309,
-24321,
-28117,
-30733,
-31459,
-32354,
-34787,
-36365,
-33169,
-24791,
-16401,
-14149,
-19434,
-27899,
-34448,
-37828,
-40057,
-42037,
-41868,
-37342,
-29858,
-24045,
-23704,
-28544,
-35032,
-40191,
-43659,
-46594,
-48929,
-48865,
-44756,
-37576,
-30979,
-28760,
-31768,
-37158,
-40499,
-39568,
-35883,
-33444,
-34698,
-38563,
-41222,
-39894,
-35056,
-29775,
-26797,
-26675,
-28348,
-30804,
-33853,
-37333,
-40539,
-42730,
-43970,
-45061,
-46239,
-46696,
-45465,
-42968,
-40923,
-40674,
-41606,
-41778,
-39954,
-36948,
-34649,
-34151,
-34895,
-35583,
-35536,
-34965,
-34241,
-33351,
-31987,
-30101,
-28137,
-26933,
-27577,
-30893,
-36616,
-42778,
-46329,
-45056,
-39246,
-31424,
-24426,
-19625,
-17033,
-16652,
-19060,
-24694,
-32470,
-39942,
-44820,
-46352,
-45411,
-43167,
-40106,
-36094,
-31085,
-25815,
-21530,
-19767,
-21488,
-26586,
-33174,
-38160,
-39121,
-36491,
-33857,
-35080,
-40678,
-46678,
-48256,
-44226,
-38456,
-35945,
-38091,
-41883,
-43646,
-42549,
-40169,
-37376,
-33479,
-28699,
-26316,
-30189,
-39864,
-49116,
-50988,
-44109,
-33851,
-26617,
-24235,
-23894,
-23187,
-23659,
-28921,
-39885,
-52415,
-59914,
-57916,
-46897,
-31555,
-17975,
-10723,
-11057,
-16988,
-24785,
-31024,
-33995,
-33785,
-31591,
-29003,
-27335,
-27023,
-27578,
-28196,
-28937,
-30847,
-34749,
-39764,
-43309,
-42726,
-37423,
-29332,
-22084,
-18841,
-20601,
-25423,
-29603,
-30522,
-28974,
-28481,
-31581,
-36564,
-38530,
-34247,
-25768,
-18863,
-17633,
-21197,
-25640,
-28367,
-30206,
-33071,
-37244,
-41010,
-42542,
-41112,
-36774,
-30209,
-23762,
-21384,
-25985,
-36009,
-45540,
-49152,
-46416,
-41430,
-37657,
-34512,
-28980,
-20311,
-11199,
-5250,
-3750,
-6041,
-11568,
-20079,
-29752,
-36669,
-37748,
-33846,
-29249,
-27380,
-28018,
-28456,
-27029,
-24277,
-21279,
-18130,
-14590,
-11640,
-11126,
-13800,
-18442,
-23060,
-26666,
-29270,
-30748,
-30462,
-28221,
-25131,
-23026,
-23124,
-25404,
-28819,
-31796,
-32676,
-30758,
-27059,
-23980,
-23004,
-22973,
-21012,
-15586,
-8565,
-3869,
-4266,
-9327,
-16425,
-22650,
-26506,
-27979,
-28287,
-28759,
-29388,
-28197,
-23004,
-14567,
-7539,
-6967,
-13396,
-21781,
-26275,
-25888,
-24871,
-27490,
-33096,
-37261,
-36914,
-33655,
-31205,
-30670,
-29540,
-25111,
-18297,
-12995,
-11945,
-14032,
-15652,
-14615,
-12111,
-11387,
-14554,
-20911,
-27653,
-32088,
-33386,
-32441,
-30424,
-27344,
-22661,
-17166,
-13932,
-16154,
-23654,
-31840,
-35315,
-32517,
-26666,
-21952,
-19482,
-17599,
-15386,
-14454,
-16908,
-22341,
-28281,
-33025,
-36909,
-40372,
-41862,
-39247,
-32915,
-26249,
-22424,
-21456,
-21339,
-21386,
-23067,
-27297,
-32000,
-33898,
-32119,
-29345,
-28724,
-30720,
-33338,
-34764,
-34834,
-33760,
-31207,
-26993,
-22573,
-20451,
-21625,
-24766,
-27508,
-29171,
-30602,
-32402,
-33518,
-32572,
-29930,
-27940,
-28695,
-31797,
-34424,
-33886,
-29860,
-24630,
-21211,
-21016,
-23433,
-26765,
-29984,
-33033,
-35921,
-37675,
-36645,
-32001,
-25223,
-19509,
-17896,
-20856,
-25889,
-29141,
-28225,
-23979,
-19649,
-18196,
-19891,
-22586,
-24159,
-24446,
-24848,
-26025,
-26828,
-25546,
-22154,
-18811,
-18125,
-21096,
-26406,
-31604,
-34319,
-33507,
-29793,
-25481,
-23226,
-24233,
-27445,
-30503,
-31877,
-31756,
-31391,
-31626,
-32625,
-33993,
-35271,
-35636,
-34358,
-31352,
-27643,
-24550,
-22790,
-22458,
-23681,
-26770,
-31290,
-35576,
-37786,
-37662,
-36607,
-35961,
-35499,
-34330,
-32879,
-33200,
-36511,
-41081,
-43081,
-40096,
-33427,
-26671,
-22516,
-21074,
-21199,
-22610,
-26073,
-31949,
-38918,
-44665,
-47292,
-46226,
-41910,
-35382,
-28332,
-22918,
-20952,
-22731,
-26904,
-31629,
-35981,
-39900,
-43190,
-44664,
-42955,
-38019,
-31728,
-26792,
-25106,
-27094,
-32017,
-38577,
-44719,
-47840,
-45824,
-38748,
-29289,
-21269,
-17252,
-17441,
-20513,
-25041,
-29966,
-34098,
-35972,
-35133,
-33198,
-33299,
-37297,
-43591,
-48053,
-47628,
-43194,
-38387,
-35712,
-34413,
-32525,
-30464,
-31086,
-35686,
-41066,
-42304,
-38642,
-35064,
-36763,
-42525,
-45662,
-41653,
-33617,
-28619,
-29568,
-32635,
-33259,
-32096,
-33411,
-37960,
-40913,
-37321,
-28783,
-21816,
-20561,
-22958,
-24649,
-24928,
-26751,
-31831,
-38073,
-42627,
-45528,
-48524,
-51142,
-49937,
-42736,
-32066,
-23384,
-20253,
-22319,
-27366,
-33759,
-40069,
-44189,
-44297,
-41156,
-37738,
-36273,
-36123,
-35324,
-33388,
-31741,
-31594,
-32714,
-34540,
-37259,
-40693,
-42497,
-39521,
-31354,
-22124,
-17275,
-18773,
-23939,
-29095,
-33271,
-37842,
-43187,
-47108,
-47158,
-43954,
-41022,
-41133,
-43029,
-42446,
-36584,
-27599,
-21192,
-21717,
-28479,
-36903,
-43192,
-47360,
-51626,
-56696,
-59975,
-58607,
-52682,
-45772,
-41545,
-40845,
-41783,
-42215,
-41462,
-40142,
-39224,
-39598,
-42042,
-46478,
-51418,
-54289,
-53060,
-47736,
-40171,
-32963,
-28042,
-26191,
-27029,
-29492,
-32293,
-34801,
-37157,
-40024,
-43698,
-47488,
-49949,
-49828,
-47294,
-44233,
-42718,
-43076,
-43120,
-40356,
-34838,
-29788,
-28900,
-33077,
-39991,
-46191,
-49422,
-48812,
-44772,
-39230,
-35574,
-36377,
-40866,
-45146,
-46356,
-45192,
-44031,
-42550,
-37563,
-27980,
-18250,
-14798,
-18787,
-24493,
-25782,
-22899,
-21200,
-23767,
-27773,
-29105,
-28617,
-31270,
-39248,
-48036,
-50678,
-45055,
-35260,
-26752,
-21451,
-18465,
-17574,
-20225,
-27194,
-36665,
-45423,
-51297,
-53818,
-53265,
-49942,
-44730,
-38982,
-33761,
-29027,
-24524,
-21169,
-20789,
-24728,
-32206,
-40806,
-47439,
-49600,
-46004,
-37450,
-26940,
-18435,
-14385,
-14415,
-16239,
-18050,
-20092,
-24000,
-30807,
-39315,
-46244,
-48342,
-45159,
-40009,
-37656,
-40292,
-45341,
-47800,
-44523,
-36489,
-27175,
-19680,
-15973,
-17416,
-24214,
-33751,
-40845,
-41757,
-37912,
-34819,
-36310,
-40719,
-43015,
-40474,
-34980,
-30059,
-26990,
-24562,
-22007,
-20294,
-20475,
-21723,
-21888,
-19997,
-16995,
-14812,
-14777,
-17740,
-24081,
-32870,
-41189,
-45288,
-43723,
-38535,
-33433,
-29991,
-26552,
-20591,
-12351,
-5429,
-3895,
-8555,
-16447,
-23930,
-30120,
-36867,
-45136,
-52212,
-53397,
-46969,
-36586,
-28027,
-23894,
-22425,
-21579,
-22455,
-27432,
-35724,
-42667,
-44573,
-42075,
-38165,
-33204,
-25274,
-14892,
-7679,
-9082,
-17785,
-26377,
-29635,
-29728,
-31961,
-36716,
-38695,
-34364,
-27462,
-24724,
-27791,
-31594,
-31383,
-28162,
-25899,
-24788,
-20954,
-12914,
-5885,
-7107,
-17371,
-29456,
-35292,
-33765,
-30472,
-30970,
-35450,
-39894,
-40699,
-37507,
-32322,
-27200,
-22933,
-19398,
-16453,
-14520,
-14300,
-15647,
-17166,
-17169,
-15482,
-13788,
-13822,
-15733,
-18614,
-22477,
-28524,
-36878,
-44796,
-48234,
-45276,
-37502,
-28042,
-19147,
-12120,
-8375,
-8895,
-12631,
-17004,
-20767,
-25884,
-34668,
-45590,
-52951,
-52398,
-45515,
-38430,
-35482,
-35451,
-34165,
-29771,
-24453,
-21504,
-21959,
-24458,
-27441,
-30317,
-32762,
-33667,
-31707,
-26804,
-20859,
-16835,
-16575,
-19232,
-21659,
-21299,
-18808,
-17846,
-21392,
-28197,
-33600,
-33804,
-29135,
-22904,
-17943,
-15165,
-14857,
-17633,
-23068,
-28788,
-32120,
-33080,
-33963,
-35817,
-36571,
-33747,
-28420,
-24443,
-23930,
-24693,
-23834,
-21729,
-21283,
-22910,
-23246,
-19727,
-15052,
-14729,
-20285,
-27062,
-29638,
-27787,
-25728,
-26139,
-27641,
-28089,
-28508,
-31225,
-35549,
-37358,
-34093,
-28043,
-23651,
-21825,
-19230,
-12971,
-5056,
-1034,
-4920,
-16033,
-29908,
-41260,
-46320,
-44278,
-38112,
-32954,
-32367,
-35144,
-36771,
-34372,
-29857,
-27689,
-29886,
-34073,
-36404,
-35564,
-33475,
-32725,
-34098,
-36436,
-37992,
-37469,
-34474,
-29647,
-24621,
-20999,
-19073,
-17736,
-15710,
-13188,
-11686,
-12452,
-15200,
-18366,
-20757,
-22563,
-24863,
-27893,
-30316,
-29927,
-26005,
-20375,
-16390,
-16306,
-19638,
-24052,
-27683,
-30093,
-31509,
-31399,
-29199,
-25814,
-24057,
-26157,
-30962,
-34271,
-32664,
-27395,
-23782,
-26037,
-32667,
-37182,
-34183,
-24568,
-14747,
-10401,
-11534,
-13806,
-14096,
-13872,
-16618,
-23033,
-29914,
-33882,
-34902,
-35479,
-36772,
-37066,
-34213,
-28620,
-22898,
-18945,
-16590,
-15043,
-14803,
-17084,
-21950,
-27866,
-33218,
-37335,
-39838,
-39779,
-36688,
-32259,
-29781,
-31225,
-35017,
-37537,
-36570,
-33000,
-29208,
-26736,
-25809,
-26582,
-29303,
-33513,
-37128,
-37736,
-34372,
-28287,
-21950,
-17743,
-17121,
-20174,
-25211,
-29190,
-29476,
-25857,
-20845,
-17546,
-17142,
-18147,
-18276,
-16879,
-15875,
-18306,
-25549,
-35382,
-42936,
-43926,
-38454,
-31033,
-27102,
-28311,
-31649,
-32944,
-31343,
-29627,
-30747,
-33969,
-35665,
-33024,
-27108,
-21658,
-19651,
-21123,
-24242,
-27224,
-29268,
-29609,
-27371,
-22580,
-17304,
-14637,
-16162,
-20237,
-23575,
-24405,
-24394,
-26738,
-32708,
-39735,
-43367,
-40726,
-32647,
-22555,
-14080,
-9310,
-8712,
-11795,
-17366,
-23924,
-30020,
-34746,
-37567,
-38020,
-35895,
-32269,
-29732,
-30909,
-36114,
-42377,
-45512,
-43228,
-36765,
-29609,
-24755,
-23220,
-24237,
-26413,
-28528,
-29589,
-29159,
-27480,
-25676,
-25262,
-27316,
-31696,
-36547,
-39080,
-37242,
-31537,
-24934,
-20762,
-20139,
-21762,
-23821,
-25855,
-28198,
-30319,
-30790,
-29295,
-27964,
-29531,
-34113,
-38706,
-40431,
-39603,
-39064,
-40184,
-41296,
-39832,
-35983,
-32506,
-31534,
-32241,
-32451,
-31489,
-30706,
-31340,
-33061,
-35130,
-37760,
-41470,
-45164,
-46187,
-42890,
-36540,
-30004,
-24972,
-21364,
-19109,
-19580,
-23874,
-30724,
-36962,
-40358,
-41271,
-40646,
-37860,
-31394,
-22259,
-15102,
-14724,
-21461,
-30547,
-36633,
-38468,
-39101,
-41964,
-47178,
-51836,
-52842,
-49519,
-43718,
-38187,
-35146,
-35315,
-38097,
-41732,
-44302,
-44540,
-42523,
-39501,
-37050,
-36357,
-37760,
-40773,
-44097,
-45923,
-44701,
-40406,
-35112,
-31783,
-31975,
-34478,
-36564,
-36594,
-35110,
-33423,
-31727,
-29701,
-28206,
-29661,
-35053,
-41877,
-45853,
-45605,
-44253,
-45788,
-50209,
-53632,
-53349,
-51187,
-50979,
-53284,
-54536,
-51583,
-45813,
-41538,
-40909,
-42106,
-42586,
-42401,
-43389,
-45566,
-46629,
-45248,
-43556,
-45022,
-50018,
-54669,
-54493,
-48369,
-38916,
-29752,
-23553,
-21972,
-25898,
-34513,
-44692,
-52613,
-56027,
-55289,
-51808,
-46841,
-41649,
-37914,
-36924,
-38016,
-39213,
-39700,
-41069,
-45273,
-51382,
-55753,
-55561,
-51767,
-47509,
-44309,
-40871,
-36028,
-31600,
-31160,
-35978,
-43575,
-50377,
-55138,
-58611,
-60459,
-58306,
-50619,
-39846,
-31287,
-28442,
-30143,
-32603,
-33680,
-34324,
-36306,
-39416,
-41591,
-41299,
-38802,
-35530,
-32520,
-30062,
-28298,
-27575,
-28297,
-30638,
-34173,
-37749,
-39407,
-37773,
-33618,
-30320,
-31394,
-37348,
-44886,
-49459,
-48928,
-44434,
-38696,
-33669,
-30279,
-29017,
-30287,
-33444,
-36811,
-38623,
-38628,
-37895,
-37425,
-36992,
-35664,
-33490,
-32193,
-33979,
-39175,
-45084,
-47290,
-42776,
-32467,
-20899,
-13624,
-13786,
-20662,
-30290,
-37859,
-40303,
-37956,
-34166,
-32678,
-34611,
-37744,
-39078,
-37911,
-36253,
-35759,
-35605,
-33681,
-30083,
-27891,
-29807,
-34706,
-38448,
-38352,
-36013,
-35085,
-36955,
-39526,
-40054,
-38346,
-36437,
-35861,
-36219,
-36271,
-35725,
-34838,
-33301,
-29947,
-24698,
-19690,
-18116,
-21056,
-25969,
-28339,
-25639,
-19475,
-14151,
-12672,
-14441,
-16552,
-17317,
-17675,
-19342,
-21888,
-23050,
-21664,
-19793,
-20871,
-25969,
-32607,
-37510,
-39732,
-40516,
-40821,
-39775,
-36361,
-31209,
-26375,
-23339,
-22163,
-22614,
-24965,
-29322,
-34139,
-36838,
-35770,
-31423,
-25584,
-19564,
-13911,
-9093,
-5986,
-5181,
-6667,
-10054,
-14853,
-19980,
-22838,
-20714,
-13087,
-3475,
-1,
-93,
-9913,
-22301,
-31706,
-35652,
-35575,
-34359,
-33073,
-30223,
-24136,
-15740,
-8539,
-5529,
-6726,
-10214,
-14860,
-21355,
-29578,
-36944,
-39775,
-37383,
-32817,
-29682,
-28512,
-27358,
-25300,
-23799,
-24289,
-25646,
-25497,
-23500,
-21780,
-21516,
-20771,
-16956,
-11172,
-8293,
-11836,
-19639,
-25655,
-25529,
-20011,
-12777,
-7077,
-4535,
-6339,
-12626,
-20967,
-26587,
-26598,
-23386,
-22861,
-28059,
-35361,
-37552,
-30950,
-19123,
-9680,
-8053,
-14047,
-23454,
-31866,
-37088,
-38988,
-38193,
-34997,
-29495,
-22454,
-16005,
-12899,
-14325,
-18604,
-22245,
-23141,
-22082,
-21155,
-20728,
-19041,
-14955,
-10236,
-8336,
-10768,
-15657,
-19874,
-21827,
-21648,
-19638,
-16116,
-13180,
-14756,
-23110,
-35297,
-44476,
-45963,
-41140,
-34966,
-29956,
-24366,
-16310,
-8390,
-6154,
-12307,
-23389,
-33041,
-37748,
-38901,
-39810,
-42055,
-44667,
-45557,
-42842,
-35554,
-24819,
-14506,
-9524,
-11900,
-18802,
-25033,
-28010,
-29536,
-32640,
-37228,
-40015,
-38139,
-32299,
-25781,
-21244,
-19359,
-19636,
-21559,
-23832,
-23967,
-20200,
-14265,
-11356,
-15690,
-25914,
-35552,
-38995,
-36641,
-34155,
-35931,
-40544,
-42462,
-38415,
-30905,
-25327,
-24431,
-26316,
-27872,
-28904,
-31866,
-38053,
-45076,
-48974,
-47950,
-43544,
-38260,
-33140,
-28276,
-24492,
-23380,
-25069,
-27118,
-26540,
-22919,
-19034,
-17844,
-19584,
-21906,
-22880,
-23025,
-24339,
-27756,
-31804,
-33999,
-33016,
-29866,
-27016,
-26687,
-29333,
-33626,
-37393,
-39341,
-39622,
-39231,
-38474,
-36685,
-33329,
-29477,
-27516,
-29063,
-33339,
-37856,
-40774,
-42405,
-44149,
-46428,
-48065,
-47698,
-45353,
-42036,
-38279,
-33513,
-27629,
-22222,
-19905,
-21496,
-24804,
-26211,
-24373,
-21456,
-21018,
-24273,
-28796,
-30919,
-29186,
-25744,
-24008,
-25660,
-29126,
-31303,
-30276,
-27110,
-24891,
-26348,
-31467,
-37260,
-39927,
-38046,
-33951,
-32064,
-34787,
-40158,
-43378,
-41420,
-36006,
-32020,
-32748,
-37080,
-41212,
-42887,
-43071,
-44037,
-45979,
-46886,
-44840,
-40351,
-35868,
-33474,
-33566,
-35030,
-36399,
-36541,
-34974,
-32249,
-29501,
-27585,
-26064,
-24050,
-21563,
-19984,
-20746,
-23650,
-27456,
-31309,
-35135,
-38454,
-39535,
-37302,
-33300,
-30877,
-31539,
-32973,
-31938,
-28744,
-27805,
-32700,
-41520,
-48103,
-48003,
-42417,
-36151,
-32521,
-31295,
-30901,
-31074,
-32772,
-36003,
-39113,
-40173,
-38502,
-34690,
-29954,
-25570,
-22814,
-22095,
-22533,
-22822,
-22796,
-23644,
-26090,
-28841,
-29942,
-29236,
-29016,
-31361,
-35644,
-39211,
-40214,
-39020,
-36753,
-33806,
-30436,
-27957,
-27997,
-30095,
-31663,
-30812,
-29136,
-29923,
-34179,
-39110,
-41307,
-40546,
-39308,
-39351,
-39883,
-39543,
-38873,
-39411,
-41158,
-42174,
-41230,
-39747,
-39897,
-41591,
-42258,
-40002,
-35883,
-32409,
-30761,
-30222,
-30299,
-31876,
-35459,
-39311,
-40381,
-37736,
-33983,
-32759,
-34814,
-37111,
-36070,
-31318,
-26152,
-24341,
-26629,
-30261,
-31886,
-30814,
-29552,
-31125,
-35983,
-41682,
-45469,
-46736,
-46784,
-46394,
-44850,
-41276,
-36629,
-33078,
-31702,
-31353,
-30591,
-29811,
-31048,
-35234,
-40870,
-45439,
-47608,
-47305,
-44289,
-38103,
-30120,
-24372,
-24749,
-30829,
-37474,
-39405,
-36151,
-31668,
-29715,
-30002,
-29840,
-28060,
-26623,
-27809,
-31218,
-34039,
-34036,
-31499,
-28221,
-25644,
-24401,
-25284,
-29041,
-35219,
-41167,
-43622,
-41196,
-35442,
-29501,
-25765,
-24749,
-25587,
-27046,
-28341,
-29426,
-30680,
-32253,
-33315,
-32590,
-29732,
-26276,
-24524,
-25375,
-27446,
-28747,
-28956,
-29647,
-32031,
-35139,
-36581,
-35170,
-32395,
-30861,
-31733,
-33369,
-32982,
-28994,
-22337,
-15554,
-10805,
-8756,
-8759,
-10169,
-13000,
-17571,
-23551,
-29526,
-33915,
-35802,
-35481,
-33954,
-32448,
-32011,
-32833,
-33787,
-32928,
-29413,
-25039,
-23408,
-26625,
-32941,
-37753,
-37470,
-32303,
-25580,
-20852,
-19675,
-21811,
-26280,
-32180,
-38426,
-43695,
-46425,
-45274,
-39826,
-31472,
-23431,
-19246,
-20370,
-25167,
-30461,
-33905,
-34988,
-34026,
-31180,
-26816,
-22111,
-18608,
-17048,
-17232,
-19212,
-23423,
-29346,
-34115,
-34315,
-29368,
-22905,
-19651,
-21188,
-25055,
-27950,
-29013,
-29359,
-29742,
-29197,
-26773,
-23029,
-19562,
-17265,
-15768,
-14716,
-14528,
-15786,
-18099,
-20536,
-22843,
-25704,
-29409,
-32757,
-34023,
-32787,
-30459,
-28537,
-27085,
-25297,
-23469,
-23421,
-26272,
-30107,
-31005,
-26862,
-20276,
-16302,
-17556,
-21449,
-23155,
-20999,
-18055,
-18455,
-22459,
-26172,
-25994,
-22518,
-19666,
-20595,
-25065,
-30602,
-35063,
-37415,
-37137,
-33857,
-28322,
-22827,
-19954,
-21020,
-25426,
-31385,
-36559,
-38766,
-37081,
-33005,
-29761,
-29604,
-31999,
-34731,
-37070,
-40202,
-44607,
-47774,
-46246,
-39796,
-32354,
-27808,
-26116,
-24458,
-21977,
-21338,
-25100,
-31711,
-36932,
-38755,
-39129,
-40357,
-40968,
-37398,
-29036,
-20042,
-15291,
-15420,
-17407,
-19265,
-22322,
-28742,
-37329,
-44271,
-46792,
-45700,
-43442,
-41123,
-38350,
-35394,
-34029,
-35667,
-39166,
-41403,
-40035,
-35266,
-29580,
-25904,
-26121,
-30236,
-36281,
-41428,
-44205,
-45503,
-47354,
-50028,
-51273,
-48664,
-42624,
-36308,
-32788,
-32368,
-33434,
-34455,
-35090,
-35412,
-35419,
-35736,
-37488,
-40736,
-42827,
-40444,
-33383,
-26368,
-25218,
-31179,
-39298,
-43230,
-41055,
-36688,
-35248,
-38252,
-42749,
-44874,
-43163,
-39156,
-35265,
-32992,
-32455,
-33314,
-35223,
-37863,
-40421,
-41964,
-42143,
-41915,
-42701,
-44844,
-46714,
-46065,
-42249,
-37181,
-33587,
-32780,
-34100,
-36424,
-39129,
-41635,
-42593,
-40925,
-37556,
-35292,
-35923,
-38067,
-38489,
-35897,
-32360,
-30558,
-30215,
-28385,
-23523,
-18164,
-16818,
-21277,
-28698,
-34482,
-36383,
-35717,
-35108,
-36084,
-38609,
-42008,
-45448,
-47755,
-47668,
-44861,
-40558,
-36942,
-35646,
-36866,
-39488,
-41915,
-42697,
-41186,
-37641,
-33336,
-29999,
-29052,
-31200,
-36078,
-42470,
-48441,
-52001,
-51844,
-47883,
-41339,
-34146,
-28257,
-24764,
-23525,
-23474,
-23772,
-24648,
-27028,
-30906,
-34549,
-35537,
-33036,
-28740,
-25296,
-24035,
-24309,
-25006,
-26025,
-27932,
-30518,
-32432,
-32554,
-31322,
-30283,
-30306,
-30718,
-30454,
-29813,
-30543,
-33973,
-39149,
-43172,
-43593,
-40287,
-35307,
-30720,
-27231,
-24607,
-23188,
-24329,
-29001,
-36306,
-43558,
-48178,
-49050,
-46440,
-40890,
-33041,
-24674,
-18937,
-18849,
-24569,
-32625,
-38109,
-38269,
-34381,
-29880,
-27090,
-25223,
-21925,
-16436,
-10936,
-8679,
-10644,
-14648,
-17675,
-19022,
-20468,
-23624,
-27839,
-31300,
-33597,
-36319,
-40571,
-44918,
-46433,
-43749,
-38401,
-32923,
-28576,
-25217,
-22858,
-22394,
-24577,
-29261,
-35673,
-42865,
-49022,
-51154,
-46981,
-37730,
-28161,
-22828,
-22194,
-23347,
-24019,
-24941,
-27672,
-31402,
-33325,
-32185,
-29857,
-28587,
-27820,
-24829,
-19018,
-13569,
-12341,
-15253,
-18233,
-17690,
-14621,
-13581,
-18097,
-27391,
-37323,
-43802,
-45446,
-43492,
-40142,
-36829,
-33493,
-29367,
-24126,
-18942,
-15894,
-16811,
-21974,
-30075,
-38979,
-46415,
-50797,
-51413,
-48722,
-43730,
-37536,
-30976,
-25046,
-20971,
-19760,
-21523,
-25573,
-31060,
-37160,
-42578,
-45367,
-44183,
-39790,
-35113,
-32904,
-33500,
-34821,
-34469,
-31745,
-27426,
-22502,
-17473,
-12945,
-10115,
-10069,
-12655,
-16403,
-19938,
-23259,
-27650,
-33801,
-40510,
-44847,
-44394,
-39226,
-32109,
-26495,
-24057,
-24138,
-25036,
-26025,
-27608,
-30496,
-34481,
-38620,
-41891,
-43364,
-41979,
-37076,
-29718,
-23111,
-20707,
-23372,
-28524,
-32446,
-33369,
-32333,
-31033,
-29735,
-27546,
-24343,
-21938,
-22564,
-26703,
-32187,
-35850,
-35748,
-32260,
-27365,
-23050,
-20351,
-19429,
-20065,
-22042,
-24738,
-27348,
-29462,
-31834,
-35721,
-40918,
-44806,
-43981,
-37752,
-29513,
-24292,
-24335,
-27770,
-31184,
-33383,
-35785,
-39622,
-43647,
-45150,
-42700,
-37581,
-32276,
-28478,
-26437,
-25671,
-25787,
-26400,
-27138,
-27546,
-27302,
-26011,
-23914,
-22150,
-22406,
-25076,
-27965,
-27833,
-23619,
-17993,
-15169,
-16787,
-20798,
-24004,
-25413,
-26391,
-28229,
-30230,
-30758,
-29104,
-25942,
-22081,
-17493,
-12087,
-6765,
-3552,
-4421,
-10158,
-19741,
-30409,
-38298,
-40325,
-36415,
-30080,
-26086,
-26539,
-29049,
-29149,
-24626,
-18091,
-14558,
-17009,
-23548,
-29352,
-31099,
-29364,
-27171,
-26110,
-25206,
-23018,
-20640,
-21093,
-25741,
-31865,
-34795,
-32450,
-27107,
-22602,
-20620,
-20273,
-20905,
-23494,
-28715,
-34423,
-36614,
-33358,
-27064,
-22179,
-21052,
-22376,
-23462,
-23100,
-21882,
-20921,
-20835,
-22029,
-24524,
-27518,
-29411,
-29659,
-29593,
-31222,
-34250,
-35892,
-33905,
-29850,
-28075,
-31162,
-37023,
-41004,
-40567,
-37001,
-32939,
-29149,
-25072,
-21391,
-20870,
-25259,
-32494,
-37644,
-37388,
-32843,
-28009,
-25769,
-26018,
-27059,
-27995,
-29107,
-30587,
-31858,
-32182,
-31873,
-32037,
-33640,
-36254,
-38256,
-37588,
-33357,
-26760,
-20885,
-18687,
-20901,
-25418,
-29147,
-30355,
-29370,
-27662,
-26396,
-26304,
-27562,
-29595,
-30905,
-30292,
-28468,
-28003,
-30701,
-35279,
-37953,
-36136,
-30994,
-26415,
-25465,
-27918,
-31263,
-32981,
-32359,
-30228,
-28125,
-27385,
-28704,
-31978,
-36390,
-40922,
-44411,
-45700,
-44120,
-40227,
-35878,
-32847,
-31096,
-29131,
-26036,
-23285,
-23556,
-27829,
-33946,
-38232,
-38538,
-35519,
-31341,
-27778,
-25140,
-22853,
-20404,
-18344,
-18341,
-21878,
-28213,
-33938,
-35385,
-32184,
-27884,
-26437,
-28333,
-30818,
-31776,
-32427,
-35111,
-39415,
-41831,
-39753,
-34806,
-31088,
-30477,
-30973,
-29906,
-27871,
-28303,
-33193,
-40197,
-44569,
-43636,
-39093,
-35102,
-34483,
-36737,
-39026,
-38954,
-36441,
-33554,
-32448,
-33495,
-35276,
-36448,
-37088,
-38117,
-39388,
-39448,
-37212,
-33790,
-31581,
-31817,
-33503,
-34894,
-35484,
-35714,
-35491,
-34052,
-31643,
-30294,
-31801,
-35203,
-37517,
-36919,
-34844,
-33812,
-34322,
-34777,
-34376,
-34557,
-36752,
-39623,
-40224,
-37937,
-35928,
-37723,
-43017,
-47842,
-48874,
-46323,
-42485,
-38892,
-35785,
-33962,
-34849,
-38249,
-41122,
-40260,
-36048,
-32509,
-33056,
-36818,
-39969,
-39820,
-36915,
-33241,
-29584,
-25668,
-21811,
-19538,
-19826,
-21863,
-23686,
-24231,
-24012,
-24226,
-25446,
-27127,
-28124,
-27434,
-25172,
-23025,
-23392,
-27293,
-32967,
-37041,
-37509,
-35510,
-34110,
-35181,
-38075,
-40463,
-40595,
-38244,
-34528,
-31007,
-28803,
-27939,
-27294,
-25964,
-24393,
-24324,
-26753,
-30758,
-34375,
-36795,
-38727,
-40619,
-41252,
-39049,
-34311,
-29549,
-26803,
-25749,
-24885,
-24008,
-24787,
-28209,
-32682,
-35201,
-34157,
-30493,
-26154,
-22502,
-20236,
-20017,
-21831,
-24107,
-24565,
-22717,
-20964,
-22224,
-26804,
-31990,
-35089,
-35923,
-35871,
-35467,
-33917,
-31283,
-29748,
-31444,
-35507,
-38147,
-36432,
-31346,
-26662,
-25061,
-26104,
-27864,
-29523,
-31679,
-34370,
-36255,
-35786,
-33104,
-29778,
-27096,
-25164,
-23976,
-24332,
-27242,
-31941,
-35757,
-36107,
-32936,
-28472,
-25012,
-22957,
-21517,
-20313,
-20028,
-20917,
-22033,
-21971,
-20889,
-20681,
-22957,
-27155,
-30922,
-32685,
-33039,
-33569,
-34572,
-34700,
-33034,
-30873,
-30771,
-33706,
-37685,
-39654,
-38561,
-36376,
-35903,
-37961,
-40825,
-42116,
-41029,
-38484,
-35844,
-33437,
-30814,
-27759,
-25219,
-24738,
-27113,
-31444,
-35491,
-37291,
-36461,
-34121,
-31673,
-29904,
-28858,
-28549,
-28846,
-29295,
-29138,
-28250,
-27540,
-28160,
-30245,
-32713,
-34603,
-35868,
-36940,
-37301,
-36014,
-33202,
-30917,
-31192,
-33589,
-35166,
-33657,
-30015,
-27631,
-28700,
-32250,
-35662,
-37681,
-39295,
-41559,
-43839,
-44189,
-41923,
-38506,
-36303,
-36261,
-37491,
-38765,
-39868,
-41434,
-43449,
-44861,
-44540,
-42674,
-40477,
-38727,
-36801,
-33760,
-30203,
-28419,
-30284,
-35099,
-39827,
-41932,
-41337,
-39882,
-38745,
-37294,
-34323,
-30261,
-27297,
-27705,
-31667,
-37325,
-42270,
-45049,
-45532,
-43926,
-40506,
-35635,
-30573,
-27155,
-26703,
-28814,
-31722,
-34171,
-36644,
-40517,
-45566,
-49197,
-48555,
-43659,
-37738,
-34250,
-34104,
-35756,
-37784,
-39998,
-42239,
-43013,
-40532,
-34954,
-28865,
-25121,
-24844,
-27261,
-31160,
-35193,
-37961,
-38370,
-37111,
-36277,
-37075,
-38115,
-37153,
-34353,
-32964,
-35359,
-39681,
-41330,
-38115,
-32928,
-30494,
-32227,
-35289,
-36373,
-35316,
-34425,
-35125,
-36599,
-37242,
-36749,
-35777,
-34595,
-32734,
-30162,
-28004,
-27820,
-30201,
-34341,
-38550,
-41128,
-40929,
-37947,
-33417,
-29060,
-26025,
-24417,
-24153,
-25704,
-29515,
-34836,
-39507,
-41547,
-40588,
-37828,
-34525,
-31356,
-28905,
-28173,
-29727,
-32630,
-34815,
-35146,
-34528,
-34692,
-35770,
-35812,
-32996,
-28102,
-24227,
-23922,
-26729,
-29859,
-31098,
-30754,
-30825,
-32299,
-33860,
-33168,
-29286,
-23919,
-19940,
-19140,
-21030,
-23761,
-25851,
-26935,
-27286,
-27014,
-26096,
-24991,
-24563,
-25307,
-26475,
-26647,
-25090,
-22697,
-21187,
-21657,
-23795,
-26669,
-29597,
-32324,
-34363,
-34924,
-33803,
-31764,
-30031,
-28811,
-27422,
-25357,
-23577,
-23574,
-25635,
-28160,
-29318,
-29011,
-28837,
-30084,
-32167,
-33431,
-33011,
-31517,
-29657,
-27218,
-23452,
-18962,
-15672,
-15361,
-17673,
-20665,
-22813,
-24445,
-26732,
-29710,
-31739,
-31133,
-28164,
-24875,
-23291,
-23486,
-24176,
-24475,
-25028,
-26910,
-29951,
-32364,
-32617,
-30984,
-29187,
-28399,
-28069,
-27251,
-26284,
-26913,
-29916,
-33747,
-35548,
-34063,
-30638,
-27630,
-25772,
-24071,
-21424,
-18347,
-16212,
-15860,
-16887,
-18784,
-21674,
-26004,
-31313,
-35841,
-37511,
-35298,
-30317,
-25154,
-22402,
-22533,
-23534,
-22490,
-18665,
-14391,
-13253,
-16346,
-21468,
-25408,
-27258,
-28768,
-31502,
-34507,
-35314,
-32679,
-28370,
-25216,
-24704,
-25990,
-27549,
-28707,
-29785,
-30762,
-31089,
-30425,
-29860,
-31375,
-36020,
-42428,
-47466,
-48489,
-45306,
-39814,
-34116,
-29116,
-24900,
-22060,
-21653,
-24040,
-27810,
-30876,
-32224,
-32618,
-33337,
-34460,
-35015,
-33965,
-31447,
-28417,
-26092,
-25397,
-26489,
-28427,
-29544,
-28901,
-27599,
-27910,
-30862,
-34818,
-37220,
-37279,
-36636,
-36693,
-36569,
-34044,
-28752,
-23225,
-20549,
-21355,
-23596,
-25098,
-25661,
-26495,
-28621,
-31599,
-34213,
-35055,
-33636,
-30706,
-28335,
-28156,
-29750,
-30561,
-28868,
-25894,
-24995,
-27752,
-32288,
-35538,
-36905,
-38184,
-40368,
-41639,
-39964,
-36476,
-34683,
-35843,
-36841,
-33851,
-27718,
-23755,
-25754,
-31493,
-35544,
-35676,
-35156,
-37956,
-43545,
-47434,
-46465,
-41828,
-36514,
-31618,
-26318,
-21196,
-19274,
-22955,
-30748,
-38180,
-42135,
-43103,
-43536,
-44407,
-44692,
-43361,
-40888,
-38855,
-38211,
-38865,
-40131,
-41195,
-41387,
-40701,
-40066,
-40672,
-42424,
-43527,
-42161,
-38178,
-33189,
-28737,
-25475,
-23960,
-25162,
-29335,
-34537,
-37697,
-37765,
-36837,
-37681,
-40082,
-41230,
-39322,
-36141,
-35027,
-36945,
-39766,
-41110,
-40891,
-40318,
-39492,
-37409,
-34376,
-32942,
-35539,
-41251,
-46181,
-46922,
-43485,
-38686,
-35223,
-33830,
-33515,
-32900,
-31106,
-28224,
-25385,
-24255,
-25718,
-29153,
-32720,
-34841,
-34863,
-33159,
-30604,
-28421,
-27433,
-27209,
-26149,
-23336,
-20323,
-20454,
-25446,
-33344,
-40051,
-43201,
-43709,
-43588,
-43230,
-41505,
-38065,
-34159,
-30953,
-27832,
-23881,
-19927,
-18788,
-21888,
-27251,
-31027,
-31232,
-29350,
-27915,
-27558,
-26735,
-24042,
-20181,
-17487,
-17874,
-21480,
-26571,
-30602,
-31714,
-30012,
-27730,
-27387,
-29701,
-32818,
-34292,
-33308,
-30871,
-28227,
-25475,
-22509,
-20019,
-19359,
-20637,
-22335,
-22882,
-22591,
-23232,
-25557,
-28149,
-28821,
-27293,
-25406,
-25096,
-26226,
-27211,
-26971,
-26057,
-25621,
-26060,
-26927,
-27889,
-28941,
-29800,
-29710,
-28325,
-26872,
-27271,
-30287,
-34308,
-36829,
-36664,
-34684,
-32374,
-30204,
-27915,
-25775,
-24905,
-26014,
-28361,
-30470,
-31617,
-32174,
-32262,
-31230,
-28489,
-25117,
-22995,
-22822,
-22984,
-21795,
-19913,
-20364,
-25155,
-32949,
-40129,
-44062,
-44672,
-43028,
-39722,
-35094,
-30616,
-28275,
-28555,
-29459,
-28781,
-26845,
-26281,
-28900,
-33320,
-36489,
-36909,
-35939,
-35696,
-36646,
-37444,
-36855,
-34926,
-32477,
-30020,
-27697,
-25805,
-24832,
-24902,
-25421,
-25511,
-24707,
-23114,
-21611,
-21453,
-23635,
-27587,
-30925,
-31055,
-27902,
-24345,
-23821,
-26730,
-30227,
-31189,
-29554,
-27933,
-28556,
-30901,
-32697,
-32444,
-30564,
-28323,
-26428,
-25049,
-24502,
-25276,
-27283,
-29635,
-31494,
-32805,
-34036,
-35174,
-35672,
-35221,
-34187,
-33196,
-32276,
-31202,
-30355,
-30727,
-32685,
-35022,
-35836,
-34429,
-32037,
-30406,
-30200,
-30835,
-31752,
-32911,
-33945,
-33648,
-31033,
-26947,
-23933,
-23912,
-26300,
-28749,
-29518,
-28889,
-28360,
-28928,
-30763,
-33475,
-36541,
-38948,
-39742,
-38918,
-37718,
-37118,
-36496,
-34118,
-29731,
-25602,
-24788,
-28114,
-33448,
-38036,
-40794,
-42204,
-42407,
-40491,
-35983,
-30114,
-25209,
-22482,
-21354,
-20746,
-20708,
-22174,
-25305,
-28759,
-30816,
-31113,
-30796,
-31233,
-32688,
-34564,
-36242,
-37536,
-38266,
-37889,
-36057,
-33126,
-30152,
-27922,
-26713,
-26478,
-27553,
-29911,
-32655,
-33992,
-32900,
-30085,
-27048,
-24406,
-21503,
-18365,
-16973,
-19863,
-26974,
-34800,
-39284,
-39386,
-37246,
-35241,
-33565,
-31486,
-29446,
-28969,
-30302,
-31585,
-31398,
-31194,
-33995,
-40233,
-46287,
-48046,
-45454,
-42508,
-42334,
-43660,
-42670,
-37896,
-32026,
-28705,
-28516,
-29003,
-28040,
-26138,
-25264,
-26051,
-27284,
-27650,
-27394,
-27902,
-29914,
-32743,
-34820,
-34869,
-32555,
-28664,
-24892,
-23160,
-24467,
-28068,
-32111,
-34975,
-36400,
-37049,
-37516,
-37915,
-38299,
-38861,
-39574,
-39643,
-38225,
-35607,
-33491,
-33487,
-35346,
-36921,
-36263,
-33493,
-30610,
-29319,
-29791,
-30999,
-32442,
-34284,
-36353,
-37539,
-36718,
-34473,
-32915,
-33568,
-35567,
-36526,
-35362,
-33975,
-35137,
-39223,
-42742,
-41683,
-35637,
-29109,
-27506,
-32129,
-38713,
-41429,
-38238,
-32323,
-28824,
-29963,
-33953,
-37614,
-39513,
-40428,
-41038,
-40665,
-38120,
-33736,
-29615,
-27746,
-28004,
-28546,
-27837,
-26628,
-27269,
-31540,
-38632,
-45464,
-49000,
-48503,
-45760,
-43179,
-41413,
-39233,
-35304,
-30210,
-26278,
-25249,
-26690,
-28561,
-29616,
-30593,
-33016,
-36811,
-39873,
-39744,
-36360,
-32119,
-29995,
-30672,
-32509,
-33389,
-33016,
-32727,
-33390,
-34126,
-33509,
-31876,
-31596,
-34398,
-38849,
-41315,
-39694,
-35787,
-33156,
-33269,
-34230,
-33622,
-31729,
-31064,
-33185,
-36716,
-38872,
-38169,
-35401,
-32261,
-30089,
-29545,
-30639,
-32281,
-32708,
-30982,
-28336,
-26927,
-27230,
-27415,
-25734,
-23325,
-23111,
-26276,
-30454,
-32329,
-31399,
-30309,
-31496,
-34457,
-36851,
-37459,
-37382,
-38191,
-40021,
-41669,
-42174,
-41451,
-39852,
-37472,
-34495,
-31449,
-28986,
-27388,
-26665,
-26856,
-28165,
-30440,
-33087,
-35428,
-36904,
-37061,
-35528,
-32595,
-29602,
-28247,
-29145,
-31220,
-32577,
-32060,
-29781,
-26778,
-24303,
-23427,
-24501,
-26601,
-27992,
-27663,
-26548,
-26716,
-29104,
-32416,
-34314,
-33719,
-31534,
-29443,
-28616,
-29381,
-31491,
-33926,
-34918,
-33057,
-28952,
-25308,
-24784,
-27731,
-32123,
-35691,
-37600,
-38213,
-37796,
-36209,
-33538,
-30688,
-28613,
-27699,
-27627,
-28256,
-29684,
-31981,
-34526,
-36597,
-37815,
-38501,
-38961,
-38817,
-37291,
-33916,
-29701,
-26575,
-26219,
-28426,
-31211,
-32542,
-32039,
-31011,
-30535,
-30162,
-28622,
-25690,
-22993,
-22372,
-24311,
-27579,
-30864,
-33673,
-36145,
-38313,
-39992,
-41082,
-41287,
-39931,
-36479,
-31730,
-27740,
-26026,
-26091,
-26227,
-26171,
-27848,
-33230,
-41279,
-48186,
-50630,
-48599,
-44735,
-41056,
-37288,
-31993,
-25197,
-18994,
-16087,
-17463,
-21783,
-26356,
-29121,
-29885,
-30188,
-31702,
-34508,
-36995,
-37350,
-35396,
-32580,
-30305,
-28614,
-26531,
-23719,
-21193,
-20468,
-22097,
-25202,
-28262,
-30252,
-31264,
-32256,
-34233,
-37200,
-39578,
-39121,
-34727,
-27899,
-22021,
-19883,
-21525,
-24537,
-26420,
-26839,
-27594,
-30546,
-35390,
-39622,
-40356,
-36872,
-31027,
-25899,
-23363,
-23312,
-24321,
-25395,
-26273,
-27267,
-28449,
-29775,
-31166,
-32412,
-33073,
-32816,
-32104,
-31936,
-32851,
-34157,
-34504,
-33527,
-32017,
-31150,
-31005,
-30983,
-31047,
-32008,
-34488,
-37489,
-39043,
-38053,
-35508,
-33515,
-33356,
-34395,
-34985,
-33903,
-31377,
-28717,
-27283,
-27477,
-28389,
-28643,
-27574,
-25876,
-24761,
-24719,
-25139,
-25288,
-25145,
-25234,
-25686,
-26366,
-27609,
-30288,
-34430,
-37927,
-37966,
-33881,
-28537,
-25843,
-26949,
-29363,
-29961,
-28299,
-26456,
-26069,
-26392,
-25898,
-24639,
-24660,
-27513,
-32637,
-38057,
-42312,
-45014,
-45829,
-44027,
-39543,
-33719,
-28510,
-24620,
-21592,
-19346,
-19259,
-22521,
-27918,
-32261,
-33443,
-32758,
-33266,
-36231,
-39785,
-41204,
-40043,
-37848,
-35872,
-33431,
-29577,
-25140,
-22657,
-23875,
-28134,
-33178,
-37067,
-39079,
-39168,
-37700,
-35697,
-34654,
-35291,
-36414,
-35946,
-32927,
-28763,
-25774,
-25182,
-26439,
-28459,
-30823,
-33600,
-36519,
-38841,
-40144,
-40804,
-41629,
-43087,
-44945,
-46489,
-46738,
-44681,
-39917,
-33117,
-26165,
-21202,
-19771,
-22165,
-27507,
-33865,
-38887,
-41126,
-41023,
-40580,
-41175,
-41976,
-40739,
-36431,
-30784,
-26819,
-26034,
-27406,
-29036,
-30030,
-30696,
-31062,
-30512,
-28766,
-26850,
-26323,
-27694,
-30029,
-31968,
-33045,
-33380,
-33005,
-31682,
-29522,
-27540,
-26753,
-27689,
-29918,
-32699,
-35196,
-36662,
-36705,
-35458,
-33397,
-30537,
-26628,
-22085,
-18868,
-19323,
-23929,
-30294,
-35020,
-36455,
-35365,
-33291,
-30677,
-27466,
-24414,
-23435,
-25695,
-30204,
-34259,
-35624,
-33897,
-30464,
-27263,
-25678,
-25852,
-26784,
-27308,
-27354,
-27761,
-28917,
-29292,
-27007,
-22403,
-18978,
-20316,
-26275,
-32853,
-36356,
-36838,
-37240,
-39213,
-41075,
-39937,
-35105,
-28575,
-22735,
-18589,
-16149,
-15783,
-17816,
-21590,
-25543,
-28766,
-31737,
-35022,
-37820,
-38478,
-36571,
-33730,
-31986,
-31532,
-30846,
-28797,
-26227,
-25054,
-26105,
-28190,
-29262,
-28335,
-26109,
-24470,
-25057,
-28396,
-33474,
-38247,
-40742,
-40267,
-37583,
-34123,
-30828,
-27962,
-25741,
-24702,
-25408,
-27581,
-30248,
-32558,
-34661,
-37024,
-39445,
-40618,
-39458,
-36561,
-33998,
-33313,
-33877,
-33665,
-31489,
-28597,
-27256,
-28451,
-31066,
-33392,
-35044,
-36816,
-39201,
-41380,
-42204,
-41515,
-40154,
-38854,
-37425,
-35438,
-33013,
-30946,
-29721,
-29351,
-29501,
-30092,
-30949,
-31577,
-31375,
-30368,
-29201,
-28853,
-29754,
-31850,
-34401,
-36095,
-35622,
-32925,
-29921,
-29360,
-32289,
-36908,
-40297,
-41178,
-40689,
-40214,
-39469,
-37087,
-32917,
-28719,
-26345,
-25938,
-26443,
-27503,
-29801,
-33595,
-37502,
-39707,
-39729,
-38650,
-37440,
-36104,
-34483,
-33082,
-32395,
-31439,
-28494,
-23354,
-18380,
-16331,
-17541,
-19803,
-21254,
-22335,
-24657,
-28532,
-32534,
-35407,
-37054,
-37629,
-36209,
-31840,
-25808,
-21545,
-21894,
-26351,
-31716,
-35210,
-36426,
-36437,
-35994,
-35161,
-34015,
-33120,
-32493,
-31438,
-29376,
-27016,
-25972,
-27251,
-30411,
-34205,
-37730,
-40582,
-42287,
-42147,
-39949,
-36468,
-33208,
-31172,
-30354,
-30044,
-29557,
-28936,
-28577,
-28811,
-29519,
-30328,
-31363,
-33123,
-35949,
-39011,
-40750,
-40222,
-38199,
-36276,
-35303,
-34517,
-32984,
-31132,
-30805,
-33491,
-38913,
-44891,
-48663,
-48039,
-42684,
-34726,
-28194,
-26421,
-29218,
-32821,
-33342,
-30324,
-26793,
-25615,
-26680,
-27914,
-28271,
-29080,
-31910,
-36386,
-40286,
-41569,
-39954,
-36526,
-32966,
-30947,
-31478,
-33981,
-36101,
-35578,
-32215,
-28282,
-26111,
-26386,
-28305,
-31146,
-34523,
-37402,
-38213,
-36592,
-34598,
-34807,
-37207,
-38624,
-36027,
-29976,
-24047,
-21471,
-22526,
-25766,
-30172,
-35466,
-40673,
-43719,
-43341,
-40553,
-37816,
-36346,
-35189,
-33056,
-30318,
-29015,
-30555,
-34292,
-38210,
-40780,
-41930,
-42329,
-42474,
-42287,
-41515,
-39953,
-37472,
-34132,
-30524,
-27991,
-27922,
-30471,
-33946,
-35651,
-34133,
-30638,
-28084,
-28450,
-30770,
-32291,
-31502,
-29642,
-29274,
-31097,
-33239,
-33298,
-31191,
-29070,
-28841,
-30172,
-31238,
-31118,
-30784,
-31732,
-34104,
-36541,
-37645,
-37289,
-36208,
-35023,
-33641,
-31866,
-30004,
-28810,
-29118,
-31281,
-35059,
-39304,
-42348,
-42800,
-40832,
-38224,
-36917,
-37159,
-37230,
-35186,
-30902,
-26213,
-23260,
-22791,
-24283,
-26751,
-29591,
-32034,
-33352,
-33418,
-33207,
-33789,
-34953,
-35309,
-34060,
-32618,
-33059,
-35839,
-38728,
-39410,
-38022,
-36868,
-37376,
-38274,
-37295,
-34230,
-31346,
-30630,
-31498,
-31566,
-29699,
-27320,
-26661,
-28523,
-31772,
-34882,
-36967,
-37670,
-36766,
-34551,
-32272,
-31236,
-31515,
-31666,
-30281,
-27401,
-24429,
-22599,
-22250,
-23114,
-24925,
-27275,
-29231,
-30045,
-30157,
-31123,
-33865,
-37280,
-38858,
-37231,
-33594,
-30783,
-30760,
-33252,
-36457,
-38647,
-39037,
-37650,
-34949,
-31942,
-29952,
-29995,
-31625,
-33095,
-32386,
-29105,
-25000,
-22762,
-23813,
-27042,
-29808,
-30497,
-30030,
-30729,
-33634,
-36974,
-38040,
-35960,
-32654,
-30397,
-29273,
-27413,
-24006,
-20869,
-20669,
-23668,
-27270,
-29070,
-29443,
-30570,
-32996,
-34600,
-33072,
-29081,
-25675,
-24989,
-26341,
-27921,
-29449,
-32089,
-35950,
-39089,
-39457,
-37382,
-34999,
-33450,
-31770,
-28873,
-25772,
-24652,
-25839,
-26950,
-25654,
-22816,
-21779,
-24662,
-30019,
-34731,
-37264,
-38501,
-39436,
-39245,
-36599,
-32026,
-28249,
-27458,
-28798,
-29345,
-27077,
-23126,
-20256,
-20308,
-22813,
-26231,
-29323,
-31469,
-32006,
-30546,
-27927,
-26155,
-26558,
-28029,
-28122,
-26107,
-24547,
-26758,
-32565,
-37741,
-38031,
-33896,
-29964,
-29926,
-32519,
-33347,
-30143,
-25353,
-23144,
-24946,
-28416,
-30782,
-31754,
-33013,
-35451,
-37877,
-38633,
-37508,
-35806,
-34470,
-33169,
-30733,
-27037,
-23144,
-20817,
-20843,
-22685,
-24858,
-25983,
-25636,
-24439,
-23656,
-24351,
-26533,
-28840,
-29144,
-26171,
-21127,
-17327,
-17908,
-23018,
-29719,
-34716,
-37142,
-38484,
-39818,
-40231,
-38105,
-33782,
-29599,
-27493,
-26905,
-26140,
-24876,
-24820,
-27291,
-31164,
-33944,
-34541,
-34326,
-35178,
-36987,
-37846,
-36330,
-33256,
-30819,
-30456,
-31584,
-32302,
-31154,
-28271,
-25385,
-24555,
-26559,
-30267,
-33370,
-34442,
-33798,
-32950,
-32730,
-32639,
-31828,
-30468,
-29928,
-31204,
-33753,
-35740,
-35823,
-34479,
-33503,
-34151,
-35826,
-36629,
-35444,
-33049,
-31161,
-30249,
-28997,
-26181,
-22877,
-21883,
-24660,
-29289,
-32161,
-31804,
-30236,
-30230,
-32042,
-33411,
-32825,
-31586,
-31817,
-33494,
-34214,
-32469,
-29784,
-29024,
-30787,
-32840,
-32935,
-31628,
-31073,
-31892,
-32158,
-30050,
-26657,
-25146,
-27291,
-31483,
-34553,
-34956,
-33716,
-32496,
-31779,
-30957,
-29928,
-29304,
-29428,
-29501,
-28453,
-26418,
-24974,
-25784,
-29185,
-34017,
-38733,
-42012,
-42914,
-40835,
-36222,
-30958,
-27622,
-27464,
-29450,
-31377,
-32559,
-34455,
-38824,
-44737,
-48668,
-47726,
-42713,
-37424,
-34681,
-33813,
-32266,
-29165,
-26543,
-26498,
-28535,
-30076,
-29822,
-29448,
-31596,
-36602,
-41845,
-44148,
-42528,
-38628,
-34949,
-33153,
-33072,
-33282,
-32153,
-29602,
-27408,
-27729,
-30639,
-33668,
-34469,
-33556,
-33878,
-37222,
-41664,
-43382,
-40524,
-35087,
-30589,
-28918,
-29279,
-29755,
-28881,
-26408,
-23377,
-21937,
-24022,
-29241,
-34317,
-35669,
-32775,
-28771,
-27086,
-28274,
-30226,
-31153,
-31176,
-31021,
-30370,
-28404,
-25750,
-24476,
-26052,
-29503,
-32366,
-32983,
-31581,
-29396,
-27571,
-26947,
-28230,
-31512,
-35768,
-39282,
-40575,
-39126,
-35051,
-29322,
-23827,
-20862,
-21370,
-23985,
-26281,
-27218,
-27702,
-28568,
-29094,
-28014,
-26199,
-26460,
-30247,
-35244,
-37058,
-34092,
-29122,
-26686,
-28269,
-31619,
-33394,
-32367,
-29722,
-27132,
-25525,
-24797,
-24475,
-23929,
-23143,
-23141,
-25385,
-30082,
-35157,
-37761,
-37047,
-35017,
-34414,
-35838,
-37490,
-37544,
-36067,
-34402,
-33047,
-30963,
-27121,
-22192,
-18415,
-17773,
-20640,
-25900,
-32007,
-37585,
-41438,
-42650,
-41252,
-38689,
-37108,
-37727,
-39575,
-40361,
-38613,
-35352,
-32881,
-32214,
-31780,
-29451,
-25826,
-24519,
-28592,
-36623,
-43293,
-44223,
-40058,
-35280,
-33364,
-33830,
-34062,
-32928,
-31692,
-31745,
-32722,
-33493,
-33935,
-34777,
-35707,
-35225,
-32848,
-30762,
-31716,
-35312,
-37724,
-35893,
-31611,
-30119,
-34288,
-41425,
-45975,
-45643,
-43015,
-42069,
-43338,
-43945,
-41414,
-36550,
-32276,
-30412,
-30448,
-30993,
-31535,
-32434,
-33879,
-35619,
-37567,
-39884,
-42241,
-43341,
-41945,
-38325,
-34308,
-31551,
-30077,
-28628,
-26487,
-24430,
-23867,
-25220,
-27639,
-29991,
-32048,
-34383,
-37430,
-40881,
-43765,
-44969,
-43743,
-40108,
-35389,
-31688,
-30584,
-31525,
-32259,
-31028,
-28697,
-28126,
-31325,
-37115,
-42194,
-44022,
-42799,
-40370,
-38033,
-35660,
-32883,
-30083,
-28154,
-27403,
-27580,
-28608,
-30804,
-33991,
-36883,
-38129,
-37884,
-37706,
-38458,
-38701,
-35964,
-29848,
-23341,
-20485,
-22633,
-27311,
-30930,
-32276,
-33249,
-36202,
-41153,
-45612,
-47020,
-45050,
-41482,
-38270,
-35898,
-33751,
-31713,
-30862,
-32604,
-36603,
-40641,
-42124,
-40537,
-37843,
-36406,
-36720,
-37049,
-35639,
-32635,
-29906,
-29033,
-29867,
-31152,
-31814,
-31611,
-30524,
-28692,
-26975,
-27117,
-30382,
-35658,
-39647,
-39541,
-35714,
-31360,
-29546,
-30453,
-31899,
-31830,
-30203,
-28676,
-28903,
-31454,
-35504,
-39245,
-40797,
-39572,
-37171,
-36217,
-37775,
-39865,
-39189,
-34663,
-28770,
-25408,
-26102,
-29284,
-32278,
-34029,
-35175,
-36627,
-38536,
-40618,
-42344,
-42623,
-39845,
-33555,
-25883,
-20694,
-20518,
-24509,
-29678,
-33982,
-37598,
-41196,
-44117,
-44652,
-42467,
-39316,
-37369,
-36699,
-35402,
-31904,
-27020,
-23296,
-22659,
-24827,
-28083,
-30883,
-32777,
-33902,
-34159,
-33443,
-32149,
-31206,
-31245,
-31857,
-31960,
-31062,
-29634,
-28390,
-27276,
-25864,
-24649,
-25338,
-29052,
-34225,
-37408,
-36410,
-33019,
-31246,
-33145,
-36344,
-36475,
-31892,
-25427,
-21652,
-22621,
-26635,
-30580,
-32851,
-33685,
-33903,
-33678,
-32975,
-32142,
-31683,
-31455,
-30662,
-28732,
-26146,
-23934,
-22690,
-22024,
-21476,
-21453,
-22967,
-26405,
-30570,
-33663,
-35031,
-35674,
-36659,
-37268,
-35358,
-30109,
-23871,
-20683,
-22555,
-27409,
-31286,
-31930,
-30547,
-29731,
-30750,
-33016,
-35394,
-37264,
-38179,
-37322,
-34335,
-30230,
-26910,
-25377,
-24730,
-23574,
-21878,
-21377,
-23574,
-28011,
-32499,
-35145,
-35826,
-35953,
-36716,
-37943,
-38254,
-36425,
-32760,
-28936,
-26681,
-26379,
-27090,
-27992,
-29331,
-31717,
-34941,
-37712,
-39227,
-39836,
-40282,
-40047,
-37900,
-33723,
-29511,
-27530,
-28026,
-29396,
-30601,
-32336,
-35330,
-38242,
-38828,
-36946,
-35549,
-37267,
-40983,
-42605,
-39756,
-34396,
-30515,
-29749,
-30292,
-30069,
-29349,
-30116,
-33069,
-36788,
-39312,
-39905,
-38713,
-35809,
-31318,
-26510,
-23470,
-23402,
-25198,
-26511,
-25811,
-23689,
-21963,
-22340,
-25312,
-29986,
-34539,
-37304,
-38192,
-38552,
-39469,
-39967,
-37907,
-32732,
-27042,
-24300,
-25407,
-28090,
-29896,
-31025,
-33206,
-36739,
-39520,
-39852,
-38614,
-38136,
-38774,
-38370,
-35312,
-31302,
-29728,
-31639,
-34137,
-33923,
-31273,
-30011,
-32878,
-38291,
-41607,
-40090,
-35456,
-31913,
-31970,
-34288,
-35591,
-34032,
-30815,
-28803,
-29863,
-33208,
-36454,
-37692,
-37185,
-36547,
-36870,
-37412,
-36637,
-34119,
-31394,
-30234,
-30721,
-31088,
-29870,
-27773,
-26813,
-28038,
-30238,
-31675,
-32042,
-32500,
-33396,
-33177,
-30212,
-25457,
-22363,
-23535,
-27895,
-31876,
-33065,
-32299,
-31772,
-32244,
-32727,
-32678,
-33048,
-34842,
-37198,
-38264,
-37770,
-37492,
-38718,
-39842,
-37775,
-32080,
-26292,
-24803,
-28228,
-33040,
-35439,
-35095,
-34446,
-35287,
-36811,
-37093,
-35586,
-33380,
-31768,
-31031,
-30988,
-31545,
-32386,
-32453,
-30766,
-27916,
-26165,
-27294,
-30504,
-33035,
-32931,
-30974,
-29443,
-29350,
-29620,
-28878,
-27586,
-27578,
-29636,
-32425,
-33920,
-33926,
-34145,
-35914,
-38419,
-39242,
-37158,
-33196,
-29831,
-28690,
-29706,
-31543,
-32689,
-32071,
-29679,
-26902,
-25882,
-27948,
-32170,
-36054,
-37695,
-37355,
-36511,
-36075,
-35490,
-34109,
-32372,
-31418,
-31744,
-32643,
-33343,
-33892,
-34680,
-35262,
-34484,
-32115,
-29888,
-30187,
-33351,
-36631,
-36478,
-32077,
-26535,
-24199,
-26572,
-30976,
-33316,
-32130,
-29739,
-29530,
-32329,
-35907,
-37638,
-37081,
-35696,
-34456,
-32793,
-29831,
-26141,
-23309,
-22240,
-22393,
-23200,
-25339,
-30019,
-36993,
-43928,
-48177,
-48537,
-45626,
-40660,
-35002,
-30306,
-28063,
-28247,
-28944,
-28155,
-26216,
-25684,
-28422,
-33418,
-37809,
-39971,
-40661,
-41234,
-41417,
-39844,
-36082,
-31584,
-27978,
-25618,
-23840,
-22745,
-23410,
-26486,
-30729,
-33909,
-34531,
-33106,
-31434,
-31202,
-32873,
-35482,
-37068,
-36283,
-33360,
-30139,
-27938,
-26437,
-24473,
-22493,
-22740,
-26575,
-32080,
-35459,
-35227,
-33825,
-34506,
-37111,
-38402,
-36387,
-33011,
-31469,
-31783,
-30871,
-27024,
-23080,
-23426,
-28681,
-34738,
-37464,
-37147,
-37198,
-39158,
-40556,
-38163,
-32117,
-25959,
-22919,
-23108,
-24873,
-27255,
-30817,
-35820,
-40960,
-44112,
-44066,
-41342,
-37617,
-34587,
-33241,
-33302,
-33689,
-33327,
-32202,
-30997,
-29981,
-28620,
-26731,
-25826,
-28086,
-33884,
-40525,
-44309,
-43841,
-40621,
-36879,
-33104,
-28764,
-24250,
-21292,
-20966,
-22163,
-22977,
-23098,
-24220,
-27625,
-32385,
-36182,
-37784,
-37656,
-36517,
-34240,
-30689,
-27154,
-25591,
-26499,
-28397,
-29721,
-30887,
-33276,
-36566,
-38238,
-36360,
-32228,
-29345,
-29590,
-31627,
-33040,
-33339,
-33743,
-34516,
-34030,
-31092,
-27110,
-24842,
-25229,
-26558,
-27414,
-28709,
-32016,
-36191,
-37570,
-34138,
-28471,
-25167,
-25798,
-27721,
-27960,
-27116,
-28177,
-32244,
-37121,
-40217,
-41474,
-42384,
-42944,
-41388,
-37245,
-33181,
-32529,
-35388,
-38280,
-37900,
-34488,
-30863,
-29200,
-29255,
-29782,
-30422,
-31924,
-34885,
-39061,
-43113,
-45233,
-43830,
-39005,
-33179,
-29578,
-29244,
-29981,
-28837,
-25428,
-22429,
-22180,
-24306,
-26814,
-28927,
-31830,
-35833,
-38974,
-38612,
-34816,
-30511,
-28474,
-28734,
-29592,
-30162,
-31135,
-32952,
-34669,
-35322,
-35520,
-36837,
-39201,
-40121,
-37196,
-31123,
-25591,
-23729,
-25271,
-27166,
-27089,
-25530,
-24929,
-26872,
-30648,
-34282,
-36397,
-36861,
-36052,
-33983,
-30772,
-27459,
-25826,
-26748,
-29097,
-30519,
-29871,
-28316,
-27994,
-29650,
-31948,
-33223,
-33409,
-33795,
-35337,
-37285,
-38081,
-36812,
-34000,
-31065,
-29305,
-29217,
-30144,
-30568,
-29443,
-27320,
-26404,
-28177,
-31762,
-34492,
-34974,
-34663,
-35987,
-39005,
-40847,
-38818,
-33662,
-28869,
-27188,
-28224,
-29863,
-31210,
-33181,
-36734,
-40958,
-43915,
-44462,
-43049,
-40672,
-37809,
-34722,
-32244,
-31611,
-33178,
-35720,
-37067,
-35969,
-33089,
-30675,
-30770,
-33678,
-37582,
-39964,
-39590,
-37293,
-34916,
-33360,
-32134,
-30437,
-28679,
-28084,
-29283,
-31608,
-33943,
-36050,
-38325,
-40640,
-41998,
-41506,
-39684,
-37914,
-37195,
-37354,
-37686,
-37806,
-37455,
-36214,
-33836,
-31196,
-29954,
-31061,
-33454,
-35037,
-34853,
-33982,
-34232,
-35959,
-38067,
-39331,
-39892,
-40578,
-41491,
-41456,
-39193,
-34737,
-29729,
-26285,
-25434,
-26609,
-28195,
-28937,
-28746,
-28378,
-28390,
-28452,
-28033,
-27368,
-27534,
-29192,
-31641,
-33312,
-33314,
-32090,
-30627,
-29388,
-28487,
-28408,
-29895,
-32752,
-35256,
-35362,
-32699,
-28704,
-25177,
-22604,
-20601,
-19278,
-19673,
-22608,
-27444,
-32498,
-36182,
-38094,
-38587,
-38368,
-37924,
-37353,
-36164,
-33732,
-30126,
-26558,
-24333,
-23524,
-23025,
-22203,
-22029,
-23975,
-27880,
-31584,
-33108,
-32630,
-32007,
-32559,
-33817,
-34556,
-34049,
-32350,
-29863,
-27574,
-26960,
-28616,
-30427,
-28905,
-23222,
-17773,
-18669,
-27097,
-37152,
-41414,
-38528,
-33794,
-32623,
-34495,
-34767,
-31014,
-25913,
-23712,
-25343,
-28447,
-30742,
-32155,
-33210,
-33550,
-32914,
-32470,
-33806,
-36190,
-36804,
-33890,
-29156,
-25816,
-25089,
-25502,
-25722,
-26278,
-28053,
-30301,
-31556,
-32170,
-33997,
-37344,
-39478,
-37819,
-33654,
-30892,
-31220,
-31874,
-29823,
-26348,
-25843,
-29814,
-34353,
-34793,
-31692,
-30289,
-34142,
-40782,
-44708,
-43033,
-37329,
-30584,
-24372,
-19627,
-17640,
-19104,
-22052,
-23391,
-22487,
-22394,
-25945,
-31747,
-35372,
-34775,
-32941,
-34172,
-38530,
-41391,
-38777,
-32033,
-26435,
-25860,
-29247,
-32552,
-32909,
-30859,
-29042,
-29469,
-32205,
-35721,
-38415,
-39529,
-39250,
-38112,
-36363,
-34260,
-32214,
-30811,
-30064,
-29405,
-28424,
-27661,
-27962,
-29296,
-30645,
-31404,
-32381,
-34467,
-36681,
-36485,
-32901,
-28627,
-27867,
-31681,
-36354,
-37091,
-33206,
-28638,
-27707,
-30574,
-34043,
-35332,
-34712,
-33877,
-33386,
-32523,
-31139,
-30531,
-31504,
-32795,
-32246,
-29630,
-27531,
-28282,
-31002,
-32027,
-29135,
-24129,
-21316,
-22774,
-26789,
-29789,
-30344,
-29633,
-29334,
-29529,
-29275,
-28299,
-27337,
-26822,
-26340,
-25567,
-25232,
-26163,
-27730,
-28068,
-26525,
-24876,
-25657,
-28780,
-31421,
-30878,
-27866,
-25415,
-25409,
-26682,
-27083,
-26538,
-27131,
-30081,
-33770,
-35271,
-33636,
-30988,
-30031,
-31250,
-32669,
-32240,
-29993,
-27621,
-26563,
-26844,
-27576,
-28190,
-28626,
-28787,
-28331,
-27477,
-27620,
-30218,
-34721,
-37965,
-36744,
-31246,
-25618,
-24022,
-26369,
-28415,
-26619,
-22200,
-19877,
-22523,
-28222,
-32770,
-34299,
-34408,
-35181,
-36147,
-35330,
-32010,
-27909,
-25209,
-24724,
-26035,
-28657,
-32078,
-35304,
-37296,
-38392,
-39850,
-41772,
-42052,
-38782,
-33491,
-30441,
-31974,
-35483,
-36168,
-32490,
-27873,
-26253,
-28028,
-30449,
-31931,
-33396,
-35848,
-38042,
-38064,
-36272,
-34906,
-34894,
-34538,
-32304,
-29522,
-28866,
-30470,
-31608,
-30699,
-30059,
-33210,
-39940,
-46010,
-47855,
-46248,
-43972,
-41723,
-37732,
-31668,
-26331,
-24491,
-25326,
-25790,
-25150,
-25908,
-29873,
-34649,
-36307,
-34319,
-32355,
-33384,
-36089,
-36979,
-35337,
-33636,
-33709,
-34006,
-32109,
-28402,
-25757,
-25879,
-27556,
-29124,
-30718,
-33382,
-36552,
-38425,
-38611,
-38683,
-39511,
-39346,
-36213,
-31358,
-28526,
-29304,
-31157,
-30892,
-29249,
-29711,
-33315,
-36765,
-36648,
-34073,
-32968,
-34541,
-35590,
-33167,
-28997,
-27296,
-29353,
-31915,
-32081,
-31059,
-32339,
-36359,
-39892,
-40025,
-37951,
-37087,
-38900,
-41714,
-43256,
-42981,
-41577,
-39714,
-38074,
-37872,
-39673,
-41969,
-42118,
-39523,
-36683,
-36599,
-39363,
-42635,
-44692,
-45862,
-46482,
-45331,
-41255,
-35898,
-32536,
-32193,
-32191,
-29938,
-26984,
-27586,
-33181,
-40054,
-43511,
-43089,
-42296,
-43480,
-44884,
-43563,
-39663,
-36284,
-35457,
-35574,
-33949,
-30213,
-26892,
-26289,
-28396,
-31562,
-34575,
-37194,
-39525,
-41282,
-42171,
-42068,
-41030,
-39202,
-36974,
-34916,
-33362,
-32417,
-32366,
-33590,
-35534,
-36459,
-35152,
-33018,
-33278,
-37075,
-41412,
-42115,
-38999,
-36365,
-37575,
-40454,
-39773,
-34128,
-28218,
-27383,
-31377,
-35347,
-36440,
-36899,
-39871,
-44151,
-45438,
-42521,
-39419,
-40491,
-44663,
-46652,
-43321,
-37057,
-32422,
-31292,
-32428,
-34722,
-38395,
-43034,
-46205,
-45811,
-42849,
-40409,
-40010,
-40217,
-39409,
-38258,
-38464,
-39613,
-39214,
-36055,
-32282,
-30899,
-32302,
-34021,
-34089,
-32982,
-32274,
-32375,
-32849,
-33853,
-35906,
-38041,
-37671,
-33586,
-28138,
-25360,
-26781,
-30093,
-32189,
-32547,
-32765,
-33725,
-34523,
-34389,
-34208,
-35239,
-37104,
-37939,
-36841,
-34646,
-32481,
-30141,
-27322,
-25366,
-26678,
-31657,
-37252,
-39669,
-38075,
-35239,
-34229,
-35439,
-36965,
-37138,
-36037,
-34704,
-34031,
-34262,
-35086,
-35433,
-33973,
-30487,
-26917,
-25912,
-28218,
-31665,
-33553,
-33409,
-32986,
-33544,
-34291,
-33795,
-32258,
-31262,
-31719,
-32786,
-33522,
-34161,
-35300,
-36005,
-34532,
-31057,
-28685,
-30396,
-35313,
-39140,
-38733,
-35234,
-32229,
-31353,
-31116,
-29785,
-28038,
-27849,
-29443,
-30910,
-30822,
-30129,
-30725,
-32778,
-34757,
-35675,
-36367,
-37885,
-39534,
-39619,
-37754,
-35433,
-34237,
-34051,
-34031,
-34287,
-35638,
-37596,
-37914,
-34970,
-30160,
-26954,
-27351,
-30133,
-32544,
-33192,
-32451,
-30909,
-28467,
-25483,
-23523,
-24138,
-26896,
-29631,
-30765,
-31047,
-32203,
-34764,
-37216,
-37819,
-36088,
-32924,
-29528,
-27012,
-26308,
-27811,
-30622,
-32851,
-33190,
-32131,
-31249,
-31498,
-32357,
-32886,
-32771,
-32435,
-32016,
-31476,
-30928,
-30880,
-31283,
-31217,
-29809,
-27574,
-26034,
-25996,
-26520,
-26451,
-26162,
-27584,
-31404,
-35624,
-36991,
-34563,
-30944,
-29754,
-31980,
-35166,
-36002,
-33814,
-30849,
-30291,
-33313,
-38551,
-42988,
-44032,
-40856,
-35113,
-30113,
-28633,
-30591,
-32974,
-32365,
-28581,
-24831,
-24636,
-27752,
-30396,
-29239,
-25292,
-22765,
-24518,
-28957,
-32153,
-32298,
-31114,
-30980,
-31696,
-31239,
-29187,
-27805,
-29127,
-31905,
-32874,
-31117,
-29679,
-31888,
-36696,
-39266,
-36426,
-30640,
-27400,
-29291,
-33507,
-35622,
-34410,
-32292,
-31664,
-32214,
-32323,
-31695,
-31437,
-32004,
-32250,
-31340,
-30429,
-31300,
-33668,
-34902,
-33223,
-30271,
-29431,
-31655,
-34106,
-33352,
-29598,
-26493,
-26990,
-30250,
-33117,
-34084,
-34716,
-36999,
-40158,
-40987,
-37462,
-31370,
-27269,
-28547,
-34508,
-41075,
-43963,
-42066,
-37709,
-34348,
-33301,
-33054,
-31457,
-28664,
-27172,
-28895,
-32483,
-34558,
-33351,
-30591,
-29101,
-29306,
-29089,
-27037,
-24755,
-24895,
-27608,
-30226,
-30562,
-29676,
-30352,
-33368,
-36477,
-36911,
-34187,
-29786,
-25220,
-21476,
-19922,
-22061,
-27409,
-32531,
-33795,
-31226,
-28715,
-29783,
-33624,
-36293,
-35235,
-31945,
-29792,
-30304,
-32309,
-33886,
-34463,
-34213,
-33151,
-30997,
-28292,
-26412,
-26457,
-28320,
-30893,
-32985,
-33739,
-32914,
-31089,
-29527,
-29112,
-29359,
-28935,
-27623,
-26887,
-28314,
-31178,
-32908,
-31909,
-29531,
-28555,
-29928,
-32074,
-32892,
-32317,
-31569,
-31433,
-31245,
-30458,
-29468,
-29108,
-29515,
-30345,
-31791,
-34195,
-36852,
-37725,
-35599,
-31927,
-29742,
-30521,
-32737,
-33763,
-32926,
-31745,
-31729,
-32791,
-33741,
-33924,
-33152,
-31168,
-27999,
-25089,
-24910,
-28309,
-32802,
-34424,
-31874,
-27980,
-26603,
-28519,
-30782,
-30342,
-27166,
-23824,
-22671,
-23991,
-26602,
-29171,
-30683,
-30669,
-29573,
-28818,
-29432,
-30706,
-30694,
-28775,
-26725,
-26747,
-28245,
-28036,
-24086,
-18686,
-16634,
-20265,
-26986,
-32035,
-33298,
-32481,
-32191,
-32832,
-32949,
-31698,
-29811,
-28143,
-26413,
-24027,
-21712,
-21187,
-23019,
-25608,
-26745,
-26143,
-25648,
-27000,
-29952,
-32684,
-33817,
-33417,
-32112,
-30173,
-27544,
-24715,
-22798,
-22635,
-24004,
-25863,
-27305,
-28133,
-29019,
-30757,
-33753,
-37257,
-39613,
-39095,
-35355,
-29856,
-25211,
-23471,
-25144,
-28738,
-31830,
-32382,
-30539,
-28787,
-30193,
-35340,
-41194,
-43615,
-41233,
-36979,
-35019,
-36606,
-39103,
-39015,
-35567,
-30979,
-28001,
-27569,
-28810,
-30269,
-30990,
-30668,
-29922,
-30000,
-31881,
-35077,
-37636,
-37771,
-35505,
-32330,
-29712,
-27873,
-26521,
-25788,
-26463,
-28814,
-32074,
-34631,
-35175,
-33377,
-30295,
-27868,
-27882,
-30485,
-33837,
-35533,
-34554,
-32037,
-29920,
-29208,
-29620,
-30246,
-30423,
-29803,
-28628,
-27828,
-28504,
-30426,
-31830,
-31120,
-29273,
-29199,
-32458,
-36620,
-37682,
-34374,
-29985,
-28567,
-30464,
-32303,
-31332,
-28608,
-27301,
-28585,
-30634,
-31168,
-30291,
-29676,
-30110,
-30757,
-30817,
-30980,
-32299,
-34486,
-36044,
-36289,
-36354,
-37621,
-39615,
-40174,
-37961,
-34235,
-31729,
-31765,
-32908,
-32672,
-30226,
-27305,
-26316,
-27913,
-30589,
-32637,
-33975,
-35897,
-38984,
-41971,
-43081,
-42122,
-40818,
-40684,
-41318,
-41199,
-40046,
-39231,
-39664,
-40040,
-38288,
-34661,
-32303,
-33698,
-37451,
-39478,
-37581,
-33953,
-32365,
-33909,
-36422,
-37831,
-38750,
-40649,
-42987,
-43110,
-39949,
-35584,
-33298,
-33686,
-34685,
-34623,
-34422,
-35970,
-39183,
-41860,
-42179,
-40500,
-38328,
-36480,
-34930,
-34113,
-34910,
-37422,
-40192,
-41666,
-41843,
-42024,
-42966,
-43937,
-43808,
-42397,
-40448,
-38653,
-37380,
-37005,
-37802,
-39104,
-39386,
-37675,
-34755,
-32480,
-31898,
-32631,
-33846,
-35213,
-36387,
-36684,
-35847,
-35137,
-36290,
-39060,
-40799,
-39401,
-36145,
-34308,
-35046,
-35651,
-33258,
-28825,
-26428,
-28194,
-31722,
-33209,
-32148,
-31567,
-33479,
-36282,
-36808,
-34787,
-33035,
-34069,
-37143,
-39453,
-39399,
-37642,
-35909,
-35180,
-35560,
-36429,
-36533,
-34630,
-30919,
-27661,
-27216,
-29506,
-31935,
-32575,
-32296,
-33223,
-35243,
-35724,
-32932,
-28834,
-27175,
-29122,
-31920,
-32220,
-29892,
-27720,
-28072,
-30604,
-33389,
-34867,
-34496,
-32247,
-28917,
-26339,
-26432,
-28903,
-31349,
-32028,
-32329,
-35224,
-40958,
-45709,
-45393,
-40429,
-35524,
-34501,
-36348,
-37021,
-34595,
-31148,
-29869,
-31063,
-32240,
-31526,
-29955,
-30004,
-32611,
-36024,
-37754,
-36822,
-34539,
-33044,
-33595,
-35591,
-37150,
-36734,
-34630,
-32762,
-33043,
-35325,
-37581,
-37705,
-35488,
-32682,
-31417,
-32607,
-35401,
-37865,
-38328,
-36670,
-34764,
-34868,
-37322,
-39630,
-38877,
-34922,
-30995,
-30120,
-31881,
-33057,
-31910,
-30426,
-31892,
-36434,
-40377,
-40121,
-35906,
-31357,
-29519,
-30467,
-32246,
-33331,
-33351,
-32439,
-30863,
-29510,
-29695,
-31779,
-34284,
-35156,
-33919,
-32198,
-31970,
-33511,
-35445,
-36357,
-36010,
-35153,
-34564,
-34553,
-34866,
-34951,
-34240,
-32799,
-31399,
-30859,
-31134,
-31207,
-30308,
-28618,
-27162,
-26703,
-27390,
-28978,
-30993,
-32629,
-32920,
-31808,
-30558,
-30812,
-32869,
-35295,
-36451,
-36006,
-34842,
-33863,
-33484,
-33994,
-35420,
-36672,
-35773,
-32061,
-28034,
-27653,
-32048,
-37520,
-38959,
-35223,
-30407,
-29370,
-32817,
-37226,
-38962,
-37493,
-34627,
-32258,
-31458,
-32774,
-35898,
-38704,
-38403,
-34541,
-30190,
-29046,
-31152,
-32828,
-31136,
-27547,
-26040,
-28092,
-30952,
-31133,
-28630,
-26456,
-26801,
-28743,
-30166,
-30489,
-30720,
-31451,
-31980,
-31748,
-31261,
-31260,
-31304,
-30496,
-29201,
-29085,
-30990,
-33324,
-33713,
-31716,
-29415,
-28776,
-29382,
-29082,
-26784,
-23816,
-22486,
-23843,
-26808,
-29352,
-30061,
-29052,
-27848,
-28182,
-30379,
-32826,
-33281,
-31436,
-29474,
-29780,
-32173,
-33923,
-32956,
-30102,
-28061,
-28155,
-29337,
-29967,
-29913,
-30011,
-30463,
-30703,
-30983,
-32633,
-35841,
-38026,
-36014,
-30268,
-25713,
-27040,
-33162,
-37738,
-35683,
-28808,
-23956,
-25871,
-32528,
-37640,
-37378,
-33229,
-29492,
-28312,
-28589,
-28356,
-27447,
-26911,
-27056,
-26732,
-25070,
-22991,
-22429,
-24139,
-26826,
-28599,
-29176,
-29826,
-31580,
-33570,
-33878,
-31801,
-28850,
-27437,
-28550,
-31093,
-33332,
-34544,
-35082,
-35128,
-34162,
-31943,
-29643,
-29187,
-31315,
-34399,
-35890,
-34767,
-32230,
-30082,
-28798,
-27628,
-26421,
-26068,
-27228,
-28841,
-29151,
-28000,
-27272,
-28521,
-30571,
-30823,
-28611,
-26748,
-28194,
-32153,
-34130,
-30727,
-23590,
-18030,
-17918,
-22426,
-27682,
-30617,
-30883,
-29875,
-29096,
-29569,
-31426,
-33567,
-33866,
-31368,
-27821,
-26575,
-28856,
-32003,
-32293,
-29227,
-26540,
-27721,
-32115,
-35485,
-35001,
-32168,
-30537,
-31473,
-32887,
-32464,
-30609,
-29861,
-31617,
-34557,
-36211,
-35581,
-33607,
-31746,
-30577,
-30013,
-29804,
-29702,
-29211,
-28183,
-27468,
-28481,
-31471,
-34645,
-35596,
-33902,
-31729,
-31502,
-33245,
-34504,
-33501,
-31012,
-29449,
-29766,
-30494,
-29941,
-28729,
-29264,
-32804,
-37493,
-40139,
-39448,
-37128,
-35804,
-36308,
-37392,
-37612,
-36789,
-35669,
-34720,
-33841,
-33170,
-33260,
-34501,
-36249,
-37178,
-36653,
-35317,
-34544,
-34972,
-35884,
-36131,
-35381,
-34632,
-35022,
-36338,
-36851,
-35111,
-31619,
-28956,
-29174,
-31999,
-34940,
-36046,
-35457,
-34905,
-35470,
-36816,
-38050,
-38928,
-39487,
-39451,
-38123,
-35742,
-33619,
-32996,
-33711,
-34465,
-34556,
-34624,
-35634,
-37415,
-38630,
-38249,
-36592,
-34900,
-34112,
-34401,
-35449,
-36946,
-38458,
-39330,
-38844,
-36838,
-34055,
-31974,
-31995,
-34474,
-38174,
-40996,
-41450,
-39793,
-37471,
-35761,
-34911,
-34859,
-35886,
-38244,
-41159,
-43001,
-42956,
-41844,
-41026,
-40532,
-39137,
-36463,
-34103,
-34032,
-36106,
-38047,
-38074,
-36868,
-36278,
-36869,
-37196,
-36015,
-33900,
-32479,
-32450,
-32989,
-33238,
-33366,
-34234,
-36227,
-38960,
-41715,
-43577,
-43683,
-41790,
-39047,
-37344,
-37402,
-38105,
-38169,
-38336,
-40775,
-46000,
-51236,
-52803,
-49933,
-45245,
-41780,
-39947,
-38627,
-37404,
-37227,
-38366,
-39428,
-39038,
-37556,
-36348,
-35641,
-34484,
-32986,
-33176,
-36470,
-40961,
-42605,
-39679,
-34858,
-32389,
-33650,
-36474,
-38240,
-38301,
-37337,
-35732,
-33867,
-33241,
-35451,
-39774,
-42973,
-42688,
-40241,
-38943,
-39749,
-40045,
-37451,
-33423,
-31907,
-34538,
-38751,
-41018,
-40689,
-39593,
-38803,
-37376,
-34720,
-32605,
-33211,
-36143,
-38154,
-36918,
-33479,
-30868,
-30578,
-31600,
-32398,
-32817,
-33299,
-33515,
-32485,
-30289,
-28633,
-29151,
-31865,
-35029,
-36776,
-36054,
-33145,
-29602,
-27991,
-30147,
-35041,
-38774,
-37683,
-32198,
-26676,
-25395,
-28558,
-32779,
-34974,
-35041,
-34710,
-34795,
-34365,
-32427,
-29365,
-26595,
-25144,
-25314,
-27123,
-30579,
-34939,
-38593,
-39897,
-38417,
-35266,
-32172,
-30542,
-30785,
-32124,
-32932,
-31851,
-29407,
-27917,
-29425,
-33138,
-35725,
-34574,
-30708,
-27706,
-27888,
-29827,
-30304,
-28016,
-24976,
-24057,
-26108,
-29594,
-32567,
-33957,
-33308,
-30187,
-25093,
-20355,
-19090,
-22536,
-28474,
-33053,
-33982,
-32147,
-30013,
-29058,
-28980,
-28803,
-28211,
-27683,
-27628,
-27920,
-28193,
-28190,
-28239,
-28920,
-30782,
-33515,
-35807,
-36226,
-34623,
-32649,
-32228,
-33460,
-34401,
-33138,
-30180,
-28045,
-28765,
-31657,
-34277,
-34757,
-33269,
-31041,
-28905,
-27009,
-25622,
-25394,
-26434,
-27829,
-28212,
-27240,
-25880,
-25473,
-26255,
-27405,
-27657,
-26566,
-24609,
-22907,
-22319,
-23042,
-24281,
-25180,
-25277,
-25005,
-24912,
-25253,
-25936,
-26862,
-27947,
-28684,
-28376,
-26916,
-25372,
-24999,
-26035,
-27277,
-27626,
-27264,
-27081,
-27346,
-27186,
-26184,
-25224,
-25721,
-27692,
-29577,
-30121,
-29715,
-29617,
-29984,
-29611,
-27921,
-26226,
-26560,
-29080,
-31576,
-31737,
-29696,
-27807,
-28015,
-29883,
-31283,
-30761,
-28942,
-27685,
-28157,
-29752,
-30930,
-30806,
-30150,
-30449,
-32156,
-33933,
-33949,
-32150,
-30592,
-31395,
-34119,
-36011,
-34894,
-31721,
-29556,
-30352,
-32970,
-34821,
-34723,
-33666,
-33056,
-32894,
-32475,
-31831,
-31971,
-33172,
-34282,
-34045,
-33043,
-33101,
-34647,
-35440,
-32752,
-26985,
-22090,
-21814,
-25846,
-30133,
-31108,
-29185,
-27576,
-28372,
-30350,
-30825,
-28988,
-26871,
-26787,
-28727,
-30208,
-29039,
-25641,
-22870,
-23398,
-27442,
-32621,
-35898,
-35900,
-33460,
-30684,
-29108,
-29090,
-29894,
-30516,
-30039,
-28134,
-25438,
-23647,
-24245,
-27072,
-30028,
-31034,
-30253,
-29928,
-31729,
-34494,
-35279,
-32939,
-29623,
-28815,
-31215,
-33976,
-33751,
-30450,
-27367,
-27750,
-31439,
-35390,
-36711,
-35297,
-33241,
-32468,
-32960,
-33304,
-32287,
-30145,
-28278,
-28050,
-29777,
-32409,
-34395,
-34686,
-33749,
-33109,
-34277,
-37136,
-39962,
-40608,
-38564,
-35254,
-32781,
-31848,
-31531,
-30746,
-29902,
-30385,
-32784,
-35794,
-37611,
-37846,
-37890,
-39028,
-40723,
-41443,
-40354,
-38365,
-36684,
-35433,
-33928,
-32146,
-31158,
-31964,
-34204,
-36512,
-37944,
-38358,
-37872,
-36325,
-34107,
-32724,
-33671,
-36471,
-38340,
-36764,
-32231,
-27978,
-26910,
-28859,
-31180,
-31768,
-30743,
-29747,
-29824,
-30725,
-31848,
-33179,
-35103,
-37341,
-38635,
-37536,
-33795,
-29126,
-26372,
-27452,
-31501,
-35129,
-35199,
-31696,
-27841,
-26908,
-29130,
-31957,
-33251,
-33435,
-34264,
-36011,
-36993,
-35943,
-33740,
-32332,
-32167,
-31954,
-30883,
-29995,
-30710,
-32367,
-32766,
-30958,
-28826,
-28930,
-31379,
-33717,
-33912,
-32414,
-31027,
-30522,
-30273,
-30097,
-30862,
-33167,
-35683,
-36452,
-34887,
-32631,
-31347,
-31118,
-30942,
-30554,
-30605,
-31466,
-32267,
-32149,
-31292,
-30698,
-30556,
-30105,
-28852,
-27622,
-27926,
-30310,
-34054,
-37733,
-40063,
-40063,
-37306,
-32895,
-29069,
-27856,
-29179,
-31218,
-32582,
-33615,
-35373,
-37680,
-38828,
-37454,
-34040,
-30546,
-28783,
-29483,
-32296,
-35956,
-38593,
-38609,
-36067,
-32957,
-31335,
-31561,
-32175,
-31902,
-30884,
-29919,
-29213,
-28471,
-28234,
-29777,
-33635,
-38216,
-41138,
-41407,
-40087,
-38648,
-37476,
-36265,
-35435,
-36071,
-38388,
-41046,
-42183,
-41225,
-38916,
-36262,
-33731,
-31905,
-31729,
-33658,
-36527,
-38122,
-37141,
-34654,
-33073,
-34099,
-37305,
-40563,
-41554,
-39206,
-34623,
-30658,
-30162,
-33613,
-38519,
-41421,
-40769,
-37748,
-34454,
-31865,
-29998,
-29221,
-30318,
-32957,
-35077,
-34854,
-33067,
-32542,
-34892,
-38385,
-39878,
-38378,
-36088,
-35693,
-37441,
-39289,
-39619,
-38541,
-37150,
-35859,
-34425,
-33038,
-32374,
-32856,
-33843,
-34466,
-34382,
-33982,
-33780,
-34041,
-34875,
-36077,
-36931,
-36586,
-34986,
-33083,
-31883,
-31438,
-31248,
-31383,
-32509,
-34458,
-35712,
-35031,
-33323,
-32916,
-34368,
-35263,
-32667,
-26983,
-21965,
-20916,
-23522,
-26944,
-29204,
-30600,
-31888,
-32823,
-32955,
-33144,
-34699,
-37173,
-38179,
-35990,
-31927,
-28764,
-27767,
-27638,
-27075,
-26761,
-28358,
-31784,
-34872,
-35793,
-34879,
-33662,
-32744,
-31700,
-30703,
-31087,
-33573,
-36597,
-37585,
-35646,
-32751,
-31558,
-32855,
-35245,
-36914,
-37181,
-36177,
-34237,
-31582,
-28748,
-26421,
-25169,
-25399,
-27355,
-30559,
-33160,
-32888,
-29272,
-24873,
-23355,
-26009,
-30709,
-34392,
-36179,
-37152,
-37898,
-37356,
-34933,
-32518,
-32897,
-36138,
-38650,
-36995,
-32002,
-28196,
-28843,
-32640,
-35576,
-35526,
-34073,
-33863,
-35527,
-37508,
-38420,
-38445,
-38434,
-38421,
-37799,
-36339,
-34704,
-33568,
-32926,
-32183,
-31031,
-29805,
-29271,
-30189,
-32642,
-35700,
-37807,
-37960,
-36809,
-36140,
-36880,
-38080,
-38020,
-36443,
-34995,
-35194,
-36525,
-37183,
-36567,
-36142,
-37478,
-39668,
-39998,
-36918,
-32481,
-30538,
-33024,
-37700,
-40171,
-37840,
-32233,
-27445,
-26544,
-29048,
-31862,
-32372,
-30685,
-29012,
-29048,
-30396,
-31546,
-31903,
-32242,
-33118,
-33727,
-32940,
-31297,
-30971,
-33243,
-36589,
-38022,
-36384,
-33640,
-32523,
-33379,
-34072,
-32706,
-29926,
-28026,
-28427,
-30533,
-32890,
-34557,
-35355,
-35158,
-33877,
-31972,
-30379,
-29722,
-29868,
-30449,
-31508,
-33121,
-34724,
-35303,
-34717,
-34024,
-34361,
-35311,
-35495,
-34519,
-33877,
-35174,
-37737,
-38737,
-36242,
-31522,
-28120,
-28395,
-31624,
-35076,
-36748,
-36436,
-35038,
-33348,
-32154,
-32201,
-34040,
-36848,
-38851,
-38613,
-36423,
-34148,
-33508,
-34848,
-36977,
-38486,
-38727,
-38096,
-37394,
-37061,
-36905,
-36464,
-35720,
-35224,
-35497,
-36343,
-36858,
-36515,
-35842,
-35783,
-36412,
-36432,
-34653,
-31694,
-29877,
-30941,
-34065,
-36434,
-36161,
-34191,
-33044,
-33809,
-34639,
-32949,
-28531,
-24373,
-23761,
-27168,
-32023,
-35475,
-36832,
-36981,
-36453,
-34738,
-31858,
-29509,
-29591,
-31760,
-33126,
-31327,
-27317,
-24671,
-25806,
-29523,
-32501,
-32806,
-31425,
-30432,
-30488,
-30549,
-29569,
-27916,
-26875,
-27353,
-29181,
-31415,
-32892,
-32582,
-30277,
-26993,
-24831,
-25493,
-29045,
-33664,
-37081,
-38039,
-36940,
-35252,
-34420,
-34916,
-36149,
-36974,
-36770,
-35652,
-34075,
-32243,
-30327,
-29218,
-30167,
-33449,
-37360,
-39340,
-38346,
-35822,
-34061,
-34114,
-35199,
-36335,
-37040,
-37065,
-35704,
-32821,
-29823,
-28804,
-30118,
-31725,
-31405,
-29643,
-28927,
-30670,
-33175,
-33863,
-32370,
-30814,
-30788,
-31348,
-30584,
-28613,
-27678,
-29513,
-33135,
-36009,
-36671,
-35615,
-33987,
-32336,
-30956,
-30599,
-31889,
-34368,
-36447,
-36977,
-36120,
-34798,
-33651,
-32838,
-32576,
-33057,
-33845,
-34073,
-33609,
-33627,
-35236,
-37607,
-38319,
-35978,
-32237,
-30489,
-32378,
-36113,
-38203,
-36868,
-33275,
-30154,
-29151,
-30215,
-32156,
-34067,
-35469,
-36022,
-35226,
-32875,
-29662,
-27318,
-27458,
-30109,
-33322,
-34684,
-33599,
-31687,
-31155,
-32395,
-34049,
-34810,
-34882,
-35118,
-35340,
-34307,
-31642,
-29046,
-28879,
-31513,
-34623,
-35496,
-33672,
-31224,
-30431,
-31700,
-33634,
-34796,
-34959,
-34826,
-35013,
-35365,
-35448,
-35138,
-34877,
-35082,
-35585,
-35695,
-34961,
-33801,
-33071,
-33085,
-33377,
-33440,
-33717,
-34852,
-36471,
-36758,
-34417,
-30375,
-27392,
-27236,
-29156,
-31060,
-32207,
-33718,
-36442,
-39129,
-39487,
-36859,
-33263,
-31207,
-31305,
-32010,
-32031,
-31654,
-32218,
-34058,
-36094,
-36903,
-36356,
-35515,
-35473,
-36012,
-35604,
-33021,
-28834,
-25783,
-26524,
-31095,
-36236,
-38113,
-35831,
-32117,
-30434,
-31647,
-33837,
-35131,
-35651,
-36581,
-38014,
-38796,
-38419,
-38141,
-39210,
-40919,
-40999,
-38632,
-35869,
-35483,
-37630,
-39364,
-37992,
-34156,
-31212,
-31716,
-34831,
-37556,
-37668,
-35484,
-33013,
-31949,
-32685,
-34476,
-36060,
-36384,
-34957,
-32465,
-30356,
-29901,
-31135,
-32870,
-33950,
-34345,
-34998,
-36276,
-37114,
-35779,
-32177,
-28673,
-28356,
-31810,
-36137,
-37598,
-35444,
-32612,
-32601,
-35706,
-39201,
-40466,
-39599,
-38162,
-36786,
-34771,
-32357,
-31628,
-34488,
-39529,
-42805,
-41509,
-36917,
-32740,
-31377,
-32193,
-33465,
-34438,
-35283,
-35647,
-34647,
-32404,
-30413,
-30081,
-31116,
-32231,
-32761,
-33173,
-33532,
-33169,
-31716,
-30405,
-30789,
-32706,
-34189,
-33990,
-33062,
-32978,
-33331,
-32193,
-29062,
-26310,
-26610,
-29636,
-32432,
-33114,
-32722,
-33247,
-34491,
-34638,
-33260,
-32315,
-33376,
-35146,
-34910,
-32440,
-30548,
-31631,
-34469,
-35891,
-34891,
-33768,
-34669,
-36505,
-36290,
-33276,
-30126,
-29805,
-32103,
-34341,
-34715,
-34052,
-33985,
-34791,
-35518,
-35865,
-36464,
-37415,
-37383,
-35219,
-31806,
-29739,
-30624,
-33393,
-35530,
-35530,
-33976,
-32267,
-31200,
-30717,
-30506,
-30261,
-29592,
-28282,
-27059,
-27259,
-29673,
-33279,
-35866,
-35924,
-33938,
-31731,
-30725,
-30835,
-31002,
-30539,
-29708,
-29471,
-30284,
-31725,
-32659,
-32535,
-31891,
-31913,
-33039,
-34299,
-34270,
-32610,
-30417,
-28919,
-28201,
-27504,
-26590,
-26204,
-26896,
-28109,
-28677,
-28507,
-28655,
-29883,
-31453,
-32078,
-31715,
-31811,
-33268,
-34937,
-34633,
-31718,
-28101,
-26496,
-27884,
-30882,
-33271,
-33832,
-32908,
-31711,
-31441,
-32505,
-34347,
-35708,
-35531,
-33644,
-30695,
-27779,
-26056,
-26717,
-30172,
-35079,
-38567,
-38318,
-34857,
-31212,
-29982,
-31058,
-32396,
-32738,
-32663,
-32999,
-33184,
-32186,
-30234,
-29037,
-29355,
-30107,
-29712,
-28725,
-28933,
-30857,
-32333,
-31224,
-28390,
-27034,
-29024,
-32545,
-34409,
-33520,
-31531,
-30074,
-28890,
-27094,
-25591,
-26423,
-30107,
-34077,
-35217,
-33071,
-30183,
-29140,
-30076,
-31392,
-32082,
-32531,
-33178,
-33335,
-31978,
-29429,
-27278,
-26844,
-27791,
-28830,
-29379,
-29954,
-31156,
-32425,
-32530,
-30915,
-28510,
-26981,
-27274,
-28960,
-30646,
-31031,
-29728,
-27594,
-26374,
-27633,
-31495,
-35962,
-38168,
-36475,
-32057,
-28052,
-26942,
-28663,
-31051,
-32166,
-31919,
-31498,
-31545,
-31509,
-30585,
-29359,
-29407,
-31680,
-35033,
-37035,
-36139,
-33079,
-30154,
-29150,
-30096,
-31768,
-33121,
-34082,
-35138,
-36252,
-36732,
-35897,
-34139,
-32930,
-33606,
-35968,
-38225,
-38435,
-36350,
-33626,
-32157,
-32428,
-33280,
-33597,
-33472,
-33734,
-34642,
-35231,
-34722,
-33491,
-32820,
-33376,
-34353,
-34527,
-33579,
-32293,
-31494,
-31203,
-31083,
-31082,
-31389,
-31694,
-31256,
-29852,
-28514,
-28770,
-31044,
-34188,
-36326,
-36482,
-34894,
-32642,
-30844,
-30467,
-31852,
-34339,
-36368,
-36491,
-34567,
-31738,
-29374,
-28028,
-27639,
-28169,
-29701,
-31853,
-33435,
-33290,
-31287,
-28465,
-26198,
-25151,
-25280,
-26161,
-27324,
-28317,
-28780,
-28878,
-29323,
-30798,
-33061,
-34796,
-34430,
-31692,
-28051,
-25857,
-26284,
-28304,
-29686,
-29381,
-28713,
-29955,
-33351,
-36372,
-35930,
-31940,
-27679,
-26721,
-29400,
-32766,
-33749,
-31973,
-29404,
-27891,
-27684,
-28093,
-28811,
-29991,
-31458,
-32396,
-32130,
-30860,
-29535,
-28982,
-29495,
-30655,
-31679,
-31605,
-30084,
-27894,
-26702,
-27668,
-30319,
-32883,
-33992,
-33763,
-33496,
-34033,
-35086,
-35570,
-34784,
-33000,
-31358,
-31089,
-32626,
-34848,
-35813,
-34265,
-31502,
-30623,
-33797,
-39665,
-43897,
-43004,
-37494,
-31399,
-28525,
-29379,
-31666,
-33135,
-33526,
-33743,
-34183,
-34343,
-34015,
-33873,
-34473,
-35204,
-34799,
-33261,
-32320,
-33603,
-36364,
-37801,
-35946,
-31895,
-28863,
-28949,
-31483,
-34247,
-35880,
-36616,
-37081,
-37255,
-36982,
-36738,
-37250,
-38303,
-38524,
-36825,
-33787,
-31196,
-30409,
-31303,
-32986,
-34768,
-36295,
-37009,
-36340,
-34758,
-34021,
-35685,
-39239,
-41923,
-41173,
-37113,
-32637,
-30794,
-32096,
-34439,
-35593,
-35453,
-35610,
-36970,
-38220,
-37302,
-34217,
-31644,
-32194,
-35281,
-37311,
-35714,
-31903,
-29838,
-31508,
-34657,
-35600,
-33655,
-31864,
-33239,
-37056,
-39744,
-38900,
-35790,
-33421,
-33322,
-34442,
-35274,
-35535,
-35763,
-35883,
-35037,
-33032,
-31131,
-30865,
-32458,
-34502,
-35352,
-34519,
-32753,
-31211,
-30789,
-31813,
-34007,
-36369,
-37613,
-37020,
-35124,
-33470,
-33442,
-35322,
-38007,
-39959,
-40149,
-38763,
-36778,
-35216,
-34439,
-34261,
-34409,
-34635,
-34604,
-33734,
-32064,
-30716,
-31409,
-34585,
-38525,
-40528,
-39424,
-36716,
-34840,
-34803,
-35473,
-35506,
-34894,
-34774,
-35523,
-36135,
-35287,
-32959,
-30472,
-29336,
-30090,
-32263,
-34801,
-36533,
-36655,
-35445,
-34245,
-34473,
-36208,
-38182,
-39205,
-39408,
-39482,
-39251,
-37472,
-33697,
-29857,
-28887,
-31927,
-36760,
-39756,
-39049,
-35738,
-32315,
-30439,
-30337,
-31529,
-33474,
-35299,
-35880,
-34547,
-32091,
-30328,
-30728,
-33080,
-35670,
-36699,
-35740,
-33993,
-33284,
-34326,
-36072,
-36538,
-34947,
-32578,
-31671,
-32840,
-34245,
-33401,
-29988,
-26578,
-26170,
-29316,
-33615,
-36057,
-35661,
-33924,
-32989,
-33720,
-35190,
-35772,
-34680,
-32599,
-31213,
-31719,
-33908,
-36194,
-37063,
-36112,
-34153,
-32218,
-30863,
-30234,
-30459,
-31518,
-32977,
-34107,
-34582,
-34841,
-35444,
-36303,
-36707,
-36196,
-35339,
-35079,
-35819,
-36914,
-37418,
-37062,
-36386,
-36130,
-36394,
-36619,
-36295,
-35528,
-35098,
-35400,
-35749,
-34664,
-31538,
-27732,
-25879,
-27479,
-31308,
-34534,
-35419,
-34825,
-34790,
-36087,
-37386,
-37042,
-35000,
-33017,
-32723,
-34342,
-36575,
-38008,
-37929,
-36588,
-34748,
-33237,
-32447,
-32260,
-32352,
-32653,
-33315,
-34061,
-34129,
-33050,
-31644,
-31504,
-33334,
-35754,
-36672,
-35469,
-33877,
-34017,
-35918,
-37414,
-36492,
-33590,
-31176,
-31306,
-33639,
-35858,
-35922,
-33575,
-30462,
-28384,
-28086,
-28818,
-29616,
-30181,
-31078,
-32558,
-33781,
-33514,
-31724,
-30057,
-30417,
-32857,
-35573,
-36704,
-35983,
-34368,
-32407,
-29989,
-27579,
-26663,
-28482,
-31977,
-34415,
-33972,
-31453,
-29067,
-27840,
-27185,
-26598,
-26847,
-28760,
-31300,
-32255,
-30778,
-28606,
-28203,
-29874,
-31616,
-31574,
-29977,
-28526,
-28441,
-29700,
-31801,
-34192,
-35934,
-35860,
-33562,
-30446,
-28421,
-28080,
-28138,
-27371,
-26353,
-26863,
-29621,
-33226,
-35374,
-34984,
-32774,
-30576,
-30028,
-31863,
-35292,
-38111,
-37968,
-34366,
-29322,
-25767,
-25069,
-26337,
-27969,
-29237,
-30222,
-30808,
-30529,
-29569,
-29060,
-30021,
-32112,
-33888,
-34181,
-32875,
-30577,
-28026,
-26132,
-25940,
-27875,
-31011,
-33769,
-35366,
-36403,
-37495,
-38142,
-37324,
-35315,
-33883,
-34334,
-35853,
-36426,
-35317,
-33728,
-33034,
-32957,
-32483,
-31993,
-33305,
-37163,
-41262,
-42143,
-38904,
-34576,
-33017,
-35053,
-38056,
-39095,
-37869,
-36156,
-35300,
-35070,
-34923,
-35256,
-36948,
-39640,
-41671,
-41607,
-39767,
-37614,
-36240,
-35697,
-35647,
-36120,
-37017,
-37647,
-37180,
-35814,
-34680,
-34581,
-34880,
-34434,
-33336,
-33166,
-35173,
-38462,
-40490,
-39559,
-36331,
-33249,
-32129,
-32973,
-34198,
-34195,
-32373,
-29743,
-28289,
-29717,
-33934,
-38711,
-41237,
-40377,
-37566,
-35463,
-35576,
-37190,
-38304,
-37483,
-35082,
-32890,
-32786,
-35079,
-38043,
-39009,
-36653,
-32379,
-29381,
-29854,
-33082,
-36194,
-36678,
-34344,
-30941,
-28571,
-28479,
-30688,
-34141,
-37000,
-37464,
-35252,
-32033,
-30335,
-31451,
-34480,
-37487,
-39351,
-40094,
-40281,
-39805,
-38653,
-37367,
-36952,
-37584,
-38026,
-36860,
-34247,
-32137,
-32393,
-34719,
-36876,
-37007,
-35657,
-35135,
-36956,
-40045,
-41766,
-40462,
-36948,
-33602,
-32192,
-32937,
-34928,
-37009,
-38139,
-37508,
-35238,
-32937,
-32770,
-35344,
-38530,
-39020,
-35611,
-30695,
-28154,
-29589,
-32859,
-34300,
-32508,
-29382,
-28018,
-29547,
-32452,
-34575,
-35193,
-35321,
-35759,
-36066,
-35029,
-32433,
-29603,
-28208,
-28596,
-29676,
-30293,
-30440,
-30822,
-31557,
-31763,
-30661,
-28762,
-27492,
-27734,
-29039,
-30447,
-31572,
-32626,
-33411,
-33236,
-31903,
-30510,
-30437,
-31688,
-32582,
-31777,
-29790,
-28607,
-29396,
-31422,
-33207,
-34111,
-34416,
-34252,
-33144,
-31081,
-29139,
-28540,
-29079,
-29368,
-28558,
-27687,
-28418,
-30984,
-33750,
-34999,
-34667,
-34023,
-33873,
-33796,
-33063,
-31804,
-30986,
-31120,
-31707,
-31730,
-30741,
-29220,
-28129,
-28223,
-29657,
-31833,
-33644,
-33809,
-31711,
-27923,
-24290,
-22991,
-25059,
-29185,
-32436,
-32322,
-29244,
-26108,
-25651,
-27629,
-29287,
-28504,
-26222,
-25070,
-26281,
-28224,
-28790,
-27921,
-27520,
-28606,
-30056,
-29903,
-28191,
-26723,
-26947,
-28179,
-28676,
-27837,
-26834,
-26980,
-28317,
-29811,
-30731,
-31408,
-32470,
-33941,
-34953,
-34500,
-32421,
-29726,
-28091,
-28509,
-30425,
-32131,
-32342,
-31359,
-30444,
-30460,
-31154,
-32115,
-33438,
-35098,
-35963,
-34416,
-30359,
-26295,
-25193,
-27678,
-31442,
-33837,
-34416,
-34486,
-34718,
-34135,
-31792,
-28581,
-26580,
-26686,
-27610,
-27642,
-26609,
-25861,
-26138,
-26658,
-26321,
-25484,
-25847,
-28334,
-31778,
-33868,
-33327,
-30976,
-28646,
-27543,
-27761,
-28826,
-30352,
-31790,
-32308,
-31257,
-29107,
-27419,
-27662,
-29870,
-32491,
-33757,
-32920,
-30736,
-28692,
-28019,
-29091,
-31154,
-32846,
-33130,
-32254,
-31475,
-31790,
-32688,
-32931,
-32148,
-31649,
-32787,
-34902,
-35676,
-33672,
-30211,
-28245,
-29131,
-31555,
-33273,
-33493,
-32948,
-32111,
-30557,
-28286,
-26943,
-28458,
-32646,
-36916,
-38566,
-37411,
-35196,
-33507,
-32594,
-32224,
-32670,
-33817,
-34332,
-32517,
-28888,
-26419,
-27860,
-32455,
-36487,
-36959,
-34572,
-32195,
-31564,
-31746,
-31252,
-30188,
-29937,
-30750,
-31334,
-30462,
-29071,
-29069,
-30982,
-32803,
-32259,
-29399,
-26751,
-26737,
-29230,
-31964,
-32794,
-31614,
-30121,
-29940,
-31371,
-33152,
-33723,
-32512,
-30388,
-29006,
-29375,
-31145,
-33123,
-34459,
-35196,
-35615,
-35731,
-35278,
-34668,
-34651,
-35515,
-36209,
-35488,
-33280,
-31214,
-30785,
-31890,
-33019,
-33254,
-33304,
-34521,
-36954,
-39116,
-39413,
-37841,
-35788,
-34559,
-34435,
-34838,
-35456,
-36332,
-37558,
-38684,
-39101,
-38597,
-37735,
-37313,
-37598,
-37954,
-37438,
-35846,
-34007,
-33008,
-32898,
-32649,
-31390,
-29877,
-29804,
-32064,
-35204,
-36671,
-35146,
-31821,
-29201,
-28973,
-30973,
-33994,
-36740,
-38334,
-38150,
-36191,
-33344,
-31217,
-31083,
-33008,
-35831,
-37822,
-37679,
-35363,
-32384,
-30963,
-32305,
-35307,
-37487,
-37363,
-35892,
-35067,
-35333,
-35141,
-33275,
-31032,
-31109,
-34272,
-38050,
-39223,
-37312,
-34813,
-34021,
-34740,
-35213,
-35122,
-35859,
-38296,
-40735,
-40474,
-37059,
-33178,
-32044,
-34017,
-36645,
-37356,
-36146,
-34844,
-35039,
-36554,
-38359,
-39802,
-40897,
-41515,
-41146,
-39502,
-37442,
-36401,
-37210,
-39102,
-40340,
-39832,
-38111,
-36819,
-37133,
-38651,
-39866,
-39595,
-38036,
-36502,
-36142,
-37055,
-38296,
-38801,
-38174,
-36921,
-36157,
-36712,
-38407,
-39797,
-39083,
-35823,
-31630,
-29272,
-30239,
-33480,
-36443,
-37455,
-36897,
-36018,
-35099,
-33270,
-30253,
-27614,
-27654,
-30964,
-35472,
-38228,
-38107,
-36545,
-35556,
-35835,
-36337,
-36110,
-35244,
-34452,
-33867,
-32881,
-31350,
-30272,
-30978,
-33632,
-36603,
-37963,
-37104,
-35187,
-33809,
-33609,
-34048,
-34356,
-34207,
-33576,
-32405,
-30861,
-29737,
-30225,
-32562,
-35451,
-36919,
-36175,
-34336,
-33077,
-32886,
-32935,
-32584,
-32391,
-33236,
-34596,
-34729,
-32573,
-29503,
-28219,
-30027,
-33573,
-36350,
-37316,
-37402,
-37731,
-37952,
-36916,
-34497,
-32387,
-32349,
-34385,
-36733,
-37697,
-37221,
-36266,
-35472,
-34449,
-32941,
-31692,
-32039,
-34195,
-36522,
-36699,
-33967,
-30023,
-27758,
-28810,
-32240,
-35547,
-36649,
-35418,
-33270,
-31747,
-31563,
-32448,
-33892,
-35351,
-36292,
-36247,
-35277,
-34223,
-34179,
-35370,
-36850,
-37324,
-36563,
-35540,
-35204,
-35207,
-34383,
-32422,
-30854,
-31650,
-34954,
-38349,
-38905,
-36023,
-32028,
-30074,
-31323,
-34257,
-36426,
-36488,
-34872,
-32824,
-31345,
-30962,
-31838,
-33622,
-35432,
-36080,
-35182,
-33493,
-32215,
-31797,
-31655,
-31139,
-30668,
-31132,
-32683,
-34030,
-33918,
-32772,
-32486,
-34241,
-36766,
-37643,
-35970,
-33554,
-32816,
-34000,
-35121,
-34515,
-32800,
-31804,
-32006,
-32040,
-30772,
-29017,
-28523,
-29456,
-30171,
-29433,
-28396,
-29134,
-31632,
-33119,
-31023,
-26257,
-22701,
-23405,
-27670,
-31901,
-33186,
-31270,
-28127,
-25825,
-25537,
-27283,
-30188,
-32401,
-32311,
-29748,
-26744,
-25845,
-27796,
-30774,
-32034,
-30401,
-27182,
-24667,
-24286,
-25829,
-28169,
-30294,
-31665,
-32016,
-31358,
-30049,
-28869,
-28525,
-29067,
-29738,
-29557,
-28288,
-26710,
-26284,
-27743,
-30595,
-33257,
-34309,
-33469,
-31533,
-29679,
-28513,
-28151,
-28378,
-29144,
-30369,
-31826,
-33050,
-33443,
-32575,
-30496,
-27956,
-26277,
-26434,
-28276,
-30322,
-30985,
-30017,
-28747,
-28894,
-30689,
-32608,
-32725,
-30593,
-27688,
-26122,
-26766,
-28657,
-29932,
-29469,
-27727,
-26170,
-26134,
-27772,
-30277,
-32517,
-33882,
-34439,
-34577,
-34692,
-34864,
-34953,
-34627,
-33567,
-31829,
-29956,
-28898,
-29297,
-31015,
-33099,
-34411,
-34342,
-33210,
-31901,
-31379,
-31858,
-32744,
-33001,
-32271,
-31219,
-31105,
-32102,
-33082,
-32456,
-30422,
-28920,
-29866,
-32705,
-34826,
-34333,
-32260,
-31518,
-33572,
-36910,
-38806,
-38347,
-36850,
-35633,
-34352,
-32152,
-29884,
-29888,
-33107,
-37336,
-39147,
-37557,
-34962,
-34127,
-35182,
-36083,
-35880,
-35869,
-37542,
-39724,
-39484,
-35675,
-30766,
-28654,
-30588,
-34367,
-36916,
-37326,
-36872,
-36711,
-36802,
-36629,
-36558,
-37279,
-38518,
-38779,
-37131,
-34406,
-32656,
-32816,
-33920,
-34349,
-33929,
-34032,
-35695,
-37937,
-38542,
-36531,
-33485,
-32170,
-33795,
-36922,
-39057,
-38949,
-37283,
-35364,
-33848,
-32947,
-33143,
-35196,
-38765,
-42147,
-43117,
-41089,
-37382,
-34239,
-33151,
-34166,
-36289,
-37936,
-37770,
-35479,
-32381,
-30694,
-31732,
-34808,
-38022,
-40047,
-40886,
-40966,
-39979,
-37531,
-34230,
-31900,
-31900,
-33759,
-35699,
-36463,
-36089,
-35248,
-34158,
-32838,
-31948,
-32502,
-34702,
-37207,
-38095,
-36741,
-34171,
-32184,
-31881,
-33274,
-35584,
-37608,
-38177,
-36910,
-34815,
-33747,
-34655,
-36593,
-37530,
-36393,
-34006,
-31893,
-30685,
-29999,
-29535,
-29837,
-31330,
-33380,
-34609,
-34498,
-33908,
-34058,
-34885,
-35220,
-34351,
-33021,
-32672,
-33469,
-34081,
-32957,
-30403,
-28517,
-29308,
-32696,
-36219,
-37107,
-34601,
-30646,
-28310,
-29191,
-32330,
-35290,
-36354,
-35676,
-34428,
-33448,
-32636,
-31848,
-31323,
-31516,
-32177,
-32570,
-32294,
-31816,
-31892,
-32505,
-32882,
-32397,
-31334,
-30671,
-30992,
-32082,
-33175,
-33526,
-32988,
-31859,
-31044,
-31332,
-32847,
-34638,
-35314,
-34213,
-32002,
-30153,
-29924,
-31572,
-34415,
-36962,
-37389,
-34696,
-29803,
-25731,
-25471,
-29251,
-33870,
-35364,
-32599,
-28399,
-26834,
-29345,
-33777,
-36562,
-36134,
-33839,
-32040,
-31867,
-32418,
-32277,
-31026,
-29646,
-29519,
-31201,
-34056,
-36667,
-37780,
-36856,
-34479,
-32018,
-30961,
-31958,
-34165,
-35872,
-35670,
-33741,
-31589,
-30757,
-31445,
-32666,
-33333,
-33428,
-33613,
-34321,
-35129,
-35488,
-35524,
-35977,
-37114,
-38087,
-37642,
-35595,
-33266,
-32417,
-33390,
-34887,
-35117,
-33640,
-31669,
-30929,
-32140,
-34489,
-36323,
-36507,
-35224,
-33949,
-34187,
-36010,
-37627,
-36855,
-33493,
-30031,
-29654,
-32942,
-37044,
-38277,
-35702,
-31957,
-30380,
-31935,
-35012,
-37502,
-38677,
-38618,
-37303,
-34805,
-32385,
-31718,
-33023,
-34168,
-32961,
-30252,
-29407,
-32586,
-37607,
-40026,
-37987,
-34382,
-33386,
-35662,
-37772,
-36463,
-32465,
-29434,
-29650,
-31835,
-33181,
-32777,
-32138,
-32840,
-34527,
-35417,
-34392,
-31955,
-29496,
-28210,
-28479,
-29949,
-31593,
-32292,
-31760,
-30994,
-31181,
-32395,
-33225,
-32698,
-31405,
-31074,
-32312,
-33860,
-34029,
-32670,
-31216,
-30987,
-31813,
-32672,
-32913,
-32554,
-31601,
-29934,
-27831,
-26534,
-26931,
-28520,
-29573,
-28935,
-27480,
-26980,
-28355,
-30599,
-31994,
-31695,
-30273,
-28876,
-28494,
-29443,
-31433,
-33417,
-34132,
-33023,
-30947,
-29540,
-29737,
-30994,
-32105,
-32599,
-33086,
-34123,
-35294,
-35455,
-34148,
-32199,
-31017,
-31431,
-33107,
-35126,
-36546,
-36677,
-35257,
-32678,
-30167,
-29026,
-29684,
-31287,
-32558,
-32902,
-32598,
-32082,
-31443,
-30819,
-30818,
-32072,
-34173,
-35673,
-35467,
-34127,
-33178,
-33374,
-33766,
-33225,
-32086,
-31918,
-33354,
-35116,
-35443,
-34321,
-33548,
-34365,
-35938,
-36366,
-35080,
-33400,
-32828,
-33298,
-33700,
-33386,
-32739,
-32241,
-31867,
-31688,
-32421,
-34460,
-36629,
-36689,
-33878,
-30174,
-28537,
-29657,
-31219,
-30726,
-28367,
-26585,
-27036,
-28747,
-29737,
-29529,
-29502,
-30643,
-32261,
-32986,
-32809,
-32989,
-34118,
-35135,
-34522,
-32402,
-30234,
-29063,
-28399,
-27522,
-27006,
-28239,
-31252,
-34107,
-34816,
-33511,
-32143,
-31876,
-31951,
-31074,
-29600,
-29130,
-30192,
-31194,
-30258,
-27755,
-26071,
-27112,
-30336,
-33757,
-36084,
-37245,
-37372,
-36098,
-33636,
-31577,
-31701,
-33858,
-35587,
-34626,
-31365,
-28605,
-28690,
-31317,
-34145,
-35197,
-34348,
-32896,
-32064,
-32233,
-32983,
-33735,
-34042,
-33930,
-33685,
-33607,
-33684,
-33691,
-33696,
-34106,
-35289,
-36967,
-38319,
-38670,
-37937,
-36569,
-34930,
-33341,
-32135,
-31865,
-32669,
-34026,
-34713,
-33934,
-31816,
-29536,
-28421,
-29087,
-31057,
-33205,
-34381,
-34049,
-32475,
-30512,
-29223,
-29325,
-30686,
-32384,
-33315,
-33025,
-32084,
-31314,
-30982,
-30530,
-29535,
-28364,
-28018,
-28985,
-30669,
-31971,
-32187,
-31510,
-30534,
-29885,
-30162,
-31637,
-33828,
-35362,
-34905,
-32574,
-30105,
-29297,
-30478,
-32446,
-33982,
-34814,
-35212,
-35001,
-33872,
-32194,
-31114,
-31242,
-31615,
-30880,
-29012,
-27910,
-29218,
-32417,
-35269,
-36295,
-36155,
-36438,
-37209,
-37012,
-34760,
-31569,
-29778,
-30379,
-32108,
-33010,
-32716,
-32526,
-33446,
-34705,
-34788,
-33376,
-31956,
-31977,
-33006,
-33253,
-31888,
-30189,
-30135,
-31795,
-33241,
-32867,
-31443,
-31101,
-32296,
-32980,
-31055,
-27464,
-25607,
-27555,
-31542,
-33837,
-32988,
-31133,
-31197,
-33263,
-34818,
-33907,
-31499,
-30049,
-30677,
-32171,
-32690,
-31547,
-29461,
-27602,
-27184,
-29087,
-33132,
-37356,
-38947,
-36715,
-32554,
-29942,
-30652,
-33314,
-35168,
-34832,
-33302,
-32214,
-32244,
-32769,
-33112,
-33189,
-33508,
-34440,
-35873,
-37048,
-37050,
-35536,
-33425,
-32136,
-32460,
-33485,
-33736,
-32755,
-31612,
-31612,
-32832,
-34111,
-34498,
-33955,
-33026,
-32062,
-31130,
-30488,
-30331,
-30455,
-30286,
-29748,
-29515,
-30326,
-31796,
-32869,
-32967,
-32796,
-33369,
-34702,
-35650,
-35200,
-33470,
-31550,
-30562,
-30979,
-32639,
-34673,
-35834,
-35219,
-33186,
-31513,
-31822,
-34139,
-36651,
-37536,
-36452,
-34691,
-33560,
-33294,
-33217,
-32787,
-32213,
-32158,
-32823,
-33713,
-33967,
-33263,
-32267,
-32206,
-33663,
-35825,
-36940,
-35850,
-33235,
-30981,
-30667,
-32062,
-33655,
-34111,
-33485,
-32864,
-33131,
-34057,
-34654,
-34284,
-33365,
-32956,
-33594,
-34709,
-35122,
-34350,
-32995,
-32074,
-31864,
-31823,
-31575,
-31484,
-32189,
-33437,
-34072,
-33335,
-31820,
-30988,
-31532,
-32700,
-33130,
-32368,
-31058,
-30119,
-29830,
-29944,
-30168,
-30606,
-31355,
-32480,
-33723,
-34591,
-34443,
-33162,
-31622,
-31367,
-33079,
-35631,
-36943,
-36080,
-34267,
-33397,
-34051,
-35131,
-35792,
-36490,
-38072,
-39723,
-39436,
-36261,
-32290,
-30765,
-33017,
-37040,
-39678,
-39667,
-38098,
-36600,
-35671,
-35012,
-34677,
-35109,
-36157,
-36787,
-36151,
-34745,
-33911,
-34524,
-35988,
-37116,
-37106,
-36141,
-34888,
-33863,
-33316,
-32985,
-32404,
-31348,
-30339,
-30477,
-32283,
-34759,
-36042,
-35020,
-32549,
-30554,
-30412,
-31887,
-33915,
-35539,
-36378,
-36319,
-35481,
-34334,
-33524,
-33218,
-32965,
-32296,
-31576,
-31631,
-32796,
-34397,
-35575,
-36225,
-36806,
-37365,
-37299,
-36248,
-34979,
-34546,
-35012,
-35144,
-34046,
-32390,
-31823,
-33057,
-35041,
-36371,
-36800,
-37250,
-38209,
-38874,
-38174,
-36276,
-34744,
-34968,
-36737,
-38315,
-38071,
-35774,
-32933,
-31555,
-32704,
-35552,
-37970,
-38220,
-36484,
-34527,
-34108,
-35322,
-36993,
-37871,
-37585,
-36248,
-34138,
-31962,
-31058,
-32310,
-34742,
-35659,
-33278,
-28791,
-25695,
-26448,
-30349,
-34623,
-37031,
-37271,
-35908,
-33532,
-30952,
-29626,
-30602,
-32983,
-34302,
-33009,
-30249,
-28701,
-29517,
-31473,
-32616,
-32657,
-32634,
-33194,
-33681,
-33481,
-33068,
-33344,
-34138,
-34269,
-33288,
-32272,
-32524,
-33653,
-33891,
-32396,
-30507,
-30295,
-32063,
-33925,
-34017,
-32542,
-31425,
-32039,
-34000,
-35744,
-36349,
-35875,
-35003,
-34177,
-33710,
-33847,
-34700,
-35820,
-36405,
-35909,
-34449,
-32819,
-31860,
-32068,
-33422,
-35407,
-37187,
-38033,
-37577,
-36141,
-34407,
-33095,
-32610,
-32810,
-33307,
-33717,
-34128,
-34840,
-35818,
-36335,
-35535,
-33667,
-32261,
-32969,
-35671,
-38277,
-38572,
-36316,
-33365,
-31748,
-31866,
-32653,
-33102,
-33120,
-32970,
-32619,
-31918,
-31366,
-31889,
-33561,
-35175,
-35170,
-33427,
-31428,
-30727,
-31499,
-32644,
-33311,
-33650,
-34170,
-34586,
-33989,
-31958,
-29386,
-27739,
-27694,
-28504,
-29040,
-28992,
-29266,
-30812,
-33444,
-35760,
-36294,
-34900,
-32720,
-31233,
-30961,
-31450,
-31790,
-31521,
-30615,
-29541,
-28950,
-29592,
-31536,
-33936,
-35298,
-34851,
-33270,
-31836,
-31129,
-30401,
-28918,
-27269,
-26991,
-28784,
-31445,
-32898,
-32376,
-30910,
-30132,
-30407,
-30988,
-31143,
-31088,
-31386,
-31995,
-32380,
-32357,
-32576,
-33694,
-35279,
-36034,
-34952,
-32610,
-30721,
-30622,
-32086,
-33608,
-33952,
-33255,
-32674,
-33021,
-33915,
-34381,
-34164,
-33983,
-34464,
-35053,
-34502,
-32575,
-30761,
-30782,
-32579,
-34190,
-33996,
-32563,
-31896,
-32868,
-34299,
-34571,
-33838,
-33527,
-34189,
-34466,
-33117,
-31185,
-31155,
-33683,
-36192,
-35469,
-31738,
-28771,
-29944,
-34447,
-38253,
-38511,
-36188,
-34291,
-34318,
-35176,
-35436,
-35076,
-35085,
-35379,
-34826,
-32920,
-30946,
-30732,
-32307,
-33944,
-33862,
-32359,
-31008,
-30870,
-31400,
-31594,
-31243,
-31064,
-31497,
-32131,
-32387,
-32340,
-32564,
-33114,
-33313,
-32581,
-31462,
-31219,
-32421,
-34125,
-34746,
-33635,
-31678,
-30336,
-30259,
-31111,
-32120,
-32831,
-32862,
-31784,
-29680,
-27516,
-26922,
-28481,
-30971,
-32141,
-30884,
-28335,
-26755,
-27412,
-29391,
-30697,
-30075,
-28105,
-26541,
-26823,
-28990,
-31646,
-33086,
-32567,
-30928,
-29806,
-30187,
-31550,
-32472,
-32097,
-30804,
-29635,
-29142,
-29137,
-29271,
-29599,
-30140,
-30516,
-30037,
-28815,
-27985,
-28844,
-31293,
-33700,
-34158,
-32340,
-29623,
-27836,
-27579,
-28037,
-28199,
-27948,
-28160,
-29498,
-31531,
-32920,
-32599,
-30621,
-28269,
-26896,
-27213,
-28793,
-30616,
-31641,
-31464,
-30439,
-29559,
-29606,
-30627,
-31767,
-32058,
-31414,
-30722,
-30963,
-32065,
-32939,
-32598,
-31421,
-30779,
-31663,
-33481,
-34656,
-34280,
-33007,
-32187,
-32344,
-32690,
-32280,
-31313,
-30807,
-31405,
-32480,
-33073,
-33068,
-33312,
-34326,
-35439,
-35378,
-33888,
-32058,
-31321,
-31984,
-33213,
-34068,
-34310,
-34203,
-33817,
-33144,
-32538,
-32748,
-34202,
-36172,
-37243,
-36443,
-34253,
-32297,
-32033,
-33738,
-36071,
-37354,
-36553,
-34336,
-32310,
-31754,
-32543,
-33562,
-33969,
-33951,
-34141,
-34607,
-34685,
-34008,
-33183,
-33155,
-34071,
-34894,
-34587,
-33212,
-31927,
-31789,
-32931,
-34666,
-36198,
-36986,
-36839,
-35976,
-35089,
-34972,
-35723,
-36538,
-36362,
-35057,
-33612,
-33292,
-34511,
-36458,
-37886,
-37836,
-36318,
-34145,
-32562,
-32561,
-34022,
-35811,
-36381,
-35140,
-32840,
-30998,
-30659,
-31709,
-33064,
-33660,
-33101,
-31923,
-31059,
-31070,
-31802,
-32587,
-33051,
-33317,
-33623,
-33781,
-33263,
-32097,
-31123,
-31299,
-32560,
-33751,
-33733,
-32523,
-31142,
-30570,
-31010,
-32039,
-33201,
-34003,
-34032,
-33104,
-31836,
-31231,
-31778,
-32781,
-33106,
-32506,
-31792,
-31823,
-32285,
-32198,
-31343,
-30792,
-31825,
-34196,
-36056,
-35694,
-33174,
-30485,
-29762,
-31494,
-34274,
-35939,
-35319,
-32915,
-30383,
-29103,
-29356,
-30302,
-31054,
-31264,
-31159,
-31045,
-31102,
-31553,
-32589,
-33972,
-34809,
-34331,
-32847,
-31783,
-32323,
-34012,
-35079,
-34226,
-31926,
-29799,
-28951,
-29047,
-29358,
-29747,
-30706,
-32229,
-33411,
-33415,
-32560,
-32104,
-32855,
-34255,
-35001,
-34419,
-33032,
-31802,
-31175,
-30903,
-30739,
-30838,
-31639,
-33189,
-35026,
-36365,
-36685,
-35990,
-34895,
-34208,
-34509,
-35635,
-36814,
-37194,
-36516,
-35227,
-34076,
-33412,
-33127,
-32865,
-32536,
-32381,
-32713,
-33652,
-34967,
-36239,
-36971,
-36802,
-35676,
-34124,
-33005,
-33077,
-34154,
-35251,
-35330,
-34359,
-33357,
-33402,
-34506,
-35680,
-35999,
-35504,
-34914,
-34736,
-34824,
-34935,
-35169,
-35745,
-36298,
-36061,
-34794,
-33334,
-32979,
-34069,
-35680,
-36545,
-36331,
-35705,
-35567,
-36129,
-37115,
-37969,
-38210,
-37486,
-35864,
-34116,
-33188,
-33368,
-34022,
-34297,
-34167,
-34158,
-34644,
-35098,
-35163,
-35037,
-35442,
-36289,
-36643,
-35935,
-34893,
-34863,
-35990,
-36842,
-36196,
-34519,
-33619,
-34236,
-35285,
-35192,
-33969,
-33020,
-33160,
-33630,
-33201,
-32126,
-31797,
-32816,
-34023,
-33809,
-32324,
-31294,
-31885,
-33249,
-33424,
-31780,
-29559,
-28538,
-29303,
-31154,
-33208,
-34895,
-35742,
-35218,
-33489,
-31668,
-30928,
-31188,
-31108,
-29807,
-28108,
-27715,
-29254,
-31409,
-32409,
-31862,
-30920,
-30744,
-31310,
-31901,
-32215,
-32549,
-32973,
-32899,
-32017,
-31037,
-31170,
-32525,
-33525,
-32583,
-29956,
-27838,
-28097,
-30239,
-31990,
-31699,
-30068,
-29185,
-30294,
-32560,
-34120,
-33808,
-31994,
-29846,
-28425,
-28134,
-28865,
-30117,
-31276,
-31950,
-32293,
-32640,
-33120,
-33457,
-33559,
-33835,
-34693,
-35697,
-35719,
-34164,
-31990,
-30924,
-31689,
-33115,
-33441,
-32148,
-30481,
-29949,
-30780,
-32014,
-32609,
-32417,
-31836,
-31269,
-31032,
-31427,
-32620,
-34025,
-34673,
-34124,
-33147,
-33053,
-34194,
-35585,
-35849,
-34837,
-33655,
-33590,
-34784,
-36162,
-36524,
-35419,
-33534,
-32136,
-32281,
-33982,
-36039,
-36749,
-35283,
-32464,
-30121,
-29566,
-30631,
-32124,
-33112,
-33471,
-33635,
-33923,
-34500,
-35477,
-36620,
-37144,
-36062,
-33372,
-30555,
-29515,
-30713,
-32641,
-33290,
-32204,
-30742,
-30505,
-31683,
-33241,
-34163,
-34235,
-33592,
-32145,
-30175,
-28729,
-29159,
-31387,
-33579,
-33781,
-32152,
-30933,
-31854,
-34239,
-35655,
-34868,
-32976,
-32002,
-32379,
-32913,
-32535,
-31749,
-31671,
-32352,
-32710,
-32007,
-30914,
-30516,
-30938,
-31259,
-30912,
-30394,
-30543,
-31305,
-32021,
-32415,
-32995,
-34013,
-34752,
-34205,
-32535,
-31228,
-31596,
-33372,
-35108,
-35619,
-35042,
-34139,
-33456,
-33103,
-33165,
-33904,
-35291,
-36832,
-37919,
-38233,
-37628,
-35989,
-33374,
-30727,
-29547,
-30712,
-33345,
-35331,
-35132,
-33262,
-31661,
-31953,
-34073,
-36619,
-38210,
-38320,
-37277,
-35694,
-34115,
-33063,
-32792,
-33235,
-33860,
-34074,
-33710,
-33073,
-32701,
-32896,
-33569,
-34433,
-35165,
-35532,
-35325,
-34476,
-33139,
-31686,
-30543,
-29925,
-29863,
-30266,
-31084,
-32069,
-32849,
-32986,
-32298,
-31123,
-29956,
-29371,
-29525,
-30310,
-31269,
-31815,
-31501,
-30372,
-28929,
-27947,
-27902,
-28933,
-30727,
-32753,
-34214,
-34537,
-33789,
-32881,
-32812,
-33616,
-34254,
-33671,
-32057,
-30835,
-31086,
-32523,
-33745,
-33835,
-33083,
-32437,
-32292,
-32427,
-32517,
-32697,
-33020,
-33149,
-32600,
-31585,
-31037,
-31580,
-32867,
-33775,
-33669,
-32851,
-32132,
-31867,
-31995,
-32313,
-32894,
-33596,
-34030,
-33657,
-32697,
-31832,
-31813,
-32594,
-33574,
-34179,
-34317,
-34286,
-34216,
-34050,
-33579,
-32820,
-31979,
-31278,
-30831,
-30580,
-30501,
-30576,
-30854,
-31179,
-31324,
-31063,
-30379,
-29502,
-28642,
-27966,
-27547,
-27482,
-27786,
-28440,
-29295,
-30371,
-31585,
-32677,
-33028,
-32320,
-30854,
-29669,
-29569,
-30563,
-32010,
-33280,
-34241,
-34801,
-34789,
-34051,
-33115,
-32785,
-33516,
-34709,
-35424,
-35224,
-34446,
-33575,
-32687,
-31792,
-31337,
-31987,
-33658,
-35228,
-35351,
-33840,
-31783,
-30544,
-30485,
-31036,
-31495,
-31819,
-32341,
-33219,
-34120,
-34519,
-34202,
-33384,
-32530,
-32007,
-31780,
-31619,
-31280,
-31055,
-31413,
-32654,
-34350,
-35651,
-35886,
-35116,
-33890,
-32793,
-32080,
-31718,
-31584,
-31593,
-31755,
-32330,
-33469,
-34978,
-35932,
-35349,
-33222,
-30849,
-29928,
-31111,
-33285,
-34803,
-34843,
-33996,
-33321,
-33241,
-33382,
-33295,
-33028,
-32953,
-33306,
-34016,
-34973,
-36098,
-37156,
-37718,
-37374,
-36326,
-35199,
-34679,
-34838,
-35275,
-35466,
-35138,
-34398,
-33478,
-32867,
-32906,
-33718,
-34795,
-35391,
-35007,
-33935,
-32909,
-32643,
-33091,
-33784,
-34052,
-33596,
-32575,
-31498,
-31034,
-31646,
-33286,
-35287,
-36714,
-36948,
-36126,
-35076,
-34606,
-34936,
-35451,
-35314,
-34359,
-33202,
-32904,
-33695,
-34904,
-35467,
-35094,
-34414,
-34244,
-34628,
-35003,
-34993,
-34965,
-35574,
-36895,
-38257,
-38899,
-38584,
-37527,
-36023,
-34284,
-32723,
-31957,
-32299,
-33360,
-34416,
-35001,
-35326,
-35607,
-35767,
-35450,
-34759,
-34239,
-34369,
-34955,
-35395,
-35299,
-34751,
-33948,
-32869,
-31560,
-30548,
-30618,
-32007,
-33965,
-35294,
-35404,
-34679,
-33906,
-33480,
-33328,
-33285,
-33405,
-33727,
-34046,
-34113,
-33980,
-33974,
-34225,
-34389,
-34097,
-33544,
-33438,
-34277,
-35685,
-36718,
-36884,
-36572,
-36526,
-36954,
-37218,
-36721,
-35517,
-34350,
-33751,
-33643,
-33638,
-33730,
-34288,
-35442,
-36563,
-36721,
-35542,
-33805,
-32733,
-33010,
-34166,
-35063,
-34902,
-33736,
-32429,
-31791,
-32162,
-33155,
-34093,
-34444,
-34145,
-33651,
-33482,
-33912,
-34685,
-35215,
-35144,
-34496,
-33795,
-33368,
-33246,
-32972,
-32343,
-31528,
-31174,
-31713,
-33041,
-34534,
-35605,
-36075,
-36206,
-36219,
-36169,
-35966,
-35797,
-35931,
-36433,
-36736,
-36118,
-34438,
-32593,
-31882,
-32883,
-34912,
-36655,
-37393,
-37355,
-37195,
-37044,
-36546,
-35545,
-34501,
-34053,
-34274,
-34576,
-34472,
-34067,
-33844,
-33916,
-33864,
-33333,
-32579,
-32360,
-33003,
-34108,
-34773,
-34523,
-33729,
-33119,
-33198,
-33635,
-33679,
-32759,
-31092,
-29623,
-29222,
-30123,
-31693,
-33197,
-34175,
-34668,
-34750,
-34511,
-34222,
-34332,
-35021,
-35831,
-36043,
-35485,
-34856,
-34858,
-35354,
-35413,
-34463,
-32992,
-32035,
-32045,
-32747,
-33625,
-34747,
-36019,
-36940,
-36602,
-35058,
-33371,
-32755,
-33155,
-33482,
-32949,
-32058,
-31884,
-32753,
-33881,
-34443,
-34361,
-34188,
-34177,
-34176,
-34152,
-34488,
-35296,
-35881,
-35193,
-33023,
-30519,
-29096,
-29270,
-30296,
-31281,
-31863,
-32199,
-32299,
-31912,
-31118,
-30339,
-30132,
-30423,
-30769,
-30808,
-30647,
-30553,
-30611,
-30648,
-30614,
-30581,
-30714,
-31034,
-31439,
-31810,
-31766,
-31004,
-29466,
-27854,
-27203,
-28085,
-30069,
-32060,
-33250,
-33525,
-33184,
-32367,
-31178,
-29960,
-29369,
-29769,
-30762,
-31669,
-32074,
-32270,
-32541,
-32690,
-32197,
-31022,
-29894,
-29758,
-30788,
-32156,
-32828,
-32325,
-31143,
-30093,
-29827,
-30416,
-31543,
-32597,
-33086,
-32848,
-32241,
-31838,
-31834,
-31898,
-31535,
-30688,
-29902,
-29624,
-29784,
-29917,
-29897,
-30178,
-31090,
-32153,
-32280,
-30926,
-28832,
-27330,
-27014,
-27221,
-26997,
-26352,
-26195,
-27183,
-28833,
-30039,
-30340,
-30203,
-30255,
-30377,
-29985,
-29039,
-28286,
-28444,
-29218,
-29503,
-28602,
-27097,
-26222,
-26741,
-28230,
-29683,
-30469,
-30539,
-30116,
-29226,
-27908,
-26602,
-26059,
-26798,
-28486,
-30161,
-30891,
-30580,
-29830,
-29448,
-29681,
-30195,
-30444,
-30184,
-29656,
-29302,
-29433,
-29977,
-30595,
-30926,
-30916,
-30802,
-30954,
-31449,
-32033,
-32231,
-31826,
-30917,
-29923,
-29172,
-28838,
-28895,
-29192,
-29615,
-30074,
-30656,
-31432,
-32377,
-33180,
-33514,
-33270,
-32725,
-32282,
-32186,
-32397,
-32751,
-33116,
-33319,
-33183,
-32500,
-31448,
-30443,
-30087,
-30614,
-31816,
-33096,
-33863,
-33778,
-32923,
-31723,
-30733,
-30422,
-30944,
-32022,
-33029,
-33279,
-32460,
-30890,
-29358,
-28558,
-28641,
-29253,
-29967,
-30584,
-31011,
-31119,
-30780,
-30156,
-29698,
-29631,
-29778,
-29763,
-29529,
-29444,
-29760,
-30214,
-30389,
-30138,
-29921,
-30085,
-30554,
-30849,
-30660,
-30128,
-29612,
-29411,
-29735,
-30600,
-31743,
-32535,
-32441,
-31566,
-30717,
-30558,
-30998,
-31245,
-30725,
-29684,
-28797,
-28651,
-29178,
-30100,
-31015,
-31718,
-32115,
-32305,
-32479,
-32511,
-32027,
-30698,
-28956,
-27756,
-27768,
-28688,
-29535,
-29757,
-29595,
-29732,
-30375,
-31312,
-32218,
-33022,
-33558,
-33460,
-32483,
-31029,
-29919,
-29775,
-30554,
-31805,
-33221,
-34580,
-35475,
-35434,
-34328,
-32839,
-31838,
-31854,
-32632,
-33736,
-34789,
-35537,
-35657,
-34957,
-33766,
-32804,
-32590,
-33041,
-33606,
-33985,
-34104,
-34075,
-33740,
-33127,
-32512,
-32324,
-32702,
-33403,
-34184,
-35077,
-36094,
-36860,
-36832,
-35868,
-34652,
-34111,
-34627,
-35663,
-36382,
-36331,
-35739,
-35174,
-35100,
-35584,
-36319,
-36772,
-36495,
-35519,
-34351,
-33674,
-33823,
-34564,
-35382,
-35810,
-35703,
-35207,
-34656,
-34433,
-34728,
-35356,
-35890,
-35974,
-35677,
-35398,
-35390,
-35615,
-35726,
-35525,
-35133,
-34813,
-34872,
-35343,
-36126,
-36977,
-37650,
-37973,
-37827,
-37119,
-35847,
-34276,
-32990,
-32581,
-33169,
-34246,
-35104,
-35400,
-35277,
-34947,
-34366,
-33437,
-32478,
-32049,
-32446,
-33132,
-33357,
-32848,
-32152,
-31929,
-32231,
-32614,
-32785,
-32875,
-33155,
-33442,
-33399,
-33044,
-32783,
-32984,
-33376,
-33450,
-33161,
-32972,
-33401,
-34207,
-34753,
-34548,
-33767,
-32826,
-32027,
-31396,
-31003,
-31004,
-31384,
-31954,
-32417,
-32717,
-32847,
-32737,
-32332,
-31799,
-31625,
-32044,
-32831,
-33342,
-33273,
-32697,
-32018,
-31415,
-31144,
-31473,
-32636,
-34235,
-35332,
-35196,
-34023,
-32734,
-32055,
-31879,
-31783,
-31571,
-31622,
-32079,
-32667,
-32890,
-32715,
-32461,
-32497,
-32629,
-32599,
-32226,
-31686,
-31103,
-30594,
-30242,
-30255,
-30751,
-31580,
-32546,
-33417,
-34077,
-34179,
-33539,
-32380,
-31572,
-31748,
-32777,
-33687,
-33748,
-33126,
-32574,
-32465,
-32557,
-32386,
-32050,
-31974,
-32289,
-32766,
-32967,
-32997,
-32968,
-32914,
-32612,
-32072,
-31745,
-32011,
-32788,
-33554,
-33837,
-33619,
-33056,
-32440,
-32068,
-32409,
-33658,
-35349,
-36496,
-36367,
-35272,
-34166,
-33857,
-34273,
-34748,
-34839,
-34488,
-34013,
-33632,
-33539,
-33922,
-34725,
-35606,
-35986,
-35633,
-34885,
-34252,
-34031,
-34026,
-34053,
-34116,
-34426,
-34982,
-35636,
-36234,
-36770,
-37160,
-37103,
-36334,
-35109,
-34181,
-34165,
-34913,
-35650,
-35773,
-35474,
-35301,
-35499,
-35588,
-35170,
-34416,
-34166,
-34891,
-36304,
-37532,
-38013,
-37796,
-37174,
-36284,
-35160,
-34141,
-33817,
-34501,
-35743,
-36667,
-36751,
-36218,
-35667,
-35407,
-35264,
-34975,
-34646,
-34491,
-34663,
-34855,
-34763,
-34333,
-33849,
-33720,
-34204,
-35318,
-36782,
-38116,
-38775,
-38594,
-37852,
-37103,
-36694,
-36495,
-36223,
-35863,
-35733,
-36145,
-36956,
-37661,
-37908,
-37798,
-37736,
-37892,
-37959,
-37525,
-36502,
-35431,
-35017,
-35539,
-36584,
-37307,
-37181,
-36364,
-35465,
-35017,
-34913,
-34825,
-34513,
-34165,
-33989,
-33955,
-33855,
-33822,
-34166,
-35053,
-35893,
-35883,
-34770,
-33261,
-32298,
-32153,
-32284,
-32219,
-32139,
-32592,
-33607,
-34523,
-34676,
-34276,
-34038,
-34440,
-35035,
-35014,
-34068,
-32703,
-31738,
-31585,
-32108,
-32864,
-33471,
-33711,
-33526,
-33093,
-32679,
-32500,
-32442,
-32324,
-32060,
-31914,
-32083,
-32407,
-32502,
-32113,
-31706,
-31919,
-32987,
-34243,
-34621,
-33699,
-32107,
-31122,
-31388,
-32605,
-33686,
-33949,
-33395,
-32545,
-31894,
-31638,
-31858,
-32533,
-33378,
-33883,
-33497,
-32297,
-30842,
-29875,
-29717,
-30188,
-31050,
-32126,
-33280,
-34139,
-34295,
-33757,
-33040,
-32775,
-33064,
-33371,
-33153,
-32394,
-31617,
-31287,
-31341,
-31456,
-31500,
-31689,
-32169,
-32628,
-32606,
-32039,
-31515,
-31645,
-32495,
-33384,
-33764,
-33553,
-33245,
-33074,
-32983,
-32742,
-32569,
-32833,
-33648,
-34548,
-34891,
-34509,
-33781,
-33303,
-33256,
-33433,
-33498,
-33334,
-33022,
-32734,
-32564,
-32626,
-32910,
-33367,
-33767,
-34040,
-34168,
-34333,
-34673,
-35217,
-35958,
-36754,
-37389,
-37520,
-36919,
-35710,
-34399,
-33593,
-33541,
-34076,
-34722,
-35127,
-35157,
-34767,
-34042,
-33125,
-32367,
-32145,
-32515,
-33135,
-33484,
-33340,
-32923,
-32766,
-33035,
-33627,
-34046,
-34134,
-33953,
-33814,
-33845,
-33972,
-34055,
-34110,
-34226,
-34430,
-34563,
-34426,
-34151,
-34000,
-34179,
-34430,
-34260,
-33523,
-32666,
-32419,
-33030,
-34004,
-34481,
-34056,
-33024,
-32013,
-31546,
-31704,
-32390,
-33292,
-34025,
-34169,
-33611,
-32617,
-31611,
-30744,
-29916,
-29128,
-28701,
-29011,
-29957,
-30890,
-31283,
-31124,
-30940,
-31050,
-31278,
-31177,
-30646,
-29999,
-29643,
-29633,
-29657,
-29422,
-28968,
-28711,
-29099,
-30260,
-31751,
-32835,
-32995,
-32391,
-31695,
-31548,
-31903,
-32261,
-32122,
-31468,
-30645,
-29955,
-29496,
-29217,
-28959,
-28560,
-27806,
-26784,
-25965,
-25852,
-26562,
-27607,
-28337,
-28565,
-28520,
-28588,
-28864,
-29234,
-29539,
-29690,
-29517,
-29056,
-28585,
-28711,
-29752,
-31300,
-32439,
-32501,
-31668,
-30832,
-30713,
-31340,
-32086,
-32246,
-31592,
-30399,
-29330,
-28926,
-29426,
-30446,
-31351,
-31491,
-30914,
-30143,
-30006,
-30811,
-32134,
-33050,
-32832,
-31551,
-30079,
-29432,
-30050,
-31467,
-32777,
-33245,
-32817,
-31967,
-31325,
-31278,
-31798,
-32541,
-33015,
-32940,
-32445,
-31953,
-31938,
-32370,
-32897,
-33012,
-32579,
-31928,
-31474,
-31467,
-31776,
-32055,
-32158,
-32081,
-31991,
-31822,
-31486,
-30899,
-30412,
-30392,
-31029,
-31961,
-32624,
-32705,
-32334,
-31820,
-31397,
-31099,
-31005,
-31201,
-31457,
-31379,
-30566,
-29443,
-28808,
-29302,
-30522,
-31390,
-31141,
-30071,
-29210,
-29316,
-30251,
-31264,
-31744,
-31636,
-31214,
-30730,
-30320,
-30096,
-30068,
-30168,
-30060,
-29680,
-29248,
-29134,
-29423,
-29730,
-29672,
-29305,
-29124,
-29442,
-30050,
-30376,
-30164,
-29778,
-29690,
-30093,
-30518,
-30605,
-30288,
-29986,
-30060,
-30555,
-31286,
-32019,
-32595,
-32910,
-32854,
-32528,
-32106,
-31843,
-31780,
-31845,
-31966,
-32172,
-32426,
-32655,
-32639,
-32378,
-31962,
-31624,
-31522,
-31742,
-32285,
-33028,
-33674,
-33930,
-33633,
-32973,
-32216,
-31655,
-31461,
-31770,
-32664,
-33830,
-34636,
-34437,
-33184,
-31647,
-30791,
-31050,
-32030,
-32937,
-33321,
-33331,
-33304,
-33472,
-33529,
-33257,
-32426,
-31384,
-30530,
-30316,
-30811,
-31639,
-32305,
-32435,
-32176,
-31822,
-31653,
-31640,
-31669,
-31723,
-31750,
-31629,
-31231,
-30725,
-30593,
-31115,
-31938,
-32212,
-31425,
-29966,
-28929,
-29072,
-30303,
-31722,
-32503,
-32374,
-31670,
-30958,
-30695,
-31059,
-31872,
-32789,
-33435,
-33642,
-33464,
-33053,
-32702,
-32703,
-33265,
-34114,
-34610,
-34169,
-32949,
-31897,
-31967,
-33283,
-34988,
-35947,
-35716,
-34729,
-33894,
-33832,
-34452,
-35164,
-35237,
-34507,
-33353,
-32526,
-32464,
-33048,
-33839,
-34457,
-34782,
-34787,
-34424,
-33861,
-33488,
-33701,
-34394,
-34978,
-35023,
-34593,
-34158,
-33881,
-33578,
-33136,
-32957,
-33513,
-34644,
-35510,
-35340,
-34220,
-32961,
-32236,
-32155,
-32505,
-33139,
-33918,
-34454,
-34196,
-33141,
-32001,
-31636,
-32203,
-33011,
-33326,
-33063,
-32726,
-32760,
-33173,
-33759,
-34393,
-35070,
-35512,
-35349,
-34462,
-33319,
-32766,
-33241,
-34461,
-35569,
-36007,
-35838,
-35696,
-35966,
-36414,
-36472,
-35991,
-35501,
-35662,
-36380,
-36863,
-36408,
-35408,
-34833,
-35344,
-36440,
-37213,
-37263,
-36874,
-36330,
-35461,
-34086,
-32772,
-32411,
-33293,
-34524,
-34996,
-34563,
-34024,
-34154,
-34651,
-34829,
-34416,
-33926,
-33931,
-34364,
-34942,
-35447,
-35852,
-35843,
-34957,
-33432,
-32315,
-32723,
-34443,
-36095,
-36409,
-35466,
-34414,
-34025,
-34151,
-34150,
-33944,
-33929,
-34221,
-34439,
-34132,
-33572,
-33444,
-34022,
-34890,
-35319,
-35147,
-34748,
-34564,
-34567,
-34591,
-34453,
-34374,
-34413,
-34571,
-34667,
-34699,
-34758,
-34954,
-35283,
-35654,
-36000,
-36295,
-36461,
-36408,
-36005,
-35335,
-34701,
-34530,
-34997,
-35730,
-36069,
-35665,
-34811,
-34255,
-34236,
-34406,
-34174,
-33601,
-33314,
-33694,
-34283,
-34220,
-33271,
-32167,
-31795,
-32184,
-32553,
-32251,
-31478,
-30970,
-31027,
-31391,
-31550,
-31546,
-31663,
-32053,
-32522,
-32811,
-33023,
-33312,
-33700,
-33909,
-33753,
-33321,
-32890,
-32681,
-32789,
-33259,
-34020,
-34847,
-35305,
-35233,
-34691,
-34147,
-33780,
-33635,
-33558,
-33590,
-33838,
-34228,
-34438,
-34081,
-33175,
-32147,
-31711,
-32176,
-33293,
-34316,
-34705,
-34496,
-34187,
-34065,
-33834,
-33101,
-32019,
-31483,
-32052,
-33297,
-33957,
-33300,
-31842,
-30714,
-30448,
-30592,
-30636,
-30759,
-31509,
-32705,
-33359,
-32655,
-31057,
-29848,
-29760,
-30325,
-30542,
-30139,
-29710,
-29771,
-30201,
-30414,
-30362,
-30410,
-30933,
-31618,
-32000,
-31868,
-31609,
-31494,
-31454,
-31160,
-30565,
-30034,
-30034,
-30697,
-31783,
-32822,
-33390,
-33281,
-32635,
-31932,
-31662,
-32035,
-32683,
-33093,
-32875,
-32158,
-31407,
-31152,
-31627,
-32674,
-33677,
-34027,
-33459,
-32397,
-31624,
-31712,
-32610,
-33800,
-34712,
-35094,
-34879,
-34178,
-33159,
-32256,
-31862,
-32147,
-32826,
-33346,
-33386,
-32900,
-32211,
-31631,
-31497,
-31903,
-32693,
-33360,
-33369,
-32539,
-31290,
-30303,
-30103,
-30628,
-31451,
-32003,
-31996,
-31422,
-30579,
-29901,
-29742,
-30212,
-31051,
-31841,
-32169,
-31948,
-31383,
-30923,
-30963,
-31610,
-32469,
-32949,
-32615,
-31664,
-30735,
-30422,
-30850,
-31631,
-32407,
-32970,
-33270,
-33105,
-32300,
-31013,
-29925,
-29729,
-30511,
-31676,
-32355,
-32292,
-31738,
-31253,
-31096,
-31343,
-31979,
-32920,
-33813,
-34049,
-33391,
-32227,
-31547,
-31924,
-33165,
-34450,
-35148,
-35266,
-35082,
-34807,
-34433,
-34045,
-33928,
-34221,
-34724,
-34982,
-34804,
-34339,
-33962,
-33797,
-33832,
-33978,
-34211,
-34392,
-34377,
-34090,
-33864,
-33969,
-34495,
-35015,
-35135,
-34808,
-34356,
-34198,
-34328,
-34551,
-34520,
-34241,
-33960,
-34006,
-34452,
-34969,
-35082,
-34723,
-34273,
-34293,
-34825,
-35250,
-35064,
-34311,
-33730,
-33774,
-34194,
-34344,
-33925,
-33254,
-32748,
-32433,
-32107,
-31881,
-32140,
-33081,
-34144,
-34491,
-33747,
-32450,
-31495,
-31390,
-31918,
-32544,
-32911,
-32908,
-32635,
-32137,
-31601,
-31244,
-31291,
-31760,
-32438,
-33071,
-33395,
-33338,
-32881,
-32235,
-31646,
-31361,
-31343,
-31324,
-30990,
-30455,
-30110,
-30416,
-31195,
-31780,
-31572,
-30721,
-30122,
-30553,
-31869,
-33157,
-33505,
-32901,
-32052,
-31615,
-31650,
-31674,
-31388,
-30903,
-30707,
-31109,
-31991,
-32887,
-33247,
-32844,
-31975,
-31313,
-31450,
-32422,
-33577,
-34096,
-33627,
-32539,
-31629,
-31394,
-31837,
-32484,
-33026,
-33418,
-33843,
-34299,
-34512,
-34140,
-33243,
-32303,
-31966,
-32455,
-33437,
-34315,
-34652,
-34443,
-33904,
-33341,
-33047,
-33191,
-33791,
-34460,
-34759,
-34490,
-33963,
-33705,
-33870,
-34125,
-34060,
-33674,
-33448,
-33727,
-34351,
-34796,
-34735,
-34429,
-34267,
-34474,
-34730,
-34627,
-34026,
-33166,
-32436,
-32174,
-32390,
-32873,
-33286,
-33346,
-33087,
-32734,
-32545,
-32596,
-32809,
-33198,
-33806,
-34599,
-35203,
-35196,
-34542,
-33661,
-33210,
-33461,
-34167,
-34836,
-35105,
-34837,
-34173,
-33369,
-32803,
-32753,
-33184,
-33715,
-33988,
-33828,
-33467,
-33021,
-32535,
-31917,
-31295,
-30967,
-31139,
-31746,
-32330,
-32491,
-31998,
-31133,
-30430,
-30436,
-31124,
-31929,
-32026,
-31187,
-29969,
-29349,
-29824,
-31070,
-32183,
-32543,
-32124,
-31482,
-31147,
-31334,
-31791,
-32094,
-31966,
-31467,
-31020,
-30902,
-31193,
-31557,
-31823,
-31962,
-32146,
-32369,
-32477,
-32280,
-31799,
-31132,
-30469,
-29923,
-29760,
-30104,
-30861,
-31694,
-32255,
-32550,
-32708,
-32718,
-32385,
-31651,
-30921,
-30696,
-31016,
-31347,
-31134,
-30493,
-30119,
-30508,
-31495,
-32392,
-32768,
-32618,
-32208,
-31671,
-31069,
-30572,
-30419,
-30597,
-30885,
-31068,
-31258,
-31710,
-32281,
-32514,
-32013,
-30999,
-30224,
-30260,
-31039,
-32025,
-32595,
-32595,
-32143,
-31607,
-31303,
-31452,
-31999,
-32651,
-33180,
-33489,
-33786,
-34072,
-34172,
-33850,
-33219,
-32709,
-32682,
-33088,
-33506,
-33638,
-33419,
-33140,
-32978,
-33063,
-33382,
-33897,
-34460,
-34960,
-35253,
-35396,
-35330,
-35030,
-34444,
-33791,
-33426,
-33458,
-33634,
-33561,
-33249,
-33214,
-33891,
-35052,
-35814,
-35478,
-34155,
-32709,
-32001,
-32225,
-32949,
-33600,
-33785,
-33524,
-33105,
-32966,
-33437,
-34314,
-34976,
-34817,
-33980,
-33287,
-33513,
-34560,
-35561,
-35715,
-35097,
-34364,
-34085,
-34096,
-34013,
-33716,
-33543,
-33865,
-34504,
-35022,
-34979,
-34455,
-33793,
-33419,
-33447,
-33806,
-34192,
-34343,
-34162,
-33743,
-33349,
-33173,
-33294,
-33697,
-34225,
-34693,
-34745,
-34275,
-33394,
-32594,
-32231,
-32416,
-32920,
-33531,
-34108,
-34557,
-34664,
-34314,
-33651,
-33180,
-33303,
-34025,
-34790,
-34924,
-34196,
-32943,
-31946,
-31782,
-32358,
-33107,
-33376,
-33149,
-32993,
-33436,
-34416,
-35252,
-35234,
-34334,
-33061,
-32078,
-31692,
-31825,
-32310,
-32906,
-33392,
-33558,
-33329,
-32895,
-32492,
-32209,
-32068,
-32005,
-32088,
-32308,
-32506,
-32520,
-32281,
-31962,
-31722,
-31622,
-31564,
-31518,
-31496,
-31556,
-31631,
-31660,
-31543,
-31319,
-31058,
-30828,
-30836,
-31082,
-31547,
-31975,
-32126,
-31910,
-31424,
-30805,
-30168,
-29654,
-29442,
-29714,
-30394,
-31127,
-31515,
-31421,
-31123,
-30993,
-31242,
-31768,
-32269,
-32557,
-32444,
-31954,
-31157,
-30334,
-29790,
-29657,
-29849,
-30165,
-30530,
-31060,
-31738,
-32316,
-32408,
-31879,
-31037,
-30412,
-30332,
-30752,
-31359,
-31890,
-32174,
-32139,
-31788,
-31207,
-30737,
-30588,
-30846,
-31233,
-31482,
-31507,
-31582,
-31900,
-32474,
-32886,
-32785,
-32119,
-31292,
-30784,
-30802,
-31174,
-31533,
-31655,
-31543,
-31296,
-31098,
-31096,
-31383,
-31909,
-32378,
-32504,
-32234,
-31845,
-31642,
-31757,
-31988,
-32144,
-32133,
-31943,
-31585,
-31087,
-30638,
-30442,
-30553,
-30746,
-30832,
-30854,
-31042,
-31450,
-31820,
-31826,
-31472,
-31042,
-30889,
-31012,
-31321,
-31713,
-32100,
-32418,
-32364,
-31983,
-31420,
-31092,
-31042,
-31186,
-31323,
-31484,
-31705,
-31913,
-31968,
-31866,
-31807,
-31892,
-31924,
-31662,
-31121,
-30683,
-30675,
-30966,
-31152,
-31016,
-30762,
-30772,
-31123,
-31509,
-31667,
-31544,
-31532,
-31884,
-32683,
-33613,
-34224,
-34169,
-33390,
-32275,
-31406,
-31213,
-31710,
-32521,
-33255,
-33702,
-33920,
-33990,
-34042,
-34095,
-34194,
-34223,
-34092,
-33769,
-33413,
-33276,
-33414,
-33705,
-33898,
-33786,
-33364,
-32710,
-32103,
-31901,
-32369,
-33371,
-34377,
-34762,
-34351,
-33509,
-32843,
-32698,
-33041,
-33543,
-33881,
-33778,
-33183,
-32296,
-31634,
-31654,
-32395,
-33395,
-34095,
-34278,
-34213,
-34303,
-34727,
-35375,
-35949,
-36140,
-35759,
-34860,
-33873,
-33312,
-33384,
-33719,
-33742,
-33254,
-32717,
-32697,
-33287,
-34056,
-34458,
-34467,
-34329,
-34267,
-34208,
-34079,
-33887,
-33753,
-33577,
-33245,
-32847,
-32707,
-33077,
-33729,
-34236,
-34288,
-34053,
-33768,
-33547,
-33402,
-33381,
-33674,
-34193,
-34595,
-34605,
-34403,
-34399,
-34736,
-34951,
-34610,
-33804,
-33200,
-33318,
-33902,
-34353,
-34319,
-34035,
-33918,
-33953,
-33911,
-33656,
-33465,
-33550,
-33813,
-33872,
-33564,
-33121,
-32835,
-32748,
-32661,
-32527,
-32523,
-32842,
-33404,
-33873,
-34092,
-34129,
-34169,
-34211,
-34140,
-33922,
-33727,
-33748,
-33914,
-34017,
-33851,
-33497,
-33092,
-32751,
-32377,
-31977,
-31674,
-31669,
-31992,
-32413,
-32664,
-32624,
-32428,
-32207,
-32000,
-31744,
-31443,
-31252,
-31243,
-31411,
-31544,
-31644,
-31791,
-32107,
-32492,
-32699,
-32642,
-32500,
-32496,
-32534,
-32233,
-31362,
-30276,
-29722,
-30214,
-31508,
-32799,
-33395,
-33220,
-32714,
-32334,
-32232,
-32254,
-32281,
-32316,
-32411,
-32625,
-32861,
-33059,
-33047,
-32796,
-32299,
-31866,
-31808,
-32311,
-33182,
-33969,
-34248,
-33900,
-33053,
-32041,
-31197,
-30890,
-31282,
-32178,
-32995,
-33144,
-32502,
-31569,
-31022,
-31152,
-31718,
-32180,
-32282,
-32105,
-31945,
-32003,
-32291,
-32687,
-33056,
-33193,
-33060,
-32608,
-32127,
-31790,
-31912,
-32419,
-33137,
-33675,
-33746,
-33379,
-32933,
-32810,
-33156,
-33747,
-34199,
-34400,
-34363,
-34270,
-34118,
-33966,
-33902,
-34055,
-34326,
-34501,
-34436,
-34293,
-34333,
-34630,
-35016,
-35222,
-35262,
-35240,
-35329,
-35496,
-35763,
-36015,
-36117,
-35815,
-35049,
-34138,
-33550,
-33537,
-33830,
-34042,
-34089,
-34231,
-34733,
-35440,
-35939,
-35992,
-35631,
-35157,
-34771,
-34659,
-34947,
-35639,
-36446,
-36933,
-36807,
-36249,
-35627,
-35275,
-35192,
-35306,
-35522,
-35817,
-36028,
-36005,
-35751,
-35424,
-35141,
-34862,
-34383,
-33813,
-33414,
-33477,
-33935,
-34374,
-34468,
-34176,
-33838,
-33775,
-34142,
-34783,
-35492,
-36049,
-36347,
-36265,
-35805,
-35071,
-34400,
-34156,
-34429,
-34942,
-35197,
-34921,
-34298,
-33739,
-33496,
-33522,
-33564,
-33540,
-33429,
-33238,
-32844,
-32245,
-31572,
-31072,
-30852,
-30922,
-31251,
-31857,
-32580,
-33072,
-32985,
-32364,
-31635,
-31232,
-31239,
-31397,
-31589,
-31819,
-32180,
-32449,
-32375,
-31952,
-31524,
-31421,
-31608,
-31798,
-31786,
-31631,
-31456,
-31187,
-30782,
-30354,
-30258,
-30614,
-31137,
-31369,
-31176,
-30908,
-30994,
-31531,
-32180,
-32554,
-32508,
-32120,
-31628,
-31220,
-31167,
-31563,
-32300,
-32980,
-33283,
-33179,
-32896,
-32626,
-32357,
-32093,
-32025,
-32428,
-33218,
-33812,
-33580,
-32486,
-31256,
-30785,
-31375,
-32522,
-33485,
-33796,
-33579,
-33062,
-32463,
-31903,
-31659,
-31987,
-32883,
-33874,
-34334,
-34058,
-33374,
-32947,
-33165,
-33845,
-34457,
-34529,
-34014,
-33321,
-32923,
-33045,
-33445,
-33679,
-33434,
-32874,
-32392,
-32390,
-32825,
-33467,
-33946,
-34160,
-34088,
-33786,
-33332,
-32853,
-32577,
-32638,
-32960,
-33405,
-33763,
-34003,
-34146,
-34150,
-34095,
-33981,
-33921,
-33873,
-33718,
-33312,
-32723,
-32117,
-31700,
-31522,
-31498,
-31539,
-31582,
-31568,
-31511,
-31438,
-31492,
-31651,
-31799,
-31735,
-31480,
-31305,
-31457,
-31908,
-32335,
-32413,
-32126,
-31647,
-31179,
-30755,
-30388,
-30153,
-30192,
-30477,
-30851,
-31038,
-30963,
-30690,
-30491,
-30567,
-31049,
-31725,
-32198,
-32099,
-31410,
-30589,
-30164,
-30342,
-30824,
-31163,
-31156,
-30963,
-30851,
-30962,
-31251,
-31661,
-32136,
-32623,
-32953,
-33023,
-32701,
-32112,
-31380,
-30828,
-30747,
-31264,
-32145,
-32909,
-33105,
-32757,
-32271,
-32083,
-32344,
-32826,
-33284,
-33583,
-33697,
-33518,
-32999,
-32219,
-31624,
-31515,
-31912,
-32328,
-32284,
-31661,
-30864,
-30335,
-30257,
-30447,
-30691,
-31007,
-31479,
-32043,
-32358,
-32126,
-31457,
-30712,
-30374,
-30452,
-30691,
-30823,
-30751,
-30616,
-30530,
-30485,
-30541,
-30720,
-31048,
-31371,
-31384,
-30976,
-30255,
-29595,
-29332,
-29533,
-30040,
-30547,
-30781,
-30638,
-30280,
-30050,
-30302,
-31060,
-31962,
-32419,
-32166,
-31361,
-30601,
-30356,
-30710,
-31366,
-31927,
-32215,
-32320,
-32387,
-32484,
-32516,
-32340,
-31934,
-31421,
-30958,
-30649,
-30473,
-30353,
-30298,
-30288,
-30415,
-30623,
-30965,
-31317,
-31622,
-31684,
-31499,
-31101,
-30709,
-30368,
-30071,
-29755,
-29503,
-29439,
-29554,
-29709,
-29771,
-29857,
-30138,
-30595,
-30948,
-30989,
-30748,
-30503,
-30303,
-29993,
-29536,
-29195,
-29377,
-30049,
-30712,
-30832,
-30466,
-30090,
-30057,
-30273,
-30419,
-30488,
-30657,
-30975,
-31055,
-30624,
-29925,
-29565,
-29979,
-30837,
-31535,
-31708,
-31578,
-31444,
-31423,
-31330,
-31107,
-30949,
-31034,
-31343,
-31684,
-31903,
-32036,
-32100,
-32032,
-31826,
-31607,
-31661,
-32007,
-32443,
-32532,
-32117,
-31298,
-30443,
-29886,
-29831,
-30255,
-30978,
-31690,
-32151,
-32275,
-32135,
-31907,
-31728,
-31753,
-32028,
-32493,
-32852,
-32804,
-32269,
-31533,
-30965,
-30734,
-30746,
-30847,
-31081,
-31507,
-32001,
-32283,
-32175,
-31892,
-31781,
-32036,
-32512,
-32958,
-33270,
-33413,
-33353,
-32994,
-32531,
-32267,
-32541,
-33140,
-33617,
-33638,
-33403,
-33386,
-33859,
-34656,
-35326,
-35620,
-35476,
-35118,
-34709,
-34454,
-34378,
-34363,
-34252,
-33958,
-33742,
-33820,
-34234,
-34668,
-34810,
-34643,
-34419,
-34328,
-34326,
-34198,
-33959,
-33761,
-33806,
-34042,
-34184,
-34029,
-33528,
-32921,
-32513,
-32501,
-32900,
-33387,
-33676,
-33519,
-33087,
-32719,
-32764,
-33234,
-33887,
-34278,
-34208,
-33688,
-33132,
-32905,
-33209,
-33782,
-34188,
-34064,
-33539,
-33023,
-32981,
-33516,
-34403,
-35302,
-35985,
-36441,
-36700,
-36773,
-36630,
-36253,
-35721,
-35149,
-34635,
-34314,
-34236,
-34503,
-35047,
-35682,
-36157,
-36275,
-36124,
-35842,
-35666,
-35609,
-35597,
-35492,
-35168,
-34630,
-34051,
-33687,
-33708,
-33974,
-34127,
-33936,
-33558,
-33388,
-33681,
-34210,
-34561,
-34500,
-34144,
-33782,
-33519,
-33364,
-33263,
-33268,
-33243,
-33078,
-32681,
-32306,
-32281,
-32620,
-33005,
-33104,
-32972,
-32982,
-33357,
-33892,
-34169,
-33969,
-33433,
-32913,
-32689,
-32937,
-33578,
-34329,
-34643,
-34182,
-33166,
-32343,
-32426,
-33414,
-34676,
-35443,
-35510,
-35126,
-34668,
-34312,
-34093,
-34074,
-34296,
-34599,
-34736,
-34539,
-34181,
-33913,
-33888,
-33983,
-34094,
-34219,
-34440,
-34770,
-35077,
-35242,
-35244,
-35069,
-34739,
-34268,
-33821,
-33597,
-33622,
-33734,
-33658,
-33369,
-33002,
-32803,
-32775,
-32907,
-33091,
-33281,
-33397,
-33304,
-33033,
-32745,
-32665,
-32766,
-32905,
-32865,
-32686,
-32508,
-32411,
-32356,
-32245,
-32030,
-31743,
-31439,
-31220,
-31249,
-31557,
-32058,
-32419,
-32522,
-32423,
-32395,
-32534,
-32641,
-32523,
-32126,
-31758,
-31707,
-32058,
-32715,
-33410,
-33926,
-34130,
-33956,
-33620,
-33307,
-33236,
-33291,
-33296,
-33094,
-32718,
-32347,
-32053,
-31959,
-32089,
-32536,
-33205,
-33852,
-34182,
-34084,
-33749,
-33490,
-33501,
-33758,
-34019,
-34076,
-33843,
-33498,
-33283,
-33445,
-33898,
-34387,
-34605,
-34529,
-34375,
-34341,
-34496,
-34579,
-34615,
-34515,
-34521,
-34498,
-34411,
-34201,
-34023,
-34014,
-34142,
-34194,
-34122,
-33991,
-33992,
-34130,
-34243,
-34246,
-34109,
-33893,
-33532,
-33022,
-32550,
-32394,
-32671,
-33062,
-33162,
-32863,
-32428,
-32173,
-32062,
-31872,
-31565,
-31470,
-31822,
-32473,
-32901,
-32814,
-32411,
-32138,
-32121,
-32220,
-32234,
-32272,
-32497,
-32766,
-32740,
-32236,
-31557,
-31244,
-31480,
-32044,
-32465,
-32587,
-32516,
-32475,
-32514,
-32556,
-32502,
-32214,
-31697,
-31082,
-30674,
-30836,
-31495,
-32313,
-32774,
-32797,
-32655,
-32700,
-33018,
-33376,
-33571,
-33624,
-33675,
-33805,
-33899,
-33793,
-33469,
-33101,
-32978,
-33243,
-33840,
-34396,
-34590,
-34232,
-33614,
-33070,
-32936,
-33152,
-33477,
-33708,
-33745,
-33694,
-33555,
-33470,
-33394,
-33485,
-33660,
-33886,
-34010,
-34004,
-33934,
-33922,
-34009,
-34196,
-34389,
-34541,
-34654,
-34709,
-34757,
-34802,
-34839,
-34806,
-34575,
-34090,
-33445,
-32944,
-32923,
-33423,
-34209,
-34748,
-34801,
-34409,
-33975,
-33803,
-33917,
-34131,
-34153,
-33958,
-33562,
-33222,
-33024,
-33054,
-33189,
-33256,
-33099,
-32744,
-32311,
-32007,
-31873,
-31855,
-31841,
-31744,
-31627,
-31617,
-31806,
-32190,
-32558,
-32661,
-32383,
-31853,
-31385,
-31192,
-31266,
-31361,
-31327,
-31103,
-30902,
-30783,
-30861,
-31033,
-31304,
-31603,
-31826,
-31863,
-31608,
-31208,
-30853,
-30742,
-30875,
-31070,
-31206,
-31210,
-31197,
-31239,
-31344,
-31415,
-31385,
-31221,
-31029,
-30934,
-31055,
-31300,
-31468,
-31313,
-30870,
-30418,
-30311,
-30613,
-31097,
-31461,
-31563,
-31519,
-31400,
-31272,
-31159,
-31168,
-31345,
-31578,
-31614,
-31439,
-31238,
-31260,
-31482,
-31572,
-31398,
-31118,
-31072,
-31378,
-31766,
-32000,
-32136,
-32392,
-32878,
-33297,
-33384,
-33092,
-32741,
-32596,
-32694,
-32887,
-33073,
-33262,
-33456,
-33530,
-33411,
-33138,
-32993,
-33155,
-33619,
-34186,
-34609,
-34766,
-34622,
-34225,
-33685,
-33212,
-33037,
-33246,
-33660,
-33980,
-33943,
-33634,
-33312,
-33269,
-33487,
-33780,
-33936,
-33985,
-34109,
-34353,
-34568,
-34473,
-34007,
-33439,
-33120,
-33248,
-33713,
-34180,
-34433,
-34323,
-33910,
-33400,
-33095,
-33281,
-33894,
-34527,
-34714,
-34364,
-33948,
-33945,
-34431,
-34876,
-34758,
-34118,
-33464,
-33330,
-33633,
-33945,
-33912,
-33585,
-33306,
-33219,
-33271,
-33402,
-33634,
-34119,
-34656,
-34959,
-34734,
-34166,
-33605,
-33371,
-33366,
-33333,
-33104,
-32799,
-32599,
-32571,
-32581,
-32520,
-32413,
-32313,
-32239,
-32084,
-31875,
-31764,
-31889,
-32177,
-32323,
-32148,
-31746,
-31489,
-31551,
-31849,
-32035,
-31940,
-31677,
-31481,
-31500,
-31661,
-31817,
-31908,
-31960,
-31984,
-32029,
-32094,
-32263,
-32495,
-32616,
-32416,
-31828,
-31145,
-30695,
-30651,
-30787,
-30810,
-30683,
-30654,
-31001,
-31589,
-32077,
-32129,
-31831,
-31449,
-31210,
-31121,
-31148,
-31228,
-31342,
-31288,
-31029,
-30665,
-30584,
-30890,
-31413,
-31748,
-31769,
-31640,
-31607,
-31592,
-31472,
-31170,
-30888,
-30729,
-30654,
-30543,
-30514,
-30657,
-30934,
-30959,
-30604,
-30098,
-29936,
-30251,
-30727,
-30991,
-30985,
-30988,
-31061,
-31058,
-30849,
-30613,
-30651,
-30923,
-31052,
-30768,
-30222,
-29922,
-30046,
-30466,
-30826,
-31018,
-31087,
-31062,
-30885,
-30636,
-30560,
-30839,
-31313,
-31604,
-31504,
-31222,
-31172,
-31462,
-31886,
-32023,
-31814,
-31449,
-31296,
-31485,
-31940,
-32367,
-32592,
-32492,
-32223,
-31944,
-31871,
-32019,
-32277,
-32385,
-32225,
-31803,
-31425,
-31360,
-31697,
-32246,
-32555,
-32459,
-32053,
-31802,
-32019,
-32612,
-33225,
-33490,
-33424,
-33290,
-33279,
-33302,
-33196,
-32816,
-32379,
-32035,
-31859,
-31759,
-31693,
-31805,
-32168,
-32712,
-33139,
-33297,
-33262,
-33247,
-33260,
-33135,
-32745,
-32291,
-32102,
-32294,
-32628,
-32724,
-32523,
-32244,
-32161,
-32318,
-32523,
-32663,
-32712,
-32745,
-32707,
-32612,
-32480,
-32454,
-32559,
-32669,
-32680,
-32614,
-32638,
-32838,
-33118,
-33281,
-33185,
-32857,
-32478,
-32178,
-32147,
-32365,
-32739,
-33049,
-33137,
-33085,
-33091,
-33288,
-33529,
-33583,
-33305,
-32931,
-32625,
-32570,
-32584,
-32653,
-32836,
-33197,
-33696,
-33961,
-33925,
-33640,
-33497,
-33564,
-33703,
-33629,
-33314,
-33008,
-32887,
-32956,
-32996,
-32913,
-32839,
-32930,
-33207,
-33487,
-33557,
-33327,
-32878,
-32289,
-31765,
-31455,
-31540,
-31969,
-32518,
-32875,
-32875,
-32602,
-32202,
-31821,
-31480,
-31210,
-31084,
-31134,
-31305,
-31436,
-31440,
-31399,
-31486,
-31812,
-32287,
-32670,
-32806,
-32651,
-32344,
-31996,
-31676,
-31464,
-31417,
-31577,
-31823,
-31934,
-31761,
-31482,
-31416,
-31868,
-32672,
-33398,
-33589,
-33210,
-32523,
-31946,
-31616,
-31495,
-31495,
-31545,
-31659,
-31788,
-31856,
-31905,
-31958,
-32050,
-32073,
-31985,
-31817,
-31777,
-31943,
-32200,
-32309,
-32114,
-31742,
-31433,
-31404,
-31615,
-31936,
-32167,
-32266,
-32161,
-31946,
-31656,
-31472,
-31537,
-31908,
-32387,
-32726,
-32651,
-32302,
-31968,
-31970,
-32298,
-32642,
-32682,
-32375,
-31953,
-31675,
-31632,
-31748,
-31989,
-32348,
-32792,
-33158,
-33295,
-33200,
-33026,
-32854,
-32647,
-32396,
-32207,
-32305,
-32659,
-32967,
-32869,
-32412,
-31941,
-31881,
-32232,
-32700,
-33020,
-33139,
-33161,
-33147,
-33039,
-32966,
-33021,
-33348,
-33695,
-33844,
-33656,
-33415,
-33339,
-33523,
-33685,
-33672,
-33484,
-33347,
-33367,
-33510,
-33626,
-33736,
-33874,
-34108,
-34328,
-34369,
-34191,
-33847,
-33578,
-33507,
-33597,
-33679,
-33545,
-33260,
-33049,
-33102,
-33414,
-33784,
-34063,
-34289,
-34530,
-34729,
-34707,
-34443,
-34088,
-33853,
-33723,
-33507,
-33193,
-33009,
-33139,
-33469,
-33589,
-33313,
-32906,
-32797,
-33134,
-33594,
-33795,
-33630,
-33321,
-33077,
-32959,
-32879,
-32883,
-32958,
-33159,
-33363,
-33547,
-33679,
-33715,
-33579,
-33272,
-32966,
-32937,
-33231,
-33694,
-33984,
-33939,
-33644,
-33289,
-33081,
-33093,
-33219,
-33313,
-33230,
-32995,
-32764,
-32631,
-32546,
-32423,
-32296,
-32407,
-32797,
-33275,
-33397,
-33061,
-32540,
-32261,
-32382,
-32624,
-32698,
-32458,
-32083,
-31686,
-31387,
-31244,
-31332,
-31641,
-31924,
-31941,
-31646,
-31262,
-31049,
-30945,
-30737,
-30275,
-29763,
-29582,
-29920,
-30593,
-31182,
-31394,
-31246,
-30969,
-30833,
-30868,
-31001,
-31113,
-31123,
-31086,
-31002,
-30918,
-30898,
-30979,
-31190,
-31397,
-31452,
-31283,
-31005,
-30769,
-30664,
-30519,
-30260,
-29875,
-29664,
-29789,
-30256,
-30805,
-31218,
-31474,
-31664,
-31849,
-31905,
-31724,
-31337,
-30977,
-30825,
-30914,
-31053,
-31174,
-31210,
-31279,
-31285,
-31185,
-30924,
-30696,
-30633,
-30774,
-30949,
-30952,
-30807,
-30600,
-30489,
-30551,
-30783,
-31196,
-31712,
-32117,
-32280,
-32116,
-31849,
-31662,
-31662,
-31754,
-31844,
-31903,
-31995,
-32152,
-32376,
-32645,
-32862,
-33035,
-33021,
-32930,
-32798,
-32725,
-32716,
-32689,
-32673,
-32725,
-32953,
-33288,
-33620,
-33908,
-34119,
-34367,
-34551,
-34710,
-34800,
-34925,
-34996,
-34935,
-34672,
-34368,
-34241,
-34348,
-34617,
-34850,
-35089,
-35334,
-35563,
-35550,
-35234,
-34767,
-34496,
-34566,
-34839,
-35008,
-34956,
-34773,
-34679,
-34726,
-34847,
-34931,
-34858,
-34672,
-34376,
-34120,
-34004,
-34120,
-34412,
-34749,
-35054,
-35277,
-35511,
-35765,
-36024,
-36257,
-36394,
-36444,
-36357,
-36171,
-35925,
-35724,
-35637,
-35664,
-35746,
-35779,
-35783,
-35790,
-35873,
-35997,
-36010,
-35804,
-35358,
-34847,
-34459,
-34318,
-34313,
-34310,
-34154,
-33925,
-33735,
-33730,
-33877,
-34035,
-34081,
-33956,
-33813,
-33741,
-33805,
-33928,
-34008,
-34019,
-33971,
-33913,
-33867,
-33819,
-33781,
-33771,
-33763,
-33779,
-33723,
-33582,
-33327,
-33074,
-32931,
-33005,
-33191,
-33330,
-33279,
-33103,
-32977,
-32985,
-33018,
-32909,
-32603,
-32290,
-32152,
-32226,
-32369,
-32458,
-32502,
-32611,
-32842,
-33126,
-33391,
-33612,
-33834,
-34019,
-34045,
-33768,
-33256,
-32717,
-32501,
-32622,
-32917,
-33041,
-32843,
-32522,
-32342,
-32501,
-32801,
-33017,
-32945,
-32740,
-32618,
-32781,
-33170,
-33611,
-33885,
-33920,
-33793,
-33677,
-33699,
-33868,
-34095,
-34250,
-34306,
-34259,
-34159,
-34052,
-33988,
-34056,
-34252,
-34541,
-34791,
-34860,
-34700,
-34301,
-33811,
-33431,
-33360,
-33593,
-33953,
-34156,
-34111,
-34042,
-34110,
-34452,
-34784,
-34960,
-34957,
-34984,
-35142,
-35335,
-35301,
-34997,
-34619,
-34453,
-34603,
-34845,
-34916,
-34672,
-34306,
-34010,
-33955,
-33984,
-33931,
-33649,
-33186,
-32717,
-32384,
-32343,
-32538,
-32891,
-33173,
-33260,
-33135,
-32965,
-32868,
-32885,
-32886,
-32805,
-32654,
-32537,
-32510,
-32576,
-32693,
-32856,
-32980,
-32937,
-32664,
-32300,
-32078,
-32137,
-32238,
-32038,
-31427,
-30697,
-30321,
-30499,
-31008,
-31496,
-31787,
-31936,
-32063,
-32088,
-31994,
-31791,
-31773,
-31963,
-32303,
-32454,
-32326,
-32032,
-31867,
-31935,
-32221,
-32483,
-32689,
-32770,
-32760,
-32600,
-32279,
-31909,
-31685,
-31713,
-31939,
-32195,
-32401,
-32614,
-32899,
-33154,
-33177,
-32947,
-32692,
-32787,
-33283,
-33802,
-33929,
-33563,
-33121,
-33125,
-33597,
-34213,
-34424,
-34137,
-33599,
-33165,
-33010,
-33051,
-33136,
-33167,
-33077,
-32873,
-32631,
-32522,
-32717,
-33231,
-33840,
-34254,
-34280,
-33994,
-33648,
-33498,
-33625,
-33910,
-34095,
-33968,
-33519,
-32957,
-32601,
-32577,
-32741,
-32778,
-32533,
-32168,
-31963,
-32017,
-32121,
-32000,
-31661,
-31353,
-31359,
-31602,
-31839,
-31852,
-31733,
-31617,
-31551,
-31420,
-31148,
-30879,
-30767,
-30809,
-30849,
-30729,
-30521,
-30429,
-30569,
-30889,
-31236,
-31498,
-31672,
-31693,
-31557,
-31253,
-30975,
-30871,
-31031,
-31287,
-31464,
-31529,
-31632,
-31956,
-32452,
-32866,
-32926,
-32692,
-32405,
-32386,
-32591,
-32793,
-32736,
-32462,
-32182,
-32123,
-32269,
-32512,
-32707,
-32804,
-32745,
-32487,
-32133,
-31789,
-31691,
-31784,
-31972,
-32087,
-32153,
-32212,
-32338,
-32450,
-32531,
-32556,
-32579,
-32564,
-32481,
-32351,
-32227,
-32119,
-31956,
-31699,
-31509,
-31642,
-32155,
-32763,
-33021,
-32714,
-32079,
-31506,
-31279,
-31269,
-31286,
-31128,
-30858,
-30599,
-30476,
-30605,
-30929,
-31329,
-31615,
-31701,
-31647,
-31504,
-31237,
-30803,
-30343,
-30150,
-30388,
-30821,
-30987,
-30675,
-30096,
-29712,
-29665,
-29791,
-29880,
-29976,
-30217,
-30540,
-30624,
-30318,
-29854,
-29628,
-29850,
-30300,
-30691,
-30914,
-31040,
-31089,
-30995,
-30789,
-30655,
-30789,
-31128,
-31392,
-31510,
-31538,
-31724,
-31999,
-32152,
-32098,
-31938,
-31950,
-32099,
-32234,
-32139,
-31876,
-31590,
-31395,
-31299,
-31361,
-31683,
-32279,
-32893,
-33172,
-32940,
-32479,
-32195,
-32386,
-32856,
-33189,
-33143,
-32776,
-32487,
-32502,
-32777,
-32956,
-32805,
-32329,
-31864,
-31658,
-31717,
-31780,
-31669,
-31422,
-31261,
-31223,
-31180,
-30893,
-30477,
-30217,
-30341,
-30735,
-31015,
-30993,
-30790,
-30669,
-30717,
-30743,
-30668,
-30564,
-30585,
-30672,
-30560,
-30200,
-29880,
-29973,
-30504,
-31015,
-31087,
-30746,
-30432,
-30453,
-30657,
-30676,
-30369,
-30067,
-30113,
-30537,
-31020,
-31238,
-31258,
-31304,
-31573,
-31902,
-32077,
-31979,
-31700,
-31492,
-31440,
-31580,
-31796,
-31972,
-32025,
-31926,
-31770,
-31637,
-31592,
-31597,
-31579,
-31551,
-31532,
-31546,
-31535,
-31543,
-31680,
-32116,
-32714,
-33184,
-33194,
-32848,
-32512,
-32500,
-32733,
-32901,
-32833,
-32715,
-32784,
-33057,
-33325,
-33447,
-33557,
-33803,
-34082,
-34111,
-33764,
-33299,
-33121,
-33327,
-33631,
-33642,
-33257,
-32731,
-32466,
-32622,
-33122,
-33642,
-33857,
-33673,
-33231,
-32846,
-32728,
-32777,
-32819,
-32661,
-32406,
-32164,
-32029,
-31991,
-32015,
-32051,
-32031,
-31800,
-31451,
-31149,
-31148,
-31427,
-31719,
-31801,
-31714,
-31684,
-31891,
-32224,
-32443,
-32409,
-32116,
-31720,
-31331,
-31115,
-31124,
-31274,
-31395,
-31322,
-31146,
-31102,
-31283,
-31627,
-31863,
-31942,
-31887,
-31815,
-31644,
-31340,
-30964,
-30731,
-30756,
-30923,
-30999,
-30937,
-30917,
-31197,
-31744,
-32274,
-32466,
-32332,
-32137,
-32179,
-32439,
-32646,
-32608,
-32372,
-32241,
-32388,
-32705,
-32952,
-33017,
-32996,
-32968,
-32879,
-32562,
-32164,
-31981,
-32292,
-32910,
-33374,
-33416,
-33197,
-33143,
-33395,
-33719,
-33819,
-33696,
-33585,
-33606,
-33577,
-33329,
-32957,
-32846,
-33198,
-33844,
-34342,
-34473,
-34309,
-34152,
-34140,
-34269,
-34437,
-34593,
-34704,
-34673,
-34493,
-34204,
-33992,
-33995,
-34172,
-34428,
-34637,
-34801,
-34950,
-35097,
-35215,
-35238,
-35200,
-35053,
-34872,
-34636,
-34448,
-34362,
-34382,
-34360,
-34180,
-33764,
-33363,
-33200,
-33393,
-33709,
-33848,
-33650,
-33335,
-33220,
-33414,
-33750,
-33906,
-33835,
-33622,
-33470,
-33358,
-33227,
-33081,
-33045,
-33192,
-33385,
-33417,
-33203,
-32916,
-32772,
-32831,
-32947,
-32974,
-32882,
-32767,
-32665,
-32562,
-32432,
-32325,
-32288,
-32317,
-32361,
-32385,
-32461,
-32579,
-32685,
-32692,
-32595,
-32573,
-32710,
-32943,
-33035,
-32822,
-32388,
-32031,
-31997,
-32273,
-32627,
-32749,
-32565,
-32229,
-32054,
-32181,
-32541,
-32784,
-32758,
-32481,
-32288,
-32370,
-32657,
-32887,
-32839,
-32650,
-32546,
-32693,
-32930,
-33057,
-33002,
-32946,
-33045,
-33237,
-33276,
-33045,
-32680,
-32527,
-32666,
-32991,
-33153,
-33151,
-33160,
-33408,
-33845,
-34141,
-34072,
-33760,
-33518,
-33597,
-33858,
-34033,
-33971,
-33844,
-33880,
-34146,
-34440,
-34556,
-34464,
-34361,
-34398,
-34574,
-34762,
-34861,
-34932,
-35025,
-35156,
-35148,
-34981,
-34661,
-34427,
-34401,
-34530,
-34647,
-34572,
-34325,
-34058,
-33937,
-34009,
-34210,
-34433,
-34638,
-34836,
-35058,
-35290,
-35464,
-35540,
-35445,
-35204,
-34843,
-34454,
-34192,
-34108,
-34204,
-34336,
-34488,
-34658,
-34980,
-35367,
-35671,
-35723,
-35553,
-35319,
-35188,
-35100,
-35015,
-34862,
-34683,
-34497,
-34293,
-34177,
-34326,
-34792,
-35329,
-35535,
-35278,
-34879,
-34809,
-35165,
-35578,
-35636,
-35301,
-34920,
-34738,
-34713,
-34657,
-34498,
-34361,
-34238,
-34051,
-33719,
-33426,
-33358,
-33552,
-33774,
-33858,
-33814,
-33804,
-33849,
-33886,
-33857,
-33803,
-33732,
-33510,
-33023,
-32433,
-32049,
-32121,
-32441,
-32706,
-32667,
-32496,
-32398,
-32430,
-32479,
-32395,
-32246,
-32139,
-32109,
-32060,
-31870,
-31595,
-31414,
-31561,
-32003,
-32497,
-32696,
-32479,
-32111,
-31971,
-32197,
-32575,
-32718,
-32572,
-32338,
-32259,
-32287,
-32187,
-31896,
-31582,
-31467,
-31514,
-31521,
-31395,
-31252,
-31226,
-31292,
-31275,
-31212,
-31257,
-31563,
-31939,
-32109,
-31959,
-31715,
-31633,
-31675,
-31572,
-31152,
-30620,
-30289,
-30373,
-30673,
-30974,
-31119,
-31185,
-31236,
-31260,
-31232,
-31168,
-31083,
-31008,
-30869,
-30722,
-30690,
-30807,
-31015,
-31127,
-31129,
-31163,
-31365,
-31608,
-31631,
-31341,
-30994,
-30998,
-31382,
-31774,
-31689,
-31143,
-30578,
-30497,
-30857,
-31213,
-31116,
-30650,
-30175,
-30017,
-30099,
-30173,
-30159,
-30187,
-30407,
-30700,
-30910,
-30921,
-30955,
-31114,
-31373,
-31462,
-31314,
-31070,
-31053,
-31273,
-31479,
-31399,
-31031,
-30755,
-30860,
-31336,
-31826,
-32027,
-31907,
-31715,
-31736,
-31997,
-32387,
-32625,
-32642,
-32388,
-32030,
-31765,
-31762,
-32067,
-32496,
-32761,
-32706,
-32445,
-32314,
-32552,
-33051,
-33464,
-33523,
-33302,
-33119,
-33209,
-33439,
-33564,
-33395,
-33078,
-32816,
-32711,
-32700,
-32723,
-32793,
-32909,
-32982,
-32856,
-32604,
-32432,
-32602,
-33066,
-33515,
-33652,
-33376,
-32948,
-32610,
-32576,
-32801,
-33152,
-33356,
-33274,
-32924,
-32610,
-32629,
-33031,
-33528,
-33765,
-33645,
-33413,
-33312,
-33413,
-33501,
-33482,
-33370,
-33297,
-33233,
-33136,
-33003,
-33021,
-33268,
-33616,
-33814,
-33768,
-33675,
-33751,
-34016,
-34227,
-34209,
-34014,
-33830,
-33807,
-33863,
-33982,
-34108,
-34270,
-34350,
-34221,
-33899,
-33577,
-33501,
-33628,
-33786,
-33736,
-33532,
-33367,
-33405,
-33597,
-33799,
-33896,
-33938,
-33982,
-34009,
-33880,
-33572,
-33176,
-32963,
-33070,
-33430,
-33844,
-34130,
-34283,
-34311,
-34304,
-34207,
-34144,
-34134,
-34175,
-34112,
-33819,
-33428,
-33179,
-33204,
-33376,
-33425,
-33373,
-33388,
-33652,
-33942,
-33914,
-33455,
-32859,
-32552,
-32617,
-32798,
-32768,
-32509,
-32199,
-31971,
-31808,
-31601,
-31416,
-31353,
-31458,
-31600,
-31649,
-31557,
-31449,
-31438,
-31539,
-31699,
-31818,
-31871,
-31878,
-31836,
-31788,
-31664,
-31551,
-31474,
-31548,
-31708,
-31839,
-31794,
-31580,
-31312,
-31106,
-30953,
-30784,
-30610,
-30526,
-30611,
-30811,
-30946,
-30893,
-30687,
-30495,
-30497,
-30770,
-31192,
-31533,
-31541,
-31198,
-30770,
-30625,
-30930,
-31431,
-31731,
-31583,
-31156,
-30823,
-30783,
-31004,
-31229,
-31332,
-31284,
-31135,
-30968,
-30787,
-30699,
-30678,
-30710,
-30708,
-30679,
-30692,
-30799,
-30941,
-30940,
-30742,
-30408,
-30183,
-30254,
-30561,
-30909,
-31020,
-30846,
-30565,
-30441,
-30615,
-30924,
-31098,
-30933,
-30514,
-30167,
-30104,
-30363,
-30690,
-30910,
-30998,
-31061,
-31178,
-31194,
-31016,
-30653,
-30386,
-30412,
-30708,
-30965,
-30928,
-30634,
-30304,
-30224,
-30367,
-30627,
-30794,
-30856,
-30851,
-30891,
-31023,
-31191,
-31227,
-31036,
-30697,
-30508,
-30751,
-31307,
-31803,
-31818,
-31405,
-30950,
-30856,
-31133,
-31489,
-31629,
-31505,
-31294,
-31137,
-31200,
-31484,
-31985,
-32484,
-32748,
-32639,
-32335,
-32092,
-32111,
-32242,
-32291,
-32143,
-31928,
-31853,
-32000,
-32329,
-32621,
-32811,
-32831,
-32833,
-32912,
-33105,
-33336,
-33495,
-33552,
-33510,
-33420,
-33264,
-33126,
-33102,
-33266,
-33492,
-33575,
-33428,
-33235,
-33256,
-33572,
-33979,
-34249,
-34326,
-34315,
-34273,
-34134,
-33899,
-33696,
-33717,
-33895,
-33977,
-33752,
-33362,
-33137,
-33286,
-33617,
-33794,
-33681,
-33488,
-33508,
-33822,
-34193,
-34361,
-34239,
-33990,
-33810,
-33761,
-33813,
-33800,
-33755,
-33624,
-33540,
-33569,
-33782,
-34190,
-34596,
-34854,
-34818,
-34605,
-34422,
-34383,
-34464,
-34492,
-34446,
-34373,
-34360,
-34355,
-34247,
-34061,
-33980,
-34137,
-34487,
-34716,
-34667,
-34404,
-34267,
-34379,
-34683,
-34849,
-34764,
-34484,
-34169,
-33930,
-33751,
-33672,
-33731,
-33868,
-33960,
-33834,
-33630,
-33554,
-33768,
-34078,
-34189,
-34019,
-33812,
-33907,
-34272,
-34593,
-34499,
-34022,
-33490,
-33215,
-33227,
-33294,
-33233,
-33061,
-32941,
-32963,
-33077,
-33109,
-33037,
-32899,
-32888,
-33000,
-33142,
-33085,
-32804,
-32419,
-32195,
-32158,
-32206,
-32139,
-31943,
-31806,
-31840,
-32021,
-32189,
-32192,
-32084,
-31925,
-31795,
-31701,
-31668,
-31695,
-31754,
-31738,
-31589,
-31349,
-31138,
-31041,
-31024,
-31065,
-31127,
-31252,
-31413,
-31547,
-31648,
-31756,
-31951,
-32168,
-32249,
-32080,
-31736,
-31412,
-31288,
-31302,
-31318,
-31195,
-30997,
-30833,
-30818,
-30879,
-30978,
-31054,
-31192,
-31393,
-31573,
-31539,
-31293,
-30954,
-30792,
-30860,
-31029,
-31113,
-31094,
-31132,
-31294,
-31537,
-31654,
-31668,
-31686,
-31827,
-32003,
-32026,
-31841,
-31591,
-31440,
-31427,
-31467,
-31510,
-31583,
-31639,
-31595,
-31349,
-31092,
-31071,
-31409,
-31905,
-32181,
-32147,
-31963,
-31962,
-32228,
-32576,
-32770,
-32711,
-32584,
-32559,
-32760,
-33038,
-33251,
-33266,
-33209,
-33188,
-33335,
-33467,
-33496,
-33346,
-33234,
-33287,
-33476,
-33606,
-33565,
-33444,
-33398,
-33438,
-33476,
-33409,
-33273,
-33176,
-33108,
-33119,
-33242,
-33573,
-34049,
-34427,
-34526,
-34380,
-34283,
-34353,
-34519,
-34520,
-34378,
-34265,
-34382,
-34612,
-34718,
-34571,
-34226,
-33927,
-33692,
-33559,
-33508,
-33539,
-33641,
-33692,
-33667,
-33691,
-33900,
-34286,
-34601,
-34628,
-34366,
-34053,
-33862,
-33837,
-33769,
-33591,
-33316,
-33121,
-33130,
-33347,
-33667,
-33928,
-34072,
-34042,
-33937,
-33779,
-33614,
-33463,
-33290,
-33079,
-32795,
-32467,
-32229,
-32151,
-32232,
-32288,
-32210,
-32072,
-32036,
-32222,
-32453,
-32591,
-32544,
-32511,
-32504,
-32483,
-32247,
-31917,
-31708,
-31803,
-32034,
-32085,
-31854,
-31469,
-31207,
-31130,
-31219,
-31441,
-31789,
-32169,
-32296,
-32118,
-31800,
-31755,
-32070,
-32429,
-32423,
-31971,
-31436,
-31180,
-31221,
-31279,
-31159,
-30949,
-30867,
-31016,
-31252,
-31461,
-31564,
-31604,
-31602,
-31558,
-31541,
-31596,
-31732,
-31853,
-31823,
-31682,
-31534,
-31557,
-31796,
-32185,
-32574,
-32816,
-32839,
-32721,
-32616,
-32699,
-32892,
-33010,
-32856,
-32433,
-32055,
-31881,
-32008,
-32201,
-32349,
-32421,
-32550,
-32746,
-32939,
-32993,
-32920,
-32803,
-32831,
-33027,
-33359,
-33665,
-33838,
-33856,
-33835,
-33856,
-33980,
-33994,
-33870,
-33568,
-33336,
-33328,
-33453,
-33497,
-33287,
-32947,
-32773,
-32925,
-33280,
-33571,
-33609,
-33422,
-33164,
-32925,
-32812,
-32843,
-33000,
-33174,
-33138,
-32925,
-32632,
-32567,
-32738,
-33007,
-33135,
-33148,
-33171,
-33316,
-33432,
-33364,
-33076,
-32796,
-32735,
-32884,
-33083,
-33120,
-32988,
-32722,
-32440,
-32191,
-32044,
-32025,
-32037,
-31934,
-31610,
-31197,
-30902,
-30923,
-31196,
-31532,
-31729,
-31736,
-31608,
-31444,
-31293,
-31149,
-31009,
-30869,
-30832,
-30929,
-31167,
-31406,
-31544,
-31613,
-31739,
-32073,
-32459,
-32736,
-32688,
-32420,
-32137,
-32012,
-32084,
-32191,
-32281,
-32276,
-32260,
-32279,
-32377,
-32541,
-32704,
-32822,
-32873,
-32908,
-32955,
-33038,
-33103,
-33143,
-33049,
-32876,
-32631,
-32547,
-32705,
-32999,
-33143,
-32937,
-32566,
-32467,
-32793,
-33321,
-33531,
-33357,
-33101,
-33202,
-33614,
-33958,
-33948,
-33691,
-33523,
-33503,
-33497,
-33314,
-33134,
-33110,
-33274,
-33370,
-33215,
-32956,
-32804,
-32877,
-33004,
-33047,
-32979,
-32934,
-32927,
-32905,
-32792,
-32663,
-32552,
-32530,
-32455,
-32333,
-32132,
-31938,
-31808,
-31760,
-31854,
-32046,
-32286,
-32429,
-32437,
-32303,
-32163,
-32053,
-31995,
-31940,
-31848,
-31752,
-31697,
-31685,
-31728,
-31740,
-31728,
-31762,
-31872,
-32071,
-32183,
-32089,
-31855,
-31728,
-31934,
-32458,
-32954,
-33164,
-32984,
-32684,
-32450,
-32387,
-32353,
-32251,
-32073,
-31902,
-31813,
-31845,
-32005,
-32278,
-32614,
-32897,
-33087,
-33202,
-33342,
-33548,
-33722,
-33679,
-33377,
-32965,
-32724,
-32902,
-33336,
-33763,
-33870,
-33704,
-33558,
-33640,
-33889,
-34000,
-33795,
-33442,
-33260,
-33382,
-33620,
-33695,
-33520,
-33312,
-33221,
-33216,
-33121,
-32828,
-32498,
-32293,
-32263,
-32327,
-32387,
-32474,
-32651,
-32870,
-33019,
-32985,
-32796,
-32558,
-32383,
-32263,
-32155,
-32009,
-31812,
-31650,
-31554,
-31626,
-31774,
-32003,
-32179,
-32361,
-32524,
-32687,
-32724,
-32652,
-32479,
-32435,
-32512,
-32678,
-32739,
-32709,
-32724,
-32928,
-33257,
-33515,
-33569,
-33524,
-33554,
-33717,
-33876,
-33861,
-33692,
-33529,
-33483,
-33597,
-33721,
-33845,
-33907,
-33902,
-33814,
-33686,
-33602,
-33663,
-33783,
-33908,
-33973,
-34027,
-34099,
-34137,
-34098,
-33977,
-33899,
-33881,
-33878,
-33809,
-33682,
-33615,
-33631,
-33656,
-33610,
-33489,
-33451,
-33474,
-33497,
-33349,
-33135,
-33012,
-33111,
-33294,
-33341,
-33135,
-32831,
-32617,
-32575,
-32554,
-32430,
-32203,
-32048,
-32112,
-32372,
-32623,
-32719,
-32631,
-32525,
-32582,
-32797,
-33056,
-33179,
-33151,
-33039,
-32963,
-32920,
-32902,
-32915,
-33001,
-33128,
-33170,
-32984,
-32665,
-32453,
-32497,
-32760,
-32912,
-32894,
-32791,
-32921,
-33287,
-33703,
-33907,
-33876,
-33782,
-33755,
-33721,
-33606,
-33432,
-33390,
-33497,
-33682,
-33759,
-33818,
-34026,
-34390,
-34731,
-34738,
-34457,
-34105,
-33948,
-33931,
-33873,
-33706,
-33545,
-33551,
-33635,
-33639,
-33502,
-33423,
-33552,
-33821,
-33973,
-33821,
-33536,
-33367,
-33427,
-33568,
-33543,
-33286,
-32945,
-32673,
-32550,
-32488,
-32451,
-32394,
-32396,
-32425,
-32518,
-32650,
-32813,
-32967,
-32995,
-32862,
-32609,
-32419,
-32396,
-32512,
-32578,
-32477,
-32270,
-32156,
-32219,
-32374,
-32455,
-32452,
-32516,
-32751,
-33080,
-33289,
-33309,
-33245,
-33243,
-33292,
-33241,
-33119,
-33074,
-33341,
-33776,
-34106,
-34050,
-33781,
-33561,
-33630,
-33823,
-33927,
-33920,
-33965,
-34225,
-34544,
-34671,
-34453,
-34081,
-33821,
-33753,
-33727,
-33542,
-33229,
-33001,
-33010,
-33207,
-33396,
-33474,
-33445,
-33368,
-33265,
-33107,
-33018,
-33068,
-33239,
-33333,
-33171,
-32808,
-32523,
-32470,
-32566,
-32568,
-32391,
-32203,
-32208,
-32395,
-32570,
-32553,
-32451,
-32379,
-32472,
-32590,
-32623,
-32527,
-32378,
-32220,
-32099,
-31999,
-31980,
-32041,
-32136,
-32172,
-32088,
-31988,
-31971,
-32086,
-32263,
-32358,
-32335,
-32230,
-32139,
-32090,
-32072,
-32037,
-31982,
-31922,
-31818,
-31665,
-31457,
-31329,
-31402,
-31722,
-32170,
-32566,
-32763,
-32794,
-32699,
-32619,
-32580,
-32598,
-32669,
-32686,
-32612,
-32417,
-32208,
-32125,
-32265,
-32549,
-32827,
-32938,
-32885,
-32779,
-32740,
-32782,
-32842,
-32821,
-32754,
-32722,
-32796,
-32917,
-32995,
-32953,
-32901,
-32914,
-33067,
-33218,
-33257,
-33143,
-32958,
-32843,
-32862,
-32954,
-33067,
-33096,
-33034,
-32898,
-32705,
-32499,
-32297,
-32108,
-31925,
-31750,
-31579,
-31464,
-31470,
-31607,
-31838,
-31990,
-31982,
-31806,
-31605,
-31478,
-31433,
-31332,
-31126,
-30870,
-30713,
-30751,
-30907,
-31099,
-31234,
-31323,
-31375,
-31357,
-31239,
-31089,
-30923,
-30855,
-30831,
-30820,
-30777,
-30685,
-30552,
-30440,
-30386,
-30425,
-30516,
-30527,
-30452,
-30341,
-30335,
-30450,
-30612,
-30680,
-30672,
-30667,
-30700,
-30727,
-30632,
-30458,
-30309,
-30277,
-30326,
-30367,
-30420,
-30517,
-30734,
-30929,
-31085,
-31160,
-31280,
-31425,
-31511,
-31410,
-31181,
-31020,
-31054,
-31316,
-31583,
-31754,
-31742,
-31618,
-31460,
-31358,
-31349,
-31469,
-31637,
-31826,
-31943,
-32038,
-32068,
-32088,
-32091,
-32077,
-32084,
-32046,
-32030,
-32025,
-32119,
-32281,
-32435,
-32519,
-32565,
-32663,
-32888,
-33163,
-33423,
-33558,
-33643,
-33577,
-33417,
-33108,
-32813,
-32700,
-32823,
-33056,
-33212,
-33145,
-32978,
-32821,
-32798,
-32860,
-32916,
-32920,
-32895,
-32934,
-33081,
-33310,
-33471,
-33501,
-33316,
-33113,
-32905,
-32798,
-32628,
-32439,
-32250,
-32267,
-32493,
-32772,
-32942,
-32917,
-32867,
-32927,
-33079,
-33171,
-33066,
-32810,
-32578,
-32404,
-32303,
-32139,
-31995,
-31948,
-32060,
-32249,
-32391,
-32488,
-32572,
-32657,
-32620,
-32365,
-31989,
-31692,
-31652,
-31749,
-31774,
-31610,
-31360,
-31237,
-31206,
-31181,
-30972,
-30745,
-30665,
-30851,
-31153,
-31344,
-31374,
-31363,
-31450,
-31630,
-31756,
-31715,
-31508,
-31216,
-30911,
-30672,
-30542,
-30563,
-30728,
-30929,
-31089,
-31167,
-31205,
-31285,
-31449,
-31657,
-31833,
-31857,
-31674,
-31377,
-31096,
-30985,
-31044,
-31158,
-31247,
-31262,
-31297,
-31327,
-31301,
-31171,
-30984,
-31002,
-31273,
-31774,
-32158,
-32176,
-31877,
-31510,
-31429,
-31690,
-32062,
-32235,
-32080,
-31730,
-31424,
-31328,
-31428,
-31707,
-32114,
-32609,
-33036,
-33217,
-33155,
-33001,
-33003,
-33193,
-33430,
-33502,
-33408,
-33196,
-33029,
-32867,
-32777,
-32779,
-32969,
-33283,
-33528,
-33574,
-33413,
-33229,
-33134,
-33107,
-33025,
-32841,
-32649,
-32642,
-32859,
-33228,
-33495,
-33571,
-33485,
-33470,
-33670,
-34040,
-34378,
-34460,
-34300,
-34015,
-33822,
-33763,
-33831,
-33956,
-34083,
-34125,
-34017,
-33761,
-33531,
-33470,
-33607,
-33765,
-33791,
-33694,
-33678,
-33824,
-34082,
-34230,
-34179,
-34026,
-33932,
-33947,
-33987,
-33890,
-33639,
-33353,
-33161,
-33239,
-33478,
-33792,
-33979,
-34019,
-33984,
-34000,
-34045,
-34049,
-33931,
-33808,
-33817,
-34011,
-34239,
-34301,
-34173,
-34007,
-33980,
-34149,
-34380,
-34561,
-34618,
-34571,
-34455,
-34329,
-34272,
-34291,
-34361,
-34327,
-34149,
-33862,
-33596,
-33414,
-33289,
-33160,
-33018,
-32934,
-32908,
-32957,
-32993,
-33047,
-33079,
-33108,
-33050,
-32896,
-32639,
-32344,
-32069,
-31881,
-31825,
-31872,
-31994,
-32102,
-32180,
-32247,
-32281,
-32282,
-32223,
-32164,
-32184,
-32289,
-32351,
-32289,
-32138,
-32046,
-32108,
-32211,
-32197,
-32057,
-31936,
-32003,
-32155,
-32201,
-31979,
-31644,
-31432,
-31505,
-31777,
-32025,
-32124,
-32040,
-31825,
-31585,
-31331,
-31155,
-31010,
-30892,
-30791,
-30709,
-30739,
-30840,
-31010,
-31160,
-31311,
-31377,
-31383,
-31260,
-31097,
-30988,
-30956,
-30969,
-30901,
-30798,
-30735,
-30800,
-30949,
-31063,
-31122,
-31167,
-31247,
-31273,
-31162,
-30898,
-30705,
-30728,
-31016,
-31340,
-31523,
-31484,
-31356,
-31231,
-31184,
-31113,
-31012,
-30879,
-30819,
-30871,
-31076,
-31321,
-31525,
-31557,
-31396,
-31131,
-30895,
-30782,
-30776,
-30734,
-30582,
-30311,
-30087,
-30058,
-30271,
-30621,
-30916,
-31051,
-31031,
-30976,
-30966,
-31034,
-31112,
-31147,
-31137,
-31130,
-31200,
-31358,
-31517,
-31540,
-31394,
-31113,
-30933,
-30913,
-31081,
-31268,
-31394,
-31480,
-31621,
-31821,
-32025,
-32114,
-32113,
-32136,
-32225,
-32382,
-32424,
-32297,
-32048,
-31854,
-31888,
-32157,
-32580,
-32935,
-33184,
-33264,
-33273,
-33250,
-33209,
-33179,
-33140,
-33135,
-33140,
-33175,
-33199,
-33256,
-33295,
-33326,
-33304,
-33267,
-33248,
-33300,
-33381,
-33451,
-33487,
-33538,
-33666,
-33891,
-34122,
-34278,
-34257,
-34123,
-33909,
-33720,
-33565,
-33438,
-33341,
-33251,
-33243,
-33307,
-33497,
-33767,
-34043,
-34249,
-34314,
-34250,
-34109,
-33965,
-33845,
-33763,
-33700,
-33669,
-33703,
-33824,
-34013,
-34199,
-34336,
-34379,
-34390,
-34391,
-34381,
-34337,
-34244,
-34119,
-34083,
-34086,
-34163,
-34185,
-34158,
-34097,
-34030,
-33996,
-33935,
-33862,
-33752,
-33672,
-33671,
-33825,
-34118,
-34484,
-34746,
-34812,
-34685,
-34520,
-34430,
-34412,
-34394,
-34293,
-34172,
-34083,
-34008,
-33930,
-33818,
-33803,
-33950,
-34218,
-34430,
-34511,
-34486,
-34490,
-34544,
-34524,
-34394,
-34185,
-34096,
-34161,
-34324,
-34424,
-34481,
-34524,
-34641,
-34746,
-34786,
-34760,
-34777,
-34859,
-34977,
-35012,
-34995,
-34950,
-34928,
-34887,
-34788,
-34666,
-34558,
-34443,
-34263,
-34018,
-33822,
-33815,
-34016,
-34259,
-34439,
-34469,
-34473,
-34464,
-34473,
-34427,
-34330,
-34160,
-33910,
-33586,
-33308,
-33196,
-33313,
-33544,
-33695,
-33737,
-33707,
-33735,
-33783,
-33763,
-33647,
-33516,
-33490,
-33565,
-33641,
-33593,
-33425,
-33199,
-33022,
-32892,
-32835,
-32813,
-32825,
-32837,
-32828,
-32749,
-32665,
-32568,
-32531,
-32545,
-32602,
-32623,
-32568,
-32368,
-32108,
-31838,
-31677,
-31612,
-31627,
-31682,
-31772,
-31915,
-32077,
-32216,
-32251,
-32224,
-32141,
-32081,
-31993,
-31875,
-31717,
-31608,
-31570,
-31605,
-31620,
-31608,
-31639,
-31782,
-32027,
-32208,
-32203,
-32016,
-31787,
-31705,
-31740,
-31860,
-31894,
-31859,
-31752,
-31646,
-31605,
-31609,
-31682,
-31699,
-31667,
-31562,
-31511,
-31549,
-31658,
-31738,
-31732,
-31647,
-31593,
-31564,
-31587,
-31555,
-31468,
-31334,
-31185,
-31107,
-31073,
-31128,
-31213,
-31360,
-31557,
-31790,
-31991,
-32076,
-32007,
-31857,
-31722,
-31631,
-31614,
-31585,
-31597,
-31578,
-31532,
-31389,
-31256,
-31250,
-31448,
-31720,
-31814,
-31627,
-31305,
-31110,
-31174,
-31340,
-31399,
-31271,
-31139,
-31119,
-31256,
-31346,
-31332,
-31225,
-31200,
-31286,
-31479,
-31688,
-31865,
-31977,
-31981,
-31856,
-31744,
-31720,
-31849,
-31933,
-31809,
-31493,
-31163,
-31027,
-31029,
-31037,
-30964,
-30995,
-31249,
-31744,
-32185,
-32386,
-32318,
-32170,
-32074,
-32038,
-32012,
-31957,
-31927,
-31934,
-31964,
-32005,
-32078,
-32229,
-32453,
-32698,
-32870,
-32941,
-32894,
-32777,
-32666,
-32606,
-32641,
-32757,
-32866,
-32964,
-32988,
-32991,
-32990,
-33047,
-33146,
-33290,
-33356,
-33357,
-33275,
-33274,
-33391,
-33635,
-33852,
-33911,
-33745,
-33409,
-33046,
-32824,
-32861,
-33090,
-33348,
-33381,
-33225,
-33024,
-33049,
-33326,
-33644,
-33783,
-33656,
-33466,
-33341,
-33322,
-33298,
-33177,
-33046,
-33000,
-33067,
-33225,
-33368,
-33474,
-33571,
-33608,
-33640,
-33632,
-33626,
-33604,
-33565,
-33499,
-33512,
-33584,
-33715,
-33746,
-33688,
-33574,
-33569,
-33674,
-33823,
-33894,
-33844,
-33706,
-33560,
-33447,
-33432,
-33497,
-33611,
-33633,
-33541,
-33359,
-33253,
-33266,
-33380,
-33488,
-33579,
-33684,
-33819,
-33932,
-33972,
-33938,
-33891,
-33875,
-33829,
-33800,
-33740,
-33740,
-33721,
-33643,
-33493,
-33384,
-33378,
-33495,
-33558,
-33528,
-33393,
-33301,
-33295,
-33360,
-33415,
-33419,
-33387,
-33332,
-33300,
-33268,
-33286,
-33241,
-33181,
-33013,
-32866,
-32714,
-32636,
-32584,
-32597,
-32685,
-32801,
-32858,
-32781,
-32575,
-32387,
-32286,
-32267,
-32251,
-32170,
-32063,
-31988,
-31966,
-31989,
-32015,
-32045,
-32037,
-31960,
-31800,
-31613,
-31474,
-31424,
-31433,
-31487,
-31579,
-31717,
-31836,
-31880,
-31792,
-31657,
-31486,
-31322,
-31133,
-30936,
-30847,
-30890,
-31035,
-31207,
-31320,
-31470,
-31589,
-31682,
-31564,
-31334,
-31070,
-30940,
-30950,
-30962,
-30980,
-31008,
-31200,
-31496,
-31776,
-31884,
-31804,
-31701,
-31659,
-31767,
-31882,
-31943,
-31878,
-31709,
-31527,
-31370,
-31299,
-31309,
-31335,
-31347,
-31279,
-31169,
-31096,
-31098,
-31175,
-31235,
-31214,
-31167,
-31214,
-31418,
-31716,
-31907,
-31879,
-31664,
-31482,
-31439,
-31619,
-31875,
-32164,
-32388,
-32569,
-32685,
-32770,
-32885,
-33029,
-33208,
-33279,
-33260,
-33105,
-32953,
-32827,
-32770,
-32750,
-32757,
-32736,
-32696,
-32647,
-32656,
-32788,
-32979,
-33152,
-33221,
-33219,
-33259,
-33366,
-33513,
-33598,
-33626,
-33590,
-33546,
-33441,
-33329,
-33261,
-33324,
-33482,
-33639,
-33715,
-33725,
-33772,
-33842,
-33911,
-33889,
-33797,
-33679,
-33592,
-33520,
-33484,
-33492,
-33512,
-33522,
-33469,
-33420,
-33454,
-33578,
-33685,
-33693,
-33619,
-33630,
-33759,
-33969,
-34045,
-33971,
-33817,
-33709,
-33693,
-33676,
-33627,
-33572,
-33520,
-33504,
-33425,
-33342,
-33304,
-33381,
-33565,
-33718,
-33784,
-33687,
-33486,
-33216,
-32982,
-32846,
-32813,
-32841,
-32781,
-32677,
-32515,
-32437,
-32393,
-32397,
-32358,
-32382,
-32409,
-32453,
-32420,
-32326,
-32263,
-32238,
-32226,
-32121,
-31934,
-31827,
-31844,
-31977,
-32074,
-32062,
-32023,
-31974,
-31956,
-31881,
-31823,
-31838,
-31981,
-32102,
-32111,
-31984,
-31867,
-31841,
-31844,
-31784,
-31639,
-31541,
-31534,
-31612,
-31644,
-31659,
-31683,
-31754,
-31795,
-31753,
-31682,
-31693,
-31828,
-31987,
-32071,
-32026,
-31948,
-31896,
-31903,
-31963,
-32066,
-32218,
-32373,
-32468,
-32473,
-32428,
-32425,
-32530,
-32716,
-32911,
-33014,
-33025,
-33018,
-33079,
-33250,
-33410,
-33465,
-33333,
-33142,
-32986,
-32947,
-32964,
-32989,
-32995,
-33008,
-33035,
-33056,
-33084,
-33166,
-33318,
-33507,
-33641,
-33664,
-33636,
-33613,
-33644,
-33677,
-33678,
-33627,
-33582,
-33555,
-33565,
-33576,
-33599,
-33647,
-33729,
-33809,
-33831,
-33768,
-33683,
-33656,
-33682,
-33698,
-33598,
-33394,
-33218,
-33147,
-33183,
-33187,
-33085,
-32931,
-32859,
-32916,
-33048,
-33141,
-33143,
-33147,
-33171,
-33224,
-33203,
-33097,
-32932,
-32797,
-32688,
-32552,
-32361,
-32149,
-32005,
-32016,
-32112,
-32235,
-32290,
-32303,
-32302,
-32311,
-32279,
-32151,
-31926,
-31656,
-31432,
-31310,
-31310,
-31395,
-31523,
-31620,
-31684,
-31694,
-31714,
-31739,
-31756,
-31733,
-31654,
-31562,
-31490,
-31469,
-31491,
-31532,
-31563,
-31582,
-31536,
-31468,
-31398,
-31336,
-31341,
-31327,
-31356,
-31405,
-31550,
-31751,
-31915,
-31973,
-31892,
-31765,
-31648,
-31547,
-31437,
-31303,
-31250,
-31320,
-31546,
-31812,
-32022,
-32139,
-32260,
-32410,
-32666,
-32875,
-33017,
-33029,
-32971,
-32895,
-32823,
-32776,
-32791,
-32861,
-32963,
-32985,
-32884,
-32697,
-32564,
-32553,
-32647,
-32744,
-32812,
-32871,
-32983,
-33073,
-33090,
-32990,
-32864,
-32813,
-32807,
-32799,
-32688,
-32547,
-32434,
-32405,
-32378,
-32362,
-32320,
-32347,
-32390,
-32402,
-32342,
-32207,
-32112,
-32026,
-31953,
-31805,
-31621,
-31464,
-31404,
-31424,
-31454,
-31473,
-31487,
-31602,
-31782,
-31989,
-32073,
-32060,
-31929,
-31804,
-31670,
-31523,
-31373,
-31274,
-31228,
-31221,
-31160,
-31040,
-30971,
-31015,
-31192,
-31383,
-31482,
-31534,
-31566,
-31660,
-31692,
-31644,
-31493,
-31404,
-31427,
-31572,
-31670,
-31701,
-31634,
-31657,
-31786,
-32042,
-32300,
-32485,
-32571,
-32619,
-32652,
-32699,
-32695,
-32601,
-32426,
-32189,
-32004,
-31889,
-31879,
-31912,
-31990,
-32046,
-32168,
-32290,
-32495,
-32699,
-32911,
-33103,
-33234,
-33320,
-33319,
-33272,
-33256,
-33302,
-33446,
-33571,
-33575,
-33420,
-33169,
-32968,
-32870,
-32850,
-32833,
-32816,
-32809,
-32860,
-32874,
-32829,
-32703,
-32553,
-32417,
-32250,
-32036,
-31837,
-31781,
-31908,
-32120,
-32197,
-32113,
-31910,
-31820,
-31856,
-31991,
-32117,
-32170,
-32201,
-32165,
-32089,
-31951,
-31776,
-31610,
-31425,
-31264,
-31123,
-31101,
-31203,
-31381,
-31572,
-31731,
-31888,
-32043,
-32190,
-32209,
-32134,
-31956,
-31768,
-31626,
-31548,
-31546,
-31613,
-31707,
-31793,
-31847,
-31914,
-32060,
-32263,
-32508,
-32643,
-32689,
-32657,
-32621,
-32623,
-32653,
-32674,
-32693,
-32700,
-32702,
-32704,
-32672,
-32594,
-32458,
-32343,
-32350,
-32543,
-32910,
-33252,
-33442,
-33446,
-33407,
-33447,
-33553,
-33552,
-33331,
-32951,
-32637,
-32532,
-32634,
-32759,
-32817,
-32823,
-32919,
-33142,
-33432,
-33636,
-33711,
-33670,
-33617,
-33565,
-33507,
-33400,
-33273,
-33110,
-32972,
-32806,
-32668,
-32564,
-32518,
-32508,
-32471,
-32409,
-32329,
-32319,
-32369,
-32440,
-32488,
-32466,
-32441,
-32403,
-32357,
-32260,
-32115,
-31977,
-31916,
-31940,
-32048,
-32165,
-32295,
-32363,
-32363,
-32245,
-32082,
-31939,
-31891,
-31898,
-31864,
-31731,
-31511,
-31324,
-31225,
-31240,
-31354,
-31565,
-31834,
-32115,
-32254,
-32276,
-32215,
-32273,
-32439,
-32673,
-32754,
-32667,
-32495,
-32375,
-32380,
-32421,
-32436,
-32428,
-32470,
-32595,
-32766,
-32915,
-33018,
-33116,
-33183,
-33203,
-33112,
-32976,
-32910,
-32958,
-33092,
-33156,
-33141,
-33073,
-33073,
-33157,
-33243,
-33286,
-33300,
-33383,
-33567,
-33803,
-33970,
-34001,
-33927,
-33779,
-33632,
-33482,
-33360,
-33281,
-33233,
-33169,
-33097,
-33021,
-33047,
-33188,
-33416,
-33616,
-33746,
-33773,
-33771,
-33744,
-33703,
-33675,
-33685,
-33749,
-33821,
-33779,
-33595,
-33314,
-33079,
-32977,
-33023,
-33113,
-33159,
-33133,
-33023,
-32894,
-32761,
-32666,
-32581,
-32506,
-32398,
-32258,
-32139,
-32043,
-31984,
-31938,
-31872,
-31862,
-31923,
-32102,
-32338,
-32535,
-32643,
-32623,
-32515,
-32367,
-32227,
-32135,
-32106,
-32053,
-31948,
-31754,
-31542,
-31450,
-31482,
-31648,
-31809,
-31987,
-32148,
-32388,
-32610,
-32787,
-32861,
-32907,
-32958,
-32996,
-32930,
-32716,
-32505,
-32392,
-32524,
-32749,
-32975,
-33118,
-33207,
-33294,
-33356,
-33344,
-33293,
-33254,
-33311,
-33402,
-33468,
-33435,
-33335,
-33220,
-33104,
-33007,
-32934,
-32949,
-33077,
-33289,
-33494,
-33629,
-33709,
-33792,
-33916,
-34058,
-34146,
-34126,
-33998,
-33830,
-33673,
-33590,
-33517,
-33480,
-33436,
-33492,
-33630,
-33884,
-34114,
-34307,
-34385,
-34378,
-34305,
-34200,
-34150,
-34215,
-34335,
-34467,
-34407,
-34268,
-34063,
-33962,
-33946,
-33944,
-33948,
-33935,
-33937,
-33943,
-33896,
-33846,
-33825,
-33870,
-33932,
-33897,
-33758,
-33534,
-33332,
-33187,
-33108,
-33074,
-33099,
-33128,
-33133,
-33093,
-33033,
-33033,
-33090,
-33140,
-33110,
-32988,
-32843,
-32742,
-32680,
-32641,
-32563,
-32498,
-32431,
-32380,
-32352,
-32319,
-32341,
-32387,
-32452,
-32511,
-32586,
-32647,
-32715,
-32692,
-32579,
-32428,
-32298,
-32265,
-32264,
-32201,
-32062,
-31882,
-31752,
-31738,
-31784,
-31853,
-31931,
-31986,
-32072,
-32104,
-32095,
-31996,
-31847,
-31684,
-31516,
-31390,
-31294,
-31268,
-31318,
-31412,
-31513,
-31613,
-31706,
-31849,
-32014,
-32170,
-32263,
-32314,
-32341,
-32385,
-32408,
-32344,
-32189,
-31987,
-31793,
-31670,
-31608,
-31629,
-31764,
-31998,
-32292,
-32584,
-32838,
-33076,
-33273,
-33414,
-33464,
-33461,
-33461,
-33455,
-33407,
-33268,
-33066,
-32944,
-32889,
-32942,
-32989,
-33069,
-33176,
-33313,
-33402,
-33409,
-33340,
-33293,
-33254,
-33213,
-33145,
-33066,
-33050,
-33031,
-33015,
-32919,
-32835,
-32842,
-32927,
-33110,
-33317,
-33563,
-33844,
-34078,
-34249,
-34289,
-34274,
-34179,
-34015,
-33791,
-33570,
-33451,
-33398,
-33346,
-33246,
-33168,
-33248,
-33499,
-33824,
-34025,
-34045,
-33936,
-33784,
-33696,
-33656,
-33682,
-33718,
-33724,
-33649,
-33536,
-33456,
-33466,
-33545,
-33625,
-33673,
-33720,
-33819,
-33954,
-34098,
-34200,
-34281,
-34325,
-34310,
-34176,
-33939,
-33667,
-33462,
-33369,
-33396,
-33494,
-33630,
-33739,
-33789,
-33760,
-33671,
-33583,
-33476,
-33362,
-33178,
-32947,
-32717,
-32532,
-32436,
-32366,
-32306,
-32183,
-32052,
-31934,
-31894,
-31901,
-31927,
-31937,
-31944,
-31996,
-32106,
-32256,
-32426,
-32563,
-32685,
-32718,
-32664,
-32457,
-32203,
-31943,
-31822,
-31796,
-31869,
-31931,
-31964,
-31955,
-31946,
-31968,
-32029,
-32071,
-32040,
-31901,
-31715,
-31567,
-31524,
-31560,
-31584,
-31521,
-31374,
-31195,
-31072,
-31004,
-30994,
-30998,
-31024,
-31085,
-31195,
-31329,
-31443,
-31507,
-31532,
-31537,
-31510,
-31467,
-31365,
-31277,
-31209,
-31188,
-31200,
-31207,
-31196,
-31201,
-31218,
-31269,
-31363,
-31452,
-31579,
-31616,
-31606,
-31459,
-31308,
-31159,
-31116,
-31142,
-31201,
-31240,
-31228,
-31181,
-31125,
-31084,
-31062,
-31027,
-30973,
-30910,
-30882,
-30899,
-30955,
-31012,
-31041,
-31072,
-31110,
-31107,
-31101,
-31017,
-30972,
-30954,
-31012,
-31125,
-31280,
-31452,
-31625,
-31728,
-31774,
-31734,
-31694,
-31628,
-31587,
-31516,
-31457,
-31442,
-31522,
-31702,
-31919,
-32130,
-32254,
-32355,
-32449,
-32590,
-32726,
-32810,
-32779,
-32689,
-32583,
-32529,
-32474,
-32412,
-32321,
-32249,
-32243,
-32260,
-32283,
-32287,
-32307,
-32407,
-32562,
-32742,
-32881,
-32933,
-32933,
-32890,
-32870,
-32872,
-32888,
-32860,
-32791,
-32696,
-32682,
-32751,
-32927,
-33093,
-33237,
-33333,
-33386,
-33394,
-33329,
-33187,
-33039,
-32928,
-32841,
-32782,
-32673,
-32586,
-32551,
-32616,
-32721,
-32811,
-32827,
-32837,
-32876,
-32991,
-33090,
-33140,
-33127,
-33129,
-33213,
-33332,
-33441,
-33462,
-33446,
-33457,
-33488,
-33537,
-33525,
-33458,
-33361,
-33251,
-33166,
-33140,
-33176,
-33258,
-33307,
-33271,
-33161,
-33044,
-32969,
-32964,
-32978,
-33027,
-33103,
-33214,
-33341,
-33471,
-33616,
-33805,
-33952,
-34019,
-33882,
-33644,
-33357,
-33188,
-33132,
-33172,
-33255,
-33315,
-33351,
-33343,
-33319,
-33285,
-33302,
-33335,
-33414,
-33482,
-33551,
-33590,
-33639,
-33686,
-33737,
-33792,
-33802,
-33786,
-33726,
-33684,
-33634,
-33617,
-33573,
-33549,
-33554,
-33609,
-33695,
-33745,
-33719,
-33639,
-33551,
-33494,
-33470,
-33413,
-33319,
-33220,
-33140,
-33140,
-33188,
-33263,
-33359,
-33407,
-33452,
-33397,
-33339,
-33212,
-33088,
-32935,
-32791,
-32639,
-32512,
-32366,
-32243,
-32178,
-32229,
-32388,
-32555,
-32623,
-32587,
-32502,
-32477,
-32489,
-32505,
-32471,
-32435,
-32394,
-32377,
-32336,
-32277,
-32257,
-32243,
-32224,
-32113,
-31954,
-31804,
-31747,
-31760,
-31788,
-31796,
-31776,
-31784,
-31777,
-31784,
-31739,
-31625,
-31491,
-31304,
-31223,
-31225,
-31339,
-31495,
-31621,
-31719,
-31814,
-31888,
-31916,
-31850,
-31713,
-31592,
-31501,
-31440,
-31377,
-31301,
-31269,
-31281,
-31345,
-31407,
-31469,
-31489,
-31485,
-31471,
-31476,
-31556,
-31660,
-31742,
-31752,
-31716,
-31692,
-31691,
-31683,
-31644,
-31600,
-31613,
-31638,
-31608,
-31502,
-31372,
-31342,
-31402,
-31477,
-31488,
-31446,
-31414,
-31395,
-31365,
-31283,
-31202,
-31169,
-31159,
-31115,
-31023,
-30976,
-31036,
-31208,
-31348,
-31406,
-31374,
-31372,
-31391,
-31429,
-31415,
-31349,
-31251,
-31117,
-30946,
-30752,
-30607,
-30552,
-30586,
-30665,
-30752,
-30843,
-30972,
-31101,
-31268,
-31379,
-31472,
-31489,
-31444,
-31368,
-31251,
-31172,
-31059,
-30957,
-30835,
-30750,
-30734,
-30796,
-30895,
-30971,
-30971,
-30929,
-30878,
-30908,
-30975,
-31048,
-31001,
-30885,
-30752,
-30704,
-30788,
-30900,
-31006,
-31032,
-31057,
-31066,
-31138,
-31231,
-31342,
-31445,
-31493,
-31460,
-31382,
-31260,
-31145,
-31032,
-30910,
-30832,
-30790,
-30815,
-30857,
-30902,
-30933,
-30982,
-31035,
-31094,
-31157,
-31224,
-31336,
-31454,
-31578,
-31664,
-31709,
-31725,
-31713,
-31725,
-31787,
-31884,
-31995,
-32013,
-31989,
-31983,
-32134,
-32395,
-32673,
-32787,
-32718,
-32568,
-32456,
-32443,
-32494,
-32545,
-32585,
-32597,
-32616,
-32603,
-32595,
-32583,
-32587,
-32640,
-32721,
-32834,
-32972,
-33081,
-33185,
-33218,
-33181,
-33056,
-32865,
-32689,
-32591,
-32581,
-32619,
-32647,
-32673,
-32764,
-32925,
-33134,
-33296,
-33387,
-33429,
-33474,
-33495,
-33479,
-33389,
-33268,
-33155,
-33096,
-33098,
-33192,
-33320,
-33457,
-33473,
-33438,
-33352,
-33355,
-33448,
-33563,
-33682,
-33711,
-33707,
-33607,
-33467,
-33259,
-33102,
-33002,
-32993,
-33019,
-33050,
-33121,
-33229,
-33392,
-33578,
-33763,
-33923,
-34050,
-34089,
-34046,
-33927,
-33783,
-33638,
-33494,
-33350,
-33236,
-33206,
-33283,
-33466,
-33641,
-33817,
-33904,
-34012,
-34077,
-34169,
-34188,
-34176,
-34150,
-34125,
-34143,
-34143,
-34132,
-34096,
-34045,
-33996,
-33931,
-33896,
-33915,
-34012,
-34157,
-34250,
-34273,
-34217,
-34200,
-34205,
-34248,
-34215,
-34105,
-33933,
-33745,
-33618,
-33516,
-33524,
-33587,
-33781,
-34031,
-34309,
-34505,
-34605,
-34586,
-34547,
-34512,
-34510,
-34491,
-34415,
-34294,
-34178,
-34107,
-34061,
-33978,
-33871,
-33751,
-33721,
-33774,
-33853,
-33969,
-34048,
-34177,
-34275,
-34349,
-34357,
-34379,
-34381,
-34394,
-34306,
-34127,
-33923,
-33770,
-33714,
-33703,
-33717,
-33733,
-33788,
-33815,
-33788,
-33659,
-33501,
-33394,
-33344,
-33373,
-33361,
-33367,
-33319,
-33264,
-33167,
-33043,
-32963,
-32890,
-32858,
-32745,
-32643,
-32577,
-32664,
-32877,
-33106,
-33244,
-33198,
-33028,
-32777,
-32540,
-32322,
-32155,
-32006,
-31900,
-31831,
-31830,
-31902,
-32067,
-32272,
-32488,
-32655,
-32744,
-32731,
-32630,
-32457,
-32267,
-32110,
-32023,
-32003,
-32011,
-32036,
-32046,
-32082,
-32141,
-32209,
-32254,
-32257,
-32222,
-32173,
-32139,
-32075,
-32004,
-31903,
-31821,
-31789,
-31772,
-31785,
-31771,
-31757,
-31739,
-31744,
-31769,
-31869,
-32028,
-32253,
-32464,
-32602,
-32603,
-32507,
-32325,
-32120,
-31928,
-31771,
-31682,
-31660,
-31644,
-31643,
-31629,
-31676,
-31805,
-31985,
-32155,
-32193,
-32110,
-31922,
-31757,
-31682,
-31696,
-31750,
-31741,
-31696,
-31641,
-31646,
-31713,
-31769,
-31785,
-31761,
-31744,
-31767,
-31791,
-31789,
-31726,
-31672,
-31649,
-31709,
-31811,
-31907,
-31937,
-31873,
-31740,
-31619,
-31578,
-31674,
-31865,
-32086,
-32298,
-32446,
-32559,
-32623,
-32617,
-32571,
-32471,
-32389,
-32338,
-32335,
-32351,
-32343,
-32305,
-32256,
-32253,
-32335,
-32502,
-32686,
-32907,
-33076,
-33275,
-33422,
-33537,
-33583,
-33571,
-33534,
-33499,
-33482,
-33460,
-33432,
-33345,
-33278,
-33226,
-33248,
-33317,
-33396,
-33461,
-33502,
-33541,
-33549,
-33534,
-33453,
-33370,
-33302,
-33277,
-33286,
-33295,
-33315,
-33350,
-33409,
-33492,
-33578,
-33671,
-33751,
-33827,
-33879,
-33953,
-34035,
-34111,
-34118,
-34032,
-33863,
-33734,
-33675,
-33687,
-33693,
-33647,
-33561,
-33526,
-33555,
-33646,
-33748,
-33847,
-33941,
-34071,
-34204,
-34307,
-34365,
-34348,
-34301,
-34214,
-34092,
-33976,
-33877,
-33847,
-33854,
-33871,
-33874,
-33880,
-33884,
-33961,
-34009,
-34075,
-34067,
-33987,
-33837,
-33638,
-33441,
-33303,
-33223,
-33200,
-33180,
-33146,
-33099,
-33005,
-32915,
-32800,
-32739,
-32743,
-32833,
-32938,
-33040,
-33058,
-33033,
-32934,
-32785,
-32598,
-32374,
-32192,
-32023,
-31924,
-31821,
-31774,
-31754,
-31814,
-31924,
-32048,
-32132,
-32177,
-32165,
-32132,
-32054,
-31961,
-31842,
-31763,
-31689,
-31631,
-31558,
-31491,
-31453,
-31484,
-31537,
-31636,
-31707,
-31809,
-31899,
-31939,
-31942,
-31853,
-31768,
-31698,
-31651,
-31629,
-31598,
-31537,
-31467,
-31382,
-31327,
-31326,
-31378,
-31471,
-31588,
-31713,
-31813,
-31899,
-31883,
-31822,
-31691,
-31555,
-31406,
-31242,
-31069,
-30920,
-30828,
-30826,
-30868,
-31002,
-31155,
-31386,
-31606,
-31829,
-32005,
-32154,
-32268,
-32355,
-32407,
-32423,
-32435,
-32406,
-32401,
-32362,
-32413,
-32492,
-32648,
-32745,
-32796,
-32770,
-32787,
-32829,
-32939,
-33020,
-33051,
-33016,
-32904,
-32768,
-32625,
-32563,
-32559,
-32590,
-32576,
-32493,
-32440,
-32510,
-32723,
-33009,
-33213,
-33320,
-33344,
-33386,
-33401,
-33402,
-33282,
-33124,
-32955,
-32855,
-32834,
-32906,
-33055,
-33262,
-33468,
-33615,
-33690,
-33744,
-33819,
-33917,
-34025,
-34037,
-34017,
-33916,
-33792,
-33656,
-33490,
-33373,
-33279,
-33249,
-33206,
-33164,
-33108,
-33081,
-33092,
-33131,
-33149,
-33146,
-33103,
-33044,
-32991,
-32894,
-32770,
-32601,
-32441,
-32386,
-32466,
-32630,
-32811,
-32882,
-32889,
-32881,
-32900,
-32936,
-32907,
-32804,
-32672,
-32537,
-32461,
-32364,
-32292,
-32203,
-32133,
-32044,
-31925,
-31809,
-31743,
-31795,
-31928,
-32083,
-32191,
-32216,
-32178,
-32095,
-31999,
-31928,
-31866,
-31838,
-31791,
-31731,
-31655,
-31578,
-31527,
-31512,
-31547,
-31625,
-31731,
-31855,
-31986,
-32109,
-32197,
-32176,
-32071,
-31918,
-31834,
-31825,
-31869,
-31858,
-31815,
-31772,
-31784,
-31887,
-32020,
-32231,
-32459,
-32712,
-32900,
-32987,
-32994,
-32941,
-32870,
-32755,
-32593,
-32444,
-32342,
-32304,
-32319,
-32351,
-32446,
-32598,
-32808,
-32997,
-33154,
-33244,
-33325,
-33349,
-33339,
-33287,
-33230,
-33216,
-33221,
-33243,
-33276,
-33329,
-33384,
-33417,
-33375,
-33297,
-33227,
-33207,
-33254,
-33349,
-33441,
-33520,
-33537,
-33475,
-33378,
-33246,
-33142,
-33046,
-32945,
-32869,
-32852,
-32921,
-33075,
-33216,
-33336,
-33378,
-33381,
-33330,
-33224,
-33051,
-32814,
-32555,
-32299,
-32099,
-31989,
-31969,
-32047,
-32165,
-32292,
-32399,
-32472,
-32515,
-32540,
-32545,
-32556,
-32553,
-32552,
-32509,
-32459,
-32366,
-32270,
-32152,
-32046,
-31977,
-31954,
-31982,
-32005,
-31990,
-31939,
-31868,
-31819,
-31791,
-31782,
-31779,
-31778,
-31778,
-31716,
-31626,
-31496,
-31445,
-31511,
-31717,
-31993,
-32270,
-32487,
-32612,
-32635,
-32574,
-32459,
-32367,
-32332,
-32351,
-32389,
-32413,
-32398,
-32419,
-32442,
-32487,
-32519,
-32505,
-32509,
-32546,
-32598,
-32683,
-32708,
-32738,
-32784,
-32869,
-33020,
-33168,
-33293,
-33357,
-33316,
-33227,
-33100,
-33037,
-33046,
-33127,
-33207,
-33264,
-33281,
-33264,
-33213,
-33145,
-33112,
-33163,
-33257,
-33307,
-33239,
-33086,
-32952,
-32919,
-32919,
-32922,
-32887,
-32885,
-32946,
-32984,
-32955,
-32846,
-32773,
-32812,
-32921,
-32961,
-32933,
-32856,
-32856,
-32908,
-32914,
-32806,
-32596,
-32358,
-32181,
-32073,
-32046,
-32113,
-32234,
-32395,
-32489,
-32521,
-32478,
-32421,
-32308,
-32172,
-31948,
-31771,
-31622,
-31611,
-31641,
-31723,
-31791,
-31850,
-31889,
-31904,
-31941,
-31954,
-32001,
-31992,
-31963,
-31890,
-31852,
-31840,
-31893,
-31956,
-32024,
-32096,
-32140,
-32178,
-32170,
-32177,
-32217,
-32354,
-32530,
-32742,
-32895,
-32998,
-33037,
-33019,
-32942,
-32804,
-32617,
-32413,
-32244,
-32167,
-32206,
-32357,
-32561,
-32747,
-32879,
-32970,
-33024,
-33101,
-33136,
-33144,
-33090,
-33025,
-32993,
-33019,
-33083,
-33152,
-33201,
-33254,
-33321,
-33395,
-33470,
-33531,
-33587,
-33635,
-33659,
-33629,
-33570,
-33473,
-33390,
-33297,
-33200,
-33065,
-32933,
-32788,
-32703,
-32666,
-32729,
-32845,
-32982,
-33075,
-33089,
-33043,
-32959,
-32851,
-32745,
-32617,
-32505,
-32372,
-32277,
-32176,
-32128,
-32070,
-32033,
-31991,
-31990,
-32038,
-32097,
-32140,
-32121,
-32065,
-32007,
-31944,
-31911,
-31909,
-31991,
-32108,
-32219,
-32202,
-32095,
-31949,
-31846,
-31804,
-31776,
-31730,
-31720,
-31751,
-31824,
-31858,
-31839,
-31775,
-31717,
-31700,
-31674,
-31652,
-31606,
-31605,
-31637,
-31715,
-31765,
-31804,
-31804,
-31835,
-31867,
-31914,
-31935,
-31977,
-32033,
-32164,
-32314,
-32443,
-32514,
-32514,
-32478,
-32434,
-32398,
-32367,
-32375,
-32393,
-32466,
-32544,
-32629,
-32694,
-32774,
-32819,
-32893,
-32930,
-32967,
-32981,
-32964,
-32918,
-32844,
-32804,
-32816,
-32908,
-33057,
-33185,
-33280,
-33288,
-33262,
-33216,
-33181,
-33159,
-33143,
-33122,
-33096,
-33073,
-33070,
-33110,
-33174,
-33223,
-33225,
-33154,
-33067,
-32996,
-32974,
-32970,
-32958,
-32934,
-32926,
-32966,
-33016,
-33034,
-32973,
-32830,
-32665,
-32493,
-32377,
-32307,
-32287,
-32304,
-32337,
-32347,
-32376,
-32386,
-32422,
-32438,
-32418,
-32355,
-32273,
-32187,
-32143,
-32103,
-32080,
-32037,
-32010,
-32000,
-32015,
-32007,
-31955,
-31877,
-31792,
-31756,
-31719,
-31688,
-31639,
-31606,
-31619,
-31631,
-31643,
-31573,
-31487,
-31394,
-31318,
-31270,
-31228,
-31229,
-31275,
-31357,
-31456,
-31541,
-31620,
-31681,
-31705,
-31699,
-31682,
-31677,
-31716,
-31735,
-31749,
-31739,
-31726,
-31731,
-31708,
-31698,
-31681,
-31723,
-31772,
-31831,
-31902,
-31986,
-32128,
-32235,
-32265,
-32243,
-32201,
-32252,
-32350,
-32434,
-32444,
-32389,
-32345,
-32342,
-32413,
-32515,
-32664,
-32832,
-32970,
-33030,
-33009,
-32916,
-32881,
-32861,
-32947,
-33030,
-33114,
-33169,
-33179,
-33185,
-33189,
-33217,
-33228,
-33229,
-33174,
-33099,
-33040,
-33023,
-33051,
-33105,
-33147,
-33193,
-33237,
-33282,
-33325,
-33289,
-33222,
-33073,
-32963,
-32858,
-32822,
-32791,
-32795,
-32805,
-32833,
-32877,
-32898,
-32913,
-32878,
-32817,
-32726,
-32613,
-32503,
-32429,
-32384,
-32418,
-32449,
-32501,
-32509,
-32500,
-32480,
-32471,
-32467,
-32432,
-32363,
-32270,
-32180,
-32153,
-32110,
-32093,
-32004,
-31899,
-31767,
-31663,
-31553,
-31495,
-31448,
-31466,
-31509,
-31586,
-31643,
-31701,
-31745,
-31812,
-31895,
-32000,
-32081,
-32131,
-32114,
-32039,
-31931,
-31814,
-31727,
-31700,
-31712,
-31746,
-31776,
-31793,
-31829,
-31886,
-31945,
-31960,
-31935,
-31890,
-31900,
-31953,
-32017,
-32034,
-32014,
-32015,
-32079,
-32210,
-32325,
-32423,
-32485,
-32579,
-32685,
-32784,
-32818,
-32823,
-32821,
-32816,
-32848,
-32827,
-32842,
-32845,
-32904,
-32978,
-33064,
-33146,
-33223,
-33308,
-33383,
-33426,
-33418,
-33369,
-33322,
-33299,
-33315,
-33315,
-33288,
-33213,
-33154,
-33105,
-33096,
-33059,
-33038,
-33025,
-33091,
-33189,
-33299,
-33350,
-33372,
-33367,
-33385,
-33384,
-33381,
-33356,
-33342,
-33308,
-33260,
-33168,
-33097,
-33090,
-33123,
-33205,
-33230,
-33268,
-33279,
-33306,
-33314,
-33317,
-33319,
-33378,
-33423,
-33459,
-33395,
-33278,
-33123,
-33003,
-32921,
-32882,
-32848,
-32803,
-32717,
-32641,
-32598,
-32620,
-32685,
-32729,
-32751,
-32742,
-32701,
-32609,
-32433,
-32207,
-31988,
-31830,
-31730,
-31667,
-31618,
-31622,
-31686,
-31812,
-31959,
-32118,
-32241,
-32332,
-32325,
-32228,
-32080,
-31923,
-31835,
-31813,
-31857,
-31947,
-32057,
-32138,
-32197,
-32207,
-32198,
-32178,
-32141,
-32121,
-32103,
-32099,
-32050,
-31964,
-31839,
-31738,
-31671,
-31624,
-31542,
-31445,
-31376,
-31373,
-31430,
-31500,
-31539,
-31590,
-31660,
-31725,
-31760,
-31704,
-31598,
-31486,
-31424,
-31398,
-31404,
-31429,
-31463,
-31570,
-31711,
-31896,
-32088,
-32209,
-32309,
-32318,
-32329,
-32340,
-32387,
-32445,
-32520,
-32553,
-32571,
-32558,
-32568,
-32605,
-32700,
-32777,
-32854,
-32875,
-32899,
-32921,
-32967,
-33022,
-33103,
-33218,
-33356,
-33467,
-33489,
-33419,
-33326,
-33268,
-33278,
-33344,
-33410,
-33539,
-33650,
-33821,
-33912,
-33946,
-33902,
-33804,
-33736,
-33660,
-33631,
-33582,
-33546,
-33485,
-33429,
-33401,
-33398,
-33480,
-33569,
-33707,
-33807,
-33902,
-33962,
-34017,
-34065,
-34118,
-34139,
-34152,
-34115,
-34087,
-34027,
-33991,
-33951,
-33937,
-33964,
-34010,
-34090,
-34173,
-34261,
-34348,
-34412,
-34436,
-34414,
-34375,
-34349,
-34335,
-34328,
-34305,
-34277,
-34267,
-34278,
-34274,
-34237,
-34164,
-34117,
-34145,
-34261,
-34393,
-34477,
-34491,
-34475,
-34471,
-34476,
-34446,
-34371,
-34276,
-34214,
-34176,
-34137,
-34071,
-33983,
-33930,
-33909,
-33920,
-33936,
-33947,
-33977,
-33980,
-33970,
-33899,
-33830,
-33771,
-33735,
-33703,
-33640,
-33571,
-33495,
-33438,
-33389,
-33353,
-33350,
-33365,
-33413,
-33419,
-33409,
-33357,
-33299,
-33238,
-33164,
-33084,
-33015,
-32952,
-32911,
-32857,
-32804,
-32749,
-32717,
-32668,
-32628,
-32561,
-32511,
-32509,
-32556,
-32641,
-32718,
-32745,
-32692,
-32613,
-32546,
-32547,
-32598,
-32622,
-32586,
-32491,
-32414,
-32366,
-32361,
-32326,
-32294,
-32286,
-32341,
-32408,
-32455,
-32445,
-32431,
-32436,
-32453,
-32454,
-32416,
-32370,
-32333,
-32327,
-32319,
-32330,
-32334,
-32343,
-32341,
-32338,
-32323,
-32338,
-32332,
-32331,
-32319,
-32315,
-32358,
-32395,
-32404,
-32364,
-32292,
-32222,
-32177,
-32120,
-32079,
-32038,
-32029,
-32031,
-32048,
-32060,
-32083,
-32107,
-32111,
-32085,
-32039,
-31973,
-31914,
-31847,
-31793,
-31757,
-31754,
-31787,
-31792,
-31823,
-31833,
-31919,
-32036,
-32189,
-32306,
-32387,
-32407,
-32426,
-32426,
-32466,
-32498,
-32529,
-32508,
-32447,
-32360,
-32312,
-32325,
-32404,
-32518,
-32617,
-32710,
-32765,
-32804,
-32813,
-32806,
-32798,
-32809,
-32801,
-32793,
-32728,
-32684,
-32638,
-32652,
-32671,
-32707,
-32737,
-32802,
-32910,
-33044,
-33169,
-33210,
-33222,
-33196,
-33201,
-33204,
-33182,
-33124,
-33067,
-33028,
-33037,
-33055,
-33096,
-33190,
-33326,
-33482,
-33585,
-33620,
-33623,
-33636,
-33654,
-33640,
-33579,
-33512,
-33468,
-33454,
-33432,
-33381,
-33338,
-33332,
-33390,
-33456,
-33532,
-33592,
-33637,
-33659,
-33638,
-33572,
-33503,
-33449,
-33407,
-33383,
-33343,
-33315,
-33276,
-33236,
-33181,
-33147,
-33134,
-33191,
-33271,
-33376,
-33479,
-33565,
-33647,
-33715,
-33746,
-33748,
-33683,
-33581,
-33478,
-33385,
-33359,
-33339,
-33367,
-33386,
-33459,
-33538,
-33641,
-33734,
-33790,
-33820,
-33813,
-33789,
-33748,
-33715,
-33661,
-33621,
-33583,
-33587,
-33624,
-33693,
-33713,
-33717,
-33656,
-33628,
-33602,
-33607,
-33626,
-33687,
-33750,
-33855,
-33894,
-33890,
-33828,
-33750,
-33685,
-33649,
-33619,
-33606,
-33601,
-33584,
-33570,
-33554,
-33554,
-33595,
-33607,
-33593,
-33523,
-33408,
-33305,
-33184,
-33074,
-32964,
-32855,
-32772,
-32684,
-32615,
-32566,
-32551,
-32575,
-32603,
-32631,
-32645,
-32663,
-32653,
-32624,
-32543,
-32474,
-32419,
-32409,
-32392,
-32377,
-32334,
-32318,
-32308,
-32293,
-32266,
-32202,
-32158,
-32097,
-32061,
-31979,
-31890,
-31788,
-31702,
-31650,
-31604,
-31580,
-31535,
-31479,
-31402,
-31318,
-31273,
-31266,
-31295,
-31324,
-31316,
-31276,
-31204,
-31133,
-31040,
-30971,
-30909,
-30898,
-30897,
-30916,
-30902,
-30893,
-30907,
-30941,
-31030,
-31098,
-31159,
-31164,
-31146,
-31090,
-31062,
-31052,
-31088,
-31123,
-31146,
-31125,
-31095,
-31055,
-31024,
-31004,
-30998,
-31013,
-31039,
-31058,
-31052,
-31008,
-30956,
-30884,
-30816,
-30773,
-30746,
-30748,
-30766,
-30769,
-30777,
-30766,
-30769,
-30770,
-30794,
-30805,
-30806,
-30763,
-30703,
-30652,
-30666,
-30745,
-30864,
-30949,
-30942,
-30856,
-30717,
-30602,
-30518,
-30484,
-30433,
-30407,
-30353,
-30359,
-30402,
-30522,
-30661,
-30786,
-30856,
-30865,
-30846,
-30818,
-30795,
-30762,
-30686,
-30588,
-30500,
-30452,
-30484,
-30549,
-30634,
-30731,
-30797,
-30865,
-30876,
-30880,
-30850,
-30849,
-30852,
-30861,
-30870,
-30864,
-30873,
-30895,
-30915,
-30931,
-30957,
-30976,
-31034,
-31076,
-31145,
-31222,
-31347,
-31503,
-31689,
-31838,
-31960,
-32032,
-32072,
-32084,
-32047,
-31959,
-31857,
-31735,
-31696,
-31692,
-31773,
-31896,
-32041,
-32200,
-32346,
-32471,
-32566,
-32612,
-32640,
-32626,
-32630,
-32609,
-32564,
-32498,
-32414,
-32403,
-32409,
-32469,
-32457,
-32457,
-32422,
-32454,
-32488,
-32536,
-32558,
-32591,
-32635,
-32684,
-32727,
-32716,
-32707,
-32666,
-32651,
-32626,
-32659,
-32720,
-32816,
-32887,
-32917,
-32927,
-32949,
-33000,
-33010,
-32971,
-32863,
-32765,
-32712,
-32701,
-32689,
-32689,
-32677,
-32702,
-32736,
-32765,
-32818,
-32897,
-33016,
-33122,
-33176,
-33136,
-33047,
-32962,
-32887,
-32862,
-32868,
-32878,
-32918,
-32893,
-32849,
-32788,
-32769,
-32837,
-32954,
-33074,
-33155,
-33197,
-33225,
-33278,
-33306,
-33319,
-33281,
-33198,
-33124,
-33034,
-32975,
-32922,
-32871,
-32841,
-32813,
-32805,
-32811,
-32820,
-32844,
-32866,
-32899,
-32920,
-32910,
-32864,
-32772,
-32646,
-32516,
-32384,
-32283,
-32219,
-32173,
-32164,
-32126,
-32125,
-32081,
-32080,
-32052,
-32034,
-32006,
-31984,
-31951,
-31932,
-31889,
-31840,
-31787,
-31743,
-31737,
-31787,
-31878,
-31995,
-32109,
-32185,
-32236,
-32222,
-32182,
-32117,
-32059,
-32032,
-32018,
-31979,
-31906,
-31790,
-31688,
-31602,
-31568,
-31535,
-31540,
-31528,
-31525,
-31505,
-31505,
-31514,
-31574,
-31607,
-31618,
-31547,
-31459,
-31360,
-31312,
-31297,
-31316,
-31342,
-31392,
-31439,
-31516,
-31590,
-31698,
-31807,
-31928,
-32008,
-32049,
-32023,
-31971,
-31909,
-31869,
-31852,
-31848,
-31843,
-31819,
-31784,
-31754,
-31723,
-31753,
-31787,
-31861,
-31897,
-31898,
-31850,
-31819,
-31816,
-31882,
-31946,
-31978,
-31943,
-31868,
-31800,
-31774,
-31820,
-31938,
-32114,
-32323,
-32495,
-32621,
-32683,
-32721,
-32759,
-32803,
-32826,
-32852,
-32837,
-32840,
-32814,
-32801,
-32799,
-32833,
-32919,
-33013,
-33118,
-33194,
-33259,
-33279,
-33278,
-33252,
-33240,
-33300,
-33393,
-33515,
-33604,
-33635,
-33640,
-33606,
-33581,
-33579,
-33615,
-33702,
-33790,
-33859,
-33890,
-33919,
-33969,
-34047,
-34136,
-34181,
-34200,
-34160,
-34104,
-34037,
-33987,
-33966,
-33981,
-33968,
-33928,
-33855,
-33777,
-33784,
-33829,
-33921,
-34013,
-34100,
-34189,
-34236,
-34229,
-34149,
-34038,
-33947,
-33869,
-33825,
-33753,
-33700,
-33636,
-33622,
-33614,
-33665,
-33712,
-33796,
-33838,
-33852,
-33814,
-33744,
-33686,
-33626,
-33612,
-33587,
-33575,
-33526,
-33483,
-33419,
-33396,
-33387,
-33385,
-33383,
-33361,
-33343,
-33327,
-33309,
-33298,
-33271,
-33239,
-33169,
-33070,
-32955,
-32834,
-32749,
-32680,
-32647,
-32651,
-32703,
-32787,
-32885,
-32962,
-33016,
-33044,
-33041,
-32981,
-32881,
-32740,
-32610,
-32483,
-32385,
-32274,
-32203,
-32179,
-32246,
-32367,
-32498,
-32582,
-32615,
-32615,
-32618,
-32647,
-32666,
-32682,
-32681,
-32672,
-32695,
-32730,
-32785,
-32853,
-32901,
-32975,
-33005,
-33051,
-33042,
-33057,
-33059,
-33123,
-33202,
-33311,
-33404,
-33465,
-33465,
-33415,
-33335,
-33255,
-33223,
-33220,
-33248,
-33284,
-33325,
-33408,
-33498,
-33584,
-33639,
-33649,
-33658,
-33654,
-33659,
-33647,
-33648,
-33660,
-33702,
-33756,
-33830,
-33900,
-34006,
-34108,
-34200,
-34252,
-34266,
-34245,
-34228,
-34192,
-34160,
-34146,
-34130,
-34160,
-34160,
-34197,
-34204,
-34251,
-34294,
-34338,
-34359,
-34365,
-34341,
-34329,
-34291,
-34261,
-34242,
-34243,
-34279,
-34307,
-34344,
-34329,
-34323,
-34293,
-34298,
-34315,
-34387,
-34479,
-34548,
-34574,
-34491,
-34368,
-34222,
-34104,
-34034,
-34008,
-34013,
-34032,
-34021,
-33966,
-33878,
-33794,
-33756,
-33747,
-33741,
-33702,
-33651,
-33621,
-33596,
-33578,
-33523,
-33448,
-33388,
-33337,
-33308,
-33250,
-33185,
-33093,
-33014,
-32953,
-32899,
-32882,
-32856,
-32848,
-32857,
-32876,
-32924,
-32939,
-32915,
-32850,
-32757,
-32700,
-32659,
-32643,
-32600,
-32564,
-32498,
-32476,
-32447,
-32453,
-32474,
-32497,
-32537,
-32544,
-32578,
-32602,
-32661,
-32708,
-32734,
-32721,
-32690,
-32640,
-32608,
-32557,
-32517,
-32467,
-32445,
-32458,
-32517,
-32620,
-32712,
-32807,
-32825,
-32819,
-32768,
-32711,
-32680,
-32669,
-32706,
-32764,
-32842,
-32921,
-32990,
-33045,
-33099,
-33121,
-33148,
-33146,
-33140,
-33170,
-33191,
-33250,
-33278,
-33305,
-33318,
-33335,
-33339,
-33360,
-33372,
-33405,
-33434,
-33453,
-33482,
-33495,
-33542,
-33562,
-33588,
-33593,
-33606,
-33610,
-33604,
-33568,
-33510,
-33473,
-33461,
-33515,
-33590,
-33694,
-33780,
-33847,
-33879,
-33865,
-33822,
-33751,
-33679,
-33614,
-33557,
-33491,
-33422,
-33319,
-33229,
-33111,
-33016,
-32919,
-32820,
-32761,
-32709,
-32718,
-32731,
-32757,
-32760,
-32740,
-32717,
-32689,
-32691,
-32669,
-32658,
-32603,
-32569,
-32554,
-32564,
-32599,
-32615,
-32626,
-32611,
-32576,
-32494,
-32382,
-32248,
-32140,
-32053,
-32002,
-31950,
-31911,
-31861,
-31822,
-31786,
-31749,
-31728,
-31669,
-31609,
-31506,
-31425,
-31368,
-31346,
-31371,
-31388,
-31442,
-31461,
-31502,
-31495,
-31506,
-31501,
-31535,
-31592,
-31675,
-31770,
-31871,
-31942,
-32019,
-32055,
-32131,
-32197,
-32289,
-32322,
-32315,
-32245,
-32155,
-32071,
-32001,
-31964,
-31957,
-31985,
-32024,
-32077,
-32093,
-32124,
-32145,
-32234,
-32367,
-32512,
-32637,
-32675,
-32663,
-32611,
-32571,
-32528,
-32508,
-32483,
-32502,
-32530,
-32564,
-32580,
-32564,
-32575,
-32599,
-32656,
-32708,
-32720,
-32715,
-32648,
-32597,
-32528,
-32505,
-32530,
-32601,
-32677,
-32730,
-32723,
-32672,
-32597,
-32517,
-32471,
-32438,
-32423,
-32375,
-32309,
-32225,
-32161,
-32117,
-32094,
-32083,
-32058,
-32047,
-32011,
-31981,
-31934,
-31892,
-31847,
-31808,
-31759,
-31703,
-31657,
-31625,
-31617,
-31619,
-31584,
-31552,
-31483,
-31448,
-31418,
-31385,
-31345,
-31307,
-31270,
-31276,
-31254,
-31219,
-31140,
-31051,
-30976,
-30922,
-30905,
-30913,
-30964,
-31045,
-31127,
-31205,
-31259,
-31307,
-31382,
-31456,
-31564,
-31668,
-31769,
-31868,
-31932,
-31972,
-31977,
-31980,
-32003,
-32053,
-32129,
-32205,
-32255,
-32281,
-32277,
-32264,
-32255,
-32240,
-32235,
-32221,
-32239,
-32251,
-32268,
-32275,
-32277,
-32313,
-32361,
-32453,
-32526,
-32588,
-32615,
-32624,
-32609,
-32624,
-32608,
-32638,
-32628,
-32611,
-32584,
-32526,
-32512,
-32512,
-32538,
-32579,
-32580,
-32567,
-32556,
-32565,
-32623,
-32662,
-32693,
-32673,
-32657,
-32643,
-32635,
-32607,
-32551,
-32484,
-32431,
-32395,
-32355,
-32303,
-32237,
-32163,
-32110,
-32038,
-32000,
-31937,
-31917,
-31877,
-31869,
-31852,
-31840,
-31828,
-31819,
-31804,
-31810,
-31802,
-31803,
-31774,
-31737,
-31674,
-31633,
-31596,
-31612,
-31640,
-31677,
-31691,
-31693,
-31680,
-31698,
-31684,
-31679,
-31632,
-31601,
-31611,
-31655,
-31740,
-31787,
-31829,
-31843,
-31871,
-31923,
-31975,
-32028,
-32076,
-32094,
-32123,
-32154,
-32189,
-32274,
-32348,
-32465,
-32552,
-32638,
-32698,
-32729,
-32751,
-32760,
-32774,
-32807,
-32847,
-32853,
-32871,
-32844,
-32876,
-32897,
-32929,
-32922,
-32900,
-32909,
-32955,
-33046,
-33102,
-33136,
-33131,
-33148,
-33192,
-33242,
-33286,
-33301,
-33299,
-33317,
-33331,
-33375,
-33390,
-33411,
-33382,
-33345,
-33301,
-33272,
-33276,
-33275,
-33286,
-33249,
-33225,
-33182,
-33170,
-33169,
-33173,
-33168,
-33144,
-33095,
-33041,
-32982,
-32938,
-32920,
-32907,
-32918,
-32904,
-32906,
-32869,
-32857,
-32831,
-32818,
-32790,
-32750,
-32703,
-32652,
-32610,
-32565,
-32511,
-32463,
-32388,
-32330,
-32269,
-32236,
-32228,
-32226,
-32214,
-32189,
-32171,
-32191,
-32236,
-32271,
-32266,
-32214,
-32167,
-32155,
-32167,
-32218,
-32221,
-32251,
-32250,
-32264,
-32271,
-32266,
-32273,
-32286,
-32303,
-32307,
-32276,
-32231,
-32182,
-32196,
-32244,
-32331,
-32403,
-32427,
-32436,
-32432,
-32469,
-32534,
-32611,
-32670,
-32691,
-32670,
-32641,
-32634,
-32667,
-32754,
-32824,
-32876,
-32882,
-32870,
-32883,
-32890,
-32925,
-32939,
-32983,
-33017,
-33068,
-33077,
-33085,
-33080,
-33097,
-33111,
-33111,
-33089,
-33074,
-33098,
-33154,
-33227,
-33292,
-33325,
-33373,
-33394,
-33433,
-33454,
-33457,
-33476,
-33472,
-33486,
-33487,
-33491,
-33496,
-33507,
-33509,
-33540,
-33552,
-33587,
-33593,
-33595,
-33610,
-33624,
-33677,
-33685,
-33702,
-33655,
-33609,
-33516,
-33438,
-33334,
-33271,
-33187,
-33150,
-33092,
-33062,
-33031,
-33001,
-32984,
-32970,
-32981,
-33023,
-33067,
-33117,
-33119,
-33107,
-33050,
-33010,
-32947,
-32912,
-32867,
-32825,
-32796,
-32772,
-32758,
-32721,
-32671,
-32595,
-32510,
-32469,
-32400,
-32379,
-32323,
-32269,
-32210,
-32150,
-32113,
-32104,
-32135,
-32162,
-32169,
-32151,
-32131,
-32135,
-32168,
-32203,
-32232,
-32257,
-32273,
-32276,
-32239,
-32183,
-32127,
-32100,
-32104,
-32106,
-32097,
-32075,
-32063,
-32059,
-32072,
-32072,
-32049,
-31993,
-31910,
-31831,
-31781,
-31788,
-31822,
-31894,
-31940,
-32009,
-32049,
-32090,
-32120,
-32124,
-32139,
-32133,
-32147,
-32154,
-32194,
-32239,
-32296,
-32357,
-32409,
-32466,
-32529,
-32612,
-32672,
-32727,
-32720,
-32713,
-32679,
-32705,
-32716,
-32793,
-32842,
-32920,
-32975,
-33024,
-33041,
-33046,
-33005,
-32970,
-32912,
-32874,
-32884,
-32915,
-32998,
-33043,
-33078,
-33089,
-33112,
-33160,
-33208,
-33227,
-33227,
-33219,
-33239,
-33287,
-33322,
-33352,
-33364,
-33401,
-33455,
-33498,
-33509,
-33447,
-33376,
-33294,
-33261,
-33247,
-33239,
-33251,
-33268,
-33337,
-33412,
-33490,
-33531,
-33536,
-33530,
-33501,
-33502,
-33495,
-33498,
-33509,
-33488,
-33494,
-33496,
-33531,
-33577,
-33602,
-33599,
-33574,
-33558,
-33565,
-33589,
-33600,
-33604,
-33601,
-33602,
-33595,
-33568,
-33513,
-33452,
-33406,
-33383,
-33375,
-33379,
-33382,
-33387,
-33394,
-33384,
-33339,
-33262,
-33139,
-33027,
-32915,
-32860,
-32804,
-32768,
-32710,
-32654,
-32629,
-32606,
-32601,
-32562,
-32503,
-32436,
-32382,
-32315,
-32278,
-32222,
-32218,
-32211,
-32241,
-32250,
-32262,
-32267,
-32249,
-32241,
-32185,
-32166,
-32101,
-32054,
-31968,
-31892,
-31841,
-31806,
-31804,
-31767,
-31767,
-31736,
-31747,
-31707,
-31680,
-31620,
-31597,
-31605,
-31623,
-31665,
-31689,
-31709,
-31679,
-31633,
-31566,
-31540,
-31553,
-31559,
-31551,
-31504,
-31473,
-31451,
-31441,
-31402,
-31365,
-31340,
-31341,
-31360,
-31373,
-31374,
-31378,
-31373,
-31356,
-31335,
-31320,
-31330,
-31338,
-31327,
-31266,
-31228,
-31186,
-31212,
-31223,
-31251,
-31272,
-31288,
-31307,
-31280,
-31255,
-31212,
-31208,
-31195,
-31195,
-31166,
-31121,
-31091,
-31078,
-31107,
-31175,
-31243,
-31321,
-31354,
-31399,
-31433,
-31487,
-31538,
-31557,
-31553,
-31530,
-31499,
-31477,
-31438,
-31412,
-31405,
-31434,
-31514,
-31609,
-31705,
-31767,
-31792,
-31779,
-31788,
-31797,
-31839,
-31859,
-31856,
-31840,
-31816,
-31827,
-31836,
-31865,
-31889,
-31922,
-31951,
-31984,
-32015,
-32048,
-32097,
-32148,
-32209,
-32272,
-32336,
-32402,
-32471,
-32527,
-32585,
-32612,
-32620,
-32614,
-32581,
-32571,
-32561,
-32565,
-32569,
-32557,
-32540,
-32521,
-32522,
-32550,
-32607,
-32647,
-32669,
-32652,
-32635,
-32649,
-32675,
-32714,
-32716,
-32705,
-32695,
-32708,
-32752,
-32791,
-32831,
-32850,
-32878,
-32882,
-32894,
-32866,
-32870,
-32854,
-32898,
-32911,
-32947,
-32935,
-32972,
-32993,
-33048,
-33094,
-33121,
-33162,
-33178,
-33174,
-33136,
-33073,
-33049,
-33049,
-33085,
-33097,
-33093,
-33096,
-33120,
-33166,
-33207,
-33214,
-33206,
-33180,
-33154,
-33122,
-33099,
-33087,
-33099,
-33125,
-33134,
-33159,
-33166,
-33196,
-33215,
-33243,
-33274,
-33318,
-33388,
-33464,
-33555,
-33643,
-33724,
-33777,
-33800,
-33785,
-33775,
-33766,
-33786,
-33808,
-33823,
-33822,
-33796,
-33754,
-33724,
-33686,
-33689,
-33669,
-33679,
-33681,
-33697,
-33717,
-33722,
-33719,
-33710,
-33679,
-33652,
-33592,
-33541,
-33489,
-33466,
-33470,
-33510,
-33558,
-33620,
-33655,
-33676,
-33668,
-33636,
-33603,
-33555,
-33523,
-33503,
-33484,
-33477,
-33443,
-33415,
-33366,
-33315,
-33258,
-33193,
-33141,
-33108,
-33082,
-33067,
-33031,
-32988,
-32955,
-32918,
-32888,
-32854,
-32806,
-32770,
-32711,
-32664,
-32605,
-32590,
-32586,
-32645,
-32672,
-32721,
-32706,
-32692,
-32639,
-32584,
-32534,
-32497,
-32504,
-32517,
-32546,
-32561,
-32575,
-32598,
-32643,
-32680,
-32722,
-32734,
-32706,
-32686,
-32605,
-32566,
-32488,
-32464,
-32451,
-32486,
-32521,
-32548,
-32551,
-32524,
-32508,
-32489,
-32492,
-32505,
-32504,
-32527,
-32515,
-32531,
-32522,
-32508,
-32491,
-32464,
-32444,
-32425,
-32398,
-32356,
-32303,
-32248,
-32229,
-32205,
-32221,
-32199,
-32220,
-32231,
-32291,
-32313,
-32312,
-32248,
-32173,
-32132,
-32163,
-32224,
-32319,
-32355,
-32394,
-32418,
-32472,
-32533,
-32576,
-32567,
-32537,
-32481,
-32453,
-32415,
-32377,
-32310,
-32278,
-32226,
-32241,
-32215,
-32231,
-32256,
-32285,
-32337,
-32351,
-32339,
-32321,
-32292,
-32293,
-32292,
-32286,
-32243,
-32188,
-32115,
-32093,
-32092,
-32159,
-32199,
-32242,
-32260,
-32293,
-32349,
-32393,
-32392,
-32361,
-32302,
-32291,
-32282,
-32281,
-32257,
-32223,
-32225,
-32247,
-32301,
-32316,
-32329,
-32296,
-32298,
-32291,
-32297,
-32279,
-32244,
-32199,
-32161,
-32135,
-32104,
-32070,
-32033,
-32008,
-32014,
-32016,
-32026,
-31999,
-31998,
-31991,
-32024,
-32059,
-32068,
-32073,
-32053,
-32054,
-32065,
-32111,
-32158,
-32237,
-32290,
-32356,
-32387,
-32441,
-32468,
-32487,
-32463,
-32424,
-32380,
-32370,
-32370,
-32410,
-32458,
-32541,
-32622,
-32718,
-32776,
-32837,
-32891,
-32935,
-32976,
-32973,
-32963,
-32944,
-32940,
-32936,
-32934,
-32927,
-32940,
-32957,
-32989,
-33012,
-33014,
-33029,
-33021,
-33044,
-33067,
-33118,
-33204,
-33297,
-33392,
-33448,
-33494,
-33516,
-33548,
-33559,
-33555,
-33527,
-33498,
-33464,
-33461,
-33457,
-33489,
-33528,
-33574,
-33609,
-33609,
-33618,
-33609,
-33627,
-33621,
-33601,
-33568,
-33553,
-33556,
-33567,
-33569,
-33541,
-33540,
-33542,
-33582,
-33595,
-33589,
-33550,
-33525,
-33539,
-33584,
-33660,
-33707,
-33741,
-33735,
-33711,
-33690,
-33657,
-33646,
-33635,
-33651,
-33662,
-33682,
-33664,
-33640,
-33615,
-33622,
-33659,
-33713,
-33749,
-33751,
-33752,
-33722,
-33734,
-33719,
-33758,
-33780,
-33820,
-33858,
-33890,
-33949,
-34023,
-34080,
-34117,
-34071,
-34029,
-33960,
-33924,
-33904,
-33886,
-33874,
-33871,
-33867,
-33867,
-33866,
-33863,
-33867,
-33874,
-33875,
-33871,
-33840,
-33796,
-33713,
-33653,
-33589,
-33568,
-33579,
-33592,
-33645,
-33676,
-33761,
-33819,
-33898,
-33937,
-33958,
-33965,
-33957,
-33948,
-33925,
-33899,
-33899,
-33900,
-33935,
-33952,
-33959,
-33971,
-33981,
-34016,
-34026,
-34038,
-34008,
-34007,
-34002,
-34017,
-34020,
-34000,
-33966,
-33891,
-33827,
-33763,
-33749,
-33767,
-33809,
-33841,
-33840,
-33827,
-33799,
-33787,
-33780,
-33772,
-33763,
-33733,
-33708,
-33675,
-33653,
-33647,
-33654,
-33672,
-33709,
-33735,
-33777,
-33792,
-33812,
-33797,
-33779,
-33731,
-33672,
-33619,
-33580,
-33564,
-33566,
-33552,
-33529,
-33495,
-33447,
-33406,
-33353,
-33299,
-33227,
-33145,
-33068,
-32991,
-32945,
-32906,
-32877,
-32879,
-32852,
-32864,
-32822,
-32818,
-32786,
-32768,
-32741,
-32696,
-32661,
-32621,
-32600,
-32555,
-32510,
-32461,
-32414,
-32401,
-32346,
-32310,
-32229,
-32188,
-32168,
-32171,
-32194,
-32208,
-32219,
-32200,
-32167,
-32088,
-32022,
-31942,
-31872,
-31776,
-31692,
-31601,
-31553,
-31528,
-31514,
-31524,
-31535,
-31568,
-31607,
-31628,
-31620,
-31578,
-31494,
-31429,
-31363,
-31353,
-31344,
-31335,
-31311,
-31287,
-31272,
-31281,
-31274,
-31264,
-31245,
-31227,
-31209,
-31172,
-31145,
-31130,
-31169,
-31215,
-31260,
-31271,
-31269,
-31248,
-31243,
-31194,
-31153,
-31104,
-31081,
-31098,
-31120,
-31142,
-31146,
-31125,
-31069,
-30998,
-30922,
-30859,
-30834,
-30802,
-30789,
-30750,
-30724,
-30686,
-30686,
-30692,
-30750,
-30779,
-30796,
-30752,
-30701,
-30666,
-30663,
-30690,
-30712,
-30732,
-30735,
-30724,
-30699,
-30664,
-30646,
-30654,
-30696,
-30732,
-30754,
-30735,
-30720,
-30696,
-30696,
-30689,
-30680,
-30675,
-30685,
-30707,
-30752,
-30764,
-30797,
-30772,
-30786,
-30765,
-30770,
-30785,
-30791,
-30810,
-30799,
-30774,
-30727,
-30680,
-30628,
-30587,
-30544,
-30511,
-30493,
-30500,
-30535,
-30604,
-30680,
-30777,
-30859,
-30961,
-31045,
-31134,
-31192,
-31232,
-31265,
-31297,
-31366,
-31459,
-31565,
-31673,
-31732,
-31767,
-31754,
-31754,
-31745,
-31781,
-31794,
-31832,
-31842,
-31853,
-31868,
-31877,
-31891,
-31908,
-31909,
-31906,
-31901,
-31884,
-31904,
-31905,
-31944,
-31965,
-32032,
-32089,
-32155,
-32176,
-32162,
-32138,
-32098,
-32075,
-32041,
-32020,
-32033,
-32081,
-32162,
-32252,
-32342,
-32454,
-32549,
-32653,
-32695,
-32740,
-32766,
-32805,
-32840,
-32817,
-32801,
-32751,
-32766,
-32769,
-32798,
-32799,
-32794,
-32788,
-32774,
-32766,
-32764,
-32793,
-32841,
-32878,
-32902,
-32883,
-32864,
-32868,
-32867,
-32889,
-32879,
-32884,
-32891,
-32951,
-32993,
-33080,
-33127,
-33190,
-33218,
-33231,
-33230,
-33227,
-33245,
-33241,
-33247,
-33228,
-33239,
-33278,
-33325,
-33361,
-33367,
-33355,
-33370,
-33380,
-33405,
-33376,
-33339,
-33289,
-33241,
-33226,
-33192,
-33188,
-33172,
-33172,
-33172,
-33186,
-33204,
-33232,
-33230,
-33216,
-33192,
-33181,
-33195,
-33192,
-33177,
-33120,
-33060,
-32995,
-32928,
-32862,
-32781,
-32726,
-32709,
-32728,
-32757,
-32776,
-32768,
-32772,
-32752,
-32732,
-32680,
-32614,
-32552,
-32527,
-32513,
-32512,
-32506,
-32480,
-32463,
-32451,
-32439,
-32441,
-32457,
-32472,
-32517,
-32536,
-32556,
-32530,
-32492,
-32442,
-32394,
-32341,
-32291,
-32213,
-32154,
-32083,
-32050,
-32037,
-32039,
-32064,
-32088,
-32093,
-32099,
-32059,
-32057,
-32045,
-32079,
-32082,
-32090,
-32036,
-32000,
-31958,
-31943,
-31947,
-31947,
-31961,
-31981,
-31985,
-32007,
-32012,
-32058,
-32125,
-32206,
-32272,
-32303,
-32291,
-32255,
-32193,
-32125,
-32064,
-32035,
-32030,
-32052,
-32094,
-32133,
-32199,
-32245,
-32269,
-32280,
-32264,
-32267,
-32279,
-32286,
-32295,
-32309,
-32343,
-32408,
-32466,
-32536,
-32574,
-32625,
-32665,
-32679,
-32688,
-32683,
-32673,
-32692,
-32701,
-32719,
-32739,
-32754,
-32782,
-32795,
-32814,
-32832,
-32866,
-32928,
-33005,
-33097,
-33186,
-33261,
-33315,
-33344,
-33342,
-33329,
-33306,
-33289,
-33286,
-33302,
-33333,
-33392,
-33462,
-33542,
-33615,
-33648,
-33665,
-33657,
-33654,
-33646,
-33641,
-33624,
-33629,
-33610,
-33595,
-33544,
-33497,
-33467,
-33471,
-33483,
-33509,
-33508,
-33545,
-33563,
-33628,
-33656,
-33707,
-33743,
-33808,
-33859,
-33911,
-33903,
-33869,
-33802,
-33747,
-33721,
-33738,
-33760,
-33802,
-33819,
-33854,
-33880,
-33899,
-33892,
-33861,
-33834,
-33794,
-33771,
-33707,
-33644,
-33576,
-33541,
-33507,
-33473,
-33383,
-33300,
-33191,
-33138,
-33071,
-33045,
-33008,
-33016,
-33014,
-33022,
-32995,
-32945,
-32888,
-32841,
-32803,
-32772,
-32770,
-32782,
-32817,
-32850,
-32863,
-32835,
-32811,
-32771,
-32749,
-32724,
-32673,
-32609,
-32535,
-32472,
-32426,
-32409,
-32398,
-32411,
-32414,
-32412,
-32403,
-32374,
-32371,
-32376,
-32412,
-32451,
-32469,
-32464,
-32439,
-32387,
-32356,
-32304,
-32276,
-32253,
-32243,
-32257,
-32277,
-32314,
-32354,
-32393,
-32426,
-32453,
-32463,
-32467,
-32456,
-32443,
-32444,
-32447,
-32478,
-32522,
-32592,
-32680,
-32770,
-32860,
-32928,
-32990,
-33031,
-33088,
-33133,
-33210,
-33261,
-33306,
-33319,
-33329,
-33337,
-33362,
-33371,
-33371,
-33349,
-33325,
-33319,
-33338,
-33386,
-33445,
-33521,
-33558,
-33565,
-33533,
-33479,
-33466,
-33466,
-33492,
-33496,
-33505,
-33504,
-33556,
-33613,
-33690,
-33739,
-33762,
-33754,
-33726,
-33690,
-33660,
-33649,
-33659,
-33680,
-33702,
-33719,
-33758,
-33770,
-33810,
-33802,
-33815,
-33818,
-33842,
-33869,
-33885,
-33882,
-33858,
-33810,
-33747,
-33684,
-33633,
-33599,
-33559,
-33477,
-33389,
-33294,
-33253,
-33248,
-33246,
-33243,
-33220,
-33202,
-33173,
-33130,
-33076,
-33013,
-32973,
-32934,
-32867,
-32822,
-32753,
-32739,
-32722,
-32703,
-32685,
-32660,
-32652,
-32651,
-32624,
-32583,
-32524,
-32455,
-32410,
-32355,
-32331,
-32310,
-32322,
-32344,
-32378,
-32415,
-32437,
-32455,
-32456,
-32448,
-32459,
-32458,
-32486,
-32479,
-32491,
-32483,
-32490,
-32503,
-32513,
-32526,
-32544,
-32553,
-32566,
-32575,
-32577,
-32587,
-32592,
-32600,
-32621,
-32651,
-32712,
-32765,
-32802,
-32824,
-32846,
-32880,
-32939,
-32982,
-33023,
-33061,
-33110,
-33162,
-33213,
-33245,
-33266,
-33290,
-33312,
-33341,
-33369,
-33382,
-33391,
-33369,
-33371,
-33368,
-33395,
-33432,
-33456,
-33462,
-33456,
-33425,
-33391,
-33350,
-33303,
-33297,
-33282,
-33307,
-33315,
-33330,
-33349,
-33354,
-33354,
-33344,
-33301,
-33278,
-33240,
-33221,
-33211,
-33206,
-33210,
-33209,
-33213,
-33198,
-33186,
-33176,
-33148,
-33132,
-33106,
-33084,
-33088,
-33088,
-33080,
-33062,
-33010,
-32974,
-32919,
-32861,
-32774,
-32682,
-32604,
-32561,
-32550,
-32541,
-32548,
-32543,
-32546,
-32535,
-32511,
-32476,
-32441,
-32413,
-32382,
-32358,
-32344,
-32349,
-32381,
-32438,
-32486,
-32537,
-32533,
-32509,
-32474,
-32450,
-32449,
-32455,
-32435,
-32426,
-32432,
-32448,
-32477,
-32460,
-32445,
-32445,
-32484,
-32522,
-32538,
-32515,
-32486,
-32476,
-32482,
-32480,
-32485,
-32470,
-32473,
-32453,
-32430,
-32405,
-32429,
-32477,
-32565,
-32641,
-32710,
-32769,
-32814,
-32846,
-32874,
-32899,
-32915,
-32927,
-32914,
-32916,
-32916,
-32943,
-32970,
-32994,
-33017,
-33037,
-33041,
-33029,
-32978,
-32918,
-32862,
-32837,
-32835,
-32848,
-32840,
-32822,
-32794,
-32779,
-32786,
-32798,
-32802,
-32812,
-32800,
-32809,
-32805,
-32814,
-32821,
-32830,
-32822,
-32813,
-32786,
-32784,
-32796,
-32801,
-32782,
-32747,
-32685,
-32655,
-32603,
-32551,
-32484,
-32431,
-32393,
-32360,
-32315,
-32228,
-32167,
-32082,
-32059,
-32020,
-32006,
-31984,
-31981,
-31953,
-31925,
-31851,
-31791,
-31735,
-31708,
-31699,
-31697,
-31685,
-31674,
-31666,
-31672,
-31717,
-31756,
-31836,
-31887,
-31941,
-31956,
-31969,
-31976,
-31995,
-32017,
-32012,
-32011,
-31974,
-31975,
-31953,
-31953,
-31954,
-31981,
-32046,
-32107,
-32156,
-32142,
-32124,
-32112,
-32144,
-32211,
-32258,
-32302,
-32288,
-32294,
-32288,
-32311,
-32313,
-32329,
-32305,
-32318,
-32318,
-32356,
-32399,
-32444,
-32486,
-32521,
-32555,
-32591,
-32638,
-32648,
-32655,
-32627,
-32628,
-32641,
-32687,
-32714,
-32725,
-32717,
-32710,
-32719,
-32729,
-32741,
-32736,
-32732,
-32720,
-32716,
-32714,
-32733,
-32755,
-32775,
-32793,
-32800,
-32811,
-32819,
-32810,
-32791,
-32769,
-32741,
-32702,
-32639,
-32552,
-32479,
-32423,
-32383,
-32352,
-32293,
-32249,
-32216,
-32177,
-32169,
-32129,
-32133,
-32141,
-32175,
-32212,
-32240,
-32271,
-32267,
-32242,
-32160,
-32063,
-31969,
-31920,
-31887,
-31867,
-31826,
-31794,
-31767,
-31784,
-31789,
-31816,
-31815,
-31805,
-31770,
-31718,
-31646,
-31592,
-31544,
-31523,
-31507,
-31495,
-31492,
-31482,
-31478,
-31443,
-31445,
-31437,
-31481,
-31514,
-31544,
-31562,
-31589,
-31621,
-31663,
-31707,
-31739,
-31776,
-31804,
-31813,
-31810,
-31802,
-31800,
-31818,
-31843,
-31854,
-31890,
-31903,
-31945,
-31960,
-31962,
-31981,
-32000,
-32086,
-32168,
-32253,
-32291,
-32315,
-32325,
-32353,
-32370,
-32398,
-32415,
-32439,
-32455,
-32480,
-32495,
-32524,
-32559,
-32598,
-32625,
-32627,
-32621,
-32622,
-32628,
-32647,
-32656,
-32677,
-32706,
-32727,
-32747,
-32744,
-32742,
-32732,
-32732,
-32732,
-32733,
-32743,
-32749,
-32760,
-32769,
-32791,
-32800,
-32846,
-32862,
-32909,
-32949,
-32984,
-33034,
-33054,
-33075,
-33079,
-33068,
-33059,
-33022,
-32993,
-32920,
-32880,
-32824,
-32839,
-32864,
-32895,
-32927,
-32930,
-32969,
-32999,
-33038,
-33018,
-32977,
-32888,
-32839,
-32778,
-32758,
-32727,
-32713,
-32709,
-32695,
-32676,
-32646,
-32592,
-32563,
-32517,
-32479,
-32431,
-32370,
-32330,
-32304,
-32313,
-32324,
-32328,
-32316,
-32282,
-32239,
-32191,
-32145,
-32114,
-32097,
-32120,
-32128,
-32159,
-32155,
-32160,
-32149,
-32120,
-32089,
-32024,
-32003,
-31971,
-31986,
-31978,
-31966,
-31930,
-31915,
-31904,
-31937,
-31958,
-31975,
-31959,
-31920,
-31879,
-31841,
-31840,
-31864,
-31910,
-31965,
-31984,
-31990,
-31971,
-31955,
-31948,
-31949,
-31958,
-31975,
-32007,
-32043,
-32070,
-32089,
-32090,
-32101,
-32121,
-32145,
-32188,
-32208,
-32256,
-32269,
-32303,
-32319,
-32347,
-32366,
-32382,
-32369,
-32377,
-32377,
-32412,
-32459,
-32506,
-32561,
-32596,
-32627,
-32633,
-32640,
-32641,
-32655,
-32662,
-32684,
-32708,
-32766,
-32836,
-32922,
-33009,
-33089,
-33167,
-33211,
-33238,
-33218,
-33198,
-33181,
-33195,
-33245,
-33302,
-33362,
-33405,
-33426,
-33454,
-33474,
-33498,
-33523,
-33526,
-33545,
-33548,
-33567,
-33570,
-33579,
-33552,
-33529,
-33490,
-33472,
-33466,
-33480,
-33469,
-33469,
-33452,
-33479,
-33514,
-33571,
-33594,
-33607,
-33605,
-33596,
-33595,
-33564,
-33539,
-33504,
-33494,
-33489,
-33525,
-33572,
-33644,
-33716,
-33772,
-33807,
-33849,
-33877,
-33916,
-33930,
-33899,
-33872,
-33825,
-33815,
-33829,
-33844,
-33871,
-33862,
-33853,
-33834,
-33827,
-33827,
-33801,
-33802,
-33752,
-33760,
-33727,
-33710,
-33653,
-33595,
-33534,
-33509,
-33473,
-33454,
-33400,
-33375,
-33350,
-33372,
-33383,
-33391,
-33359,
-33297,
-33226,
-33157,
-33119,
-33092,
-33088,
-33071,
-33053,
-33032,
-33013,
-32994,
-32993,
-32975,
-32975,
-32950,
-32912,
-32854,
-32780,
-32719,
-32693,
-32686,
-32689,
-32683,
-32636,
-32615,
-32574,
-32569,
-32542,
-32531,
-32495,
-32485,
-32478,
-32463,
-32462,
-32420,
-32414,
-32407,
-32455,
-32479,
-32499,
-32475,
-32434,
-32411,
-32389,
-32395,
-32379,
-32389,
-32366,
-32365,
-32346,
-32316,
-32309,
-32274,
-32280,
-32237,
-32214,
-32144,
-32103,
-32049,
-32050,
-32022,
-32021,
-31987,
-31968,
-31958,
-31967,
-31978,
-31996,
-31999,
-32004,
-31997,
-31987,
-31986,
-31978,
-31994,
-32008,
-32033,
-32053,
-32078,
-32093,
-32103,
-32108,
-32099,
-32091,
-32072,
-32056,
-32025,
-32001,
-31970,
-31960,
-31926,
-31925,
-31876,
-31859,
-31828,
-31812,
-31829,
-31830,
-31853,
-31876,
-31908,
-31964,
-31999,
-32019,
-32009,
-31985,
-31965,
-31957,
-31955,
-31961,
-31992,
-32036,
-32106,
-32167,
-32239,
-32292,
-32352,
-32369,
-32395,
-32386,
-32414,
-32427,
-32455,
-32463,
-32470,
-32486,
-32510,
-32567,
-32615,
-32688,
-32727,
-32772,
-32785,
-32820,
-32857,
-32910,
-32944,
-32967,
-32976,
-33013,
-33022,
-33031,
-33001,
-32977,
-32959,
-32986,
-33009,
-33067,
-33105,
-33152,
-33169,
-33170,
-33161,
-33152,
-33174,
-33183,
-33184,
-33174,
-33156,
-33161,
-33163,
-33171,
-33158,
-33172,
-33169,
-33199,
-33193,
-33211,
-33211,
-33240,
-33249,
-33258,
-33239,
-33254,
-33268,
-33319,
-33334,
-33342,
-33327,
-33345,
-33370,
-33427,
-33447,
-33458,
-33451,
-33437,
-33452,
-33447,
-33452,
-33426,
-33412,
-33383,
-33380,
-33374,
-33384,
-33383,
-33380,
-33365,
-33357,
-33368,
-33374,
-33429,
-33443,
-33490,
-33497,
-33492,
-33481,
-33453,
-33430,
-33405,
-33382,
-33372,
-33367,
-33384,
-33402,
-33429,
-33452,
-33469,
-33479,
-33495,
-33505,
-33523,
-33523,
-33509,
-33485,
-33463,
-33456,
-33454,
-33468,
-33463,
-33461,
-33444,
-33429,
-33415,
-33393,
-33392,
-33387,
-33406,
-33410,
-33416,
-33410,
-33408,
-33404,
-33410,
-33397,
-33386,
-33361,
-33346,
-33343,
-33358,
-33385,
-33430,
-33461,
-33484,
-33501,
-33501,
-33526,
-33532,
-33543,
-33542,
-33535,
-33535,
-33535,
-33525,
-33513,
-33490,
-33489,
-33469,
-33460,
-33422,
-33386,
-33353,
-33315,
-33295,
-33259,
-33238,
-33207,
-33175,
-33129,
-33079,
-33027,
-32989,
-32951,
-32924,
-32891,
-32866,
-32852,
-32829,
-32805,
-32753,
-32707,
-32652,
-32606,
-32566,
-32504,
-32459,
-32395,
-32360,
-32317,
-32298,
-32277,
-32271,
-32278,
-32281,
-32292,
-32283,
-32253,
-32232,
-32180,
-32158,
-32117,
-32077,
-32022,
-31963,
-31923,
-31910,
-31927,
-31951,
-31963,
-31961,
-31943,
-31929,
-31921,
-31933,
-31944,
-31956,
-31920,
-31853,
-31763,
-31707,
-31718,
-31755,
-31799,
-31794,
-31772,
-31760,
-31767,
-31790,
-31777,
-31765,
-31732,
-31720,
-31692,
-31651,
-31598,
-31554,
-31545,
-31523,
-31502,
-31446,
-31404,
-31373,
-31377,
-31378,
-31399,
-31416,
-31446,
-31463,
-31462,
-31445,
-31416,
-31393,
-31380,
-31358,
-31369,
-31364,
-31388,
-31405,
-31412,
-31445,
-31446,
-31469,
-31458,
-31454,
-31442,
-31425,
-31409,
-31397,
-31409,
-31451,
-31497,
-31522,
-31522,
-31495,
-31471,
-31452,
-31434,
-31423,
-31424,
-31430,
-31429,
-31408,
-31373,
-31348,
-31340,
-31326,
-31328,
-31297,
-31331,
-31345,
-31393,
-31399,
-31406,
-31396,
-31421,
-31427,
-31430,
-31408,
-31376,
-31345,
-31323,
-31290,
-31266,
-31235,
-31219,
-31201,
-31204,
-31201,
-31215,
-31228,
-31259,
-31309,
-31367,
-31418,
-31450,
-31469,
-31486,
-31528,
-31537,
-31540,
-31509,
-31494,
-31499,
-31511,
-31516,
-31490,
-31483,
-31475,
-31487,
-31473,
-31476,
-31447,
-31467,
-31469,
-31480,
-31482,
-31482,
-31479,
-31483,
-31473,
-31489,
-31503,
-31542,
-31558,
-31583,
-31584,
-31619,
-31628,
-31662,
-31664,
-31688,
-31705,
-31738,
-31756,
-31786,
-31791,
-31839,
-31860,
-31908,
-31929,
-31970,
-32008,
-32049,
-32088,
-32120,
-32153,
-32193,
-32234,
-32275,
-32321,
-32363,
-32405,
-32442,
-32497,
-32537,
-32619,
-32678,
-32746,
-32796,
-32825,
-32846,
-32854,
-32856,
-32863,
-32887,
-32931,
-32991,
-33026,
-33061,
-33075,
-33118,
-33141,
-33184,
-33194,
-33213,
-33229,
-33232,
-33226,
-33221,
-33225,
-33252,
-33281,
-33271,
-33251,
-33236,
-33235,
-33266,
-33267,
-33263,
-33234,
-33231,
-33208,
-33229,
-33233,
-33273,
-33294,
-33307,
-33299,
-33295,
-33314,
-33344,
-33368,
-33367,
-33369,
-33368,
-33406,
-33423,
-33466,
-33487,
-33519,
-33544,
-33556,
-33546,
-33556,
-33565,
-33588,
-33622,
-33611,
-33620,
-33594,
-33608,
-33608,
-33640,
-33660,
-33675,
-33670,
-33681,
-33685,
-33730,
-33737,
-33738,
-33716,
-33694,
-33704,
-33720,
-33726,
-33739,
-33733,
-33750,
-33768,
-33768,
-33755,
-33719,
-33705,
-33713,
-33721,
-33747,
-33710,
-33703,
-33668,
-33690,
-33708,
-33729,
-33728,
-33709,
-33709,
-33713,
-33744,
-33760,
-33757,
-33776,
-33774,
-33808,
-33820,
-33825,
-33840,
-33862,
-33893,
-33921,
-33933,
-33951,
-33969,
-33994,
-34002,
-34015,
-34009,
-34030,
-34023,
-34015,
-33993,
-33957,
-33944,
-33910,
-33908,
-33887,
-33917,
-33926,
-33936,
-33919,
-33903,
-33900,
-33936,
-33949,
-33956,
-33936,
-33919,
-33937,
-33943,
-33967,
-33947,
-33949,
-33950,
-33958,
-33983,
-33978,
-33980,
-33977,
-33969,
-33962,
-33946,
-33925,
-33918,
-33904,
-33904,
-33880,
-33881,
-33856,
-33861,
-33844,
-33851,
-33847,
-33855,
-33851,
-33832,
-33821,
-33798,
-33790,
-33771,
-33745,
-33696,
-33656,
-33597,
-33565,
-33511,
-33483,
-33439,
-33413,
-33377,
-33336,
-33300,
-33269,
-33243,
-33221,
-33177,
-33137,
-33081,
-33067,
-33042,
-33044,
-33007,
-32979,
-32925,
-32899,
-32867,
-32858,
-32839,
-32833,
-32814,
-32797,
-32763,
-32738,
-32703,
-32702,
-32682,
-32667,
-32625,
-32579,
-32548,
-32547,
-32537,
-32541,
-32516,
-32493,
-32482,
-32476,
-32476,
-32481,
-32474,
-32473,
-32477,
-32478,
-32493,
-32498,
-32503,
-32498,
-32486,
-32486,
-32499,
-32515,
-32531,
-32498,
-32476,
-32417,
-32419,
-32409,
-32410,
-32374,
-32320,
-32265,
-32244,
-32236,
-32231,
-32210,
-32183,
-32164,
-32150,
-32150,
-32141,
-32138,
-32143,
-32156,
-32167,
-32176,
-32180,
-32195,
-32212,
-32231,
-32250,
-32257,
-32285,
-32293,
-32283,
-32260,
-32211,
-32174,
-32148,
-32112,
-32088,
-32068,
-32052,
-32052,
-32032,
-32008,
-31974,
-31953,
-31937,
-31936,
-31938,
-31950,
-31948,
-31943,
-31909,
-31895,
-31899,
-31943,
-31985,
-32014,
-32010,
-32002,
-32008,
-32034,
-32068,
-32103,
-32114,
-32130,
-32139,
-32145,
-32165,
-32180,
-32194,
-32220,
-32224,
-32237,
-32244,
-32267,
-32282,
-32323,
-32334,
-32368,
-32383,
-32417,
-32448,
-32494,
-32543,
-32577,
-32613,
-32634,
-32643,
-32680,
-32676,
-32715,
-32718,
-32747,
-32771,
-32799,
-32827,
-32843,
-32862,
-32875,
-32895,
-32927,
-32958,
-32986,
-33015,
-33038,
-33078,
-33110,
-33145,
-33156,
-33165,
-33157,
-33161,
-33154,
-33166,
-33149,
-33165,
-33154,
-33166,
-33178,
-33187,
-33199,
-33211,
-33223,
-33231,
-33257,
-33270,
-33296,
-33328,
-33332,
-33350,
-33358,
-33360,
-33384,
-33393,
-33400,
-33431,
-33432,
-33473,
-33486,
-33508,
-33524,
-33512,
-33516,
-33494,
-33505,
-33517,
-33548,
-33548,
-33549,
-33518,
-33499,
-33492,
-33468,
-33476,
-33461,
-33470,
-33470,
-33474,
-33460,
-33472,
-33462,
-33475,
-33460,
-33450,
-33445,
-33461,
-33482,
-33504,
-33511,
-33520,
-33523,
-33522,
-33511,
-33497,
-33486,
-33488,
-33470,
-33461,
-33421,
-33401,
-33388,
-33366,
-33365,
-33323,
-33314,
-33275,
-33268,
-33239,
-33235,
-33203,
-33194,
-33133,
-33110,
-33057,
-33051,
-33039,
-33026,
-33027,
-33000,
-33000,
-32978,
-32955,
-32928,
-32891,
-32850,
-32823,
-32771,
-32748,
-32707,
-32686,
-32645,
-32609,
-32556,
-32520,
-32485,
-32442,
-32413,
-32368,
-32338,
-32300,
-32272,
-32228,
-32215,
-32182,
-32184,
-32164,
-32157,
-32149,
-32146,
-32160,
-32158,
-32166,
-32165,
-32154,
-32154,
-32133,
-32121,
-32092,
-32065,
-32019,
-31974,
-31932,
-31902,
-31897,
-31883,
-31875,
-31860,
-31852,
-31847,
-31839,
-31843,
-31837,
-31851,
-31857,
-31853,
-31870,
-31852,
-31869,
-31870,
-31868,
-31887,
-31885,
-31898,
-31901,
-31885,
-31883,
-31870,
-31872,
-31873,
-31857,
-31857,
-31846,
-31850,
-31864,
-31866,
-31883,
-31883,
-31911,
-31922,
-31953,
-31965,
-31986,
-31996,
-32013,
-32035,
-32056,
-32093,
-32114,
-32160,
-32185,
-32232,
-32247,
-32287,
-32296,
-32340,
-32352,
-32385,
-32393,
-32415,
-32422,
-32439,
-32451,
-32453,
-32463,
-32467,
-32490,
-32506,
-32544,
-32548,
-32590,
-32593,
-32635,
-32638,
-32656,
-32657,
-32659,
-32681,
-32689,
-32718,
-32728,
-32748,
-32756,
-32748,
-32742,
-32729,
-32734,
-32747,
-32740,
-32736,
-32709,
-32687,
-32674,
-32662,
-32666,
-32667,
-32666,
-32658,
-32634,
-32633,
-32624,
-32646,
-32651,
-32660,
-32653,
-32658,
-32667,
-32680,
-32700,
-32714,
-32717,
-32717,
-32706,
-32693,
-32692,
-32678,
-32666,
-32641,
-32613,
-32593,
-32557,
-32536,
-32499,
-32474,
-32463,
-32437,
-32420,
-32385,
-32361,
-32339,
-32307,
-32288,
-32245,
-32218,
-32169,
-32123,
-32069,
-32036,
-32000,
-31977,
-31928,
-31883,
-31828,
-31793,
-31766,
-31739,
-31726,
-31699,
-31700,
-31671,
-31662,
-31643,
-31645,
-31659,
-31657,
-31651,
-31623,
-31624,
-31621,
-31629,
-31608,
-31587,
-31551,
-31565,
-31573,
-31592,
-31589,
-31559,
-31567,
-31546,
-31576,
-31551,
-31561,
-31554,
-31574,
-31585,
-31579,
-31566,
-31566,
-31565,
-31585,
-31576,
-31580,
-31593,
-31613,
-31648,
-31656,
-31685,
-31703,
-31742,
-31771,
-31792,
-31807,
-31837,
-31865,
-31921,
-31954,
-32020,
-32066,
-32128,
-32155,
-32195,
-32232,
-32280,
-32330,
-32342,
-32353,
-32345,
-32357,
-32373,
-32407,
-32443,
-32479,
-32516,
-32535,
-32558,
-32566,
-32594,
-32617,
-32653,
-32686,
-32707,
-32737,
-32750,
-32775,
-32798,
-32818,
-32839,
-32843,
-32846,
-32839,
-32844,
-32842,
-32840,
-32824,
-32826,
-32832,
-32847,
-32861,
-32858,
-32862,
-32853,
-32867,
-32859,
-32869,
-32863,
-32868,
-32896,
-32907,
-32924,
-32905,
-32880,
-32862,
-32840,
-32822,
-32778,
-32738,
-32693,
-32680,
-32660,
-32650,
-32622,
-32599,
-32575,
-32560,
-32542,
-32515,
-32502,
-32476,
-32481,
-32479,
-32491,
-32499,
-32513,
-32503,
-32510,
-32492,
-32510,
-32513,
-32528,
-32524,
-32507,
-32492,
-32485,
-32472,
-32483,
-32466,
-32464,
-32431,
-32403,
-32352,
-32339,
-32324,
-32341,
-32343,
-32325,
-32318,
-32305,
-32323,
-32342,
-32360,
-32386,
-32417,
-32450,
-32492,
-32523,
-32572,
-32625,
-32675,
-32697,
-32708,
-32704,
-32747,
-32774,
-32828,
-32848,
-32882,
-32896,
-32931,
-32926,
-32957,
-32978,
-33033,
-33061,
-33084,
-33066,
-33085,
-33089,
-33121,
-33126,
-33143,
-33138,
-33168,
-33157,
-33176,
-33166,
-33189,
-33211,
-33232,
-33253,
-33263,
-33280,
-33291,
-33303,
-33312,
-33336,
-33366,
-33391,
-33410,
-33424,
-33429,
-33454,
-33449,
-33451,
-33440,
-33440,
-33444,
-33439,
-33417,
-33384,
-33354,
-33328,
-33302,
-33279,
-33267,
-33255,
-33254,
-33237,
-33201,
-33186,
-33140,
-33119,
-33058,
-33026,
-32975,
-32973,
-32941,
-32928,
-32892,
-32868,
-32840,
-32817,
-32778,
-32747,
-32712,
-32683,
-32648,
-32615,
-32580,
-32551,
-32538,
-32512,
-32502,
-32484,
-32480,
-32481,
-32493,
-32507,
-32530,
-32555,
-32583,
-32599,
-32611,
-32628,
-32648,
-32680,
-32685,
-32671,
-32631,
-32602,
-32595,
-32593,
-32608,
-32582,
-32592,
-32573,
-32604,
-32604,
-32628,
-32634,
-32664,
-32685,
-32709,
-32724,
-32741,
-32768,
-32792,
-32814,
-32813,
-32829,
-32832,
-32880,
-32902,
-32944,
-32966,
-33001,
-33025,
-33051,
-33064,
-33088,
-33122,
-33159,
-33189,
-33215,
-33245,
-33279,
-33318,
-33340,
-33341,
-33330,
-33323,
-33319,
-33331,
-33329,
-33331,
-33317,
-33317,
-33299,
-33300,
-33284,
-33289,
-33281,
-33291,
-33269,
-33266,
-33239,
-33242,
-33230,
-33224,
-33200,
-33172,
-33165,
-33153,
-33166,
-33143,
-33128,
-33087,
-33063,
-33032,
-33003,
-32974,
-32950,
-32938,
-32921,
-32903,
-32876,
-32856,
-32839,
-32826,
-32821,
-32804,
-32813,
-32794,
-32787,
-32750,
-32731,
-32714,
-32701,
-32691,
-32633,
-32605,
-32564,
-32557,
-32541,
-32503,
-32476,
-32441,
-32444,
-32437,
-32440,
-32425,
-32440,
-32442,
-32463,
-32456,
-32450,
-32453,
-32464,
-32478,
-32484,
-32478,
-32484,
-32489,
-32501,
-32514,
-32513,
-32534,
-32551,
-32589,
-32625,
-32654,
-32671,
-32685,
-32700,
-32717,
-32743,
-32756,
-32791,
-32823,
-32874,
-32914,
-32963,
-32986,
-33018,
-33040,
-33063,
-33095,
-33118,
-33136,
-33159,
-33174,
-33210,
-33258,
-33291,
-33321,
-33322,
-33324,
-33343,
-33353,
-33370,
-33365,
-33370,
-33378,
-33393,
-33395,
-33381,
-33357,
-33348,
-33340,
-33354,
-33347,
-33346,
-33310,
-33303,
-33281,
-33294,
-33301,
-33296,
-33289,
-33278,
-33280,
-33299,
-33307,
-33306,
-33308,
-33294,
-33294,
-33269,
-33260,
-33235,
-33251,
-33244,
-33242,
-33216,
-33181,
-33153,
-33130,
-33098,
-33088,
-33058,
-33057,
-33028,
-33005,
-32964,
-32926,
-32899,
-32881,
-32877,
-32871,
-32871,
-32860,
-32851,
-32837,
-32825,
-32809,
-32794,
-32772,
-32748,
-32730,
-32696,
-32680,
-32645,
-32632,
-32603,
-32587,
-32546,
-32526,
-32498,
-32514,
-32511,
-32514,
-32491,
-32470,
-32465,
-32478,
-32483,
-32511,
-32500,
-32521,
-32536,
-32568,
-32591,
-32614,
-32612,
-32648,
-32664,
-32699,
-32707,
-32695,
-32705,
-32720,
-32755,
-32802,
-32826,
-32869,
-32903,
-32927,
-32939,
-32920,
-32923,
-32924,
-32958,
-32966,
-32980,
-32987,
-32992,
-33022,
-33028,
-33047,
-33061,
-33072,
-33089,
-33096,
-33098,
-33118,
-33130,
-33155,
-33174,
-33196,
-33223,
-33262,
-33278,
-33316,
-33321,
-33359,
-33389,
-33419,
-33452,
-33465,
-33494,
-33528,
-33566,
-33608,
-33639,
-33643,
-33632,
-33602,
-33563,
-33543,
-33535,
-33535,
-33544,
-33521,
-33514,
-33487,
-33491,
-33491,
-33472,
-33454,
-33418,
-33408,
-33402,
-33394,
-33382,
-33352,
-33340,
-33315,
-33289,
-33274,
-33252,
-33256,
-33249,
-33230,
-33206,
-33175,
-33164,
-33141,
-33129,
-33097,
-33066,
-33037,
-33012,
-32985,
-32960,
-32942,
-32914,
-32904,
-32863,
-32844,
-32813,
-32777,
-32763,
-32704,
-32689,
-32642,
-32619,
-32592,
-32567,
-32554,
-32523,
-32499,
-32467,
-32451,
-32446,
-32439,
-32414,
-32389,
-32352,
-32352,
-32334,
-32317,
-32270,
-32225,
-32193,
-32193,
-32178,
-32165,
-32130,
-32114,
-32119,
-32122,
-32142,
-32115,
-32119,
-32083,
-32073,
-32040,
-32034,
-32019,
-32036,
-32035,
-32042,
-32035,
-32036,
-32046,
-32060,
-32069,
-32065,
-32052,
-32033,
-32031,
-32015,
-32026,
-32006,
-32013,
-32005,
-32035,
-32045,
-32072,
-32068,
-32079,
-32085,
-32108,
-32118,
-32135,
-32148,
-32188,
-32225,
-32260,
-32270,
-32265,
-32266,
-32275,
-32293,
-32318,
-32306,
-32316,
-32299,
-32304,
-32314,
-32298,
-32309,
-32294,
-32317,
-32337,
-32374,
-32395,
-32416,
-32417,
-32430,
-32445,
-32483,
-32528,
-32563,
-32601,
-32620,
-32661,
-32709,
-32749,
-32802,
-32836,
-32880,
-32926,
-32941,
-32951,
-32924,
-32915,
-32902,
-32912,
-32918,
-32928,
-32916,
-32917,
-32887,
-32894,
-32877,
-32881,
-32857,
-32848,
-32839,
-32854,
-32864,
-32868,
-32848,
-32831,
-32819,
-32828,
-32843,
-32875,
-32885,
-32902,
-32875,
-32883,
-32888,
-32933,
-32974,
-32992,
-32989,
-32985,
-32990,
-33013,
-33034,
-33035,
-33058,
-33061,
-33107,
-33108,
-33132,
-33103,
-33120,
-33113,
-33135,
-33145,
-33127,
-33121,
-33093,
-33088,
-33067,
-33041,
-33015,
-32995,
-32980,
-32963,
-32921,
-32877,
-32836,
-32794,
-32769,
-32723,
-32704,
-32675,
-32672,
-32657,
-32644,
-32620,
-32591,
-32559,
-32522,
-32495,
-32484,
-32485,
-32478,
-32482,
-32451,
-32434,
-32396,
-32364,
-32340,
-32319,
-32311,
-32290,
-32287,
-32280,
-32292,
-32301,
-32292,
-32277,
-32261,
-32262,
-32261,
-32255,
-32236,
-32208,
-32186,
-32160,
-32144,
-32121,
-32114,
-32116,
-32117,
-32118,
-32094,
-32054,
-32020,
-31985,
-31991,
-31991,
-31995,
-31975,
-31958,
-31945,
-31939,
-31936,
-31911,
-31906,
-31886,
-31881,
-31871,
-31846,
-31832,
-31818,
-31793,
-31797,
-31751,
-31765,
-31734,
-31738,
-31728,
-31704,
-31717,
-31701,
-31708,
-31706,
-31708,
-31720,
-31715,
-31710,
-31688,
-31689,
-31685,
-31687,
-31670,
-31663,
-31658,
-31682,
-31691,
-31708,
-31707,
-31705,
-31707,
-31701,
-31697,
-31698,
-31707,
-31711,
-31720,
-31715,
-31718,
-31738,
-31752,
-31782,
-31794,
-31803,
-31816,
-31829,
-31850,
-31881,
-31915,
-31953,
-31985,
-32007,
-32018,
-32023,
-32038,
-32058,
-32093,
-32121,
-32165,
-32178,
-32219,
-32221,
-32245,
-32259,
-32290,
-32325,
-32341,
-32359,
-32371,
-32399,
-32430,
-32452,
-32465,
-32484,
-32508,
-32535,
-32552,
-32556,
-32579,
-32604,
-32646,
-32666,
-32676,
-32696,
-32713,
-32760,
-32790,
-32813,
-32844,
-32856,
-32896,
-32908,
-32937,
-32952,
-32974,
-33005,
-33010,
-33032,
-33035,
-33045,
-33070,
-33076,
-33099,
-33117,
-33131,
-33163,
-33173,
-33193,
-33192,
-33201,
-33203,
-33212,
-33225,
-33219,
-33229,
-33231,
-33232,
-33247,
-33237,
-33245,
-33254,
-33239,
-33247,
-33213,
-33209,
-33207,
-33212,
-33221,
-33230,
-33223,
-33221,
-33214,
-33199,
-33208,
-33200,
-33216,
-33202,
-33214,
-33216,
-33243,
-33274,
-33288,
-33300,
-33313,
-33325,
-33346,
-33351,
-33348,
-33346,
-33356,
-33356,
-33379,
-33366,
-33390,
-33398,
-33423,
-33436,
-33439,
-33441,
-33447,
-33461,
-33468,
-33475,
-33462,
-33464,
-33445,
-33451,
-33450,
-33472,
-33494,
-33521,
-33529,
-33531,
-33523,
-33529,
-33522,
-33531,
-33518,
-33512,
-33504,
-33494,
-33476,
-33464,
-33463,
-33475,
-33493,
-33494,
-33483,
-33467,
-33464,
-33480,
-33493,
-33505,
-33499,
-33486,
-33483,
-33496,
-33507,
-33537,
-33553,
-33565,
-33568,
-33565,
-33549,
-33557,
-33551,
-33563,
-33572,
-33566,
-33575,
-33575,
-33578,
-33580,
-33565,
-33555,
-33529,
-33498,
-33454,
-33414,
-33383,
-33360,
-33347,
-33314,
-33290,
-33262,
-33245,
-33226,
-33194,
-33163,
-33123,
-33109,
-33073,
-33060,
-33014,
-32989,
-32957,
-32925,
-32908,
-32879,
-32871,
-32843,
-32804,
-32765,
-32722,
-32710,
-32698,
-32673,
-32660,
-32626,
-32622,
-32600,
-32590,
-32553,
-32542,
-32530,
-32542,
-32553,
-32551,
-32540,
-32522,
-32513,
-32511,
-32512,
-32498,
-32477,
-32442,
-32429,
-32409,
-32415,
-32389,
-32384,
-32360,
-32350,
-32339,
-32324,
-32318,
-32311,
-32318,
-32311,
-32313,
-32299,
-32300,
-32285,
-32283,
-32271,
-32258,
-32262,
-32240,
-32229,
-32202,
-32188,
-32179,
-32181,
-32160,
-32158,
-32140,
-32130,
-32125,
-32108,
-32100,
-32092,
-32084,
-32088,
-32076,
-32087,
-32082,
-32096,
-32095,
-32092,
-32082,
-32073,
-32057,
-32057,
-32038,
-32047,
-32050,
-32073,
-32089,
-32112,
-32110,
-32128,
-32119,
-32126,
-32130,
-32119,
-32139,
-32122,
-32146,
-32127,
-32133,
-32110,
-32104,
-32102,
-32101,
-32100,
-32077,
-32063,
-32042,
-32046,
-32052,
-32054,
-32068,
-32058,
-32055,
-32042,
-32014,
-32028,
-32017,
-32043,
-32046,
-32050,
-32045,
-32042,
-32028,
-32024,
-32010,
-32002,
-31982,
-31959,
-31923,
-31894,
-31876,
-31859,
-31851,
-31827,
-31810,
-31808,
-31808,
-31812,
-31811,
-31815,
-31832,
-31859,
-31886,
-31905,
-31916,
-31924,
-31935,
-31934,
-31940,
-31933,
-31935,
-31939,
-31942,
-31957,
-31963,
-31984,
-31993,
-32006,
-32009,
-32000,
-31975,
-31952,
-31928,
-31933,
-31932,
-31932,
-31912,
-31898,
-31880,
-31892,
-31878,
-31873,
-31861,
-31852,
-31877,
-31883,
-31897,
-31905,
-31904,
-31930,
-31937,
-31960,
-31982,
-32008,
-32049,
-32081,
-32120,
-32145,
-32180,
-32195,
-32214,
-32211,
-32219,
-32228,
-32245,
-32260,
-32259,
-32259,
-32259,
-32260,
-32279,
-32288,
-32311,
-32317,
-32322,
-32320,
-32342,
-32351,
-32385,
-32383,
-32402,
-32423,
-32460,
-32496,
-32515,
-32525,
-32532,
-32560,
-32592,
-32625,
-32656,
-32679,
-32720,
-32743,
-32777,
-32775,
-32798,
-32803,
-32840,
-32871,
-32900,
-32934,
-32956,
-32980,
-32985,
-32988,
-32984,
-32983,
-32992,
-32982,
-32993,
-33001,
-33028,
-33049,
-33060,
-33060,
-33057,
-33077,
-33092,
-33103,
-33105,
-33095,
-33103,
-33107,
-33112,
-33110,
-33109,
-33118,
-33131,
-33131,
-33140,
-33134,
-33148,
-33145,
-33145,
-33142,
-33152,
-33161,
-33175,
-33172,
-33179,
-33182,
-33205,
-33195,
-33214,
-33188,
-33220,
-33217,
-33241,
-33249,
-33265,
-33289,
-33329,
-33337,
-33365,
-33372,
-33405,
-33432,
-33469,
-33475,
-33504,
-33500,
-33510,
-33479,
-33474,
-33447,
-33451,
-33438,
-33430,
-33410,
-33403,
-33397,
-33399,
-33395,
-33399,
-33390,
-33405,
-33396,
-33407,
-33397,
-33385,
-33382,
-33357,
-33365,
-33362,
-33378,
-33389,
-33398,
-33398,
-33409,
-33415,
-33433,
-33437,
-33436,
-33425,
-33407,
-33402,
-33399,
-33387,
-33378,
-33341,
-33334,
-33319,
-33321,
-33314,
-33303,
-33292,
-33299,
-33287,
-33300,
-33291,
-33306,
-33318,
-33343,
-33356,
-33373,
-33378,
-33386,
-33393,
-33395,
-33409,
-33420,
-33442,
-33459,
-33466,
-33477,
-33473,
-33483,
-33480,
-33489,
-33486,
-33489,
-33482,
-33484,
-33475,
-33486,
-33491,
-33500,
-33503,
-33508,
-33514,
-33529,
-33534,
-33538,
-33527,
-33530,
-33509,
-33520,
-33505,
-33518,
-33517,
-33514,
-33508,
-33480,
-33467,
-33437,
-33434,
-33409,
-33402,
-33386,
-33363,
-33353,
-33318,
-33301,
-33260,
-33233,
-33202,
-33182,
-33169,
-33151,
-33127,
-33083,
-33053,
-33019,
-33011,
-33008,
-32998,
-32986,
-32969,
-32950,
-32951,
-32938,
-32942,
-32917,
-32898,
-32873,
-32847,
-32841,
-32817,
-32812,
-32799,
-32790,
-32788,
-32773,
-32755,
-32728,
-32684,
-32660,
-32612,
-32601,
-32564,
-32562,
-32520,
-32518,
-32461,
-32461,
-32418,
-32419,
-32395,
-32369,
-32353,
-32322,
-32315,
-32300,
-32283,
-32274,
-32247,
-32234,
-32202,
-32191,
-32178,
-32187,
-32181,
-32178,
-32158,
-32154,
-32155,
-32169,
-32172,
-32174,
-32169,
-32161,
-32149,
-32146,
-32125,
-32135,
-32116,
-32115,
-32102,
-32113,
-32124,
-32144,
-32145,
-32139,
-32148,
-32141,
-32158,
-32132,
-32134,
-32124,
-32133,
-32133,
-32114,
-32096,
-32082,
-32085,
-32088,
-32071,
-32056,
-32045,
-32035,
-32036,
-32026,
-32028,
-32035,
-32044,
-32053,
-32034,
-32036,
-32025,
-32044,
-32053,
-32063,
-32059,
-32059,
-32073,
-32090,
-32132,
-32155,
-32191,
-32168,
-32158,
-32092,
-32083,
-32060,
-32078,
-32080,
-32067,
-32033,
-32001,
-31969,
-31975,
-31969,
-31983,
-31973,
-31968,
-31955,
-31944,
-31946,
-31947,
-31975,
-31977,
-32020,
-32013,
-32047,
-32051,
-32073,
-32110,
-32145,
-32171,
-32200,
-32207,
-32229,
-32257,
-32274,
-32312,
-32300,
-32333,
-32327,
-32357,
-32362,
-32371,
-32378,
-32392,
-32411,
-32433,
-32444,
-32460,
-32465,
-32490,
-32519,
-32561,
-32594,
-32620,
-32626,
-32651,
-32674,
-32715,
-32748,
-32767,
-32783,
-32817,
-32860,
-32930,
-32964,
-33004,
-33010,
-33034,
-33040,
-33070,
-33066,
-33107,
-33118,
-33169,
-33185,
-33209,
-33228,
-33232,
-33255,
-33243,
-33263,
-33256,
-33284,
-33302,
-33322,
-33332,
-33345,
-33344,
-33345,
-33345,
-33328,
-33343,
-33331,
-33337,
-33329,
-33322,
-33326,
-33326,
-33317,
-33321,
-33308,
-33320,
-33324,
-33322,
-33342,
-33335,
-33350,
-33355,
-33365,
-33386,
-33409,
-33443,
-33475,
-33505,
-33539,
-33571,
-33615,
-33654,
-33676,
-33689,
-33671,
-33665,
-33634,
-33640,
-33627,
-33649,
-33652,
-33672,
-33677,
-33682,
-33678,
-33678,
-33680,
-33697,
-33710,
-33707,
-33702,
-33669,
-33661,
-33626,
-33611,
-33576,
-33532,
-33508,
-33459,
-33445,
-33419,
-33398,
-33392,
-33371,
-33358,
-33344,
-33339,
-33336,
-33348,
-33342,
-33347,
-33339,
-33342,
-33347,
-33338,
-33332,
-33303,
-33283,
-33243,
-33222,
-33185,
-33166,
-33127,
-33078,
-33035,
-32991,
-32982,
-32956,
-32937,
-32902,
-32863,
-32845,
-32812,
-32800,
-32770,
-32748,
-32716,
-32690,
-32636,
-32608,
-32575,
-32563,
-32545,
-32519,
-32473,
-32453,
-32424,
-32419,
-32419,
-32404,
-32407,
-32392,
-32396,
-32392,
-32404,
-32419,
-32427,
-32423,
-32405,
-32398,
-32390,
-32405,
-32388,
-32391,
-32361,
-32362,
-32342,
-32343,
-32326,
-32327,
-32310,
-32297,
-32277,
-32248,
-32245,
-32231,
-32229,
-32232,
-32211,
-32231,
-32212,
-32229,
-32219,
-32210,
-32211,
-32191,
-32182,
-32166,
-32147,
-32159,
-32153,
-32171,
-32172,
-32188,
-32197,
-32217,
-32227,
-32252,
-32262,
-32284,
-32297,
-32314,
-32360,
-32388,
-32438,
-32456,
-32463,
-32490,
-32495,
-32541,
-32552,
-32574,
-32585,
-32595,
-32620,
-32614,
-32618,
-32601,
-32615,
-32615,
-32641,
-32634,
-32665,
-32670,
-32721,
-32730,
-32764,
-32774,
-32791,
-32822,
-32847,
-32888,
-32912,
-32943,
-32946,
-32966,
-32971,
-32986,
-32999,
-32997,
-33007,
-33011,
-33033,
-33051,
-33059,
-33058,
-33054,
-33055,
-33059,
-33066,
-33069,
-33075,
-33078,
-33081,
-33084,
-33084,
-33095,
-33084,
-33094,
-33083,
-33086,
-33090,
-33091,
-33089,
-33083,
-33079,
-33069,
-33081,
-33079,
-33086,
-33082,
-33055,
-33036,
-33013,
-33003,
-33006,
-33000,
-32996,
-32977,
-32964,
-32945,
-32937,
-32922,
-32906,
-32886,
-32855,
-32845,
-32821,
-32822,
-32808,
-32806,
-32786,
-32781,
-32758,
-32739,
-32712,
-32678,
-32664,
-32635,
-32638,
-32626,
-32608,
-32603,
-32554,
-32529,
-32487,
-32443,
-32423,
-32379,
-32366,
-32340,
-32331,
-32309,
-32297,
-32263,
-32260,
-32229,
-32230,
-32202,
-32200,
-32186,
-32192,
-32173,
-32176,
-32158,
-32166,
-32175,
-32181,
-32200,
-32211,
-32226,
-32249,
-32255,
-32273,
-32288,
-32312,
-32341,
-32358,
-32379,
-32393,
-32422,
-32444,
-32460,
-32473,
-32476,
-32483,
-32487,
-32489,
-32488,
-32505,
-32515,
-32545,
-32564,
-32581,
-32607,
-32618,
-32651,
-32661,
-32690,
-32720,
-32755,
-32798,
-32813,
-32831,
-32833,
-32852,
-32873,
-32892,
-32917,
-32928,
-32954,
-32973,
-33001,
-33028,
-33051,
-33070,
-33069,
-33069,
-33047,
-33038,
-33012,
-32998,
-32985,
-32974,
-32963,
-32936,
-32916,
-32890,
-32887,
-32874,
-32867,
-32841,
-32828,
-32806,
-32803,
-32768,
-32767,
-32729,
-32730,
-32708,
-32682,
-32656,
-32634,
-32625,
-32625,
-32623,
-32607,
-32587,
-32563,
-32527,
-32510,
-32471,
-32473,
-32455,
-32463,
-32459,
-32463,
-32471,
-32475,
-32487,
-32485,
-32479,
-32472,
-32451,
-32445,
-32444,
-32443,
-32454,
-32452,
-32446,
-32442,
-32405,
-32395,
-32359,
-32377,
-32390,
-32426,
-32448,
-32454,
-32467,
-32464,
-32489,
-32500,
-32520,
-32537,
-32529,
-32540,
-32523,
-32526,
-32537,
-32550,
-32574,
-32587,
-32593,
-32604,
-32611,
-32631,
-32642,
-32656,
-32653,
-32665,
-32675,
-32706,
-32746,
-32777,
-32809,
-32827,
-32845,
-32849,
-32849,
-32828,
-32830,
-32824,
-32845,
-32840,
-32831,
-32822,
-32813,
-32822,
-32811,
-32809,
-32789,
-32795,
-32792,
-32800,
-32784,
-32765,
-32743,
-32731,
-32728,
-32723,
-32716,
-32703,
-32698,
-32694,
-32693,
-32685,
-32659,
-32645,
-32622,
-32626,
-32624,
-32637,
-32638,
-32634,
-32637,
-32596,
-32574,
-32516,
-32491,
-32464,
-32444,
-32417,
-32386,
-32355,
-32346,
-32325,
-32312,
-32293,
-32282,
-32276,
-32275,
-32263,
-32253,
-32245,
-32246,
-32237,
-32261,
-32257,
-32287,
-32287,
-32290,
-32302,
-32308,
-32349,
-32372,
-32396,
-32413,
-32421,
-32449,
-32476,
-32508,
-32535,
-32557,
-32579,
-32604,
-32633,
-32662,
-32699,
-32718,
-32759,
-32767,
-32781,
-32776,
-32766,
-32762,
-32766,
-32777,
-32797,
-32805,
-32790,
-32777,
-32754,
-32758,
-32758,
-32754,
-32742,
-32716,
-32701,
-32667,
-32655,
-32618,
-32621,
-32615,
-32623,
-32626,
-32625,
-32622,
-32626,
-32614,
-32596,
-32588,
-32582,
-32601,
-32615,
-32601,
-32594,
-32571,
-32566,
-32561,
-32537,
-32514,
-32475,
-32453,
-32432,
-32403,
-32386,
-32357,
-32346,
-32338,
-32327,
-32340,
-32334,
-32345,
-32350,
-32357,
-32375,
-32389,
-32406,
-32419,
-32433,
-32440,
-32449,
-32442,
-32448,
-32467,
-32476,
-32496,
-32482,
-32483,
-32491,
-32515,
-32548,
-32554,
-32565,
-32569,
-32584,
-32598,
-32608,
-32612,
-32631,
-32639,
-32652,
-32653,
-32645,
-32649,
-32638,
-32647,
-32632,
-32637,
-32624,
-32633,
-32652,
-32678,
-32723,
-32757,
-32777,
-32799,
-32807,
-32850,
-32879,
-32914,
-32909,
-32902,
-32884,
-32875,
-32898,
-32892,
-32913,
-32906,
-32909,
-32915,
-32912,
-32902,
-32865,
-32844,
-32775,
-32779,
-32741,
-32748,
-32729,
-32689,
-32644,
-32608,
-32580,
-32585,
-32557,
-32534,
-32485,
-32463,
-32457,
-32451,
-32451,
-32421,
-32424,
-32414,
-32428,
-32424,
-32418,
-32410,
-32408,
-32404,
-32390,
-32372,
-32357,
-32354,
-32356,
-32360,
-32358,
-32368,
-32385,
-32402,
-32404,
-32394,
-32373,
-32377,
-32397,
-32419,
-32446,
-32453,
-32459,
-32472,
-32471,
-32503,
-32521,
-32546,
-32559,
-32544,
-32561,
-32566,
-32618,
-32652,
-32688,
-32704,
-32739,
-32793,
-32849,
-32916,
-32942,
-32959,
-32957,
-32950,
-32952,
-32957,
-32983,
-32973,
-33000,
-32983,
-33008,
-33007,
-33021,
-33007,
-33010,
-33005,
-33006,
-33021,
-33015,
-33023,
-33007,
-32986,
-32972,
-32951,
-32947,
-32935,
-32904,
-32897,
-32882,
-32885,
-32879,
-32869,
-32848,
-32856,
-32843,
-32847,
-32810,
-32791,
-32776,
-32771,
-32762,
-32738,
-32712,
-32699,
-32689,
-32678,
-32663,
-32645,
-32642,
-32630,
-32626,
-32615,
-32619,
-32634,
-32651,
-32668,
-32669,
-32672,
-32685,
-32694,
-32690,
-32689,
-32666,
-32676,
-32670,
-32670,
-32641,
-32636,
-32615,
-32625,
-32630,
-32627,
-32627,
-32614,
-32605,
-32601,
-32590,
-32589,
-32585,
-32587,
-32588,
-32590,
-32594,
-32613,
-32632,
-32663,
-32669,
-32678,
-32677,
-32685,
-32712,
-32734,
-32779,
-32799,
-32835,
-32856,
-32877,
-32909,
-32923,
-32943,
-32947,
-32943,
-32941,
-32930,
-32942,
-32943,
-32952,
-32958,
-32959,
-32984,
-32998,
-33046,
-33066,
-33097,
-33115,
-33133,
-33161,
-33187,
-33220,
-33245,
-33266,
-33276,
-33276,
-33288,
-33290,
-33301,
-33296,
-33278,
-33264,
-33243,
-33242,
-33228,
-33231,
-33206,
-33207,
-33184,
-33174,
-33140,
-33120,
-33096,
-33086,
-33066,
-33042,
-33008,
-32978,
-32961,
-32945,
-32933,
-32913,
-32895,
-32875,
-32869,
-32851,
-32852,
-32843,
-32856,
-32845,
-32843,
-32817,
-32799,
-32790,
-32767,
-32749,
-32713,
-32691,
-32682,
-32685,
-32683,
-32699,
-32703,
-32726,
-32735,
-32739,
-32732,
-32730,
-32710,
-32695,
-32660,
-32651,
-32635,
-32636,
-32628,
-32615,
-32603,
-32590,
-32575,
-32560,
-32551,
-32542,
-32552,
-32557,
-32564,
-32568,
-32566,
-32563,
-32571,
-32579,
-32606,
-32632,
-32651,
-32657,
-32659,
-32664,
-32691,
-32717,
-32750,
-32760,
-32771,
-32778,
-32807,
-32841,
-32893,
-32926,
-32975,
-32991,
-33030,
-33045,
-33066,
-33093,
-33112,
-33135,
-33136,
-33112,
-33092,
-33072,
-33087,
-33104,
-33134,
-33153,
-33172,
-33188,
-33205,
-33197,
-33195,
-33186,
-33186,
-33208,
-33221,
-33232,
-33248,
-33240,
-33250,
-33238,
-33246,
-33242,
-33255,
-33259,
-33262,
-33281,
-33288,
-33309,
-33327,
-33338,
-33364,
-33359,
-33375,
-33363,
-33376,
-33372,
-33368,
-33353,
-33336,
-33322,
-33319,
-33307,
-33311,
-33308,
-33317,
-33318,
-33303,
-33276,
-33242,
-33215,
-33195,
-33177,
-33149,
-33126,
-33102,
-33078,
-33059,
-33032,
-33005,
-32993,
-32973,
-32961,
-32940,
-32924,
-32908,
-32907,
-32894,
-32889,
-32870,
-32854,
-32838,
-32829,
-32805,
-32794,
-32760,
-32755,
-32715,
-32726,
-32684,
-32702,
-32670,
-32676,
-32654,
-32658,
-32658,
-32656,
-32645,
-32617,
-32592,
-32571,
-32550,
-32527,
-32501,
-32483,
-32483,
-32490,
-32511,
-32514,
-32518,
-32514,
-32502,
-32498,
-32475,
-32471,
-32441,
-32436,
-32410,
-32406,
-32392,
-32387,
-32377,
-32382,
-32373,
-32378,
-32377,
-32376,
-32395,
-32409,
-32432,
-32442,
-32452,
-32455,
-32475,
-32506,
-32534,
-32569,
-32576,
-32589,
-32600,
-32626,
-32670,
-32710,
-32747,
-32769,
-32787,
-32806,
-32830,
-32867,
-32882,
-32911,
-32899,
-32916,
-32903,
-32931,
-32936,
-32960,
-32966,
-32968,
-32965,
-32970,
-32983,
-33005,
-33022,
-33048,
-33074,
-33104,
-33138,
-33141,
-33142,
-33122,
-33109,
-33115,
-33116,
-33136,
-33130,
-33141,
-33142,
-33158,
-33163,
-33197,
-33215,
-33266,
-33282,
-33308,
-33329,
-33360,
-33408,
-33426,
-33445,
-33421,
-33413,
-33387,
-33380,
-33359,
-33357,
-33331,
-33333,
-33315,
-33326,
-33335,
-33355,
-33375,
-33387,
-33380,
-33362,
-33322,
-33305,
-33298,
-33319,
-33338,
-33339,
-33340,
-33338,
-33360,
-33387,
-33404,
-33410,
-33408,
-33404,
-33416,
-33399,
-33405,
-33380,
-33387,
-33369,
-33369,
-33345,
-33353,
-33319,
-33313,
-33272,
-33246,
-33218,
-33195,
-33171,
-33153,
-33125,
-33092,
-33049,
-33007,
-32987,
-32983,
-32966,
-32913,
-32850,
-32792,
-32777,
-32762,
-32731,
-32680,
-32639,
-32638,
-32648,
-32653,
-32614,
-32593,
-32573,
-32589,
-32570,
-32540,
-32492,
-32482,
-32476,
-32495,
-32489,
-32489,
-32487,
-32493,
-32474,
-32467,
-32426,
-32409,
-32378,
-32345,
-32304,
-32278,
-32249,
-32254,
-32242,
-32245,
-32240,
-32229,
-32226,
-32207,
-32215,
-32206,
-32202,
-32172,
-32139,
-32108,
-32084,
-32069,
-32039,
-32019,
-32006,
-32001,
-31999,
-31990,
-31968,
-31957,
-31950,
-31943,
-31930,
-31899,
-31877,
-31852,
-31856,
-31837,
-31835,
-31814,
-31811,
-31802,
-31799,
-31791,
-31800,
-31806,
-31818,
-31813,
-31791,
-31782,
-31771,
-31800,
-31822,
-31856,
-31871,
-31880,
-31894,
-31905,
-31923,
-31929,
-31930,
-31920,
-31912,
-31902,
-31896,
-31874,
-31861,
-31854,
-31865,
-31880,
-31883,
-31884,
-31878,
-31895,
-31905,
-31919,
-31916,
-31928,
-31940,
-31982,
-32012,
-32029,
-32051,
-32066,
-32104,
-32132,
-32159,
-32173,
-32184,
-32219,
-32240,
-32291,
-32325,
-32382,
-32421,
-32476,
-32488,
-32508,
-32501,
-32504,
-32497,
-32490,
-32473,
-32467,
-32490,
-32507,
-32556,
-32555,
-32582,
-32575,
-32600,
-32618,
-32650,
-32671,
-32699,
-32711,
-32739,
-32747,
-32768,
-32758,
-32774,
-32754,
-32773,
-32751,
-32765,
-32757,
-32760,
-32775,
-32784,
-32802,
-32806,
-32810,
-32808,
-32826,
-32840,
-32854,
-32857,
-32856,
-32869,
-32874,
-32871,
-32859,
-32835,
-32835,
-32847,
-32858,
-32881,
-32878,
-32892,
-32908,
-32945,
-32974,
-33007,
-33009,
-33020,
-33011,
-33020,
-33016,
-33017,
-33011,
-33004,
-33001,
-33003,
-33004,
-33027,
-33037,
-33065,
-33071,
-33079,
-33089,
-33106,
-33128,
-33144,
-33152,
-33164,
-33180,
-33184,
-33187,
-33174,
-33165,
-33183,
-33163,
-33172,
-33137,
-33141,
-33142,
-33159,
-33160,
-33163,
-33159,
-33174,
-33173,
-33186,
-33165,
-33172,
-33161,
-33165,
-33151,
-33137,
-33115,
-33097,
-33094,
-33087,
-33100,
-33082,
-33086,
-33051,
-33055,
-33027,
-33040,
-33025,
-33037,
-33037,
-33040,
-33038,
-33020,
-33015,
-33000,
-32994,
-32966,
-32921,
-32893,
-32855,
-32847,
-32829,
-32814,
-32805,
-32799,
-32785,
-32781,
-32757,
-32744,
-32731,
-32703,
-32687,
-32655,
-32646,
-32630,
-32632,
-32628,
-32628,
-32621,
-32602,
-32564,
-32531,
-32504,
-32486,
-32466,
-32444,
-32410,
-32413,
-32399,
-32402,
-32376,
-32347,
-32332,
-32326,
-32311,
-32299,
-32259,
-32246,
-32223,
-32224,
-32212,
-32198,
-32193,
-32169,
-32172,
-32152,
-32149,
-32131,
-32118,
-32103,
-32103,
-32094,
-32111,
-32107,
-32118,
-32125,
-32124,
-32127,
-32115,
-32096,
-32087,
-32072,
-32078,
-32067,
-32066,
-32046,
-32036,
-32028,
-32014,
-32024,
-31995,
-31994,
-31959,
-31952,
-31926,
-31917,
-31888,
-31881,
-31873,
-31870,
-31874,
-31860,
-31856,
-31851,
-31861,
-31861,
-31864,
-31859,
-31850,
-31855,
-31856,
-31861,
-31861,
-31857,
-31854,
-31860,
-31878,
-31892,
-31933,
-31946,
-31985,
-31995,
-32009,
-32015,
-32000,
-32002,
-31987,
-31974,
-31969,
-31959,
-31965,
-31977,
-31971,
-31971,
-31956,
-31949,
-31947,
-31941,
-31939,
-31940,
-31941,
-31938,
-31934,
-31914,
-31913,
-31894,
-31891,
-31874,
-31878,
-31877,
-31883,
-31881,
-31886,
-31890,
-31918,
-31924,
-31946,
-31956,
-31982,
-32009,
-32031,
-32037,
-32030,
-32043,
-32041,
-32071,
-32080,
-32096,
-32114,
-32120,
-32138,
-32152,
-32174,
-32199,
-32221,
-32258,
-32281,
-32336,
-32350,
-32388,
-32386,
-32406,
-32426,
-32453,
-32477,
-32493,
-32516,
-32542,
-32585,
-32613,
-32642,
-32645,
-32648,
-32643,
-32664,
-32690,
-32728,
-32741,
-32739,
-32752,
-32759,
-32793,
-32805,
-32801,
-32817,
-32818,
-32859,
-32869,
-32897,
-32905,
-32940,
-32971,
-32994,
-33011,
-32999,
-33011,
-33010,
-33030,
-33048,
-33041,
-33043,
-33033,
-33050,
-33108,
-33132,
-33172,
-33170,
-33186,
-33230,
-33274,
-33313,
-33321,
-33334,
-33331,
-33348,
-33333,
-33325,
-33307,
-33320,
-33332,
-33340,
-33341,
-33350,
-33369,
-33407,
-33417,
-33422,
-33427,
-33445,
-33477,
-33484,
-33488,
-33474,
-33492,
-33510,
-33525,
-33520,
-33519,
-33520,
-33537,
-33536,
-33538,
-33526,
-33553,
-33557,
-33570,
-33567,
-33557,
-33578,
-33584,
-33599,
-33588,
-33581,
-33572,
-33581,
-33587,
-33611,
-33626,
-33659,
-33668,
-33697,
-33698,
-33735,
-33730,
-33747,
-33724,
-33739,
-33738,
-33751,
-33749,
-33733,
-33725,
-33731,
-33728,
-33732,
-33718,
-33713,
-33717,
-33728,
-33726,
-33724,
-33709,
-33705,
-33707,
-33712,
-33717,
-33710,
-33699,
-33702,
-33709,
-33731,
-33744,
-33742,
-33745,
-33737,
-33743,
-33741,
-33749,
-33745,
-33767,
-33762,
-33772,
-33762,
-33764,
-33778,
-33790,
-33795,
-33777,
-33760,
-33725,
-33708,
-33664,
-33629,
-33587,
-33565,
-33558,
-33550,
-33538,
-33510,
-33490,
-33479,
-33469,
-33447,
-33408,
-33356,
-33325,
-33292,
-33281,
-33244,
-33209,
-33169,
-33121,
-33098,
-33076,
-33045,
-33032,
-32982,
-32958,
-32935,
-32940,
-32935,
-32934,
-32900,
-32885,
-32868,
-32874,
-32852,
-32864,
-32839,
-32881,
-32879,
-32890,
-32864,
-32820,
-32800,
-32773,
-32766,
-32759,
-32737,
-32728,
-32697,
-32675,
-32628,
-32602,
-32554,
-32537,
-32501,
-32492,
-32462,
-32459,
-32450,
-32452,
-32445,
-32426,
-32402,
-32387,
-32374,
-32372,
-32341,
-32321,
-32296,
-32292,
-32279,
-32266,
-32240,
-32229,
-32231,
-32227,
-32231,
-32211,
-32231,
-32231,
-32247,
-32228,
-32210,
-32193,
-32173,
-32180,
-32154,
-32168,
-32162,
-32169,
-32148,
-32135,
-32113,
-32126,
-32134,
-32137,
-32126,
-32125,
-32117,
-32127,
-32126,
-32117,
-32128,
-32111,
-32112,
-32091,
-32088,
-32087,
-32096,
-32086,
-32080,
-32068,
-32068,
-32057,
-32052,
-32033,
-32036,
-32032,
-32027,
-32002,
-31992,
-31986,
-32007,
-32008,
-32022,
-32019,
-32053,
-32090,
-32132,
-32159,
-32169,
-32191,
-32208,
-32238,
-32248,
-32252,
-32269,
-32291,
-32335,
-32367,
-32379,
-32380,
-32375,
-32400,
-32437,
-32474,
-32496,
-32497,
-32511,
-32528,
-32558,
-32572,
-32582,
-32584,
-32611,
-32638,
-32659,
-32660,
-32646,
-32642,
-32649,
-32661,
-32667,
-32660,
-32650,
-32655,
-32667,
-32701,
-32726,
-32746,
-32748,
-32750,
-32756,
-32768,
-32784,
-32783,
-32794,
-32799,
-32834,
-32867,
-32911,
-32940,
-32976,
-33005,
-33051,
-33058,
-33083,
-33077,
-33103,
-33119,
-33147,
-33154,
-33168,
-33178,
-33184,
-33188,
-33171,
-33165,
-33154,
-33154,
-33149,
-33142,
-33140,
-33147,
-33152,
-33162,
-33162,
-33164,
-33166,
-33171,
-33162,
-33154,
-33140,
-33140,
-33151,
-33173,
-33203,
-33227,
-33249,
-33265,
-33282,
-33301,
-33318,
-33332,
-33349,
-33371,
-33398,
-33413,
-33418,
-33407,
-33408,
-33423,
-33417,
-33405,
-33372,
-33340,
-33333,
-33316,
-33293,
-33272,
-33248,
-33250,
-33227,
-33217,
-33182,
-33179,
-33155,
-33138,
-33099,
-33062,
-33042,
-33007,
-32977,
-32935,
-32916,
-32899,
-32886,
-32845,
-32814,
-32798,
-32791,
-32784,
-32757,
-32722,
-32718,
-32719,
-32730,
-32723,
-32705,
-32697,
-32693,
-32684,
-32679,
-32656,
-32659,
-32643,
-32640,
-32621,
-32605,
-32589,
-32578,
-32550,
-32528,
-32487,
-32463,
-32432,
-32415,
-32399,
-32389,
-32365,
-32356,
-32333,
-32329,
-32314,
-32295,
-32282,
-32266,
-32295,
-32288,
-32301,
-32269,
-32255,
-32251,
-32267,
-32252,
-32239,
-32189,
-32183,
-32182,
-32188,
-32186,
-32156,
-32144,
-32144,
-32157,
-32178,
-32171,
-32169,
-32161,
-32170,
-32167,
-32169,
-32162,
-32170,
-32189,
-32204,
-32221,
-32240,
-32251,
-32277,
-32292,
-32305,
-32320,
-32336,
-32351,
-32377,
-32394,
-32405,
-32419,
-32423,
-32436,
-32451,
-32464,
-32470,
-32478,
-32470,
-32487,
-32485,
-32503,
-32508,
-32516,
-32538,
-32546,
-32562,
-32552,
-32573,
-32580,
-32617,
-32631,
-32641,
-32641,
-32649,
-32650,
-32664,
-32660,
-32667,
-32661,
-32668,
-32664,
-32682,
-32689,
-32708,
-32710,
-32712,
-32717,
-32746,
-32757,
-32769,
-32751,
-32751,
-32758,
-32787,
-32799,
-32813,
-32817,
-32852,
-32872,
-32883,
-32875,
-32851,
-32874,
-32890,
-32918,
-32907,
-32887,
-32863,
-32848,
-32842,
-32833,
-32822,
-32810,
-32799,
-32790,
-32776,
-32770,
-32763,
-32767,
-32771,
-32767,
-32770,
-32766,
-32768,
-32759,
-32754,
-32736,
-32727,
-32703,
-32673,
-32643,
-32611,
-32583,
-32563,
-32532,
-32504,
-32474,
-32449,
-32446,
-32425,
-32424,
-32399,
-32394,
-32389,
-32403,
-32406,
-32413,
-32404,
-32413,
-32425,
-32454,
-32455,
-32458,
-32452,
-32462,
-32479,
-32478,
-32447,
-32422,
-32380,
-32387,
-32363,
-32350,
-32319,
-32301,
-32293,
-32286,
-32273,
-32258,
-32246,
-32246,
-32249,
-32248,
-32237,
-32244,
-32242,
-32265,
-32262,
-32270,
-32271,
-32289,
-32320,
-32337,
-32363,
-32373,
-32393,
-32419,
-32436,
-32455,
-32460,
-32474,
-32499,
-32521,
-32525,
-32528,
-32517,
-32534,
-32551,
-32568,
-32570,
-32587,
-32593,
-32628,
-32648,
-32659,
-32687,
-32699,
-32729,
-32741,
-32750,
-32764,
-32777,
-32810,
-32816,
-32840,
-32829,
-32848,
-32852,
-32877,
-32888,
-32907,
-32926,
-32943,
-32963,
-32980,
-33005,
-33025,
-33060,
-33073,
-33108,
-33124,
-33155,
-33177,
-33187,
-33202,
-33202,
-33219,
-33233,
-33247,
-33251,
-33266,
-33268,
-33291,
-33287,
-33280,
-33254,
-33225,
-33211,
-33194,
-33194,
-33177,
-33167,
-33146,
-33132,
-33113,
-33096,
-33064,
-33045,
-33019,
-33022,
-33001,
-32989,
-32955,
-32941,
-32939,
-32930,
-32928,
-32906,
-32902,
-32899,
-32897,
-32880,
-32859,
-32853,
-32858,
-32868,
-32864,
-32839,
-32847,
-32838,
-32859,
-32846,
-32827,
-32832,
-32821,
-32831,
-32798,
-32769,
-32739,
-32736,
-32744,
-32749,
-32751,
-32734,
-32736,
-32732,
-32745,
-32758,
-32763,
-32777,
-32781,
-32798,
-32816,
-32836,
-32854,
-32858,
-32868,
-32873,
-32890,
-32916,
-32926,
-32949,
-32954,
-32981,
-32993,
-33025,
-33032,
-33041,
-33049,
-33058,
-33077,
-33096,
-33105,
-33133,
-33140,
-33177,
-33199,
-33230,
-33248,
-33273,
-33294,
-33345,
-33373,
-33412,
-33402,
-33400,
-33395,
-33394,
-33409,
-33391,
-33373,
-33340,
-33327,
-33329,
-33311,
-33317,
-33278,
-33280,
-33261,
-33269,
-33261,
-33271,
-33262,
-33263,
-33251,
-33240,
-33229,
-33221,
-33206,
-33199,
-33178,
-33173,
-33140,
-33121,
-33075,
-33059,
-33044,
-33032,
-33020,
-32982,
-32968,
-32952,
-32951,
-32955,
-32949,
-32955,
-32939,
-32930,
-32905,
-32897,
-32897,
-32900,
-32907,
-32884,
-32880,
-32862,
-32882,
-32882,
-32906,
-32894,
-32885,
-32863,
-32832,
-32819,
-32824,
-32825,
-32846,
-32823,
-32833,
-32827,
-32849,
-32852,
-32844,
-32843,
-32828,
-32856,
-32865,
-32889,
-32878,
-32881,
-32879,
-32886,
-32906,
-32901,
-32923,
-32922,
-32943,
-32966,
-32989,
-33013,
-33027,
-33040,
-33071,
-33092,
-33121,
-33117,
-33131,
-33124,
-33150,
-33155,
-33165,
-33162,
-33162,
-33152,
-33148,
-33128,
-33125,
-33128,
-33122,
-33121,
-33095,
-33086,
-33080,
-33090,
-33077,
-33074,
-33055,
-33047,
-33037,
-33006,
-32982,
-32952,
-32946,
-32939,
-32926,
-32899,
-32874,
-32863,
-32848,
-32828,
-32799,
-32776,
-32776,
-32769,
-32760,
-32737,
-32708,
-32714,
-32709,
-32713,
-32688,
-32655,
-32642,
-32640,
-32632,
-32614,
-32565,
-32551,
-32537,
-32553,
-32546,
-32530,
-32519,
-32514,
-32541,
-32543,
-32555,
-32551,
-32572,
-32591,
-32623,
-32632,
-32638,
-32656,
-32669,
-32692,
-32704,
-32714,
-32733,
-32746,
-32765,
-32763,
-32772,
-32774,
-32785,
-32796,
-32794,
-32798,
-32792,
-32797,
-32794,
-32790,
-32790,
-32791,
-32794,
-32805,
-32797,
-32811,
-32811,
-32822,
-32836,
-32841,
-32862,
-32870,
-32871,
-32871,
-32873,
-32876,
-32899,
-32903,
-32911,
-32903,
-32898,
-32907,
-32914,
-32918,
-32905,
-32894,
-32874,
-32874,
-32850,
-32838,
-32813,
-32808,
-32802,
-32800,
-32773,
-32761,
-32746,
-32761,
-32766,
-32759,
-32741,
-32717,
-32716,
-32713,
-32714,
-32700,
-32677,
-32660,
-32637,
-32615,
-32587,
-32555,
-32534,
-32509,
-32489,
-32457,
-32436,
-32418,
-32403,
-32407,
-32378,
-32383,
-32361,
-32360,
-32346,
-32326,
-32311,
-32293,
-32278,
-32271,
-32249,
-32254,
-32256,
-32272,
-32271,
-32269,
-32259,
-32275,
-32290,
-32294,
-32293,
-32276,
-32291,
-32304,
-32315,
-32322,
-32316,
-32331,
-32338,
-32348,
-32343,
-32343,
-32354,
-32374,
-32389,
-32392,
-32387,
-32397,
-32400,
-32432,
-32428,
-32444,
-32437,
-32449,
-32459,
-32461,
-32471,
-32467,
-32478,
-32483,
-32487,
-32496,
-32489,
-32504,
-32500,
-32528,
-32535,
-32569,
-32585,
-32611,
-32627,
-32643,
-32653,
-32671,
-32673,
-32686,
-32683,
-32698,
-32713,
-32729,
-32737,
-32732,
-32728,
-32724,
-32739,
-32757,
-32755,
-32747,
-32707,
-32679,
-32655,
-32640,
-32617,
-32599,
-32574,
-32576,
-32579,
-32582,
-32582,
-32565,
-32563,
-32545,
-32529,
-32532,
-32529,
-32564,
-32569,
-32578,
-32570,
-32568,
-32575,
-32565,
-32547,
-32517,
-32491,
-32474,
-32455,
-32437,
-32416,
-32390,
-32379,
-32357,
-32337,
-32317,
-32289,
-32277,
-32259,
-32249,
-32237,
-32208,
-32189,
-32161,
-32157,
-32163,
-32152,
-32135,
-32104,
-32081,
-32071,
-32073,
-32062,
-32055,
-32053,
-32058,
-32079,
-32085,
-32081,
-32102,
-32110,
-32161,
-32191,
-32225,
-32255,
-32291,
-32315,
-32353,
-32364,
-32392,
-32404,
-32417,
-32409,
-32406,
-32410,
-32413,
-32431,
-32417,
-32410,
-32399,
-32413,
-32428,
-32451,
-32465,
-32481,
-32506,
-32541,
-32555,
-32581,
-32588,
-32620,
-32652,
-32683,
-32704,
-32720,
-32737,
-32753,
-32766,
-32766,
-32762,
-32755,
-32755,
-32759,
-32763,
-32770,
-32770,
-32792,
-32779,
-32807,
-32797,
-32815,
-32824,
-32830,
-32837,
-32848,
-32853,
-32863,
-32865,
-32858,
-32862,
-32851,
-32850,
-32837,
-32829,
-32828,
-32819,
-32816,
-32800,
-32802,
-32803,
-32813,
-32801,
-32798,
-32789,
-32793,
-32789,
-32773,
-32752,
-32745,
-32734,
-32732,
-32702,
-32683,
-32658,
-32647,
-32622,
-32589,
-32555,
-32532,
-32528,
-32506,
-32493,
-32463,
-32451,
-32441,
-32440,
-32422,
-32424,
-32400,
-32395,
-32369,
-32348,
-32340,
-32332,
-32332,
-32333,
-32310,
-32312,
-32286,
-32286,
-32284,
-32284,
-32279,
-32259,
-32239,
-32216,
-32197,
-32173,
-32166,
-32146,
-32163,
-32136,
-32127,
-32098,
-32088,
-32106,
-32127,
-32144,
-32142,
-32133,
-32133,
-32147,
-32153,
-32161,
-32163,
-32168,
-32188,
-32190,
-32202,
-32187,
-32195,
-32185,
-32213,
-32223,
-32247,
-32274,
-32293,
-32326,
-32345,
-32364,
-32370,
-32391,
-32393,
-32432,
-32444,
-32462,
-32454,
-32447,
-32443,
-32468,
-32490,
-32518,
-32523,
-32519,
-32534,
-32537,
-32577,
-32590,
-32617,
-32635,
-32646,
-32668,
-32676,
-32703,
-32710,
-32725,
-32712,
-32723,
-32710,
-32729,
-32715,
-32710,
-32709,
-32711,
-32736,
-32743,
-32752,
-32769,
-32778,
-32810,
-32814,
-32841,
-32871,
-32915,
-32948,
-32966,
-32983,
-33003,
-33053,
-33088,
-33092,
-33084,
-33061,
-33068,
-33063,
-33067,
-33039,
-33057,
-33072,
-33095,
-33104,
-33074,
-33078,
-33083,
-33115,
-33120,
-33118,
-33101,
-33123,
-33133,
-33153,
-33142,
-33130,
-33124,
-33127,
-33120,
-33097,
-33068,
-33039,
-33031,
-33007,
-32991,
-32955,
-32933,
-32902,
-32892,
-32872,
-32867,
-32850,
-32831,
-32822,
-32815,
-32830,
-32827,
-32837,
-32825,
-32848,
-32857,
-32880,
-32872,
-32863,
-32843,
-32832,
-32805,
-32784,
-32758,
-32762,
-32775,
-32780,
-32794,
-32786,
-32786,
-32785,
-32760,
-32749,
-32734,
-32729,
-32721,
-32691,
-32660,
-32647,
-32641,
-32657,
-32639,
-32621,
-32601,
-32577,
-32574,
-32553,
-32552,
-32533,
-32530,
-32508,
-32498,
-32488,
-32482,
-32483,
-32472,
-32473,
-32467,
-32483,
-32481,
-32494,
-32491,
-32499,
-32513,
-32520,
-32530,
-32532,
-32536,
-32558,
-32561,
-32575,
-32569,
-32566,
-32567,
-32577,
-32588,
-32587,
-32592,
-32580,
-32583,
-32580,
-32585,
-32575,
-32583,
-32562,
-32568,
-32559,
-32567,
-32580,
-32588,
-32596,
-32594,
-32589,
-32591,
-32590,
-32596,
-32601,
-32611,
-32606,
-32607,
-32602,
-32619,
-32629,
-32654,
-32653,
-32671,
-32689,
-32718,
-32751,
-32770,
-32800,
-32831,
-32876,
-32913,
-32944,
-32975,
-33011,
-33048,
-33082,
-33099,
-33101,
-33112,
-33097,
-33123,
-33138,
-33177,
-33212,
-33219,
-33221,
-33214,
-33214,
-33227,
-33218,
-33231,
-33227,
-33241,
-33248,
-33255,
-33258,
-33283,
-33280,
-33295,
-33279,
-33280,
-33292,
-33293,
-33297,
-33282,
-33284,
-33305,
-33312,
-33337,
-33319,
-33345,
-33356,
-33383,
-33397,
-33405,
-33410,
-33439,
-33461,
-33487,
-33509,
-33518,
-33544,
-33545,
-33575,
-33568,
-33584,
-33562,
-33552,
-33534,
-33537,
-33531,
-33547,
-33530,
-33541,
-33531,
-33530,
-33526,
-33523,
-33524,
-33532,
-33531,
-33528,
-33511,
-33502,
-33483,
-33490,
-33487,
-33507,
-33516,
-33520,
-33522,
-33515,
-33516,
-33536,
-33532,
-33545,
-33530,
-33532,
-33543,
-33575,
-33610,
-33624,
-33640,
-33623,
-33625,
-33598,
-33575,
-33534,
-33513,
-33498,
-33507,
-33513,
-33506,
-33502,
-33483,
-33495,
-33480,
-33479,
-33443,
-33426,
-33391,
-33375,
-33356,
-33336,
-33325,
-33309,
-33303,
-33284,
-33263,
-33225,
-33200,
-33176,
-33165,
-33157,
-33145,
-33137,
-33126,
-33112,
-33086,
-33063,
-33030,
-33012,
-32989,
-32958,
-32928,
-32899,
-32870,
-32850,
-32832,
-32808,
-32809,
-32775,
-32770,
-32727,
-32722,
-32704,
-32715,
-32705,
-32713,
-32718,
-32740,
-32764,
-32765,
-32764,
-32742,
-32737,
-32720,
-32700,
-32684,
-32666,
-32659,
-32653,
-32633,
-32607,
-32584,
-32562,
-32550,
-32536,
-32524,
-32504,
-32495,
-32488,
-32488,
-32483,
-32475,
-32466,
-32458,
-32458,
-32454,
-32440,
-32445,
-32427,
-32430,
-32415,
-32397,
-32385,
-32377,
-32370,
-32361,
-32346,
-32329,
-32330,
-32325,
-32330,
-32313,
-32320,
-32316,
-32329,
-32333,
-32312,
-32311,
-32285,
-32289,
-32267,
-32255,
-32230,
-32230,
-32238,
-32256,
-32274,
-32287,
-32302,
-32317,
-32315,
-32315,
-32306,
-32300,
-32300,
-32299,
-32302,
-32301,
-32296,
-32286,
-32265,
-32251,
-32246,
-32243,
-32246,
-32238,
-32233,
-32233,
-32237,
-32223,
-32217,
-32200,
-32199,
-32200,
-32195,
-32180,
-32175,
-32164,
-32173,
-32159,
-32153,
-32144,
-32137,
-32146,
-32136,
-32139,
-32129,
-32130,
-32146,
-32142,
-32157,
-32144,
-32162,
-32169,
-32206,
-32215,
-32238,
-32251,
-32258,
-32298,
-32312,
-32351,
-32362,
-32390,
-32405,
-32431,
-32442,
-32458,
-32467,
-32485,
-32497,
-32502,
-32517,
-32515,
-32549,
-32549,
-32573,
-32574,
-32598,
-32620,
-32658,
-32678,
-32708,
-32731,
-32750,
-32770,
-32768,
-32771,
-32764,
-32767,
-32778,
-32767,
-32777,
-32763,
-32774,
-32777,
-32791,
-32803,
-32811,
-32836,
-32847,
-32872,
-32887,
-32913,
-32929,
-32956,
-32968,
-32978,
-32998,
-33010,
-33045,
-33051,
-33078,
-33075,
-33115,
-33118,
-33145,
-33125,
-33120,
-33101,
-33092,
-33082,
-33075,
-33097,
-33112,
-33154,
-33163,
-33164,
-33169,
-33169,
-33176,
-33165,
-33139,
-33124,
-33114,
-33115,
-33098,
-33088,
-33058,
-33065,
-33047,
-33046,
-33036,
-33029,
-33041,
-33040,
-33045,
-33047,
-33061,
-33087,
-33116,
-33140,
-33159,
-33189,
-33207,
-33221,
-33231,
-33235,
-33261,
-33264,
-33278,
-33258,
-33254,
-33244,
-33232,
-33213,
-33181,
-33166,
-33146,
-33150,
-33133,
-33143,
-33139,
-33151,
-33150,
-33147,
-33134,
-33128,
-33117,
-33107,
-33095,
-33090,
-33096,
-33102,
-33106,
-33101,
-33104,
-33098,
-33102,
-33090,
-33096,
-33097,
-33119,
-33112,
-33119,
-33099,
-33113,
-33132,
-33149,
-33159,
-33155,
-33149,
-33160,
-33172,
-33169,
-33183,
-33162,
-33176,
-33169,
-33169,
-33174,
-33178,
-33193,
-33196,
-33198,
-33196,
-33194,
-33208,
-33200,
-33208,
-33205,
-33203,
-33221,
-33231,
-33254,
-33277,
-33294,
-33306,
-33297,
-33291,
-33265,
-33254,
-33228,
-33223,
-33210,
-33215,
-33211,
-33202,
-33184,
-33179,
-33167,
-33186,
-33182,
-33194,
-33184,
-33184,
-33183,
-33188,
-33191,
-33191,
-33178,
-33164,
-33156,
-33144,
-33143,
-33133,
-33112,
-33084,
-33052,
-33018,
-33004,
-32987,
-32962,
-32938,
-32891,
-32871,
-32853,
-32862,
-32852,
-32837,
-32815,
-32786,
-32772,
-32751,
-32741,
-32723,
-32721,
-32695,
-32681,
-32660,
-32633,
-32627,
-32586,
-32566,
-32528,
-32524,
-32505,
-32505,
-32468,
-32451,
-32434,
-32439,
-32442,
-32430,
-32421,
-32412,
-32412,
-32410,
-32398,
-32383,
-32381,
-32376,
-32378,
-32363,
-32353,
-32346,
-32341,
-32327,
-32305,
-32281,
-32265,
-32262,
-32243,
-32228,
-32207,
-32183,
-32182,
-32159,
-32161,
-32125,
-32127,
-32106,
-32113,
-32110,
-32104,
-32102,
-32100,
-32097,
-32088,
-32082,
-32056,
-32060,
-32045,
-32038,
-32014,
-31999,
-31976,
-31985,
-31977,
-31980,
-31985,
-31987,
-32006,
-32014,
-32016,
-32016,
-32001,
-31992,
-31981,
-31977,
-31970,
-31990,
-31989,
-32021,
-32026,
-32037,
-32043,
-32037,
-32045,
-32036,
-32029,
-32011,
-31991,
-31989,
-31977,
-31990,
-31986,
-31987,
-31973,
-31955,
-31937,
-31925,
-31923,
-31915,
-31916,
-31904,
-31891,
-31882,
-31860,
-31848,
-31841,
-31826,
-31839,
-31828,
-31838,
-31831,
-31842,
-31843,
-31856,
-31862,
-31861,
-31868,
-31865,
-31876,
-31884,
-31896,
-31910,
-31927,
-31941,
-31953,
-31956,
-31958,
-31937,
-31919,
-31886,
-31870,
-31866,
-31876,
-31881,
-31901,
-31896,
-31914,
-31940,
-31948,
-31976,
-31968,
-31976,
-31995,
-32001,
-32010,
-32007,
-31991,
-31998,
-31990,
-31994,
-31977,
-31974,
-31961,
-31958,
-31955,
-31945,
-31945,
-31949,
-31950,
-31959,
-31951,
-31967,
-31960,
-31977,
-31982,
-31988,
-32005,
-32021,
-32047,
-32064,
-32080,
-32086,
-32097,
-32106,
-32135,
-32145,
-32175,
-32184,
-32215,
-32259,
-32299,
-32354,
-32386,
-32421,
-32451,
-32472,
-32483,
-32491,
-32488,
-32495,
-32504,
-32517,
-32530,
-32544,
-32555,
-32570,
-32581,
-32604,
-32616,
-32639,
-32650,
-32664,
-32679,
-32687,
-32693,
-32706,
-32703,
-32720,
-32724,
-32732,
-32742,
-32752,
-32768,
-32783,
-32804,
-32816,
-32843,
-32852,
-32883,
-32903,
-32930,
-32967,
-32989,
-33027,
-33031,
-33051,
-33044,
-33064,
-33063,
-33073,
-33070,
-33070,
-33078,
-33080,
-33097,
-33097,
-33111,
-33117,
-33127,
-33123,
-33121,
-33123,
-33148,
-33170,
-33190,
-33195,
-33194,
-33212,
-33226,
-33243,
-33247,
-33249,
-33245,
-33264,
-33274,
-33297,
-33294,
-33310,
-33303,
-33316,
-33308,
-33311,
-33307,
-33311,
-33310,
-33331,
-33336,
-33381,
-33382,
-33416,
-33417,
-33433,
-33445,
-33446,
-33437,
-33428,
-33410,
-33431,
-33436,
-33454,
-33443,
-33434,
-33420,
-33423,
-33430,
-33426,
-33437,
-33435,
-33442,
-33443,
-33431,
-33426,
-33428,
-33434,
-33430,
-33424,
-33406,
-33419,
-33420,
-33437,
-33428,
-33432,
-33426,
-33423,
-33426,
-33413,
-33415,
-33420,
-33424,
-33441,
-33445,
-33461,
-33465,
-33479,
-33473,
-33481,
-33476,
-33480,
-33470,
-33467,
-33459,
-33458,
-33450,
-33441,
-33436,
-33429,
-33437,
-33416,
-33404,
-33374,
-33355,
-33343,
-33319,
-33298,
-33278,
-33255,
-33247,
-33222,
-33202,
-33185,
-33166,
-33160,
-33137,
-33116,
-33090,
-33076,
-33056,
-33054,
-33024,
-33021,
-32991,
-32990,
-32971,
-32954,
-32950,
-32923,
-32927,
-32914,
-32915,
-32908,
-32890,
-32870,
-32848,
-32830,
-32815,
-32805,
-32779,
-32761,
-32738,
-32711,
-32708,
-32681,
-32678,
-32658,
-32644,
-32635,
-32619,
-32606,
-32593,
-32588,
-32577,
-32580,
-32565,
-32554,
-32549,
-32535,
-32542,
-32528,
-32534,
-32516,
-32518,
-32493,
-32492,
-32465,
-32471,
-32454,
-32459,
-32453,
-32449,
-32456,
-32444,
-32440,
-32417,
-32398,
-32382,
-32367,
-32360,
-32360,
-32361,
-32389,
-32394,
-32409,
-32399,
-32387,
-32374,
-32367,
-32365,
-32355,
-32352,
-32330,
-32317,
-32292,
-32270,
-32252,
-32232,
-32212,
-32200,
-32188,
-32183,
-32187,
-32186,
-32191,
-32204,
-32211,
-32216,
-32214,
-32215,
-32222,
-32247,
-32267,
-32282,
-32298,
-32318,
-32337,
-32363,
-32369,
-32389,
-32398,
-32426,
-32426,
-32446,
-32444,
-32474,
-32489,
-32503,
-32504,
-32504,
-32517,
-32541,
-32552,
-32566,
-32572,
-32576,
-32600,
-32604,
-32617,
-32618,
-32627,
-32635,
-32655,
-32647,
-32663,
-32656,
-32681,
-32682,
-32701,
-32698,
-32721,
-32732,
-32759,
-32761,
-32779,
-32789,
-32801,
-32838,
-32836,
-32872,
-32873,
-32896,
-32912,
-32934,
-32956,
-32974,
-32989,
-32993,
-33001,
-33018,
-33029,
-33047,
-33045,
-33041,
-33050,
-33040,
-33056,
-33047,
-33069,
-33076,
-33103,
-33107,
-33115,
-33128,
-33147,
-33184,
-33192,
-33216,
-33211,
-33240,
-33246,
-33263,
-33267,
-33263,
-33275,
-33274,
-33281,
-33285,
-33302,
-33307,
-33335,
-33323,
-33346,
-33343,
-33360,
-33366,
-33359,
-33355,
-33336,
-33326,
-33310,
-33304,
-33286,
-33281,
-33271,
-33251,
-33246,
-33213,
-33200,
-33179,
-33158,
-33140,
-33112,
-33103,
-33089,
-33087,
-33082,
-33073,
-33073,
-33066,
-33067,
-33060,
-33048,
-33038,
-33018,
-33001,
-32979,
-32961,
-32938,
-32928,
-32907,
-32885,
-32862,
-32834,
-32820,
-32800,
-32788,
-32769,
-32762,
-32753,
-32751,
-32736,
-32735,
-32715,
-32725,
-32718,
-32719,
-32715,
-32708,
-32700,
-32690,
-32679,
-32660,
-32641,
-32620,
-32610,
-32590,
-32587,
-32561,
-32539,
-32524,
-32492,
-32482,
-32448,
-32436,
-32412,
-32403,
-32385,
-32359,
-32349,
-32326,
-32328,
-32300,
-32287,
-32252,
-32249,
-32231,
-32234,
-32218,
-32213,
-32204,
-32207,
-32205,
-32208,
-32213,
-32220,
-32240,
-32252,
-32263,
-32280,
-32291,
-32313,
-32334,
-32340,
-32344,
-32338,
-32336,
-32346,
-32345,
-32346,
-32341,
-32342,
-32352,
-32375,
-32385,
-32410,
-32417,
-32452,
-32467,
-32493,
-32494,
-32504,
-32508,
-32526,
-32531,
-32548,
-32565,
-32570,
-32587,
-32572,
-32595,
-32602,
-32634,
-32641,
-32649,
-32658,
-32676,
-32697,
-32708,
-32711,
-32724,
-32727,
-32737,
-32729,
-32710,
-32707,
-32696,
-32705,
-32704,
-32713,
-32724,
-32747,
-32754,
-32759,
-32763,
-32761,
-32775,
-32764,
-32765,
-32758,
-32764,
-32770,
-32772,
-32766,
-32770,
-32769,
-32773,
-32783,
-32780,
-32809,
-32808,
-32839,
-32835,
-32859,
-32866,
-32878,
-32877,
-32877,
-32878,
-32893,
-32889,
-32889,
-32867,
-32860,
-32851,
-32842,
-32837,
-32812,
-32802,
-32776,
-32764,
-32739,
-32734,
-32721,
-32721,
-32707,
-32694,
-32678,
-32663,
-32650,
-32632,
-32620,
-32607,
-32616,
-32616,
-32620,
-32613,
-32606,
-32604,
-32608,
-32591,
-32592,
-32567,
-32558,
-32545,
-32538,
-32532,
-32520,
-32518,
-32497,
-32507,
-32493,
-32509,
-32505,
-32511,
-32502,
-32504,
-32499,
-32498,
-32486,
-32476,
-32460,
-32459,
-32453,
-32473,
-32484,
-32518,
-32529,
-32554,
-32561,
-32571,
-32581,
-32583,
-32587,
-32586,
-32587,
-32599,
-32609,
-32626,
-32631,
-32630,
-32634,
-32632,
-32642,
-32641,
-32650,
-32652,
-32667,
-32678,
-32678,
-32695,
-32683,
-32708,
-32695,
-32713,
-32711,
-32723,
-32743,
-32746,
-32760,
-32762,
-32757,
-32777,
-32773,
-32796,
-32801,
-32820,
-32837,
-32866,
-32889,
-32913,
-32937,
-32956,
-32977,
-32999,
-33019,
-33045,
-33068,
-33100,
-33124,
-33150,
-33157,
-33159,
-33141,
-33140,
-33121,
-33129,
-33111,
-33106,
-33097,
-33090,
-33090,
-33072,
-33058,
-33037,
-33033,
-33025,
-33025,
-33014,
-33011,
-33001,
-33009,
-32990,
-32993,
-32973,
-32981,
-32976,
-32969,
-32963,
-32954,
-32958,
-32961,
-32962,
-32952,
-32939,
-32919,
-32901,
-32884,
-32866,
-32861,
-32845,
-32825,
-32808,
-32769,
-32759,
-32732,
-32724,
-32715,
-32697,
-32704,
-32691,
-32687,
-32684,
-32663,
-32663,
-32647,
-32655,
-32647,
-32660,
-32661,
-32660,
-32661,
-32651,
-32655,
-32648,
-32651,
-32638,
-32643,
-32639,
-32655,
-32655,
-32670,
-32673,
-32690,
-32700,
-32711,
-32727,
-32731,
-32751,
-32765,
-32783,
-32806,
-32828,
-32838,
-32852,
-32849,
-32851,
-32852,
-32847,
-32852,
-32850,
-32861,
-32874,
-32877,
-32886,
-32877,
-32876,
-32876,
-32880,
-32886,
-32888,
-32886,
-32887,
-32896,
-32894,
-32909,
-32899,
-32903,
-32898,
-32900,
-32884,
-32887,
-32862,
-32872,
-32859,
-32875,
-32855,
-32866,
-32847,
-32872,
-32881,
-32893,
-32897,
-32904,
-32921,
-32943,
-32960,
-32974,
-32983,
-32999,
-32995,
-32994,
-32976,
-32956,
-32933,
-32905,
-32875,
-32856,
-32844,
-32830,
-32807,
-32775,
-32743,
-32736,
-32721,
-32709,
-32670,
-32648,
-32626,
-32633,
-32616,
-32599,
-32575,
-32560,
-32551,
-32535,
-32507,
-32494,
-32493,
-32502,
-32506,
-32490,
-32480,
-32489,
-32496,
-32528,
-32533,
-32553,
-32565,
-32583,
-32600,
-32618,
-32634,
-32653,
-32651,
-32661,
-32644,
-32650,
-32638,
-32638,
-32635,
-32642,
-32639,
-32663,
-32658,
-32678,
-32674,
-32671,
-32669,
-32677,
-32694,
-32730,
-32746,
-32773,
-32770,
-32788,
-32803,
-32822,
-32838,
-32860,
-32873,
-32912,
-32921,
-32944,
-32953,
-32965,
-32994,
-32996,
-33031,
-33024,
-33058,
-33049,
-33054,
-33036,
-33028,
-33014,
-33006,
-32994,
-32975,
-32982,
-32963,
-32976,
-32952,
-32950,
-32947,
-32947,
-32966,
-32962,
-32967,
-32958,
-32949,
-32946,
-32934,
-32938,
-32934,
-32930,
-32920,
-32909,
-32898,
-32887,
-32890,
-32868,
-32871,
-32855,
-32852,
-32842,
-32845,
-32821,
-32826,
-32803,
-32796,
-32782,
-32782,
-32761,
-32773,
-32760,
-32769,
-32772,
-32757,
-32753,
-32731,
-32723,
-32717,
-32700,
-32679,
-32658,
-32643,
-32654,
-32654,
-32659,
-32651,
-32641,
-32653,
-32653,
-32664,
-32654,
-32646,
-32637,
-32628,
-32636,
-32627,
-32630,
-32627,
-32629,
-32641,
-32645,
-32644,
-32646,
-32644,
-32666,
-32670,
-32695,
-32705,
-32722,
-32747,
-32755,
-32770,
-32780,
-32789,
-32809,
-32811,
-32823,
-32835,
-32851,
-32878,
-32885,
-32904,
-32900,
-32922,
-32928,
-32946,
-32950,
-32962,
-32966,
-32969,
-32970,
-32963,
-32956,
-32962,
-32948,
-32944,
-32942,
-32926,
-32946,
-32944,
-32950,
-32947,
-32940,
-32946,
-32972,
-32984,
-33006,
-32999,
-33005,
-33016,
-33022,
-33028,
-33015,
-33004,
-33003,
-33001,
-32998,
-32994,
-32973,
-32968,
-32950,
-32927,
-32903,
-32865,
-32852,
-32815,
-32806,
-32763,
-32752,
-32722,
-32721,
-32700,
-32700,
-32686,
-32680,
-32675,
-32673,
-32667,
-32672,
-32661,
-32673,
-32650,
-32676,
-32644,
-32668,
-32642,
-32642,
-32633,
-32621,
-32619,
-32613,
-32614,
-32606,
-32603,
-32591,
-32578,
-32558,
-32544,
-32521,
-32527,
-32524,
-32537,
-32538,
-32521,
-32505,
-32490,
-32490,
-32491,
-32493,
-32482,
-32483,
-32489,
-32502,
-32513,
-32523,
-32526,
-32531,
-32525,
-32514,
-32510,
-32501,
-32520,
-32508,
-32530,
-32515,
-32527,
-32521,
-32531,
-32546,
-32576,
-32610,
-32642,
-32666,
-32699,
-32721,
-32744,
-32749,
-32756,
-32751,
-32779,
-32785,
-32815,
-32822,
-32839,
-32854,
-32858,
-32867,
-32857,
-32863,
-32858,
-32862,
-32860,
-32866,
-32864,
-32861,
-32856,
-32835,
-32835,
-32813,
-32824,
-32806,
-32834,
-32833,
-32860,
-32860,
-32878,
-32882,
-32915,
-32920,
-32940,
-32937,
-32947,
-32954,
-32987,
-33013,
-33053,
-33085,
-33100,
-33108,
-33098,
-33090,
-33081,
-33058,
-33048,
-33023,
-33017,
-33003,
-32976,
-32962,
-32933,
-32934,
-32918,
-32909,
-32888,
-32867,
-32855,
-32843,
-32830,
-32813,
-32814,
-32792,
-32805,
-32767,
-32760,
-32727,
-32716,
-32700,
-32694,
-32678,
-32679,
-32679,
-32693,
-32696,
-32700,
-32692,
-32704,
-32715,
-32728,
-32727,
-32717,
-32707,
-32712,
-32703,
-32698,
-32672,
-32651,
-32627,
-32603,
-32567,
-32546,
-32518,
-32516,
-32513,
-32495,
-32481,
-32458,
-32450,
-32442,
-32436,
-32429,
-32430,
-32431,
-32432,
-32423,
-32430,
-32431,
-32451,
-32440,
-32433,
-32407,
-32398,
-32390,
-32387,
-32373,
-32382,
-32366,
-32388,
-32367,
-32378,
-32376,
-32398,
-32423,
-32442,
-32454,
-32466,
-32470,
-32487,
-32492,
-32492,
-32495,
-32482,
-32479,
-32460,
-32445,
-32441,
-32434,
-32455,
-32448,
-32452,
-32435,
-32448,
-32439,
-32471,
-32454,
-32482,
-32466,
-32492,
-32506,
-32527,
-32561,
-32569,
-32595,
-32593,
-32606,
-32610,
-32617,
-32640,
-32638,
-32663,
-32674,
-32706,
-32748,
-32791,
-32823,
-32856,
-32863,
-32866,
-32868,
-32850,
-32862,
-32849,
-32854,
-32861,
-32850,
-32857,
-32832,
-32824,
-32807,
-32808,
-32801,
-32798,
-32790,
-32787,
-32793,
-32799,
-32781,
-32777,
-32756,
-32762,
-32772,
-32773,
-32777,
-32782,
-32788,
-32803,
-32812,
-32823,
-32846,
-32872,
-32884,
-32888,
-32893,
-32904,
-32931,
-32938,
-32944,
-32942,
-32952,
-32951,
-32962,
-32938,
-32954,
-32946,
-32960,
-32956,
-32943,
-32944,
-32943,
-32948,
-32946,
-32950,
-32958,
-32976,
-32979,
-32989,
-32968,
-32979,
-32947,
-32944,
-32905,
-32903,
-32872,
-32880,
-32845,
-32840,
-32819,
-32800,
-32789,
-32757,
-32754,
-32739,
-32736,
-32714,
-32698,
-32675,
-32665,
-32651,
-32632,
-32616,
-32605,
-32594,
-32594,
-32574,
-32571,
-32558,
-32562,
-32552,
-32541,
-32529,
-32523,
-32533,
-32530,
-32528,
-32526,
-32520,
-32532,
-32529,
-32534,
-32523,
-32518,
-32516,
-32504,
-32507,
-32485,
-32477,
-32454,
-32450,
-32437,
-32431,
-32416,
-32402,
-32398,
-32390,
-32394,
-32380,
-32379,
-32359,
-32370,
-32350,
-32358,
-32349,
-32347,
-32350,
-32336,
-32321,
-32317,
-32301,
-32307,
-32287,
-32272,
-32257,
-32239,
-32242,
-32227,
-32222,
-32202,
-32189,
-32186,
-32181,
-32184,
-32178,
-32179,
-32175,
-32183,
-32172,
-32177,
-32181,
-32187,
-32202,
-32199,
-32199,
-32199,
-32203,
-32213,
-32216,
-32223,
-32215,
-32217,
-32205,
-32202,
-32208,
-32209,
-32211,
-32202,
-32186,
-32193,
-32198,
-32220,
-32224,
-32247,
-32252,
-32284,
-32284,
-32294,
-32286,
-32289,
-32302,
-32308,
-32320,
-32322,
-32320,
-32328,
-32326,
-32340,
-32345,
-32356,
-32360,
-32365,
-32385,
-32394,
-32432,
-32432,
-32452,
-32452,
-32463,
-32487,
-32485,
-32509,
-32505,
-32524,
-32540,
-32561,
-32582,
-32607,
-32632,
-32650,
-32689,
-32691,
-32727,
-32715,
-32740,
-32730,
-32760,
-32765,
-32779,
-32793,
-32801,
-32828,
-32840,
-32855,
-32865,
-32878,
-32898,
-32906,
-32915,
-32902,
-32913,
-32901,
-32923,
-32932,
-32960,
-32996,
-33024,
-33043,
-33060,
-33065,
-33091,
-33111,
-33124,
-33122,
-33126,
-33111,
-33118,
-33098,
-33094,
-33079,
-33087,
-33076,
-33090,
-33073,
-33076,
-33079,
-33069,
-33079,
-33054,
-33056,
-33042,
-33054,
-33042,
-33045,
-33026,
-33029,
-33030,
-33037,
-33040,
-33046,
-33051,
-33072,
-33098,
-33123,
-33156,
-33183,
-33206,
-33232,
-33232,
-33241,
-33231,
-33231,
-33233,
-33243,
-33254,
-33272,
-33275,
-33279,
-33273,
-33252,
-33244,
-33220,
-33214,
-33212,
-33209,
-33222,
-33214,
-33213,
-33208,
-33203,
-33206,
-33200,
-33207,
-33202,
-33212,
-33211,
-33214,
-33214,
-33208,
-33207,
-33205,
-33214,
-33221,
-33223,
-33223,
-33224,
-33238,
-33252,
-33268,
-33264,
-33282,
-33272,
-33295,
-33283,
-33296,
-33285,
-33288,
-33282,
-33269,
-33257,
-33243,
-33224,
-33224,
-33210,
-33208,
-33192,
-33182,
-33171,
-33171,
-33169,
-33160,
-33157,
-33145,
-33149,
-33148,
-33159,
-33156,
-33164,
-33167,
-33162,
-33164,
-33158,
-33158,
-33158,
-33158,
-33132,
-33116,
-33089,
-33070,
-33050,
-33038,
-33010,
-33007,
-32983,
-32974,
-32956,
-32941,
-32940,
-32922,
-32912,
-32893,
-32877,
-32875,
-32866,
-32852,
-32842,
-32813,
-32810,
-32782,
-32773,
-32757,
-32756,
-32762,
-32755,
-32761,
-32742,
-32744,
-32740,
-32732,
-32739,
-32723,
-32722,
-32715,
-32717,
-32710,
-32716,
-32697,
-32704,
-32699,
-32704,
-32699,
-32674,
-32657,
-32633,
-32643,
-32655,
-32676,
-32683,
-32685,
-32682,
-32669,
-32661,
-32632,
-32620,
-32587,
-32584,
-32564,
-32560,
-32565,
-32562,
-32572,
-32563,
-32570,
-32565,
-32581,
-32578,
-32585,
-32587,
-32582,
-32592,
-32582,
-32581,
-32568,
-32555,
-32533,
-32520,
-32509,
-32507,
-32513,
-32507,
-32501,
-32490,
-32499,
-32489,
-32503,
-32481,
-32479,
-32471,
-32477,
-32485,
-32483,
-32502,
-32504,
-32527,
-32530,
-32537,
-32543,
-32554,
-32574,
-32589,
-32595,
-32590,
-32564,
-32556,
-32528,
-32533,
-32512,
-32508,
-32503,
-32493,
-32489,
-32466,
-32444,
-32416,
-32416,
-32412,
-32417,
-32407,
-32395,
-32393,
-32397,
-32396,
-32385,
-32361,
-32353,
-32352,
-32346,
-32352,
-32333,
-32329,
-32332,
-32322,
-32317,
-32307,
-32302,
-32310,
-32313,
-32303,
-32304,
-32296,
-32313,
-32317,
-32333,
-32332,
-32347,
-32360,
-32371,
-32389,
-32395,
-32407,
-32416,
-32427,
-32425,
-32428,
-32425,
-32422,
-32433,
-32417,
-32418,
-32397,
-32388,
-32391,
-32391,
-32405,
-32394,
-32399,
-32388,
-32405,
-32411,
-32432,
-32430,
-32452,
-32439,
-32463,
-32455,
-32475,
-32475,
-32492,
-32494,
-32515,
-32516,
-32535,
-32537,
-32547,
-32556,
-32572,
-32577,
-32585,
-32575,
-32575,
-32583,
-32589,
-32605,
-32614,
-32620,
-32631,
-32626,
-32621,
-32626,
-32624,
-32647,
-32662,
-32676,
-32700,
-32712,
-32734,
-32742,
-32754,
-32769,
-32781,
-32805,
-32800,
-32819,
-32826,
-32859,
-32882,
-32895,
-32913,
-32914,
-32939,
-32952,
-32961,
-32968,
-32968,
-32968,
-32968,
-32959,
-32956,
-32950,
-32966,
-32975,
-32990,
-32987,
-32985,
-32988,
-32989,
-33004,
-33019,
-33016,
-33037,
-33029,
-33054,
-33058,
-33067,
-33060,
-33051,
-33041,
-33034,
-33027,
-33026,
-33029,
-33038,
-33038,
-33043,
-33038,
-33043,
-33052,
-33055,
-33065,
-33058,
-33067,
-33075,
-33098,
-33117,
-33128,
-33130,
-33127,
-33121,
-33122,
-33127,
-33135,
-33140,
-33141,
-33138,
-33142,
-33154,
-33173,
-33181,
-33196,
-33197,
-33197,
-33201,
-33190,
-33201,
-33206,
-33214,
-33216,
-33188,
-33180,
-33152,
-33155,
-33148,
-33145,
-33133,
-33121,
-33097,
-33090,
-33075,
-33075,
-33067,
-33071,
-33050,
-33072,
-33058,
-33096,
-33095,
-33122,
-33126,
-33149,
-33148,
-33159,
-33150,
-33171,
-33187,
-33224,
-33242,
-33260,
-33270,
-33268,
-33270,
-33245,
-33248,
-33238,
-33249,
-33245,
-33240,
-33215,
-33199,
-33169,
-33163,
-33154,
-33170,
-33171,
-33173,
-33161,
-33148,
-33147,
-33140,
-33139,
-33116,
-33109,
-33089,
-33100,
-33087,
-33087,
-33075,
-33067,
-33070,
-33064,
-33065,
-33067,
-33072,
-33081,
-33096,
-33113,
-33116,
-33135,
-33106,
-33115,
-33106,
-33129,
-33146,
-33171,
-33180,
-33207,
-33219,
-33230,
-33219,
-33202,
-33191,
-33198,
-33203,
-33226,
-33220,
-33232,
-33230,
-33218,
-33215,
-33191,
-33182,
-33167,
-33170,
-33160,
-33170,
-33155,
-33151,
-33135,
-33125,
-33117,
-33115,
-33108,
-33110,
-33095,
-33086,
-33065,
-33060,
-33048,
-33043,
-33029,
-32992,
-32988,
-32973,
-32980,
-32976,
-32956,
-32932,
-32923,
-32916,
-32924,
-32937,
-32929,
-32934,
-32918,
-32909,
-32887,
-32874,
-32842,
-32844,
-32832,
-32841,
-32837,
-32822,
-32808,
-32787,
-32787,
-32781,
-32764,
-32767,
-32730,
-32742,
-32722,
-32720,
-32708,
-32693,
-32678,
-32661,
-32632,
-32620,
-32591,
-32596,
-32576,
-32576,
-32555,
-32545,
-32530,
-32523,
-32522,
-32511,
-32509,
-32494,
-32496,
-32484,
-32485,
-32464,
-32464,
-32459,
-32458,
-32458,
-32449,
-32438,
-32450,
-32439,
-32461,
-32464,
-32484,
-32501,
-32504,
-32502,
-32483,
-32483,
-32461,
-32465,
-32427,
-32424,
-32397,
-32395,
-32379,
-32378,
-32371,
-32382,
-32390,
-32380,
-32388,
-32370,
-32381,
-32369,
-32378,
-32378,
-32393,
-32406,
-32402,
-32412,
-32404,
-32426,
-32427,
-32440,
-32433,
-32439,
-32433,
-32437,
-32425,
-32419,
-32413,
-32412,
-32413,
-32405,
-32379,
-32357,
-32319,
-32304,
-32295,
-32298,
-32309,
-32301,
-32297,
-32279,
-32271,
-32268,
-32259,
-32260,
-32253,
-32248,
-32245,
-32227,
-32216,
-32207,
-32209,
-32237,
-32247,
-32273,
-32281,
-32272,
-32272,
-32246,
-32247,
-32236,
-32238,
-32245,
-32253,
-32260,
-32254,
-32256,
-32257,
-32264,
-32278,
-32262,
-32277,
-32262,
-32283,
-32275,
-32270,
-32260,
-32243,
-32250,
-32232,
-32229,
-32206,
-32209,
-32212,
-32218,
-32224,
-32220,
-32223,
-32214,
-32209,
-32197,
-32195,
-32196,
-32205,
-32206,
-32218,
-32223,
-32239,
-32268,
-32284,
-32313,
-32314,
-32333,
-32333,
-32346,
-32354,
-32363,
-32374,
-32385,
-32399,
-32406,
-32412,
-32419,
-32409,
-32426,
-32414,
-32428,
-32424,
-32427,
-32436,
-32440,
-32459,
-32466,
-32476,
-32480,
-32480,
-32500,
-32518,
-32560,
-32574,
-32598,
-32587,
-32605,
-32604,
-32618,
-32631,
-32626,
-32639,
-32641,
-32640,
-32650,
-32661,
-32681,
-32709,
-32712,
-32715,
-32708,
-32712,
-32727,
-32741,
-32756,
-32775,
-32786,
-32814,
-32821,
-32837,
-32846,
-32859,
-32879,
-32875,
-32875,
-32858,
-32854,
-32866,
-32866,
-32882,
-32865,
-32870,
-32846,
-32852,
-32836,
-32834,
-32837,
-32833,
-32849,
-32852,
-32863,
-32872,
-32888,
-32903,
-32924,
-32939,
-32958,
-32977,
-33000,
-33010,
-33037,
-33032,
-33048,
-33050,
-33052,
-33063,
-33043,
-33042,
-33030,
-33032,
-33035,
-33034,
-33040,
-33041,
-33056,
-33045,
-33051,
-33029,
-33036,
-33027,
-33033,
-33018,
-33021,
-33018,
-33024,
-33029,
-33018,
-33013,
-33002,
-32993,
-32988,
-32976,
-32962,
-32958,
-32932,
-32917,
-32904,
-32889,
-32901,
-32890,
-32888,
-32885,
-32884,
-32891,
-32896,
-32884,
-32891,
-32875,
-32877,
-32859,
-32855,
-32848,
-32861,
-32872,
-32864,
-32863,
-32833,
-32819,
-32804,
-32775,
-32777,
-32750,
-32759,
-32750,
-32740,
-32725,
-32699,
-32682,
-32666,
-32657,
-32649,
-32630,
-32627,
-32608,
-32605,
-32589,
-32564,
-32551,
-32524,
-32520,
-32509,
-32512,
-32503,
-32508,
-32494,
-32488,
-32483,
-32486,
-32505,
-32527,
-32550,
-32559,
-32570,
-32574,
-32577,
-32576,
-32563,
-32555,
-32540,
-32541,
-32549,
-32560,
-32569,
-32571,
-32556,
-32535,
-32521,
-32502,
-32504,
-32513,
-32517,
-32523,
-32526,
-32515,
-32520,
-32502,
-32500,
-32484,
-32480,
-32489,
-32484,
-32506,
-32496,
-32510,
-32500,
-32515,
-32514,
-32529,
-32548,
-32555,
-32590,
-32597,
-32621,
-32628,
-32631,
-32636,
-32646,
-32652,
-32669,
-32683,
-32713,
-32737,
-32767,
-32778,
-32795,
-32804,
-32822,
-32834,
-32832,
-32836,
-32821,
-32830,
-32825,
-32824,
-32839,
-32847,
-32890,
-32896,
-32912,
-32903,
-32899,
-32900,
-32905,
-32906,
-32907,
-32913,
-32921,
-32932,
-32933,
-32931,
-32933,
-32935,
-32943,
-32938,
-32941,
-32944,
-32944,
-32950,
-32938,
-32938,
-32943,
-32948,
-32959,
-32949,
-32939,
-32938,
-32930,
-32940,
-32918,
-32918,
-32883,
-32901,
-32885,
-32897,
-32889,
-32884,
-32888,
-32889,
-32899,
-32903,
-32901,
-32913,
-32898,
-32913,
-32897,
-32893,
-32873,
-32869,
-32852,
-32860,
-32854,
-32852,
-32855,
-32846,
-32852,
-32848,
-32856,
-32850,
-32847,
-32834,
-32816,
-32805,
-32788,
-32777,
-32769,
-32765,
-32747,
-32745,
-32719,
-32707,
-32685,
-32668,
-32638,
-32637,
-32603,
-32609,
-32584,
-32576,
-32556,
-32549,
-32531,
-32534,
-32525,
-32507,
-32515,
-32490,
-32508,
-32491,
-32490,
-32486,
-32489,
-32502,
-32499,
-32500,
-32493,
-32492,
-32503,
-32501,
-32508,
-32513,
-32518,
-32545,
-32550,
-32573,
-32576,
-32596,
-32597,
-32599,
-32586,
-32574,
-32573,
-32596,
-32608,
-32661,
-32664,
-32679,
-32667,
-32646,
-32645,
-32640,
-32661,
-32670,
-32690,
-32693,
-32702,
-32699,
-32708,
-32711,
-32738,
-32751,
-32765,
-32773,
-32766,
-32795,
-32809,
-32842,
-32848,
-32853,
-32850,
-32853,
-32858,
-32864,
-32877,
-32889,
-32904,
-32917,
-32920,
-32929,
-32936,
-32947,
-32959,
-32958,
-32959,
-32943,
-32940,
-32924,
-32931,
-32926,
-32937,
-32932,
-32932,
-32928,
-32934,
-32931,
-32928,
-32921,
-32915,
-32931,
-32935,
-32934,
-32927,
-32917,
-32913,
-32921,
-32907,
-32898,
-32881,
-32870,
-32865,
-32852,
-32850,
-32841,
-32837,
-32835,
-32818,
-32809,
-32798,
-32786,
-32775,
-32763,
-32756,
-32751,
-32749,
-32744,
-32728,
-32731,
-32719,
-32726,
-32715,
-32698,
-32704,
-32686,
-32697,
-32675,
-32657,
-32642,
-32622,
-32621,
-32608,
-32613,
-32607,
-32609,
-32607,
-32601,
-32588,
-32599,
-32577,
-32595,
-32572,
-32590,
-32587,
-32609,
-32593,
-32601,
-32589,
-32607,
-32628,
-32631,
-32643,
-32639,
-32650,
-32657,
-32675,
-32678,
-32690,
-32698,
-32703,
-32715,
-32733,
-32750,
-32771,
-32788,
-32790,
-32804,
-32805,
-32819,
-32817,
-32829,
-32832,
-32856,
-32857,
-32881,
-32875,
-32886,
-32880,
-32894,
-32905,
-32925,
-32937,
-32928,
-32927,
-32915,
-32920,
-32916,
-32909,
-32901,
-32892,
-32888,
-32879,
-32852,
-32833,
-32818,
-32814,
-32824,
-32810,
-32804,
-32787,
-32782,
-32780,
-32780,
-32775,
-32787,
-32780,
-32790,
-32783,
-32786,
-32797,
-32790,
-32789,
-32757,
-32752,
-32731,
-32729,
-32718,
-32708,
-32716,
-32709,
-32720,
-32698,
-32690,
-32675,
-32682,
-32686,
-32692,
-32677,
-32676,
-32666,
-32672,
-32672,
-32662,
-32662,
-32653,
-32651,
-32638,
-32627,
-32631,
-32633,
-32649,
-32646,
-32648,
-32655,
-32668,
-32693,
-32699,
-32714,
-32719,
-32729,
-32740,
-32734,
-32742,
-32738,
-32754,
-32764,
-32768,
-32775,
-32763,
-32768,
-32763,
-32778,
-32778,
-32795,
-32804,
-32813,
-32825,
-32824,
-32835,
-32840,
-32849,
-32857,
-32872,
-32871,
-32884,
-32883,
-32901,
-32898,
-32911,
-32895,
-32906,
-32896,
-32913,
-32905,
-32906,
-32903,
-32890,
-32905,
-32877,
-32875,
-32842,
-32833,
-32837,
-32840,
-32850,
-32853,
-32852,
-32863,
-32867,
-32876,
-32871,
-32876,
-32861,
-32872,
-32871,
-32866,
-32867,
-32850,
-32851,
-32847,
-32848,
-32846,
-32827,
-32816,
-32792,
-32782,
-32782,
-32770,
-32776,
-32757,
-32752,
-32743,
-32737,
-32740,
-32735,
-32728,
-32726,
-32715,
-32719,
-32716,
-32705,
-32709,
-32697,
-32704,
-32697,
-32688,
-32690,
-32682,
-32697,
-32698,
-32699,
-32696,
-32705,
-32713,
-32737,
-32744,
-32754,
-32765,
-32777,
-32797,
-32811,
-32836,
-32853,
-32873,
-32885,
-32885,
-32893,
-32894,
-32902,
-32906,
-32910,
-32908,
-32917,
-32910,
-32916,
-32911,
-32917,
-32919,
-32929,
-32920,
-32936,
-32924,
-32936,
-32925,
-32921,
-32913,
-32913,
-32913,
-32907,
-32904,
-32890,
-32892,
-32879,
-32877,
-32874,
-32858,
-32856,
-32838,
-32840,
-32829,
-32832,
-32817,
-32804,
-32803,
-32793,
-32790,
-32776,
-32760,
-32748,
-32738,
-32729,
-32719,
-32704,
-32701,
-32686,
-32685,
-32661,
-32661,
-32648,
-32647,
-32640,
-32629,
-32638,
-32636,
-32656,
-32652,
-32662,
-32668,
-32684,
-32696,
-32715,
-32717,
-32731,
-32735,
-32750,
-32754,
-32756,
-32754,
-32740,
-32743,
-32731,
-32748,
-32754,
-32780,
-32779,
-32802,
-32796,
-32808,
-32805,
-32802,
-32795,
-32796,
-32789,
-32814,
-32815,
-32831,
-32814,
-32819,
-32805,
-32826,
-32815,
-32829,
-32809,
-32828,
-32827,
-32837,
-32842,
-32833,
-32843,
-32842,
-32842,
-32839,
-32839,
-32840,
-32846,
-32843,
-32843,
-32844,
-32861,
-32863,
-32882,
-32868,
-32881,
-32878,
-32881,
-32886,
-32882,
-32889,
-32887,
-32895,
-32885,
-32903,
-32899,
-32918,
-32899,
-32879,
-32852,
-32826,
-32821,
-32811,
-32806,
-32797,
-32785,
-32784,
-32763,
-32761,
-32738,
-32740,
-32730,
-32726,
-32711,
-32695,
-32683,
-32677,
-32678,
-32681,
-32675,
-32669,
-32663,
-32661,
-32667,
-32666,
-32672,
-32658,
-32663,
-32647,
-32662,
-32655,
-32668,
-32666,
-32672,
-32688,
-32700,
-32722,
-32740,
-32748,
-32761,
-32757,
-32757,
-32759,
-32750,
-32755,
-32746,
-32752,
-32756,
-32777,
-32779,
-32798,
-32781,
-32801,
-32793,
-32822,
-32828,
-32839,
-32845,
-32850,
-32864,
-32875,
-32878,
-32893,
-32892,
-32912,
-32907,
-32907,
-32898,
-32896,
-32898,
-32908,
-32901,
-32907,
-32892,
-32905,
-32894,
-32905,
-32889,
-32883,
-32884,
-32870,
-32879,
-32851,
-32851,
-32833,
-32827,
-32821,
-32799,
-32781,
-32763,
-32747,
-32745,
-32738,
-32719,
-32715,
-32700,
-32702,
-32702,
-32701,
-32695,
-32705,
-32712,
-32727,
-32735,
-32740,
-32743,
-32747,
-32739,
-32733,
-32712,
-32699,
-32685,
-32669,
-32672,
-32642,
-32642,
-32607,
-32610,
-32606,
-32607,
-32619,
-32606,
-32600,
-32595,
-32586,
-32577,
-32575,
-32564,
-32571,
-32565,
-32576,
-32557,
-32568,
-32554,
-32562,
-32564,
-32562,
-32575,
-32583,
-32600,
-32617,
-32631,
-32648,
-32665,
-32676,
-32681,
-32683,
-32686,
-32702,
-32702,
-32713,
-32705,
-32715,
-32730,
-32739,
-32749,
-32737,
-32746,
-32739,
-32754,
-32759,
-32760,
-32774,
-32772,
-32784,
-32775,
-32786,
-32781,
-32795,
-32782,
-32785,
-32765,
-32774,
-32761,
-32764,
-32749,
-32748,
-32729,
-32735,
-32716,
-32715,
-32704,
-32699,
-32685,
-32681,
-32665,
-32668,
-32658,
-32666,
-32656,
-32667,
-32658,
-32659,
-32663,
-32663,
-32677,
-32681,
-32686,
-32693,
-32688,
-32701,
-32686,
-32688,
-32671,
-32667,
-32645,
-32636,
-32608,
-32598,
-32592,
-32579,
-32573,
-32549,
-32529,
-32520,
-32497,
-32494,
-32473,
-32455,
-32452,
-32430,
-32427,
-32405,
-32398,
-32390,
-32383,
-32380,
-32365,
-32360,
-32359,
-32353,
-32358,
-32358,
-32370,
-32381,
-32394,
-32385,
-32398,
-32388,
-32413,
-32412,
-32417,
-32424,
-32426,
-32444,
-32445,
-32436,
-32443,
-32439,
-32472,
-32471,
-32482,
-32478,
-32484,
-32485,
-32488,
-32469,
-32477,
-32477,
-32492,
-32501,
-32501,
-32507,
-32525,
-32522,
-32522,
-32511,
-32525,
-32547,
-32571,
-32569,
-32564,
-32566,
-32587,
-32606,
-32620,
-32619,
-32624,
-32644,
-32662,
-32680,
-32696,
-32709,
-32738,
-32745,
-32764,
-32767,
-32786,
-32796,
-32815,
-32814,
-32823,
-32827,
-32822,
-32837,
-32822,
-32832,
-32832,
-32829,
-32829,
-32822,
-32820,
-32828,
-32836,
-32837,
-32837,
-32832,
-32835,
-32847,
-32848,
-32855,
-32843,
-32854,
-32846,
-32863,
-32858,
-32876,
-32870,
-32875,
-32870,
-32861,
-32866,
-32863,
-32866,
-32875,
-32869,
-32883,
-32881,
-32886,
-32886,
-32874,
-32876,
-32870,
-32869,
-32856,
-32838,
-32820,
-32804,
-32800,
-32799,
-32798,
-32802,
-32785,
-32781,
-32762,
-32760,
-32746,
-32737,
-32731,
-32720,
-32721,
-32709,
-32696,
-32691,
-32679,
-32678,
-32675,
-32661,
-32655,
-32642,
-32639,
-32637,
-32634,
-32635,
-32635,
-32635,
-32646,
-32638,
-32655,
-32644,
-32649,
-32631,
-32632,
-32621,
-32634,
-32634,
-32635,
-32642,
-32628,
-32631,
-32614,
-32595,
-32587,
-32560,
-32559,
-32551,
-32551,
-32565,
-32555,
-32566,
-32557,
-32576,
-32571,
-32585,
-32573,
-32581,
-32584,
-32595,
-32598,
-32606,
-32615,
-32633,
-32658,
-32677,
-32702,
-32723,
-32744,
-32748,
-32762,
-32751,
-32777,
-32778,
-32804,
-32806,
-32828,
-32840,
-32858,
-32876,
-32882,
-32900,
-32905,
-32920,
-32918,
-32926,
-32934,
-32927,
-32943,
-32931,
-32940,
-32949,
-32952,
-32968,
-32971,
-32977,
-32982,
-32977,
-32983,
-32985,
-32998,
-33008,
-33021,
-33022,
-33028,
-33035,
-33036,
-33043,
-33047,
-33055,
-33070,
-33080,
-33085,
-33089,
-33097,
-33098,
-33112,
-33112,
-33123,
-33131,
-33148,
-33171,
-33180,
-33188,
-33191,
-33194,
-33200,
-33201,
-33186,
-33186,
-33188,
-33198,
-33209,
-33203,
-33200,
-33199,
-33215,
-33213,
-33222,
-33207,
-33221,
-33224,
-33248,
-33248,
-33253,
-33253,
-33256,
-33254,
-33253,
-33238,
-33242,
-33228,
-33218,
-33199,
-33186,
-33180,
-33185,
-33178,
-33178,
-33164,
-33150,
-33148,
-33141,
-33149,
-33149,
-33140,
-33127,
-33110,
-33109,
-33104,
-33110,
-33096,
-33099,
-33089,
-33098,
-33091,
-33090,
-33080,
-33074,
-33073,
-33068,
-33065,
-33061,
-33048,
-33045,
-33034,
-33023,
-33010,
-32980,
-32974,
-32952,
-32964,
-32952,
-32962,
-32960,
-32986,
-32987,
-33002,
-32987,
-32980,
-32983,
-32984,
-32994,
-32987,
-32976,
-32961,
-32943,
-32936,
-32916,
-32916,
-32893,
-32884,
-32857,
-32836,
-32833,
-32816,
-32814,
-32802,
-32779,
-32783,
-32761,
-32759,
-32753,
-32751,
-32744,
-32748,
-32722,
-32730,
-32708,
-32713,
-32698,
-32705,
-32696,
-32711,
-32705,
-32707,
-32718,
-32721,
-32741,
-32740,
-32734,
-32743,
-32734,
-32753,
-32733,
-32730,
-32708,
-32701,
-32700,
-32687,
-32671,
-32653,
-32641,
-32630,
-32625,
-32616,
-32604,
-32599,
-32585,
-32589,
-32589,
-32603,
-32603,
-32612,
-32608,
-32626,
-32626,
-32650,
-32646,
-32660,
-32674,
-32680,
-32694,
-32678,
-32680,
-32680,
-32685,
-32705,
-32694,
-32709,
-32709,
-32718,
-32724,
-32729,
-32742,
-32746,
-32771,
-32757,
-32774,
-32761,
-32767,
-32772,
-32761,
-32772,
-32762,
-32767,
-32760,
-32758,
-32755,
-32759,
-32758,
-32759,
-32753,
-32765,
-32759,
-32781,
-32781,
-32793,
-32801,
-32804,
-32816,
-32829,
-32847,
-32858,
-32869,
-32862,
-32873,
-32875,
-32882,
-32889,
-32885,
-32892,
-32891,
-32895,
-32881,
-32884,
-32881,
-32893,
-32895,
-32890,
-32881,
-32876,
-32884,
-32888,
-32894,
-32888,
-32911,
-32907,
-32942,
-32932,
-32939,
-32929,
-32930,
-32922,
-32923,
-32912,
-32904,
-32893,
-32885,
-32877,
-32866,
-32853,
-32840,
-32839,
-32834,
-32837,
-32838,
-32846,
-32860,
-32872,
-32873,
-32869,
-32865,
-32873,
-32876,
-32881,
-32870,
-32865,
-32871,
-32869,
-32874,
-32877,
-32879,
-32899,
-32903,
-32913,
-32910,
-32911,
-32921,
-32918,
-32933,
-32922,
-32932,
-32922,
-32932,
-32922,
-32930,
-32927,
-32922,
-32914,
-32896,
-32899,
-32891,
-32902,
-32886,
-32884,
-32875,
-32888,
-32872,
-32879,
-32847,
-32847,
-32837,
-32835,
-32825,
-32806,
-32797,
-32786,
-32776,
-32757,
-32739,
-32727,
-32714,
-32707,
-32682,
-32667,
-32658,
-32651,
-32640,
-32632,
-32600,
-32600,
-32586,
-32587,
-32584,
-32574,
-32571,
-32564,
-32557,
-32547,
-32539,
-32530,
-32526,
-32525,
-32507,
-32521,
-32509,
-32531,
-32534,
-32539,
-32530,
-32527,
-32516,
-32502,
-32492,
-32470,
-32462,
-32446,
-32437,
-32422,
-32421,
-32416,
-32419,
-32399,
-32381,
-32369,
-32355,
-32374,
-32363,
-32375,
-32365,
-32371,
-32352,
-32349,
-32322,
-32312,
-32306,
-32291,
-32295,
-32276,
-32281,
-32271,
-32269,
-32266,
-32264,
-32263,
-32269,
-32260,
-32250,
-32242,
-32233,
-32239,
-32226,
-32235,
-32220,
-32231,
-32227,
-32229,
-32232,
-32237,
-32237,
-32244,
-32239,
-32247,
-32248,
-32255,
-32253,
-32258,
-32247,
-32248,
-32231,
-32222,
-32210,
-32210,
-32203,
-32207,
-32195,
-32187,
-32190,
-32188,
-32197,
-32201,
-32205,
-32215,
-32226,
-32232,
-32237,
-32230,
-32236,
-32230,
-32237,
-32232,
-32232,
-32231,
-32227,
-32231,
-32236,
-32238,
-32241,
-32239,
-32231,
-32237,
-32231,
-32231,
-32231,
-32220,
-32230,
-32216,
-32220,
-32208,
-32199,
-32201,
-32195,
-32188,
-32186,
-32163,
-32169,
-32161,
-32167,
-32162,
-32154,
-32154,
-32147,
-32156,
-32150,
-32155,
-32152,
-32167,
-32165,
-32194,
-32195,
-32222,
-32242,
-32257,
-32290,
-32293,
-32329,
-32335,
-32356,
-32368,
-32369,
-32386,
-32385,
-32399,
-32397,
-32399,
-32402,
-32392,
-32408,
-32396,
-32412,
-32406,
-32417,
-32413,
-32427,
-32428,
-32444,
-32452,
-32458,
-32467,
-32475,
-32483,
-32501,
-32504,
-32517,
-32529,
-32538,
-32549,
-32561,
-32562,
-32587,
-32586,
-32606,
-32606,
-32629,
-32644,
-32666,
-32681,
-32692,
-32723,
-32731,
-32762,
-32756,
-32772,
-32766,
-32785,
-32781,
-32787,
-32775,
-32779,
-32771,
-32783,
-32775,
-32792,
-32789,
-32792,
-32785,
-32781,
-32782,
-32790,
-32785,
-32783,
-32784,
-32790,
-32801,
-32813,
-32805,
-32812,
-32826,
-32831,
-32858,
-32841,
-32854,
-32844,
-32859,
-32860,
-32884,
-32904,
-32940,
-32967,
-32998,
-33016,
-33037,
-33050,
-33049,
-33045,
-33033,
-33031,
-33030,
-33033,
-33026,
-33012,
-33004,
-32994,
-32985,
-32980,
-32977,
-32966,
-32971,
-32960,
-32962,
-32970,
-32966,
-32983,
-32970,
-32988,
-32979,
-32996,
-32993,
-32999,
-32993,
-32998,
-32992,
-33006,
-33007,
-33024,
-33028,
-33046,
-33050,
-33073,
-33075,
-33091,
-33085,
-33092,
-33090,
-33098,
-33103,
-33119,
-33129,
-33147,
-33153,
-33152,
-33149,
-33143,
-33152,
-33156,
-33176,
-33172,
-33186,
-33180,
-33190,
-33175,
-33172,
-33142,
-33132,
-33105,
-33096,
-33093,
-33089,
-33092,
-33081,
-33071,
-33056,
-33064,
-33076,
-33091,
-33095,
-33093,
-33095,
-33099,
-33118,
-33112,
-33130,
-33126,
-33132,
-33145,
-33130,
-33132,
-33112,
-33106,
-33111,
-33119,
-33129,
-33130,
-33128,
-33115,
-33119,
-33114,
-33120,
-33114,
-33106,
-33094,
-33078,
-33078,
-33073,
-33084,
-33083,
-33076,
-33061,
-33051,
-33037,
-33052,
-33035,
-33040,
-33019,
-33017,
-33005,
-33001,
-32984,
-32973,
-32968,
-32954,
-32949,
-32935,
-32927,
-32929,
-32922,
-32927,
-32910,
-32917,
-32906,
-32900,
-32900,
-32888,
-32894,
-32881,
-32877,
-32855,
-32857,
-32846,
-32841,
-32831,
-32809,
-32813,
-32798,
-32805,
-32785,
-32783,
-32777,
-32778,
-32778,
-32769,
-32766,
-32773,
-32762,
-32780,
-32755,
-32778,
-32760,
-32774,
-32767,
-32764,
-32764,
-32757,
-32750,
-32744,
-32745,
-32738,
-32736,
-32723,
-32716,
-32720,
-32726,
-32726,
-32730,
-32732,
-32747,
-32753,
-32766,
-32756,
-32762,
-32767,
-32774,
-32780,
-32777,
-32776,
-32773,
-32771,
-32768,
-32763,
-32756,
-32752,
-32728,
-32735,
-32716,
-32715,
-32708,
-32686,
-32686,
-32675,
-32672,
-32648,
-32639,
-32612,
-32612,
-32610,
-32603,
-32608,
-32602,
-32605,
-32597,
-32599,
-32585,
-32597,
-32588,
-32589,
-32591,
-32578,
-32606,
-32601,
-32622,
-32617,
-32629,
-32625,
-32640,
-32642,
-32655,
-32674,
-32692,
-32714,
-32720,
-32727,
-32716,
-32726,
-32716,
-32725,
-32723,
-32726,
-32737,
-32746,
-32763,
-32779,
-32782,
-32790,
-32788,
-32792,
-32798,
-32794,
-32803,
-32801,
-32797,
-32800,
-32776,
-32786,
-32778,
-32785,
-32788,
-32778,
-32770,
-32776,
-32770,
-32779,
-32785,
-32784,
-32802,
-32799,
-32806,
-32809,
-32815,
-32830,
-32844,
-32861,
-32878,
-32893,
-32907,
-32921,
-32935,
-32959,
-32981,
-32992,
-33000,
-32991,
-32996,
-32992,
-33002,
-32993,
-32991,
-32983,
-32993,
-32989,
-32990,
-32988,
-32980,
-33002,
-33006,
-33026,
-33017,
-33022,
-33020,
-33034,
-33049,
-33056,
-33056,
-33062,
-33050,
-33059,
-33045,
-33048,
-33044,
-33043,
-33037,
-33034,
-33027,
-33031,
-33030,
-33032,
-33034,
-33038,
-33047,
-33048,
-33059,
-33048,
-33076,
-33068,
-33105,
-33096,
-33119,
-33124,
-33130,
-33142,
-33131,
-33135,
-33117,
-33118,
-33115,
-33115,
-33114,
-33112,
-33098,
-33103,
-33095,
-33087,
-33078,
-33057,
-33054,
-33043,
-33043,
-33038,
-33035,
-33040,
-33044,
-33055,
-33047,
-33051,
-33027,
-33032,
-33021,
-33028,
-33021,
-33025,
-33014,
-33019,
-33018,
-33025,
-33038,
-33041,
-33046,
-33040,
-33029,
-33017,
-33001,
-32987,
-32976,
-32965,
-32952,
-32948,
-32926,
-32926,
-32900,
-32898,
-32874,
-32871,
-32855,
-32862,
-32855,
-32857,
-32843,
-32839,
-32820,
-32819,
-32802,
-32803,
-32800,
-32794,
-32788,
-32775,
-32784,
-32776,
-32791,
-32782,
-32777,
-32781,
-32774,
-32781,
-32774,
-32767,
-32746,
-32740,
-32717,
-32714,
-32704,
-32699,
-32697,
-32690,
-32679,
-32674,
-32656,
-32655,
-32636,
-32617,
-32611,
-32586,
-32594,
-32575,
-32578,
-32562,
-32565,
-32553,
-32553,
-32544,
-32542,
-32540,
-32546,
-32552,
-32558,
-32562,
-32572,
-32582,
-32596,
-32605,
-32611,
-32616,
-32625,
-32629,
-32635,
-32633,
-32640,
-32646,
-32647,
-32652,
-32634,
-32642,
-32628,
-32643,
-32631,
-32639,
-32635,
-32653,
-32659,
-32662,
-32658,
-32655,
-32652,
-32658,
-32651,
-32651,
-32645,
-32641,
-32641,
-32642,
-32634,
-32631,
-32627,
-32623,
-32631,
-32630,
-32630,
-32639,
-32650,
-32672,
-32691,
-32693,
-32704,
-32711,
-32737,
-32766,
-32781,
-32805,
-32810,
-32828,
-32829,
-32830,
-32814,
-32831,
-32812,
-32826,
-32815,
-32804,
-32809,
-32793,
-32792,
-32780,
-32777,
-32778,
-32779,
-32773,
-32773,
-32761,
-32778,
-32768,
-32778,
-32762,
-32769,
-32764,
-32763,
-32768,
-32749,
-32761,
-32740,
-32750,
-32732,
-32738,
-32726,
-32737,
-32730,
-32747,
-32739,
-32752,
-32746,
-32763,
-32764,
-32775,
-32766,
-32760,
-32764,
-32764,
-32776,
-32779,
-32772,
-32784,
-32779,
-32786,
-32767,
-32766,
-32750,
-32756,
-32746,
-32720,
-32706,
-32681,
-32670,
-32666,
-32635,
-32618,
-32603,
-32585,
-32587,
-32569,
-32558,
-32544,
-32538,
-32516,
-32508,
-32488,
-32491,
-32483,
-32490,
-32468,
-32475,
-32465,
-32471,
-32476,
-32456,
-32454,
-32443,
-32442,
-32440,
-32438,
-32429,
-32434,
-32435,
-32442,
-32437,
-32453,
-32453,
-32470,
-32468,
-32471,
-32468,
-32474,
-32480,
-32477,
-32486,
-32483,
-32497,
-32488,
-32497,
-32493,
-32502,
-32515,
-32519,
-32516,
-32527,
-32528,
-32535,
-32535,
-32521,
-32525,
-32520,
-32536,
-32525,
-32537,
-32518,
-32542,
-32527,
-32548,
-32535,
-32538,
-32538,
-32542,
-32545,
-32563,
-32557,
-32570,
-32562,
-32563,
-32573,
-32582,
-32593,
-32597,
-32600,
-32617,
-32630,
-32659,
-32661,
-32670,
-32668,
-32674,
-32684,
-32690,
-32693,
-32693,
-32697,
-32712,
-32720,
-32728,
-32731,
-32730,
-32722,
-32731,
-32716,
-32721,
-32713,
-32719,
-32734,
-32729,
-32726,
-32707,
-32692,
-32695,
-32681,
-32686,
-32666,
-32667,
-32653,
-32651,
-32644,
-32634,
-32635,
-32636,
-32634,
-32630,
-32620,
-32621,
-32625,
-32640,
-32636,
-32646,
-32631,
-32636,
-32635,
-32642,
-32646,
-32648,
-32644,
-32645,
-32636,
-32633,
-32611,
-32608,
-32586,
-32588,
-32565,
-32566,
-32552,
-32547,
-32550,
-32541,
-32535,
-32525,
-32512,
-32505,
-32501,
-32495,
-32492,
-32492,
-32493,
-32501,
-32498,
-32516,
-32511,
-32529,
-32531,
-32530,
-32537,
-32533,
-32546,
-32566,
-32574,
-32594,
-32599,
-32602,
-32626,
-32625,
-32659,
-32653,
-32676,
-32673,
-32680,
-32694,
-32697,
-32706,
-32715,
-32703,
-32721,
-32714,
-32738,
-32743,
-32757,
-32754,
-32762,
-32762,
-32771,
-32769,
-32764,
-32762,
-32752,
-32761,
-32745,
-32756,
-32738,
-32753,
-32744,
-32749,
-32733,
-32730,
-32729,
-32743,
-32751,
-32759,
-32750,
-32757,
-32747,
-32757,
-32741,
-32750,
-32741,
-32740,
-32742,
-32718,
-32725,
-32703,
-32705,
-32699,
-32696,
-32697,
-32699,
-32685,
-32682,
-32672,
-32688,
-32703,
-32727,
-32732,
-32744,
-32748,
-32748,
-32740,
-32737,
-32723,
-32732,
-32716,
-32713,
-32700,
-32697,
-32699,
-32705,
-32690,
-32686,
-32676,
-32666,
-32682,
-32669,
-32684,
-32677,
-32681,
-32684,
-32681,
-32689,
-32684,
-32685,
-32671,
-32678,
-32675,
-32686,
-32687,
-32686,
-32681,
-32678,
-32677,
-32673,
-32684,
-32684,
-32688,
-32700,
-32691,
-32712,
-32711,
-32732,
-32740,
-32753,
-32774,
-32786,
-32808,
-32817,
-32846,
-32848,
-32892,
-32890,
-32923,
-32915,
-32924,
-32911,
-32924,
-32918,
-32913,
-32908,
-32894,
-32888,
-32873,
-32863,
-32847,
-32855,
-32846,
-32856,
-32835,
-32835,
-32818,
-32823,
-32825,
-32818,
-32833,
-32822,
-32843,
-32829,
-32834,
-32822,
-32831,
-32837,
-32834,
-32849,
-32839,
-32865,
-32860,
-32873,
-32865,
-32879,
-32872,
-32885,
-32879,
-32876,
-32879,
-32883,
-32891,
-32890,
-32891,
-32877,
-32877,
-32856,
-32839,
-32828,
-32811,
-32823,
-32811,
-32809,
-32801,
-32788,
-32795,
-32782,
-32779,
-32767,
-32769,
-32773,
-32784,
-32785,
-32781,
-32779,
-32779,
-32790,
-32792,
-32799,
-32793,
-32796,
-32793,
-32789,
-32796,
-32796,
-32817,
-32811,
-32833,
-32831,
-32850,
-32857,
-32864,
-32865,
-32882,
-32890,
-32907,
-32897,
-32889,
-32880,
-32890,
-32902,
-32917,
-32919,
-32933,
-32949,
-32961,
-32976,
-32966,
-32964,
-32954,
-32942,
-32939,
-32918,
-32926,
-32918,
-32920,
-32918,
-32907,
-32889,
-32891,
-32864,
-32872,
-32858,
-32848,
-32849,
-32835,
-32837,
-32831,
-32821,
-32812,
-32802,
-32786,
-32780,
-32772,
-32767,
-32760,
-32746,
-32726,
-32714,
-32715,
-32716,
-32724,
-32719,
-32717,
-32718,
-32725,
-32731,
-32736,
-32732,
-32736,
-32729,
-32733,
-32739,
-32749,
-32774,
-32782,
-32797,
-32808,
-32819,
-32832,
-32842,
-32834,
-32858,
-32854,
-32870,
-32870,
-32866,
-32878,
-32884,
-32901,
-32898,
-32906,
-32882,
-32897,
-32884,
-32894,
-32898,
-32895,
-32908,
-32900,
-32911,
-32893,
-32900,
-32888,
-32888,
-32895,
-32888,
-32887,
-32875,
-32864,
-32856,
-32857,
-32856,
-32857,
-32855,
-32845,
-32844,
-32844,
-32841,
-32839,
-32834,
-32829,
-32825,
-32824,
-32823,
-32808,
-32813,
-32783,
-32800,
-32777,
-32780,
-32764,
-32766,
-32759,
-32758,
-32745,
-32737,
-32734,
-32728,
-32723,
-32708,
-32698,
-32696,
-32694,
-32691,
-32694,
-32689,
-32702,
-32712,
-32713,
-32721,
-32721,
-32730,
-32735,
-32745,
-32738,
-32750,
-32747,
-32761,
-32766,
-32768,
-32782,
-32777,
-32797,
-32793,
-32809,
-32806,
-32821,
-32814,
-32835,
-32835,
-32855,
-32866,
-32870,
-32890,
-32881,
-32901,
-32896,
-32904,
-32906,
-32913,
-32896,
-32903,
-32880,
-32886,
-32878,
-32884,
-32878,
-32879,
-32877,
-32866,
-32873,
-32856,
-32849,
-32841,
-32838,
-32839,
-32837,
-32825,
-32812,
-32802,
-32799,
-32797,
-32790,
-32778,
-32771,
-32759,
-32769,
-32756,
-32762,
-32746,
-32758,
-32758,
-32775,
-32776,
-32776,
-32778,
-32782,
-32781,
-32778,
-32774,
-32772,
-32788,
-32795,
-32801,
-32798,
-32796,
-32791,
-32788,
-32771,
-32751,
-32738,
-32735,
-32730,
-32738,
-32729,
-32741,
-32744,
-32738,
-32730,
-32710,
-32714,
-32721,
-32724,
-32720,
-32711,
-32701,
-32709,
-32701,
-32703,
-32693,
-32688,
-32698,
-32687,
-32704,
-32684,
-32695,
-32688,
-32695,
-32696,
-32700,
-32697,
-32700,
-32704,
-32720,
-32717,
-32738,
-32724,
-32734,
-32743,
-32732,
-32762,
-32741,
-32763,
-32750,
-32748,
-32745,
-32750,
-32749,
-32746,
-32741,
-32734,
-32742,
-32749,
-32746,
-32752,
-32744,
-32753,
-32755,
-32767,
-32767,
-32765,
-32773,
-32763,
-32776,
-32773,
-32778,
-32778,
-32785,
-32779,
-32791,
-32787,
-32795,
-32797,
-32792,
-32796,
-32787,
-32786,
-32776,
-32778,
-32772,
-32774,
-32761,
-32751,
-32744,
-32726,
-32719,
-32697,
-32687,
-32684,
-32675,
-32672,
-32655,
-32641,
-32644,
-32630,
-32634,
-32624,
-32626,
-32624,
-32635,
-32629,
-32637,
-32647,
-32638,
-32653,
-32641,
-32650,
-32648,
-32644,
-32643,
-32629,
-32639,
-32626,
-32629,
-32613,
-32613,
-32611,
-32612,
-32611,
-32605,
-32614,
-32618,
-32632,
-32631,
-32646,
-32651,
-32663,
-32678,
-32681,
-32713,
-32720,
-32732,
-32737,
-32734,
-32756,
-32773,
-32779,
-32791,
-32801,
-32814,
-32841,
-32830,
-32830,
-32825,
-32825,
-32835,
-32824,
-32813,
-32807,
-32803,
-32813,
-32813,
-32813,
-32813,
-32800,
-32797,
-32783,
-32776,
-32779,
-32765,
-32774,
-32758,
-32764,
-32760,
-32747,
-32743,
-32729,
-32726,
-32726,
-32714,
-32719,
-32710,
-32723,
-32723,
-32743,
-32744,
-32771,
-32769,
-32780,
-32788,
-32780,
-32801,
-32784,
-32788,
-32770,
-32763,
-32755,
-32762,
-32757,
-32763,
-32757,
-32746,
-32747,
-32728,
-32735,
-32712,
-32713,
-32690,
-32686,
-32676,
-32674,
-32668,
-32672,
-32662,
-32669,
-32658,
-32653,
-32653,
-32642,
-32659,
-32634,
-32644,
-32628,
-32637,
-32647,
-32642,
-32642,
-32630,
-32633,
-32629,
-32635,
-32635,
-32633,
-32630,
-32628,
-32630,
-32631,
-32641,
-32640,
-32642,
-32637,
-32634,
-32639,
-32644,
-32643,
-32649,
-32637,
-32640,
-32645,
-32644,
-32651,
-32646,
-32643,
-32659,
-32651,
-32659,
-32652,
-32652,
-32661,
-32662,
-32663,
-32668,
-32668,
-32679,
-32679,
-32688,
-32688,
-32699,
-32707,
-32707,
-32712,
-32718,
-32726,
-32748,
-32753,
-32757,
-32770,
-32773,
-32791,
-32802,
-32812,
-32822,
-32835,
-32840,
-32847,
-32848,
-32849,
-32856,
-32855,
-32862,
-32863,
-32874,
-32880,
-32893,
-32899,
-32915,
-32922,
-32921,
-32926,
-32908,
-32913,
-32895,
-32887,
-32888,
-32882,
-32891,
-32885,
-32870,
-32862,
-32854,
-32851,
-32841,
-32826,
-32811,
-32811,
-32799,
-32801,
-32781,
-32781,
-32771,
-32761,
-32771,
-32749,
-32767,
-32747,
-32748,
-32737,
-32745,
-32736,
-32751,
-32725,
-32741,
-32728,
-32752,
-32742,
-32745,
-32730,
-32743,
-32743,
-32751,
-32737,
-32743,
-32746,
-32760,
-32765,
-32757,
-32757,
-32751,
-32748,
-32736,
-32730,
-32716,
-32731,
-32732,
-32750,
-32759,
-32763,
-32765,
-32751,
-32746,
-32730,
-32722,
-32717,
-32702,
-32702,
-32699,
-32693,
-32690,
-32679,
-32668,
-32658,
-32644,
-32627,
-32620,
-32613,
-32605,
-32607,
-32594,
-32603,
-32600,
-32608,
-32598,
-32607,
-32598,
-32610,
-32600,
-32599,
-32592,
-32601,
-32605,
-32610,
-32616,
-32616,
-32638,
-32640,
-32662,
-32664,
-32670,
-32689,
-32688,
-32714,
-32720,
-32740,
-32757,
-32779,
-32799,
-32809,
-32812,
-32817,
-32817,
-32823,
-32824,
-32824,
-32835,
-32831,
-32847,
-32838,
-32852,
-32849,
-32851,
-32851,
-32847,
-32848,
-32840,
-32850,
-32834,
-32854,
-32846,
-32853,
-32855,
-32848,
-32848,
-32854,
-32852,
-32861,
-32849,
-32857,
-32850,
-32866,
-32864,
-32875,
-32873,
-32882,
-32885,
-32893,
-32886,
-32888,
-32891,
-32897,
-32910,
-32912,
-32905,
-32909,
-32896,
-32899,
-32896,
-32894,
-32892,
-32898,
-32907,
-32927,
-32940,
-32954,
-32959,
-32976,
-32978,
-32984,
-32970,
-32967,
-32967,
-32978,
-32985,
-32988,
-32978,
-32976,
-32976,
-32978,
-32975,
-32967,
-32956,
-32948,
-32940,
-32932,
-32920,
-32913,
-32911,
-32905,
-32904,
-32901,
-32882,
-32892,
-32869,
-32874,
-32861,
-32850,
-32848,
-32838,
-32837,
-32822,
-32818,
-32812,
-32817,
-32822,
-32816,
-32803,
-32793,
-32784,
-32786,
-32770,
-32773,
-32759,
-32760,
-32756,
-32746,
-32750,
-32749,
-32765,
-32769,
-32770,
-32772,
-32761,
-32760,
-32742,
-32735,
-32726,
-32719,
-32710,
-32698,
-32695,
-32704,
-32709,
-32715,
-32698,
-32686,
-32672,
-32662,
-32658,
-32648,
-32653,
-32660,
-32658,
-32656,
-32632,
-32629,
-32620,
-32621,
-32626,
-32614,
-32616,
-32598,
-32598,
-32580,
-32588,
-32584,
-32589,
-32576,
-32565,
-32557,
-32549,
-32548,
-32541,
-32529,
-32528,
-32506,
-32502,
-32489,
-32495,
-32502,
-32505,
-32516,
-32499,
-32518,
-32511,
-32532,
-32531,
-32540,
-32545,
-32547,
-32554,
-32542,
-32540,
-32527,
-32525,
-32519,
-32519,
-32504,
-32502,
-32491,
-32491,
-32484,
-32485,
-32473,
-32480,
-32477,
-32475,
-32476,
-32481,
-32475,
-32485,
-32478,
-32478,
-32495,
-32492,
-32510,
-32512,
-32520,
-32530,
-32539,
-32538,
-32547,
-32538,
-32562,
-32555,
-32570,
-32564,
-32575,
-32590,
-32608,
-32622,
-32626,
-32629,
-32636,
-32647,
-32663,
-32676,
-32679,
-32688,
-32674,
-32672,
-32658,
-32656,
-32658,
-32664,
-32671,
-32678,
-32677,
-32681,
-32670,
-32673,
-32672,
-32684,
-32685,
-32694,
-32685,
-32690,
-32697,
-32705,
-32714,
-32720,
-32726,
-32736,
-32740,
-32747,
-32748,
-32754,
-32762,
-32766,
-32771,
-32770,
-32769,
-32764,
-32777,
-32769,
-32786,
-32781,
-32792,
-32790,
-32791,
-32788,
-32794,
-32802,
-32811,
-32818,
-32815,
-32830,
-32835,
-32855,
-32866,
-32874,
-32877,
-32883,
-32887,
-32889,
-32880,
-32883,
-32875,
-32883,
-32877,
-32879,
-32880,
-32886,
-32885,
-32885,
-32877,
-32871,
-32875,
-32864,
-32865,
-32850,
-32855,
-32855,
-32865,
-32856,
-32862,
-32845,
-32868,
-32857,
-32882,
-32872,
-32881,
-32882,
-32884,
-32895,
-32906,
-32916,
-32923,
-32941,
-32933,
-32963,
-32953,
-32965,
-32959,
-32963,
-32964,
-32973,
-32965,
-32982,
-32980,
-32999,
-33002,
-33000,
-33002,
-32998,
-33003,
-32996,
-32995,
-32997,
-33006,
-33018,
-33012,
-33012,
-33000,
-33000,
-32996,
-32991,
-32987,
-32977,
-32978,
-32968,
-32963,
-32956,
-32945,
-32940,
-32930,
-32930,
-32915,
-32924,
-32912,
-32919,
-32915,
-32918,
-32908,
-32909,
-32905,
-32913,
-32925,
-32924,
-32932,
-32939,
-32945,
-32960,
-32961,
-32966,
-32974,
-32978,
-32984,
-32978,
-32980,
-32985,
-32992,
-33004,
-32996,
-33003,
-32996,
-32992,
-32975,
-32954,
-32932,
-32913,
-32905,
-32888,
-32885,
-32871,
-32857,
-32843,
-32826,
-32815,
-32809,
-32803,
-32799,
-32793,
-32793,
-32791,
-32792,
-32783,
-32781,
-32775,
-32775,
-32779,
-32781,
-32775,
-32788,
-32778,
-32789,
-32783,
-32773,
-32762,
-32742,
-32730,
-32723,
-32716,
-32706,
-32710,
-32704,
-32705,
-32710,
-32689,
-32703,
-32701,
-32717,
-32727,
-32731,
-32734,
-32756,
-32751,
-32777,
-32755,
-32772,
-32765,
-32773,
-32765,
-32765,
-32761,
-32776,
-32776,
-32781,
-32780,
-32776,
-32774,
-32750,
-32739,
-32711,
-32718,
-32713,
-32703,
-32700,
-32677,
-32693,
-32681,
-32680,
-32653,
-32649,
-32634,
-32647,
-32636,
-32638,
-32639,
-32635,
-32635,
-32631,
-32628,
-32635,
-32633,
-32635,
-32632,
-32639,
-32650,
-32668,
-32677,
-32693,
-32692,
-32705,
-32711,
-32709,
-32714,
-32719,
-32719,
-32738,
-32734,
-32732,
-32733,
-32702,
-32702,
-32683,
-32684,
-32687,
-32682,
-32686,
-32682,
-32684,
-32678,
-32681,
-32687,
-32686,
-32689,
-32681,
-32672,
-32679,
-32670,
-32675,
-32660,
-32669,
-32651,
-32661,
-32645,
-32649,
-32638,
-32643,
-32633,
-32628,
-32627,
-32622,
-32630,
-32628,
-32628,
-32619,
-32626,
-32621,
-32633,
-32631,
-32637,
-32640,
-32652,
-32655,
-32668,
-32668,
-32672,
-32659,
-32656,
-32651,
-32651,
-32651,
-32651,
-32648,
-32654,
-32645,
-32646,
-32632,
-32636,
-32628,
-32639,
-32626,
-32638,
-32629,
-32653,
-32658,
-32676,
-32687,
-32692,
-32710,
-32709,
-32719,
-32723,
-32726,
-32732,
-32712,
-32717,
-32704,
-32706,
-32698,
-32683,
-32679,
-32680,
-32686,
-32694,
-32687,
-32689,
-32692,
-32696,
-32703,
-32706,
-32714,
-32736,
-32745,
-32770,
-32772,
-32804,
-32804,
-32820,
-32800,
-32799,
-32791,
-32791,
-32793,
-32789,
-32794,
-32797,
-32789,
-32784,
-32766,
-32767,
-32763,
-32752,
-32741,
-32724,
-32711,
-32722,
-32710,
-32724,
-32722,
-32734,
-32746,
-32741,
-32737,
-32726,
-32729,
-32736,
-32741,
-32739,
-32741,
-32732,
-32753,
-32744,
-32758,
-32752,
-32750,
-32749,
-32747,
-32749,
-32746,
-32772,
-32764,
-32784,
-32766,
-32768,
-32761,
-32775,
-32769,
-32784,
-32773,
-32789,
-32789,
-32798,
-32800,
-32788,
-32794,
-32780,
-32778,
-32765,
-32762,
-32748,
-32760,
-32743,
-32745,
-32736,
-32727,
-32739,
-32739,
-32751,
-32749,
-32756,
-32749,
-32756,
-32757,
-32767,
-32766,
-32768,
-32767,
-32761,
-32766,
-32758,
-32761,
-32768,
-32766,
-32782,
-32788,
-32800,
-32816,
-32810,
-32822,
-32812,
-32823,
-32830,
-32832,
-32837,
-32827,
-32830,
-32826,
-32830,
-32819,
-32816,
-32804,
-32798,
-32799,
-32778,
-32779,
-32758,
-32761,
-32761,
-32757,
-32763,
-32753,
-32758,
-32757,
-32770,
-32777,
-32787,
-32786,
-32788,
-32790,
-32788,
-32791,
-32785,
-32791,
-32794,
-32795,
-32806,
-32809,
-32816,
-32821,
-32815,
-32810,
-32793,
-32790,
-32778,
-32781,
-32777,
-32782,
-32785,
-32797,
-32783,
-32791,
-32777,
-32780,
-32776,
-32764,
-32759,
-32748,
-32745,
-32733,
-32723,
-32716,
-32703,
-32708,
-32692,
-32684,
-32675,
-32667,
-32671,
-32668,
-32663,
-32656,
-32657,
-32651,
-32637,
-32631,
-32611,
-32625,
-32615,
-32613,
-32594,
-32587,
-32577,
-32569,
-32574,
-32560,
-32554,
-32553,
-32533,
-32536,
-32545,
-32540,
-32561,
-32549,
-32548,
-32561,
-32561,
-32584,
-32575,
-32588,
-32577,
-32596,
-32581,
-32593,
-32589,
-32605,
-32605,
-32611,
-32603,
-32602,
-32618,
-32608,
-32616,
-32597,
-32584,
-32583,
-32568,
-32571,
-32550,
-32549,
-32544,
-32552,
-32538,
-32542,
-32518,
-32532,
-32522,
-32521,
-32515,
-32508,
-32506,
-32508,
-32502,
-32497,
-32488,
-32477,
-32483,
-32490,
-32499,
-32508,
-32507,
-32512,
-32522,
-32528,
-32540,
-32537,
-32536,
-32537,
-32537,
-32548,
-32554,
-32564,
-32569,
-32576,
-32577,
-32582,
-32589,
-32593,
-32616,
-32609,
-32625,
-32600,
-32593,
-32583,
-32575,
-32578,
-32557,
-32556,
-32545,
-32550,
-32547,
-32538,
-32532,
-32530,
-32532,
-32534,
-32537,
-32534,
-32552,
-32551,
-32580,
-32569,
-32586,
-32577,
-32581,
-32580,
-32586,
-32584,
-32609,
-32594,
-32618,
-32603,
-32627,
-32629,
-32647,
-32647,
-32667,
-32681,
-32707,
-32710,
-32729,
-32720,
-32746,
-32749,
-32768,
-32771,
-32791,
-32798,
-32814,
-32818,
-32828,
-32828,
-32829,
-32813,
-32804,
-32792,
-32808,
-32807,
-32821,
-32812,
-32813,
-32815,
-32812,
-32820,
-32808,
-32827,
-32820,
-32838,
-32839,
-32856,
-32866,
-32874,
-32877,
-32872,
-32883,
-32881,
-32888,
-32890,
-32886,
-32898,
-32899,
-32911,
-32912,
-32921,
-32920,
-32939,
-32930,
-32944,
-32930,
-32948,
-32949,
-32971,
-32978,
-32987,
-32991,
-33000,
-32981,
-32987,
-32966,
-32972,
-32969,
-32974,
-32974,
-32986,
-32998,
-33013,
-33024,
-33031,
-33038,
-33038,
-33036,
-33022,
-33005,
-32999,
-32995,
-32997,
-32998,
-32996,
-32995,
-32996,
-32992,
-32975,
-32974,
-32952,
-32968,
-32962,
-32968,
-32967,
-32975,
-32978,
-32985,
-32984,
-32976,
-32990,
-32994,
-33007,
-33015,
-33005,
-33013,
-33010,
-33027,
-33022,
-33030,
-33011,
-33008,
-32993,
-32989,
-32976,
-32966,
-32951,
-32945,
-32935,
-32939,
-32928,
-32916,
-32908,
-32897,
-32896,
-32900,
-32894,
-32897,
-32887,
-32897,
-32885,
-32905,
-32899,
-32913,
-32912,
-32911,
-32907,
-32902,
-32904,
-32911,
-32913,
-32922,
-32914,
-32920,
-32914,
-32912,
-32910,
-32905,
-32902,
-32896,
-32885,
-32871,
-32866,
-32851,
-32856,
-32833,
-32830,
-32808,
-32806,
-32798,
-32798,
-32788,
-32780,
-32771,
-32772,
-32771,
-32773,
-32765,
-32767,
-32762,
-32767,
-32751,
-32749,
-32738,
-32750,
-32750,
-32750,
-32744,
-32741,
-32753,
-32749,
-32754,
-32745,
-32743,
-32752,
-32749,
-32748,
-32737,
-32734,
-32730,
-32721,
-32721,
-32711,
-32720,
-32715,
-32713,
-32699,
-32704,
-32699,
-32709,
-32712,
-32708,
-32728,
-32716,
-32731,
-32722,
-32728,
-32738,
-32753,
-32752,
-32763,
-32761,
-32773,
-32784,
-32790,
-32803,
-32805,
-32818,
-32805,
-32791,
-32786,
-32778,
-32786,
-32773,
-32767,
-32755,
-32771,
-32771,
-32777,
-32781,
-32770,
-32787,
-32777,
-32786,
-32772,
-32781,
-32772,
-32780,
-32766,
-32767,
-32761,
-32770,
-32767,
-32765,
-32773,
-32767,
-32793,
-32774,
-32792,
-32777,
-32799,
-32793,
-32798,
-32786,
-32790,
-32790,
-32808,
-32811,
-32825,
-32823,
-32841,
-32843,
-32856,
-32858,
-32865,
-32882,
-32887,
-32892,
-32888,
-32872,
-32867,
-32848,
-32843,
-32849,
-32840,
-32854,
-32835,
-32842,
-32832,
-32835,
-32836,
-32828,
-32828,
-32819,
-32814,
-32808,
-32799,
-32790,
-32784,
-32766,
-32774,
-32756,
-32771,
-32755,
-32754,
-32734,
-32732,
-32721,
-32722,
-32712,
-32706,
-32702,
-32702,
-32706,
-32704,
-32707,
-32713,
-32721,
-32726,
-32738,
-32731,
-32742,
-32741,
-32734,
-32736,
-32729,
-32723,
-32729,
-32702,
-32706,
-32690,
-32692,
-32684,
-32675,
-32669,
-32671,
-32672,
-32679,
-32672,
-32674,
-32672,
-32686,
-32676,
-32691,
-32666,
-32669,
-32651,
-32652,
-32649,
-32656,
-32652,
-32644,
-32638,
-32633,
-32635,
-32620,
-32622,
-32605,
-32605,
-32608,
-32608,
-32605,
-32616,
-32598,
-32619,
-32610,
-32628,
-32624,
-32629,
-32624,
-32633,
-32636,
-32650,
-32649,
-32661,
-32668,
-32691,
-32699,
-32717,
-32717,
-32726,
-32727,
-32733,
-32717,
-32711,
-32690,
-32682,
-32691,
-32687,
-32696,
-32699,
-32694,
-32698,
-32690,
-32695,
-32693,
-32699,
-32709,
-32713,
-32727,
-32732,
-32733,
-32738,
-32742,
-32736,
-32744,
-32731,
-32738,
-32737,
-32737,
-32730,
-32727,
-32721,
-32730,
-32731,
-32731,
-32740,
-32734,
-32754,
-32748,
-32752,
-32752,
-32751,
-32763,
-32766,
-32767,
-32777,
-32777,
-32791,
-32794,
-32805,
-32804,
-32819,
-32818,
-32822,
-32817,
-32824,
-32826,
-32837,
-32828,
-32831,
-32825,
-32834,
-32834,
-32828,
-32819,
-32809,
-32817,
-32824,
-32829,
-32823,
-32820,
-32815,
-32820,
-32809,
-32816,
-32802,
-32812,
-32794,
-32797,
-32787,
-32789,
-32797,
-32786,
-32792,
-32784,
-32780,
-32786,
-32776,
-32780,
-32784,
-32787,
-32794,
-32793,
-32794,
-32798,
-32801,
-32816,
-32815,
-32822,
-32825,
-32821,
-32821,
-32819,
-32810,
-32813,
-32802,
-32790,
-32780,
-32772,
-32766,
-32760,
-32752,
-32751,
-32740,
-32737,
-32725,
-32725,
-32718,
-32730,
-32712,
-32713,
-32702,
-32708,
-32709,
-32715,
-32716,
-32714,
-32736,
-32738,
-32757,
-32758,
-32770,
-32767,
-32797,
-32793,
-32814,
-32808,
-32814,
-32804,
-32809,
-32794,
-32799,
-32786,
-32793,
-32786,
-32784,
-32779,
-32770,
-32769,
-32771,
-32775,
-32765,
-32772,
-32755,
-32771,
-32762,
-32765,
-32765,
-32764,
-32769,
-32773,
-32772,
-32770,
-32786,
-32771,
-32791,
-32783,
-32792,
-32797,
-32808,
-32808,
-32826,
-32828,
-32837,
-32842,
-32858,
-32867,
-32896,
-32906,
-32920,
-32925,
-32923,
-32932,
-32927,
-32931,
-32924,
-32920,
-32921,
-32916,
-32909,
-32908,
-32895,
-32896,
-32888,
-32890,
-32879,
-32886,
-32872,
-32877,
-32862,
-32859,
-32854,
-32850,
-32845,
-32837,
-32828,
-32831,
-32828,
-32828,
-32825,
-32817,
-32820,
-32809,
-32821,
-32799,
-32806,
-32796,
-32795,
-32806,
-32795,
-32808,
-32810,
-32815,
-32819,
-32814,
-32804,
-32806,
-32797,
-32800,
-32785,
-32777,
-32762,
-32754,
-32748,
-32752,
-32743,
-32751,
-32739,
-32749,
-32747,
-32751,
-32743,
-32745,
-32744,
-32758,
-32766,
-32764,
-32763,
-32757,
-32765,
-32765,
-32770,
-32762,
-32764,
-32763,
-32767,
-32758,
-32753,
-32751,
-32744,
-32748,
-32732,
-32720,
-32715,
-32705,
-32705,
-32701,
-32692,
-32699,
-32692,
-32699,
-32684,
-32687,
-32681,
-32689,
-32685,
-32697,
-32700,
-32708,
-32720,
-32715,
-32739,
-32742,
-32766,
-32768,
-32779,
-32775,
-32783,
-32785,
-32784,
-32778,
-32777,
-32771,
-32773,
-32771,
-32764,
-32772,
-32759,
-32775,
-32760,
-32774,
-32762,
-32772,
-32767,
-32770,
-32767,
-32773,
-32768,
-32778,
-32763,
-32766,
-32751,
-32758,
-32742,
-32753,
-32740,
-32743,
-32738,
-32747,
-32747,
-32758,
-32754,
-32752,
-32752,
-32753,
-32754,
-32755,
-32741,
-32739,
-32737,
-32739,
-32739,
-32722,
-32709,
-32705,
-32702,
-32706,
-32694,
-32679,
-32670,
-32653,
-32658,
-32643,
-32643,
-32645,
-32640,
-32645,
-32639,
-32639,
-32636,
-32639,
-32638,
-32641,
-32647,
-32651,
-32641,
-32644,
-32634,
-32646,
-32646,
-32646,
-32638,
-32640,
-32643,
-32653,
-32647,
-32653,
-32644,
-32655,
-32649,
-32652,
-32646,
-32641,
-32640,
-32636,
-32633,
-32638,
-32624,
-32634,
-32613,
-32617,
-32609,
-32607,
-32604,
-32597,
-32593,
-32592,
-32588,
-32590,
-32587,
-32588,
-32597,
-32591,
-32603,
-32591,
-32597,
-32600,
-32603,
-32610,
-32611,
-32617,
-32611,
-32621,
-32600,
-32619,
-32610,
-32628,
-32638,
-32645,
-32655,
-32662,
-32667,
-32681,
-32688,
-32696,
-32698,
-32692,
-32700,
-32691,
-32691,
-32682,
-32668,
-32666,
-32664,
-32650,
-32658,
-32629,
-32637,
-32619,
-32618,
-32623,
-32615,
-32623,
-32610,
-32607,
-32610,
-32619,
-32635,
-32642,
-32646,
-32636,
-32647,
-32643,
-32653,
-32654,
-32657,
-32667,
-32666,
-32679,
-32666,
-32683,
-32674,
-32697,
-32687,
-32704,
-32688,
-32706,
-32703,
-32724,
-32717,
-32727,
-32718,
-32724,
-32710,
-32716,
-32689,
-32696,
-32685,
-32684,
-32687,
-32670,
-32678,
-32659,
-32670,
-32662,
-32676,
-32673,
-32681,
-32673,
-32677,
-32677,
-32695,
-32694,
-32699,
-32689,
-32679,
-32675,
-32671,
-32660,
-32657,
-32644,
-32645,
-32630,
-32633,
-32618,
-32623,
-32612,
-32617,
-32609,
-32614,
-32612,
-32610,
-32616,
-32611,
-32625,
-32619,
-32629,
-32623,
-32627,
-32636,
-32634,
-32654,
-32642,
-32659,
-32656,
-32662,
-32677,
-32673,
-32690,
-32681,
-32693,
-32697,
-32699,
-32711,
-32704,
-32709,
-32711,
-32724,
-32719,
-32724,
-32704,
-32707,
-32709,
-32712,
-32715,
-32710,
-32703,
-32707,
-32706,
-32701,
-32706,
-32701,
-32701,
-32708,
-32701,
-32715,
-32717,
-32728,
-32732,
-32740,
-32747,
-32763,
-32771,
-32783,
-32793,
-32802,
-32820,
-32818,
-32847,
-32841,
-32873,
-32867,
-32872,
-32867,
-32867,
-32872,
-32869,
-32856,
-32845,
-32837,
-32838,
-32842,
-32822,
-32825,
-32806,
-32817,
-32814,
-32814,
-32815,
-32826,
-32825,
-32842,
-32826,
-32831,
-32839,
-32844,
-32863,
-32863,
-32864,
-32878,
-32871,
-32896,
-32895,
-32915,
-32931,
-32936,
-32954,
-32950,
-32956,
-32941,
-32949,
-32935,
-32947,
-32942,
-32933,
-32931,
-32918,
-32909,
-32910,
-32896,
-32908,
-32888,
-32901,
-32880,
-32889,
-32883,
-32882,
-32882,
-32874,
-32873,
-32867,
-32866,
-32863,
-32857,
-32857,
-32846,
-32859,
-32840,
-32854,
-32840,
-32844,
-32842,
-32838,
-32843,
-32848,
-32845,
-32851,
-32834,
-32845,
-32834,
-32848,
-32828,
-32829,
-32816,
-32823,
-32814,
-32814,
-32792,
-32795,
-32792,
-32788,
-32785,
-32764,
-32757,
-32758,
-32760,
-32759,
-32765,
-32757,
-32766,
-32762,
-32766,
-32762,
-32773,
-32774,
-32780,
-32778,
-32776,
-32787,
-32792,
-32805,
-32809,
-32822,
-32827,
-32834,
-32837,
-32829,
-32843,
-32838,
-32842,
-32842,
-32834,
-32844,
-32841,
-32846,
-32847,
-32840,
-32846,
-32841,
-32844,
-32843,
-32842,
-32847,
-32834,
-32834,
-32825,
-32830,
-32831,
-32831,
-32820,
-32830,
-32831,
-32853,
-32849,
-32851,
-32853,
-32851,
-32865,
-32858,
-32863,
-32850,
-32868,
-32858,
-32870,
-32868,
-32869,
-32889,
-32887,
-32910,
-32900,
-32912,
-32897,
-32894,
-32881,
-32882,
-32882,
-32888,
-32879,
-32884,
-32875,
-32880,
-32873,
-32864,
-32869,
-32860,
-32871,
-32856,
-32862,
-32849,
-32864,
-32854,
-32866,
-32853,
-32854,
-32853,
-32854,
-32857,
-32853,
-32852,
-32847,
-32851,
-32849,
-32858,
-32859,
-32861,
-32863,
-32853,
-32867,
-32848,
-32870,
-32845,
-32861,
-32840,
-32846,
-32842,
-32849,
-32856,
-32860,
-32862,
-32861,
-32864,
-32866,
-32866,
-32869,
-32870,
-32867,
-32876,
-32866,
-32879,
-32880,
-32881,
-32888,
-32878,
-32878,
-32874,
-32873,
-32870,
-32860,
-32861,
-32856,
-32856,
-32849,
-32841,
-32830,
-32835,
-32821,
-32830,
-32817,
-32818,
-32804,
-32797,
-32792,
-32789,
-32790,
-32782,
-32776,
-32766,
-32770,
-32766,
-32770,
-32763,
-32766,
-32761,
-32769,
-32759,
-32767,
-32763,
-32763,
-32763,
-32757,
-32752,
-32752,
-32751,
-32751,
-32751,
-32744,
-32746,
-32745,
-32748,
-32748,
-32743,
-32738,
-32729,
-32722,
-32718,
-32726,
-32717,
-32730,
-32714,
-32730,
-32723,
-32730,
-32721,
-32716,
-32719,
-32709,
-32716,
-32698,
-32698,
-32710,
-32712,
-32730,
-32722,
-32727,
-32721,
-32730,
-32722,
-32729,
-32721,
-32725,
-32722,
-32715,
-32717,
-32716,
-32719,
-32715,
-32708,
-32698,
-32702,
-32697,
-32700,
-32691,
-32682,
-32677,
-32679,
-32671,
-32684,
-32672,
-32669,
-32670,
-32659,
-32667,
-32662,
-32655,
-32656,
-32639,
-32641,
-32626,
-32624,
-32613,
-32617,
-32615,
-32621,
-32615,
-32616,
-32619,
-32626,
-32637,
-32646,
-32654,
-32663,
-32672,
-32671,
-32677,
-32662,
-32668,
-32660,
-32668,
-32667,
-32661,
-32652,
-32641,
-32635,
-32644,
-32632,
-32642,
-32630,
-32627,
-32629,
-32617,
-32622,
-32624,
-32632,
-32644,
-32639,
-32633,
-32636,
-32639,
-32656,
-32657,
-32662,
-32660,
-32663,
-32665,
-32665,
-32672,
-32685,
-32693,
-32706,
-32705,
-32704,
-32704,
-32706,
-32697,
-32692,
-32681,
-32679,
-32676,
-32676,
-32671,
-32670,
-32670,
-32675,
-32660,
-32672,
-32654,
-32664,
-32663,
-32664,
-32664,
-32661,
-32658,
-32665,
-32674,
-32682,
-32680,
-32682,
-32689,
-32699,
-32717,
-32719,
-32730,
-32729,
-32742,
-32738,
-32741,
-32740,
-32751,
-32752,
-32765,
-32759,
-32767,
-32769,
-32775,
-32777,
-32780,
-32780,
-32785,
-32778,
-32772,
-32754,
-32753,
-32750,
-32752,
-32763,
-32748,
-32762,
-32748,
-32755,
-32746,
-32742,
-32729,
-32734,
-32728,
-32740,
-32739,
-32735,
-32738,
-32726,
-32734,
-32727,
-32738,
-32727,
-32737,
-32723,
-32732,
-32724,
-32737,
-32738,
-32747,
-32751,
-32737,
-32752,
-32746,
-32762,
-32761,
-32763,
-32756,
-32762,
-32763,
-32768,
-32779,
-32778,
-32787,
-32788,
-32792,
-32797,
-32792,
-32791,
-32786,
-32781,
-32788,
-32787,
-32789,
-32797,
-32797,
-32800,
-32807,
-32788,
-32800,
-32781,
-32782,
-32773,
-32771,
-32766,
-32771,
-32770,
-32771,
-32786,
-32786,
-32797,
-32790,
-32783,
-32779,
-32778,
-32769,
-32764,
-32755,
-32758,
-32752,
-32755,
-32730,
-32731,
-32715,
-32711,
-32701,
-32690,
-32686,
-32688,
-32680,
-32687,
-32667,
-32680,
-32663,
-32676,
-32655,
-32665,
-32658,
-32670,
-32669,
-32673,
-32669,
-32684,
-32684,
-32691,
-32693,
-32696,
-32705,
-32715,
-32727,
-32736,
-32747,
-32750,
-32756,
-32758,
-32755,
-32748,
-32730,
-32720,
-32716,
-32715,
-32709,
-32715,
-32699,
-32725,
-32718,
-32724,
-32712,
-32706,
-32702,
-32709,
-32698,
-32695,
-32680,
-32679,
-32674,
-32672,
-32674,
-32674,
-32689,
-32680,
-32701,
-32683,
-32700,
-32688,
-32686,
-32673,
-32673,
-32661,
-32666,
-32656,
-32645,
-32644,
-32631,
-32635,
-32626,
-32622,
-32630,
-32628,
-32630,
-32626,
-32622,
-32623,
-32641,
-32643,
-32663,
-32658,
-32663,
-32667,
-32671,
-32679,
-32679,
-32684,
-32677,
-32688,
-32680,
-32690,
-32685,
-32681,
-32681,
-32681,
-32689,
-32700,
-32701,
-32707,
-32706,
-32711,
-32711,
-32718,
-32710,
-32717,
-32706,
-32715,
-32713,
-32716,
-32719,
-32715,
-32712,
-32720,
-32710,
-32719,
-32713,
-32714,
-32718,
-32711,
-32712,
-32711,
-32708,
-32728,
-32711,
-32723,
-32708,
-32706,
-32723,
-32710,
-32723,
-32711,
-32704,
-32718,
-32707,
-32722,
-32717,
-32718,
-32725,
-32722,
-32728,
-32724,
-32723,
-32727,
-32725,
-32740,
-32746,
-32756,
-32765,
-32758,
-32773,
-32766,
-32794,
-32798,
-32813,
-32823,
-32826,
-32832,
-32839,
-32833,
-32839,
-32831,
-32833,
-32836,
-32828,
-32833,
-32826,
-32827,
-32825,
-32818,
-32818,
-32811,
-32817,
-32823,
-32818,
-32828,
-32807,
-32819,
-32806,
-32829,
-32827,
-32835,
-32830,
-32825,
-32827,
-32824,
-32834,
-32832,
-32844,
-32841,
-32849,
-32853,
-32853,
-32867,
-32865,
-32877,
-32870,
-32869,
-32869,
-32863,
-32865,
-32854,
-32852,
-32849,
-32848,
-32845,
-32836,
-32831,
-32829,
-32828,
-32831,
-32817,
-32821,
-32817,
-32816,
-32824,
-32806,
-32815,
-32806,
-32816,
-32817,
-32821,
-32826,
-32823,
-32826,
-32815,
-32823,
-32824,
-32831,
-32840,
-32829,
-32842,
-32839,
-32845,
-32855,
-32850,
-32865,
-32872,
-32895,
-32906,
-32910,
-32899,
-32896,
-32895,
-32895,
-32890,
-32877,
-32873,
-32864,
-32860,
-32850,
-32841,
-32835,
-32836,
-32830,
-32831,
-32817,
-32824,
-32809,
-32820,
-32807,
-32801,
-32805,
-32800,
-32803,
-32801,
-32785,
-32792,
-32784,
-32788,
-32783,
-32771,
-32778,
-32775,
-32786,
-32786,
-32783,
-32796,
-32792,
-32799,
-32789,
-32789,
-32782,
-32788,
-32775,
-32778,
-32756,
-32764,
-32757,
-32755,
-32765,
-32758,
-32770,
-32768,
-32771,
-32759,
-32770,
-32761,
-32772,
-32763,
-32760,
-32764,
-32765,
-32774,
-32755,
-32764,
-32751,
-32767,
-32755,
-32761,
-32756,
-32770,
-32772,
-32780,
-32758,
-32771,
-32752,
-32773,
-32750,
-32745,
-32729,
-32724,
-32729,
-32721,
-32723,
-32708,
-32709,
-32699,
-32694,
-32687,
-32681,
-32688,
-32674,
-32676,
-32662,
-32661,
-32667,
-32656,
-32654,
-32643,
-32649,
-32647,
-32655,
-32652,
-32661,
-32667,
-32686,
-32684,
-32704,
-32705,
-32725,
-32730,
-32725,
-32729,
-32716,
-32715,
-32710,
-32697,
-32703,
-32707,
-32700,
-32719,
-32694,
-32712,
-32700,
-32707,
-32704,
-32703,
-32696,
-32708,
-32693,
-32706,
-32690,
-32696,
-32689,
-32683,
-32686,
-32682,
-32695,
-32683,
-32692,
-32670,
-32682,
-32667,
-32679,
-32675,
-32682,
-32680,
-32683,
-32673,
-32676,
-32676,
-32686,
-32693,
-32701,
-32693,
-32701,
-32695,
-32711,
-32711,
-32727,
-32718,
-32731,
-32733,
-32746,
-32750,
-32759,
-32756,
-32757,
-32759,
-32748,
-32748,
-32745,
-32733,
-32736,
-32721,
-32728,
-32719,
-32727,
-32709,
-32710,
-32701,
-32705,
-32712,
-32705,
-32714,
-32702,
-32715,
-32719,
-32726,
-32728,
-32731,
-32734,
-32741,
-32747,
-32742,
-32751,
-32743,
-32749,
-32744,
-32747,
-32746,
-32753,
-32757,
-32759,
-32765,
-32763,
-32769,
-32766,
-32766,
-32770,
-32763,
-32770,
-32762,
-32773,
-32771,
-32778,
-32775,
-32782,
-32787,
-32804,
-32805,
-32813,
-32810,
-32816,
-32821,
-32816,
-32809,
-32806,
-32810,
-32817,
-32830,
-32818,
-32833,
-32828,
-32840,
-32843,
-32836,
-32836,
-32835,
-32837,
-32833,
-32830,
-32830,
-32834,
-32846,
-32851,
-32853,
-32855,
-32855,
-32867,
-32867,
-32874,
-32868,
-32863,
-32858,
-32847,
-32832,
-32834,
-32825,
-32846,
-32839,
-32846,
-32836,
-32845,
-32843,
-32852,
-32838,
-32836,
-32838,
-32841,
-32853,
-32833,
-32839,
-32824,
-32835,
-32831,
-32828,
-32824,
-32823,
-32825,
-32826,
-32826,
-32837,
-32830,
-32854,
-32840,
-32853,
-32858,
-32857,
-32874,
-32872,
-32881,
-32883,
-32882,
-32878,
-32876,
-32875,
-32879,
-32881,
-32881,
-32888,
-32888,
-32894,
-32895,
-32897,
-32899,
-32895,
-32893,
-32887,
-32878,
-32885,
-32879,
-32890,
-32889,
-32903,
-32911,
-32920,
-32927,
-32917,
-32912,
-32901,
-32901,
-32887,
-32901,
-32888,
-32896,
-32889,
-32875,
-32875,
-32858,
-32862,
-32845,
-32835,
-32822,
-32818,
-32818,
-32815,
-32807,
-32802,
-32796,
-32806,
-32798,
-32803,
-32800,
-32803,
-32812,
-32813,
-32816,
-32815,
-32817,
-32814,
-32823,
-32820,
-32828,
-32827,
-32837,
-32841,
-32840,
-32854,
-32846,
-32862,
-32848,
-32839,
-32826,
-32816,
-32811,
-32805,
-32795,
-32782,
-32778,
-32776,
-32778,
-32776,
-32781,
-32774,
-32783,
-32773,
-32763,
-32764,
-32758,
-32774,
-32771,
-32779,
-32774,
-32779,
-32778,
-32776,
-32786,
-32777,
-32798,
-32778,
-32794,
-32774,
-32782,
-32780,
-32781,
-32786,
-32785,
-32793,
-32795,
-32794,
-32807,
-32795,
-32821,
-32815,
-32830,
-32824,
-32826,
-32819,
-32828,
-32832,
-32830,
-32838,
-32826,
-32834,
-32828,
-32821,
-32827,
-32812,
-32820,
-32806,
-32798,
-32800,
-32789,
-32801,
-32797,
-32807,
-32801,
-32810,
-32793,
-32807,
-32795,
-32805,
-32804,
-32797,
-32800,
-32791,
-32798,
-32795,
-32796,
-32787,
-32788,
-32785,
-32782,
-32776,
-32764,
-32763,
-32761,
-32763,
-32765,
-32762,
-32757,
-32745,
-32758,
-32749,
-32778,
-32769,
-32774,
-32773,
-32777,
-32798,
-32802,
-32814,
-32808,
-32822,
-32834,
-32847,
-32855,
-32852,
-32854,
-32869,
-32860,
-32873,
-32862,
-32863,
-32863,
-32848,
-32842,
-32829,
-32831,
-32827,
-32828,
-32820,
-32821,
-32818,
-32822,
-32818,
-32815,
-32813,
-32808,
-32803,
-32805,
-32798,
-32808,
-32798,
-32800,
-32787,
-32792,
-32780,
-32788,
-32773,
-32780,
-32771,
-32781,
-32767,
-32777,
-32761,
-32774,
-32764,
-32771,
-32761,
-32770,
-32766,
-32766,
-32767,
-32749,
-32756,
-32752,
-32758,
-32759,
-32758,
-32753,
-32747,
-32738,
-32737,
-32727,
-32735,
-32723,
-32719,
-32721,
-32720,
-32722,
-32717,
-32705,
-32706,
-32711,
-32716,
-32714,
-32706,
-32697,
-32700,
-32695,
-32694,
-32688,
-32684,
-32695,
-32688,
-32685,
-32668,
-32681,
-32674,
-32692,
-32682,
-32682,
-32688,
-32693,
-32704,
-32705,
-32705,
-32712,
-32706,
-32720,
-32699,
-32721,
-32700,
-32726,
-32714,
-32712,
-32713,
-32695,
-32703,
-32689,
-32692,
-32693,
-32696,
-32698,
-32698,
-32692,
-32693,
-32681,
-32683,
-32664,
-32669,
-32656,
-32657,
-32652,
-32651,
-32656,
-32648,
-32655,
-32645,
-32660,
-32657,
-32663,
-32656,
-32655,
-32648,
-32660,
-32637,
-32645,
-32627,
-32633,
-32633,
-32621,
-32614,
-32603,
-32609,
-32606,
-32607,
-32593,
-32598,
-32582,
-32590,
-32569,
-32565,
-32560,
-32556,
-32564,
-32555,
-32565,
-32561,
-32574,
-32578,
-32581,
-32574,
-32572,
-32566,
-32563,
-32566,
-32572,
-32564,
-32575,
-32558,
-32566,
-32564,
-32562,
-32564,
-32564,
-32557,
-32565,
-32549,
-32557,
-32552,
-32551,
-32556,
-32538,
-32556,
-32544,
-32565,
-32556,
-32563,
-32561,
-32564,
-32568,
-32565,
-32564,
-32573,
-32570,
-32593,
-32585,
-32602,
-32592,
-32596,
-32583,
-32585,
-32578,
-32585,
-32577,
-32578,
-32557,
-32568,
-32556,
-32570,
-32569,
-32566,
-32561,
-32556,
-32547,
-32550,
-32551,
-32556,
-32552,
-32555,
-32534,
-32550,
-32531,
-32543,
-32534,
-32535,
-32538,
-32536,
-32529,
-32534,
-32529,
-32539,
-32534,
-32542,
-32533,
-32547,
-32537,
-32551,
-32545,
-32562,
-32562,
-32566,
-32575,
-32567,
-32586,
-32587,
-32594,
-32607,
-32599,
-32610,
-32613,
-32624,
-32633,
-32642,
-32652,
-32642,
-32657,
-32647,
-32645,
-32648,
-32636,
-32641,
-32640,
-32635,
-32633,
-32624,
-32633,
-32627,
-32636,
-32637,
-32634,
-32643,
-32640,
-32644,
-32648,
-32656,
-32661,
-32669,
-32661,
-32665,
-32661,
-32669,
-32669,
-32670,
-32664,
-32664,
-32665,
-32670,
-32667,
-32672,
-32663,
-32667,
-32670,
-32670,
-32672,
-32663,
-32667,
-32673,
-32684,
-32682,
-32678,
-32670,
-32696,
-32723
+static const uint8_t bcfire01_48k_wav_data[26819] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+144,64,62,43,144,24,74,59,78,60,26,177,162,163,32,93,
+61,42,9,24,176,243,164,145,128,129,40,27,24,162,59,145,
+243,179,212,177,3,163,0,74,62,112,17,153,129,160,138,137,
+158,57,25,12,185,141,112,49,137,8,160,154,145,10,78,57,
+13,141,25,24,8,165,5,1,41,85,32,115,103,35,249,255,
+154,8,80,103,129,190,41,52,185,43,38,217,139,50,2,186,
+154,66,146,171,66,184,121,22,185,42,163,174,65,162,172,66,
+145,154,50,144,138,17,185,156,66,131,154,98,146,188,41,3,
+189,72,20,201,155,8,50,21,153,64,21,218,172,32,52,129,
+188,9,34,201,173,82,20,160,155,24,136,138,82,19,136,153,
+203,156,24,51,35,8,33,232,190,40,19,0,33,146,189,41,
+146,191,41,55,1,137,136,168,137,0,170,41,38,217,139,83,
+130,188,26,85,19,202,171,8,128,137,49,37,160,203,32,20,
+185,155,152,26,87,146,203,26,67,130,171,114,35,169,202,172,
+40,146,190,56,21,128,136,0,84,130,205,9,51,160,171,154,
+137,97,53,129,187,41,54,177,191,26,33,128,136,136,33,19,
+8,49,130,188,153,152,0,250,174,32,1,80,55,144,172,9,
+16,152,187,57,23,201,139,82,20,145,170,65,4,188,27,1,
+189,57,71,18,201,187,56,39,160,188,26,85,2,169,170,154,
+25,18,1,49,34,33,130,239,9,51,177,206,138,81,3,235,
+138,83,20,176,172,40,36,145,187,170,185,25,68,1,137,48,
+70,19,202,172,154,8,18,136,0,49,87,19,218,172,10,33,
+2,169,113,53,162,207,155,48,35,136,16,19,252,139,66,2,
+8,144,219,9,1,40,38,249,154,51,130,185,187,81,4,203,
+26,68,129,188,41,21,218,9,36,184,138,35,136,136,202,58,
+55,217,26,51,184,154,186,80,21,185,170,10,86,145,139,52,
+234,10,67,160,138,8,0,2,152,25,128,137,152,56,4,174,
+117,162,173,64,160,25,19,203,98,176,12,20,169,48,208,12,
+37,169,9,185,88,6,203,72,2,172,48,130,170,9,0,1,
+160,187,115,163,175,82,146,155,16,153,49,193,13,51,201,10,
+17,49,241,141,68,184,12,36,169,10,17,0,161,141,82,177,
+157,81,130,235,57,37,217,138,35,129,169,154,99,161,157,67,
+160,171,49,19,201,156,69,160,157,66,145,171,72,19,233,10,
+52,160,157,49,3,204,41,36,200,11,66,145,172,64,3,203,
+41,36,185,155,67,131,189,56,22,185,10,34,145,154,48,208,
+172,99,145,172,48,4,202,26,53,192,157,65,131,218,9,67,
+160,172,49,35,217,155,81,2,186,40,162,157,115,161,173,65,
+130,186,25,52,161,173,72,20,186,139,83,145,187,64,3,203,
+72,4,203,41,36,185,155,40,50,152,26,161,159,116,145,157,
+32,34,169,173,57,37,144,171,137,67,20,168,203,11,99,131,
+203,170,49,53,184,189,40,52,160,153,144,138,115,146,172,56,
+2,187,57,55,200,155,68,144,154,51,161,174,41,51,144,154,
+168,172,114,22,168,172,25,35,1,17,249,171,98,19,185,154,
+16,168,40,54,176,158,32,18,153,56,52,217,172,9,18,66,
+35,232,205,40,68,1,185,171,154,65,53,146,204,137,17,128,
+33,19,218,156,24,17,16,82,129,219,171,32,68,18,169,155,
+49,38,200,174,48,53,129,251,187,9,67,67,2,219,187,9,
+67,51,34,192,206,138,24,33,69,2,202,171,153,8,83,67,
+17,185,220,171,24,52,67,35,249,172,137,16,67,36,144,186,
+188,154,32,99,36,129,186,204,154,40,34,68,19,201,171,188,
+139,49,85,67,129,154,185,174,10,17,66,53,130,169,202,188,
+10,64,68,35,168,186,204,171,16,83,68,2,153,186,190,137,
+34,51,54,129,169,234,187,8,18,83,52,129,169,204,188,136,
+17,82,52,128,153,169,188,40,52,128,170,154,154,81,71,1,
+153,136,217,156,8,0,65,52,51,160,189,172,187,139,65,52,
+52,19,160,219,188,189,137,49,50,52,52,0,186,153,169,205,
+172,137,64,68,35,35,1,170,169,204,204,171,56,70,35,1,
+0,153,220,203,137,128,16,84,51,1,136,185,221,171,137,136,
+49,70,34,50,2,218,203,187,172,9,99,51,17,49,2,217,
+204,187,156,24,50,50,52,17,49,209,191,137,152,137,32,50,
+21,33,53,193,156,24,128,0,184,157,144,220,170,32,100,130,
+171,41,19,218,188,137,66,67,67,18,152,203,153,0,16,50,
+168,56,21,234,9,52,168,157,33,232,173,136,185,88,55,18,
+128,201,174,9,128,153,0,129,136,97,54,35,0,145,235,154,
+24,32,2,185,139,169,27,87,35,35,184,191,204,170,170,8,
+50,36,16,85,36,18,136,170,170,218,205,170,152,24,67,50,
+84,19,152,25,51,2,168,186,235,204,187,188,155,81,35,0,
+99,20,201,171,25,36,129,138,128,219,154,153,154,50,85,52,
+145,171,50,129,80,38,1,16,161,191,155,153,187,97,36,144,
+8,65,35,130,235,154,153,207,156,0,0,17,17,65,51,67,
+51,145,170,204,156,24,2,168,206,138,34,17,99,37,34,0,
+128,144,201,205,172,154,81,19,201,156,136,186,138,17,100,36,
+17,66,18,17,146,221,187,188,186,170,40,51,1,114,52,18,
+145,153,115,23,129,137,169,204,188,155,9,8,33,34,83,51,
+67,34,0,144,188,156,16,66,20,236,172,136,8,16,144,138,
+50,162,205,41,71,19,1,50,36,184,205,171,24,19,185,10,
+2,253,171,170,153,66,54,36,17,16,144,203,25,35,128,72,
+52,177,206,203,171,154,40,101,34,1,17,160,188,171,137,185,
+204,137,50,52,129,65,54,50,83,35,16,17,144,16,18,236,
+205,171,170,219,186,153,32,69,35,50,2,186,171,24,102,52,
+35,0,153,235,188,171,169,155,16,3,217,187,8,184,142,100,
+34,49,71,18,0,128,137,24,34,168,189,186,223,171,153,169,
+40,145,138,70,129,138,17,99,53,129,24,128,153,184,220,154,
+187,11,51,17,99,34,33,192,189,32,144,138,100,36,185,190,
+138,9,32,17,65,3,202,171,136,64,53,18,50,19,250,206,
+154,17,17,100,19,185,172,170,186,9,18,169,88,70,130,169,
+153,64,54,2,8,50,160,174,138,98,3,203,155,169,187,202,
+189,10,50,2,64,52,145,172,16,145,220,10,115,37,2,160,
+153,128,205,139,66,51,35,201,155,128,204,187,57,119,1,170,
+8,17,136,169,40,38,161,188,172,137,0,8,66,53,18,17,
+129,218,154,8,8,83,18,34,216,174,171,155,113,51,168,190,
+171,16,34,128,32,83,146,189,58,55,2,136,24,18,233,139,
+67,19,201,221,187,136,16,49,66,84,19,186,173,155,41,52,
+17,99,146,204,137,8,8,0,40,52,176,190,156,81,19,170,
+24,161,58,87,176,156,98,35,128,9,1,144,218,172,138,50,
+37,160,189,170,188,138,34,0,98,18,168,170,16,33,101,19,
+186,57,39,168,171,154,138,98,19,201,40,39,128,128,169,48,
+22,152,25,17,114,19,202,9,145,172,82,130,206,171,153,0,
+8,1,145,185,155,82,210,207,56,53,17,136,24,17,176,187,
+185,173,66,19,32,193,191,65,4,169,137,40,54,200,140,33,
+18,1,17,2,203,42,21,250,204,10,83,130,186,136,169,56,
+37,0,168,139,84,18,48,193,223,25,35,128,128,153,32,33,
+97,36,217,140,50,18,8,185,203,235,172,81,20,136,136,153,
+138,50,5,218,156,32,3,201,187,153,139,115,3,9,69,176,
+172,128,128,50,129,171,154,114,21,185,155,152,9,69,145,171,
+56,54,208,174,25,18,128,24,84,35,168,172,137,0,40,69,
+18,153,219,172,9,1,32,51,252,142,49,131,188,24,146,138,
+114,19,0,152,204,154,24,50,20,1,249,189,25,35,136,17,
+18,83,161,189,9,66,50,128,64,131,191,72,3,235,138,50,
+146,172,114,146,205,25,1,136,9,51,192,157,82,146,172,65,
+2,186,64,4,218,25,20,233,138,67,129,187,32,20,187,42,
+22,202,26,37,176,139,67,162,188,65,4,170,56,5,251,10,
+51,161,155,82,130,173,41,1,137,115,19,217,138,17,168,11,
+52,176,11,52,192,156,83,130,220,10,34,160,155,52,208,155,
+115,130,203,40,37,160,139,50,176,173,64,4,185,25,35,251,
+11,115,130,203,25,35,184,11,52,146,190,41,37,160,172,16,
+19,168,171,116,130,251,137,33,1,137,49,162,221,9,51,146,
+203,41,37,168,140,34,160,172,40,50,34,176,175,8,145,170,
+97,20,184,173,40,52,2,186,172,81,35,136,81,131,220,154,
+0,32,69,129,172,9,17,16,33,184,207,155,56,53,35,152,
+153,184,189,10,69,129,139,84,161,157,33,192,140,49,19,18,
+128,186,221,10,51,2,17,184,141,67,160,56,6,236,139,49,
+131,186,96,3,186,171,188,57,55,144,171,153,40,131,239,25,
+69,129,170,32,2,251,154,32,68,130,185,137,168,170,170,41,
+119,20,185,173,40,18,136,40,34,34,160,189,26,17,49,130,
+187,41,177,158,17,160,168,223,10,69,145,170,49,21,168,251,
+188,41,53,19,168,190,24,51,184,27,67,129,218,204,9,67,
+51,145,221,154,34,0,0,50,36,200,155,17,185,41,209,159,
+81,18,1,184,188,8,1,136,187,112,21,184,138,18,128,65,
+131,171,114,2,137,34,217,155,152,173,97,51,17,128,184,174,
+56,132,223,26,53,130,170,9,168,56,87,161,170,33,144,138,
+129,187,97,3,236,155,48,51,33,20,250,155,33,145,137,18,
+0,49,131,221,25,54,146,154,136,153,185,205,139,33,49,68,
+51,249,174,48,20,186,25,160,156,66,145,137,33,36,218,26,
+22,218,42,36,235,155,33,36,129,136,153,172,49,146,156,68,
+144,25,35,185,26,67,85,145,191,155,33,18,153,65,22,184,
+41,20,202,171,154,56,87,145,137,99,130,152,137,170,154,136,
+136,17,51,177,14,85,162,174,48,19,203,155,34,19,169,64,
+131,203,88,3,204,154,176,155,118,130,251,9,51,162,187,32,
+146,138,168,173,80,131,139,101,146,219,137,1,128,136,137,96,
+20,217,139,50,160,156,48,18,16,160,189,97,3,153,32,192,
+188,24,18,129,137,201,174,114,131,191,40,20,153,48,161,172,
+136,128,81,53,130,218,187,10,33,67,129,154,154,33,55,3,
+203,139,128,203,26,50,33,19,56,119,23,152,9,168,187,24,
+19,152,33,146,158,115,23,201,26,34,185,27,19,235,41,36,
+136,80,2,204,10,33,184,187,16,168,41,55,129,170,187,139,
+2,40,119,146,173,25,128,40,84,2,218,139,82,145,173,32,
+130,154,40,1,137,32,129,251,175,65,35,202,64,20,185,139,
+128,8,66,35,232,189,64,20,153,16,129,187,8,186,72,4,
+186,49,160,121,23,184,58,20,235,138,17,153,137,50,161,191,
+88,20,186,57,130,172,16,234,11,68,2,0,186,57,23,184,
+40,131,206,138,24,48,67,2,234,156,82,19,219,9,35,184,
+27,34,201,138,67,19,184,58,119,145,171,153,153,24,50,1,
+219,10,54,224,156,98,3,187,10,34,144,137,0,34,2,144,
+236,139,115,130,154,32,130,203,170,8,69,130,203,40,3,9,
+66,34,68,194,207,41,51,1,0,168,206,138,66,19,153,8,
+192,172,16,2,9,70,146,191,26,53,129,169,24,145,204,138,
+83,35,128,169,188,171,98,20,144,24,18,251,159,33,2,137,
+16,161,154,50,145,11,84,129,203,187,172,24,82,51,184,171,
+0,202,96,132,204,25,2,218,138,83,18,168,8,2,218,138,
+34,129,219,138,40,83,19,153,128,202,88,133,239,138,50,2,
+152,32,3,219,139,66,20,128,33,162,239,138,16,16,67,130,
+186,155,66,5,234,139,66,146,186,40,38,130,136,170,10,34,
+200,140,98,130,202,24,20,168,10,129,172,32,249,158,81,36,
+176,10,17,168,138,0,137,1,136,114,22,168,9,51,161,239,
+137,1,136,64,37,176,187,16,160,172,115,20,168,138,49,147,
+190,10,0,25,100,34,8,202,187,170,156,115,36,184,171,153,
+154,41,53,17,49,38,176,173,9,17,160,172,80,18,9,52,
+248,174,25,51,17,33,2,216,220,155,33,17,24,51,19,128,
+219,10,36,2,2,250,190,153,32,52,19,136,8,19,252,158,
+32,18,1,169,155,152,138,114,1,138,65,52,2,204,10,129,
+220,155,8,0,49,71,129,203,9,1,136,24,83,130,205,25,
+4,170,56,21,168,138,99,19,202,40,19,251,156,8,2,136,
+65,19,171,40,2,234,204,10,35,184,113,38,144,153,185,186,
+9,83,131,220,57,55,161,204,9,0,0,0,136,33,18,152,
+8,50,5,252,155,33,2,24,69,3,251,154,8,8,66,130,
+203,154,49,18,9,86,146,172,32,19,153,139,100,4,202,138,
+1,8,34,201,11,68,131,204,26,69,129,186,155,24,16,16,
+36,160,40,71,1,186,25,20,218,156,169,154,83,53,18,251,
+155,49,2,128,128,154,218,172,98,19,185,40,19,168,187,41,
+53,146,222,171,24,35,177,206,42,71,1,187,154,33,1,202,
+138,152,72,71,1,153,24,32,200,175,24,18,152,0,202,140,
+82,37,184,172,49,2,202,10,52,162,171,82,161,188,24,18,
+35,184,173,137,8,19,252,158,48,36,128,137,1,202,26,70,
+130,205,11,67,18,152,170,10,68,145,187,8,49,36,250,155,
+98,35,160,188,138,16,33,68,161,173,56,19,152,153,81,37,
+185,174,138,137,98,3,218,11,68,129,170,49,1,218,172,8,
+130,24,70,2,153,16,16,136,152,220,155,48,131,206,10,83,
+18,33,21,217,171,24,0,0,8,144,190,120,39,152,155,49,
+3,201,138,17,152,24,162,207,137,66,34,168,25,3,191,42,
+21,144,138,17,216,171,101,3,185,25,35,251,156,67,131,171,
+24,184,171,115,18,185,27,69,161,188,24,35,129,185,186,154,
+115,3,201,138,1,152,169,24,160,156,84,224,189,64,3,235,
+26,37,161,170,32,34,152,25,20,236,26,38,144,171,137,32,
+18,251,11,67,130,169,10,33,129,136,17,250,190,40,55,129,
+137,33,0,202,172,24,200,156,99,146,153,40,67,19,219,26,
+18,219,203,138,97,20,168,170,32,55,129,170,48,51,201,190,
+154,136,9,66,130,137,85,36,216,189,48,52,184,173,24,51,
+128,137,8,24,82,18,234,154,50,161,172,136,185,57,37,128,
+115,37,160,189,26,50,176,203,154,16,18,114,55,161,171,65,
+146,235,155,24,52,168,172,25,49,69,131,186,171,41,68,177,
+174,32,1,128,144,187,104,53,145,219,24,67,160,189,25,67,
+3,201,188,154,48,71,146,203,57,20,152,137,169,40,37,168,
+153,170,72,37,168,171,10,100,162,172,64,35,129,220,172,16,
+18,17,144,48,132,204,64,130,203,25,83,2,202,139,0,65,
+21,185,10,130,206,25,51,145,170,154,17,217,156,81,3,170,
+9,50,68,177,189,97,131,221,154,0,32,52,34,201,190,24,
+20,160,170,138,115,129,154,17,161,138,0,65,5,185,104,20,
+152,25,36,161,188,171,10,83,177,190,138,33,68,35,18,168,
+190,138,16,144,202,42,71,18,128,204,41,20,204,27,67,35,
+146,207,137,1,136,65,2,24,37,185,189,152,16,35,200,174,
+8,34,53,36,152,203,25,34,233,171,66,19,185,172,8,34,
+161,138,114,19,200,26,69,1,128,201,156,32,146,189,138,100,
+35,201,11,67,3,152,189,9,35,168,190,139,99,35,1,216,
+204,40,36,18,169,154,34,216,173,32,51,160,172,66,146,26,
+18,154,66,161,64,148,223,137,16,51,161,188,185,140,115,4,
+8,0,185,25,3,204,10,1,137,98,130,187,73,54,176,206,
+25,34,184,156,65,161,174,32,131,154,67,161,187,25,84,20,
+218,156,48,2,152,32,19,170,24,250,140,51,131,169,186,138,
+240,190,72,36,1,49,216,189,25,69,2,186,154,0,33,53,
+18,168,204,154,8,136,97,52,232,189,24,36,1,153,8,50,
+192,189,11,115,20,160,156,16,1,144,202,138,32,1,16,52,
+68,3,251,172,8,1,17,1,153,170,32,147,223,48,21,152,
+17,168,156,128,9,68,18,168,221,139,65,34,130,201,138,128,
+137,86,147,206,10,50,50,1,219,155,32,2,169,187,41,69,
+18,168,204,9,37,145,41,2,153,152,255,26,35,18,2,251,
+11,51,232,155,64,35,160,186,170,56,119,1,169,32,1,219,
+8,1,153,136,251,26,52,130,82,3,204,171,25,52,162,174,
+24,34,18,128,24,34,136,160,207,56,38,168,171,154,56,37,
+129,8,49,55,162,255,9,49,129,169,153,40,84,18,170,9,
+18,218,9,35,1,168,204,155,144,154,100,51,51,200,156,17,
+220,10,35,185,172,25,102,3,202,25,51,217,172,32,50,18,
+160,221,154,16,17,169,154,65,53,52,168,157,49,3,219,205,
+154,50,34,33,19,187,56,36,128,250,173,56,37,201,188,9,
+98,51,160,154,9,99,131,206,11,67,2,136,170,154,154,32,
+53,17,0,0,136,138,48,146,156,101,145,204,186,188,27,71,
+35,160,219,138,51,177,158,83,130,187,138,1,128,48,71,129,
+171,64,19,218,173,32,37,160,172,153,152,65,52,161,187,88,
+35,251,139,68,130,170,41,145,187,11,66,34,17,49,52,200,
+191,153,8,17,144,202,10,83,131,204,88,20,220,155,115,18,
+185,154,16,17,17,160,187,155,16,18,202,26,85,18,0,0,
+185,189,104,36,250,156,48,19,169,26,52,161,187,8,192,173,
+98,52,160,189,137,35,2,137,152,171,25,85,35,200,155,169,
+172,115,5,202,138,16,18,144,9,52,2,137,98,2,236,11,
+99,2,203,137,0,136,16,192,174,72,53,145,172,41,35,201,
+154,33,144,9,53,19,201,188,72,54,129,170,136,169,0,200,
+156,136,203,9,100,67,160,189,24,36,129,187,72,37,200,187,
+138,152,40,71,19,185,11,17,144,219,155,115,4,185,172,0,
+33,18,152,187,89,55,145,172,16,130,203,48,38,200,188,32,
+53,128,187,171,56,69,18,128,202,155,50,35,201,205,138,16,
+115,38,184,172,32,19,144,172,41,35,152,136,234,171,49,69,
+18,185,140,115,34,184,189,138,65,19,201,172,56,20,144,10,
+33,161,189,41,38,160,156,41,84,162,189,25,34,8,33,177,
+157,48,51,146,187,41,232,157,98,130,220,155,48,36,129,137,
+0,16,128,16,130,172,113,37,168,171,185,171,64,54,128,153,
+152,187,112,3,220,25,19,202,138,66,146,204,88,53,129,154,
+137,0,160,10,53,130,170,237,171,49,20,50,18,137,2,254,
+157,32,18,0,136,48,52,201,156,34,144,172,170,10,51,3,
+81,85,18,176,189,25,35,176,205,171,8,66,51,232,156,81,
+20,152,136,170,10,68,130,219,172,26,83,19,144,203,155,48,
+51,2,137,24,18,249,12,84,178,223,8,34,0,136,17,17,
+144,187,137,82,35,200,204,154,32,130,185,72,55,130,154,97,
+20,152,169,206,138,50,2,128,202,139,50,34,54,248,158,65,
+35,200,172,10,83,3,168,153,137,153,25,68,36,184,190,10,
+67,19,168,172,10,67,2,234,170,24,33,17,65,35,249,189,
+24,50,17,136,136,49,39,176,175,8,16,49,20,201,203,154,
+50,20,168,154,186,40,53,129,154,48,36,234,139,18,144,187,
+73,87,129,136,136,9,49,2,200,255,139,49,1,40,34,185,
+136,201,41,71,145,170,9,98,161,206,42,53,3,186,189,57,
+70,1,169,172,25,83,129,169,154,153,16,66,67,144,219,172,
+56,39,145,138,0,144,9,2,169,155,128,136,16,98,87,3,
+217,187,24,67,131,153,154,205,155,16,17,32,84,18,185,173,
+64,53,145,219,188,10,69,3,144,202,156,49,20,17,1,203,
+139,169,25,70,129,188,10,83,129,202,9,128,152,9,50,19,
+129,16,0,137,72,103,130,188,10,19,185,188,203,56,103,146,
+204,138,67,3,153,136,201,171,96,51,176,188,155,138,100,52,
+144,155,137,202,155,17,66,68,131,152,129,250,138,34,34,19,
+249,171,137,0,8,152,152,155,112,36,1,52,178,255,137,49,
+51,160,203,170,25,70,18,170,170,170,137,168,73,103,129,186,
+10,50,19,235,138,18,168,152,128,82,3,205,10,33,66,34,
+129,186,72,38,216,173,137,32,51,2,136,153,48,3,218,205,
+12,100,3,136,144,220,138,24,65,19,235,26,67,129,0,144,
+202,137,83,20,168,170,153,186,155,82,69,130,185,188,187,120,
+38,145,170,136,153,25,51,2,218,156,50,37,35,161,175,154,
+136,33,67,130,221,171,40,17,50,147,222,26,83,2,152,153,
+137,82,146,205,25,36,144,187,172,16,68,67,161,191,25,51,
+1,128,144,186,155,66,3,236,187,138,50,68,36,161,221,10,
+66,129,170,66,19,235,154,0,169,56,55,2,170,171,137,16,
+1,66,177,175,48,69,2,200,189,138,33,67,3,186,56,55,
+161,190,25,18,153,56,54,130,217,155,24,144,136,33,17,98,
+18,236,155,33,36,129,203,41,37,168,139,176,190,57,39,129,
+172,56,38,129,154,187,187,104,54,146,189,9,33,50,145,174,
+138,169,9,69,19,128,185,25,69,18,185,205,171,32,132,203,
+72,36,201,155,32,50,67,18,233,156,32,18,153,137,168,139,
+49,2,82,193,239,25,68,34,152,171,154,8,84,3,204,155,
+136,16,36,129,1,217,172,65,19,152,25,129,221,26,54,130,
+171,136,200,171,88,53,130,186,153,186,156,98,36,160,203,137,
+66,52,2,218,172,138,33,18,24,84,19,250,203,25,66,3,
+169,138,1,169,139,49,160,24,161,223,24,36,129,8,98,20,
+201,139,17,1,129,219,138,65,83,2,203,154,236,154,16,16,
+71,145,187,16,18,34,216,156,0,169,56,19,128,128,114,54,
+176,156,17,16,17,233,138,1,153,16,200,173,170,26,85,66,
+67,161,174,40,18,16,128,186,205,188,24,54,1,169,153,8,
+17,48,87,130,202,171,41,52,2,137,185,189,169,202,80,39,
+129,169,154,65,19,152,0,154,48,178,142,177,223,41,2,138,
+68,35,152,170,8,217,172,24,50,71,146,205,155,16,83,18,
+168,187,172,40,69,35,144,219,188,25,83,35,129,187,171,136,
+17,160,175,49,38,1,184,190,32,21,144,170,154,48,53,18,
+200,206,138,33,19,136,16,129,153,24,144,205,155,80,54,130,
+219,138,50,2,201,187,58,70,2,153,138,65,2,186,9,17,
+1,233,189,154,65,18,234,154,82,35,17,168,220,154,32,35,
+69,19,152,203,138,67,208,174,8,128,32,176,175,80,52,1,
+152,205,10,83,3,153,138,185,171,48,184,157,68,35,17,144,
+9,51,217,172,137,88,37,176,156,0,169,153,152,115,4,169,
+187,156,64,35,84,19,219,139,18,34,34,185,172,136,235,140,
+99,35,8,17,250,157,137,66,52,144,138,1,202,171,24,66,
+3,235,9,34,53,132,188,11,152,26,70,34,34,232,173,25,
+16,50,3,219,170,24,99,146,187,138,136,64,69,2,152,153,
+201,206,138,16,34,68,129,170,9,17,128,169,10,53,19,33,
+200,174,153,235,172,9,51,19,49,130,221,25,36,161,188,112,
+38,201,156,136,17,36,144,154,16,128,136,65,21,251,155,33,
+19,2,128,186,207,138,34,35,130,203,25,19,169,25,66,54,
+192,190,25,67,18,184,205,25,35,200,171,65,70,18,185,174,
+138,48,35,129,185,154,17,144,155,153,112,53,144,186,154,116,
+20,235,171,8,83,19,128,170,170,153,137,97,52,128,201,171,
+32,18,137,0,235,187,41,86,3,153,33,146,206,170,154,56,
+71,160,155,65,131,203,171,41,87,2,128,168,170,32,160,156,
+17,67,36,200,26,37,129,234,189,9,67,51,19,186,203,170,
+80,20,202,154,49,36,184,174,138,99,36,176,156,49,19,128,
+152,171,65,224,173,32,128,40,51,128,51,248,175,40,34,18,
+136,32,147,239,10,33,152,137,16,1,33,50,53,129,236,171,
+137,8,113,38,168,172,136,1,1,0,128,8,68,130,187,41,
+70,145,222,155,64,51,2,202,155,33,144,154,32,35,51,129,
+137,201,191,153,185,171,72,103,19,201,10,144,153,50,216,140,
+99,67,2,201,189,155,33,20,144,32,20,168,204,155,66,19,
+136,136,186,64,53,35,232,205,153,8,81,67,144,187,170,153,
+40,34,49,19,251,72,23,201,157,32,50,17,152,128,168,171,
+186,205,24,36,67,51,200,155,152,235,203,138,100,67,1,202,
+188,9,67,3,202,138,50,34,160,204,57,20,220,9,68,17,
+144,170,137,185,174,40,69,18,184,187,153,136,32,34,17,129,
+24,66,50,87,177,207,25,19,128,169,172,64,131,171,82,18,
+49,3,138,67,251,157,0,8,16,218,41,35,152,8,251,10,
+18,136,115,37,128,219,187,9,52,18,144,33,145,191,57,71,
+129,203,138,49,3,235,155,98,4,184,171,8,17,51,130,152,
+144,235,154,66,37,145,220,25,83,145,203,9,66,18,184,172,
+65,3,185,187,25,3,237,9,69,2,152,170,137,8,153,97,
+69,3,204,172,33,35,168,173,41,67,144,203,25,54,35,169,
+172,8,145,137,116,4,184,187,171,48,38,161,155,32,168,188,
+155,116,36,201,138,33,33,18,200,155,0,218,156,64,20,200,
+138,83,36,160,173,25,34,129,169,41,52,129,216,191,40,4,
+202,138,50,18,152,57,87,130,219,187,25,84,3,169,138,136,
+154,32,51,37,216,172,16,2,1,249,140,82,2,153,153,24,
+35,130,128,251,173,25,99,34,144,218,172,48,20,186,138,34,
+53,146,172,32,192,139,34,128,99,146,204,138,81,21,184,170,
+136,154,40,68,35,144,137,251,156,65,20,128,0,0,234,188,
+24,35,160,10,67,146,155,17,234,57,55,152,154,17,50,161,
+222,154,0,8,33,184,27,87,17,16,160,206,170,64,68,146,
+187,9,161,188,64,54,144,172,9,129,17,68,128,170,24,1,
+169,203,57,103,1,187,203,171,82,51,17,0,219,154,136,32,
+4,220,72,36,168,8,0,137,0,217,155,97,53,161,206,10,
+33,34,129,219,138,33,50,130,172,56,162,175,48,19,234,156,
+65,130,187,26,52,145,156,32,18,65,21,252,139,65,51,130,
+219,154,34,1,186,171,138,16,17,144,48,100,36,162,204,202,
+173,96,36,152,0,201,157,32,36,34,145,204,170,136,17,17,
+32,1,187,112,53,161,204,138,33,160,204,10,35,177,13,101,
+130,170,154,136,136,32,84,50,17,160,237,155,32,51,129,8,
+83,35,217,205,154,32,69,129,170,9,17,66,178,207,41,18,
+128,16,185,27,52,184,189,138,64,51,200,156,114,20,160,170,
+204,138,98,51,2,185,188,155,64,36,18,152,206,138,33,33,
+1,186,74,23,217,171,32,68,1,8,17,234,11,34,168,137,
+152,9,19,172,114,37,160,203,138,83,35,17,176,205,153,169,
+137,33,52,130,218,171,137,114,53,130,235,155,33,18,66,4,
+234,138,144,137,49,18,153,152,170,219,172,114,36,129,168,9,
+33,234,27,51,184,9,208,174,9,98,67,145,172,9,17,144,
+187,41,50,129,50,37,184,190,138,51,18,144,252,26,71,1,
+202,138,33,145,188,25,51,66,51,249,173,8,49,35,128,24,
+1,152,186,26,69,19,160,221,172,24,83,36,2,218,188,138,
+65,51,2,8,128,169,219,191,42,54,2,168,189,26,53,3,
+136,170,25,53,176,156,128,187,26,129,170,8,116,38,136,153,
+252,171,99,34,0,152,171,40,145,155,98,35,144,9,192,239,
+41,50,168,138,16,18,152,11,50,144,56,37,145,222,156,24,
+36,2,202,188,203,9,52,50,99,19,202,187,204,154,48,86,
+35,200,173,8,0,16,34,34,216,187,49,130,40,5,221,139,
+168,25,53,130,16,161,207,9,66,18,136,25,130,186,170,251,
+155,33,35,52,1,219,155,100,2,186,8,184,28,86,34,152,
+171,186,204,10,50,17,84,129,171,50,2,56,5,238,138,49,
+67,2,217,171,32,35,1,218,172,137,9,66,130,25,71,129,
+202,138,16,51,36,50,160,239,155,33,51,50,178,223,9,33,
+1,0,128,137,0,128,219,10,83,2,154,136,203,10,67,128,
+97,20,185,40,225,189,32,19,33,224,173,64,36,0,152,188,
+137,0,16,34,82,37,250,155,49,20,144,202,170,138,66,36,
+160,171,82,35,217,171,48,54,145,170,49,129,155,250,191,8,
+34,18,17,128,0,176,173,40,145,219,80,54,130,202,172,136,
+152,187,8,33,70,146,174,65,20,144,187,188,24,82,83,35,
+144,204,187,154,40,69,51,144,187,188,137,17,3,202,72,54,
+2,184,189,138,1,0,136,64,70,176,156,0,153,48,192,141,
+83,1,32,22,168,172,154,64,36,176,10,35,251,156,0,136,
+16,128,40,70,35,160,206,171,16,18,33,50,18,235,187,138,
+80,69,130,202,187,137,66,67,19,217,155,50,130,169,170,116,
+23,168,171,170,24,50,51,131,203,9,145,203,237,171,66,35,
+33,161,188,9,32,103,146,204,9,17,144,8,49,162,191,26,
+83,52,177,206,9,35,2,136,152,185,157,49,2,10,36,250,
+156,16,1,17,18,52,2,219,173,11,115,19,152,185,187,8,
+49,100,19,251,156,16,18,35,18,169,152,218,173,32,50,17,
+83,145,188,9,184,188,9,32,18,49,87,52,130,218,188,25,
+18,8,50,51,37,193,174,48,130,204,154,24,66,2,16,53,
+131,236,187,136,0,98,36,160,154,50,129,237,187,24,1,17,
+51,51,52,2,235,204,171,137,82,68,1,8,136,219,155,136,
+65,38,177,188,24,19,160,204,137,33,18,184,138,99,52,52,
+161,205,171,186,25,35,0,32,1,114,21,200,155,8,8,16,
+136,113,38,176,188,153,152,136,186,137,18,100,51,201,139,99,
+51,145,207,172,64,36,18,184,219,138,136,16,1,152,65,51,
+34,176,239,137,50,52,160,173,8,128,32,35,17,145,238,138,
+50,51,130,222,155,17,17,16,8,34,35,50,145,253,171,24,
+18,16,0,235,41,37,0,19,252,157,66,18,16,168,173,40,
+36,18,129,219,156,34,130,170,49,147,191,10,33,66,35,17,
+1,202,139,130,251,139,1,144,153,219,171,112,55,146,204,171,
+137,65,53,2,152,185,204,154,65,36,144,9,53,177,156,33,
+129,186,205,57,71,160,172,136,8,98,36,200,172,10,33,18,
+136,153,8,16,65,36,200,174,9,34,128,40,21,251,138,33,
+17,49,18,201,190,40,54,129,170,186,190,154,49,69,2,169,
+136,128,170,187,155,84,51,18,168,172,32,53,161,189,136,250,
+188,48,53,17,8,128,221,139,52,130,24,36,168,137,201,174,
+24,128,138,99,36,128,169,219,25,53,146,172,153,137,66,37,
+34,144,190,137,8,64,19,185,40,35,152,252,155,33,19,34,
+145,173,65,131,206,138,50,66,34,233,188,41,51,201,155,49,
+1,32,161,191,73,53,130,203,26,51,129,8,34,3,251,174,
+137,49,54,129,152,152,9,85,161,190,154,0,83,52,129,219,
+187,25,67,50,19,218,173,25,83,35,217,188,10,49,50,129,
+10,100,130,186,154,169,96,19,187,98,178,174,16,128,49,178,
+207,24,0,48,52,33,129,207,155,48,51,2,186,9,169,138,
+50,85,177,239,9,18,34,34,160,138,130,223,10,67,18,34,
+146,188,139,0,152,8,99,36,201,189,139,16,34,49,52,131,
+203,9,200,175,57,53,130,203,10,36,128,137,253,155,34,144,
+25,3,56,71,161,173,154,0,68,35,128,185,187,172,138,115,
+51,161,205,155,24,16,82,36,161,154,65,161,221,154,48,52,
+160,25,18,217,170,169,9,0,202,10,115,55,145,185,169,235,
+138,65,51,83,2,234,154,136,32,52,128,186,206,10,67,129,
+33,160,156,33,160,154,251,13,68,129,9,18,144,187,171,170,
+16,1,171,72,69,85,35,217,203,154,40,34,99,36,168,155,
+144,202,9,33,34,161,206,138,18,168,72,54,184,172,10,81,
+35,0,17,235,138,128,138,130,220,88,35,153,24,129,68,177,
+174,153,205,25,70,18,152,138,17,185,41,34,168,24,35,217,
+190,155,153,171,65,36,34,36,216,173,56,51,18,176,157,98,
+146,188,82,163,191,9,129,16,52,2,16,168,205,154,9,65,
+37,34,168,156,49,146,188,154,49,54,176,191,138,50,3,235,
+10,0,153,114,39,152,170,32,144,8,18,234,155,33,34,160,
+206,25,50,128,114,35,233,203,137,33,67,18,136,155,80,20,
+201,187,8,33,128,169,57,71,145,204,138,17,33,1,153,98,
+20,9,16,217,139,0,153,49,83,53,193,190,170,10,68,20,
+128,217,188,48,52,0,49,3,218,171,40,20,144,187,24,53,
+162,221,10,18,152,169,170,114,23,144,33,130,137,18,220,138,
+0,24,18,185,114,133,251,155,41,52,4,144,186,138,16,16,
+84,130,186,186,189,72,53,34,145,222,138,0,0,17,129,169,
+171,138,64,52,162,189,97,21,160,187,154,33,35,144,152,202,
+41,119,161,205,10,50,19,169,24,2,168,8,219,42,38,160,
+24,3,170,9,144,202,223,155,66,162,174,25,1,16,18,169,
+113,53,0,128,203,156,9,66,35,216,188,187,154,49,54,145,
+206,137,69,18,136,152,218,154,32,50,53,145,170,152,153,16,
+168,138,249,158,82,130,202,154,64,36,160,48,5,251,138,65,
+18,0,185,203,25,34,144,136,217,155,81,19,152,172,113,39,
+152,153,186,139,114,18,0,16,144,220,155,48,34,32,19,217,
+172,9,17,176,158,114,19,137,32,177,173,24,0,82,36,169,
+187,172,24,129,219,24,2,16,53,130,188,56,54,1,152,202,
+156,65,36,17,34,184,205,235,154,32,145,139,68,145,155,65,
+146,187,114,21,169,41,36,217,10,51,1,32,177,206,9,16,
+160,187,171,219,26,69,67,18,202,10,145,140,102,2,187,153,
+8,49,19,218,188,154,0,0,52,145,64,54,144,186,173,32,
+146,10,71,146,136,0,9,19,185,64,209,190,137,16,53,177,
+156,50,249,140,33,145,41,69,18,136,185,173,137,152,97,52,
+129,234,172,32,20,170,9,152,25,36,168,172,9,101,19,201,
+171,9,17,17,17,216,171,48,2,81,36,202,9,147,223,172,
+9,32,83,51,129,153,24,145,221,40,37,192,187,41,99,51,
+129,205,171,48,35,128,202,172,9,65,37,176,157,32,2,0,
+168,189,153,137,65,50,84,18,169,170,186,80,21,236,9,2,
+169,64,2,187,81,52,130,219,156,48,52,145,171,40,51,69,
+147,191,154,153,56,38,1,0,250,172,0,17,68,18,152,153,
+154,49,146,206,137,67,35,16,19,251,156,8,1,8,16,51,
+251,143,50,129,154,50,145,172,138,17,67,1,24,51,249,174,
+24,33,18,186,11,19,221,137,234,155,84,18,136,32,50,2,
+235,139,48,18,218,188,40,85,19,176,189,171,9,0,66,19,
+219,139,0,33,36,152,10,128,41,119,3,187,173,153,65,54,
+1,185,205,10,66,2,170,154,202,156,49,2,49,37,34,68,
+144,189,170,138,82,68,3,218,172,0,8,34,128,138,185,191,
+40,1,155,117,51,144,153,186,188,9,84,52,1,169,188,187,
+24,83,36,146,187,9,129,235,188,170,40,36,83,68,1,203,
+155,24,16,66,51,145,222,155,50,2,152,169,172,80,21,160,
+172,138,32,50,50,70,130,205,11,18,18,51,178,190,171,8,
+16,128,202,10,53,232,172,49,19,32,3,234,188,189,10,85,
+36,161,170,16,176,157,65,18,153,136,170,80,21,185,171,0,
+114,19,218,138,16,152,136,49,20,0,82,161,157,114,130,186,
+186,140,84,130,186,9,16,17,1,8,82,147,223,155,34,19,
+153,137,49,146,155,87,162,188,41,35,184,155,114,52,3,201,
+172,153,187,96,52,168,187,170,187,80,55,144,155,33,1,99,
+162,188,8,168,96,37,168,139,18,176,155,49,17,50,240,172,
+40,18,144,234,42,38,168,9,128,64,20,203,115,19,186,172,
+26,67,201,11,52,184,204,187,10,34,128,32,20,201,12,71,
+2,153,33,131,234,155,137,169,72,53,19,18,251,156,137,8,
+52,130,204,155,40,2,186,114,21,0,152,154,81,146,189,25,
+17,50,147,204,171,9,116,2,202,154,153,24,129,137,100,19,
+0,1,186,104,20,168,40,20,185,173,203,139,115,18,168,154,
+137,0,152,25,69,35,1,250,10,35,235,26,52,34,66,176,
+173,40,17,66,130,188,202,204,42,54,129,137,186,189,80,52,
+1,185,204,138,33,35,69,130,204,137,17,33,160,191,138,49,
+36,144,25,145,156,99,177,157,33,128,25,17,153,202,188,72,
+54,131,235,171,9,65,53,128,170,187,24,52,144,32,232,174,
+40,18,8,34,249,188,24,19,1,152,137,33,192,173,64,52,
+36,144,171,186,188,88,35,136,67,130,219,236,187,40,36,33,
+36,200,171,0,16,84,2,170,137,154,113,21,185,171,202,172,
+0,67,69,19,217,171,16,201,155,99,18,33,2,218,139,33,
+17,1,137,115,55,144,188,171,138,50,4,16,1,201,172,41,
+34,185,113,36,144,128,251,157,16,129,17,51,144,188,40,161,
+158,68,18,49,161,173,17,252,26,20,128,66,130,188,203,155,
+99,20,128,0,168,137,16,1,137,33,162,255,170,8,83,1,
+8,17,186,41,21,136,185,157,115,3,202,154,144,185,155,97,
+35,152,172,9,202,12,86,19,0,152,187,187,189,57,38,144,
+137,184,173,64,36,145,138,66,145,202,187,155,50,129,97,19,
+202,40,129,153,33,67,131,190,113,37,152,171,187,41,68,1,
+160,205,138,160,27,119,35,144,185,156,0,152,40,38,136,24,
+128,202,186,155,0,160,188,104,38,176,140,67,144,26,35,184,
+188,154,81,36,18,18,169,171,187,113,21,202,10,32,18,248,
+173,56,2,136,48,54,3,153,153,237,155,99,19,1,202,173,
+138,136,49,20,0,16,35,18,200,190,155,40,68,145,204,186,
+156,115,37,136,153,153,0,129,48,71,145,138,129,189,138,128,
+154,17,0,64,52,184,191,25,83,18,16,0,16,168,174,56,
+146,205,9,18,67,145,172,49,162,44,87,201,140,66,161,171,
+48,20,0,168,174,137,128,25,117,19,152,153,186,188,24,17,
+49,53,200,156,16,129,24,128,155,87,129,172,16,153,57,37,
+185,172,24,2,234,9,176,139,86,145,24,35,129,49,19,202,
+205,172,153,32,83,34,160,190,25,19,200,188,25,20,152,64,
+37,184,155,65,20,250,139,67,19,0,186,173,136,33,83,18,
+1,168,223,10,49,128,152,168,189,57,69,34,34,1,234,173,
+137,128,114,52,145,170,218,172,9,50,2,16,51,176,188,186,
+189,57,68,18,49,52,248,189,25,18,24,98,2,218,170,0,
+16,16,18,2,136,24,4,202,137,8,115,37,185,139,2,234,
+171,16,160,172,0,128,32,82,103,2,204,9,2,169,8,168,
+80,70,18,144,219,187,154,56,54,128,32,4,168,186,205,9,
+68,18,136,154,17,216,172,24,49,52,34,16,51,3,253,190,
+139,65,51,1,8,144,221,138,17,0,128,170,40,36,2,169,
+189,25,69,19,160,235,204,10,84,2,152,170,139,98,18,185,
+171,16,0,32,225,174,96,35,128,33,217,188,155,40,67,50,
+51,160,172,152,219,25,35,202,10,71,20,168,186,186,25,67,
+51,52,161,189,8,184,158,49,20,66,18,169,185,204,171,8,
+17,130,203,57,71,130,189,72,37,0,137,219,156,8,33,68,
+1,153,169,153,233,190,25,17,33,53,34,144,222,10,51,18,
+128,153,137,186,157,82,52,19,168,189,154,136,137,16,34,101,
+35,184,155,186,140,102,36,184,190,24,130,185,8,1,49,39,
+145,187,10,51,217,157,40,67,18,170,48,211,207,9,34,52,
+130,170,153,202,41,53,3,0,136,219,204,138,67,145,172,32,
+146,139,52,192,12,17,128,97,19,152,171,204,9,100,36,160,
+154,128,251,171,24,50,35,128,33,176,28,55,161,9,162,191,
+25,176,156,99,35,144,187,10,176,207,137,33,51,1,113,20,
+186,12,66,2,186,172,40,130,207,9,51,128,80,19,203,154,
+218,139,52,2,49,179,191,41,33,68,3,186,186,189,25,161,
+157,116,18,1,176,188,24,176,173,56,52,2,186,11,131,188,
+117,4,171,16,177,158,33,18,48,3,185,170,237,171,32,18,
+152,25,68,208,189,80,36,17,0,201,171,136,137,68,2,0,
+18,218,139,17,218,140,82,18,152,8,169,41,54,168,25,35,
+251,154,218,140,98,130,137,18,168,48,177,158,50,160,41,224,
+157,82,2,137,153,137,8,218,26,71,20,161,219,10,17,17,
+69,130,219,137,169,10,18,136,115,5,168,154,8,185,10,68,
+144,80,20,218,155,0,168,171,115,4,170,25,17,136,184,156,
+82,19,186,139,114,52,161,220,171,32,17,16,144,11,87,161,
+156,33,129,187,153,136,137,117,35,168,24,2,186,186,239,138,
+66,36,2,168,25,17,218,138,168,157,116,2,185,136,128,9,
+16,0,129,188,113,162,156,84,2,138,1,218,155,0,0,34,
+66,19,234,172,153,170,41,52,66,68,18,201,173,25,144,154,
+85,19,153,170,203,153,16,83,19,128,16,254,155,49,18,48,
+53,145,172,170,138,82,20,169,10,160,204,8,2,152,172,96,
+38,176,156,17,152,10,99,19,169,41,147,223,10,34,17,33,
+34,208,207,10,49,35,34,144,156,168,220,138,49,35,129,168,
+137,1,202,171,188,114,39,168,25,3,206,10,51,1,128,152,
+136,185,174,138,9,114,52,16,16,251,172,49,3,137,48,35,
+145,237,154,152,153,115,19,0,1,160,205,137,16,49,37,2,
+128,251,156,16,17,67,160,41,21,235,154,0,25,83,2,185,
+190,11,17,184,10,101,35,0,0,250,171,17,2,67,2,137,
+145,221,41,130,155,100,146,187,56,161,157,64,19,136,0,217,
+171,1,218,41,36,0,129,223,10,52,145,8,129,48,20,136,
+34,253,157,50,129,24,129,185,154,16,1,221,42,52,168,11,
+144,139,86,129,48,4,250,154,17,129,203,57,54,129,152,168,
+154,16,18,18,250,13,52,224,156,49,146,138,83,129,153,202,
+188,9,49,87,20,144,187,171,0,168,56,55,2,128,217,187,
+155,9,69,18,154,40,20,200,172,169,11,86,130,8,18,202,
+137,216,12,68,1,24,161,190,10,33,67,36,160,187,137,128,
+169,186,156,116,23,160,169,186,138,16,16,84,19,152,202,156,
+33,17,82,162,173,40,1,16,216,173,16,17,53,177,175,16,
+128,64,36,16,144,189,56,130,188,10,16,82,53,146,190,11,
+144,187,56,51,70,130,219,137,1,17,3,32,20,253,155,17,
+152,40,37,2,184,188,26,35,169,73,21,0,51,161,207,137,
+1,201,40,38,128,65,162,191,25,17,65,36,144,186,172,41,
+35,233,10,83,130,186,154,186,41,54,51,36,185,155,0,144,
+252,171,66,130,9,83,18,32,224,191,139,17,129,136,128,137,
+84,130,185,154,72,54,184,175,170,9,84,51,1,136,168,235,
+171,152,136,115,19,136,16,145,218,155,51,251,143,53,129,138,
+0,202,25,18,17,144,40,19,222,138,8,32,35,48,39,202,
+138,177,140,53,176,89,37,200,188,138,32,128,48,38,152,65,
+162,175,40,1,153,32,36,128,153,187,154,168,26,83,33,69,
+232,140,67,176,155,67,129,137,169,41,146,190,65,193,159,48,
+2,136,128,153,137,153,82,176,28,39,184,139,2,24,71,145,
+155,33,200,171,16,17,144,10,119,148,188,41,145,157,66,19,
+0,128,204,138,49,52,2,50,224,173,33,193,140,32,17,35,
+176,137,216,140,33,153,118,19,153,185,174,9,128,48,21,169,
+33,161,10,176,175,40,33,68,1,24,200,159,16,152,48,133,
+154,18,251,41,1,24,68,152,41,35,168,187,72,4,204,72,
+35,2,249,157,136,169,80,21,144,1,184,139,168,204,40,67,
+34,18,152,203,187,137,83,161,13,70,160,10,131,207,40,18,
+32,19,187,97,161,175,8,49,35,168,139,144,9,146,207,25,
+130,153,0,66,132,207,9,19,128,17,136,65,161,188,219,26,
+71,145,153,17,144,153,16,160,207,24,20,136,1,168,9,18,
+49,193,207,82,131,187,9,170,40,131,25,54,17,36,192,156,
+136,48,5,237,10,34,128,186,172,64,19,32,52,177,206,138,
+65,2,153,16,128,136,169,16,232,173,24,136,115,23,170,41,
+19,187,89,38,161,189,24,129,203,32,147,173,81,130,136,128,
+154,81,144,58,39,218,26,35,169,8,136,24,160,42,23,218,
+40,131,190,64,18,32,20,236,10,68,145,170,136,169,25,21,
+169,137,168,12,52,144,96,3,235,187,25,54,161,26,51,201,
+10,35,128,202,173,32,52,144,171,9,200,57,55,201,41,19,
+153,136,186,24,115,69,160,173,48,145,10,33,160,237,139,84,
+161,155,34,216,155,50,51,168,25,3,191,32,248,158,82,2,
+136,0,153,169,186,57,21,137,82,19,152,188,173,40,35,17,
+115,36,200,189,25,51,160,42,71,145,155,33,192,172,24,1,
+136,56,38,160,173,169,24,83,3,218,138,83,129,171,9,1,
+169,26,38,185,120,5,202,41,145,155,34,145,9,130,64,38,
+0,66,192,174,0,176,141,49,19,99,3,168,0,168,25,208,
+175,65,162,156,49,17,51,224,157,24,8,81,2,170,170,25,
+84,1,0,130,203,171,24,4,236,138,32,33,144,41,55,218,
+26,176,175,49,146,57,4,171,82,131,186,9,2,253,138,34,
+128,50,224,156,49,176,11,53,130,204,11,51,1,102,131,203,
+25,161,140,16,168,48,22,184,9,35,200,11,53,184,157,65,
+3,186,64,148,190,24,145,42,55,184,157,17,0,153,10,83,
+144,138,66,129,153,24,168,189,25,184,190,41,84,2,185,96,
+35,169,153,65,163,255,56,4,186,57,20,169,154,81,2,189,
+41,161,156,50,192,10,50,0,17,152,8,235,104,19,204,8,
+200,156,81,2,168,64,3,187,80,146,173,16,129,0,16,116,
+179,191,65,147,189,65,131,186,136,144,8,168,155,99,2,33,
+4,188,26,37,17,152,204,56,21,185,155,170,57,4,170,115,
+176,44,23,235,11,66,1,137,32,130,218,41,3,203,97,130,
+154,32,169,57,22,168,155,137,136,171,115,7,153,24,146,156,
+0,168,112,37,168,9,1,153,154,9,67,146,171,49,176,43,
+23,253,10,51,129,25,34,18,192,175,25,1,40,36,200,155,
+32,37,146,221,138,68,3,186,154,16,69,2,154,168,190,32,
+3,154,1,235,138,1,32,86,35,176,173,16,8,117,19,202,
+154,137,24,129,170,169,11,103,161,156,32,130,168,154,84,131,
+170,1,220,41,21,136,168,171,80,146,173,24,16,0,202,10,
+69,146,219,58,53,232,139,50,1,136,168,173,137,82,37,128,
+187,9,17,202,42,39,185,12,2,203,40,52,146,252,154,67,
+18,169,136,144,136,0,0,81,37,160,139,34,251,27,52,160,
+203,170,24,19,202,41,3,251,155,49,2,9,33,68,130,190,
+57,19,137,145,189,114,4,8,144,188,112,131,186,48,147,173,
+49,2,26,54,208,26,53,218,26,35,160,137,168,64,147,138,
+22,254,139,51,161,9,3,203,48,162,191,80,36,160,154,24,
+128,219,26,52,145,56,6,218,40,131,188,64,5,168,8,160,
+186,56,38,144,41,54,176,188,137,153,81,36,128,50,161,173,
+186,156,81,35,128,235,25,36,250,155,34,144,9,33,66,36,
+250,156,48,132,202,24,19,24,18,201,138,152,26,5,219,64,
+131,170,152,40,55,161,172,136,8,18,168,138,233,11,103,35,
+184,189,25,34,33,35,250,156,48,36,176,156,0,152,153,137,
+115,23,128,153,152,33,20,185,188,138,83,146,156,65,20,219,
+139,83,130,202,154,24,35,168,89,36,186,56,3,186,203,171,
+49,130,153,81,52,233,172,136,56,38,185,57,242,191,41,19,
+33,0,32,20,251,139,136,40,53,145,153,154,80,5,201,25,
+35,144,188,173,137,83,131,205,41,37,1,128,186,80,162,189,
+64,130,137,34,129,128,184,172,153,187,58,119,1,137,32,168,
+11,19,153,100,208,157,66,145,189,40,2,154,40,1,32,144,
+140,85,145,156,17,218,9,50,19,184,188,9,49,53,145,26,
+3,187,118,177,191,48,19,160,170,48,38,192,154,50,3,153,
+137,169,26,20,185,48,240,223,49,131,171,33,252,140,67,2,
+128,170,11,34,251,10,52,160,136,160,170,65,36,200,173,80,
+36,145,153,16,129,185,188,42,87,145,154,16,1,160,190,25,
+147,170,68,161,11,161,157,115,3,168,155,57,53,144,170,138,
+33,144,120,21,220,41,51,218,155,49,34,145,221,10,67,145,
+154,50,1,0,251,140,83,144,155,50,1,24,0,137,32,192,
+173,16,24,85,208,175,16,2,50,4,219,10,128,24,67,145,
+137,129,239,10,68,161,154,17,2,17,129,40,132,205,56,162,
+175,48,131,202,25,50,176,189,24,20,16,35,252,140,83,144,
+10,51,129,170,188,89,38,200,139,16,16,144,187,41,18,1,
+216,11,38,152,8,250,13,51,128,32,176,41,132,174,81,145,
+25,131,190,56,3,137,18,32,131,255,9,35,168,154,137,152,
+187,112,23,144,154,8,152,24,35,152,72,132,220,138,169,24,
+19,8,69,145,64,132,222,25,35,145,10,49,131,221,171,96,
+52,184,140,16,0,128,185,10,129,11,39,233,41,21,168,154,
+186,114,19,186,25,2,17,192,189,24,2,49,4,236,9,34,
+177,172,114,21,185,140,33,129,136,144,138,85,146,172,25,18,
+33,2,217,26,53,176,173,16,128,32,162,171,65,193,172,136,
+0,145,191,96,37,160,187,56,53,184,189,138,33,37,184,174,
+9,17,2,0,84,130,205,10,34,152,114,130,204,40,3,185,
+138,1,50,130,203,25,67,216,157,81,19,136,32,161,188,73,
+21,218,73,39,200,155,32,0,0,128,8,129,171,115,178,174,
+32,19,1,128,8,3,237,139,33,50,145,156,100,130,189,26,
+19,8,33,249,10,51,234,42,19,171,114,146,186,16,0,0,
+217,139,67,162,203,40,53,130,188,72,37,160,171,10,24,184,
+189,113,23,153,10,0,9,16,217,155,64,36,152,10,83,1,
+136,251,157,67,130,187,138,34,19,219,10,68,145,139,49,193,
+156,49,250,140,83,129,137,32,144,156,64,18,185,172,8,50,
+3,33,19,202,57,22,169,8,145,172,33,255,158,49,19,9,
+18,200,139,83,130,186,171,8,32,3,221,88,4,169,48,163,
+191,48,3,220,138,16,17,35,216,27,69,145,186,188,57,54,
+200,154,137,48,21,186,57,132,186,56,70,130,235,138,144,25,
+69,130,171,57,54,200,173,8,17,1,152,24,52,160,205,138,
+83,35,17,144,187,64,161,157,144,73,87,160,140,33,128,154,
+128,48,37,176,156,137,33,145,172,8,185,121,39,185,156,17,
+176,172,114,20,168,10,17,184,139,68,177,174,72,2,202,10,
+66,3,203,26,52,18,128,170,25,177,207,48,3,154,84,162,
+189,9,51,145,188,88,4,220,9,19,186,25,37,128,1,202,
+172,32,0,32,176,173,32,36,34,200,139,51,250,27,53,1,
+168,205,8,144,25,55,129,136,152,155,16,192,173,48,39,176,
+191,41,37,168,139,34,201,41,18,153,51,216,11,19,202,64,
+36,33,21,216,172,48,3,170,16,67,21,251,142,49,2,8,
+184,173,16,152,9,129,26,71,130,187,9,49,4,218,10,68,
+129,172,25,36,144,9,2,154,100,193,157,48,2,153,219,41,
+71,128,154,136,16,160,175,81,2,169,136,152,24,145,139,53,
+248,138,51,145,11,66,161,173,48,21,17,136,137,34,250,140,
+33,128,99,3,202,138,17,49,19,185,26,178,255,9,168,139,
+70,145,173,40,36,130,202,11,82,130,203,42,52,168,9,200,
+12,69,161,154,1,24,53,232,155,50,161,10,67,34,145,204,
+42,20,200,26,35,200,140,49,145,172,82,163,239,9,35,145,
+152,218,11,84,130,153,0,144,153,201,25,85,145,154,8,128,
+169,172,97,20,184,137,136,40,4,206,58,37,1,128,201,11,
+83,145,153,186,10,70,192,173,49,4,168,138,33,19,152,139,
+68,144,139,168,191,113,19,204,25,35,168,186,40,67,145,172,
+137,153,97,2,139,85,177,155,34,217,9,184,156,34,186,114,
+180,191,64,19,186,138,82,130,203,40,35,234,138,49,35,144,
+186,24,146,220,73,69,128,171,153,32,66,18,234,172,32,20,
+170,64,3,205,9,34,184,12,83,35,129,0,144,235,171,80,
+51,184,155,49,177,141,36,249,26,53,200,40,22,152,153,203,
+88,20,169,25,129,48,132,207,25,35,128,8,8,48,192,173,
+40,128,48,22,204,41,36,152,171,137,85,19,218,139,48,1,
+204,9,68,17,152,203,11,50,129,170,171,113,20,202,138,66,
+3,202,25,20,218,170,152,48,37,152,32,160,140,33,252,10,
+54,160,157,48,19,153,154,137,16,145,9,18,234,26,52,161,
+188,97,20,218,139,115,2,251,138,67,160,155,82,130,154,8,
+160,10,99,19,201,155,65,2,188,25,18,0,34,1,81,147,
+207,25,2,203,41,38,160,10,52,250,139,68,160,171,66,18,
+160,188,40,161,142,84,162,139,34,233,138,18,136,33,145,190,
+9,50,145,9,35,217,56,5,203,40,17,185,191,27,51,202,
+73,37,184,154,98,19,202,138,35,17,67,192,173,49,37,176,
+205,25,18,145,152,10,84,2,171,16,202,88,4,170,66,177,
+141,16,153,153,56,87,200,156,32,184,11,35,8,83,129,48,
+147,223,137,153,98,19,170,128,185,57,178,191,113,35,129,185,
+12,51,234,11,67,145,154,16,2,136,8,8,97,37,161,219,
+171,40,35,250,157,33,20,168,156,56,19,168,154,201,155,84,
+3,170,10,86,146,188,41,51,18,200,172,0,218,58,71,0,
+0,184,158,32,0,24,2,203,32,192,12,51,200,57,226,159,
+65,130,10,18,200,26,2,202,139,115,22,170,10,34,168,9,
+16,8,67,2,205,26,1,170,72,19,186,203,138,128,139,116,
+131,40,37,217,156,48,21,200,10,52,162,171,9,169,32,19,
+235,88,37,218,139,50,144,25,18,200,41,20,218,154,144,32,
+22,217,26,19,202,139,0,50,69,131,189,89,21,184,25,18,
+81,131,223,41,51,152,154,152,33,161,187,98,130,186,171,169,
+189,112,36,217,138,50,19,160,171,152,186,96,37,17,129,203,
+25,192,157,83,2,33,145,175,48,131,190,26,53,160,155,66,
+129,219,155,82,193,174,64,19,144,186,42,35,234,9,19,128,
+17,152,33,192,11,5,220,56,4,171,81,19,169,153,32,36,
+218,172,48,54,145,202,139,16,16,51,194,175,97,3,188,10,
+1,128,153,25,54,200,140,17,2,17,250,172,24,129,49,55,
+160,187,24,128,186,42,87,146,170,153,188,72,37,169,8,0,
+0,18,8,70,161,190,32,3,169,49,145,40,179,255,56,130,
+155,51,160,40,241,12,68,232,26,52,160,138,1,136,128,189,
+56,132,171,24,144,24,3,0,4,220,72,21,203,138,34,130,
+251,156,82,145,172,49,129,172,64,36,169,10,35,200,139,8,
+17,162,159,113,19,219,138,129,8,83,130,204,9,50,130,170,
+56,4,169,80,146,156,114,129,154,24,185,41,36,0,53,216,
+157,49,1,144,170,112,36,202,155,68,146,188,24,17,8,1,
+186,72,147,190,56,54,129,185,56,147,190,73,37,192,187,56,
+21,203,155,50,162,187,32,20,17,177,191,80,2,219,25,66,
+1,187,42,4,170,40,216,90,55,216,155,67,130,188,10,33,
+8,8,49,37,217,26,36,233,155,0,32,36,160,41,21,201,
+170,136,32,55,3,185,26,68,144,188,138,152,41,100,19,184,
+174,32,3,187,88,19,170,8,16,67,249,141,66,129,137,49,
+19,251,156,16,128,24,2,41,20,219,88,162,173,49,200,10,
+145,140,67,216,26,4,220,25,67,18,200,155,128,219,56,21,
+168,24,2,17,200,11,38,250,11,51,184,42,39,184,156,8,
+35,1,17,1,65,3,223,25,2,202,41,34,153,138,97,35,
+201,72,19,203,72,19,204,11,68,161,175,24,18,128,1,50,
+177,239,8,18,169,40,34,160,204,27,53,176,42,38,185,26,
+128,138,18,234,8,145,9,67,33,38,234,10,52,145,154,9,
+98,51,161,222,171,66,131,187,80,36,160,186,138,32,144,154,
+49,68,145,220,203,9,48,51,176,190,10,67,146,205,138,99,
+51,144,138,34,250,10,51,160,138,0,17,193,158,81,130,170,
+9,34,36,218,139,52,3,136,169,190,156,9,40,17,218,189,
+155,24,68,53,19,234,139,83,34,1,186,41,38,169,187,171,
+115,5,203,138,17,16,51,145,219,153,152,41,87,2,185,171,
+137,0,99,37,233,171,82,1,153,128,144,0,66,67,129,188,
+9,1,185,173,72,36,201,155,49,161,190,41,71,2,170,8,
+129,203,57,36,169,41,1,72,71,145,202,188,9,50,18,0,
+185,10,36,200,220,172,88,36,160,153,8,0,1,136,2,202,
+104,38,128,24,161,190,137,0,82,3,236,9,34,184,172,49,
+19,169,40,52,200,187,152,205,41,55,19,128,144,8,19,252,
+158,50,35,136,152,172,9,129,154,128,235,40,38,169,10,1,
+253,138,65,34,1,137,32,4,170,40,208,159,40,49,36,216,
+155,16,186,72,20,136,8,40,36,251,175,40,1,129,168,138,
+16,128,8,8,8,67,131,255,140,65,35,145,186,171,65,19,
+1,177,191,56,22,185,139,66,19,168,10,160,190,25,128,98,
+4,221,138,128,137,82,3,8,152,187,64,193,158,64,35,152,
+218,155,98,34,153,25,1,168,26,66,1,8,52,177,207,154,
+16,34,67,53,128,170,8,35,145,238,155,82,51,184,189,24,
+52,176,206,9,17,18,144,170,8,160,56,35,171,114,146,173,
+25,71,130,187,40,160,175,24,36,19,0,160,239,137,18,128,
+32,51,35,216,174,40,83,19,176,173,16,67,1,202,138,33,
+1,152,188,41,69,67,2,204,25,51,168,139,83,145,205,10,
+51,129,186,25,53,160,137,18,218,10,116,35,146,251,173,25,
+35,0,185,188,42,19,219,24,2,32,130,187,83,176,89,39,
+185,189,154,16,51,17,200,140,98,130,187,156,114,52,184,172,
+136,8,49,145,9,128,219,172,138,84,52,2,235,10,36,160,
+138,128,138,50,1,136,251,42,69,145,202,25,71,131,187,24,
+1,169,154,99,35,202,154,8,32,53,36,130,237,10,34,144,
+8,160,157,100,18,152,203,155,82,131,169,137,153,25,129,204,
+56,103,18,152,154,152,137,66,19,136,0,251,142,33,130,202,
+137,152,138,136,56,71,200,157,136,128,65,3,138,49,224,173,
+24,19,145,169,9,153,25,3,204,113,7,201,26,50,144,171,
+9,52,146,207,10,48,67,2,170,25,129,189,137,129,65,2,
+188,112,19,153,136,153,113,19,185,139,1,169,171,49,55,17,
+49,86,35,177,207,10,33,129,185,173,25,35,169,41,37,144,
+9,17,16,34,218,58,163,255,42,21,201,155,32,52,160,189,
+172,170,65,20,137,16,184,156,8,201,57,103,2,154,24,145,
+202,170,137,218,188,56,37,0,24,18,145,203,112,38,160,138,
+34,160,174,25,67,160,139,84,130,204,25,36,145,154,40,19,
+168,11,67,176,173,40,2,152,201,174,72,37,144,186,137,33,
+249,158,65,146,171,72,20,152,154,137,128,186,57,147,156,115,
+146,139,67,160,27,101,35,129,185,138,1,50,131,220,155,99,
+53,161,188,155,98,37,200,157,32,18,8,0,201,188,41,36,
+128,138,8,128,200,156,84,193,189,64,20,152,138,48,36,128,
+154,48,22,233,138,84,129,154,24,2,218,138,50,18,160,187,
+97,131,170,170,155,117,131,204,10,32,35,217,156,34,129,10,
+50,53,146,221,25,52,129,8,2,186,96,162,173,66,131,169,
+205,140,50,145,10,18,186,32,53,130,254,26,52,160,154,128,
+136,17,201,56,37,153,137,128,9,2,0,83,52,19,216,190,
+57,21,202,11,144,171,83,232,156,17,185,11,18,24,83,33,
+50,162,189,26,101,35,184,171,137,32,36,252,156,81,18,152,
+152,219,42,37,218,154,0,48,36,250,138,1,152,40,128,48,
+36,153,136,234,138,100,19,168,155,50,163,205,40,53,161,173,
+48,37,129,203,155,49,2,218,154,82,131,220,139,34,131,203,
+155,83,19,184,11,100,145,188,24,67,18,216,173,40,20,160,
+138,49,53,177,158,80,19,128,153,137,33,129,172,136,33,130,
+187,113,20,186,9,130,187,112,4,186,88,130,174,16,177,188,
+169,25,87,161,173,16,17,144,186,9,82,35,184,189,9,168,
+172,98,130,173,98,19,186,9,152,154,114,19,186,12,53,162,
+188,24,35,50,34,251,156,65,19,184,170,65,35,186,26,130,
+172,114,131,154,34,249,188,25,50,160,155,32,85,52,184,158,
+48,19,201,172,40,19,169,219,219,25,51,193,189,48,5,204,
+25,52,145,155,33,129,203,40,34,17,18,250,204,154,82,35,
+2,160,190,24,145,172,99,35,153,203,138,32,17,68,177,191,
+48,36,160,155,49,37,18,2,234,138,50,161,154,64,53,36,
+128,218,172,16,168,104,38,201,172,17,2,168,40,37,200,26,
+68,160,154,136,153,82,2,219,137,34,145,172,25,83,3,236,
+155,33,67,2,218,26,52,192,174,24,3,136,97,2,235,154,
+32,33,128,170,138,8,33,176,172,153,136,17,160,206,138,84,
+4,201,188,155,97,35,168,24,37,146,251,171,24,33,83,3,
+235,138,50,34,168,173,41,34,0,115,130,189,11,34,145,154,
+56,55,144,156,17,130,202,189,25,1,32,38,176,156,33,37,
+131,204,138,1,34,2,137,1,238,139,19,185,80,19,9,116,
+22,176,188,40,51,18,0,0,144,203,25,35,249,189,40,55,
+145,172,24,34,200,188,64,36,128,32,36,161,190,10,1,187,
+64,36,144,136,168,153,204,73,52,144,170,137,115,2,137,35,
+251,13,34,152,8,168,9,3,220,138,152,72,53,130,0,168,
+11,34,251,188,203,10,82,130,170,170,172,40,18,99,20,152,
+0,253,158,65,35,153,137,128,0,33,129,218,139,116,18,201,
+172,41,67,176,172,33,2,137,32,51,162,190,27,85,2,170,
+57,52,1,153,153,66,146,26,69,2,24,66,35,253,173,24,
+1,48,37,160,171,41,55,130,203,137,16,18,176,187,220,172,
+48,19,187,89,54,35,200,188,25,35,234,170,0,136,186,191,
+155,48,84,130,219,9,0,34,129,219,24,1,154,219,140,82,
+145,9,84,130,186,139,115,19,152,154,138,100,147,206,41,51,
+145,170,171,114,35,185,26,52,176,157,32,145,173,32,52,0,
+202,171,48,52,18,136,153,168,239,171,9,0,136,25,33,216,
+42,39,161,173,187,9,66,146,186,113,37,185,173,33,130,137,
+32,68,35,177,206,138,98,18,154,25,51,2,217,189,40,2,
+205,138,17,49,21,201,156,16,128,136,8,65,2,252,154,48,
+19,169,42,87,129,203,24,35,2,0,160,235,155,153,136,49,
+68,2,217,187,202,138,17,17,100,2,185,201,188,113,3,170,
+16,1,49,225,157,97,2,136,136,137,32,35,1,184,11,71,
+176,207,137,49,36,144,137,40,36,200,173,137,17,67,129,154,
+83,35,129,204,42,38,144,56,39,129,170,137,144,170,80,4,
+153,9,185,10,20,249,173,32,35,201,11,84,130,203,41,36,
+185,140,84,51,17,128,202,203,137,65,36,128,154,8,201,204,
+138,18,186,74,37,184,171,153,8,251,139,52,144,64,37,217,
+154,65,21,218,11,68,2,153,153,24,2,185,10,16,50,53,
+130,218,189,10,145,219,137,33,18,217,155,33,184,156,169,205,
+172,48,55,144,16,161,189,72,54,19,169,139,0,218,187,41,
+101,35,168,10,34,176,172,98,35,153,40,1,10,152,189,32,
+144,139,37,184,238,204,24,3,202,154,185,73,39,168,10,0,
+32,131,223,25,35,129,136,128,251,156,64,36,136,16,34,128,
+17,201,156,99,19,218,139,33,2,153,152,49,51,152,40,54,
+35,17,16,248,255,137,66,2,170,9,130,201,170,16,144,190,
+155,128,153,56,71,160,173,9,128,170,25,66,36,176,174,25,
+18,8,16,146,219,58,37,250,140,50,19,152,169,48,4,187,
+80,177,141,84,17,98,2,185,9,34,50,161,173,114,37,128,
+203,139,49,131,203,40,35,32,52,249,173,49,35,201,172,81,
+4,169,56,131,190,24,130,186,8,49,71,145,188,9,152,171,
+128,168,153,218,41,21,234,10,35,185,11,51,17,16,98,36,
+251,175,8,144,32,37,160,170,8,16,200,140,99,2,137,144,
+188,137,137,81,208,156,82,129,0,160,138,20,251,26,50,2,
+168,155,85,130,139,83,161,155,113,18,168,138,49,161,191,56,
+22,168,26,54,129,9,136,188,155,137,81,53,129,8,217,171,
+50,177,155,66,2,145,186,56,3,26,119,146,204,138,66,3,
+8,51,225,172,136,33,85,1,154,16,201,155,1,153,97,19,
+251,173,26,66,2,186,172,154,17,1,24,101,18,169,172,138,
+34,178,140,118,18,186,171,8,0,1,16,1,186,72,21,235,
+138,50,19,185,174,65,38,169,138,67,176,173,0,66,36,129,
+154,186,27,39,216,139,67,18,8,153,65,20,185,57,130,187,
+64,34,84,3,251,138,16,202,10,53,51,35,208,172,185,156,
+65,177,142,66,129,171,153,16,51,51,193,206,56,38,168,171,
+40,128,188,138,186,115,6,186,10,3,219,187,25,83,184,172,
+169,206,40,68,145,153,16,0,152,136,49,20,235,154,186,174,
+81,36,18,1,202,155,17,1,1,218,155,50,176,173,81,70,
+3,169,137,17,16,67,52,130,169,137,136,113,54,34,35,18,
+18,233,156,49,36,67,200,173,48,129,154,32,145,220,155,81,
+67,34,51,35,145,204,155,16,0,32,4,254,172,9,152,169,
+40,2,170,42,35,152,154,170,136,209,239,171,49,130,172,24,
+251,157,17,0,50,53,51,3,238,155,33,144,156,49,147,155,
+115,36,136,9,49,18,153,170,82,38,161,206,138,49,130,8,
+53,130,32,131,206,25,18,219,139,144,251,172,16,50,144,154,
+0,185,138,49,37,248,172,16,251,158,48,18,16,144,137,66,
+145,171,80,50,0,219,157,16,35,67,3,188,113,4,186,64,
+20,186,155,24,144,202,57,71,2,170,25,34,233,172,24,160,
+171,16,233,138,50,160,153,234,155,0,186,58,87,18,160,203,
+24,51,32,102,2,185,16,130,203,24,36,145,220,139,17,2,
+33,33,0,168,204,202,174,114,20,217,154,128,168,154,65,51,
+128,186,191,42,20,234,138,1,32,19,204,42,52,18,144,170,
+98,18,32,36,169,32,163,206,138,80,54,145,171,81,130,171,
+32,146,191,9,144,170,136,205,26,36,168,25,136,10,178,223,
+80,3,186,32,192,11,54,1,32,35,185,140,50,3,201,154,
+128,152,128,112,119,130,169,16,129,9,67,17,67,208,156,49,
+200,172,65,20,185,155,1,186,156,8,128,236,138,51,145,56,
+39,184,189,10,33,169,57,39,128,168,189,11,18,137,102,19,
+153,32,130,155,98,2,8,217,157,83,131,137,50,145,9,216,
+156,100,2,152,0,33,0,203,10,66,34,35,2,185,221,154,
+128,251,157,49,161,155,82,129,155,154,139,67,209,156,16,144,
+170,186,155,17,49,54,192,72,22,251,139,51,161,157,65,130,
+171,65,131,155,82,146,24,4,236,25,35,128,100,130,171,48,
+130,10,54,145,9,51,18,51,216,191,40,145,204,25,51,67,
+67,3,201,190,139,32,34,70,2,185,153,169,187,172,115,7,
+168,40,18,203,137,152,154,234,138,49,128,0,128,153,239,172,
+32,1,154,16,169,138,201,173,113,20,185,41,4,168,9,201,
+156,129,169,24,152,113,21,169,9,233,172,32,19,0,128,168,
+169,140,82,130,80,3,205,64,131,175,24,147,219,8,128,32,
+35,0,82,144,12,50,233,27,54,129,10,82,130,202,10,83,
+130,155,115,2,153,32,161,172,137,16,17,234,42,55,161,188,
+32,35,216,11,84,129,138,16,152,152,170,96,36,152,65,131,
+187,24,50,21,250,140,17,168,27,51,18,1,252,173,49,37,
+129,144,136,128,221,10,2,9,52,248,156,16,168,155,170,154,
+34,144,11,82,18,144,201,171,98,147,206,154,171,25,36,201,
+11,101,131,203,57,37,201,138,34,145,169,155,8,136,48,5,
+222,26,83,144,155,82,145,189,40,20,1,1,234,10,35,200,
+140,49,18,8,66,176,175,114,131,202,40,18,169,9,100,19,
+184,10,17,186,41,39,2,24,66,2,152,187,72,21,202,80,
+36,129,152,172,32,177,175,49,146,11,54,146,187,24,152,171,
+113,54,130,170,24,128,137,184,157,115,131,156,65,146,188,171,
+8,34,203,73,6,169,81,147,221,9,128,153,0,128,138,50,
+249,172,24,169,10,51,160,188,138,32,217,190,137,16,67,35,
+98,19,251,155,128,185,139,33,66,68,216,156,32,129,48,36,
+128,67,192,172,24,16,129,191,88,37,152,56,36,168,56,37,
+136,40,3,187,81,147,139,16,218,170,64,119,18,137,16,152,
+25,20,218,187,153,32,128,81,39,160,156,136,186,11,115,18,
+152,170,186,251,171,25,128,139,68,146,136,216,173,33,193,173,
+8,67,20,186,72,132,204,10,128,154,50,34,0,137,65,130,
+188,112,53,131,153,49,178,223,25,17,1,35,144,9,100,19,
+128,32,168,190,16,193,157,65,3,202,154,32,147,204,57,20,
+0,34,249,139,49,160,189,156,8,234,172,32,20,144,154,170,
+139,98,19,33,55,131,172,9,17,128,32,67,3,17,34,177,
+239,41,36,219,73,21,169,49,3,171,136,187,72,177,174,33,
+144,136,184,188,168,236,171,24,69,1,170,154,169,170,40,128,
+97,38,218,57,87,145,154,136,168,154,48,84,19,33,35,232,
+172,81,3,153,49,177,158,33,160,170,160,206,137,0,49,51,
+200,173,169,202,154,33,38,50,18,186,41,21,9,86,3,8,
+50,200,154,50,35,184,173,50,36,49,161,173,9,235,9,144,
+141,0,221,42,19,221,138,152,156,64,19,153,80,35,168,153,
+128,67,225,174,33,130,41,71,129,136,152,138,49,17,101,131,
+218,9,168,137,129,154,99,162,157,16,192,173,137,136,8,49,
+67,176,174,24,145,157,33,1,97,37,136,24,169,104,37,168,
+10,19,24,84,161,173,136,202,138,35,129,169,171,81,194,175,
+25,160,11,51,168,58,19,251,171,138,49,177,140,100,129,170,
+137,168,202,221,26,86,19,144,136,0,144,188,57,54,129,138,
+16,152,40,36,169,96,4,202,10,34,161,205,188,203,186,10,
+99,130,203,153,217,187,33,36,2,176,204,137,152,202,155,49,
+176,141,84,129,24,176,174,25,17,115,51,33,35,251,10,53,
+130,170,138,67,36,17,128,8,137,72,54,18,114,52,17,184,
+190,25,20,168,139,17,128,80,37,176,188,186,188,80,36,152,
+33,162,190,170,186,40,37,18,146,223,138,0,186,138,200,156,
+83,2,24,51,217,204,155,32,51,17,65,37,176,190,25,17,
+0,128,219,80,55,168,139,82,145,172,8,83,52,128,9,34,
+145,187,171,80,38,160,154,152,203,72,38,145,56,53,161,156,
+25,33,144,174,41,2,10,115,129,154,0,234,187,65,36,128,
+16,168,11,54,161,140,83,3,168,155,32,233,205,169,169,137,
+1,17,144,222,172,154,17,18,1,144,10,36,234,26,131,188,
+81,225,172,64,18,169,188,171,169,9,82,51,129,219,138,152,
+171,98,19,33,192,191,80,20,152,153,168,154,81,52,176,189,
+9,185,189,56,39,1,136,16,129,24,68,176,174,40,35,34,
+53,1,32,19,251,12,84,19,129,128,152,128,1,17,128,153,
+67,34,114,54,2,203,187,171,10,113,68,2,153,170,153,25,
+99,35,1,8,201,155,48,144,187,202,220,138,102,52,144,154,
+136,185,169,186,105,38,129,0,168,157,48,18,49,19,8,68,
+129,138,218,188,235,173,56,52,128,8,169,236,188,25,51,128,
+0,184,140,34,249,172,138,136,128,170,155,32,177,255,157,136,
+17,49,2,168,169,204,138,0,24,117,130,202,9,2,168,154,
+32,144,172,66,2,156,25,202,205,138,33,85,67,145,186,137,
+9,152,190,80,21,203,10,18,170,73,129,138,98,67,1,170,
+73,177,207,137,144,64,39,129,152,8,137,0,16,52,37,145,
+169,9,51,3,128,83,21,168,64,55,160,206,9,34,160,10,
+84,145,154,136,170,25,52,34,17,136,168,27,116,144,139,68,
+145,219,138,49,177,175,32,35,66,19,153,168,185,144,253,138,
+19,216,10,33,152,169,25,203,223,154,9,50,161,207,137,152,
+154,8,16,184,207,154,16,66,18,202,204,187,10,68,49,34,
+235,172,0,0,84,19,168,40,18,202,188,137,1,202,10,34,
+168,114,71,168,138,66,36,18,17,51,129,188,155,8,153,137,
+87,18,0,66,17,153,203,25,54,1,17,130,188,187,9,1,
+187,114,134,9,115,145,155,136,153,138,202,57,55,161,221,170,
+8,168,171,9,9,33,202,139,217,175,48,130,153,184,10,55,
+192,154,160,173,16,1,49,161,12,71,129,154,16,68,51,152,
+48,71,130,0,52,177,173,9,0,16,0,84,52,144,24,0,
+154,9,16,99,19,219,8,225,174,9,160,156,64,1,0,129,
+220,171,235,171,40,19,128,144,253,187,10,33,34,0,0,200,
+187,8,34,177,190,11,41,116,39,144,170,170,155,114,52,33,
+82,19,144,153,136,50,193,174,40,18,50,3,204,137,200,188,
+152,152,17,176,191,186,221,154,0,0,115,19,168,187,204,153,
+152,171,113,35,1,18,218,26,51,161,96,55,18,0,129,202,
+173,138,17,49,99,52,34,130,136,65,3,237,154,8,136,1,
+201,187,205,155,67,145,157,33,2,145,202,188,173,138,81,35,
+51,3,233,187,137,34,19,99,53,3,152,0,1,128,144,221,
+11,118,34,136,16,176,175,25,1,24,68,2,136,137,186,203,
+187,155,152,186,56,36,153,186,223,171,49,52,2,205,139,136,
+236,170,32,84,35,136,49,20,185,11,0,16,85,19,34,176,
+172,66,1,11,67,17,115,23,128,170,171,153,169,26,101,19,
+129,152,8,49,250,174,9,17,153,187,170,202,172,170,169,56,
+87,19,152,187,139,201,205,9,51,52,53,19,16,144,190,42,
+53,18,18,152,25,51,217,203,171,65,55,18,33,35,200,188,
+154,153,82,39,3,144,154,50,147,221,137,8,8,152,137,49,
+250,190,154,8,0,153,40,146,206,170,168,186,138,26,67,83,
+50,233,173,9,202,173,0,33,49,129,220,188,170,25,51,52,
+53,36,1,1,218,205,153,48,69,51,36,17,8,152,219,138,
+16,50,36,152,154,185,140,137,189,48,103,67,35,128,185,189,
+138,169,41,71,2,169,153,16,152,187,48,35,98,68,33,129,
+236,172,9,33,18,153,187,220,204,154,137,171,139,24,0,81,
+53,51,145,207,171,24,1,8,16,146,206,139,0,217,187,10,
+24,66,37,2,136,217,170,8,128,0,99,99,0,173,155,32,
+128,169,138,186,156,64,19,50,136,191,56,71,52,18,137,154,
+171,72,71,35,34,51,130,203,169,202,138,16,16,86,52,0,
+137,0,185,140,115,36,2,144,188,171,202,138,65,3,16,53,
+146,64,52,129,16,130,220,172,24,34,233,171,8,50,54,68,
+36,177,221,137,0,1,144,8,33,34,33,35,19,217,186,185,
+26,101,146,188,154,234,171,40,83,33,186,190,189,187,173,25,
+52,146,138,0,169,138,202,137,249,190,9,0,8,8,234,235,
+137,66,34,34,160,173,170,170,9,51,19,144,112,52,144,137,
+168,10,178,255,41,1,153,152,203,137,218,58,55,129,8,129,
+218,204,172,9,34,66,83,18,144,201,186,203,138,50,132,169,
+49,164,190,58,52,17,72,83,34,185,189,188,153,16,18,50,
+67,84,83,2,128,48,99,144,80,70,145,154,24,1,0,136,
+8,50,70,50,144,220,171,8,1,115,51,2,17,169,189,9,
+67,4,184,48,53,129,204,189,137,16,49,54,52,2,184,188,
+188,138,97,51,34,49,128,137,0,153,172,172,97,37,144,136,
+146,237,171,10,97,52,19,136,136,168,172,154,203,140,33,36,
+36,2,0,192,191,155,8,32,128,190,155,128,144,219,172,154,
+188,58,103,129,202,186,170,154,16,68,36,129,201,187,137,24,
+0,50,130,185,218,235,154,8,152,136,114,70,35,160,204,171,
+10,136,24,69,3,217,155,16,152,9,34,144,24,1,174,57,
+39,161,189,57,55,36,17,136,170,137,128,169,64,71,36,35,
+18,136,137,152,172,9,67,34,2,217,172,9,16,50,55,51,
+51,52,4,236,155,0,185,25,68,51,68,19,152,188,188,8,
+128,0,36,131,237,189,154,136,153,186,172,48,52,145,236,204,
+186,169,136,49,36,129,185,204,170,185,155,49,38,52,129,203,
+155,153,203,157,40,84,35,131,234,203,203,155,24,52,54,51,
+35,18,0,9,42,116,17,8,49,19,218,188,138,129,171,115,
+71,0,0,152,187,138,66,53,34,32,50,144,219,204,154,137,
+169,8,1,176,187,223,188,24,68,1,8,128,219,155,171,171,
+204,171,82,36,144,170,171,168,203,156,24,68,68,34,184,173,
+0,160,9,69,69,36,0,152,202,170,8,48,100,50,17,128,
+153,8,16,35,178,189,57,54,3,219,188,187,139,115,36,0,
+185,221,188,154,24,34,34,1,0,8,186,205,188,138,1,168,
+172,137,8,216,221,41,86,51,1,169,153,1,145,1,34,9,
+66,21,33,116,51,145,202,10,35,3,169,172,99,161,190,9,
+144,40,146,159,64,128,138,2,253,187,153,34,36,144,185,221,
+171,24,33,17,16,32,168,172,56,68,35,130,48,119,36,2,
+152,188,188,9,68,34,18,17,152,154,49,35,83,67,34,19,
+202,189,188,189,172,41,83,2,169,188,172,172,154,154,137,50,
+146,203,156,88,53,200,172,137,137,33,146,203,152,170,40,39,
+130,33,19,52,119,18,136,153,8,32,36,51,65,33,144,218,
+10,101,34,128,153,152,152,137,67,3,221,138,136,137,50,210,
+223,171,137,16,0,16,145,219,156,153,153,8,200,220,153,168,
+26,0,205,172,154,40,69,50,2,136,40,17,152,176,168,70,
+68,115,3,152,65,2,154,72,84,36,129,154,56,51,3,8,
+2,208,173,24,35,51,67,234,175,154,136,16,2,144,204,189,
+154,17,2,152,9,251,188,168,200,220,186,153,16,51,50,68,
+52,129,235,171,9,17,32,67,145,11,68,145,64,71,18,66,
+18,8,24,25,72,83,51,36,130,186,25,160,175,138,154,89,
+69,1,24,136,152,186,175,24,4,2,1,8,52,210,206,171,
+152,185,171,49,19,184,255,189,154,137,16,67,51,131,235,171,
+24,66,34,8,153,137,184,207,171,185,172,32,19,67,35,251,
+156,136,17,84,68,33,128,16,33,1,8,82,51,16,49,99,
+69,2,185,10,35,39,21,128,170,138,153,171,137,69,37,18,
+18,2,144,201,154,41,99,52,36,144,153,136,169,25,200,175,
+97,20,128,0,185,172,154,219,138,0,32,144,190,155,202,188,
+171,138,65,144,204,203,188,170,187,156,187,173,56,54,160,172,
+56,161,175,137,153,40,36,136,16,184,173,136,0,129,168,147,
+184,120,7,218,171,171,139,40,48,3,236,188,188,137,2,18,
+103,36,2,128,17,129,219,10,68,51,18,128,24,137,173,27,
+49,114,69,19,144,128,184,171,16,100,69,2,0,128,186,153,
+169,139,84,51,18,217,187,170,170,188,172,89,84,51,35,1,
+251,171,137,1,52,68,17,152,153,171,11,99,129,171,137,98,
+115,129,186,154,138,136,153,72,145,223,203,187,172,171,137,16,
+2,145,250,171,152,184,137,185,175,171,205,172,154,169,218,155,
+24,129,218,204,170,8,128,8,115,50,136,155,57,34,186,188,
+154,66,146,206,189,154,16,24,9,56,1,207,11,86,130,234,
+170,152,153,16,54,20,128,137,185,173,26,51,37,3,152,128,
+16,8,34,65,114,66,84,84,34,1,144,186,156,32,53,53,
+34,1,8,153,203,8,147,160,34,36,66,67,137,155,58,103,
+2,16,2,250,170,136,128,17,50,86,19,185,203,136,32,169,
+156,100,51,1,18,144,174,187,170,169,8,17,66,146,253,204,
+171,169,160,160,160,168,185,201,204,138,115,52,34,168,171,153,
+234,173,155,9,8,137,80,1,204,156,25,33,82,83,67,18,
+153,155,9,152,171,59,116,1,155,88,34,202,140,97,69,19,
+17,16,16,9,137,16,54,36,2,144,56,85,3,144,9,81,
+51,17,82,20,144,202,138,128,218,139,83,52,35,200,173,170,
+170,139,56,115,1,185,187,153,201,218,137,128,154,153,185,237,
+205,187,138,40,53,35,0,251,188,171,187,40,54,18,8,1,
+129,24,67,37,35,130,129,70,52,2,202,155,24,50,70,19,
+0,128,8,48,85,82,51,2,137,154,153,131,4,52,35,160,
+217,155,88,50,137,12,114,38,176,205,170,136,129,202,155,136,
+186,154,218,188,155,188,190,170,152,8,65,144,205,170,184,217,
+153,16,34,33,99,19,184,172,188,171,97,38,4,152,154,24,
+83,51,35,33,136,19,23,17,0,18,51,50,114,34,0,145,
+221,138,115,36,18,168,203,171,188,189,188,203,169,0,1,153,
+10,154,173,25,19,161,253,189,172,153,169,153,154,203,174,138,
+16,18,130,129,83,54,21,3,51,20,184,189,154,24,50,33,
+113,54,19,152,169,152,32,18,9,99,3,216,203,25,53,130,
+203,172,137,202,188,153,168,168,203,187,188,173,138,176,251,153,
+170,171,160,251,189,153,48,68,19,66,83,51,36,129,16,66,
+51,129,137,137,41,33,0,71,54,18,144,145,146,169,143,40,
+2,153,113,33,153,152,234,203,169,203,172,156,139,154,152,152,
+9,9,204,159,10,34,1,25,137,159,48,39,1,49,51,4,
+34,115,99,34,17,1,16,2,161,19,131,27,103,18,24,50,
+3,16,81,17,202,187,0,209,202,9,136,235,188,155,25,10,
+156,155,204,204,186,188,173,171,8,153,42,37,200,140,49,48,
+24,145,33,19,223,27,115,4,128,50,36,145,137,114,34,128,
+0,3,36,19,128,18,176,75,103,18,18,17,16,16,8,16,
+80,81,0,17,6,177,221,219,170,185,153,153,8,67,132,200,
+202,186,170,154,235,220,169,169,186,172,40,2,154,48,37,18,
+192,190,9,136,154,16,184,255,155,16,51,20,34,16,25,65,
+68,36,67,36,2,168,17,38,36,2,160,218,9,97,17,1,
+35,1,24,37,18,83,19,190,156,136,16,53,20,128,137,8,
+161,0,84,129,169,33,17,9,217,207,154,8,0,144,221,175,
+155,138,170,153,168,188,188,186,136,3,1,154,175,188,190,169,
+160,160,176,234,9,49,33,219,157,0,184,170,201,171,40,130,
+145,219,42,161,255,26,17,17,161,218,152,176,173,40,55,20,
+33,51,129,186,202,138,115,39,2,8,16,129,153,1,34,36,
+67,67,68,36,36,35,17,184,152,16,170,138,117,18,153,33,
+4,137,81,67,33,0,10,122,48,57,98,19,19,184,159,40,
+129,32,52,145,186,173,24,19,19,22,67,100,83,51,2,136,
+41,17,168,173,11,26,32,3,168,175,175,155,32,68,18,184,
+202,170,137,172,189,189,155,154,202,186,187,189,188,141,72,33,
+152,188,187,16,19,50,39,19,155,191,156,40,33,160,169,16,
+48,58,186,251,171,220,204,153,145,17,22,200,172,50,22,17,
+50,146,201,170,219,186,145,33,98,128,169,8,232,235,136,35,
+3,67,131,218,152,160,11,114,16,138,8,201,172,186,203,10,
+16,12,73,4,144,24,55,38,19,19,145,172,9,83,54,20,
+34,34,136,137,8,25,66,131,146,52,103,67,18,17,128,169,
+138,56,68,131,128,146,218,137,1,12,96,145,187,113,36,130,
+153,155,24,49,203,27,86,130,160,144,36,52,83,53,161,203,
+154,137,136,128,8,1,248,236,186,25,48,115,50,17,128,168,
+10,48,18,33,22,193,144,2,219,207,138,32,130,169,152,152,
+172,172,8,98,50,34,170,207,171,9,169,219,203,204,203,171,
+169,160,177,184,186,175,154,188,203,201,218,138,16,16,186,191,
+188,188,156,137,16,33,129,251,187,136,152,154,129,169,171,174,
+90,67,128,137,189,171,18,3,251,205,138,138,154,138,96,17,
+187,11,34,130,185,174,81,34,154,138,153,40,116,33,26,26,
+2,163,237,219,170,154,48,55,53,36,35,17,50,54,21,0,
+136,1,2,1,16,130,136,58,120,98,51,145,185,186,43,102,
+52,52,19,18,33,153,28,16,128,152,137,100,34,154,0,146,
+16,87,37,18,128,16,8,26,68,3,25,49,204,188,185,168,
+128,50,133,201,41,184,255,186,202,154,17,129,160,217,173,153,
+128,154,137,40,114,17,186,189,188,189,171,8,33,0,12,57,
+16,191,155,0,33,64,96,69,34,153,188,156,0,35,37,1,
+136,1,17,116,66,33,2,128,24,17,34,35,51,103,52,52,
+18,136,153,24,99,52,20,128,144,144,160,233,170,0,2,20,
+23,34,36,131,203,156,17,19,50,129,172,157,174,156,153,189,
+157,138,9,8,185,172,170,24,51,177,204,170,206,203,153,8,
+128,168,8,68,129,234,186,154,25,82,51,36,0,153,0,85,
+69,52,34,50,66,35,16,32,0,171,57,87,20,160,139,16,
+16,104,83,18,152,171,8,50,97,48,24,48,51,201,207,172,
+169,189,157,128,136,153,187,173,201,202,152,152,138,160,220,172,
+154,9,34,51,1,41,88,41,25,34,66,50,17,19,115,102,
+35,17,83,35,67,67,18,33,50,17,11,89,21,145,203,204,
+136,17,33,128,249,185,154,8,0,170,250,185,10,152,251,189,
+220,187,138,8,8,169,203,186,170,80,38,3,186,137,160,25,
+82,154,120,18,185,25,8,10,204,75,117,51,34,18,17,145,
+128,67,35,3,250,174,137,128,169,25,1,161,129,18,162,251,
+41,193,222,186,204,170,186,190,155,138,10,186,191,154,9,137,
+25,37,39,2,0,17,8,12,10,32,71,130,137,81,50,9,
+40,16,43,104,67,51,51,21,176,16,38,128,25,17,152,153,
+72,52,19,18,218,204,252,172,170,185,171,154,11,64,36,147,
+250,175,153,152,153,0,1,169,205,171,153,136,9,12,89,34,
+34,52,37,34,129,9,50,114,49,1,50,119,19,129,17,17,
+17,18,51,37,144,16,18,99,34,9,10,0,18,50,23,23,
+52,66,17,144,200,250,186,17,34,48,83,201,158,139,138,136,
+185,172,172,188,155,16,152,204,188,154,2,132,144,219,142,26,
+137,155,73,33,202,188,56,69,16,138,9,17,53,34,16,67,
+22,4,19,18,146,0,85,52,34,0,16,49,115,55,51,35,
+145,153,81,67,18,18,34,16,48,16,189,157,24,137,74,85,
+17,152,176,203,152,69,68,19,18,19,171,141,1,147,169,136,
+12,15,155,189,156,154,156,42,16,220,188,153,152,169,169,160,
+184,207,173,137,128,155,155,154,156,168,240,136,20,145,156,10,
+25,11,219,201,209,233,170,152,168,153,17,2,144,10,74,83,
+67,18,144,202,250,186,185,248,169,25,56,66,23,129,154,136,
+49,101,51,51,33,57,49,16,66,55,21,18,34,20,2,3,
+177,171,36,55,19,136,41,1,170,0,178,148,135,2,20,160,
+50,55,144,65,22,128,25,24,171,13,25,128,155,18,71,4,
+136,171,187,153,51,39,2,34,2,219,155,56,137,189,218,136,
+19,145,153,210,250,10,66,38,18,56,16,144,136,170,15,155,
+190,219,185,185,204,203,171,186,155,186,207,171,203,203,185,153,
+8,16,201,250,169,202,172,24,17,152,153,17,226,222,9,17,
+144,25,145,200,184,204,139,154,174,10,16,50,1,218,154,43,
+73,18,5,146,168,187,42,119,130,154,169,136,129,235,138,10,
+76,65,16,57,0,235,170,172,155,10,40,98,54,51,17,20,
+184,9,2,156,41,10,47,16,128,8,57,115,67,64,64,32,
+65,50,96,65,49,67,35,67,67,51,36,37,37,35,2,129,
+32,69,33,49,50,33,2,137,80,148,170,80,144,155,59,113,
+19,137,83,2,128,22,21,34,128,1,83,25,27,80,34,41,
+112,1,171,33,33,57,4,251,26,49,142,43,34,176,24,22,
+32,104,1,33,52,49,66,33,57,153,237,185,168,35,177,155,
+39,177,58,65,11,16,134,136,153,188,186,240,176,176,129,129,
+173,157,202,175,156,156,154,186,187,170,174,156,137,186,173,138,
+153,169,173,139,170,206,10,9,170,153,0,137,1,35,145,13,
+99,243,234,128,168,189,137,152,170,137,137,33,34,49,54,35,
+22,201,174,186,169,10,202,172,137,16,144,159,80,35,136,48,
+68,17,1,34,67,32,81,98,48,50,68,36,19,49,88,32,
+50,20,18,67,36,51,38,3,145,128,177,163,35,51,52,115,
+66,4,18,64,1,5,21,33,9,43,97,128,187,185,176,2,
+193,162,195,155,85,19,17,184,187,240,249,154,137,157,139,139,
+141,158,139,137,168,184,202,189,234,169,185,203,171,172,156,171,
+156,10,154,136,146,130,11,158,189,205,171,144,153,137,9,40,
+129,196,3,88,40,176,185,0,141,27,5,132,22,20,19,50,
+100,65,66,48,64,33,33,32,1,17,52,7,3,5,1,40,
+65,33,128,169,48,153,191,170,0,160,15,57,32,9,50,23,
+129,186,176,251,172,172,172,169,218,170,171,174,188,187,171,174,
+172,153,169,176,169,32,137,14,8,187,31,32,184,176,181,129,
+19,184,128,149,33,101,48,66,35,65,115,66,50,49,66,19,
+145,33,83,67,33,33,83,35,19,51,36,1,9,136,12,65,
+131,177,164,147,113,36,203,187,236,203,153,169,171,186,156,12,
+40,33,25,60,49,217,155,59,141,191,157,25,144,169,51,99,
+67,36,53,19,129,36,21,18,2,50,38,145,1,4,129,148,
+146,66,50,33,50,97,36,34,64,8,10,144,221,187,172,169,
+176,159,156,157,139,154,171,187,189,187,188,188,169,169,9,50,
+69,35,34,68,161,174,136,177,177,5,3,37,18,51,52,56,
+112,67,50,50,49,69,34,51,37,136,137,1,168,200,176,161,
+243,200,144,185,142,25,171,174,187,203,169,202,170,138,43,141,
+159,153,248,169,152,170,139,8,42,64,137,32,19,42,81,147,
+39,54,18,18,66,81,83,66,33,33,50,49,82,37,130,32,
+32,8,49,176,157,58,137,175,43,145,169,80,1,176,248,201,
+146,208,203,186,201,184,235,171,138,136,169,170,172,189,234,185,
+186,234,185,130,176,155,18,151,34,36,131,21,4,8,66,37,
+51,18,10,96,16,1,4,34,49,1,36,37,83,20,4,51,
+67,49,68,51,144,188,139,24,171,13,176,220,137,153,156,172,
+186,145,188,157,155,189,187,203,186,250,169,171,158,155,170,185,
+203,138,200,219,160,233,171,152,185,10,48,12,158,139,25,16,
+9,50,146,220,184,210,145,22,131,17,20,35,71,18,9,33,
+163,178,33,44,91,115,18,16,82,36,19,68,51,67,19,177,
+153,17,161,240,144,176,153,34,209,171,50,23,194,1,54,129,
+24,50,72,112,16,26,40,161,201,185,188,171,251,173,155,156,
+138,153,186,189,154,136,208,202,187,154,139,41,162,188,8,234,
+189,171,140,128,208,189,11,8,171,155,232,184,168,173,201,240,
+177,128,26,26,8,146,217,128,192,153,22,130,8,153,32,49,
+26,71,21,17,50,54,52,18,32,83,83,65,40,49,20,17,
+52,18,66,35,64,115,1,18,52,49,81,33,49,19,3,82,
+48,51,7,2,0,33,41,0,164,34,45,159,0,17,137,201,
+162,180,3,70,17,34,19,137,2,151,19,21,0,33,33,11,
+29,88,99,0,25,25,154,169,173,56,132,202,72,34,185,56,
+116,34,144,26,57,162,131,17,175,206,189,170,185,203,185,188,
+157,155,157,187,185,185,190,140,169,201,168,216,152,17,152,155,
+136,219,157,27,140,171,185,153,161,209,176,185,28,159,156,137,
+139,156,185,154,26,60,73,152,187,14,29,65,67,56,25,160,
+181,165,176,153,128,174,11,1,179,201,31,73,0,152,154,155,
+205,174,169,184,138,0,24,84,51,18,130,145,16,81,98,49,
+160,190,11,128,172,44,154,171,23,17,64,49,53,53,36,19,
+1,32,50,8,8,22,20,128,21,133,34,53,2,65,67,35,
+37,131,2,53,66,34,0,136,145,34,38,130,72,34,160,2,
+146,48,134,163,132,152,36,149,2,151,195,132,19,50,23,2,
+36,4,130,193,184,161,185,153,128,177,165,162,140,31,40,33,
+32,81,0,203,137,186,175,27,185,42,60,74,99,49,16,17,
+35,39,17,40,41,8,26,75,50,33,115,18,27,31,42,136,
+249,218,168,169,155,159,156,155,169,235,170,9,153,171,176,225,
+186,140,155,169,184,236,157,140,139,139,142,138,170,185,169,154,
+157,141,9,136,139,56,0,169,156,30,11,43,99,144,162,212,
+160,130,219,26,176,156,10,27,50,243,160,20,146,64,115,52,
+154,159,25,144,187,11,40,138,171,0,23,134,3,66,51,4,
+50,83,73,40,1,33,67,49,80,84,34,32,82,19,50,101,
+33,16,32,72,64,17,2,146,146,36,19,130,128,60,26,170,
+129,27,62,129,151,19,66,69,36,67,36,18,138,12,57,48,
+16,9,80,130,249,201,201,156,156,169,168,153,137,146,161,17,
+155,223,172,171,205,187,168,202,171,155,172,188,173,139,186,157,
+139,160,160,128,50,146,158,57,28,15,10,138,170,251,152,0,
+59,59,170,224,169,44,57,48,98,65,49,50,71,19,33,96,
+32,16,130,160,130,132,5,6,3,49,83,34,32,32,130,17,
+37,1,9,17,33,17,129,167,178,17,144,186,62,32,249,174,
+9,137,156,171,187,221,185,160,192,200,202,156,11,185,249,187,
+157,155,138,170,140,139,140,26,11,27,18,22,83,48,66,21,
+34,51,35,17,1,88,114,34,19,6,51,84,16,32,33,19,
+36,52,50,136,156,156,170,218,202,168,200,186,232,200,160,187,
+155,128,219,235,201,160,129,0,17,144,202,137,56,168,249,205,
+17,21,1,48,49,146,194,33,98,17,33,51,147,36,87,35,
+34,128,11,89,153,153,161,216,145,194,235,137,152,139,9,251,
+186,128,3,25,223,158,153,169,139,154,154,9,170,10,122,72,
+0,17,39,18,49,52,51,67,52,36,20,145,152,17,20,171,
+13,128,234,201,201,128,0,144,161,171,89,162,218,152,189,158,
+186,201,152,25,24,17,52,51,19,163,115,65,10,97,4,1,
+18,2,20,2,26,59,29,43,70,38,18,81,34,136,154,131,
+147,17,169,223,14,10,185,203,137,170,173,144,176,144,146,153,
+152,235,138,0,56,53,160,13,52,21,32,104,34,145,18,71,
+18,82,83,1,128,8,146,147,2,178,145,48,58,221,186,169,
+143,26,153,27,27,191,153,201,171,169,203,168,169,65,52,16,
+51,153,31,137,143,26,128,168,154,138,9,16,113,70,16,16,
+52,38,19,51,50,128,184,3,19,113,115,51,34,67,36,18,
+32,40,201,202,168,224,176,233,185,184,219,155,154,187,171,139,
+74,11,191,185,220,154,0,2,20,145,201,250,153,144,154,186,
+155,58,33,129,73,115,39,0,48,68,16,65,115,49,49,17,
+35,2,203,42,83,34,35,137,10,38,49,41,43,73,17,22,
+52,82,40,42,152,219,154,26,41,208,222,170,201,170,171,188,
+186,201,186,176,201,203,217,217,200,192,161,160,128,160,189,187,
+219,138,49,1,184,249,200,185,168,169,161,130,120,66,33,64,
+53,4,17,84,35,34,49,21,147,162,5,18,136,33,37,83,
+67,0,155,0,131,2,20,39,22,18,67,33,154,155,11,13,
+26,65,19,200,159,40,1,128,67,18,152,195,209,177,208,193,
+217,170,170,202,235,155,160,205,155,168,173,0,176,154,161,220,
+9,129,136,177,249,185,219,185,128,136,137,27,138,191,172,186,
+155,137,202,154,170,191,12,138,139,153,41,65,233,169,38,35,
+33,49,130,170,155,191,41,19,160,37,131,67,103,17,49,51,
+17,22,37,51,5,129,136,152,57,114,16,40,50,51,82,48,
+41,59,45,9,19,20,128,52,3,72,145,220,40,82,40,115,
+51,16,25,136,153,8,112,81,16,33,36,17,19,176,90,44,
+15,16,0,57,40,28,26,203,188,152,211,241,160,161,130,128,
+155,155,239,170,168,153,152,185,187,174,140,10,9,185,207,170,
+169,12,10,203,138,170,159,10,153,185,176,201,186,160,132,34,
+8,220,186,177,232,154,43,143,141,139,140,9,160,152,130,161,
+26,32,168,57,87,23,3,17,10,170,169,49,10,157,152,9,
+144,250,201,200,129,129,17,39,35,53,4,41,104,32,2,35,
+52,84,82,33,16,50,34,52,53,2,128,67,21,24,65,129,
+2,7,18,51,35,42,64,147,176,116,52,24,53,18,0,145,
+185,34,2,81,23,0,65,16,42,35,9,48,0,124,17,152,
+19,163,185,50,55,23,2,132,178,130,130,171,129,209,25,131,
+217,25,33,203,33,55,8,25,40,121,40,10,36,209,251,217,
+186,153,152,187,169,251,173,138,187,204,169,154,157,137,8,156,
+9,26,92,0,218,169,152,154,172,158,140,139,138,9,184,171,
+11,175,11,170,156,128,192,3,195,187,29,28,24,156,44,16,
+138,58,169,227,208,8,161,169,184,250,128,217,153,19,147,103,
+19,17,50,1,51,55,129,56,53,2,49,20,1,53,2,154,
+49,161,26,116,36,128,17,131,18,71,36,50,4,130,35,19,
+34,1,156,10,170,56,81,8,33,188,141,115,37,34,34,51,
+83,20,161,48,185,207,152,171,11,156,141,170,189,202,202,154,
+201,155,152,235,8,145,138,153,201,176,200,187,250,218,170,154,
+185,201,168,171,107,41,157,40,170,159,0,184,137,50,9,42,
+9,58,55,83,65,34,50,83,19,3,51,35,179,134,20,81,
+49,90,97,1,16,40,24,25,89,65,0,97,33,11,81,18,
+97,18,185,51,149,187,154,170,171,203,170,33,42,26,173,159,
+205,203,170,188,187,184,208,136,2,161,34,7,128,49,240,218,
+160,184,154,168,170,8,176,129,7,1,84,50,50,52,3,99,
+18,160,51,4,19,55,49,82,17,33,21,146,3,21,50,51,
+68,82,65,49,18,130,51,18,3,135,201,156,10,155,172,187,
+174,11,171,158,152,176,137,200,171,33,249,161,164,10,25,191,
+139,1,176,128,51,81,64,83,3,17,68,50,81,66,17,32,
+67,81,65,51,66,114,34,136,136,145,219,9,26,14,26,25,
+9,170,154,156,156,159,157,152,185,154,8,25,171,158,0,193,
+185,4,164,201,172,129,180,145,4,137,107,49,9,24,132,132,
+52,52,18,38,131,129,4,146,160,201,8,137,159,41,139,156,
+250,186,137,202,171,202,188,144,201,12,8,204,137,169,159,25,
+153,153,4,129,36,5,33,49,34,51,133,1,35,25,25,153,
+0,114,74,32,20,36,8,16,7,145,41,2,203,141,157,140,
+136,157,25,145,188,136,176,174,203,219,170,203,170,26,13,11,
+186,187,156,28,48,136,91,19,216,35,34,74,34,137,100,2,
+40,112,32,41,2,146,19,49,122,121,64,33,18,34,32,56,
+52,145,152,84,152,207,169,154,11,0,184,201,27,121,18,137,
+161,220,171,187,204,169,187,158,153,202,202,24,185,173,9,154,
+24,5,56,114,37,50,50,65,17,137,0,163,170,52,22,51,
+23,2,36,51,33,19,128,10,17,2,167,150,18,17,17,2,
+9,139,173,184,233,0,195,168,145,206,169,248,185,185,189,139,
+155,157,137,10,141,187,169,0,14,12,8,201,187,188,201,211,
+185,57,51,168,48,50,32,23,178,178,39,52,99,33,48,104,
+17,152,56,83,128,2,22,19,49,65,33,42,75,154,8,23,
+48,97,48,99,34,17,38,144,9,8,43,50,226,0,4,160,
+19,164,153,144,190,141,155,173,155,138,186,154,131,178,23,148,
+185,234,186,32,33,137,248,169,152,190,137,178,187,141,139,155,
+157,153,168,160,133,147,67,49,16,23,146,8,50,32,29,25,
+59,15,26,20,146,9,32,66,26,123,84,56,83,20,36,37,
+34,36,19,16,58,114,2,128,40,41,41,18,112,40,11,2,
+193,65,81,74,49,18,97,50,19,4,148,178,201,128,178,162,
+144,9,131,249,219,145,21,0,9,148,179,48,119,17,10,186,
+157,9,145,184,178,240,202,169,154,153,203,174,153,153,153,218,
+203,170,188,172,170,139,157,141,25,25,48,4,200,168,187,156,
+201,188,171,170,157,9,153,170,144,29,13,203,154,170,235,144,
+177,145,35,143,13,155,12,48,51,67,136,154,128,145,202,191,
+137,160,9,209,218,128,185,186,211,170,58,28,139,151,180,20,
+7,18,80,49,49,50,49,65,2,131,7,3,67,21,51,34,
+8,25,162,194,3,52,113,50,67,67,17,51,7,131,5,162,
+168,169,56,115,2,0,144,173,9,155,15,137,137,1,0,99,
+36,66,18,17,4,178,169,203,158,11,26,56,152,171,187,157,
+33,161,178,243,1,150,193,51,51,153,51,105,45,9,16,19,
+128,89,58,153,39,68,18,153,157,140,26,153,171,90,40,10,
+41,0,205,185,176,207,188,169,203,158,25,153,202,169,169,200,
+186,140,159,138,10,156,10,144,153,136,202,144,192,170,201,205,
+10,187,189,192,224,160,129,9,136,154,14,153,172,27,25,1,
+21,0,156,139,106,104,16,128,145,186,13,42,9,219,187,160,
+176,173,157,186,163,163,3,21,32,73,82,67,51,16,191,157,
+25,49,73,20,148,33,33,185,161,209,169,153,11,17,180,151,
+19,97,82,34,32,97,49,81,52,37,34,17,0,16,34,34,
+51,22,20,34,18,130,5,34,66,83,66,81,50,37,4,129,
+130,129,24,49,48,50,153,113,39,128,34,19,144,36,133,147,
+162,145,129,23,7,3,17,144,185,4,147,186,32,73,40,208,
+9,162,250,2,164,145,25,12,17,7,19,163,163,177,201,176,
+172,58,207,173,201,186,155,173,186,200,219,169,216,192,160,153,
+11,10,201,188,171,234,186,140,139,187,186,187,186,225,154,27,
+28,13,141,12,26,153,178,249,186,154,0,6,146,186,137,139,
+175,188,186,156,154,129,49,34,9,115,23,34,66,48,65,32,
+80,18,128,82,33,1,5,2,33,148,163,6,147,36,4,34,
+114,72,16,34,34,3,49,67,152,178,165,21,4,33,115,33,
+56,33,145,131,17,21,150,131,18,153,172,155,157,217,232,153,
+155,156,137,153,144,152,187,175,172,171,219,203,185,185,169,184,
+232,145,128,154,203,189,157,139,188,235,185,185,170,157,11,157,
+140,26,154,9,24,32,38,50,82,35,144,56,8,10,116,82,
+80,33,16,48,48,35,195,21,21,16,51,2,3,179,142,42,
+40,115,17,128,163,160,34,176,146,99,121,81,56,32,8,56,
+8,159,153,216,201,185,169,176,187,188,172,43,24,186,40,143,
+158,153,185,208,161,131,177,161,208,203,152,37,23,3,33,24,
+8,50,21,8,56,56,113,130,164,165,3,66,48,144,134,19,
+52,53,51,67,51,53,36,19,176,184,193,169,9,174,140,9,
+139,42,13,28,153,169,1,193,220,203,139,219,250,168,137,26,
+138,200,176,145,3,9,43,27,30,89,48,81,34,19,38,83,
+19,130,0,25,56,5,179,8,49,144,80,104,10,9,29,30,
+58,44,75,33,16,68,34,50,9,205,219,171,169,204,155,154,
+159,10,169,170,185,157,24,160,42,113,49,49,51,52,32,28,
+11,41,121,48,136,40,117,49,40,34,67,113,32,16,3,133,
+147,177,184,169,28,44,140,8,131,161,155,28,153,188,188,241,
+184,168,241,176,184,192,162,17,140,157,185,188,43,16,187,4,
+179,187,60,27,42,23,8,120,65,49,5,18,50,48,82,5,
+147,4,3,18,0,170,210,137,77,24,153,113,49,8,18,177,
+138,153,249,202,188,143,155,156,138,10,138,9,9,58,63,60,
+12,153,152,160,168,204,218,0,1,187,12,0,139,66,51,33,
+219,185,167,165,146,49,55,36,35,3,145,5,20,33,32,26,
+25,41,152,250,217,178,133,3,3,7,130,17,52,38,1,137,
+185,201,168,157,139,154,188,170,187,240,193,201,168,168,128,18,
+160,36,131,187,177,250,175,203,186,128,171,156,153,9,8,42,
+112,154,158,136,43,75,27,80,36,18,49,1,192,216,139,90,
+25,44,121,41,57,49,6,131,17,64,72,65,53,50,0,160,
+161,17,26,159,10,137,153,33,142,28,1,1,65,34,55,17,
+32,21,128,130,210,146,147,10,24,41,115,33,46,142,139,12,
+155,186,233,152,169,187,186,188,170,224,168,161,171,41,152,169,
+150,177,138,29,159,140,138,187,168,177,249,194,145,8,203,184,
+225,170,11,140,172,152,144,144,195,17,83,136,16,4,179,225,
+41,16,220,2,6,4,5,128,16,33,128,146,20,19,113,113,
+16,16,131,131,51,53,52,99,48,57,89,16,2,20,34,65,
+17,42,107,65,52,33,49,51,24,28,140,27,74,12,161,242,
+160,162,192,129,17,17,70,83,35,3,161,0,34,5,145,157,
+156,136,163,152,9,58,90,24,184,160,53,129,112,52,89,74,
+41,10,185,203,140,139,172,138,184,217,1,147,19,26,155,0,
+255,171,170,141,154,171,184,203,139,202,250,184,169,24,25,13,
+152,193,160,144,225,145,145,175,43,65,1,169,234,217,168,8,
+40,26,56,40,160,180,216,251,154,24,153,42,75,142,25,1,
+4,5,17,66,18,232,201,160,152,138,189,13,25,154,8,168,
+159,144,177,25,155,155,19,12,123,49,48,52,20,35,131,145,
+89,13,157,128,163,177,21,133,164,148,3,3,4,4,33,19,
+178,48,114,33,146,26,120,51,22,19,49,83,57,114,18,1,
+35,17,128,176,168,22,148,0,48,133,148,5,145,169,169,16,
+2,178,83,65,58,115,21,128,9,17,17,25,85,49,0,177,
+19,19,223,12,136,170,157,10,25,61,122,56,32,24,57,115,
+18,1,184,160,130,249,202,152,2,160,11,10,159,43,10,171,
+145,0,50,71,64,29,41,67,65,17,185,26,81,41,176,248,
+169,161,178,201,169,168,209,218,168,185,159,9,184,157,24,145,
+177,234,218,144,128,186,12,185,240,160,168,170,204,202,177,192,
+169,9,138,28,11,14,137,160,75,107,48,2,208,192,208,184,
+160,152,18,42,45,43,48,132,162,7,146,161,177,170,0,252,
+205,137,16,137,171,168,144,154,174,10,23,4,136,12,9,17,
+145,0,66,60,107,153,185,209,200,0,17,8,170,155,64,64,
+97,22,132,2,17,33,50,18,178,166,147,49,113,17,1,52,
+55,146,130,35,57,128,51,87,0,9,35,67,98,32,17,3,
+200,40,48,28,14,10,144,4,34,67,37,51,21,148,2,32,
+12,10,128,17,180,242,161,177,145,18,171,188,217,140,174,170,
+162,136,40,193,210,192,168,51,138,207,202,176,161,185,174,154,
+185,201,184,158,140,9,25,155,8,69,35,17,0,172,11,51,
+19,207,186,16,17,177,241,184,41,121,41,58,56,21,6,3,
+16,17,51,55,19,19,51,8,44,9,36,55,145,8,1,40,
+50,145,1,165,33,56,14,33,180,12,75,15,30,25,152,129,
+2,56,60,155,157,43,10,160,162,180,217,173,172,153,12,158,
+187,140,13,154,154,11,186,241,162,136,48,9,153,148,34,113,
+67,64,8,170,104,113,16,153,136,3,19,129,2,23,18,89,
+66,0,0,16,50,51,49,67,3,240,185,145,147,160,147,202,
+123,129,185,58,173,173,185,184,137,159,186,186,170,168,31,27,
+219,193,194,187,155,26,26,169,62,47,59,56,43,91,4,146,
+19,4,19,65,52,37,48,56,56,113,64,24,41,67,162,176,
+145,186,171,252,157,41,155,155,8,57,74,26,164,249,203,168,
+42,58,158,27,17,140,42,184,192,216,26,80,8,50,23,3,
+50,58,89,2,178,161,134,36,49,56,49,68,48,112,40,43,
+74,9,201,243,200,9,16,129,2,146,209,131,137,13,9,232,
+218,9,26,156,153,144,153,27,201,193,178,27,108,128,40,115,
+18,50,52,38,34,24,16,17,57,59,59,113,90,42,154,10,
+176,233,176,137,142,12,26,172,168,201,187,187,204,200,232,160,
+144,43,104,24,49,67,48,49,2,217,193,20,134,147,130,152,
+160,7,178,177,165,195,131,2,58,9,9,48,26,113,82,59,
+8,145,130,195,151,180,219,155,137,170,208,200,160,184,172,9,
+161,154,41,56,15,61,41,40,52,38,49,9,176,178,18,23,
+181,131,21,17,48,3,132,149,160,8,163,209,179,211,9,44,
+15,154,200,186,138,201,185,129,168,51,22,17,177,250,171,28,
+15,12,8,145,137,154,168,145,227,178,1,72,81,51,67,18,
+16,4,179,99,49,43,90,1,131,180,147,181,225,161,177,216,
+176,184,201,216,144,161,179,32,104,17,162,181,208,201,218,153,
+138,189,185,201,139,140,156,153,184,137,42,88,51,90,122,8,
+1,3,42,121,17,8,16,29,48,130,82,136,74,53,136,64,
+51,0,38,51,99,33,48,50,32,161,181,130,9,139,67,0,
+59,7,194,179,149,148,145,25,25,163,135,129,11,10,221,187,
+137,24,157,140,171,185,200,156,11,217,185,153,25,8,166,165,
+209,168,3,40,12,189,250,144,40,25,73,57,43,49,49,115,
+53,51,20,162,5,19,51,52,65,48,16,162,181,50,80,17,
+161,18,37,4,33,48,65,37,17,3,5,35,55,34,0,17,
+13,32,147,153,135,178,19,7,129,128,208,177,218,138,144,192,
+139,42,176,221,152,194,161,162,184,11,155,250,185,203,159,43,
+26,80,32,170,1,162,235,171,140,157,188,168,184,13,139,153,
+25,15,27,43,58,9,19,7,41,90,155,157,160,203,170,169,
+155,29,72,16,105,72,40,19,195,0,81,58,32,17,20,151,
+162,17,59,27,138,41,25,123,105,16,2,50,37,162,3,34,
+41,40,143,56,161,187,20,179,39,135,145,152,176,185,186,235,
+11,9,48,53,145,58,34,159,1,17,113,33,8,147,166,162,
+178,147,186,143,57,141,58,28,143,9,186,169,218,171,154,174,
+153,169,15,10,152,152,185,169,137,47,90,0,153,186,218,186,
+186,160,241,171,75,58,43,142,156,169,176,160,152,136,194,187,
+44,45,44,25,32,48,91,33,57,15,173,10,26,171,145,20,
+81,35,161,179,164,144,43,35,146,45,11,240,194,177,10,170,
+249,160,145,11,75,42,105,120,64,18,5,3,19,32,48,25,
+176,181,148,130,19,21,49,34,7,50,34,3,7,3,52,51,
+115,49,40,73,25,26,58,90,8,153,32,138,48,54,58,21,
+151,162,131,38,37,35,18,144,10,8,202,185,155,201,177,48,
+122,89,57,24,42,90,64,65,80,48,25,40,65,82,129,152,
+18,135,146,178,249,201,9,25,170,43,66,129,16,150,148,49,
+12,171,33,3,217,145,178,219,140,57,176,174,75,11,141,139,
+172,185,201,26,26,30,154,176,209,232,160,153,13,26,140,9,
+168,40,107,61,59,153,160,169,176,232,25,130,17,23,179,18,
+50,153,153,186,157,15,140,201,160,217,201,8,9,9,9,60,
+11,192,7,147,146,19,99,67,16,42,42,8,36,53,17,24,
+145,131,58,143,42,176,43,107,130,134,1,66,83,51,51,115,
+35,161,145,179,184,148,144,123,66,9,56,36,24,59,13,137,
+154,42,41,49,6,179,7,135,2,32,26,139,136,144,28,170,
+251,169,152,24,65,26,143,42,26,27,56,5,162,188,189,171,
+156,141,141,155,43,10,171,14,12,152,185,179,165,25,41,187,
+175,141,153,152,155,141,188,233,161,176,160,168,144,34,34,68,
+36,18,35,147,52,48,15,60,42,89,17,153,41,11,171,16,
+157,169,148,64,116,3,33,69,50,48,0,60,59,187,210,184,
+8,160,224,164,178,145,16,47,28,27,42,73,57,89,32,170,
+1,20,91,25,14,11,250,201,137,156,170,176,186,217,201,144,
+193,161,17,140,11,137,43,48,122,65,24,25,146,147,167,146,
+67,145,19,2,31,73,42,77,58,9,24,96,41,9,34,19,
+113,98,0,0,2,129,65,33,0,59,29,42,149,232,10,27,
+13,154,169,0,152,12,97,57,29,24,1,9,155,175,13,139,
+155,177,186,172,169,9,64,121,72,128,146,115,49,1,133,134,
+130,17,32,161,148,20,130,130,130,153,60,46,60,26,155,72,
+50,59,60,46,138,241,176,144,8,192,168,52,6,2,160,184,
+211,184,8,210,169,90,59,25,145,147,240,129,3,168,9,122,
+0,164,134,35,67,66,97,64,48,25,25,152,185,201,186,178,
+243,184,1,90,74,10,42,145,165,134,145,146,147,8,49,25,
+15,173,186,179,168,44,140,27,49,144,9,6,162,145,73,112,
+88,56,18,64,66,170,58,52,64,36,163,184,140,31,9,168,
+12,29,170,176,144,186,235,153,169,204,11,32,153,33,35,43,
+44,98,23,34,49,162,135,130,40,65,41,46,42,128,146,210,
+161,40,138,188,10,25,217,128,153,186,155,249,240,177,160,144,
+184,154,169,174,136,25,90,3,2,51,180,150,20,64,89,57,
+56,89,64,17,148,147,2,193,225,144,145,128,43,158,153,128,
+219,138,168,172,59,29,44,64,0,16,152,138,39,145,153,249,
+187,152,178,20,170,15,1,168,59,27,156,179,199,146,1,128,
+16,134,164,18,122,58,10,25,144,169,50,57,60,97,136,178,
+148,2,179,135,2,25,155,28,27,191,233,201,137,138,203,177,
+160,128,147,83,91,42,152,217,195,192,144,129,58,98,72,33,
+20,7,2,56,35,34,115,136,136,178,154,57,8,232,201,25,
+44,29,185,200,8,28,74,88,64,16,145,181,177,154,145,162,
+12,30,12,156,137,25,43,155,200,213,177,34,137,27,41,152,
+153,17,135,161,24,130,243,16,40,154,151,145,32,16,1,5,
+3,52,32,82,23,33,64,34,66,17,0,146,3,37,36,21,
+24,29,156,144,162,172,138,235,11,27,142,169,210,195,160,162,
+227,162,148,160,2,177,17,21,10,154,156,61,80,2,176,217,
+153,12,152,185,172,204,169,9,43,57,60,91,139,75,17,131,
+39,5,49,96,48,67,19,16,16,128,147,166,131,0,26,76,
+77,25,160,16,56,45,90,40,40,33,26,33,23,26,12,152,
+40,116,34,65,16,155,48,19,140,24,186,175,185,156,169,144,
+31,13,154,169,192,153,33,202,187,225,176,144,43,121,1,176,
+217,154,186,155,35,243,188,154,26,130,249,170,16,11,14,28,
+25,171,171,184,13,143,10,2,210,147,133,2,32,139,140,137,
+141,138,10,44,137,32,123,137,133,4,33,130,162,135,146,51,
+37,1,34,53,32,140,155,17,51,41,15,48,48,59,67,36,
+66,49,32,21,130,184,151,148,147,128,50,67,105,81,18,17,
+1,27,75,27,48,153,173,193,224,1,178,226,149,147,1,32,
+51,114,89,25,8,32,74,72,128,144,162,8,99,137,139,154,
+218,176,186,157,12,45,43,25,139,74,133,34,98,0,18,162,
+33,115,42,154,206,203,169,169,187,173,153,168,128,192,168,16,
+193,166,163,203,174,153,26,10,242,130,35,16,135,179,163,162,
+144,5,0,153,175,13,152,200,162,216,168,162,0,9,153,147,
+161,69,37,131,20,24,1,135,136,15,10,144,145,144,17,24,
+203,178,242,194,177,177,178,10,58,8,45,106,24,65,64,0,
+155,10,8,59,12,31,58,59,123,50,3,5,17,32,14,10,
+201,8,33,10,17,35,116,99,64,40,138,137,144,17,170,14,
+169,219,59,75,56,163,185,48,146,209,151,146,8,9,120,56,
+11,57,89,75,16,176,210,184,200,211,160,58,48,56,59,96,
+8,176,195,49,121,51,148,163,51,32,29,25,141,156,248,176,
+8,25,26,88,49,8,145,177,20,112,32,145,250,168,144,2,
+196,178,144,171,156,188,202,209,169,26,153,11,251,218,146,201,
+169,42,156,232,16,72,10,2,150,162,180,130,3,161,80,42,
+189,192,209,136,177,225,162,144,137,144,186,27,83,2,81,65,
+9,128,36,35,3,83,113,56,157,153,208,160,128,154,0,16,
+121,112,41,9,24,88,74,58,48,72,82,32,73,48,64,48,
+32,0,157,75,56,10,144,194,150,3,20,2,57,40,144,5,
+19,131,151,179,5,20,2,210,209,129,0,50,51,34,152,206,
+137,0,136,160,143,61,9,16,17,176,21,51,59,121,41,141,
+154,171,156,26,203,186,24,42,61,108,57,136,153,33,48,59,
+156,184,187,207,184,224,184,153,168,170,144,177,176,243,185,3,
+176,105,25,154,147,240,137,11,60,153,29,57,161,151,163,50,
+4,131,52,66,64,203,169,194,201,132,17,91,42,43,59,13,
+58,153,163,167,181,148,161,129,20,147,5,3,81,1,200,201,
+24,58,29,10,160,176,170,219,249,177,179,232,152,168,137,16,
+25,51,114,57,168,177,59,191,12,185,9,48,11,121,90,13,
+10,24,169,153,209,192,0,144,227,148,147,145,18,132,51,23,
+131,2,209,201,25,40,144,177,146,83,81,129,17,58,45,8,
+155,107,0,163,135,129,56,17,3,7,2,132,145,18,180,161,
+132,202,59,35,156,58,46,44,13,10,178,178,58,29,18,147,
+49,115,32,145,152,27,191,186,185,11,142,12,58,13,43,32,
+144,23,133,130,134,130,161,177,176,162,168,139,33,46,61,26,
+128,18,152,167,150,17,2,4,17,36,23,1,16,25,153,144,
+138,13,10,44,28,140,169,185,27,26,218,193,228,161,40,58,
+16,145,12,27,159,171,9,58,61,25,27,120,129,160,2,194,
+129,210,153,42,191,169,152,43,59,143,41,73,33,148,7,4,
+129,1,152,160,128,75,77,59,59,26,41,90,13,43,45,27,
+58,48,137,0,17,159,8,224,139,24,188,218,193,0,25,137,
+25,24,35,30,75,8,11,81,42,75,26,171,176,58,47,14,
+137,153,136,9,9,180,181,17,49,32,91,63,74,17,34,64,
+33,160,179,185,143,200,242,177,0,25,154,33,21,177,131,3,
+65,89,91,90,57,59,64,41,42,28,15,137,177,193,162,131,
+162,1,135,161,154,201,200,192,176,177,177,146,73,122,41,26,
+147,151,131,65,73,58,1,163,18,149,241,0,16,169,129,42,
+10,179,23,18,35,38,50,98,104,56,24,137,129,187,10,241,
+192,130,8,130,181,17,97,128,147,134,35,49,24,44,59,185,
+217,10,60,46,28,136,152,152,137,11,77,60,11,152,33,41,
+47,75,12,43,138,15,136,216,136,0,161,146,145,4,129,89,
+65,65,17,161,149,1,58,57,208,162,146,48,143,26,0,60,
+112,0,144,148,193,164,131,80,88,25,138,11,40,27,43,219,
+178,227,177,164,195,128,16,10,43,89,16,208,197,196,178,145,
+33,0,24,0,1,106,75,0,178,153,168,14,137,187,29,45,
+139,172,153,176,203,145,210,161,196,147,8,171,144,0,28,57,
+176,251,153,178,197,147,178,25,44,141,3,149,161,163,178,145,
+27,32,203,28,25,173,26,92,139,176,163,11,159,155,27,57,
+27,67,37,51,3,242,160,2,187,157,194,179,9,29,49,148,
+27,114,16,25,0,83,66,128,24,156,140,9,10,56,47,29,
+0,152,40,51,25,68,7,130,147,129,3,149,2,18,129,179,
+253,144,33,60,43,155,28,57,160,226,162,179,227,162,19,19,
+78,57,24,26,17,133,3,33,154,187,3,81,16,243,210,144,
+137,145,80,32,170,137,187,28,26,191,156,170,9,59,31,59,
+30,41,24,73,16,16,51,37,19,3,185,207,136,25,108,25,
+154,24,154,140,137,0,165,182,163,184,176,193,139,29,155,147,
+161,26,39,133,1,17,32,75,58,169,144,69,16,16,48,61,
+61,25,145,74,60,10,194,145,121,57,140,180,179,74,91,9,
+145,146,24,120,33,162,149,6,34,16,145,178,17,43,28,185,
+192,35,91,47,91,24,137,144,147,131,19,112,40,153,160,209,
+152,152,156,137,241,144,40,31,41,0,129,193,2,51,92,41,
+147,21,23,144,136,152,154,155,203,26,27,31,59,156,145,145,
+30,25,186,146,133,89,41,11,59,14,30,137,162,131,176,179,
+181,24,64,31,58,26,57,49,31,75,140,155,145,192,176,169,
+41,13,140,178,201,130,147,51,23,5,20,25,139,201,17,106,
+44,26,8,58,60,28,154,145,180,242,161,146,146,177,1,36,
+179,179,7,165,3,19,130,0,13,201,209,162,226,144,16,41,
+75,33,16,49,179,180,178,1,36,48,48,9,195,195,149,130,
+34,7,129,33,185,41,115,74,57,160,144,161,25,115,1,129,
+4,178,185,205,176,151,145,1,177,9,81,13,59,137,137,0,
+80,122,41,0,131,3,152,137,19,65,32,17,178,201,60,90,
+72,50,194,185,216,179,178,13,13,187,155,144,187,106,26,25,
+4,145,161,149,3,20,96,90,171,171,169,235,136,128,177,180,
+12,89,40,25,152,181,183,195,129,16,24,129,180,135,146,144,
+17,57,44,170,227,194,9,58,57,58,63,43,160,176,163,225,
+144,169,13,25,161,250,179,135,129,64,32,57,51,147,97,58,
+11,216,201,128,176,144,162,153,203,193,180,209,177,226,145,194,
+194,163,161,146,0,31,25,0,170,139,61,141,128,144,13,33,
+185,28,153,186,151,217,163,164,16,49,129,179,215,179,148,8,
+28,10,0,129,26,13,29,11,10,177,211,149,162,160,243,177,
+0,155,28,8,29,44,141,137,145,146,35,177,169,42,179,229,
+146,0,168,227,146,24,62,90,25,8,145,32,120,57,9,27,
+42,11,31,59,144,169,27,48,43,31,45,10,128,26,57,74,
+107,58,89,0,179,6,49,58,65,50,195,165,8,27,160,185,
+180,4,73,25,50,83,43,74,8,27,49,57,29,1,208,33,
+149,185,119
 };
+
+static const imaAdpcm_state_t bcfire01_48k_wav_index[53] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+{0, 0},
+{-2199, 74},
+{-1681, 67},
+{4839, 61},
+{-15106, 71},
+{-8158, 68},
+{-1973, 65},
+{-10652, 67},
+{11789, 74},
+{-12904, 66},
+{1186, 73},
+{-1247, 72},
+{-22968, 72},
+{12670, 62},
+{12735, 71},
+{15047, 63},
+{-3763, 58},
+{4743, 67},
+{5347, 61},
+{-6148, 61},
+{1480, 56},
+{2157, 50},
+{-135, 61},
+{2432, 57},
+{2975, 52},
+{1055, 51},
+{-2138, 49},
+{1387, 44},
+{799, 37},
+{115, 34},
+{288, 25},
+{2207, 29},
+{-834, 25},
+{634, 34},
+{331, 26},
+{837, 14},
+{-571, 22},
+{146, 17},
+{915, 12},
+{-118, 16},
+{-492, 11},
+{-194, 10},
+{388, 12},
+{336, 13},
+{-414, 5},
+{124, 12},
+{121, 11},
+{40, 9},
+{199, 6},
+{-87, 4},
+{47, 11},
+{20, 6},
+{7, 4}
+};
+
+const imaAdpcm_clip_t bcfire01_48k_wav_clip = {bcfire01_48k_wav_data, bcfire01_48k_wav_index, 53638};
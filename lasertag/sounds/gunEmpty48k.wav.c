@@ -1,15462 +1,510 @@
-// This file was generated by executing this statement: wav2c gunEmpty48k.wav
+// This file was generated by executing this statement: wav2c -a gunEmpty48k.wav
 
-#include <stdint.h>
+#include "gunEmpty48k.wav.h"
 
-uint16_t gunEmpty48k_wav[15456] = {
-32767,
-32768,
-32764,
-32771,
-32763,
-32770,
-32766,
-32766,
-32769,
-32764,
-32771,
-32763,
-32770,
-32764,
-32766,
-32766,
-32767,
-32768,
-32768,
-32764,
-32767,
-32766,
-32770,
-32769,
-32765,
-32764,
-32765,
-32767,
-32772,
-32766,
-32768,
-32760,
-32770,
-32762,
-32774,
-32761,
-32771,
-32762,
-32769,
-32766,
-32767,
-32767,
-32767,
-32765,
-32766,
-32765,
-32767,
-32769,
-32763,
-32767,
-32764,
-32766,
-32770,
-32762,
-32766,
-32765,
-32765,
-32768,
-32768,
-32764,
-32771,
-32764,
-32769,
-32764,
-32771,
-32765,
-32770,
-32765,
-32766,
-32769,
-32773,
-32771,
-32769,
-32769,
-32767,
-32775,
-32772,
-32773,
-32767,
-32764,
-32766,
-32763,
-32770,
-32762,
-32765,
-32762,
-32764,
-32769,
-32770,
-32769,
-32764,
-32770,
-32785,
-32800,
-32806,
-32789,
-32787,
-32797,
-32842,
-32867,
-32874,
-32841,
-32822,
-32823,
-32846,
-32868,
-32861,
-32836,
-32810,
-32785,
-32780,
-32753,
-32724,
-32679,
-32650,
-32656,
-32670,
-32686,
-32660,
-32627,
-32608,
-32635,
-32681,
-32701,
-32684,
-32657,
-32667,
-32720,
-32759,
-32767,
-32739,
-32749,
-32793,
-32855,
-32864,
-32832,
-32792,
-32799,
-32823,
-32837,
-32819,
-32816,
-32836,
-32880,
-32878,
-32843,
-32797,
-32793,
-32809,
-32821,
-32796,
-32764,
-32732,
-32710,
-32684,
-32669,
-32681,
-32711,
-32721,
-32699,
-32665,
-32662,
-32685,
-32711,
-32713,
-32725,
-32749,
-32791,
-32813,
-32819,
-32855,
-32906,
-32977,
-32984,
-32972,
-32961,
-33003,
-33064,
-33044,
-32853,
-32398,
-31644,
-30575,
-29261,
-27845,
-26586,
-25831,
-25926,
-27109,
-29372,
-32413,
-35665,
-38403,
-39927,
-39887,
-38518,
-36606,
-34983,
-33944,
-33168,
-32193,
-31102,
-30449,
-30669,
-31514,
-32260,
-32402,
-32045,
-31582,
-31215,
-30878,
-30671,
-30988,
-32182,
-34055,
-35892,
-36960,
-37055,
-36498,
-35765,
-35220,
-34892,
-34656,
-34338,
-33992,
-33934,
-34459,
-35469,
-36382,
-36651,
-36244,
-35624,
-35174,
-34842,
-34376,
-33794,
-33383,
-33245,
-32983,
-32137,
-30685,
-29223,
-28389,
-28457,
-29253,
-30500,
-31906,
-33204,
-34147,
-34743,
-35117,
-35379,
-35395,
-35127,
-34858,
-35020,
-35587,
-35904,
-35283,
-33773,
-32225,
-31439,
-31485,
-31836,
-32045,
-32145,
-32272,
-32366,
-32217,
-31900,
-31772,
-32065,
-32578,
-32961,
-33159,
-33464,
-34096,
-34859,
-35390,
-35546,
-35518,
-35432,
-35169,
-34514,
-33532,
-32621,
-32036,
-31727,
-31394,
-30960,
-30612,
-30547,
-30718,
-30908,
-31027,
-31210,
-31601,
-32148,
-32679,
-33034,
-33190,
-33130,
-32845,
-32435,
-32164,
-32235,
-32580,
-32854,
-32819,
-32542,
-32283,
-32099,
-31858,
-31457,
-31122,
-31154,
-31546,
-31951,
-32055,
-31947,
-31987,
-32315,
-32669,
-32687,
-32356,
-31976,
-31904,
-32114,
-32422,
-32642,
-32756,
-32802,
-32772,
-32667,
-32548,
-32473,
-32442,
-32408,
-32401,
-32490,
-32706,
-32937,
-33069,
-33119,
-33193,
-33340,
-33486,
-33505,
-33450,
-33392,
-33404,
-33398,
-33315,
-33212,
-33153,
-33129,
-32985,
-32633,
-32153,
-31729,
-31480,
-31421,
-31513,
-31734,
-32045,
-32312,
-32464,
-32527,
-32705,
-33090,
-33632,
-34089,
-34319,
-34317,
-34202,
-34039,
-33854,
-33610,
-33359,
-33138,
-33039,
-33053,
-33125,
-33090,
-32883,
-32571,
-32378,
-32437,
-32636,
-32749,
-32658,
-32525,
-32548,
-32735,
-32891,
-32859,
-32723,
-32631,
-32628,
-32569,
-32389,
-32204,
-32143,
-32223,
-32282,
-32256,
-32215,
-32253,
-32336,
-32372,
-32355,
-32375,
-32447,
-32470,
-32347,
-32174,
-32103,
-32184,
-32231,
-32052,
-31623,
-31061,
-30537,
-30214,
-30321,
-30989,
-32001,
-32757,
-32736,
-32126,
-31754,
-32373,
-33759,
-34848,
-34745,
-33688,
-32850,
-33123,
-34198,
-34928,
-34657,
-33911,
-33707,
-34233,
-34535,
-33709,
-32155,
-31379,
-32309,
-34169,
-35176,
-34447,
-32866,
-32043,
-32627,
-33795,
-34400,
-34129,
-33478,
-32981,
-32662,
-32370,
-32124,
-32007,
-31884,
-31545,
-31098,
-30899,
-31123,
-31404,
-31301,
-30867,
-30606,
-30876,
-31410,
-31738,
-31656,
-31386,
-31126,
-30848,
-30570,
-30555,
-31050,
-31884,
-32548,
-32754,
-32775,
-33014,
-33481,
-33757,
-33640,
-33426,
-33589,
-34091,
-34405,
-34119,
-33466,
-33084,
-33273,
-33686,
-33765,
-33377,
-32912,
-32738,
-32692,
-32326,
-31553,
-30954,
-31215,
-32271,
-33233,
-33249,
-32512,
-32068,
-32702,
-34020,
-34866,
-34613,
-33761,
-33282,
-33519,
-33962,
-34079,
-33966,
-34103,
-34586,
-34988,
-34900,
-34437,
-34010,
-33811,
-33752,
-33773,
-34017,
-34440,
-34692,
-34397,
-33702,
-33170,
-33131,
-33382,
-33530,
-33506,
-33547,
-33675,
-33646,
-33310,
-32923,
-32771,
-32801,
-32750,
-32621,
-32668,
-32827,
-32639,
-32090,
-32190,
-34158,
-37667,
-40520,
-40439,
-37469,
-33901,
-32124,
-32409,
-33224,
-32994,
-31329,
-28818,
-26387,
-25261,
-26729,
-31150,
-37012,
-41540,
-42792,
-40999,
-37885,
-34934,
-32648,
-31254,
-31135,
-32298,
-33669,
-33794,
-32191,
-29771,
-27772,
-26660,
-26369,
-27166,
-29488,
-32872,
-35523,
-35616,
-33092,
-29817,
-27935,
-28050,
-29094,
-29556,
-28813,
-27335,
-26139,
-26022,
-27245,
-29500,
-32158,
-34436,
-35685,
-35766,
-35311,
-35388,
-36290,
-36798,
-35070,
-30939,
-26990,
-26379,
-29386,
-32661,
-32754,
-30116,
-28568,
-30698,
-34627,
-36380,
-34737,
-32570,
-32911,
-35110,
-35924,
-33926,
-31266,
-30655,
-31931,
-32722,
-32054,
-31625,
-33227,
-35980,
-37438,
-36858,
-36090,
-36868,
-38311,
-38052,
-35539,
-32940,
-32615,
-34278,
-35458,
-34460,
-32184,
-30971,
-32036,
-34393,
-36085,
-36084,
-35154,
-34875,
-36078,
-37872,
-38561,
-37354,
-35308,
-34114,
-34193,
-34300,
-33259,
-31588,
-30747,
-31087,
-31330,
-30417,
-29240,
-29602,
-31667,
-33549,
-33585,
-32511,
-32250,
-33172,
-33480,
-31810,
-29330,
-28429,
-29589,
-30779,
-30065,
-28081,
-26896,
-27299,
-27982,
-27838,
-27659,
-28929,
-31249,
-32240,
-30294,
-26702,
-24538,
-25518,
-28601,
-31459,
-32798,
-32914,
-32715,
-32571,
-32365,
-31925,
-31350,
-30976,
-31123,
-31784,
-32339,
-31982,
-30642,
-29423,
-29695,
-31641,
-33913,
-35017,
-34770,
-34230,
-34333,
-34994,
-35551,
-35623,
-35355,
-35041,
-35114,
-36088,
-38076,
-40062,
-40390,
-38454,
-35741,
-34453,
-35007,
-35499,
-34138,
-31641,
-30590,
-32338,
-35342,
-37025,
-36702,
-35947,
-36193,
-36890,
-36491,
-34682,
-32832,
-32166,
-32315,
-32041,
-30970,
-30065,
-30222,
-31189,
-31898,
-31769,
-31187,
-30861,
-31149,
-31970,
-33098,
-34126,
-34422,
-33482,
-31555,
-29701,
-29025,
-29761,
-31156,
-32168,
-32274,
-31663,
-30897,
-30371,
-30095,
-29809,
-29322,
-28827,
-28756,
-29364,
-30411,
-31344,
-31838,
-32081,
-32338,
-32553,
-32209,
-31038,
-29356,
-28023,
-27639,
-28205,
-29246,
-30340,
-31341,
-32203,
-32749,
-32790,
-32371,
-31923,
-31834,
-32154,
-32535,
-32691,
-32656,
-32686,
-32852,
-33017,
-33130,
-33377,
-33925,
-34544,
-34754,
-34468,
-34107,
-34144,
-34413,
-34326,
-33741,
-33256,
-33459,
-34110,
-34287,
-33698,
-33043,
-33214,
-33969,
-34208,
-33342,
-32281,
-32385,
-33961,
-35756,
-36393,
-35593,
-34174,
-32922,
-32046,
-31535,
-31592,
-32350,
-33394,
-34071,
-34150,
-34188,
-34670,
-35417,
-35710,
-35213,
-34369,
-33796,
-33602,
-33339,
-32753,
-32089,
-31806,
-31953,
-32149,
-32044,
-31694,
-31447,
-31454,
-31602,
-31558,
-31235,
-30725,
-30232,
-29825,
-29452,
-29074,
-28826,
-28890,
-29342,
-30012,
-30638,
-31104,
-31484,
-31842,
-32095,
-32080,
-31755,
-31281,
-30825,
-30450,
-30164,
-30021,
-30073,
-30260,
-30381,
-30396,
-30450,
-30781,
-31367,
-31975,
-32401,
-32651,
-32804,
-32786,
-32502,
-32065,
-31851,
-32136,
-32782,
-33399,
-33783,
-33997,
-34169,
-34144,
-33741,
-33083,
-32584,
-32510,
-32642,
-32557,
-32237,
-32069,
-32458,
-33224,
-33855,
-34042,
-34011,
-34189,
-34714,
-35301,
-35661,
-35703,
-35567,
-35306,
-34928,
-34481,
-34152,
-34056,
-34125,
-34140,
-34037,
-33871,
-33761,
-33668,
-33447,
-33097,
-32712,
-32460,
-32372,
-32355,
-32347,
-32329,
-32337,
-32375,
-32425,
-32543,
-32758,
-33098,
-33415,
-33537,
-33366,
-32952,
-32491,
-32060,
-31657,
-31127,
-30489,
-29898,
-29628,
-29765,
-30215,
-30718,
-31136,
-31421,
-31587,
-31623,
-31595,
-31619,
-31810,
-32076,
-32213,
-32118,
-31943,
-31928,
-32128,
-32362,
-32464,
-32473,
-32511,
-32554,
-32388,
-31955,
-31441,
-31182,
-31259,
-31486,
-31669,
-31809,
-32023,
-32312,
-32575,
-32780,
-33038,
-33389,
-33685,
-33683,
-33383,
-32987,
-32693,
-32443,
-32117,
-31742,
-31528,
-31557,
-31691,
-31735,
-31774,
-32041,
-32652,
-33400,
-33953,
-34199,
-34226,
-34169,
-34050,
-33864,
-33700,
-33656,
-33718,
-33763,
-33713,
-33638,
-33623,
-33661,
-33689,
-33704,
-33816,
-34088,
-34408,
-34613,
-34596,
-34423,
-34212,
-34019,
-33858,
-33686,
-33487,
-33218,
-32878,
-32587,
-32501,
-32728,
-33174,
-33564,
-33657,
-33362,
-32825,
-32274,
-31918,
-31779,
-31824,
-32001,
-32382,
-32998,
-33703,
-34142,
-34092,
-33658,
-33231,
-33039,
-32911,
-32529,
-31853,
-31246,
-31039,
-31203,
-31419,
-31517,
-31601,
-31820,
-32077,
-32190,
-32111,
-31902,
-31529,
-30869,
-30137,
-29852,
-30348,
-31191,
-31548,
-31212,
-30872,
-31269,
-32100,
-32303,
-31488,
-30544,
-30616,
-31598,
-32264,
-31906,
-31303,
-31654,
-32941,
-33927,
-33855,
-33466,
-33850,
-34769,
-34872,
-33579,
-32109,
-31986,
-33037,
-33612,
-32831,
-31810,
-32106,
-33448,
-33898,
-32525,
-30918,
-31443,
-34117,
-36159,
-35082,
-31649,
-29218,
-30150,
-33272,
-35335,
-34354,
-31467,
-29447,
-29957,
-32254,
-34211,
-34260,
-32613,
-30875,
-30659,
-32097,
-33686,
-33715,
-32183,
-31003,
-31977,
-34532,
-36050,
-34802,
-32130,
-31108,
-32875,
-35132,
-34727,
-31517,
-28773,
-29503,
-33081,
-36000,
-35870,
-33847,
-32828,
-33980,
-35568,
-35318,
-33100,
-30923,
-30569,
-31775,
-32877,
-32853,
-32239,
-32127,
-32642,
-32852,
-32162,
-31292,
-31408,
-32367,
-32461,
-30458,
-27641,
-26959,
-29701,
-33601,
-34944,
-32693,
-29729,
-29577,
-32486,
-35304,
-35169,
-32349,
-29471,
-28554,
-29628,
-31542,
-33192,
-33877,
-33428,
-32647,
-32893,
-34418,
-35497,
-34233,
-31378,
-30073,
-32063,
-35039,
-35144,
-31924,
-29244,
-30469,
-34021,
-35189,
-32007,
-27755,
-26904,
-29984,
-33540,
-34498,
-33163,
-31599,
-30910,
-30828,
-31130,
-31985,
-32849,
-32689,
-31606,
-31383,
-33270,
-35906,
-36556,
-34576,
-32295,
-32141,
-33563,
-34012,
-32357,
-30276,
-29913,
-31303,
-32629,
-32609,
-31722,
-31166,
-31622,
-32906,
-34476,
-35641,
-35841,
-35133,
-34180,
-33398,
-32399,
-30859,
-29537,
-29630,
-30929,
-31699,
-30991,
-30244,
-31324,
-33641,
-34630,
-33428,
-32343,
-33404,
-35093,
-34417,
-31970,
-31712,
-34825,
-36285,
-30761,
-20996,
-16475,
-22332,
-32633,
-37433,
-34999,
-32898,
-36884,
-42959,
-43194,
-36621,
-29432,
-25378,
-21073,
-13814,
-9471,
-17135,
-36028,
-53221,
-56675,
-47402,
-35598,
-27812,
-22913,
-19881,
-22237,
-30737,
-36542,
-29401,
-13036,
-5464,
-19364,
-45731,
-62167,
-56724,
-38277,
-23196,
-18052,
-19335,
-24291,
-33289,
-41490,
-38197,
-20884,
-4959,
-9759,
-34353,
-55504,
-54509,
-39703,
-34031,
-43087,
-47209,
-30106,
-5795,
-4649,
-33560,
-62697,
-59766,
-29994,
-10420,
-24062,
-51984,
-58349,
-36292,
-15884,
-24917,
-53123,
-65021,
-43929,
-11899,
-2311,
-21388,
-44829,
-49445,
-37937,
-29317,
-32751,
-39281,
-37818,
-30267,
-26960,
-32176,
-40461,
-45487,
-46234,
-43160,
-34618,
-22224,
-15718,
-24475,
-42670,
-50304,
-35299,
-11317,
-5567,
-26997,
-53351,
-55526,
-31343,
-7667,
-8269,
-27212,
-39343,
-32338,
-19360,
-19093,
-31875,
-42162,
-40540,
-34021,
-33085,
-36338,
-34583,
-26258,
-20546,
-23916,
-30597,
-31703,
-28963,
-31949,
-41648,
-45366,
-33271,
-15061,
-11527,
-28895,
-48697,
-48523,
-28704,
-11779,
-15780,
-34694,
-48594,
-47719,
-39962,
-36280,
-36968,
-35782,
-32116,
-31490,
-35169,
-36553,
-31291,
-25757,
-29291,
-39841,
-44366,
-36093,
-25539,
-28409,
-44462,
-55664,
-47864,
-29094,
-20662,
-31712,
-48778,
-52431,
-39694,
-25461,
-23957,
-34201,
-44650,
-47277,
-43010,
-36109,
-28822,
-23097,
-22792,
-29959,
-39778,
-43420,
-37407,
-28052,
-24622,
-29316,
-35944,
-38180,
-36220,
-34523,
-34768,
-34082,
-29961,
-24887,
-24160,
-29752,
-37771,
-42296,
-41223,
-37582,
-35783,
-36989,
-38657,
-37695,
-33817,
-29396,
-26874,
-26877,
-28711,
-31768,
-35327,
-37527,
-35968,
-30440,
-24276,
-21801,
-23857,
-27073,
-27819,
-26287,
-25529,
-27190,
-29577,
-30604,
-30859,
-32580,
-35817,
-37637,
-35721,
-31752,
-30175,
-33606,
-40370,
-46206,
-47854,
-44994,
-40056,
-36516,
-36544,
-39049,
-40369,
-37904,
-33167,
-30150,
-30513,
-31713,
-30874,
-29221,
-30485,
-34988,
-37856,
-34640,
-27421,
-22788,
-23929,
-27367,
-28272,
-27009,
-27528,
-30602,
-31831,
-28087,
-23022,
-23497,
-30830,
-38622,
-40220,
-36304,
-33001,
-33820,
-36127,
-35941,
-33813,
-33617,
-36720,
-39664,
-38458,
-33680,
-29940,
-30751,
-34880,
-37821,
-36096,
-29933,
-22740,
-18505,
-19373,
-24648,
-31588,
-37101,
-39325,
-38135,
-34773,
-30978,
-27646,
-24268,
-20212,
-17508,
-20931,
-33041,
-48296,
-54999,
-46582,
-30974,
-25029,
-36830,
-54992,
-59086,
-41132,
-14520,
-2,
-5225,
-20474,
-31945,
-35102,
-33353,
-29354,
-22619,
-15281,
-14279,
-24391,
-41231,
-54261,
-56592,
-49532,
-38222,
-26721,
-18379,
-17316,
-24574,
-33928,
-36003,
-28947,
-21745,
-23907,
-33495,
-39390,
-35334,
-27450,
-25399,
-29707,
-32545,
-30000,
-28064,
-33456,
-42747,
-45509,
-38124,
-29139,
-28717,
-35779,
-39807,
-34305,
-24532,
-20308,
-24199,
-29754,
-30164,
-25634,
-21565,
-21847,
-25638,
-29264,
-29720,
-26597,
-22730,
-22889,
-30002,
-41306,
-49418,
-48702,
-40768,
-32453,
-28783,
-29014,
-29656,
-29491,
-30113,
-32590,
-35731,
-37718,
-37932,
-36299,
-32701,
-28487,
-27467,
-32602,
-41024,
-44667,
-38048,
-24933,
-15411,
-16022,
-24309,
-33097,
-38235,
-40229,
-40082,
-37104,
-31766,
-28141,
-30199,
-36080,
-38733,
-33511,
-23872,
-17727,
-19083,
-24899,
-30212,
-33982,
-38179,
-42549,
-43081,
-36967,
-27642,
-22857,
-26958,
-35846,
-40333,
-35013,
-23982,
-17552,
-22844,
-36799,
-48651,
-49875,
-42056,
-34568,
-34344,
-38870,
-40184,
-35003,
-28761,
-28685,
-34598,
-38986,
-36173,
-28957,
-24762,
-26636,
-30686,
-32058,
-30831,
-30372,
-31773,
-32723,
-31707,
-30421,
-30741,
-31166,
-29173,
-26102,
-26778,
-32787,
-38882,
-38747,
-33649,
-31740,
-37694,
-45630,
-45413,
-35230,
-24597,
-23675,
-32070,
-40537,
-42706,
-41361,
-42519,
-46033,
-45789,
-38476,
-29101,
-25749,
-30474,
-37607,
-40734,
-39340,
-37341,
-37127,
-36999,
-34699,
-31172,
-29718,
-31821,
-35536,
-37828,
-37589,
-35629,
-32845,
-29623,
-27127,
-27558,
-31968,
-38070,
-41677,
-40868,
-38089,
-37238,
-38786,
-39123,
-35270,
-29410,
-27231,
-31498,
-38359,
-41225,
-37895,
-32738,
-31382,
-34466,
-37573,
-36856,
-32964,
-29045,
-26274,
-23253,
-19604,
-18040,
-21377,
-28102,
-32766,
-31576,
-26598,
-23504,
-25350,
-29769,
-32306,
-31595,
-30156,
-30707,
-32798,
-33755,
-32115,
-29275,
-27800,
-28705,
-30987,
-33380,
-35838,
-39091,
-42770,
-44876,
-43603,
-39904,
-37594,
-39754,
-44901,
-47623,
-44233,
-37512,
-34239,
-37412,
-42177,
-41561,
-35634,
-32519,
-38644,
-49811,
-54993,
-49052,
-38722,
-34043,
-36123,
-36934,
-31103,
-23516,
-22561,
-28466,
-33028,
-31168,
-27853,
-30505,
-37108,
-37664,
-27798,
-16476,
-16196,
-27673,
-38716,
-38630,
-29833,
-23013,
-23669,
-27686,
-29156,
-28065,
-28043,
-29851,
-30915,
-30536,
-31352,
-34506,
-36265,
-32473,
-24964,
-20425,
-22566,
-28085,
-31718,
-33008,
-35666,
-41085,
-45731,
-45706,
-41768,
-37997,
-36758,
-37157,
-37983,
-39663,
-42315,
-43785,
-41639,
-36658,
-32469,
-31478,
-32512,
-32825,
-31357,
-28710,
-25446,
-21897,
-19668,
-21221,
-26908,
-33617,
-37407,
-37214,
-34729,
-31461,
-27573,
-23902,
-22916,
-25657,
-29060,
-28442,
-23742,
-20767,
-24776,
-33416,
-38588,
-35693,
-29729,
-30004,
-39478,
-50359,
-51578,
-39996,
-23715,
-14242,
-15853,
-23045,
-27681,
-27375,
-25938,
-26864,
-28816,
-29004,
-28802,
-32572,
-40454,
-45863,
-43336,
-37001,
-36301,
-42614,
-45158,
-34790,
-18805,
-14984,
-29230,
-45966,
-46294,
-32153,
-23731,
-32187,
-43971,
-39195,
-19971,
-9395,
-20602,
-37704,
-35486,
-12906,
-65535,
-1967,
-22972,
-34209,
-29730,
-26626,
-38254,
-54695,
-57295,
-45277,
-36420,
-41621,
-49846,
-44462,
-27209,
-16388,
-22476,
-35273,
-39065,
-33200,
-30268,
-36685,
-43947,
-41552,
-31794,
-25993,
-28796,
-32880,
-29994,
-22267,
-18820,
-23995,
-32897,
-38291,
-38654,
-37595,
-37807,
-37553,
-33524,
-25934,
-20216,
-22662,
-33419,
-43940,
-44053,
-32949,
-21259,
-19277,
-24363,
-24660,
-16173,
-10654,
-20835,
-40724,
-48970,
-34559,
-12523,
-7011,
-21739,
-35944,
-31671,
-16543,
-12733,
-27430,
-44598,
-47172,
-38491,
-34705,
-40838,
-44690,
-35577,
-20719,
-16140,
-25430,
-35132,
-32547,
-21465,
-16408,
-24267,
-36776,
-41179,
-34258,
-24448,
-22014,
-29470,
-40327,
-45907,
-43546,
-38997,
-40062,
-46767,
-49661,
-40290,
-23093,
-13292,
-20837,
-39047,
-51723,
-50405,
-40900,
-33479,
-31188,
-30330,
-28185,
-25467,
-22357,
-17956,
-14957,
-19506,
-32531,
-44536,
-45201,
-37299,
-34525,
-43146,
-51894,
-46232,
-29133,
-19478,
-28092,
-43424,
-46470,
-35347,
-26382,
-31176,
-41641,
-42464,
-32517,
-25248,
-29188,
-36668,
-35636,
-26785,
-22283,
-29511,
-42521,
-50768,
-50799,
-46096,
-39593,
-31935,
-25916,
-26693,
-35100,
-44406,
-47088,
-43373,
-39815,
-40355,
-41930,
-39547,
-32624,
-24749,
-19700,
-19690,
-25576,
-35225,
-42658,
-42764,
-38245,
-37924,
-45360,
-51801,
-45383,
-27161,
-13023,
-16697,
-33808,
-46675,
-43947,
-31712,
-24486,
-28754,
-37723,
-40366,
-32662,
-20832,
-15569,
-22949,
-38244,
-48439,
-43809,
-28630,
-18119,
-22379,
-35220,
-42127,
-37969,
-31870,
-33499,
-40055,
-41471,
-34968,
-27858,
-25685,
-25327,
-23208,
-24191,
-34366,
-47400,
-47975,
-32109,
-16411,
-19349,
-37231,
-47827,
-38757,
-22907,
-20621,
-33233,
-43523,
-40076,
-30509,
-27402,
-29774,
-27178,
-17439,
-10281,
-12202,
-17147,
-17229,
-15607,
-20276,
-28455,
-28112,
-17057,
-10611,
-22142,
-42063,
-47049,
-30547,
-13537,
-18887,
-42354,
-58116,
-51076,
-33583,
-27485,
-37977,
-52113,
-58332,
-58186,
-58426,
-60366,
-61446,
-61906,
-63063,
-61578,
-52601,
-39337,
-32648,
-37686,
-45961,
-46245,
-40244,
-40196,
-50767,
-60899,
-57803,
-43554,
-31248,
-27469,
-26546,
-22976,
-20967,
-26009,
-33126,
-32623,
-26365,
-28242,
-44180,
-59586,
-55378,
-33374,
-15419,
-15634,
-22846,
-18054,
-2731,
-65535,
-15947,
-39451,
-43881,
-27944,
-15780,
-25902,
-47442,
-53460,
-33732,
-6340,
-65535,
-8460,
-25983,
-30749,
-21552,
-11751,
-13181,
-24734,
-35016,
-34099,
-22681,
-10771,
-7881,
-14615,
-23642,
-28079,
-27320,
-24929,
-23788,
-25310,
-31191,
-41223,
-49368,
-46896,
-33380,
-21270,
-23620,
-37397,
-44841,
-35025,
-18925,
-16991,
-33325,
-49971,
-49736,
-38012,
-35279,
-50190,
-65532,
-65534,
-52953,
-32639,
-23429,
-26324,
-34324,
-42731,
-49934,
-53230,
-50135,
-43496,
-39716,
-40482,
-40101,
-33655,
-24585,
-20703,
-24392,
-31130,
-36737,
-41150,
-43245,
-37767,
-22438,
-5590,
-65535,
-7080,
-15701,
-15946,
-13336,
-20679,
-38400,
-51175,
-46741,
-32041,
-24314,
-29132,
-34897,
-30493,
-20861,
-19535,
-29510,
-39346,
-39101,
-33373,
-34070,
-43973,
-53683,
-54673,
-49621,
-46788,
-48061,
-47381,
-40659,
-32421,
-30327,
-35595,
-41889,
-43354,
-41014,
-40102,
-42849,
-45738,
-43943,
-37137,
-30183,
-28352,
-32431,
-38649,
-42893,
-44117,
-43473,
-41176,
-36356,
-30218,
-27267,
-30615,
-36345,
-35727,
-25222,
-12783,
-10839,
-22262,
-35760,
-37368,
-25570,
-12841,
-12228,
-24344,
-38296,
-43463,
-38596,
-30572,
-26794,
-29502,
-35220,
-38160,
-34887,
-27618,
-22886,
-25662,
-34171,
-41532,
-42985,
-40374,
-38582,
-38748,
-37182,
-31278,
-24351,
-22917,
-29519,
-39961,
-47392,
-48402,
-44601,
-39982,
-37861,
-39489,
-43983,
-48522,
-49860,
-46557,
-40257,
-34470,
-32073,
-33719,
-38061,
-43060,
-47238,
-50250,
-52111,
-52034,
-48704,
-42439,
-36573,
-34659,
-36002,
-35815,
-31606,
-27977,
-31519,
-40780,
-44970,
-36415,
-21928,
-16991,
-27178,
-40139,
-39837,
-26267,
-15301,
-18385,
-28299,
-29313,
-18036,
-7368,
-9256,
-19792,
-25906,
-23065,
-19640,
-23791,
-32007,
-35115,
-31437,
-28360,
-30993,
-34872,
-33170,
-27184,
-25148,
-30796,
-37786,
-37387,
-29158,
-21388,
-21702,
-29667,
-38738,
-43079,
-42006,
-39041,
-38330,
-41017,
-44167,
-43597,
-38894,
-34812,
-36139,
-41563,
-44925,
-43329,
-41395,
-45104,
-52985,
-57095,
-53242,
-46524,
-44096,
-44967,
-41516,
-31269,
-22495,
-24712,
-35818,
-43000,
-37366,
-24485,
-18163,
-25248,
-38884,
-46636,
-42996,
-33183,
-26247,
-26156,
-29378,
-29955,
-26074,
-21585,
-21030,
-24068,
-26011,
-24333,
-22551,
-25646,
-32388,
-35656,
-31626,
-25769,
-26404,
-33614,
-38806,
-36328,
-31203,
-31942,
-38127,
-40606,
-34453,
-26432,
-26249,
-33614,
-39145,
-37120,
-31790,
-29462,
-29465,
-27808,
-26234,
-30757,
-40257,
-43652,
-33352,
-17999,
-14612,
-27790,
-43108,
-44546,
-34224,
-28864,
-38238,
-53494,
-59167,
-51644,
-40903,
-36273,
-36637,
-35965,
-33502,
-34020,
-39755,
-46684,
-49794,
-49053,
-48106,
-48816,
-49462,
-47828,
-43910,
-38818,
-32932,
-26288,
-20404,
-17881,
-19925,
-24552,
-27842,
-27448,
-24894,
-24297,
-27838,
-32464,
-32477,
-26703,
-21912,
-26316,
-38870,
-48003,
-43720,
-30055,
-21500,
-26437,
-37286,
-40276,
-32457,
-24549,
-26355,
-34108,
-35873,
-27216,
-16579,
-14523,
-21643,
-29570,
-31691,
-28870,
-25724,
-24641,
-25630,
-28602,
-33217,
-36958,
-36573,
-32015,
-27235,
-26051,
-28522,
-32281,
-35688,
-38152,
-38369,
-35329,
-31337,
-31313,
-37120,
-44244,
-46463,
-43194,
-39357,
-37876,
-35660,
-29674,
-24074,
-27050,
-39450,
-50873,
-50057,
-37804,
-26002,
-23822,
-28215,
-29951,
-26237,
-23625,
-28207,
-37020,
-41424,
-38039,
-32783,
-33434,
-39966,
-44276,
-39574,
-28394,
-20514,
-22905,
-32684,
-40336,
-39652,
-33590,
-29782,
-31181,
-32905,
-28871,
-19968,
-13342,
-13917,
-19080,
-23023,
-24361,
-26262,
-29940,
-31688,
-28779,
-25324,
-28131,
-36876,
-42791,
-39646,
-32994,
-33995,
-44607,
-53627,
-50050,
-36757,
-26888,
-27564,
-32579,
-32673,
-28514,
-28520,
-35650,
-42247,
-40374,
-32776,
-28993,
-32186,
-35200,
-31227,
-24025,
-23139,
-30769,
-38358,
-37576,
-31266,
-29500,
-36589,
-45342,
-45866,
-37148,
-27760,
-25850,
-30833,
-35468,
-34590,
-30289,
-28833,
-33393,
-40481,
-43515,
-39907,
-33841,
-31531,
-33724,
-34767,
-30040,
-22937,
-21920,
-29967,
-39865,
-41970,
-35605,
-29445,
-30343,
-34953,
-34836,
-27860,
-20817,
-20469,
-25460,
-29364,
-29308,
-28175,
-28674,
-29277,
-27717,
-25724,
-26818,
-30301,
-31240,
-27639,
-24537,
-28000,
-36338,
-40864,
-36306,
-27704,
-24775,
-30573,
-38559,
-40793,
-36896,
-33255,
-35000,
-40659,
-44717,
-43731,
-39196,
-35364,
-35053,
-37282,
-38381,
-35746,
-31001,
-28948,
-32550,
-39187,
-43195,
-42315,
-40244,
-41564,
-45537,
-46906,
-43025,
-37615,
-35852,
-37392,
-36932,
-31827,
-26310,
-26240,
-31438,
-35813,
-35057,
-31515,
-29937,
-30713,
-29961,
-26070,
-22961,
-25228,
-31678,
-36268,
-35166,
-30829,
-28143,
-28471,
-29242,
-28655,
-28269,
-30175,
-33227,
-33974,
-30911,
-26489,
-24335,
-25553,
-28189,
-29561,
-28463,
-25482,
-22692,
-22734,
-26931,
-33279,
-37114,
-35349,
-30217,
-27688,
-31315,
-38156,
-41686,
-38743,
-32750,
-29757,
-32115,
-36546,
-38248,
-35829,
-32034,
-30420,
-31950,
-34876,
-36853,
-36998,
-35932,
-34782,
-34223,
-34454,
-35383,
-36856,
-38486,
-39870,
-40779,
-41368,
-41925,
-42526,
-43043,
-43307,
-43097,
-41997,
-39684,
-36787,
-35069,
-36014,
-38891,
-40759,
-39205,
-35097,
-31845,
-31735,
-33204,
-32648,
-28580,
-23503,
-21315,
-23201,
-26597,
-27777,
-25377,
-21350,
-19105,
-20573,
-24451,
-27083,
-25620,
-21042,
-17779,
-19666,
-25884,
-31739,
-33447,
-31818,
-30378,
-30876,
-31736,
-31073,
-29502,
-28845,
-29168,
-28898,
-28009,
-28877,
-32879,
-37283,
-37982,
-34950,
-32958,
-35545,
-40158,
-41465,
-38724,
-37061,
-40343,
-45251,
-45211,
-39300,
-34163,
-35755,
-41793,
-44821,
-41712,
-36929,
-35668,
-36890,
-35769,
-31428,
-28699,
-31183,
-35772,
-36487,
-32479,
-29022,
-30219,
-33751,
-34751,
-32996,
-32934,
-36741,
-40379,
-38814,
-33079,
-29498,
-31713,
-36323,
-37655,
-35110,
-33342,
-35566,
-39304,
-39733,
-35862,
-31342,
-29712,
-30535,
-30831,
-29004,
-26361,
-25142,
-26269,
-28824,
-30962,
-31051,
-28972,
-26561,
-26327,
-28717,
-31062,
-30332,
-26893,
-24628,
-26640,
-31378,
-34225,
-32653,
-28990,
-27646,
-30388,
-35022,
-38218,
-38642,
-37397,
-36315,
-36629,
-38562,
-41149,
-42414,
-40590,
-36084,
-31841,
-31123,
-34300,
-38381,
-39866,
-38288,
-36425,
-37032,
-39482,
-40412,
-37599,
-32997,
-30799,
-32712,
-35704,
-35486,
-31708,
-28435,
-29169,
-32452,
-33987,
-32322,
-30653,
-32025,
-34792,
-34664,
-30975,
-28107,
-29746,
-33549,
-34030,
-29930,
-26166,
-27291,
-31509,
-33396,
-31532,
-30238,
-33131,
-37594,
-38349,
-34949,
-32769,
-35559,
-40053,
-40047,
-34743,
-30048,
-31219,
-36428,
-39363,
-36921,
-32209,
-29984,
-31044,
-32165,
-30520,
-26861,
-24567,
-26488,
-32541,
-39443,
-42718,
-40263,
-34662,
-31303,
-33173,
-37732,
-39929,
-38079,
-35487,
-35898,
-38717,
-40103,
-38079,
-34718,
-32970,
-32894,
-32389,
-30524,
-28571,
-27632,
-27142,
-26444,
-26613,
-29098,
-32897,
-34804,
-33089,
-29801,
-28453,
-29929,
-31864,
-31941,
-30654,
-30146,
-31308,
-32723,
-32674,
-31011,
-29164,
-28514,
-29243,
-30445,
-31174,
-31476,
-32406,
-34635,
-37085,
-37459,
-34963,
-31716,
-30724,
-32168,
-33029,
-31079,
-28063,
-27701,
-30704,
-33711,
-33697,
-31865,
-31671,
-33791,
-35372,
-34504,
-33144,
-34117,
-36388,
-36144,
-32428,
-29303,
-30770,
-35169,
-36972,
-33908,
-29758,
-29251,
-32039,
-33763,
-32179,
-29726,
-29623,
-31537,
-32709,
-32117,
-31516,
-32274,
-33439,
-33529,
-33025,
-33414,
-34581,
-34915,
-33964,
-33502,
-34835,
-36605,
-36460,
-34487,
-33250,
-34126,
-35234,
-33944,
-30564,
-27941,
-27916,
-29358,
-30341,
-30631,
-31224,
-32176,
-32529,
-32152,
-32275,
-33504,
-34522,
-33850,
-32286,
-32220,
-34391,
-36642,
-36649,
-34897,
-33984,
-35172,
-36966,
-37295,
-36091,
-34978,
-35036,
-35794,
-36307,
-36185,
-35542,
-34636,
-34079,
-34829,
-36890,
-38645,
-38159,
-35548,
-33221,
-33112,
-34511,
-35012,
-33681,
-32011,
-31890,
-33204,
-34199,
-33655,
-32004,
-30479,
-29891,
-30380,
-31665,
-33091,
-33839,
-33709,
-33523,
-34156,
-35265,
-35483,
-34202,
-32474,
-31823,
-32529,
-33617,
-34278,
-34448,
-34150,
-33151,
-31926,
-31873,
-33754,
-36041,
-36258,
-34151,
-32336,
-33083,
-35130,
-35315,
-32940,
-30971,
-32073,
-34894,
-35692,
-33322,
-30626,
-30536,
-32198,
-32475,
-30362,
-28259,
-28567,
-30584,
-31793,
-31243,
-30322,
-30330,
-30767,
-30631,
-30212,
-30801,
-32653,
-34587,
-35416,
-35228,
-34804,
-34581,
-34547,
-34781,
-35341,
-35855,
-35828,
-35430,
-35194,
-35059,
-34315,
-33062,
-32659,
-33940,
-35366,
-34519,
-31578,
-29893,
-31929,
-35603,
-36423,
-33229,
-30007,
-30980,
-35141,
-37526,
-35386,
-31427,
-29969,
-31761,
-33872,
-34022,
-32994,
-32471,
-32417,
-31754,
-30880,
-31394,
-33573,
-35334,
-34786,
-32706,
-31599,
-32478,
-33861,
-33799,
-32198,
-30472,
-29874,
-30514,
-31751,
-32630,
-32326,
-30907,
-29827,
-30597,
-32783,
-34106,
-33244,
-31849,
-32461,
-34901,
-36121,
-34434,
-32115,
-32568,
-35487,
-37026,
-35065,
-32302,
-32630,
-35642,
-36983,
-34294,
-30499,
-29939,
-32650,
-34642,
-33469,
-31340,
-31653,
-34267,
-35956,
-34984,
-33124,
-32661,
-33131,
-32490,
-30560,
-29545,
-30816,
-32791,
-32892,
-30938,
-29326,
-29998,
-32226,
-33669,
-33054,
-31190,
-29863,
-30153,
-31698,
-33100,
-33109,
-31906,
-31086,
-32018,
-33972,
-34741,
-33314,
-31373,
-31373,
-33367,
-34913,
-34226,
-32382,
-31667,
-32480,
-33136,
-32627,
-31957,
-32354,
-33010,
-32398,
-30872,
-30734,
-32905,
-35164,
-34811,
-32419,
-31307,
-33233,
-35966,
-36242,
-33949,
-32165,
-33046,
-35199,
-35800,
-34212,
-32537,
-32695,
-34233,
-35262,
-34776,
-33481,
-32616,
-32727,
-33384,
-33764,
-33269,
-32075,
-31088,
-31076,
-31691,
-31850,
-31183,
-30672,
-31274,
-32323,
-32291,
-31064,
-30459,
-31808,
-33844,
-34197,
-32617,
-31409,
-32099,
-33166,
-32222,
-29738,
-28739,
-30492,
-32313,
-31046,
-27655,
-26415,
-29275,
-33076,
-33420,
-30369,
-28195,
-29850,
-33372,
-34791,
-33225,
-31501,
-32088,
-34151,
-35236,
-34546,
-33437,
-33156,
-33386,
-33362,
-33140,
-33231,
-33512,
-33352,
-32690,
-32244,
-32489,
-33137,
-33661,
-34027,
-34355,
-34505,
-34377,
-34397,
-34961,
-35442,
-34709,
-32881,
-31773,
-32799,
-34852,
-35407,
-33836,
-32281,
-32840,
-34530,
-34638,
-32499,
-30637,
-31360,
-33617,
-34394,
-32842,
-31333,
-32086,
-34078,
-34505,
-32649,
-30864,
-31398,
-33536,
-34660,
-33577,
-31630,
-30718,
-31091,
-31692,
-31730,
-31436,
-31202,
-31132,
-31123,
-31236,
-31428,
-31425,
-31136,
-30896,
-31004,
-31252,
-31219,
-31053,
-31252,
-31807,
-32023,
-31616,
-31409,
-32251,
-33566,
-33781,
-32523,
-31432,
-32208,
-34248,
-35217,
-34021,
-32168,
-31832,
-33117,
-34223,
-33924,
-32897,
-32386,
-32493,
-32477,
-32255,
-32484,
-33308,
-33795,
-33268,
-32349,
-32193,
-32850,
-33291,
-32974,
-32592,
-32942,
-33631,
-33729,
-33172,
-32923,
-33456,
-34060,
-33950,
-33461,
-33506,
-34084,
-34212,
-33425,
-32519,
-32396,
-32730,
-32521,
-31724,
-31337,
-31854,
-32328,
-31700,
-30425,
-30009,
-30953,
-32051,
-32016,
-31082,
-30482,
-30712,
-31121,
-31117,
-30927,
-30975,
-31075,
-30978,
-30998,
-31559,
-32105,
-31603,
-30244,
-29832,
-31492,
-33798,
-34050,
-31760,
-29514,
-29865,
-32136,
-33413,
-32390,
-30976,
-31525,
-33756,
-35308,
-34977,
-34039,
-34118,
-34957,
-35173,
-34504,
-34185,
-34973,
-35933,
-35750,
-34700,
-34197,
-34891,
-35710,
-35401,
-34203,
-33438,
-33903,
-34960,
-35491,
-35049,
-34092,
-33351,
-33272,
-33743,
-34171,
-33941,
-33109,
-32502,
-32681,
-33151,
-32795,
-31584,
-30793,
-31409,
-32530,
-32411,
-30825,
-29625,
-30299,
-31879,
-32146,
-30681,
-29474,
-30215,
-31962,
-32523,
-31509,
-30867,
-31927,
-33529,
-33575,
-32108,
-31174,
-31945,
-33021,
-32505,
-30815,
-30198,
-31683,
-33589,
-33754,
-32326,
-31470,
-32488,
-34247,
-34713,
-33450,
-31894,
-31589,
-32554,
-33619,
-33712,
-32804,
-31732,
-31454,
-32234,
-33340,
-33768,
-33278,
-32769,
-33158,
-34221,
-34858,
-34544,
-33997,
-34023,
-34344,
-34165,
-33664,
-34014,
-35526,
-36655,
-35755,
-33397,
-31991,
-32758,
-34043,
-33499,
-31203,
-29726,
-30760,
-33023,
-33930,
-32835,
-31425,
-31155,
-31440,
-30872,
-29573,
-29046,
-30075,
-31515,
-31810,
-31030,
-30686,
-31731,
-33297,
-33752,
-32583,
-30891,
-30225,
-31017,
-32368,
-32957,
-32401,
-31519,
-31463,
-32326,
-33036,
-32676,
-31821,
-31899,
-33252,
-34390,
-33860,
-32351,
-32042,
-33705,
-35385,
-34828,
-32508,
-31210,
-32331,
-34012,
-33655,
-31567,
-30688,
-32531,
-34970,
-34818,
-32003,
-29744,
-30557,
-33386,
-35315,
-35218,
-34552,
-34759,
-35238,
-34577,
-32860,
-31639,
-31809,
-32418,
-32207,
-31471,
-31689,
-33338,
-34914,
-34443,
-31808,
-29024,
-28297,
-29863,
-31880,
-32371,
-31240,
-30348,
-31390,
-33847,
-35266,
-33907,
-30843,
-28878,
-29444,
-31154,
-31819,
-31267,
-31222,
-32520,
-33675,
-32951,
-31084,
-30496,
-31975,
-33295,
-32258,
-29993,
-29861,
-32990,
-36384,
-36410,
-33305,
-30827,
-31576,
-33902,
-34367,
-32134,
-29813,
-29993,
-32204,
-33915,
-33731,
-32526,
-31821,
-31749,
-31462,
-30593,
-29913,
-30334,
-31752,
-33127,
-33421,
-32653,
-31920,
-32406,
-34037,
-35252,
-34593,
-32541,
-31403,
-32636,
-34872,
-35279,
-33040,
-30619,
-30799,
-33239,
-34941,
-34054,
-32095,
-31582,
-32634,
-33095,
-31860,
-30520,
-30981,
-32641,
-33214,
-32174,
-31626,
-33292,
-35740,
-35964,
-33325,
-30504,
-30126,
-31605,
-32349,
-31383,
-30480,
-31477,
-33633,
-34676,
-33744,
-32405,
-32389,
-33479,
-34023,
-33233,
-32140,
-32146,
-33351,
-34374,
-33971,
-32232,
-30572,
-30340,
-31629,
-33135,
-33413,
-32343,
-31213,
-31245,
-32133,
-32524,
-31776,
-30813,
-30847,
-31735,
-32304,
-32054,
-31857,
-32521,
-33446,
-33449,
-32591,
-32274,
-33180,
-34136,
-33649,
-32173,
-31766,
-33352,
-35398,
-35787,
-34536,
-33577,
-34152,
-35324,
-35517,
-34685,
-34126,
-34507,
-35052,
-34850,
-34164,
-33817,
-33802,
-33293,
-32022,
-30873,
-30831,
-31678,
-32388,
-32277,
-31613,
-30942,
-30517,
-30476,
-30902,
-31688,
-32265,
-32362,
-32391,
-32918,
-33530,
-33117,
-31379,
-29646,
-29498,
-30835,
-32035,
-32005,
-31437,
-31629,
-32662,
-33519,
-33649,
-33578,
-33739,
-33602,
-32574,
-31333,
-31232,
-32449,
-33604,
-33591,
-33040,
-33248,
-34095,
-34071,
-32580,
-31013,
-31074,
-32381,
-33085,
-32389,
-31687,
-32475,
-34147,
-34778,
-33746,
-32575,
-32839,
-34092,
-34638,
-33813,
-32724,
-32611,
-33331,
-33867,
-33774,
-33549,
-33658,
-33922,
-33941,
-33642,
-33203,
-32646,
-32079,
-31842,
-32227,
-32884,
-33106,
-32780,
-32608,
-33090,
-33703,
-33460,
-32257,
-31040,
-30612,
-30776,
-30977,
-31203,
-31799,
-32529,
-32639,
-32078,
-31762,
-32385,
-33170,
-32832,
-31509,
-30871,
-32017,
-33827,
-34314,
-33160,
-32046,
-32380,
-33540,
-33975,
-33393,
-32914,
-33240,
-33649,
-33312,
-32719,
-33042,
-34264,
-34997,
-34335,
-33192,
-33168,
-34484,
-35768,
-35779,
-34761,
-33778,
-33336,
-33091,
-32672,
-32231,
-32208,
-32876,
-34197,
-35652,
-36161,
-34824,
-32035,
-29734,
-29530,
-30978,
-32017,
-31631,
-31124,
-32206,
-34423,
-35401,
-33893,
-31494,
-30683,
-31818,
-32983,
-32653,
-31463,
-30853,
-31151,
-31572,
-32016,
-33147,
-34913,
-35648,
-33972,
-30743,
-28443,
-28317,
-29172,
-29363,
-29073,
-29984,
-32635,
-35321,
-35785,
-33587,
-30431,
-28383,
-28357,
-29876,
-31796,
-32971,
-32885,
-32027,
-31457,
-31714,
-32235,
-32178,
-31658,
-31555,
-32291,
-33083,
-33005,
-32153,
-31417,
-31315,
-31663,
-32396,
-33733,
-35251,
-35475,
-33431,
-30444,
-29245,
-30884,
-33298,
-33659,
-31814,
-30210,
-30590,
-31880,
-32034,
-31093,
-31010,
-32650,
-34264,
-33776,
-31685,
-30488,
-31497,
-33295,
-33903,
-33405,
-33570,
-35058,
-36341,
-35590,
-33137,
-31245,
-31731,
-34307,
-37135,
-38592,
-38274,
-36879,
-35534,
-34986,
-35100,
-35110,
-34525,
-33799,
-33691,
-34187,
-34380,
-33764,
-32942,
-32840,
-33225,
-33036,
-31836,
-30532,
-30035,
-30024,
-29717,
-29557,
-30925,
-33942,
-36377,
-35985,
-33340,
-31370,
-31819,
-33166,
-32947,
-31146,
-30198,
-31483,
-33377,
-33465,
-31900,
-31208,
-32799,
-35050,
-35401,
-33595,
-31720,
-31351,
-31852,
-31792,
-31128,
-31005,
-31867,
-32730,
-32638,
-31942,
-31637,
-31848,
-31749,
-30891,
-29901,
-29647,
-30069,
-30432,
-30355,
-30142,
-30167,
-30295,
-30220,
-29900,
-29562,
-29336,
-29414,
-30101,
-31564,
-33194,
-33985,
-33497,
-32490,
-31961,
-32174,
-32587,
-33001,
-33726,
-34695,
-34911,
-33503,
-31231,
-30019,
-30856,
-32555,
-33245,
-32626,
-32176,
-32941,
-34077,
-33908,
-32237,
-30761,
-31062,
-32842,
-34280,
-34045,
-32479,
-30977,
-30647,
-31606,
-33170,
-34467,
-34921,
-34563,
-33906,
-33399,
-33088,
-32804,
-32633,
-32868,
-33537,
-34130,
-34240,
-34002,
-33905,
-33936,
-33681,
-33040,
-32657,
-33061,
-33765,
-33666,
-32560,
-31551,
-31791,
-32990,
-33749,
-33317,
-32354,
-31967,
-32304,
-32719,
-32860,
-33061,
-33572,
-33980,
-33889,
-33669,
-34002,
-34788,
-34978,
-34015,
-32678,
-32282,
-33046,
-33777,
-33415,
-32195,
-31266,
-31274,
-31861,
-32312,
-32282,
-31726,
-30705,
-29499,
-28821,
-29200,
-30312,
-31124,
-31016,
-30467,
-30390,
-31006,
-31713,
-31987,
-32062,
-32505,
-33457,
-34523,
-35292,
-35621,
-35497,
-34980,
-34452,
-34524,
-35419,
-36484,
-36745,
-35959,
-34833,
-34180,
-34064,
-34050,
-34023,
-34246,
-34769,
-35079,
-34723,
-33879,
-33110,
-32573,
-32089,
-31699,
-31902,
-32828,
-33749,
-33769,
-33053,
-32704,
-33323,
-34145,
-33966,
-32763,
-31739,
-31816,
-32555,
-32928,
-32697,
-32533,
-32876,
-33343,
-33421,
-33347,
-33644,
-34158,
-34061,
-33040,
-31949,
-31947,
-33061,
-34206,
-34433,
-33935,
-33596,
-33934,
-34715,
-35379,
-35482,
-34775,
-33371,
-31949,
-31491,
-32316,
-33607,
-34120,
-33556,
-32737,
-32486,
-32587,
-32304,
-31583,
-31185,
-31519,
-31919,
-31475,
-30424,
-30063,
-31229,
-33247,
-34657,
-34678,
-33719,
-32567,
-31712,
-31383,
-31759,
-32652,
-33307,
-33087,
-32342,
-32091,
-32629,
-32875,
-31801,
-29994,
-29355,
-30667,
-32506,
-32853,
-31788,
-31418,
-33096,
-35308,
-35226,
-32056,
-28279,
-27240,
-30014,
-34779,
-38496,
-38899,
-35424,
-29802,
-25862,
-27380,
-34274,
-41302,
-42005,
-35224,
-26801,
-23951,
-27884,
-33295,
-34866,
-32901,
-31458,
-32448,
-33709,
-33312,
-33070,
-35921,
-40682,
-42227,
-37811,
-31203,
-28663,
-31371,
-34306,
-32902,
-28813,
-27249,
-29775,
-32338,
-30850,
-26615,
-24342,
-26007,
-28817,
-29522,
-28626,
-28861,
-31058,
-33343,
-34528,
-35778,
-38066,
-39583,
-37737,
-33542,
-31514,
-34397,
-39130,
-40045,
-35484,
-29630,
-27299,
-28478,
-29349,
-27848,
-26081,
-26969,
-29946,
-31711,
-30621,
-28804,
-29290,
-32101,
-34336,
-33808,
-31603,
-30585,
-32025,
-34409,
-35415,
-34386,
-32651,
-31747,
-31953,
-32546,
-33059,
-33776,
-34863,
-35514,
-34480,
-31688,
-28979,
-28633,
-31116,
-34492,
-36454,
-36537,
-36145,
-36411,
-36827,
-36247,
-34697,
-33467,
-33445,
-33918,
-33694,
-32666,
-31913,
-32018,
-32325,
-31886,
-31057,
-31087,
-32509,
-34224,
-34653,
-33443,
-31653,
-30574,
-30594,
-31390,
-32570,
-33891,
-35030,
-35541,
-35346,
-34816,
-34525,
-34620,
-34782,
-34504,
-33536,
-32128,
-30922,
-30555,
-31040,
-31693,
-31741,
-31091,
-30459,
-30411,
-30924,
-31559,
-32201,
-32942,
-33391,
-32818,
-31154,
-29686,
-29879,
-31549,
-32895,
-32510,
-31197,
-30829,
-31916,
-32820,
-31934,
-29807,
-28522,
-29128,
-30547,
-31226,
-31060,
-31032,
-31494,
-31750,
-31547,
-31834,
-33322,
-34801,
-34151,
-31255,
-28850,
-29653,
-32923,
-35108,
-34004,
-31458,
-31049,
-33686,
-36417,
-36046,
-32809,
-29958,
-29812,
-31532,
-32664,
-32274,
-31523,
-31656,
-32405,
-32796,
-32762,
-33154,
-34188,
-34895,
-34347,
-33127,
-32694,
-33501,
-34347,
-33916,
-32514,
-31718,
-32305,
-33380,
-33560,
-32811,
-32361,
-33002,
-34018,
-34182,
-33271,
-32279,
-32070,
-32426,
-32558,
-32228,
-31851,
-31820,
-31963,
-32003,
-32014,
-32202,
-32370,
-32093,
-31375,
-30883,
-31228,
-32173,
-32873,
-32816,
-32259,
-31822,
-31757,
-31925,
-32140,
-32331,
-32346,
-32052,
-31595,
-31474,
-31945,
-32612,
-32809,
-32441,
-32099,
-32316,
-32809,
-32900,
-32438,
-31959,
-32009,
-32410,
-32662,
-32630,
-32696,
-33065,
-33484,
-33568,
-33333,
-33015,
-32592,
-31920,
-31199,
-31049,
-31757,
-32657,
-32835,
-32119,
-31325,
-31176,
-31478,
-31566,
-31367,
-31416,
-31974,
-32447,
-32218,
-31602,
-31564,
-32368,
-33149,
-32962,
-32109,
-31735,
-32401,
-33279,
-33311,
-32480,
-31806,
-32002,
-32681,
-33020,
-32817,
-32523,
-32475,
-32422,
-32092,
-31691,
-31736,
-32250,
-32687,
-32482,
-31759,
-31077,
-30880,
-31079,
-31399,
-31708,
-32128,
-32660,
-33071,
-32996,
-32377,
-31584,
-31230,
-31540,
-32150,
-32399,
-32127,
-31848,
-32164,
-32882,
-33192,
-32597,
-31688,
-31434,
-32030,
-32624,
-32450,
-31855,
-31820,
-32635,
-33477,
-33484,
-32949,
-32879,
-33638,
-34360,
-34026,
-32770,
-31745,
-31784,
-32518,
-32986,
-32726,
-32129,
-31718,
-31614,
-31604,
-31605,
-31729,
-31947,
-32097,
-32024,
-31871,
-31861,
-32047,
-32292,
-32467,
-32566,
-32634,
-32615,
-32440,
-32124,
-31858,
-31866,
-32212,
-32746,
-33104,
-33082,
-32785,
-32553,
-32616,
-32800,
-32777,
-32505,
-32276,
-32338,
-32519,
-32446,
-32107,
-31869,
-32012,
-32238,
-32112,
-31616,
-31293,
-31500,
-31943,
-32029,
-31673,
-31387,
-31622,
-32182,
-32501,
-32350,
-32027,
-31895,
-31940,
-31931,
-31833,
-31863,
-32153,
-32548,
-32723,
-32579,
-32240,
-31965,
-31939,
-32153,
-32438,
-32510,
-32320,
-32064,
-32090,
-32363,
-32562,
-32423,
-32132,
-32065,
-32243,
-32305,
-32077,
-31878,
-32148,
-32749,
-33067,
-32798,
-32343,
-32317,
-32706,
-32996,
-32892,
-32739,
-32935,
-33300,
-33283,
-32802,
-32384,
-32473,
-32811,
-32788,
-32374,
-32124,
-32482,
-33087,
-33268,
-32875,
-32438,
-32468,
-32828,
-33013,
-32797,
-32439,
-32306,
-32444,
-32659,
-32761,
-32760,
-32696,
-32661,
-32694,
-32754,
-32733,
-32548,
-32329,
-32308,
-32495,
-32651,
-32553,
-32363,
-32373,
-32603,
-32685,
-32441,
-32143,
-32256,
-32732,
-33060,
-32878,
-32476,
-32341,
-32532,
-32618,
-32318,
-31915,
-31790,
-31932,
-31931,
-31652,
-31387,
-31472,
-31771,
-31945,
-31879,
-31843,
-32005,
-32218,
-32256,
-32202,
-32300,
-32595,
-32822,
-32813,
-32720,
-32784,
-32992,
-33093,
-32994,
-32846,
-32816,
-32839,
-32769,
-32637,
-32556,
-32547,
-32447,
-32224,
-32052,
-32061,
-32134,
-32042,
-31792,
-31647,
-31736,
-31911,
-31974,
-31958,
-32075,
-32284,
-32392,
-32286,
-32188,
-32294,
-32482,
-32467,
-32264,
-32179,
-32394,
-32665,
-32659,
-32430,
-32342,
-32506,
-32646,
-32516,
-32298,
-32365,
-32689,
-32860,
-32656,
-32370,
-32405,
-32673,
-32719,
-32379,
-32026,
-32074,
-32391,
-32498,
-32231,
-31918,
-31954,
-32222,
-32373,
-32258,
-32096,
-32137,
-32277,
-32343,
-32281,
-32237,
-32295,
-32376,
-32429,
-32469,
-32533,
-32581,
-32581,
-32601,
-32692,
-32743,
-32654,
-32477,
-32456,
-32613,
-32723,
-32590,
-32388,
-32467,
-32774,
-32911,
-32621,
-32255,
-32315,
-32775,
-33048,
-32795,
-32397,
-32444,
-32916,
-33179,
-32830,
-32314,
-32258,
-32734,
-33051,
-32808,
-32286,
-32161,
-32528,
-32903,
-32846,
-32528,
-32428,
-32678,
-32984,
-32993,
-32774,
-32615,
-32677,
-32843,
-32913,
-32834,
-32738,
-32752,
-32873,
-32941,
-32819,
-32553,
-32384,
-32468,
-32651,
-32618,
-32312,
-32089,
-32284,
-32740,
-32911,
-32594,
-32220,
-32380,
-32970,
-33323,
-33022,
-32471,
-32385,
-32814,
-33123,
-32829,
-32274,
-32150,
-32589,
-33008,
-32893,
-32485,
-32344,
-32672,
-32996,
-32925,
-32569,
-32402,
-32580,
-32818,
-32775,
-32491,
-32264,
-32290,
-32465,
-32560,
-32506,
-32391,
-32394,
-32524,
-32671,
-32650,
-32504,
-32423,
-32630,
-32969,
-33124,
-32924,
-32689,
-32801,
-33237,
-33486,
-33242,
-32782,
-32685,
-33005,
-33248,
-33001,
-32548,
-32463,
-32848,
-33155,
-32962,
-32529,
-32441,
-32818,
-33181,
-33105,
-32812,
-32742,
-32990,
-33171,
-33033,
-32798,
-32808,
-33035,
-33150,
-32976,
-32756,
-32743,
-32900,
-32966,
-32847,
-32701,
-32697,
-32807,
-32882,
-32876,
-32820,
-32781,
-32792,
-32891,
-33049,
-33129,
-33030,
-32850,
-32858,
-33096,
-33307,
-33185,
-32841,
-32673,
-32852,
-33094,
-33034,
-32765,
-32679,
-32919,
-33156,
-33075,
-32819,
-32808,
-33098,
-33309,
-33184,
-32942,
-32996,
-33301,
-33440,
-33195,
-32866,
-32860,
-33113,
-33207,
-32977,
-32709,
-32741,
-32998,
-33133,
-33004,
-32839,
-32835,
-32949,
-33009,
-33001,
-33067,
-33214,
-33331,
-33339,
-33342,
-33403,
-33455,
-33376,
-33224,
-33158,
-33207,
-33222,
-33127,
-33028,
-33052,
-33135,
-33116,
-33042,
-33076,
-33262,
-33359,
-33214,
-33018,
-33070,
-33343,
-33456,
-33216,
-32935,
-32992,
-33329,
-33460,
-33179,
-32822,
-32838,
-33126,
-33226,
-32939,
-32629,
-32698,
-33032,
-33201,
-33030,
-32827,
-32903,
-33169,
-33337,
-33332,
-33345,
-33492,
-33610,
-33561,
-33433,
-33426,
-33525,
-33544,
-33394,
-33266,
-33294,
-33406,
-33390,
-33249,
-33157,
-33207,
-33291,
-33269,
-33188,
-33159,
-33179,
-33139,
-33068,
-33071,
-33186,
-33234,
-33104,
-32952,
-33022,
-33295,
-33450,
-33330,
-33110,
-33119,
-33310,
-33388,
-33216,
-33021,
-33097,
-33366,
-33515,
-33435,
-33322,
-33364,
-33464,
-33414,
-33242,
-33168,
-33259,
-33317,
-33187,
-32998,
-32981,
-33148,
-33236,
-33147,
-33039,
-33137,
-33371,
-33494,
-33395,
-33252,
-33233,
-33304,
-33313,
-33236,
-33183,
-33223,
-33282,
-33302,
-33321,
-33375,
-33405,
-33311,
-33161,
-33061,
-33096,
-33128,
-33117,
-33107,
-33197,
-33321,
-33364,
-33363,
-33437,
-33625,
-33707,
-33590,
-33429,
-33484,
-33683,
-33683,
-33332,
-32963,
-32970,
-33291,
-33443,
-33188,
-32875,
-32936,
-33306,
-33477,
-33190,
-32831,
-32854,
-33246,
-33487,
-33313,
-32996,
-32943,
-33203,
-33387,
-33292,
-33072,
-32992,
-33109,
-33208,
-33172,
-33060,
-32959,
-32901,
-32850,
-32838,
-32898,
-33015,
-33146,
-33300,
-33450,
-33552,
-33516,
-33418,
-33385,
-33426,
-33402,
-33207,
-33039,
-33108,
-33390,
-33525,
-33363,
-33131,
-33200,
-33505,
-33640,
-33415,
-33178,
-33356,
-33860,
-34134,
-33893,
-33497,
-33457,
-33799,
-34032,
-33844,
-33481,
-33348,
-33511,
-33628,
-33507,
-33307,
-33275,
-33391,
-33434,
-33324,
-33210,
-33212,
-33287,
-33301,
-33265,
-33281,
-33392,
-33532,
-33631,
-33656,
-33610,
-33510,
-33451,
-33547,
-33729,
-33799,
-33611,
-33405,
-33484,
-33825,
-33994,
-33673,
-33148,
-32986,
-33328,
-33700,
-33616,
-33242,
-33123,
-33444,
-33747,
-33555,
-33028,
-32725,
-32889,
-33161,
-33147,
-32953,
-33005,
-33402,
-33757,
-33675,
-33278,
-32969,
-32993,
-33117,
-33079,
-32858,
-32692,
-32744,
-32909,
-33006,
-32919,
-32746,
-32637,
-32695,
-32855,
-32954,
-32887,
-32759,
-32777,
-32982,
-33195,
-33245,
-33212,
-33363,
-33696,
-33942,
-33847,
-33642,
-33716,
-34175,
-34606,
-34622,
-34334,
-34194,
-34334,
-34493,
-34340,
-34028,
-33863,
-33857,
-33685,
-33215,
-32794,
-32810,
-33152,
-33312,
-33023,
-32623,
-32538,
-32781,
-32939,
-32804,
-32598,
-32626,
-32869,
-33022,
-32985,
-32904,
-32964,
-33058,
-33035,
-32913,
-32893,
-33070,
-33283,
-33395,
-33398,
-33425,
-33484,
-33491,
-33385,
-33246,
-33162,
-33143,
-33151,
-33183,
-33255,
-33382,
-33538,
-33710,
-33858,
-33848,
-33613,
-33267,
-33079,
-33126,
-33149,
-32844,
-32302,
-31976,
-32122,
-32467,
-32529,
-32268,
-32138,
-32451,
-32972,
-33174,
-32982,
-32794,
-32972,
-33350,
-33521,
-33445,
-33418,
-33671,
-33997,
-34077,
-33965,
-33944,
-34147,
-34297,
-34098,
-33603,
-33157,
-32948,
-32883,
-32754,
-32551,
-32393,
-32339,
-32341,
-32310,
-32265,
-32199,
-32158,
-32164,
-32299,
-32545,
-32807,
-32987,
-33137,
-33321,
-33498,
-33522,
-33391,
-33327,
-33491,
-33740,
-33763,
-33491,
-33246,
-33297,
-33528,
-33546,
-33239,
-32919,
-32868,
-33009,
-32971,
-32710,
-32517,
-32623,
-32834,
-32809,
-32542,
-32396,
-32538,
-32757,
-32781,
-32762,
-32985,
-33228,
-32844,
-31774,
-31299,
-33001,
-36618,
-39217,
-37459,
-31389,
-25642,
-25998,
-33558,
-42581,
-44859,
-37455,
-26251,
-21087,
-26616,
-37732,
-44391,
-41160,
-31972,
-25533,
-26700,
-32699,
-37249,
-37127,
-34131,
-31676,
-31077,
-31532,
-32380,
-33878,
-35817,
-36665,
-35068,
-31752,
-29222,
-29411,
-32053,
-35269,
-37108,
-36501,
-33598,
-30137,
-28933,
-31589,
-36189,
-38240,
-35169,
-29674,
-27402,
-30831,
-36417,
-38445,
-35369,
-31002,
-29695,
-31666,
-33760,
-33816,
-32615,
-31768,
-31375,
-30892,
-30984,
-32890,
-35748,
-36440,
-33214,
-28694,
-27586,
-31312,
-36008,
-36828,
-33312,
-29599,
-29427,
-32243,
-34719,
-34933,
-34013,
-33841,
-34547,
-34899,
-34298,
-33428,
-32900,
-32403,
-31478,
-30664,
-30971,
-32437,
-33849,
-34166,
-33873,
-34169,
-35345,
-36229,
-35614,
-33816,
-32350,
-32346,
-33434,
-34309,
-34093,
-32979,
-31866,
-31595,
-32410,
-33849,
-34874,
-34609,
-33081,
-31467,
-31055,
-32028,
-33191,
-33228,
-32073,
-30855,
-30705,
-31654,
-32969,
-34049,
-34790,
-35184,
-35008,
-34255,
-33465,
-33270,
-33615,
-33701,
-33006,
-31975,
-31496,
-31787,
-32212,
-32257,
-32298,
-33002,
-34260,
-35050,
-34652,
-33516,
-32722,
-32752,
-33096,
-33078,
-32691,
-32374,
-32362,
-32576,
-33015,
-33829,
-34842,
-35356,
-34848,
-33733,
-32987,
-33030,
-33191,
-32676,
-31658,
-31165,
-31753,
-32798,
-33257,
-32901,
-32479,
-32663,
-33318,
-33789,
-33775,
-33457,
-33068,
-32602,
-32139,
-32053,
-32592,
-33393,
-33681,
-33143,
-32349,
-32155,
-32756,
-33521,
-33728,
-33327,
-32797,
-32598,
-32709,
-32901,
-33040,
-33178,
-33325,
-33398,
-33348,
-33270,
-33362,
-33656,
-33978,
-34025,
-33684,
-33143,
-32852,
-33132,
-33842,
-34426,
-34309,
-33448,
-32413,
-31902,
-32154,
-32755,
-33049,
-32762,
-32210,
-31970,
-32299,
-32895,
-33201,
-33012,
-32617,
-32536,
-32865,
-33254,
-33276,
-32987,
-32769,
-32941,
-33313,
-33548,
-33531,
-33504,
-33692,
-34008,
-34176,
-34096,
-33900,
-33773,
-33700,
-33560,
-33274,
-32899,
-32546,
-32373,
-32484,
-32868,
-33256,
-33363,
-33144,
-32921,
-32969,
-33165,
-33109,
-32677,
-32249,
-32277,
-32720,
-33102,
-33108,
-32932,
-32939,
-33105,
-33129,
-32902,
-32766,
-33007,
-33392,
-33353,
-32733,
-32080,
-32103,
-32894,
-33830,
-34225,
-33975,
-33522,
-33367,
-33592,
-33915,
-33978,
-33673,
-33164,
-32768,
-32608,
-32603,
-32523,
-32337,
-32224,
-32375,
-32742,
-33090,
-33243,
-33236,
-33195,
-33160,
-33134,
-33128,
-33157,
-33155,
-33005,
-32816,
-32844,
-33258,
-33805,
-34048,
-33835,
-33465,
-33345,
-33472,
-33520,
-33261,
-32864,
-32631,
-32611,
-32621,
-32514,
-32421,
-32538,
-32879,
-33265,
-33520,
-33595,
-33600,
-33649,
-33848,
-34133,
-34305,
-34172,
-33823,
-33584,
-33691,
-33994,
-34139,
-34057,
-34020,
-34224,
-34394,
-34127,
-33478,
-33062,
-33313,
-33889,
-34070,
-33567,
-32948,
-32816,
-33185,
-33491,
-33443,
-33288,
-33386,
-33604,
-33565,
-33193,
-32924,
-33074,
-33429,
-33465,
-33056,
-32598,
-32564,
-32925,
-33337,
-33513,
-33542,
-33554,
-33564,
-33454,
-33241,
-33072,
-33031,
-33049,
-33005,
-32877,
-32766,
-32780,
-32917,
-33114,
-33232,
-33203,
-33070,
-32952,
-32940,
-32919,
-32738,
-32398,
-32150,
-32202,
-32480,
-32656,
-32556,
-32370,
-32403,
-32739,
-33135,
-33320,
-33288,
-33180,
-33173,
-33253,
-33399,
-33515,
-33541,
-33432,
-33305,
-33337,
-33581,
-33861,
-33935,
-33792,
-33615,
-33542,
-33475,
-33352,
-33239,
-33320,
-33506,
-33512,
-33253,
-32995,
-33117,
-33520,
-33793,
-33686,
-33431,
-33426,
-33654,
-33759,
-33555,
-33260,
-33189,
-33322,
-33385,
-33358,
-33474,
-33889,
-34297,
-34302,
-33882,
-33472,
-33412,
-33582,
-33649,
-33422,
-33084,
-32794,
-32643,
-32650,
-32922,
-33415,
-33853,
-33905,
-33566,
-33193,
-33092,
-33217,
-33295,
-33207,
-33106,
-33132,
-33221,
-33233,
-33132,
-33058,
-33065,
-33132,
-33206,
-33336,
-33527,
-33674,
-33621,
-33345,
-32968,
-32648,
-32451,
-32421,
-32543,
-32792,
-33040,
-33223,
-33353,
-33457,
-33450,
-33234,
-32900,
-32730,
-32866,
-33091,
-33052,
-32753,
-32565,
-32803,
-33246,
-33450,
-33227,
-32910,
-32821,
-32923,
-32931,
-32785,
-32733,
-32932,
-33207,
-33282,
-33139,
-33039,
-33067,
-33077,
-32930,
-32747,
-32818,
-33111,
-33401,
-33476,
-33445,
-33455,
-33441,
-33230,
-32835,
-32573,
-32643,
-32934,
-33126,
-33121,
-33067,
-33114,
-33172,
-33105,
-32946,
-32875,
-32984,
-33154,
-33234,
-33224,
-33209,
-33228,
-33218,
-33157,
-33074,
-33046,
-33062,
-33122,
-33222,
-33344,
-33386,
-33289,
-33110,
-33026,
-33099,
-33215,
-33266,
-33283,
-33385,
-33539,
-33519,
-33229,
-32855,
-32722,
-32915,
-33190,
-33281,
-33166,
-33024,
-32969,
-32978,
-32993,
-33042,
-33096,
-33067,
-32858,
-32613,
-32539,
-32709,
-32931,
-32979,
-32876,
-32764,
-32752,
-32739,
-32697,
-32708,
-32870,
-33036,
-32973,
-32658,
-32402,
-32513,
-32909,
-33199,
-33120,
-32808,
-32614,
-32676,
-32827,
-32833,
-32676,
-32533,
-32565,
-32732,
-32890,
-32866,
-32648,
-32373,
-32237,
-32382,
-32700,
-32959,
-32977,
-32777,
-32567,
-32475,
-32538,
-32648,
-32765,
-32822,
-32791,
-32688,
-32637,
-32757,
-33023,
-33210,
-33143,
-32864,
-32615,
-32577,
-32704,
-32820,
-32802,
-32649,
-32452,
-32308,
-32328,
-32520,
-32777,
-32888,
-32822,
-32767,
-32914,
-33234,
-33391,
-33211,
-32842,
-32610,
-32689,
-32882,
-32981,
-32945,
-32877,
-32851,
-32811,
-32781,
-32820,
-32956,
-33023,
-32888,
-32636,
-32529,
-32682,
-32943,
-33053,
-33001,
-32926,
-32974,
-33063,
-33119,
-33121,
-33127,
-33102,
-32986,
-32862,
-32860,
-33029,
-33125,
-32949,
-32555,
-32254,
-32256,
-32456,
-32613,
-32626,
-32586,
-32572,
-32565,
-32531,
-32527,
-32616,
-32729,
-32745,
-32672,
-32634,
-32726,
-32839,
-32827,
-32701,
-32594,
-32609,
-32661,
-32699,
-32726,
-32822,
-32912,
-32871,
-32697,
-32553,
-32595,
-32757,
-32858,
-32828,
-32765,
-32769,
-32802,
-32776,
-32720,
-32703,
-32762,
-32767,
-32694,
-32621,
-32652,
-32759,
-32782,
-32680,
-32564,
-32546,
-32607,
-32632,
-32568,
-32514,
-32492,
-32508,
-32503,
-32515,
-32589,
-32645,
-32623,
-32509,
-32480,
-32585,
-32743,
-32774,
-32669,
-32601,
-32677,
-32850,
-32943,
-32917,
-32851,
-32811,
-32799,
-32785,
-32821,
-32926,
-33006,
-32943,
-32740,
-32593,
-32639,
-32802,
-32877,
-32757,
-32579,
-32517,
-32639,
-32820,
-32936,
-32916,
-32811,
-32691,
-32657,
-32739,
-32892,
-32977,
-32930,
-32808,
-32730,
-32742,
-32764,
-32751,
-32724,
-32754,
-32803,
-32798,
-32750,
-32765,
-32901,
-33047,
-33056,
-32930,
-32830,
-32880,
-32989,
-33038,
-33007,
-33026,
-33152,
-33254,
-33209,
-33048,
-32933,
-32952,
-33000,
-32953,
-32818,
-32703,
-32664,
-32653,
-32633,
-32621,
-32689,
-32777,
-32823,
-32782,
-32737,
-32737,
-32788,
-32813,
-32833,
-32854,
-32908,
-32960,
-32997,
-33059,
-33141,
-33193,
-33148,
-33032,
-32962,
-33007,
-33129,
-33212,
-33215,
-33155,
-33107,
-33071,
-33067,
-33049,
-33013,
-32925,
-32826,
-32784,
-32807,
-32806,
-32693,
-32505,
-32426,
-32521,
-32664,
-32623,
-32405,
-32218,
-32261,
-32438,
-32494,
-32353,
-32186,
-32199,
-32371,
-32510,
-32539,
-32550,
-32658,
-32802,
-32871,
-32868,
-32912,
-33065,
-33213,
-33244,
-33194,
-33201,
-33310,
-33394,
-33341,
-33170,
-33031,
-33005,
-33035,
-33038,
-32972,
-32882,
-32820,
-32791,
-32782,
-32739,
-32627,
-32485,
-32402,
-32468,
-32632,
-32758,
-32786,
-32770,
-32831,
-32933,
-32996,
-32976,
-32990,
-33120,
-33272,
-33317,
-33219,
-33143,
-33168,
-33202,
-33110,
-32953,
-32926,
-33104,
-33284,
-33265,
-33085,
-32966,
-33014,
-33067,
-32966,
-32771,
-32695,
-32784,
-32868,
-32789,
-32614,
-32549,
-32632,
-32739,
-32726,
-32631,
-32560,
-32538,
-32518,
-32496,
-32524,
-32624,
-32706,
-32720,
-32712,
-32784,
-32899,
-32962,
-32886,
-32800,
-32786,
-32880,
-32962,
-33015,
-33062,
-33122,
-33131,
-33062,
-33006,
-33066,
-33210,
-33260,
-33153,
-32991,
-32954,
-33021,
-33049,
-32949,
-32808,
-32746,
-32726,
-32647,
-32491,
-32395,
-32426,
-32519,
-32530,
-32464,
-32424,
-32484,
-32562,
-32598,
-32599,
-32653,
-32765,
-32847,
-32891,
-32938,
-33067,
-33203,
-33249,
-33200,
-33133,
-33128,
-33117,
-33038,
-32926,
-32878,
-32936,
-33005,
-32995,
-32911,
-32847,
-32842,
-32871,
-32875,
-32842,
-32790,
-32735,
-32705,
-32727,
-32787,
-32816,
-32752,
-32636,
-32584,
-32645,
-32734,
-32726,
-32641,
-32564,
-32602,
-32686,
-32735,
-32759,
-32794,
-32861,
-32893,
-32868,
-32867,
-32963,
-33100,
-33162,
-33080,
-32969,
-32928,
-32961,
-32989,
-32958,
-32912,
-32882,
-32828,
-32748,
-32689,
-32737,
-32853,
-32910,
-32848,
-32736,
-32721,
-32794,
-32886,
-32900,
-32883,
-32904,
-32964,
-33024,
-33058,
-33061,
-33037,
-32950,
-32846,
-32820,
-32904,
-33024,
-33011,
-32890,
-32787,
-32832,
-32981,
-33068,
-33037,
-32958,
-32913,
-32898,
-32878,
-32871,
-32931,
-32998,
-32991,
-32864,
-32775,
-32827,
-32967,
-33015,
-32875,
-32709,
-32658,
-32752,
-32823,
-32787,
-32705,
-32677,
-32709,
-32719,
-32683,
-32651,
-32653,
-32668,
-32647,
-32631,
-32663,
-32748,
-32814,
-32838,
-32844,
-32860,
-32856,
-32824,
-32799,
-32844,
-32921,
-32945,
-32879,
-32803,
-32798,
-32810,
-32758,
-32639,
-32558,
-32601,
-32686,
-32752,
-32816,
-32973,
-33144,
-33129,
-32842,
-32487,
-32387,
-32588,
-32824,
-32852,
-32762,
-32809,
-33097,
-33341,
-33300,
-32996,
-32731,
-32681,
-32776,
-32829,
-32859,
-32987,
-33260,
-33505,
-33525,
-33271,
-32912,
-32622,
-32495,
-32518,
-32638,
-32794,
-32926,
-32972,
-32926,
-32818,
-32706,
-32655,
-32687,
-32754,
-32750,
-32613,
-32408,
-32313,
-32407,
-32616,
-32742,
-32728,
-32644,
-32610,
-32591,
-32492,
-32295,
-32139,
-32167,
-32392,
-32700,
-32975,
-33154,
-33236,
-33237,
-33229,
-33277,
-33350,
-33352,
-33206,
-33046,
-33028,
-33135,
-33147,
-32913,
-32602,
-32515,
-32706,
-32875,
-32735,
-32359,
-32053,
-31988,
-32002,
-31985,
-32021,
-32294,
-32607,
-32588,
-32102,
-31583,
-31515,
-31858,
-32076,
-31864,
-31574,
-31790,
-32525,
-33142,
-33072,
-32479,
-32014,
-32109,
-32557,
-32958,
-33179,
-33380,
-33686,
-33984,
-34146,
-34155,
-34090,
-33995,
-33960,
-34143,
-34549,
-34831,
-34550,
-33745,
-33131,
-33353,
-34200,
-34661,
-34014,
-32701,
-31787,
-31869,
-32405,
-32607,
-32329,
-32154,
-32414,
-32694,
-32396,
-31602,
-31052,
-31265,
-31927,
-32371,
-32418,
-32475,
-32868,
-33354,
-33462,
-33205,
-32996,
-33066,
-33085,
-32720,
-32260,
-32410,
-33344,
-34267,
-34117,
-32809,
-31385,
-31049,
-31996,
-33359,
-34178,
-34218,
-33890,
-33644,
-33560,
-33492,
-33332,
-33106,
-32840,
-32613,
-32513,
-32598,
-32721,
-32643,
-32312,
-32062,
-32277,
-32961,
-33631,
-33768,
-33342,
-32726,
-32273,
-31989,
-31776,
-31765,
-32203,
-33020,
-33669,
-33611,
-32962,
-32397,
-32441,
-32834,
-32923,
-32499,
-32199,
-32791,
-34208,
-35471,
-35593,
-34585,
-33381,
-32881,
-33190,
-33680,
-33752,
-33354,
-32845,
-32628,
-32738,
-32904,
-32726,
-32038,
-31201,
-30910,
-31655,
-33050,
-34093,
-33996,
-33068,
-32345,
-32479,
-33056,
-33147,
-32528,
-31982,
-32424,
-33702,
-34723,
-34483,
-33139,
-31706,
-31100,
-31339,
-31835,
-32024,
-31880,
-31777,
-32048,
-32692,
-33303,
-33450,
-33087,
-32670,
-32757,
-33378,
-33962,
-33885,
-33162,
-32417,
-32275,
-32848,
-33785,
-34683,
-35170,
-34969,
-34026,
-32864,
-32273,
-32579,
-33144,
-33027,
-32138,
-31389,
-31649,
-32671,
-33496,
-33712,
-33785,
-34151,
-34249,
-33272,
-31529,
-30618,
-31646,
-33835,
-35181,
-34726,
-33480,
-33033,
-33579,
-33866,
-32996,
-31734,
-31589,
-32972,
-34619,
-34972,
-33838,
-32457,
-32116,
-32907,
-33797,
-33782,
-32772,
-31611,
-31152,
-31582,
-32295,
-32601,
-32346,
-31875,
-31558,
-31391,
-31222,
-31134,
-31352,
-31907,
-32454,
-32707,
-32673,
-32502,
-32047,
-31133,
-30094,
-29781,
-30695,
-32160,
-32905,
-32397,
-31448,
-31219,
-31907,
-32657,
-32800,
-32629,
-32911,
-33778,
-34526,
-34434,
-33484,
-32281,
-31462,
-31329,
-31864,
-32698,
-33303,
-33351,
-33073,
-32960,
-33039,
-32696,
-31592,
-30439,
-30510,
-32137,
-34062,
-34732,
-33942,
-32973,
-32966,
-33668,
-34001,
-33553,
-32962,
-32960,
-33404,
-33625,
-33417,
-33188,
-33310,
-33627,
-33820,
-33934,
-34206,
-34534,
-34492,
-33911,
-33229,
-32900,
-32854,
-32574,
-31904,
-31320,
-31301,
-31740,
-32023,
-31820,
-31353,
-31018,
-30879,
-30739,
-30594,
-30652,
-31065,
-31622,
-32000,
-32082,
-31983,
-31817,
-31588,
-31354,
-31275,
-31469,
-31779,
-31931,
-31845,
-31725,
-31822,
-32109,
-32345,
-32324,
-32098,
-31849,
-31722,
-31730,
-31790,
-31849,
-31860,
-31857,
-31870,
-31932,
-31979,
-31955,
-31834,
-31721,
-31729,
-31907,
-32235,
-32587,
-32839,
-32882,
-32748,
-32615,
-32600,
-32592,
-32389,
-32060,
-32108,
-32901,
-34114,
-34760,
-34273,
-33129,
-32491,
-32855,
-33569,
-33665,
-33098,
-32692,
-32966,
-33367,
-33006,
-31953,
-31278,
-31754,
-32840,
-33320,
-32845,
-32229,
-32420,
-33182,
-33579,
-33149,
-32566,
-32628,
-33255,
-33606,
-33197,
-32431,
-32008,
-31985,
-31875,
-31380,
-30868,
-30811,
-31206,
-31497,
-31330,
-30891,
-30679,
-30945,
-31472,
-31901,
-31986,
-31757,
-31373,
-31046,
-30964,
-31139,
-31466,
-31714,
-31811,
-31753,
-31614,
-31383,
-31033,
-30647,
-30378,
-30405,
-30745,
-31223,
-31586,
-31661,
-31555,
-31528,
-31794,
-32248,
-32570,
-32547,
-32281,
-32091,
-32169,
-32413,
-32597,
-32569,
-32342,
-32036,
-31783,
-31725,
-31852,
-31990,
-31916,
-31666,
-31538,
-31796,
-32270,
-32572,
-32535,
-32465,
-32692,
-33131,
-33368,
-33241,
-33084,
-33237,
-33555,
-33551,
-33058,
-32521,
-32468,
-32895,
-33326,
-33389,
-33146,
-32866,
-32589,
-32269,
-31994,
-31988,
-32282,
-32522,
-32438,
-32088,
-31860,
-31897,
-32001,
-31899,
-31594,
-31296,
-31092,
-30929,
-30794,
-30813,
-31066,
-31391,
-31588,
-31637,
-31694,
-31839,
-31923,
-31807,
-31550,
-31319,
-31186,
-31144,
-31240,
-31641,
-32287,
-32829,
-32896,
-32525,
-32166,
-32136,
-32303,
-32277,
-31902,
-31474,
-31331,
-31549,
-31884,
-32083,
-32080,
-31944,
-31818,
-31830,
-32043,
-32354,
-32562,
-32561,
-32474,
-32520,
-32661,
-32700,
-32473,
-32200,
-32185,
-32482,
-32741,
-32597,
-32060,
-31502,
-31276,
-31424,
-31749,
-32024,
-32168,
-32192,
-32158,
-32153,
-32223,
-32343,
-32408,
-32380,
-32323,
-32351,
-32480,
-32597,
-32581,
-32405,
-32175,
-32018,
-32012,
-32118,
-32188,
-32102,
-31865,
-31677,
-31723,
-32000,
-32293,
-32434,
-32445,
-32475,
-32561,
-32568,
-32438,
-32251,
-32155,
-32126,
-32004,
-31787,
-31645,
-31732,
-31903,
-31880,
-31603,
-31346,
-31390,
-31641,
-31797,
-31666,
-31462,
-31440,
-31679,
-31976,
-32205,
-32394,
-32581,
-32695,
-32607,
-32369,
-32172,
-32125,
-32146,
-32088,
-31959,
-31916,
-32026,
-32218,
-32327,
-32349,
-32335,
-32380,
-32421,
-32460,
-32499,
-32617,
-32762,
-32838,
-32760,
-32584,
-32449,
-32426,
-32489,
-32538,
-32529,
-32490,
-32457,
-32435,
-32392,
-32361,
-32376,
-32470,
-32578,
-32608,
-32541,
-32379,
-32168,
-31875,
-31555,
-31318,
-31314,
-31519,
-31766,
-31833,
-31732,
-31628,
-31699,
-31929,
-32112,
-32096,
-31926,
-31807,
-31914,
-32141,
-32275,
-32177,
-31990,
-31882,
-31768,
-31408,
-30854,
-30596,
-31011,
-31678,
-31804,
-31310,
-31269,
-32487,
-33972,
-33593,
-30822,
-28194,
-28913,
-32974,
-36713,
-36894,
-34643,
-33883,
-36142,
-38322,
-36763,
-32277,
-29320,
-30045,
-31256,
-28825,
-23893,
-22175,
-26526,
-32454,
-33189,
-28364,
-25133,
-29463,
-38356,
-42949,
-38796,
-30960,
-27586,
-30495,
-34021,
-32966,
-28915,
-27571,
-31192,
-36186,
-38131,
-36942,
-35601,
-34962,
-32381,
-26058,
-18943,
-16512,
-20815,
-28292,
-33862,
-36080,
-37385,
-39923,
-42796,
-43509,
-41012,
-36417,
-31539,
-27821,
-26408,
-27635,
-30061,
-31284,
-30850,
-31667,
-36383,
-42630,
-43952,
-37221,
-27777,
-24415,
-29122,
-34305,
-32048,
-24421,
-21299,
-28166,
-38967,
-43536,
-39719,
-34850,
-35190,
-37847,
-35639,
-27628,
-20789,
-20649,
-24193,
-24507,
-20756,
-19572,
-26112,
-36683,
-42832,
-41179,
-36474,
-34878,
-36596,
-37194,
-34167,
-29993,
-28162,
-28617,
-28618,
-27458,
-28349,
-34625,
-44698,
-51647,
-48929,
-36846,
-23579,
-18511,
-23706,
-31684,
-33038,
-26487,
-20574,
-24168,
-36149,
-46282,
-46595,
-39727,
-34492,
-34663,
-35362,
-31040,
-23895,
-21414,
-26545,
-33676,
-35701,
-32560,
-30428,
-33276,
-38284,
-40069,
-37285,
-32924,
-29692,
-27442,
-25414,
-24391,
-25418,
-27848,
-30444,
-33569,
-38007,
-41753,
-40693,
-34116,
-27486,
-26963,
-31406,
-33074,
-27480,
-19869,
-19260,
-27121,
-35845,
-38889,
-38694,
-41478,
-46613,
-46342,
-37153,
-26602,
-24946,
-31629,
-35534,
-29648,
-20965,
-21914,
-33956,
-45153,
-44873,
-36519,
-31649,
-34182,
-35744,
-28103,
-15512,
-10558,
-19122,
-33584,
-42001,
-40624,
-35132,
-31911,
-31783,
-32393,
-32773,
-33319,
-33059,
-30321,
-25898,
-23455,
-25418,
-30317,
-34998,
-38082,
-39682,
-38821,
-34426,
-28903,
-27855,
-33504,
-40153,
-39358,
-30087,
-20891,
-20489,
-28343,
-36881,
-41289,
-43346,
-45235,
-44227,
-37082,
-27323,
-22882,
-25454,
-27026,
-20395,
-10665,
-10558,
-24037,
-39572,
-43352,
-36084,
-31135,
-36419,
-43930,
-41069,
-28317,
-19498,
-24136,
-35509,
-39957,
-34537,
-29512,
-33373,
-41204,
-41954,
-33848,
-27169,
-30725,
-40622,
-45243,
-39335,
-28895,
-22621,
-22594,
-25226,
-28182,
-32432,
-37981,
-41713,
-41457,
-39701,
-40488,
-43211,
-42368,
-34384,
-22600,
-14002,
-12608,
-17537,
-26486,
-37608,
-47468,
-50536,
-44150,
-33153,
-26189,
-26269,
-27684,
-24274,
-18653,
-19455,
-29270,
-39543,
-40542,
-34147,
-32078,
-40537,
-50694,
-48280,
-31269,
-13763,
-10939,
-23013,
-36878,
-41691,
-39015,
-36923,
-38507,
-39996,
-38747,
-38035,
-41385,
-45161,
-41272,
-27977,
-14938,
-14396,
-28006,
-44204,
-49713,
-42228,
-31304,
-27683,
-33150,
-40438,
-41286,
-33724,
-22730,
-15324,
-15331,
-21178,
-27732,
-30334,
-28271,
-25102,
-25250,
-29976,
-36098,
-38678,
-35024,
-26649,
-18208,
-14615,
-18224,
-27206,
-36299,
-40215,
-37923,
-33891,
-34140,
-40197,
-46969,
-47484,
-39893,
-29629,
-24330,
-26915,
-33745,
-38890,
-39499,
-37024,
-34499,
-33595,
-34114,
-35037,
-35394,
-34489,
-32351,
-29995,
-28790,
-29004,
-29442,
-29012,
-28498,
-30054,
-34412,
-39239,
-40901,
-38293,
-34108,
-32125,
-33173,
-34612,
-33392,
-29321,
-24722,
-21982,
-22132,
-25678,
-32818,
-41585,
-46675,
-42825,
-31162,
-20783,
-21468,
-33216,
-44583,
-43512,
-30356,
-18536,
-21079,
-36853,
-51625,
-52570,
-40792,
-28484,
-25503,
-30244,
-34128,
-32213,
-27531,
-25265,
-25916,
-25999,
-24471,
-25226,
-31792,
-40978,
-44536,
-38017,
-26619,
-20355,
-23734,
-31296,
-34284,
-30222,
-24941,
-25297,
-31911,
-39673,
-43840,
-43876,
-41379,
-36963,
-30790,
-25024,
-23236,
-26238,
-30362,
-31354,
-29783,
-30536,
-36533,
-44241,
-47058,
-42650,
-35472,
-31540,
-32009,
-33145,
-31937,
-30047,
-31391,
-36764,
-42319,
-43556,
-40063,
-35793,
-34687,
-36733,
-38313,
-36301,
-31337,
-27127,
-26476,
-28545,
-30100,
-29168,
-27044,
-26342,
-27938,
-30364,
-32087,
-33074,
-33773,
-33384,
-30947,
-27827,
-27803,
-32988,
-40457,
-44244,
-41401,
-34997,
-30562,
-30240,
-31476,
-31047,
-28721,
-26318,
-24621,
-22988,
-21757,
-23190,
-28627,
-35634,
-39425,
-37636,
-32734,
-29351,
-29696,
-32153,
-33925,
-33905,
-33083,
-32916,
-34147,
-36600,
-39384,
-41026,
-40342,
-37460,
-33959,
-31542,
-30650,
-30496,
-30181,
-29382,
-28300,
-27545,
-28350,
-31859,
-37482,
-42182,
-42601,
-38553,
-33735,
-32289,
-34603,
-37294,
-37154,
-34413,
-31625,
-30287,
-29743,
-29252,
-29598,
-31451,
-33019,
-30949,
-24483,
-17644,
-16055,
-21297,
-29217,
-34077,
-33926,
-31523,
-30483,
-31779,
-33934,
-35728,
-37223,
-38550,
-38597,
-36299,
-32553,
-30196,
-31190,
-34360,
-36397,
-35261,
-32294,
-30591,
-31628,
-33727,
-34012,
-31512,
-28098,
-26530,
-27932,
-31267,
-34742,
-37146,
-37897,
-36582,
-33414,
-29988,
-28821,
-31162,
-35338,
-37940,
-37124,
-34482,
-33371,
-35171,
-37987,
-38702,
-36385,
-32835,
-30376,
-29648,
-29726,
-29929,
-30441,
-31498,
-32404,
-32213,
-30988,
-30059,
-30629,
-32623,
-34786,
-35932,
-35714,
-34527,
-33052,
-32047,
-32064,
-33050,
-34149,
-34380,
-33596,
-32699,
-32639,
-33414,
-34155,
-34122,
-33484,
-32860,
-32529,
-32179,
-31424,
-30436,
-29861,
-30413,
-32350,
-35292,
-38142,
-39587,
-38891,
-36686,
-34630,
-34101,
-35040,
-36143,
-36203,
-35033,
-33190,
-31100,
-28914,
-27083,
-26421,
-27257,
-28602,
-28974,
-28008,
-27093,
-27755,
-29828,
-31571,
-31863,
-31550,
-32244,
-34013,
-35202,
-34661,
-33550,
-33972,
-36163,
-37773,
-36663,
-33560,
-31444,
-31996,
-33778,
-33985,
-31726,
-28652,
-26754,
-26392,
-26751,
-27585,
-29319,
-31809,
-33737,
-34072,
-33481,
-33721,
-35492,
-37494,
-37960,
-36556,
-34647,
-33665,
-33842,
-34537,
-35079,
-35263,
-34907,
-33893,
-32376,
-30972,
-30231,
-30264,
-30715,
-31177,
-31359,
-31151,
-30759,
-30742,
-31504,
-32725,
-33474,
-33295,
-32872,
-33317,
-34705,
-35843,
-35628,
-34442,
-33626,
-33805,
-34155,
-33588,
-32268,
-31405,
-31795,
-32833,
-33373,
-32939,
-32023,
-31262,
-30958,
-31231,
-32354,
-34243,
-36106,
-36813,
-35995,
-34463,
-33393,
-33225,
-33442,
-33400,
-33049,
-32790,
-32841,
-32906,
-32522,
-31589,
-30486,
-29754,
-29605,
-29746,
-29668,
-29213,
-28876,
-29467,
-31351,
-33907,
-35820,
-36056,
-34647,
-32798,
-32005,
-33001,
-35149,
-36945,
-37262,
-36331,
-35385,
-35391,
-35976,
-36068,
-35131,
-33799,
-32881,
-32361,
-31707,
-31025,
-31255,
-32792,
-34373,
-34153,
-31845,
-29402,
-28966,
-30589,
-32369,
-32816,
-32369,
-32479,
-33591,
-34848,
-35329,
-35149,
-34911,
-34799,
-34580,
-34241,
-33943,
-33503,
-32488,
-31241,
-31065,
-32826,
-35447,
-36719,
-35658,
-33599,
-32310,
-31827,
-30789,
-28963,
-28058,
-29556,
-32344,
-33825,
-33114,
-32232,
-33212,
-35250,
-35582,
-33281,
-30685,
-30553,
-32648,
-34338,
-34180,
-33621,
-34482,
-35986,
-35566,
-32554,
-29513,
-29389,
-31875,
-33979,
-33649,
-31985,
-31125,
-31416,
-31446,
-30818,
-31125,
-33576,
-36632,
-37289,
-34852,
-32137,
-32226,
-34671,
-36045,
-34160,
-30784,
-29363,
-30925,
-33210,
-33858,
-33208,
-33195,
-34280,
-34763,
-33463,
-31694,
-31683,
-33449,
-34543,
-33374,
-31621,
-32296,
-35736,
-38668,
-37926,
-34176,
-31077,
-31000,
-32539,
-32874,
-31378,
-30178,
-30997,
-32887,
-33475,
-32084,
-30527,
-30863,
-32976,
-34900,
-35072,
-33789,
-32477,
-32161,
-32847,
-33996,
-35118,
-35862,
-36086,
-35942,
-35891,
-36211,
-36660,
-36646,
-35813,
-34447,
-33210,
-32634,
-32816,
-33403,
-33883,
-33920,
-33692,
-33701,
-34333,
-35232,
-35572,
-34721,
-32923,
-31029,
-29912,
-29895,
-30872,
-32388,
-33774,
-34311,
-33763,
-32691,
-32018,
-32107,
-32363,
-31989,
-30923,
-30029,
-30020,
-30722,
-31277,
-31199,
-30845,
-30860,
-31396,
-32014,
-32434,
-32836,
-33615,
-34627,
-35244,
-35037,
-34324,
-33915,
-34243,
-34998,
-35583,
-35805,
-35894,
-35958,
-35635,
-34705,
-33642,
-33414,
-34341,
-35459,
-35438,
-34012,
-32445,
-32163,
-33224,
-34364,
-34404,
-33512,
-32675,
-32528,
-32818,
-33079,
-33282,
-33609,
-33881,
-33674,
-32996,
-32426,
-32449,
-32772,
-32771,
-32378,
-32246,
-32776,
-33436,
-33321,
-32341,
-31467,
-31538,
-32252,
-32533,
-31931,
-31179,
-31279,
-32310,
-33382,
-33845,
-33936,
-34349,
-35116,
-35525,
-34989,
-33879,
-33190,
-33499,
-34354,
-34808,
-34367,
-33428,
-32777,
-32865,
-33484,
-34059,
-34170,
-33755,
-33117,
-32636,
-32540,
-32831,
-33280,
-33703,
-33986,
-34156,
-34139,
-33855,
-33349,
-32957,
-32992,
-33400,
-33608,
-33168,
-32296,
-31826,
-32311,
-33381,
-34073,
-33883,
-33303,
-33118,
-33456,
-33579,
-32912,
-31801,
-31195,
-31584,
-32499,
-33173,
-33409,
-33621,
-34099,
-34556,
-34500,
-33847,
-33014,
-32459,
-32293,
-32476,
-32953,
-33644,
-34260,
-34464,
-34211,
-33784,
-33398,
-33030,
-32557,
-32229,
-32334,
-32805,
-33062,
-32763,
-32319,
-32515,
-33459,
-34298,
-34136,
-33127,
-32365,
-32616,
-33488,
-33959,
-33616,
-33010,
-32865,
-33159,
-33293,
-32942,
-32459,
-32414,
-32833,
-33229,
-33154,
-32655,
-32158,
-31926,
-31989,
-32175,
-32442,
-32788,
-33206,
-33594,
-33813,
-33827,
-33715,
-33663,
-33795,
-33998,
-33999,
-33647,
-33180,
-33068,
-33489,
-34071,
-34171,
-33591,
-32794,
-32460,
-32747,
-33214,
-33268,
-32926,
-32663,
-32976,
-33788,
-34566,
-34804,
-34431,
-33819,
-33436,
-33507,
-33890,
-34229,
-34232,
-33929,
-33616,
-33532,
-33620,
-33484,
-32886,
-31997,
-31341,
-31275,
-31669,
-32104,
-32364,
-32580,
-32967,
-33355,
-33393,
-32988,
-32551,
-32606,
-33138,
-33600,
-33557,
-33208,
-33160,
-33622,
-34124,
-34071,
-33467,
-32923,
-32897,
-33171,
-33206,
-32850,
-32552,
-32732,
-33240,
-33548,
-33424,
-33209,
-33336,
-33798,
-34210,
-34328,
-34319,
-34423,
-34547,
-34397,
-33864,
-33250,
-32871,
-32786,
-32800,
-32897,
-33209,
-33776,
-34315,
-34453,
-34128,
-33582,
-33038,
-32527,
-32111,
-32062,
-32637,
-33623,
-34347,
-34329,
-33750,
-33227,
-33064,
-32961,
-32535,
-31912,
-31637,
-31989,
-32607,
-32921,
-32754,
-32436,
-32265,
-32221,
-32140,
-32077,
-32258,
-32695,
-33140,
-33393,
-33572,
-33887,
-34246,
-34345,
-34103,
-33946,
-34298,
-35075,
-35658,
-35609,
-35112,
-34691,
-34585,
-34520,
-34228,
-33772,
-33505,
-33517,
-33615,
-33619,
-33595,
-33710,
-33784,
-33516,
-32818,
-32136,
-31956,
-32323,
-32781,
-32923,
-32818,
-32794,
-32980,
-33114,
-32931,
-32496,
-32125,
-32008,
-32065,
-32185,
-32396,
-32810,
-33265,
-33453,
-33185,
-32694,
-32407,
-32522,
-32878,
-33190,
-33392,
-33618,
-33977,
-34352,
-34564,
-34534,
-34350,
-34166,
-34105,
-34221,
-34505,
-34800,
-34864,
-34602,
-34147,
-33826,
-33781,
-33873,
-33812,
-33522,
-33212,
-33109,
-33230,
-33352,
-33290,
-33078,
-32870,
-32760,
-32706,
-32655,
-32617,
-32675,
-32809,
-32952,
-32990,
-32947,
-32861,
-32789,
-32711,
-32601,
-32494,
-32451,
-32564,
-32818,
-33133,
-33335,
-33293,
-33002,
-32670,
-32561,
-32822,
-33284,
-33630,
-33666,
-33519,
-33488,
-33728,
-34051,
-34180,
-33999,
-33739,
-33646,
-33785,
-33960,
-33988,
-33875,
-33744,
-33658,
-33532,
-33304,
-33015,
-32835,
-32838,
-32991,
-33149,
-33226,
-33208,
-33097,
-32920,
-32696,
-32494,
-32385,
-32392,
-32479,
-32582,
-32676,
-32744,
-32806,
-32838,
-32836,
-32785,
-32690,
-32564,
-32435,
-32347,
-32353,
-32475,
-32639,
-32770,
-32802,
-32818,
-32924,
-33131,
-33315,
-33350,
-33275,
-33304,
-33555,
-33897,
-34032,
-33850,
-33527,
-33383,
-33526,
-33764,
-33906,
-33891,
-33850,
-33815,
-33740,
-33563,
-33389,
-33295,
-33254,
-33125,
-32891,
-32732,
-32818,
-33085,
-33291,
-33234,
-33005,
-32800,
-32755,
-32845,
-32968,
-33081,
-33140,
-33114,
-32990,
-32842,
-32748,
-32693,
-32603,
-32466,
-32402,
-32508,
-32706,
-32805,
-32710,
-32548,
-32506,
-32611,
-32725,
-32750,
-32732,
-32805,
-32977,
-33186,
-33352,
-33506,
-33637,
-33676,
-33588,
-33422,
-33349,
-33364,
-33365,
-33202,
-32969,
-32860,
-33003,
-33289,
-33528,
-33628,
-33640,
-33639,
-33611,
-33548,
-33475,
-33432,
-33411,
-33340,
-33230,
-33179,
-33263,
-33439,
-33552,
-33506,
-33341,
-33119,
-32921,
-32724,
-32577,
-32501,
-32498,
-32502,
-32468,
-32434,
-32461,
-32549,
-32633,
-32638,
-32612,
-32598,
-32620,
-32612,
-32575,
-32563,
-32664,
-32867,
-33069,
-33182,
-33180,
-33105,
-33001,
-32892,
-32801,
-32780,
-32826,
-32933,
-33064,
-33183,
-33308,
-33400,
-33468,
-33492,
-33488,
-33462,
-33417,
-33369,
-33355,
-33405,
-33505,
-33611,
-33673,
-33660,
-33586,
-33465,
-33344,
-33249,
-33172,
-33060,
-32918,
-32794,
-32821,
-32996,
-33204,
-33303,
-33264,
-33217,
-33216,
-33200,
-33026,
-32721,
-32465,
-32430,
-32576,
-32722,
-32759,
-32730,
-32753,
-32802,
-32799,
-32683,
-32541,
-32452,
-32413,
-32367,
-32311,
-32327,
-32468,
-32675,
-32838,
-32930,
-33006,
-33113,
-33207,
-33215,
-33138,
-33066,
-33087,
-33197,
-33358,
-33531,
-33712,
-33882,
-33974,
-33961,
-33856,
-33736,
-33636,
-33531,
-33421,
-33292,
-33231,
-33226,
-33257,
-33237,
-33135,
-32994,
-32892,
-32879,
-32932,
-32944,
-32870,
-32713,
-32596,
-32570,
-32633,
-32667,
-32635,
-32556,
-32519,
-32551,
-32572,
-32541,
-32432,
-32347,
-32315,
-32344,
-32363,
-32370,
-32388,
-32435,
-32496,
-32516,
-32518,
-32549,
-32663,
-32827,
-32965,
-33030,
-33064,
-33127,
-33274,
-33436,
-33569,
-33621,
-33619,
-33585,
-33554,
-33505,
-33476,
-33437,
-33410,
-33377,
-33355,
-33372,
-33417,
-33452,
-33403,
-33267,
-33088,
-32941,
-32853,
-32784,
-32717,
-32667,
-32676,
-32733,
-32785,
-32758,
-32684,
-32586,
-32516,
-32415,
-32270,
-32107,
-32009,
-32023,
-32108,
-32196,
-32265,
-32361,
-32505,
-32672,
-32770,
-32788,
-32758,
-32754,
-32793,
-32841,
-32878,
-32928,
-33019,
-33166,
-33294,
-33372,
-33376,
-33357,
-33332,
-33303,
-33246,
-33171,
-33108,
-33101,
-33140,
-33193,
-33235,
-33246,
-33265,
-33276,
-33281,
-33239,
-33179,
-33116,
-33089,
-33086,
-33078,
-33058,
-33030,
-33001,
-32957,
-32884,
-32784,
-32700,
-32626,
-32569,
-32489,
-32443,
-32463,
-32572,
-32686,
-32716,
-32643,
-32565,
-32564,
-32630,
-32667,
-32614,
-32530,
-32538,
-32668,
-32844,
-32942,
-32933,
-32886,
-32893,
-32934,
-32968,
-32926,
-32872,
-32849,
-32904,
-32983,
-33052,
-33105,
-33169,
-33256,
-33313,
-33318,
-33257,
-33193,
-33153,
-33118,
-33049,
-32946,
-32854,
-32832,
-32857,
-32871,
-32829,
-32765,
-32733,
-32760,
-32790,
-32754,
-32654,
-32529,
-32459,
-32436,
-32464,
-32490,
-32529,
-32567,
-32589,
-32595,
-32556,
-32517,
-32451,
-32386,
-32302,
-32241,
-32222,
-32250,
-32305,
-32349,
-32398,
-32467,
-32567,
-32663,
-32710,
-32713,
-32704,
-32735,
-32796,
-32848,
-32878,
-32892,
-32946,
-33011,
-33081,
-33101,
-33111,
-33127,
-33158,
-33166,
-33125,
-33068,
-33051,
-33089,
-33147,
-33169,
-33145,
-33123,
-33125,
-33147,
-33160,
-33141,
-33106,
-33057,
-32993,
-32922,
-32867,
-32846,
-32858,
-32848,
-32813,
-32753,
-32706,
-32672,
-32642,
-32594,
-32563,
-32538,
-32537,
-32518,
-32502,
-32505,
-32543,
-32585,
-32596,
-32586,
-32595,
-32659,
-32728,
-32764,
-32743,
-32729,
-32767,
-32856,
-32911,
-32914,
-32856,
-32808,
-32782,
-32763,
-32744,
-32720,
-32733,
-32762,
-32815,
-32856,
-32897,
-32926,
-32917,
-32867,
-32785,
-32732,
-32714,
-32727,
-32722,
-32708,
-32726,
-32785,
-32881,
-32939,
-32947,
-32913,
-32869,
-32823,
-32768,
-32696,
-32631,
-32590,
-32579,
-32586,
-32601,
-32622,
-32631,
-32633,
-32619,
-32604,
-32591,
-32562,
-32509,
-32455,
-32428,
-32457,
-32525,
-32588,
-32655,
-32712,
-32779,
-32835,
-32869,
-32892,
-32914,
-32938,
-32935,
-32906,
-32886,
-32907,
-32966,
-33025,
-33044,
-33059,
-33082,
-33127,
-33145,
-33143,
-33125,
-33150,
-33170,
-33159,
-33083,
-33003,
-32968,
-32991,
-33008,
-32983,
-32933,
-32889,
-32875,
-32842,
-32765,
-32660,
-32569,
-32543,
-32558,
-32584,
-32572,
-32507,
-32424,
-32354,
-32359,
-32401,
-32453,
-32452,
-32419,
-32405,
-32428,
-32488,
-32526,
-32557,
-32586,
-32630,
-32675,
-32710,
-32777,
-32888,
-33030,
-33113,
-33119,
-33088,
-33095,
-33162,
-33190,
-33149,
-33025,
-32931,
-32879,
-32881,
-32874,
-32862,
-32870,
-32876,
-32892,
-32885,
-32881,
-32882,
-32830,
-32715,
-32555,
-32449,
-32454,
-32517,
-32562,
-32519,
-32454,
-32442,
-32483,
-32547,
-32556,
-32551,
-32573,
-32630,
-32655,
-32597,
-32533,
-32549,
-32699,
-32830,
-32876,
-32921,
-33279,
-34046,
-34960,
-35523,
-35486,
-35114,
-34795,
-34662,
-34381,
-33728,
-32890,
-32350,
-32296,
-32406,
-32228,
-31740,
-31320,
-31264,
-31402,
-31360,
-31028,
-30682,
-30600,
-30739,
-30842,
-30776,
-30655,
-30611,
-30645,
-30688,
-30775,
-30984,
-31295,
-31559,
-31727,
-31918,
-32264,
-32677,
-32957,
-33036,
-33084,
-33285,
-33534,
-33625,
-33483,
-33343,
-33446,
-33726,
-33924,
-33814,
-33544,
-33341,
-33346,
-33478,
-33605,
-33686,
-33755,
-33837,
-33930,
-34027,
-34094,
-34092,
-33989,
-33865,
-33811,
-33864,
-33916,
-33857,
-33736,
-33653,
-33707,
-33757,
-33724,
-33592,
-33492,
-33461,
-33385,
-33177,
-32893,
-32728,
-32764,
-32883,
-32926,
-32882,
-32878,
-33019,
-33207,
-33310,
-33282,
-33210,
-33186,
-33167,
-33075,
-32895,
-32715,
-32611,
-32568,
-32506,
-32401,
-32294,
-32229,
-32194,
-32125,
-32027,
-31923,
-31876,
-31854,
-31818,
-31748,
-31692,
-31687,
-31741,
-31779,
-31781,
-31757,
-31766,
-31825,
-31890,
-31906,
-31870,
-31799,
-31757,
-31744,
-31769,
-31835,
-31937,
-32060,
-32172,
-32244,
-32309,
-32390,
-32500,
-32613,
-32691,
-32754,
-32829,
-32942,
-33062,
-33155,
-33194,
-33213,
-33222,
-33254,
-33275,
-33293,
-33306,
-33332,
-33367,
-33397,
-33405,
-33372,
-33327,
-33267,
-33224,
-33174,
-33129,
-33062,
-33006,
-32961,
-32935,
-32915,
-32877,
-32823,
-32765,
-32723,
-32710,
-32697,
-32691,
-32670,
-32667,
-32672,
-32684,
-32674,
-32666,
-32675,
-32738,
-32828,
-32916,
-32947,
-32938,
-32902,
-32869,
-32844,
-32818,
-32806,
-32810,
-32831,
-32835,
-32822,
-32790,
-32769,
-32753,
-32738,
-32704,
-32671,
-32620,
-32557,
-32444,
-32314,
-32197,
-32136,
-32107,
-32085,
-32054,
-32045,
-32070,
-32120,
-32133,
-32105,
-32067,
-32052,
-32080,
-32105,
-32116,
-32121,
-32157,
-32209,
-32268,
-32283,
-32291,
-32294,
-32315,
-32336,
-32338,
-32344,
-32359,
-32406,
-32458,
-32507,
-32532,
-32543,
-32539,
-32520,
-32498,
-32478,
-32482,
-32484,
-32486,
-32465,
-32454,
-32475,
-32537,
-32612,
-32683,
-32719,
-32758,
-32794,
-32828,
-32843,
-32830,
-32815,
-32821,
-32852,
-32876,
-32886,
-32872,
-32871,
-32893,
-32911,
-32902,
-32839,
-32760,
-32700,
-32681,
-32684,
-32658,
-32601,
-32526,
-32493,
-32497,
-32510,
-32470,
-32385,
-32298,
-32257,
-32262,
-32256,
-32202,
-32122,
-32064,
-32067,
-32104,
-32143,
-32173,
-32216,
-32295,
-32371,
-32424,
-32438,
-32459,
-32519,
-32605,
-32667,
-32688,
-32665,
-32675,
-32702,
-32747,
-32770,
-32759,
-32763,
-32779,
-32829,
-32869,
-32888,
-32883,
-32867,
-32855,
-32847,
-32845,
-32855,
-32861,
-32862,
-32829,
-32802,
-32798,
-32839,
-32902,
-32927,
-32908,
-32856,
-32823,
-32818,
-32826,
-32818,
-32794,
-32779,
-32761,
-32757,
-32744,
-32736,
-32755,
-32752,
-32749,
-32696,
-32648,
-32610,
-32590,
-32583,
-32580,
-32598,
-32638,
-32687,
-32726,
-32755,
-32795,
-32841,
-32886,
-32898,
-32875,
-32845,
-32804,
-32790,
-32776,
-32789,
-32807,
-32813,
-32810,
-32782,
-32764,
-32747,
-32721,
-32699,
-32675,
-32683,
-32669,
-32643,
-32588,
-32572,
-32602,
-32637,
-32624,
-32559,
-32523,
-32544,
-32594,
-32575,
-32483,
-32382,
-32362,
-32384,
-32379,
-32298,
-32212,
-32199,
-32258,
-32303,
-32288,
-32233,
-32220,
-32261,
-32314,
-32327,
-32318,
-32308,
-32329,
-32346,
-32355,
-32380,
-32437,
-32519,
-32575,
-32580,
-32563,
-32571,
-32616,
-32658,
-32670,
-32634,
-32612,
-32601,
-32611,
-32592,
-32558,
-32533,
-32561,
-32618,
-32684,
-32717,
-32748,
-32797,
-32877,
-32936,
-32953,
-32924,
-32899,
-32894,
-32892,
-32866,
-32834,
-32827,
-32856,
-32881,
-32850,
-32784,
-32725,
-32718,
-32707,
-32664,
-32571,
-32495,
-32490,
-32521,
-32549,
-32542,
-32527,
-32521,
-32516,
-32482,
-32456,
-32466,
-32528,
-32591,
-32600,
-32593,
-32628,
-32739,
-32869,
-32949,
-32956,
-32968,
-33007,
-33065,
-33070,
-33024,
-32970,
-32949,
-32935,
-32887,
-32822,
-32792,
-32853,
-32940,
-33000,
-32988,
-32951,
-32943,
-32964,
-32977,
-32948,
-32875,
-32798,
-32714,
-32645,
-32581,
-32538,
-32517,
-32496,
-32461,
-32422,
-32382,
-32375,
-32364,
-32356,
-32326,
-32305,
-32287,
-32290,
-32300,
-32317,
-32333,
-32352,
-32362,
-32392,
-32435,
-32514,
-32585,
-32648,
-32666,
-32677,
-32687,
-32724,
-32777,
-32828,
-32865,
-32873,
-32869,
-32860,
-32875,
-32910,
-32936,
-32939,
-32882,
-32828,
-32787,
-32790,
-32799,
-32779,
-32737,
-32703,
-32692,
-32698,
-32675,
-32650,
-32638,
-32670,
-32688,
-32661,
-32553,
-32456,
-32390,
-32400,
-32412,
-32427,
-32431,
-32457,
-32492,
-32522,
-32536,
-32559,
-32591,
-32623,
-32632,
-32617,
-32616,
-32630,
-32660,
-32675,
-32679,
-32687,
-32690,
-32684,
-32643,
-32601,
-32582,
-32578,
-32585,
-32556,
-32532,
-32541,
-32591,
-32669,
-32726,
-32743,
-32746,
-32736,
-32734,
-32731,
-32728,
-32720,
-32702,
-32671,
-32633,
-32609,
-32597,
-32590,
-32571,
-32551,
-32543,
-32566,
-32608,
-32647,
-32676,
-32679,
-32673,
-32647,
-32622,
-32591,
-32588,
-32582,
-32589,
-32595,
-32625,
-32683,
-32738,
-32751,
-32708,
-32653,
-32633,
-32665,
-32688,
-32667,
-32602,
-32563,
-32601,
-32688,
-32779,
-32810,
-32813,
-32803,
-32819,
-32834,
-32849,
-32838,
-32817,
-32778,
-32743,
-32718,
-32728,
-32736,
-32751,
-32741,
-32756,
-32790,
-32832,
-32835,
-32795,
-32738,
-32721,
-32735,
-32759,
-32763,
-32758,
-32757,
-32756,
-32755,
-32739,
-32743,
-32744,
-32727,
-32664,
-32592,
-32538,
-32530,
-32519,
-32480,
-32432,
-32416,
-32446,
-32475,
-32468,
-32446,
-32450,
-32496,
-32525,
-32500,
-32448,
-32427,
-32463,
-32514,
-32538,
-32535,
-32555,
-32605,
-32635,
-32646,
-32622,
-32665,
-32721,
-32780,
-32756,
-32710,
-32681,
-32699,
-32712,
-32669,
-32610,
-32585,
-32642,
-32719,
-32773,
-32786,
-32794,
-32829,
-32863,
-32872,
-32854,
-32825,
-32804,
-32792,
-32771,
-32773,
-32782,
-32792,
-32771,
-32716,
-32671,
-32659,
-32687,
-32702,
-32692,
-32653,
-32613,
-32579,
-32523,
-32474,
-32435,
-32442,
-32475,
-32472,
-32437,
-32376,
-32334,
-32325,
-32319,
-32318,
-32338,
-32396,
-32476,
-32537,
-32565,
-32604,
-32693,
-32806,
-32892,
-32889,
-32860,
-32837,
-32871,
-32894,
-32872,
-32814,
-32759,
-32744,
-32760,
-32779,
-32804,
-32835,
-32852,
-32837,
-32787,
-32733,
-32700,
-32670,
-32605,
-32533,
-32478,
-32481,
-32484,
-32455,
-32393,
-32376,
-32440,
-32541,
-32598,
-32580,
-32536,
-32509,
-32498,
-32475,
-32459,
-32475,
-32534,
-32556,
-32499,
-32408,
-32365,
-32430,
-32517,
-32559,
-32524,
-32507,
-32537,
-32600,
-32629,
-32623,
-32635,
-32685,
-32753,
-32785,
-32813,
-32865,
-32956,
-33005,
-32970,
-32886,
-32826,
-32838,
-32854,
-32829,
-32780,
-32771,
-32808,
-32834,
-32773,
-32681,
-32623,
-32661,
-32703,
-32687,
-32593,
-32521,
-32522,
-32572,
-32590,
-32552,
-32499,
-32505,
-32553,
-32615,
-32631,
-32647,
-32655,
-32680,
-32665,
-32616,
-32568,
-32557,
-32608,
-32649,
-32684,
-32677,
-32679,
-32686,
-32700,
-32705,
-32723,
-32737,
-32749,
-32713,
-32649,
-32592,
-32598,
-32653,
-32721,
-32735,
-32700,
-32641,
-32597,
-32584,
-32604,
-32634,
-32646,
-32612,
-32534,
-32461,
-32456,
-32516,
-32587,
-32606,
-32577,
-32577,
-32630,
-32709,
-32712,
-32646,
-32555,
-32532,
-32552,
-32560,
-32506,
-32449,
-32450,
-32521,
-32615,
-32654,
-32671,
-32666,
-32682,
-32679,
-32673,
-32688,
-32728,
-32777,
-32777,
-32739,
-32710,
-32704,
-32705,
-32682,
-32652,
-32660,
-32695,
-32725,
-32709,
-32722,
-32769,
-32864,
-32906,
-32892,
-32876,
-32893,
-32917,
-32861,
-32742,
-32654,
-32633,
-32652,
-32594,
-32483,
-32391,
-32380,
-32412,
-32409,
-32379,
-32374,
-32436,
-32532,
-32601,
-32631,
-32640,
-32653,
-32662,
-32663,
-32639,
-32613,
-32606,
-32621,
-32631,
-32597,
-32548,
-32590,
-32716,
-32804,
-32675,
-32441,
-32415,
-32725,
-33051,
-32920,
-32355,
-31937,
-32114,
-32590,
-32719,
-32351,
-32086,
-32350,
-32775,
-32714,
-32312,
-32406,
-33283,
-33985,
-33510,
-32312,
-31947,
-33022,
-34213,
-33946,
-32535,
-31901,
-32908,
-34157,
-33833,
-32312,
-31723,
-32988,
-34463,
-34106,
-32354,
-31530,
-32676,
-34098,
-33799,
-32225,
-31649,
-32800,
-33912,
-33198,
-31575,
-31375,
-33024,
-34280,
-33303,
-31262,
-30762,
-32344,
-33729,
-33065,
-31379,
-31087,
-32567,
-33716,
-32933,
-31341,
-31157,
-32566,
-33592,
-32865,
-31550,
-31561,
-32900,
-33654,
-32783,
-31503,
-31611,
-32924,
-33643,
-32782,
-31541,
-31538,
-32679,
-33347,
-32666,
-31570,
-31429,
-32248,
-32819,
-32493,
-31878,
-31876,
-32341,
-32522,
-32198,
-31989,
-32329,
-32710,
-32451,
-31734,
-31480,
-32109,
-32880,
-32890,
-32245,
-31917,
-32457,
-33236,
-33351,
-32760,
-32321,
-32575,
-33142,
-33256,
-32852,
-32536,
-32740,
-33156,
-33258,
-33029,
-32934,
-33200,
-33470,
-33327,
-32891,
-32713,
-32994,
-33357,
-33269,
-32776,
-32396,
-32493,
-32849,
-32988,
-32792,
-32569,
-32638,
-32912,
-33074,
-32981,
-32838,
-32824,
-32899,
-32840,
-32651,
-32528,
-32637,
-32774,
-32676,
-32358,
-32179,
-32377,
-32723,
-32742,
-32351,
-31967,
-32049,
-32474,
-32722,
-32497,
-32122,
-32086,
-32415,
-32653,
-32504,
-32192,
-32153,
-32427,
-32598,
-32413,
-32100,
-32072,
-32361,
-32585,
-32477,
-32224,
-32169,
-32347,
-32431,
-32244,
-31975,
-31967,
-32227,
-32457,
-32413,
-32229,
-32160,
-32299,
-32446,
-32436,
-32316,
-32244,
-32287,
-32363,
-32406,
-32457,
-32542,
-32627,
-32616,
-32532,
-32503,
-32606,
-32742,
-32779,
-32643,
-32517,
-32530,
-32680,
-32809,
-32784,
-32678,
-32629,
-32695,
-32779,
-32782,
-32702,
-32659,
-32673,
-32698,
-32658,
-32583,
-32560,
-32615,
-32674,
-32695,
-32695,
-32752,
-32831,
-32852,
-32756,
-32618,
-32528,
-32542,
-32601,
-32690,
-32794,
-32899,
-32958,
-32916,
-32843,
-32791,
-32789,
-32765,
-32682,
-32610,
-32604,
-32662,
-32681,
-32642,
-32640,
-32746,
-32905,
-32959,
-32840,
-32646,
-32523,
-32485,
-32458,
-32390,
-32347,
-32390,
-32487,
-32537,
-32487,
-32432,
-32433,
-32500,
-32541,
-32509,
-32440,
-32416,
-32409,
-32420,
-32365,
-32307,
-32269,
-32291,
-32352,
-32428,
-32480,
-32494,
-32467,
-32431,
-32390,
-32361,
-32297,
-32215,
-32153,
-32176,
-32281,
-32420,
-32489,
-32508,
-32499,
-32535,
-32605,
-32664,
-32704,
-32733,
-32789,
-32837,
-32850,
-32791,
-32711,
-32633,
-32571,
-32508,
-32449,
-32427,
-32480,
-32563,
-32634,
-32644,
-32622,
-32614,
-32624,
-32643,
-32641,
-32650,
-32699,
-32781,
-32866,
-32886,
-32851,
-32774,
-32709,
-32661,
-32627,
-32580,
-32516,
-32469,
-32450,
-32493,
-32544,
-32574,
-32552,
-32505,
-32473,
-32481,
-32518,
-32579,
-32636,
-32707,
-32731,
-32724,
-32674,
-32648,
-32657,
-32708,
-32738,
-32755,
-32751,
-32779,
-32799,
-32812,
-32780,
-32737,
-32700,
-32679,
-32650,
-32607,
-32559,
-32523,
-32506,
-32488,
-32469,
-32425,
-32382,
-32343,
-32322,
-32340,
-32385,
-32445,
-32475,
-32480,
-32440,
-32412,
-32388,
-32383,
-32378,
-32354,
-32305,
-32255,
-32224,
-32260,
-32331,
-32419,
-32483,
-32529,
-32584,
-32646,
-32692,
-32676,
-32608,
-32540,
-32509,
-32534,
-32553,
-32536,
-32501,
-32470,
-32499,
-32564,
-32632,
-32685,
-32690,
-32681,
-32645,
-32626,
-32632,
-32678,
-32744,
-32785,
-32781,
-32740,
-32696,
-32677,
-32675,
-32676,
-32649,
-32619,
-32592,
-32604,
-32629,
-32656,
-32639,
-32595,
-32538,
-32502,
-32501,
-32526,
-32573,
-32628,
-32674,
-32698,
-32674,
-32619,
-32558,
-32504,
-32477,
-32446,
-32425,
-32399,
-32381,
-32364,
-32351,
-32372,
-32436,
-32522,
-32592,
-32597,
-32565,
-32535,
-32520,
-32504,
-32446,
-32378,
-32328,
-32340,
-32394,
-32452,
-32512,
-32575,
-32641,
-32700,
-32730,
-32749,
-32777,
-32799,
-32800,
-32775,
-32753,
-32780,
-32833,
-32890,
-32925,
-32943,
-32943,
-32906,
-32802,
-32670,
-32554,
-32492,
-32459,
-32410,
-32367,
-32356,
-32411,
-32488,
-32533,
-32556,
-32580,
-32630,
-32675,
-32678,
-32651,
-32648,
-32650,
-32670,
-32647,
-32643,
-32675,
-32713,
-32730,
-32681,
-32662,
-32695,
-32760,
-32745,
-32634,
-32489,
-32428,
-32442,
-32454,
-32414,
-32374,
-32428,
-32568,
-32701,
-32738,
-32718,
-32721,
-32786,
-32844,
-32836,
-32747,
-32667,
-32619,
-32622,
-32633,
-32668,
-32727,
-32796,
-32822,
-32783,
-32704,
-32648,
-32634,
-32646,
-32641,
-32594,
-32518,
-32441,
-32383,
-32372,
-32398,
-32438,
-32495,
-32546,
-32617,
-32704,
-32771,
-32822,
-32836,
-32823,
-32778,
-32680,
-32554,
-32466,
-32454,
-32528,
-32606,
-32643,
-32657,
-32686,
-32751,
-32800,
-32796,
-32755,
-32740,
-32784,
-32851,
-32888,
-32887,
-32867,
-32871,
-32877,
-32856,
-32788,
-32707,
-32631,
-32592,
-32571,
-32561,
-32559,
-32552,
-32531,
-32520,
-32554,
-32647,
-32785,
-32864,
-32867,
-32795,
-32742,
-32742,
-32784,
-32783,
-32722,
-32621,
-32553,
-32545,
-32570,
-32606,
-32615,
-32628,
-32636,
-32649,
-32669,
-32688,
-32705,
-32705,
-32692,
-32706,
-32770,
-32869,
-32956,
-32964,
-32925,
-32862,
-32844,
-32820,
-32791,
-32708,
-32637,
-32587,
-32580,
-32586,
-32586,
-32592,
-32601,
-32621,
-32641,
-32671,
-32712,
-32765,
-32817,
-32859,
-32897,
-32929,
-32954,
-32955,
-32944,
-32934,
-32937,
-32958,
-32963,
-32973,
-32964,
-32958,
-32926,
-32879,
-32824,
-32795,
-32798,
-32799,
-32769,
-32698,
-32623,
-32585,
-32590,
-32618,
-32637,
-32653,
-32684,
-32745,
-32824,
-32898,
-32935,
-32937,
-32875,
-32783,
-32681,
-32625,
-32645,
-32690,
-32727,
-32702,
-32676,
-32669,
-32698,
-32722,
-32716,
-32717,
-32747,
-32813,
-32870,
-32894,
-32912,
-32939,
-32994,
-33013,
-33002,
-32961,
-32928,
-32893,
-32848,
-32790,
-32770,
-32796,
-32860,
-32902,
-32922,
-32926,
-32938,
-32955,
-32963,
-32978,
-33020,
-33068,
-33097,
-33069,
-33034,
-33027,
-33068,
-33114,
-33127,
-33099,
-33084,
-33087,
-33108,
-33117,
-33105,
-33079,
-33059,
-33035,
-33035,
-33032,
-33040,
-33028,
-33000,
-32980,
-32969,
-32977,
-32960,
-32924,
-32878,
-32861,
-32879,
-32904,
-32915,
-32892,
-32858,
-32816,
-32797,
-32796,
-32827,
-32855,
-32852,
-32815,
-32758,
-32751,
-32765,
-32807,
-32822,
-32881,
-32975,
-33113,
-33151,
-33045,
-32840,
-32708,
-32753,
-32917,
-33036,
-33021,
-32925,
-32867,
-32871,
-32839,
-32700,
-32499,
-32366,
-32359,
-32407,
-32390,
-32270,
-32140,
-32086,
-32143,
-32232,
-32293,
-32292,
-32280,
-32312,
-32395,
-32485,
-32498,
-32420,
-32347,
-32406,
-32618,
-32858,
-32936,
-32826,
-32669,
-32647,
-32785,
-32948,
-32983,
-32898,
-32778,
-32736,
-32749,
-32796,
-32807,
-32788,
-32697,
-32578,
-32479,
-32488,
-32596,
-32700,
-32707,
-32608,
-32504,
-32484,
-32553,
-32675,
-32802,
-32913,
-32968,
-32924,
-32816,
-32732,
-32756,
-32852,
-32923,
-32889,
-32825,
-32799,
-32852,
-32902,
-32892,
-32845,
-32824,
-32846,
-32866,
-32830,
-32772,
-32729,
-32752,
-32790,
-32823,
-32825,
-32826,
-32825,
-32847,
-32879,
-32951,
-33008,
-33022,
-32936,
-32803,
-32707,
-32702,
-32773,
-32827,
-32823,
-32764,
-32722,
-32726,
-32769,
-32793,
-32796,
-32756,
-32731,
-32707,
-32695,
-32678,
-32655,
-32631,
-32625,
-32623,
-32631,
-32629,
-32624,
-32622,
-32623,
-32614,
-32602,
-32565,
-32536,
-32502,
-32488,
-32490,
-32525,
-32571,
-32619,
-32647,
-32647,
-32656,
-32667,
-32700,
-32724,
-32743,
-32762,
-32783,
-32811,
-32817,
-32810,
-32792,
-32793,
-32806,
-32835,
-32850,
-32860,
-32851,
-32852,
-32849,
-32877,
-32902,
-32944,
-32948,
-32950,
-32924,
-32926,
-32944,
-32978,
-33010,
-33021,
-33021,
-33020,
-33036,
-33060,
-33092,
-33096,
-33093,
-33079,
-33079,
-33100,
-33119,
-33141,
-33161,
-33180,
-33208,
-33215,
-33216,
-33196,
-33194,
-33187,
-33186,
-33159,
-33129,
-33099,
-33091,
-33098,
-33107,
-33116,
-33120,
-33125,
-33127,
-33129,
-33123,
-33104,
-33072,
-33028,
-32991,
-32983,
-32993,
-33030,
-33052,
-33072,
-33072,
-33073,
-33077,
-33078,
-33091,
-33088,
-33095,
-33088,
-33089,
-33083,
-33087,
-33084,
-33087,
-33088,
-33083,
-33082,
-33073,
-33072,
-33068,
-33074,
-33070,
-33066,
-33057,
-33042,
-33033,
-33019,
-33019,
-33022,
-33027,
-33025,
-33003,
-32992,
-32990,
-33017,
-33049,
-33071,
-33069,
-33058,
-33046,
-33024,
-32980,
-32918,
-32851,
-32829,
-32832,
-32847,
-32833,
-32802,
-32782,
-32801,
-32840,
-32863,
-32850,
-32822,
-32810,
-32821,
-32840,
-32847,
-32835,
-32844,
-32834,
-32841,
-32808,
-32784,
-32772,
-32790,
-32813,
-32832,
-32821,
-32815,
-32808,
-32812,
-32824,
-32828,
-32841,
-32850,
-32869,
-32877,
-32883,
-32863,
-32844,
-32818,
-32810,
-32810,
-32813,
-32805,
-32789,
-32763,
-32734,
-32714,
-32694,
-32710,
-32734,
-32780,
-32817,
-32825,
-32822,
-32791,
-32754,
-32718,
-32684,
-32670,
-32663,
-32648,
-32628,
-32604,
-32594,
-32606,
-32613,
-32621,
-32615,
-32623,
-32638,
-32650,
-32656,
-32631,
-32625,
-32625,
-32646,
-32673,
-32679,
-32679,
-32669,
-32668,
-32688,
-32723,
-32766,
-32807,
-32824,
-32827,
-32811,
-32801,
-32796,
-32799,
-32799,
-32778,
-32751,
-32715,
-32704,
-32709,
-32722,
-32709,
-32664,
-32610,
-32564,
-32562,
-32556,
-32554,
-32529,
-32520,
-32535,
-32576,
-32625,
-32666,
-32709,
-32741,
-32765,
-32744,
-32720,
-32698,
-32728,
-32757,
-32772,
-32735,
-32715,
-32723,
-32781,
-32818,
-32804,
-32749,
-32696,
-32659,
-32631,
-32567,
-32485,
-32415,
-32371,
-32356,
-32352,
-32365,
-32420,
-32511,
-32608,
-32695,
-32759,
-32825,
-32881,
-32926,
-32935,
-32968,
-33014,
-33096,
-33154,
-33170,
-33161,
-33148,
-33131,
-33072,
-32949,
-32809,
-32707,
-32683,
-32699,
-32703,
-32676,
-32636,
-32614,
-32605,
-32596,
-32579,
-32583,
-32609,
-32656,
-32708,
-32761,
-32844,
-32968,
-33113,
-33240,
-33302,
-33300,
-33249,
-33196,
-33169,
-33158,
-33171,
-33160,
-33146,
-33139,
-33153,
-33185,
-33215,
-33209,
-33188,
-33144,
-33091,
-33012,
-32917,
-32828,
-32802,
-32838,
-32923,
-33005,
-33059,
-33086,
-33101,
-33103,
-33083,
-33049,
-32986,
-32923,
-32853,
-32797,
-32760,
-32747,
-32738,
-32709,
-32654,
-32588,
-32548,
-32535,
-32530,
-32502,
-32440,
-32374,
-32330,
-32327,
-32367,
-32436,
-32548,
-32670,
-32781,
-32839,
-32833,
-32798,
-32765,
-32764,
-32774,
-32800,
-32824,
-32875,
-32932,
-32996,
-33028,
-33041,
-33027,
-32989,
-32925,
-32822,
-32740,
-32676,
-32679,
-32685,
-32683,
-32668,
-32650,
-32680,
-32718,
-32758,
-32776,
-32779,
-32795,
-32812,
-32839,
-32860,
-32906,
-32958,
-33042,
-33105,
-33153,
-33159,
-33136,
-33088,
-33048,
-33027,
-33039,
-33070,
-33113,
-33159,
-33187,
-33203,
-33170,
-33121,
-33056,
-33009,
-32971,
-32922,
-32864,
-32792,
-32751,
-32736,
-32746,
-32764,
-32777,
-32789,
-32798,
-32801,
-32798,
-32793,
-32779,
-32772,
-32756,
-32743,
-32735,
-32716,
-32699,
-32679,
-32681,
-32699,
-32727,
-32724,
-32691,
-32627,
-32555,
-32483,
-32411,
-32341,
-32306,
-32303,
-32353,
-32409,
-32463,
-32487,
-32499,
-32496,
-32506,
-32502,
-32517,
-32519,
-32548,
-32585,
-32645,
-32700,
-32735,
-32746,
-32726,
-32701,
-32669,
-32658,
-32660,
-32691,
-32712,
-32725,
-32710,
-32714,
-32754,
-32841,
-32938,
-33005,
-33020,
-33007,
-32977,
-32969,
-32964,
-32990,
-33021,
-33054,
-33056,
-33013,
-32929,
-32820,
-32720,
-32643,
-32604,
-32605,
-32616,
-32645,
-32672,
-32721,
-32778,
-32830,
-32817,
-32764,
-32677,
-32648,
-32679,
-32754,
-32822,
-32855,
-32881,
-32902,
-32930,
-32913,
-32860,
-32770,
-32701,
-32657,
-32623,
-32585,
-32515,
-32467,
-32449,
-32481,
-32531,
-32570,
-32582,
-32582,
-32580,
-32581,
-32570,
-32549,
-32517,
-32481,
-32439,
-32376,
-32302,
-32238,
-32200,
-32200,
-32226,
-32251,
-32280,
-32293,
-32308,
-32308,
-32321,
-32340,
-32381,
-32429,
-32493,
-32560,
-32657,
-32752,
-32843,
-32890,
-32891,
-32851,
-32776,
-32703,
-32628,
-32603,
-32602,
-32625,
-32631,
-32624,
-32641,
-32702,
-32812,
-32903,
-32944,
-32925,
-32889,
-32878,
-32889,
-32921,
-32945,
-32967,
-32962,
-32915,
-32821,
-32712,
-32639,
-32644,
-32701,
-32774,
-32824,
-32830,
-32827,
-32823,
-32834,
-32853,
-32849,
-32799,
-32713,
-32624,
-32607,
-32673,
-32801,
-32915,
-32980,
-32993,
-32997,
-32991,
-32978,
-32933,
-32878,
-32826,
-32772,
-32685,
-32556,
-32447,
-32423,
-32545,
-32720,
-32857,
-32865,
-32790,
-32722,
-32749,
-32827,
-32902,
-32896,
-32824,
-32752,
-32722,
-32767,
-32852,
-32934,
-32960,
-32892,
-32765,
-32638,
-32587,
-32620,
-32676,
-32684,
-32622,
-32537,
-32505,
-32568,
-32711,
-32884,
-33035,
-33109,
-33095,
-32983,
-32844,
-32723,
-32676,
-32664,
-32640,
-32567,
-32470,
-32420,
-32438,
-32514,
-32569,
-32566,
-32516,
-32474,
-32463,
-32496,
-32524,
-32555,
-32580,
-32618,
-32654,
-32684,
-32717,
-32765,
-32830,
-32886,
-32883,
-32834,
-32737,
-32661,
-32626,
-32656,
-32727,
-32807,
-32852,
-32848,
-32823,
-32819,
-32863,
-32935,
-32982,
-32987,
-32963,
-32941,
-32943,
-32938,
-32912,
-32842,
-32778,
-32739,
-32769,
-32832,
-32904,
-32927,
-32917,
-32881,
-32852,
-32844,
-32846,
-32861,
-32897,
-32940,
-32969,
-32969,
-32938,
-32929,
-32966,
-33019,
-33055,
-33032,
-32991,
-32967,
-32996,
-33024,
-33017,
-32934,
-32811,
-32696,
-32620,
-32594,
-32581,
-32591,
-32611,
-32651,
-32698,
-32733,
-32745,
-32760,
-32802,
-32874,
-32961,
-33014,
-33014,
-32968,
-32910,
-32871,
-32872,
-32883,
-32883,
-32829,
-32748,
-32663,
-32628,
-32649,
-32688,
-32724,
-32733,
-32746,
-32771,
-32810,
-32844,
-32858,
-32872,
-32871,
-32885,
-32877,
-32884,
-32885,
-32902,
-32911,
-32891,
-32847,
-32784,
-32752,
-32757,
-32806,
-32847,
-32863,
-32829,
-32786,
-32754,
-32746,
-32763,
-32768,
-32779,
-32765,
-32735,
-32686,
-32644,
-32654,
-32726,
-32841,
-32935,
-32990,
-32988,
-32980,
-32963,
-32972,
-32988,
-33020,
-33027,
-33000,
-32909,
-32801,
-32706,
-32673,
-32681,
-32718,
-32739,
-32756,
-32757,
-32781,
-32818,
-32883,
-32926,
-32924,
-32859,
-32777,
-32735,
-32768,
-32852,
-32918,
-32935,
-32907,
-32876,
-32890,
-32928,
-32980,
-33003,
-32993,
-32957,
-32918,
-32893,
-32894,
-32931,
-33003,
-33115,
-33229,
-33317,
-33319,
-33233,
-33057,
-32840,
-32617,
-32419,
-32265,
-32144,
-32047,
-31973,
-31913,
-31883,
-31857,
-31832,
-31798,
-31798,
-31861,
-32014,
-32224,
-32455,
-32675,
-32877,
-33034,
-33154,
-33227,
-33305,
-33428,
-33583,
-33725,
-33779,
-33738,
-33634,
-33534,
-33452,
-33384,
-33298,
-33191,
-33073,
-32963,
-32876,
-32823,
-32792,
-32770,
-32716,
-32645,
-32563,
-32511,
-32514,
-32532,
-32575,
-32583,
-32591,
-32598,
-32645,
-32738,
-32869,
-32983,
-33047,
-33036,
-32993,
-32920,
-32868,
-32788,
-32708,
-32621,
-32549,
-32507,
-32471,
-32438,
-32425,
-32436,
-32489,
-32540,
-32546,
-32501,
-32408,
-32339,
-32306,
-32325,
-32351,
-32364,
-32344,
-32323,
-32329,
-32376,
-32455,
-32514,
-32533,
-32501,
-32463,
-32437,
-32459,
-32482,
-32519,
-32529,
-32564,
-32601,
-32671,
-32742,
-32821,
-32907,
-32980,
-33024,
-32995,
-32917,
-32802,
-32733,
-32697,
-32729,
-32786,
-32865,
-32930,
-32964,
-32943,
-32903,
-32869,
-32880,
-32936,
-32975,
-32997,
-32955,
-32909,
-32892,
-32916,
-32998,
-33059,
-33103,
-33088,
-33064,
-33057,
-33093,
-33147,
-33174,
-33158,
-33075,
-32993,
-32911,
-32887,
-32905,
-32968,
-33037,
-33090,
-33113,
-33104,
-33085,
-33063,
-33039,
-33010,
-32972,
-32936,
-32908,
-32877,
-32850,
-32792,
-32755,
-32725,
-32737,
-32730,
-32682,
-32573,
-32461,
-32407,
-32453,
-32538,
-32617,
-32611,
-32562,
-32482,
-32437,
-32421,
-32438,
-32474,
-32494,
-32496,
-32467,
-32448,
-32471,
-32527,
-32574,
-32562,
-32465,
-32335,
-32228,
-32185,
-32206,
-32271,
-32343,
-32417,
-32468,
-32490,
-32483,
-32475,
-32489,
-32564,
-32657,
-32764,
-32815,
-32846,
-32857,
-32897,
-32943,
-32984,
-32962,
-32888,
-32773,
-32657,
-32603,
-32589,
-32636,
-32652,
-32640,
-32572,
-32499,
-32454,
-32443,
-32485,
-32570,
-32710,
-32863,
-32983,
-33033,
-33033,
-33024,
-33032,
-33015,
-32952,
-32840,
-32746,
-32709,
-32728,
-32752,
-32744,
-32724,
-32685,
-32673,
-32647,
-32636,
-32643,
-32675,
-32730,
-32774,
-32797,
-32795,
-32783,
-32780,
-32804,
-32849,
-32893,
-32895,
-32855,
-32792,
-32759,
-32771,
-32814,
-32855,
-32868,
-32857,
-32831,
-32790,
-32764,
-32763,
-32808,
-32886,
-32962,
-32997,
-33007,
-32988,
-32967,
-32937,
-32895,
-32856,
-32838,
-32864,
-32927,
-33002,
-33063,
-33064,
-33024,
-32935,
-32851,
-32772,
-32714,
-32657,
-32615,
-32588,
-32592,
-32610,
-32631,
-32641,
-32661,
-32691,
-32750,
-32809,
-32854,
-32865,
-32837,
-32789,
-32742,
-32713,
-32726,
-32749,
-32781,
-32791,
-32779,
-32764,
-32740,
-32747,
-32752,
-32764,
-32766,
-32757,
-32765,
-32796,
-32848,
-32903,
-32936,
-32954,
-32968,
-32985,
-33005,
-32997,
-32970,
-32912,
-32851,
-32781,
-32714,
-32651,
-32602,
-32577,
-32567,
-32575,
-32582,
-32610,
-32639,
-32686,
-32726,
-32760,
-32787,
-32806,
-32826,
-32850,
-32860,
-32876,
-32879,
-32900,
-32928,
-32958,
-32970,
-32969,
-32956,
-32967,
-32971,
-32961,
-32902,
-32803,
-32716,
-32648,
-32636,
-32639,
-32660,
-32670,
-32674,
-32656,
-32639,
-32630,
-32656,
-32703,
-32739,
-32751,
-32731,
-32720,
-32729,
-32756,
-32788,
-32809,
-32827,
-32831,
-32823,
-32789,
-32754,
-32730,
-32735,
-32753,
-32767,
-32777,
-32778,
-32803,
-32831,
-32872,
-32893,
-32895,
-32876,
-32860,
-32850,
-32855,
-32851,
-32834,
-32819,
-32813,
-32807,
-32790,
-32740,
-32709,
-32719,
-32763,
-32803,
-32796,
-32773,
-32784,
-32828,
-32873,
-32850,
-32778,
-32706,
-32686,
-32708,
-32750,
-32780,
-32814,
-32835,
-32827,
-32797,
-32762,
-32793,
-32859,
-32953,
-32989,
-32988,
-32959,
-32932,
-32911,
-32886,
-32870,
-32878,
-32911,
-32941,
-32938,
-32886,
-32808,
-32740,
-32716,
-32727,
-32759,
-32758,
-32724,
-32668,
-32640,
-32659,
-32720,
-32774,
-32796,
-32773,
-32733,
-32674,
-32628,
-32575,
-32551,
-32539,
-32557,
-32567,
-32593,
-32623,
-32706,
-32801,
-32896,
-32920,
-32890,
-32822,
-32781,
-32752,
-32747,
-32727,
-32728,
-32765,
-32833,
-32891,
-32898,
-32846,
-32763,
-32681,
-32614,
-32580,
-32582,
-32610,
-32655,
-32674,
-32690,
-32709,
-32744,
-32776,
-32801,
-32820,
-32885,
-32965,
-33012,
-32979,
-32875,
-32788,
-32764,
-32797,
-32830,
-32821,
-32791,
-32754,
-32711,
-32669,
-32638,
-32653,
-32723,
-32784,
-32800,
-32756,
-32704,
-32691,
-32712,
-32747,
-32769,
-32792,
-32818,
-32827,
-32800,
-32740,
-32700,
-32712,
-32783,
-32857,
-32873,
-32835,
-32744,
-32687,
-32659,
-32678,
-32695,
-32701,
-32688,
-32667,
-32639,
-32607,
-32556,
-32523,
-32513,
-32543,
-32613,
-32693,
-32778,
-32842,
-32869,
-32842,
-32795,
-32747,
-32735,
-32751,
-32768,
-32794,
-32835,
-32896,
-32938,
-32946,
-32913,
-32907,
-32931,
-32973,
-32960,
-32882,
-32769,
-32678,
-32633,
-32622,
-32633,
-32674,
-32738,
-32814,
-32862,
-32887,
-32895,
-32908,
-32908,
-32879,
-32813,
-32743,
-32688,
-32667,
-32676,
-32717,
-32789,
-32853,
-32888,
-32851,
-32792,
-32732,
-32724,
-32736,
-32760,
-32777,
-32806,
-32838,
-32869,
-32865,
-32831,
-32797,
-32798,
-32840,
-32897,
-32919,
-32877,
-32792,
-32695,
-32633,
-32626,
-32650,
-32714,
-32783,
-32866,
-32915,
-32936,
-32913,
-32899,
-32909,
-32935,
-32936,
-32873,
-32743,
-32604,
-32490,
-32438,
-32428,
-32414,
-32399,
-32365,
-32383,
-32467,
-32608,
-32757,
-32835,
-32838,
-32807,
-32797,
-32839,
-32888,
-32913,
-32903,
-32886,
-32882,
-32895,
-32895,
-32901,
-32919,
-32968,
-33013,
-33004,
-32897,
-32727,
-32552,
-32447,
-32444,
-32495,
-32536,
-32520,
-32466,
-32419,
-32446,
-32525,
-32627,
-32703,
-32737,
-32751,
-32763,
-32791,
-32834,
-32891,
-32963,
-33018,
-33044,
-33013,
-32941,
-32849,
-32757,
-32670,
-32589,
-32528,
-32500,
-32511,
-32550,
-32583,
-32602,
-32591,
-32570,
-32567,
-32597,
-32684,
-32792,
-32887,
-32933,
-32940,
-32945,
-32962,
-32980,
-32952,
-32889,
-32812,
-32780,
-32784,
-32788,
-32740,
-32650,
-32555,
-32517,
-32535,
-32594,
-32646,
-32673,
-32680,
-32674,
-32696,
-32724,
-32762,
-32777,
-32761,
-32750,
-32750,
-32784,
-32799,
-32799,
-32765,
-32745,
-32743,
-32753,
-32738,
-32717,
-32690,
-32713,
-32753,
-32797,
-32801,
-32793,
-32785,
-32806,
-32837,
-32855,
-32851,
-32825,
-32804,
-32781,
-32773,
-32761,
-32751,
-32734,
-32713,
-32692,
-32676,
-32685,
-32709,
-32751,
-32797,
-32826,
-32846,
-32834,
-32810,
-32790,
-32778,
-32807,
-32832,
-32874,
-32896,
-32918,
-32924,
-32914,
-32879,
-32831,
-32792,
-32772,
-32764,
-32749,
-32722,
-32698,
-32692,
-32712,
-32744,
-32773,
-32793,
-32802,
-32804,
-32805,
-32799,
-32791,
-32768,
-32745,
-32725,
-32713,
-32713,
-32705,
-32694,
-32681,
-32680,
-32708,
-32748,
-32790,
-32828,
-32833,
-32850,
-32830,
-32827,
-32809,
-32807,
-32807,
-32806,
-32807,
-32803,
-32803,
-32805,
-32800,
-32801,
-32787,
-32781,
-32749,
-32716,
-32668,
-32640,
-32644,
-32675,
-32730,
-32766,
-32795,
-32794,
-32804,
-32807,
-32830,
-32836,
-32833,
-32804,
-32767,
-32732,
-32706,
-32693,
-32684,
-32675,
-32678,
-32678,
-32695,
-32706,
-32721,
-32731,
-32750,
-32765,
-32785,
-32792,
-32794,
-32793,
-32796,
-32805,
-32803,
-32804,
-32781,
-32776,
-32766,
-32771,
-32775,
-32772,
-32765,
-32735,
-32717,
-32680,
-32673,
-32665,
-32674,
-32679,
-32680,
-32682,
-32694,
-32718,
-32747,
-32771,
-32781,
-32792,
-32785,
-32789,
-32780,
-32775,
-32768,
-32765,
-32756,
-32750,
-32745,
-32736,
-32734,
-32721,
-32715,
-32711,
-32712,
-32719,
-32726,
-32739,
-32757,
-32783,
-32806,
-32835,
-32850,
-32862,
-32865,
-32867,
-32871,
-32893,
-32911,
-32934,
-32942,
-32950,
-32972,
-33004,
-33043,
-33069,
-33082,
-33092,
-33093,
-33099,
-33087,
-33070,
-33055,
-33038,
-33020,
-32982,
-32931,
-32874,
-32831,
-32787,
-32753,
-32701,
-32671,
-32640,
-32631,
-32606,
-32570,
-32515,
-32481,
-32453,
-32456,
-32455,
-32465,
-32478,
-32514,
-32548,
-32589,
-32608,
-32627,
-32647,
-32673,
-32696,
-32709,
-32707,
-32708,
-32704,
-32714,
-32709,
-32710,
-32708,
-32710,
-32721,
-32712,
-32706,
-32675,
-32665,
-32649,
-32654,
-32656,
-32670,
-32688,
-32716,
-32752,
-32780,
-32823,
-32851,
-32882,
-32898,
-32901,
-32902,
-32900,
-32902,
-32899,
-32897,
-32892,
-32892,
-32879,
-32876,
-32867,
-32881,
-32899,
-32911,
-32904,
-32883,
-32862,
-32852,
-32848,
-32837,
-32833,
-32837,
-32855,
-32871,
-32879,
-32870,
-32867,
-32865,
-32868,
-32870,
-32860,
-32855,
-32832,
-32818,
-32790,
-32768,
-32743,
-32715,
-32685,
-32658,
-32637,
-32621,
-32609,
-32592,
-32586,
-32585,
-32604,
-32616,
-32636,
-32644,
-32663,
-32677,
-32692,
-32692,
-32699,
-32694,
-32703,
-32693,
-32687,
-32669,
-32670,
-32665,
-32676,
-32668,
-32668,
-32664,
-32663,
-32675,
-32686,
-32710,
-32730,
-32756,
-32765,
-32790,
-32798,
-32823,
-32839,
-32858,
-32873,
-32886,
-32903,
-32908,
-32920,
-32917,
-32918,
-32911,
-32902,
-32890,
-32883,
-32879,
-32875,
-32875,
-32868,
-32855,
-32846,
-32823,
-32821,
-32813,
-32828,
-32842,
-32859,
-32871,
-32871,
-32865,
-32850,
-32831,
-32813,
-32802,
-32797,
-32795,
-32789,
-32781,
-32772,
-32773,
-32770,
-32772,
-32771,
-32770,
-32769,
-32764,
-32745,
-32727,
-32709,
-32708,
-32719,
-32728,
-32733,
-32722,
-32712,
-32692,
-32672,
-32641,
-32605,
-32578,
-32560,
-32568,
-32585,
-32603,
-32627,
-32635,
-32660,
-32671,
-32695,
-32699,
-32720,
-32724,
-32748,
-32746,
-32744,
-32731,
-32724,
-32736,
-32746,
-32763,
-32771,
-32786,
-32799,
-32813,
-32813,
-32805,
-32800,
-32798,
-32802,
-32794,
-32775,
-32761,
-32751,
-32762,
-32767,
-32764,
-32754,
-32740,
-32735,
-32742,
-32744,
-32752,
-32748,
-32747,
-32749,
-32762,
-32782,
-32808,
-32821,
-32831,
-32817,
-32816,
-32803,
-32806,
-32807,
-32814,
-32830,
-32848,
-32867,
-32867,
-32857,
-32838,
-32813,
-32807,
-32797,
-32803,
-32811,
-32816,
-32832,
-32833,
-32840,
-32832,
-32823,
-32807,
-32795,
-32788,
-32781,
-32778,
-32766,
-32760,
-32751,
-32756,
-32754,
-32759,
-32748,
-32737,
-32722,
-32709,
-32695,
-32687,
-32675,
-32671,
-32671,
-32662,
-32661,
-32657,
-32662,
-32678,
-32687,
-32706,
-32717,
-32739,
-32760,
-32778,
-32782,
-32784,
-32776,
-32774,
-32756,
-32742,
-32710,
-32701,
-32691,
-32697,
-32701,
-32697,
-32697,
-32698,
-32698,
-32704,
-32705,
-32712,
-32720,
-32724,
-32713,
-32709,
-32693,
-32701,
-32704,
-32713,
-32724,
-32740,
-32761,
-32786,
-32791,
-32802,
-32798,
-32809,
-32815,
-32821,
-32827,
-32839,
-32859,
-32877,
-32887,
-32882,
-32888,
-32890,
-32911,
-32909,
-32914,
-32902,
-32905,
-32905,
-32901,
-32898,
-32894,
-32910,
-32929,
-32948,
-32955,
-32947,
-32942,
-32926,
-32918,
-32900,
-32893,
-32892,
-32896,
-32886,
-32873,
-32838,
-32839,
-32835,
-32856,
-32863,
-32877,
-32883,
-32907,
-32920,
-32941,
-32951,
-32970,
-32989,
-33012,
-33025,
-33014,
-32990,
-32938,
-32881,
-32814,
-32742,
-32671,
-32601,
-32533,
-32481,
-32443,
-32422,
-32407,
-32396,
-32377,
-32374,
-32377,
-32417,
-32469,
-32551,
-32633,
-32726,
-32813,
-32890,
-32953,
-32994,
-33026,
-33039,
-33039,
-33018,
-32973,
-32921,
-32852,
-32796,
-32717,
-32639,
-32542,
-32441,
-32352,
-32272,
-32214,
-32182,
-32172,
-32193,
-32215,
-32244,
-32262,
-32293,
-32328,
-32386,
-32445,
-32516,
-32579,
-32657,
-32728,
-32817,
-32888,
-32950,
-32976,
-32982,
-32970,
-32957,
-32948,
-32939,
-32931,
-32933,
-32925,
-32935,
-32922,
-32918,
-32895,
-32882,
-32866,
-32867,
-32861,
-32870,
-32858,
-32853,
-32834,
-32824,
-32811,
-32807,
-32809,
-32822,
-32830,
-32830,
-32802,
-32771,
-32740,
-32724,
-32718,
-32702,
-32697,
-32694,
-32722,
-32749,
-32769,
-32763,
-32753,
-32755,
-32782,
-32819,
-32857,
-32860,
-32857,
-32825,
-32809,
-32792,
-32777,
-32753,
-32737,
-32718,
-32731,
-32741,
-32754,
-32755,
-32735,
-32699,
-32652,
-32625,
-32644,
-32716,
-32788,
-32828,
-32804,
-32775,
-32777,
-32816,
-32833,
-32787,
-32691,
-32618,
-32621,
-32680,
-32735,
-32730,
-32678,
-32633,
-32651,
-32740,
-32859,
-32948,
-32950,
-32889,
-32815,
-32794,
-32866,
-33003,
-33142,
-33236,
-33213,
-33089,
-32899,
-32746,
-32675,
-32671,
-32629,
-32505,
-32341,
-32275,
-32355,
-32535,
-32669,
-32734,
-32767,
-32867,
-33015,
-33125,
-33138,
-33095,
-33074,
-33121,
-33163,
-33113,
-32942,
-32735,
-32608,
-32634,
-32757,
-32820,
-32696,
-32402,
-32091,
-31978,
-32118,
-32420,
-32720,
-32910,
-33005,
-33028,
-33031,
-33018,
-33055,
-33141,
-33233,
-33215,
-33058,
-32831,
-32676,
-32650,
-32694,
-32709,
-32647,
-32519,
-32370,
-32222,
-32155,
-32209,
-32411,
-32673,
-32873,
-32963,
-32952,
-32937,
-32953,
-33023,
-33085,
-33055,
-32888,
-32626,
-32462,
-32514,
-32747,
-32914,
-32850,
-32598,
-32409,
-32418,
-32559,
-32652,
-32657,
-32664,
-32752,
-32862,
-32888,
-32855,
-32878,
-33021,
-33179,
-33230,
-33124,
-32958,
-32816,
-32707,
-32634,
-32597,
-32619,
-32666,
-32683,
-32652,
-32622,
-32609,
-32611,
-32614,
-32658,
-32770,
-32899,
-32955,
-32932,
-32927,
-33039,
-33166,
-33188,
-33020,
-32822,
-32758,
-32832,
-32933,
-32930,
-32856,
-32795,
-32756,
-32716,
-32653,
-32630,
-32677,
-32758,
-32784,
-32747,
-32701,
-32713,
-32779,
-32861,
-32910,
-32942,
-32943,
-32945,
-32936,
-32941,
-32922,
-32878,
-32805,
-32765,
-32768,
-32783,
-32739,
-32654,
-32586,
-32609,
-32653,
-32648,
-32551,
-32478,
-32505,
-32633,
-32746,
-32773,
-32741,
-32721,
-32740,
-32762,
-32772,
-32794,
-32857,
-32916,
-32895,
-32751,
-32567,
-32465,
-32501,
-32627,
-32719,
-32720,
-32674,
-32642,
-32673,
-32708,
-32714,
-32707,
-32741,
-32824,
-32902,
-32892,
-32828,
-32779,
-32818,
-32880,
-32871,
-32761,
-32618,
-32560,
-32592,
-32673,
-32724,
-32752,
-32763,
-32743,
-32678,
-32586,
-32544,
-32586,
-32652,
-32623,
-32472,
-32295,
-32264,
-32452,
-32758,
-32995,
-33035,
-32927,
-32805,
-32787,
-32834,
-32865,
-32818,
-32755,
-32768,
-32863,
-32953,
-32967,
-32905,
-32857,
-32843,
-32839,
-32786,
-32728,
-32728,
-32789,
-32836,
-32778,
-32663,
-32610,
-32700,
-32866,
-32966,
-32943,
-32855,
-32828,
-32881,
-32957,
-32969,
-32913,
-32866,
-32877,
-32948,
-33010,
-33024,
-32986,
-32941,
-32907,
-32903,
-32904,
-32904,
-32889,
-32849,
-32799,
-32744,
-32722,
-32717,
-32720,
-32721,
-32703,
-32714,
-32728,
-32763,
-32785,
-32789,
-32749,
-32677,
-32597,
-32584,
-32685,
-32833,
-32952,
-32932,
-32870,
-32840,
-32893,
-32924,
-32836,
-32643,
-32506,
-32509,
-32615,
-32679,
-32626,
-32518,
-32459,
-32480,
-32550,
-32616,
-32666,
-32692,
-32664,
-32594,
-32513,
-32509,
-32616,
-32800,
-32996,
-33109,
-33095,
-32941,
-32739,
-32596,
-32595,
-32682,
-32749,
-32741,
-32703,
-32725,
-32808,
-32878,
-32888,
-32852,
-32849,
-32870,
-32884,
-32855,
-32818,
-32816,
-32848,
-32888,
-32898,
-32910,
-32904,
-32877,
-32822,
-32764,
-32759,
-32786,
-32799,
-32772,
-32721,
-32715,
-32758,
-32836,
-32898,
-32932,
-32915,
-32842,
-32734,
-32670,
-32693,
-32801,
-32873,
-32855,
-32773,
-32716,
-32734,
-32757,
-32727,
-32647,
-32610,
-32664,
-32755,
-32800,
-32769,
-32728,
-32752,
-32812,
-32844,
-32796,
-32719,
-32691,
-32737,
-32797,
-32810,
-32749,
-32693,
-32663,
-32695,
-32721,
-32751,
-32752,
-32762,
-32764,
-32754,
-32750,
-32751,
-32777,
-32796,
-32796,
-32778,
-32748,
-32733,
-32710,
-32695,
-32671,
-32680,
-32698,
-32739,
-32771,
-32790,
-32794,
-32775,
-32751,
-32743,
-32760,
-32808,
-32847,
-32852,
-32832,
-32788,
-32769,
-32751,
-32746,
-32727,
-32714,
-32691,
-32675,
-32645,
-32616,
-32590,
-32582,
-32583,
-32583,
-32568,
-32555,
-32556,
-32595,
-32648,
-32694,
-32709,
-32702,
-32693,
-32695,
-32685,
-32672,
-32648,
-32647,
-32665,
-32682,
-32687,
-32683,
-32689,
-32703,
-32714,
-32702,
-32680,
-32656,
-32642,
-32618,
-32605,
-32595,
-32616,
-32649,
-32684,
-32712,
-32728,
-32734,
-32723,
-32696,
-32676,
-32667,
-32678,
-32680,
-32685,
-32683,
-32697,
-32718,
-32723,
-32737,
-32742,
-32778,
-32797,
-32815,
-32798,
-32795,
-32787,
-32807,
-32826,
-32863,
-32896,
-32915,
-32901,
-32864,
-32825,
-32813,
-32821,
-32833,
-32828,
-32818,
-32816,
-32823,
-32840,
-32840,
-32839,
-32822,
-32810,
-32800,
-32796,
-32806,
-32803,
-32817,
-32815,
-32840,
-32849,
-32848,
-32818,
-32784,
-32755,
-32745,
-32721,
-32694,
-32660,
-32666,
-32699,
-32752,
-32776,
-32772,
-32745,
-32724,
-32716,
-32714,
-32705,
-32687,
-32671,
-32667,
-32679,
-32706,
-32716,
-32725,
-32708,
-32700,
-32681,
-32679,
-32669,
-32679,
-32684,
-32694,
-32695,
-32692,
-32693,
-32690,
-32688,
-32674,
-32666,
-32672,
-32695,
-32718,
-32726,
-32712,
-32712,
-32716,
-32741,
-32754,
-32755,
-32749,
-32752,
-32759,
-32770,
-32778,
-32782,
-32802,
-32816,
-32840,
-32839,
-32822,
-32796,
-32765,
-32762,
-32759,
-32773,
-32778,
-32787,
-32800,
-32820,
-32829,
-32823,
-32805,
-32788,
-32786,
-32795,
-32797,
-32799,
-32797,
-32798,
-32805,
-32807,
-32807,
-32810,
-32803,
-32798,
-32787,
-32780,
-32793,
-32804,
-32816,
-32808,
-32793,
-32787,
-32794,
-32814,
-32824,
-32832,
-32823,
-32827,
-32822,
-32834,
-32834,
-32846,
-32840,
-32838,
-32822,
-32810,
-32797,
-32781,
-32781,
-32785,
-32805,
-32819,
-32819,
-32809,
-32796,
-32795,
-32790,
-32782,
-32761,
-32751,
-32752,
-32771,
-32778,
-32776,
-32759,
-32751,
-32753,
-32754,
-32760,
-32749,
-32750,
-32748,
-32755,
-32765,
-32772,
-32778,
-32779,
-32781,
-32776,
-32775,
-32773,
-32770,
-32767,
-32768,
-32764,
-32769,
-32770,
-32771,
-32765,
-32757,
-32741,
-32732,
-32728,
-32731,
-32732,
-32738,
-32744,
-32760,
-32775,
-32782,
-32780,
-32764,
-32761,
-32753,
-32768,
-32768,
-32772,
-32773,
-32773,
-32793,
-32801,
-32813,
-32807,
-32805,
-32793,
-32795,
-32786,
-32780,
-32770,
-32765,
-32763,
-32777,
-32778,
-32789,
-32794,
-32793,
-32794,
-32786,
-32775,
-32775,
-32769,
-32774,
-32769,
-32769,
-32767,
-32777,
-32778,
-32785,
-32775,
-32767,
-32764,
-32762,
-32765,
-32764,
-32753,
-32755,
-32751,
-32758,
-32756,
-32751,
-32752,
-32754,
-32768,
-32777,
-32774,
-32772,
-32761,
-32764,
-32763,
-32764,
-32753,
-32748,
-32746,
-32753,
-32760,
-32758,
-32755,
-32758,
-32771,
-32784,
-32793,
-32784,
-32778,
-32774,
-32782,
-32794,
-32796,
-32801,
-32797,
-32805,
-32808,
-32808,
-32805,
-32801,
-32795,
-32790,
-32782,
-32773,
-32773,
-32781,
-32793,
-32796,
-32799,
-32789,
-32795,
-32798,
-32804,
-32811,
-32811,
-32820,
-32819,
-32825,
-32816,
-32815,
-32808,
-32806,
-32808,
-32796,
-32795,
-32780,
-32781,
-32778,
-32787,
-32784,
-32790,
-32789,
-32792,
-32792,
-32788,
-32781,
-32780,
-32791,
-32798,
-32814,
-32804,
-32812,
-32804,
-32817,
-32827,
-32828,
-32825,
-32813,
-32798,
-32795,
-32792,
-32793,
-32799,
-32794,
-32791,
-32775,
-32763,
-32749,
-32754,
-32758,
-32774,
-32783,
-32786,
-32790,
-32792,
-32790,
-32788,
-32777,
-32761,
-32756,
-32752,
-32762,
-32768,
-32781,
-32788,
-32797,
-32795,
-32785,
-32763,
-32749,
-32731,
-32724,
-32709,
-32698,
-32692,
-32712,
-32740,
-32784,
-32802,
-32805,
-32788,
-32772,
-32761,
-32764,
-32752,
-32752,
-32742,
-32758,
-32777,
-32801,
-32806,
-32801,
-32782,
-32776,
-32770,
-32786,
-32796,
-32819,
-32832,
-32833,
-32826,
-32806,
-32797,
-32796,
-32800,
-32806,
-32796,
-32788,
-32777,
-32763,
-32753,
-32742,
-32730,
-32742,
-32736,
-32747,
-32740,
-32748,
-32772,
-32802,
-32837,
-32849,
-32851,
-32848,
-32841,
-32833,
-32816,
-32790,
-32766,
-32746,
-32742,
-32740,
-32757,
-32759,
-32776,
-32778,
-32773,
-32762,
-32728,
-32707,
-32690,
-32702,
-32729,
-32763,
-32790,
-32796,
-32792,
-32773,
-32759,
-32749,
-32757,
-32761,
-32768,
-32758,
-32743,
-32740,
-32745,
-32761,
-32762,
-32758,
-32745,
-32742,
-32740,
-32736,
-32719,
-32710,
-32702,
-32715,
-32733,
-32743,
-32755,
-32752,
-32764,
-32761,
-32761,
-32747,
-32729,
-32732,
-32739,
-32767,
-32779,
-32780,
-32780,
-32770,
-32777,
-32767,
-32759,
-32745,
-32744,
-32748,
-32759,
-32763,
-32772,
-32780,
-32793,
-32802,
-32819,
-32824,
-32830,
-32812,
-32795,
-32774,
-32768,
-32766,
-32774,
-32786,
-32806,
-32817,
-32818,
-32811,
-32814,
-32837,
-32861,
-32880,
-32858,
-32795,
-32684,
-32585,
-32563,
-32683,
-32846,
-32935,
-32881,
-32802,
-32901,
-33157,
-33360,
-33244,
-32858,
-32512,
-32468,
-32660,
-32798,
-32713,
-32502,
-32393,
-32449,
-32600,
-32759,
-32922,
-33047,
-33033,
-32829,
-32613,
-32623,
-32904,
-33207,
-33253,
-33063,
-32883,
-32876,
-32951,
-32901,
-32722,
-32561,
-32531,
-32520,
-32429,
-32262,
-32216,
-32350,
-32598,
-32799,
-32917,
-32959,
-32962,
-32898,
-32839,
-32861,
-32980,
-33098,
-33085,
-32962,
-32852,
-32817,
-32841,
-32844,
-32818,
-32788,
-32690,
-32512,
-32295,
-32241,
-32407,
-32695,
-32875,
-32863,
-32782,
-32753,
-32788,
-32822,
-32831,
-32894,
-33000,
-33033,
-32912,
-32706,
-32601,
-32671,
-32825,
-32894,
-32850,
-32719,
-32575,
-32435,
-32353,
-32418,
-32625,
-32836,
-32915,
-32850,
-32790,
-32854,
-32967,
-33041,
-32996,
-32920,
-32864,
-32803,
-32753,
-32743,
-32848,
-32972,
-32984,
-32810,
-32590,
-32492,
-32561,
-32663,
-32703,
-32675,
-32669,
-32695,
-32713,
-32703,
-32713,
-32780,
-32851,
-32886,
-32864,
-32860,
-32873,
-32888,
-32883,
-32902,
-32964,
-32986,
-32867,
-32628,
-32440,
-32451,
-32603,
-32728,
-32705,
-32626,
-32614,
-32699,
-32782,
-32791,
-32757,
-32751,
-32769,
-32769,
-32744,
-32750,
-32821,
-32925,
-32978,
-32956,
-32894,
-32823,
-32754,
-32666,
-32590,
-32541,
-32537,
-32553,
-32588,
-32644,
-32707,
-32760,
-32770,
-32784,
-32809,
-32863,
-32874,
-32852,
-32812,
-32820,
-32853,
-32868,
-32825,
-32766,
-32723,
-32703,
-32669,
-32615,
-32583,
-32605,
-32658,
-32691,
-32675,
-32665,
-32686,
-32759,
-32808,
-32817,
-32795,
-32786,
-32829,
-32889,
-32941,
-32938,
-32890,
-32819,
-32761,
-32739,
-32735,
-32720,
-32697,
-32651,
-32632,
-32621,
-32625,
-32629,
-32649,
-32687,
-32750,
-32805,
-32845,
-32858,
-32854,
-32847,
-32830,
-32831,
-32834,
-32842,
-32826,
-32787,
-32735,
-32698,
-32700,
-32716,
-32744,
-32734,
-32711,
-32671,
-32664,
-32685,
-32737,
-32771,
-32779,
-32763,
-32764,
-32781,
-32817,
-32818,
-32805,
-32789,
-32785,
-32791,
-32763,
-32717,
-32684,
-32689,
-32727,
-32746,
-32719,
-32678,
-32657,
-32691,
-32744,
-32793,
-32809,
-32812,
-32806,
-32803,
-32800,
-32798,
-32803,
-32802,
-32785,
-32763,
-32730,
-32729,
-32735,
-32756,
-32767,
-32761,
-32743,
-32712,
-32687,
-32682,
-32702,
-32746,
-32777,
-32799,
-32792,
-32782,
-32762,
-32753,
-32737,
-32750,
-32774,
-32802,
-32816,
-32794,
-32769,
-32755,
-32774,
-32798,
-32815,
-32791,
-32764,
-32741,
-32749,
-32786,
-32811,
-32832,
-32819,
-32799,
-32774,
-32752,
-32735,
-32725,
-32724,
-32723,
-32731,
-32735,
-32745,
-32766,
-32786,
-32801,
-32802,
-32783,
-32774,
-32762,
-32777,
-32779,
-32790,
-32793,
-32801,
-32802,
-32804,
-32776,
-32765,
-32739,
-32744,
-32743,
-32751,
-32744,
-32744,
-32739,
-32745,
-32748,
-32744,
-32749,
-32754,
-32771,
-32781,
-32775,
-32768,
-32759,
-32771,
-32783,
-32792,
-32787,
-32776,
-32771,
-32767,
-32764,
-32754,
-32747,
-32750,
-32762,
-32773,
-32775,
-32770,
-32763,
-32752,
-32742,
-32726,
-32726,
-32728,
-32749,
-32754,
-32761,
-32758,
-32763,
-32772,
-32782,
-32780,
-32779,
-32771,
-32773,
-32771,
-32774,
-32771,
-32778,
-32787,
-32803,
-32808,
-32803,
-32786,
-32774,
-32763,
-32768,
-32770,
-32765,
-32767,
-32758,
-32770,
-32775,
-32782,
-32775,
-32770,
-32761,
-32761,
-32756,
-32755,
-32755,
-32765,
-32778,
-32785,
-32784,
-32775,
-32766,
-32767,
-32765,
-32765,
-32769,
-32762,
-32771,
-32764,
-32769,
-32768,
-32778,
-32778,
-32780,
-32768,
-32757,
-32753,
-32749,
-32756,
-32757,
-32761,
-32765,
-32765,
-32769,
-32769,
-32780,
-32781,
-32784,
-32771,
-32765,
-32758,
-32765,
-32766,
-32770,
-32775,
-32773,
-32779,
-32764,
-32758,
-32750,
-32754,
-32769,
-32771,
-32776,
-32769,
-32766,
-32763,
-32760,
-32759,
-32764,
-32769,
-32775,
-32772,
-32765,
-32764,
-32763,
-32774,
-32769,
-32773,
-32760,
-32767,
-32757,
-32762,
-32761,
-32762,
-32770,
-32768,
-32770,
-32774,
-32772,
-32776,
-32769,
-32765,
-32766,
-32762,
-32770,
-32765,
-32767,
-32768,
-32770,
-32775,
-32769,
-32769,
-32761,
-32763,
-32759,
-32760,
-32762,
-32763,
-32775,
-32773,
-32778,
-32776,
-32772,
-32774,
-32766,
-32769,
-32763,
-32767,
-32764,
-32764,
-32762,
-32761,
-32759,
-32757,
-32754,
-32754,
-32754,
-32759,
-32757,
-32762,
-32757,
-32765,
-32767,
-32778,
-32778,
-32782,
-32777,
-32770,
-32770,
-32760,
-32764,
-32761,
-32763,
-32761,
-32760,
-32758,
-32755,
-32754,
-32753,
-32753,
-32758,
-32753,
-32760,
-32751,
-32761,
-32754,
-32761,
-32759,
-32763,
-32766,
-32769,
-32771,
-32765,
-32765,
-32766,
-32765,
-32773,
-32767,
-32771,
-32768,
-32768,
-32767,
-32763,
-32765,
-32765,
-32765,
-32768,
-32769,
-32764,
-32773,
-32761,
-32769,
-32763,
-32764,
-32763,
-32762,
-32761,
-32766,
-32767,
-32772,
-32769,
-32773,
-32771,
-32774,
-32774,
-32770,
-32765,
-32766,
-32762,
-32769,
-32767,
-32768,
-32766,
-32767,
-32767,
-32767,
-32765,
-32764,
-32764,
-32767,
-32767,
-32766,
-32767,
-32765,
-32770,
-32772,
-32770,
-32777,
-32770,
-32780,
-32773,
-32776,
-32770,
-32769,
-32770,
-32771,
-32774,
-32772,
-32772,
-32765,
-32771,
-32765,
-32771,
-32763,
-32765,
-32761,
-32763,
-32762,
-32759,
-32759,
-32761,
-32763,
-32768,
-32768,
-32766,
-32770,
-32765,
-32773,
-32770,
-32773,
-32771,
-32767,
-32772,
-32769,
-32775,
-32770,
-32769,
-32766,
-32766,
-32767,
-32767,
-32767,
-32768,
-32765,
-32768,
-32768,
-32771,
-32770,
-32774,
-32771,
-32773,
-32774,
-32769,
-32771,
-32767,
-32767,
-32770,
-32767,
-32768,
-32767,
-32767,
-32767,
-32768,
-32764,
-32768,
-32765,
-32768,
-32768,
-32766,
-32771,
-32769,
-32776,
-32772,
-32773,
-32772,
-32770,
-32775,
-32768,
-32771,
-32766,
-32766,
-32769,
-32765,
-32769,
-32765,
-32768,
-32768,
-32766,
-32770,
-32767,
-32770,
-32768,
-32766,
-32768,
-32768,
-32767,
-32771,
-32766,
-32772,
-32765,
-32769,
-32765,
-32770,
-32763,
-32771,
-32761,
-32767,
-32763,
-32764,
-32766,
-32766,
-32767,
-32765,
-32768,
-32764,
-32771,
-32764,
-32769,
-32766,
-32767,
-32767,
-32767,
-32766,
-32766,
-32767,
-32764,
-32766,
-32764,
-32763,
-32767,
-32763,
-32769,
-32767,
-32766,
-32768,
-32766,
-32767,
-32767,
-32764,
-32765,
-32768,
-32768,
-32766,
-32768,
-32762,
-32769,
-32764,
-32769,
-32763,
-32766,
-32763,
-32766,
-32768,
-32769,
-32765,
-32769,
-32763,
-32769,
-32766,
-32767,
-32768,
-32766,
-32768,
-32766,
-32767,
-32768,
-32768,
-32767,
-32769,
-32765,
-32767,
-32768,
-32766,
-32769,
-32763,
-32767,
-32764,
-32769,
-32766,
-32766,
-32765,
-32767,
-32765,
-32768,
-32764,
-32767,
-32765,
-32766,
-32768,
-32764,
-32768,
-32763,
-32768,
-32762,
-32767,
-32762,
-32766,
-32768,
-32762,
-32769,
-32763,
-32766,
-32768,
-32765,
-32768,
-32768,
-32765,
-32768,
-32764,
-32768,
-32766,
-32769,
-32765,
-32768,
-32764,
-32768,
-32767,
-32766,
-32766,
-32763,
-32767,
-32766,
-32767,
-32768,
-32764,
-32766,
-32765,
-32765,
-32768,
-32765,
-32766,
-32766,
-32765,
-32767,
-32764,
-32765,
-32767,
-32766,
-32768,
-32765,
-32766,
-32765,
-32765,
-32768,
-32765,
-32768,
-32767,
-32765,
-32766,
-32765,
-32763,
-32769,
-32764,
-32770,
-32764,
-32768,
-32765,
-32766,
-32769,
-32765,
-32769,
-32766,
-32768,
-32764,
-32767,
-32764,
-32768,
-32766,
-32770,
-32763,
-32768,
-32763,
-32766,
-32767,
-32767,
-32765,
-32769,
-32761,
-32769,
-32764,
-32766,
-32769,
-32764,
-32768,
-32767,
-32763,
-32769,
-32763,
-32768,
-32766,
-32767,
-32767,
-32766,
-32769,
-32763,
-32769,
-32765,
-32766,
-32770,
-32764,
-32768,
-32768,
-32765,
-32769,
-32766,
-32767,
-32768,
-32766,
-32768,
-32764,
-32769,
-32764,
-32769,
-32766,
-32766,
-32769,
-32765,
-32768,
-32767,
-32764,
-32768,
-32766,
-32769,
-32766,
-32767,
-32766,
-32768,
-32767,
-32768,
-32765,
-32768,
-32768,
-32765,
-32769,
-32766,
-32767,
-32768,
-32766,
-32767,
-32768,
-32766,
-32768,
-32765,
-32769,
-32766,
-32768,
-32767,
-32766,
-32767,
-32769,
-32764,
-32770,
-32765,
-32767,
-32770,
-32762,
-32772,
-32762,
-32771,
-32766,
-32766,
-32768,
-32765,
-32770,
-32765,
-32767,
-32767,
-32768,
-32767,
-32766,
-32766,
-32769,
-32767,
-32767,
-32764,
-32770,
-32767,
-32771,
-32761,
-32766,
-32770,
-32776,
-32781,
-32771
+static const uint8_t gunEmpty48k_wav_data[7728] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+16,75,59,155,178,179,179,1,17,176,146,147,155,17,179,193,
+180,197,162,130,128,144,144,33,27,25,211,1,24,176,180,178,
+179,179,33,147,10,73,9,187,161,180,177,49,146,59,87,176,
+32,71,176,10,51,201,188,200,251,9,16,186,58,23,169,65,
+3,26,100,160,10,18,10,97,168,140,17,186,156,155,65,177,
+140,51,16,85,2,99,4,152,83,249,255,207,187,9,115,69,
+18,160,170,153,170,9,34,144,154,153,113,39,130,168,152,152,
+136,66,19,185,155,203,139,250,205,137,50,37,34,16,136,9,
+19,252,156,0,0,0,152,41,34,33,69,3,136,217,189,154,
+169,137,16,17,68,20,129,186,10,36,184,186,235,11,52,145,
+80,131,203,41,36,1,152,154,136,40,70,1,49,2,153,128,
+187,154,255,174,138,17,51,17,98,53,129,152,170,187,9,145,
+220,10,19,169,64,147,171,160,190,25,129,25,19,8,20,222,
+25,193,255,154,64,37,176,57,55,184,27,52,185,40,209,174,
+98,145,155,49,129,170,153,152,168,155,49,217,42,22,152,170,
+138,86,18,16,34,153,81,162,173,33,176,156,184,191,97,131,
+170,115,146,154,17,128,48,146,187,153,48,37,250,139,17,8,
+129,219,9,152,32,250,120,119,161,156,0,152,203,41,86,18,
+169,170,137,33,168,188,153,82,37,176,172,16,144,170,40,70,
+34,136,16,193,207,40,3,171,99,145,10,18,203,24,145,56,
+23,152,33,216,139,34,202,26,22,144,40,19,234,137,144,156,
+0,170,112,2,138,2,220,41,145,172,17,136,115,161,159,48,
+19,128,136,152,136,18,216,11,70,129,8,17,136,9,100,19,
+205,25,160,157,67,130,9,145,188,9,168,11,51,184,25,85,
+3,251,155,49,2,185,153,169,139,100,19,1,161,222,139,33,
+36,34,152,137,33,128,16,17,114,19,185,32,248,26,4,203,
+65,192,12,70,144,171,154,56,51,0,82,177,172,152,203,9,
+129,171,16,200,189,171,156,64,53,34,34,184,204,170,25,17,
+0,101,35,2,176,156,114,34,17,184,189,24,184,73,54,0,
+64,35,136,186,173,8,144,153,185,190,154,8,8,0,83,53,
+162,191,187,220,155,33,36,18,128,40,35,185,72,20,8,177,
+239,9,17,17,35,51,53,184,174,185,156,16,0,115,38,0,
+136,137,8,128,137,129,32,69,130,170,187,203,205,154,98,3,
+234,155,9,49,70,130,186,137,235,155,17,16,49,128,219,191,
+41,22,153,65,193,139,37,169,97,130,24,3,206,56,161,11,
+21,188,113,163,189,65,146,187,64,3,187,56,132,187,115,146,
+157,50,216,11,53,168,25,131,204,40,1,137,1,170,72,240,
+141,83,161,139,52,184,156,49,18,153,64,178,159,66,192,27,
+5,218,40,19,154,9,16,129,138,85,177,12,17,203,40,2,
+154,65,36,144,171,235,11,35,170,116,145,42,147,142,21,223,
+58,36,137,65,184,156,202,74,71,144,155,137,48,161,159,99,
+130,187,136,33,130,190,96,131,154,2,251,72,131,172,50,177,
+28,21,218,40,3,154,16,152,41,34,144,205,58,22,219,73,
+4,172,32,129,11,35,168,24,200,25,2,25,7,251,56,132,
+187,80,130,153,128,136,1,170,97,177,11,55,218,41,19,203,
+40,19,170,171,72,20,202,41,18,152,144,203,72,22,152,25,
+128,187,138,66,35,249,156,33,144,24,2,32,37,218,57,39,
+145,171,40,177,173,16,153,97,178,174,32,144,48,193,13,53,
+161,10,130,137,51,249,10,51,250,187,49,53,128,170,187,172,
+115,55,202,41,5,235,9,34,128,153,10,98,3,186,171,56,
+4,171,80,146,140,17,137,83,177,13,18,218,25,2,170,56,
+2,202,96,38,168,171,0,8,34,1,201,140,100,177,174,56,
+19,129,185,42,20,251,10,34,34,2,236,25,20,218,25,53,
+168,10,1,186,48,163,158,32,128,24,128,9,176,13,71,168,
+73,132,189,56,4,8,1,204,25,20,137,8,185,24,35,176,
+219,10,85,130,138,1,220,57,36,202,40,129,187,187,156,115,
+131,171,65,129,9,18,202,9,36,52,36,201,42,38,219,42,
+131,157,115,162,156,0,186,56,146,42,6,190,72,132,170,16,
+128,0,129,32,194,174,49,17,66,131,187,9,33,20,250,139,
+0,185,188,26,71,130,169,186,57,131,174,115,130,139,70,192,
+172,32,129,8,0,40,37,185,72,225,141,67,192,25,147,173,
+66,216,137,20,136,50,177,43,162,175,49,161,40,130,173,17,
+200,41,36,136,128,218,26,54,200,155,2,172,116,161,156,35,
+200,56,4,138,17,219,41,131,156,66,161,155,83,146,9,19,
+253,25,51,168,138,152,153,170,115,134,137,34,233,42,19,187,
+65,176,27,132,156,98,130,169,170,64,19,169,0,217,172,32,
+38,160,48,195,207,49,130,171,49,177,158,82,146,172,49,146,
+10,3,203,137,8,71,208,11,21,185,56,146,154,128,173,32,
+144,82,200,74,7,186,96,129,154,49,1,8,0,144,220,25,
+2,138,53,217,155,136,41,131,27,119,200,10,128,139,68,177,
+42,5,219,25,18,154,32,131,188,40,19,144,8,100,130,174,
+48,178,141,68,168,56,4,219,9,33,17,169,9,184,157,49,
+35,193,223,25,130,40,53,201,25,145,139,52,168,80,131,153,
+128,219,41,4,137,33,217,140,50,2,152,204,42,132,222,56,
+4,203,48,4,168,9,18,201,26,37,128,9,185,141,99,2,
+169,8,50,160,189,9,52,34,1,251,155,129,187,115,195,158,
+66,184,27,3,189,64,129,25,20,138,32,200,57,133,172,72,
+35,153,40,130,188,65,130,58,39,201,9,249,10,36,202,42,
+37,185,10,1,170,40,145,41,23,186,80,130,11,20,204,48,
+130,171,144,73,23,220,73,3,155,83,145,155,136,136,67,129,
+8,144,203,189,155,49,2,139,84,200,59,71,201,26,4,170,
+48,192,140,50,145,138,32,51,200,140,49,35,176,14,84,161,
+138,217,26,71,184,155,2,138,82,145,10,51,251,28,35,168,
+26,160,174,56,17,48,160,59,71,185,112,146,172,40,152,48,
+147,172,33,234,72,2,155,68,192,139,18,168,56,21,201,25,
+176,141,84,160,10,130,188,32,2,9,144,26,5,187,116,179,
+156,82,144,9,51,185,139,18,235,41,23,136,32,177,141,128,
+219,48,130,170,145,188,114,131,171,0,136,66,176,158,32,146,
+172,88,37,185,41,23,185,25,3,185,42,35,144,154,32,52,
+51,17,34,128,254,156,49,179,175,24,216,156,33,161,172,65,
+146,173,97,3,152,0,152,136,144,113,19,171,99,161,58,134,
+203,64,162,139,144,172,82,176,27,4,137,52,233,26,19,154,
+66,192,156,129,185,25,36,176,140,36,216,42,22,184,41,37,
+128,9,50,178,207,40,19,169,49,209,157,33,192,11,20,169,
+65,200,43,4,188,80,145,57,5,155,82,200,27,36,202,9,
+145,156,97,20,185,26,20,169,32,145,172,128,171,138,9,86,
+145,171,50,168,40,131,220,8,19,32,55,192,156,2,218,56,
+4,138,35,169,97,216,27,21,202,40,162,11,34,137,33,144,
+65,176,89,133,156,33,251,139,18,16,1,8,51,234,104,131,
+155,66,160,10,17,152,156,114,131,174,40,160,139,35,217,155,
+49,21,136,50,208,156,49,1,200,12,69,176,28,132,203,66,
+193,11,2,188,64,129,10,129,25,54,130,137,24,33,152,153,
+236,73,163,191,99,193,10,21,201,24,1,137,136,9,52,201,
+25,131,188,25,51,217,26,23,184,81,161,28,20,202,64,177,
+141,34,169,64,146,155,145,157,66,184,27,22,184,10,67,168,
+42,22,202,72,146,155,33,169,33,250,88,131,156,82,176,26,
+4,186,48,146,187,48,161,190,16,177,58,134,156,84,176,26,
+163,175,51,250,57,4,187,98,161,9,19,169,24,136,0,168,
+26,35,34,128,104,194,191,98,160,27,132,172,80,160,26,4,
+187,81,145,156,16,144,136,0,0,153,16,136,81,177,121,5,
+203,98,161,139,50,184,10,144,65,162,141,34,169,81,176,73,
+147,138,5,204,24,201,41,178,159,66,168,10,130,136,145,80,
+179,175,101,176,12,35,170,81,130,137,2,153,66,200,41,147,
+173,65,145,187,40,146,173,32,249,26,132,173,65,176,43,21,
+170,83,192,25,130,157,67,176,41,21,187,57,3,188,57,21,
+169,81,129,10,145,26,71,249,9,130,172,65,161,138,128,140,
+50,177,56,23,203,41,19,185,72,146,139,39,201,72,147,173,
+50,201,74,4,173,64,130,8,144,187,32,184,97,131,191,41,
+19,170,114,145,157,16,129,40,146,141,34,218,104,3,172,48,
+176,12,51,168,137,169,42,53,161,43,39,217,25,5,203,48,
+147,156,2,186,81,161,73,5,204,40,144,41,20,185,32,161,
+139,37,232,139,51,177,12,18,202,48,146,73,3,156,52,249,
+73,4,154,48,160,9,130,171,176,207,40,130,170,138,82,2,
+48,163,255,41,2,9,35,128,128,205,72,131,9,131,191,48,
+145,59,23,170,48,178,140,34,152,17,152,219,155,82,161,56,
+148,207,9,16,34,160,74,148,158,83,177,10,20,154,17,185,
+114,145,12,67,176,155,168,10,115,5,250,138,18,152,82,161,
+141,17,168,8,16,99,177,175,24,8,65,4,203,138,50,130,
+169,17,152,56,131,173,24,84,4,221,41,3,187,33,160,104,
+147,157,49,129,88,146,174,64,20,168,153,0,169,16,160,139,
+129,191,137,152,118,131,172,32,184,41,4,155,99,160,140,129,
+137,34,168,8,200,155,18,152,16,169,187,113,103,129,154,16,
+33,3,222,26,35,138,50,248,10,36,184,140,50,4,168,137,
+137,49,18,138,160,158,66,248,10,20,184,25,1,33,131,58,
+7,220,41,146,188,32,1,235,187,66,131,138,51,2,115,36,
+129,170,80,4,202,138,128,33,161,205,169,26,53,176,57,133,
+174,40,129,24,2,24,132,191,72,4,153,49,2,251,156,50,
+145,139,144,156,33,250,73,37,160,170,25,35,200,40,208,158,
+82,160,72,3,207,40,37,176,173,81,3,204,41,18,153,16,
+8,98,177,158,33,169,41,162,172,49,145,48,36,65,178,159,
+82,176,157,0,152,48,145,10,37,184,41,20,185,9,17,50,
+194,223,56,20,128,0,184,138,129,171,16,186,120,5,186,11,
+50,37,129,153,16,217,189,24,130,170,40,52,35,251,15,50,
+169,57,178,175,33,130,24,128,97,147,207,49,147,140,52,216,
+11,18,137,40,128,49,162,141,34,233,25,2,154,82,176,139,
+1,154,8,0,33,251,44,52,168,11,16,130,218,73,20,170,
+65,176,139,36,8,68,144,203,190,72,4,187,41,144,64,147,
+141,53,216,57,3,188,49,129,138,184,12,37,217,155,33,50,
+37,216,156,49,145,42,22,203,57,147,140,69,168,48,147,191,
+32,145,170,8,24,17,168,32,51,17,200,190,64,38,152,10,
+1,187,48,249,26,147,175,49,177,43,39,169,136,144,48,22,
+185,138,66,160,11,36,217,40,176,91,23,185,48,146,41,133,
+204,33,200,41,6,185,32,162,140,17,1,137,16,200,140,51,
+202,64,193,28,38,185,25,193,156,1,203,49,130,57,4,24,
+39,136,48,145,139,160,187,192,175,24,233,25,2,32,36,170,
+82,200,73,132,139,34,218,81,161,11,4,189,64,160,12,19,
+169,32,145,41,18,33,130,81,194,142,51,204,97,177,13,21,
+185,64,178,141,51,218,57,131,155,67,168,26,18,169,48,177,
+207,33,216,59,23,171,97,145,140,19,217,40,147,155,67,200,
+41,146,171,56,129,138,67,184,106,22,170,97,162,156,35,234,
+56,162,140,67,169,40,146,12,19,202,40,161,11,34,152,9,
+100,161,12,53,234,42,131,156,67,185,88,146,11,37,219,56,
+177,12,35,186,32,129,66,3,40,194,157,1,187,64,169,113,
+195,11,23,187,80,177,13,3,203,64,162,10,36,8,34,169,
+40,192,11,131,173,33,184,25,202,96,193,28,23,169,56,177,
+28,37,169,17,200,25,177,141,35,186,115,146,11,1,170,33,
+1,19,222,10,129,56,6,32,22,186,96,216,140,4,170,64,
+161,13,35,201,56,146,155,18,184,154,138,67,53,36,169,24,
+249,27,22,201,49,178,44,39,201,56,162,171,18,185,57,160,
+12,130,8,68,18,201,57,22,188,113,177,158,35,200,40,147,
+159,32,152,64,130,172,16,184,26,18,185,27,37,170,96,3,
+56,55,169,113,3,155,18,202,10,251,11,34,219,40,145,11,
+20,136,16,168,88,35,0,1,219,138,16,82,52,132,221,26,
+200,158,32,160,56,22,153,65,145,32,4,9,34,251,156,152,
+154,8,152,136,56,54,50,51,176,73,6,188,49,216,140,1,
+172,49,200,42,3,64,212,207,103,163,191,104,19,204,25,21,
+184,10,34,152,137,0,33,160,172,72,35,200,156,98,161,172,
+67,161,155,34,152,137,136,84,209,140,67,176,11,50,144,24,
+128,154,185,27,54,145,65,162,174,40,130,203,40,37,200,140,
+49,184,139,99,34,128,186,24,192,172,33,8,116,129,171,24,
+152,137,49,70,162,173,0,217,41,35,154,64,130,169,203,72,
+20,218,40,19,186,25,17,32,128,25,54,192,158,81,147,220,
+9,18,169,25,20,184,56,3,187,98,1,40,35,184,154,251,
+188,9,53,161,27,146,191,64,2,137,2,171,84,232,139,85,
+145,153,17,144,187,137,168,41,53,130,136,136,129,219,112,21,
+169,25,160,173,128,137,81,20,129,32,36,202,10,20,136,35,
+253,26,4,203,40,130,9,130,172,65,208,139,67,1,128,169,
+154,128,171,64,36,184,11,233,175,48,146,10,70,129,9,32,
+1,185,81,5,169,153,154,65,224,43,53,185,72,177,156,2,
+16,71,192,138,1,186,156,48,54,176,155,17,153,16,160,10,
+34,85,130,222,170,16,50,35,129,236,25,130,172,99,162,155,
+1,138,83,161,9,184,28,39,129,128,251,10,35,136,0,184,
+58,20,128,128,186,25,83,5,234,25,18,48,133,207,41,3,
+169,8,24,129,206,57,3,169,136,9,54,249,27,53,185,10,
+2,171,64,131,190,42,38,160,155,17,18,168,57,71,200,139,
+33,184,172,64,20,152,115,161,172,33,145,136,137,49,210,157,
+66,146,25,17,0,201,139,38,252,138,18,128,8,9,34,160,
+57,132,188,32,17,52,249,11,36,168,16,169,56,200,43,21,
+204,24,161,154,129,80,130,143,82,160,41,37,168,9,41,36,
+250,11,20,202,41,36,168,139,82,146,171,24,152,49,184,112,
+7,170,33,129,80,146,188,16,217,155,136,56,20,169,32,17,
+66,51,85,145,173,81,130,169,9,153,205,25,216,157,65,201,
+11,4,186,88,2,32,20,24,68,144,32,146,174,8,152,171,
+136,234,156,81,2,24,35,25,69,177,9,193,156,69,184,10,
+161,158,18,201,25,2,171,136,25,53,128,99,161,139,52,33,
+3,172,114,178,157,2,203,137,234,9,130,153,34,130,99,18,
+82,20,169,136,218,41,130,172,0,144,187,26,37,236,25,3,
+172,49,18,81,145,104,20,186,25,161,154,219,43,23,201,40,
+3,8,35,2,234,156,83,184,28,21,168,137,136,51,248,26,
+20,204,24,146,138,0,153,0,153,115,18,24,168,57,7,186,
+8,251,27,51,115,132,206,41,3,9,53,216,138,1,16,53,
+192,188,9,33,18,169,154,32,216,157,65,2,138,184,190,80,
+37,2,128,17,184,155,3,223,41,162,174,136,24,83,216,140,
+18,185,114,132,186,33,35,49,19,128,138,100,162,207,49,178,
+191,16,145,8,162,173,64,130,32,19,154,128,204,113,132,189,
+57,36,144,136,136,153,138,16,200,42,71,160,171,169,48,55,
+184,11,2,171,118,132,186,25,1,169,9,145,205,57,39,176,
+10,2,186,114,131,204,9,1,136,33,19,186,80,131,204,40,
+53,130,205,9,130,172,65,18,16,208,159,81,146,138,1,186,
+72,5,186,24,3,204,25,18,153,153,136,65,19,160,251,142,
+66,146,139,50,128,81,131,205,138,50,2,153,160,207,104,19,
+169,40,144,10,17,153,33,17,66,232,156,152,188,32,146,172,
+137,9,84,2,152,170,40,20,168,81,2,203,9,16,8,16,
+128,203,80,55,3,169,136,251,112,23,185,9,3,170,33,250,
+43,36,170,64,145,11,51,251,137,168,11,34,201,41,52,144,
+172,41,51,145,186,191,11,84,2,136,82,130,154,48,130,235,
+138,17,200,74,38,136,81,145,8,3,190,56,4,170,187,139,
+52,217,10,145,204,169,9,83,2,32,145,189,138,113,39,160,
+10,0,203,41,19,160,9,99,1,25,17,204,72,163,191,9,
+35,1,136,17,129,9,67,216,172,16,145,174,64,20,0,129,
+186,138,251,25,130,189,64,145,139,84,34,34,201,139,144,139,
+98,1,24,1,49,37,218,138,17,152,137,154,81,4,234,220,
+172,56,3,153,65,131,187,115,145,155,250,158,82,160,120,132,
+191,96,3,154,51,251,10,161,142,82,176,41,23,185,25,129,
+154,67,129,137,251,156,66,18,17,17,202,172,8,2,0,70,
+192,157,34,185,74,22,153,24,201,138,1,138,85,130,138,0,
+185,9,136,112,38,201,156,33,160,26,54,176,137,160,140,66,
+144,41,19,202,170,153,49,83,52,233,140,18,219,72,19,16,
+131,191,57,178,13,53,168,26,192,157,82,130,153,128,0,152,
+170,65,35,129,220,56,133,189,72,19,16,200,157,1,203,104,
+4,153,33,201,26,20,154,49,192,27,22,186,11,17,50,131,
+9,147,255,11,49,52,160,172,8,185,112,131,138,52,248,140,
+50,128,8,128,24,162,207,48,20,170,25,3,188,11,50,145,
+137,68,161,190,25,53,129,10,67,208,156,33,2,169,8,129,
+168,154,0,152,115,6,169,9,145,204,10,114,36,233,138,52,
+200,11,53,176,155,33,169,9,144,96,20,234,9,3,169,48,
+36,152,202,155,50,144,112,20,202,9,144,8,52,177,139,33,
+235,139,33,169,41,36,17,201,141,71,145,187,0,152,155,154,
+114,22,168,10,17,144,16,66,129,204,138,136,152,25,87,131,
+202,41,130,171,138,8,51,253,142,50,131,137,32,17,1,235,
+26,35,201,26,3,204,42,68,2,201,155,98,146,138,65,160,
+157,9,0,17,168,26,53,130,202,137,50,160,139,36,168,155,
+202,173,114,54,146,187,41,2,235,203,154,49,160,42,54,128,
+81,146,10,38,233,10,2,219,138,16,67,3,9,52,177,172,
+16,1,200,188,10,17,145,137,100,129,24,53,200,10,161,173,
+49,162,203,25,101,19,201,137,128,137,128,201,172,8,168,57,
+119,132,169,41,51,161,138,130,219,155,170,112,131,190,40,19,
+9,67,129,136,153,169,190,121,21,185,138,202,57,22,152,65,
+192,139,51,152,66,248,12,34,168,9,144,96,4,202,32,178,
+157,49,145,16,177,140,36,202,113,147,188,16,160,25,19,203,
+80,3,186,24,67,17,136,17,208,204,9,18,136,32,21,220,
+172,16,36,145,170,0,201,11,50,168,48,37,66,37,184,42,
+36,1,160,207,56,132,204,40,131,186,24,16,18,217,11,130,
+139,84,232,10,18,187,96,20,24,35,219,10,20,201,10,50,
+160,172,24,51,18,184,174,72,177,175,82,130,154,17,220,26,
+36,0,34,184,158,25,50,19,185,187,173,64,162,28,55,216,
+26,19,185,24,161,140,51,216,155,16,66,51,2,137,49,240,
+156,68,192,156,33,160,41,55,144,171,32,131,186,25,249,175,
+40,17,17,131,202,64,2,139,68,200,11,1,171,97,146,9,
+37,0,16,233,156,136,32,53,160,219,171,88,37,168,138,184,
+156,66,129,154,136,24,69,17,35,161,90,39,168,138,168,187,
+16,136,18,253,156,34,145,16,144,173,9,33,69,144,172,33,
+35,66,20,152,138,65,19,220,11,128,172,25,129,172,153,152,
+49,4,153,170,188,73,71,130,188,57,39,144,40,4,185,24,
+3,170,186,206,10,34,129,202,188,10,33,19,18,168,220,171,
+64,52,16,115,3,9,70,161,156,49,2,137,201,171,185,175,
+65,147,187,41,50,129,204,154,203,57,22,185,41,4,24,54,
+67,2,186,10,224,172,83,19,128,152,153,168,156,99,146,204,
+187,155,8,152,48,4,137,0,154,119,19,152,170,138,65,67,
+35,18,152,170,56,55,130,235,171,202,188,81,20,152,128,221,
+139,34,128,16,184,172,153,10,86,34,33,130,154,64,53,37,
+1,186,186,219,9,128,188,155,2,251,139,17,185,25,145,175,
+25,0,32,4,16,87,18,17,68,18,136,153,153,168,8,35,
+252,174,153,153,16,146,203,186,191,10,50,65,52,3,9,17,
+34,101,34,136,152,185,139,50,3,17,208,204,9,153,185,251,
+173,171,155,96,4,170,32,161,12,70,130,9,17,169,57,52,
+66,20,160,171,218,173,25,160,155,33,251,173,24,16,2,160,
+202,188,155,65,50,100,19,128,49,34,64,52,1,33,193,156,
+67,145,10,18,202,205,172,9,168,188,170,172,137,169,80,19,
+25,71,129,41,23,160,154,152,25,66,50,147,221,139,0,25,
+85,2,169,187,189,137,0,17,160,153,236,171,98,51,67,34,
+17,130,155,114,19,17,20,152,18,248,158,1,169,153,218,173,
+9,129,219,138,34,160,24,37,33,67,82,85,130,8,2,233,
+154,8,8,24,136,184,255,10,1,168,24,131,0,35,188,112,
+6,113,87,1,154,152,219,138,128,187,24,184,155,33,169,8,
+32,86,19,83,36,0,50,161,26,38,201,10,33,17,17,19,
+184,156,33,218,26,146,174,168,207,10,2,136,67,130,138,168,
+191,137,185,170,184,203,138,185,11,35,160,96,4,186,139,97,
+53,36,34,52,35,83,36,1,0,1,32,33,160,204,187,235,
+170,153,187,173,137,168,0,145,25,119,4,152,152,137,16,136,
+155,154,188,206,221,170,136,137,33,144,154,34,0,84,19,0,
+18,16,113,36,17,152,170,0,176,74,103,19,33,17,153,48,
+18,137,51,249,207,8,185,171,16,251,171,128,218,138,34,49,
+54,2,65,36,145,32,34,9,82,19,152,153,24,1,175,72,
+22,185,138,128,154,154,153,131,249,175,137,16,67,35,83,3,
+185,156,24,17,200,170,188,27,202,175,50,233,26,147,207,8,
+192,154,19,184,40,20,137,33,48,71,131,8,51,176,154,161,
+173,115,35,66,37,144,137,160,154,51,252,138,169,190,16,145,
+136,184,26,55,128,114,37,8,33,160,154,184,172,68,130,137,
+1,234,203,187,153,169,187,137,185,187,17,36,51,86,39,3,
+16,65,35,128,25,36,224,171,24,186,140,160,155,36,251,191,
+0,0,32,17,33,3,137,65,2,16,249,156,24,171,97,37,
+1,9,136,168,203,154,169,155,115,36,128,171,12,25,80,54,
+176,156,34,234,25,54,129,24,16,153,187,27,33,58,70,176,
+158,17,128,8,168,129,251,175,136,170,41,146,9,37,218,41,
+20,16,20,161,68,147,171,17,205,57,38,0,34,144,170,169,
+16,177,223,24,145,187,204,187,48,200,173,137,16,70,19,82,
+37,136,25,145,187,8,34,19,249,171,234,171,8,202,73,22,
+152,137,152,49,210,157,66,145,24,35,8,84,17,83,146,188,
+1,185,40,210,174,18,216,138,2,185,48,5,1,145,219,56,
+51,136,17,48,34,239,11,52,160,203,24,18,251,140,51,144,
+72,4,219,25,176,11,84,17,8,128,48,4,171,136,186,80,
+147,97,23,136,16,251,154,161,173,24,152,56,38,0,0,144,
+153,17,219,115,196,141,69,233,10,4,170,66,184,112,148,157,
+67,200,58,148,156,67,216,41,131,156,50,218,72,162,156,67,
+201,56,162,140,20,185,64,161,139,21,186,48,179,141,19,184,
+56,144,58,163,159,83,184,57,5,171,50,176,42,4,138,66,
+217,41,131,174,48,144,10,35,153,24,217,25,163,175,82,184,
+12,36,202,32,146,155,36,218,56,147,140,18,203,72,131,155,
+50,176,26,34,50,133,155,69,176,12,52,169,25,132,170,1,
+202,40,19,64,5,220,10,49,52,146,171,152,189,56,161,120,
+22,203,154,152,25,35,170,72,145,140,8,203,26,68,18,170,
+170,221,26,100,1,24,18,2,35,176,190,186,154,83,3,136,
+16,24,116,19,186,172,185,187,74,35,217,9,82,67,129,155,
+64,18,40,18,235,155,203,172,153,217,171,42,84,1,170,138,
+168,190,59,55,35,67,146,188,25,145,187,115,36,136,153,48,
+37,168,171,128,202,26,66,218,157,24,52,19,217,172,154,169,
+153,41,87,131,153,137,204,26,66,51,52,17,33,168,58,55,
+18,184,255,154,152,137,50,17,33,131,137,40,138,68,209,41,
+134,206,9,144,25,54,129,40,130,188,137,32,52,161,189,24,
+184,190,139,34,67,84,18,145,218,173,40,19,16,51,184,73,
+36,160,0,249,172,138,136,152,40,119,1,154,16,168,172,24,
+1,0,17,33,152,113,39,144,138,153,173,138,128,16,17,51,
+54,51,34,144,9,3,162,249,205,10,160,191,137,2,33,85,
+34,184,205,9,33,153,24,130,56,39,17,49,146,203,202,141,
+65,2,0,17,65,20,185,72,19,170,48,161,188,12,41,234,
+154,177,206,25,3,202,156,56,131,221,24,18,86,20,251,10,
+51,168,10,217,173,24,184,156,49,1,24,52,192,42,119,144,
+137,34,144,154,16,144,219,11,52,184,140,82,51,145,172,64,
+146,154,34,168,42,177,174,33,131,128,66,55,208,173,40,130,
+170,32,1,171,154,185,139,24,152,8,187,255,155,48,38,2,
+16,35,50,67,128,11,114,17,9,89,83,128,10,66,35,136,
+67,5,152,56,67,51,5,176,144,232,188,24,32,0,1,218,
+206,139,64,34,8,0,146,162,144,128,1,11,142,41,169,236,
+186,16,129,191,96,51,160,202,223,155,0,184,41,36,170,42,
+18,42,26,207,41,35,153,9,3,36,20,193,204,9,144,235,
+187,59,116,2,176,203,155,153,187,42,33,41,52,241,9,83,
+129,137,84,52,130,153,8,200,204,9,162,191,12,136,138,65,
+37,35,162,186,52,193,26,39,185,172,218,172,154,0,84,67,
+34,34,16,99,2,136,185,223,138,128,152,136,152,16,67,99,
+84,18,144,153,8,136,8,34,168,204,221,154,65,34,1,144,
+202,219,154,152,201,171,137,234,171,56,101,51,130,153,0,17,
+52,36,128,219,174,138,0,137,49,18,32,49,115,115,18,144,
+170,8,50,36,177,205,170,188,172,8,1,17,136,152,185,154,
+173,11,115,200,221,187,171,48,52,2,24,24,64,84,35,145,
+187,136,36,162,112,70,2,152,8,33,130,251,174,154,8,17,
+50,131,220,25,36,18,32,201,174,153,186,154,50,19,128,160,
+219,188,191,171,40,49,17,24,99,68,68,67,1,201,186,9,
+129,24,101,19,168,24,17,1,252,171,40,20,128,0,129,220,
+140,98,34,128,136,169,187,221,139,84,2,154,48,130,187,41,
+38,177,205,9,2,202,57,70,34,184,172,137,184,171,64,130,
+170,40,49,66,50,83,53,184,175,25,51,2,10,99,130,153,
+128,234,171,66,4,152,138,16,67,2,155,100,145,170,35,248,
+191,153,8,17,18,16,83,36,160,156,0,184,191,8,33,0,
+50,18,1,145,1,19,252,158,32,3,186,139,1,162,237,10,
+70,35,128,9,33,160,223,154,16,0,16,66,2,189,26,38,
+144,9,50,146,187,138,101,53,3,236,188,172,169,153,136,152,
+56,86,67,35,18,49,52,145,187,186,219,172,170,152,186,172,
+0,3,0,115,39,129,169,185,202,154,169,8,67,176,190,8,
+1,153,64,53,144,170,33,19,52,55,52,20,185,174,8,50,
+35,185,26,52,177,156,114,34,152,40,20,233,203,8,51,19,
+153,169,203,187,187,175,10,200,207,25,50,168,187,8,19,176,
+58,55,248,173,9,34,35,128,0,69,20,1,33,146,236,171,
+40,128,203,138,82,54,35,136,128,235,154,16,152,153,137,32,
+53,129,136,82,3,204,10,67,128,202,137,100,19,144,153,187,
+58,71,130,217,187,171,170,16,2,50,55,3,186,157,32,18,
+169,10,17,144,113,54,18,17,146,251,188,188,154,8,32,83,
+50,33,34,33,48,69,129,25,160,255,157,8,0,136,152,50,
+18,138,48,21,2,201,172,32,18,72,68,130,169,9,184,171,
+201,223,48,132,26,52,250,139,33,33,146,202,99,21,152,137,
+153,32,131,206,155,17,176,172,81,19,185,173,171,24,33,115,
+39,128,154,137,9,82,2,219,187,137,50,17,49,36,114,20,
+217,139,17,152,186,187,113,3,186,24,34,50,193,174,80,4,
+217,138,16,136,169,202,138,114,67,18,169,139,17,65,52,176,
+16,149,206,171,8,66,35,1,129,234,187,9,99,19,186,140,
+32,33,50,208,138,84,177,221,137,48,67,2,137,32,216,207,
+154,128,152,48,55,1,136,17,129,9,0,16,52,248,207,137,
+1,152,25,66,18,0,33,67,34,218,188,172,139,16,18,153,
+56,103,18,128,1,185,156,128,235,171,49,34,128,49,35,154,
+104,129,187,16,187,46,69,144,40,19,184,203,168,185,173,43,
+100,20,146,170,73,82,33,144,204,155,152,187,57,38,18,8,
+153,188,171,168,186,120,55,2,145,168,136,0,9,160,192,249,
+190,138,115,33,8,32,128,219,171,137,9,32,50,66,83,0,
+0,130,240,168,1,152,175,140,25,0,32,69,18,145,145,169,
+168,154,155,158,9,50,85,37,20,2,0,36,20,64,68,18,
+1,144,187,203,207,172,186,187,154,202,174,9,24,49,52,34,
+50,20,8,41,9,8,163,250,172,0,67,69,83,49,1,128,
+136,144,176,169,68,163,189,138,139,81,35,138,25,193,249,219,
+187,188,172,154,154,72,65,49,50,16,57,187,15,57,10,137,
+52,55,20,4,20,34,34,33,8,186,187,169,208,173,142,57,
+51,131,202,189,155,160,186,144,145,144,251,174,40,17,171,189,
+191,155,32,67,64,49,64,48,128,155,50,21,36,131,154,24,
+251,155,18,185,157,2,146,0,70,37,161,184,129,82,83,152,
+188,169,33,65,16,186,189,153,201,185,145,210,219,187,201,9,
+138,42,39,20,37,3,144,200,251,137,0,8,128,1,49,193,
+217,2,50,54,6,129,17,17,82,19,24,80,0,10,144,153,
+70,19,153,172,156,0,187,175,56,50,97,50,66,67,162,252,
+204,187,188,170,153,168,128,53,55,52,50,33,128,185,220,202,
+203,188,170,137,17,17,50,53,53,36,52,18,144,136,137,128,
+144,200,169,144,161,201,170,25,51,240,191,137,153,72,51,153,
+80,53,128,171,171,188,59,49,208,207,25,54,146,10,34,237,
+10,34,184,26,71,2,186,56,55,130,220,154,136,219,25,37,
+0,66,130,136,16,233,157,32,160,191,25,37,18,128,0,33,
+200,173,24,136,203,155,97,36,1,8,17,201,159,48,146,188,
+32,2,40,19,9,70,160,203,154,9,17,153,136,48,71,129,
+72,19,206,8,2,154,153,138,50,161,10,69,18,8,8,201,
+157,24,219,27,130,175,65,4,137,1,16,51,249,159,32,1,
+153,17,8,49,132,171,66,232,157,33,1,128,203,25,147,223,
+56,39,144,137,0,152,32,2,154,136,186,72,178,175,115,129,
+153,33,144,10,51,161,187,128,144,205,156,128,144,16,36,208,
+205,72,38,152,24,193,174,32,145,171,48,34,145,204,88,54,
+130,219,138,18,152,33,131,9,16,170,56,19,129,252,139,2,
+202,56,55,145,220,9,36,184,10,161,172,83,146,26,20,203,
+41,4,203,41,33,24,136,9,20,160,172,171,27,115,20,144,
+139,114,2,201,153,168,169,218,171,9,168,10,103,18,152,128,
+185,32,18,24,35,251,171,156,74,68,18,145,172,41,24,56,
+20,3,55,162,153,52,54,145,204,25,128,9,48,128,172,153,
+146,132,23,200,188,169,188,64,22,152,138,152,154,41,21,177,
+185,168,18,3,25,138,175,113,19,138,81,130,25,33,18,39,
+3,235,12,24,32,65,145,187,41,1,8,18,40,172,173,37,
+163,157,82,18,26,57,64,138,174,203,16,52,168,139,186,175,
+64,129,156,0,177,144,67,34,0,154,185,26,59,17,219,174,
+8,32,82,20,200,168,132,1,104,33,137,27,155,156,88,32,
+130,176,13,42,10,105,32,203,152,129,13,57,169,17,55,137,
+28,8,156,40,147,41,55,179,154,83,32,58,130,186,203,219,
+48,5,177,18,51,89,32,140,139,241,200,144,147,146,1,186,
+122,81,42,58,2,216,155,8,162,249,187,33,37,16,128,201,
+157,40,66,34,184,191,156,171,89,85,129,153,9,137,41,68,
+128,155,57,114,1,185,137,16,186,219,186,59,74,58,119,3,
+128,152,203,187,136,19,4,185,191,26,84,2,168,169,17,161,
+155,82,144,155,153,159,58,36,147,131,208,12,113,1,152,161,
+185,24,19,67,36,21,193,219,9,33,36,160,97,51,251,255,
+40,20,168,114,147,175,24,129,170,33,35,131,205,64,4,170,
+24,200,138,152,156,99,34,0,153,48,131,188,9,144,201,207,
+57,37,144,8,0,49,193,158,48,129,203,171,113,19,153,33,
+146,170,154,88,4,221,25,1,8,0,8,50,129,8,129,82,
+241,191,32,130,137,34,144,24,152,80,21,168,187,188,138,17,
+52,19,17,5,185,49,209,188,169,172,81,129,41,38,144,40,
+37,176,173,137,153,155,9,32,101,19,129,152,128,161,221,10,
+33,169,140,82,3,137,66,160,137,208,173,48,178,157,83,19,
+128,136,8,176,220,0,18,184,174,40,38,129,168,169,50,22,
+186,58,36,188,27,38,146,202,170,9,24,33,53,131,156,75,
+32,16,16,191,28,24,9,25,144,18,39,169,74,34,185,154,
+217,26,52,161,203,251,0,20,145,49,147,176,144,163,68,21,
+217,171,1,9,91,33,170,11,11,96,20,184,10,9,193,180,
+146,5,208,155,57,32,1,3,7,176,186,3,49,57,175,9,
+5,161,137,153,35,147,141,88,26,44,43,25,147,49,41,172,
+177,164,1,49,11,29,26,16,135,1,9,27,59,153,153,154,
+11,48,57,91,65,24,185,232,145,145,144,154,9,179,196,164,
+146,33,17,155,144,165,145,144,27,1,18,91,44,9,9,57,
+50,41,25,177,11,75,25,26,0,153,41,144,145,19,73,91,
+26,11,0,146,201,179,179,176,1,10,33,19,41,75,25,185,
+163,163,169,16,0,161,2,146,163,17,27,10,162,145,0,177,
+163,2,57,57,9,153,195,161,32,59,43,144,162,146,26,145,
+179,179,161,179,211,146,0,16,25,74,43,26,0,9,161,145,
+57,59,144,145,1,26,2,25,59,59,27,25,18,59,59,26,
+145,145,16,144,161,17,41,27,57,10,25,41,43,9,161,179,
+179,178,18,59,43,145,17,42,59,25,42,59,153,160,147,17,
+27,0,162,1,25,9,1,145,144,32,42,153,144,57,59,59,
+26,178,163,161,162,147,194,162,18,144,210,163,17,43,185,179,
+147,1,41,59,27,179,17,58,26,145,177,179,147,41,43,169,
+147,145,144,1,161,2,58,26,145,16,25,58,26,144,17,59,
+26,211,179,164,0,57,27,17,153,32,153,58,57,30,49,193
 };
+
+static const imaAdpcm_state_t gunEmpty48k_wav_index[16] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+{0, 0},
+{1451, 48},
+{17007, 71},
+{159, 66},
+{105, 57},
+{-230, 45},
+{196, 33},
+{-669, 52},
+{-3322, 46},
+{279, 21},
+{-162, 20},
+{251, 12},
+{-95, 18},
+{128, 3},
+{35, 14},
+{-4, 0}
+};
+
+const imaAdpcm_clip_t gunEmpty48k_wav_clip = {gunEmpty48k_wav_data, gunEmpty48k_wav_index, 15456};
@@ -1,23473 +1,768 @@
-// This file was generated by executing this statement: wav2c ouch48k.wav
+// This file was generated by executing this statement: wav2c -a ouch48k.wav
 
-#include <stdint.h>
+#include "ouch48k.wav.h"
 
-uint16_t ouch48k_wav[23467] = {
-32101,
-32046,
-32061,
-32124,
-32200,
-32250,
-32254,
-32202,
-32117,
-32021,
-31947,
-31911,
-31917,
-31949,
-31994,
-32024,
-32041,
-32044,
-32045,
-32061,
-32101,
-32158,
-32230,
-32287,
-32321,
-32326,
-32298,
-32263,
-32224,
-32206,
-32207,
-32230,
-32257,
-32285,
-32294,
-32291,
-32272,
-32250,
-32232,
-32220,
-32222,
-32229,
-32248,
-32273,
-32303,
-32342,
-32391,
-32435,
-32488,
-32519,
-32546,
-32547,
-32547,
-32525,
-32519,
-32503,
-32492,
-32479,
-32442,
-32404,
-32339,
-32278,
-32222,
-32196,
-32191,
-32223,
-32260,
-32296,
-32313,
-32296,
-32264,
-32215,
-32190,
-32190,
-32237,
-32313,
-32404,
-32483,
-32525,
-32516,
-32464,
-32379,
-32290,
-32227,
-32190,
-32199,
-32228,
-32265,
-32294,
-32296,
-32284,
-32255,
-32229,
-32220,
-32224,
-32247,
-32270,
-32285,
-32289,
-32270,
-32252,
-32227,
-32222,
-32232,
-32247,
-32278,
-32285,
-32289,
-32271,
-32242,
-32225,
-32213,
-32229,
-32254,
-32284,
-32303,
-32299,
-32272,
-32232,
-32194,
-32182,
-32206,
-32266,
-32350,
-32437,
-32492,
-32514,
-32478,
-32415,
-32337,
-32276,
-32257,
-32280,
-32347,
-32431,
-32510,
-32562,
-32580,
-32562,
-32526,
-32492,
-32468,
-32472,
-32488,
-32516,
-32539,
-32543,
-32539,
-32514,
-32494,
-32484,
-32481,
-32503,
-32516,
-32537,
-32537,
-32531,
-32510,
-32492,
-32482,
-32487,
-32504,
-32524,
-32542,
-32541,
-32530,
-32502,
-32474,
-32464,
-32474,
-32512,
-32580,
-32646,
-32723,
-32767,
-32798,
-32797,
-32785,
-32765,
-32751,
-32750,
-32755,
-32769,
-32779,
-32782,
-32778,
-32768,
-32754,
-32755,
-32750,
-32766,
-32773,
-32784,
-32784,
-32777,
-32764,
-32752,
-32746,
-32747,
-32763,
-32777,
-32794,
-32795,
-32788,
-32764,
-32742,
-32721,
-32719,
-32744,
-32782,
-32853,
-32912,
-32971,
-33002,
-32995,
-32966,
-32901,
-32836,
-32767,
-32727,
-32702,
-32721,
-32739,
-32781,
-32804,
-32810,
-32804,
-32768,
-32740,
-32717,
-32719,
-32756,
-32818,
-32900,
-32977,
-33046,
-33072,
-33079,
-33048,
-33016,
-32981,
-32974,
-32980,
-33020,
-33051,
-33089,
-33086,
-33066,
-33008,
-32937,
-32867,
-32813,
-32792,
-32800,
-32841,
-32895,
-32954,
-33003,
-33038,
-33056,
-33055,
-33053,
-33035,
-33027,
-33014,
-33001,
-33000,
-32992,
-33004,
-33018,
-33049,
-33090,
-33138,
-33193,
-33243,
-33287,
-33315,
-33328,
-33316,
-33286,
-33236,
-33163,
-33089,
-33001,
-32927,
-32863,
-32817,
-32791,
-32777,
-32773,
-32769,
-32758,
-32750,
-32732,
-32736,
-32744,
-32780,
-32829,
-32889,
-32948,
-32997,
-33026,
-33039,
-33039,
-33035,
-33034,
-33035,
-33040,
-33036,
-33018,
-32980,
-32925,
-32859,
-32798,
-32751,
-32728,
-32729,
-32745,
-32766,
-32782,
-32786,
-32783,
-32770,
-32765,
-32762,
-32770,
-32770,
-32759,
-32720,
-32660,
-32582,
-32502,
-32441,
-32416,
-32435,
-32496,
-32577,
-32665,
-32729,
-32764,
-32755,
-32717,
-32649,
-32581,
-32511,
-32460,
-32438,
-32442,
-32486,
-32568,
-32680,
-32822,
-32951,
-33063,
-33101,
-33070,
-32946,
-32764,
-32551,
-32367,
-32251,
-32236,
-32336,
-32503,
-32726,
-32911,
-33051,
-33085,
-33043,
-32923,
-32784,
-32645,
-32548,
-32497,
-32499,
-32527,
-32586,
-32645,
-32715,
-32787,
-32858,
-32933,
-32985,
-33023,
-33012,
-32973,
-32894,
-32808,
-32730,
-32682,
-32678,
-32714,
-32780,
-32859,
-32928,
-32983,
-33016,
-33033,
-33039,
-33043,
-33035,
-33018,
-32975,
-32916,
-32830,
-32758,
-32686,
-32669,
-32688,
-32754,
-32845,
-32933,
-32999,
-33019,
-33003,
-32943,
-32881,
-32816,
-32778,
-32760,
-32756,
-32761,
-32755,
-32748,
-32732,
-32735,
-32751,
-32801,
-32864,
-32938,
-32987,
-33009,
-32985,
-32928,
-32859,
-32798,
-32770,
-32794,
-32849,
-32943,
-33026,
-33097,
-33119,
-33104,
-33045,
-32969,
-32887,
-32814,
-32767,
-32732,
-32731,
-32734,
-32759,
-32794,
-32836,
-32894,
-32944,
-33002,
-33036,
-33062,
-33062,
-33051,
-33029,
-33009,
-32997,
-32999,
-33007,
-33026,
-33035,
-33046,
-33037,
-33033,
-33015,
-33010,
-33007,
-33010,
-33023,
-33029,
-33037,
-33036,
-33028,
-33025,
-33010,
-33016,
-33010,
-33021,
-33026,
-33031,
-33033,
-33032,
-33023,
-33020,
-33014,
-33013,
-33018,
-33022,
-33028,
-33032,
-33033,
-33029,
-33024,
-33015,
-33011,
-33008,
-33016,
-33025,
-33039,
-33051,
-33049,
-33032,
-32999,
-32940,
-32876,
-32809,
-32754,
-32723,
-32720,
-32732,
-32770,
-32789,
-32814,
-32799,
-32782,
-32743,
-32720,
-32710,
-32736,
-32782,
-32850,
-32920,
-32975,
-33015,
-33030,
-33025,
-33030,
-33020,
-33039,
-33047,
-33058,
-33044,
-33010,
-32949,
-32879,
-32816,
-32778,
-32781,
-32820,
-32895,
-32970,
-33042,
-33081,
-33086,
-33065,
-33030,
-32997,
-32981,
-32986,
-33006,
-33033,
-33051,
-33055,
-33043,
-33028,
-33002,
-33000,
-32995,
-33016,
-33031,
-33046,
-33046,
-33039,
-33018,
-33009,
-32998,
-33006,
-33018,
-33036,
-33044,
-33048,
-33030,
-33016,
-32998,
-32995,
-33007,
-33030,
-33051,
-33068,
-33055,
-33021,
-32958,
-32888,
-32815,
-32767,
-32731,
-32735,
-32743,
-32766,
-32784,
-32785,
-32785,
-32769,
-32759,
-32752,
-32752,
-32763,
-32771,
-32780,
-32779,
-32775,
-32764,
-32760,
-32752,
-32760,
-32764,
-32774,
-32779,
-32777,
-32774,
-32762,
-32756,
-32756,
-32756,
-32769,
-32775,
-32782,
-32778,
-32773,
-32758,
-32756,
-32747,
-32761,
-32764,
-32785,
-32787,
-32787,
-32774,
-32754,
-32735,
-32731,
-32738,
-32774,
-32825,
-32885,
-32953,
-33000,
-33039,
-33051,
-33050,
-33039,
-33026,
-33016,
-33013,
-33014,
-33015,
-33017,
-33016,
-33013,
-33026,
-33043,
-33089,
-33149,
-33218,
-33286,
-33334,
-33351,
-33335,
-33295,
-33241,
-33204,
-33198,
-33238,
-33314,
-33416,
-33501,
-33552,
-33538,
-33452,
-33319,
-33162,
-33031,
-32963,
-32974,
-33065,
-33210,
-33352,
-33458,
-33474,
-33401,
-33249,
-33061,
-32888,
-32783,
-32765,
-32847,
-32977,
-33134,
-33236,
-33270,
-33208,
-33074,
-32916,
-32771,
-32703,
-32714,
-32816,
-32964,
-33110,
-33206,
-33217,
-33132,
-32976,
-32788,
-32617,
-32515,
-32498,
-32573,
-32706,
-32866,
-32998,
-33074,
-33070,
-32993,
-32862,
-32716,
-32582,
-32501,
-32473,
-32519,
-32605,
-32733,
-32861,
-32975,
-33054,
-33096,
-33091,
-33067,
-33018,
-32986,
-32965,
-32975,
-33013,
-33056,
-33097,
-33103,
-33064,
-32977,
-32845,
-32705,
-32576,
-32503,
-32492,
-32549,
-32648,
-32749,
-32808,
-32778,
-32649,
-32417,
-32122,
-31822,
-31574,
-31456,
-31487,
-31707,
-32082,
-32582,
-33144,
-33701,
-34189,
-34553,
-34758,
-34790,
-34651,
-34368,
-33983,
-33540,
-33103,
-32717,
-32424,
-32259,
-32210,
-32287,
-32443,
-32653,
-32869,
-33053,
-33186,
-33248,
-33242,
-33181,
-33081,
-32965,
-32852,
-32748,
-32662,
-32587,
-32513,
-32443,
-32372,
-32311,
-32284,
-32305,
-32396,
-32571,
-32805,
-33091,
-33375,
-33622,
-33795,
-33867,
-33846,
-33741,
-33587,
-33408,
-33233,
-33071,
-32920,
-32784,
-32648,
-32531,
-32431,
-32383,
-32379,
-32448,
-32543,
-32676,
-32773,
-32847,
-32850,
-32818,
-32754,
-32701,
-32676,
-32699,
-32746,
-32813,
-32854,
-32860,
-32825,
-32761,
-32694,
-32661,
-32663,
-32720,
-32795,
-32880,
-32938,
-32965,
-32959,
-32943,
-32938,
-32960,
-33012,
-33076,
-33131,
-33149,
-33116,
-33033,
-32918,
-32795,
-32689,
-32615,
-32571,
-32546,
-32527,
-32503,
-32473,
-32451,
-32444,
-32464,
-32509,
-32558,
-32598,
-32603,
-32568,
-32498,
-32413,
-32335,
-32279,
-32264,
-32261,
-32277,
-32282,
-32274,
-32269,
-32267,
-32304,
-32368,
-32463,
-32556,
-32625,
-32637,
-32602,
-32525,
-32445,
-32402,
-32396,
-32448,
-32495,
-32532,
-32491,
-32387,
-32225,
-32049,
-31921,
-31869,
-31898,
-31996,
-32090,
-32156,
-32140,
-32062,
-31950,
-31856,
-31825,
-31868,
-31971,
-32085,
-32170,
-32194,
-32175,
-32151,
-32178,
-32295,
-32502,
-32746,
-32947,
-33022,
-32915,
-32648,
-32278,
-31921,
-31689,
-31626,
-31762,
-31998,
-32268,
-32458,
-32547,
-32532,
-32483,
-32471,
-32532,
-32660,
-32787,
-32817,
-32696,
-32415,
-32040,
-31709,
-31523,
-31578,
-31830,
-32183,
-32465,
-32546,
-32365,
-31993,
-31595,
-31363,
-31454,
-31864,
-32489,
-33070,
-33384,
-33271,
-32775,
-32105,
-31584,
-31493,
-31924,
-32691,
-33308,
-33129,
-31527,
-28129,
-23012,
-16738,
-10322,
-5009,
-2007,
-2231,
-6077,
-13358,
-23318,
-34779,
-46318,
-56491,
-64001,
-65534,
-65534,
-63076,
-54917,
-44168,
-32301,
-21022,
-11969,
-6422,
-5054,
-7767,
-13740,
-21604,
-29788,
-36896,
-42003,
-44887,
-45925,
-45985,
-46014,
-46782,
-48561,
-51098,
-53638,
-55199,
-54816,
-51868,
-46185,
-38192,
-28729,
-18981,
-10193,
-3535,
-65535,
-0,
-3433,
-10409,
-20033,
-31224,
-42665,
-52927,
-60690,
-64917,
-65037,
-61075,
-53622,
-43799,
-33014,
-22771,
-14388,
-8857,
-6651,
-7798,
-11847,
-18047,
-25453,
-33071,
-39963,
-45327,
-48568,
-49296,
-47411,
-43040,
-36606,
-28748,
-20324,
-12289,
-5648,
-1284,
-65535,
-1791,
-6955,
-14904,
-24750,
-35336,
-45350,
-53566,
-58993,
-61085,
-59778,
-55552,
-49263,
-42043,
-35022,
-29170,
-25123,
-23112,
-22996,
-24348,
-26608,
-29243,
-31843,
-34205,
-36329,
-38317,
-40354,
-42525,
-44821,
-47066,
-48964,
-50136,
-50240,
-49011,
-46364,
-42419,
-37454,
-31943,
-26376,
-21306,
-17160,
-14281,
-12842,
-12874,
-14280,
-16859,
-20367,
-24496,
-28991,
-33534,
-37920,
-41896,
-45334,
-48070,
-50040,
-51157,
-51362,
-50591,
-48767,
-45838,
-41815,
-36798,
-31068,
-25048,
-19348,
-14642,
-11591,
-10704,
-12197,
-15924,
-21363,
-27632,
-33693,
-38461,
-41035,
-40875,
-37870,
-32402,
-25273,
-17557,
-10458,
-5072,
-2255,
-2457,
-5681,
-11514,
-19150,
-27625,
-35881,
-43008,
-48339,
-51540,
-52613,
-51865,
-49776,
-46905,
-43770,
-40751,
-38065,
-35797,
-33900,
-32328,
-31027,
-30017,
-29382,
-29225,
-29670,
-30760,
-32482,
-34704,
-37219,
-39750,
-41994,
-43660,
-44475,
-44253,
-42865,
-40305,
-36689,
-32253,
-27399,
-22629,
-18516,
-15653,
-14497,
-15361,
-18250,
-22897,
-28732,
-34986,
-40790,
-45327,
-47970,
-48383,
-46570,
-42881,
-37912,
-32457,
-27304,
-23196,
-20677,
-20051,
-21382,
-24446,
-28839,
-33978,
-39217,
-43884,
-47414,
-49342,
-49430,
-47620,
-44060,
-39049,
-32998,
-26354,
-19596,
-13178,
-7556,
-3196,
-534,
-15,
-1928,
-6445,
-13390,
-22328,
-32442,
-42695,
-51931,
-59065,
-63291,
-64186,
-61820,
-56682,
-49621,
-41655,
-33815,
-26983,
-21824,
-18676,
-17634,
-18490,
-20895,
-24326,
-28260,
-32148,
-35571,
-38221,
-39969,
-40838,
-40937,
-40446,
-39461,
-38026,
-36077,
-33504,
-30255,
-26387,
-22174,
-18073,
-14705,
-12674,
-12517,
-14471,
-18535,
-24363,
-31397,
-38959,
-46320,
-52827,
-57921,
-61163,
-62279,
-61173,
-57963,
-53050,
-47036,
-40715,
-34858,
-30038,
-26461,
-23852,
-21531,
-18659,
-14491,
-8821,
-2120,
-65535,
-2,
-65535,
-65535,
-3554,
-17439,
-33927,
-50418,
-64295,
-65534,
-65534,
-65534,
-65534,
-60347,
-51173,
-42656,
-35272,
-28762,
-22443,
-15694,
-8371,
-1058,
-65535,
-65535,
-0,
-65535,
-9609,
-24018,
-39967,
-55103,
-65534,
-65534,
-65534,
-65534,
-65534,
-56739,
-45118,
-33234,
-22112,
-12534,
-5126,
-371,
-0,
-285,
-5160,
-12941,
-22879,
-33894,
-44724,
-54111,
-61003,
-64729,
-65034,
-62109,
-56483,
-48890,
-40189,
-31206,
-22718,
-15374,
-9683,
-5997,
-4478,
-5110,
-7694,
-11882,
-17254,
-23339,
-29721,
-36001,
-41844,
-46930,
-50909,
-53466,
-54248,
-53063,
-49835,
-44798,
-38411,
-31408,
-24630,
-18906,
-14911,
-13030,
-13329,
-15571,
-19293,
-23913,
-28846,
-33560,
-37639,
-40782,
-42810,
-43668,
-43420,
-42250,
-40461,
-38399,
-36430,
-34817,
-33684,
-32975,
-32498,
-31991,
-31238,
-30178,
-28913,
-27737,
-27009,
-27035,
-27980,
-29768,
-32117,
-34623,
-36862,
-38516,
-39446,
-39666,
-39317,
-38555,
-37508,
-36234,
-34783,
-33237,
-31810,
-30841,
-30760,
-31965,
-34678,
-38838,
-44042,
-49605,
-54698,
-58513,
-60431,
-60105,
-57468,
-52665,
-45961,
-37700,
-28257,
-18188,
-8210,
-0,
-65535,
-0,
-65535,
-0,
-7791,
-21203,
-35519,
-48408,
-57777,
-62213,
-61393,
-56071,
-47943,
-39169,
-31848,
-27551,
-26974,
-29877,
-35251,
-41632,
-47488,
-51588,
-53171,
-52065,
-48592,
-43411,
-37365,
-31275,
-25837,
-21536,
-18566,
-16877,
-16128,
-15834,
-15423,
-14435,
-12644,
-10212,
-7676,
-5928,
-5945,
-8606,
-14364,
-23102,
-34057,
-45953,
-57215,
-65534,
-65534,
-65534,
-65533,
-65534,
-59430,
-51216,
-43336,
-36840,
-32409,
-30435,
-30942,
-33667,
-38071,
-43403,
-48726,
-53098,
-55592,
-55574,
-52722,
-47190,
-39546,
-30715,
-21777,
-13827,
-7730,
-4094,
-3120,
-4743,
-8577,
-14086,
-20583,
-27283,
-33409,
-38152,
-40895,
-41246,
-39187,
-35186,
-30087,
-25085,
-21382,
-20009,
-21476,
-25698,
-31907,
-38876,
-45109,
-49245,
-50275,
-47797,
-42055,
-33879,
-24530,
-15456,
-8105,
-3642,
-2858,
-5954,
-12549,
-21645,
-31759,
-41136,
-48059,
-51184,
-49871,
-44339,
-35687,
-25662,
-16285,
-9385,
-6203,
-7144,
-11741,
-18906,
-27196,
-35264,
-42078,
-47078,
-50136,
-51379,
-51080,
-49474,
-46836,
-43478,
-39891,
-36735,
-34760,
-34558,
-36389,
-39893,
-44197,
-48004,
-50043,
-49463,
-46180,
-40978,
-35310,
-30860,
-28968,
-30161,
-33911,
-38730,
-42622,
-43636,
-40520,
-33074,
-22271,
-9999,
-2,
-65535,
-0,
-65535,
-65535,
-10486,
-26545,
-43755,
-59856,
-65534,
-65534,
-65534,
-65534,
-61572,
-44708,
-26789,
-11433,
-1937,
-491,
-7550,
-21593,
-39483,
-57131,
-65534,
-65534,
-65534,
-64805,
-49488,
-31831,
-15015,
-1558,
-65535,
-65535,
-1,
-65535,
-4700,
-15431,
-27697,
-40606,
-52988,
-63383,
-65533,
-65534,
-65534,
-59215,
-45963,
-30660,
-15756,
-3586,
-65535,
-1,
-65535,
-3277,
-13437,
-25196,
-37121,
-48017,
-56870,
-62929,
-65534,
-65063,
-61279,
-55094,
-47671,
-40363,
-34487,
-30968,
-30146,
-31670,
-34586,
-37629,
-39482,
-39184,
-36240,
-30790,
-23471,
-15296,
-7469,
-1157,
-1,
-65535,
-219,
-7095,
-17037,
-28988,
-41550,
-53148,
-62375,
-65534,
-65534,
-65534,
-65534,
-61148,
-56618,
-52976,
-50448,
-48693,
-46958,
-44390,
-40309,
-34424,
-26924,
-18398,
-9721,
-1876,
-65535,
-65535,
-65535,
-65535,
-3310,
-14221,
-27702,
-42281,
-56056,
-65534,
-65534,
-65534,
-65534,
-57793,
-44444,
-30677,
-19077,
-11744,
-9857,
-13517,
-21756,
-32832,
-44613,
-54957,
-62124,
-64989,
-63219,
-57272,
-48309,
-38008,
-28238,
-20781,
-16910,
-17205,
-21392,
-28453,
-36930,
-45272,
-52312,
-57434,
-60720,
-62637,
-63802,
-64485,
-64487,
-63050,
-59218,
-52216,
-41926,
-29176,
-15637,
-3594,
-65535,
-3,
-65535,
-3415,
-15528,
-29409,
-42970,
-54453,
-62693,
-65532,
-65534,
-63187,
-55272,
-44035,
-30631,
-16883,
-5170,
-65535,
-0,
-4515,
-18183,
-35925,
-53805,
-65534,
-65534,
-65534,
-58087,
-40505,
-22093,
-7853,
-1758,
-5600,
-18538,
-37373,
-57448,
-65534,
-65534,
-65533,
-65534,
-62437,
-47081,
-33466,
-24371,
-20948,
-22722,
-27831,
-33737,
-37938,
-38631,
-35097,
-27768,
-18069,
-7986,
-0,
-65535,
-0,
-895,
-11527,
-25890,
-42054,
-57570,
-65534,
-65530,
-65534,
-65533,
-56875,
-39883,
-22331,
-7772,
-65535,
-3,
-6192,
-20072,
-37211,
-53823,
-65534,
-65534,
-65533,
-62870,
-50559,
-36674,
-23714,
-13391,
-6283,
-2075,
-3,
-65535,
-2,
-1685,
-5700,
-12220,
-21068,
-31215,
-40971,
-48405,
-52082,
-51539,
-47622,
-42204,
-37680,
-36107,
-38573,
-44811,
-53312,
-61900,
-65534,
-65534,
-65534,
-65534,
-60624,
-54058,
-47633,
-41402,
-34851,
-27300,
-18456,
-8728,
-65535,
-2,
-65535,
-1,
-65535,
-8738,
-23485,
-39335,
-54245,
-65534,
-65534,
-65534,
-65534,
-65534,
-55683,
-39638,
-21881,
-4946,
-0,
-65535,
-0,
-65535,
-4747,
-21276,
-37976,
-52104,
-61978,
-65534,
-65534,
-65533,
-65534,
-65531,
-65534,
-65532,
-65254,
-60513,
-52610,
-42056,
-30142,
-18538,
-8760,
-1821,
-65535,
-65535,
-1,
-2052,
-7131,
-13844,
-22202,
-31981,
-42512,
-52721,
-61198,
-65534,
-65534,
-64925,
-57696,
-47127,
-34474,
-21135,
-8552,
-0,
-65535,
-0,
-65535,
-1,
-9844,
-24705,
-40564,
-55208,
-65532,
-65534,
-65534,
-65534,
-65534,
-59672,
-51693,
-43843,
-36230,
-28665,
-20937,
-13150,
-5813,
-2,
-65535,
-1,
-65535,
-1,
-3187,
-8237,
-13579,
-19443,
-26386,
-34914,
-45068,
-56130,
-65533,
-65534,
-65533,
-65534,
-65533,
-54430,
-38357,
-21664,
-6704,
-65535,
-1,
-65535,
-65535,
-958,
-14087,
-29953,
-46774,
-62343,
-65534,
-65534,
-65534,
-65534,
-58784,
-42121,
-25152,
-10602,
-323,
-0,
-65535,
-1,
-65535,
-1394,
-4546,
-8080,
-12755,
-19169,
-27382,
-36761,
-46202,
-54480,
-60716,
-64589,
-65534,
-65534,
-65534,
-63526,
-60069,
-54672,
-47056,
-37580,
-27426,
-18430,
-12561,
-11309,
-15076,
-22952,
-32890,
-42253,
-48560,
-50190,
-46706,
-38928,
-28490,
-17385,
-7399,
-1,
-65535,
-1,
-65535,
-4320,
-14248,
-26857,
-40914,
-54662,
-65534,
-65533,
-65534,
-65534,
-61501,
-49693,
-37306,
-26382,
-18187,
-13052,
-10462,
-9531,
-9427,
-9809,
-10839,
-13070,
-16985,
-22675,
-29588,
-36611,
-42347,
-45562,
-45517,
-42190,
-36190,
-28550,
-20418,
-12811,
-6545,
-2208,
-286,
-1126,
-4915,
-11454,
-20064,
-29522,
-38261,
-44781,
-48082,
-48065,
-45636,
-42432,
-40305,
-40670,
-43981,
-49617,
-56111,
-61767,
-65351,
-65530,
-65534,
-65096,
-65082,
-65534,
-65534,
-65534,
-65534,
-60906,
-48507,
-31732,
-13297,
-1,
-65535,
-3,
-65535,
-0,
-13946,
-31169,
-47100,
-59952,
-65534,
-65534,
-65533,
-65534,
-64336,
-52627,
-37161,
-19604,
-2701,
-65535,
-1,
-65535,
-2,
-17985,
-38109,
-55004,
-64441,
-64267,
-55103,
-40195,
-24461,
-13030,
-9730,
-15968,
-30384,
-49252,
-65534,
-65530,
-65534,
-65532,
-65534,
-46699,
-26710,
-10170,
-429,
-0,
-6015,
-19136,
-35320,
-50980,
-62808,
-65534,
-65534,
-58746,
-45658,
-30308,
-15639,
-4274,
-1,
-65535,
-3390,
-13439,
-26263,
-39794,
-52050,
-61298,
-65534,
-65534,
-60881,
-51059,
-38029,
-23843,
-10960,
-1917,
-65535,
-2434,
-12706,
-27807,
-44843,
-60408,
-65534,
-65534,
-65534,
-61408,
-46553,
-30143,
-15231,
-4221,
-2,
-65535,
-2616,
-9994,
-18556,
-26549,
-32636,
-36003,
-36432,
-34213,
-30087,
-25072,
-20352,
-17051,
-16089,
-18005,
-22831,
-30134,
-39001,
-48288,
-56736,
-63210,
-65534,
-65533,
-63856,
-57447,
-48578,
-38315,
-27980,
-18986,
-12586,
-9613,
-10245,
-13878,
-19205,
-24491,
-27975,
-28394,
-25284,
-19236,
-11672,
-4570,
-1,
-65535,
-2624,
-10303,
-20935,
-32916,
-44582,
-54514,
-61677,
-65482,
-65534,
-62255,
-55526,
-46087,
-34895,
-23359,
-13121,
-5908,
-3045,
-5197,
-12059,
-22436,
-34452,
-46080,
-55550,
-61865,
-64809,
-64977,
-63290,
-60715,
-57810,
-54663,
-50931,
-46097,
-39829,
-32169,
-23657,
-15190,
-7815,
-2445,
-65535,
-1,
-2481,
-7689,
-14985,
-23972,
-34136,
-44738,
-54730,
-62780,
-65534,
-65534,
-62906,
-53391,
-40469,
-26231,
-13171,
-3628,
-0,
-1020,
-8258,
-19660,
-33117,
-46300,
-57037,
-63681,
-65329,
-61914,
-54145,
-43430,
-31603,
-20701,
-12609,
-8743,
-9769,
-15404,
-24478,
-35070,
-44970,
-52096,
-55014,
-53222,
-47288,
-38674,
-29370,
-21443,
-16533,
-15550,
-18498,
-24572,
-32345,
-40140,
-46330,
-49649,
-49391,
-45511,
-38614,
-29904,
-20950,
-13531,
-9242,
-9282,
-14130,
-23397,
-35851,
-49559,
-62228,
-65534,
-65532,
-65534,
-65534,
-56157,
-41768,
-26801,
-13437,
-3457,
-65535,
-65535,
-1535,
-9145,
-18915,
-29265,
-38692,
-46003,
-50473,
-51925,
-50724,
-47636,
-43635,
-39708,
-36581,
-34682,
-34032,
-34385,
-35340,
-36503,
-37602,
-38504,
-39184,
-39633,
-39752,
-39381,
-38304,
-36407,
-33799,
-30889,
-28350,
-27015,
-27564,
-30374,
-35227,
-41392,
-47636,
-52611,
-55094,
-54366,
-50353,
-43663,
-35437,
-27076,
-19957,
-15148,
-13257,
-14349,
-18011,
-23437,
-29614,
-35458,
-40001,
-42561,
-42824,
-40986,
-37669,
-33869,
-30695,
-29138,
-29750,
-32526,
-36813,
-41517,
-45339,
-47187,
-46406,
-43037,
-37680,
-31385,
-25285,
-20316,
-17042,
-15585,
-15774,
-17307,
-19950,
-23583,
-28208,
-33733,
-39931,
-46240,
-51973,
-56395,
-59078,
-60072,
-59962,
-59729,
-60367,
-62504,
-65534,
-65534,
-65534,
-65532,
-65534,
-57877,
-43887,
-27465,
-11213,
-65535,
-2,
-65535,
-1,
-65535,
-8987,
-20675,
-31816,
-41548,
-49602,
-56003,
-60798,
-63753,
-64379,
-62038,
-56339,
-47424,
-36189,
-24255,
-13633,
-6280,
-3554,
-5822,
-12372,
-21542,
-31204,
-39304,
-44399,
-45993,
-44603,
-41518,
-38382,
-36690,
-37357,
-40486,
-45398,
-50836,
-55414,
-57960,
-57922,
-55441,
-51367,
-46933,
-43458,
-41931,
-42757,
-45609,
-49537,
-53157,
-55045,
-54040,
-49587,
-41822,
-31624,
-20396,
-9829,
-1591,
-65535,
-3,
-1402,
-9999,
-21561,
-34541,
-47173,
-57714,
-64709,
-65534,
-65092,
-58776,
-49516,
-39034,
-29227,
-21800,
-17937,
-18057,
-21758,
-27938,
-35070,
-41581,
-46199,
-48222,
-47626,
-44995,
-41294,
-37643,
-34956,
-33836,
-34405,
-36368,
-39124,
-41903,
-43956,
-44678,
-43706,
-40980,
-36756,
-31575,
-26222,
-21591,
-18597,
-17936,
-20034,
-24802,
-31730,
-39829,
-47879,
-54590,
-58902,
-60150,
-58227,
-53559,
-47024,
-39742,
-32867,
-27370,
-23882,
-22643,
-23508,
-26028,
-29582,
-33492,
-37133,
-40043,
-41897,
-42618,
-42251,
-41015,
-39191,
-37106,
-35040,
-33251,
-31859,
-30942,
-30472,
-30392,
-30622,
-31115,
-31820,
-32751,
-33905,
-35279,
-36863,
-38572,
-40320,
-41968,
-43376,
-44406,
-44954,
-44937,
-44341,
-43199,
-41602,
-39722,
-37767,
-35997,
-34678,
-34022,
-34183,
-35147,
-36770,
-38708,
-40514,
-41653,
-41645,
-40142,
-37041,
-32550,
-27175,
-21697,
-17008,
-14012,
-13385,
-15496,
-20262,
-27169,
-35334,
-43655,
-50998,
-56416,
-59274,
-59391,
-57008,
-52747,
-47457,
-42052,
-37335,
-33884,
-31955,
-31500,
-32202,
-33586,
-35138,
-36410,
-37129,
-37207,
-36788,
-36129,
-35589,
-35473,
-35974,
-37094,
-38641,
-40224,
-41397,
-41669,
-40715,
-38412,
-34893,
-30612,
-26178,
-22366,
-19871,
-19260,
-20794,
-24403,
-29681,
-35918,
-42266,
-47826,
-51823,
-53730,
-53324,
-50726,
-46377,
-40916,
-35143,
-29823,
-25637,
-23059,
-22340,
-23439,
-26133,
-29934,
-34302,
-38589,
-42218,
-44697,
-45725,
-45206,
-43282,
-40311,
-36798,
-33350,
-30530,
-28810,
-28434,
-29436,
-31551,
-34343,
-37187,
-39469,
-40616,
-40272,
-38339,
-35037,
-30879,
-26623,
-23113,
-21168,
-21379,
-24006,
-28857,
-35349,
-42519,
-49283,
-54570,
-57583,
-57933,
-55713,
-51466,
-46028,
-40372,
-35336,
-31543,
-29210,
-28247,
-28278,
-28792,
-29336,
-29546,
-29317,
-28718,
-28009,
-27519,
-27576,
-28408,
-30108,
-32570,
-35547,
-38626,
-41339,
-43235,
-43932,
-43269,
-41276,
-38247,
-34669,
-31140,
-28257,
-26515,
-26177,
-27310,
-29705,
-33030,
-36830,
-40670,
-44142,
-46935,
-48788,
-49548,
-49103,
-47464,
-44738,
-41187,
-37204,
-33272,
-29903,
-27499,
-26322,
-26374,
-27472,
-29268,
-31374,
-33470,
-35346,
-36957,
-38322,
-39494,
-40420,
-40945,
-40787,
-39652,
-37312,
-33776,
-29290,
-24440,
-19962,
-16711,
-15405,
-16526,
-20178,
-26060,
-33484,
-41499,
-48983,
-54891,
-58320,
-58755,
-56078,
-50661,
-43299,
-35069,
-27213,
-20828,
-16787,
-15505,
-16955,
-20711,
-26058,
-32213,
-38424,
-44126,
-48918,
-52557,
-54853,
-55637,
-54725,
-52005,
-47520,
-41605,
-34908,
-28412,
-23250,
-20513,
-20985,
-24935,
-31958,
-41068,
-50742,
-59271,
-65000,
-65533,
-63534,
-55714,
-44000,
-29846,
-15179,
-2117,
-0,
-65535,
-0,
-65535,
-9927,
-25315,
-41321,
-55411,
-65449,
-65533,
-65534,
-62047,
-51778,
-39949,
-28770,
-20103,
-15117,
-14097,
-16490,
-21103,
-26428,
-31029,
-33856,
-34469,
-33113,
-30613,
-28172,
-27036,
-28190,
-32078,
-38443,
-46388,
-54466,
-61132,
-64969,
-65194,
-61742,
-55425,
-47647,
-40132,
-34435,
-31560,
-31686,
-34129,
-37522,
-40188,
-40597,
-37772,
-31565,
-22732,
-12731,
-3477,
-65535,
-65535,
-1,
-4040,
-15318,
-28981,
-43046,
-55397,
-64192,
-65534,
-65533,
-60297,
-50088,
-37959,
-26072,
-16541,
-10970,
-10187,
-14052,
-21550,
-30976,
-40399,
-47986,
-52493,
-53365,
-50902,
-46001,
-39963,
-34123,
-29565,
-26939,
-26362,
-27511,
-29720,
-32207,
-34226,
-35207,
-34874,
-33237,
-30613,
-27542,
-24703,
-22798,
-22414,
-23916,
-27337,
-32357,
-38328,
-44374,
-49555,
-53044,
-54277,
-53077,
-49658,
-44593,
-38664,
-32734,
-27566,
-23724,
-21507,
-20937,
-21823,
-23817,
-26515,
-29524,
-32486,
-35164,
-37333,
-38903,
-39770,
-39906,
-39296,
-37977,
-36037,
-33650,
-31036,
-28523,
-26418,
-25062,
-24684,
-25400,
-27172,
-29775,
-32868,
-36016,
-38796,
-40850,
-41968,
-42105,
-41376,
-40033,
-38385,
-36756,
-35412,
-34523,
-34148,
-34237,
-34653,
-35228,
-35770,
-36150,
-36302,
-36235,
-36060,
-35886,
-35846,
-35976,
-36206,
-36339,
-36066,
-35068,
-33069,
-29997,
-26003,
-21538,
-17252,
-13936,
-12287,
-12833,
-15710,
-20677,
-27090,
-34074,
-40625,
-45904,
-49298,
-50597,
-49991,
-47959,
-45204,
-42419,
-40167,
-38767,
-38227,
-38317,
-38598,
-38651,
-38086,
-36784,
-34819,
-32524,
-30369,
-28811,
-28221,
-28692,
-30080,
-31960,
-33784,
-34986,
-35183,
-34224,
-32321,
-29917,
-27630,
-26061,
-25634,
-26476,
-28408,
-30943,
-33499,
-35478,
-36503,
-36460,
-35560,
-34259,
-33106,
-32620,
-33095,
-34528,
-36619,
-38785,
-40377,
-40772,
-39599,
-36815,
-32773,
-28150,
-23843,
-20765,
-19657,
-20915,
-24501,
-29894,
-36232,
-42410,
-47344,
-50130,
-50246,
-47593,
-42544,
-35808,
-28339,
-21131,
-15115,
-11007,
-9273,
-10083,
-13338,
-18674,
-25537,
-33173,
-40763,
-47442,
-52450,
-55211,
-55460,
-53261,
-49066,
-43573,
-37666,
-32202,
-27877,
-25115,
-23991,
-24295,
-25599,
-27378,
-29172,
-30624,
-31577,
-32022,
-32075,
-31880,
-31587,
-31247,
-30881,
-30407,
-29767,
-28895,
-27803,
-26595,
-25451,
-24631,
-24425,
-25078,
-26756,
-29455,
-32986,
-36978,
-40911,
-44219,
-46391,
-47075,
-46176,
-43858,
-40543,
-36805,
-33258,
-30471,
-28805,
-28466,
-29396,
-31392,
-34103,
-37098,
-39920,
-42092,
-43177,
-42813,
-40757,
-36983,
-31684,
-25352,
-18673,
-12505,
-7676,
-4902,
-4579,
-6796,
-11227,
-17304,
-24221,
-31177,
-37393,
-42318,
-45568,
-47050,
-46847,
-45271,
-42735,
-39759,
-36843,
-34417,
-32762,
-31959,
-31892,
-32305,
-32868,
-33332,
-33560,
-33632,
-33737,
-34148,
-35040,
-36414,
-38074,
-39637,
-40737,
-41129,
-40879,
-40364,
-40217,
-41069,
-43340,
-46935,
-51193,
-54914,
-56636,
-55033,
-49292,
-39479,
-26602,
-12517,
-0,
-65535,
-65535,
-65535,
-0,
-9495,
-25693,
-42513,
-57625,
-65534,
-65531,
-65534,
-65531,
-65014,
-54218,
-42216,
-30561,
-20588,
-13286,
-9159,
-8250,
-10152,
-14142,
-19340,
-24880,
-30086,
-34544,
-38168,
-41090,
-43598,
-45932,
-48204,
-50281,
-51809,
-52304,
-51255,
-48361,
-43593,
-37343,
-30368,
-23690,
-18426,
-15503,
-15503,
-18424,
-23708,
-30250,
-36648,
-41464,
-43540,
-42292,
-37823,
-30977,
-23170,
-16074,
-11333,
-10125,
-12974,
-19592,
-28931,
-39407,
-49198,
-56608,
-60397,
-59981,
-55553,
-47976,
-38654,
-29177,
-21113,
-15633,
-13411,
-14472,
-18261,
-23796,
-29855,
-35264,
-39106,
-40872,
-40561,
-38606,
-35766,
-32937,
-30919,
-30288,
-31205,
-33490,
-36561,
-39699,
-42104,
-43177,
-42610,
-40484,
-37296,
-33806,
-30921,
-29445,
-29864,
-32214,
-35973,
-40173,
-43560,
-44892,
-43261,
-38333,
-30552,
-21046,
-11494,
-3754,
-65535,
-65535,
-4539,
-13448,
-24930,
-37091,
-47970,
-55947,
-59998,
-59883,
-56087,
-49661,
-41984,
-34428,
-28183,
-24016,
-22252,
-22742,
-24983,
-28205,
-31579,
-34302,
-35791,
-35755,
-34245,
-31660,
-28667,
-26043,
-24554,
-24741,
-26806,
-30563,
-35428,
-40576,
-45057,
-48048,
-48976,
-47648,
-44301,
-39498,
-34080,
-28936,
-24904,
-22584,
-22283,
-23958,
-27241,
-31515,
-36021,
-39963,
-42675,
-43671,
-42783,
-40112,
-36076,
-31254,
-26351,
-22027,
-18812,
-17054,
-16841,
-18094,
-20529,
-23822,
-27573,
-31446,
-35109,
-38315,
-40841,
-42524,
-43248,
-42971,
-41739,
-39704,
-37118,
-34294,
-31600,
-29344,
-27772,
-26992,
-26976,
-27595,
-28623,
-29840,
-31043,
-32127,
-33048,
-33863,
-34640,
-35452,
-36327,
-37230,
-38049,
-38677,
-38966,
-38862,
-38361,
-37541,
-36542,
-35499,
-34505,
-33552,
-32546,
-31260,
-29504,
-27085,
-24005,
-20454,
-16864,
-13819,
-12017,
-12018,
-14203,
-18544,
-24652,
-31731,
-38780,
-44736,
-48709,
-50180,
-49080,
-45843,
-41270,
-36394,
-32219,
-29566,
-28863,
-30136,
-32998,
-36771,
-40659,
-43879,
-45849,
-46233,
-45017,
-42423,
-38898,
-34948,
-31101,
-27782,
-25270,
-23699,
-23041,
-23172,
-23909,
-25076,
-26517,
-28150,
-29897,
-31719,
-33499,
-35114,
-36329,
-36926,
-36702,
-35579,
-33638,
-31149,
-28551,
-26322,
-24952,
-24722,
-25733,
-27803,
-30568,
-33549,
-36288,
-38456,
-39886,
-40635,
-40839,
-40719,
-40413,
-39952,
-39264,
-38155,
-36465,
-34069,
-31028,
-27536,
-23976,
-20793,
-18440,
-17276,
-17457,
-18936,
-21426,
-24474,
-27550,
-30173,
-31999,
-32970,
-33258,
-33308,
-33659,
-34815,
-37061,
-40334,
-44189,
-47846,
-50397,
-50987,
-49105,
-44709,
-38294,
-30815,
-23442,
-17365,
-13469,
-12219,
-13575,
-17062,
-21929,
-27339,
-32505,
-36859,
-40009,
-41785,
-42171,
-41226,
-39129,
-36116,
-32506,
-28720,
-25183,
-22332,
-20482,
-19824,
-20340,
-21887,
-24175,
-26928,
-29846,
-32761,
-35530,
-38123,
-40510,
-42693,
-44646,
-46346,
-47712,
-48663,
-49031,
-48643,
-47258,
-44696,
-40841,
-35785,
-29841,
-23550,
-17620,
-12756,
-9527,
-8215,
-8734,
-10717,
-13601,
-16826,
-20025,
-23036,
-25973,
-29025,
-32348,
-35901,
-39396,
-42358,
-44271,
-44751,
-43716,
-41377,
-38253,
-34921,
-31931,
-29592,
-28008,
-27053,
-26601,
-26510,
-26819,
-27590,
-28903,
-30678,
-32678,
-34505,
-35805,
-36401,
-36505,
-36682,
-37749,
-40448,
-45134,
-51507,
-58549,
-64729,
-65532,
-65534,
-63286,
-54376,
-42571,
-29681,
-17578,
-7810,
-1239,
-1,
-65535,
-508,
-5076,
-11428,
-19409,
-28786,
-39036,
-49180,
-57849,
-63578,
-65149,
-62077,
-54763,
-44532,
-33310,
-23121,
-15603,
-11576,
-10980,
-12986,
-16414,
-20177,
-23614,
-26678,
-29795,
-33594,
-38542,
-44652,
-51407,
-57802,
-62736,
-65194,
-64716,
-61349,
-55756,
-48873,
-41745,
-35151,
-29550,
-24957,
-21119,
-17646,
-14223,
-10747,
-7385,
-4553,
-2828,
-2798,
-4951,
-9521,
-16446,
-25285,
-35291,
-45429,
-54551,
-61539,
-65490,
-65534,
-62745,
-56532,
-48206,
-38993,
-30187,
-22919,
-17992,
-15745,
-16080,
-18507,
-22289,
-26624,
-30763,
-34160,
-36512,
-37777,
-38129,
-37896,
-37425,
-37074,
-37009,
-37303,
-37795,
-38219,
-38236,
-37524,
-35889,
-33340,
-30089,
-26593,
-23425,
-21243,
-20596,
-21882,
-25189,
-30284,
-36605,
-43295,
-49337,
-53687,
-55461,
-54097,
-49501,
-42097,
-32824,
-22980,
-14063,
-7434,
-4178,
-4765,
-9106,
-16437,
-25582,
-35089,
-43557,
-49826,
-53184,
-53424,
-50836,
-46097,
-40128,
-33909,
-28333,
-24063,
-21476,
-20633,
-21318,
-23102,
-25489,
-27964,
-30191,
-31975,
-33359,
-34536,
-35763,
-37292,
-39204,
-41432,
-43677,
-45545,
-46577,
-46428,
-44916,
-42115,
-38333,
-34062,
-29887,
-26364,
-23943,
-22878,
-23193,
-24710,
-27048,
-29728,
-32217,
-34039,
-34838,
-34467,
-33001,
-30755,
-28208,
-25940,
-24477,
-24218,
-25297,
-27590,
-30714,
-34119,
-37227,
-39515,
-40674,
-40600,
-39447,
-37522,
-35244,
-33012,
-31175,
-29935,
-29382,
-29462,
-30038,
-30909,
-31852,
-32666,
-33184,
-33335,
-33115,
-32648,
-32111,
-31759,
-31811,
-32446,
-33710,
-35517,
-37631,
-39730,
-41444,
-42457,
-42557,
-41681,
-39941,
-37568,
-34898,
-32257,
-29951,
-28152,
-26939,
-26238,
-25886,
-25656,
-25325,
-24716,
-23776,
-22566,
-21319,
-20340,
-20041,
-20745,
-22713,
-25966,
-30309,
-35297,
-40317,
-44667,
-47719,
-49001,
-48353,
-45900,
-42082,
-37542,
-32983,
-29069,
-26274,
-24808,
-24637,
-25485,
-26956,
-28629,
-30142,
-31295,
-32031,
-32474,
-32813,
-33297,
-34122,
-35402,
-37142,
-39225,
-41460,
-43566,
-45289,
-46327,
-46461,
-45496,
-43321,
-39906,
-35356,
-29871,
-23845,
-17760,
-12236,
-7914,
-5365,
-5038,
-7093,
-11415,
-17561,
-24826,
-32360,
-39286,
-44868,
-48603,
-50329,
-50170,
-48538,
-45967,
-43029,
-40191,
-37757,
-35819,
-34312,
-33054,
-31843,
-30550,
-29139,
-27739,
-26549,
-25857,
-25883,
-26771,
-28469,
-30779,
-33305,
-35621,
-37259,
-37943,
-37542,
-36226,
-34334,
-32375,
-30820,
-30032,
-30114,
-30900,
-31995,
-32879,
-33079,
-32308,
-30573,
-28179,
-25670,
-23672,
-22735,
-23193,
-25070,
-28106,
-31820,
-35646,
-39063,
-41686,
-43311,
-43915,
-43575,
-42434,
-40650,
-38335,
-35634,
-32650,
-29547,
-26485,
-23651,
-21209,
-19309,
-18061,
-17557,
-17887,
-19124,
-21333,
-24518,
-28562,
-33238,
-38121,
-42728,
-46497,
-48974,
-49859,
-49072,
-46786,
-43330,
-39142,
-34668,
-30272,
-26258,
-22838,
-20188,
-18467,
-17817,
-18327,
-19993,
-22661,
-26025,
-29654,
-33096,
-35941,
-37957,
-39100,
-39516,
-39475,
-39252,
-39060,
-38948,
-38845,
-38545,
-37836,
-36534,
-34571,
-31998,
-28983,
-25794,
-22722,
-20103,
-18221,
-17325,
-17572,
-18989,
-21462,
-24710,
-28347,
-31910,
-35006,
-37354,
-38876,
-39707,
-40120,
-40441,
-40961,
-41769,
-42834,
-43882,
-44574,
-44539,
-43427,
-41053,
-37289,
-32215,
-26021,
-19091,
-11992,
-5477,
-421,
-65535,
-0,
-1703,
-8574,
-17895,
-28475,
-38877,
-47733,
-53979,
-57109,
-57137,
-54577,
-50184,
-44774,
-39045,
-33519,
-28574,
-24519,
-21662,
-20287,
-20589,
-22531,
-25762,
-29632,
-33318,
-36118,
-37662,
-38171,
-38359,
-39290,
-41914,
-46674,
-53191,
-60202,
-65532,
-65534,
-65468,
-57511,
-44946,
-29634,
-14092,
-876,
-2,
-65535,
-2,
-65535,
-5151,
-15666,
-26537,
-36956,
-46405,
-54431,
-60513,
-64001,
-64284,
-61026,
-54441,
-45438,
-35515,
-26480,
-19981,
-17064,
-17890,
-21677,
-26982,
-32104,
-35630,
-36797,
-35689,
-33142,
-30433,
-28866,
-29381,
-32300,
-37280,
-43430,
-49552,
-54467,
-57187,
-57159,
-54238,
-48706,
-41192,
-32534,
-23705,
-15672,
-9273,
-5135,
-3549,
-4472,
-7513,
-12073,
-17424,
-22924,
-28092,
-32676,
-36664,
-40146,
-43266,
-46074,
-48503,
-50369,
-51421,
-51450,
-50323,
-48099,
-44942,
-41177,
-37154,
-33250,
-29800,
-27063,
-25237,
-24406,
-24577,
-25618,
-27304,
-29283,
-31186,
-32615,
-33312,
-33135,
-32176,
-30690,
-29110,
-27891,
-27490,
-28205,
-30146,
-33192,
-36973,
-40943,
-44417,
-46706,
-47190,
-45487,
-41505,
-35541,
-28266,
-20645,
-13821,
-8895,
-6738,
-7831,
-12116,
-19062,
-27669,
-36728,
-44940,
-51221,
-54780,
-55310,
-52932,
-48221,
-42012,
-35350,
-29223,
-24496,
-21723,
-21094,
-22437,
-25227,
-28755,
-32232,
-34994,
-36629,
-37041,
-36474,
-35418,
-34478,
-34203,
-34967,
-36828,
-39561,
-42664,
-45475,
-47320,
-47611,
-46005,
-42404,
-37060,
-30448,
-23304,
-16428,
-10657,
-6671,
-4941,
-5630,
-8594,
-13401,
-19434,
-25986,
-32414,
-38193,
-43005,
-46704,
-49294,
-50839,
-51425,
-51091,
-49864,
-47763,
-44856,
-41297,
-37329,
-33282,
-29509,
-26342,
-24035,
-22724,
-22430,
-23057,
-24441,
-26335,
-28497,
-30660,
-32588,
-34106,
-35099,
-35563,
-35583,
-35323,
-34964,
-34679,
-34513,
-34436,
-34256,
-33780,
-32778,
-31198,
-29106,
-26799,
-24694,
-23256,
-22878,
-23742,
-25806,
-28739,
-32045,
-35144,
-37507,
-38788,
-38864,
-37878,
-36157,
-34159,
-32343,
-31067,
-30546,
-30763,
-31542,
-32541,
-33378,
-33701,
-33293,
-32137,
-30459,
-28659,
-27296,
-26906,
-27908,
-30496,
-34515,
-39556,
-44912,
-49799,
-53438,
-55206,
-54763,
-52021,
-47212,
-40744,
-33180,
-25134,
-17209,
-10000,
-4012,
-1,
-65535,
-65535,
-1,
-4316,
-10614,
-18142,
-26225,
-34138,
-41244,
-47037,
-51242,
-53777,
-54777,
-54475,
-53217,
-51285,
-48984,
-46467,
-43874,
-41218,
-38497,
-35677,
-32741,
-29714,
-26706,
-23917,
-21624,
-20198,
-19972,
-21228,
-24068,
-28338,
-33599,
-39135,
-44028,
-47324,
-48189,
-46116,
-41047,
-33466,
-24329,
-14986,
-6886,
-1399,
-1,
-1649,
-7624,
-16602,
-27309,
-38210,
-47808,
-54886,
-58700,
-59108,
-56516,
-51825,
-46171,
-40749,
-36535,
-34117,
-33597,
-34582,
-36307,
-37798,
-38153,
-36714,
-33295,
-28221,
-22279,
-16595,
-12344,
-10529,
-11716,
-15923,
-22563,
-30602,
-38711,
-45593,
-50170,
-51839,
-50516,
-46632,
-41041,
-34750,
-28857,
-24172,
-21308,
-20396,
-21308,
-23558,
-26550,
-29625,
-32247,
-34047,
-34940,
-35045,
-34709,
-34359,
-34408,
-35162,
-36704,
-38904,
-41409,
-43749,
-45395,
-45930,
-45059,
-42744,
-39134,
-34611,
-29648,
-24832,
-20702,
-17740,
-16312,
-16579,
-18547,
-21978,
-26480,
-31496,
-36430,
-40689,
-43824,
-45542,
-45798,
-44722,
-42614,
-39827,
-36726,
-33590,
-30642,
-27991,
-25733,
-23918,
-22635,
-21953,
-21967,
-22718,
-24220,
-26418,
-29211,
-32479,
-36051,
-39767,
-43399,
-46692,
-49318,
-50918,
-51128,
-49684,
-46483,
-41643,
-35583,
-28898,
-22386,
-16834,
-12934,
-11165,
-11699,
-14400,
-18861,
-24441,
-30430,
-36071,
-40746,
-43982,
-45589,
-45602,
-44351,
-42295,
-40010,
-37986,
-36544,
-35746,
-35387,
-35036,
-34224,
-32531,
-29812,
-26228,
-22264,
-18637,
-16116,
-15336,
-16659,
-20051,
-25108,
-31139,
-37271,
-42664,
-46585,
-48578,
-48455,
-46360,
-42685,
-38051,
-33173,
-28778,
-25455,
-23577,
-23202,
-24084,
-25764,
-27658,
-29310,
-30460,
-31214,
-31947,
-33219,
-35548,
-39165,
-43922,
-49168,
-53949,
-57149,
-57841,
-55473,
-50055,
-42142,
-32715,
-22942,
-13985,
-6756,
-1874,
-65535,
-3,
-2764,
-7674,
-14212,
-21850,
-29861,
-37501,
-44000,
-48744,
-51395,
-51986,
-50912,
-48860,
-46587,
-44744,
-43669,
-43312,
-43266,
-42918,
-41662,
-39132,
-35349,
-30764,
-26205,
-22646,
-21047,
-22025,
-25781,
-31920,
-39551,
-47385,
-53925,
-57784,
-57873,
-53687,
-45411,
-33965,
-20896,
-8145,
-0,
-65535,
-1,
-65535,
-2585,
-14225,
-26914,
-38533,
-47243,
-51899,
-52170,
-48640,
-42582,
-35718,
-29804,
-26292,
-26021,
-29081,
-34769,
-41819,
-48564,
-53417,
-55094,
-53001,
-47304,
-38993,
-29623,
-21062,
-15044,
-12825,
-14877,
-20804,
-29399,
-38920,
-47482,
-53399,
-55599,
-53738,
-48272,
-40296,
-31266,
-22717,
-15935,
-11782,
-10564,
-12054,
-15611,
-20302,
-25160,
-29302,
-32125,
-33382,
-33206,
-32085,
-30727,
-29934,
-30368,
-32465,
-36219,
-41268,
-46845,
-52030,
-55858,
-57601,
-56856,
-53676,
-48508,
-42106,
-35357,
-29099,
-23992,
-20408,
-18442,
-17932,
-18569,
-19980,
-21806,
-23781,
-25713,
-27516,
-29151,
-30614,
-31906,
-33004,
-33867,
-34426,
-34609,
-34350,
-33624,
-32471,
-30996,
-29417,
-27971,
-26962,
-26614,
-27085,
-28366,
-30306,
-32593,
-34877,
-36776,
-38062,
-38620,
-38571,
-38141,
-37663,
-37411,
-37563,
-38098,
-38853,
-39538,
-39887,
-39699,
-38978,
-37872,
-36665,
-35643,
-34962,
-34574,
-34179,
-33291,
-31365,
-28000,
-23056,
-16841,
-10030,
-3641,
-1,
-65535,
-0,
-1834,
-9190,
-18642,
-28952,
-38740,
-46761,
-52085,
-54269,
-53407,
-50094,
-45305,
-40208,
-35939,
-33385,
-33008,
-34750,
-38038,
-41908,
-45212,
-46876,
-46165,
-42866,
-37352,
-30536,
-23659,
-18007,
-14657,
-14174,
-16552,
-21180,
-27026,
-32851,
-37513,
-40162,
-40442,
-38482,
-34854,
-30401,
-26046,
-22588,
-20575,
-20179,
-21256,
-23345,
-25849,
-28151,
-29757,
-30451,
-30273,
-29588,
-28918,
-28869,
-29925,
-32310,
-35934,
-40334,
-44804,
-48538,
-50776,
-51077,
-49297,
-45775,
-41098,
-36115,
-31603,
-28212,
-26248,
-25678,
-26146,
-27093,
-27915,
-28103,
-27404,
-25831,
-23717,
-21587,
-20062,
-19707,
-20872,
-23642,
-27718,
-32552,
-37353,
-41310,
-43724,
-44178,
-42623,
-39429,
-35284,
-31081,
-27716,
-25874,
-25914,
-27714,
-30775,
-34230,
-37135,
-38612,
-38098,
-35483,
-31147,
-25895,
-20807,
-16974,
-15277,
-16189,
-19625,
-25002,
-31317,
-37405,
-42159,
-44821,
-45095,
-43239,
-39967,
-36272,
-33202,
-31576,
-31846,
-33921,
-37277,
-40989,
-43991,
-45286,
-44143,
-40302,
-33989,
-25936,
-17236,
-9171,
-2968,
-0,
-65535,
-2876,
-8909,
-16645,
-24830,
-32205,
-37770,
-41011,
-41942,
-41119,
-39477,
-38064,
-37821,
-39295,
-42542,
-47068,
-51976,
-56141,
-58499,
-58261,
-55124,
-49313,
-41563,
-32971,
-24762,
-18087,
-13783,
-12239,
-13350,
-16536,
-20908,
-25410,
-29096,
-31241,
-31546,
-30126,
-27492,
-24407,
-21728,
-20193,
-20289,
-22153,
-25551,
-29982,
-34736,
-39134,
-42560,
-44679,
-45380,
-44853,
-43456,
-41682,
-40000,
-38778,
-38200,
-38235,
-38630,
-39012,
-38917,
-37976,
-35960,
-32889,
-29035,
-24897,
-21085,
-18224,
-16786,
-17035,
-18910,
-22117,
-26109,
-30277,
-33998,
-36785,
-38337,
-38560,
-37595,
-35704,
-33294,
-30778,
-28551,
-26921,
-26059,
-25991,
-26596,
-27625,
-28785,
-29767,
-30376,
-30513,
-30271,
-29849,
-29546,
-29660,
-30395,
-31850,
-33919,
-36384,
-38910,
-41129,
-42731,
-43492,
-43334,
-42319,
-40642,
-38566,
-36413,
-34449,
-32893,
-31821,
-31187,
-30826,
-30482,
-29905,
-28879,
-27336,
-25327,
-23075,
-20864,
-19020,
-17783,
-17293,
-17534,
-18382,
-19645,
-21135,
-22714,
-24330,
-26013,
-27812,
-29815,
-32039,
-34484,
-37086,
-39756,
-42378,
-44834,
-46979,
-48652,
-49673,
-49865,
-49081,
-47280,
-44506,
-40962,
-36933,
-32759,
-28784,
-25260,
-22374,
-20207,
-18787,
-18135,
-18229,
-19089,
-20624,
-22700,
-25037,
-27274,
-29012,
-29901,
-29774,
-28635,
-26765,
-24543,
-22442,
-20853,
-20024,
-20039,
-20831,
-22267,
-24186,
-26477,
-29035,
-31759,
-34510,
-37094,
-39301,
-40996,
-42125,
-42856,
-43420,
-44117,
-45102,
-46300,
-47369,
-47775,
-46982,
-44709,
-41097,
-36797,
-32845,
-30366,
-30236,
-32710,
-37288,
-42734,
-47398,
-49631,
-48265,
-42945,
-34232,
-23481,
-12469,
-3016,
-65535,
-1,
-65535,
-159,
-7831,
-17241,
-27295,
-36899,
-44999,
-50674,
-53241,
-52424,
-48539,
-42521,
-35883,
-30398,
-27702,
-28835,
-33882,
-41882,
-50975,
-58864,
-63405,
-63184,
-57888,
-48459,
-36766,
-25252,
-16232,
-11444,
-11643,
-16536,
-24903,
-34959,
-44708,
-52378,
-56639,
-56842,
-52971,
-45672,
-36056,
-25555,
-15713,
-7902,
-3172,
-2007,
-4275,
-9262,
-15799,
-22576,
-28366,
-32364,
-34278,
-34388,
-33420,
-32300,
-31951,
-33035,
-35841,
-40271,
-45861,
-51940,
-57728,
-62453,
-65473,
-65534,
-64689,
-60683,
-54605,
-47109,
-39031,
-31360,
-24988,
-20572,
-18381,
-18214,
-19478,
-21294,
-22759,
-23133,
-22054,
-19612,
-16306,
-12947,
-10426,
-9540,
-10790,
-14319,
-19840,
-26771,
-34267,
-41452,
-47486,
-51773,
-53975,
-54127,
-52559,
-49866,
-46762,
-43945,
-41939,
-40994,
-41020,
-41635,
-42246,
-42223,
-41048,
-38471,
-34572,
-29760,
-24682,
-20101,
-16701,
-14994,
-15169,
-17103,
-20384,
-24375,
-28388,
-31732,
-33927,
-34681,
-34040,
-32273,
-29901,
-27535,
-25797,
-25160,
-25889,
-27936,
-31005,
-34564,
-37994,
-40707,
-42287,
-42560,
-41652,
-39930,
-37916,
-36195,
-35224,
-35300,
-36439,
-38391,
-40719,
-42835,
-44177,
-44288,
-42929,
-40128,
-36185,
-31615,
-27065,
-23181,
-20511,
-19367,
-19832,
-21674,
-24485,
-27683,
-30699,
-33023,
-34330,
-34498,
-33635,
-32001,
-30011,
-28055,
-26539,
-25701,
-25682,
-26425,
-27769,
-29431,
-31107,
-32517,
-33457,
-33858,
-33784,
-33416,
-33028,
-32895,
-33263,
-34264,
-35900,
-38032,
-40396,
-42664,
-44498,
-45603,
-45804,
-45044,
-43436,
-41213,
-38726,
-36345,
-34445,
-33281,
-32959,
-33396,
-34292,
-35210,
-35616,
-35021,
-33082,
-29702,
-25101,
-19779,
-14476,
-10016,
-7158,
-6452,
-8111,
-11967,
-17512,
-23978,
-30504,
-36298,
-40773,
-43666,
-45067,
-45345,
-45110,
-44986,
-45520,
-47026,
-49469,
-52524,
-55546,
-57771,
-58439,
-56966,
-53127,
-47060,
-39351,
-30863,
-22621,
-15629,
-10626,
-8024,
-7785,
-9498,
-12472,
-15910,
-19097,
-21521,
-23025,
-23718,
-24022,
-24446,
-25507,
-27566,
-30740,
-34861,
-39539,
-44190,
-48221,
-51083,
-52430,
-52129,
-50323,
-47334,
-43649,
-39763,
-36148,
-33102,
-30789,
-29152,
-28038,
-27165,
-26310,
-25253,
-23966,
-22483,
-21015,
-19797,
-19098,
-19115,
-19955,
-21589,
-23905,
-26670,
-29678,
-32682,
-35549,
-38159,
-40497,
-42545,
-44303,
-45725,
-46716,
-47138,
-46834,
-45663,
-43562,
-40566,
-36830,
-32638,
-28324,
-24273,
-20810,
-18176,
-16481,
-15680,
-15648,
-16150,
-16992,
-18004,
-19132,
-20428,
-22040,
-24150,
-26938,
-30460,
-34666,
-39314,
-44055,
-48422,
-51987,
-54369,
-55391,
-55043,
-53557,
-51286,
-48693,
-46178,
-44048,
-42404,
-41131,
-39950,
-38456,
-36256,
-33080,
-28844,
-23741,
-18197,
-12805,
-8238,
-5088,
-3752,
-4373,
-6773,
-10533,
-15068,
-19748,
-24052,
-27638,
-30426,
-32562,
-34371,
-36230,
-38492,
-41310,
-44696,
-48355,
-51898,
-54794,
-56558,
-56840,
-55463,
-52527,
-48344,
-43392,
-38259,
-33489,
-29529,
-26651,
-24901,
-24147,
-24103,
-24419,
-24774,
-24933,
-24824,
-24502,
-24166,
-24049,
-24371,
-25266,
-26707,
-28558,
-30542,
-32374,
-33779,
-34596,
-34816,
-34545,
-34036,
-33531,
-33283,
-33405,
-33911,
-34674,
-35477,
-36109,
-36382,
-36226,
-35707,
-34991,
-34338,
-34006,
-34182,
-34954,
-36230,
-37812,
-39362,
-40564,
-41100,
-40821,
-39713,
-37953,
-35841,
-33754,
-32034,
-30920,
-30477,
-30570,
-30913,
-31118,
-30805,
-29713,
-27747,
-25056,
-21964,
-18940,
-16474,
-14975,
-14678,
-15614,
-17586,
-20258,
-23216,
-26088,
-28605,
-30682,
-32375,
-33897,
-35488,
-37379,
-39687,
-42376,
-45256,
-48000,
-50223,
-51545,
-51703,
-50572,
-48232,
-44936,
-41054,
-37033,
-33274,
-30081,
-27613,
-25851,
-24658,
-23791,
-23012,
-22114,
-21009,
-19711,
-18350,
-17118,
-16233,
-15860,
-16126,
-17023,
-18511,
-20438,
-22657,
-25000,
-27332,
-29556,
-31623,
-33508,
-35236,
-36822,
-38301,
-39692,
-41002,
-42217,
-43310,
-44236,
-44943,
-45389,
-45530,
-45342,
-44835,
-43997,
-42879,
-41478,
-39844,
-37993,
-35972,
-33824,
-31627,
-29455,
-27421,
-25601,
-24077,
-22872,
-21984,
-21353,
-20911,
-20580,
-20304,
-20085,
-19952,
-19997,
-20321,
-21028,
-22191,
-23820,
-25896,
-28308,
-30958,
-33689,
-36398,
-38976,
-41355,
-43504,
-45366,
-46925,
-48095,
-48819,
-48978,
-48514,
-47345,
-45509,
-43072,
-40222,
-37168,
-34183,
-31482,
-29232,
-27487,
-26177,
-25149,
-24185,
-23086,
-21727,
-20106,
-18361,
-16753,
-15601,
-15220,
-15826,
-17477,
-20056,
-23267,
-26717,
-29973,
-32681,
-34616,
-35752,
-36235,
-36359,
-36483,
-36921,
-37896,
-39424,
-41362,
-43379,
-45062,
-45996,
-45857,
-44499,
-41989,
-38592,
-34746,
-30929,
-27600,
-25083,
-23498,
-22793,
-22706,
-22915,
-23074,
-22934,
-22402,
-21554,
-20622,
-19919,
-19761,
-20387,
-21872,
-24135,
-26921,
-29874,
-32621,
-34830,
-36301,
-37008,
-37068,
-36745,
-36350,
-36155,
-36357,
-36961,
-37839,
-38693,
-39169,
-38928,
-37739,
-35561,
-32551,
-29072,
-25588,
-22608,
-20514,
-19545,
-19679,
-20703,
-22226,
-23809,
-25066,
-25745,
-25803,
-25399,
-24835,
-24508,
-24777,
-25910,
-28025,
-31048,
-34776,
-38878,
-42993,
-46757,
-49865,
-52088,
-53287,
-53409,
-52467,
-50541,
-47749,
-44250,
-40221,
-35852,
-31334,
-26843,
-22530,
-18511,
-14867,
-11640,
-8859,
-6533,
-4702,
-3423,
-2810,
-3004,
-4181,
-6489,
-10039,
-14825,
-20718,
-27423,
-34533,
-41539,
-47924,
-53255,
-57212,
-59714,
-60831,
-60848,
-60103,
-58966,
-57719,
-56486,
-55253,
-53845,
-52033,
-49582,
-46357,
-42367,
-37783,
-32912,
-28128,
-23807,
-20216,
-17505,
-15619,
-14409,
-13593,
-12926,
-12192,
-11346,
-10454,
-9755,
-9546,
-10146,
-11798,
-14597,
-18472,
-23176,
-28330,
-33521,
-38335,
-42497,
-45849,
-48409,
-50310,
-51749,
-52908,
-53913,
-54748,
-55328,
-55460,
-54961,
-53707,
-51669,
-48997,
-45919,
-42793,
-39928,
-37591,
-35879,
-34713,
-33853,
-32942,
-31595,
-29518,
-26556,
-22802,
-18555,
-14303,
-10630,
-8066,
-7038,
-7677,
-9891,
-13265,
-17250,
-21192,
-24545,
-26947,
-28327,
-28912,
-29165,
-29678,
-31004,
-33536,
-37359,
-42247,
-47666,
-52900,
-57184,
-59906,
-60682,
-59513,
-56710,
-52869,
-48722,
-44952,
-42088,
-40366,
-39687,
-39706,
-39846,
-39530,
-38257,
-35759,
-32046,
-27425,
-22411,
-17641,
-13711,
-11093,
-9982,
-10362,
-11906,
-14196,
-16712,
-19026,
-20870,
-22175,
-23092,
-23931,
-25048,
-26798,
-29360,
-32782,
-36844,
-41216,
-45418,
-49002,
-51579,
-52941,
-53052,
-52082,
-50323,
-48149,
-45898,
-43830,
-42049,
-40530,
-39103,
-37559,
-35689,
-33362,
-30604,
-27547,
-24483,
-21730,
-19614,
-18350,
-18014,
-18504,
-19588,
-20915,
-22172,
-23066,
-23500,
-23493,
-23254,
-23067,
-23251,
-24065,
-25628,
-27914,
-30716,
-33717,
-36552,
-38872,
-40446,
-41181,
-41162,
-40607,
-39840,
-39177,
-38894,
-39128,
-39846,
-40877,
-41900,
-42584,
-42604,
-41795,
-40137,
-37847,
-35269,
-32878,
-31097,
-30255,
-30465,
-31580,
-33244,
-34917,
-36035,
-36121,
-34898,
-32382,
-28854,
-24852,
-20999,
-17924,
-16059,
-15595,
-16415,
-18126,
-20190,
-22022,
-23170,
-23427,
-22880,
-21905,
-21091,
-21066,
-22387,
-25341,
-29910,
-35700,
-42062,
-48171,
-53242,
-56655,
-58109,
-57671,
-55731,
-52947,
-50041,
-47675,
-46283,
-45981,
-46569,
-47561,
-48328,
-48228,
-46771,
-43717,
-39145,
-33439,
-27196,
-21135,
-15918,
-12064,
-9817,
-9156,
-9783,
-11242,
-13008,
-14631,
-15815,
-16514,
-16867,
-17257,
-18058,
-19723,
-22461,
-26383,
-31273,
-36793,
-42408,
-47592,
-51861,
-54880,
-56531,
-56872,
-56165,
-54747,
-53003,
-51252,
-49691,
-48387,
-47237,
-46046,
-44554,
-42526,
-39807,
-36385,
-32382,
-28088,
-23850,
-20084,
-17102,
-15150,
-14273,
-14383,
-15227,
-16501,
-17875,
-19117,
-20084,
-20815,
-21446,
-22223,
-23397,
-25166,
-27634,
-30736,
-34304,
-38014,
-41531,
-44511,
-46680,
-47917,
-48216,
-47739,
-46722,
-45470,
-44237,
-43225,
-42483,
-41955,
-41457,
-40745,
-39600,
-37836,
-35435,
-32485,
-29236,
-26011,
-23169,
-21016,
-19743,
-19409,
-19889,
-20984,
-22368,
-23770,
-24941,
-25764,
-26243,
-26499,
-26725,
-27145,
-27936,
-29193,
-30893,
-32897,
-34974,
-36860,
-38293,
-39115,
-39255,
-38799,
-37939,
-36941,
-36089,
-35608,
-35624,
-36126,
-36978,
-37946,
-38766,
-39188,
-39077,
-38374,
-37194,
-35718,
-34197,
-32877,
-31938,
-31459,
-31417,
-31669,
-32019,
-32248,
-32169,
-31682,
-30767,
-29543,
-28161,
-26862,
-25827,
-25222,
-25093,
-25405,
-26020,
-26761,
-27447,
-27931,
-28174,
-28203,
-28153,
-28198,
-28497,
-29179,
-30254,
-31656,
-33222,
-34739,
-36011,
-36893,
-37321,
-37359,
-37119,
-36798,
-36568,
-36567,
-36854,
-37389,
-38065,
-38708,
-39156,
-39253,
-38948,
-38229,
-37211,
-36030,
-34876,
-33886,
-33164,
-32695,
-32392,
-32074,
-31538,
-30588,
-29111,
-27096,
-24678,
-22085,
-19629,
-17614,
-16270,
-15736,
-15971,
-16837,
-18098,
-19492,
-20827,
-21984,
-22991,
-23959,
-25080,
-26536,
-28448,
-30856,
-33655,
-36669,
-39634,
-42306,
-44472,
-46015,
-46931,
-47308,
-47332,
-47218,
-47172,
-47370,
-47873,
-48658,
-49572,
-50361,
-50722,
-50316,
-48872,
-46214,
-42343,
-37423,
-31824,
-26011,
-20535,
-15884,
-12418,
-10291,
-9424,
-9511,
-10121,
-10761,
-11022,
-10674,
-9718,
-8409,
-7201,
-6636,
-7243,
-9394,
-13203,
-18517,
-24882,
-31672,
-38176,
-43739,
-47915,
-50492,
-51601,
-51594,
-51025,
-50483,
-50471,
-51300,
-53026,
-55407,
-58016,
-60257,
-61560,
-61440,
-59636,
-56130,
-51162,
-45181,
-38743,
-32431,
-26731,
-21988,
-18331,
-15722,
-13943,
-12711,
-11713,
-10711,
-9553,
-8261,
-6947,
-5875,
-5326,
-5603,
-6935,
-9449,
-13120,
-17789,
-23160,
-28851,
-34449,
-39571,
-43910,
-47310,
-49744,
-51340,
-52324,
-52973,
-53547,
-54212,
-55033,
-55895,
-56599,
-56839,
-56318,
-54820,
-52236,
-48664,
-44332,
-39626,
-34959,
-30733,
-27229,
-24565,
-22694,
-21387,
-20371,
-19327,
-18061,
-16481,
-14706,
-12973,
-11635,
-11054,
-11502,
-13120,
-15856,
-19468,
-23607,
-27827,
-31754,
-35080,
-37691,
-39614,
-41033,
-42206,
-43397,
-44801,
-46490,
-48384,
-50279,
-51876,
-52870,
-52998,
-52124,
-50249,
-47539,
-44274,
-40802,
-37469,
-34549,
-32204,
-30451,
-29181,
-28182,
-27221,
-26075,
-24614,
-22832,
-20831,
-18839,
-17130,
-15977,
-15600,
-16091,
-17422,
-19429,
-21848,
-24394,
-26770,
-28792,
-30373,
-31548,
-32482,
-33372,
-34446,
-35867,
-37694,
-39877,
-42232,
-44517,
-46427,
-47730,
-48228,
-47908,
-46825,
-45226,
-43358,
-41559,
-40054,
-39030,
-38480,
-38315,
-38289,
-38120,
-37528,
-36301,
-34361,
-31771,
-28762,
-25631,
-22758,
-20442,
-18907,
-18219,
-18283,
-18891,
-19738,
-20552,
-21100,
-21302,
-21199,
-20973,
-20889,
-21214,
-22203,
-23943,
-26464,
-29581,
-33057,
-36563,
-39786,
-42466,
-44456,
-45713,
-46342,
-46519,
-46468,
-46420,
-46509,
-46807,
-47239,
-47642,
-47795,
-47441,
-46415,
-44610,
-42104,
-39063,
-35785,
-32595,
-29789,
-27581,
-26027,
-25059,
-24464,
-23990,
-23380,
-22448,
-21173,
-19631,
-18077,
-16803,
-16118,
-16274,
-17360,
-19348,
-22013,
-25073,
-28147,
-30940,
-33202,
-34869,
-35988,
-36755,
-37424,
-38248,
-39421,
-41001,
-42921,
-44972,
-46853,
-48269,
-48937,
-48734,
-47645,
-45828,
-43555,
-41147,
-38927,
-37125,
-35848,
-35066,
-34606,
-34226,
-33657,
-32678,
-31173,
-29154,
-26769,
-24275,
-21970,
-20156,
-19038,
-18722,
-19158,
-20174,
-21521,
-22900,
-24085,
-24911,
-25376,
-25580,
-25743,
-26102,
-26894,
-28237,
-30147,
-32480,
-35003,
-37412,
-39436,
-40866,
-41641,
-41806,
-41566,
-41146,
-40813,
-40745,
-41032,
-41630,
-42390,
-43098,
-43520,
-43484,
-42892,
-41762,
-40221,
-38440,
-36631,
-34954,
-33502,
-32267,
-31165,
-30037,
-28747,
-27167,
-25282,
-23154,
-20952,
-18891,
-17189,
-16025,
-15469,
-15506,
-16016,
-16809,
-17735,
-18634,
-19510,
-20401,
-21483,
-22923,
-24904,
-27484,
-30640,
-34190,
-37871,
-41367,
-44383,
-46721,
-48295,
-49181,
-49541,
-49624,
-49650,
-49772,
-50032,
-50331,
-50487,
-50242,
-49380,
-47743,
-45317,
-42208,
-38663,
-34966,
-31445,
-28324,
-25753,
-23738,
-22168,
-20869,
-19633,
-18314,
-16838,
-15253,
-13707,
-12415,
-11625,
-11535,
-12270,
-13849,
-16163,
-19045,
-22241,
-25535,
-28724,
-31703,
-34432,
-36966,
-39371,
-41756,
-44152,
-46564,
-48896,
-51014,
-52725,
-53873,
-54314,
-54006,
-52982,
-51341,
-49272,
-46920,
-44477,
-42017,
-39604,
-37215,
-34799,
-32312,
-29717,
-27043,
-24357,
-21786,
-19466,
-17545,
-16127,
-15285,
-15011,
-15282,
-15985,
-17042,
-18321,
-19751,
-21248,
-22803,
-24395,
-26077,
-27869,
-29821,
-31948,
-34230,
-36614,
-38995,
-41237,
-43211,
-44766,
-45841,
-46373,
-46420,
-46044,
-45375,
-44532,
-43612,
-42678,
-41733,
-40747,
-39660,
-38422,
-36994,
-35406,
-33698,
-31984,
-30354,
-28928,
-27750,
-26869,
-26228,
-25775,
-25412,
-25045,
-24627,
-24135,
-23621,
-23163,
-22892,
-22900,
-23283,
-24031,
-25097,
-26327,
-27551,
-28574,
-29258,
-29550,
-29488,
-29249,
-29029,
-29103,
-29640,
-30749,
-32383,
-34366,
-36438,
-38292,
-39677,
-40448,
-40608,
-40305,
-39807,
-39409,
-39381,
-39877,
-40900,
-42300,
-43806,
-45079,
-45815,
-45796,
-44950,
-43357,
-41241,
-38881,
-36596,
-34611,
-33057,
-31920,
-31065,
-30271,
-29311,
-27982,
-26211,
-24013,
-21557,
-19080,
-16854,
-15141,
-14106,
-13828,
-14272,
-15323,
-16812,
-18590,
-20511,
-22527,
-24604,
-26792,
-29108,
-31608,
-34271,
-37069,
-39927,
-42752,
-45447,
-47935,
-50125,
-51979,
-53420,
-54408,
-54882,
-54788,
-54102,
-52816,
-50969,
-48657,
-45993,
-43130,
-40213,
-37351,
-34625,
-32040,
-29575,
-27159,
-24735,
-22258,
-19738,
-17247,
-14920,
-12918,
-11445,
-10642,
-10630,
-11421,
-12942,
-15045,
-17507,
-20114,
-22641,
-24985,
-27056,
-28945,
-30737,
-32614,
-34721,
-37154,
-39927,
-42943,
-46006,
-48862,
-51240,
-52886,
-53661,
-53502,
-52484,
-50798,
-48651,
-46320,
-43994,
-41803,
-39772,
-37835,
-35836,
-33646,
-31106,
-28199,
-24960,
-21574,
-18275,
-15359,
-13095,
-11670,
-11187,
-11588,
-12733,
-14387,
-16296,
-18251,
-20104,
-21832,
-23504,
-25272,
-27330,
-29823,
-32852,
-36367,
-40221,
-44134,
-47776,
-50807,
-52944,
-54037,
-54064,
-53174,
-51616,
-49709,
-47742,
-45938,
-44369,
-42983,
-41582,
-39919,
-37740,
-34877,
-31303,
-27149,
-22713,
-18381,
-14586,
-11691,
-9950,
-9431,
-10024,
-11477,
-13419,
-15502,
-17417,
-18989,
-20221,
-21239,
-22306,
-23723,
-25729,
-28498,
-31983,
-36032,
-40296,
-44384,
-47896,
-50523,
-52124,
-52717,
-52520,
-51827,
-50991,
-50288,
-49861,
-49700,
-49621,
-49327,
-48522,
-46921,
-44439,
-41108,
-37191,
-33043,
-29094,
-25722,
-23184,
-21559,
-20744,
-20474,
-20422,
-20258,
-19761,
-18879,
-17728,
-16608,
-15885,
-15938,
-17039,
-19275,
-22525,
-26459,
-30614,
-34488,
-37656,
-39857,
-41062,
-41461,
-41425,
-41378,
-41726,
-42692,
-44300,
-46338,
-48389,
-49978,
-50634,
-50055,
-48162,
-45141,
-41399,
-37477,
-33933,
-31201,
-29515,
-28839,
-28908,
-29266,
-29438,
-28983,
-27683,
-25539,
-22832,
-20025,
-17671,
-16307,
-16261,
-17669,
-20323,
-23825,
-27577,
-30988,
-33562,
-35016,
-35379,
-34901,
-34079,
-33452,
-33507,
-34552,
-36607,
-39416,
-42489,
-45197,
-46958,
-47316,
-46118,
-43496,
-39871,
-35873,
-32142,
-29276,
-27588,
-27133,
-27654,
-28652,
-29544,
-29774,
-28968,
-27051,
-24221,
-20967,
-17908,
-15689,
-14797,
-15482,
-17658,
-20961,
-24810,
-28545,
-31604,
-33622,
-34549,
-34639,
-34378,
-34383,
-35191,
-37168,
-40335,
-44395,
-48744,
-52627,
-55296,
-56207,
-55135,
-52263,
-48114,
-43465,
-39129,
-35780,
-33782,
-33092,
-33277,
-33643,
-33373,
-31812,
-28571,
-23719,
-17746,
-11480,
-5935,
-2018,
-393,
-1267,
-4353,
-8973,
-14133,
-18851,
-22310,
-24088,
-24243,
-23296,
-22081,
-21578,
-22605,
-25671,
-30795,
-37504,
-44941,
-52029,
-57753,
-61350,
-62500,
-61389,
-58621,
-55108,
-51785,
-49445,
-48497,
-48941,
-50320,
-51910,
-52871,
-52468,
-50283,
-46266,
-40808,
-34603,
-28508,
-23355,
-19733,
-17917,
-17755,
-18794,
-20335,
-21661,
-22176,
-21569,
-19879,
-17483,
-14996,
-13142,
-12544,
-13614,
-16419,
-20670,
-25802,
-31060,
-35718,
-39188,
-41188,
-41754,
-41256,
-40256,
-39407,
-39242,
-40107,
-42010,
-44687,
-47618,
-50173,
-51772,
-51987,
-50672,
-47990,
-44343,
-40338,
-36572,
-33582,
-31642,
-30788,
-30760,
-31111,
-31313,
-30891,
-29552,
-27246,
-24220,
-20910,
-17898,
-15740,
-14837,
-15378,
-17237,
-20069,
-23340,
-26483,
-29016,
-30651,
-31344,
-31305,
-30920,
-30655,
-30937,
-32033,
-34000,
-36650,
-39607,
-42393,
-44519,
-45629,
-45555,
-44344,
-42284,
-39779,
-37287,
-35222,
-33809,
-33113,
-32966,
-33059,
-33008,
-32467,
-31206,
-29188,
-26581,
-23707,
-20993,
-18863,
-17614,
-17420,
-18203,
-19754,
-21711,
-23710,
-25427,
-26692,
-27490,
-27972,
-28416,
-29117,
-30346,
-32246,
-34802,
-37840,
-41060,
-44088,
-46577,
-48246,
-48967,
-48753,
-47763,
-46257,
-44509,
-42798,
-41269,
-39996,
-38896,
-37807,
-36515,
-34810,
-32542,
-29696,
-26342,
-22717,
-19117,
-15874,
-13322,
-11658,
-11006,
-11297,
-12351,
-13898,
-15607,
-17226,
-18544,
-19544,
-20286,
-21013,
-21976,
-23453,
-25634,
-28569,
-32174,
-36189,
-40285,
-44068,
-47218,
-49506,
-50860,
-51376,
-51266,
-50829,
-50360,
-50085,
-50116,
-50421,
-50838,
-51117,
-50992,
-50209,
-48660,
-46305,
-43303,
-39880,
-36344,
-33012,
-30119,
-27840,
-26179,
-25069,
-24306,
-23691,
-23002,
-22102,
-20952,
-19601,
-18222,
-17029,
-16238,
-16065,
-16583,
-17818,
-19656,
-21899,
-24341,
-26724,
-28901,
-30751,
-32291,
-33578,
-34762,
-35969,
-37328,
-38897,
-40651,
-42522,
-44343,
-45979,
-47244,
-48049,
-48312,
-48054,
-47329,
-46250,
-44945,
-43539,
-42140,
-40811,
-39584,
-38437,
-37318,
-36163,
-34891,
-33463,
-31853,
-30094,
-28263,
-26476,
-24864,
-23564,
-22670,
-22243,
-22265,
-22670,
-23331,
-24099,
-24824,
-25394,
-25725,
-25852,
-25802,
-25748,
-25803,
-26151,
-26878,
-28038,
-29570,
-31337,
-33127,
-34696,
-35826,
-36367,
-36282,
-35660,
-34705,
-33685,
-32879,
-32488,
-32619,
-33190,
-34034,
-34832,
-35311,
-35194,
-34398,
-32939,
-31049,
-29019,
-27220,
-25946,
-25392,
-25586,
-26380,
-27524,
-28668,
-29516,
-29838,
-29567,
-28801,
-27788,
-26879,
-26434,
-26759,
-28002,
-30129,
-32902,
-35917,
-38692,
-40748,
-41750,
-41545,
-40245,
-38184,
-35843,
-33772,
-32397,
-31978,
-32476,
-33596,
-34832,
-35580,
-35303,
-33652,
-30570,
-26315,
-21429,
-16596,
-12530,
-9792,
-8682,
-9174,
-10920,
-13358,
-15801,
-17661,
-18522,
-18279,
-17164,
-15656,
-14418,
-14101,
-15207,
-17952,
-22214,
-27545,
-33262,
-38616,
-42931,
-45787,
-47094,
-47127,
-46427,
-45705,
-45618,
-46659,
-48981,
-52391,
-56364,
-60175,
-63049,
-64369,
-63759,
-61258,
-57213,
-52291,
-47269,
-42875,
-39663,
-37816,
-37202,
-37339,
-37559,
-37156,
-35561,
-32491,
-28016,
-22568,
-16844,
-11653,
-7754,
-5671,
-5596,
-7350,
-10423,
-14100,
-17621,
-20358,
-21926,
-22290,
-21724,
-20760,
-20035,
-20167,
-21558,
-24380,
-28442,
-33330,
-38407,
-43036,
-46634,
-48874,
-49674,
-49268,
-48081,
-46673,
-45572,
-45160,
-45602,
-46772,
-48336,
-49797,
-50639,
-50452,
-49000,
-46332,
-42704,
-38589,
-34515,
-30991,
-28379,
-26839,
-26287,
-26461,
-26945,
-27321,
-27213,
-26421,
-24917,
-22894,
-20675,
-18685,
-17317,
-16871,
-17469,
-19052,
-21346,
-23990,
-26537,
-28611,
-29963,
-30505,
-30366,
-29801,
-29179,
-28852,
-29106,
-30065,
-31693,
-33765,
-35971,
-37899,
-39238,
-39714,
-39262,
-37970,
-36070,
-33933,
-31921,
-30390,
-29544,
-29454,
-29995,
-30907,
-31847,
-32442,
-32434,
-31664,
-30203,
-28245,
-26155,
-24317,
-23091,
-22728,
-23299,
-24716,
-26730,
-29025,
-31249,
-33143,
-34521,
-35369,
-35758,
-35878,
-35922,
-36107,
-36534,
-37294,
-38306,
-39476,
-40607,
-41498,
-41953,
-41814,
-40987,
-39466,
-37333,
-34733,
-31904,
-29061,
-26455,
-24252,
-22541,
-21331,
-20498,
-19881,
-19244,
-18409,
-17202,
-15633,
-13743,
-11784,
-10026,
-8806,
-8431,
-9080,
-10837,
-13573,
-17060,
-20930,
-24821,
-28406,
-31474,
-33998,
-36074,
-37958,
-39939,
-42292,
-45175,
-48600,
-52391,
-56246,
-59755,
-62540,
-64270,
-64806,
-64163,
-62553,
-60303,
-57817,
-55452,
-53482,
-52014,
-50995,
-50220,
-49393,
-48203,
-46379,
-43804,
-40471,
-36592,
-32418,
-28351,
-24685,
-21702,
-19502,
-18052,
-17184,
-16650,
-16178,
-15565,
-14699,
-13620,
-12471,
-11516,
-10999,
-11177,
-12157,
-13956,
-16435,
-19342,
-22383,
-25255,
-27734,
-29693,
-31162,
-32252,
-33196,
-34224,
-35533,
-37247,
-39346,
-41712,
-44117,
-46299,
-48010,
-49071,
-49428,
-49127,
-48359,
-47331,
-46319,
-45482,
-44963,
-44707,
-44639,
-44522,
-44169,
-43356,
-41986,
-40031,
-37600,
-34876,
-32111,
-29547,
-27385,
-25743,
-24623,
-23951,
-23550,
-23251,
-22866,
-22303,
-21523,
-20605,
-19673,
-18914,
-18484,
-18506,
-19026,
-19986,
-21277,
-22714,
-24126,
-25354,
-26302,
-26970,
-27394,
-27724,
-28078,
-28605,
-29393,
-30454,
-31748,
-33132,
-34470,
-35562,
-36306,
-36608,
-36491,
-36051,
-35423,
-34796,
-34300,
-34044,
-34026,
-34190,
-34405,
-34529,
-34436,
-34048,
-33383,
-32506,
-31571,
-30733,
-30159,
-29970,
-30246,
-30988,
-32175,
-33704,
-35469,
-37313,
-39085,
-40614,
-41764,
-42437,
-42602,
-42338,
-41790,
-41206,
-40827,
-40887,
-41489,
-42601,
-44018,
-45393,
-46306,
-46379,
-45323,
-43096,
-39838,
-35951,
-31916,
-28283,
-25460,
-23674,
-22894,
-22821,
-22995,
-22864,
-21961,
-19982,
-16923,
-13032,
-8859,
-5045,
-2286,
-1102,
-1764,
-4207,
-8036,
-12619,
-17205,
-21112,
-23874,
-25338,
-25735,
-25568,
-25545,
-26346,
-28499,
-32195,
-37271,
-43213,
-49289,
-54704,
-58816,
-61214,
-61907,
-61173,
-59613,
-57877,
-56591,
-56158,
-56693,
-58007,
-59664,
-61108,
-61770,
-61249,
-59353,
-56165,
-52031,
-47433,
-42944,
-39053,
-36086,
-34159,
-33102,
-32604,
-32161,
-31337,
-29734,
-27208,
-23807,
-19848,
-15791,
-12166,
-9465,
-7989,
-7842,
-8863,
-10698,
-12880,
-14937,
-16505,
-17402,
-17670,
-17521,
-17333,
-17470,
-18282,
-19933,
-22449,
-25642,
-29212,
-32780,
-35983,
-38561,
-40369,
-41451,
-41956,
-42163,
-42347,
-42768,
-43562,
-44757,
-46211,
-47710,
-48943,
-49650,
-49619,
-48779,
-47200,
-45085,
-42721,
-40430,
-38470,
-37013,
-36082,
-35570,
-35256,
-34883,
-34198,
-33039,
-31357,
-29242,
-26893,
-24585,
-22595,
-21141,
-20360,
-20227,
-20635,
-21358,
-22147,
-22779,
-23100,
-23067,
-22764,
-22346,
-22045,
-22062,
-22560,
-23578,
-25074,
-26860,
-28735,
-30435,
-31779,
-32641,
-33020,
-33002,
-32768,
-32504,
-32404,
-32581,
-33061,
-33790,
-34609,
-35346,
-35800,
-35835,
-35377,
-34456,
-33185,
-31751,
-30368,
-29250,
-28547,
-28351,
-28626,
-29279,
-30116,
-30947,
-31575,
-31889,
-31862,
-31591,
-31267,
-31148,
-31500,
-32516,
-34293,
-36745,
-39647,
-42638,
-45301,
-47256,
-48244,
-48205,
-47298,
-45880,
-44437,
-43458,
-43327,
-44208,
-45984,
-48291,
-50539,
-52114,
-52445,
-51227,
-48442,
-44433,
-39792,
-35275,
-31594,
-29269,
-28491,
-29075,
-30483,
-31975,
-32728,
-32107,
-29728,
-25668,
-20346,
-14555,
-9196,
-5148,
-3048,
-3144,
-5260,
-8828,
-13008,
-16896,
-19718,
-20995,
-20679,
-19104,
-16978,
-15119,
-14372,
-15296,
-18137,
-22682,
-28380,
-34412,
-39913,
-44150,
-46684,
-47463,
-46817,
-45365,
-43873,
-43056,
-43427,
-45168,
-48097,
-51738,
-55388,
-58351,
-60018,
-60078,
-58514,
-55665,
-52080,
-48453,
-45416,
-43445,
-42729,
-43163,
-44357,
-45760,
-46739,
-46789,
-45560,
-43009,
-39355,
-35049,
-30681,
-26843,
-23999,
-22416,
-22076,
-22717,
-23884,
-25030,
-25657,
-25415,
-24176,
-22085,
-19487,
-16888,
-14806,
-13667,
-13714,
-14940,
-17105,
-19790,
-22494,
-24736,
-26184,
-26691,
-26343,
-25418,
-24316,
-23458,
-23211,
-23782,
-25190,
-27288,
-29752,
-32229,
-34345,
-35838,
-36585,
-36628,
-36165,
-35489,
-34916,
-34733,
-35090,
-36013,
-37361,
-38882,
-40264,
-41215,
-41522,
-41110,
-40060,
-38571,
-36940,
-35457,
-34380,
-33829,
-33806,
-34176,
-34697,
-35119,
-35185,
-34747,
-33756,
-32284,
-30521,
-28693,
-27050,
-25793,
-25022,
-24762,
-24899,
-25268,
-25657,
-25864,
-25760,
-25289,
-24510,
-23565,
-22656,
-21981,
-21712,
-21918,
-22594,
-23606,
-24786,
-25913,
-26816,
-27376,
-27573,
-27471,
-27200,
-26927,
-26795,
-26905,
-27294,
-27903,
-28646,
-29374,
-29967,
-30318,
-30389,
-30198,
-29832,
-29407,
-29078,
-28954,
-29135,
-29632,
-30400,
-31349,
-32326,
-33227,
-33939,
-34462,
-34831,
-35176,
-35626,
-36319,
-37315,
-38582,
-40017,
-41408,
-42562,
-43296,
-43534,
-43314,
-42808,
-42266,
-41959,
-42137,
-42891,
-44218,
-45906,
-47670,
-49134,
-49963,
-49917,
-48904,
-47022,
-44529,
-41805,
-39277,
-37332,
-36235,
-36061,
-36679,
-37756,
-38819,
-39353,
-38913,
-37210,
-34241,
-30230,
-25693,
-21247,
-17557,
-15127,
-14235,
-14816,
-16502,
-18686,
-20651,
-21758,
-21575,
-19973,
-17206,
-13792,
-10472,
-7988,
-6976,
-7777,
-10416,
-14551,
-19570,
-24716,
-29219,
-32487,
-34189,
-34341,
-33282,
-31622,
-30060,
-29308,
-29844,
-31898,
-35317,
-39668,
-44268,
-48399,
-51394,
-52864,
-52702,
-51182,
-48822,
-46316,
-44352,
-43441,
-43864,
-45522,
-48066,
-50896,
-53347,
-54819,
-54902,
-53463,
-50669,
-46937,
-42843,
-39004,
-35923,
-33937,
-33074,
-33158,
-33744,
-34328,
-34378,
-33514,
-31564,
-28606,
-24968,
-21124,
-17624,
-14931,
-13360,
-12969,
-13612,
-14910,
-16421,
-17686,
-18366,
-18307,
-17556,
-16350,
-15045,
-14031,
-13631,
-14050,
-15324,
-17307,
-19743,
-22281,
-24583,
-26379,
-27505,
-27953,
-27844,
-27407,
-26920,
-26663,
-26823,
-27513,
-28680,
-30188,
-31789,
-33233,
-34292,
-34820,
-34806,
-34333,
-33595,
-32832,
-32264,
-32058,
-32287,
-32906,
-33793,
-34758,
-35611,
-36185,
-36399,
-36238,
-35783,
-35164,
-34542,
-34066,
-33842,
-33909,
-34245,
-34741,
-35275,
-35684,
-35839,
-35665,
-35124,
-34290,
-33249,
-32149,
-31132,
-30285,
-29680,
-29284,
-29038,
-28832,
-28554,
-28117,
-27473,
-26631,
-25639,
-24591,
-23573,
-22682,
-21965,
-21466,
-21158,
-21038,
-21038,
-21121,
-21244,
-21366,
-21486,
-21595,
-21720,
-21890,
-22154,
-22538,
-23081,
-23783,
-24636,
-25623,
-26704,
-27874,
-29122,
-30476,
-31958,
-33609,
-35416,
-37361,
-39341,
-41240,
-42911,
-44233,
-45132,
-45628,
-45798,
-45839,
-45917,
-46249,
-46937,
-48008,
-49380,
-50853,
-52185,
-53117,
-53441,
-53045,
-51935,
-50238,
-48189,
-46069,
-44169,
-42732,
-41889,
-41672,
-41959,
-42526,
-43088,
-43333,
-43004,
-41949,
-40143,
-37724,
-34941,
-32128,
-29616,
-27690,
-26482,
-25998,
-26056,
-26376,
-26611,
-26433,
-25631,
-24102,
-21981,
-19473,
-16966,
-14821,
-13372,
-12842,
-13271,
-14552,
-16426,
-18554,
-20585,
-22225,
-23308,
-23798,
-23829,
-23626,
-23480,
-23676,
-24406,
-25773,
-27716,
-30076,
-32593,
-34986,
-37011,
-38495,
-39390,
-39762,
-39781,
-39680,
-39690,
-40017,
-40747,
-41907,
-43359,
-44934,
-46386,
-47484,
-48058,
-48013,
-47363,
-46224,
-44781,
-43253,
-41864,
-40760,
-40047,
-39694,
-39619,
-39650,
-39591,
-39261,
-38504,
-37264,
-35545,
-33467,
-31192,
-28934,
-26898,
-25233,
-24037,
-23271,
-22850,
-22585,
-22274,
-21742,
-20848,
-19584,
-18003,
-16299,
-14666,
-13371,
-12583,
-12443,
-12950,
-14033,
-15505,
-17153,
-18734,
-20050,
-20961,
-21426,
-21477,
-21262,
-20945,
-20758,
-20871,
-21436,
-22489,
-23984,
-25773,
-27652,
-29380,
-30763,
-31651,
-32027,
-31939,
-31568,
-31096,
-30753,
-30685,
-30988,
-31638,
-32548,
-33547,
-34451,
-35088,
-35312,
-35089,
-34437,
-33488,
-32450,
-31563,
-31103,
-31277,
-32217,
-33915,
-36211,
-38804,
-41307,
-43312,
-44485,
-44664,
-43864,
-42358,
-40544,
-38932,
-37974,
-37985,
-39052,
-41008,
-43470,
-45902,
-47756,
-48571,
-48076,
-46265,
-43369,
-39857,
-36307,
-33318,
-31377,
-30763,
-31481,
-33231,
-35484,
-37526,
-38660,
-38292,
-36136,
-32229,
-27029,
-21244,
-15801,
-11532,
-9105,
-8768,
-10349,
-13278,
-16676,
-19617,
-21260,
-21099,
-19028,
-15362,
-10787,
-6151,
-2361,
-117,
-1,
-1642,
-5162,
-9833,
-14882,
-19532,
-23106,
-25179,
-25641,
-24721,
-22946,
-21048,
-19805,
-19896,
-21736,
-25406,
-30569,
-36602,
-42638,
-47817,
-51443,
-53126,
-52910,
-51205,
-48742,
-46369,
-44876,
-44810,
-46377,
-49379,
-53310,
-57436,
-61008,
-63373,
-64161,
-63281,
-61000,
-57797,
-54310,
-51173,
-48882,
-47766,
-47832,
-48906,
-50547,
-52256,
-53493,
-53820,
-52984,
-50932,
-47843,
-44084,
-40109,
-36405,
-33377,
-31244,
-30069,
-29661,
-29704,
-29770,
-29451,
-28426,
-26553,
-23869,
-20623,
-17171,
-13946,
-11335,
-9605,
-8877,
-9072,
-9978,
-11275,
-12631,
-13756,
-14469,
-14722,
-14580,
-14234,
-13894,
-13793,
-14096,
-14894,
-16176,
-17842,
-19720,
-21610,
-23317,
-24686,
-25632,
-26162,
-26354,
-26359,
-26354,
-26514,
-26969,
-27786,
-28941,
-30344,
-31838,
-33260,
-34447,
-35294,
-35765,
-35889,
-35765,
-35542,
-35351,
-35353,
-35608,
-36180,
-37015,
-38044,
-39140,
-40150,
-40960,
-41446,
-41574,
-41340,
-40816,
-40108,
-39343,
-38648,
-38099,
-37736,
-37534,
-37408,
-37270,
-36990,
-36503,
-35743,
-34734,
-33507,
-32167,
-30788,
-29490,
-28325,
-27362,
-26599,
-26037,
-25617,
-25305,
-24997,
-24654,
-24189,
-23584,
-22831,
-21970,
-21079,
-20259,
-19633,
-19288,
-19321,
-19730,
-20519,
-21611,
-22914,
-24333,
-25764,
-27133,
-28395,
-29528,
-30541,
-31471,
-32356,
-33281,
-34284,
-35462,
-36827,
-38415,
-40181,
-42040,
-43878,
-45528,
-46855,
-47736,
-48126,
-48068,
-47675,
-47140,
-46683,
-46496,
-46727,
-47406,
-48468,
-49724,
-50939,
-51819,
-52144,
-51739,
-50581,
-48760,
-46497,
-44094,
-41882,
-40173,
-39175,
-38987,
-39549,
-40660,
-42019,
-43263,
-44031,
-44056,
-43167,
-41368,
-38815,
-35788,
-32666,
-29822,
-27582,
-26146,
-25553,
-25674,
-26229,
-26860,
-27172,
-26873,
-25755,
-23839,
-21281,
-18420,
-15662,
-13432,
-12071,
-11780,
-12587,
-14321,
-16686,
-19279,
-21694,
-23592,
-24745,
-25105,
-24759,
-23966,
-23031,
-22325,
-22139,
-22686,
-24034,
-26115,
-28715,
-31574,
-34342,
-36775,
-38631,
-39841,
-40401,
-40446,
-40144,
-39708,
-39316,
-39101,
-39127,
-39407,
-39881,
-40491,
-41124,
-41721,
-42179,
-42455,
-42478,
-42212,
-41624,
-40706,
-39487,
-38017,
-36415,
-34783,
-33284,
-32032,
-31126,
-30608,
-30450,
-30571,
-30832,
-31068,
-31123,
-30852,
-30201,
-29143,
-27773,
-26225,
-24693,
-23395,
-22515,
-22208,
-22523,
-23436,
-24796,
-26413,
-27989,
-29295,
-30058,
-30166,
-29556,
-28327,
-26667,
-24851,
-23196,
-21979,
-21429,
-21637,
-22573,
-24068,
-25846,
-27577,
-28938,
-29655,
-29596,
-28738,
-27249,
-25364,
-23451,
-21836,
-20846,
-20663,
-21377,
-22891,
-25023,
-27461,
-29880,
-31959,
-33452,
-34234,
-34307,
-33822,
-33041,
-32296,
-31941,
-32266,
-33457,
-35565,
-38462,
-41898,
-45513,
-48909,
-51739,
-53716,
-54736,
-54786,
-54055,
-52767,
-51258,
-49798,
-48657,
-47970,
-47794,
-48055,
-48604,
-49213,
-49635,
-49637,
-49015,
-47690,
-45627,
-42967,
-39883,
-36669,
-33601,
-30952,
-28904,
-27543,
-26821,
-26589,
-26606,
-26618,
-26372,
-25710,
-24550,
-22947,
-21031,
-19023,
-17158,
-15656,
-14680,
-14318,
-14537,
-15269,
-16319,
-17511,
-18637,
-19539,
-20103,
-20301,
-20157,
-19765,
-19248,
-18747,
-18388,
-18262,
-18434,
-18888,
-19615,
-20519,
-21517,
-22507,
-23375,
-24047,
-24447,
-24555,
-24375,
-23959,
-23398,
-22789,
-22271,
-21932,
-21867,
-22103,
-22639,
-23423,
-24380,
-25421,
-26464,
-27448,
-28350,
-29157,
-29906,
-30621,
-31349,
-32121,
-32956,
-33863,
-34833,
-35845,
-36870,
-37863,
-38785,
-39588,
-40229,
-40689,
-40948,
-41026,
-40954,
-40780,
-40566,
-40352,
-40180,
-40042,
-39927,
-39787,
-39568,
-39227,
-38734,
-38082,
-37307,
-36441,
-35543,
-34648,
-33773,
-32910,
-32029,
-31086,
-30056,
-28933,
-27759,
-26612,
-25600,
-24821,
-24365,
-24239,
-24416,
-24766,
-25145,
-25382,
-25332,
-24955,
-24251,
-23367,
-22480,
-21822,
-21598,
-21946,
-22912,
-24424,
-26318,
-28376,
-30337,
-32017,
-33254,
-34032,
-34406,
-34537,
-34640,
-34947,
-35657,
-36920,
-38763,
-41132,
-43843,
-46660,
-49294,
-51479,
-53013,
-53801,
-53888,
-53431,
-52707,
-52010,
-51645,
-51812,
-52581,
-53896,
-55523,
-57178,
-58492,
-59183,
-59006,
-57907,
-55926,
-53261,
-50189,
-47009,
-44015,
-41425,
-39355,
-37828,
-36757,
-35984,
-35311,
-34534,
-33473,
-32017,
-30111,
-27806,
-25194,
-22448,
-19753,
-17283,
-15210,
-13601,
-12521,
-11916,
-11730,
-11859,
-12191,
-12659,
-13183,
-13758,
-14368,
-15046,
-15801,
-16662,
-17622,
-18683,
-19820,
-21011,
-22235,
-23471,
-24713,
-25951,
-27188,
-28422,
-29646,
-30860,
-32030,
-33155,
-34180,
-35109,
-35883,
-36523,
-36992,
-37322,
-37518,
-37610,
-37623,
-37579,
-37491,
-37367,
-37208,
-37007,
-36781,
-36522,
-36270,
-36032,
-35842,
-35705,
-35635,
-35594,
-35576,
-35515,
-35396,
-35187,
-34896,
-34554,
-34211,
-33935,
-33793,
-33826,
-34051,
-34449,
-34956,
-35494,
-35966,
-36290,
-36401,
-36284,
-35947,
-35444,
-34843,
-34221,
-33629,
-33130,
-32698,
-32355,
-32036,
-31724,
-31376,
-30970,
-30509,
-29984,
-29418,
-28806,
-28144,
-27422,
-26612,
-25687,
-24648,
-23474,
-22210,
-20881,
-19554,
-18287,
-17142,
-16168,
-15393,
-14832,
-14477,
-14292,
-14258,
-14313,
-14440,
-14591,
-14762,
-14938,
-15145,
-15385,
-15704,
-16106,
-16616,
-17235,
-17940,
-18732,
-19571,
-20457,
-21387,
-22363,
-23433,
-24604,
-25921,
-27392,
-28999,
-30719,
-32479,
-34215,
-35839,
-37282,
-38490,
-39440,
-40142,
-40635,
-40991,
-41303,
-41655,
-42157,
-42853,
-43805,
-44983,
-46355,
-47816,
-49262,
-50547,
-51568,
-52230,
-52501,
-52408,
-52011,
-51448,
-50822,
-50285,
-49890,
-49696,
-49651,
-49693,
-49692,
-49532,
-49103,
-48342,
-47237,
-45837,
-44229,
-42533,
-40865,
-39317,
-37956,
-36779,
-35776,
-34864,
-33989,
-33058,
-32035,
-30884,
-29616,
-28266,
-26885,
-25532,
-24268,
-23127,
-22137,
-21298,
-20587,
-19989,
-19460,
-18981,
-18541,
-18131,
-17779,
-17497,
-17326,
-17281,
-17382,
-17630,
-18004,
-18496,
-19063,
-19693,
-20373,
-21098,
-21895,
-22777,
-23771,
-24897,
-26151,
-27517,
-28954,
-30411,
-31829,
-33150,
-34344,
-35385,
-36285,
-37080,
-37796,
-38504,
-39228,
-40001,
-40836,
-41695,
-42572,
-43396,
-44141,
-44755,
-45210,
-45503,
-45622,
-45601,
-45449,
-45222,
-44931,
-44628,
-44320,
-44022,
-43730,
-43421,
-43072,
-42656,
-42148,
-41549,
-40873,
-40163,
-39463,
-38840,
-38316,
-37928,
-37639,
-37420,
-37203,
-36919,
-36541,
-36031,
-35440,
-34797,
-34189,
-33669,
-33279,
-33030,
-32882,
-32781,
-32661,
-32458,
-32142,
-31712,
-31188,
-30624,
-30065,
-29555,
-29110,
-28732,
-28389,
-28058,
-27700,
-27298,
-26850,
-26362,
-25863,
-25381,
-24942,
-24567,
-24264,
-24021,
-23836,
-23666,
-23518,
-23345,
-23166,
-22966,
-22769,
-22593,
-22467,
-22410,
-22449,
-22583,
-22818,
-23139,
-23525,
-23961,
-24425,
-24894,
-25377,
-25847,
-26332,
-26818,
-27324,
-27843,
-28379,
-28913,
-29415,
-29869,
-30212,
-30442,
-30515,
-30456,
-30288,
-30070,
-29884,
-29798,
-29892,
-30192,
-30706,
-31392,
-32184,
-32999,
-33748,
-34389,
-34869,
-35217,
-35458,
-35645,
-35855,
-36128,
-36517,
-37032,
-37672,
-38415,
-39230,
-40069,
-40909,
-41705,
-42462,
-43179,
-43881,
-44608,
-45385,
-46256,
-47198,
-48208,
-49206,
-50124,
-50878,
-51391,
-51630,
-51593,
-51329,
-50901,
-50416,
-49931,
-49525,
-49202,
-48953,
-48731,
-48484,
-48142,
-47676,
-47054,
-46293,
-45418,
-44481,
-43533,
-42637,
-41833,
-41148,
-40592,
-40141,
-39763,
-39402,
-39021,
-38569,
-38048,
-37468,
-36873,
-36334,
-35900,
-35640,
-35556,
-35661,
-35880,
-36177,
-36453,
-36662,
-36753,
-36720,
-36573,
-36364,
-36129,
-35938,
-35818,
-35815,
-35916,
-36125,
-36394,
-36670,
-36906,
-37023,
-36993,
-36786,
-36413,
-35919,
-35376,
-34858,
-34447,
-34185,
-34085,
-34123,
-34224,
-34318,
-34319,
-34166,
-33848,
-33378,
-32809,
-32238,
-31720,
-31359,
-31181,
-31214,
-31439,
-31818,
-32302,
-32832,
-33379,
-33903,
-34436,
-34977,
-35604,
-36338,
-37246,
-38326,
-39567,
-40918,
-42282,
-43583,
-44707,
-45621,
-46280,
-46733,
-47021,
-47239,
-47444,
-47694,
-47987,
-48286,
-48540,
-48669,
-48625,
-48389,
-47967,
-47424,
-46829,
-46258,
-45780,
-45410,
-45166,
-44992,
-44853,
-44681,
-44433,
-44085,
-43643,
-43132,
-42608,
-42134,
-41772,
-41573,
-41570,
-41752,
-42091,
-42518,
-42948,
-43293,
-43484,
-43453,
-43227,
-42803,
-42287,
-41747,
-41289,
-40986,
-40870,
-40952,
-41169,
-41477,
-41768,
-41990,
-42072,
-41997,
-41769,
-41416,
-40976,
-40506,
-40031,
-39583,
-39172,
-38784,
-38425,
-38058,
-37695,
-37305,
-36914,
-36510,
-36116,
-35739,
-35388,
-35067,
-34776,
-34510,
-34272,
-34069,
-33916,
-33838,
-33864,
-34012,
-34300,
-34700,
-35192,
-35690,
-36154,
-36480,
-36651,
-36629,
-36451,
-36178,
-35886,
-35686,
-35638,
-35815,
-36214,
-36828,
-37606,
-38484,
-39411,
-40316,
-41175,
-41942,
-42602,
-43122,
-43488,
-43669,
-43667,
-43479,
-43144,
-42707,
-42248,
-41834,
-41548,
-41425,
-41506,
-41770,
-42193,
-42720,
-43278,
-43823,
-44277,
-44626,
-44831,
-44907,
-44876,
-44779,
-44689,
-44658,
-44775,
-45076,
-45606,
-46370,
-47337,
-48478,
-49718,
-51013,
-52308,
-53562,
-54757,
-55876,
-56905,
-57840,
-58650,
-59332,
-59852,
-60212,
-60409,
-60449,
-60362,
-60164,
-59873,
-59502,
-59048,
-58507,
-57875,
-57156,
-56357,
-55507,
-54641,
-53792,
-52994,
-52279,
-51646,
-51112,
-50636,
-50206,
-49760,
-49265,
-48651,
-47899,
-46969,
-45886,
-44678,
-43429,
-42214,
-41141,
-40259,
-39619,
-39189,
-38914,
-38705,
-38451,
-38095,
-37586,
-36959,
-36281,
-35650,
-35182,
-34954,
-35012,
-35341,
-35891,
-36564,
-37268,
-37911,
-38429,
-38805,
-39029,
-39145,
-39183,
-39206,
-39250,
-39349,
-39523,
-39765,
-40054,
-40352,
-40593,
-40729,
-40703,
-40494,
-40104,
-39575,
-38973,
-38389,
-37890,
-37541,
-37340,
-37274,
-37259,
-37233,
-37099,
-36814,
-36363,
-35763,
-35081,
-34392,
-33759,
-33261,
-32903,
-32707,
-32631,
-32648,
-32710,
-32779,
-32834,
-32851,
-32833,
-32779,
-32705,
-32618,
-32554,
-32512,
-32542,
-32640,
-32836,
-33117,
-33472,
-33867,
-34250,
-34579,
-34783,
-34835,
-34692,
-34354,
-33823,
-33140,
-32326,
-31450,
-30530,
-29620,
-28731,
-27879,
-27062,
-26263,
-25477,
-24682,
-23870,
-23041,
-22191,
-21339,
-20489,
-19660,
-18864,
-18100,
-17381,
-16683,
-16022,
-15366,
-14741,
-14122,
-13549,
-13015,
-12567,
-12201,
-11955,
-11810,
-11768,
-11804,
-11881,
-11970,
-12037,
-12058,
-12025,
-11934,
-11790,
-11604,
-11384,
-11130,
-10850,
-10537,
-10201,
-9844,
-9486,
-9129,
-8803,
-8493,
-8215,
-7941,
-7669,
-7379,
-7080,
-6787,
-6524,
-6342,
-6249,
-6286,
-6423,
-6636,
-6869,
-7061,
-7173,
-7182,
-7106,
-6988,
-6906,
-6924,
-7118,
-7501,
-8098,
-8837,
-9696,
-10560,
-11404,
-12138,
-12764,
-13255,
-13644,
-13949,
-14200,
-14438,
-14658,
-14892,
-15108,
-15303,
-15439,
-15486,
-15414,
-15199,
-14833,
-14328,
-13710,
-13030,
-12337,
-11699,
-11157,
-10754,
-10496,
-10388,
-10380,
-10456,
-10543,
-10611,
-10627,
-10574,
-10467,
-10352,
-10264,
-10289,
-10475,
-10877,
-11509,
-12372,
-13405,
-14550,
-15696,
-16763,
-17653,
-18316,
-18722,
-18887,
-18859,
-18713,
-18534,
-18409,
-18404,
-18559,
-18871,
-19303,
-19783,
-20228,
-20532,
-20642,
-20497,
-20118,
-19549,
-18860,
-18169,
-17546,
-17074,
-16774,
-16646,
-16657,
-16761,
-16916,
-17096,
-17301,
-17542,
-17845,
-18240,
-18731,
-19336,
-20037,
-20840,
-21724,
-22712,
-23774,
-24929,
-26127,
-27332,
-28470,
-29463,
-30237,
-30758,
-31007,
-31038,
-30911,
-30727,
-30557,
-30469,
-30468,
-30539,
-30619,
-30641,
-30530,
-30242,
-29737,
-29025,
-28116,
-27051,
-25864,
-24611,
-23321,
-22060,
-20843,
-19720,
-18687,
-17762,
-16910,
-16119,
-15356,
-14611,
-13891,
-13227,
-12664,
-12257,
-12053,
-12058,
-12273,
-12640,
-13087,
-13545,
-13928,
-14200,
-14333,
-14338,
-14248,
-14104,
-13948,
-13829,
-13761,
-13769,
-13852,
-13993,
-14186,
-14377,
-14542,
-14617,
-14567,
-14350,
-13956,
-13399,
-12715,
-11971,
-11229,
-10559,
-9991,
-9544,
-9191,
-8876,
-8559,
-8166,
-7690,
-7134,
-6544,
-6013,
-5629,
-5487,
-5660,
-6167,
-6984,
-8045,
-9232,
-10435,
-11526,
-12415,
-13053,
-13425,
-13562,
-13523,
-13365,
-13164,
-12944,
-12746,
-12545,
-12342,
-12093,
-11788,
-11409,
-10959,
-10465,
-9943,
-9443,
-8984,
-8612,
-8322,
-8150,
-8074,
-8103,
-8226,
-8431,
-8714,
-9072,
-9493,
-9978,
-10514,
-11095,
-11698,
-12315,
-12924,
-13503,
-14056,
-14549,
-15013,
-15409,
-15774,
-16069,
-16310,
-16468,
-16535,
-16491,
-16335,
-16069,
-15708,
-15292,
-14857,
-14446,
-14112,
-13872,
-13755,
-13753,
-13843,
-13995,
-14159,
-14294,
-14363,
-14347,
-14240,
-14070,
-13857,
-13659,
-13510,
-13451,
-13503,
-13662,
-13927,
-14264,
-14657,
-15071,
-15498,
-15925,
-16346,
-16772,
-17192,
-17607,
-18018,
-18394,
-18765,
-19087,
-19403,
-19689,
-19975,
-20258,
-20544,
-20828,
-21110,
-21371,
-21624,
-21858,
-22103,
-22352,
-22646,
-22967,
-23340,
-23731,
-24129,
-24491,
-24805,
-25026,
-25173,
-25242,
-25264,
-25285,
-25334,
-25459,
-25668,
-25965,
-26313,
-26681,
-27003,
-27240,
-27362,
-27361,
-27280,
-27165,
-27103,
-27163,
-27403,
-27843,
-28476,
-29223,
-30025,
-30746,
-31326,
-31669,
-31754,
-31591,
-31216,
-30720,
-30177,
-29687,
-29323,
-29132,
-29148,
-29343,
-29703,
-30159,
-30651,
-31124,
-31526,
-31847,
-32074,
-32258,
-32408,
-32600,
-32838,
-33146,
-33516,
-33902,
-34284,
-34614,
-34878,
-35091,
-35278,
-35500,
-35811,
-36262,
-36870,
-37637,
-38507,
-39423,
-40302,
-41062,
-41658,
-42057,
-42280,
-42374,
-42410,
-42473,
-42633,
-42937,
-43397,
-43978,
-44620,
-45227,
-45713,
-46007,
-46063,
-45894,
-45545,
-45091,
-44637,
-44267,
-44043,
-44005,
-44140,
-44410,
-44775,
-45157,
-45532,
-45859,
-46137,
-46377,
-46584,
-46789,
-46974,
-47156,
-47289,
-47368,
-47349,
-47227,
-46997,
-46676,
-46319,
-45962,
-45689,
-45536,
-45540,
-45698,
-45963,
-46267,
-46506,
-46584,
-46422,
-45974,
-45259,
-44330,
-43288,
-42259,
-41346,
-40644,
-40195,
-39985,
-39981,
-40087,
-40236,
-40335,
-40334,
-40209,
-39956,
-39614,
-39226,
-38841,
-38523,
-38292,
-38189,
-38189,
-38287,
-38418,
-38550,
-38611,
-38583,
-38436,
-38197,
-37908,
-37626,
-37427,
-37352,
-37444,
-37686,
-38048,
-38461,
-38847,
-39133,
-39262,
-39201,
-38952,
-38540,
-38019,
-37447,
-36890,
-36399,
-36007,
-35740,
-35566,
-35478,
-35404,
-35312,
-35139,
-34866,
-34493,
-34034,
-33562,
-33125,
-32813,
-32676,
-32750,
-33032,
-33485,
-34045,
-34635,
-35165,
-35584,
-35837,
-35938,
-35907,
-35808,
-35716,
-35697,
-35811,
-36076,
-36476,
-36948,
-37421,
-37785,
-37981,
-37941,
-37686,
-37250,
-36731,
-36230,
-35839,
-35619,
-35580,
-35675,
-35829,
-35937,
-35910,
-35701,
-35289,
-34729,
-34072,
-33421,
-32827,
-32359,
-32006,
-31777,
-31615,
-31501,
-31392,
-31285,
-31183,
-31086,
-31028,
-30983,
-30979,
-30969,
-30948,
-30882,
-30756,
-30558,
-30300,
-29981,
-29646,
-29302,
-29009,
-28778,
-28665,
-28670,
-28813,
-29081,
-29435,
-29839,
-30231,
-30565,
-30804,
-30936,
-30973,
-30949,
-30914,
-30917,
-30979,
-31139,
-31353,
-31629,
-31896,
-32143,
-32322,
-32440,
-32498,
-32530,
-32565,
-32641,
-32784,
-32993,
-33271,
-33564,
-33832,
-34023,
-34066,
-33950,
-33640,
-33182,
-32615,
-32039,
-31523,
-31160,
-30999,
-31034,
-31251,
-31554,
-31862,
-32082,
-32147,
-32039,
-31784,
-31445,
-31112,
-30879,
-30798,
-30919,
-31202,
-31629,
-32097,
-32569,
-32953,
-33241,
-33414,
-33492,
-33518,
-33517,
-33547,
-33616,
-33768,
-33985,
-34289,
-34647,
-35054,
-35475,
-35884,
-36261,
-36596,
-36898,
-37205,
-37563,
-38031,
-38660,
-39471,
-40449,
-41536,
-42622,
-43598,
-44331,
-44748,
-44804,
-44524,
-44000,
-43340,
-42686,
-42155,
-41817,
-41690,
-41739,
-41870,
-41982,
-41969,
-41739,
-41263,
-40531,
-39610,
-38580,
-37554,
-36656,
-35971,
-35605,
-35573,
-35900,
-36533,
-37412,
-38435,
-39512,
-40550,
-41473,
-42258,
-42872,
-43352,
-43711,
-43987,
-44212,
-44392,
-44546,
-44671,
-44778,
-44890,
-45038,
-45260,
-45602,
-46082,
-46698,
-47417,
-48160,
-48856,
-49387,
-49701,
-49736,
-49512,
-49078,
-48515,
-47948,
-47466,
-47161,
-47068,
-47188,
-47476,
-47864,
-48273,
-48633,
-48910,
-49071,
-49151,
-49163,
-49166,
-49181,
-49237,
-49324,
-49427,
-49500,
-49508,
-49407,
-49171,
-48799,
-48295,
-47708,
-47073,
-46459,
-45915,
-45485,
-45193,
-45038,
-44982,
-44979,
-44942,
-44809,
-44502,
-43997,
-43283,
-42414,
-41453,
-40509,
-39666,
-39012,
-38573,
-38342,
-38268,
-38238,
-38180,
-37954,
-37542,
-36883,
-36046,
-35095,
-34146,
-33337,
-32760,
-32506,
-32593,
-32991,
-33628,
-34385,
-35139,
-35772,
-36196,
-36372,
-36306,
-36048,
-35694,
-35324,
-35043,
-34906,
-34941,
-35154,
-35483,
-35900,
-36312,
-36693,
-36976,
-37168,
-37233,
-37208,
-37079,
-36869,
-36582,
-36214,
-35773,
-35252,
-34650,
-33985,
-33260,
-32520,
-31784,
-31116,
-30554,
-30150,
-29945,
-29946,
-30156,
-30539,
-31030,
-31573,
-32083,
-32517,
-32840,
-33055,
-33203,
-33325,
-33503,
-33767,
-34170,
-34693,
-35332,
-36015,
-36716,
-37350,
-37912,
-38367,
-38730,
-39033,
-39299,
-39571,
-39873,
-40195,
-40551,
-40871,
-41139,
-41277,
-41244,
-40995,
-40520,
-39818,
-38938,
-37922,
-36863,
-35816,
-34873,
-34063,
-33427,
-32958,
-32631,
-32419,
-32265,
-32136,
-32004,
-31841,
-31661,
-31462,
-31270,
-31103,
-30985,
-30929,
-30938,
-31029,
-31177,
-31400,
-31666,
-31992,
-32351,
-32758,
-33185,
-33643,
-34104,
-34557,
-34982,
-35352,
-35653,
-35880,
-36015,
-36089,
-36104,
-36101,
-36105,
-36155,
-36268,
-36474,
-36762,
-37135,
-37559,
-38001,
-38415,
-38765,
-39012,
-39151,
-39185,
-39153,
-39113,
-39130,
-39263,
-39561,
-40025,
-40638,
-41333,
-42040,
-42665,
-43165,
-43482,
-43653,
-43700,
-43700,
-43728,
-43829,
-44042,
-44351,
-44725,
-45101,
-45433,
-45668,
-45796,
-45824,
-45781,
-45706,
-45642,
-45587,
-45563,
-45504,
-45399,
-45161,
-44770,
-44187,
-43422,
-42513,
-41519,
-40528,
-39618,
-38881,
-38349,
-38072,
-38009,
-38141,
-38378,
-38657,
-38892,
-39040,
-39059,
-38967,
-38788,
-38584,
-38422,
-38355,
-38445,
-38685,
-39091,
-39593,
-40154,
-40679,
-41111,
-41386,
-41485,
-41408,
-41195,
-40907,
-40621,
-40407,
-40324,
-40393,
-40603,
-40917,
-41258,
-41559,
-41746,
-41777,
-41629,
-41337,
-40936,
-40513,
-40137,
-39875,
-39786,
-39870,
-40129,
-40502,
-40929,
-41331,
-41629,
-41766,
-41717,
-41482,
-41106,
-40658,
-40218,
-39868,
-39676,
-39652,
-39805,
-40059,
-40360,
-40608,
-40737,
-40698,
-40481,
-40114,
-39659,
-39175,
-38747,
-38406,
-38190,
-38086,
-38069,
-38103,
-38133,
-38137,
-38081,
-37969,
-37815,
-37636,
-37475,
-37351,
-37303,
-37334,
-37460,
-37659,
-37915,
-38200,
-38475,
-38722,
-38917,
-39061,
-39158,
-39220,
-39277,
-39329,
-39397,
-39470,
-39541,
-39606,
-39651,
-39679,
-39705,
-39736,
-39811,
-39918,
-40080,
-40270,
-40469,
-40637,
-40739,
-40746,
-40642,
-40438,
-40149,
-39815,
-39479,
-39174,
-38945,
-38794,
-38742,
-38766,
-38851,
-38974,
-39105,
-39232,
-39338,
-39422,
-39498,
-39557,
-39622,
-39672,
-39706,
-39685,
-39590,
-39364,
-39008,
-38489,
-37846,
-37104,
-36337,
-35613,
-35005,
-34571,
-34333,
-34282,
-34387,
-34561,
-34746,
-34835,
-34790,
-34550,
-34131,
-33551,
-32868,
-32157,
-31483,
-30908,
-30482,
-30213,
-30098,
-30124,
-30235,
-30429,
-30654,
-30915,
-31209,
-31543,
-31948,
-32426,
-32994,
-33634,
-34323,
-35014,
-35659,
-36197,
-36581,
-36785,
-36793,
-36640,
-36356,
-36019,
-35683,
-35429,
-35271,
-35252,
-35321,
-35459,
-35592,
-35674,
-35660,
-35560,
-35372,
-35187,
-35039,
-35024,
-35158,
-35478,
-35923,
-36465,
-36979,
-37413,
-37663,
-37717,
-37554,
-37223,
-36799,
-36364,
-36022,
-35846,
-35893,
-36178,
-36691,
-37370,
-38146,
-38918,
-39604,
-40114,
-40414,
-40464,
-40302,
-39958,
-39504,
-39003,
-38516,
-38079,
-37714,
-37397,
-37121,
-36844,
-36547,
-36224,
-35872,
-35527,
-35208,
-34961,
-34794,
-34735,
-34768,
-34881,
-35039,
-35217,
-35375,
-35503,
-35575,
-35607,
-35596,
-35574,
-35558,
-35576,
-35653,
-35797,
-36021,
-36306,
-36656,
-37019,
-37393,
-37722,
-37991,
-38175,
-38256,
-38244,
-38139,
-37976,
-37773,
-37571,
-37396,
-37264,
-37192,
-37151,
-37145,
-37120,
-37065,
-36956,
-36782,
-36584,
-36373,
-36231,
-36184,
-36301,
-36584,
-37036,
-37609,
-38243,
-38846,
-39352,
-39676,
-39792,
-39694,
-39397,
-38984,
-38494,
-38029,
-37629,
-37343,
-37186,
-37122,
-37140,
-37163,
-37158,
-37067,
-36872,
-36548,
-36131,
-35610,
-35063,
-34491,
-33956,
-33466,
-33046,
-32680,
-32371,
-32081,
-31810,
-31525,
-31240,
-30953,
-30702,
-30517,
-30428,
-30473,
-30643,
-30935,
-31297,
-31668,
-31994,
-32197,
-32263,
-32176,
-31980,
-31740,
-31542,
-31471,
-31607,
-31973,
-32584,
-33376,
-34292,
-35215,
-36056,
-36726,
-37162,
-37349,
-37299,
-37071,
-36726,
-36374,
-36058,
-35876,
-35827,
-35919,
-36119,
-36355,
-36570,
-36703,
-36698,
-36564,
-36299,
-35954,
-35589,
-35248,
-34995,
-34835,
-34774,
-34779,
-34805,
-34810,
-34742,
-34590,
-34346,
-34043,
-33728,
-33461,
-33300,
-33304,
-33485,
-33872,
-34409,
-35084,
-35804,
-36531,
-37186,
-37738,
-38153,
-38417,
-38540,
-38535,
-38408,
-38209,
-37926,
-37622,
-37290,
-36982,
-36693,
-36452,
-36238,
-36041,
-35833,
-35572,
-35248,
-34840,
-34373,
-33881,
-33422,
-33056,
-32838,
-32799,
-32941,
-33236,
-33635,
-34060,
-34453,
-34738,
-34885,
-34868,
-34702,
-34412,
-34062,
-33699,
-33416,
-33245,
-33257,
-33451,
-33828,
-34334,
-34914,
-35475,
-35953,
-36285,
-36438,
-36424,
-36268,
-36023,
-35752,
-35482,
-35258,
-35062,
-34887,
-34700,
-34471,
-34180,
-33839,
-33452,
-33067,
-32717,
-32438,
-32264,
-32181,
-32197,
-32249,
-32317,
-32332,
-32269,
-32104,
-31842,
-31522,
-31181,
-30887,
-30686,
-30597,
-30645,
-30772,
-30957,
-31117,
-31213,
-31196,
-31071,
-30840,
-30552,
-30237,
-29938,
-29674,
-29436,
-29221,
-28985,
-28720,
-28394,
-28016,
-27592,
-27149,
-26711,
-26309,
-25971,
-25719,
-25570,
-25531,
-25610,
-25790,
-26055,
-26361,
-26663,
-26914,
-27068,
-27111,
-27043,
-26906,
-26750,
-26652,
-26663,
-26845,
-27185,
-27686,
-28275,
-28899,
-29480,
-29973,
-30336,
-30591,
-30734,
-30845,
-30936,
-31072,
-31250,
-31472,
-31695,
-31873,
-31940,
-31844,
-31552,
-31057,
-30385,
-29597,
-28776,
-28005,
-27377,
-26949,
-26752,
-26775,
-26976,
-27274,
-27588,
-27835,
-27937,
-27873,
-27619,
-27211,
-26689,
-26106,
-25526,
-24989,
-24538,
-24192,
-23969,
-23873,
-23905,
-24069,
-24339,
-24702,
-25115,
-25531,
-25900,
-26179,
-26335,
-26374,
-26313,
-26212,
-26111,
-26079,
-26133,
-26280,
-26486,
-26698,
-26842,
-26876,
-26757,
-26495,
-26128,
-25716,
-25341,
-25072,
-24980,
-25078,
-25396,
-25878,
-26497,
-27162,
-27808,
-28329,
-28673,
-28762,
-28592,
-28170,
-27555,
-26844,
-26144,
-25566,
-25201,
-25089,
-25229,
-25571,
-26024,
-26502,
-26899,
-27184,
-27304,
-27318,
-27238,
-27157,
-27109,
-27155,
-27288,
-27516,
-27772,
-28028,
-28197,
-28253,
-28143,
-27869,
-27460,
-26952,
-26439,
-25981,
-25659,
-25509,
-25542,
-25711,
-25964,
-26194,
-26344,
-26336,
-26175,
-25878,
-25518,
-25177,
-24936,
-24848,
-24929,
-25148,
-25449,
-25737,
-25948,
-25998,
-25864,
-25547,
-25072,
-24516,
-23945,
-23444,
-23087,
-22909,
-22943,
-23150,
-23502,
-23899,
-24280,
-24550,
-24675,
-24631,
-24448,
-24184,
-23914,
-23713,
-23625,
-23677,
-23844,
-24097,
-24370,
-24627,
-24838,
-24997,
-25140,
-25282,
-25479,
-25749,
-26100,
-26539,
-27016,
-27519,
-27992,
-28398,
-28714,
-28896,
-28955,
-28889,
-28723,
-28526,
-28336,
-28254,
-28313,
-28567,
-28999,
-29566,
-30187,
-30757,
-31181,
-31388,
-31354,
-31101,
-30704,
-30252,
-29843,
-29556,
-29427,
-29449,
-29590,
-29759,
-29913,
-29955,
-29870,
-29623,
-29235,
-28745,
-28191,
-27640,
-27127,
-26694,
-26359,
-26117,
-25942,
-25805,
-25650,
-25444,
-25155,
-24787,
-24359,
-23934,
-23567,
-23347,
-23322,
-23534,
-23984,
-24636,
-25439,
-26306,
-27171,
-27957,
-28624,
-29142,
-29511,
-29751,
-29882,
-29948,
-29965,
-29967,
-29962,
-29953,
-29943,
-29918,
-29879,
-29824,
-29758,
-29706,
-29674,
-29699,
-29772,
-29910,
-30077,
-30257,
-30402,
-30479,
-30466,
-30352,
-30155,
-29903,
-29631,
-29383,
-29177,
-29038,
-28960,
-28937,
-28957,
-29012,
-29096,
-29214,
-29367,
-29550,
-29771,
-29995,
-30223,
-30420,
-30573,
-30679,
-30716,
-30711,
-30651,
-30561,
-30443,
-30305,
-30165,
-30028,
-29923,
-29853,
-29839,
-29877,
-29949,
-30036,
-30094,
-30096,
-30020,
-29868,
-29665,
-29452,
-29293,
-29207,
-29241,
-29355,
-29514,
-29644,
-29663,
-29518,
-29170,
-28652,
-28014,
-27366,
-26805,
-26443,
-26335,
-26509,
-26923,
-27507,
-28158,
-28762,
-29251,
-29549,
-29681,
-29655,
-29572,
-29490,
-29510,
-29677,
-30013,
-30500,
-31083,
-31685,
-32233,
-32661,
-32931,
-33047,
-33037,
-32962,
-32887,
-32876,
-32966,
-33178,
-33479,
-33834,
-34167,
-34411,
-34509,
-34427,
-34156,
-33742,
-33220,
-32688,
-32203,
-31835,
-31615,
-31542,
-31579,
-31678,
-31749,
-31747,
-31621,
-31354,
-30985,
-30540,
-30112,
-29736,
-29488,
-29362,
-29372,
-29468,
-29609,
-29740,
-29825,
-29843,
-29792,
-29695,
-29574,
-29477,
-29412,
-29426,
-29497,
-29663,
-29892,
-30194,
-30553,
-30953,
-31383,
-31810,
-32217,
-32562,
-32829,
-32989,
-33037,
-32980,
-32833,
-32634,
-32415,
-32222,
-32085,
-32037,
-32083,
-32227,
-32443,
-32706,
-32966,
-33192,
-33326,
-33353,
-33250,
-33037,
-32728,
-32401,
-32075,
-31847,
-31739,
-31787,
-31994,
-32336,
-32760,
-33224,
-33648,
-33996,
-34216,
-34294,
-34229,
-34035,
-33746,
-33396,
-33030,
-32673,
-32370,
-32116,
-31927,
-31776,
-31639,
-31473,
-31241,
-30919,
-30483,
-29964,
-29379,
-28799,
-28286,
-27901,
-27693,
-27673,
-27833,
-28133,
-28504,
-28895,
-29229,
-29489,
-29639,
-29705,
-29696,
-29665,
-29632,
-29639,
-29705,
-29839,
-30051,
-30337,
-30684,
-31082,
-31508,
-31936,
-32328,
-32670,
-32904,
-33054,
-33078,
-33018,
-32880,
-32698,
-32492,
-32285,
-32071,
-31858,
-31628,
-31378,
-31121,
-30864,
-30651,
-30500,
-30457,
-30516,
-30686,
-30917,
-31180,
-31404,
-31559,
-31606,
-31553,
-31420,
-31251,
-31095,
-30996,
-30982,
-31061,
-31218,
-31432,
-31667,
-31895,
-32104,
-32277,
-32429,
-32556,
-32678,
-32795,
-32910,
-33020,
-33117,
-33195,
-33255,
-33277,
-33272,
-33216,
-33110,
-32938,
-32691,
-32361,
-31963,
-31502,
-31012,
-30518,
-30056,
-29646,
-29308,
-29041,
-28831,
-28665,
-28521,
-28382,
-28242,
-28109,
-27989,
-27913,
-27897,
-27951,
-28087,
-28292,
-28543,
-28812,
-29071,
-29289,
-29471,
-29610,
-29748,
-29908,
-30145,
-30480,
-30941,
-31504,
-32152,
-32812,
-33441,
-33962,
-34349,
-34564,
-34638,
-34588,
-34470,
-34343,
-34235,
-34193,
-34204,
-34257,
-34318,
-34337,
-34275,
-34096,
-33785,
-33347,
-32812,
-32224,
-31653,
-31151,
-30793,
-30606,
-30615,
-30806,
-31131,
-31532,
-31927,
-32242,
-32417,
-32417,
-32240,
-31905,
-31470,
-30992,
-30533,
-30158,
-29885,
-29743,
-29720,
-29793,
-29941,
-30132,
-30350,
-30586,
-30847,
-31136,
-31467,
-31830,
-32217,
-32586,
-32903,
-33105,
-33165,
-33052,
-32772,
-32373,
-31898,
-31441,
-31060,
-30814,
-30735,
-30809,
-31005,
-31275,
-31552,
-31798,
-31975,
-32071,
-32101,
-32073,
-32029,
-31973,
-31943,
-31930,
-31956,
-32003,
-32091,
-32191,
-32323,
-32467,
-32624,
-32800,
-32974,
-33163,
-33354,
-33540,
-33732,
-33894,
-34050,
-34172,
-34278,
-34389,
-34505,
-34690,
-34921,
-35238,
-35591,
-35939,
-36213,
-36326,
-36221,
-35864,
-35262,
-34486,
-33620,
-32800,
-32116,
-31676,
-31494,
-31570,
-31825,
-32176,
-32503,
-32728,
-32765,
-32608,
-32254,
-31773,
-31225,
-30712,
-30307,
-30078,
-30062,
-30247,
-30607,
-31066,
-31541,
-31957,
-32227,
-32341,
-32283,
-32104,
-31876,
-31672,
-31567,
-31607,
-31785,
-32082,
-32430,
-32749,
-32977,
-33060,
-32986,
-32772,
-32466,
-32128,
-31824,
-31598,
-31484,
-31470,
-31556,
-31683,
-31838,
-31981,
-32097,
-32200,
-32292,
-32404,
-32550,
-32733,
-32940,
-33144,
-33299,
-33366,
-33316,
-33142,
-32860,
-32524,
-32182,
-31919,
-31770,
-31786,
-31948,
-32243,
-32605,
-32985,
-33307,
-33531,
-33633,
-33599,
-33460,
-33238,
-32971,
-32695,
-32429,
-32192,
-31969,
-31763,
-31533,
-31271,
-30954,
-30575,
-30145,
-29690,
-29247,
-28860,
-28576,
-28412,
-28390,
-28483,
-28662,
-28875,
-29068,
-29203,
-29258,
-29230,
-29162,
-29070,
-29030,
-29058,
-29193,
-29422,
-29730,
-30070,
-30402,
-30674,
-30867,
-30961,
-30983,
-30953,
-30926,
-30945,
-31045,
-31248,
-31554,
-31921,
-32321,
-32675,
-32932,
-33048,
-32978,
-32746,
-32364,
-31899,
-31421,
-31008,
-30724,
-30620,
-30701,
-30955,
-31327,
-31754,
-32164,
-32490,
-32710,
-32785,
-32774,
-32678,
-32575,
-32502,
-32477,
-32532,
-32623,
-32742,
-32836,
-32891,
-32881,
-32819,
-32721,
-32624,
-32543,
-32519,
-32528,
-32585,
-32650,
-32708,
-32738,
-32730,
-32690,
-32632,
-32574,
-32540,
-32533,
-32569,
-32630,
-32717,
-32806,
-32891,
-32965,
-33027,
-33087,
-33154,
-33240,
-33360,
-33512,
-33702,
-33910,
-34120,
-34306,
-34435,
-34499,
-34465,
-34363,
-34184,
-33983,
-33787,
-33641,
-33579,
-33613,
-33743,
-33946,
-34183,
-34412,
-34587,
-34677,
-34667,
-34560,
-34373,
-34154,
-33927,
-33750,
-33637,
-33613,
-33668,
-33786,
-33924,
-34051,
-34113,
-34090,
-33952,
-33713,
-33376,
-32991,
-32588,
-32218,
-31928,
-31739,
-31684,
-31756,
-31944,
-32221,
-32546,
-32877,
-33169,
-33383,
-33497,
-33503,
-33408,
-33247,
-33054,
-32873,
-32758,
-32723,
-32809,
-33001,
-33290,
-33653,
-34041,
-34433,
-34784,
-35074,
-35296,
-35439,
-35525,
-35566,
-35582,
-35594,
-35602,
-35614,
-35605,
-35572,
-35484,
-35348,
-35160,
-34950,
-34754,
-34619,
-34581,
-34671,
-34884,
-35202,
-35573,
-35937,
-36231,
-36392,
-36404,
-36244,
-35941,
-35541,
-35095,
-34670,
-34326,
-34096,
-34007,
-34056,
-34206,
-34419,
-34625,
-34778,
-34817,
-34739,
-34539,
-34269,
-33980,
-33746,
-33617,
-33627,
-33769,
-34002,
-34259,
-34471,
-34563,
-34511,
-34298,
-33970,
-33581,
-33213,
-32931,
-32790,
-32810,
-32979,
-33268,
-33606,
-33942,
-34210,
-34374,
-34414,
-34349,
-34194,
-34018,
-33849,
-33745,
-33721,
-33776,
-33897,
-34039,
-34172,
-34264,
-34304,
-34309,
-34292,
-34289,
-34318,
-34376,
-34462,
-34526,
-34554,
-34507,
-34391,
-34200,
-33970,
-33699,
-33402,
-33039,
-32583,
-31976,
-31210,
-30297,
-29326,
-28427,
-27781,
-27544,
-27857,
-28747,
-30164,
-31940,
-33826,
-35548,
-36827,
-37466,
-37349,
-36488,
-35014,
-33133,
-31145,
-29332,
-27984,
-27305,
-27424,
-28332,
-29937,
-32001,
-34253,
-36355,
-38015,
-38993,
-39166,
-38546,
-37258,
-35547,
-33706,
-32031,
-30788,
-30137,
-30149,
-30771,
-31872,
-33238,
-34645,
-35868,
-36718,
-37081,
-36914,
-36249,
-35215,
-33968,
-32722,
-31678,
-31004,
-30814,
-31131,
-31902,
-32995,
-34224,
-35401,
-36325,
-36889,
-36995,
-36686,
-36006,
-35106,
-34106,
-33175,
-32411,
-31916,
-31704,
-31773,
-32071,
-32510,
-33022,
-33503,
-33905,
-34175,
-34299,
-34281,
-34133,
-33882,
-33548,
-33149,
-32721,
-32268,
-31860,
-31509,
-31294,
-31226,
-31341,
-31592,
-31945,
-32267,
-32485,
-32464,
-32173,
-31596,
-30818,
-29971,
-29244,
-28814,
-28849,
-29419,
-30545,
-32113,
-33965,
-35860,
-37552,
-38818,
-39487,
-39486,
-38830,
-37650,
-36146,
-34577,
-33207,
-32260,
-31886,
-32136,
-32936,
-34131,
-35494,
-36778,
-37777,
-38344,
-38430,
-38080,
-37410,
-36584,
-35770,
-35100,
-34674,
-34501,
-34573,
-34810,
-35135,
-35460,
-35714,
-35846,
-35832,
-35683,
-35400,
-35056,
-34661,
-34290,
-33968,
-33721,
-33555,
-33458,
-33395,
-33352,
-33287,
-33204,
-33094,
-32974,
-32859,
-32758,
-32668,
-32570,
-32439,
-32254,
-32003,
-31701,
-31377,
-31091,
-30892,
-30835,
-30935,
-31187,
-31561,
-31986,
-32414,
-32765,
-33017,
-33129,
-33126,
-33012,
-32848,
-32657,
-32505,
-32416,
-32429,
-32550,
-32772,
-33077,
-33403,
-33728,
-33971,
-34127,
-34165,
-34112,
-34007,
-33902,
-33855,
-33905,
-34056,
-34298,
-34584,
-34846,
-35048,
-35126,
-35088,
-34933,
-34708,
-34457,
-34233,
-34080,
-34016,
-34055,
-34176,
-34358,
-34568,
-34756,
-34906,
-34957,
-34911,
-34739,
-34454,
-34081,
-33639,
-33197,
-32775,
-32436,
-32191,
-32050,
-31999,
-32008,
-32040,
-32061,
-32043,
-31984,
-31883,
-31788,
-31717,
-31734,
-31859,
-32124,
-32522,
-33035,
-33611,
-34195,
-34713,
-35115,
-35353,
-35423,
-35330,
-35127,
-34862,
-34609,
-34410,
-34300,
-34280,
-34316,
-34366,
-34365,
-34258,
-34015,
-33614,
-33097,
-32481,
-31862,
-31281,
-30808,
-30472,
-30276,
-30196,
-30177,
-30165,
-30087,
-29922,
-29638,
-29277,
-28872,
-28513,
-28259,
-28179,
-28301,
-28624,
-29109,
-29706,
-30339,
-30954,
-31515,
-31996,
-32416,
-32789,
-33144,
-33503,
-33868,
-34240,
-34599,
-34932,
-35222,
-35464,
-35661,
-35815,
-35940,
-36033,
-36092,
-36117,
-36092,
-36015,
-35890,
-35716,
-35510,
-35289,
-35053,
-34830,
-34597,
-34378,
-34142,
-33904,
-33642,
-33358,
-33050,
-32705,
-32339,
-31939,
-31535,
-31132,
-30773,
-30481,
-30299,
-30246,
-30342,
-30571,
-30918,
-31331,
-31771,
-32181,
-32534,
-32791,
-32957,
-33036,
-33044,
-33022,
-32981,
-32963,
-32974,
-33033,
-33137,
-33273,
-33421,
-33567,
-33662,
-33709,
-33673,
-33557,
-33386,
-33153,
-32916,
-32672,
-32456,
-32258,
-32082,
-31905,
-31723,
-31524,
-31325,
-31142,
-31019,
-30984,
-31078,
-31302,
-31669,
-32122,
-32652,
-33168,
-33655,
-34046,
-34332,
-34507,
-34569,
-34566,
-34497,
-34424,
-34351,
-34316,
-34329,
-34391,
-34503,
-34642,
-34783,
-34893,
-34934,
-34879,
-34701,
-34400,
-33986,
-33488,
-32945,
-32402,
-31893,
-31447,
-31079,
-30780,
-30540,
-30338,
-30165,
-30008,
-29882,
-29793,
-29772,
-29830,
-29988,
-30240,
-30573,
-30963,
-31379,
-31775,
-32140,
-32437,
-32669,
-32845,
-32965,
-33069,
-33163,
-33275,
-33412,
-33582,
-33777,
-33992,
-34210,
-34414,
-34594,
-34734,
-34837,
-34888,
-34906,
-34876,
-34827,
-34739,
-34637,
-34504,
-34354,
-34186,
-34005,
-33822,
-33654,
-33501,
-33388,
-33308,
-33268,
-33274,
-33298,
-33359,
-33425,
-33505,
-33595,
-33687,
-33800,
-33925,
-34077,
-34262,
-34487,
-34745,
-35040,
-35343,
-35633,
-35885,
-36043,
-36106,
-36034,
-35858,
-35584,
-35285,
-35004,
-34804,
-34729,
-34784,
-34954,
-35188,
-35417,
-35562,
-35574,
-35403,
-35058,
-34564,
-33979,
-33374,
-32821,
-32369,
-32063,
-31891,
-31851,
-31889,
-31958,
-32006,
-31993,
-31895,
-31717,
-31484,
-31237,
-31038,
-30922,
-30938,
-31083,
-31345,
-31686,
-32038,
-32364,
-32602,
-32743,
-32788,
-32760,
-32706,
-32663,
-32663,
-32734,
-32860,
-33042,
-33234,
-33422,
-33559,
-33632,
-33616,
-33507,
-33305,
-33031,
-32708,
-32379,
-32094,
-31891,
-31812,
-31870,
-32050,
-32325,
-32635,
-32926,
-33144,
-33266,
-33279,
-33226,
-33126,
-33052,
-33023,
-33077,
-33197,
-33373,
-33556,
-33716,
-33819,
-33848,
-33810,
-33724,
-33621,
-33537,
-33514,
-33565,
-33715,
-33951,
-34256,
-34591,
-34914,
-35170,
-35325,
-35342,
-35226,
-34978,
-34653,
-34273,
-33916,
-33589,
-33342,
-33150,
-33023,
-32914,
-32813,
-32698,
-32558,
-32404,
-32255,
-32121,
-32032,
-32000,
-32023,
-32125,
-32279,
-32499,
-32765,
-33058,
-33379,
-33679,
-33966,
-34203,
-34379,
-34503,
-34563,
-34585,
-34583,
-34572,
-34565,
-34580,
-34613,
-34673,
-34761,
-34868,
-34998,
-35135,
-35261,
-35351,
-35377,
-35309,
-35140,
-34854,
-34487,
-34056,
-33616,
-33216,
-32883,
-32656,
-32522,
-32484,
-32502,
-32562,
-32632,
-32699,
-32771,
-32830,
-32922,
-33022,
-33173,
-33340,
-33540,
-33739,
-33924,
-34071,
-34162,
-34190,
-34149,
-34065,
-33947,
-33837,
-33771,
-33761,
-33849,
-34014,
-34250,
-34532,
-34800,
-35038,
-35177,
-35224,
-35138,
-34943,
-34643,
-34261,
-33833,
-33382,
-32949,
-32556,
-32243,
-32019,
-31910,
-31907,
-32002,
-32163,
-32366,
-32567,
-32760,
-32920,
-33074,
-33228,
-33428,
-33679,
-33999,
-34361,
-34734,
-35059,
-35280,
-35361,
-35265,
-35019,
-34646,
-34211,
-33784,
-33419,
-33164,
-33040,
-33038,
-33132,
-33288,
-33446,
-33592,
-33670,
-33694,
-33635,
-33525,
-33378,
-33220,
-33098,
-33021,
-33037,
-33142,
-33344,
-33618,
-33922,
-34215,
-34439,
-34561,
-34550,
-34421,
-34187,
-33902,
-33617,
-33366,
-33193,
-33089,
-33036,
-33018,
-32963,
-32882,
-32722,
-32511,
-32261,
-31997,
-31757,
-31551,
-31385,
-31260,
-31148,
-31049,
-30943,
-30840,
-30754,
-30708,
-30717,
-30800,
-30952,
-31156,
-31391,
-31613,
-31797,
-31926,
-31986,
-32004,
-31992,
-32004,
-32069,
-32227,
-32490,
-32861,
-33313,
-33812,
-34301,
-34736,
-35062,
-35262,
-35328,
-35274,
-35152,
-34984,
-34843,
-34736,
-34702,
-34716,
-34780,
-34841,
-34894,
-34904,
-34872,
-34808,
-34727,
-34651,
-34595,
-34566,
-34544,
-34531,
-34478,
-34390,
-34230,
-34029,
-33767,
-33516,
-33266,
-33084,
-32969,
-32940,
-32993,
-33100,
-33246,
-33382,
-33495,
-33552,
-33549,
-33495,
-33393,
-33277,
-33160,
-33073,
-33025,
-33021,
-33056,
-33120,
-33189,
-33248,
-33275,
-33245,
-33163,
-33007,
-32794,
-32539,
-32266,
-32005,
-31801,
-31665,
-31641,
-31705,
-31862,
-32055,
-32261,
-32414,
-32503,
-32499,
-32434,
-32332,
-32253,
-32242,
-32335,
-32544,
-32850,
-33210,
-33567,
-33868,
-34062,
-34135,
-34092,
-33955,
-33792,
-33624,
-33531,
-33515,
-33614,
-33803,
-34065,
-34358,
-34643,
-34867,
-35016,
-35045,
-34985,
-34833,
-34640,
-34441,
-34280,
-34181,
-34157,
-34198,
-34268,
-34351,
-34394,
-34401,
-34360,
-34293,
-34229,
-34195,
-34215,
-34296,
-34428,
-34583,
-34740,
-34851,
-34911,
-34889,
-34782,
-34606,
-34356,
-34068,
-33769,
-33488,
-33275,
-33155,
-33152,
-33264,
-33470,
-33714,
-33942,
-34090,
-34120,
-34025,
-33826,
-33581,
-33358,
-33210,
-33181,
-33259,
-33406,
-33562,
-33654,
-33627,
-33462,
-33165,
-32778,
-32367,
-31989,
-31693,
-31513,
-31442,
-31469,
-31562,
-31675,
-31786,
-31856,
-31870,
-31832,
-31734,
-31620,
-31504,
-31443,
-31454,
-31579,
-31795,
-32109,
-32446,
-32781,
-33042,
-33208,
-33266,
-33231,
-33145,
-33060,
-33011,
-33049,
-33164,
-33371,
-33636,
-33930,
-34229,
-34487,
-34694,
-34804,
-34816,
-34705,
-34486,
-34175,
-33805,
-33422,
-33074,
-32782,
-32572,
-32421,
-32314,
-32215,
-32109,
-31978,
-31852,
-31745,
-31692,
-31716,
-31803,
-31951,
-32104,
-32242,
-32326,
-32351,
-32324,
-32269,
-32200,
-32145,
-32100,
-32071,
-32054,
-32040,
-32054,
-32079,
-32155,
-32236,
-32339,
-32394,
-32398,
-32308,
-32145,
-31942,
-31759,
-31668,
-31710,
-31911,
-32236,
-32628,
-33012,
-33309,
-33483,
-33514,
-33426,
-33264,
-33061,
-32856,
-32670,
-32505,
-32385,
-32323,
-32334,
-32447,
-32651,
-32915,
-33199,
-33401,
-33493,
-33420,
-33227,
-32974,
-32758,
-32672,
-32746,
-32966,
-33248,
-33480,
-33560,
-33447,
-33149,
-32767,
-32413,
-32177,
-32130,
-32226,
-32400,
-32557,
-32620,
-32595,
-32531,
-32527,
-32642,
-32901,
-33199,
-33402,
-33343,
-32914,
-32165,
-31241,
-30443,
-30032,
-30199,
-30915,
-31937,
-32833,
-33141,
-32492,
-30810,
-28314,
-25568,
-23267,
-22103,
-22514,
-24567,
-27891,
-31816,
-35456,
-38069,
-39099,
-38446,
-36354,
-33417,
-30340,
-27814,
-26317,
-26065,
-26966,
-28712,
-30833,
-32874,
-34432,
-35286,
-35419,
-34988,
-34363,
-33934,
-34136,
-35212,
-37204,
-39836,
-42552,
-44614,
-45272,
-43970,
-40540,
-35332,
-29159,
-23210,
-18710,
-16692,
-17656,
-21464,
-27338,
-34025,
-40146,
-44492,
-46348,
-45607,
-42804,
-38850,
-34866,
-31771,
-30146,
-30062,
-31169,
-32807,
-34259,
-34949,
-34591,
-33261,
-31336,
-29382,
-27987,
-27604,
-28455,
-30455,
-33264,
-36336,
-39067,
-40883,
-41433,
-40569,
-38489,
-35606,
-32535,
-29914,
-28282,
-27960,
-28947,
-30950,
-33432,
-35740,
-37303,
-37693,
-36837,
-34912,
-32393,
-29866,
-27916,
-26977,
-27247,
-28652,
-30868,
-33444,
-35837,
-37608,
-38426,
-38160,
-36890,
-34823,
-32355,
-29859,
-27764,
-26382,
-25926,
-26455,
-27867,
-29931,
-32314,
-34650,
-36591,
-37873,
-38360,
-38039,
-37055,
-35619,
-34030,
-32563,
-31467,
-30887,
-30894,
-31423,
-32355,
-33485,
-34616,
-35546,
-36145,
-36347,
-36161,
-35661,
-34966,
-34195,
-33480,
-32908,
-32555,
-32457,
-32648,
-33113,
-33838,
-34740,
-35705,
-36585,
-37181,
-37366,
-37021,
-36175,
-34944,
-33552,
-32271,
-31347,
-30950,
-31123,
-31771,
-32724,
-33734,
-34629,
-35254,
-35584,
-35635,
-35452,
-35089,
-34529,
-33762,
-32758,
-31541,
-30228,
-28991,
-28082,
-27731,
-28077,
-29160,
-30812,
-32799,
-34750,
-36363,
-37346,
-37572,
-37030,
-35815,
-34168,
-32320,
-30616,
-29322,
-28731,
-28998,
-30154,
-32049,
-34304,
-36421,
-37802,
-37961,
-36634,
-33915,
-30275,
-26509,
-23541,
-22215,
-23052,
-26101,
-30892,
-36536,
-41912,
-45935,
-47788,
-47105,
-44013,
-39096,
-33250,
-27490,
-22781,
-19875,
-19212,
-20877,
-24611,
-29832,
-35746,
-41405,
-45905,
-48443,
-48548,
-46073,
-41333,
-34992,
-28014,
-21486,
-16440,
-13741,
-13877,
-17006,
-22808,
-30620,
-39409,
-47933,
-54852,
-58938,
-59273,
-55481,
-47866,
-37481,
-26007,
-15503,
-8004,
-5116,
-7590,
-15182,
-26555,
-39638,
-51927,
-61088,
-65367,
-63948,
-57090,
-46015,
-32689,
-19391,
-8394,
-1504,
-1,
-3825,
-12716,
-25126,
-39026,
-52060,
-61954,
-65534,
-65531,
-59320,
-48026,
-34216,
-20438,
-9214,
-2557,
-1530,
-6145,
-15385,
-27514,
-40484,
-52301,
-61387,
-65534,
-65534,
-64606,
-57631,
-47506,
-35207,
-21921,
-9112,
-65535,
-65535,
-0,
-65535,
-1374,
-14601,
-30287,
-45975,
-59118,
-65534,
-65534,
-65534,
-56144,
-42703,
-27879,
-14290,
-4300,
-65535,
-1031,
-8299,
-20171,
-34617,
-49130,
-61164,
-65534,
-65534,
-64627,
-53613,
-38452,
-21554,
-5588,
-2,
-65535,
-0,
-65535,
-3230,
-18743,
-35854,
-52114,
-65288,
-65533,
-65534,
-65534,
-62657,
-49172,
-33705,
-18699,
-6627,
-0,
-65535,
-4359,
-15537,
-30229,
-45630,
-58718,
-65533,
-65534,
-61731,
-49041,
-32081,
-13958,
-1,
-65535,
-4,
-65535,
-0,
-13359,
-30659,
-46997,
-59894,
-65531,
-65534,
-65533,
-57986,
-46751,
-33980,
-21203,
-9863,
-1173,
-4,
-65535,
-3,
-8697,
-20989,
-35074,
-48700,
-59415,
-65096,
-64417,
-57268,
-44827,
-29434,
-14090,
-1875,
-65535,
-1,
-3040,
-16202,
-32837,
-50132,
-65259,
-65533,
-65534,
-65534,
-65534,
-56186,
-39799,
-22944,
-8143,
-0,
-65535,
-0,
-3585,
-16562,
-31821,
-46570,
-58113,
-64422,
-64528,
-58702,
-48395,
-35859,
-23710,
-14299,
-9340,
-9522,
-14505,
-23029,
-33227,
-43046,
-50649,
-54749,
-54857,
-51289,
-45108,
-37844,
-31160,
-26494,
-24726,
-26004,
-29729,
-34725,
-39553,
-42913,
-43960,
-42553,
-39240,
-35107,
-31435,
-29328,
-29423,
-31690,
-35499,
-39790,
-43379,
-45282,
-44910,
-42221,
-37627,
-31916,
-26011,
-20834,
-17145,
-15490,
-16135,
-19089,
-24049,
-30456,
-37448,
-44014,
-49030,
-51543,
-50891,
-46937,
-40130,
-31467,
-22370,
-14383,
-8915,
-6948,
-8836,
-14278,
-22332,
-31620,
-40554,
-47605,
-51556,
-51712,
-48008,
-41058,
-32068,
-22668,
-14618,
-9526,
-8469,
-11808,
-19011,
-28736,
-39082,
-47922,
-53413,
-54342,
-50447,
-42489,
-32059,
-21316,
-12425,
-7186,
-6572,
-10608,
-18305,
-27993,
-37583,
-45139,
-49189,
-49094,
-45136,
-38420,
-30635,
-23634,
-19036,
-17865,
-20332,
-25816,
-33027,
-40342,
-46145,
-49256,
-49110,
-45898,
-40445,
-33995,
-27904,
-23348,
-21100,
-21424,
-24104,
-28516,
-33854,
-39193,
-43728,
-46790,
-47934,
-46987,
-44046,
-39495,
-34001,
-28397,
-23628,
-20519,
-19660,
-21205,
-24843,
-29809,
-35056,
-39473,
-42144,
-42584,
-40808,
-37385,
-33197,
-29321,
-26647,
-25782,
-26818,
-29420,
-32860,
-36236,
-38698,
-39576,
-38620,
-35932,
-32033,
-27696,
-23802,
-21180,
-20403,
-21716,
-24922,
-29473,
-34520,
-39120,
-42423,
-43815,
-43099,
-40434,
-36359,
-31572,
-26829,
-22734,
-19700,
-17879,
-17281,
-17799,
-19355,
-21893,
-25371,
-29686,
-34580,
-39572,
-43988,
-47047,
-48053,
-46559,
-42586,
-36593,
-29541,
-22595,
-17011,
-13779,
-13517,
-16306,
-21740,
-29016,
-37064,
-44754,
-50970,
-54835,
-55676,
-53247,
-47670,
-39579,
-30023,
-20420,
-12322,
-7144,
-5888,
-8855,
-15577,
-24858,
-35042,
-44361,
-51375,
-55196,
-55696,
-53334,
-48945,
-43407,
-37341,
-31036,
-24479,
-17626,
-10672,
-4254,
-1,
-65535,
-148,
-7303,
-18747,
-32859,
-47152,
-58699,
-64902,
-64120,
-56183,
-42467,
-25657,
-9104,
-2,
-65535,
-3,
-65535,
-10653,
-27149,
-44036,
-58598,
-65534,
-65534,
-65534,
-62697,
-50243,
-35367,
-20519,
-8300,
-953,
-65535,
-5787,
-17414,
-32739,
-48693,
-62023,
-65533,
-65534,
-64052,
-51676,
-36182,
-20893,
-8914,
-2489,
-2470,
-8286,
-18173,
-29702,
-40421,
-48381,
-52475,
-52569,
-49284,
-43780,
-37369,
-31245,
-26327,
-23168,
-21961,
-22635,
-24854,
-28128,
-31846,
-35328,
-37984,
-39329,
-39193,
-37649,
-35106,
-32132,
-29350,
-27298,
-26261,
-26313,
-27273,
-28862,
-30773,
-32766,
-34691,
-36465,
-37999,
-39161,
-39772,
-39621,
-38613,
-36772,
-34398,
-31929,
-29953,
-28976,
-29315,
-30973,
-33626,
-36691,
-39484,
-41380,
-41971,
-41133,
-39063,
-36163,
-32990,
-30097,
-27980,
-26976,
-27282,
-28855,
-31505,
-34796,
-38166,
-40949,
-42517,
-42420,
-40543,
-37153,
-32950,
-28868,
-25939,
-24953,
-26296,
-29766,
-34635,
-39789,
-44021,
-46329,
-46156,
-43546,
-39057,
-33679,
-28491,
-24502,
-22374,
-22393,
-24402,
-27975,
-32443,
-37119,
-41303,
-44420,
-46019,
-45827,
-43805,
-40145,
-35336,
-30112,
-25349,
-21969,
-20679,
-21869,
-25426,
-30736,
-36778,
-42285,
-46053,
-47174,
-45279,
-40637,
-34116,
-27048,
-20910,
-17072,
-16426,
-19251,
-25071,
-32776,
-40819,
-47542,
-51532,
-51935,
-48632,
-42315,
-34304,
-26322,
-20070,
-16917,
-17552,
-21872,
-28982,
-37392,
-45334,
-51119,
-53507,
-51942,
-46676,
-38738,
-29680,
-21350,
-15412,
-13128,
-14976,
-20640,
-28994,
-38360,
-46863,
-52778,
-54961,
-53020,
-47430,
-39383,
-30513,
-22540,
-16902,
-14502,
-15575,
-19732,
-26116,
-33609,
-41045,
-47388,
-51779,
-53651,
-52667,
-48826,
-42478,
-34343,
-25573,
-17566,
-11813,
-9594,
-11606,
-17802,
-27210,
-38148,
-48490,
-56172,
-59651,
-58260,
-52356,
-43222,
-32701,
-22830,
-15336,
-11368,
-11333,
-14933,
-21317,
-29342,
-37712,
-45227,
-50805,
-53657,
-53284,
-49637,
-43143,
-34758,
-25869,
-18098,
-12992,
-11664,
-14524,
-21103,
-30132,
-39813,
-48196,
-53669,
-55262,
-52878,
-47217,
-39571,
-31505,
-24469,
-19576,
-17416,
-18052,
-21128,
-25938,
-31653,
-37349,
-42190,
-45464,
-46703,
-45752,
-42817,
-38468,
-33517,
-28905,
-25427,
-23628,
-23602,
-25071,
-27459,
-30098,
-32457,
-34240,
-35470,
-36339,
-37105,
-37870,
-38509,
-38671,
-37931,
-35961,
-32787,
-28810,
-24853,
-21903,
-20874,
-22309,
-26165,
-31812,
-38115,
-43760,
-47524,
-48642,
-46892,
-42725,
-37028,
-30979,
-25736,
-22213,
-20939,
-21991,
-25040,
-29445,
-34395,
-39024,
-42573,
-44462,
-44397,
-42429,
-38907,
-34528,
-30086,
-26470,
-24360,
-24142,
-25794,
-28884,
-32653,
-36241,
-38834,
-39933,
-39423,
-37622,
-35161,
-32814,
-31265,
-30926,
-31809,
-33539,
-35444,
-36779,
-36902,
-35535,
-32782,
-29242,
-25769,
-23380,
-22913,
-24872,
-29220,
-35370,
-42237,
-48464,
-52680,
-53794,
-51271,
-45249,
-36612,
-26806,
-17601,
-10757,
-7616,
-8880,
-14396,
-23191,
-33691,
-43986,
-52270,
-57163,
-57970,
-54769,
-48340,
-39933,
-31014,
-22950,
-16828,
-13317,
-12674,
-14778,
-19225,
-25394,
-32505,
-39654,
-45867,
-50211,
-51909,
-50564,
-46264,
-39692,
-32084,
-24971,
-19949,
-18200,
-20277,
-25805,
-33620,
-41873,
-48533,
-51770,
-50407,
-44213,
-33947,
-21254,
-8347,
-65535,
-65535,
-1,
-65535,
-5690,
-20137,
-36182,
-51130,
-62383,
-65534,
-65534,
-58669,
-45552,
-29766,
-14476,
-2834,
-65535,
-2,
-8721,
-23665,
-41299,
-58134,
-65534,
-65534,
-65534,
-65313,
-50369,
-32995,
-16723,
-4881,
-65535,
-2716,
-12866,
-28289,
-45878,
-62088,
-65534,
-65534,
-65534,
-63855,
-47881,
-29930,
-13553,
-1999,
-65535,
-651,
-10753,
-25528,
-41817,
-56259,
-65534,
-65534,
-65032,
-55008,
-41187,
-26532,
-14121,
-6474,
-5059,
-9962,
-19915,
-32558,
-44993,
-54435,
-58836,
-57370,
-50564,
-40176,
-28712,
-18804,
-12574,
-11116,
-14351,
-21070,
-29391,
-37259,
-42961,
-45562,
-44925,
-41729,
-37052,
-32117,
-27920,
-25087,
-23820,
-23983,
-25231,
-27148,
-29312,
-31350,
-32962,
-33905,
-34116,
-33656,
-32821,
-32017,
-31682,
-32085,
-33173,
-34523,
-35394,
-35007,
-32817,
-28850,
-23830,
-19103,
-16283,
-16779,
-21229,
-29229,
-39221,
-48873,
-55637,
-57482,
-53513,
-44265,
-31643,
-18449,
-7662,
-1714,
-1872,
-8004,
-18677,
-31551,
-44002,
-53681,
-58971,
-59229,
-54754,
-46603,
-36349,
-25687,
-16292,
-9506,
-6286,
-7068,
-11738,
-19631,
-29588,
-40074,
-49411,
-56006,
-58635,
-56715,
-50374,
-40602,
-28998,
-17659,
-8696,
-3950,
-4520,
-10554,
-21095,
-34208,
-47297,
-57619,
-62880,
-61778,
-54389,
-42195,
-27855,
-14580,
-5407,
-2459,
-6386,
-16227,
-29624,
-43417,
-54429,
-60255,
-59761,
-53383,
-42823,
-30671,
-19646,
-12052,
-9228,
-11434,
-17851,
-26933,
-36731,
-45366,
-51267,
-53470,
-51653,
-46161,
-37956,
-28438,
-19298,
-12238,
-8687,
-9544,
-14904,
-24011,
-35292,
-46603,
-55700,
-60598,
-60127,
-54148,
-43653,
-30621,
-17601,
-7209,
-1602,
-1986,
-8408,
-19668,
-33626,
-47531,
-58651,
-64753,
-64568,
-58073,
-46442,
-31897,
-17197,
-5178,
-65535,
-65535,
-3138,
-14234,
-28588,
-43478,
-56099,
-64051,
-65534,
-61052,
-50547,
-36201,
-20644,
-6762,
-65535,
-0,
-65535,
-7071,
-21473,
-37748,
-52779,
-63652,
-65534,
-65533,
-56535,
-42663,
-26927,
-12520,
-2348,
-1,
-1440,
-10755,
-24417,
-39749,
-53737,
-63757,
-65534,
-65532,
-57341,
-44627,
-29912,
-15942,
-5318,
-72,
-1232,
-8711,
-21179,
-36390,
-51460,
-63480,
-65533,
-65534,
-62044,
-48640,
-31734,
-14438,
-65535,
-65535,
-65535,
-65535,
-7158,
-23124,
-39871,
-54112,
-63087,
-65012,
-59531,
-47675,
-31772,
-14938,
-527,
-65535,
-0,
-65535,
-7918,
-24642,
-42289,
-57342,
-65533,
-65534,
-62880,
-50568,
-34467,
-18027,
-4727,
-1,
-65535,
-4532,
-17365,
-33069,
-48378,
-60264,
-65532,
-65534,
-58962,
-47125,
-32788,
-18683,
-7438,
-1035,
-586,
-6085,
-16469,
-29805,
-43570,
-55150,
-62275,
-63486,
-58472,
-48188,
-34695,
-20823,
-9471,
-3063,
-2871,
-8773,
-19226,
-31687,
-43235,
-51334,
-54434,
-52353,
-46169,
-37932,
-29897,
-24041,
-21388,
-21975,
-24891,
-28728,
-32105,
-34085,
-34459,
-33671,
-32599,
-32125,
-32816,
-34680,
-37176,
-39434,
-40530,
-39869,
-37325,
-33358,
-28845,
-24857,
-22370,
-22019,
-23966,
-27862,
-32959,
-38251,
-42698,
-45409,
-45805,
-43745,
-39530,
-33905,
-27884,
-22618,
-19110,
-18080,
-19738,
-23817,
-29563,
-35963,
-41888,
-46371,
-48689,
-48519,
-45889,
-41178,
-35049,
-28378,
-22182,
-17521,
-15320,
-16189,
-20220,
-26820,
-34766,
-42332,
-47730,
-49532,
-47150,
-41086,
-32881,
-24781,
-19095,
-17541,
-20705,
-27798,
-36884,
-45393,
-50902,
-51833,
-47900,
-40212,
-30868,
-22397,
-16975,
-15891,
-19230,
-25949,
-34226,
-42000,
-47469,
-49518,
-47863,
-43058,
-36273,
-29058,
-22987,
-19432,
-19262,
-22694,
-29175,
-37425,
-45606,
-51699,
-53956,
-51371,
-44080,
-33416,
-21739,
-11884,
-6469,
-7177,
-14247,
-26366,
-40898,
-54556,
-64179,
-65534,
-63655,
-53408,
-38851,
-22962,
-8915,
-65535,
-2,
-65535,
-9536,
-23360,
-38718,
-52691,
-62628,
-65534,
-63812,
-54780,
-41270,
-25986,
-11983,
-2049,
-65535,
-464,
-8490,
-20120,
-32747,
-43855,
-51557,
-54992,
-54333,
-50576,
-45092,
-39189,
-33818,
-29402,
-25979,
-23364,
-21393,
-20069,
-19593,
-20224,
-22204,
-25534,
-29989,
-35093,
-40237,
-44759,
-48059,
-49609,
-49018,
-46055,
-40741,
-33455,
-25037,
-16765,
-10260,
-7112,
-8532,
-14880,
-25427,
-38343,
-51003,
-60583,
-64745,
-62295,
-53534,
-40254,
-25345,
-12086,
-3379,
-1050,
-5465,
-15488,
-28837,
-42589,
-53931,
-60632,
-61567,
-56768,
-47396,
-35426,
-23229,
-13145,
-7027,
-5957,
-10025,
-18378,
-29312,
-40699,
-50288,
-56270,
-57532,
-53951,
-46350,
-36333,
-25931,
-17166,
-11671,
-10378,
-13370,
-19950,
-28750,
-38083,
-46189,
-51596,
-53321,
-51084,
-45295,
-37067,
-27956,
-19740,
-14053,
-12062,
-14237,
-20175,
-28741,
-38193,
-46643,
-52353,
-54194,
-51798,
-45684,
-37089,
-27736,
-19449,
-13825,
-11928,
-14088,
-19901,
-28248,
-37561,
-46041,
-52021,
-54243,
-52122,
-45899,
-36609,
-25942,
-15929,
-8505,
-5141,
-6460,
-12119,
-20842,
-30735,
-39699,
-45953,
-48432,
-47016,
-42540,
-36482,
-30599,
-26391,
-24767,
-25818,
-28898,
-32854,
-36439,
-38684,
-39148,
-38011,
-35922,
-33727,
-32185,
-31697,
-32260,
-33513,
-34960,
-36168,
-36942,
-37319,
-37523,
-37703,
-37907,
-37899,
-37384,
-36096,
-34096,
-31825,
-30076,
-29734,
-31360,
-34942,
-39636,
-44005,
-46362,
-45429,
-40823,
-33398,
-25102,
-18438,
-15735,
-18261,
-25813,
-36579,
-47702,
-56065,
-59312,
-56518,
-48528,
-37598,
-26736,
-18717,
-15335,
-16917,
-22439,
-29939,
-37251,
-42634,
-45175,
-44862,
-42340,
-38557,
-34392,
-30508,
-27305,
-25092,
-24122,
-24703,
-26976,
-30803,
-35595,
-40316,
-43774,
-44956,
-43482,
-39812,
-35205,
-31319,
-29646,
-30891,
-34684,
-39556,
-43473,
-44460,
-41387,
-34376,
-24867,
-15192,
-7886,
-4921,
-7187,
-14281,
-24752,
-36551,
-47602,
-56217,
-61313,
-62409,
-59484,
-52918,
-43405,
-32106,
-20625,
-10978,
-5248,
-5059,
-11022,
-22253,
-36416,
-50057,
-59574,
-62168,
-56795,
-44582,
-28575,
-12973,
-1890,
-0,
-2888,
-14583,
-30339,
-46430,
-59426,
-65532,
-65534,
-64331,
-56337,
-46410,
-36296,
-27306,
-20233,
-15554,
-13536,
-14369,
-17953,
-23882,
-31185,
-38498,
-44271,
-47246,
-46837,
-43459,
-38353,
-33337,
-30070,
-29596,
-31874,
-35873,
-39886,
-42221,
-41763,
-38480,
-33347,
-28094,
-24511,
-23861,
-26423,
-31381,
-37169,
-41923,
-44215,
-43386,
-39826,
-34753,
-29809,
-26574,
-26053,
-28448,
-33124,
-38786,
-43870,
-46895,
-46832,
-43342,
-36851,
-28537,
-20073,
-13374,
-10153,
-11544,
-17745,
-27880,
-40010,
-51566,
-59819,
-62613,
-58931,
-49248,
-35529,
-20816,
-8515,
-1564,
-1687,
-8948,
-21761,
-37233,
-51946,
-62703,
-65534,
-64945,
-56353,
-43497,
-29072,
-15936,
-6477,
-2292,
-3892,
-10779,
-21566,
-34265,
-46646,
-56527,
-62184,
-62574,
-57583,
-48108,
-35933,
-23513,
-13473,
-8117,
-8844,
-15806,
-27719,
-42104,
-55740,
-65436,
-65532,
-64616,
-53719,
-38327,
-21800,
-7842,
-65535,
-2,
-5917,
-19065,
-35436,
-51535,
-64044,
-65530,
-65534,
-62706,
-50532,
-35926,
-21729,
-10464,
-3980,
-3163,
-7844,
-16920,
-28515,
-40343,
-50061,
-55705,
-56086,
-51066,
-41682,
-29991,
-18707,
-10563,
-7708,
-11078,
-20125,
-32868,
-46322,
-57247,
-62970,
-62076,
-54823,
-43043,
-29717,
-18154,
-11166,
-10354,
-15695,
-25632,
-37452,
-48024,
-54563,
-55283,
-49837,
-39328,
-26076,
-13043,
-3218,
-65535,
-1370,
-10362,
-24332,
-40685,
-56257,
-65534,
-65534,
-65533,
-63152,
-49170,
-32702,
-16985,
-5125,
-65535,
-755,
-8817,
-21814,
-37072,
-51591,
-62666,
-65534,
-65534,
-62398,
-52719,
-41355,
-30645,
-22589,
-18416,
-18407,
-21939,
-27687,
-34028,
-39427,
-42794,
-43685,
-42337,
-39496,
-36186,
-33358,
-31690,
-31403,
-32305,
-33893,
-35570,
-36835,
-37424,
-37369,
-36924,
-36475,
-36371,
-36839,
-37870,
-39268,
-40634,
-41511,
-41432,
-40065,
-37280,
-33265,
-28512,
-23852,
-20286,
-18832,
-20269,
-24849,
-32157,
-41050,
-49815,
-56529,
-59503,
-57754,
-51318,
-41357,
-29914,
-19494,
-12421,
-10289,
-13547,
-21377,
-31934,
-42756,
-51425,
-56061,
-55774,
-50791,
-42321,
-32285,
-22808,
-15828,
-12716,
-14023,
-19469,
-27959,
-37868,
-47268,
-54332,
-57641,
-56477,
-51011,
-42265,
-31991,
-22278,
-15140,
-12058,
-13630,
-19426,
-28103,
-37684,
-46073,
-51511,
-52995,
-50450,
-44732,
-37298,
-29906,
-24096,
-20952,
-20823,
-23429,
-27911,
-33198,
-38182,
-42022,
-44208,
-44640,
-43502,
-41210,
-38228,
-35023,
-31972,
-29375,
-27450,
-26374,
-26263,
-27183,
-29095,
-31837,
-35111,
-38466,
-41414,
-43432,
-44164,
-43400,
-41219,
-37926,
-34017,
-30109,
-26803,
-24626,
-23932,
-24895,
-27463,
-31377,
-36172,
-41174,
-45592,
-48551,
-49302,
-47324,
-42594,
-35622,
-27535,
-19872,
-14335,
-12363,
-14767,
-21420,
-31204,
-42163,
-51934,
-58277,
-59643,
-55566,
-46830,
-35291,
-23474,
-13966,
-8832,
-9135,
-14720,
-24284,
-35688,
-46475,
-54396,
-57904,
-56429,
-50477,
-41447,
-31326,
-22228,
-15950,
-13638,
-15537,
-21024,
-28768,
-37033,
-44119,
-48674,
-49992,
-48097,
-43680,
-37859,
-31935,
-27037,
-23985,
-23111,
-24336,
-27225,
-31138,
-35377,
-39244,
-42169,
-43691,
-43571,
-41769,
-38577,
-34509,
-30388,
-27040,
-25279,
-25535,
-27839,
-31684,
-36177,
-40239,
-42909,
-43553,
-42103,
-38946,
-34880,
-30819,
-27538,
-25567,
-25034,
-25848,
-27704,
-30321,
-33430,
-36799,
-40148,
-43069,
-45015,
-45412,
-43803,
-40110,
-34757,
-28682,
-23193,
-19604,
-18885,
-21339,
-26459,
-33060,
-39582,
-44542,
-46942,
-46531,
-43779,
-39710,
-35471,
-32003,
-29774,
-28706,
-28391,
-28296,
-28121,
-27896,
-28011,
-28988,
-31209,
-34636,
-38732,
-42488,
-44790,
-44696,
-41857,
-36669,
-30199,
-24004,
-19577,
-18078,
-19867,
-24527,
-30908,
-37481,
-42734,
-45531,
-45367,
-42438,
-37518,
-31767,
-26431,
-22606,
-21058,
-22095,
-25581,
-30934,
-37238,
-43366,
-48117,
-50470,
-49727,
-45776,
-39133,
-30989,
-22994,
-16963,
-14467,
-16390,
-22703,
-32298,
-43235,
-53103,
-59592,
-61078,
-57040,
-48216,
-36495,
-24442,
-14699,
-9358,
-9438,
-14692,
-23677,
-34169,
-43700,
-50199,
-52419,
-50224,
-44496,
-36896,
-29363,
-23659,
-20968,
-21648,
-25252,
-30677,
-36486,
-41263,
-43931,
-43958,
-41463,
-37105,
-31954,
-27192,
-23869,
-22679,
-23793,
-26885,
-31170,
-35651,
-39327,
-41432,
-41636,
-40049,
-37237,
-33985,
-31153,
-29389,
-29043,
-30048,
-32033,
-34377,
-36474,
-37796,
-38103,
-37396,
-35945,
-34180,
-32575,
-31570,
-31435,
-32267,
-33920,
-36062,
-38203,
-39829,
-40460,
-39863,
-38048,
-35378,
-32477,
-30062,
-28801,
-29034,
-30704,
-33281,
-35937,
-37751,
-38020,
-36493,
-33487,
-29799,
-26528,
-24668,
-24897,
-27271,
-31288,
-35995,
-40281,
-43217,
-44239,
-43299,
-40749,
-37204,
-33320,
-29645,
-26549,
-24282,
-23018,
-22960,
-24296,
-27103,
-31252,
-36204,
-41137,
-44954,
-46672,
-45672,
-41991,
-36371,
-30169,
-24899,
-21918,
-21898,
-24694,
-29377,
-34513,
-38685,
-40869,
-40794,
-38909,
-36203,
-33774,
-32430,
-32400,
-33298,
-34306,
-34547,
-33478,
-31115,
-28131,
-25592,
-24648,
-26089,
-30050,
-35905,
-42384,
-47911,
-50983,
-50592,
-46458,
-39127,
-29861,
-20385,
-12557,
-8013,
-7847,
-12395,
-21097,
-32545,
-44673,
-55083,
-61547,
-62466,
-57307,
-46855,
-33092,
-18906,
-7396,
-1177,
-1709,
-8886,
-21049,
-35352,
-48494,
-57501,
-60491,
-57063,
-48341,
-36622,
-24729,
-15311,
-10236,
-10240,
-14872,
-22749,
-31961,
-40536,
-46882,
-50001,
-49664,
-46306,
-40899,
-34720,
-29079,
-25085,
-23425,
-24231,
-27059,
-31001,
-34906,
-37691,
-38645,
-37622,
-35121,
-32090,
-29663,
-28764,
-29798,
-32512,
-36050,
-39250,
-41011,
-40659,
-38179,
-34180,
-29720,
-25925,
-23675,
-23349,
-24808,
-27502,
-30747,
-33931,
-36684,
-38874,
-40466,
-41423,
-41540,
-40548,
-38180,
-34463,
-29810,
-25096,
-21458,
-19964,
-21278,
-25312,
-31225,
-37552,
-42673,
-45248,
-44686,
-41264,
-36075,
-30621,
-26383,
-24323,
-24730,
-27127,
-30616,
-34149,
-36912,
-38473,
-38832,
-38217,
-36971,
-35304,
-33362,
-31218,
-29070,
-27295,
-26412,
-26952,
-29158,
-32847,
-37249,
-41269,
-43666,
-43637,
-40969,
-36359,
-31061,
-26668,
-24436,
-24976,
-27951,
-32268,
-36421,
-39060,
-39434,
-37649,
-34588,
-31556,
-29770,
-29944,
-32003,
-35179,
-38280,
-40144,
-40042,
-37879,
-34218,
-30015,
-26329,
-23998,
-23447,
-24695,
-27405,
-31094,
-35169,
-39074,
-42190,
-43936,
-43754,
-41324,
-36707,
-30573,
-24131,
-19026,
-16839,
-18662,
-24591,
-33577,
-43515,
-51836,
-56112,
-54953,
-48315,
-37768,
-25947,
-15960,
-10415,
-10766,
-16882,
-27164,
-39009,
-49564,
-56444,
-58306,
-55044,
-47681,
-38007,
-28077,
-19815,
-14632,
-13331,
-16004,
-22112,
-30555,
-39791,
-48074,
-53664,
-55242,
-52202,
-44914,
-34788,
-23990,
-15009,
-9992,
-10170,
-15451,
-24464,
-34848,
-43971,
-49644,
-50681,
-47257,
-40671,
-32965,
-26224,
-21995,
-20921,
-22701,
-26343,
-30618,
-34469,
-37301,
-39015,
-39859,
-40134,
-40014,
-39398,
-38054,
-35778,
-32652,
-29135,
-26026,
-24214,
-24376,
-26678,
-30669,
-35368,
-39535,
-42095,
-42415,
-40564,
-37186,
-33334,
-30067,
-28159,
-27911,
-29094,
-31188,
-33511,
-35533,
-36945,
-37670,
-37807,
-37463,
-36730,
-35642,
-34266,
-32771,
-31460,
-30719,
-30883,
-32059,
-34029,
-36245,
-37976,
-38585,
-37761,
-35720,
-33157,
-31059,
-30340,
-31498,
-34351,
-38092,
-41443,
-43146,
-42336,
-38876,
-33449,
-27332,
-22063,
-18972,
-18831,
-21716,
-27010,
-33688,
-40563,
-46537,
-50780,
-52709,
-52020,
-48649,
-42824,
-35168,
-26756,
-19094,
-13873,
-12599,
-16090,
-24078,
-35073,
-46555,
-55573,
-59576,
-57157,
-48657,
-36111,
-22831,
-12457,
-7923,
-10601,
-19853,
-33245,
-47203,
-58066,
-63058,
-61029,
-52649,
-40138,
-26579,
-15091,
-8084,
-6803,
-11202,
-20103,
-31621,
-43521,
-53677,
-60322,
-62292,
-59166,
-51376,
-40188,
-27619,
-16116,
-8100,
-5448,
-8922,
-17955,
-30579,
-43923,
-54827,
-60691,
-60169,
-53495,
-42461,
-29879,
-18841,
-11891,
-10431,
-14421,
-22547,
-32635,
-42307,
-49509,
-52989,
-52370,
-48165,
-41465,
-33706,
-26354,
-20721,
-17765,
-18011,
-21434,
-27413,
-34829,
-42124,
-47715,
-50240,
-49014,
-44203,
-36891,
-28802,
-21924,
-17895,
-17640,
-21041,
-27068,
-34061,
-40249,
-44259,
-45438,
-43972,
-40679,
-36698,
-33046,
-30391,
-28886,
-28324,
-28320,
-28580,
-29036,
-29849,
-31267,
-33407,
-36113,
-38875,
-40977,
-41707,
-40612,
-37738,
-33582,
-29072,
-25199,
-22834,
-22423,
-23971,
-27058,
-31058,
-35284,
-39187,
-42348,
-44487,
-45356,
-44716,
-42377,
-38327,
-32869,
-26762,
-21121,
-17269,
-16333,
-18906,
-24713,
-32610,
-40725,
-47000,
-49689,
-47943,
-42054,
-33443,
-24293,
-16949,
-13295,
-14251,
-19546,
-27850,
-37122,
-45196,
-50251,
-51258,
-48094,
-41517,
-32919,
-23997,
-16444,
-11628,
-10443,
-13114,
-19224,
-27712,
-37062,
-45515,
-51447,
-53649,
-51715,
-46060,
-37993,
-29287,
-21861,
-17218,
-16111,
-18362,
-23009,
-28573,
-33596,
-36989,
-38332,
-37882,
-36376,
-34693,
-33540,
-33215,
-33568,
-34153,
-34428,
-34009,
-32793,
-30974,
-28930,
-27083,
-25754,
-25109,
-25213,
-26067,
-27690,
-30119,
-33298,
-36993,
-40686,
-43583,
-44792,
-43560,
-39590,
-33259,
-25639,
-18326,
-13045,
-11169,
-13340,
-19196,
-27483,
-36313,
-43693,
-48023,
-48469,
-45191,
-39170,
-31985,
-25332,
-20639,
-18734,
-19732,
-23029,
-27561,
-32018,
-35233,
-36380,
-35246,
-32188,
-28155,
-24356,
-22045,
-22084,
-24757,
-29551,
-35299,
-40421,
-43351,
-43014,
-39141,
-32441,
-24413,
-17007,
-12085,
-10910,
-13865,
-20294,
-28769,
-37445,
-44509,
-48639,
-49188,
-46278,
-40664,
-33487,
-26052,
-19590,
-15084,
-13195,
-14132,
-17684,
-23146,
-29473,
-35387,
-39668,
-41454,
-40438,
-37067,
-32348,
-27685,
-24372,
-23264,
-24484,
-27375,
-30792,
-33395,
-34224,
-32897,
-29837,
-26003,
-22659,
-20839,
-21144,
-23495,
-27281,
-31588,
-35456,
-38185,
-39371,
-38934,
-36973,
-33682,
-29317,
-24254,
-19085,
-14672,
-12045,
-12205,
-15734,
-22516,
-31527,
-40957,
-48576,
-52329,
-50947,
-44401,
-33992,
-22083,
-11491,
-4711,
-3305,
-7445,
-15988,
-26778,
-37308,
-45317,
-49336,
-48919,
-44589,
-37621,
-29585,
-22070,
-16303,
-13097,
-12709,
-14975,
-19297,
-24822,
-30506,
-35316,
-38393,
-39206,
-37728,
-34370,
-29995,
-25600,
-22165,
-20332,
-20354,
-22016,
-24802,
-28068,
-31171,
-33674,
-35248,
-35746,
-35052,
-33119,
-30015,
-25996,
-21630,
-17787,
-15484,
-15654,
-18792,
-24654,
-32232,
-39787,
-45383,
-47313,
-44723,
-37910,
-28338,
-18334,
-10429,
-6706,
-8162,
-14461,
-23974,
-34272,
-42753,
-47361,
-47096,
-42247,
-34239,
-25244,
-17575,
-13107,
-12873,
-16794,
-23834,
-32199,
-39832,
-44872,
-46056,
-43017,
-36364,
-27530,
-18502,
-11347,
-7760,
-8642,
-13901,
-22387,
-32204,
-41101,
-47010,
-48597,
-45484,
-38461,
-29161,
-19745,
-12314,
-8464,
-8898,
-13389,
-20790,
-29482,
-37623,
-43666,
-46550,
-45896,
-41994,
-35677,
-28135,
-20712,
-14661,
-11003,
-10344,
-12815,
-17997,
-25017,
-32612,
-39399,
-44080,
-45741,
-44045,
-39326,
-32559,
-25134,
-18600,
-14277,
-12998,
-14914,
-19472,
-25586,
-31886,
-37055,
-40150,
-40720,
-38970,
-35505,
-31291,
-27233,
-24101,
-22276,
-21822,
-22496,
-23937,
-25784,
-27771,
-29760,
-31672,
-33399,
-34761,
-35444,
-35145,
-33634,
-30966,
-27521,
-24040,
-21442,
-20606,
-22057,
-25777,
-31072,
-36753,
-41329,
-43494,
-42445,
-38171,
-31525,
-23994,
-17388,
-13337,
-12890,
-16251,
-22722,
-30876,
-38927,
-45114,
-48125,
-47340,
-42942,
-35839,
-27467,
-19455,
-13365,
-10341,
-10963,
-15093,
-21956,
-30226,
-38335,
-44722,
-48200,
-48162,
-44751,
-38791,
-31631,
-24810,
-19724,
-17302,
-17833,
-20942,
-25708,
-30945,
-35471,
-38369,
-39172,
-37875,
-34923,
-31045,
-27120,
-23998,
-22369,
-22652,
-24902,
-28795,
-33623,
-38411,
-42069,
-43648,
-42554,
-38783,
-32960,
-26267,
-20208,
-16232,
-15367,
-17954,
-23505,
-30830,
-38315,
-44314,
-47536,
-47347,
-43847,
-37838,
-30576,
-23478,
-17871,
-14683,
-14413,
-16987,
-21893,
-28211,
-34828,
-40561,
-44434,
-45793,
-44551,
-41131,
-36478,
-31767,
-28125,
-26307,
-26449,
-28044,
-30085,
-31425,
-31174,
-29070,
-25606,
-21955,
-19583,
-19790,
-23223,
-29587,
-37648,
-45514,
-51140,
-52906,
-50050,
-42910,
-32853,
-21915,
-12362,
-6147,
-4549,
-7912,
-15681,
-26475,
-38424,
-49453,
-57602,
-61398,
-60067,
-53732,
-43474,
-31174,
-19218,
-10040,
-5548,
-6705,
-13217,
-23568,
-35356,
-45877,
-52784,
-54702,
-51509,
-44354,
-35246,
-26523,
-20179,
-17406,
-18380,
-22298,
-27800,
-33325,
-37608,
-39941,
-40218,
-38887,
-36639,
-34228,
-32191,
-30846,
-30190,
-30078,
-30254,
-30486,
-30610,
-30570,
-30398,
-30219,
-30204,
-30545,
-31373,
-32730,
-34478,
-36326,
-37838,
-38545,
-38085,
-36325,
-33466,
-30022,
-26736,
-24401,
-23635,
-24737,
-27564,
-31577,
-35956,
-39792,
-42280,
-42908,
-41508,
-38307,
-33850,
-28900,
-24339,
-20989,
-19567,
-20436,
-23659,
-28801,
-35050,
-41297,
-46315,
-49057,
-48885,
-45735,
-40214,
-33402,
-26710,
-21456,
-18643,
-18692,
-21421,
-26106,
-31715,
-37150,
-41457,
-44017,
-44561,
-43163,
-40207,
-36225,
-31923,
-28007,
-25159,
-23915,
-24518,
-26885,
-30511,
-34609,
-38231,
-40561,
-41131,
-39994,
-37709,
-35188,
-33347,
-32832,
-33683,
-35373,
-36883,
-37131,
-35345,
-31444,
-26156,
-20885,
-17323,
-16919,
-20396,
-27460,
-36766,
-46280,
-53745,
-57316,
-56025,
-50040,
-40604,
-29734,
-19727,
-12644,
-9897,
-11969,
-18405,
-27916,
-38670,
-48626,
-55880,
-59018,
-57333,
-51028,
-41179,
-29642,
-18700,
-10636,
-7252,
-9418,
-16854,
-28099,
-40839,
-52383,
-60337,
-63071,
-60183,
-52429,
-41599,
-29954,
-19759,
-12755,
-9897,
-11267,
-16204,
-23581,
-32049,
-40321,
-47273,
-52048,
-54099,
-53185,
-49474,
-43513,
-36261,
-28954,
-22916,
-19276,
-18695,
-21199,
-26117,
-32289,
-38292,
-42864,
-45144,
-44889,
-42439,
-38569,
-34243,
-30369,
-27647,
-26463,
-26956,
-29021,
-32370,
-36547,
-40886,
-44578,
-46722,
-46573,
-43736,
-38448,
-31620,
-24746,
-19561,
-17545,
-19449,
-24983,
-32807,
-40861,
-46976,
-49510,
-47887,
-42794,
-35916,
-29457,
-25337,
-24650,
-27285,
-32041,
-37082,
-40578,
-41364,
-39277,
-35196,
-30644,
-27270,
-26213,
-27800,
-31421,
-35859,
-39701,
-41857,
-41875,
-40034,
-37151,
-34247,
-32175,
-31360,
-31740,
-32875,
-34177,
-35159,
-35575,
-35449,
-34991,
-34425,
-33911,
-33433,
-32931,
-32297,
-31597,
-31003,
-30837,
-31426,
-32941,
-35327,
-38239,
-41096,
-43254,
-44141,
-43425,
-41102,
-37494,
-33193,
-28942,
-25508,
-23549,
-23517,
-25561,
-29487,
-34746,
-40476,
-45633,
-49165,
-50230,
-48431,
-43921,
-37482,
-30326,
-23942,
-19646,
-18398,
-20440,
-25328,
-31977,
-38923,
-44675,
-48027,
-48317,
-45583,
-40485,
-34207,
-28157,
-23708,
-21898,
-23215,
-27486,
-33856,
-40977,
-47197,
-50970,
-51156,
-47351,
-40047,
-30581,
-20907,
-13194,
-9299,
-10357,
-16429,
-26460,
-38486,
-50031,
-58701,
-62677,
-61160,
-54508,
-44134,
-32181,
-21008,
-12709,
-8682,
-9386,
-14349,
-22326,
-31634,
-40521,
-47501,
-51595,
-52438,
-50244,
-45691,
-39732,
-33413,
-27709,
-23384,
-20957,
-20608,
-22237,
-25441,
-29611,
-34007,
-37895,
-40659,
-41947,
-41707,
-40208,
-37942,
-35483,
-33341,
-31806,
-30927,
-30523,
-30325,
-30096,
-29797,
-29569,
-29742,
-30642,
-32443,
-35050,
-38019,
-40712,
-42421,
-42628,
-41192,
-38391,
-34907,
-31579,
-29217,
-28307,
-28931,
-30715,
-32979,
-34943,
-35929,
-35587,
-33945,
-31443,
-28788,
-26824,
-26303,
-27719,
-31127,
-36059,
-41577,
-46335,
-48970,
-48321,
-43926,
-36205,
-26577,
-17192,
-10526,
-8608,
-12515,
-21803,
-34555,
-47737,
-57951,
-62411,
-59725,
-50354,
-36570,
-21793,
-9716,
-3229,
-3709,
-10659,
-22001,
-34698,
-45687,
-52657,
-54575,
-51790,
-45682,
-38202,
-31185,
-25999,
-23268,
-22938,
-24473,
-27094,
-30027,
-32612,
-34396,
-35126,
-34794,
-33635,
-32117,
-30882,
-30564,
-31604,
-34024,
-37328,
-40580,
-42622,
-42491,
-39765,
-34799,
-28741,
-23186,
-19759,
-19543,
-22747,
-28589,
-35536,
-41752,
-45665,
-46381,
-43904,
-39038,
-33079,
-27398,
-23116,
-20878,
-20868,
-22924,
-26656,
-31593,
-37117,
-42474,
-46723,
-48836,
-47966,
-43710,
-36504,
-27617,
-19096,
-13207,
-11828,
-15814,
-24560,
-36078,
-47394,
-55399,
-57707,
-53388,
-43297,
-29839,
-16394,
-6344,
-2254,
-5205,
-14576,
-28293,
-43326,
-56479,
-65005,
-65534,
-62632,
-52154,
-37735,
-22058,
-8092,
-65535,
-3,
-65535,
-9999,
-25164,
-41818,
-56390,
-65534,
-65534,
-61082,
-48233,
-31800,
-15700,
-3792,
-0,
-2205,
-12767,
-27978,
-44183,
-57565,
-65151,
-65376,
-58464,
-46181,
-31395,
-17331,
-6891,
-2053,
-3574,
-10923,
-22461,
-35825,
-48383,
-57694,
-62004,
-60479,
-53459,
-42349,
-29410,
-17342,
-8689,
-5349,
-8091,
-16360,
-28379,
-41506,
-52837,
-59885,
-61147,
-56443,
-46963,
-34902,
-22998,
-13773,
-9077,
-9608,
-14917,
-23555,
-33511,
-42690,
-49386,
-52562,
-51983,
-48132,
-42009,
-34885,
-28047,
-22600,
-19366,
-18761,
-20814,
-25099,
-30841,
-36937,
-42201,
-45530,
-46214,
-44094,
-39697,
-34088,
-28698,
-24860,
-23524,
-24904,
-28480,
-33118,
-37454,
-40298,
-41002,
-39621,
-36852,
-33732,
-31283,
-30136,
-30381,
-31580,
-32995,
-33948,
-34018,
-33316,
-32246,
-31481,
-31503,
-32516,
-34267,
-36204,
-37660,
-38145,
-37492,
-35937,
-33969,
-32156,
-30923,
-30434,
-30592,
-31160,
-31914,
-32753,
-33727,
-34925,
-36361,
-37851,
-38979,
-39274,
-38332,
-36128,
-33039,
-29856,
-27515,
-26800,
-28034,
-30944,
-34714,
-38266,
-40618,
-41221,
-40112,
-37852,
-35270,
-33094,
-31720,
-31053,
-30687,
-30134,
-29169,
-28004,
-27255,
-27727,
-29995,
-34092,
-39337,
-44414,
-47805,
-48197,
-45055,
-38759,
-30668,
-22642,
-16651,
-14107,
-15620,
-20784,
-28414,
-36853,
-44401,
-49684,
-51847,
-50660,
-46456,
-40024,
-32485,
-25166,
-19379,
-16304,
-16642,
-20507,
-27224,
-35433,
-43333,
-49092,
-51358,
-49627,
-44419,
-37150,
-29715,
-23933,
-21063,
-21401,
-24379,
-28708,
-32954,
-35925,
-37056,
-36459,
-34782,
-32894,
-31527,
-31085,
-31547,
-32609,
-33855,
-34958,
-35737,
-36185,
-36304,
-36078,
-35371,
-34045,
-32058,
-29606,
-27158,
-25381,
-24895,
-26094,
-28837,
-32558,
-36254,
-38925,
-39829,
-38781,
-36245,
-33151,
-30614,
-29525,
-30270,
-32570,
-35637,
-38377,
-39816,
-39369,
-37009,
-33297,
-29121,
-25535,
-23402,
-23273,
-25232,
-28960,
-33774,
-38777,
-42997,
-45520,
-45688,
-43210,
-38309,
-31723,
-24659,
-18547,
-14754,
-14262,
-17355,
-23575,
-31737,
-40227,
-47381,
-51824,
-52808,
-50269,
-44816,
-37525,
-29671,
-22548,
-17196,
-14390,
-14469,
-17402,
-22680,
-29426,
-36426,
-42370,
-46092,
-46869,
-44672,
-40193,
-34760,
-29903,
-26981,
-26666,
-28765,
-32234,
-35508,
-37076,
-35965,
-32181,
-26718,
-21295,
-17811,
-17699,
-21478,
-28503,
-37179,
-45374,
-51080,
-52907,
-50521,
-44576,
-36571,
-28336,
-21591,
-17528,
-16640,
-18647,
-22756,
-27799,
-32639,
-36304,
-38239,
-38347,
-36985,
-34880,
-32933,
-31947,
-32453,
-34388,
-37161,
-39672,
-40634,
-39023,
-34417,
-27339,
-19236,
-12186,
-8402,
-9528,
-16138,
-27390,
-41141,
-54390,
-64040,
-65530,
-64103,
-53927,
-39196,
-22968,
-8682,
-65535,
-0,
-870,
-11182,
-25185,
-39948,
-52530,
-60546,
-62622,
-58606,
-49568,
-37522,
-25018,
-14615,
-8348,
-7325,
-11516,
-19759,
-30072,
-40084,
-47591,
-51054,
-49909,
-44672,
-36744,
-28053,
-20569,
-15877,
-14813,
-17411,
-22893,
-29992,
-37205,
-43156,
-46831,
-47713,
-45831,
-41666,
-36039,
-29939,
-24370,
-20200,
-18061,
-18263,
-20742,
-25100,
-30605,
-36338,
-41310,
-44613,
-45636,
-44122,
-40324,
-34908,
-28907,
-23490,
-19721,
-18352,
-19602,
-23142,
-28146,
-33485,
-38023,
-40879,
-41633,
-40399,
-37749,
-34498,
-31470,
-29264,
-28105,
-27905,
-28299,
-28908,
-29432,
-29777,
-30025,
-30326,
-30792,
-31394,
-31963,
-32283,
-32222,
-31849,
-31463,
-31510,
-32368,
-34181,
-36631,
-39032,
-40395,
-39848,
-36904,
-31767,
-25396,
-19283,
-15116,
-14242,
-17259,
-23788,
-32497,
-41440,
-48542,
-52139,
-51392,
-46478,
-38511,
-29249,
-20662,
-14479,
-11883,
-13237,
-18173,
-25598,
-34035,
-41814,
-47437,
-49780,
-48369,
-43422,
-35908,
-27348,
-19562,
-14271,
-12718,
-15329,
-21590,
-30116,
-38939,
-46019,
-49675,
-49098,
-44471,
-36987,
-28510,
-21098,
-16489,
-15675,
-18666,
-24516,
-31627,
-38122,
-42389,
-43450,
-41179,
-36352,
-30360,
-24878,
-21401,
-20848,
-23357,
-28233,
-34165,
-39585,
-43078,
-43758,
-41511,
-36934,
-31235,
-25786,
-21818,
-20079,
-20681,
-23178,
-26728,
-30429,
-33546,
-35715,
-36925,
-37437,
-37565,
-37509,
-37266,
-36629,
-35341,
-33246,
-30441,
-27337,
-24568,
-22840,
-22698,
-24335,
-27525,
-31612,
-35716,
-38932,
-40550,
-40264,
-38180,
-34816,
-30936,
-27360,
-24816,
-23736,
-24267,
-26185,
-29031,
-32174,
-34953,
-36815,
-37391,
-36571,
-34531,
-31651,
-28495,
-25656,
-23678,
-22970,
-23720,
-25906,
-29258,
-33334,
-37506,
-41105,
-43420,
-43932,
-42307,
-38674,
-33521,
-27823,
-22762,
-19567,
-19151,
-21831,
-27191,
-34072,
-40858,
-45841,
-47721,
-45968,
-40997,
-34098,
-27032,
-21598,
-19057,
-19852,
-23489,
-28743,
-34087,
-38144,
-40078,
-39806,
-37857,
-35187,
-32759,
-31233,
-30839,
-31324,
-32180,
-32868,
-32987,
-32445,
-31360,
-30011,
-28656,
-27488,
-26590,
-26057,
-25999,
-26669,
-28301,
-31058,
-34793,
-38974,
-42687,
-44849,
-44487,
-41150,
-35099,
-27403,
-19721,
-13856,
-11329,
-12845,
-18164,
-26087,
-34833,
-42497,
-47556,
-49204,
-47472,
-43091,
-37197,
-30991,
-25467,
-21288,
-18789,
-18115,
-19278,
-22247,
-26842,
-32660,
-38960,
-44687,
-48637,
-49733,
-47395,
-41759,
-33804,
-25151,
-17713,
-13180,
-12580,
-15994,
-22524,
-30592,
-38302,
-44020,
-46662,
-45980,
-42446,
-37097,
-31170,
-25851,
-22011,
-20170,
-20442,
-22648,
-26343,
-30893,
-35513,
-39346,
-41582,
-41625,
-39281,
-34886,
-29310,
-23819,
-19777,
-18282,
-19847,
-24207,
-30350,
-36785,
-41905,
-44469,
-43856,
-40263,
-34565,
-28057,
-22115,
-17851,
-15927,
-16515,
-19329,
-23848,
-29344,
-35088,
-40279,
-44153,
-45985,
-45232,
-41695,
-35689,
-28119,
-20421,
-14280,
-11272,
-12381,
-17700,
-26280,
-36298,
-45475,
-51631,
-53268,
-49938,
-42396,
-32351,
-22096,
-13872,
-9404,
-9506,
-13958,
-21669,
-30929,
-39848,
-46726,
-50338,
-50133,
-46254,
-39481,
-31063,
-22520,
-15384,
-10950,
-10072,
-12959,
-19166,
-27592,
-36719,
-44836,
-50416,
-52385,
-50353,
-44708,
-36512,
-27346,
-18943,
-12919,
-10405,
-11872,
-16998,
-24755,
-33551,
-41597,
-47208,
-49212,
-47183,
-41584,
-33661,
-25201,
-18104,
-13943,
-13591,
-17010,
-23281,
-30873,
-38003,
-43153,
-45341,
-44398,
-40842,
-35728,
-30286,
-25598,
-22412,
-21003,
-21257,
-22838,
-25268,
-28161,
-31156,
-33978,
-36373,
-38052,
-38779,
-38351,
-36753,
-34181,
-31041,
-27905,
-25351,
-23844,
-23637,
-24680,
-26724,
-29311,
-31984,
-34274,
-35853,
-36474,
-36041,
-34584,
-32282,
-29506,
-26765,
-24699,
-23894,
-24751,
-27293,
-31082,
-35257,
-38714,
-40415,
-39719,
-36633,
-31897,
-26817,
-22925,
-21517,
-23232,
-27807,
-34101,
-40380,
-44811,
-45992,
-43372,
-37434,
-29584,
-21758,
-15940,
-13601,
-15377,
-20903,
-28952,
-37766,
-45468,
-50492,
-51878,
-49426,
-43679,
-35765,
-27168,
-19455,
-14034,
-11896,
-13514,
-18675,
-26553,
-35769,
-44612,
-51358,
-54570,
-53471,
-48085,
-39374,
-28997,
-19069,
-11668,
-8390,
-10010,
-16263,
-25923,
-37073,
-47495,
-55190,
-58747,
-57632,
-52237,
-43743,
-33826,
-24304,
-16770,
-12345,
-11527,
-14177,
-19639,
-26871,
-34671,
-41854,
-47383,
-50543,
-50949,
-48653,
-44080,
-38008,
-31438,
-25464,
-21066,
-18979,
-19505,
-22504,
-27374,
-33185,
-38853,
-43329,
-45822,
-45910,
-43631,
-39452,
-34179,
-28805,
-24340,
-21616,
-21153,
-23063,
-27001,
-32256,
-37833,
-42684,
-45872,
-46804,
-45320,
-41758,
-36848,
-31564,
-26905,
-23672,
-22331,
-22955,
-25244,
-28689,
-32675,
-36630,
-40113,
-42785,
-44423,
-44849,
-43915,
-41571,
-37896,
-33221,
-28134,
-23473,
-20150,
-19005,
-20495,
-24615,
-30732,
-37753,
-44268,
-48892,
-50575,
-48813,
-43849,
-36546,
-28320,
-20787,
-15489,
-13600,
-15632,
-21398,
-29904,
-39581,
-48483,
-54686,
-56672,
-53704,
-46058,
-35082,
-22953,
-12313,
-5594,
-4522,
-9563,
-19806,
-33074,
-46428,
-56862,
-62034,
-60853,
-53738,
-42487,
-29828,
-18697,
-11537,
-9725,
-13292,
-21031,
-30856,
-40376,
-47511,
-50898,
-50214,
-46070,
-39843,
-33213,
-27816,
-24779,
-24588,
-26947,
-30931,
-35251,
-38547,
-39789,
-38500,
-34942,
-30025,
-25158,
-21806,
-21163,
-23751,
-29224,
-36428,
-43619,
-48930,
-50861,
-48681,
-42684,
-34109,
-24867,
-17063,
-12439,
-12039,
-15876,
-23097,
-32119,
-41115,
-48361,
-52613,
-53270,
-50425,
-44744,
-37297,
-29367,
-22212,
-16971,
-14421,
-14971,
-18478,
-24316,
-31396,
-38342,
-43809,
-46694,
-46515,
-43456,
-38414,
-32738,
-27905,
-25096,
-24917,
-27208,
-31152,
-35505,
-38996,
-40654,
-40104,
-37569,
-33808,
-29817,
-26552,
-24700,
-24547,
-25991,
-28670,
-32075,
-35699,
-39086,
-41822,
-43547,
-43919,
-42702,
-39822,
-35534,
-30400,
-25344,
-21395,
-19532,
-20311,
-23760,
-29203,
-35491,
-41186,
-44988,
-46054,
-44205,
-39989,
-34480,
-29014,
-24815,
-22720,
-23002,
-25383,
-29142,
-33348,
-37084,
-39619,
-40538,
-39767,
-37538,
-34359,
-30898,
-27901,
-26068,
-25907,
-27606,
-30925,
-35208,
-39436,
-42501,
-43445,
-41777,
-37687,
-32014,
-26150,
-21601,
-19626,
-20821,
-24910,
-30826,
-36968,
-41693,
-43801,
-42871,
-39418,
-34662,
-30171,
-27332,
-26905,
-28828,
-32210,
-35694,
-37888,
-37851,
-35395,
-31171,
-26455,
-22754,
-21358,
-22923,
-27316,
-33603,
-40361,
-45982,
-49159,
-49067,
-45660,
-39507,
-31761,
-23856,
-17251,
-13216,
-12592,
-15650,
-22039,
-30737,
-40233,
-48691,
-54323,
-55771,
-52427,
-44720,
-34058,
-22653,
-12990,
-7297,
-6946,
-12091,
-21616,
-33347,
-44637,
-52989,
-56666,
-55111,
-48980,
-39933,
-30155,
-21769,
-16379,
-14727,
-16671,
-21315,
-27360,
-33407,
-38296,
-41272,
-42051,
-40805,
-38015,
-34405,
-30740,
-27756,
-26004,
-25769,
-27019,
-29375,
-32241,
-34891,
-36692,
-37270,
-36573,
-34934,
-32872,
-30985,
-29685,
-29130,
-29152,
-29425,
-29561,
-29384,
-28933,
-28534,
-28600,
-29464,
-31198,
-33502,
-35820,
-37450,
-37876,
-36893,
-34774,
-32135,
-29793,
-28438,
-28431,
-29695,
-31735,
-33853,
-35390,
-35911,
-35380,
-34052,
-32397,
-30864,
-29754,
-29150,
-28957,
-29032,
-29274,
-29716,
-30471,
-31641,
-33201,
-34912,
-36355,
-37052,
-36655,
-35113,
-32740,
-30178,
-28154,
-27306,
-27872,
-29660,
-32079,
-34317,
-35682,
-35745,
-34570,
-32561,
-30395,
-28673,
-27808,
-27853,
-28585,
-29639,
-30696,
-31608,
-32446,
-33372,
-34531,
-35854,
-37051,
-37638,
-37160,
-35372,
-32441,
-28948,
-25780,
-23849,
-23798,
-25769,
-29290,
-33449,
-37086,
-39226,
-39303,
-37384,
-34096,
-30463,
-27550,
-26219,
-26819,
-29194,
-32686,
-36381,
-39316,
-40755,
-40297,
-38026,
-34395,
-30214,
-26392,
-23846,
-23202,
-24745,
-28224,
-32945,
-37837,
-41700,
-43510,
-42655,
-39206,
-33877,
-27957,
-22941,
-20178,
-20472,
-23874,
-29620,
-36358,
-42463,
-46503,
-47551,
-45443,
-40722,
-34519,
-28173,
-22980,
-19860,
-19260,
-21121,
-24964,
-30033,
-35457,
-40341,
-43905,
-45547,
-44902,
-41993,
-37167,
-31219,
-25184,
-20253,
-17456,
-17476,
-20413,
-25753,
-32464,
-39207,
-44671,
-47858,
-48279,
-46034,
-41707,
-36168,
-30351,
-25044,
-20801,
-17929,
-16567,
-16777,
-18597,
-22026,
-26964,
-33076,
-39750,
-46092,
-51019,
-53532,
-52872,
-48848,
-41860,
-32963,
-23624,
-15489,
-10019,
-8218,
-10412,
-16209,
-24557,
-33975,
-42809,
-49515,
-52978,
-52617,
-48583,
-41642,
-33120,
-24618,
-17770,
-13861,
-13640,
-17072,
-23371,
-31142,
-38638,
-44221,
-46658,
-45495,
-41100,
-34630,
-27677,
-21939,
-18726,
-18697,
-21696,
-26822,
-32713,
-37908,
-41210,
-42001,
-40301,
-36752,
-32350,
-28192,
-25178,
-23828,
-24228,
-26069,
-28813,
-31829,
-34576,
-36630,
-37776,
-37904,
-37053,
-35327,
-32937,
-30208,
-27567,
-25548,
-24654,
-25297,
-27581,
-31287,
-35776,
-40138,
-43343,
-44506,
-43133,
-39278,
-33586,
-27189,
-21420,
-17565,
-16472,
-18423,
-22991,
-29202,
-35707,
-41160,
-44440,
-44985,
-42776,
-38403,
-32834,
-27211,
-22600,
-19792,
-19157,
-20657,
-23845,
-28045,
-32421,
-36196,
-38716,
-39569,
-38655,
-36143,
-32529,
-28479,
-24800,
-22250,
-21408,
-22554,
-25530,
-29804,
-34465,
-38462,
-40799,
-40762,
-38182,
-33430,
-27492,
-21678,
-17412,
-15859,
-17613,
-22552,
-29753,
-37722,
-44661,
-48918,
-49354,
-45674,
-38505,
-29328,
-20130,
-13002,
-9627,
-10895,
-16676,
-25808,
-36375,
-46087,
-52825,
-55106,
-52401,
-45275,
-35233,
-24355,
-14894,
-8680,
-6860,
-9573,
-16068,
-24849,
-34084,
-41982,
-47177,
-48948,
-47301,
-42883,
-36781,
-30261,
-24517,
-20465,
-18638,
-19154,
-21744,
-25865,
-30770,
-35649,
-39723,
-42326,
-43033,
-41670,
-38428,
-33781,
-28490,
-23461,
-19578,
-17570,
-17825,
-20312,
-24574,
-29789,
-34934,
-38984,
-41125,
-40910,
-38388,
-34065,
-28844,
-23826,
-20073,
-18429,
-19262,
-22457,
-27340,
-32892,
-37882,
-41214,
-42097,
-40297,
-36155,
-30531,
-24639,
-19713,
-16826,
-16527,
-18875,
-23301,
-28884,
-34479,
-39031,
-41778,
-42364,
-40900,
-37863,
-33960,
-29970,
-26561,
-24228,
-23166,
-23377,
-24599,
-26482,
-28598,
-30534,
-31995,
-32768,
-32858,
-32365,
-31549,
-30700,
-30094,
-29920,
-30234,
-30938,
-31844,
-32702,
-33298,
-33506,
-33286,
-32722,
-31909,
-30979,
-29998,
-29023,
-28072,
-27214,
-26553,
-26261,
-26516,
-27435,
-29005,
-31031,
-33163,
-34949,
-35990,
-36020,
-35048,
-33324,
-31313,
-29518,
-28366,
-28035,
-28450,
-29273,
-30060,
-30408,
-30080,
-29129,
-27833,
-26664,
-26075,
-26421,
-27777,
-29968,
-32552,
-34976,
-36668,
-37216,
-36412,
-34352,
-31373,
-28035,
-24983,
-22855,
-22139,
-23072,
-25568,
-29218,
-33328,
-37073,
-39650,
-40477,
-39324,
-36409,
-32323,
-27928,
-24154,
-21727,
-21102,
-22253,
-24823,
-28151,
-31502,
-34227,
-35882,
-36319,
-35631,
-34132,
-32212,
-30296,
-28746,
-27837,
-27725,
-28449,
-29881,
-31818,
-33880,
-35702,
-36873,
-37122,
-36323,
-34553,
-32076,
-29267,
-26554,
-24303,
-22804,
-22238,
-22685,
-24185,
-26682,
-30072,
-34072,
-38241,
-41959,
-44475,
-45157,
-43550,
-39736,
-34245,
-28165,
-22791,
-19412,
-18885,
-21407,
-26417,
-32679,
-38666,
-42865,
-44269,
-42573,
-38238,
-32389,
-26408,
-21680,
-19167,
-19307,
-21923,
-26369,
-31738,
-37046,
-41455,
-44344,
-45378,
-44486,
-41844,
-37846,
-33050,
-28161,
-23894,
-20921,
-19711,
-20433,
-22916,
-26655,
-30912,
-34878,
-37825,
-39266,
-39023,
-37268,
-34429,
-31162,
-28145,
-26062,
-25405,
-26441,
-29148,
-33116,
-37684,
-41890,
-44773,
-45437,
-43411,
-38698,
-31944,
-24309,
-17277,
-12338,
-10652,
-12752,
-18410,
-26654,
-35957,
-44579,
-50888,
-53734,
-52612,
-47809,
-40257,
-31429,
-22991,
-16546,
-13322,
-13927,
-18253,
-25431,
-34021,
-42257,
-48422,
-51251,
-50183,
-45563,
-38530,
-30749,
-24026,
-19797,
-18815,
-20950,
-25271,
-30333,
-34628,
-36957,
-36832,
-34479,
-30826,
-27130,
-24661,
-24340,
-26507,
-30870,
-36604,
-42530,
-47416,
-50177,
-50096,
-46937,
-40986,
-33034,
-24273,
-16147,
-10107,
-7380,
-8688,
-14049,
-22744,
-33328,
-43979,
-52756,
-58101,
-59092,
-55704,
-48717,
-39591,
-30050,
-21757,
-15958,
-13295,
-13774,
-16840,
-21622,
-27075,
-32286,
-36488,
-39248,
-40399,
-40046,
-38530,
-36313,
-33940,
-31919,
-30605,
-30185,
-30569,
-31497,
-32566,
-33390,
-33709,
-33472,
-32854,
-32170,
-31761,
-31867,
-32489,
-33419,
-34260,
-34585,
-34099,
-32749,
-30796,
-28744,
-27225,
-26800,
-27773,
-30117,
-33382,
-36867,
-39716,
-41176,
-40787,
-38502,
-34756,
-30367,
-26376,
-23826,
-23467,
-25612,
-29953,
-35645,
-41391,
-45782,
-47536,
-45899,
-40811,
-33000,
-23899,
-15344,
-9218,
-7045,
-9607,
-16785,
-27494,
-39912,
-51767,
-60848,
-65345,
-64313,
-57778,
-46837,
-33384,
-19850,
-8661,
-1837,
-562,
-4942,
-14016,
-25904,
-38253,
-48684,
-55330,
-57185,
-54307,
-47727,
-39180,
-30647,
-23894,
-20086,
-19564,
-21866,
-25918,
-30375,
-33996,
-35911,
-35861,
-34104,
-31393,
-28648,
-26760,
-26352,
-27610,
-30285,
-33736,
-37067,
-39378,
-39928,
-38356,
-34811,
-29909,
-24713,
-20421,
-18185,
-18728,
-22217,
-28108,
-35292,
-42308,
-47707,
-50399,
-49919,
-46528,
-41104,
-34897,
-29174,
-24888,
-22498,
-21888,
-22551,
-23795,
-25038,
-25993,
-26750,
-27694,
-29302,
-31941,
-35635,
-40047,
-44455,
-47987,
-49797,
-49299,
-46334,
-41180,
-34549,
-27390,
-20777,
-15672,
-12822,
-12651,
-15182,
-20103,
-26729,
-34171,
-41385,
-47388,
-51340,
-52771,
-51573,
-48102,
-43039,
-37282,
-31746,
-27181,
-24060,
-22495,
-22329,
-23182,
-24649,
-26385,
-28190,
-30016,
-31896,
-33887,
-35954,
-37954,
-39628,
-40654,
-40767,
-39783,
-37741,
-34827,
-31449,
-28078,
-25242,
-23413,
-22919,
-23946,
-26424,
-30081,
-34416,
-38758,
-42365,
-44537,
-44765,
-42852,
-39013,
-33830,
-28225,
-23203,
-19715,
-18399,
-19453,
-22645,
-27309,
-32614,
-37682,
-41798,
-44542,
-45718,
-45411,
-43755,
-40979,
-37256,
-32828,
-27996,
-23258,
-19236,
-16680,
-16238,
-18306,
-22827,
-29211,
-36382,
-43008,
-47737,
-49598,
-48156,
-43719,
-37197,
-29932,
-23377,
-18763,
-16859,
-17855,
-21341,
-26478,
-32184,
-37336,
-41012,
-42593,
-41845,
-38980,
-34537,
-29387,
-24517,
-20907,
-19326,
-20159,
-23310,
-28178,
-33762,
-38893,
-42465,
-43765,
-42573,
-39309,
-34821,
-30242,
-26620,
-24687,
-24682,
-26323,
-28934,
-31697,
-33861,
-35001,
-35038,
-34262,
-33137,
-32145,
-31607,
-31573,
-31876,
-32173,
-32162,
-31659,
-30742,
-29710,
-29006,
-29080,
-30212,
-32389,
-35291,
-38290,
-40620,
-41565,
-40608,
-37646,
-32989,
-27394,
-21885,
-17582,
-15462,
-16137,
-19722,
-25777,
-33355,
-41202,
-47927,
-52334,
-53569,
-51359,
-46006,
-38393,
-29802,
-21715,
-15536,
-12379,
-12823,
-16847,
-23778,
-32413,
-41217,
-48573,
-53097,
-53881,
-50694,
-44047,
-35114,
-25538,
-17129,
-11497,
-9783,
-12373,
-18866,
-28110,
-38409,
-47888,
-54764,
-57783,
-56345,
-50724,
-41928,
-31581,
-21585,
-13796,
-9655,
-9951,
-14631,
-22833,
-33034,
-43329,
-51813,
-56921,
-57750,
-54220,
-47072,
-37742,
-28031,
-19780,
-14491,
-13032,
-15495,
-21186,
-28754,
-36538,
-42800,
-46221,
-46038,
-42327,
-35928,
-28323,
-21330,
-16690,
-15721,
-18935,
-25951,
-35456,
-45506,
-53899,
-58673,
-58558,
-53297,
-43734,
-31672,
-19501,
-9675,
-4204,
-4192,
-9632,
-19406,
-31537,
-43632,
-53365,
-58953,
-59502,
-55100,
-46797,
-36307,
-25648,
-16776,
-11136,
-9542,
-11942,
-17594,
-25168,
-33085,
-39785,
-44062,
-45225,
-43239,
-38677,
-32581,
-26252,
-20965,
-17733,
-17112,
-19101,
-23168,
-28377,
-33584,
-37684,
-39860,
-39705,
-37387,
-33514,
-29099,
-25256,
-23024,
-23074,
-25592,
-30190,
-35983,
-41759,
-46244,
-48347,
-47457,
-43530,
-37199,
-29586,
-22180,
-16446,
-13625,
-14398,
-18781,
-26094,
-35060,
-44077,
-51480,
-55893,
-56476,
-53085,
-46311,
-37349,
-27756,
-19192,
-13039,
-10248,
-11097,
-15289,
-21961,
-29989,
-38144,
-45341,
-50793,
-54028,
-54924,
-53572,
-50248,
-45307,
-39177,
-32377,
-25515,
-19315,
-14560,
-11987,
-12138,
-15231,
-20993,
-28710,
-37221,
-45166,
-51212,
-54310,
-53953,
-50242,
-43932,
-36223,
-28584,
-22386,
-18709,
-18061,
-20364,
-24940,
-30719,
-36435,
-40930,
-43377,
-43429,
-41306,
-37675,
-33516,
-29869,
-27577,
-27111,
-28453,
-31119,
-34302,
-37078,
-38662,
-38609,
-36917,
-34067,
-30826,
-28117,
-26710,
-27055,
-29152,
-32545,
-36460,
-39968,
-42259,
-42787,
-41430,
-38465,
-34507,
-30335,
-26728,
-24287,
-23369,
-24021,
-26060,
-29122,
-32760,
-36522,
-39986,
-42783,
-44598,
-45180,
-44364,
-42109,
-38560,
-34052,
-29136,
-24497,
-20857,
-18841,
-18844,
-20926,
-24807,
-29861,
-35301,
-40246,
-43968,
-45932,
-45941,
-44109,
-40811,
-36651,
-32279,
-28398,
-25564,
-24211,
-24512,
-26403,
-29534,
-33334,
-37061,
-39980,
-41432,
-41115,
-39026,
-35654,
-31768,
-28329,
-26229,
-26052,
-27929,
-31456,
-35797,
-39860,
-42602,
-43274,
-41640,
-38048,
-33326,
-28621,
-25064,
-23533,
-24422,
-27551,
-32230,
-37399,
-41922,
-44772,
-45331,
-43423,
-39406,
-34033,
-28321,
-23331,
-19982,
-18883,
-20247,
-23846,
-29087,
-35091,
-40868,
-45467,
-48136,
-48450,
-46361,
-42253,
-36793,
-30934,
-25624,
-21748,
-19914,
-20340,
-22887,
-26971,
-31822,
-36492,
-40156,
-42195,
-42341,
-40715,
-37776,
-34194,
-30726,
-28014,
-26467,
-26214,
-27054,
-28601,
-30356,
-31859,
-32831,
-33172,
-33026,
-32675,
-32434,
-32584,
-33225,
-34285,
-35519,
-36550,
-37020,
-36627,
-35272,
-33060,
-30308,
-27502,
-25165,
-23814,
-23755,
-25131,
-27751,
-31257,
-35047,
-38529,
-41098,
-42376,
-42171,
-40581,
-37888,
-34555,
-31041,
-27793,
-25117,
-23199,
-22108,
-21847,
-22402,
-23767,
-25945,
-28901,
-32499,
-36490,
-40429,
-43813,
-46061,
-46750,
-45624,
-42788,
-38612,
-33775,
-29047,
-25190,
-22772,
-22064,
-23015,
-25266,
-28292,
-31477,
-34309,
-36412,
-37623,
-37991,
-37682,
-36981,
-36140,
-35402,
-34890,
-34645,
-34614,
-34649,
-34595,
-34279,
-33593,
-32518,
-31169,
-29756,
-28598,
-28006,
-28227,
-29375,
-31332,
-33806,
-36313,
-38326,
-39365,
-39118,
-37534,
-34837,
-31480,
-28100,
-25318,
-23708,
-23603,
-25091,
-27975,
-31799,
-35932,
-39672,
-42333,
-43435,
-42697,
-40233,
-36439,
-32024,
-27847,
-24724,
-23305,
-23826,
-26111,
-29542,
-33224,
-36208,
-37717,
-37416,
-35428,
-32423,
-29316,
-27125,
-26600,
-28037,
-31173,
-35227,
-39122,
-41750,
-42280,
-40379,
-36301,
-30836,
-25127,
-20379,
-17637,
-17496,
-20050,
-24855,
-31025,
-37463,
-43007,
-46680,
-47850,
-46291,
-42274,
-36456,
-29831,
-23508,
-18587,
-15897,
-15907,
-18578,
-23420,
-29517,
-35784,
-41090,
-44552,
-45652,
-44320,
-40950,
-36238,
-31086,
-26366,
-22840,
-20982,
-21035,
-22913,
-26340,
-30808,
-35713,
-40328,
-43952,
-45942,
-45840,
-43507,
-39159,
-33430,
-27296,
-21892,
-18329,
-17410,
-19435,
-24118,
-30581,
-37568,
-43685,
-47718,
-48920,
-47125,
-42835,
-37006,
-30925,
-25827,
-22723,
-22179,
-24206,
-28373,
-33784,
-39392,
-44063,
-46871,
-47196,
-44875,
-40236,
-34095,
-27587,
-22039,
-18629,
-18195,
-20968,
-26501,
-33699,
-41053,
-46930,
-49990,
-49485,
-45448,
-38743,
-30782,
-23307,
-17872,
-15587,
-16813,
-21168,
-27621,
-34783,
-41215,
-45727,
-47621,
-46725,
-43444,
-38529,
-33000,
-27831,
-23881,
-21667,
-21384,
-22828,
-25531,
-28801,
-31969,
-34424,
-35881,
-36290,
-35961,
-35356,
-34976,
-35201,
-36089,
-37423,
-38671,
-39219,
-38516,
-36313,
-32751,
-28405,
-24141,
-20932,
-19619,
-20659,
-24073,
-29319,
-35521,
-41524,
-46231,
-48738,
-48548,
-45624,
-40436,
-33833,
-26958,
-21023,
-17109,
-16000,
-17967,
-22756,
-29535,
-37091,
-43979,
-48876,
-50787,
-49313,
-44727,
-37917,
-30249,
-23230,
-18234,
-16214,
-17479,
-21705,
-27942,
-34874,
-41062,
-45243,
-46586,
-44851,
-40460,
-34377,
-27967,
-22651,
-19656,
-19683,
-22782,
-28262,
-34884,
-41078,
-45340,
-46575,
-44365,
-39108,
-31901,
-24344,
-18143,
-14726,
-14966,
-18915,
-25904,
-34578,
-43281,
-50291,
-54218,
-54214,
-50133,
-42595,
-32843,
-22596,
-13733,
-7975,
-6552,
-9953,
-17731,
-28608,
-40578,
-51373,
-58858,
-61505,
-58770,
-51158,
-40218,
-28121,
-17272,
-9724,
-6814,
-8877,
-15260,
-24485,
-34643,
-43755,
-50204,
-52978,
-51822,
-47215,
-40241,
-32337,
-25050,
-19742,
-17351,
-18260,
-22168,
-28227,
-35120,
-41402,
-45744,
-47248,
-45666,
-41397,
-35473,
-29238,
-24083,
-21116,
-20894,
-23368,
-27886,
-33405,
-38745,
-42819,
-44889,
-44619,
-42151,
-37977,
-32875,
-27739,
-23456,
-20800,
-20288,
-22140,
-26156,
-31767,
-38024,
-43792,
-47895,
-49419,
-47877,
-43417,
-36790,
-29273,
-22360,
-17502,
-15697,
-17346,
-22073,
-28871,
-36298,
-42786,
-47016,
-48144,
-45985,
-41034,
-34290,
-27119,
-20887,
-16777,
-15538,
-17359,
-21896,
-28285,
-35372,
-41870,
-46648,
-48882,
-48248,
-44951,
-39657,
-33402,
-27301,
-22407,
-19441,
-18714,
-20105,
-23104,
-27024,
-31114,
-34759,
-37583,
-39412,
-40331,
-40468,
-40025,
-39101,
-37760,
-36007,
-33870,
-31457,
-28975,
-26725,
-25064,
-24269,
-24546,
-25885,
-28132,
-30983,
-34068,
-37015,
-39520,
-41369,
-42411,
-42603,
-41906,
-40360,
-38054,
-35159,
-31970,
-28870,
-26306,
-24701,
-24345,
-25337,
-27504,
-30454,
-33634,
-36466,
-38483,
-39417,
-39281,
-38281,
-36811,
-35240,
-33904,
-32945,
-32360,
-32031,
-31767,
-31452,
-31032,
-30576,
-30229,
-30152,
-30481,
-31238,
-32367,
-33701,
-35026,
-36124,
-36804,
-36932,
-36462,
-35403,
-33854,
-31986,
-30019,
-28253,
-26983,
-26493,
-26984,
-28504,
-30947,
-34014,
-37280,
-40251,
-42463,
-43571,
-43396,
-41985,
-39518,
-36354,
-32861,
-29446,
-26440,
-24134,
-22732,
-22382,
-23152,
-25035,
-27885,
-31483,
-35412,
-39236,
-42416,
-44514,
-45203,
-44381,
-42178,
-38976,
-35276,
-31706,
-28757,
-26858,
-26133,
-26555,
-27827,
-29584,
-31406,
-32946,
-34002,
-34517,
-34614,
-34477,
-34349,
-34383,
-34647,
-35058,
-35447,
-35583,
-35293,
-34506,
-33318,
-31985,
-30860,
-30310,
-30592,
-31773,
-33668,
-35898,
-37916,
-39210,
-39377,
-38278,
-36073,
-33187,
-30223,
-27809,
-26440,
-26385,
-27571,
-29700,
-32221,
-34592,
-36312,
-37117,
-36999,
-36182,
-35107,
-34212,
-33915,
-34391,
-35608,
-37241,
-38820,
-39773,
-39638,
-38127,
-35284,
-31437,
-27218,
-23384,
-20691,
-19718,
-20730,
-23612,
-27898,
-32835,
-37587,
-41360,
-43600,
-44067,
-42872,
-40434,
-37341,
-34256,
-31712,
-30092,
-29488,
-29781,
-30653,
-31678,
-32462,
-32676,
-32183,
-31042,
-29491,
-27939,
-26809,
-26513,
-27285,
-29133,
-31837,
-34889,
-37725,
-39702,
-40374,
-39529,
-37276,
-34056,
-30496,
-27327,
-25160,
-24403,
-25116,
-27078,
-29787,
-32620,
-34990,
-36394,
-36618,
-35632,
-33693,
-31179,
-28594,
-26409,
-25051,
-24771,
-25686,
-27662,
-30438,
-33552,
-36514,
-38807,
-40057,
-40036,
-38792,
-36546,
-33730,
-30830,
-28304,
-26509,
-25605,
-25586,
-26305,
-27518,
-28983,
-30485,
-31856,
-33003,
-33849,
-34333,
-34434,
-34107,
-33413,
-32423,
-31312,
-30279,
-29521,
-29182,
-29306,
-29809,
-30540,
-31259,
-31786,
-31980,
-31822,
-31385,
-30804,
-30234,
-29794,
-29534,
-29461,
-29516,
-29678,
-29905,
-30247,
-30715,
-31377,
-32192,
-33120,
-34001,
-34692,
-35028,
-34921,
-34366,
-33441,
-32300,
-31103,
-30004,
-29073,
-28343,
-27772,
-27335,
-27005,
-26828,
-26874,
-27255,
-28044,
-29271,
-30863,
-32679,
-34502,
-36116,
-37310,
-37965,
-38008,
-37462,
-36378,
-34849,
-32973,
-30878,
-28716,
-26702,
-25079,
-24141,
-24115,
-25162,
-27237,
-30124,
-33376,
-36459,
-38777,
-39894,
-39578,
-37902,
-35242,
-32169,
-29357,
-27394,
-26680,
-27310,
-29119,
-31665,
-34426,
-36821,
-38429,
-38954,
-38353,
-36734,
-34370,
-31617,
-28839,
-26398,
-24566,
-23545,
-23410,
-24151,
-25633,
-27661,
-29997,
-32395,
-34644,
-36591,
-38131,
-39190,
-39747,
-39723,
-39093,
-37800,
-35861,
-33369,
-30516,
-27612,
-25006,
-23074,
-22088,
-22215,
-23425,
-25559,
-28310,
-31336,
-34274,
-36819,
-38735,
-39859,
-40118,
-39505,
-38109,
-36106,
-33760,
-31400,
-29365,
-27945,
-27295,
-27425,
-28147,
-29190,
-30218,
-30994,
-31411,
-31538,
-31602,
-31829,
-32447,
-33458,
-34724,
-35910,
-36618,
-36516,
-35434,
-33466,
-30934,
-28346,
-26250,
-25114,
-25228,
-26611,
-29077,
-32218,
-35543,
-38546,
-40764,
-41874,
-41688,
-40190,
-37552,
-34089,
-30268,
-26619,
-23685,
-21906,
-21579,
-22749,
-25248,
-28696,
-32571,
-36333,
-39468,
-41588,
-42483,
-42056,
-40448,
-37839,
-34594,
-31106,
-27816,
-25154,
-23465,
-22946,
-23623,
-25300,
-27640,
-30208,
-32599,
-34526,
-35879,
-36741,
-37298,
-37782,
-38305,
-38858,
-39218,
-39093,
-38154,
-36225,
-33335,
-29777,
-26064,
-22809,
-20617,
-19897,
-20838,
-23308,
-26950,
-31207,
-35466,
-39133,
-41733,
-42954,
-42691,
-41031,
-38281,
-34862,
-31349,
-28270,
-26141,
-25252,
-25715,
-27357,
-29805,
-32558,
-35071,
-36915,
-37812,
-37715,
-36755,
-35224,
-33449,
-31773,
-30435,
-29607,
-29338,
-29620,
-30355,
-31438,
-32697,
-33975,
-35115,
-35976,
-36500,
-36671,
-36575,
-36303,
-35981,
-35641,
-35260,
-34704,
-33790,
-32355,
-30336,
-27823,
-25127,
-22675,
-21008,
-20589,
-21714,
-24431,
-28463,
-33295,
-38224,
-42502,
-45496,
-46751,
-46110,
-43705,
-39916,
-35335,
-30616,
-26410,
-23261,
-21490,
-21218,
-22289,
-24359,
-26942,
-29526,
-31658,
-33069,
-33682,
-33639,
-33244,
-32863,
-32807,
-33273,
-34242,
-35507,
-36746,
-37554,
-37632,
-36819,
-35168,
-32962,
-30602,
-28591,
-27333,
-27122,
-27992,
-29783,
-32092,
-34446,
-36308,
-37291,
-37138,
-35875,
-33719,
-31118,
-28593,
-26691,
-25847,
-26302,
-28079,
-30937,
-34450,
-38052,
-41152,
-43231,
-43915,
-43066,
-40765,
-37326,
-33243,
-29064,
-25391,
-22682,
-21289,
-21312,
-22694,
-25140,
-28284,
-31647,
-34803,
-37381,
-39146,
-39990,
-39968,
-39212,
-37955,
-36433,
-34863,
-33407,
-32134,
-31042,
-30045,
-29059,
-27972,
-26801,
-25590,
-24556,
-23932,
-24015,
-24994,
-26952,
-29738,
-33016,
-36289,
-38983,
-40612,
-40853,
-39674,
-37323,
-34292,
-31209,
-28675,
-27140,
-26821,
-27612,
-29224,
-31166,
-32963,
-34215,
-34700,
-34400,
-33484,
-32228,
-30967,
-29984,
-29494,
-29574,
-30203,
-31244,
-32514,
-33792,
-34878,
-35625,
-35941,
-35844,
-35383,
-34714,
-33956,
-33244,
-32634,
-32125,
-31642,
-31105,
-30425,
-29603,
-28706,
-27908,
-27408,
-27425,
-28070,
-29365,
-31163,
-33221,
-35218,
-36841,
-37866,
-38151,
-37734,
-36708,
-35272,
-33620,
-31929,
-30328,
-28912,
-27734,
-26835,
-26277,
-26070,
-26277,
-26872,
-27834,
-29081,
-30503,
-31992,
-33424,
-34722,
-35794,
-36616,
-37123,
-37302,
-37125,
-36585,
-35729,
-34620,
-33388,
-32172,
-31110,
-30316,
-29815,
-29610,
-29583,
-29675,
-29750,
-29826,
-29888,
-30073,
-30473,
-31213,
-32321,
-33754,
-35356,
-36918,
-38197,
-39000,
-39204,
-38805,
-37897,
-36648,
-35268,
-33927,
-32769,
-31845,
-31163,
-30674,
-30337,
-30099,
-29964,
-29933,
-30043,
-30311,
-30752,
-31343,
-32052,
-32826,
-33623,
-34391,
-35113,
-35740,
-36243,
-36568,
-36638,
-36409,
-35819,
-34889,
-33661,
-32265,
-30858,
-29607,
-28680,
-28154,
-28064,
-28359,
-28937,
-29678,
-30472,
-31240,
-31947,
-32594,
-33180,
-33708,
-34150,
-34454,
-34571,
-34456,
-34116,
-33600,
-33000,
-32430,
-31981,
-31695,
-31562,
-31481,
-31354,
-31049,
-30520,
-29778,
-28939,
-28182,
-27713,
-27719,
-28302,
-29469,
-31090,
-32977,
-34843,
-36436,
-37531,
-37983,
-37763,
-36927,
-35608,
-34010,
-32329,
-30767,
-29480,
-28559,
-28055,
-27928,
-28130,
-28559,
-29128,
-29768,
-30427,
-31109,
-31813,
-32570,
-33376,
-34208,
-35002,
-35661,
-36086,
-36173,
-35881,
-35193,
-34177,
-32934,
-31602,
-30320,
-29227,
-28405,
-27928,
-27824,
-28077,
-28686,
-29571,
-30683,
-31900,
-33104,
-34152,
-34904,
-35261,
-35165,
-34654,
-33823,
-32852,
-31930,
-31252,
-30937,
-31020,
-31435,
-32017,
-32567,
-32879,
-32816,
-32342,
-31534,
-30580,
-29717,
-29184,
-29156,
-29677,
-30684,
-31960,
-33245,
-34240,
-34740,
-34626,
-33934,
-32844,
-31581,
-30464,
-29690,
-29429,
-29668,
-30308,
-31134,
-31923,
-32447,
-32596,
-32313,
-31700,
-30899,
-30109,
-29513,
-29245,
-29346,
-29795,
-30473,
-31234,
-31931,
-32423,
-32655,
-32606,
-32347,
-31977,
-31624,
-31407,
-31400,
-31635,
-32065,
-32594,
-33101,
-33438,
-33514,
-33272,
-32740,
-32024,
-31262,
-30638,
-30291,
-30311,
-30722,
-31429,
-32320,
-33203,
-33941,
-34414,
-34602,
-34534,
-34312,
-34055,
-33852,
-33761,
-33771,
-33805,
-33773,
-33583,
-33172,
-32566,
-31831,
-31101,
-30543,
-30279,
-30422,
-30975,
-31890,
-33038,
-34237,
-35302,
-36053,
-36363,
-36160,
-35471,
-34365,
-33024,
-31630,
-30412,
-29563,
-29219,
-29429,
-30149,
-31229,
-32461,
-33601,
-34435,
-34823,
-34712,
-34184,
-33365,
-32488,
-31726,
-31242,
-31106,
-31265,
-31641,
-32051,
-32356,
-32436,
-32246,
-31833,
-31298,
-30803,
-30503,
-30513,
-30902,
-31618,
-32574,
-33582,
-34464,
-35029,
-35174,
-34846,
-34112,
-33104,
-32005,
-31028,
-30320,
-30004,
-30085,
-30513,
-31170,
-31907,
-32603,
-33145,
-33495,
-33639,
-33606,
-33444,
-33182,
-32862,
-32496,
-32114,
-31737,
-31407,
-31177,
-31087,
-31176,
-31452,
-31881,
-32429,
-32996,
-33535,
-33944,
-34203,
-34251,
-34108,
-33764,
-33272,
-32684,
-32076,
-31557,
-31207,
-31131,
-31355,
-31879,
-32615,
-33427,
-34151,
-34638,
-34779,
-34575,
-34092,
-33481,
-32929,
-32574,
-32529,
-32760,
-33195,
-33666,
-34015,
-34128,
-33961,
-33565,
-33068,
-32620,
-32369,
-32398,
-32713,
-33261,
-33899,
-34514,
-34961,
-35169,
-35107,
-34796,
-34300,
-33698,
-33086,
-32543,
-32142,
-31939,
-31949,
-32184,
-32593,
-33121,
-33671,
-34151,
-34478,
-34593,
-34485,
-34181,
-33733,
-33230,
-32732,
-32314,
-32003,
-31826,
-31773,
-31856,
-32035,
-32327,
-32669,
-33038,
-33368,
-33576,
-33631,
-33456,
-33091,
-32554,
-31958,
-31399,
-30993,
-30809,
-30880,
-31165,
-31594,
-32054,
-32444,
-32688,
-32738,
-32614,
-32358,
-32043,
-31756,
-31555,
-31502,
-31607,
-31872,
-32256,
-32719,
-33181,
-33604,
-33898,
-34052,
-34024,
-33836,
-33519,
-33121,
-32714,
-32349,
-32083,
-31943,
-31936,
-32059,
-32286,
-32586,
-32926,
-33263,
-33561,
-33794,
-33927,
-33968,
-33920,
-33823,
-33729,
-33683,
-33733,
-33883,
-34111,
-34349,
-34518,
-34533,
-34337,
-33933,
-33362,
-32743,
-32196,
-31861,
-31821,
-32111,
-32671,
-33406,
-34148,
-34755,
-35093,
-35105,
-34786,
-34225,
-33518,
-32842,
-32294,
-32008,
-32007,
-32301,
-32815,
-33466,
-34121,
-34677,
-35035,
-35133,
-34964,
-34540,
-33939,
-33233,
-32531,
-31918,
-31472,
-31249,
-31263,
-31518,
-31959,
-32545,
-33182,
-33783,
-34268,
-34538,
-34568,
-34325,
-33847,
-33203,
-32493,
-31830,
-31319,
-31027,
-30972,
-31134,
-31427,
-31770,
-32067,
-32251,
-32312,
-32252,
-32149,
-32045,
-32019,
-32079,
-32223,
-32396,
-32533,
-32557,
-32427,
-32128,
-31692,
-31188,
-30710,
-30340,
-30164,
-30209,
-30483,
-30938,
-31506,
-32085,
-32593,
-32929,
-33056,
-32932,
-32587,
-32068,
-31467,
-30881,
-30429,
-30172,
-30180,
-30427,
-30877,
-31424,
-31960,
-32371,
-32581,
-32555,
-32321,
-31943,
-31531,
-31177,
-30972,
-30956,
-31116,
-31419,
-31775,
-32110,
-32352,
-32450,
-32400,
-32213,
-31945,
-31637,
-31379,
-31194,
-31159,
-31268,
-31524,
-31884,
-32277,
-32620,
-32821,
-32807,
-32547,
-32061,
-31432,
-30785,
-30257,
-29983,
-30017,
-30382,
-30974,
-31669,
-32289,
-32694,
-32791,
-32574,
-32110,
-31536,
-30988,
-30607,
-30443,
-30508,
-30727,
-31001,
-31223,
-31328,
-31285,
-31147,
-30969,
-30858,
-30872,
-31041,
-31353,
-31723,
-32078,
-32306,
-32354,
-32178,
-31815,
-31318,
-30792,
-30327,
-30024,
-29924,
-30058,
-30382,
-30836,
-31326,
-31752,
-32030,
-32102,
-31957,
-31620,
-31163,
-30676,
-30259,
-30000,
-29948,
-30122,
-30486,
-30975,
-31501,
-31961,
-32285,
-32403,
-32329,
-32058,
-31685,
-31262,
-30902,
-30659,
-30586,
-30683,
-30914,
-31223,
-31521,
-31744,
-31837,
-31789,
-31623,
-31393,
-31171,
-31019,
-30995,
-31099,
-31327,
-31628,
-31951,
-32237,
-32446,
-32557,
-32559,
-32467,
-32289,
-32039,
-31738,
-31406,
-31067,
-30768,
-30557,
-30476,
-30588,
-30871,
-31345,
-31913,
-32514,
-33026,
-33359,
-33450,
-33263,
-32853,
-32265,
-31638,
-31062,
-30649,
-30464,
-30512,
-30776,
-31179,
-31636,
-32053,
-32353,
-32491,
-32447,
-32255,
-31953,
-31611,
-31290,
-31041,
-30908,
-30892,
-31003,
-31200,
-31463,
-31750,
-32021,
-32253,
-32416,
-32500,
-32504,
-32442,
-32327,
-32201,
-32080,
-32001,
-31966,
-31968,
-31988,
-31979,
-31924,
-31784,
-31581,
-31341,
-31136,
-31031,
-31104,
-31379,
-31850,
-32467,
-33104,
-33675,
-34029,
-34127,
-33914,
-33460,
-32825,
-32144,
-31523,
-31051,
-30790,
-30729,
-30851,
-31083,
-31385,
-31680,
-31962,
-32183,
-32360,
-32474,
-32534,
-32537,
-32481,
-32379,
-32237,
-32088,
-31942,
-31832,
-31755,
-31705,
-31675,
-31622,
-31553,
-31446,
-31332,
-31234,
-31188,
-31230,
-31352,
-31553,
-31774,
-31967,
-32067,
-32053,
-31897,
-31664,
-31377,
-31146,
-31014,
-31048,
-31239,
-31578,
-31976,
-32376,
-32677,
-32818,
-32769,
-32517,
-32118,
-31616,
-31108,
-30658,
-30339,
-30190,
-30222,
-30410,
-30722,
-31089,
-31464,
-31787,
-32031,
-32176,
-32240,
-32226,
-32180,
-32105,
-32036,
-31963,
-31897,
-31829,
-31751,
-31682,
-31600,
-31555,
-31511,
-31522,
-31541,
-31596,
-31650,
-31705,
-31748,
-31767,
-31784,
-31770,
-31774,
-31750,
-31748,
-31724,
-31714,
-31699,
-31701,
-31716,
-31761,
-31818,
-31893,
-31949,
-31977,
-31953,
-31872,
-31753,
-31614,
-31516,
-31491,
-31578,
-31792,
-32108,
-32484,
-32852,
-33146,
-33294,
-33291,
-33114,
-32841,
-32513,
-32233,
-32059,
-32041,
-32175,
-32430,
-32723,
-32983,
-33128,
-33108,
-32936,
-32630,
-32283,
-31970,
-31781,
-31756,
-31911,
-32201,
-32574,
-32940,
-33248,
-33448,
-33544,
-33559,
-33537,
-33511,
-33506,
-33509,
-33496,
-33417,
-33249,
-32965,
-32603,
-32197,
-31830,
-31568,
-31456,
-31533,
-31751,
-32092,
-32456,
-32790,
-33021,
-33124,
-33079,
-32923,
-32672,
-32411,
-32163,
-32013,
-31971,
-32079,
-32313,
-32649,
-33020,
-33354,
-33574,
-33622,
-33475,
-33154,
-32736,
-32305,
-31979,
-31836,
-31913,
-32206,
-32626,
-33081,
-33453,
-33654,
-33643,
-33443,
-33109,
-32749,
-32446,
-32269,
-32247,
-32348,
-32527,
-32701,
-32818,
-32838,
-32767,
-32630,
-32485,
-32372,
-32341,
-32381,
-32493,
-32625,
-32744,
-32811,
-32797,
-32724,
-32590,
-32450,
-32326,
-32236,
-32210,
-32207,
-32242,
-32252,
-32249,
-32198,
-32128,
-32037,
-31971,
-31926,
-31932,
-31961,
-32002,
-32017,
-31989,
-31899,
-31780,
-31645,
-31557,
-31550,
-31640,
-31825,
-32061,
-32293,
-32458,
-32519,
-32463,
-32318,
-32151,
-32012,
-31970,
-32039,
-32199,
-32403,
-32577,
-32657,
-32622,
-32465,
-32240,
-32023,
-31867,
-31845,
-31946,
-32164,
-32432,
-32703,
-32910,
-33037,
-33070,
-33028,
-32931,
-32792,
-32615,
-32399,
-32141,
-31847,
-31555,
-31302,
-31153,
-31145,
-31300,
-31600,
-31982,
-32387,
-32713,
-32931,
-32999,
-32954,
-32842,
-32733,
-32680,
-32719,
-32849,
-33036,
-33262,
-33461,
-33647,
-33786,
-33916,
-34029,
-34147,
-34244,
-34301,
-34292,
-34190,
-34013,
-33786,
-33563,
-33412,
-33372,
-33474,
-33686,
-33977,
-34263,
-34493,
-34617,
-34624,
-34542,
-34409,
-34276,
-34178,
-34128,
-34105,
-34083,
-34013,
-33879,
-33673,
-33427,
-33176,
-32984,
-32886,
-32910,
-33039,
-33247,
-33470,
-33660,
-33764,
-33755,
-33640,
-33440,
-33202,
-32981,
-32821,
-32765,
-32825,
-32993,
-33244,
-33532,
-33802,
-34007,
-34096,
-34055,
-33871,
-33565,
-33177,
-32746,
-32343,
-32001,
-31775,
-31675,
-31710,
-31872,
-32108,
-32400,
-32667,
-32888,
-33008,
-33025,
-32940,
-32791,
-32632,
-32518,
-32502,
-32611,
-32830,
-33120,
-33406,
-33610,
-33664,
-33536,
-33243,
-32844,
-32441,
-32129,
-31997,
-32084,
-32374,
-32805,
-33275,
-33688,
-33953,
-34048,
-33962,
-33782,
-33549,
-33371,
-33267,
-33270,
-33336,
-33420,
-33451,
-33384,
-33195,
-32908,
-32566,
-32245,
-32012,
-31921,
-32008,
-32245,
-32610,
-33010,
-33394,
-33670,
-33809,
-33777,
-33606,
-33334,
-33033,
-32775,
-32610,
-32589,
-32697,
-32918,
-33196,
-33461,
-33674,
-33773,
-33771,
-33654,
-33477,
-33265,
-33060,
-32899,
-32783,
-32734,
-32733,
-32787,
-32881,
-33008,
-33160,
-33312,
-33453,
-33547,
-33585,
-33539,
-33429,
-33259,
-33061,
-32877,
-32706,
-32602,
-32529,
-32501,
-32506,
-32517,
-32563,
-32629,
-32738,
-32895,
-33085,
-33287,
-33458,
-33551,
-33532,
-33381,
-33111,
-32763,
-32393,
-32070,
-31841,
-31741,
-31776,
-31916,
-32131,
-32364,
-32577,
-32737,
-32819,
-32832,
-32765,
-32662,
-32515,
-32386,
-32281,
-32233,
-32274,
-32387,
-32587,
-32839,
-33107,
-33373,
-33593,
-33773,
-33911,
-34024,
-34135,
-34253,
-34373,
-34469,
-34503,
-34437,
-34248,
-33948,
-33560,
-33162,
-32818,
-32599,
-32544,
-32646,
-32873,
-33153,
-33407,
-33578,
-33613,
-33527,
-33343,
-33117,
-32912,
-32773,
-32734,
-32795,
-32947,
-33157,
-33393,
-33627,
-33826,
-33968,
-34039,
-34009,
-33882,
-33666,
-33374,
-33076,
-32808,
-32659,
-32659,
-32840,
-33173,
-33594,
-34013,
-34319,
-34434,
-34314,
-33968,
-33458,
-32889,
-32357,
-31976,
-31775,
-31774,
-31922,
-32137,
-32358,
-32493,
-32523,
-32443,
-32278,
-32086,
-31913,
-31806,
-31786,
-31870,
-32033,
-32270,
-32531,
-32799,
-33010,
-33157,
-33182,
-33093,
-32886,
-32590,
-32272,
-31985,
-31799,
-31758,
-31865,
-32105,
-32411,
-32714,
-32938,
-33044,
-33015,
-32873,
-32680,
-32474,
-32330,
-32250,
-32251,
-32305,
-32378,
-32456,
-32503,
-32554,
-32584,
-32645,
-32711,
-32796,
-32858,
-32890,
-32854,
-32767,
-32640,
-32517,
-32445,
-32479,
-32617,
-32884,
-33215,
-33583,
-33900,
-34136,
-34231,
-34198,
-34041,
-33802,
-33531,
-33275,
-33079,
-32969,
-32957,
-33028,
-33163,
-33316,
-33446,
-33510,
-33462,
-33302,
-33020,
-32656,
-32253,
-31871,
-31573,
-31408,
-31400,
-31548,
-31826,
-32173,
-32531,
-32825,
-33000,
-33031,
-32913,
-32682,
-32401,
-32134,
-31959,
-31925,
-32039,
-32296,
-32617,
-32943,
-33185,
-33291,
-33233,
-33028,
-32729,
-32400,
-32121,
-31931,
-31866,
-31904,
-32033,
-32199,
-32383,
-32555,
-32716,
-32854,
-32972,
-33052,
-33067,
-33002,
-32835,
-32579,
-32269,
-31969,
-31742,
-31656,
-31721,
-31934,
-32225,
-32518,
-32729,
-32792,
-32702,
-32476,
-32192,
-31931,
-31762,
-31735,
-31855,
-32087,
-32381,
-32681,
-32932,
-33125,
-33243,
-33311,
-33336,
-33338,
-33315,
-33268,
-33189,
-33083,
-32954,
-32832,
-32725,
-32669,
-32658,
-32699,
-32771,
-32859,
-32934,
-33000,
-33029,
-33047,
-33043,
-33036,
-33024,
-33001,
-32972,
-32917,
-32852,
-32757,
-32650,
-32528,
-32401,
-32276,
-32157,
-32060,
-31999,
-31978,
-32035,
-32143,
-32332,
-32551,
-32793,
-32994,
-33133,
-33154,
-33063,
-32853,
-32558,
-32225,
-31910,
-31669,
-31546,
-31564,
-31722,
-32001,
-32344,
-32712,
-33023,
-33251,
-33341,
-33304,
-33147,
-32921,
-32667,
-32454,
-32303,
-32249,
-32272,
-32352,
-32444,
-32501,
-32508,
-32439,
-32325,
-32189,
-32070,
-32019,
-32036,
-32140,
-32295,
-32468,
-32617,
-32695,
-32691,
-32600,
-32453,
-32298,
-32183,
-32161,
-32254,
-32460,
-32741,
-33045,
-33281,
-33399,
-33334,
-33094,
-32705,
-32252,
-31818,
-31523,
-31416,
-31554,
-31897,
-32397,
-32935,
-33421,
-33746,
-33868,
-33774,
-33507,
-33148,
-32791,
-32524,
-32421,
-32492,
-32735,
-33078,
-33448,
-33756,
-33930,
-33932,
-33761,
-33471,
-33121,
-32826,
-32639,
-32632,
-32795,
-33085,
-33419,
-33680,
-33787,
-33660,
-33313,
-32774,
-32166,
-31594,
-31184,
-31020,
-31120,
-31454,
-31944,
-32463,
-32921,
-33221,
-33336,
-33276,
-33099,
-32891,
-32727,
-32678,
-32765,
-32971,
-33254,
-33525,
-33724,
-33770,
-33650,
-33362,
-32968,
-32542,
-32183,
-31966,
-31954,
-32145,
-32507,
-32957,
-33391,
-33703,
-33817,
-33681,
-33324,
-32788,
-32188,
-31622,
-31203,
-31011,
-31070,
-31375,
-31857,
-32421,
-32957,
-33364,
-33552,
-33511,
-33232,
-32816,
-32344,
-31952,
-31747,
-31789,
-32104,
-32618,
-33244,
-33820,
-34232,
-34358,
-34171,
-33701,
-33046,
-32353,
-31768,
-31427,
-31398,
-31690,
-32249,
-32950,
-33684,
-34298,
-34710,
-34864,
-34756,
-34443,
-33997,
-33532,
-33126,
-32879,
-32813,
-32947,
-33246,
-33632,
-34039,
-34369,
-34559,
-34587,
-34438,
-34177,
-33853,
-33563,
-33365,
-33317,
-33416,
-33645,
-33939,
-34236,
-34474,
-34590,
-34594,
-34471,
-34283,
-34064,
-33870,
-33724,
-33633,
-33582,
-33515,
-33406,
-33192,
-32868,
-32446,
-31968,
-31516,
-31164,
-30993,
-31048,
-31332,
-31814,
-32400,
-33001,
-33501,
-33821,
-33918,
-33777,
-33459,
-33011,
-32543,
-32110,
-31788,
-31600,
-31553,
-31634,
-31803,
-32038,
-32289,
-32549,
-32772,
-32971,
-33113,
-33213,
-33256,
-33267,
-33229,
-33179,
-33101,
-33014,
-32911,
-32793,
-32655,
-32502,
-32340,
-32193,
-32075,
-32026,
-32043,
-32153,
-32327,
-32554,
-32795,
-33010,
-33182,
-33275,
-33311,
-33278,
-33216,
-33126,
-33037,
-32946,
-32850,
-32753,
-32637,
-32527,
-32421,
-32361,
-32363,
-32450,
-32630,
-32876,
-33169,
-33438,
-33659,
-33769,
-33773,
-33663,
-33479,
-33268,
-33062,
-32912,
-32813,
-32775,
-32766,
-32766,
-32750,
-32722,
-32684,
-32670,
-32705,
-32801,
-32980,
-33210,
-33465,
-33701,
-33867,
-33935,
-33883,
-33723,
-33472,
-33176,
-32883,
-32640,
-32488,
-32449,
-32532,
-32707,
-32955,
-33192,
-33392,
-33463,
-33408,
-33183,
-32852,
-32445,
-32066,
-31775,
-31650,
-31712,
-31952,
-32321,
-32729,
-33095,
-33325,
-33384,
-33243,
-32943,
-32542,
-32124,
-31777,
-31571,
-31547,
-31714,
-32050,
-32484,
-32955,
-33370,
-33666,
-33803,
-33766,
-33592,
-33332,
-33063,
-32872,
-32795,
-32885,
-33112,
-33442,
-33817,
-34158,
-34416,
-34554,
-34565,
-34470,
-34304,
-34113,
-33933,
-33805,
-33732,
-33740,
-33805,
-33925,
-34075,
-34214,
-34329,
-34361,
-34300,
-34135,
-33864,
-33553,
-33221,
-32964,
-32811,
-32805,
-32947,
-33185,
-33487,
-33754,
-33952,
-34032,
-33997,
-33880,
-33719,
-33580,
-33492,
-33477,
-33525,
-33593,
-33652,
-33651,
-33575,
-33422,
-33216,
-32997,
-32806,
-32676,
-32627,
-32651,
-32726,
-32810,
-32878,
-32890,
-32851,
-32757,
-32641,
-32539,
-32478,
-32499,
-32596,
-32777,
-33012,
-33282,
-33543,
-33779,
-33950,
-34056,
-34077,
-34013,
-33872,
-33662,
-33408,
-33147,
-32918,
-32762,
-32720,
-32796,
-32985,
-33248,
-33515,
-33736,
-33828,
-33785,
-33579,
-33272,
-32897,
-32545,
-32250,
-32067,
-31984,
-31999,
-32062,
-32154,
-32237,
-32312,
-32368,
-32425,
-32470,
-32519,
-32542,
-32558,
-32536,
-32519,
-32513,
-32559,
-32691,
-32910,
-33201,
-33526,
-33809,
-34001,
-34042,
-33932,
-33685,
-33371,
-33056,
-32816,
-32709,
-32738,
-32912,
-33162,
-33457,
-33726,
-33940,
-34070,
-34114,
-34075,
-33971,
-33812,
-33627,
-33424,
-33241,
-33085,
-33001,
-32976,
-33038,
-33145,
-33288,
-33416,
-33511,
-33556,
-33548,
-33532,
-33520,
-33570,
-33679,
-33861,
-34058,
-34246,
-34336,
-34314,
-34131,
-33843,
-33463,
-33106,
-32825,
-32709,
-32780,
-33045,
-33446,
-33916,
-34353,
-34669,
-34802,
-34715,
-34428,
-33986,
-33472,
-32986,
-32597,
-32394,
-32382,
-32571,
-32903,
-33313,
-33720,
-34044,
-34233,
-34264,
-34135,
-33900,
-33601,
-33316,
-33106,
-33010,
-33059,
-33246,
-33539,
-33894,
-34251,
-34547,
-34738,
-34783,
-34672,
-34425,
-34071,
-33669,
-33282,
-32966,
-32767,
-32713,
-32793,
-32987,
-33255,
-33531,
-33789,
-33970,
-34073,
-34091,
-34029,
-33926,
-33783,
-33635,
-33496,
-33369,
-33287,
-33246,
-33285,
-33402,
-33626,
-33932,
-34313,
-34708,
-35069,
-35328,
-35432,
-35355,
-35101,
-34702,
-34247,
-33796,
-33457,
-33280,
-33298,
-33504,
-33841,
-34222,
-34567,
-34767,
-34787,
-34587,
-34210,
-33721,
-33212,
-32803,
-32552,
-32544,
-32736,
-33120,
-33570,
-34010,
-34326,
-34465,
-34406,
-34187,
-33870,
-33560,
-33326,
-33232,
-33295,
-33487,
-33760,
-34047,
-34288,
-34442,
-34503,
-34463,
-34363,
-34209,
-34037,
-33855,
-33681,
-33524,
-33411,
-33350,
-33380,
-33488,
-33680,
-33911,
-34133,
-34281,
-34314,
-34196,
-33944,
-33602,
-33230,
-32913,
-32707,
-32649,
-32736,
-32942,
-33204,
-33472,
-33685,
-33818,
-33851,
-33804,
-33688,
-33544,
-33399,
-33285,
-33228,
-33245,
-33338,
-33501,
-33710,
-33928,
-34114,
-34231,
-34249,
-34183,
-34038,
-33878,
-33744,
-33693,
-33749,
-33917,
-34160,
-34434,
-34677,
-34839,
-34884,
-34805,
-34612,
-34336,
-34017,
-33686,
-33380,
-33114,
-32915,
-32780,
-32721,
-32729,
-32782,
-32872,
-32956,
-33013,
-33029,
-32983,
-32911,
-32824,
-32768,
-32779,
-32875,
-33059,
-33307,
-33579,
-33831,
-34008,
-34095,
-34054,
-33923,
-33702,
-33440,
-33175,
-32940,
-32770,
-32683,
-32681,
-32759,
-32894,
-33050,
-33197,
-33285,
-33305,
-33226,
-33082,
-32874,
-32665,
-32476,
-32341,
-32281,
-32282,
-32344,
-32438,
-32555,
-32686,
-32838,
-33012,
-33212,
-33426,
-33634,
-33794,
-33882,
-33871,
-33756,
-33574,
-33360,
-33177,
-33078,
-33084,
-33199,
-33393,
-33604,
-33784,
-33879,
-33871,
-33769,
-33601,
-33425,
-33280,
-33203,
-33206,
-33268,
-33373,
-33474,
-33555,
-33593,
-33591,
-33563,
-33523,
-33484,
-33457,
-33428,
-33403,
-33359,
-33310,
-33255,
-33210,
-33202,
-33224,
-33303,
-33400,
-33509,
-33581,
-33604,
-33555,
-33446,
-33305,
-33166,
-33080,
-33077,
-33168,
-33352,
-33591,
-33844,
-34069,
-34220,
-34278,
-34246,
-34123,
-33965,
-33779,
-33623,
-33509,
-33464,
-33482,
-33559,
-33660,
-33767,
-33831,
-33834,
-33756,
-33598,
-33393,
-33163,
-32969,
-32833,
-32779,
-32812,
-32879,
-32968,
-33012,
-33005,
-32935,
-32844,
-32761,
-32750,
-32832,
-33017,
-33268,
-33534,
-33740,
-33841,
-33806,
-33653,
-33420,
-33185,
-32995,
-32906,
-32923,
-33019,
-33162,
-33278,
-33343,
-33311,
-33195,
-33016,
-32795,
-32595,
-32425,
-32332,
-32319,
-32392,
-32542,
-32739,
-32960,
-33144,
-33264,
-33267,
-33157,
-32937,
-32669,
-32415,
-32262,
-32265,
-32450,
-32794,
-33220,
-33637,
-33937,
-34049,
-33939,
-33642,
-33218,
-32778,
-32409,
-32186,
-32140,
-32256,
-32493,
-32790,
-33085,
-33337,
-33509,
-33606,
-33602,
-33537,
-33388,
-33199,
-32979,
-32767,
-32607,
-32538,
-32583,
-32755,
-33032,
-33360,
-33701,
-33959,
-34126,
-34144,
-34044,
-33838,
-33575,
-33293,
-33025,
-32791,
-32595,
-32440,
-32330,
-32252,
-32235,
-32262,
-32357,
-32507,
-32697,
-32911,
-33112,
-33287,
-33399,
-33449,
-33417,
-33323,
-33172,
-32986,
-32802,
-32637,
-32538,
-32517,
-32585,
-32738,
-32936,
-33144,
-33308,
-33388,
-33369,
-33257,
-33090,
-32915,
-32789,
-32732,
-32775,
-32859,
-32977,
-33042,
-33040,
-32947,
-32779,
-32595,
-32438,
-32369,
-32408,
-32563,
-32785,
-33045,
-33270,
-33433,
-33505,
-33495,
-33412,
-33289,
-33151,
-33007,
-32883,
-32782,
-32729,
-32741,
-32842,
-33039,
-33322,
-33663,
-33989,
-34239,
-34337,
-34240,
-33956,
-33526,
-33033,
-32599,
-32291,
-32210,
-32333,
-32648,
-33055,
-33468,
-33782,
-33948,
-33933,
-33771,
-33506,
-33214,
-32956,
-32781,
-32708,
-32733,
-32827,
-32960,
-33082,
-33167,
-33185,
-33130,
-33004,
-32823,
-32621,
-32429,
-32286,
-32217,
-32223,
-32308,
-32426,
-32555,
-32638,
-32664,
-32613,
-32512,
-32382,
-32276,
-32215,
-32237,
-32313,
-32448,
-32584,
-32707,
-32791,
-32818,
-32826,
-32791,
-32772,
-32738,
-32705,
-32652,
-32557,
-32421,
-32243,
-32045,
-31856,
-31715,
-31626,
-31615,
-31656,
-31732,
-31821,
-31891,
-31946,
-31985,
-32020,
-32070,
-32134,
-32202,
-32265,
-32285,
-32256,
-32165,
-32023,
-31870,
-31735,
-31668,
-31690,
-31814,
-32027,
-32290,
-32564,
-32796,
-32951,
-33003,
-32951,
-32805,
-32605,
-32373,
-32181,
-32033,
-31997,
-32057,
-32232,
-32486,
-32790,
-33091,
-33345,
-33505,
-33547,
-33463,
-33269,
-32999,
-32695,
-32411,
-32176,
-32031,
-31970,
-32002,
-32093,
-32226,
-32358,
-32482,
-32555,
-32594,
-32585,
-32545,
-32498,
-32453,
-32435,
-32453,
-32508,
-32585,
-32678,
-32746,
-32775,
-32737,
-32623,
-32436,
-32195,
-31935,
-31692,
-31516,
-31440,
-31474,
-31634,
-31868,
-32148,
-32411,
-32597,
-32672,
-32618,
-32450,
-32211,
-31963,
-31769,
-31677,
-31721,
-31884,
-32136,
-32420,
-32669,
-32840,
-32891,
-32834,
-32680,
-32482,
-32277,
-32112,
-32019,
-31994,
-32056,
-32156,
-32297,
-32435,
-32545,
-32623,
-32634,
-32596,
-32512,
-32402,
-32303,
-32237,
-32235,
-32303,
-32435,
-32586,
-32725,
-32785,
-32740,
-32577,
-32307,
-31993,
-31688,
-31469,
-31380,
-31441,
-31629,
-31900,
-32178,
-32404,
-32525,
-32529,
-32414,
-32234,
-32020,
-31828,
-31705,
-31650,
-31699,
-31810,
-31984,
-32186,
-32382,
-32555,
-32664,
-32699,
-32650,
-32522,
-32352,
-32168,
-32037,
-31984,
-32061,
-32236,
-32511,
-32798,
-33057,
-33204,
-33212,
-33076,
-32821,
-32529,
-32244,
-32057,
-31982,
-32032,
-32168,
-32330,
-32463,
-32514,
-32468,
-32343,
-32173,
-32031,
-31937,
-31951,
-32030,
-32175,
-32299,
-32376,
-32343,
-32211,
-31989,
-31733,
-31489,
-31317,
-31232,
-31240,
-31310,
-31395,
-31471,
-31494,
-31491,
-31460,
-31447,
-31482,
-31563,
-31702,
-31851,
-31975,
-32040,
-32027,
-31939,
-31820,
-31703,
-31647,
-31676,
-31798,
-31994,
-32227,
-32453,
-32628,
-32736,
-32756,
-32704,
-32585,
-32421,
-32225,
-32010,
-31800,
-31612,
-31485,
-31435,
-31496,
-31649,
-31888,
-32149,
-32386,
-32535,
-32566,
-32473,
-32284,
-32066,
-31866,
-31772,
-31778,
-31920,
-32127,
-32373,
-32580,
-32706,
-32738,
-32655,
-32515,
-32330,
-32159,
-32034,
-31982,
-32015,
-32144,
-32345,
-32608,
-32897,
-33168,
-33386,
-33509,
-33516,
-33416,
-33229,
-33013,
-32827,
-32723,
-32741,
-32874,
-33096,
-33345,
-33559,
-33674,
-33678,
-33549,
-33351,
-33116,
-32913,
-32781,
-32742,
-32781,
-32875,
-32978,
-33045,
-33063,
-33004,
-32902,
-32769,
-32652,
-32585,
-32596,
-32701,
-32889,
-33141,
-33410,
-33647,
-33811,
-33856,
-33777,
-33588,
-33323,
-33054,
-32828,
-32711,
-32712,
-32840,
-33045,
-33268,
-33458,
-33537,
-33511,
-33350,
-33110,
-32825,
-32560,
-32350,
-32237,
-32220,
-32297,
-32448,
-32638,
-32846,
-33042,
-33194,
-33302,
-33329,
-33297,
-33200,
-33067,
-32927,
-32812,
-32762,
-32786,
-32899,
-33072,
-33276,
-33472,
-33603,
-33651,
-33587,
-33419,
-33178,
-32900,
-32642,
-32457,
-32387,
-32460,
-32681,
-33013,
-33419,
-33806,
-34122,
-34279,
-34257,
-34057,
-33710,
-33317,
-32946,
-32701,
-32627,
-32731,
-32985,
-33300,
-33598,
-33792,
-33834,
-33721,
-33484,
-33195,
-32919,
-32731,
-32650,
-32692,
-32822,
-32999,
-33191,
-33342,
-33458,
-33512,
-33526,
-33502,
-33442,
-33372,
-33273,
-33182,
-33091,
-33033,
-33010,
-33039,
-33101,
-33186,
-33260,
-33299,
-33285,
-33216,
-33117,
-33004,
-32930,
-32900,
-32933,
-33006,
-33095,
-33152,
-33161,
-33090,
-32963,
-32797,
-32645,
-32538,
-32522,
-32591,
-32755,
-32966,
-33196,
-33399,
-33540,
-33607,
-33593,
-33512,
-33392,
-33256,
-33125,
-33023,
-32941,
-32891,
-32842,
-32798,
-32734,
-32664,
-32585,
-32527,
-32504,
-32543,
-32648,
-32811,
-33005,
-33192,
-33329,
-33381,
-33332,
-33189,
-32985,
-32771,
-32598,
-32507,
-32516,
-32627,
-32796,
-32991,
-33143,
-33228,
-33209,
-33112,
-32937,
-32762,
-32594,
-32514,
-32515,
-32615,
-32795,
-33013,
-33233,
-33405,
-33496,
-33486,
-33382,
-33196,
-32980,
-32759,
-32595,
-32508,
-32511,
-32612,
-32765,
-32968,
-33160,
-33330,
-33450,
-33516,
-33531,
-33506,
-33448,
-33374,
-33283,
-33196,
-33109,
-33051,
-33018,
-33028,
-33077,
-33154,
-33236,
-33301,
-33316,
-33271,
-33169,
-33024,
-32879,
-32766,
-32713,
-32744,
-32837,
-32977,
-33118,
-33223,
-33277,
-33261,
-33204,
-33116,
-33043,
-32991,
-32977,
-32986,
-33004,
-33016,
-33014,
-33002,
-33007,
-33043,
-33143,
-33304,
-33515,
-33739,
-33929,
-34037,
-34037,
-33914,
-33693,
-33411,
-33127,
-32890,
-32745,
-32699,
-32746,
-32863,
-33000,
-33132,
-33222,
-33269,
-33274,
-33259,
-33239,
-33238,
-33257,
-33294,
-33333,
-33355,
-33345,
-33289,
-33201,
-33076,
-32954,
-32838
+static const uint8_t ouch48k_wav_data[11734] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+240,127,36,168,189,171,32,34,1,40,84,52,130,185,155,32,
+67,128,186,171,16,84,68,52,21,130,160,152,169,189,175,155,
+40,50,145,235,10,84,52,129,218,187,9,18,2,169,139,48,
+51,192,203,24,99,16,203,154,66,36,200,188,41,87,35,161,
+219,154,65,67,18,169,169,16,34,145,187,137,36,3,217,155,
+49,53,168,190,42,102,83,17,136,137,128,17,128,169,144,19,
+2,202,170,80,67,160,189,140,84,54,35,168,190,171,25,49,
+18,201,171,80,70,51,1,170,154,49,52,168,207,171,9,66,
+36,2,128,137,153,152,34,85,52,52,17,169,221,219,170,154,
+136,144,152,0,68,53,18,1,136,0,169,237,203,154,24,33,
+8,153,24,160,239,188,139,64,52,35,169,204,171,9,99,69,
+50,145,220,188,137,50,38,18,169,203,153,24,33,50,67,18,
+168,189,156,24,52,35,2,0,152,220,173,155,65,52,18,200,
+186,154,8,136,10,114,52,19,202,188,25,84,51,128,219,187,
+170,8,34,68,67,33,136,154,9,48,17,153,140,25,19,2,
+155,31,41,33,0,140,11,18,51,178,235,153,67,52,216,239,
+188,154,8,19,146,202,154,99,53,51,128,128,2,145,222,172,
+10,82,67,1,169,153,16,34,144,202,144,51,2,217,169,49,
+20,193,203,40,53,163,239,203,170,0,18,8,154,136,18,1,
+169,185,19,20,153,157,8,21,146,233,168,4,5,176,188,25,
+103,52,50,128,152,9,8,128,57,116,69,35,145,187,155,116,
+36,146,235,188,9,82,35,160,205,170,24,52,2,201,188,9,
+82,35,176,220,155,24,83,18,160,219,155,8,67,36,18,136,
+154,25,49,2,251,190,171,40,83,129,221,189,155,48,71,52,
+50,129,184,204,187,170,24,34,36,2,144,186,186,171,186,187,
+25,118,68,51,18,152,219,186,171,187,155,32,68,35,152,170,
+25,67,2,218,171,64,68,2,144,24,52,19,250,204,170,153,
+152,137,24,51,3,251,173,138,24,136,8,83,54,18,186,157,
+40,34,250,205,138,32,18,168,188,24,68,2,136,96,69,19,
+218,189,138,49,36,129,136,33,3,251,175,9,66,2,201,156,
+64,68,129,219,138,82,130,255,191,187,10,114,68,51,3,144,
+204,188,171,24,67,51,34,128,0,49,34,200,223,203,171,10,
+65,68,36,18,144,219,203,154,9,34,52,51,1,185,205,188,
+155,8,99,83,35,17,168,203,187,154,0,34,50,50,66,51,
+34,160,207,189,172,155,9,48,52,53,51,35,18,144,219,205,
+188,187,154,65,68,36,129,186,190,171,10,66,53,36,19,128,
+169,170,170,170,153,137,33,99,52,50,0,235,204,188,171,25,
+83,53,36,1,185,188,172,138,33,53,52,18,152,235,219,187,
+171,138,65,85,67,35,1,184,188,188,154,8,33,67,34,17,
+136,169,203,205,203,154,40,84,53,51,19,145,202,189,187,170,
+185,204,141,8,40,119,35,0,0,185,171,171,188,139,128,120,
+69,35,0,0,203,188,170,137,40,68,52,35,129,169,189,172,
+171,153,16,67,83,35,35,2,185,205,188,186,136,50,52,52,
+18,0,169,171,155,153,169,202,171,48,71,36,18,128,154,203,
+187,138,115,71,36,18,168,204,189,173,11,136,48,71,35,0,
+170,172,137,49,51,18,169,205,171,171,152,128,169,203,10,116,
+69,36,3,128,176,188,171,8,49,37,19,160,221,188,186,137,
+48,83,67,18,152,202,171,25,84,67,1,185,190,172,138,50,
+69,50,128,202,188,155,32,68,35,19,128,168,187,155,40,69,
+35,200,189,155,49,37,160,207,173,128,8,115,67,0,0,201,
+173,137,49,53,1,128,204,187,8,136,65,52,36,0,160,205,
+187,136,0,68,51,34,0,186,188,155,8,34,130,251,204,171,
+8,72,69,36,18,0,160,169,153,168,235,219,203,8,136,113,
+67,51,0,176,205,155,8,67,36,18,168,204,170,137,50,52,
+51,17,1,152,251,190,173,9,24,68,51,2,128,204,219,154,
+0,53,21,0,201,172,25,82,19,128,128,173,138,16,17,144,
+219,187,8,120,83,19,0,168,190,171,16,84,19,0,200,187,
+171,137,8,32,68,68,2,160,154,25,68,20,0,160,188,187,
+189,173,136,128,116,51,2,0,192,205,154,8,24,69,34,0,
+8,0,8,202,204,187,139,128,33,68,68,35,1,184,221,187,
+10,136,64,54,51,0,0,202,187,203,187,11,136,32,68,52,
+69,51,128,0,222,172,137,128,64,52,4,0,160,189,172,128,
+8,24,33,67,52,35,2,0,169,205,204,155,24,83,35,161,
+235,172,10,136,66,53,52,8,144,189,171,153,136,0,49,68,
+36,129,201,188,187,139,32,70,67,18,136,154,32,68,35,8,
+8,0,0,254,191,138,128,72,52,18,128,128,220,188,8,136,
+69,19,152,188,138,65,52,0,8,190,156,0,67,35,0,202,
+188,154,0,83,36,18,144,219,172,138,48,69,19,0,201,173,
+154,0,34,50,129,168,187,139,81,69,67,2,128,235,187,156,
+9,33,19,160,220,171,16,100,67,34,1,169,189,188,154,49,
+84,35,18,136,153,169,188,189,188,138,24,83,68,51,19,144,
+221,172,154,32,52,37,1,169,219,171,8,65,36,18,184,219,
+155,24,67,51,130,218,204,170,32,100,51,129,0,220,203,138,
+8,50,52,34,128,185,154,138,16,17,1,0,168,205,172,9,
+100,52,35,185,206,203,153,17,67,50,1,185,187,9,115,51,
+145,235,188,170,136,33,52,69,51,19,0,8,66,0,8,255,
+175,10,136,32,51,51,35,1,186,207,187,139,48,53,35,128,
+154,9,82,51,1,202,187,26,83,35,217,207,203,138,0,83,
+52,35,128,202,188,170,16,67,35,129,185,171,25,50,36,145,
+236,188,171,40,100,52,34,144,218,187,171,25,34,52,34,128,
+169,203,170,138,8,33,67,83,52,35,19,152,220,203,187,9,
+67,37,2,251,205,187,138,81,84,51,18,144,203,187,170,24,
+17,2,128,153,24,83,51,176,223,204,170,24,68,68,34,0,
+186,204,171,138,33,52,52,17,168,188,172,137,48,52,19,184,
+222,171,10,98,53,51,1,185,205,170,137,128,0,144,152,16,
+99,67,35,128,235,203,170,24,83,52,35,18,169,220,203,155,
+137,33,67,34,34,17,184,207,205,170,25,99,68,50,129,185,
+205,186,153,33,83,51,35,1,184,236,203,154,32,69,36,2,
+200,220,187,8,136,84,51,131,144,188,172,10,32,34,1,168,
+138,80,84,51,2,202,173,139,24,18,160,237,203,136,16,69,
+36,2,152,219,171,138,50,52,35,144,187,173,137,32,33,129,
+186,173,138,81,69,51,3,169,190,203,154,24,33,51,51,18,
+136,219,219,171,138,49,85,51,18,144,186,172,153,16,17,17,
+152,136,32,160,255,207,187,155,48,71,67,18,129,169,170,137,
+0,136,202,203,154,33,52,2,218,188,154,66,68,18,152,170,
+8,68,36,160,221,188,139,49,55,36,130,201,204,171,138,16,
+68,52,35,130,185,204,171,138,24,18,2,129,136,136,169,202,
+203,153,98,85,67,19,145,203,188,155,24,67,52,18,184,207,
+204,171,137,65,83,51,19,129,169,186,171,9,0,1,0,33,
+54,36,128,137,114,55,19,249,205,188,8,136,84,67,1,128,
+176,173,155,137,16,35,35,19,34,34,2,217,221,203,154,40,
+83,51,128,235,203,138,65,68,35,130,202,188,171,8,50,52,
+18,152,171,154,49,53,19,184,190,171,48,55,18,233,205,187,
+9,97,67,51,129,185,188,155,9,33,35,1,186,173,137,83,
+53,20,128,203,188,170,40,67,52,2,184,205,187,170,16,82,
+67,35,19,129,186,189,187,155,16,50,51,51,67,67,34,129,
+218,219,186,188,206,220,186,137,98,53,52,17,153,188,170,24,
+82,50,1,185,204,172,154,8,16,50,66,35,18,184,221,187,
+138,81,52,36,17,128,152,169,220,189,188,138,40,83,51,19,
+128,33,85,52,3,234,205,171,138,48,67,36,2,128,186,219,
+171,153,32,83,51,36,51,50,34,144,251,221,219,170,138,40,
+34,67,50,83,50,17,185,189,187,154,8,16,67,52,19,8,
+115,87,51,0,249,204,186,137,8,49,68,67,19,128,204,187,
+171,0,34,34,66,83,52,18,168,204,172,171,169,186,186,137,
+99,85,67,35,1,185,189,172,138,0,50,50,17,128,136,8,
+1,144,205,189,156,41,115,52,51,145,251,188,156,9,49,53,
+51,129,169,204,170,137,16,33,34,33,33,83,35,1,235,189,
+172,138,40,66,34,129,202,172,138,50,55,35,129,185,188,171,
+136,33,35,2,169,170,64,87,67,19,144,220,203,171,153,136,
+152,187,172,24,87,69,35,18,168,204,172,153,24,17,18,16,
+0,50,68,52,19,160,237,204,219,170,137,49,54,36,19,129,
+168,170,155,154,154,171,170,32,85,36,18,168,188,170,32,34,
+177,207,203,8,98,52,50,17,168,202,204,187,187,155,25,82,
+69,37,51,2,168,204,188,186,170,8,66,52,36,18,0,136,
+136,152,235,204,203,170,9,66,68,51,34,16,0,33,19,184,
+255,188,189,187,8,96,68,51,18,144,186,188,187,153,16,52,
+36,1,24,84,53,3,232,205,172,136,128,65,51,51,18,144,
+220,203,153,16,50,17,153,154,48,70,51,130,218,189,188,155,
+25,49,52,67,34,34,34,129,185,205,172,171,138,24,51,35,
+1,203,187,41,102,68,34,160,236,219,170,8,66,68,35,1,
+185,219,171,137,17,51,19,128,169,40,115,67,1,202,206,172,
+171,8,50,53,52,35,17,128,169,219,172,187,154,8,50,52,
+50,17,144,152,136,168,221,205,170,24,68,37,19,152,186,171,
+9,34,3,217,189,139,114,54,37,18,152,205,188,203,170,128,
+56,84,67,34,18,0,153,170,170,172,203,171,171,16,85,68,
+19,144,220,204,170,8,67,53,35,1,169,172,154,24,1,144,
+235,188,139,48,70,67,1,152,203,171,138,32,50,35,0,136,
+40,99,67,2,201,205,188,187,136,66,53,36,18,136,186,203,
+187,187,153,40,99,68,67,51,35,152,206,189,203,153,16,83,
+67,18,129,168,169,153,136,185,221,203,153,65,84,51,18,152,
+188,188,154,24,33,18,17,82,85,67,2,202,190,188,171,8,
+33,53,52,35,130,152,154,9,136,202,205,187,25,84,53,35,
+168,206,188,11,136,81,52,18,144,202,154,16,67,51,161,220,
+188,138,48,69,34,128,202,188,154,25,49,51,18,144,138,48,
+71,36,3,168,205,187,187,137,17,33,35,50,34,18,144,202,
+189,187,24,100,67,35,0,153,8,49,18,200,204,171,153,251,
+239,203,171,8,112,83,50,17,168,170,155,24,67,18,184,207,
+171,138,65,67,34,152,202,187,137,48,51,18,152,137,115,54,
+52,1,201,204,170,138,16,0,168,203,138,82,85,50,1,185,
+204,154,40,67,19,200,220,171,9,83,68,18,152,185,154,40,
+68,18,201,206,203,154,24,83,67,18,8,137,24,66,67,129,
+218,189,172,138,16,51,34,152,202,170,32,69,52,34,128,154,
+170,136,1,168,222,204,170,137,66,52,51,1,169,188,187,137,
+49,50,17,153,26,100,54,52,18,168,219,203,154,137,152,203,
+189,188,153,32,51,53,67,68,51,37,51,18,144,220,204,203,
+170,154,136,33,67,51,129,202,188,155,40,99,52,52,51,19,
+17,34,51,161,255,173,137,66,52,145,236,188,140,8,56,68,
+35,18,152,188,154,48,70,34,168,205,187,9,65,52,34,152,
+204,203,170,24,50,36,18,136,136,48,69,36,19,128,235,188,
+187,155,0,17,128,203,172,24,84,53,36,18,136,170,170,136,
+1,160,205,189,156,137,34,52,35,128,186,172,8,68,68,18,
+136,170,155,32,68,35,168,222,172,171,9,50,52,19,144,202,
+187,9,49,53,35,129,153,24,85,68,51,2,201,204,187,137,
+32,2,233,222,203,155,24,83,53,50,17,8,8,49,52,3,
+234,206,203,170,137,33,34,17,129,32,82,53,36,18,152,219,
+187,171,154,153,169,203,154,32,100,83,35,51,51,34,128,235,
+205,188,187,170,136,17,33,66,68,69,67,35,2,152,202,186,
+154,170,220,205,187,156,9,50,68,35,34,33,51,69,50,1,
+201,189,188,171,138,128,129,144,136,33,68,52,18,128,153,9,
+50,36,145,202,155,80,85,35,145,234,188,170,8,0,200,221,
+203,155,24,83,67,50,18,51,84,51,34,160,236,203,187,154,
+153,153,170,171,154,48,70,52,52,50,51,51,51,36,18,144,
+186,206,188,204,187,172,170,154,152,136,136,49,86,68,67,51,
+36,34,18,136,203,205,188,186,154,154,186,219,155,25,100,52,
+67,17,0,0,49,68,18,168,206,188,186,137,8,128,153,170,
+40,85,53,51,17,128,137,32,50,129,238,204,203,153,16,33,
+18,144,137,64,101,83,51,34,1,185,220,219,187,203,186,170,
+154,8,65,85,68,51,36,18,128,136,153,153,202,204,219,171,
+171,153,152,152,153,24,84,69,52,51,35,33,32,16,144,218,
+204,172,170,137,169,204,220,186,138,32,68,51,18,0,33,100,
+52,36,2,184,219,186,137,8,152,220,204,186,138,16,50,35,
+18,34,84,84,51,51,129,169,203,171,171,188,220,187,172,137,
+16,35,17,136,8,115,84,51,35,129,168,137,32,67,2,251,
+189,187,9,66,35,176,223,203,170,24,49,34,144,154,72,87,
+68,51,17,152,186,170,24,17,184,223,204,187,154,8,33,17,
+1,16,99,69,83,34,18,136,153,154,154,170,204,220,187,187,
+154,16,34,18,18,66,84,53,52,35,1,152,170,170,153,202,
+205,189,188,154,8,34,50,17,16,33,70,52,35,2,169,187,
+137,66,52,129,235,188,172,136,16,129,202,189,172,137,32,51,
+17,128,32,86,68,51,18,136,153,16,67,35,144,206,188,171,
+154,169,237,204,188,170,8,49,51,51,67,69,68,67,35,18,
+0,8,24,50,19,250,206,205,187,171,138,24,0,168,170,24,
+117,68,52,35,1,144,8,17,67,34,168,207,188,188,170,154,
+152,152,154,153,48,101,83,36,35,19,1,1,16,1,128,235,
+205,203,171,154,153,153,186,186,25,100,68,36,34,18,32,33,
+51,35,160,221,189,187,170,154,170,218,187,171,25,68,53,67,
+33,17,50,68,52,34,145,186,189,171,137,128,202,191,189,172,
+153,0,18,0,136,0,115,84,67,35,18,129,128,0,1,144,
+251,220,187,187,154,153,168,219,171,137,115,52,52,19,18,32,
+50,69,34,129,202,204,171,154,152,169,220,188,187,137,32,36,
+35,1,16,99,69,36,35,0,136,136,32,50,129,235,189,173,
+171,170,219,219,187,171,9,33,35,36,68,69,68,51,51,18,
+128,0,0,128,235,221,203,187,171,169,170,202,186,137,82,84,
+67,51,51,36,67,50,34,128,186,190,188,203,203,187,188,171,
+154,8,33,52,52,52,52,52,37,51,34,0,153,186,187,204,
+219,203,187,172,153,153,153,169,154,32,85,52,34,129,137,48,
+102,52,35,2,153,9,81,52,35,168,222,203,170,154,169,218,
+188,188,154,25,50,53,52,52,52,68,50,35,35,17,152,219,
+189,204,186,187,203,203,187,170,137,65,68,67,50,50,67,52,
+53,35,18,152,219,203,171,203,203,219,203,170,153,32,50,52,
+51,83,68,52,52,34,129,168,203,170,171,188,206,219,171,170,
+24,33,51,35,34,99,84,83,50,18,128,152,137,136,152,236,
+188,189,170,138,136,144,169,154,56,87,52,51,19,128,0,65,
+67,18,201,205,188,154,9,0,169,204,172,137,66,53,51,1,
+152,9,82,68,35,160,220,203,154,8,17,136,204,188,138,48,
+54,36,17,128,24,99,52,20,145,218,203,154,8,8,202,221,
+187,154,33,68,50,0,152,24,115,53,36,17,153,170,154,17,
+17,184,223,203,170,9,16,1,153,203,138,81,84,51,34,128,
+153,24,83,67,1,201,189,187,138,8,128,203,190,171,9,83,
+52,34,0,136,32,84,52,18,160,219,187,154,8,152,251,219,
+171,137,33,52,35,17,17,84,84,51,35,128,185,203,187,170,
+204,220,219,171,170,136,34,51,34,34,98,84,52,52,35,1,
+136,136,8,1,168,237,188,173,171,153,137,153,186,171,154,82,
+84,67,35,19,35,67,83,35,34,128,186,189,203,171,203,203,
+188,188,171,154,16,34,51,1,136,48,87,68,67,17,152,186,
+154,32,52,130,236,189,171,9,50,36,128,203,170,97,69,52,
+18,168,203,156,8,34,129,252,204,187,154,17,51,18,152,187,
+57,119,52,51,17,144,136,65,68,35,129,235,203,171,153,0,
+168,236,219,170,137,49,51,35,136,153,48,102,67,51,17,152,
+154,8,50,35,201,222,203,171,153,0,129,185,204,155,25,99,
+67,18,129,152,25,66,53,20,145,202,203,170,0,50,129,234,
+188,172,24,67,53,34,17,8,16,50,37,19,184,207,204,187,
+170,154,153,186,204,188,153,65,54,53,51,35,50,83,68,51,
+34,128,202,187,187,153,186,221,220,187,187,154,137,137,170,170,
+9,115,68,36,35,18,33,50,69,51,34,128,185,186,153,136,
+217,221,204,187,187,138,137,153,186,172,9,66,53,52,34,1,
+33,68,52,36,2,152,170,154,24,17,185,207,203,153,49,86,
+67,35,19,128,170,9,83,53,2,251,190,188,170,136,128,185,
+206,172,154,32,69,35,18,0,24,99,84,35,19,128,153,153,
+17,35,145,236,189,172,154,137,152,201,204,187,155,0,51,36,
+1,136,32,85,68,51,34,17,128,17,51,52,130,234,204,171,
+170,136,153,235,219,187,138,8,33,2,144,169,48,86,68,34,
+2,144,136,32,51,20,160,221,203,155,8,50,36,0,153,41,
+103,68,36,18,152,170,10,81,52,18,235,189,188,153,32,17,
+201,221,203,154,16,51,36,129,185,138,81,85,51,35,128,169,
+8,66,53,35,168,204,203,153,17,17,160,221,188,171,137,16,
+2,168,220,171,10,66,68,18,145,153,138,65,84,50,18,136,
+153,8,83,67,17,185,204,187,9,17,1,217,205,172,154,136,
+17,128,185,173,139,48,69,51,17,152,137,32,53,52,1,169,
+171,25,86,52,51,18,50,100,52,52,1,152,154,49,87,35,
+130,234,188,172,137,17,18,201,222,188,170,8,34,34,184,221,
+171,8,115,67,34,1,153,153,33,70,51,19,152,203,154,33,
+68,35,168,205,188,155,9,16,152,220,188,187,138,33,34,1,
+186,172,25,100,52,51,17,152,152,32,69,51,19,152,171,139,
+64,68,35,128,186,172,9,50,37,128,220,204,171,154,137,169,
+204,204,186,170,137,0,0,1,17,83,84,52,53,52,68,67,
+36,35,17,128,16,66,68,34,145,235,188,187,153,17,17,201,
+207,203,171,138,0,128,202,205,187,154,33,68,51,18,136,8,
+83,69,67,19,2,8,8,66,83,35,129,186,189,172,153,8,
+152,234,189,173,187,154,136,153,218,219,186,137,49,68,36,17,
+136,136,16,69,68,34,2,136,153,0,67,67,2,184,189,171,
+80,70,52,35,160,203,155,56,85,35,129,251,203,170,8,50,
+35,216,206,188,154,24,50,35,168,206,172,9,48,53,36,1,
+153,154,32,70,52,35,1,185,170,32,69,36,2,184,219,171,
+136,33,35,160,236,204,170,154,8,136,185,221,187,170,9,33,
+35,17,152,137,65,69,52,51,18,128,0,50,70,67,34,1,
+152,136,49,53,53,18,128,202,187,170,137,169,236,204,188,187,
+171,170,153,170,204,188,156,137,66,84,51,52,35,51,67,68,
+83,67,34,2,136,154,24,82,52,18,217,220,203,154,24,34,
+35,168,207,188,187,138,24,1,184,222,203,154,24,66,52,18,
+128,169,137,81,84,67,34,17,136,152,8,16,50,18,130,201,
+221,219,187,171,137,16,0,185,207,203,155,25,82,52,34,152,
+204,188,138,32,68,51,1,203,189,171,40,84,52,35,129,168,
+138,80,69,53,51,18,144,186,171,153,17,34,168,239,188,173,
+171,137,136,128,185,204,203,154,9,34,67,18,128,153,155,8,
+99,83,51,18,128,186,188,138,66,69,52,67,34,51,67,52,
+52,51,36,17,8,153,153,137,169,220,204,188,188,187,189,188,
+203,154,24,17,129,202,189,155,82,70,67,19,2,0,32,84,
+53,52,35,1,153,138,32,53,37,129,219,220,187,171,170,153,
+169,204,188,189,186,154,137,0,17,18,51,52,68,67,51,52,
+36,51,36,35,18,17,128,144,152,154,187,171,154,136,170,222,
+203,155,48,85,36,2,184,220,187,171,171,202,203,188,204,203,
+219,188,219,186,170,153,136,0,16,17,34,68,68,83,51,52,
+53,68,67,35,51,34,17,17,50,54,53,36,19,0,154,171,
+138,8,152,251,190,189,203,186,170,186,203,188,188,187,187,186,
+170,170,170,137,48,84,52,68,67,83,83,51,67,35,50,34,
+51,37,36,34,18,0,153,170,171,203,219,219,188,203,154,154,
+169,218,219,186,154,152,168,203,189,172,171,171,203,219,187,171,
+171,154,170,187,188,138,48,86,83,67,51,52,52,67,51,34,
+128,170,154,81,86,67,51,34,17,33,83,68,52,67,50,67,
+67,67,36,34,128,168,187,170,170,186,206,204,203,187,171,170,
+185,203,188,187,153,33,51,18,168,204,154,40,99,51,146,251,
+189,187,138,0,1,218,205,172,138,40,82,51,52,52,53,69,
+67,51,34,17,16,32,33,128,202,204,187,154,153,170,204,204,
+170,137,34,37,19,168,220,187,138,32,51,19,201,205,188,187,
+172,187,188,203,187,187,186,171,9,114,84,51,18,168,202,153,
+98,84,83,50,35,19,129,169,203,171,9,83,68,35,18,129,
+137,24,116,68,68,67,35,36,34,18,17,136,168,186,189,204,
+172,203,170,170,170,203,204,204,187,187,170,137,169,188,188,154,
+32,68,52,34,1,0,0,50,83,18,168,206,188,171,137,136,
+185,206,204,170,138,136,0,129,136,152,137,32,100,52,36,2,
+186,207,204,187,172,203,186,203,187,188,187,188,202,186,186,171,
+153,8,16,129,152,202,188,189,188,188,187,172,187,188,171,9,
+66,36,1,169,9,117,69,52,51,51,34,33,33,35,1,200,
+221,204,187,171,153,0,1,144,153,10,116,85,52,52,50,1,
+136,137,0,51,53,2,185,191,188,154,136,17,17,51,54,69,
+83,67,52,51,51,18,136,137,9,16,152,251,205,204,187,188,
+187,187,203,186,187,153,24,67,51,18,144,169,154,32,67,52,
+145,237,205,188,186,170,170,203,204,170,25,84,68,67,18,1,
+136,152,153,168,202,203,203,170,154,9,33,68,83,83,51,67,
+51,35,51,18,145,202,220,187,171,9,32,35,129,218,203,154,
+49,86,67,67,51,52,51,36,35,51,52,51,52,51,53,68,
+51,35,2,0,32,69,68,34,129,168,8,85,69,36,34,144,
+186,188,154,16,83,36,35,18,33,66,52,36,19,50,68,70,
+67,51,35,16,8,49,84,67,34,136,187,188,137,49,52,37,
+34,33,34,18,168,205,173,155,16,52,3,250,221,203,171,153,
+0,0,144,185,188,155,137,33,2,184,221,171,24,115,51,19,
+184,206,188,171,154,136,169,235,219,170,25,66,53,35,18,152,
+9,65,84,35,130,203,189,154,8,17,168,222,203,171,154,153,
+152,137,137,128,152,219,220,203,170,9,65,68,51,18,128,136,
+49,84,51,34,1,32,99,68,35,160,236,204,170,136,34,34,
+145,188,172,41,99,52,35,1,128,16,66,68,52,36,35,67,
+84,68,83,34,129,168,187,171,8,16,168,222,204,187,154,40,
+83,68,35,35,33,17,16,16,17,66,84,52,36,129,184,188,
+170,8,51,37,18,129,0,16,33,168,222,205,203,186,153,8,
+152,235,205,203,171,138,136,152,219,189,188,153,16,52,36,2,
+160,170,154,32,68,51,19,129,186,205,204,204,203,186,171,9,
+49,68,51,18,17,49,70,83,51,35,35,49,66,51,34,200,
+237,204,187,172,154,138,152,152,153,169,137,16,66,99,67,67,
+67,35,34,1,128,0,66,84,52,51,18,0,9,98,85,67,
+50,17,128,0,66,51,36,0,136,137,152,234,221,189,189,171,
+154,8,33,17,144,185,153,65,70,36,19,145,185,171,25,99,
+51,2,202,190,186,8,83,52,18,184,204,172,137,49,35,130,
+204,205,170,153,128,0,168,186,171,9,68,69,35,19,2,17,
+33,33,17,17,99,69,51,2,234,189,188,170,8,33,50,34,
+18,34,145,253,222,188,188,187,9,16,17,184,206,188,188,153,
+9,32,49,51,54,53,68,34,18,136,186,186,137,17,18,160,
+173,139,115,69,51,1,185,189,170,33,55,53,35,2,169,188,
+172,170,186,202,187,187,138,16,67,50,1,136,8,99,85,83,
+35,35,128,169,172,171,137,136,186,206,171,57,102,68,35,2,
+168,188,172,154,8,8,185,205,189,188,186,186,170,203,186,138,
+32,69,36,2,169,171,41,103,52,37,34,128,153,170,137,17,
+50,1,218,188,172,137,8,144,203,189,171,56,71,53,67,34,
+17,152,169,187,172,171,171,204,189,188,170,24,83,67,2,160,
+218,186,9,66,54,36,18,152,170,171,186,187,206,203,186,137,
+24,0,185,221,187,154,32,51,130,251,188,203,170,203,188,189,
+172,170,137,32,52,51,18,169,156,48,103,52,35,19,1,17,
+50,35,161,238,220,187,170,9,33,34,128,219,189,188,170,138,
+16,67,52,20,1,152,136,32,67,18,219,205,171,25,68,69,
+35,2,185,205,187,153,33,52,35,0,137,8,50,53,3,233,
+220,187,138,40,50,1,219,188,139,64,67,2,202,190,173,138,
+40,66,34,129,186,187,25,83,52,34,50,99,68,52,36,18,
+144,169,138,64,70,36,3,160,203,171,9,33,2,201,206,203,
+187,170,153,185,235,203,170,16,85,52,52,35,17,0,0,136,
+128,136,153,8,50,53,35,184,191,173,170,137,16,34,68,83,
+35,34,0,169,188,203,170,24,51,130,251,190,154,32,67,192,
+207,189,171,24,83,52,34,128,136,16,84,52,51,17,136,136,
+49,84,35,145,204,189,171,138,16,128,201,205,187,138,24,33,
+1,153,171,10,114,68,68,67,35,19,128,186,187,139,64,84,
+51,1,201,189,172,9,67,69,35,17,153,188,188,171,170,170,
+220,204,188,171,137,49,52,51,17,136,8,33,70,68,67,35,
+18,144,169,172,187,204,187,171,24,99,51,18,169,188,138,82,
+52,52,35,34,51,51,34,0,235,221,205,219,187,186,170,169,
+169,154,10,64,68,52,35,34,83,69,53,52,35,1,136,153,
+136,1,144,251,205,203,155,137,49,52,19,152,205,203,170,136,
+16,50,67,52,53,51,2,201,205,171,138,32,67,34,1,152,
+136,8,33,52,53,52,52,52,50,50,50,70,53,36,145,236,
+204,187,153,16,50,1,201,204,187,9,49,53,20,129,170,153,
+32,53,36,145,203,188,154,0,50,34,35,67,53,36,145,251,
+203,155,32,68,36,2,152,202,203,170,187,204,204,203,170,9,
+32,34,2,152,153,49,87,51,51,1,152,48,85,68,35,145,
+218,204,170,8,66,67,18,129,137,137,17,34,0,186,187,8,
+66,34,169,219,137,66,53,67,34,67,69,68,51,19,169,205,
+171,9,99,67,18,168,219,187,137,33,67,129,236,204,172,170,
+24,50,53,35,1,185,203,138,81,53,53,51,18,1,0,8,
+136,218,188,172,24,85,67,34,152,204,188,155,9,34,35,144,
+220,187,137,67,36,129,251,203,154,32,67,36,1,168,186,137,
+48,67,18,136,0,66,18,234,205,189,204,205,204,170,25,84,
+53,51,129,218,188,172,136,66,52,36,1,169,204,170,9,33,
+52,35,129,202,173,171,24,67,68,33,136,186,173,170,8,33,
+50,19,129,169,204,203,187,153,49,37,2,220,190,155,56,87,
+67,35,1,186,204,171,8,66,52,18,144,186,172,138,16,33,
+2,144,203,188,186,153,136,153,170,171,171,205,205,187,139,65,
+54,36,18,152,170,154,32,69,52,34,128,154,25,115,51,19,
+184,189,156,9,50,37,18,185,207,188,187,154,136,0,152,169,
+10,116,69,52,35,2,169,186,170,0,0,250,205,188,172,153,
+136,136,185,204,171,24,68,53,52,34,35,51,67,51,34,18,
+17,128,186,205,203,203,202,202,187,204,172,172,154,24,66,52,
+36,18,129,144,128,33,66,34,145,219,189,188,186,187,204,170,
+40,116,83,51,35,1,144,152,8,33,51,19,249,221,204,186,
+187,170,169,154,137,49,85,52,67,34,17,17,33,51,53,51,
+34,1,152,203,204,203,172,155,138,8,34,67,67,52,54,53,
+52,35,144,219,188,138,48,52,2,220,190,188,170,137,0,128,
+169,219,154,32,84,67,18,128,137,16,66,51,19,168,207,188,
+171,8,83,67,18,128,154,24,67,36,2,168,171,24,102,52,
+36,130,185,205,187,171,153,154,187,187,139,64,100,52,52,36,
+17,1,136,0,16,66,67,34,161,222,205,187,171,137,16,16,
+17,34,68,52,35,2,168,188,137,99,69,51,2,201,205,219,
+171,155,9,32,51,51,51,54,69,51,18,185,206,187,138,24,
+49,2,145,187,173,9,98,68,35,130,202,188,171,138,152,202,
+204,188,170,170,169,170,9,98,68,51,18,128,16,101,68,52,
+51,17,153,154,138,16,17,144,185,187,153,184,239,204,187,171,
+24,66,50,1,186,189,154,0,51,19,218,223,219,186,137,33,
+52,34,152,170,56,103,67,34,145,169,155,40,69,83,18,144,
+170,172,137,32,17,144,186,25,84,37,19,169,206,204,170,137,
+49,37,2,201,187,139,65,19,200,191,189,154,8,32,17,136,
+170,155,88,85,67,19,128,153,8,67,69,51,34,152,220,188,
+172,153,153,169,169,9,66,51,2,168,170,154,137,32,70,20,
+192,205,155,80,69,51,2,169,203,186,138,56,85,35,129,188,
+140,64,51,145,206,171,24,34,128,9,114,51,233,207,170,49,
+53,177,239,187,9,115,67,2,168,203,155,24,66,35,1,168,
+8,115,68,2,217,205,156,9,66,36,18,168,202,153,24,17,
+129,186,187,40,85,67,2,185,204,171,16,67,35,161,204,172,
+9,66,36,3,168,235,171,138,48,68,51,18,168,188,187,137,
+50,53,34,145,186,188,171,24,99,68,34,144,251,187,139,32,
+52,51,1,169,204,220,203,153,49,85,51,1,185,220,170,9,
+67,53,2,219,190,154,64,69,50,145,202,204,154,24,66,52,
+19,160,220,203,154,40,68,52,35,168,220,188,154,49,69,51,
+129,203,189,170,24,83,52,18,152,189,188,137,65,67,35,1,
+184,220,203,10,136,80,52,35,0,219,188,138,40,68,36,0,
+184,220,154,8,8,69,35,8,128,189,187,138,65,53,35,144,
+220,187,8,136,69,35,1,168,219,187,139,8,115,67,18,168,
+235,171,136,80,67,3,0,176,190,155,136,65,68,18,152,187,
+173,9,49,52,18,144,203,171,9,51,36,145,203,155,40,53,
+35,184,206,172,154,32,84,51,19,184,206,187,139,64,68,35,
+1,186,190,171,24,84,51,2,202,204,170,16,67,36,1,186,
+172,138,49,53,19,160,204,171,10,66,67,19,145,202,189,155,
+25,83,36,1,169,188,138,33,68,17,185,204,171,25,68,52,
+3,168,189,188,154,8,50,84,67,35,145,220,188,155,40,68,
+52,35,160,235,188,171,24,99,36,18,144,170,172,172,187,11,
+88,70,51,130,219,204,9,136,67,52,1,128,204,187,137,65,
+53,18,128,204,187,9,49,37,3,144,186,171,138,16,67,50,
+129,186,188,155,16,67,67,50,18,168,206,171,26,83,37,2,
+184,189,187,9,82,53,18,160,205,187,24,84,51,130,218,188,
+155,16,52,52,19,168,205,187,155,65,53,36,144,235,187,138,
+66,53,35,160,220,171,9,66,68,17,184,188,172,25,82,36,
+2,168,204,155,9,50,53,19,129,218,204,170,25,83,52,19,
+169,189,172,137,34,68,34,129,186,205,170,24,83,36,2,169,
+188,187,8,65,67,19,145,202,203,154,24,35,35,17,18,129,
+233,205,172,24,68,52,18,185,190,170,25,66,67,18,160,219,
+187,137,65,67,18,168,187,154,50,37,168,206,187,40,71,36,
+18,202,220,171,25,66,53,18,144,203,172,154,8,51,53,35,
+129,235,203,138,33,69,2,168,190,172,8,40,70,50,0,202,
+188,139,32,69,35,0,200,173,139,32,53,4,0,200,188,10,
+56,52,36,128,218,171,138,49,53,19,184,204,155,24,66,35,
+129,170,172,153,16,33,18,1,152,153,33,36,233,191,172,64,
+85,35,144,205,187,137,82,67,34,152,203,172,154,32,83,36,
+2,168,189,188,9,82,67,19,168,205,170,25,83,51,129,202,
+203,138,32,52,35,129,219,188,155,48,69,36,129,202,188,155,
+56,84,51,1,218,219,154,0,67,52,1,185,205,154,8,81,
+67,2,168,219,171,9,67,37,2,160,204,171,9,66,37,3,
+144,204,172,8,40,68,34,144,219,172,8,40,84,18,128,203,
+187,137,81,67,18,160,219,187,10,65,68,18,144,219,187,137,
+66,52,2,168,203,154,16,34,1,152,8,66,18,185,191,171,
+40,84,36,1,185,205,170,8,83,36,18,152,219,188,138,32,
+69,35,145,204,187,24,69,34,144,204,155,24,83,50,128,203,
+172,137,66,52,19,202,205,155,56,69,51,128,204,203,10,40,
+53,51,128,219,188,138,32,52,20,129,153,171,154,154,136,32,
+99,67,34,129,218,205,171,26,115,67,3,184,205,170,8,52,
+36,2,186,204,170,24,83,51,2,201,188,155,41,83,51,3,
+185,190,156,25,82,51,18,201,188,187,8,68,52,2,184,190,
+187,9,83,67,18,153,203,153,32,35,1,168,155,25,34,19,
+1,0,160,222,172,57,71,35,216,205,154,65,68,18,185,204,
+154,17,67,17,144,186,170,138,32,69,35,145,204,154,49,37,
+177,222,187,25,68,52,19,144,219,188,155,40,54,36,144,235,
+171,8,99,50,1,168,187,187,154,32,68,51,1,202,171,40,
+67,130,235,171,24,53,35,200,203,138,66,52,130,235,188,171,
+49,71,35,144,235,187,138,83,52,2,176,204,171,9,66,52,
+19,160,204,187,10,83,37,131,192,188,171,40,84,35,0,200,
+188,170,16,67,36,1,201,203,154,49,54,34,168,189,171,40,
+68,19,160,220,171,8,98,67,1,136,188,188,9,66,52,2,
+144,203,187,137,34,36,2,169,170,137,33,33,129,137,24,67,
+51,216,207,204,138,49,71,35,145,219,173,138,48,53,34,168,
+204,186,8,66,52,19,184,205,171,25,66,52,2,185,188,155,
+40,67,51,130,184,203,187,155,16,99,52,35,145,235,188,155,
+25,99,52,35,161,221,188,139,65,69,34,144,204,187,137,82,
+67,18,168,188,172,8,51,52,2,169,188,171,8,51,53,18,
+152,204,187,10,83,52,2,201,203,155,8,66,67,51,2,234,
+189,172,40,99,35,129,185,172,153,128,8,24,68,37,130,234,
+188,154,65,52,34,168,235,170,9,67,68,2,168,220,171,25,
+99,52,1,185,190,170,16,68,34,128,202,186,136,50,52,129,
+201,187,155,49,54,34,152,203,170,24,51,36,144,203,170,40,
+84,35,145,220,187,10,83,51,176,221,155,56,69,51,128,203,
+188,170,137,65,69,51,129,220,187,10,66,36,129,169,154,24,
+1,217,172,41,101,36,129,218,204,154,40,68,36,2,186,190,
+171,32,53,36,128,203,187,137,50,53,18,152,203,170,9,50,
+51,145,219,154,65,36,130,219,188,137,49,52,50,18,152,221,
+188,155,65,54,34,184,188,171,32,52,19,144,169,188,187,9,
+86,52,1,219,172,137,51,36,144,203,137,82,34,168,205,170,
+24,67,52,19,168,191,173,25,115,35,130,235,187,10,82,36,
+2,184,188,171,25,68,51,3,217,204,154,40,52,20,144,202,
+170,24,34,34,1,0,153,219,172,10,98,51,2,201,172,138,
+49,50,18,128,170,204,154,48,69,19,202,173,24,84,19,200,
+190,171,56,84,36,2,168,235,172,138,65,53,19,185,190,155,
+64,52,35,185,205,170,24,83,35,18,185,190,171,25,68,36,
+1,202,203,137,33,52,18,152,188,187,9,66,53,18,184,205,
+170,16,83,34,144,185,170,137,8,16,66,52,18,233,188,156,
+24,67,36,19,129,219,205,170,41,84,51,145,235,187,10,83,
+52,1,185,189,171,24,99,36,2,168,173,171,24,66,34,128,
+153,136,0,128,186,188,154,32,84,53,52,128,221,204,153,49,
+68,19,144,188,187,8,66,35,128,219,170,32,69,35,184,206,
+171,24,68,36,1,169,204,170,8,50,52,19,169,173,154,33,
+51,161,220,170,48,68,35,129,202,205,171,10,114,68,18,184,
+189,172,40,67,36,129,185,188,154,0,51,37,1,168,188,154,
+40,51,52,17,185,221,203,137,99,52,19,217,204,154,32,53,
+19,168,188,156,40,83,19,161,235,171,10,83,67,2,185,189,
+155,32,68,35,129,186,174,155,24,83,67,17,169,204,170,8,
+67,51,2,185,188,155,8,34,67,50,18,200,205,172,41,84,
+36,129,219,188,138,66,53,18,168,204,156,137,50,53,34,152,
+188,172,9,49,52,17,185,219,154,32,68,36,145,219,188,138,
+65,53,34,168,204,187,137,50,54,34,145,202,171,137,33,130,
+235,171,64,86,35,144,220,187,154,50,55,35,129,203,189,154,
+32,68,35,144,203,171,9,50,51,2,169,187,153,8,0,144,
+8,49,86,51,145,221,188,154,65,69,34,144,219,172,154,48,
+69,51,130,218,188,171,32,99,50,1,169,188,171,9,83,67,
+17,185,186,24,51,192,223,171,40,71,51,145,234,187,155,49,
+69,35,129,219,188,154,49,69,35,144,218,187,154,32,52,36,
+18,168,188,188,137,49,53,18,152,203,171,8,65,68,18,176,
+205,172,25,83,36,145,202,155,24,67,17,186,172,41,83,19,
+152,187,155,32,19,129,153,154,186,187,73,119,67,18,185,206,
+171,10,66,54,35,144,220,203,153,49,68,34,160,219,171,25,
+83,52,1,218,204,154,32,53,52,128,202,188,155,32,52,36,
+1,169,187,172,10,33,52,35,129,185,172,154,136,136,8,98,
+84,34,152,204,187,8,66,18,168,189,155,99,54,35,200,206,
+171,41,100,35,129,235,187,9,66,67,1,168,171,155,0,18,
+34,128,169,137,81,68,1,235,188,138,67,53,1,185,204,138,
+24,51,38,18,184,206,171,24,69,36,144,188,173,8,67,36,
+2,200,219,170,128,67,37,2,185,189,138,32,69,18,152,203,
+187,9,67,52,19,184,220,171,8,83,51,2,201,204,138,40,
+66,35,129,170,188,155,24,67,52,2,201,188,138,33,52,18,
+185,172,9,33,1,169,10,98,51,161,204,171,9,18,51,84,
+35,177,207,172,24,99,19,145,187,171,137,169,170,113,71,35,
+176,221,187,9,52,53,2,168,204,171,9,66,53,2,184,204,
+154,16,50,18,153,154,8,18,34,0,168,236,188,154,98,52,
+18,185,173,25,67,35,185,191,171,40,69,36,130,217,188,156,
+40,99,51,2,186,189,172,9,49,53,35,160,203,171,40,51,
+146,206,172,32,54,36,128,219,171,138,33,67,18,152,169,8,
+66,19,250,190,171,64,70,35,128,235,203,137,32,52,20,128,
+203,187,137,65,67,18,168,188,171,24,83,51,2,185,204,171,
+10,66,52,51,144,204,188,138,48,68,19,128,186,156,137,16,
+0,0,17,1,136,10,116,68,129,221,188,139,98,52,19,168,
+205,171,25,66,52,2,168,205,170,24,83,51,129,218,203,137,
+49,52,17,201,187,138,66,52,3,202,188,155,32,52,34,1,
+128,136,203,205,170,16,69,51,129,202,188,139,32,68,34,128,
+219,187,139,64,69,51,18,218,189,187,32,85,35,145,219,172,
+9,50,36,129,169,154,8,1,144,170,187,170,32,87,69,34,
+184,207,171,9,99,51,18,185,219,171,137,33,68,52,2,202,
+189,156,24,52,51,129,202,203,138,40,66,36,1,202,188,155,
+65,53,19,184,220,170,9,50,68,35,129,235,188,170,49,70,
+34,144,219,187,138,67,52,19,160,204,172,10,49,68,35,145,
+219,172,139,32,53,51,128,204,187,138,66,52,19,169,219,170,
+9,33,51,51,18,184,206,171,10,49,68,19,129,203,173,139,
+64,69,18,184,205,138,49,54,18,202,189,139,48,54,35,145,
+204,203,138,48,68,51,129,219,204,138,32,68,35,129,202,188,
+154,8,67,36,18,144,202,188,153,16,52,36,130,201,203,155,
+24,68,51,18,186,205,171,8,50,68,34,1,169,205,172,154,
+49,55,35,145,235,188,138,49,69,35,144,251,187,137,65,53,
+34,184,204,170,8,67,51,129,186,188,9,33,36,128,219,187,
+56,85,51,144,220,187,138,66,53,34,144,219,187,155,32,53,
+36,1,186,188,10,65,51,129,203,188,137,50,68,35,2,217,
+204,187,9,99,52,17,185,189,154,16,52,50,128,203,172,10,
+81,52,2,201,190,154,49,68,19,184,188,137,49,36,168,205,
+154,65,68,35,168,205,187,137,65,69,34,144,204,187,138,82,
+52,18,168,204,170,8,50,36,1,153,187,154,24,67,35,145,
+203,171,136,0,152,9,100,68,2,201,172,10,65,35,128,203,
+186,137,16,33,69,52,145,251,187,9,68,34,160,188,155,40,
+50,50,83,36,146,222,188,138,83,52,1,202,187,9,99,51,
+129,219,188,138,65,53,19,185,190,156,32,68,35,144,219,172,
+137,33,52,51,128,234,203,155,40,53,52,1,185,204,171,154,
+16,68,52,52,129,219,189,171,24,83,52,18,152,204,187,137,
+50,54,2,168,188,171,40,68,35,144,203,171,9,50,52,18,
+144,219,203,154,49,55,36,145,204,173,138,49,68,19,144,219,
+171,138,49,52,51,144,219,188,138,49,54,35,176,206,171,25,
+84,67,1,201,204,154,33,68,35,144,219,203,138,33,68,18,
+145,185,172,154,32,51,37,2,185,220,186,136,66,52,18,160,
+189,172,25,66,52,2,185,190,171,16,68,36,1,169,187,156,
+9,33,50,18,144,154,138,33,52,17,169,189,188,172,154,65,
+70,36,1,201,203,153,17,2,184,188,26,101,67,18,201,204,
+171,8,68,52,18,201,188,156,8,51,52,1,168,187,171,40,
+68,52,2,202,189,188,153,33,69,53,50,160,236,187,138,81,
+52,2,185,204,155,16,52,52,17,184,235,171,154,48,99,34,
+129,185,188,138,65,53,36,144,221,203,153,49,69,35,128,202,
+188,170,32,53,36,129,202,203,137,48,35,130,186,172,40,85,
+51,1,234,188,172,9,83,52,35,152,219,172,154,16,35,51,
+2,160,170,155,25,33,2,168,154,48,68,144,206,172,41,85,
+51,129,235,188,137,66,69,2,200,204,187,24,84,52,18,168,
+205,171,138,49,69,18,145,186,172,137,33,34,1,185,170,24,
+68,51,160,221,187,10,115,36,19,168,188,187,138,1,17,17,
+82,84,50,129,219,205,170,10,49,69,35,2,168,188,172,138,
+8,33,33,50,67,18,160,220,188,171,24,84,52,34,160,236,
+187,138,48,53,36,2,152,202,204,186,137,81,68,35,145,219,
+203,138,32,67,35,129,218,203,138,32,68,51,128,219,171,137,
+49,51,1,169,154,0,0,186,173,64,71,36,128,220,204,138,
+32,84,51,2,185,190,172,137,66,52,35,160,204,188,138,49,
+69,35,129,203,173,155,32,99,35,1,185,189,171,24,67,36,
+130,186,174,138,65,53,34,168,205,187,10,66,53,34,160,219,
+187,138,48,68,34,144,202,187,137,49,68,34,168,203,171,56,
+70,35,129,235,188,154,32,69,36,1,185,189,187,9,67,52,
+51,1,168,204,188,171,10,82,68,35,129,201,188,155,24,67,
+51,130,201,187,138,49,53,129,202,203,9,82,52,1,185,205,
+170,8,50,53,36,1,184,205,203,154,40,99,51,19,160,219,
+172,154,32,83,35,129,218,187,138,82,52,3,202,204,154,48,
+53,35,144,220,172,153,33,68,51,130,201,188,172,136,50,37,
+19,152,202,187,137,33,35,17,152,8,66,36,145,236,189,170,
+32,84,52,2,160,219,172,170,9,32,83,68,51,2,185,206,
+187,153,33,52,50,1,152,153,137,8,152,203,205,154,48,70,
+36,129,218,188,155,40,84,36,18,184,220,170,9,50,37,129,
+186,172,41,69,35,160,205,172,10,65,68,34,144,218,187,171,
+32,68,52,1,168,188,172,9,49,68,51,129,202,190,155,41,
+99,36,2,169,188,171,24,68,51,2,218,204,154,24,68,51,
+129,218,188,154,48,68,35,128,186,173,155,0,66,34,1,136,
+8,33,18,233,206,171,25,115,67,18,152,204,203,137,48,53,
+20,129,203,188,138,48,52,36,128,219,187,137,67,68,17,185,
+205,154,32,99,35,1,202,204,155,41,99,51,3,200,204,170,
+9,51,53,2,152,188,187,9,67,52,3,185,204,171,16,68,
+50,129,186,174,155,24,99,67,2,184,205,171,8,83,51,18,
+201,204,170,24,82,51,3,176,204,187,138,33,52,51,2,128,
+185,203,204,170,9,66,53,36,2,128,203,204,171,138,65,52,
+51,129,170,187,155,152,153,154,24,85,68,18,144,235,203,187,
+24,115,68,34,129,201,188,172,154,8,67,53,36,2,184,204,
+171,154,32,66,18,0,8,8,17,145,204,188,9,100,67,1,
+202,204,170,16,83,34,1,154,138,49,53,130,252,204,170,25,
+83,52,19,144,202,171,138,16,17,144,218,171,40,85,52,18,
+201,204,170,25,66,51,2,186,190,170,24,68,52,19,160,204,
+203,153,24,34,35,35,1,169,189,171,9,66,35,128,187,188,
+137,16,50,70,53,36,129,203,189,203,169,153,8,65,70,52,
+35,1,201,188,205,170,137,66,69,35,129,202,188,154,49,68,
+19,145,203,204,170,137,33,68,51,35,18,152,204,205,187,154,
+16,53,37,35,1,184,219,172,153,16,33,2,0,33,68,35,
+200,206,172,137,66,53,51,129,218,204,171,137,49,69,35,18,
+153,204,203,154,8,50,52,35,17,16,17,184,239,203,171,24,
+83,68,18,129,185,188,187,8,66,52,18,160,187,172,138,32,
+67,36,18,129,153,169,219,222,188,156,41,84,53,34,129,203,
+188,187,10,33,52,34,129,152,0,67,35,176,222,187,138,65,
+53,34,184,220,171,25,83,53,35,144,219,189,186,9,49,53,
+51,18,144,186,188,170,171,172,172,137,115,53,36,2,201,203,
+155,8,51,51,128,202,187,9,66,53,34,129,170,172,171,170,
+189,188,10,115,53,52,1,184,219,187,187,155,8,82,52,52,
+36,17,128,185,189,172,155,136,0,0,33,86,52,52,1,184,
+204,187,170,153,137,24,49,68,52,67,34,2,201,221,203,171,
+137,17,67,35,51,50,2,184,205,187,153,152,219,190,187,48,
+103,51,20,129,186,204,187,153,8,33,50,67,52,51,51,160,
+221,204,171,170,24,66,68,51,18,168,188,172,9,49,35,200,
+205,155,40,85,35,129,202,188,138,48,51,3,201,173,155,33,
+68,34,129,169,170,56,84,35,160,205,172,137,66,53,34,0,
+169,137,0,168,221,188,155,49,71,51,19,185,190,173,138,32,
+83,35,129,186,188,138,17,19,161,235,170,32,86,35,18,186,
+190,187,9,50,53,18,129,153,187,219,154,25,98,67,51,130,
+200,188,173,138,65,68,35,128,203,171,40,67,18,201,188,9,
+82,37,18,168,219,187,155,16,68,36,2,168,204,171,154,8,
+50,53,35,160,221,188,154,32,52,35,144,203,171,24,84,52,
+51,129,202,188,172,9,33,68,50,34,128,154,8,68,36,184,
+223,187,138,82,53,18,160,219,187,10,66,52,20,128,203,204,
+170,9,49,68,35,130,201,204,171,137,32,35,2,152,137,48,
+51,176,255,172,154,32,68,67,17,169,204,187,9,65,52,19,
+168,219,154,24,67,51,145,202,188,153,66,68,35,184,222,187,
+9,82,52,1,169,173,154,32,33,129,170,9,99,52,2,218,
+204,155,25,67,52,17,201,219,154,24,67,37,2,168,203,171,
+24,66,35,129,202,171,24,69,52,2,144,218,219,171,154,65,
+70,51,2,201,204,155,9,49,52,18,168,203,172,9,33,52,
+67,17,144,170,170,8,128,234,189,156,65,71,36,17,185,189,
+156,137,16,34,34,18,0,168,186,172,153,152,202,187,41,85,
+52,130,235,172,9,98,67,18,168,205,187,155,32,52,52,18,
+0,137,153,169,169,170,9,33,51,19,145,160,184,169,48,119,
+51,145,237,187,56,103,36,19,152,188,187,16,53,20,168,204,
+171,40,84,50,2,128,8,8,202,221,203,138,32,68,34,128,
+185,188,137,65,53,36,152,235,171,9,83,36,129,185,172,138,
+33,19,144,187,139,65,67,129,202,188,138,24,0,202,187,10,
+49,160,223,172,32,70,35,145,202,139,65,52,129,235,171,24,
+69,35,2,168,203,204,188,170,40,54,37,17,152,137,16,52,
+51,50,50,34,200,221,171,24,69,51,1,169,171,137,184,221,
+204,154,32,52,34,168,220,171,24,83,52,18,184,206,172,171,
+8,49,52,19,144,187,138,114,52,3,233,188,154,64,68,34,
+128,170,154,16,1,217,220,170,25,98,51,19,168,188,156,24,
+83,50,129,170,188,171,9,33,68,51,18,201,189,188,154,8,
+24,67,84,36,129,219,205,170,136,34,36,18,136,186,171,26,
+100,52,36,34,18,50,2,233,221,187,138,49,52,2,201,187,
+138,49,69,51,19,184,206,203,137,82,52,19,201,205,171,9,
+17,18,128,186,171,40,84,52,34,144,220,187,139,66,68,2,
+152,187,154,24,34,17,33,67,19,218,189,9,101,68,35,0,
+202,187,155,24,67,18,201,206,188,170,16,52,37,1,185,203,
+138,66,52,19,184,190,171,8,34,36,35,19,144,206,173,139,
+48,53,2,185,189,138,66,52,36,1,128,136,185,187,171,40,
+67,51,1,128,169,218,205,204,187,172,153,66,70,51,2,217,
+189,172,9,65,68,34,128,185,172,138,16,17,144,219,154,48,
+53,20,168,203,139,114,52,35,201,190,172,8,68,67,17,168,
+203,138,32,68,18,160,219,170,16,68,2,201,205,171,9,67,
+36,18,168,169,24,67,51,144,206,172,10,65,52,18,201,189,
+172,9,66,36,19,168,188,171,48,55,20,145,219,187,138,66,
+53,35,145,186,188,138,49,53,19,144,219,171,24,52,36,1,
+186,203,154,153,234,220,188,154,32,54,52,17,185,219,171,137,
+17,51,67,34,17,136,169,186,204,203,187,8,99,68,50,1,
+152,170,186,219,186,10,115,69,50,1,186,188,170,136,136,152,
+24,116,52,36,145,218,188,155,8,83,51,128,236,203,154,33,
+68,35,160,219,172,10,65,83,19,129,185,171,24,115,51,19,
+144,202,170,9,49,67,3,233,220,187,137,66,36,3,152,171,
+138,33,1,251,188,187,8,34,17,186,174,26,115,68,51,18,
+144,219,188,171,25,84,51,145,235,188,155,9,16,18,16,17,
+1,137,40,103,68,34,144,219,187,9,82,67,18,128,185,188,
+171,138,49,52,19,136,40,86,36,130,220,173,139,48,69,51,
+128,219,188,155,40,83,51,1,185,188,155,64,68,51,18,186,
+191,187,138,48,52,36,1,153,187,187,154,65,87,83,34,128,
+218,172,155,32,83,34,152,205,187,10,81,51,19,184,188,139,
+48,53,35,145,201,202,186,154,33,54,36,160,205,188,153,49,
+67,35,144,186,187,9,115,83,18,144,186,155,81,69,19,145,
+235,203,187,154,136,17,2,128,186,10,116,68,35,129,218,203,
+170,137,33,36,1,201,204,170,9,33,51,53,53,36,129,186,
+189,137,82,51,130,218,171,137,49,51,129,153,170,169,219,187,
+40,71,51,161,206,171,32,55,37,18,153,203,171,8,34,35,
+176,207,188,138,16,18,168,187,72,71,36,129,202,187,137,50,
+35,201,205,187,137,65,68,34,152,205,155,56,70,51,145,204,
+187,154,34,37,35,129,169,219,171,9,84,52,34,144,219,187,
+172,154,9,16,52,53,34,128,202,188,155,24,84,51,129,203,
+187,9,67,1,251,187,25,68,37,18,152,186,187,155,64,86,
+52,18,201,205,155,25,67,36,129,185,187,139,16,35,2,201,
+205,171,137,50,20,161,218,154,32,68,19,1,153,153,218,221,
+203,154,24,33,34,1,50,67,144,221,188,9,84,52,20,128,
+186,173,138,49,69,36,17,185,204,171,138,16,50,34,129,169,
+153,49,84,18,218,206,172,154,48,68,20,129,187,173,25,66,
+52,2,184,219,154,24,50,51,2,185,189,138,99,52,145,221,
+188,139,48,53,19,160,219,155,25,66,52,34,145,219,187,41,
+85,36,130,201,188,138,32,50,128,219,155,16,52,146,236,203,
+154,0,18,0,137,49,54,35,184,173,26,84,53,18,128,187,
+190,187,154,65,69,34,144,203,171,48,69,34,144,203,171,8,
+99,68,50,1,186,172,10,83,36,130,186,189,138,32,34,160,
+219,171,64,85,67,1,184,189,155,32,83,3,176,190,187,10,
+49,68,35,2,168,188,155,64,69,35,144,204,173,154,49,70,
+51,129,218,203,153,49,67,2,201,203,153,32,66,33,129,152,
+185,186,154,49,37,146,219,172,25,67,130,235,189,137,81,52,
+20,129,169,187,171,154,170,188,154,98,54,36,145,219,172,9,
+50,52,130,219,187,10,98,52,18,160,189,172,9,49,53,35,
+1,153,186,203,153,32,83,2,233,188,155,49,69,2,160,186,
+137,0,0,9,115,71,36,1,202,189,170,8,34,35,129,136,
+0,33,129,220,189,11
 };
+
+static const imaAdpcm_state_t ouch48k_wav_index[23] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+{-666, 0},
+{-31788, 72},
+{-3418, 72},
+{-19977, 68},
+{-27297, 72},
+{7929, 63},
+{-25371, 55},
+{722, 56},
+{4414, 59},
+{-8153, 42},
+{-1865, 35},
+{-3830, 43},
+{2357, 35},
+{-3834, 56},
+{8886, 77},
+{-16370, 71},
+{-26286, 76},
+{4035, 61},
+{-8183, 66},
+{-17063, 68},
+{-4055, 54},
+{-1011, 41},
+{202, 37}
+};
+
+const imaAdpcm_clip_t ouch48k_wav_clip = {ouch48k_wav_data, ouch48k_wav_index, 23467};
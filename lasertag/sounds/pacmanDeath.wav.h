@@ -1,5 +1,6 @@
-// This file was generated by executing this statement: wav2c pacmanDeath.wav
-extern uint16_t pacmanDeath_wav[];
-#define PACMANDEATH_WAV_SAMPLE_RATE 480000
+// This file was generated by executing this statement: wav2c -a pacmanDeath.wav
+#include "../imaAdpcm.h"
+extern const imaAdpcm_clip_t pacmanDeath_wav_clip;
+#define PACMANDEATH_WAV_SAMPLE_RATE 48000
 #define PACMANDEATH_WAV_BITS_PER_SAMPLE 16
 #define PACMANDEATH_WAV_NUMBER_OF_SAMPLES 82712
@@ -1,60486 +1,1961 @@
-// This file was generated by executing this statement: wav2c powerUp48k.wav
+// This file was generated by executing this statement: wav2c -a powerUp48k.wav
 
-#include <stdint.h>
+#include "powerUp48k.wav.h"
 
-uint16_t powerUp48k_wav[60480] = {
-32766,
-32768,
-32763,
-32763,
-32758,
-32758,
-32753,
-32750,
-32749,
-32742,
-32745,
-32739,
-32742,
-32737,
-32742,
-32738,
-32741,
-32745,
-32740,
-32748,
-32747,
-32747,
-32751,
-32745,
-32750,
-32744,
-32743,
-32739,
-32732,
-32725,
-32718,
-32704,
-32698,
-32681,
-32668,
-32655,
-32638,
-32622,
-32607,
-32589,
-32575,
-32559,
-32545,
-32532,
-32521,
-32514,
-32505,
-32500,
-32501,
-32496,
-32506,
-32508,
-32519,
-32532,
-32542,
-32566,
-32579,
-32604,
-32626,
-32652,
-32677,
-32705,
-32730,
-32760,
-32787,
-32816,
-32842,
-32868,
-32891,
-32920,
-32939,
-32964,
-32983,
-33003,
-33021,
-33040,
-33056,
-33074,
-33090,
-33105,
-33123,
-33137,
-33157,
-33172,
-33192,
-33209,
-33232,
-33249,
-33272,
-33295,
-33313,
-33341,
-33355,
-33383,
-33396,
-33420,
-33429,
-33444,
-33453,
-33455,
-33459,
-33449,
-33443,
-33421,
-33403,
-33370,
-33334,
-33290,
-33243,
-33181,
-33123,
-33052,
-32977,
-32903,
-32815,
-32735,
-32644,
-32559,
-32469,
-32384,
-32298,
-32218,
-32139,
-32070,
-32002,
-31948,
-31892,
-31856,
-31817,
-31797,
-31782,
-31775,
-31777,
-31792,
-31807,
-31839,
-31870,
-31908,
-31953,
-31999,
-32046,
-32101,
-32143,
-32198,
-32237,
-32286,
-32315,
-32355,
-32375,
-32398,
-32408,
-32417,
-32411,
-32407,
-32393,
-32373,
-32351,
-32325,
-32296,
-32265,
-32240,
-32209,
-32189,
-32171,
-32159,
-32158,
-32162,
-32179,
-32208,
-32247,
-32302,
-32365,
-32447,
-32535,
-32641,
-32753,
-32883,
-33012,
-33154,
-33301,
-33448,
-33603,
-33750,
-33895,
-34040,
-34167,
-34295,
-34399,
-34500,
-34576,
-34640,
-34679,
-34706,
-34707,
-34688,
-34650,
-34590,
-34514,
-34416,
-34304,
-34177,
-34035,
-33890,
-33724,
-33571,
-33396,
-33238,
-33074,
-32914,
-32773,
-32629,
-32512,
-32395,
-32309,
-32224,
-32176,
-32125,
-32112,
-32102,
-32120,
-32148,
-32191,
-32248,
-32312,
-32392,
-32464,
-32555,
-32630,
-32716,
-32785,
-32856,
-32908,
-32954,
-32983,
-32994,
-32993,
-32969,
-32932,
-32870,
-32802,
-32702,
-32603,
-32477,
-32351,
-32207,
-32064,
-31910,
-31766,
-31613,
-31476,
-31340,
-31218,
-31117,
-31019,
-30955,
-30899,
-30872,
-30868,
-30880,
-30926,
-30985,
-31074,
-31177,
-31302,
-31443,
-31597,
-31767,
-31936,
-32122,
-32299,
-32483,
-32658,
-32827,
-32985,
-33128,
-33263,
-33369,
-33469,
-33538,
-33593,
-33626,
-33637,
-33627,
-33603,
-33555,
-33499,
-33425,
-33344,
-33251,
-33161,
-33058,
-32971,
-32870,
-32794,
-32709,
-32657,
-32598,
-32571,
-32549,
-32552,
-32570,
-32608,
-32660,
-32733,
-32820,
-32921,
-33034,
-33156,
-33287,
-33422,
-33558,
-33698,
-33826,
-33960,
-34071,
-34186,
-34276,
-34364,
-34421,
-34482,
-34501,
-34531,
-34514,
-34509,
-34466,
-34424,
-34360,
-34289,
-34209,
-34121,
-34030,
-33933,
-33838,
-33746,
-33652,
-33568,
-33489,
-33412,
-33357,
-33288,
-33254,
-33201,
-33180,
-33146,
-33133,
-33109,
-33102,
-33081,
-33069,
-33048,
-33022,
-32992,
-32948,
-32896,
-32834,
-32750,
-32669,
-32554,
-32443,
-32309,
-32164,
-32012,
-31843,
-31677,
-31493,
-31320,
-31131,
-30962,
-30783,
-30621,
-30467,
-30325,
-30202,
-30092,
-30006,
-29937,
-29891,
-29867,
-29864,
-29885,
-29924,
-29987,
-30063,
-30160,
-30266,
-30388,
-30514,
-30652,
-30785,
-30929,
-31059,
-31197,
-31318,
-31438,
-31542,
-31643,
-31725,
-31804,
-31864,
-31921,
-31966,
-32004,
-32043,
-32074,
-32110,
-32147,
-32195,
-32248,
-32316,
-32403,
-32502,
-32627,
-32773,
-32935,
-33135,
-33341,
-33590,
-33844,
-34132,
-34428,
-34745,
-35071,
-35404,
-35742,
-36072,
-36404,
-36714,
-37014,
-37286,
-37532,
-37747,
-37924,
-38061,
-38157,
-38205,
-38210,
-38161,
-38071,
-37932,
-37745,
-37523,
-37252,
-36957,
-36621,
-36269,
-35886,
-35503,
-35098,
-34696,
-34303,
-33905,
-33538,
-33176,
-32846,
-32538,
-32260,
-32016,
-31800,
-31622,
-31471,
-31353,
-31266,
-31196,
-31161,
-31130,
-31122,
-31116,
-31117,
-31111,
-31106,
-31079,
-31043,
-30983,
-30897,
-30792,
-30651,
-30485,
-30288,
-30062,
-29816,
-29536,
-29245,
-28932,
-28611,
-28291,
-27961,
-27652,
-27348,
-27078,
-26825,
-26621,
-26447,
-26333,
-26264,
-26254,
-26309,
-26420,
-26603,
-26844,
-27150,
-27520,
-27941,
-28422,
-28945,
-29511,
-30117,
-30736,
-31390,
-32038,
-32700,
-33347,
-33980,
-34590,
-35166,
-35710,
-36198,
-36652,
-37033,
-37377,
-37645,
-37868,
-38018,
-38122,
-38163,
-38154,
-38103,
-37999,
-37871,
-37705,
-37517,
-37317,
-37103,
-36890,
-36678,
-36481,
-36292,
-36132,
-35990,
-35878,
-35795,
-35742,
-35719,
-35727,
-35760,
-35820,
-35898,
-35995,
-36098,
-36215,
-36321,
-36428,
-36517,
-36590,
-36633,
-36650,
-36625,
-36565,
-36457,
-36303,
-36102,
-35848,
-35547,
-35200,
-34801,
-34369,
-33886,
-33383,
-32842,
-32287,
-31713,
-31136,
-30555,
-29989,
-29431,
-28903,
-28398,
-27936,
-27513,
-27141,
-26822,
-26558,
-26348,
-26208,
-26114,
-26087,
-26114,
-26195,
-26330,
-26510,
-26732,
-26992,
-27283,
-27606,
-27939,
-28300,
-28658,
-29027,
-29392,
-29753,
-30100,
-30441,
-30754,
-31061,
-31335,
-31601,
-31832,
-32056,
-32243,
-32429,
-32580,
-32733,
-32857,
-32984,
-33096,
-33205,
-33316,
-33416,
-33533,
-33642,
-33762,
-33891,
-34018,
-34164,
-34306,
-34464,
-34618,
-34784,
-34946,
-35110,
-35274,
-35424,
-35580,
-35713,
-35840,
-35954,
-36046,
-36124,
-36182,
-36213,
-36232,
-36223,
-36192,
-36148,
-36070,
-35990,
-35881,
-35764,
-35629,
-35492,
-35338,
-35188,
-35030,
-34869,
-34720,
-34562,
-34419,
-34277,
-34146,
-34018,
-33906,
-33791,
-33691,
-33593,
-33500,
-33409,
-33319,
-33227,
-33133,
-33035,
-32925,
-32809,
-32683,
-32542,
-32395,
-32229,
-32051,
-31865,
-31664,
-31458,
-31244,
-31023,
-30806,
-30588,
-30380,
-30177,
-29997,
-29826,
-29686,
-29568,
-29479,
-29428,
-29405,
-29426,
-29482,
-29576,
-29712,
-29879,
-30088,
-30323,
-30592,
-30879,
-31193,
-31512,
-31847,
-32179,
-32505,
-32826,
-33121,
-33400,
-33647,
-33856,
-34036,
-34164,
-34255,
-34294,
-34290,
-34241,
-34144,
-34009,
-33829,
-33625,
-33386,
-33129,
-32860,
-32572,
-32304,
-32021,
-31774,
-31537,
-31336,
-31169,
-31042,
-30966,
-30932,
-30960,
-31031,
-31161,
-31338,
-31565,
-31834,
-32146,
-32484,
-32852,
-33236,
-33625,
-34018,
-34399,
-34759,
-35099,
-35393,
-35651,
-35856,
-36004,
-36095,
-36116,
-36082,
-35972,
-35805,
-35576,
-35288,
-34952,
-34570,
-34151,
-33709,
-33244,
-32781,
-32310,
-31863,
-31436,
-31045,
-30696,
-30403,
-30161,
-29992,
-29888,
-29855,
-29899,
-30011,
-30196,
-30447,
-30759,
-31124,
-31539,
-31986,
-32464,
-32955,
-33451,
-33942,
-34415,
-34859,
-35263,
-35620,
-35919,
-36159,
-36323,
-36422,
-36437,
-36384,
-36252,
-36049,
-35780,
-35447,
-35065,
-34634,
-34170,
-33680,
-33175,
-32670,
-32171,
-31695,
-31244,
-30838,
-30476,
-30175,
-29930,
-29758,
-29650,
-29619,
-29656,
-29762,
-29934,
-30167,
-30453,
-30789,
-31154,
-31557,
-31967,
-32395,
-32809,
-33217,
-33593,
-33941,
-34243,
-34495,
-34689,
-34820,
-34890,
-34885,
-34818,
-34677,
-34475,
-34210,
-33892,
-33518,
-33110,
-32663,
-32196,
-31714,
-31226,
-30747,
-30281,
-29844,
-29436,
-29076,
-28763,
-28503,
-28313,
-28175,
-28118,
-28118,
-28193,
-28333,
-28534,
-28801,
-29119,
-29486,
-29902,
-30345,
-30826,
-31319,
-31831,
-32343,
-32858,
-33353,
-33843,
-34298,
-34732,
-35132,
-35486,
-35810,
-36083,
-36315,
-36503,
-36643,
-36741,
-36800,
-36815,
-36798,
-36746,
-36664,
-36562,
-36432,
-36291,
-36136,
-35971,
-35806,
-35636,
-35472,
-35313,
-35162,
-35024,
-34896,
-34787,
-34685,
-34610,
-34541,
-34494,
-34459,
-34436,
-34432,
-34430,
-34445,
-34460,
-34483,
-34508,
-34528,
-34549,
-34556,
-34559,
-34546,
-34519,
-34472,
-34405,
-34311,
-34194,
-34047,
-33870,
-33663,
-33421,
-33152,
-32841,
-32508,
-32134,
-31741,
-31310,
-30867,
-30391,
-29908,
-29409,
-28903,
-28399,
-27899,
-27408,
-26941,
-26492,
-26082,
-25706,
-25376,
-25098,
-24879,
-24718,
-24628,
-24604,
-24654,
-24782,
-24976,
-25258,
-25596,
-26021,
-26498,
-27046,
-27640,
-28291,
-28972,
-29695,
-30431,
-31189,
-31940,
-32697,
-33425,
-34140,
-34813,
-35448,
-36033,
-36567,
-37035,
-37448,
-37786,
-38065,
-38273,
-38417,
-38502,
-38525,
-38498,
-38424,
-38307,
-38169,
-37990,
-37816,
-37618,
-37430,
-37251,
-37082,
-36943,
-36828,
-36745,
-36701,
-36689,
-36721,
-36783,
-36888,
-37013,
-37178,
-37348,
-37545,
-37736,
-37928,
-38111,
-38264,
-38394,
-38479,
-38516,
-38499,
-38415,
-38266,
-38037,
-37742,
-37354,
-36904,
-36360,
-35759,
-35077,
-34339,
-33548,
-32706,
-31840,
-30938,
-30037,
-29129,
-28241,
-27377,
-26552,
-25781,
-25067,
-24432,
-23872,
-23405,
-23032,
-22753,
-22583,
-22511,
-22541,
-22669,
-22891,
-23202,
-23595,
-24054,
-24583,
-25160,
-25777,
-26428,
-27091,
-27766,
-28433,
-29084,
-29717,
-30307,
-30869,
-31370,
-31836,
-32234,
-32585,
-32877,
-33111,
-33303,
-33436,
-33534,
-33593,
-33622,
-33634,
-33626,
-33621,
-33611,
-33619,
-33643,
-33692,
-33776,
-33895,
-34052,
-34262,
-34505,
-34802,
-35140,
-35518,
-35937,
-36381,
-36860,
-37345,
-37854,
-38353,
-38850,
-39330,
-39778,
-40195,
-40565,
-40881,
-41132,
-41325,
-41429,
-41471,
-41416,
-41288,
-41070,
-40772,
-40392,
-39935,
-39406,
-38813,
-38157,
-37458,
-36711,
-35938,
-35142,
-34336,
-33528,
-32734,
-31958,
-31211,
-30504,
-29846,
-29237,
-28691,
-28212,
-27795,
-27457,
-27184,
-26985,
-26862,
-26795,
-26805,
-26865,
-26982,
-27148,
-27348,
-27590,
-27850,
-28128,
-28420,
-28705,
-28992,
-29259,
-29515,
-29735,
-29940,
-30100,
-30230,
-30325,
-30373,
-30396,
-30372,
-30325,
-30240,
-30136,
-30008,
-29872,
-29720,
-29577,
-29428,
-29307,
-29195,
-29115,
-29068,
-29059,
-29097,
-29180,
-29319,
-29507,
-29758,
-30057,
-30416,
-30827,
-31284,
-31791,
-32331,
-32908,
-33508,
-34129,
-34751,
-35383,
-35995,
-36596,
-37162,
-37695,
-38181,
-38612,
-38986,
-39290,
-39525,
-39681,
-39767,
-39765,
-39696,
-39540,
-39321,
-39029,
-38675,
-38269,
-37813,
-37321,
-36804,
-36259,
-35720,
-35174,
-34644,
-34140,
-33665,
-33232,
-32850,
-32517,
-32253,
-32041,
-31907,
-31824,
-31822,
-31867,
-31979,
-32139,
-32340,
-32586,
-32846,
-33136,
-33418,
-33708,
-33971,
-34212,
-34417,
-34571,
-34673,
-34711,
-34678,
-34577,
-34394,
-34140,
-33809,
-33405,
-32931,
-32403,
-31811,
-31187,
-30524,
-29843,
-29154,
-28471,
-27809,
-27177,
-26597,
-26070,
-25614,
-25243,
-24954,
-24770,
-24678,
-24696,
-24817,
-25040,
-25369,
-25787,
-26295,
-26883,
-27532,
-28246,
-28993,
-29772,
-30563,
-31353,
-32124,
-32872,
-33565,
-34219,
-34790,
-35301,
-35724,
-36061,
-36313,
-36476,
-36545,
-36543,
-36451,
-36304,
-36084,
-35828,
-35523,
-35208,
-34873,
-34547,
-34236,
-33957,
-33716,
-33533,
-33404,
-33348,
-33366,
-33458,
-33629,
-33873,
-34194,
-34577,
-35020,
-35509,
-36034,
-36586,
-37143,
-37697,
-38227,
-38723,
-39169,
-39546,
-39852,
-40060,
-40180,
-40184,
-40086,
-39866,
-39539,
-39091,
-38546,
-37894,
-37150,
-36338,
-35442,
-34518,
-33539,
-32557,
-31566,
-30599,
-29660,
-28780,
-27960,
-27221,
-26577,
-26025,
-25598,
-25267,
-25067,
-24973,
-25003,
-25132,
-25368,
-25696,
-26099,
-26577,
-27101,
-27667,
-28254,
-28846,
-29435,
-29992,
-30521,
-30994,
-31410,
-31761,
-32030,
-32230,
-32343,
-32379,
-32339,
-32227,
-32055,
-31825,
-31559,
-31252,
-30942,
-30617,
-30311,
-30031,
-29784,
-29602,
-29470,
-29423,
-29452,
-29571,
-29785,
-30089,
-30490,
-30977,
-31550,
-32202,
-32911,
-33686,
-34489,
-35329,
-36169,
-37011,
-37819,
-38602,
-39315,
-39968,
-40535,
-41002,
-41369,
-41622,
-41750,
-41765,
-41648,
-41416,
-41066,
-40605,
-40042,
-39393,
-38661,
-37870,
-37030,
-36154,
-35269,
-34377,
-33508,
-32668,
-31876,
-31144,
-30482,
-29903,
-29411,
-29014,
-28714,
-28516,
-28406,
-28403,
-28476,
-28637,
-28870,
-29156,
-29503,
-29875,
-30282,
-30689,
-31101,
-31490,
-31861,
-32181,
-32468,
-32681,
-32845,
-32934,
-32954,
-32903,
-32782,
-32592,
-32345,
-32037,
-31685,
-31297,
-30878,
-30447,
-30012,
-29583,
-29181,
-28805,
-28482,
-28204,
-27998,
-27859,
-27803,
-27824,
-27939,
-28132,
-28417,
-28784,
-29228,
-29744,
-30325,
-30960,
-31638,
-32347,
-33078,
-33806,
-34542,
-35236,
-35918,
-36534,
-37104,
-37599,
-38017,
-38352,
-38590,
-38735,
-38781,
-38725,
-38576,
-38327,
-37992,
-37575,
-37082,
-36527,
-35917,
-35272,
-34590,
-33908,
-33206,
-32538,
-31879,
-31270,
-30707,
-30204,
-29775,
-29423,
-29153,
-28977,
-28888,
-28895,
-28991,
-29175,
-29441,
-29787,
-30199,
-30669,
-31191,
-31744,
-32329,
-32916,
-33514,
-34084,
-34644,
-35150,
-35620,
-36024,
-36365,
-36633,
-36818,
-36927,
-36947,
-36886,
-36747,
-36523,
-36233,
-35877,
-35464,
-35003,
-34509,
-33983,
-33454,
-32913,
-32389,
-31882,
-31413,
-30979,
-30602,
-30280,
-30023,
-29834,
-29715,
-29670,
-29691,
-29788,
-29936,
-30152,
-30411,
-30713,
-31046,
-31397,
-31761,
-32118,
-32468,
-32783,
-33075,
-33315,
-33506,
-33639,
-33702,
-33704,
-33629,
-33490,
-33279,
-33008,
-32673,
-32295,
-31866,
-31414,
-30932,
-30453,
-29966,
-29506,
-29072,
-28677,
-28346,
-28067,
-27874,
-27754,
-27729,
-27790,
-27952,
-28203,
-28552,
-28989,
-29504,
-30100,
-30754,
-31468,
-32218,
-33000,
-33793,
-34583,
-35363,
-36107,
-36813,
-37457,
-38042,
-38541,
-38964,
-39287,
-39522,
-39654,
-39694,
-39635,
-39488,
-39256,
-38945,
-38572,
-38138,
-37662,
-37153,
-36624,
-36089,
-35558,
-35043,
-34559,
-34107,
-33705,
-33347,
-33053,
-32810,
-32633,
-32504,
-32443,
-32414,
-32447,
-32498,
-32588,
-32686,
-32791,
-32893,
-32979,
-33035,
-33061,
-33037,
-32968,
-32838,
-32652,
-32398,
-32091,
-31712,
-31292,
-30808,
-30298,
-29742,
-29176,
-28600,
-28023,
-27478,
-26948,
-26481,
-26061,
-25716,
-25457,
-25283,
-25212,
-25241,
-25379,
-25623,
-25976,
-26425,
-26976,
-27605,
-28316,
-29085,
-29905,
-30758,
-31626,
-32498,
-33349,
-34170,
-34944,
-35652,
-36290,
-36836,
-37289,
-37642,
-37885,
-38025,
-38055,
-37982,
-37816,
-37556,
-37225,
-36822,
-36372,
-35884,
-35373,
-34861,
-34359,
-33882,
-33450,
-33067,
-32756,
-32516,
-32362,
-32294,
-32319,
-32429,
-32634,
-32914,
-33273,
-33695,
-34166,
-34682,
-35214,
-35763,
-36295,
-36809,
-37279,
-37697,
-38042,
-38308,
-38480,
-38558,
-38517,
-38386,
-38126,
-37775,
-37313,
-36758,
-36121,
-35410,
-34641,
-33825,
-32991,
-32136,
-31303,
-30481,
-29713,
-28995,
-28354,
-27795,
-27334,
-26972,
-26722,
-26582,
-26554,
-26635,
-26823,
-27100,
-27471,
-27912,
-28411,
-28963,
-29533,
-30127,
-30711,
-31273,
-31809,
-32282,
-32704,
-33045,
-33309,
-33481,
-33564,
-33549,
-33446,
-33253,
-32982,
-32630,
-32229,
-31760,
-31280,
-30754,
-30246,
-29731,
-29255,
-28818,
-28434,
-28125,
-27890,
-27750,
-27704,
-27758,
-27917,
-28176,
-28538,
-28992,
-29531,
-30151,
-30829,
-31566,
-32335,
-33127,
-33928,
-34715,
-35481,
-36209,
-36880,
-37491,
-38021,
-38474,
-38834,
-39100,
-39271,
-39346,
-39331,
-39227,
-39044,
-38788,
-38471,
-38109,
-37699,
-37278,
-36832,
-36398,
-35969,
-35573,
-35205,
-34885,
-34615,
-34401,
-34248,
-34156,
-34122,
-34153,
-34227,
-34359,
-34522,
-34722,
-34936,
-35166,
-35389,
-35601,
-35788,
-35938,
-36048,
-36097,
-36091,
-36013,
-35869,
-35645,
-35351,
-34984,
-34542,
-34045,
-33480,
-32871,
-32219,
-31538,
-30838,
-30126,
-29429,
-28730,
-28080,
-27447,
-26878,
-26353,
-25899,
-25510,
-25194,
-24958,
-24796,
-24709,
-24701,
-24758,
-24884,
-25074,
-25306,
-25595,
-25915,
-26261,
-26640,
-27017,
-27411,
-27797,
-28177,
-28548,
-28894,
-29232,
-29540,
-29834,
-30103,
-30354,
-30593,
-30817,
-31034,
-31252,
-31466,
-31695,
-31933,
-32190,
-32472,
-32777,
-33109,
-33480,
-33871,
-34309,
-34763,
-35251,
-35764,
-36292,
-36839,
-37390,
-37941,
-38483,
-39016,
-39513,
-39993,
-40421,
-40811,
-41143,
-41418,
-41628,
-41772,
-41844,
-41847,
-41775,
-41635,
-41427,
-41150,
-40817,
-40427,
-39988,
-39507,
-38991,
-38445,
-37882,
-37304,
-36718,
-36138,
-35561,
-34997,
-34450,
-33923,
-33422,
-32944,
-32497,
-32070,
-31676,
-31304,
-30956,
-30628,
-30322,
-30026,
-29746,
-29475,
-29210,
-28951,
-28692,
-28438,
-28177,
-27929,
-27665,
-27421,
-27166,
-26928,
-26695,
-26475,
-26275,
-26095,
-25941,
-25820,
-25729,
-25679,
-25670,
-25707,
-25788,
-25922,
-26097,
-26332,
-26602,
-26929,
-27289,
-27693,
-28130,
-28593,
-29084,
-29586,
-30101,
-30619,
-31130,
-31636,
-32118,
-32584,
-33014,
-33421,
-33778,
-34107,
-34385,
-34623,
-34820,
-34963,
-35078,
-35143,
-35180,
-35180,
-35151,
-35110,
-35038,
-34969,
-34882,
-34804,
-34724,
-34663,
-34605,
-34582,
-34560,
-34584,
-34617,
-34691,
-34783,
-34908,
-35055,
-35229,
-35420,
-35634,
-35856,
-36096,
-36330,
-36577,
-36810,
-37041,
-37257,
-37453,
-37633,
-37783,
-37909,
-38002,
-38064,
-38087,
-38082,
-38035,
-37951,
-37838,
-37682,
-37499,
-37280,
-37033,
-36758,
-36460,
-36136,
-35797,
-35439,
-35067,
-34688,
-34295,
-33905,
-33508,
-33112,
-32721,
-32329,
-31952,
-31576,
-31217,
-30864,
-30527,
-30200,
-29891,
-29592,
-29313,
-29045,
-28793,
-28558,
-28332,
-28130,
-27931,
-27758,
-27587,
-27439,
-27299,
-27173,
-27064,
-26961,
-26880,
-26808,
-26749,
-26711,
-26683,
-26671,
-26682,
-26701,
-26750,
-26807,
-26892,
-26997,
-27120,
-27271,
-27439,
-27638,
-27852,
-28102,
-28366,
-28663,
-28981,
-29322,
-29693,
-30081,
-30496,
-30930,
-31386,
-31863,
-32352,
-32863,
-33377,
-33910,
-34446,
-34984,
-35530,
-36059,
-36594,
-37105,
-37608,
-38084,
-38537,
-38960,
-39341,
-39694,
-39988,
-40248,
-40448,
-40599,
-40691,
-40728,
-40707,
-40624,
-40493,
-40296,
-40060,
-39766,
-39434,
-39063,
-38658,
-38228,
-37783,
-37318,
-36860,
-36393,
-35942,
-35503,
-35088,
-34695,
-34340,
-34008,
-33720,
-33463,
-33242,
-33060,
-32905,
-32781,
-32681,
-32596,
-32527,
-32462,
-32397,
-32325,
-32238,
-32129,
-32002,
-31833,
-31643,
-31403,
-31138,
-30825,
-30482,
-30102,
-29693,
-29260,
-28812,
-28349,
-27890,
-27435,
-26998,
-26588,
-26214,
-25884,
-25610,
-25392,
-25245,
-25171,
-25169,
-25252,
-25405,
-25640,
-25954,
-26329,
-26778,
-27274,
-27831,
-28417,
-29042,
-29676,
-30327,
-30970,
-31605,
-32214,
-32794,
-33333,
-33824,
-34268,
-34651,
-34980,
-35241,
-35454,
-35593,
-35692,
-35728,
-35723,
-35675,
-35594,
-35485,
-35355,
-35217,
-35064,
-34925,
-34783,
-34660,
-34555,
-34472,
-34415,
-34387,
-34389,
-34423,
-34484,
-34577,
-34695,
-34839,
-35001,
-35183,
-35374,
-35575,
-35778,
-35979,
-36170,
-36350,
-36514,
-36648,
-36768,
-36843,
-36892,
-36900,
-36865,
-36795,
-36673,
-36511,
-36306,
-36056,
-35766,
-35440,
-35077,
-34685,
-34269,
-33835,
-33385,
-32936,
-32480,
-32043,
-31615,
-31216,
-30846,
-30516,
-30226,
-29987,
-29799,
-29666,
-29589,
-29564,
-29598,
-29678,
-29808,
-29970,
-30175,
-30392,
-30640,
-30877,
-31123,
-31351,
-31554,
-31732,
-31864,
-31960,
-32002,
-31992,
-31928,
-31818,
-31650,
-31448,
-31198,
-30928,
-30634,
-30333,
-30035,
-29750,
-29496,
-29275,
-29104,
-28993,
-28946,
-28967,
-29070,
-29238,
-29493,
-29811,
-30201,
-30650,
-31142,
-31681,
-32239,
-32816,
-33389,
-33951,
-34488,
-34987,
-35435,
-35833,
-36160,
-36429,
-36618,
-36745,
-36799,
-36790,
-36726,
-36607,
-36452,
-36259,
-36051,
-35826,
-35600,
-35381,
-35175,
-34989,
-34827,
-34694,
-34583,
-34503,
-34441,
-34402,
-34367,
-34346,
-34310,
-34270,
-34208,
-34114,
-33990,
-33823,
-33611,
-33357,
-33053,
-32705,
-32318,
-31895,
-31447,
-30983,
-30508,
-30046,
-29591,
-29176,
-28792,
-28467,
-28195,
-28000,
-27870,
-27827,
-27853,
-27966,
-28149,
-28404,
-28719,
-29089,
-29502,
-29946,
-30412,
-30886,
-31356,
-31818,
-32252,
-32664,
-33034,
-33374,
-33666,
-33923,
-34141,
-34328,
-34485,
-34625,
-34748,
-34870,
-34994,
-35126,
-35281,
-35450,
-35654,
-35877,
-36132,
-36410,
-36708,
-37019,
-37332,
-37642,
-37932,
-38194,
-38414,
-38579,
-38678,
-38705,
-38642,
-38494,
-38246,
-37904,
-37470,
-36941,
-36335,
-35651,
-34910,
-34123,
-33303,
-32476,
-31649,
-30848,
-30085,
-29383,
-28742,
-28196,
-27731,
-27375,
-27114,
-26962,
-26905,
-26949,
-27080,
-27281,
-27556,
-27872,
-28227,
-28606,
-28981,
-29353,
-29698,
-30011,
-30280,
-30500,
-30659,
-30775,
-30818,
-30829,
-30776,
-30699,
-30586,
-30461,
-30324,
-30200,
-30083,
-30006,
-29951,
-29951,
-29995,
-30093,
-30243,
-30453,
-30705,
-31009,
-31344,
-31716,
-32102,
-32505,
-32905,
-33295,
-33675,
-34014,
-34339,
-34613,
-34855,
-35056,
-35212,
-35339,
-35428,
-35496,
-35540,
-35576,
-35603,
-35640,
-35681,
-35744,
-35820,
-35927,
-36049,
-36203,
-36367,
-36553,
-36741,
-36930,
-37111,
-37268,
-37396,
-37484,
-37524,
-37506,
-37427,
-37279,
-37066,
-36785,
-36446,
-36044,
-35606,
-35122,
-34629,
-34117,
-33626,
-33150,
-32719,
-32340,
-32031,
-31794,
-31643,
-31581,
-31603,
-31721,
-31904,
-32166,
-32481,
-32832,
-33212,
-33585,
-33946,
-34264,
-34524,
-34705,
-34798,
-34776,
-34649,
-34391,
-34021,
-33525,
-32925,
-32223,
-31440,
-30592,
-29706,
-28798,
-27899,
-27031,
-26217,
-25486,
-24845,
-24332,
-23935,
-23685,
-23578,
-23608,
-23791,
-24090,
-24522,
-25046,
-25665,
-26338,
-27067,
-27800,
-28551,
-29263,
-29951,
-30575,
-31136,
-31620,
-32025,
-32348,
-32593,
-32766,
-32877,
-32935,
-32962,
-32962,
-32963,
-32968,
-33005,
-33072,
-33199,
-33369,
-33619,
-33916,
-34291,
-34717,
-35195,
-35720,
-36268,
-36840,
-37405,
-37968,
-38495,
-38986,
-39427,
-39801,
-40113,
-40349,
-40510,
-40596,
-40614,
-40564,
-40462,
-40305,
-40114,
-39895,
-39653,
-39410,
-39153,
-38911,
-38670,
-38437,
-38217,
-37995,
-37775,
-37548,
-37295,
-37029,
-36712,
-36359,
-35951,
-35474,
-34945,
-34338,
-33668,
-32941,
-32154,
-31325,
-30471,
-29591,
-28731,
-27876,
-27078,
-26331,
-25670,
-25099,
-24644,
-24303,
-24093,
-24009,
-24052,
-24220,
-24492,
-24866,
-25318,
-25826,
-26375,
-26934,
-27485,
-28012,
-28475,
-28886,
-29203,
-29436,
-29576,
-29615,
-29568,
-29443,
-29246,
-29010,
-28739,
-28472,
-28223,
-28021,
-27890,
-27844,
-27917,
-28105,
-28435,
-28898,
-29502,
-30239,
-31093,
-32054,
-33090,
-34192,
-35310,
-36436,
-37519,
-38546,
-39472,
-40287,
-40952,
-41459,
-41799,
-41944,
-41925,
-41715,
-41344,
-40822,
-40167,
-39412,
-38569,
-37688,
-36774,
-35887,
-35024,
-34235,
-33532,
-32931,
-32459,
-32107,
-31894,
-31812,
-31852,
-32015,
-32267,
-32612,
-33011,
-33455,
-33918,
-34374,
-34808,
-35203,
-35532,
-35800,
-35978,
-36079,
-36087,
-36011,
-35857,
-35625,
-35339,
-34997,
-34621,
-34220,
-33810,
-33399,
-33002,
-32632,
-32277,
-31970,
-31682,
-31441,
-31222,
-31033,
-30865,
-30706,
-30563,
-30405,
-30256,
-30077,
-29897,
-29684,
-29463,
-29213,
-28963,
-28692,
-28431,
-28173,
-27938,
-27730,
-27559,
-27442,
-27375,
-27374,
-27443,
-27570,
-27782,
-28040,
-28370,
-28742,
-29157,
-29596,
-30049,
-30505,
-30937,
-31354,
-31720,
-32045,
-32309,
-32511,
-32657,
-32734,
-32763,
-32742,
-32683,
-32610,
-32520,
-32447,
-32395,
-32387,
-32435,
-32554,
-32750,
-33035,
-33408,
-33871,
-34414,
-35040,
-35716,
-36450,
-37198,
-37960,
-38697,
-39395,
-40028,
-40572,
-41015,
-41326,
-41513,
-41546,
-41439,
-41181,
-40784,
-40255,
-39614,
-38871,
-38059,
-37188,
-36290,
-35393,
-34509,
-33673,
-32898,
-32193,
-31593,
-31069,
-30668,
-30343,
-30129,
-29990,
-29921,
-29911,
-29930,
-29975,
-30019,
-30043,
-30039,
-29987,
-29886,
-29723,
-29508,
-29223,
-28906,
-28538,
-28159,
-27764,
-27393,
-27043,
-26758,
-26534,
-26403,
-26364,
-26446,
-26627,
-26937,
-27344,
-27859,
-28455,
-29123,
-29837,
-30574,
-31316,
-32029,
-32694,
-33294,
-33797,
-34209,
-34498,
-34677,
-34740,
-34688,
-34550,
-34314,
-34039,
-33702,
-33380,
-33051,
-32779,
-32561,
-32440,
-32414,
-32514,
-32729,
-33080,
-33537,
-34119,
-34773,
-35517,
-36287,
-37082,
-37855,
-38579,
-39231,
-39769,
-40186,
-40443,
-40545,
-40471,
-40230,
-39822,
-39265,
-38570,
-37776,
-36892,
-35969,
-35025,
-34104,
-33233,
-32440,
-31755,
-31193,
-30774,
-30498,
-30374,
-30388,
-30535,
-30791,
-31132,
-31540,
-31968,
-32408,
-32810,
-33155,
-33421,
-33576,
-33619,
-33528,
-33308,
-32962,
-32496,
-31932,
-31283,
-30583,
-29854,
-29123,
-28426,
-27785,
-27222,
-26768,
-26424,
-26213,
-26132,
-26179,
-26347,
-26622,
-26982,
-27412,
-27877,
-28362,
-28829,
-29267,
-29647,
-29951,
-30174,
-30305,
-30346,
-30306,
-30190,
-30029,
-29828,
-29634,
-29457,
-29336,
-29295,
-29361,
-29552,
-29891,
-30378,
-31027,
-31831,
-32766,
-33835,
-34989,
-36217,
-37470,
-38717,
-39910,
-41022,
-42005,
-42829,
-43474,
-43899,
-44119,
-44101,
-43864,
-43422,
-42777,
-41983,
-41046,
-40021,
-38943,
-37848,
-36788,
-35789,
-34894,
-34127,
-33507,
-33053,
-32767,
-32646,
-32681,
-32848,
-33132,
-33489,
-33901,
-34319,
-34713,
-35047,
-35291,
-35417,
-35407,
-35240,
-34922,
-34437,
-33812,
-33051,
-32177,
-31227,
-30215,
-29191,
-28177,
-27214,
-26324,
-25542,
-24878,
-24358,
-23984,
-23757,
-23674,
-23726,
-23882,
-24145,
-24465,
-24831,
-25213,
-25582,
-25921,
-26211,
-26435,
-26589,
-26672,
-26688,
-26652,
-26578,
-26490,
-26416,
-26378,
-26414,
-26539,
-26792,
-27180,
-27733,
-28445,
-29333,
-30378,
-31577,
-32899,
-34327,
-35817,
-37339,
-38850,
-40300,
-41666,
-42886,
-43945,
-44799,
-45434,
-45831,
-45986,
-45901,
-45586,
-45059,
-44353,
-43489,
-42521,
-41463,
-40390,
-39304,
-38283,
-37323,
-36482,
-35761,
-35190,
-34758,
-34485,
-34340,
-34318,
-34401,
-34544,
-34738,
-34936,
-35106,
-35230,
-35264,
-35200,
-35007,
-34688,
-34228,
-33641,
-32930,
-32119,
-31225,
-30283,
-29317,
-28369,
-27460,
-26633,
-25911,
-25318,
-24877,
-24595,
-24486,
-24541,
-24758,
-25119,
-25606,
-26192,
-26856,
-27551,
-28269,
-28956,
-29607,
-30177,
-30664,
-31038,
-31305,
-31451,
-31492,
-31427,
-31280,
-31064,
-30807,
-30531,
-30265,
-30024,
-29843,
-29726,
-29706,
-29773,
-29945,
-30214,
-30571,
-31012,
-31505,
-32048,
-32597,
-33147,
-33658,
-34116,
-34499,
-34786,
-34974,
-35049,
-35010,
-34877,
-34637,
-34332,
-33964,
-33570,
-33174,
-32800,
-32486,
-32243,
-32115,
-32096,
-32227,
-32488,
-32901,
-33449,
-34122,
-34905,
-35766,
-36688,
-37624,
-38562,
-39445,
-40260,
-40967,
-41539,
-41969,
-42218,
-42305,
-42200,
-41934,
-41499,
-40921,
-40221,
-39420,
-38550,
-37645,
-36717,
-35817,
-34947,
-34145,
-33417,
-32780,
-32232,
-31782,
-31416,
-31131,
-30901,
-30729,
-30567,
-30426,
-30258,
-30070,
-29828,
-29536,
-29171,
-28751,
-28261,
-27721,
-27141,
-26534,
-25930,
-25346,
-24799,
-24330,
-23945,
-23671,
-23530,
-23519,
-23661,
-23946,
-24376,
-24939,
-25620,
-26395,
-27248,
-28149,
-29070,
-29984,
-30863,
-31683,
-32426,
-33062,
-33600,
-34007,
-34304,
-34480,
-34553,
-34530,
-34432,
-34283,
-34095,
-33904,
-33722,
-33577,
-33485,
-33459,
-33514,
-33657,
-33880,
-34193,
-34580,
-35026,
-35525,
-36050,
-36583,
-37108,
-37595,
-38037,
-38408,
-38696,
-38892,
-38994,
-38990,
-38897,
-38706,
-38442,
-38106,
-37726,
-37308,
-36882,
-36450,
-36048,
-35674,
-35348,
-35078,
-34867,
-34719,
-34632,
-34596,
-34606,
-34653,
-34717,
-34792,
-34855,
-34902,
-34908,
-34877,
-34785,
-34642,
-34433,
-34166,
-33843,
-33469,
-33059,
-32617,
-32158,
-31694,
-31241,
-30799,
-30397,
-30019,
-29692,
-29399,
-29155,
-28941,
-28768,
-28607,
-28473,
-28327,
-28184,
-28013,
-27821,
-27588,
-27320,
-27008,
-26660,
-26279,
-25879,
-25467,
-25063,
-24687,
-24353,
-24087,
-23909,
-23832,
-23882,
-24060,
-24394,
-24863,
-25497,
-26266,
-27170,
-28200,
-29320,
-30524,
-31772,
-33043,
-34310,
-35534,
-36703,
-37774,
-38744,
-39584,
-40285,
-40842,
-41251,
-41519,
-41649,
-41661,
-41563,
-41383,
-41132,
-40841,
-40523,
-40200,
-39891,
-39599,
-39352,
-39134,
-38965,
-38834,
-38729,
-38656,
-38585,
-38519,
-38430,
-38315,
-38155,
-37942,
-37671,
-37329,
-36931,
-36461,
-35946,
-35377,
-34786,
-34173,
-33562,
-32970,
-32410,
-31897,
-31444,
-31060,
-30747,
-30504,
-30329,
-30211,
-30139,
-30091,
-30061,
-30009,
-29944,
-29819,
-29637,
-29378,
-29037,
-28604,
-28090,
-27498,
-26834,
-26139,
-25404,
-24683,
-23989,
-23349,
-22808,
-22372,
-22081,
-21944,
-21975,
-22189,
-22571,
-23138,
-23849,
-24709,
-25678,
-26732,
-27843,
-28977,
-30094,
-31177,
-32187,
-33104,
-33918,
-34604,
-35172,
-35613,
-35941,
-36172,
-36322,
-36415,
-36480,
-36536,
-36617,
-36739,
-36926,
-37192,
-37541,
-37983,
-38509,
-39106,
-39764,
-40451,
-41149,
-41823,
-42444,
-42981,
-43404,
-43690,
-43810,
-43768,
-43527,
-43115,
-42517,
-41754,
-40853,
-39824,
-38710,
-37542,
-36341,
-35167,
-34022,
-32963,
-31990,
-31147,
-30420,
-29842,
-29388,
-29068,
-28862,
-28752,
-28721,
-28740,
-28785,
-28839,
-28870,
-28869,
-28816,
-28703,
-28526,
-28292,
-28001,
-27674,
-27322,
-26965,
-26633,
-26335,
-26108,
-25956,
-25907,
-25967,
-26139,
-26433,
-26829,
-27331,
-27910,
-28551,
-29227,
-29911,
-30578,
-31197,
-31746,
-32203,
-32548,
-32778,
-32878,
-32856,
-32719,
-32479,
-32164,
-31784,
-31387,
-30979,
-30618,
-30309,
-30097,
-29994,
-30027,
-30203,
-30534,
-31010,
-31637,
-32384,
-33254,
-34195,
-35203,
-36233,
-37252,
-38239,
-39153,
-39970,
-40674,
-41232,
-41645,
-41898,
-41998,
-41939,
-41748,
-41417,
-40987,
-40466,
-39877,
-39255,
-38601,
-37959,
-37332,
-36738,
-36188,
-35693,
-35245,
-34859,
-34510,
-34214,
-33935,
-33687,
-33435,
-33186,
-32912,
-32620,
-32283,
-31919,
-31502,
-31054,
-30565,
-30046,
-29510,
-28956,
-28411,
-27878,
-27373,
-26907,
-26495,
-26144,
-25863,
-25657,
-25527,
-25482,
-25510,
-25618,
-25787,
-26024,
-26308,
-26642,
-27002,
-27393,
-27793,
-28205,
-28610,
-29019,
-29403,
-29791,
-30148,
-30499,
-30836,
-31158,
-31478,
-31788,
-32101,
-32416,
-32743,
-33074,
-33427,
-33788,
-34170,
-34568,
-34976,
-35402,
-35829,
-36265,
-36694,
-37115,
-37521,
-37898,
-38243,
-38552,
-38803,
-39009,
-39143,
-39214,
-39214,
-39136,
-38988,
-38761,
-38468,
-38106,
-37685,
-37217,
-36707,
-36169,
-35622,
-35062,
-34530,
-34011,
-33538,
-33112,
-32747,
-32451,
-32228,
-32078,
-32004,
-32001,
-32064,
-32179,
-32340,
-32528,
-32738,
-32935,
-33127,
-33277,
-33384,
-33433,
-33407,
-33311,
-33127,
-32874,
-32528,
-32133,
-31658,
-31152,
-30607,
-30050,
-29495,
-28965,
-28463,
-28026,
-27643,
-27346,
-27119,
-26987,
-26931,
-26962,
-27058,
-27219,
-27425,
-27671,
-27925,
-28201,
-28447,
-28689,
-28893,
-29062,
-29197,
-29292,
-29355,
-29404,
-29433,
-29475,
-29539,
-29635,
-29797,
-30021,
-30337,
-30744,
-31256,
-31871,
-32584,
-33393,
-34275,
-35222,
-36203,
-37202,
-38181,
-39120,
-39987,
-40753,
-41401,
-41899,
-42248,
-42418,
-42426,
-42254,
-41929,
-41450,
-40848,
-40141,
-39355,
-38525,
-37673,
-36836,
-36040,
-35300,
-34649,
-34091,
-33639,
-33304,
-33060,
-32932,
-32871,
-32890,
-32945,
-33025,
-33105,
-33156,
-33166,
-33105,
-32967,
-32744,
-32419,
-32016,
-31511,
-30951,
-30322,
-29666,
-29000,
-28339,
-27728,
-27176,
-26708,
-26355,
-26111,
-26010,
-26035,
-26202,
-26493,
-26900,
-27409,
-27991,
-28634,
-29297,
-29976,
-30618,
-31229,
-31757,
-32218,
-32568,
-32833,
-32975,
-33033,
-32983,
-32867,
-32678,
-32450,
-32199,
-31944,
-31713,
-31511,
-31379,
-31298,
-31310,
-31389,
-31556,
-31797,
-32100,
-32455,
-32846,
-33249,
-33651,
-34023,
-34354,
-34624,
-34816,
-34925,
-34944,
-34869,
-34713,
-34472,
-34178,
-33825,
-33462,
-33084,
-32741,
-32429,
-32200,
-32044,
-32005,
-32068,
-32265,
-32573,
-33010,
-33546,
-34178,
-34880,
-35633,
-36401,
-37170,
-37898,
-38563,
-39142,
-39605,
-39945,
-40140,
-40185,
-40083,
-39828,
-39445,
-38930,
-38323,
-37626,
-36880,
-36102,
-35316,
-34557,
-33830,
-33169,
-32578,
-32067,
-31648,
-31307,
-31056,
-30862,
-30736,
-30642,
-30571,
-30509,
-30426,
-30314,
-30160,
-29944,
-29677,
-29338,
-28949,
-28496,
-28021,
-27501,
-26998,
-26490,
-26039,
-25632,
-25312,
-25092,
-24971,
-24991,
-25120,
-25392,
-25780,
-26284,
-26890,
-27574,
-28322,
-29105,
-29900,
-30681,
-31425,
-32114,
-32722,
-33247,
-33665,
-33986,
-34195,
-34318,
-34339,
-34302,
-34195,
-34064,
-33906,
-33766,
-33640,
-33567,
-33551,
-33598,
-33740,
-33943,
-34244,
-34604,
-35039,
-35512,
-36025,
-36545,
-37060,
-37549,
-37991,
-38364,
-38667,
-38873,
-38984,
-38999,
-38905,
-38729,
-38460,
-38120,
-37729,
-37290,
-36838,
-36379,
-35932,
-35522,
-35148,
-34831,
-34579,
-34381,
-34263,
-34184,
-34174,
-34199,
-34252,
-34326,
-34396,
-34454,
-34489,
-34478,
-34426,
-34314,
-34146,
-33919,
-33633,
-33298,
-32918,
-32510,
-32075,
-31638,
-31198,
-30779,
-30381,
-30021,
-29693,
-29410,
-29169,
-28960,
-28787,
-28632,
-28494,
-28353,
-28204,
-28031,
-27831,
-27590,
-27319,
-27008,
-26661,
-26280,
-25878,
-25466,
-25064,
-24687,
-24351,
-24090,
-23906,
-23834,
-23880,
-24062,
-24389,
-24870,
-25491,
-26269,
-27169,
-28199,
-29322,
-30521,
-31773,
-33044,
-34308,
-35536,
-36701,
-37774,
-38744,
-39584,
-40284,
-40844,
-41251,
-41517,
-41651,
-41659,
-41563,
-41384,
-41132,
-40840,
-40524,
-40200,
-39888,
-39604,
-39346,
-39140,
-38962,
-38835,
-38729,
-38657,
-38583,
-38521,
-38428,
-38317,
-38153,
-37945,
-37668,
-37333,
-36927,
-36465,
-35942,
-35381,
-34781,
-34175,
-33561,
-32970,
-32411,
-31898,
-31445,
-31060,
-30744,
-30504,
-30328,
-30206,
-30139,
-30090,
-30063,
-30019,
-29950,
-29835,
-29653,
-29397,
-29052,
-28619,
-28094,
-27487,
-26814,
-26082,
-25333,
-24566,
-23841,
-23157,
-22574,
-22092,
-21761,
-21581,
-21583,
-21766,
-22134,
-22688,
-23405,
-24280,
-25272,
-26371,
-27526,
-28720,
-29904,
-31057,
-32141,
-33135,
-34018,
-34777,
-35398,
-35896,
-36263,
-36524,
-36693,
-36788,
-36852,
-36888,
-36952,
-37040,
-37198,
-37425,
-37748,
-38158,
-38659,
-39246,
-39887,
-40585,
-41287,
-41984,
-42629,
-43197,
-43661,
-43975,
-44149,
-44120,
-43927,
-43524,
-42946,
-42188,
-41274,
-40234,
-39088,
-37882,
-36639,
-35409,
-34211,
-33090,
-32062,
-31154,
-30383,
-29747,
-29258,
-28899,
-28666,
-28535,
-28491,
-28500,
-28548,
-28600,
-28637,
-28643,
-28596,
-28490,
-28322,
-28093,
-27807,
-27485,
-27137,
-26788,
-26461,
-26174,
-25957,
-25822,
-25791,
-25870,
-26068,
-26381,
-26806,
-27328,
-27921,
-28578,
-29250,
-29934,
-30576,
-31167,
-31670,
-32069,
-32346,
-32493,
-32505,
-32392,
-32159,
-31830,
-31425,
-30974,
-30511,
-30066,
-29679,
-29370,
-29184,
-29124,
-29230,
-29491,
-29928,
-30526,
-31275,
-32162,
-33151,
-34229,
-35343,
-36480,
-37587,
-38642,
-39611,
-40466,
-41188,
-41762,
-42180,
-42432,
-42540,
-42490,
-42316,
-42031,
-41645,
-41203,
-40700,
-40184,
-39653,
-39136,
-38639,
-38169,
-37733,
-37324,
-36946,
-36579,
-36225,
-35857,
-35474,
-35060,
-34601,
-34094,
-33530,
-32908,
-32232,
-31507,
-30742,
-29952,
-29148,
-28360,
-27587,
-26868,
-26204,
-25622,
-25129,
-24736,
-24453,
-24271,
-24211,
-24234,
-24369,
-24573,
-24855,
-25189,
-25562,
-25967,
-26378,
-26801,
-27212,
-27618,
-28007,
-28387,
-28754,
-29123,
-29486,
-29871,
-30263,
-30690,
-31148,
-31644,
-32178,
-32755,
-33363,
-34003,
-34662,
-35330,
-35988,
-36630,
-37231,
-37778,
-38266,
-38663,
-38979,
-39192,
-39303,
-39317,
-39222,
-39043,
-38773,
-38436,
-38037,
-37600,
-37128,
-36650,
-36173,
-35706,
-35272,
-34865,
-34499,
-34173,
-33887,
-33640,
-33426,
-33238,
-33071,
-32917,
-32768,
-32620,
-32467,
-32308,
-32140,
-31966,
-31790,
-31614,
-31448,
-31298,
-31172,
-31078,
-31021,
-31004,
-31039,
-31115,
-31240,
-31404,
-31600,
-31824,
-32055,
-32291,
-32511,
-32704,
-32861,
-32964,
-33009,
-32993,
-32903,
-32754,
-32536,
-32269,
-31955,
-31614,
-31257,
-30903,
-30570,
-30267,
-30027,
-29833,
-29727,
-29688,
-29735,
-29858,
-30053,
-30307,
-30616,
-30952,
-31308,
-31663,
-32000,
-32302,
-32564,
-32758,
-32902,
-32969,
-32982,
-32931,
-32840,
-32710,
-32570,
-32427,
-32307,
-32227,
-32202,
-32248,
-32378,
-32591,
-32902,
-33293,
-33771,
-34307,
-34900,
-35512,
-36141,
-36739,
-37298,
-37785,
-38182,
-38468,
-38630,
-38655,
-38546,
-38293,
-37917,
-37417,
-36816,
-36139,
-35400,
-34633,
-33859,
-33103,
-32395,
-31744,
-31177,
-30700,
-30322,
-30043,
-29867,
-29775,
-29766,
-29821,
-29919,
-30050,
-30186,
-30318,
-30421,
-30491,
-30511,
-30480,
-30396,
-30258,
-30079,
-29865,
-29633,
-29395,
-29173,
-28981,
-28842,
-28762,
-28766,
-28852,
-29039,
-29314,
-29693,
-30151,
-30692,
-31287,
-31939,
-32607,
-33283,
-33944,
-34561,
-35133,
-35621,
-36026,
-36337,
-36535,
-36641,
-36634,
-36539,
-36352,
-36100,
-35790,
-35443,
-35084,
-34715,
-34378,
-34066,
-33811,
-33611,
-33482,
-33420,
-33428,
-33499,
-33629,
-33800,
-34001,
-34215,
-34426,
-34614,
-34768,
-34861,
-34897,
-34848,
-34727,
-34513,
-34225,
-33855,
-33427,
-32946,
-32428,
-31902,
-31377,
-30880,
-30436,
-30050,
-29752,
-29554,
-29451,
-29469,
-29587,
-29816,
-30139,
-30540,
-31009,
-31519,
-32048,
-32578,
-33076,
-33531,
-33915,
-34216,
-34416,
-34521,
-34505,
-34398,
-34184,
-33891,
-33529,
-33116,
-32681,
-32239,
-31820,
-31443,
-31128,
-30895,
-30753,
-30709,
-30773,
-30933,
-31191,
-31522,
-31929,
-32364,
-32835,
-33295,
-33733,
-34122,
-34441,
-34672,
-34811,
-34832,
-34751,
-34555,
-34257,
-33873,
-33410,
-32894,
-32344,
-31783,
-31235,
-30724,
-30263,
-29888,
-29584,
-29391,
-29293,
-29303,
-29411,
-29614,
-29891,
-30242,
-30637,
-31065,
-31508,
-31945,
-32363,
-32749,
-33092,
-33384,
-33626,
-33813,
-33952,
-34056,
-34121,
-34178,
-34223,
-34280,
-34362,
-34476,
-34632,
-34848,
-35103,
-35431,
-35791,
-36207,
-36640,
-37100,
-37542,
-37979,
-38352,
-38679,
-38907,
-39039,
-39053,
-38935,
-38680,
-38286,
-37753,
-37093,
-36306,
-35433,
-34465,
-33452,
-32405,
-31358,
-30334,
-29374,
-28477,
-27699,
-27023,
-26493,
-26092,
-25840,
-25727,
-25743,
-25882,
-26118,
-26442,
-26821,
-27238,
-27674,
-28093,
-28501,
-28850,
-29162,
-29408,
-29595,
-29733,
-29812,
-29873,
-29903,
-29942,
-29998,
-30097,
-30254,
-30486,
-30805,
-31214,
-31725,
-32318,
-33004,
-33742,
-34542,
-35349,
-36158,
-36929,
-37633,
-38247,
-38741,
-39102,
-39303,
-39347,
-39223,
-38944,
-38518,
-37971,
-37316,
-36593,
-35836,
-35068,
-34338,
-33663,
-33083,
-32618,
-32277,
-32088,
-32026,
-32119,
-32317,
-32638,
-33022,
-33470,
-33926,
-34377,
-34780,
-35111,
-35348,
-35472,
-35468,
-35339,
-35082,
-34716,
-34244,
-33710,
-33116,
-32513,
-31922,
-31367,
-30892,
-30494,
-30220,
-30051,
-30017,
-30092,
-30285,
-30563,
-30911,
-31300,
-31702,
-32081,
-32420,
-32671,
-32833,
-32869,
-32781,
-32554,
-32204,
-31720,
-31144,
-30476,
-29762,
-29018,
-28288,
-27599,
-26982,
-26476,
-26090,
-25857,
-25780,
-25872,
-26131,
-26551,
-27110,
-27805,
-28596,
-29474,
-30393,
-31343,
-32278,
-33190,
-34045,
-34827,
-35524,
-36127,
-36627,
-37033,
-37340,
-37572,
-37719,
-37827,
-37872,
-37911,
-37927,
-37956,
-37995,
-38068,
-38158,
-38304,
-38458,
-38658,
-38866,
-39087,
-39298,
-39489,
-39635,
-39728,
-39742,
-39667,
-39482,
-39182,
-38751,
-38191,
-37497,
-36673,
-35728,
-34678,
-33529,
-32320,
-31057,
-29783,
-28516,
-27292,
-26140,
-25090,
-24168,
-23401,
-22799,
-22395,
-22176,
-22164,
-22345,
-22710,
-23248,
-23931,
-24740,
-25637,
-26599,
-27583,
-28568,
-29508,
-30392,
-31180,
-31868,
-32436,
-32886,
-33208,
-33427,
-33542,
-33584,
-33572,
-33526,
-33487,
-33461,
-33496,
-33585,
-33765,
-34031,
-34388,
-34836,
-35356,
-35928,
-36541,
-37147,
-37740,
-38265,
-38713,
-39038,
-39239,
-39274,
-39161,
-38874,
-38434,
-37857,
-37147,
-36361,
-35502,
-34634,
-33773,
-32972,
-32256,
-31658,
-31210,
-30915,
-30796,
-30838,
-31046,
-31393,
-31856,
-32410,
-33007,
-33625,
-34208,
-34736,
-35162,
-35462,
-35618,
-35606,
-35432,
-35088,
-34591,
-33956,
-33213,
-32383,
-31513,
-30624,
-29762,
-28956,
-28238,
-27630,
-27158,
-26826,
-26648,
-26616,
-26730,
-26965,
-27319,
-27753,
-28255,
-28798,
-29349,
-29900,
-30422,
-30898,
-31328,
-31689,
-31998,
-32241,
-32434,
-32582,
-32704,
-32797,
-32900,
-32994,
-33121,
-33267,
-33448,
-33668,
-33925,
-34211,
-34527,
-34859,
-35203,
-35540,
-35867,
-36160,
-36427,
-36639,
-36804,
-36908,
-36950,
-36935,
-36853,
-36717,
-36529,
-36290,
-36014,
-35702,
-35360,
-35003,
-34625,
-34242,
-33853,
-33463,
-33082,
-32707,
-32348,
-32006,
-31693,
-31404,
-31153,
-30941,
-30781,
-30664,
-30615,
-30615,
-30682,
-30809,
-30992,
-31232,
-31508,
-31829,
-32156,
-32505,
-32833,
-33142,
-33407,
-33615,
-33755,
-33817,
-33789,
-33681,
-33477,
-33204,
-32852,
-32451,
-32009,
-31550,
-31093,
-30659,
-30268,
-29937,
-29684,
-29512,
-29438,
-29452,
-29558,
-29745,
-30001,
-30310,
-30654,
-31015,
-31371,
-31711,
-32011,
-32266,
-32468,
-32605,
-32696,
-32724,
-32724,
-32688,
-32647,
-32610,
-32595,
-32623,
-32703,
-32840,
-33053,
-33325,
-33670,
-34063,
-34502,
-34962,
-35429,
-35876,
-36287,
-36639,
-36914,
-37099,
-37182,
-37159,
-37032,
-36802,
-36483,
-36089,
-35632,
-35143,
-34626,
-34125,
-33627,
-33184,
-32772,
-32434,
-32147,
-31929,
-31763,
-31652,
-31583,
-31537,
-31515,
-31489,
-31466,
-31424,
-31365,
-31283,
-31186,
-31070,
-30950,
-30833,
-30729,
-30652,
-30613,
-30618,
-30675,
-30791,
-30957,
-31178,
-31442,
-31732,
-32049,
-32355,
-32656,
-32915,
-33138,
-33291,
-33386,
-33400,
-33346,
-33224,
-33044,
-32816,
-32568,
-32300,
-32055,
-31825,
-31660,
-31538,
-31510,
-31540,
-31666,
-31854,
-32119,
-32421,
-32766,
-33111,
-33453,
-33754,
-34004,
-34181,
-34271,
-34270,
-34172,
-33981,
-33715,
-33373,
-32995,
-32592,
-32192,
-31826,
-31513,
-31280,
-31145,
-31117,
-31212,
-31417,
-31741,
-32154,
-32653,
-33200,
-33778,
-34353,
-34893,
-35379,
-35772,
-36068,
-36235,
-36283,
-36192,
-35985,
-35660,
-35246,
-34752,
-34226,
-33663,
-33128,
-32613,
-32167,
-31787,
-31504,
-31312,
-31216,
-31218,
-31287,
-31435,
-31612,
-31826,
-32030,
-32219,
-32368,
-32455,
-32488,
-32439,
-32329,
-32150,
-31917,
-31659,
-31368,
-31103,
-30847,
-30658,
-30527,
-30489,
-30541,
-30702,
-30959,
-31318,
-31749,
-32259,
-32799,
-33369,
-33926,
-34455,
-34927,
-35322,
-35623,
-35820,
-35904,
-35878,
-35741,
-35513,
-35199,
-34823,
-34398,
-33951,
-33497,
-33054,
-32635,
-32254,
-31913,
-31617,
-31362,
-31143,
-30955,
-30780,
-30623,
-30458,
-30290,
-30112,
-29920,
-29719,
-29523,
-29327,
-29169,
-29036,
-28978,
-28980,
-29085,
-29284,
-29598,
-30024,
-30557,
-31196,
-31914,
-32702,
-33527,
-34366,
-35188,
-35958,
-36669,
-37265,
-37764,
-38120,
-38351,
-38445,
-38418,
-38273,
-38044,
-37740,
-37388,
-37022,
-36647,
-36302,
-35985,
-35716,
-35489,
-35303,
-35156,
-35012,
-34878,
-34711,
-34501,
-34227,
-33864,
-33416,
-32860,
-32219,
-31480,
-30685,
-29835,
-28985,
-28145,
-27370,
-26685,
-26130,
-25720,
-25500,
-25450,
-25610,
-25944,
-26456,
-27109,
-27884,
-28734,
-29625,
-30518,
-31365,
-32145,
-32819,
-33369,
-33788,
-34059,
-34210,
-34233,
-34170,
-34031,
-33858,
-33677,
-33518,
-33410,
-33369,
-33417,
-33551,
-33777,
-34080,
-34445,
-34856,
-35273,
-35688,
-36050,
-36356,
-36567,
-36678,
-36677,
-36560,
-36341,
-36021,
-35634,
-35186,
-34722,
-34256,
-33817,
-33438,
-33116,
-32892,
-32742,
-32695,
-32714,
-32812,
-32946,
-33113,
-33280,
-33421,
-33522,
-33556,
-33518,
-33391,
-33181,
-32893,
-32528,
-32118,
-31665,
-31202,
-30753,
-30330,
-29964,
-29658,
-29436,
-29294,
-29237,
-29263,
-29353,
-29508,
-29703,
-29928,
-30165,
-30404,
-30630,
-30841,
-31032,
-31203,
-31361,
-31517,
-31674,
-31850,
-32053,
-32289,
-32577,
-32903,
-33278,
-33691,
-34131,
-34586,
-35037,
-35459,
-35844,
-36156,
-36394,
-36526,
-36561,
-36479,
-36292,
-36004,
-35628,
-35181,
-34688,
-34166,
-33644,
-33146,
-32683,
-32286,
-31954,
-31701,
-31526,
-31427,
-31389,
-31410,
-31460,
-31541,
-31620,
-31694,
-31745,
-31773,
-31764,
-31739,
-31678,
-31621,
-31556,
-31521,
-31514,
-31561,
-31670,
-31856,
-32111,
-32450,
-32850,
-33308,
-33804,
-34312,
-34816,
-35283,
-35690,
-36014,
-36240,
-36341,
-36330,
-36181,
-35918,
-35543,
-35074,
-34532,
-33946,
-33330,
-32724,
-32136,
-31599,
-31115,
-30704,
-30369,
-30098,
-29904,
-29751,
-29653,
-29573,
-29509,
-29448,
-29368,
-29284,
-29172,
-29058,
-28932,
-28825,
-28738,
-28704,
-28734,
-28846,
-29066,
-29386,
-29836,
-30390,
-31060,
-31822,
-32658,
-33542,
-34442,
-35331,
-36174,
-36938,
-37609,
-38147,
-38558,
-38818,
-38935,
-38915,
-38773,
-38526,
-38196,
-37815,
-37399,
-36971,
-36561,
-36168,
-35815,
-35493,
-35206,
-34936,
-34683,
-34408,
-34120,
-33772,
-33378,
-32903,
-32361,
-31739,
-31055,
-30324,
-29566,
-28811,
-28090,
-27432,
-26877,
-26449,
-26171,
-26065,
-26139,
-26390,
-26814,
-27394,
-28094,
-28905,
-29762,
-30650,
-31524,
-32349,
-33093,
-33739,
-34264,
-34670,
-34953,
-35123,
-35197,
-35202,
-35148,
-35085,
-35007,
-34961,
-34947,
-34980,
-35059,
-35184,
-35330,
-35499,
-35647,
-35763,
-35818,
-35787,
-35657,
-35412,
-35043,
-34568,
-33975,
-33311,
-32578,
-31825,
-31084,
-30384,
-29770,
-29264,
-28905,
-28692,
-28657,
-28775,
-29058,
-29474,
-30005,
-30611,
-31273,
-31931,
-32583,
-33166,
-33679,
-34090,
-34397,
-34593,
-34689,
-34694,
-34633,
-34517,
-34392,
-34257,
-34154,
-34095,
-34086,
-34146,
-34256,
-34424,
-34622,
-34840,
-35047,
-35218,
-35336,
-35364,
-35300,
-35116,
-34817,
-34398,
-33874,
-33257,
-32571,
-31847,
-31109,
-30394,
-29735,
-29150,
-28678,
-28322,
-28106,
-28024,
-28079,
-28260,
-28547,
-28934,
-29372,
-29867,
-30370,
-30874,
-31358,
-31796,
-32198,
-32539,
-32840,
-33087,
-33304,
-33494,
-33669,
-33849,
-34033,
-34245,
-34474,
-34732,
-35016,
-35309,
-35618,
-35909,
-36187,
-36419,
-36604,
-36716,
-36754,
-36700,
-36560,
-36328,
-36011,
-35617,
-35164,
-34654,
-34120,
-33568,
-33019,
-32487,
-31992,
-31533,
-31133,
-30780,
-30490,
-30249,
-30065,
-29918,
-29815,
-29744,
-29692,
-29674,
-29662,
-29678,
-29713,
-29763,
-29854,
-29966,
-30129,
-30329,
-30584,
-30886,
-31241,
-31643,
-32083,
-32560,
-33048,
-33551,
-34030,
-34499,
-34909,
-35278,
-35566,
-35789,
-35918,
-35976,
-35936,
-35838,
-35655,
-35431,
-35151,
-34850,
-34529,
-34204,
-33884,
-33578,
-33293,
-33025,
-32785,
-32556,
-32352,
-32144,
-31957,
-31755,
-31564,
-31360,
-31161,
-30957,
-30769,
-30589,
-30438,
-30326,
-30251,
-30238,
-30278,
-30385,
-30558,
-30787,
-31073,
-31402,
-31759,
-32142,
-32514,
-32884,
-33216,
-33518,
-33771,
-33974,
-34125,
-34235,
-34297,
-34339,
-34358,
-34373,
-34394,
-34430,
-34487,
-34571,
-34671,
-34789,
-34913,
-35026,
-35115,
-35159,
-35148,
-35064,
-34896,
-34646,
-34301,
-33891,
-33403,
-32885,
-32334,
-31801,
-31295,
-30862,
-30507,
-30270,
-30144,
-30152,
-30271,
-30511,
-30829,
-31213,
-31629,
-32036,
-32411,
-32714,
-32922,
-33017,
-32994,
-32843,
-32586,
-32234,
-31824,
-31382,
-30952,
-30566,
-30271,
-30081,
-30041,
-30136,
-30399,
-30794,
-31317,
-31931,
-32605,
-33286,
-33950,
-34533,
-35019,
-35366,
-35563,
-35598,
-35480,
-35229,
-34860,
-34426,
-33952,
-33488,
-33077,
-32748,
-32541,
-32460,
-32528,
-32723,
-33043,
-33440,
-33902,
-34358,
-34791,
-35138,
-35369,
-35455,
-35372,
-35121,
-34700,
-34137,
-33454,
-32699,
-31915,
-31151,
-30453,
-29872,
-29434,
-29169,
-29089,
-29189,
-29462,
-29877,
-30401,
-30991,
-31604,
-32192,
-32721,
-33149,
-33462,
-33643,
-33694,
-33628,
-33469,
-33246,
-33001,
-32772,
-32588,
-32507,
-32517,
-32676,
-32945,
-33348,
-33841,
-34404,
-34997,
-35564,
-36073,
-36468,
-36715,
-36790,
-36656,
-36332,
-35806,
-35107,
-34270,
-33329,
-32337,
-31349,
-30404,
-29560,
-28847,
-28298,
-27928,
-27747,
-27739,
-27896,
-28181,
-28571,
-29024,
-29500,
-29978,
-30411,
-30803,
-31118,
-31375,
-31564,
-31717,
-31844,
-31972,
-32136,
-32346,
-32642,
-33010,
-33488,
-34040,
-34684,
-35371,
-36093,
-36802,
-37475,
-38062,
-38542,
-38875,
-39053,
-39050,
-38873,
-38527,
-38020,
-37389,
-36654,
-35841,
-35005,
-34152,
-33333,
-32561,
-31854,
-31232,
-30683,
-30224,
-29832,
-29507,
-29232,
-28991,
-28784,
-28592,
-28425,
-28268,
-28146,
-28054,
-28018,
-28045,
-28156,
-28362,
-28672,
-29098,
-29628,
-30266,
-30986,
-31776,
-32602,
-33444,
-34257,
-35022,
-35697,
-36269,
-36711,
-37013,
-37170,
-37185,
-37071,
-36839,
-36524,
-36127,
-35704,
-35246,
-34811,
-34376,
-33994,
-33633,
-33323,
-33040,
-32782,
-32535,
-32289,
-32027,
-31744,
-31431,
-31091,
-30727,
-30349,
-29981,
-29632,
-29341,
-29112,
-28989,
-28973,
-29098,
-29348,
-29749,
-30271,
-30909,
-31642,
-32427,
-33248,
-34054,
-34819,
-35505,
-36090,
-36547,
-36864,
-37039,
-37066,
-36971,
-36747,
-36452,
-36066,
-35659,
-35219,
-34791,
-34380,
-33999,
-33654,
-33339,
-33052,
-32780,
-32510,
-32231,
-31921,
-31587,
-31209,
-30797,
-30359,
-29895,
-29449,
-29013,
-28640,
-28335,
-28136,
-28055,
-28113,
-28314,
-28661,
-29143,
-29748,
-30452,
-31225,
-32040,
-32858,
-33648,
-34387,
-35034,
-35594,
-36026,
-36353,
-36555,
-36663,
-36667,
-36610,
-36486,
-36338,
-36162,
-35985,
-35810,
-35642,
-35477,
-35316,
-35138,
-34944,
-34707,
-34433,
-34092,
-33702,
-33239,
-32728,
-32172,
-31582,
-30996,
-30409,
-29880,
-29398,
-29016,
-28726,
-28564,
-28512,
-28594,
-28787,
-29083,
-29473,
-29919,
-30415,
-30932,
-31438,
-31936,
-32379,
-32787,
-33132,
-33416,
-33652,
-33825,
-33968,
-34061,
-34144,
-34194,
-34245,
-34276,
-34309,
-34325,
-34331,
-34322,
-34281,
-34217,
-34115,
-33978,
-33806,
-33600,
-33373,
-33123,
-32880,
-32633,
-32423,
-32235,
-32103,
-32026,
-32000,
-32048,
-32142,
-32299,
-32490,
-32713,
-32951,
-33189,
-33414,
-33611,
-33776,
-33894,
-33969,
-33996,
-33983,
-33932,
-33853,
-33754,
-33644,
-33532,
-33427,
-33324,
-33241,
-33151,
-33085,
-33003,
-32924,
-32829,
-32709,
-32570,
-32394,
-32195,
-31962,
-31712,
-31447,
-31180,
-30923,
-30690,
-30497,
-30355,
-30273,
-30259,
-30328,
-30454,
-30675,
-30938,
-31270,
-31637,
-32037,
-32445,
-32857,
-33247,
-33615,
-33944,
-34226,
-34468,
-34648,
-34787,
-34869,
-34912,
-34905,
-34862,
-34776,
-34657,
-34497,
-34303,
-34067,
-33793,
-33478,
-33124,
-32730,
-32309,
-31858,
-31400,
-30938,
-30498,
-30086,
-29737,
-29452,
-29263,
-29178,
-29202,
-29355,
-29623,
-30011,
-30504,
-31085,
-31736,
-32435,
-33151,
-33867,
-34553,
-35187,
-35758,
-36247,
-36648,
-36967,
-37188,
-37346,
-37423,
-37454,
-37434,
-37382,
-37305,
-37208,
-37083,
-36944,
-36759,
-36532,
-36250,
-35884,
-35440,
-34894,
-34246,
-33498,
-32653,
-31729,
-30741,
-29731,
-28707,
-27733,
-26814,
-26015,
-25339,
-24832,
-24495,
-24352,
-24390,
-24611,
-24997,
-25518,
-26164,
-26889,
-27680,
-28503,
-29338,
-30172,
-30991,
-31789,
-32580,
-33346,
-34122,
-34890,
-35673,
-36469,
-37265,
-38068,
-38843,
-39578,
-40237,
-40791,
-41202,
-41446,
-41483,
-41300,
-40894,
-40244,
-39394,
-38338,
-37143,
-35834,
-34478,
-33121,
-31828,
-30646,
-29615,
-28776,
-28139,
-27717,
-27502,
-27466,
-27592,
-27824,
-28140,
-28484,
-28827,
-29140,
-29396,
-29595,
-29739,
-29835,
-29921,
-30015,
-30159,
-30383,
-30718,
-31177,
-31782,
-32516,
-33374,
-34320,
-35316,
-36306,
-37249,
-38075,
-38747,
-39207,
-39442,
-39412,
-39133,
-38605,
-37863,
-36944,
-35898,
-34779,
-33642,
-32539,
-31520,
-30613,
-29848,
-29234,
-28765,
-28441,
-28220,
-28100,
-28028,
-28000,
-27975,
-27954,
-27921,
-27892,
-27869,
-27891,
-27970,
-28150,
-28446,
-28896,
-29497,
-30274,
-31197,
-32257,
-33417,
-34629,
-35842,
-36999,
-38050,
-38932,
-39617,
-40058,
-40255,
-40192,
-39895,
-39383,
-38697,
-37889,
-37005,
-36092,
-35210,
-34376,
-33646,
-33006,
-32487,
-32057,
-31723,
-31433,
-31186,
-30930,
-30659,
-30341,
-29976,
-29561,
-29112,
-28648,
-28206,
-27807,
-27512,
-27331,
-27315,
-27474,
-27824,
-28361,
-29077,
-29935,
-30908,
-31948,
-33006,
-34036,
-34991,
-35830,
-36530,
-37061,
-37427,
-37624,
-37675,
-37595,
-37419,
-37172,
-36889,
-36589,
-36300,
-36023,
-35775,
-35532,
-35302,
-35047,
-34769,
-34423,
-34015,
-33518,
-32933,
-32269,
-31533,
-30761,
-29966,
-29204,
-28496,
-27892,
-27423,
-27117,
-26992,
-27058,
-27316,
-27742,
-28331,
-29027,
-29816,
-30642,
-31472,
-32263,
-32990,
-33620,
-34142,
-34547,
-34828,
-35009,
-35082,
-35086,
-35022,
-34917,
-34791,
-34647,
-34501,
-34356,
-34212,
-34062,
-33906,
-33733,
-33542,
-33328,
-33093,
-32834,
-32571,
-32302,
-32048,
-31828,
-31644,
-31526,
-31471,
-31493,
-31591,
-31764,
-31995,
-32287,
-32601,
-32947,
-33281,
-33607,
-33900,
-34158,
-34376,
-34549,
-34696,
-34805,
-34915,
-35005,
-35116,
-35234,
-35369,
-35522,
-35679,
-35830,
-35955,
-36036,
-36043,
-35970,
-35776,
-35473,
-35028,
-34470,
-33778,
-33000,
-32143,
-31241,
-30334,
-29458,
-28640,
-27927,
-27329,
-26875,
-26576,
-26422,
-26422,
-26547,
-26795,
-27118,
-27528,
-27956,
-28433,
-28897,
-29371,
-29835,
-30292,
-30750,
-31218,
-31700,
-32213,
-32754,
-33330,
-33934,
-34560,
-35188,
-35805,
-36377,
-36890,
-37314,
-37625,
-37818,
-37866,
-37786,
-37571,
-37239,
-36822,
-36328,
-35816,
-35287,
-34799,
-34364,
-34009,
-33748,
-33581,
-33513,
-33521,
-33605,
-33718,
-33858,
-33980,
-34073,
-34108,
-34078,
-33971,
-33792,
-33541,
-33245,
-32901,
-32555,
-32211,
-31893,
-31631,
-31411,
-31274,
-31185,
-31174,
-31192,
-31264,
-31332,
-31410,
-31460,
-31470,
-31437,
-31337,
-31183,
-30972,
-30706,
-30413,
-30088,
-29767,
-29452,
-29168,
-28928,
-28744,
-28623,
-28577,
-28601,
-28703,
-28884,
-29128,
-29454,
-29836,
-30288,
-30798,
-31363,
-31979,
-32644,
-33341,
-34073,
-34813,
-35558,
-36285,
-36972,
-37604,
-38155,
-38606,
-38943,
-39144,
-39215,
-39130,
-38922,
-38567,
-38107,
-37546,
-36911,
-36235,
-35527,
-34833,
-34152,
-33526,
-32944,
-32435,
-31988,
-31599,
-31282,
-30991,
-30762,
-30539,
-30355,
-30166,
-30007,
-29848,
-29718,
-29612,
-29551,
-29537,
-29594,
-29719,
-29933,
-30225,
-30600,
-31045,
-31552,
-32096,
-32661,
-33217,
-33746,
-34220,
-34622,
-34938,
-35150,
-35263,
-35274,
-35187,
-35023,
-34787,
-34500,
-34180,
-33841,
-33497,
-33159,
-32829,
-32516,
-32210,
-31912,
-31617,
-31313,
-31006,
-30684,
-30354,
-30026,
-29703,
-29409,
-29158,
-28969,
-28871,
-28872,
-28998,
-29251,
-29642,
-30160,
-30796,
-31529,
-32331,
-33170,
-34016,
-34817,
-35560,
-36196,
-36709,
-37081,
-37300,
-37368,
-37298,
-37094,
-36794,
-36407,
-35973,
-35504,
-35035,
-34574,
-34139,
-33732,
-33353,
-33002,
-32659,
-32327,
-31983,
-31624,
-31245,
-30844,
-30428,
-30012,
-29604,
-29238,
-28920,
-28692,
-28562,
-28555,
-28678,
-28938,
-29333,
-29844,
-30465,
-31159,
-31904,
-32669,
-33423,
-34139,
-34799,
-35376,
-35876,
-36279,
-36608,
-36851,
-37041,
-37169,
-37271,
-37333,
-37379,
-37400,
-37389,
-37347,
-37243,
-37080,
-36821,
-36472,
-36015,
-35441,
-34771,
-33997,
-33161,
-32275,
-31385,
-30519,
-29716,
-29016,
-28441,
-28016,
-27755,
-27655,
-27718,
-27914,
-28232,
-28628,
-29086,
-29558,
-30025,
-30459,
-30842,
-31172,
-31435,
-31647,
-31816,
-31951,
-32079,
-32199,
-32337,
-32490,
-32658,
-32843,
-33016,
-33184,
-33307,
-33382,
-33381,
-33308,
-33133,
-32892,
-32560,
-32187,
-31777,
-31369,
-30993,
-30676,
-30447,
-30336,
-30335,
-30478,
-30728,
-31098,
-31555,
-32072,
-32628,
-33191,
-33737,
-34252,
-34718,
-35132,
-35505,
-35830,
-36142,
-36439,
-36748,
-37079,
-37439,
-37814,
-38226,
-38615,
-38997,
-39308,
-39534,
-39633,
-39570,
-39336,
-38899,
-38267,
-37446,
-36454,
-35334,
-34112,
-32848,
-31581,
-30366,
-29245,
-28245,
-27403,
-26723,
-26213,
-25862,
-25657,
-25572,
-25586,
-25675,
-25811,
-25991,
-26187,
-26422,
-26674,
-26980,
-27334,
-27763,
-28281,
-28886,
-29591,
-30389,
-31260,
-32183,
-33130,
-34059,
-34939,
-35728,
-36394,
-36915,
-37263,
-37446,
-37451,
-37313,
-37033,
-36659,
-36217,
-35734,
-35259,
-34801,
-34389,
-34033,
-33732,
-33490,
-33283,
-33109,
-32943,
-32779,
-32600,
-32402,
-32190,
-31964,
-31759,
-31568,
-31445,
-31385,
-31428,
-31586,
-31863,
-32264,
-32780,
-33383,
-34061,
-34766,
-35471,
-36132,
-36717,
-37198,
-37539,
-37743,
-37792,
-37694,
-37461,
-37113,
-36665,
-36157,
-35590,
-35009,
-34402,
-33819,
-33217,
-32647,
-32060,
-31487,
-30906,
-30310,
-29719,
-29116,
-28530,
-27966,
-27445,
-26998,
-26633,
-26389,
-26261,
-26284,
-26436,
-26735,
-27147,
-27668,
-28256,
-28886,
-29531,
-30149,
-30724,
-31224,
-31650,
-31985,
-32242,
-32430,
-32561,
-32668,
-32761,
-32867,
-33001,
-33174,
-33383,
-33643,
-33912,
-34213,
-34489,
-34750,
-34957,
-35101,
-35176,
-35173,
-35099,
-34972,
-34799,
-34619,
-34446,
-34313,
-34243,
-34251,
-34353,
-34552,
-34838,
-35204,
-35625,
-36076,
-36531,
-36958,
-37333,
-37631,
-37839,
-37947,
-37946,
-37853,
-37664,
-37407,
-37085,
-36723,
-36326,
-35910,
-35480,
-35031,
-34568,
-34077,
-33549,
-32986,
-32365,
-31704,
-30986,
-30239,
-29467,
-28692,
-27958,
-27264,
-26675,
-26192,
-25854,
-25675,
-25662,
-25817,
-26136,
-26591,
-27170,
-27827,
-28544,
-29277,
-29998,
-30683,
-31298,
-31844,
-32300,
-32676,
-32967,
-33195,
-33357,
-33480,
-33564,
-33629,
-33666,
-33695,
-33689,
-33668,
-33603,
-33499,
-33345,
-33134,
-32878,
-32565,
-32228,
-31864,
-31508,
-31170,
-30889,
-30673,
-30558,
-30538,
-30647,
-30858,
-31197,
-31620,
-32140,
-32708,
-33326,
-33947,
-34569,
-35162,
-35717,
-36229,
-36688,
-37102,
-37472,
-37808,
-38113,
-38396,
-38653,
-38888,
-39087,
-39240,
-39335,
-39342,
-39255,
-39038,
-38690,
-38194,
-37543,
-36751,
-35821,
-34780,
-33659,
-32486,
-31307,
-30159,
-29078,
-28107,
-27266,
-26591,
-26076,
-25751,
-25590,
-25605,
-25759,
-26050,
-26446,
-26924,
-27468,
-28056,
-28667,
-29305,
-29931,
-30572,
-31194,
-31813,
-32412,
-32990,
-33534,
-34047,
-34495,
-34895,
-35204,
-35432,
-35558,
-35577,
-35487,
-35289,
-34993,
-34606,
-34155,
-33644,
-33120,
-32579,
-32072,
-31600,
-31192,
-30861,
-30613,
-30460,
-30394,
-30418,
-30524,
-30701,
-30944,
-31238,
-31577,
-31953,
-32356,
-32788,
-33237,
-33703,
-34185,
-34665,
-35164,
-35638,
-36110,
-36544,
-36943,
-37283,
-37547,
-37730,
-37809,
-37779,
-37631,
-37362,
-36969,
-36463,
-35848,
-35139,
-34349,
-33501,
-32609,
-31696,
-30788,
-29896,
-29049,
-28260,
-27547,
-26932,
-26423,
-26035,
-25784,
-25663,
-25702,
-25881,
-26220,
-26699,
-27325,
-28075,
-28943,
-29904,
-30938,
-32019,
-33121,
-34211,
-35268,
-36253,
-37160,
-37941,
-38608,
-39119,
-39487,
-39695,
-39747,
-39655,
-39409,
-39042,
-38545,
-37953,
-37261,
-36502,
-35681,
-34815,
-33930,
-33025,
-32137,
-31263,
-30437,
-29664,
-28973,
-28364,
-27874,
-27493,
-27254,
-27151,
-27192,
-27379,
-27708,
-28166,
-28747,
-29430,
-30197,
-31028,
-31895,
-32778,
-33655,
-34497,
-35298,
-36013,
-36662,
-37198,
-37638,
-37954,
-38151,
-38228,
-38175,
-38004,
-37703,
-37292,
-36764,
-36134,
-35406,
-34600,
-33716,
-32786,
-31818,
-30831,
-29862,
-28910,
-28026,
-27207,
-26502,
-25910,
-25467,
-25174,
-25054,
-25110,
-25343,
-25753,
-26333,
-27066,
-27943,
-28934,
-30024,
-31180,
-32375,
-33580,
-34766,
-35907,
-36964,
-37935,
-38769,
-39479,
-40027,
-40415,
-40640,
-40690,
-40579,
-40304,
-39889,
-39326,
-38658,
-37868,
-37009,
-36071,
-35096,
-34085,
-33073,
-32068,
-31097,
-30167,
-29307,
-28523,
-27833,
-27256,
-26787,
-26454,
-26252,
-26187,
-26267,
-26477,
-26828,
-27296,
-27880,
-28563,
-29326,
-30151,
-31022,
-31906,
-32801,
-33666,
-34496,
-35263,
-35961,
-36565,
-37077,
-37473,
-37761,
-37932,
-37980,
-37924,
-37739,
-37470,
-37083,
-36629,
-36088,
-35497,
-34857,
-34200,
-33519,
-32868,
-32225,
-31642,
-31107,
-30652,
-30276,
-29994,
-29805,
-29715,
-29720,
-29812,
-29987,
-30234,
-30537,
-30893,
-31277,
-31690,
-32101,
-32521,
-32918,
-33301,
-33647,
-33962,
-34222,
-34444,
-34602,
-34700,
-34742,
-34703,
-34606,
-34437,
-34195,
-33900,
-33535,
-33136,
-32691,
-32228,
-31756,
-31297,
-30859,
-30471,
-30134,
-29869,
-29683,
-29585,
-29573,
-29649,
-29810,
-30039,
-30345,
-30694,
-31091,
-31512,
-31951,
-32396,
-32831,
-33258,
-33653,
-34029,
-34362,
-34667,
-34920,
-35134,
-35295,
-35400,
-35459,
-35447,
-35383,
-35255,
-35070,
-34829,
-34536,
-34203,
-33833,
-33450,
-33045,
-32657,
-32281,
-31936,
-31639,
-31383,
-31201,
-31073,
-31024,
-31032,
-31118,
-31257,
-31456,
-31707,
-31989,
-32320,
-32655,
-33016,
-33375,
-33725,
-34066,
-34370,
-34645,
-34869,
-35039,
-35144,
-35182,
-35136,
-35027,
-34823,
-34559,
-34216,
-33818,
-33373,
-32888,
-32392,
-31888,
-31404,
-30946,
-30540,
-30182,
-29905,
-29690,
-29563,
-29510,
-29542,
-29643,
-29822,
-30065,
-30365,
-30725,
-31124,
-31571,
-32047,
-32551,
-33077,
-33603,
-34141,
-34653,
-35150,
-35601,
-36000,
-36333,
-36581,
-36737,
-36796,
-36743,
-36582,
-36319,
-35946,
-35496,
-34957,
-34366,
-33730,
-33070,
-32409,
-31756,
-31141,
-30564,
-30050,
-29598,
-29223,
-28925,
-28710,
-28579,
-28529,
-28568,
-28683,
-28884,
-29164,
-29518,
-29947,
-30439,
-30997,
-31597,
-32251,
-32911,
-33599,
-34264,
-34909,
-35501,
-36023,
-36459,
-36786,
-36996,
-37073,
-37016,
-36826,
-36500,
-36061,
-35512,
-34877,
-34183,
-33441,
-32685,
-31939,
-31215,
-30551,
-29945,
-29427,
-28996,
-28676,
-28458,
-28354,
-28365,
-28485,
-28723,
-29064,
-29513,
-30051,
-30682,
-31375,
-32137,
-32925,
-33748,
-34553,
-35351,
-36083,
-36762,
-37347,
-37833,
-38200,
-38447,
-38564,
-38554,
-38423,
-38169,
-37811,
-37348,
-36803,
-36172,
-35478,
-34725,
-33930,
-33095,
-32251,
-31386,
-30547,
-29728,
-28966,
-28269,
-27666,
-27181,
-26814,
-26604,
-26538,
-26634,
-26883,
-27285,
-27814,
-28473,
-29215,
-30043,
-30911,
-31812,
-32713,
-33598,
-34452,
-35248,
-35995,
-36657,
-37240,
-37734,
-38115,
-38400,
-38556,
-38586,
-38490,
-38246,
-37869,
-37357,
-36708,
-35949,
-35084,
-34141,
-33147,
-32123,
-31104,
-30118,
-29196,
-28358,
-27631,
-27031,
-26572,
-26261,
-26104,
-26094,
-26235,
-26517,
-26929,
-27462,
-28104,
-28835,
-29651,
-30521,
-31439,
-32375,
-33316,
-34232,
-35106,
-35910,
-36626,
-37236,
-37720,
-38075,
-38281,
-38354,
-38284,
-38084,
-37777,
-37356,
-36865,
-36305,
-35696,
-35067,
-34418,
-33773,
-33139,
-32524,
-31942,
-31398,
-30905,
-30460,
-30089,
-29785,
-29570,
-29441,
-29414,
-29485,
-29653,
-29924,
-30279,
-30709,
-31208,
-31741,
-32314,
-32888,
-33461,
-34007,
-34525,
-34992,
-35418,
-35774,
-36075,
-36303,
-36454,
-36526,
-36509,
-36390,
-36178,
-35847,
-35420,
-34879,
-34254,
-33542,
-32777,
-31977,
-31173,
-30399,
-29672,
-29037,
-28493,
-28075,
-27780,
-27610,
-27569,
-27635,
-27813,
-28074,
-28421,
-28836,
-29310,
-29851,
-30438,
-31085,
-31776,
-32513,
-33276,
-34057,
-34826,
-35565,
-36242,
-36831,
-37302,
-37640,
-37824,
-37855,
-37738,
-37477,
-37104,
-36637,
-36107,
-35542,
-34967,
-34397,
-33848,
-33327,
-32829,
-32361,
-31900,
-31463,
-31026,
-30611,
-30213,
-29851,
-29544,
-29304,
-29160,
-29113,
-29187,
-29364,
-29661,
-30030,
-30487,
-30962,
-31469,
-31949,
-32400,
-32802,
-33144,
-33437,
-33685,
-33899,
-34098,
-34295,
-34495,
-34704,
-34920,
-35122,
-35305,
-35435,
-35502,
-35475,
-35358,
-35127,
-34811,
-34393,
-33938,
-33423,
-32929,
-32445,
-32023,
-31667,
-31392,
-31197,
-31079,
-31018,
-31009,
-31022,
-31059,
-31095,
-31137,
-31188,
-31244,
-31340,
-31458,
-31633,
-31857,
-32134,
-32457,
-32811,
-33175,
-33530,
-33848,
-34112,
-34303,
-34413,
-34445,
-34396,
-34290,
-34137,
-33960,
-33782,
-33611,
-33463,
-33348,
-33254,
-33184,
-33126,
-33063,
-32997,
-32903,
-32791,
-32654,
-32500,
-32330,
-32169,
-32002,
-31873,
-31751,
-31669,
-31604,
-31560,
-31526,
-31500,
-31460,
-31422,
-31358,
-31295,
-31222,
-31159,
-31112,
-31092,
-31118,
-31186,
-31311,
-31490,
-31714,
-31992,
-32292,
-32630,
-32974,
-33333,
-33690,
-34044,
-34387,
-34724,
-35034,
-35335,
-35590,
-35825,
-35990,
-36112,
-36153,
-36120,
-36009,
-35807,
-35544,
-35205,
-34828,
-34411,
-33984,
-33562,
-33150,
-32769,
-32414,
-32089,
-31786,
-31502,
-31229,
-30961,
-30699,
-30442,
-30201,
-29986,
-29809,
-29686,
-29631,
-29649,
-29751,
-29923,
-30171,
-30465,
-30804,
-31156,
-31513,
-31861,
-32184,
-32492,
-32772,
-33046,
-33313,
-33582,
-33857,
-34142,
-34423,
-34690,
-34929,
-35101,
-35211,
-35212,
-35113,
-34897,
-34580,
-34172,
-33704,
-33203,
-32706,
-32247,
-31851,
-31538,
-31319,
-31191,
-31145,
-31165,
-31228,
-31323,
-31420,
-31529,
-31632,
-31750,
-31888,
-32071,
-32303,
-32615,
-32992,
-33438,
-33944,
-34458,
-34978,
-35432,
-35812,
-36065,
-36182,
-36143,
-35961,
-35650,
-35234,
-34759,
-34242,
-33742,
-33255,
-32826,
-32432,
-32089,
-31764,
-31454,
-31125,
-30780,
-30405,
-30009,
-29611,
-29245,
-28940,
-28735,
-28662,
-28743,
-28988,
-29393,
-29928,
-30566,
-31255,
-31948,
-32594,
-33163,
-33616,
-33963,
-34190,
-34341,
-34431,
-34506,
-34603,
-34742,
-34946,
-35200,
-35505,
-35806,
-36085,
-36276,
-36351,
-36277,
-36031,
-35625,
-35070,
-34411,
-33695,
-32970,
-32304,
-31717,
-31274,
-30951,
-30778,
-30708,
-30727,
-30790,
-30859,
-30911,
-30919,
-30889,
-30826,
-30762,
-30723,
-30754,
-30878,
-31125,
-31496,
-31986,
-32562,
-33185,
-33806,
-34356,
-34810,
-35095,
-35219,
-35151,
-34920,
-34554,
-34094,
-33594,
-33101,
-32659,
-32303,
-32033,
-31872,
-31777,
-31743,
-31726,
-31694,
-31638,
-31522,
-31367,
-31177,
-30979,
-30819,
-30718,
-30720,
-30851,
-31106,
-31506,
-31999,
-32574,
-33177,
-33758,
-34285,
-34703,
-35013,
-35188,
-35249,
-35215,
-35113,
-34991,
-34866,
-34779,
-34734,
-34732,
-34771,
-34810,
-34837,
-34800,
-34689,
-34473,
-34155,
-33736,
-33249,
-32712,
-32184,
-31685,
-31267,
-30948,
-30735,
-30640,
-30627,
-30683,
-30776,
-30857,
-30924,
-30933,
-30901,
-30824,
-30725,
-30638,
-30593,
-30618,
-30742,
-30969,
-31301,
-31719,
-32192,
-32682,
-33150,
-33553,
-33865,
-34064,
-34147,
-34124,
-34016,
-33851,
-33665,
-33486,
-33336,
-33234,
-33172,
-33154,
-33149,
-33149,
-33119,
-33062,
-32944,
-32799,
-32612,
-32426,
-32256,
-32142,
-32096,
-32153,
-32293,
-32540,
-32844,
-33207,
-33569,
-33914,
-34201,
-34415,
-34544,
-34587,
-34559,
-34476,
-34372,
-34254,
-34166,
-34094,
-34064,
-34054,
-34057,
-34046,
-34012,
-33920,
-33778,
-33569,
-33302,
-33001,
-32674,
-32360,
-32066,
-31828,
-31637,
-31512,
-31425,
-31376,
-31332,
-31276,
-31185,
-31051,
-30864,
-30641,
-30391,
-30144,
-29919,
-29759,
-29675,
-29685,
-29799,
-30004,
-30289,
-30632,
-30997,
-31373,
-31723,
-32047,
-32327,
-32577,
-32815,
-33040,
-33307,
-33587,
-33940,
-34327,
-34764,
-35220,
-35667,
-36073,
-36406,
-36633,
-36731,
-36696,
-36525,
-36239,
-35861,
-35426,
-34969,
-34523,
-34117,
-33762,
-33464,
-33218,
-32999,
-32792,
-32570,
-32303,
-31999,
-31635,
-31235,
-30825,
-30421,
-30086,
-29830,
-29708,
-29716,
-29876,
-30170,
-30569,
-31044,
-31535,
-32019,
-32432,
-32774,
-33005,
-33157,
-33228,
-33269,
-33300,
-33378,
-33514,
-33736,
-34037,
-34393,
-34775,
-35123,
-35388,
-35519,
-35471,
-35226,
-34781,
-34163,
-33417,
-32599,
-31784,
-31031,
-30409,
-29942,
-29661,
-29546,
-29578,
-29707,
-29892,
-30069,
-30220,
-30310,
-30351,
-30362,
-30390,
-30476,
-30686,
-31051,
-31602,
-32341,
-33235,
-34236,
-35265,
-36247,
-37091,
-37732,
-38111,
-38220,
-38056,
-37670,
-37116,
-36468,
-35813,
-35206,
-34697,
-34311,
-34027,
-33826,
-33648,
-33431,
-33128,
-32684,
-32098,
-31363,
-30537,
-29668,
-28843,
-28151,
-27657,
-27422,
-27475,
-27811,
-28393,
-29157,
-30024,
-30902,
-31719,
-32404,
-32924,
-33270,
-33458,
-33537,
-33559,
-33586,
-33673,
-33846,
-34127,
-34490,
-34903,
-35305,
-35628,
-35814,
-35806,
-35584,
-35137,
-34497,
-33717,
-32863,
-32022,
-31268,
-30666,
-30267,
-30086,
-30119,
-30339,
-30679,
-31103,
-31520,
-31906,
-32204,
-32405,
-32519,
-32563,
-32590,
-32646,
-32772,
-33019,
-33402,
-33921,
-34567,
-35280,
-36021,
-36706,
-37278,
-37671,
-37836,
-37752,
-37410,
-36831,
-36066,
-35150,
-34184,
-33193,
-32281,
-31460,
-30788,
-30257,
-29875,
-29601,
-29413,
-29267,
-29126,
-28964,
-28767,
-28539,
-28303,
-28093,
-27956,
-27936,
-28090,
-28423,
-28976,
-29713,
-30616,
-31617,
-32659,
-33647,
-34526,
-35212,
-35685,
-35906,
-35903,
-35710,
-35378,
-34993,
-34616,
-34316,
-34145,
-34110,
-34220,
-34430,
-34687,
-34936,
-35084,
-35108,
-34943,
-34597,
-34089,
-33468,
-32807,
-32198,
-31709,
-31425,
-31380,
-31594,
-32041,
-32669,
-33394,
-34132,
-34776,
-35259,
-35510,
-35518,
-35284,
-34855,
-34296,
-33692,
-33114,
-32649,
-32322,
-32168,
-32153,
-32245,
-32368,
-32458,
-32436,
-32249,
-31877,
-31314,
-30608,
-29814,
-29025,
-28322,
-27799,
-27509,
-27497,
-27758,
-28264,
-28958,
-29755,
-30580,
-31341,
-31993,
-32487,
-32826,
-33033,
-33153,
-33250,
-33387,
-33616,
-33977,
-34470,
-35082,
-35760,
-36443,
-37048,
-37506,
-37751,
-37750,
-37492,
-36992,
-36312,
-35501,
-34659,
-33851,
-33141,
-32593,
-32198,
-31984,
-31890,
-31893,
-31931,
-31953,
-31931,
-31835,
-31674,
-31479,
-31276,
-31130,
-31081,
-31171,
-31420,
-31827,
-32361,
-32974,
-33609,
-34182,
-34642,
-34928,
-35008,
-34891,
-34581,
-34144,
-33618,
-33087,
-32597,
-32202,
-31919,
-31752,
-31670,
-31636,
-31593,
-31488,
-31289,
-30957,
-30517,
-29976,
-29404,
-28862,
-28421,
-28153,
-28100,
-28297,
-28723,
-29365,
-30137,
-30985,
-31820,
-32576,
-33201,
-33672,
-33990,
-34201,
-34347,
-34501,
-34726,
-35064,
-35554,
-36168,
-36888,
-37629,
-38321,
-38873,
-39192,
-39246,
-38976,
-38432,
-37630,
-36669,
-35640,
-34637,
-33765,
-33069,
-32596,
-32326,
-32220,
-32202,
-32188,
-32086,
-31834,
-31381,
-30729,
-29919,
-29006,
-28107,
-27307,
-26725,
-26423,
-26459,
-26819,
-27474,
-28340,
-29311,
-30283,
-31140,
-31813,
-32243,
-32438,
-32417,
-32270,
-32071,
-31928,
-31920,
-32117,
-32536,
-33167,
-33964,
-34827,
-35683,
-36405,
-36929,
-37178,
-37148,
-36843,
-36329,
-35686,
-35008,
-34398,
-33937,
-33670,
-33630,
-33782,
-34077,
-34438,
-34766,
-34974,
-34995,
-34768,
-34302,
-33611,
-32761,
-31838,
-30935,
-30153,
-29575,
-29247,
-29204,
-29426,
-29864,
-30467,
-31118,
-31766,
-32303,
-32702,
-32903,
-32944,
-32816,
-32612,
-32369,
-32173,
-32086,
-32140,
-32373,
-32758,
-33268,
-33841,
-34399,
-34876,
-35184,
-35287,
-35148,
-34770,
-34194,
-33467,
-32675,
-31902,
-31228,
-30722,
-30426,
-30354,
-30485,
-30781,
-31162,
-31566,
-31904,
-32125,
-32189,
-32083,
-31847,
-31518,
-31182,
-30922,
-30806,
-30913,
-31255,
-31846,
-32632,
-33556,
-34507,
-35403,
-36120,
-36610,
-36807,
-36718,
-36374,
-35839,
-35213,
-34589,
-34056,
-33692,
-33517,
-33540,
-33705,
-33945,
-34166,
-34268,
-34187,
-33850,
-33277,
-32472,
-31530,
-30537,
-29605,
-28855,
-28354,
-28175,
-28306,
-28725,
-29348,
-30087,
-30825,
-31480,
-31961,
-32254,
-32353,
-32313,
-32208,
-32130,
-32170,
-32395,
-32835,
-33501,
-34321,
-35234,
-36111,
-36858,
-37359,
-37559,
-37416,
-36954,
-36233,
-35338,
-34397,
-33504,
-32770,
-32245,
-31955,
-31880,
-31955,
-32105,
-32233,
-32256,
-32121,
-31796,
-31312,
-30708,
-30084,
-29519,
-29119,
-28950,
-29051,
-29428,
-30030,
-30788,
-31601,
-32369,
-33001,
-33433,
-33636,
-33625,
-33449,
-33192,
-32931,
-32772,
-32771,
-32961,
-33362,
-33904,
-34548,
-35179,
-35721,
-36083,
-36214,
-36097,
-35745,
-35223,
-34595,
-33961,
-33399,
-32985,
-32740,
-32679,
-32754,
-32911,
-33070,
-33146,
-33074,
-32825,
-32373,
-31773,
-31061,
-30344,
-29695,
-29210,
-28948,
-28937,
-29178,
-29629,
-30223,
-30879,
-31513,
-32050,
-32451,
-32691,
-32794,
-32803,
-32777,
-32798,
-32911,
-33168,
-33579,
-34115,
-34741,
-35366,
-35928,
-36327,
-36520,
-36460,
-36152,
-35631,
-34954,
-34201,
-33463,
-32803,
-32296,
-31950,
-31780,
-31742,
-31788,
-31862,
-31888,
-31836,
-31674,
-31409,
-31076,
-30719,
-30418,
-30217,
-30188,
-30346,
-30706,
-31233,
-31882,
-32576,
-33256,
-33837,
-34278,
-34548,
-34651,
-34609,
-34470,
-34297,
-34138,
-34053,
-34050,
-34151,
-34323,
-34526,
-34707,
-34808,
-34772,
-34583,
-34206,
-33687,
-33034,
-32334,
-31629,
-30996,
-30485,
-30130,
-29942,
-29913,
-30006,
-30185,
-30393,
-30587,
-30742,
-30831,
-30870,
-30873,
-30888,
-30942,
-31095,
-31358,
-31763,
-32291,
-32922,
-33612,
-34298,
-34936,
-35443,
-35808,
-35974,
-35963,
-35777,
-35454,
-35055,
-34614,
-34205,
-33856,
-33594,
-33434,
-33351,
-33328,
-33312,
-33277,
-33170,
-32974,
-32685,
-32298,
-31868,
-31424,
-31034,
-30744,
-30612,
-30656,
-30893,
-31297,
-31828,
-32420,
-33007,
-33507,
-33867,
-34046,
-34023,
-33825,
-33488,
-33078,
-32674,
-32337,
-32134,
-32087,
-32210,
-32457,
-32789,
-33117,
-33374,
-33488,
-33419,
-33149,
-32712,
-32157,
-31576,
-31059,
-30701,
-30568,
-30702,
-31089,
-31696,
-32417,
-33175,
-33822,
-34299,
-34498,
-34422,
-34079,
-33533,
-32897,
-32270,
-31780,
-31507,
-31511,
-31785,
-32298,
-32943,
-33631,
-34223,
-34637,
-34787,
-34671,
-34298,
-33768,
-33170,
-32639,
-32280,
-32177,
-32364,
-32827,
-33491,
-34250,
-34973,
-35524,
-35803,
-35739,
-35326,
-34602,
-33667,
-32635,
-31653,
-30827,
-30260,
-29979,
-29981,
-30199,
-30537,
-30882,
-31123,
-31182,
-31015,
-30632,
-30097,
-29495,
-28958,
-28585,
-28486,
-28709,
-29264,
-30115,
-31165,
-32316,
-33444,
-34429,
-35215,
-35733,
-36018,
-36092,
-36043,
-35954,
-35902,
-35955,
-36129,
-36424,
-36786,
-37143,
-37420,
-37527,
-37416,
-37051,
-36447,
-35634,
-34700,
-33703,
-32751,
-31893,
-31189,
-30647,
-30259,
-29985,
-29781,
-29596,
-29393,
-29149,
-28873,
-28584,
-28330,
-28159,
-28114,
-28243,
-28538,
-29010,
-29613,
-30311,
-31040,
-31748,
-32401,
-32963,
-33439,
-33838,
-34186,
-34513,
-34852,
-35198,
-35575,
-35933,
-36258,
-36496,
-36602,
-36554,
-36325,
-35931,
-35402,
-34782,
-34145,
-33537,
-33025,
-32639,
-32394,
-32276,
-32262,
-32292,
-32337,
-32337,
-32266,
-32134,
-31933,
-31717,
-31522,
-31399,
-31391,
-31519,
-31789,
-32164,
-32616,
-33065,
-33454,
-33729,
-33832,
-33756,
-33509,
-33116,
-32651,
-32162,
-31730,
-31405,
-31221,
-31194,
-31304,
-31518,
-31785,
-32042,
-32248,
-32354,
-32365,
-32267,
-32111,
-31920,
-31774,
-31692,
-31741,
-31913,
-32225,
-32642,
-33115,
-33599,
-34023,
-34346,
-34520,
-34539,
-34389,
-34121,
-33747,
-33348,
-32956,
-32626,
-32400,
-32277,
-32283,
-32369,
-32532,
-32715,
-32888,
-33017,
-33081,
-33074,
-33007,
-32903,
-32791,
-32722,
-32711,
-32806,
-33003,
-33307,
-33694,
-34125,
-34548,
-34917,
-35166,
-35269,
-35186,
-34920,
-34489,
-33920,
-33277,
-32615,
-31988,
-31467,
-31060,
-30806,
-30676,
-30659,
-30698,
-30751,
-30765,
-30719,
-30579,
-30377,
-30126,
-29886,
-29716,
-29669,
-29800,
-30128,
-30654,
-31346,
-32151,
-32986,
-33781,
-34450,
-34952,
-35244,
-35340,
-35273,
-35092,
-34889,
-34709,
-34631,
-34673,
-34838,
-35094,
-35386,
-35625,
-35752,
-35685,
-35393,
-34872,
-34145,
-33290,
-32382,
-31527,
-30812,
-30309,
-30056,
-30053,
-30263,
-30624,
-31056,
-31472,
-31812,
-32022,
-32102,
-32069,
-31967,
-31876,
-31841,
-31940,
-32186,
-32593,
-33118,
-33712,
-34290,
-34775,
-35096,
-35203,
-35072,
-34735,
-34210,
-33594,
-32937,
-32330,
-31826,
-31451,
-31225,
-31118,
-31094,
-31104,
-31098,
-31043,
-30922,
-30739,
-30533,
-30330,
-30211,
-30195,
-30344,
-30654,
-31135,
-31747,
-32450,
-33182,
-33897,
-34537,
-35081,
-35505,
-35818,
-36039,
-36185,
-36280,
-36342,
-36366,
-36353,
-36267,
-36100,
-35810,
-35394,
-34847,
-34189,
-33452,
-32691,
-31959,
-31308,
-30788,
-30415,
-30202,
-30127,
-30163,
-30258,
-30384,
-30490,
-30569,
-30620,
-30652,
-30712,
-30815,
-31016,
-31311,
-31721,
-32204,
-32738,
-33241,
-33680,
-33979,
-34119,
-34082,
-33885,
-33574,
-33208,
-32858,
-32588,
-32438,
-32438,
-32565,
-32794,
-33055,
-33284,
-33423,
-33419,
-33262,
-32959,
-32562,
-32138,
-31759,
-31510,
-31433,
-31568,
-31902,
-32386,
-32971,
-33552,
-34072,
-34445,
-34650,
-34669,
-34531,
-34301,
-34021,
-33793,
-33633,
-33602,
-33680,
-33844,
-34042,
-34204,
-34279,
-34203,
-33979,
-33588,
-33100,
-32544,
-32021,
-31571,
-31268,
-31124,
-31146,
-31290,
-31518,
-31750,
-31939,
-32031,
-32003,
-31863,
-31636,
-31367,
-31115,
-30927,
-30840,
-30877,
-31018,
-31256,
-31528,
-31811,
-32055,
-32240,
-32358,
-32433,
-32477,
-32548,
-32659,
-32845,
-33110,
-33433,
-33793,
-34137,
-34429,
-34619,
-34694,
-34647,
-34497,
-34290,
-34063,
-33877,
-33760,
-33748,
-33826,
-33984,
-34173,
-34343,
-34446,
-34441,
-34303,
-34045,
-33674,
-33251,
-32808,
-32416,
-32092,
-31882,
-31758,
-31722,
-31722,
-31716,
-31667,
-31541,
-31330,
-31049,
-30732,
-30429,
-30200,
-30102,
-30171,
-30434,
-30871,
-31471,
-32159,
-32882,
-33564,
-34142,
-34566,
-34817,
-34886,
-34806,
-34611,
-34353,
-34094,
-33867,
-33714,
-33640,
-33638,
-33683,
-33724,
-33733,
-33640,
-33442,
-33097,
-32631,
-32059,
-31439,
-30825,
-30290,
-29885,
-29670,
-29657,
-29856,
-30234,
-30748,
-31329,
-31917,
-32444,
-32871,
-33183,
-33377,
-33505,
-33598,
-33732,
-33949,
-34292,
-34764,
-35342,
-35959,
-36553,
-37006,
-37253,
-37210,
-36849,
-36186,
-35258,
-34174,
-33031,
-31953,
-31049,
-30382,
-29998,
-29872,
-29958,
-30167,
-30416,
-30602,
-30682,
-30618,
-30439,
-30192,
-29965,
-29836,
-29894,
-30175,
-30696,
-31414,
-32260,
-33132,
-33920,
-34537,
-34908,
-35020,
-34886,
-34579,
-34173,
-33780,
-33474,
-33314,
-33326,
-33481,
-33718,
-33971,
-34142,
-34169,
-34014,
-33665,
-33173,
-32594,
-32026,
-31543,
-31234,
-31122,
-31223,
-31496,
-31890,
-32318,
-32723,
-33031,
-33230,
-33317,
-33322,
-33302,
-33310,
-33391,
-33573,
-33844,
-34166,
-34485,
-34719,
-34811,
-34708,
-34389,
-33891,
-33246,
-32557,
-31891,
-31349,
-30969,
-30800,
-30806,
-30956,
-31179,
-31395,
-31547,
-31581,
-31508,
-31336,
-31140,
-30978,
-30932,
-31056,
-31374,
-31877,
-32512,
-33211,
-33870,
-34421,
-34774,
-34923,
-34847,
-34618,
-34281,
-33944,
-33664,
-33514,
-33501,
-33618,
-33808,
-33994,
-34101,
-34038,
-33781,
-33302,
-32645,
-31875,
-31086,
-30375,
-29843,
-29539,
-29509,
-29726,
-30152,
-30716,
-31324,
-31928,
-32442,
-32873,
-33205,
-33481,
-33743,
-34038,
-34403,
-34844,
-35356,
-35878,
-36363,
-36727,
-36911,
-36873,
-36586,
-36074,
-35379,
-34564,
-33713,
-32895,
-32162,
-31552,
-31068,
-30682,
-30378,
-30090,
-29809,
-29501,
-29175,
-28857,
-28593,
-28427,
-28418,
-28586,
-28952,
-29498,
-30177,
-30944,
-31717,
-32449,
-33082,
-33607,
-34002,
-34326,
-34582,
-34850,
-35141,
-35487,
-35884,
-36290,
-36670,
-36943,
-37057,
-36958,
-36621,
-36057,
-35313,
-34443,
-33565,
-32733,
-32067,
-31590,
-31342,
-31304,
-31418,
-31630,
-31836,
-31986,
-32012,
-31899,
-31661,
-31335,
-31003,
-30726,
-30589,
-30622,
-30853,
-31251,
-31766,
-32311,
-32806,
-33150,
-33306,
-33232,
-32947,
-32517,
-32009,
-31541,
-31197,
-31068,
-31171,
-31539,
-32090,
-32780,
-33477,
-34100,
-34544,
-34761,
-34722,
-34471,
-34054,
-33581,
-33137,
-32825,
-32701,
-32805,
-33104,
-33560,
-34079,
-34564,
-34929,
-35088,
-35016,
-34702,
-34200,
-33566,
-32906,
-32297,
-31820,
-31522,
-31408,
-31454,
-31612,
-31789,
-31930,
-31953,
-31832,
-31557,
-31165,
-30712,
-30281,
-29958,
-29810,
-29895,
-30220,
-30768,
-31490,
-32299,
-33123,
-33876,
-34487,
-34941,
-35205,
-35320,
-35326,
-35258,
-35192,
-35144,
-35135,
-35170,
-35204,
-35217,
-35154,
-34976,
-34670,
-34215,
-33652,
-32990,
-32293,
-31604,
-30958,
-30401,
-29936,
-29574,
-29302,
-29108,
-28975,
-28907,
-28899,
-28975,
-29143,
-29436,
-29862,
-30423,
-31116,
-31900,
-32746,
-33599,
-34414,
-35149,
-35781,
-36292,
-36689,
-36982,
-37184,
-37315,
-37376,
-37359,
-37252,
-37026,
-36670,
-36148,
-35486,
-34672,
-33773,
-32819,
-31884,
-31025,
-30291,
-29720,
-29317,
-29074,
-28964,
-28944,
-28977,
-29030,
-29087,
-29150,
-29230,
-29366,
-29570,
-29885,
-30308,
-30840,
-31460,
-32130,
-32805,
-33448,
-34019,
-34508,
-34903,
-35215,
-35470,
-35684,
-35876,
-36049,
-36199,
-36302,
-36339,
-36271,
-36082,
-35765,
-35321,
-34780,
-34171,
-33546,
-32944,
-32400,
-31933,
-31542,
-31223,
-30949,
-30699,
-30458,
-30215,
-29982,
-29783,
-29648,
-29622,
-29717,
-29969,
-30357,
-30869,
-31451,
-32062,
-32634,
-33132,
-33516,
-33787,
-33948,
-34042,
-34098,
-34165,
-34263,
-34421,
-34606,
-34817,
-34982,
-35074,
-35038,
-34848,
-34499,
-34011,
-33419,
-32793,
-32180,
-31649,
-31244,
-30978,
-30860,
-30868,
-30950,
-31091,
-31228,
-31352,
-31453,
-31535,
-31630,
-31768,
-31970,
-32263,
-32647,
-33098,
-33585,
-34064,
-34473,
-34780,
-34947,
-34964,
-34846,
-34618,
-34328,
-34011,
-33724,
-33471,
-33283,
-33136,
-33017,
-32892,
-32742,
-32535,
-32288,
-31994,
-31697,
-31423,
-31212,
-31095,
-31077,
-31160,
-31313,
-31507,
-31688,
-31828,
-31893,
-31880,
-31814,
-31707,
-31643,
-31635,
-31755,
-32012,
-32406,
-32915,
-33486,
-34056,
-34556,
-34931,
-35139,
-35177,
-35050,
-34812,
-34502,
-34205,
-33943,
-33775,
-33691,
-33677,
-33695,
-33687,
-33593,
-33384,
-33023,
-32520,
-31922,
-31266,
-30658,
-30148,
-29820,
-29710,
-29831,
-30171,
-30665,
-31259,
-31859,
-32401,
-32824,
-33101,
-33234,
-33254,
-33222,
-33195,
-33239,
-33406,
-33695,
-34117,
-34608,
-35107,
-35530,
-35795,
-35844,
-35638,
-35189,
-34525,
-33734,
-32885,
-32099,
-31423,
-30953,
-30667,
-30585,
-30632,
-30765,
-30887,
-30966,
-30938,
-30826,
-30639,
-30454,
-30322,
-30341,
-30530,
-30947,
-31553,
-32304,
-33137,
-33937,
-34631,
-35148,
-35442,
-35521,
-35418,
-35194,
-34921,
-34682,
-34510,
-34455,
-34486,
-34587,
-34686,
-34742,
-34679,
-34497,
-34158,
-33710,
-33186,
-32638,
-32136,
-31702,
-31369,
-31132,
-30964,
-30833,
-30705,
-30540,
-30341,
-30107,
-29868,
-29671,
-29554,
-29562,
-29710,
-30014,
-30439,
-30972,
-31552,
-32148,
-32726,
-33258,
-33755,
-34205,
-34639,
-35051,
-35460,
-35842,
-36183,
-36453,
-36611,
-36641,
-36517,
-36255,
-35865,
-35394,
-34873,
-34357,
-33858,
-33421,
-33011,
-32642,
-32274,
-31890,
-31484,
-31046,
-30609,
-30196,
-29849,
-29615,
-29505,
-29544,
-29707,
-29970,
-30284,
-30615,
-30909,
-31157,
-31355,
-31513,
-31680,
-31871,
-32137,
-32475,
-32892,
-33350,
-33811,
-34224,
-34536,
-34728,
-34782,
-34725,
-34588,
-34430,
-34301,
-34240,
-34278,
-34396,
-34578,
-34782,
-34936,
-35024,
-34987,
-34834,
-34574,
-34240,
-33872,
-33517,
-33194,
-32927,
-32695,
-32484,
-32251,
-31967,
-31602,
-31170,
-30659,
-30141,
-29630,
-29202,
-28881,
-28707,
-28680,
-28791,
-29012,
-29316,
-29659,
-30040,
-30432,
-30851,
-31305,
-31808,
-32368,
-32975,
-33619,
-34249,
-34840,
-35341,
-35721,
-35976,
-36094,
-36124,
-36074,
-36016,
-35961,
-35946,
-35958,
-35988,
-35988,
-35928,
-35761,
-35476,
-35055,
-34539,
-33952,
-33367,
-32814,
-32354,
-31998,
-31747,
-31577,
-31449,
-31315,
-31142,
-30900,
-30595,
-30246,
-29894,
-29594,
-29391,
-29327,
-29423,
-29670,
-30053,
-30518,
-31026,
-31535,
-31994,
-32410,
-32748,
-33050,
-33315,
-33577,
-33846,
-34138,
-34443,
-34758,
-35055,
-35318,
-35522,
-35660,
-35711,
-35685,
-35571,
-35385,
-35127,
-34810,
-34437,
-34026,
-33587,
-33136,
-32699,
-32282,
-31917,
-31603,
-31345,
-31138,
-30967,
-30819,
-30675,
-30534,
-30390,
-30267,
-30180,
-30162,
-30237,
-30412,
-30703,
-31065,
-31486,
-31900,
-32271,
-32552,
-32723,
-32784,
-32754,
-32684,
-32611,
-32587,
-32646,
-32779,
-32996,
-33224,
-33440,
-33573,
-33590,
-33485,
-33247,
-32949,
-32614,
-32335,
-32136,
-32071,
-32124,
-32272,
-32460,
-32632,
-32731,
-32727,
-32618,
-32442,
-32250,
-32124,
-32128,
-32313,
-32695,
-33246,
-33916,
-34611,
-35262,
-35776,
-36132,
-36305,
-36336,
-36280,
-36203,
-36169,
-36200,
-36311,
-36437,
-36535,
-36508,
-36289,
-35841,
-35155,
-34274,
-33290,
-32292,
-31401,
-30687,
-30209,
-29959,
-29896,
-29945,
-30017,
-30034,
-29958,
-29770,
-29526,
-29281,
-29134,
-29158,
-29401,
-29878,
-30543,
-31318,
-32102,
-32782,
-33284,
-33552,
-33594,
-33455,
-33217,
-32971,
-32805,
-32774,
-32889,
-33128,
-33422,
-33700,
-33875,
-33905,
-33750,
-33452,
-33050,
-32626,
-32262,
-32020,
-31924,
-31991,
-32160,
-32384,
-32584,
-32692,
-32674,
-32511,
-32226,
-31865,
-31478,
-31122,
-30840,
-30635,
-30520,
-30452,
-30412,
-30363,
-30296,
-30212,
-30143,
-30118,
-30191,
-30384,
-30728,
-31207,
-31804,
-32464,
-33154,
-33817,
-34437,
-34993,
-35506,
-35987,
-36469,
-36961,
-37461,
-37950,
-38376,
-38698,
-38845,
-38798,
-38524,
-38049,
-37415,
-36680,
-35930,
-35214,
-34596,
-34075,
-33661,
-33301,
-32973,
-32611,
-32209,
-31756,
-31275,
-30822,
-30444,
-30210,
-30142,
-30267,
-30546,
-30950,
-31401,
-31828,
-32184,
-32406,
-32510,
-32489,
-32394,
-32265,
-32135,
-32043,
-31982,
-31942,
-31894,
-31800,
-31632,
-31390,
-31062,
-30711,
-30362,
-30073,
-29899,
-29850,
-29950,
-30165,
-30465,
-30805,
-31148,
-31458,
-31737,
-31985,
-32235,
-32511,
-32831,
-33203,
-33609,
-34006,
-34347,
-34572,
-34643,
-34530,
-34249,
-33830,
-33321,
-32815,
-32339,
-31975,
-31717,
-31567,
-31492,
-31438,
-31378,
-31261,
-31105,
-30916,
-30754,
-30669,
-30728,
-30959,
-31386,
-31963,
-32655,
-33366,
-34020,
-34547,
-34895,
-35058,
-35061,
-34958,
-34813,
-34697,
-34638,
-34669,
-34759,
-34867,
-34939,
-34912,
-34762,
-34475,
-34087,
-33666,
-33276,
-33021,
-32941,
-33091,
-33443,
-33963,
-34562,
-35163,
-35671,
-36034,
-36221,
-36243,
-36141,
-35968,
-35793,
-35641,
-35540,
-35457,
-35349,
-35157,
-34801,
-34258,
-33492,
-32548,
-31474,
-30370,
-29323,
-28438,
-27763,
-27349,
-27162,
-27180,
-27338,
-27558,
-27816,
-28046,
-28294,
-28540,
-28865,
-29284,
-29836,
-30532,
-31325,
-32185,
-33013,
-33755,
-34322,
-34683,
-34826,
-34758,
-34550,
-34234,
-33900,
-33581,
-33315,
-33097,
-32923,
-32753,
-32566,
-32336,
-32066,
-31772,
-31495,
-31275,
-31166,
-31187,
-31361,
-31666,
-32069,
-32523,
-32965,
-33355,
-33660,
-33859,
-33973,
-34006,
-34002,
-33968,
-33932,
-33888,
-33820,
-33714,
-33548,
-33305,
-33004,
-32648,
-32289,
-31956,
-31711,
-31568,
-31567,
-31689,
-31920,
-32226,
-32577,
-32925,
-33272,
-33597,
-33920,
-34261,
-34631,
-35042,
-35490,
-35936,
-36351,
-36667,
-36846,
-36848,
-36655,
-36294,
-35783,
-35212,
-34610,
-34072,
-33608,
-33256,
-32990,
-32795,
-32614,
-32426,
-32192,
-31927,
-31636,
-31379,
-31194,
-31143,
-31241,
-31509,
-31909,
-32395,
-32896,
-33334,
-33649,
-33797,
-33759,
-33563,
-33232,
-32826,
-32396,
-31967,
-31577,
-31207,
-30851,
-30469,
-30058,
-29582,
-29083,
-28558,
-28088,
-27694,
-27463,
-27399,
-27543,
-27877,
-28366,
-28993,
-29679,
-30418,
-31157,
-31897,
-32634,
-33375,
-34119,
-34857,
-35571,
-36221,
-36760,
-37140,
-37323,
-37287,
-37038,
-36608,
-36038,
-35398,
-34741,
-34109,
-33543,
-33031,
-32566,
-32130,
-31679,
-31237,
-30773,
-30348,
-29996,
-29774,
-29731,
-29908,
-30286,
-30863,
-31556,
-32302,
-33020,
-33629,
-34095,
-34401,
-34556,
-34621,
-34634,
-34658,
-34726,
-34852,
-35012,
-35176,
-35285,
-35290,
-35170,
-34913,
-34556,
-34149,
-33773,
-33491,
-33378,
-33450,
-33710,
-34119,
-34607,
-35099,
-35520,
-35809,
-35943,
-35917,
-35772,
-35538,
-35282,
-35026,
-34790,
-34573,
-34318,
-34013,
-33570,
-32984,
-32224,
-31322,
-30319,
-29285,
-28313,
-27465,
-26824,
-26408,
-26235,
-26284,
-26507,
-26873,
-27317,
-27822,
-28358,
-28933,
-29544,
-30214,
-30943,
-31721,
-32538,
-33340,
-34093,
-34740,
-35231,
-35547,
-35660,
-35589,
-35350,
-34975,
-34512,
-33986,
-33442,
-32893,
-32357,
-31851,
-31379,
-30965,
-30617,
-30368,
-30238,
-30240,
-30396,
-30692,
-31120,
-31651,
-32245,
-32865,
-33477,
-34052,
-34566,
-35032,
-35428,
-35787,
-36081,
-36338,
-36521,
-36631,
-36630,
-36514,
-36257,
-35878,
-35378,
-34809,
-34207,
-33618,
-33100,
-32669,
-32355,
-32154,
-32046,
-32008,
-32009,
-32027,
-32048,
-32074,
-32114,
-32185,
-32308,
-32486,
-32728,
-33004,
-33292,
-33542,
-33724,
-33794,
-33746,
-33577,
-33306,
-32982,
-32636,
-32333,
-32087,
-31941,
-31876,
-31891,
-31952,
-32034,
-32112,
-32172,
-32221,
-32278,
-32367,
-32521,
-32763,
-33092,
-33509,
-33963,
-34421,
-34813,
-35083,
-35195,
-35106,
-34831,
-34367,
-33777,
-33079,
-32352,
-31614,
-30909,
-30252,
-29639,
-29071,
-28543,
-28035,
-27577,
-27160,
-26828,
-26608,
-26526,
-26630,
-26919,
-27417,
-28102,
-28962,
-29955,
-31054,
-32194,
-33365,
-34486,
-35562,
-36536,
-37393,
-38111,
-38671,
-39066,
-39300,
-39365,
-39288,
-39066,
-38735,
-38298,
-37776,
-37180,
-36510,
-35781,
-34991,
-34149,
-33284,
-32408,
-31577,
-30818,
-30181,
-29705,
-29400,
-29286,
-29333,
-29518,
-29783,
-30095,
-30388,
-30650,
-30854,
-31010,
-31144,
-31277,
-31448,
-31672,
-31956,
-32291,
-32648,
-32982,
-33271,
-33467,
-33574,
-33590,
-33542,
-33480,
-33443,
-33469,
-33600,
-33813,
-34120,
-34461,
-34799,
-35085,
-35274,
-35351,
-35313,
-35174,
-34974,
-34733,
-34495,
-34266,
-34047,
-33825,
-33567,
-33242,
-32837,
-32334,
-31753,
-31134,
-30512,
-29952,
-29509,
-29203,
-29075,
-29102,
-29269,
-29543,
-29879,
-30250,
-30632,
-31020,
-31422,
-31854,
-32321,
-32838,
-33386,
-33947,
-34481,
-34931,
-35268,
-35444,
-35451,
-35287,
-34979,
-34558,
-34077,
-33566,
-33068,
-32588,
-32140,
-31714,
-31306,
-30912,
-30543,
-30217,
-29977,
-29851,
-29888,
-30102,
-30499,
-31071,
-31750,
-32511,
-33251,
-33943,
-34522,
-34972,
-35294,
-35517,
-35659,
-35777,
-35876,
-35978,
-36060,
-36087,
-36022,
-35815,
-35440,
-34882,
-34167,
-33339,
-32466,
-31633,
-30901,
-30339,
-29978,
-29799,
-29802,
-29911,
-30080,
-30261,
-30392,
-30484,
-30517,
-30539,
-30570,
-30661,
-30840,
-31111,
-31485,
-31915,
-32381,
-32824,
-33209,
-33509,
-33704,
-33806,
-33834,
-33818,
-33795,
-33794,
-33846,
-33951,
-34129,
-34356,
-34628,
-34932,
-35242,
-35554,
-35849,
-36106,
-36325,
-36471,
-36545,
-36512,
-36369,
-36105,
-35722,
-35223,
-34631,
-33967,
-33248,
-32508,
-31752,
-30997,
-30254,
-29515,
-28799,
-28109,
-27475,
-26922,
-26490,
-26224,
-26154,
-26315,
-26712,
-27329,
-28150,
-29106,
-30167,
-31244,
-32309,
-33306,
-34210,
-35018,
-35714,
-36310,
-36813,
-37205,
-37495,
-37653,
-37666,
-37525,
-37217,
-36766,
-36184,
-35527,
-34832,
-34158,
-33547,
-33017,
-32600,
-32262,
-32010,
-31796,
-31611,
-31435,
-31263,
-31125,
-31023,
-31012,
-31083,
-31273,
-31534,
-31868,
-32184,
-32460,
-32613,
-32621,
-32458,
-32148,
-31728,
-31262,
-30818,
-30467,
-30246,
-30196,
-30284,
-30503,
-30792,
-31105,
-31403,
-31662,
-31882,
-32098,
-32341,
-32673,
-33112,
-33699,
-34413,
-35219,
-36060,
-36856,
-37526,
-38013,
-38257,
-38257,
-38007,
-37557,
-36950,
-36240,
-35486,
-34711,
-33958,
-33222,
-32516,
-31833,
-31191,
-30586,
-30063,
-29628,
-29333,
-29194,
-29228,
-29434,
-29804,
-30288,
-30869,
-31483,
-32101,
-32687,
-33214,
-33664,
-34034,
-34302,
-34470,
-34521,
-34438,
-34214,
-33839,
-33315,
-32671,
-31934,
-31163,
-30408,
-29732,
-29184,
-28804,
-28607,
-28587,
-28736,
-29014,
-29407,
-29875,
-30410,
-31007,
-31663,
-32390,
-33181,
-34029,
-34904,
-35770,
-36570,
-37254,
-37771,
-38085,
-38180,
-38072,
-37783,
-37356,
-36838,
-36268,
-35680,
-35077,
-34472,
-33829,
-33165,
-32446,
-31701,
-30952,
-30244,
-29635,
-29179,
-28922,
-28874,
-29052,
-29390,
-29855,
-30358,
-30831,
-31223,
-31485,
-31621,
-31650,
-31603,
-31551,
-31515,
-31546,
-31649,
-31803,
-31991,
-32164,
-32282,
-32337,
-32306,
-32233,
-32155,
-32132,
-32231,
-32502,
-32972,
-33651,
-34500,
-35469,
-36482,
-37463,
-38326,
-39023,
-39499,
-39739,
-39739,
-39512,
-39073,
-38449,
-37654,
-36712,
-35646,
-34457,
-33202,
-31876,
-30557,
-29260,
-28050,
-26962,
-26039,
-25307,
-24786,
-24484,
-24400,
-24542,
-24896,
-25469,
-26245,
-27217,
-28370,
-29652,
-31040,
-32439,
-33807,
-35046,
-36100,
-36911,
-37453,
-37722,
-37741,
-37560,
-37232,
-36817,
-36369,
-35917,
-35488,
-35064,
-34639,
-34190,
-33700,
-33167,
-32607,
-32051,
-31542,
-31143,
-30887,
-30820,
-30949,
-31261,
-31725,
-32278,
-32869,
-33415,
-33880,
-34209,
-34384,
-34414,
-34293,
-34066,
-33745,
-33371,
-32955,
-32530,
-32091,
-31670,
-31256,
-30884,
-30555,
-30297,
-30126,
-30067,
-30124,
-30317,
-30630,
-31065,
-31598,
-32215,
-32880,
-33588,
-34289,
-34977,
-35614,
-36179,
-36632,
-36961,
-37122,
-37103,
-36892,
-36481,
-35894,
-35151,
-34302,
-33388,
-32474,
-31608,
-30842,
-30211,
-29738,
-29442,
-29311,
-29336,
-29510,
-29791,
-30179,
-30633,
-31141,
-31686,
-32235,
-32786,
-33297,
-33764,
-34155,
-34454,
-34645,
-34715,
-34660,
-34478,
-34172,
-33756,
-33241,
-32651,
-32001,
-31329,
-30659,
-30034,
-29488,
-29066,
-28789,
-28705,
-28804,
-29103,
-29582,
-30199,
-30931,
-31715,
-32508,
-33277,
-33983,
-34615,
-35173,
-35655,
-36072,
-36440,
-36737,
-36980,
-37122,
-37161,
-37051,
-36794,
-36357,
-35771,
-35047,
-34236,
-33385,
-32563,
-31806,
-31191,
-30721,
-30434,
-30320,
-30370,
-30553,
-30849,
-31217,
-31635,
-32083,
-32523,
-32967,
-33374,
-33754,
-34083,
-34346,
-34534,
-34619,
-34604,
-34464,
-34213,
-33846,
-33394,
-32870,
-32323,
-31768,
-31260,
-30817,
-30473,
-30236,
-30127,
-30140,
-30284,
-30544,
-30918,
-31387,
-31943,
-32551,
-33200,
-33838,
-34445,
-34971,
-35386,
-35659,
-35771,
-35707,
-35477,
-35080,
-34551,
-33901,
-33173,
-32392,
-31590,
-30811,
-30074,
-29424,
-28877,
-28465,
-28196,
-28079,
-28109,
-28276,
-28552,
-28939,
-29394,
-29928,
-30517,
-31162,
-31869,
-32614,
-33400,
-34192,
-34952,
-35643,
-36214,
-36616,
-36836,
-36842,
-36656,
-36305,
-35831,
-35299,
-34763,
-34269,
-33875,
-33575,
-33398,
-33311,
-33304,
-33340,
-33396,
-33447,
-33487,
-33518,
-33543,
-33592,
-33669,
-33799,
-33973,
-34191,
-34417,
-34627,
-34764,
-34794,
-34680,
-34389,
-33937,
-33315,
-32583,
-31770,
-30948,
-30170,
-29482,
-28946,
-28559,
-28375,
-28356,
-28528,
-28853,
-29321,
-29901,
-30567,
-31284,
-32023,
-32751,
-33437,
-34060,
-34602,
-35058,
-35425,
-35707,
-35903,
-36021,
-36049,
-35973,
-35785,
-35456,
-34987,
-34378,
-33651,
-32849,
-32035,
-31265,
-30630,
-30160,
-29928,
-29912,
-30128,
-30510,
-31015,
-31565,
-32104,
-32566,
-32933,
-33175,
-33309,
-33345,
-33312,
-33224,
-33115,
-32970,
-32803,
-32597,
-32340,
-32031,
-31666,
-31252,
-30826,
-30402,
-30034,
-29748,
-29582,
-29557,
-29694,
-29988,
-30442,
-31025,
-31731,
-32521,
-33375,
-34257,
-35140,
-35982,
-36762,
-37433,
-37975,
-38352,
-38552,
-38554,
-38382,
-38018,
-37517,
-36894,
-36195,
-35457,
-34712,
-33993,
-33307,
-32675,
-32081,
-31531,
-31028,
-30554,
-30145,
-29791,
-29534,
-29383,
-29366,
-29482,
-29725,
-30072,
-30475,
-30892,
-31265,
-31550,
-31714,
-31741,
-31639,
-31425,
-31140,
-30812,
-30491,
-30194,
-29955,
-29790,
-29703,
-29719,
-29836,
-30072,
-30441,
-30926,
-31542,
-32247,
-33023,
-33825,
-34605,
-35335,
-35975,
-36519,
-36965,
-37315,
-37581,
-37768,
-37861,
-37852,
-37710,
-37401,
-36917,
-36241,
-35405,
-34438,
-33413,
-32393,
-31456,
-30670,
-30072,
-29701,
-29543,
-29594,
-29818,
-30171,
-30625,
-31124,
-31653,
-32162,
-32650,
-33078,
-33460,
-33769,
-34025,
-34215,
-34355,
-34427,
-34450,
-34394,
-34264,
-34055,
-33753,
-33396,
-32982,
-32580,
-32202,
-31919,
-31740,
-31700,
-31792,
-32001,
-32302,
-32666,
-33065,
-33490,
-33923,
-34363,
-34803,
-35218,
-35580,
-35847,
-35956,
-35877,
-35561,
-35021,
-34265,
-33359,
-32364,
-31357,
-30402,
-29536,
-28789,
-28137,
-27578,
-27082,
-26638,
-26260,
-25954,
-25775,
-25741,
-25903,
-26257,
-26802,
-27513,
-28343,
-29247,
-30182,
-31108,
-31993,
-32821,
-33558,
-34193,
-34687,
-35033,
-35202,
-35202,
-35056,
-34802,
-34499,
-34218,
-34012,
-33939,
-34010,
-34230,
-34569,
-34991,
-35455,
-35914,
-36358,
-36757,
-37122,
-37446,
-37740,
-37991,
-38205,
-38361,
-38457,
-38473,
-38404,
-38230,
-37948,
-37529,
-36960,
-36227,
-35315,
-34262,
-33085,
-31886,
-30738,
-29754,
-29027,
-28620,
-28560,
-28822,
-29336,
-30007,
-30733,
-31421,
-32013,
-32487,
-32862,
-33163,
-33453,
-33737,
-34050,
-34344,
-34593,
-34740,
-34734,
-34548,
-34180,
-33643,
-32989,
-32258,
-31500,
-30761,
-30056,
-29429,
-28874,
-28438,
-28136,
-28001,
-28065,
-28325,
-28788,
-29404,
-30125,
-30875,
-31579,
-32182,
-32633,
-32927,
-33061,
-33065,
-32965,
-32787,
-32551,
-32255,
-31904,
-31495,
-31025,
-30517,
-29978,
-29446,
-28951,
-28510,
-28164,
-27911,
-27782,
-27782,
-27940,
-28268,
-28788,
-29510,
-30419,
-31481,
-32643,
-33829,
-34962,
-35975,
-36811,
-37460,
-37921,
-38221,
-38411,
-38507,
-38544,
-38524,
-38427,
-38258,
-37986,
-37639,
-37235,
-36827,
-36469,
-36206,
-36073,
-36071,
-36166,
-36326,
-36476,
-36583,
-36606,
-36549,
-36419,
-36255,
-36079,
-35905,
-35731,
-35511,
-35212,
-34768,
-34164,
-33356,
-32400,
-31294,
-30162,
-29032,
-28015,
-27156,
-26501,
-26080,
-25895,
-25945,
-26213,
-26686,
-27333,
-28126,
-29023,
-29980,
-30947,
-31883,
-32747,
-33528,
-34197,
-34773,
-35247,
-35625,
-35900,
-36045,
-36053,
-35883,
-35536,
-34995,
-34297,
-33466,
-32571,
-31655,
-30781,
-29992,
-29310,
-28762,
-28350,
-28077,
-27960,
-27986,
-28176,
-28507,
-28977,
-29527,
-30126,
-30696,
-31191,
-31563,
-31802,
-31912,
-31939,
-31928,
-31941,
-32026,
-32186,
-32438,
-32728,
-33035,
-33300,
-33507,
-33645,
-33733,
-33810,
-33927,
-34119,
-34431,
-34848,
-35378,
-35965,
-36578,
-37162,
-37673,
-38081,
-38352,
-38479,
-38440,
-38230,
-37841,
-37281,
-36557,
-35693,
-34739,
-33728,
-32737,
-31804,
-30991,
-30321,
-29827,
-29500,
-29350,
-29352,
-29511,
-29791,
-30205,
-30709,
-31304,
-31953,
-32637,
-33322,
-33986,
-34613,
-35177,
-35683,
-36099,
-36421,
-36608,
-36633,
-36451,
-36039,
-35376,
-34491,
-33422,
-32255,
-31079,
-30002,
-29105,
-28452,
-28065,
-27924,
-27994,
-28215,
-28515,
-28859,
-29203,
-29536,
-29872,
-30204,
-30554,
-30918,
-31286,
-31650,
-31987,
-32284,
-32532,
-32724,
-32866,
-32952,
-32994,
-32977,
-32914,
-32805,
-32659,
-32517,
-32401,
-32371,
-32464,
-32715,
-33138,
-33717,
-34416,
-35168,
-35915,
-36567,
-37085,
-37408,
-37524,
-37419,
-37119,
-36629,
-35986,
-35220,
-34360,
-33450,
-32519,
-31609,
-30753,
-29982,
-29309,
-28752,
-28311,
-27981,
-27782,
-27713,
-27811,
-28101,
-28611,
-29358,
-30344,
-31518,
-32835,
-34191,
-35499,
-36662,
-37604,
-38287,
-38688,
-38837,
-38743,
-38471,
-38028,
-37454,
-36744,
-35923,
-34984,
-33968,
-32901,
-31850,
-30869,
-30020,
-29351,
-28888,
-28627,
-28572,
-28663,
-28904,
-29239,
-29661,
-30149,
-30688,
-31262,
-31837,
-32384,
-32867,
-33242,
-33505,
-33627,
-33636,
-33539,
-33374,
-33151,
-32907,
-32633,
-32349,
-32059,
-31782,
-31557,
-31421,
-31426,
-31602,
-31976,
-32524,
-33213,
-33966,
-34716,
-35368,
-35889,
-36219,
-36372,
-36347,
-36164,
-35852,
-35412,
-34856,
-34188,
-33400,
-32536,
-31612,
-30690,
-29825,
-29067,
-28462,
-28024,
-27753,
-27653,
-27702,
-27911,
-28295,
-28869,
-29674,
-30711,
-31956,
-33377,
-34851,
-36309,
-37595,
-38640,
-39362,
-39732,
-39775,
-39521,
-39034,
-38378,
-37588,
-36715,
-35773,
-34784,
-33776,
-32774,
-31816,
-30940,
-30174,
-29542,
-29046,
-28683,
-28442,
-28320,
-28325,
-28462,
-28762,
-29219,
-29838,
-30579,
-31383,
-32176,
-32859,
-33379,
-33674,
-33746,
-33615,
-33335,
-32977,
-32600,
-32264,
-31982,
-31794,
-31675,
-31648,
-31699,
-31844,
-32093,
-32441,
-32889,
-33390,
-33928,
-34413,
-34834,
-35122,
-35282,
-35316,
-35247,
-35119,
-34946,
-34760,
-34533,
-34260,
-33900,
-33430,
-32839,
-32146,
-31379,
-30606,
-29886,
-29279,
-28849,
-28613,
-28601,
-28810,
-29242,
-29870,
-30691,
-31657,
-32741,
-33874,
-34993,
-36011,
-36857,
-37470,
-37815,
-37893,
-37732,
-37387,
-36921,
-36394,
-35846,
-35304,
-34758,
-34202,
-33609,
-32963,
-32278,
-31557,
-30844,
-30177,
-29592,
-29136,
-28823,
-28678,
-28700,
-28893,
-29254,
-29758,
-30392,
-31097,
-31831,
-32513,
-33080,
-33462,
-33634,
-33578,
-33345,
-32988,
-32601,
-32269,
-32066,
-32037,
-32179,
-32483,
-32875,
-33323,
-33749,
-34135,
-34443,
-34681,
-34847,
-34955,
-35010,
-35019,
-34979,
-34894,
-34775,
-34617,
-34438,
-34235,
-33991,
-33706,
-33329,
-32858,
-32259,
-31555,
-30772,
-29966,
-29234,
-28622,
-28239,
-28090,
-28211,
-28565,
-29118,
-29808,
-30586,
-31398,
-32212,
-33000,
-33733,
-34390,
-34936,
-35356,
-35610,
-35712,
-35658,
-35485,
-35235,
-34946,
-34659,
-34388,
-34142,
-33891,
-33638,
-33345,
-33035,
-32702,
-32399,
-32133,
-31964,
-31888,
-31909,
-32019,
-32173,
-32374,
-32586,
-32811,
-33048,
-33283,
-33517,
-33718,
-33854,
-33888,
-33788,
-33552,
-33182,
-32742,
-32270,
-31859,
-31558,
-31406,
-31425,
-31591,
-31882,
-32268,
-32701,
-33165,
-33626,
-34057,
-34443,
-34733,
-34927,
-34975,
-34888,
-34665,
-34336,
-33954,
-33553,
-33186,
-32849,
-32549,
-32226,
-31860,
-31396,
-30846,
-30223,
-29583,
-29003,
-28547,
-28293,
-28275,
-28504,
-28972,
-29622,
-30427,
-31302,
-32232,
-33149,
-34020,
-34787,
-35404,
-35811,
-36000,
-35947,
-35705,
-35321,
-34870,
-34418,
-34016,
-33686,
-33423,
-33209,
-32987,
-32742,
-32438,
-32105,
-31776,
-31515,
-31367,
-31370,
-31512,
-31785,
-32136,
-32544,
-32964,
-33386,
-33780,
-34124,
-34387,
-34540,
-34540,
-34364,
-33979,
-33405,
-32667,
-31857,
-31054,
-30380,
-29884,
-29627,
-29571,
-29699,
-29945,
-30282,
-30681,
-31129,
-31630,
-32192,
-32800,
-33457,
-34125,
-34766,
-35341,
-35800,
-36141,
-36363,
-36496,
-36568,
-36568,
-36478,
-36249,
-35841,
-35241,
-34464,
-33564,
-32652,
-31794,
-31115,
-30663,
-30488,
-30571,
-30874,
-31310,
-31828,
-32351,
-32887,
-33399,
-33910,
-34383,
-34782,
-35058,
-35161,
-35069,
-34795,
-34363,
-33849,
-33285,
-32747,
-32248,
-31787,
-31345,
-30853,
-30289,
-29637,
-28936,
-28278,
-27751,
-27466,
-27459,
-27753,
-28320,
-29083,
-30010,
-30994,
-32012,
-32994,
-33913,
-34738,
-35421,
-35937,
-36211,
-36233,
-35961,
-35461,
-34797,
-34083,
-33433,
-32899,
-32525,
-32272,
-32098,
-31936,
-31741,
-31479,
-31171,
-30859,
-30607,
-30512,
-30601,
-30910,
-31393,
-31998,
-32654,
-33330,
-33968,
-34580,
-35103,
-35517,
-35765,
-35802,
-35617,
-35201,
-34588,
-33829,
-33009,
-32232,
-31600,
-31204,
-31073,
-31184,
-31468,
-31844,
-32255,
-32669,
-33085,
-33507,
-33938,
-34350,
-34746,
-35095,
-35416,
-35675,
-35872,
-35977,
-35980,
-35903,
-35749,
-35553,
-35274,
-34878,
-34313,
-33558,
-32654,
-31677,
-30735,
-29904,
-29248,
-28789,
-28562,
-28579,
-28844,
-29333,
-29977,
-30703,
-31444,
-32170,
-32860,
-33511,
-34066,
-34478,
-34687,
-34699,
-34555,
-34337,
-34105,
-33893,
-33671,
-33433,
-33148,
-32854,
-32541,
-32225,
-31861,
-31443,
-30960,
-30488,
-30083,
-29808,
-29662,
-29619,
-29639,
-29738,
-29938,
-30294,
-30794,
-31384,
-31963,
-32447,
-32803,
-33025,
-33132,
-33134,
-33001,
-32758,
-32435,
-32140,
-31961,
-31957,
-32100,
-32325,
-32572,
-32807,
-33073,
-33377,
-33722,
-34043,
-34271,
-34384,
-34406,
-34410,
-34453,
-34552,
-34679,
-34815,
-34962,
-35161,
-35437,
-35754,
-36014,
-36108,
-35963,
-35603,
-35112,
-34582,
-34076,
-33588,
-33114,
-32659,
-32291,
-32058,
-32002,
-32070,
-32212,
-32357,
-32515,
-32720,
-32988,
-33306,
-33574,
-33714,
-33704,
-33596,
-33497,
-33501,
-33598,
-33763,
-33892,
-33957,
-33944,
-33864,
-33706,
-33409,
-32934,
-32277,
-31514,
-30750,
-30076,
-29505,
-29013,
-28545,
-28134,
-27840,
-27772,
-27958,
-28374,
-28898,
-29442,
-29935,
-30388,
-30813,
-31222,
-31591,
-31902,
-32179,
-32472,
-32855,
-33317,
-33805,
-34199,
-34417,
-34446,
-34354,
-34218,
-34092,
-33947,
-33732,
-33424,
-33028,
-32639,
-32318,
-32120,
-32046,
-32079,
-32230,
-32496,
-32882,
-33319,
-33699,
-33929,
-33940,
-33791,
-33571,
-33383,
-33275,
-33216,
-33163,
-33080,
-32986,
-32925,
-32953,
-33064,
-33254,
-33475,
-33733,
-34015,
-34312,
-34601,
-34823,
-34973,
-35081,
-35235,
-35535,
-36003,
-36607,
-37214,
-37707,
-37972,
-38001,
-37791,
-37382,
-36799,
-36060,
-35197,
-34261,
-33281,
-32309,
-31339,
-30401,
-29521,
-28775,
-28237,
-27955,
-27902,
-27996,
-28117,
-28197,
-28200,
-28190,
-28218,
-28360,
-28648,
-29090,
-29677,
-30366,
-31104,
-31815,
-32427,
-32902,
-33239,
-33484,
-33670,
-33807,
-33860,
-33766,
-33500,
-33076,
-32581,
-32104,
-31741,
-31538,
-31495,
-31601,
-31776,
-31979,
-32112,
-32110,
-31957,
-31671,
-31343,
-31064,
-30887,
-30816,
-30806,
-30809,
-30802,
-30836,
-30937,
-31178,
-31538,
-32008,
-32534,
-33072,
-33587,
-34038,
-34393,
-34646,
-34831,
-35025,
-35333,
-35804,
-36426,
-37123,
-37767,
-38295,
-38668,
-38925,
-39095,
-39196,
-39195,
-39055,
-38748,
-38282,
-37663,
-36918,
-36053,
-35098,
-34127,
-33213,
-32464,
-31882,
-31440,
-31024,
-30556,
-30012,
-29436,
-28930,
-28548,
-28327,
-28221,
-28223,
-28297,
-28501,
-28813,
-29264,
-29789,
-30371,
-30985,
-31644,
-32339,
-33027,
-33596,
-33949,
-34017,
-33836,
-33507,
-33148,
-32819,
-32536,
-32236,
-31914,
-31561,
-31230,
-30952,
-30721,
-30519,
-30304,
-30093,
-29917,
-29797,
-29742,
-29685,
-29599,
-29468,
-29367,
-29389,
-29607,
-30003,
-30507,
-31005,
-31433,
-31793,
-32100,
-32412,
-32697,
-32953,
-33147,
-33320,
-33510,
-33783,
-34135,
-34537,
-34949,
-35356,
-35800,
-36311,
-36897,
-37482,
-37961,
-38232,
-38268,
-38107,
-37835,
-37502,
-37139,
-36711,
-36230,
-35696,
-35177,
-34690,
-34252,
-33818,
-33373,
-32915,
-32498,
-32181,
-31980,
-31875,
-31807,
-31754,
-31722,
-31788,
-32019,
-32418,
-32961,
-33550,
-34121,
-34635,
-35086,
-35464,
-35753,
-35896,
-35885,
-35711,
-35440,
-35113,
-34768,
-34384,
-33942,
-33426,
-32875,
-32344,
-31888,
-31502,
-31159,
-30785,
-30363,
-29896,
-29430,
-29013,
-28661,
-28379,
-28167,
-28039,
-28036,
-28174,
-28465,
-28845,
-29288,
-29728,
-30184,
-30661,
-31172,
-31703,
-32218,
-32687,
-33100,
-33498,
-33920,
-34396,
-34927,
-35463,
-35962,
-36403,
-36747,
-37023,
-37192,
-37256,
-37186,
-36990,
-36689,
-36329,
-35943,
-35557,
-35175,
-34807,
-34473,
-34213,
-34039,
-33959,
-33925,
-33879,
-33778,
-33589,
-33356,
-33101,
-32891,
-32743,
-32669,
-32672,
-32737,
-32879,
-33077,
-33337,
-33641,
-33991,
-34379,
-34814,
-35256,
-35696,
-36054,
-36304,
-36418,
-36425,
-36371,
-36327,
-36313,
-36337,
-36335,
-36249,
-36015,
-35599,
-35001,
-34242,
-33377,
-32427,
-31461,
-30464,
-29483,
-28503,
-27532,
-26612,
-25775,
-25100,
-24659,
-24485,
-24592,
-24918,
-25384,
-25898,
-26404,
-26880,
-27351,
-27849,
-28408,
-29032,
-29695,
-30360,
-30963,
-31481,
-31883,
-32177,
-32395,
-32565,
-32725,
-32881,
-33014,
-33081,
-33043,
-32870,
-32582,
-32233,
-31902,
-31667,
-31570,
-31614,
-31755,
-31932,
-32089,
-32171,
-32173,
-32085,
-31935,
-31744,
-31529,
-31300,
-31043,
-30745,
-30388,
-30003,
-29611,
-29311,
-29156,
-29213,
-29497,
-29957,
-30542,
-31159,
-31756,
-32304,
-32813,
-33301,
-33821,
-34374,
-34975,
-35579,
-36146,
-36600,
-36909,
-37028,
-36984,
-36796,
-36510,
-36152,
-35707,
-35163,
-34474,
-33638,
-32679,
-31667,
-30693,
-29860,
-29223,
-28827,
-28638,
-28620,
-28694,
-28801,
-28899,
-28979,
-29049,
-29154,
-29297,
-29508,
-29736,
-29960,
-30130,
-30228,
-30271,
-30295,
-30340,
-30449,
-30616,
-30821,
-31015,
-31139,
-31162,
-31074,
-30897,
-30700,
-30528,
-30461,
-30512,
-30682,
-30932,
-31190,
-31415,
-31547,
-31601,
-31581,
-31536,
-31494,
-31464,
-31433,
-31391,
-31300,
-31181,
-31045,
-30946,
-30948,
-31075,
-31363,
-31770,
-32247,
-32714,
-33103,
-33365,
-33517,
-33586,
-33647,
-33763,
-33963,
-34254,
-34594,
-34932,
-35234,
-35486,
-35710,
-35940,
-36207,
-36507,
-36822,
-37078,
-37243,
-37246,
-37120,
-36872,
-36599,
-36359,
-36222,
-36198,
-36267,
-36362,
-36412,
-36383,
-36249,
-36061,
-35855,
-35691,
-35589,
-35545,
-35535,
-35542,
-35559,
-35624,
-35765,
-36036,
-36449,
-36987,
-37595,
-38193,
-38694,
-39028,
-39177,
-39128,
-38943,
-38662,
-38334,
-37988,
-37615,
-37234,
-36822,
-36434,
-36076,
-35804,
-35622,
-35524,
-35471,
-35427,
-35350,
-35228,
-35082,
-34940,
-34838,
-34823,
-34890,
-35070,
-35307,
-35610,
-35911,
-36224,
-36510,
-36765,
-36979,
-37104,
-37127,
-37012,
-36751,
-36391,
-35965,
-35559,
-35215,
-34963,
-34805,
-34713,
-34654,
-34607,
-34546,
-34471,
-34383,
-34274,
-34148,
-33988,
-33782,
-33535,
-33244,
-32952,
-32692,
-32515,
-32448,
-32489,
-32605,
-32734,
-32831,
-32842,
-32775,
-32626,
-32433,
-32213,
-31989,
-31772,
-31562,
-31382,
-31236,
-31149,
-31141,
-31223,
-31400,
-31659,
-31968,
-32280,
-32556,
-32746,
-32848,
-32847,
-32765,
-32620,
-32413,
-32159,
-31850,
-31495,
-31102,
-30677,
-30227,
-29749,
-29238,
-28701,
-28142,
-27593,
-27077,
-26639,
-26285,
-26056,
-25944,
-25959,
-26105,
-26365,
-26740,
-27213,
-27763,
-28373,
-28993,
-29581,
-30076,
-30429,
-30621,
-30660,
-30583,
-30456,
-30313,
-30195,
-30095,
-29997,
-29895,
-29779,
-29658,
-29557,
-29500,
-29491,
-29535,
-29599,
-29656,
-29663,
-29599,
-29455,
-29255,
-29040,
-28845,
-28703,
-28596,
-28494,
-28348,
-28123,
-27799,
-27415,
-26997,
-26617,
-26307,
-26116,
-26031,
-26078,
-26219,
-26459,
-26773,
-27155,
-27595,
-28089,
-28606,
-29130,
-29597,
-29977,
-30224,
-30331,
-30323,
-30242,
-30153,
-30102,
-30135,
-30260,
-30470,
-30748,
-31044,
-31349,
-31606,
-31833,
-32009,
-32163,
-32301,
-32421,
-32520,
-32563,
-32539,
-32431,
-32257,
-32046,
-31826,
-31625,
-31443,
-31262,
-31053,
-30787,
-30460,
-30099,
-29754,
-29508,
-29431,
-29577,
-29966,
-30561,
-31308,
-32119,
-32940,
-33723,
-34455,
-35142,
-35771,
-36325,
-36758,
-37025,
-37098,
-36988,
-36747,
-36459,
-36234,
-36139,
-36219,
-36459,
-36812,
-37205,
-37590,
-37932,
-38242,
-38554,
-38890,
-39273,
-39667,
-40032,
-40302,
-40437,
-40425,
-40286,
-40076,
-39824,
-39574,
-39292,
-38965,
-38530,
-37975,
-37311,
-36585,
-35895,
-35310,
-34919,
-34737,
-34781,
-35007,
-35383,
-35861,
-36416,
-37025,
-37665,
-38303,
-38898,
-39397,
-39748,
-39925,
-39898,
-39727,
-39412,
-39071,
-38707,
-38400,
-38149,
-37960,
-37841,
-37758,
-37724,
-37712,
-37708,
-37707,
-37671,
-37608,
-37508,
-37372,
-37210,
-37028,
-36816,
-36586,
-36315,
-36020,
-35686,
-35342,
-34976,
-34623,
-34266,
-33942,
-33621,
-33341,
-33086,
-32887,
-32778,
-32771,
-32913,
-33191,
-33587,
-34051,
-34521,
-34942,
-35275,
-35513,
-35647,
-35704,
-35675,
-35575,
-35384,
-35122,
-34788,
-34424,
-34075,
-33777,
-33590,
-33514,
-33565,
-33697,
-33877,
-34054,
-34194,
-34301,
-34363,
-34427,
-34479,
-34537,
-34554,
-34522,
-34391,
-34182,
-33895,
-33584,
-33268,
-32986,
-32733,
-32515,
-32302,
-32088,
-31877,
-31664,
-31502,
-31396,
-31382,
-31458,
-31599,
-31775,
-31938,
-32049,
-32104,
-32101,
-32053,
-31983,
-31870,
-31723,
-31495,
-31193,
-30809,
-30373,
-29919,
-29498,
-29142,
-28878,
-28706,
-28619,
-28604,
-28633,
-28706,
-28798,
-28926,
-29076,
-29247,
-29432,
-29600,
-29743,
-29837,
-29884,
-29885,
-29849,
-29788,
-29681,
-29558,
-29355,
-29124,
-28803,
-28435,
-27988,
-27493,
-26940,
-26370,
-25787,
-25236,
-24736,
-24312,
-23971,
-23712,
-23528,
-23414,
-23357,
-23368,
-23428,
-23559,
-23730,
-23953,
-24191,
-24439,
-24682,
-24917,
-25154,
-25408,
-25690,
-26010,
-26343,
-26681,
-26971,
-27208,
-27373,
-27486,
-27568,
-27654,
-27756,
-27894,
-28047,
-28215,
-28385,
-28552,
-28723,
-28885,
-29046,
-29159,
-29209,
-29148,
-28943,
-28609,
-28129,
-27580,
-26978,
-26401,
-25878,
-25436,
-25104,
-24870,
-24771,
-24803,
-24985,
-25303,
-25761,
-26314,
-26948,
-27599,
-28259,
-28887,
-29503,
-30081,
-30653,
-31189,
-31698,
-32152,
-32538,
-32842,
-33051,
-33179,
-33227,
-33212,
-33169,
-33093,
-33031,
-32977,
-32957,
-32979,
-33043,
-33153,
-33311,
-33490,
-33701,
-33903,
-34081,
-34208,
-34254,
-34202,
-34055,
-33819,
-33539,
-33261,
-33042,
-32929,
-32951,
-33123,
-33440,
-33891,
-34471,
-35155,
-35948,
-36815,
-37737,
-38660,
-39529,
-40290,
-40896,
-41331,
-41606,
-41733,
-41754,
-41676,
-41517,
-41278,
-40945,
-40543,
-40075,
-39596,
-39130,
-38723,
-38388,
-38132,
-37955,
-37844,
-37798,
-37828,
-37929,
-38107,
-38350,
-38619,
-38896,
-39124,
-39292,
-39381,
-39405,
-39366,
-39302,
-39206,
-39115,
-39030,
-38986,
-39016,
-39166,
-39460,
-39922,
-40516,
-41220,
-41952,
-42681,
-43346,
-43934,
-44420,
-44791,
-45020,
-45073,
-44919,
-44549,
-43967,
-43222,
-42371,
-41481,
-40612,
-39781,
-39010,
-38268,
-37571,
-36914,
-36342,
-35887,
-35602,
-35482,
-35520,
-35659,
-35851,
-36052,
-36253,
-36456,
-36682,
-36934,
-37198,
-37436,
-37591,
-37643,
-37559,
-37388,
-37149,
-36934,
-36755,
-36672,
-36654,
-36697,
-36774,
-36864,
-36982,
-37114,
-37291,
-37469,
-37633,
-37706,
-37652,
-37410,
-37002,
-36420,
-35730,
-34959,
-34153,
-33331,
-32506,
-31702,
-30928,
-30230,
-29615,
-29129,
-28764,
-28535,
-28416,
-28390,
-28443,
-28551,
-28715,
-28917,
-29159,
-29414,
-29679,
-29906,
-30095,
-30221,
-30279,
-30276,
-30206,
-30072,
-29867,
-29598,
-29277,
-28928,
-28594,
-28298,
-28072,
-27918,
-27818,
-27755,
-27701,
-27631,
-27535,
-27391,
-27193,
-26924,
-26565,
-26104,
-25536,
-24867,
-24128,
-23365,
-22621,
-21968,
-21416,
-21013,
-20735,
-20590,
-20556,
-20627,
-20809,
-21097,
-21483,
-21961,
-22495,
-23055,
-23617,
-24151,
-24651,
-25109,
-25519,
-25892,
-26204,
-26465,
-26637,
-26729,
-26714,
-26621,
-26446,
-26247,
-26043,
-25886,
-25791,
-25766,
-25820,
-25928,
-26091,
-26277,
-26485,
-26678,
-26848,
-26953,
-26976,
-26884,
-26676,
-26347,
-25921,
-25446,
-24954,
-24519,
-24166,
-23936,
-23834,
-23863,
-24011,
-24279,
-24659,
-25145,
-25733,
-26391,
-27108,
-27830,
-28538,
-29213,
-29828,
-30398,
-30913,
-31369,
-31780,
-32106,
-32359,
-32505,
-32562,
-32521,
-32428,
-32291,
-32168,
-32063,
-32020,
-32027,
-32111,
-32264,
-32492,
-32789,
-33143,
-33521,
-33901,
-34231,
-34490,
-34645,
-34690,
-34633,
-34475,
-34260,
-33990,
-33725,
-33483,
-33309,
-33232,
-33277,
-33462,
-33789,
-34243,
-34806,
-35441,
-36118,
-36804,
-37487,
-38132,
-38735,
-39262,
-39703,
-40034,
-40246,
-40335,
-40323,
-40215,
-40044,
-39814,
-39551,
-39252,
-38939,
-38621,
-38324,
-38075,
-37899,
-37827,
-37866,
-38017,
-38266,
-38582,
-38943,
-39315,
-39679,
-40011,
-40301,
-40529,
-40682,
-40748,
-40722,
-40617,
-40456,
-40274,
-40116,
-40013,
-40011,
-40120,
-40357,
-40722,
-41177,
-41728,
-42306,
-42916,
-43494,
-44033,
-44486,
-44831,
-45040,
-45084,
-44964,
-44675,
-44241,
-43681,
-43035,
-42328,
-41601,
-40865,
-40152,
-39470,
-38843,
-38281,
-37816,
-37457,
-37236,
-37154,
-37203,
-37368,
-37601,
-37897,
-38190,
-38501,
-38781,
-39029,
-39228,
-39335,
-39354,
-39241,
-39026,
-38714,
-38344,
-37971,
-37626,
-37361,
-37186,
-37120,
-37135,
-37246,
-37406,
-37625,
-37867,
-38110,
-38322,
-38452,
-38458,
-38301,
-37969,
-37463,
-36816,
-36050,
-35218,
-34330,
-33432,
-32535,
-31673,
-30868,
-30151,
-29545,
-29062,
-28719,
-28500,
-28415,
-28437,
-28567,
-28788,
-29083,
-29442,
-29825,
-30213,
-30556,
-30829,
-30990,
-31043,
-30961,
-30760,
-30441,
-30013,
-29501,
-28920,
-28324,
-27755,
-27264,
-26888,
-26633,
-26503,
-26454,
-26468,
-26490,
-26516,
-26489,
-26422,
-26265,
-26019,
-25657,
-25174,
-24586,
-23909,
-23205,
-22517,
-21898,
-21396,
-21015,
-20766,
-20628,
-20597,
-20671,
-20852,
-21149,
-21557,
-22067,
-22644,
-23260,
-23879,
-24473,
-25035,
-25543,
-25990,
-26362,
-26628,
-26780,
-26788,
-26653,
-26385,
-26013,
-25575,
-25135,
-24721,
-24397,
-24173,
-24068,
-24083,
-24210,
-24418,
-24704,
-25008,
-25311,
-25562,
-25729,
-25794,
-25737,
-25566,
-25292,
-24937,
-24546,
-24161,
-23827,
-23590,
-23479,
-23503,
-23665,
-23942,
-24326,
-24795,
-25344,
-25957,
-26627,
-27326,
-28040,
-28731,
-29387,
-29970,
-30489,
-30919,
-31276,
-31545,
-31731,
-31821,
-31813,
-31706,
-31517,
-31285,
-31051,
-30865,
-30765,
-30768,
-30887,
-31117,
-31449,
-31886,
-32397,
-32979,
-33572,
-34146,
-34634,
-35008,
-35238,
-35328,
-35304,
-35195,
-35028,
-34836,
-34624,
-34422,
-34234,
-34091,
-34026,
-34061,
-34213,
-34480,
-34809,
-35176,
-35515,
-35814,
-36069,
-36304,
-36547,
-36814,
-37084,
-37334,
-37516,
-37615,
-37624,
-37589,
-37540,
-37525,
-37555,
-37617,
-37681,
-37718,
-37740,
-37757,
-37830,
-37995,
-38295,
-38720,
-39232,
-39772,
-40280,
-40718,
-41087,
-41399,
-41680,
-41935,
-42141,
-42260,
-42260,
-42124,
-41889,
-41601,
-41337,
-41142,
-41042,
-41004,
-41015,
-41012,
-41007,
-40982,
-40983,
-41013,
-41084,
-41168,
-41218,
-41209,
-41103,
-40937,
-40730,
-40553,
-40420,
-40360,
-40324,
-40300,
-40233,
-40142,
-40033,
-39963,
-39949,
-40010,
-40114,
-40228,
-40314,
-40367,
-40397,
-40461,
-40576,
-40761,
-40981,
-41182,
-41300,
-41294,
-41153,
-40903,
-40587,
-40239,
-39868,
-39468,
-39013,
-38491,
-37924,
-37367,
-36877,
-36535,
-36335,
-36284,
-36304,
-36345,
-36348,
-36307,
-36241,
-36178,
-36150,
-36137,
-36121,
-36044,
-35883,
-35635,
-35332,
-35028,
-34761,
-34558,
-34387,
-34219,
-33992,
-33696,
-33332,
-32946,
-32588,
-32299,
-32094,
-31960,
-31865,
-31785,
-31698,
-31616,
-31541,
-31484,
-31415,
-31315,
-31109,
-30777,
-30286,
-29660,
-28951,
-28203,
-27500,
-26861,
-26330,
-25916,
-25619,
-25468,
-25459,
-25601,
-25889,
-26278,
-26730,
-27194,
-27617,
-27984,
-28275,
-28494,
-28659,
-28762,
-28819,
-28822,
-28778,
-28690,
-28562,
-28408,
-28223,
-28023,
-27786,
-27543,
-27280,
-27039,
-26819,
-26671,
-26581,
-26586,
-26645,
-26764,
-26901,
-27037,
-27132,
-27171,
-27104,
-26919,
-26588,
-26121,
-25530,
-24875,
-24200,
-23593,
-23097,
-22767,
-22627,
-22686,
-22956,
-23418,
-24058,
-24841,
-25694,
-26576,
-27389,
-28098,
-28663,
-29065,
-29333,
-29475,
-29518,
-29484,
-29369,
-29193,
-28959,
-28706,
-28444,
-28223,
-28043,
-27920,
-27833,
-27779,
-27744,
-27732,
-27775,
-27874,
-28064,
-28313,
-28596,
-28855,
-29031,
-29084,
-29000,
-28770,
-28430,
-27992,
-27491,
-26944,
-26391,
-25880,
-25474,
-25250,
-25268,
-25565,
-26158,
-27002,
-28036,
-29194,
-30379,
-31545,
-32613,
-33546,
-34300,
-34838,
-35145,
-35202,
-35044,
-34695,
-34229,
-33694,
-33162,
-32663,
-32225,
-31861,
-31563,
-31347,
-31208,
-31159,
-31201,
-31317,
-31491,
-31693,
-31895,
-32075,
-32224,
-32316,
-32368,
-32336,
-32233,
-32028,
-31732,
-31352,
-30932,
-30510,
-30148,
-29914,
-29844,
-30003,
-30393,
-31045,
-31932,
-33042,
-34327,
-35736,
-37203,
-38644,
-39984,
-41133,
-42038,
-42641,
-42953,
-42969,
-42749,
-42333,
-41786,
-41160,
-40516,
-39895,
-39350,
-38921,
-38619,
-38486,
-38488,
-38621,
-38843,
-39093,
-39341,
-39537,
-39662,
-39717,
-39702,
-39624,
-39486,
-39274,
-38986,
-38616,
-38196,
-37759,
-37369,
-37071,
-36906,
-36891,
-37029,
-37312,
-37745,
-38327,
-39077,
-39989,
-41034,
-42162,
-43281,
-44299,
-45116,
-45675,
-45929,
-45888,
-45563,
-44987,
-44185,
-43180,
-42008,
-40716,
-39394,
-38123,
-37018,
-36127,
-35498,
-35095,
-34866,
-34745,
-34675,
-34608,
-34549,
-34459,
-34344,
-34155,
-33862,
-33433,
-32866,
-32189,
-31458,
-30750,
-30117,
-29621,
-29250,
-29014,
-28880,
-28855,
-28945,
-29183,
-29591,
-30184,
-30930,
-31786,
-32673,
-33522,
-34282,
-34918,
-35416,
-35766,
-35930,
-35889,
-35582,
-35007,
-34167,
-33125,
-31975,
-30827,
-29786,
-28930,
-28301,
-27904,
-27743,
-27784,
-28033,
-28466,
-29056,
-29778,
-30538,
-31276,
-31882,
-32304,
-32512,
-32525,
-32410,
-32238,
-32069,
-31948,
-31871,
-31827,
-31813,
-31823,
-31901,
-32075,
-32387,
-32832,
-33383,
-33969,
-34529,
-35000,
-35370,
-35646,
-35859,
-36029,
-36132,
-36133,
-35933,
-35491,
-34745,
-33744,
-32540,
-31263,
-29994,
-28823,
-27769,
-26850,
-26061,
-25431,
-25015,
-24870,
-25033,
-25503,
-26181,
-26954,
-27672,
-28215,
-28547,
-28660,
-28623,
-28492,
-28290,
-28048,
-27709,
-27300,
-26812,
-26325,
-25926,
-25688,
-25663,
-25808,
-26066,
-26329,
-26531,
-26647,
-26702,
-26760,
-26860,
-27011,
-27161,
-27234,
-27159,
-26895,
-26474,
-25955,
-25411,
-24891,
-24395,
-23901,
-23376,
-22825,
-22313,
-21928,
-21810,
-22011,
-22582,
-23458,
-24552,
-25757,
-26974,
-28169,
-29314,
-30408,
-31435,
-32338,
-33061,
-33526,
-33722,
-33666,
-33454,
-33198,
-33003,
-32935,
-32996,
-33148,
-33334,
-33525,
-33697,
-33892,
-34122,
-34401,
-34709,
-34977,
-35154,
-35189,
-35076,
-34850,
-34550,
-34234,
-33914,
-33600,
-33254,
-32876,
-32440,
-31995,
-31578,
-31252,
-31061,
-31040,
-31166,
-31464,
-31870,
-32415,
-33045,
-33774,
-34548,
-35338,
-36070,
-36694,
-37149,
-37412,
-37470,
-37332,
-37021,
-36572,
-36015,
-35406,
-34785,
-34197,
-33678,
-33247,
-32918,
-32675,
-32524,
-32433,
-32403,
-32386,
-32383,
-32334,
-32243,
-32072,
-31832,
-31537,
-31193,
-30852,
-30507,
-30201,
-29927,
-29707,
-29557,
-29482,
-29516,
-29663,
-29937,
-30339,
-30840,
-31427,
-32061,
-32723,
-33401,
-34080,
-34755,
-35408,
-35996,
-36494,
-36835,
-37031,
-37052,
-36962,
-36764,
-36531,
-36249,
-35958,
-35640,
-35330,
-35055,
-34859,
-34799,
-34870,
-35083,
-35375,
-35710,
-36022,
-36294,
-36500,
-36648,
-36719,
-36716,
-36604,
-36398,
-36088,
-35724,
-35342,
-35010,
-34748,
-34613,
-34579,
-34684,
-34883,
-35192,
-35575,
-36025,
-36498,
-36973,
-37409,
-37793,
-38108,
-38343,
-38508,
-38576,
-38556,
-38448,
-38242,
-37990,
-37676,
-37359,
-37019,
-36675,
-36325,
-35980,
-35668,
-35429,
-35284,
-35270,
-35353,
-35541,
-35768,
-36029,
-36293,
-36537,
-36750,
-36895,
-36938,
-36864,
-36674,
-36389,
-36078,
-35765,
-35521,
-35346,
-35275,
-35307,
-35471,
-35759,
-36180,
-36675,
-37196,
-37656,
-38017,
-38222,
-38318,
-38284,
-38174,
-37991,
-37726,
-37417,
-37057,
-36720,
-36447,
-36280,
-36232,
-36284,
-36379,
-36505,
-36602,
-36713,
-36822,
-36965,
-37127,
-37291,
-37426,
-37490,
-37487,
-37399,
-37256,
-37045,
-36771,
-36409,
-35955,
-35405,
-34787,
-34165,
-33581,
-33119,
-32801,
-32659,
-32700,
-32897,
-33247,
-33695,
-34203,
-34701,
-35139,
-35452,
-35606,
-35578,
-35363,
-34966,
-34428,
-33779,
-33094,
-32444,
-31896,
-31499,
-31257,
-31164,
-31170,
-31261,
-31399,
-31586,
-31799,
-32005,
-32169,
-32222,
-32154,
-31943,
-31641,
-31276,
-30890,
-30494,
-30071,
-29619,
-29132,
-28625,
-28160,
-27740,
-27430,
-27201,
-27073,
-27030,
-27083,
-27240,
-27498,
-27844,
-28225,
-28601,
-28910,
-29128,
-29236,
-29242,
-29151,
-28955,
-28680,
-28313,
-27921,
-27549,
-27264,
-27135,
-27168,
-27376,
-27697,
-28113,
-28556,
-29029,
-29491,
-29931,
-30291,
-30524,
-30558,
-30379,
-29973,
-29386,
-28662,
-27855,
-26990,
-26099,
-25193,
-24325,
-23536,
-22897,
-22446,
-22212,
-22172,
-22314,
-22588,
-22991,
-23490,
-24068,
-24687,
-25292,
-25833,
-26264,
-26562,
-26739,
-26803,
-26785,
-26696,
-26551,
-26358,
-26152,
-25946,
-25784,
-25670,
-25626,
-25638,
-25699,
-25808,
-25940,
-26119,
-26312,
-26530,
-26742,
-26946,
-27104,
-27215,
-27250,
-27191,
-27047,
-26790,
-26467,
-26065,
-25637,
-25194,
-24771,
-24408,
-24133,
-24007,
-24052,
-24301,
-24742,
-25336,
-26040,
-26787,
-27551,
-28295,
-29021,
-29709,
-30348,
-30915,
-31385,
-31759,
-32066,
-32353,
-32667,
-33030,
-33446,
-33859,
-34251,
-34570,
-34838,
-35061,
-35280,
-35481,
-35670,
-35792,
-35852,
-35852,
-35831,
-35833,
-35868,
-35916,
-35910,
-35813,
-35568,
-35235,
-34828,
-34443,
-34089,
-33787,
-33525,
-33319,
-33226,
-33319,
-33682,
-34327,
-35219,
-36252,
-37317,
-38325,
-39253,
-40102,
-40881,
-41562,
-42094,
-42393,
-42445,
-42267,
-41959,
-41629,
-41352,
-41134,
-40943,
-40702,
-40401,
-40062,
-39768,
-39582,
-39538,
-39587,
-39670,
-39711,
-39718,
-39717,
-39791,
-39950,
-40180,
-40371,
-40427,
-40283,
-39945,
-39492,
-39011,
-38562,
-38161,
-37784,
-37423,
-37126,
-36979,
-37088,
-37512,
-38221,
-39118,
-40063,
-40941,
-41714,
-42383,
-42986,
-43514,
-43918,
-44112,
-44049,
-43717,
-43224,
-42687,
-42224,
-41887,
-41628,
-41381,
-41061,
-40676,
-40263,
-39923,
-39685,
-39554,
-39442,
-39268,
-38974,
-38579,
-38160,
-37790,
-37528,
-37330,
-37137,
-36875,
-36505,
-36092,
-35693,
-35417,
-35282,
-35298,
-35401,
-35577,
-35806,
-36138,
-36607,
-37216,
-37921,
-38622,
-39206,
-39609,
-39785,
-39767,
-39575,
-39228,
-38730,
-38054,
-37219,
-36260,
-35272,
-34351,
-33564,
-32944,
-32453,
-32051,
-31695,
-31393,
-31158,
-31016,
-30949,
-30900,
-30782,
-30534,
-30129,
-29633,
-29102,
-28639,
-28231,
-27887,
-27535,
-27154,
-26785,
-26492,
-26382,
-26497,
-26811,
-27250,
-27691,
-28077,
-28384,
-28669,
-28975,
-29328,
-29667,
-29917,
-29979,
-29835,
-29502,
-29087,
-28663,
-28280,
-27915,
-27513,
-27019,
-26433,
-25805,
-25210,
-24734,
-24367,
-24089,
-23819,
-23510,
-23163,
-22820,
-22548,
-22363,
-22247,
-22118,
-21909,
-21598,
-21212,
-20847,
-20577,
-20449,
-20433,
-20500,
-20601,
-20779,
-21080,
-21574,
-22266,
-23097,
-23938,
-24677,
-25235,
-25619,
-25871,
-26034,
-26104,
-26041,
-25797,
-25364,
-24823,
-24269,
-23837,
-23545,
-23396,
-23292,
-23176,
-23021,
-22850,
-22726,
-22662,
-22644,
-22607,
-22501,
-22311,
-22095,
-21924,
-21881,
-21980,
-22202,
-22493,
-22809,
-23142,
-23513,
-23943,
-24433,
-24969,
-25503,
-26021,
-26521,
-27035,
-27601,
-28224,
-28896,
-29575,
-30219,
-30799,
-31308,
-31741,
-32100,
-32373,
-32541,
-32603,
-32567,
-32481,
-32387,
-32349,
-32376,
-32490,
-32656,
-32847,
-33047,
-33214,
-33358,
-33446,
-33474,
-33433,
-33302,
-33116,
-32889,
-32689,
-32571,
-32583,
-32771,
-33117,
-33642,
-34290,
-35063,
-35918,
-36835,
-37759,
-38655,
-39456,
-40142,
-40704,
-41156,
-41526,
-41841,
-42085,
-42289,
-42416,
-42520,
-42597,
-42696,
-42803,
-42905,
-42957,
-42944,
-42874,
-42784,
-42715,
-42698,
-42691,
-42664,
-42554,
-42368,
-42133,
-41902,
-41717,
-41540,
-41341,
-41047,
-40671,
-40283,
-39981,
-39884,
-40013,
-40344,
-40799,
-41324,
-41914,
-42610,
-43448,
-44415,
-45408,
-46303,
-46977,
-47382,
-47574,
-47615,
-47604,
-47532,
-47383,
-47104,
-46702,
-46246,
-45843,
-45576,
-45469,
-45467,
-45473,
-45426,
-45298,
-45150,
-45023,
-44949,
-44881,
-44752,
-44487,
-44087,
-43580,
-43077,
-42616,
-42254,
-41916,
-41590,
-41222,
-40858,
-40557,
-40406,
-40433,
-40627,
-40915,
-41240,
-41555,
-41881,
-42248,
-42685,
-43160,
-43614,
-43949,
-44097,
-44048,
-43839,
-43530,
-43173,
-42757,
-42250,
-41609,
-40827,
-39963,
-39082,
-38289,
-37585,
-36971,
-36374,
-35745,
-35088,
-34418,
-33815,
-33277,
-32807,
-32327,
-31787,
-31158,
-30466,
-29788,
-29170,
-28659,
-28225,
-27856,
-27518,
-27244,
-27054,
-27019,
-27108,
-27333,
-27587,
-27849,
-28060,
-28219,
-28343,
-28422,
-28453,
-28412,
-28263,
-28016,
-27664,
-27245,
-26771,
-26249,
-25690,
-25065,
-24400,
-23665,
-22889,
-22084,
-21264,
-20474,
-19737,
-19077,
-18515,
-18045,
-17667,
-17387,
-17210,
-17138,
-17163,
-17236,
-17314,
-17338,
-17300,
-17220,
-17138,
-17116,
-17138,
-17229,
-17342,
-17504,
-17746,
-18120,
-18654,
-19325,
-20045,
-20731,
-21294,
-21730,
-22054,
-22298,
-22479,
-22551,
-22485,
-22258,
-21917,
-21524,
-21171,
-20860,
-20606,
-20321,
-20011,
-19639,
-19277,
-18944,
-18665,
-18409,
-18156,
-17909,
-17697,
-17597,
-17646,
-17848,
-18162,
-18535,
-18935,
-19377,
-19883,
-20451,
-21053,
-21610,
-22088,
-22482,
-22869,
-23302,
-23840,
-24428,
-25015,
-25522,
-25957,
-26348,
-26763,
-27185,
-27552,
-27756,
-27718,
-27462,
-27095,
-26732,
-26466,
-26251,
-26032,
-25735,
-25394,
-25098,
-24970,
-25028,
-25212,
-25365,
-25377,
-25233,
-25039,
-24942,
-25017,
-25251,
-25521,
-25750,
-25937,
-26194,
-26679,
-27448,
-28447,
-29508,
-30457,
-31241,
-31906,
-32588,
-33351,
-34164,
-34887,
-35398,
-35646,
-35748,
-35844,
-36059,
-36382,
-36691,
-36861,
-36837,
-36696,
-36579,
-36611,
-36775,
-36993,
-37120,
-37119,
-37036,
-37002,
-37112,
-37371,
-37674,
-37900,
-37974,
-37933,
-37894,
-37951,
-38155,
-38449,
-38781,
-39120,
-39521,
-40091,
-40887,
-41933,
-43122,
-44372,
-45572,
-46717,
-47797,
-48818,
-49736,
-50469,
-50956,
-51188,
-51189,
-51062,
-50843,
-50580,
-50262,
-49911,
-49561,
-49274,
-49102,
-49045,
-49064,
-49117,
-49155,
-49203,
-49284,
-49388,
-49506,
-49539,
-49446,
-49225,
-48921,
-48628,
-48379,
-48175,
-47959,
-47713,
-47453,
-47279,
-47285,
-47509,
-47922,
-48419,
-48916,
-49384,
-49865,
-50400,
-50998,
-51556,
-51962,
-52095,
-51958,
-51621,
-51183,
-50717,
-50182,
-49515,
-48667,
-47677,
-46672,
-45778,
-45070,
-44500,
-43969,
-43384,
-42747,
-42147,
-41683,
-41389,
-41188,
-40933,
-40510,
-39919,
-39252,
-38655,
-38190,
-37816,
-37419,
-36908,
-36305,
-35740,
-35384,
-35315,
-35503,
-35784,
-36034,
-36185,
-36319,
-36529,
-36858,
-37226,
-37467,
-37417,
-37046,
-36444,
-35771,
-35151,
-34578,
-33963,
-33217,
-32318,
-31393,
-30580,
-29991,
-29592,
-29261,
-28840,
-28276,
-27620,
-27002,
-26519,
-26182,
-25889,
-25534,
-25069,
-24562,
-24138,
-23912,
-23891,
-23985,
-24073,
-24054,
-23966,
-23859,
-23865,
-23961,
-24142,
-24264,
-24296,
-24216,
-24109,
-24051,
-24074,
-24148,
-24181,
-24096,
-23864,
-23514,
-23119,
-22718,
-22325,
-21928,
-21475,
-20991,
-20486,
-20022,
-19639,
-19333,
-19090,
-18848,
-18581,
-18259,
-17882,
-17460,
-17006,
-16547,
-16095,
-15698,
-15367,
-15143,
-15028,
-15060,
-15227,
-15570,
-16055,
-16673,
-17338,
-17977,
-18513,
-18924,
-19206,
-19405,
-19540,
-19598,
-19555,
-19383,
-19102,
-18793,
-18542,
-18414,
-18414,
-18477,
-18528,
-18533,
-18509,
-18533,
-18658,
-18885,
-19147,
-19363,
-19468,
-19501,
-19534,
-19642,
-19867,
-20136,
-20374,
-20513,
-20557,
-20593,
-20722,
-21000,
-21418,
-21901,
-22394,
-22878,
-23420,
-24088,
-24926,
-25894,
-26898,
-27798,
-28559,
-29144,
-29649,
-30106,
-30524,
-30883,
-31089,
-31151,
-31088,
-31015,
-31024,
-31185,
-31466,
-31816,
-32153,
-32478,
-32810,
-33224,
-33736,
-34328,
-34918,
-35432,
-35830,
-36155,
-36466,
-36833,
-37235,
-37658,
-37999,
-38272,
-38479,
-38696,
-38981,
-39330,
-39723,
-40094,
-40449,
-40805,
-41237,
-41773,
-42404,
-43072,
-43709,
-44286,
-44811,
-45311,
-45788,
-46187,
-46445,
-46500,
-46368,
-46102,
-45784,
-45451,
-45109,
-44710,
-44278,
-43845,
-43525,
-43391,
-43466,
-43702,
-44006,
-44331,
-44667,
-45061,
-45548,
-46076,
-46577,
-46912,
-47042,
-46982,
-46804,
-46613,
-46405,
-46164,
-45832,
-45398,
-44935,
-44555,
-44345,
-44338,
-44447,
-44600,
-44711,
-44793,
-44896,
-45052,
-45252,
-45393,
-45369,
-45111,
-44642,
-44053,
-43431,
-42843,
-42246,
-41620,
-40911,
-40199,
-39568,
-39140,
-38952,
-38958,
-39073,
-39203,
-39341,
-39523,
-39804,
-40177,
-40549,
-40807,
-40834,
-40653,
-40317,
-39954,
-39610,
-39255,
-38833,
-38283,
-37682,
-37136,
-36812,
-36745,
-36877,
-37067,
-37185,
-37226,
-37243,
-37337,
-37496,
-37615,
-37528,
-37118,
-36435,
-35619,
-34867,
-34263,
-33769,
-33265,
-32693,
-32104,
-31667,
-31535,
-31718,
-32092,
-32442,
-32609,
-32618,
-32567,
-32628,
-32784,
-32945,
-32913,
-32617,
-32140,
-31666,
-31406,
-31369,
-31458,
-31459,
-31282,
-30966,
-30677,
-30562,
-30592,
-30632,
-30454,
-29985,
-29279,
-28564,
-27974,
-27572,
-27208,
-26736,
-26079,
-25349,
-24724,
-24373,
-24287,
-24315,
-24276,
-24090,
-23821,
-23646,
-23664,
-23851,
-24027,
-24014,
-23730,
-23286,
-22845,
-22554,
-22386,
-22214,
-21888,
-21389,
-20855,
-20501,
-20460,
-20703,
-21056,
-21317,
-21422,
-21442,
-21529,
-21763,
-22059,
-22212,
-22025,
-21462,
-20669,
-19878,
-19272,
-18844,
-18481,
-18040,
-17535,
-17123,
-17026,
-17359,
-18028,
-18807,
-19439,
-19851,
-20118,
-20422,
-20839,
-21303,
-21604,
-21581,
-21246,
-20781,
-20466,
-20449,
-20706,
-21065,
-21356,
-21571,
-21839,
-22354,
-23177,
-24188,
-25144,
-25840,
-26222,
-26435,
-26644,
-26945,
-27264,
-27424,
-27318,
-26967,
-26583,
-26349,
-26402,
-26652,
-26971,
-27225,
-27455,
-27774,
-28334,
-29147,
-30088,
-30966,
-31636,
-32102,
-32470,
-32860,
-33305,
-33713,
-33960,
-33980,
-33847,
-33722,
-33773,
-34051,
-34494,
-34975,
-35400,
-35790,
-36225,
-36799,
-37485,
-38182,
-38704,
-38949,
-38920,
-38726,
-38520,
-38364,
-38243,
-38059,
-37774,
-37436,
-37194,
-37204,
-37538,
-38117,
-38774,
-39348,
-39786,
-40156,
-40577,
-41088,
-41594,
-41924,
-41920,
-41587,
-41091,
-40665,
-40458,
-40459,
-40501,
-40446,
-40280,
-40166,
-40325,
-40854,
-41648,
-42435,
-42957,
-43146,
-43132,
-43153,
-43323,
-43542,
-43574,
-43201,
-42447,
-41558,
-40852,
-40513,
-40457,
-40445,
-40270,
-39961,
-39744,
-39903,
-40508,
-41384,
-42183,
-42667,
-42842,
-42931,
-43185,
-43638,
-44094,
-44248,
-43943,
-43302,
-42637,
-42248,
-42181,
-42252,
-42192,
-41911,
-41549,
-41424,
-41726,
-42397,
-43145,
-43644,
-43776,
-43683,
-43620,
-43731,
-43910,
-43862,
-43375,
-42437,
-41343,
-40407,
-39820,
-39482,
-39159,
-38685,
-38116,
-37714,
-37722,
-38174,
-38855,
-39439,
-39713,
-39725,
-39670,
-39749,
-39956,
-40087,
-39912,
-39333,
-38497,
-37686,
-37110,
-36796,
-36556,
-36217,
-35688,
-35127,
-34720,
-34607,
-34707,
-34821,
-34732,
-34396,
-33930,
-33512,
-33234,
-33032,
-32721,
-32182,
-31420,
-30578,
-29830,
-29248,
-28770,
-28273,
-27673,
-27012,
-26427,
-26029,
-25874,
-25858,
-25887,
-25868,
-25815,
-25801,
-25871,
-26024,
-26160,
-26187,
-26035,
-25742,
-25378,
-25038,
-24734,
-24455,
-24141,
-23775,
-23412,
-23119,
-22966,
-22953,
-22996,
-23040,
-23000,
-22916,
-22811,
-22740,
-22691,
-22619,
-22474,
-22246,
-21975,
-21734,
-21581,
-21537,
-21561,
-21610,
-21647,
-21680,
-21758,
-21910,
-22145,
-22412,
-22653,
-22832,
-22966,
-23125,
-23347,
-23660,
-23994,
-24296,
-24525,
-24721,
-24941,
-25226,
-25548,
-25833,
-26022,
-26113,
-26169,
-26269,
-26443,
-26645,
-26814,
-26902,
-26934,
-26990,
-27110,
-27303,
-27498,
-27625,
-27662,
-27659,
-27687,
-27824,
-28037,
-28287,
-28502,
-28669,
-28860,
-29130,
-29524,
-29984,
-30412,
-30719,
-30902,
-31017,
-31162,
-31350,
-31542,
-31637,
-31610,
-31507,
-31446,
-31519,
-31721,
-31967,
-32172,
-32296,
-32416,
-32599,
-32880,
-33192,
-33421,
-33498,
-33443,
-33347,
-33305,
-33327,
-33358,
-33323,
-33196,
-33049,
-32982,
-33065,
-33286,
-33563,
-33802,
-33983,
-34154,
-34409,
-34782,
-35225,
-35626,
-35879,
-35989,
-36024,
-36111,
-36264,
-36446,
-36501,
-36410,
-36178,
-35975,
-35908,
-35993,
-36142,
-36224,
-36199,
-36141,
-36181,
-36405,
-36752,
-37102,
-37310,
-37360,
-37333,
-37343,
-37449,
-37593,
-37669,
-37587,
-37372,
-37135,
-37003,
-37040,
-37182,
-37339,
-37424,
-37466,
-37574,
-37828,
-38254,
-38723,
-39094,
-39282,
-39324,
-39359,
-39465,
-39637,
-39740,
-39651,
-39374,
-39030,
-38806,
-38775,
-38887,
-38963,
-38916,
-38745,
-38608,
-38613,
-38773,
-38945,
-38953,
-38719,
-38331,
-37936,
-37703,
-37589,
-37510,
-37312,
-36985,
-36638,
-36443,
-36496,
-36735,
-36990,
-37094,
-37005,
-36848,
-36760,
-36828,
-36963,
-36979,
-36773,
-36363,
-35940,
-35688,
-35642,
-35706,
-35680,
-35499,
-35234,
-35058,
-35091,
-35290,
-35475,
-35507,
-35330,
-35077,
-34878,
-34799,
-34749,
-34591,
-34221,
-33693,
-33129,
-32659,
-32322,
-32041,
-31721,
-31334,
-30933,
-30653,
-30566,
-30668,
-30851,
-30985,
-31014,
-30976,
-30957,
-31021,
-31110,
-31113,
-30924,
-30544,
-30105,
-29765,
-29607,
-29598,
-29607,
-29567,
-29510,
-29559,
-29839,
-30325,
-30887,
-31356,
-31617,
-31722,
-31764,
-31830,
-31906,
-31882,
-31651,
-31205,
-30623,
-30073,
-29650,
-29382,
-29180,
-28965,
-28694,
-28461,
-28374,
-28514,
-28836,
-29175,
-29404,
-29453,
-29423,
-29444,
-29582,
-29754,
-29819,
-29656,
-29344,
-29049,
-28962,
-29108,
-29377,
-29607,
-29741,
-29877,
-30160,
-30662,
-31284,
-31839,
-32175,
-32295,
-32325,
-32380,
-32509,
-32577,
-32508,
-32226,
-31853,
-31530,
-31360,
-31331,
-31309,
-31207,
-30984,
-30746,
-30600,
-30597,
-30665,
-30670,
-30521,
-30247,
-29980,
-29855,
-29872,
-29956,
-29943,
-29814,
-29655,
-29632,
-29835,
-30196,
-30560,
-30793,
-30933,
-31109,
-31451,
-31936,
-32405,
-32675,
-32695,
-32570,
-32464,
-32459,
-32485,
-32406,
-32155,
-31799,
-31508,
-31424,
-31546,
-31759,
-31932,
-31998,
-32011,
-32053,
-32147,
-32247,
-32219,
-31998,
-31579,
-31075,
-30626,
-30306,
-30132,
-30034,
-29974,
-29980,
-30133,
-30513,
-31115,
-31825,
-32484,
-33004,
-33378,
-33712,
-34037,
-34337,
-34494,
-34432,
-34175,
-33868,
-33631,
-33532,
-33481,
-33392,
-33242,
-33104,
-33112,
-33306,
-33636,
-33976,
-34225,
-34406,
-34561,
-34788,
-35034,
-35245,
-35288,
-35162,
-34885,
-34567,
-34284,
-34055,
-33870,
-33692,
-33539,
-33465,
-33565,
-33873,
-34384,
-34976,
-35553,
-36037,
-36439,
-36801,
-37134,
-37357,
-37386,
-37153,
-36731,
-36250,
-35839,
-35515,
-35233,
-34921,
-34617,
-34421,
-34433,
-34632,
-34906,
-35114,
-35216,
-35270,
-35368,
-35509,
-35608,
-35540,
-35292,
-34943,
-34652,
-34477,
-34376,
-34246,
-34031,
-33815,
-33730,
-33864,
-34182,
-34536,
-34804,
-34952,
-35080,
-35279,
-35560,
-35801,
-35837,
-35571,
-35089,
-34555,
-34151,
-33880,
-33633,
-33260,
-32736,
-32238,
-31971,
-32084,
-32432,
-32769,
-32828,
-32634,
-32396,
-32361,
-32582,
-32818,
-32761,
-32300,
-31630,
-31160,
-31137,
-31505,
-31901,
-32037,
-31882,
-31755,
-31984,
-32660,
-33486,
-34055,
-34124,
-33842,
-33573,
-33612,
-33924,
-34182,
-34074,
-33513,
-32791,
-32259,
-32132,
-32270,
-32352,
-32120,
-31607,
-31113,
-30955,
-31230,
-31723,
-32071,
-32067,
-31789,
-31548,
-31602,
-31946,
-32283,
-32293,
-31868,
-31243,
-30803,
-30785,
-31095,
-31437,
-31523,
-31395,
-31327,
-31618,
-32316,
-33159,
-33762,
-33946,
-33790,
-33602,
-33581,
-33702,
-33727,
-33441,
-32822,
-32100,
-31534,
-31295,
-31283,
-31321,
-31210,
-30974,
-30728,
-30655,
-30800,
-31065,
-31258,
-31247,
-31032,
-30763,
-30608,
-30632,
-30752,
-30810,
-30704,
-30475,
-30292,
-30294,
-30513,
-30815,
-31056,
-31150,
-31194,
-31305,
-31564,
-31917,
-32206,
-32341,
-32308,
-32203,
-32114,
-32047,
-31963,
-31783,
-31523,
-31236,
-30995,
-30830,
-30726,
-30659,
-30609,
-30599,
-30610,
-30654,
-30680,
-30702,
-30708,
-30723,
-30746,
-30769,
-30782,
-30801,
-30846,
-30960,
-31137,
-31371,
-31629,
-31899,
-32162,
-32427,
-32688,
-32949,
-33198,
-33413,
-33562,
-33633,
-33628,
-33598,
-33576,
-33581,
-33555,
-33460,
-33282,
-33083,
-32961,
-32952,
-33027,
-33075,
-33051,
-32969,
-32958,
-33071,
-33297,
-33496,
-33551,
-33461,
-33305,
-33241,
-33290,
-33403,
-33459,
-33422,
-33369,
-33423,
-33686,
-34110,
-34586,
-35002,
-35314,
-35579,
-35846,
-36127,
-36361,
-36454,
-36369,
-36136,
-35833,
-35561,
-35343,
-35184,
-35031,
-34873,
-34718,
-34633,
-34632,
-34729,
-34837,
-34895,
-34856,
-34744,
-34623,
-34530,
-34460,
-34358,
-34206,
-34016,
-33868,
-33809,
-33839,
-33914,
-33977,
-34034,
-34118,
-34275,
-34483,
-34702,
-34877,
-35008,
-35138,
-35290,
-35459,
-35575,
-35600,
-35536,
-35422,
-35318,
-35198,
-35031,
-34778,
-34465,
-34170,
-33958,
-33835,
-33760,
-33665,
-33550,
-33449,
-33406,
-33424,
-33447,
-33398,
-33242,
-32998,
-32724,
-32481,
-32279,
-32102,
-31924,
-31749,
-31615,
-31574,
-31662,
-31858,
-32109,
-32351,
-32535,
-32665,
-32770,
-32860,
-32926,
-32915,
-32777,
-32539,
-32248,
-31990,
-31813,
-31689,
-31586,
-31472,
-31380,
-31361,
-31441,
-31577,
-31700,
-31746,
-31709,
-31633,
-31531,
-31418,
-31228,
-30971,
-30644,
-30325,
-30058,
-29867,
-29727,
-29622,
-29554,
-29546,
-29621,
-29755,
-29909,
-30039,
-30128,
-30182,
-30207,
-30204,
-30156,
-30058,
-29922,
-29784,
-29658,
-29566,
-29504,
-29463,
-29469,
-29519,
-29629,
-29793,
-29987,
-30196,
-30394,
-30586,
-30749,
-30909,
-31043,
-31147,
-31196,
-31162,
-31051,
-30890,
-30722,
-30575,
-30444,
-30305,
-30147,
-29996,
-29915,
-29953,
-30109,
-30324,
-30517,
-30660,
-30765,
-30888,
-31030,
-31157,
-31191,
-31086,
-30869,
-30624,
-30447,
-30368,
-30382,
-30430,
-30512,
-30648,
-30900,
-31295,
-31802,
-32344,
-32822,
-33186,
-33438,
-33615,
-33763,
-33869,
-33918,
-33843,
-33678,
-33462,
-33310,
-33277,
-33370,
-33521,
-33650,
-33745,
-33836,
-33992,
-34229,
-34480,
-34650,
-34672,
-34558,
-34409,
-34296,
-34256,
-34227,
-34141,
-33983,
-33815,
-33725,
-33787,
-33959,
-34184,
-34376,
-34528,
-34686,
-34920,
-35240,
-35618,
-35952,
-36192,
-36329,
-36420,
-36521,
-36659,
-36783,
-36837,
-36773,
-36630,
-36485,
-36416,
-36438,
-36500,
-36527,
-36505,
-36465,
-36481,
-36584,
-36735,
-36839,
-36830,
-36698,
-36508,
-36341,
-36197,
-36054,
-35834,
-35557,
-35250,
-35039,
-34948,
-34981,
-35075,
-35157,
-35234,
-35330,
-35473,
-35672,
-35845,
-35950,
-35929,
-35808,
-35642,
-35462,
-35309,
-35142,
-34965,
-34758,
-34582,
-34463,
-34443,
-34498,
-34575,
-34640,
-34655,
-34645,
-34631,
-34602,
-34545,
-34411,
-34192,
-33926,
-33646,
-33409,
-33213,
-33032,
-32861,
-32694,
-32575,
-32515,
-32513,
-32525,
-32515,
-32464,
-32391,
-32319,
-32255,
-32180,
-32066,
-31904,
-31720,
-31534,
-31384,
-31256,
-31132,
-31001,
-30853,
-30720,
-30617,
-30558,
-30533,
-30517,
-30502,
-30483,
-30486,
-30507,
-30563,
-30616,
-30642,
-30629,
-30565,
-30489,
-30404,
-30331,
-30237,
-30127,
-29996,
-29879,
-29812,
-29815,
-29869,
-29946,
-30013,
-30070,
-30132,
-30195,
-30268,
-30278,
-30234,
-30103,
-29932,
-29751,
-29585,
-29438,
-29299,
-29177,
-29079,
-29052,
-29083,
-29189,
-29320,
-29459,
-29587,
-29693,
-29799,
-29889,
-29968,
-30019,
-30034,
-30027,
-30011,
-30015,
-30052,
-30120,
-30213,
-30310,
-30416,
-30524,
-30655,
-30795,
-30935,
-31052,
-31139,
-31199,
-31259,
-31319,
-31382,
-31427,
-31453,
-31459,
-31470,
-31498,
-31519,
-31540,
-31507,
-31473,
-31420,
-31418,
-31432,
-31465,
-31491,
-31512,
-31561,
-31665,
-31819,
-31997,
-32146,
-32254,
-32325,
-32394,
-32476,
-32557,
-32598,
-32581,
-32524,
-32480,
-32498,
-32591,
-32732,
-32878,
-33015,
-33160,
-33345,
-33590,
-33848,
-34079,
-34206,
-34254,
-34242,
-34234,
-34246,
-34258,
-34236,
-34170,
-34086,
-34055,
-34114,
-34267,
-34458,
-34627,
-34738,
-34819,
-34912,
-35039,
-35184,
-35268,
-35268,
-35156,
-35026,
-34928,
-34915,
-34943,
-34966,
-34931,
-34878,
-34851,
-34931,
-35097,
-35297,
-35452,
-35525,
-35568,
-35641,
-35794,
-36003,
-36187,
-36284,
-36302,
-36282,
-36321,
-36403,
-36518,
-36550,
-36512,
-36392,
-36308,
-36287,
-36346,
-36414,
-36434,
-36407,
-36356,
-36364,
-36422,
-36499,
-36515,
-36424,
-36241,
-36017,
-35814,
-35627,
-35443,
-35203,
-34929,
-34654,
-34455,
-34368,
-34379,
-34437,
-34486,
-34520,
-34550,
-34618,
-34711,
-34799,
-34817,
-34736,
-34574,
-34368,
-34192,
-34032,
-33913,
-33763,
-33622,
-33476,
-33405,
-33405,
-33470,
-33549,
-33597,
-33589,
-33557,
-33487,
-33425,
-33307,
-33146,
-32902,
-32619,
-32324,
-32061,
-31834,
-31649,
-31471,
-31339,
-31218,
-31173,
-31157,
-31180,
-31201,
-31195,
-31169,
-31112,
-31049,
-30970,
-30873,
-30757,
-30611,
-30472,
-30339,
-30242,
-30175,
-30144,
-30122,
-30119,
-30129,
-30160,
-30214,
-30275,
-30330,
-30366,
-30379,
-30370,
-30354,
-30316,
-30263,
-30177,
-30068,
-29944,
-29828,
-29716,
-29631,
-29550,
-29499,
-29471,
-29487,
-29547,
-29635,
-29740,
-29826,
-29895,
-29930,
-29936,
-29911,
-29839,
-29720,
-29546,
-29349,
-29147,
-29000,
-28903,
-28877,
-28904,
-28968,
-29090,
-29266,
-29495,
-29764,
-29998,
-30194,
-30291,
-30346,
-30357,
-30373,
-30373,
-30359,
-30321,
-30295,
-30317,
-30440,
-30636,
-30910,
-31166,
-31429,
-31655,
-31890,
-32116,
-32304,
-32428,
-32449,
-32393,
-32302,
-32209,
-32144,
-32075,
-31991,
-31897,
-31825,
-31818,
-31892,
-32012,
-32144,
-32253,
-32346,
-32470,
-32643,
-32855,
-33067,
-33213,
-33312,
-33368,
-33464,
-33588,
-33727,
-33832,
-33875,
-33893,
-33950,
-34079,
-34288,
-34507,
-34716,
-34879,
-35062,
-35260,
-35494,
-35695,
-35806,
-35806,
-35704,
-35558,
-35389,
-35202,
-34975,
-34709,
-34434,
-34205,
-34061,
-34015,
-34052,
-34133,
-34253,
-34392,
-34564,
-34765,
-34966,
-35144,
-35257,
-35298,
-35280,
-35230,
-35201,
-35190,
-35205,
-35209,
-35217,
-35244,
-35356,
-35556,
-35834,
-36108,
-36323,
-36460,
-36549,
-36651,
-36741,
-36776,
-36688,
-36455,
-36142,
-35835,
-35581,
-35388,
-35176,
-34940,
-34691,
-34500,
-34428,
-34459,
-34535,
-34593,
-34601,
-34591,
-34603,
-34644,
-34697,
-34714,
-34680,
-34601,
-34513,
-34445,
-34414,
-34415,
-34422,
-34428,
-34406,
-34383,
-34342,
-34336,
-34322,
-34299,
-34211,
-34041,
-33819,
-33570,
-33356,
-33149,
-32920,
-32630,
-32280,
-31946,
-31664,
-31479,
-31332,
-31174,
-30988,
-30798,
-30667,
-30638,
-30654,
-30684,
-30640,
-30562,
-30470,
-30425,
-30419,
-30415,
-30376,
-30291,
-30211,
-30170,
-30207,
-30300,
-30415,
-30530,
-30647,
-30771,
-30915,
-31055,
-31170,
-31218,
-31198,
-31105,
-30964,
-30787,
-30592,
-30383,
-30178,
-29989,
-29842,
-29759,
-29758,
-29836,
-29984,
-30186,
-30418,
-30682,
-30950,
-31228,
-31475,
-31690,
-31852,
-31967,
-32045,
-32094,
-32126,
-32148,
-32163,
-32201,
-32264,
-32365,
-32501,
-32657,
-32835,
-33026,
-33232,
-33420,
-33587,
-33696,
-33747,
-33750,
-33694,
-33602,
-33456,
-33256,
-33023,
-32776,
-32552,
-32369,
-32223,
-32121,
-32044,
-32011,
-32042,
-32115,
-32252,
-32389,
-32530,
-32649,
-32749,
-32846,
-32928,
-32990,
-33020,
-33010,
-32980,
-32936,
-32896,
-32862,
-32820,
-32773,
-32723,
-32672,
-32627,
-32583,
-32539,
-32484,
-32428,
-32360,
-32297,
-32233,
-32172,
-32119,
-32074,
-32041,
-32022,
-32007,
-32009,
-32026,
-32056,
-32104,
-32148,
-32202,
-32248,
-32313,
-32390,
-32479,
-32576,
-32675,
-32787,
-32921,
-33085,
-33278,
-33479,
-33692,
-33897,
-34118,
-34335,
-34552,
-34727,
-34867,
-34952,
-35010,
-35028,
-35009,
-34938,
-34820,
-34667,
-34523,
-34381,
-34263,
-34135,
-34021,
-33919,
-33874,
-33873,
-33914,
-33946,
-33974,
-33991,
-34022,
-34068,
-34096,
-34089,
-34015,
-33907,
-33780,
-33661,
-33532,
-33376,
-33191,
-32996,
-32832,
-32713,
-32634,
-32572,
-32518,
-32482,
-32478,
-32516,
-32575,
-32618,
-32626,
-32598,
-32542,
-32469,
-32357,
-32194,
-31971,
-31704,
-31422,
-31144,
-30879,
-30629,
-30406,
-30218,
-30092,
-30034,
-30038,
-30090,
-30185,
-30310,
-30459,
-30627,
-30772,
-30896,
-30981,
-31038,
-31065,
-31072,
-31047,
-31003,
-30953,
-30920,
-30928,
-30983,
-31079,
-31221,
-31397,
-31615,
-31878,
-32167,
-32475,
-32766,
-33035,
-33271,
-33477,
-33661,
-33814,
-33939,
-34021,
-34078,
-34114,
-34158,
-34212,
-34270,
-34320,
-34347,
-34374,
-34395,
-34438,
-34470,
-34490,
-34472,
-34439,
-34420,
-34424,
-34461,
-34502,
-34529,
-34559,
-34605,
-34689,
-34795,
-34875,
-34906,
-34868,
-34803,
-34719,
-34634,
-34501,
-34317,
-34083,
-33857,
-33687,
-33586,
-33539,
-33515,
-33514,
-33547,
-33649,
-33787,
-33943,
-34040,
-34071,
-34027,
-33932,
-33788,
-33567,
-33282,
-32929,
-32569,
-32224,
-31930,
-31671,
-31465,
-31321,
-31272,
-31314,
-31418,
-31543,
-31653,
-31776,
-31899,
-32042,
-32147,
-32182,
-32136,
-32066,
-32015,
-32017,
-32031,
-32018,
-31970,
-31935,
-31975,
-32096,
-32258,
-32379,
-32439,
-32471,
-32551,
-32693,
-32877,
-33009,
-33088,
-33131,
-33231,
-33397,
-33608,
-33767,
-33841,
-33851,
-33852,
-33881,
-33895,
-33836,
-33681,
-33468,
-33286,
-33178,
-33125,
-33097,
-33057,
-33064,
-33152,
-33347,
-33587,
-33796,
-33944,
-34029,
-34109,
-34166,
-34153,
-34026,
-33770,
-33467,
-33185,
-32953,
-32740,
-32503,
-32256,
-32069,
-31999,
-32048,
-32126,
-32161,
-32129,
-32090,
-32100,
-32148,
-32158,
-32057,
-31854,
-31633,
-31496,
-31437,
-31417,
-31327,
-31193,
-31079,
-31061,
-31143,
-31223,
-31216,
-31104,
-30956,
-30867,
-30832,
-30806,
-30701,
-30545,
-30408,
-30388,
-30493,
-30652,
-30786,
-30882,
-30986,
-31148,
-31352,
-31498,
-31524,
-31424,
-31260,
-31122,
-30995,
-30867,
-30694,
-30535,
-30482,
-30588,
-30857,
-31201,
-31584,
-31988,
-32472,
-33002,
-33523,
-33922,
-34142,
-34229,
-34230,
-34210,
-34111,
-33913,
-33611,
-33321,
-33140,
-33125,
-33210,
-33315,
-33406,
-33521,
-33733,
-34016,
-34278,
-34406,
-34354,
-34202,
-34043,
-33916,
-33781,
-33581,
-33310,
-33077,
-32957,
-32997,
-33119,
-33240,
-33319,
-33393,
-33509,
-33669,
-33801,
-33854,
-33800,
-33729,
-33686,
-33704,
-33741,
-33771,
-33791,
-33859,
-33983,
-34135,
-34250,
-34267,
-34196,
-34070,
-33906,
-33682,
-33359,
-32943,
-32499,
-32104,
-31806,
-31590,
-31412,
-31278,
-31219,
-31273,
-31444,
-31649,
-31836,
-31943,
-32017,
-32072,
-32120,
-32137,
-32080,
-31967,
-31846,
-31761,
-31752,
-31798,
-31883,
-32015,
-32187,
-32422,
-32680,
-32949,
-33180,
-33381,
-33530,
-33627,
-33645,
-33585,
-33479,
-33334,
-33211,
-33057,
-32916,
-32750,
-32628,
-32557,
-32543,
-32547,
-32520,
-32462,
-32390,
-32332,
-32288,
-32224,
-32127,
-32007,
-31941,
-31946,
-32063,
-32226,
-32447,
-32693,
-33019,
-33384,
-33770,
-34089,
-34312,
-34423,
-34463,
-34422,
-34302,
-34085,
-33788,
-33503,
-33269,
-33147,
-33095,
-33104,
-33176,
-33324,
-33558,
-33830,
-34049,
-34167,
-34159,
-34050,
-33880,
-33616,
-33262,
-32822,
-32374,
-32004,
-31759,
-31638,
-31617,
-31690,
-31884,
-32208,
-32628,
-33056,
-33416,
-33679,
-33876,
-34026,
-34117,
-34100,
-33971,
-33775,
-33606,
-33525,
-33524,
-33546,
-33571,
-33609,
-33716,
-33882,
-34057,
-34144,
-34099,
-33965,
-33783,
-33605,
-33398,
-33136,
-32846,
-32588,
-32444,
-32424,
-32495,
-32596,
-32725,
-32894,
-33114,
-33332,
-33483,
-33513,
-33457,
-33360,
-33268,
-33155,
-33008,
-32840,
-32731,
-32767,
-32932,
-33206,
-33468,
-33730,
-34003,
-34316,
-34630,
-34843,
-34870,
-34723,
-34475,
-34201,
-33918,
-33580,
-33173,
-32755,
-32419,
-32237,
-32179,
-32182,
-32183,
-32208,
-32288,
-32413,
-32534,
-32543,
-32453,
-32282,
-32133,
-31986,
-31835,
-31616,
-31398,
-31254,
-31255,
-31385,
-31533,
-31656,
-31752,
-31895,
-32103,
-32313,
-32403,
-32329,
-32134,
-31945,
-31811,
-31709,
-31556,
-31349,
-31162,
-31110,
-31221,
-31415,
-31566,
-31623,
-31624,
-31624,
-31623,
-31530,
-31250,
-30811,
-30303,
-29860,
-29514,
-29243,
-29002,
-28851,
-28861,
-29099,
-29504,
-29950,
-30332,
-30633,
-30880,
-31095,
-31193,
-31104,
-30822,
-30424,
-30075,
-29825,
-29702,
-29638,
-29667,
-29835,
-30221,
-30771,
-31371,
-31882,
-32252,
-32505,
-32681,
-32752,
-32672,
-32397,
-32015,
-31652,
-31410,
-31320,
-31309,
-31365,
-31491,
-31751,
-32123,
-32508,
-32803,
-32913,
-32899,
-32804,
-32681,
-32499,
-32246,
-31953,
-31732,
-31675,
-31807,
-32065,
-32383,
-32737,
-33135,
-33584,
-34009,
-34332,
-34483,
-34501,
-34442,
-34372,
-34281,
-34165,
-34047,
-34009,
-34116,
-34375,
-34728,
-35085,
-35441,
-35794,
-36176,
-36512,
-36733,
-36763,
-36652,
-36462,
-36286,
-36085,
-35853,
-35562,
-35289,
-35125,
-35098,
-35174,
-35247,
-35297,
-35336,
-35421,
-35535,
-35610,
-35573,
-35417,
-35219,
-35049,
-34921,
-34803,
-34658,
-34540,
-34509,
-34637,
-34864,
-35124,
-35335,
-35522,
-35728,
-35959,
-36150,
-36205,
-36105,
-35920,
-35760,
-35679,
-35637,
-35578,
-35507,
-35491,
-35621,
-35878,
-36153,
-36328,
-36352,
-36266,
-36138,
-35946,
-35634,
-35139,
-34513,
-33894,
-33388,
-33055,
-32813,
-32644,
-32533,
-32558,
-32734,
-32976,
-33176,
-33206,
-33093,
-32892,
-32662,
-32397,
-32050,
-31637,
-31257,
-31021,
-31006,
-31158,
-31395,
-31649,
-31929,
-32250,
-32591,
-32845,
-32920,
-32778,
-32505,
-32185,
-31895,
-31611,
-31325,
-31053,
-30881,
-30864,
-30985,
-31155,
-31257,
-31251,
-31150,
-30977,
-30730,
-30347,
-29820,
-29187,
-28575,
-28078,
-27743,
-27536,
-27425,
-27405,
-27518,
-27754,
-28072,
-28347,
-28508,
-28526,
-28455,
-28347,
-28225,
-28060,
-27872,
-27698,
-27639,
-27752,
-28030,
-28414,
-28832,
-29254,
-29684,
-30117,
-30500,
-30773,
-30870,
-30831,
-30691,
-30548,
-30401,
-30260,
-30112,
-29998,
-29959,
-30038,
-30199,
-30385,
-30540,
-30640,
-30703,
-30741,
-30734,
-30649,
-30481,
-30259,
-30051,
-29917,
-29859,
-29882,
-29962,
-30131,
-30415,
-30806,
-31279,
-31745,
-32170,
-32533,
-32856,
-33137,
-33364,
-33493,
-33535,
-33527,
-33552,
-33647,
-33830,
-34064,
-34345,
-34676,
-35093,
-35563,
-36039,
-36433,
-36681,
-36793,
-36777,
-36668,
-36434,
-36088,
-35637,
-35181,
-34802,
-34559,
-34449,
-34447,
-34534,
-34728,
-35033,
-35395,
-35746,
-35969,
-36055,
-36019,
-35904,
-35725,
-35476,
-35168,
-34877,
-34697,
-34703,
-34885,
-35201,
-35599,
-36069,
-36618,
-37186,
-37696,
-38030,
-38157,
-38116,
-37959,
-37741,
-37434,
-37072,
-36698,
-36426,
-36328,
-36399,
-36565,
-36767,
-36972,
-37193,
-37390,
-37495,
-37413,
-37123,
-36677,
-36160,
-35637,
-35118,
-34627,
-34216,
-33984,
-33984,
-34198,
-34544,
-34930,
-35321,
-35711,
-36050,
-36283,
-36294,
-36095,
-35720,
-35293,
-34868,
-34484,
-34135,
-33882,
-33803,
-33941,
-34295,
-34742,
-35195,
-35574,
-35874,
-36066,
-36097,
-35901,
-35446,
-34802,
-34080,
-33384,
-32777,
-32258,
-31863,
-31632,
-31629,
-31840,
-32178,
-32521,
-32764,
-32887,
-32884,
-32759,
-32462,
-31976,
-31330,
-30650,
-30070,
-29665,
-29452,
-29382,
-29469,
-29714,
-30139,
-30662,
-31145,
-31450,
-31528,
-31406,
-31144,
-30751,
-30210,
-29536,
-28849,
-28281,
-27971,
-27888,
-27991,
-28190,
-28500,
-28915,
-29400,
-29816,
-30015,
-29936,
-29640,
-29218,
-28742,
-28184,
-27569,
-26967,
-26529,
-26379,
-26503,
-26811,
-27205,
-27647,
-28167,
-28730,
-29230,
-29517,
-29540,
-29348,
-29072,
-28768,
-28447,
-28068,
-27700,
-27455,
-27453,
-27688,
-28060,
-28450,
-28824,
-29214,
-29635,
-30008,
-30218,
-30192,
-29987,
-29718,
-29491,
-29300,
-29119,
-28940,
-28859,
-28971,
-29302,
-29773,
-30255,
-30678,
-31061,
-31426,
-31759,
-31964,
-31968,
-31782,
-31521,
-31297,
-31144,
-31052,
-30981,
-30989,
-31177,
-31561,
-32112,
-32669,
-33143,
-33515,
-33825,
-34081,
-34200,
-34099,
-33762,
-33307,
-32886,
-32581,
-32382,
-32231,
-32151,
-32242,
-32572,
-33117,
-33704,
-34194,
-34535,
-34781,
-34976,
-35067,
-34961,
-34623,
-34149,
-33721,
-33450,
-33325,
-33286,
-33301,
-33451,
-33804,
-34322,
-34863,
-35257,
-35466,
-35536,
-35533,
-35447,
-35194,
-34775,
-34276,
-33874,
-33654,
-33619,
-33668,
-33792,
-34007,
-34366,
-34804,
-35202,
-35417,
-35437,
-35304,
-35090,
-34807,
-34419,
-33967,
-33520,
-33223,
-33121,
-33198,
-33416,
-33714,
-34121,
-34579,
-35054,
-35420,
-35646,
-35689,
-35602,
-35379,
-35058,
-34668,
-34266,
-33951,
-33742,
-33674,
-33730,
-33923,
-34241,
-34662,
-35091,
-35464,
-35732,
-35902,
-35984,
-35942,
-35773,
-35479,
-35153,
-34888,
-34716,
-34637,
-34625,
-34699,
-34908,
-35250,
-35644,
-35992,
-36216,
-36356,
-36430,
-36449,
-36343,
-36090,
-35751,
-35458,
-35300,
-35270,
-35305,
-35378,
-35540,
-35852,
-36272,
-36663,
-36908,
-36953,
-36896,
-36773,
-36580,
-36245,
-35771,
-35284,
-34928,
-34791,
-34806,
-34914,
-35082,
-35379,
-35804,
-36280,
-36634,
-36779,
-36721,
-36552,
-36311,
-35965,
-35484,
-34937,
-34461,
-34199,
-34126,
-34195,
-34295,
-34459,
-34714,
-35013,
-35261,
-35296,
-35124,
-34785,
-34402,
-33973,
-33510,
-33012,
-32579,
-32313,
-32253,
-32322,
-32466,
-32601,
-32760,
-32892,
-32935,
-32793,
-32477,
-32035,
-31586,
-31143,
-30725,
-30353,
-30127,
-30119,
-30332,
-30656,
-30980,
-31269,
-31528,
-31768,
-31859,
-31730,
-31349,
-30850,
-30393,
-30013,
-29681,
-29354,
-29120,
-29104,
-29354,
-29727,
-30034,
-30179,
-30228,
-30279,
-30306,
-30152,
-29736,
-29142,
-28632,
-28360,
-28282,
-28242,
-28163,
-28181,
-28439,
-28925,
-29394,
-29600,
-29519,
-29327,
-29206,
-29117,
-28896,
-28466,
-28003,
-27798,
-27967,
-28388,
-28805,
-29136,
-29513,
-30047,
-30683,
-31130,
-31182,
-30889,
-30490,
-30178,
-29912,
-29530,
-29026,
-28585,
-28484,
-28757,
-29224,
-29623,
-29897,
-30171,
-30533,
-30899,
-31020,
-30773,
-30256,
-29730,
-29350,
-29079,
-28800,
-28507,
-28361,
-28538,
-29008,
-29585,
-30060,
-30374,
-30629,
-30864,
-31031,
-30976,
-30671,
-30232,
-29865,
-29672,
-29648,
-29716,
-29875,
-30195,
-30711,
-31374,
-32004,
-32485,
-32731,
-32805,
-32715,
-32470,
-32057,
-31502,
-30917,
-30434,
-30149,
-30094,
-30251,
-30570,
-31027,
-31579,
-32161,
-32707,
-33091,
-33255,
-33155,
-32853,
-32438,
-31992,
-31575,
-31198,
-30936,
-30881,
-31120,
-31648,
-32340,
-33048,
-33683,
-34249,
-34746,
-35119,
-35242,
-35053,
-34662,
-34239,
-33962,
-33839,
-33805,
-33855,
-34078,
-34590,
-35351,
-36168,
-36802,
-37176,
-37360,
-37443,
-37397,
-37084,
-36486,
-35741,
-35139,
-34854,
-34841,
-34979,
-35192,
-35597,
-36276,
-37172,
-38000,
-38521,
-38672,
-38598,
-38457,
-38215,
-37771,
-37101,
-36400,
-35963,
-35929,
-36219,
-36628,
-37077,
-37626,
-38357,
-39158,
-39784,
-40006,
-39846,
-39462,
-39046,
-38591,
-38038,
-37385,
-36827,
-36576,
-36722,
-37119,
-37566,
-37954,
-38315,
-38684,
-38979,
-38994,
-38628,
-37922,
-37108,
-36345,
-35699,
-35124,
-34650,
-34388,
-34478,
-34902,
-35528,
-36110,
-36556,
-36822,
-36943,
-36860,
-36492,
-35805,
-34892,
-33958,
-33156,
-32594,
-32237,
-32104,
-32205,
-32567,
-33136,
-33770,
-34283,
-34554,
-34548,
-34290,
-33813,
-33131,
-32290,
-31377,
-30557,
-29956,
-29663,
-29648,
-29852,
-30197,
-30640,
-31101,
-31496,
-31686,
-31579,
-31170,
-30538,
-29803,
-29068,
-28382,
-27818,
-27449,
-27375,
-27633,
-28148,
-28785,
-29397,
-29886,
-30234,
-30382,
-30285,
-29882,
-29218,
-28421,
-27675,
-27093,
-26730,
-26579,
-26663,
-27016,
-27625,
-28387,
-29126,
-29683,
-30005,
-30091,
-29984,
-29659,
-29139,
-28476,
-27845,
-27385,
-27205,
-27277,
-27559,
-28004,
-28606,
-29310,
-30009,
-30548,
-30821,
-30836,
-30642,
-30333,
-29935,
-29494,
-29098,
-28853,
-28878,
-29180,
-29687,
-30321,
-30991,
-31657,
-32251,
-32672,
-32841,
-32726,
-32383,
-31923,
-31425,
-30982,
-30622,
-30453,
-30515,
-30858,
-31428,
-32129,
-32855,
-33518,
-34055,
-34412,
-34529,
-34396,
-34032,
-33537,
-33008,
-32540,
-32206,
-32058,
-32120,
-32417,
-32895,
-33495,
-34110,
-34645,
-35042,
-35229,
-35215,
-34975,
-34583,
-34089,
-33602,
-33190,
-32944,
-32887,
-33050,
-33400,
-33876,
-34414,
-34913,
-35303,
-35511,
-35504,
-35272,
-34851,
-34315,
-33748,
-33246,
-32879,
-32707,
-32774,
-33071,
-33571,
-34177,
-34808,
-35352,
-35758,
-35946,
-35912,
-35631,
-35165,
-34579,
-33997,
-33490,
-33158,
-33018,
-33113,
-33425,
-33925,
-34523,
-35119,
-35617,
-35944,
-36066,
-35977,
-35680,
-35225,
-34691,
-34165,
-33763,
-33523,
-33492,
-33658,
-34007,
-34476,
-35006,
-35477,
-35817,
-35958,
-35891,
-35619,
-35180,
-34623,
-34038,
-33517,
-33163,
-33006,
-33076,
-33335,
-33754,
-34265,
-34790,
-35214,
-35459,
-35457,
-35224,
-34775,
-34171,
-33458,
-32737,
-32096,
-31649,
-31436,
-31467,
-31690,
-32062,
-32516,
-32980,
-33357,
-33548,
-33497,
-33204,
-32733,
-32134,
-31490,
-30850,
-30309,
-29945,
-29830,
-29952,
-30259,
-30662,
-31087,
-31480,
-31770,
-31894,
-31790,
-31473,
-30996,
-30462,
-29959,
-29550,
-29289,
-29221,
-29377,
-29765,
-30301,
-30904,
-31449,
-31868,
-32122,
-32175,
-32021,
-31672,
-31179,
-30664,
-30214,
-29934,
-29860,
-29996,
-30358,
-30885,
-31554,
-32237,
-32861,
-33312,
-33569,
-33612,
-33465,
-33187,
-32812,
-32446,
-32156,
-32023,
-32093,
-32347,
-32771,
-33278,
-33832,
-34330,
-34742,
-34979,
-35050,
-34923,
-34677,
-34340,
-34032,
-33776,
-33654,
-33659,
-33820,
-34111,
-34492,
-34898,
-35246,
-35459,
-35524,
-35405,
-35153,
-34770,
-34317,
-33844,
-33437,
-33159,
-33048,
-33103,
-33279,
-33547,
-33857,
-34171,
-34408,
-34524,
-34458,
-34254,
-33922,
-33550,
-33145,
-32768,
-32447,
-32245,
-32198,
-32294,
-32487,
-32708,
-32918,
-33088,
-33205,
-33232,
-33132,
-32919,
-32626,
-32336,
-32099,
-31938,
-31853,
-31860,
-31963,
-32176,
-32451,
-32716,
-32911,
-32999,
-32989,
-32890,
-32702,
-32440,
-32124,
-31832,
-31629,
-31562,
-31635,
-31818,
-32092,
-32437,
-32827,
-33198,
-33488,
-33625,
-33613,
-33458,
-33218,
-32909,
-32570,
-32251,
-32003,
-31885,
-31925,
-32089,
-32351,
-32629,
-32909,
-33117,
-33239,
-33218,
-33030,
-32706,
-32273,
-31819,
-31398,
-31053,
-30828,
-30722,
-30758,
-30911,
-31133,
-31355,
-31493,
-31499,
-31347,
-31041,
-30608,
-30074,
-29497,
-28949,
-28513,
-28260,
-28206,
-28341,
-28607,
-28961,
-29329,
-29660,
-29861,
-29877,
-29680,
-29291,
-28788,
-28241,
-27735,
-27320,
-27061,
-27009,
-27186,
-27563,
-28074,
-28600,
-29073,
-29429,
-29630,
-29667,
-29521,
-29226,
-28867,
-28535,
-28352,
-28349,
-28550,
-28943,
-29496,
-30183,
-30922,
-31603,
-32142,
-32466,
-32602,
-32572,
-32440,
-32252,
-32089,
-32033,
-32174,
-32556,
-33157,
-33921,
-34758,
-35605,
-36372,
-37002,
-37408,
-37572,
-37510,
-37287,
-37011,
-36750,
-36592,
-36585,
-36760,
-37141,
-37687,
-38340,
-38991,
-39557,
-39953,
-40165,
-40170,
-39989,
-39666,
-39246,
-38842,
-38523,
-38366,
-38387,
-38560,
-38849,
-39202,
-39556,
-39844,
-39988,
-39932,
-39678,
-39250,
-38730,
-38165,
-37628,
-37169,
-36851,
-36704,
-36734,
-36890,
-37113,
-37314,
-37449,
-37456,
-37311,
-36993,
-36520,
-35923,
-35276,
-34651,
-34118,
-33719,
-33469,
-33364,
-33387,
-33515,
-33687,
-33848,
-33918,
-33870,
-33695,
-33425,
-33078,
-32685,
-32265,
-31892,
-31613,
-31480,
-31470,
-31562,
-31714,
-31906,
-32118,
-32301,
-32402,
-32394,
-32270,
-32077,
-31841,
-31599,
-31367,
-31182,
-31090,
-31107,
-31239,
-31463,
-31721,
-32012,
-32263,
-32468,
-32577,
-32585,
-32481,
-32286,
-32019,
-31741,
-31485,
-31303,
-31203,
-31206,
-31300,
-31497,
-31750,
-32034,
-32255,
-32402,
-32427,
-32359,
-32180,
-31905,
-31552,
-31174,
-30847,
-30595,
-30452,
-30394,
-30418,
-30504,
-30624,
-30715,
-30735,
-30632,
-30411,
-30080,
-29662,
-29193,
-28731,
-28322,
-28025,
-27840,
-27792,
-27846,
-27995,
-28158,
-28287,
-28313,
-28232,
-28031,
-27729,
-27327,
-26891,
-26470,
-26169,
-26014,
-26011,
-26144,
-26382,
-26719,
-27102,
-27441,
-27674,
-27759,
-27724,
-27609,
-27439,
-27252,
-27086,
-27028,
-27116,
-27370,
-27746,
-28188,
-28664,
-29115,
-29508,
-29770,
-29901,
-29910,
-29849,
-29775,
-29737,
-29784,
-29977,
-30322,
-30813,
-31389,
-32005,
-32608,
-33135,
-33539,
-33771,
-33847,
-33829,
-33757,
-33720,
-33715,
-33833,
-34096,
-34536,
-35097,
-35715,
-36300,
-36826,
-37247,
-37525,
-37629,
-37583,
-37430,
-37287,
-37172,
-37168,
-37252,
-37491,
-37843,
-38283,
-38716,
-39070,
-39311,
-39401,
-39333,
-39089,
-38722,
-38306,
-37937,
-37662,
-37497,
-37469,
-37579,
-37833,
-38144,
-38423,
-38581,
-38599,
-38481,
-38221,
-37809,
-37277,
-36714,
-36226,
-35873,
-35669,
-35574,
-35616,
-35757,
-35988,
-36190,
-36301,
-36256,
-36097,
-35823,
-35463,
-35040,
-34598,
-34235,
-33992,
-33893,
-33917,
-34050,
-34259,
-34510,
-34713,
-34838,
-34838,
-34732,
-34524,
-34215,
-33849,
-33494,
-33220,
-33068,
-33019,
-33076,
-33233,
-33501,
-33826,
-34119,
-34319,
-34399,
-34397,
-34301,
-34106,
-33788,
-33433,
-33101,
-32884,
-32750,
-32701,
-32731,
-32866,
-33111,
-33383,
-33608,
-33733,
-33768,
-33719,
-33569,
-33295,
-32929,
-32548,
-32220,
-31980,
-31818,
-31755,
-31815,
-31991,
-32228,
-32439,
-32567,
-32601,
-32522,
-32307,
-31933,
-31433,
-30905,
-30423,
-30043,
-29767,
-29633,
-29669,
-29882,
-30192,
-30496,
-30712,
-30801,
-30759,
-30527,
-30100,
-29497,
-28831,
-28210,
-27709,
-27359,
-27186,
-27234,
-27496,
-27893,
-28324,
-28673,
-28902,
-28970,
-28836,
-28499,
-27989,
-27429,
-26934,
-26573,
-26392,
-26411,
-26676,
-27165,
-27793,
-28415,
-28934,
-29303,
-29498,
-29506,
-29281,
-28912,
-28488,
-28188,
-28063,
-28144,
-28426,
-28935,
-29651,
-30499,
-31303,
-31962,
-32401,
-32645,
-32685,
-32521,
-32196,
-31828,
-31555,
-31478,
-31602,
-31921,
-32413,
-33069,
-33793,
-34477,
-34992,
-35302,
-35410,
-35340,
-35110,
-34767,
-34422,
-34177,
-34108,
-34211,
-34453,
-34831,
-35288,
-35770,
-36148,
-36352,
-36358,
-36214,
-35936,
-35565,
-35128,
-34737,
-34493,
-34421,
-34516,
-34692,
-34951,
-35250,
-35548,
-35719,
-35712,
-35509,
-35203,
-34820,
-34402,
-33952,
-33558,
-33302,
-33220,
-33276,
-33381,
-33510,
-33643,
-33763,
-33791,
-33675,
-33417,
-33101,
-32778,
-32488,
-32218,
-32013,
-31931,
-31990,
-32139,
-32307,
-32434,
-32529,
-32579,
-32544,
-32396,
-32154,
-31887,
-31673,
-31526,
-31446,
-31451,
-31575,
-31819,
-32140,
-32432,
-32688,
-32870,
-33020,
-33075,
-33040,
-32922,
-32804,
-32751,
-32767,
-32850,
-32989,
-33224,
-33548,
-33908,
-34232,
-34474,
-34661,
-34790,
-34870,
-34852,
-34782,
-34717,
-34725,
-34809,
-34942,
-35095,
-35315,
-35578,
-35859,
-36064,
-36167,
-36169,
-36124,
-36008,
-35831,
-35579,
-35346,
-35180,
-35103,
-35087,
-35098,
-35168,
-35285,
-35425,
-35509,
-35495,
-35390,
-35233,
-35018,
-34742,
-34404,
-34068,
-33800,
-33615,
-33497,
-33420,
-33394,
-33445,
-33518,
-33572,
-33541,
-33447,
-33301,
-33126,
-32891,
-32605,
-32324,
-32101,
-31970,
-31904,
-31877,
-31904,
-31986,
-32101,
-32182,
-32177,
-32088,
-31936,
-31740,
-31481,
-31180,
-30874,
-30659,
-30533,
-30524,
-30570,
-30708,
-30915,
-31189,
-31423,
-31588,
-31643,
-31628,
-31555,
-31393,
-31185,
-30950,
-30793,
-30742,
-30795,
-30928,
-31134,
-31424,
-31758,
-32073,
-32297,
-32400,
-32430,
-32379,
-32279,
-32115,
-31959,
-31874,
-31922,
-32085,
-32332,
-32645,
-33001,
-33374,
-33687,
-33870,
-33892,
-33800,
-33594,
-33341,
-33022,
-32734,
-32527,
-32475,
-32547,
-32727,
-32957,
-33241,
-33497,
-33695,
-33725,
-33602,
-33344,
-33001,
-32614,
-32212,
-31854,
-31624,
-31560,
-31647,
-31833,
-32062,
-32303,
-32510,
-32618,
-32556,
-32325,
-31958,
-31532,
-31099,
-30689,
-30367,
-30183,
-30181,
-30338,
-30577,
-30849,
-31081,
-31254,
-31294,
-31176,
-30890,
-30504,
-30094,
-29717,
-29427,
-29268,
-29283,
-29504,
-29861,
-30295,
-30714,
-31069,
-31325,
-31422,
-31334,
-31072,
-30718,
-30352,
-30049,
-29841,
-29767,
-29857,
-30135,
-30537,
-30991,
-31396,
-31718,
-31920,
-32005,
-31932,
-31741,
-31493,
-31288,
-31194,
-31242,
-31431,
-31783,
-32256,
-32824,
-33372,
-33831,
-34140,
-34284,
-34261,
-34082,
-33788,
-33459,
-33184,
-33027,
-33020,
-33166,
-33466,
-33881,
-34364,
-34813,
-35163,
-35374,
-35438,
-35369,
-35175,
-34908,
-34640,
-34462,
-34415,
-34519,
-34738,
-35067,
-35459,
-35861,
-36178,
-36341,
-36327,
-36140,
-35836,
-35421,
-34972,
-34548,
-34243,
-34107,
-34141,
-34314,
-34595,
-34925,
-35264,
-35511,
-35617,
-35553,
-35343,
-35029,
-34656,
-34273,
-33963,
-33778,
-33773,
-33925,
-34196,
-34531,
-34878,
-35170,
-35340,
-35327,
-35120,
-34760,
-34300,
-33811,
-33335,
-32960,
-32735,
-32711,
-32862,
-33142,
-33485,
-33832,
-34122,
-34297,
-34309,
-34150,
-33872,
-33517,
-33175,
-32876,
-32701,
-32677,
-32829,
-33115,
-33477,
-33847,
-34153,
-34350,
-34366,
-34191,
-33836,
-33364,
-32852,
-32371,
-31973,
-31722,
-31666,
-31797,
-32094,
-32462,
-32839,
-33165,
-33391,
-33480,
-33402,
-33179,
-32865,
-32542,
-32270,
-32081,
-32009,
-32062,
-32242,
-32496,
-32757,
-32940,
-33016,
-32944,
-32732,
-32375,
-31924,
-31427,
-30990,
-30638,
-30444,
-30390,
-30495,
-30723,
-31027,
-31331,
-31583,
-31729,
-31774,
-31696,
-31519,
-31277,
-31021,
-30817,
-30687,
-30652,
-30691,
-30809,
-30961,
-31117,
-31218,
-31225,
-31138,
-30960,
-30724,
-30446,
-30162,
-29928,
-29782,
-29750,
-29817,
-29966,
-30168,
-30415,
-30647,
-30850,
-30974,
-31034,
-31040,
-31013,
-30974,
-30930,
-30916,
-30946,
-31031,
-31141,
-31267,
-31377,
-31470,
-31539,
-31548,
-31519,
-31447,
-31371,
-31320,
-31283,
-31299,
-31349,
-31473,
-31648,
-31858,
-32082,
-32308,
-32531,
-32765,
-32972,
-33168,
-33345,
-33525,
-33710,
-33895,
-34057,
-34201,
-34319,
-34410,
-34475,
-34481,
-34463,
-34414,
-34373,
-34330,
-34311,
-34301,
-34336,
-34398,
-34489,
-34588,
-34686,
-34783,
-34876,
-34959,
-35027,
-35095,
-35171,
-35264,
-35373,
-35481,
-35592,
-35697,
-35779,
-35829,
-35811,
-35738,
-35613,
-35451,
-35260,
-35049,
-34842,
-34665,
-34546,
-34463,
-34429,
-34407,
-34422,
-34449,
-34470,
-34471,
-34437,
-34378,
-34316,
-34254,
-34180,
-34126,
-34074,
-34057,
-34055,
-34054,
-34038,
-34009,
-33947,
-33863,
-33732,
-33566,
-33379,
-33175,
-32987,
-32790,
-32626,
-32484,
-32390,
-32316,
-32284,
-32258,
-32271,
-32299,
-32337,
-32379,
-32408,
-32451,
-32484,
-32521,
-32532,
-32526,
-32517,
-32501,
-32493,
-32469,
-32444,
-32425,
-32419,
-32421,
-32416,
-32390,
-32349,
-32287,
-32207,
-32089,
-31956,
-31811,
-31690,
-31602,
-31560,
-31567,
-31648,
-31780,
-31971,
-32158,
-32347,
-32482,
-32581,
-32594,
-32537,
-32404,
-32225,
-32043,
-31867,
-31731,
-31631,
-31591,
-31594,
-31635,
-31654,
-31641,
-31560,
-31417,
-31210,
-30946,
-30652,
-30375,
-30158,
-30032,
-30009,
-30091,
-30257,
-30490,
-30722,
-30925,
-31028,
-31037,
-30929,
-30718,
-30434,
-30114,
-29832,
-29630,
-29526,
-29543,
-29642,
-29830,
-30057,
-30260,
-30400,
-30418,
-30342,
-30180,
-29970,
-29747,
-29565,
-29474,
-29536,
-29744,
-30076,
-30488,
-30921,
-31336,
-31662,
-31861,
-31895,
-31797,
-31602,
-31380,
-31182,
-31064,
-31075,
-31240,
-31555,
-31965,
-32420,
-32841,
-33192,
-33408,
-33471,
-33389,
-33203,
-32993,
-32815,
-32740,
-32800,
-33040,
-33451,
-33986,
-34579,
-35134,
-35594,
-35916,
-36053,
-36019,
-35821,
-35544,
-35275,
-35077,
-35012,
-35091,
-35327,
-35704,
-36139,
-36570,
-36892,
-37069,
-37076,
-36902,
-36585,
-36165,
-35744,
-35404,
-35215,
-35194,
-35346,
-35642,
-36043,
-36470,
-36816,
-37009,
-37008,
-36830,
-36490,
-36030,
-35504,
-35007,
-34625,
-34420,
-34387,
-34487,
-34692,
-34948,
-35198,
-35350,
-35359,
-35182,
-34878,
-34482,
-34051,
-33643,
-33318,
-33133,
-33129,
-33271,
-33527,
-33826,
-34123,
-34347,
-34456,
-34403,
-34213,
-33904,
-33553,
-33177,
-32856,
-32625,
-32536,
-32584,
-32733,
-32936,
-33153,
-33359,
-33505,
-33556,
-33475,
-33310,
-33092,
-32888,
-32689,
-32530,
-32423,
-32414,
-32502,
-32635,
-32776,
-32880,
-32969,
-33025,
-33043,
-32986,
-32878,
-32752,
-32646,
-32561,
-32484,
-32402,
-32347,
-32310,
-32293,
-32248,
-32191,
-32120,
-32079,
-32037,
-32004,
-31949,
-31918,
-31889,
-31859,
-31785,
-31662,
-31512,
-31355,
-31194,
-31029,
-30873,
-30776,
-30762,
-30810,
-30895,
-30971,
-31036,
-31074,
-31038,
-30885,
-30612,
-30248,
-29861,
-29482,
-29141,
-28875,
-28733,
-28754,
-28910,
-29150,
-29410,
-29648,
-29835,
-29904,
-29838,
-29607,
-29301,
-28961,
-28668,
-28441,
-28340,
-28405,
-28656,
-29053,
-29493,
-29918,
-30265,
-30512,
-30603,
-30514,
-30251,
-29918,
-29609,
-29400,
-29330,
-29411,
-29699,
-30191,
-30831,
-31505,
-32100,
-32559,
-32867,
-33000,
-32937,
-32706,
-32388,
-32107,
-31954,
-31952,
-32121,
-32452,
-32944,
-33539,
-34117,
-34598,
-34899,
-35035,
-34994,
-34794,
-34475,
-34129,
-33851,
-33727,
-33757,
-33949,
-34275,
-34717,
-35198,
-35616,
-35887,
-35980,
-35922,
-35709,
-35390,
-34978,
-34596,
-34313,
-34202,
-34226,
-34364,
-34583,
-34866,
-35144,
-35330,
-35338,
-35180,
-34891,
-34528,
-34108,
-33663,
-33277,
-33017,
-32943,
-33008,
-33149,
-33338,
-33534,
-33720,
-33814,
-33756,
-33556,
-33266,
-32954,
-32645,
-32361,
-32131,
-32030,
-32061,
-32202,
-32366,
-32513,
-32624,
-32693,
-32666,
-32528,
-32281,
-32008,
-31770,
-31592,
-31497,
-31482,
-31606,
-31852,
-32177,
-32498,
-32771,
-32981,
-33136,
-33186,
-33136,
-32990,
-32839,
-32733,
-32704,
-32737,
-32847,
-33054,
-33358,
-33707,
-34025,
-34267,
-34455,
-34575,
-34642,
-34614,
-34531,
-34463,
-34461,
-34549,
-34685,
-34868,
-35107,
-35401,
-35700,
-35932,
-36043,
-36057,
-36007,
-35878,
-35685,
-35422,
-35172,
-34998,
-34916,
-34897,
-34921,
-34992,
-35125,
-35266,
-35359,
-35343,
-35248,
-35082,
-34879,
-34599,
-34278,
-33959,
-33710,
-33547,
-33452,
-33395,
-33389,
-33448,
-33527,
-33580,
-33546,
-33443,
-33294,
-33113,
-32874,
-32594,
-32310,
-32099,
-31965,
-31910,
-31877,
-31912,
-31986,
-32105,
-32183,
-32176,
-32088,
-31935,
-31741,
-31481,
-31180,
-30876,
-30655,
-30538,
-30519,
-30575,
-30704,
-30920,
-31183,
-31430,
-31580,
-31649,
-31629,
-31549,
-31402,
-31178,
-30953,
-30793,
-30739,
-30799,
-30925,
-31137,
-31420,
-31761,
-32072,
-32297,
-32401,
-32427,
-32383,
-32276,
-32118,
-31956,
-31877,
-31918,
-32088,
-32332,
-32643,
-33004,
-33371,
-33690,
-33866,
-33899,
-33792,
-33600,
-33336,
-33026,
-32733,
-32528,
-32474,
-32548,
-32725,
-32962,
-33233,
-33507,
-33686,
-33732,
-33599,
-33345,
-33001,
-32614,
-32211,
-31856,
-31623,
-31559,
-31648,
-31832,
-32065,
-32301,
-32511,
-32618,
-32556,
-32326,
-31956,
-31535,
-31096,
-30692,
-30364,
-30185,
-30179,
-30339,
-30578,
-30846,
-31084,
-31251,
-31296,
-31173,
-30891,
-30505,
-30090,
-29721,
-29423,
-29270,
-29285,
-29500,
-29864,
-30291,
-30718,
-31066,
-31327,
-31421,
-31333,
-31077,
-30711,
-30358,
-30044,
-29846,
-29762,
-29860,
-30131,
-30541,
-30986,
-31400,
-31714,
-31925,
-32002,
-31932,
-31741,
-31494,
-31290,
-31192,
-31242,
-31431,
-31782,
-32259,
-32821,
-33376,
-33827,
-34143,
-34283,
-34261,
-34083,
-33786,
-33463,
-33178,
-33034,
-33012,
-33174,
-33456,
-33889,
-34359,
-34816,
-35162,
-35374,
-35437,
-35371,
-35172,
-34909,
-34640,
-34461,
-34418,
-34515,
-34740,
-35066,
-35460,
-35859,
-36179,
-36341,
-36325,
-36144,
-35833,
-35423,
-34970,
-34549,
-34243,
-34109,
-34138,
-34317,
-34591,
-34930,
-35258,
-35516,
-35615,
-35553,
-35343,
-35028,
-34655,
-34277,
-33958,
-33782,
-33770,
-33927,
-34196,
-34531,
-34878,
-35169,
-35343,
-35323,
-35123,
-34757,
-34304,
-33807,
-33339,
-32956,
-32738,
-32709,
-32865,
-33139,
-33487,
-33830,
-34125,
-34294,
-34310,
-34150,
-33870,
-33521,
-33171,
-32879,
-32698,
-32680,
-32827,
-33115,
-33478,
-33845,
-34155,
-34350,
-34366,
-34192,
-33835,
-33363,
-32855,
-32367,
-31974,
-31724,
-31661,
-31802,
-32090,
-32463,
-32839,
-33163,
-33393,
-33479,
-33405,
-33174,
-32869,
-32540,
-32271,
-32082,
-32007,
-32065,
-32240,
-32498,
-32754,
-32943,
-33013,
-32947,
-32729,
-32378,
-31920,
-31432,
-30983,
-30645,
-30440,
-30393,
-30492,
-30726,
-31023,
-31336,
-31578,
-31733,
-31771,
-31698,
-31519,
-31275,
-31023,
-30816,
-30693,
-30661,
-30705,
-30832,
-30988,
-31153,
-31254,
-31262,
-31169,
-30986,
-30742,
-30458,
-30175,
-29946,
-29809,
-29798,
-29883,
-30055,
-30284,
-30539,
-30789,
-30984,
-31101,
-31144,
-31132,
-31095,
-31039,
-30999,
-30991,
-31045,
-31158,
-31299,
-31450,
-31571,
-31667,
-31716,
-31693,
-31616,
-31486,
-31354,
-31253,
-31190,
-31188,
-31248,
-31388,
-31595,
-31836,
-32087,
-32319,
-32533,
-32723,
-32876,
-33005,
-33104,
-33221,
-33347,
-33503,
-33655,
-33816,
-33967,
-34098,
-34193,
-34220,
-34191,
-34112,
-34007,
-33883,
-33759,
-33657,
-33598,
-33608,
-33664,
-33766,
-33890,
-34042,
-34201,
-34349,
-34476,
-34562,
-34646,
-34717,
-34787,
-34846,
-34907,
-34965,
-35035,
-35083,
-35109,
-35083,
-35032,
-34932,
-34808,
-34632,
-34447,
-34258,
-34100,
-33970,
-33868,
-33798,
-33778,
-33800,
-33854,
-33914,
-33972,
-34030,
-34100,
-34157,
-34201,
-34217,
-34220,
-34226,
-34215,
-34188,
-34126,
-34048,
-33959,
-33857,
-33744,
-33603,
-33457,
-33312,
-33177,
-33039,
-32906,
-32766,
-32647,
-32536,
-32444,
-32364,
-32314,
-32299,
-32317,
-32374,
-32454,
-32563,
-32688,
-32809,
-32904,
-32958,
-32979,
-32957,
-32906,
-32806,
-32687,
-32565,
-32471,
-32406,
-32359,
-32322,
-32301,
-32289,
-32272,
-32219,
-32128,
-31998,
-31876,
-31748,
-31661,
-31595,
-31605,
-31685,
-31854,
-32069,
-32307,
-32538,
-32738,
-32881,
-32948,
-32915,
-32812,
-32655,
-32478,
-32307,
-32164,
-32066,
-32029,
-32042,
-32072,
-32099,
-32086,
-32037,
-31930,
-31768,
-31563,
-31352,
-31187,
-31090,
-31096,
-31191,
-31385,
-31649,
-31958,
-32242,
-32467,
-32584,
-32593,
-32496,
-32302,
-32055,
-31794,
-31582,
-31441,
-31406,
-31444,
-31564,
-31709,
-31860,
-31946,
-31951,
-31852,
-31679,
-31452,
-31227,
-31035,
-30947,
-30995,
-31190,
-31508,
-31906,
-32331,
-32721,
-33031,
-33186,
-33178,
-33014,
-32740,
-32433,
-32136,
-31914,
-31811,
-31857,
-32059,
-32360,
-32705,
-33007,
-33229,
-33317,
-33257,
-33060,
-32756,
-32434,
-32161,
-32018,
-32039,
-32250,
-32636,
-33148,
-33712,
-34238,
-34647,
-34875,
-34909,
-34740,
-34424,
-34034,
-33655,
-33378,
-33251,
-33308,
-33542,
-33910,
-34345,
-34752,
-35036,
-35149,
-35061,
-34792,
-34387,
-33912,
-33461,
-33142,
-33007,
-33108,
-33403,
-33859,
-34388,
-34905,
-35307,
-35520,
-35493,
-35247,
-34819,
-34300,
-33767,
-33322,
-33039,
-32966,
-33094,
-33388,
-33747,
-34118,
-34375,
-34480,
-34364,
-34049,
-33581,
-33041,
-32531,
-32125,
-31913,
-31925,
-32165,
-32580,
-33087,
-33575,
-33963,
-34167,
-34149,
-33905,
-33472,
-32932,
-32391,
-31939,
-31652,
-31574,
-31693,
-31991,
-32374,
-32766,
-33049,
-33180,
-33099,
-32824,
-32394,
-31879,
-31389,
-31007,
-30814,
-30830,
-31072,
-31469,
-31984,
-32472,
-32881,
-33093,
-33108,
-32909,
-32549,
-32095,
-31635,
-31267,
-31065,
-31070,
-31267,
-31617,
-32035,
-32454,
-32769,
-32919,
-32864,
-32607,
-32209,
-31740,
-31296,
-30960,
-30796,
-30854,
-31113,
-31541,
-32043,
-32544,
-32938,
-33177,
-33203,
-33041,
-32718,
-32315,
-31918,
-31605,
-31442,
-31461,
-31655,
-31977,
-32361,
-32700,
-32938,
-33010,
-32894,
-32599,
-32170,
-31688,
-31252,
-30941,
-30817,
-30900,
-31183,
-31618,
-32131,
-32634,
-33040,
-33277,
-33327,
-33193,
-32919,
-32581,
-32239,
-31997,
-31886,
-31948,
-32170,
-32492,
-32868,
-33193,
-33414,
-33469,
-33345,
-33069,
-32675,
-32251,
-31871,
-31618,
-31556,
-31690,
-32017,
-32462,
-32975,
-33455,
-33842,
-34060,
-34084,
-33926,
-33633,
-33280,
-32943,
-32682,
-32562,
-32591,
-32782,
-33077,
-33406,
-33705,
-33892,
-33937,
-33822,
-33561,
-33205,
-32822,
-32500,
-32301,
-32285,
-32455,
-32809,
-33278,
-33806,
-34295,
-34675,
-34895,
-34911,
-34760,
-34444,
-34066,
-33672,
-33360,
-33157,
-33105,
-33179,
-33359,
-33579,
-33770,
-33866,
-33824,
-33628,
-33301,
-32887,
-32445,
-32062,
-31795,
-31715,
-31824,
-32121,
-32546,
-33041,
-33521,
-33914,
-34154,
-34208,
-34082,
-33811,
-33449,
-33072,
-32745,
-32529,
-32454,
-32523,
-32699,
-32935,
-33162,
-33325,
-33373,
-33275,
-33048,
-32714,
-32351,
-32019,
-31789,
-31698,
-31795,
-32049,
-32450,
-32913,
-33365,
-33729,
-33945,
-33981,
-33827,
-33510,
-33078,
-32617,
-32192,
-31875,
-31698,
-31675,
-31789,
-32002,
-32246,
-32464,
-32599,
-32619,
-32530,
-32350,
-32128,
-31933,
-31816,
-31846,
-32030,
-32380,
-32848,
-33381,
-33900,
-34327,
-34588,
-34655,
-34512,
-34189,
-33739,
-33228,
-32740,
-32346,
-32093,
-31998,
-32037,
-32177,
-32352,
-32506,
-32587,
-32538,
-32378,
-32116,
-31821,
-31548,
-31363,
-31318,
-31449,
-31754,
-32193,
-32700,
-33191,
-33592,
-33836,
-33881,
-33721,
-33379,
-32922,
-32447,
-32012,
-31715,
-31574,
-31620,
-31832,
-32144,
-32500,
-32794,
-32994,
-33034,
-32938,
-32709,
-32417,
-32129,
-31932,
-31873,
-31997,
-32274,
-32686,
-33146,
-33577,
-33885,
-34000,
-33889,
-33555,
-33046,
-32429,
-31808,
-31271,
-30908,
-30762,
-30835,
-31103,
-31497,
-31933,
-32334,
-32615,
-32739,
-32711,
-32564,
-32367,
-32190,
-32118,
-32201,
-32477,
-32925,
-33490,
-34086,
-34614,
-34995,
-35151,
-35056,
-34712,
-34184,
-33550,
-32927,
-32393,
-32036,
-31889,
-31961,
-32200,
-32538,
-32874,
-33132,
-33252,
-33203,
-32996,
-32675,
-32316,
-32018,
-31849,
-31862,
-32074,
-32440,
-32933,
-33438,
-33870,
-34141,
-34184,
-34012,
-33633,
-33135,
-32585,
-32098,
-31756,
-31632,
-31727,
-32028,
-32457,
-32934,
-33372,
-33681,
-33814,
-33755,
-33530,
-33211,
-32871,
-32604,
-32466,
-32508,
-32710,
-33050,
-33425,
-33776,
-33982,
-34003,
-33786,
-33352,
-32752,
-32078,
-31433,
-30907,
-30578,
-30489,
-30641,
-30987,
-31441,
-31905,
-32289,
-32539,
-32613,
-32530,
-32313,
-32056,
-31842,
-31766,
-31861,
-32157,
-32599,
-33153,
-33709,
-34195,
-34493,
-34568,
-34381,
-34001,
-33462,
-32894,
-32359,
-31977,
-31784,
-31825,
-32048,
-32405,
-32799,
-33130,
-33341,
-33361,
-33193,
-32872,
-32456,
-32049,
-31722,
-31562,
-31596,
-31840,
-32233,
-32702,
-33162,
-33516,
-33703,
-33686,
-33462,
-33085,
-32637,
-32215,
-31905,
-31779,
-31855,
-32139,
-32577,
-33103,
-33607,
-34021,
-34262,
-34328,
-34209,
-33973,
-33668,
-33392,
-33210,
-33176,
-33291,
-33545,
-33871,
-34196,
-34451,
-34540,
-34452,
-34167,
-33728,
-33202,
-32651,
-32182,
-31841,
-31703,
-31738,
-31941,
-32224,
-32538,
-32806,
-32973,
-33010,
-32907,
-32716,
-32493,
-32317,
-32241,
-32313,
-32522,
-32890,
-33328,
-33810,
-34216,
-34503,
-34621,
-34563,
-34359,
-34051,
-33706,
-33396,
-33183,
-33097,
-33153,
-33312,
-33529,
-33724,
-33846,
-33833,
-33680,
-33379,
-32978,
-32530,
-32118,
-31798,
-31643,
-31645,
-31807,
-32068,
-32379,
-32669,
-32875,
-32937,
-32851,
-32619,
-32315,
-31995,
-31727,
-31566,
-31548,
-31688,
-31967,
-32333,
-32707,
-33022,
-33222,
-33284,
-33200,
-33006,
-32739,
-32477,
-32289,
-32215,
-32298,
-32503,
-32808,
-33154,
-33459,
-33674,
-33734,
-33630,
-33366,
-32981,
-32539,
-32106,
-31747,
-31508,
-31397,
-31410,
-31500,
-31631,
-31736,
-31770,
-31699,
-31525,
-31276,
-31005,
-30767,
-30612,
-30586,
-30712,
-30982,
-31367,
-31804,
-32238,
-32600,
-32865,
-32998,
-33021,
-32951,
-32841,
-32734,
-32688,
-32716,
-32831,
-33002,
-33202,
-33369,
-33466,
-33445,
-33305,
-33043,
-32699,
-32312,
-31942,
-31653,
-31471,
-31421,
-31477,
-31624,
-31809,
-31998,
-32130,
-32190,
-32149,
-32045,
-31906,
-31769,
-31694,
-31682,
-31783,
-31974,
-32249,
-32551,
-32839,
-33061,
-33189,
-33223,
-33146,
-33007,
-32820,
-32660,
-32550,
-32542,
-32629,
-32817,
-33078,
-33369,
-33659,
-33900,
-34065,
-34141,
-34127,
-34041,
-33919,
-33780,
-33669,
-33586,
-33548,
-33548,
-33556,
-33576,
-33549,
-33476,
-33335,
-33130,
-32892,
-32630,
-32386,
-32182,
-32057,
-32024,
-32105,
-32266,
-32515,
-32797,
-33111,
-33415,
-33692,
-33921,
-34108,
-34246,
-34364,
-34466,
-34564,
-34665,
-34769,
-34876,
-34955,
-35008,
-34995,
-34919,
-34769,
-34553,
-34276,
-33977,
-33675,
-33404,
-33186,
-33029,
-32942,
-32920,
-32935,
-32972,
-32993,
-32986,
-32948,
-32878,
-32790,
-32708,
-32650,
-32653,
-32729,
-32873,
-33071,
-33290,
-33498,
-33656,
-33733,
-33702,
-33574,
-33355,
-33097,
-32834,
-32620,
-32489,
-32461,
-32540,
-32697,
-32902,
-33092,
-33229,
-33275,
-33207,
-33040,
-32800,
-32536,
-32308,
-32151,
-32107,
-32176,
-32343,
-32571,
-32781,
-32924,
-32928,
-32784,
-32473,
-32036,
-31512,
-30983,
-30526,
-30205,
-30062,
-30098,
-30290,
-30598,
-30949,
-31288,
-31549,
-31702,
-31751,
-31720,
-31660,
-31627,
-31657,
-31803,
-32060,
-32416,
-32819,
-33204,
-33498,
-33659,
-33640,
-33448,
-33094,
-32639,
-32148,
-31684,
-31316,
-31059,
-30947,
-30938,
-31018,
-31123,
-31207,
-31252,
-31225,
-31153,
-31053,
-30964,
-30933,
-30995,
-31157,
-31424,
-31749,
-32117,
-32453,
-32742,
-32916,
-32994,
-32963,
-32872,
-32752,
-32642,
-32585,
-32594,
-32684,
-32833,
-33006,
-33167,
-33274,
-33322,
-33290,
-33193,
-33051,
-32909,
-32798,
-32769,
-32808,
-32942,
-33116,
-33336,
-33531,
-33683,
-33742,
-33708,
-33578,
-33389,
-33162,
-32939,
-32751,
-32629,
-32582,
-32609,
-32676,
-32777,
-32860,
-32930,
-32954,
-32949,
-32917,
-32893,
-32903,
-32970,
-33112,
-33327,
-33611,
-33946,
-34287,
-34619,
-34890,
-35103,
-35233,
-35285,
-35267,
-35195,
-35083,
-34958,
-34815,
-34658,
-34488,
-34288,
-34077,
-33825,
-33560,
-33277,
-33007,
-32772,
-32594,
-32479,
-32444,
-32476,
-32578,
-32710,
-32861,
-32994,
-33108,
-33185,
-33234,
-33260,
-33277,
-33323,
-33386,
-33496,
-33625,
-33769,
-33897,
-33999,
-34027,
-33987,
-33849,
-33655,
-33413,
-33169,
-32955,
-32794,
-32726,
-32746,
-32853,
-33009,
-33170,
-33300,
-33357,
-33329,
-33187,
-32961,
-32662,
-32357,
-32075,
-31870,
-31751,
-31739,
-31812,
-31940,
-32084,
-32182,
-32210,
-32131,
-31955,
-31697,
-31397,
-31109,
-30884,
-30769,
-30779,
-30923,
-31172,
-31487,
-31819,
-32094,
-32291,
-32371,
-32351,
-32248,
-32103,
-31962,
-31889,
-31900,
-32028,
-32238,
-32502,
-32767,
-32980,
-33092,
-33067,
-32899,
-32601,
-32238,
-31848,
-31506,
-31248,
-31108,
-31104,
-31202,
-31373,
-31554,
-31690,
-31766,
-31744,
-31653,
-31507,
-31364,
-31276,
-31295,
-31440,
-31709,
-32082,
-32498,
-32910,
-33242,
-33447,
-33494,
-33395,
-33167,
-32888,
-32590,
-32366,
-32241,
-32256,
-32391,
-32612,
-32871,
-33096,
-33251,
-33283,
-33188,
-32990,
-32725,
-32472,
-32275,
-32198,
-32259,
-32469,
-32792,
-33174,
-33547,
-33839,
-34006,
-34018,
-33877,
-33608,
-33276,
-32936,
-32669,
-32509,
-32490,
-32595,
-32806,
-33069,
-33325,
-33517,
-33600,
-33570,
-33430,
-33228,
-32994,
-32799,
-32687,
-32693,
-32836,
-33075,
-33397,
-33727,
-34030,
-34248,
-34350,
-34323,
-34187,
-33969,
-33727,
-33491,
-33314,
-33216,
-33205,
-33272,
-33376,
-33493,
-33570,
-33598,
-33547,
-33431,
-33267,
-33086,
-32940,
-32850,
-32856,
-32949,
-33132,
-33378,
-33637,
-33889,
-34069,
-34167,
-34169,
-34088,
-33932,
-33754,
-33571,
-33421,
-33326,
-33279,
-33273,
-33278,
-33268,
-33209,
-33083,
-32889,
-32631,
-32357,
-32091,
-31890,
-31777,
-31791,
-31924,
-32166,
-32475,
-32788,
-33080,
-33283,
-33388,
-33381,
-33269,
-33105,
-32917,
-32774,
-32691,
-32689,
-32764,
-32884,
-33014,
-33103,
-33099,
-32983,
-32748,
-32414,
-32037,
-31659,
-31355,
-31165,
-31119,
-31233,
-31455,
-31759,
-32057,
-32308,
-32450,
-32452,
-32335,
-32102,
-31834,
-31562,
-31369,
-31267,
-31297,
-31426,
-31630,
-31847,
-32020,
-32115,
-32098,
-31980,
-31781,
-31560,
-31368,
-31272,
-31303,
-31470,
-31762,
-32130,
-32522,
-32878,
-33130,
-33258,
-33244,
-33124,
-32934,
-32723,
-32558,
-32450,
-32451,
-32514,
-32637,
-32745,
-32809,
-32778,
-32639,
-32399,
-32087,
-31761,
-31470,
-31278,
-31213,
-31285,
-31484,
-31766,
-32079,
-32364,
-32581,
-32700,
-32732,
-32701,
-32643,
-32619,
-32659,
-32811,
-33053,
-33383,
-33738,
-34075,
-34335,
-34477,
-34487,
-34359,
-34141,
-33866,
-33607,
-33391,
-33273,
-33238,
-33293,
-33393,
-33492,
-33556,
-33542,
-33447,
-33279,
-33062,
-32844,
-32667,
-32570,
-32566,
-32663,
-32828,
-33026,
-33219,
-33360,
-33417,
-33401,
-33289,
-33156,
-32999,
-32889,
-32841,
-32873,
-32991,
-33162,
-33371,
-33565,
-33728,
-33832,
-33883,
-33890,
-33877,
-33875,
-33905,
-33987,
-34111,
-34264,
-34411,
-34525,
-34558,
-34505,
-34343,
-34088,
-33779,
-33426,
-33102,
-32806,
-32589,
-32434,
-32350,
-32304,
-32275,
-32244,
-32185,
-32115,
-32021,
-31954,
-31899,
-31927,
-32003,
-32169,
-32382,
-32632,
-32880,
-33104,
-33265,
-33363,
-33389,
-33362,
-33303,
-33240,
-33191,
-33172,
-33183,
-33217,
-33253,
-33269,
-33248,
-33168,
-33045,
-32866,
-32676,
-32470,
-32297,
-32154,
-32054,
-31996,
-31955,
-31925,
-31876,
-31803,
-31695,
-31562,
-31422,
-31296,
-31201,
-31169,
-31187,
-31277,
-31402,
-31558,
-31702,
-31833,
-31911,
-31955,
-31954,
-31934,
-31912,
-31911,
-31941,
-32021,
-32128,
-32269,
-32404,
-32535,
-32621,
-32678,
-32679,
-32659,
-32614,
-32572,
-32543,
-32537,
-32549,
-32581,
-32604,
-32603,
-32572,
-32482,
-32350,
-32177,
-31975,
-31774,
-31595,
-31456,
-31369,
-31342,
-31364,
-31435,
-31528,
-31647,
-31768,
-31904,
-32046,
-32204,
-32383,
-32588,
-32815,
-33058,
-33299,
-33522,
-33707,
-33839,
-33910,
-33913,
-33864,
-33771,
-33654,
-33537,
-33426,
-33338,
-33274,
-33222,
-33191,
-33150,
-33110,
-33056,
-32991,
-32932,
-32879,
-32849,
-32850,
-32879,
-32945,
-33025,
-33122,
-33201,
-33269,
-33297,
-33302,
-33282,
-33243,
-33213,
-33194,
-33203,
-33252,
-33325,
-33432,
-33540,
-33654,
-33744,
-33813,
-33846,
-33856,
-33845,
-33827,
-33808,
-33804,
-33810,
-33836,
-33863,
-33890,
-33899,
-33887,
-33843,
-33773,
-33673,
-33563,
-33444,
-33341,
-33255,
-33191,
-33157,
-33132,
-33132,
-33112,
-33101,
-33050,
-32992,
-32906,
-32813,
-32722,
-32639,
-32595,
-32577,
-32619,
-32689,
-32810,
-32946,
-33100,
-33244,
-33372,
-33464,
-33524,
-33546,
-33538,
-33505,
-33461,
-33404,
-33353,
-33297,
-33239,
-33162,
-33068,
-32941,
-32778,
-32589,
-32362,
-32143,
-31925,
-31747,
-31619,
-31565,
-31571,
-31660,
-31781,
-31947,
-32100,
-32239,
-32329,
-32375,
-32362,
-32319,
-32248,
-32182,
-32133,
-32115,
-32129,
-32165,
-32208,
-32242,
-32242,
-32197,
-32113,
-31983,
-31846,
-31715,
-31622,
-31591,
-31628,
-31740,
-31895,
-32081,
-32246,
-32375,
-32428,
-32407,
-32306,
-32154,
-31977,
-31818,
-31698,
-31648,
-31660,
-31736,
-31845,
-31956,
-32035,
-32061,
-32021,
-31931,
-31807,
-31683,
-31598,
-31578,
-31647,
-31795,
-32010,
-32251,
-32476,
-32653,
-32746,
-32748,
-32670,
-32534,
-32391,
-32274,
-32230,
-32267,
-32394,
-32588,
-32807,
-33012,
-33152,
-33206,
-33154,
-33018,
-32820,
-32615,
-32440,
-32346,
-32346,
-32442,
-32614,
-32818,
-33012,
-33154,
-33215,
-33184,
-33090,
-32952,
-32838,
-32773,
-32805,
-32942,
-33175,
-33467,
-33764,
-34016,
-34161,
-34190,
-34072,
-33858,
-33564,
-33270,
-33020,
-32863,
-32820,
-32887,
-33031,
-33212,
-33377,
-33479,
-33501,
-33432,
-33306,
-33156,
-33044,
-33007,
-33081,
-33275,
-33551,
-33893,
-34209,
-34473,
-34609,
-34613,
-34475,
-34236,
-33938,
-33653,
-33420,
-33295,
-33277,
-33356,
-33509,
-33662,
-33794,
-33834,
-33790,
-33653,
-33458,
-33254,
-33075,
-32981,
-32980,
-33082,
-33256,
-33464,
-33648,
-33767,
-33790,
-33697,
-33524,
-33279,
-33038,
-32832,
-32713,
-32692,
-32779,
-32924,
-33115,
-33273,
-33386,
-33402,
-33334,
-33186,
-32999,
-32814,
-32674,
-32607,
-32629,
-32720,
-32864,
-33012,
-33129,
-33184,
-33149,
-33042,
-32872,
-32683,
-32512,
-32388,
-32338,
-32358,
-32431,
-32533,
-32613,
-32646,
-32592,
-32461,
-32237,
-31981,
-31691,
-31440,
-31237,
-31116,
-31078,
-31111,
-31195,
-31300,
-31403,
-31489,
-31552,
-31600,
-31651,
-31720,
-31824,
-31968,
-32151,
-32345,
-32541,
-32686,
-32780,
-32786,
-32716,
-32567,
-32378,
-32156,
-31945,
-31757,
-31605,
-31497,
-31406,
-31337,
-31262,
-31182,
-31094,
-31014,
-30951,
-30940,
-30987,
-31115,
-31302,
-31553,
-31816,
-32079,
-32288,
-32438,
-32500,
-32490,
-32425,
-32330,
-32248,
-32192,
-32188,
-32239,
-32320,
-32430,
-32506,
-32560,
-32545,
-32480,
-32366,
-32239,
-32124,
-32059,
-32066,
-32149,
-32309,
-32517,
-32746,
-32965,
-33138,
-33256,
-33307,
-33315,
-33296,
-33272,
-33279,
-33311,
-33392,
-33492,
-33595,
-33675,
-33706,
-33673,
-33573,
-33421,
-33238,
-33053,
-32899,
-32791,
-32749,
-32770,
-32835,
-32938,
-33050,
-33158,
-33266,
-33368,
-33484,
-33626,
-33811,
-34036,
-34308,
-34594,
-34870,
-35099,
-35250,
-35294,
-35230,
-35057,
-34804,
-34499,
-34185,
-33889,
-33636,
-33441,
-33289,
-33180,
-33086,
-33005,
-32914,
-32845,
-32778,
-32777,
-32822,
-32975,
-33197,
-33517,
-33874,
-34257,
-34603,
-34887,
-35062,
-35135,
-35089,
-34953,
-34755,
-34515,
-34279,
-34038,
-33828,
-33612,
-33404,
-33178,
-32932,
-32670,
-32404,
-32163,
-31973,
-31862,
-31850,
-31937,
-32117,
-32362,
-32633,
-32895,
-33115,
-33268,
-33350,
-33365,
-33336,
-33284,
-33238,
-33202,
-33189,
-33180,
-33163,
-33104,
-32988,
-32798,
-32529,
-32211,
-31854,
-31504,
-31204,
-30964,
-30831,
-30784,
-30834,
-30949,
-31099,
-31275,
-31427,
-31568,
-31680,
-31771,
-31859,
-31942,
-32035,
-32143,
-32252,
-32354,
-32432,
-32461,
-32442,
-32348,
-32196,
-31973,
-31707,
-31402,
-31087,
-30770,
-30484,
-30230,
-30039,
-29911,
-29867,
-29911,
-30040,
-30265,
-30550,
-30910,
-31291,
-31690,
-32069,
-32405,
-32692,
-32904,
-33057,
-33139,
-33170,
-33153,
-33096,
-32999,
-32866,
-32687,
-32469,
-32197,
-31900,
-31569,
-31249,
-30958,
-30726,
-30586,
-30552,
-30632,
-30831,
-31119,
-31488,
-31887,
-32311,
-32709,
-33082,
-33402,
-33672,
-33890,
-34052,
-34170,
-34231,
-34251,
-34209,
-34128,
-33987,
-33815,
-33612,
-33395,
-33189,
-32998,
-32850,
-32741,
-32687,
-32674,
-32711,
-32779,
-32888,
-33015,
-33191,
-33373,
-33601,
-33838,
-34099,
-34356,
-34607,
-34820,
-34986,
-35097,
-35133,
-35116,
-35034,
-34911,
-34756,
-34582,
-34403,
-34216,
-34032,
-33845,
-33654,
-33469,
-33287,
-33132,
-33011,
-32936,
-32931,
-32986,
-33109,
-33285,
-33495,
-33727,
-33949,
-34162,
-34342,
-34500,
-34636,
-34753,
-34857,
-34945,
-35002,
-35023,
-34972,
-34848,
-34619,
-34309,
-33912,
-33474,
-33020,
-32609,
-32266,
-32036,
-31922,
-31926,
-32020,
-32186,
-32365,
-32554,
-32709,
-32829,
-32926,
-33003,
-33090,
-33198,
-33331,
-33484,
-33639,
-33756,
-33818,
-33779,
-33635,
-33382,
-33034,
-32626,
-32199,
-31789,
-31449,
-31178,
-31015,
-30930,
-30924,
-30977,
-31056,
-31161,
-31281,
-31404,
-31559,
-31722,
-31918,
-32120,
-32325,
-32509,
-32651,
-32732,
-32740,
-32676,
-32554,
-32390,
-32211,
-32037,
-31888,
-31758,
-31656,
-31552,
-31446,
-31308,
-31146,
-30958,
-30770,
-30609,
-30497,
-30479,
-30551,
-30726,
-30979,
-31281,
-31593,
-31868,
-32085,
-32210,
-32266,
-32249,
-32197,
-32143,
-32104,
-32110,
-32154,
-32230,
-32306,
-32360,
-32362,
-32300,
-32176,
-31999,
-31800,
-31617,
-31475,
-31409,
-31425,
-31522,
-31687,
-31895,
-32116,
-32331,
-32525,
-32689,
-32834,
-32955,
-33084,
-33203,
-33330,
-33439,
-33526,
-33563,
-33542,
-33449,
-33294,
-33089,
-32862,
-32643,
-32460,
-32337,
-32289,
-32303,
-32382,
-32487,
-32616,
-32735,
-32844,
-32942,
-33031,
-33143,
-33272,
-33446,
-33657,
-33894,
-34141,
-34366,
-34547,
-34651,
-34674,
-34609,
-34466,
-34270,
-34039,
-33812,
-33594,
-33422,
-33274,
-33176,
-33102,
-33052,
-33029,
-33007,
-33016,
-33042,
-33092,
-33182,
-33283,
-33416,
-33542,
-33673,
-33775,
-33856,
-33903,
-33931,
-33944,
-33950,
-33971,
-33991,
-34023,
-34044,
-34037,
-33994,
-33890,
-33729,
-33515,
-33267,
-33018,
-32794,
-32627,
-32543,
-32539,
-32623,
-32759,
-32927,
-33088,
-33220,
-33291,
-33313,
-33277,
-33214,
-33144,
-33087,
-33066,
-33084,
-33133,
-33202,
-33254,
-33289,
-33262,
-33188,
-33047,
-32881,
-32677,
-32498,
-32331,
-32218,
-32152,
-32132,
-32160,
-32205,
-32276,
-32348,
-32427,
-32508,
-32593,
-32687,
-32793,
-32887,
-32985,
-33039,
-33065,
-33029,
-32940,
-32797,
-32622,
-32430,
-32253,
-32106,
-32009,
-31959,
-31956,
-31970,
-31996,
-31988,
-31961,
-31882,
-31787,
-31674,
-31585,
-31542,
-31565,
-31671,
-31850,
-32081,
-32348,
-32600,
-32819,
-32975,
-33053,
-33068,
-33019,
-32945,
-32856,
-32780,
-32722,
-32688,
-32665,
-32640,
-32590,
-32513,
-32391,
-32238,
-32066,
-31883,
-31732,
-31599,
-31523,
-31485,
-31488,
-31514,
-31561,
-31606,
-31667,
-31727,
-31818,
-31939,
-32103,
-32318,
-32564,
-32823,
-33079,
-33273,
-33407,
-33442,
-33379,
-33241,
-33040,
-32831,
-32641,
-32507,
-32450,
-32467,
-32547,
-32659,
-32766,
-32841,
-32852,
-32801,
-32689,
-32546,
-32405,
-32298,
-32258,
-32292,
-32399,
-32567,
-32752,
-32931,
-33061,
-33126,
-33113,
-33034,
-32909,
-32764,
-32630,
-32532,
-32477,
-32483,
-32522,
-32593,
-32671,
-32751,
-32815,
-32875,
-32926,
-32988,
-33060,
-33153,
-33256,
-33368,
-33462,
-33535,
-33566,
-33566,
-33531,
-33485,
-33444,
-33435,
-33464,
-33541,
-33645,
-33759,
-33850,
-33879,
-33823,
-33677,
-33428,
-33123,
-32776,
-32449,
-32177,
-31994,
-31917,
-31944,
-32050,
-32208,
-32381,
-32531,
-32651,
-32722,
-32773,
-32815,
-32885,
-33007,
-33192,
-33447,
-33749,
-34065,
-34362,
-34595,
-34732,
-34760,
-34673,
-34488,
-34224,
-33926,
-33603,
-33301,
-33015,
-32765,
-32539,
-32340,
-32158,
-32006,
-31878,
-31799,
-31777,
-31819,
-31936,
-32112,
-32331,
-32572,
-32794,
-32985,
-33111,
-33180,
-33195,
-33170,
-33136,
-33115,
-33121,
-33172,
-33247,
-33336,
-33414,
-33442,
-33417,
-33311,
-33142,
-32924,
-32689,
-32469,
-32303,
-32199,
-32186,
-32237,
-32344,
-32479,
-32602,
-32697,
-32744,
-32736,
-32692,
-32608,
-32531,
-32452,
-32408,
-32391,
-32402,
-32430,
-32456,
-32480,
-32472,
-32445,
-32388,
-32314,
-32223,
-32133,
-32042,
-31957,
-31883,
-31811,
-31758,
-31721,
-31713,
-31744,
-31831,
-31975,
-32189,
-32452,
-32762,
-33075,
-33376,
-33618,
-33781,
-33852,
-33812,
-33687,
-33478,
-33230,
-32954,
-32690,
-32436,
-32218,
-32011,
-31834,
-31640,
-31465,
-31264,
-31083,
-30910,
-30788,
-30727,
-30760,
-30887,
-31121,
-31442,
-31839,
-32276,
-32718,
-33147,
-33520,
-33836,
-34064,
-34219,
-34291,
-34288,
-34227,
-34097,
-33936,
-33724,
-33496,
-33250,
-33009,
-32781,
-32586,
-32422,
-32304,
-32225,
-32177,
-32161,
-32144,
-32149,
-32137,
-32141,
-32146,
-32171,
-32233,
-32330,
-32478,
-32670,
-32886,
-33117,
-33336,
-33515,
-33651,
-33707,
-33717,
-33654,
-33566,
-33451,
-33348,
-33257,
-33207,
-33179,
-33192,
-33209,
-33243,
-33259,
-33269,
-33260,
-33235,
-33217,
-33193,
-33199,
-33219,
-33273,
-33347,
-33444,
-33541,
-33634,
-33709,
-33759,
-33770,
-33749,
-33678,
-33574,
-33427,
-33238,
-33028,
-32778,
-32525,
-32264,
-32018,
-31812,
-31652,
-31566,
-31559,
-31641,
-31804,
-32043,
-32335,
-32662,
-32998,
-33327,
-33620,
-33884,
-34085,
-34246,
-34352,
-34414,
-34434,
-34401,
-34337,
-34213,
-34048,
-33825,
-33557,
-33239,
-32895,
-32527,
-32166,
-31828,
-31530,
-31302,
-31137,
-31069,
-31072,
-31161,
-31312,
-31514,
-31751,
-32001,
-32254,
-32483,
-32695,
-32858,
-33001,
-33090,
-33158,
-33187,
-33201,
-33187,
-33170,
-33134,
-33094,
-33047,
-32983,
-32917,
-32833,
-32744,
-32638,
-32533,
-32418,
-32309,
-32212,
-32122,
-32067,
-32024,
-32020,
-32040,
-32093,
-32167,
-32262,
-32362,
-32465,
-32545,
-32617,
-32641,
-32648,
-32606,
-32542,
-32456,
-32356,
-32263,
-32174,
-32115,
-32069,
-32056,
-32049,
-32059,
-32068,
-32073,
-32075,
-32074,
-32079,
-32111,
-32163,
-32270,
-32413,
-32613,
-32837,
-33087,
-33324,
-33533,
-33687,
-33769,
-33774,
-33693,
-33552,
-33350,
-33121,
-32873,
-32632,
-32409,
-32204,
-32034,
-31887,
-31767,
-31690,
-31628,
-31622,
-31652,
-31739,
-31869,
-32062,
-32273,
-32527,
-32776,
-33020,
-33238,
-33414,
-33561,
-33655,
-33730,
-33764,
-33787,
-33792,
-33772,
-33742,
-33671,
-33579,
-33440,
-33278,
-33091,
-32899,
-32724,
-32579,
-32490,
-32452,
-32480,
-32549,
-32655,
-32767,
-32869,
-32948,
-32986,
-32996,
-32980,
-32955,
-32936,
-32939,
-32970,
-33038,
-33119,
-33224,
-33311,
-33389,
-33430,
-33444,
-33417,
-33380,
-33321,
-33266,
-33225,
-33185,
-33170,
-33148,
-33136,
-33110,
-33080,
-33036,
-33000,
-32958,
-32948,
-32949,
-32989,
-33038,
-33107,
-33169,
-33211,
-33230,
-33199,
-33144,
-33053,
-32948,
-32851,
-32763,
-32709,
-32683,
-32678,
-32689,
-32697,
-32683,
-32653,
-32582,
-32509,
-32416,
-32356,
-32321,
-32353,
-32435,
-32584,
-32774,
-32984,
-33189,
-33361,
-33477,
-33532,
-33516,
-33447,
-33329,
-33198,
-33055,
-32929,
-32818,
-32727,
-32648,
-32579,
-32501,
-32419,
-32324,
-32226,
-32129,
-32051,
-31985,
-31960,
-31956,
-31989,
-32037,
-32101,
-32171,
-32234,
-32300,
-32350,
-32409,
-32464,
-32527,
-32597,
-32671,
-32742,
-32807,
-32854,
-32881,
-32889,
-32866,
-32843,
-32798,
-32773,
-32745,
-32738,
-32731,
-32740,
-32727,
-32711,
-32656,
-32578,
-32468,
-32343,
-32202,
-32087,
-31978,
-31926,
-31904,
-31932,
-31996,
-32084,
-32185,
-32283,
-32370,
-32434,
-32485,
-32516,
-32539,
-32556,
-32578,
-32599,
-32623,
-32651,
-32666,
-32676,
-32678,
-32659,
-32648,
-32627,
-32617,
-32620,
-32647,
-32680,
-32744,
-32805,
-32876,
-32941,
-32993,
-33034,
-33059,
-33073,
-33078,
-33077,
-33074,
-33062,
-33049,
-33018,
-32973,
-32906,
-32818,
-32713,
-32604,
-32488,
-32400,
-32326,
-32298,
-32310,
-32360,
-32449,
-32556,
-32679,
-32797,
-32908,
-32997,
-33067,
-33125,
-33165,
-33208,
-33249,
-33300,
-33359,
-33417,
-33485,
-33530,
-33577,
-33588,
-33579,
-33552,
-33493,
-33426,
-33344,
-33262,
-33176,
-33103,
-33029,
-32970,
-32910,
-32861,
-32813,
-32772,
-32741,
-32708,
-32697,
-32687,
-32699,
-32717,
-32753,
-32794,
-32852,
-32907,
-32977,
-33039,
-33110,
-33171,
-33233,
-33284,
-33317,
-33347,
-33339,
-33327,
-33273,
-33215,
-33126,
-33036,
-32938,
-32848,
-32770,
-32718,
-32681,
-32678,
-32692,
-32718,
-32766,
-32797,
-32842,
-32863,
-32877,
-32878,
-32864,
-32848,
-32820,
-32799,
-32772,
-32748,
-32725,
-32696,
-32660,
-32622,
-32568,
-32515,
-32454,
-32398,
-32349,
-32319,
-32307,
-32316,
-32354,
-32403,
-32471,
-32546,
-32611,
-32673,
-32718,
-32740,
-32757,
-32738,
-32727,
-32694,
-32668,
-32637,
-32610,
-32582,
-32559,
-32531,
-32504,
-32471,
-32440,
-32402,
-32374,
-32342,
-32320,
-32309,
-32293,
-32296,
-32286,
-32287,
-32275,
-32271,
-32258,
-32252,
-32249,
-32262,
-32285,
-32331,
-32387,
-32464,
-32541,
-32630,
-32706,
-32781,
-32836,
-32883,
-32912,
-32932,
-32939,
-32940,
-32928,
-32909,
-32878,
-32826,
-32762,
-32674,
-32575,
-32466,
-32358,
-32258,
-32182,
-32135,
-32119,
-32143,
-32199,
-32284,
-32388,
-32495,
-32609,
-32713,
-32812,
-32899,
-32977,
-33048,
-33116,
-33176,
-33228,
-33275,
-33292,
-33301,
-33278,
-33237,
-33183,
-33105,
-33039,
-32967,
-32921,
-32891,
-32884,
-32894,
-32916,
-32945,
-32972,
-32996,
-33004,
-33007,
-32998,
-32994,
-32990,
-32997,
-33008,
-33024,
-33040,
-33052,
-33058,
-33045,
-33022,
-32986,
-32938,
-32901,
-32871,
-32855,
-32863,
-32869,
-32904,
-32933,
-32968,
-32993,
-32996,
-32998,
-32988,
-32985,
-32994,
-33016,
-33062,
-33120,
-33212,
-33294,
-33393,
-33460,
-33509,
-33525,
-33516,
-33478,
-33420,
-33343,
-33251,
-33166,
-33066,
-32980,
-32868,
-32757,
-32619,
-32481,
-32338,
-32201,
-32078,
-31976,
-31918,
-31902,
-31949,
-32028,
-32156,
-32292,
-32457,
-32616,
-32781,
-32925,
-33046,
-33141,
-33221,
-33273,
-33319,
-33321,
-33304,
-33246,
-33165,
-33063,
-32943,
-32809,
-32667,
-32540,
-32434,
-32370,
-32333,
-32320,
-32331,
-32353,
-32389,
-32432,
-32463,
-32483,
-32487,
-32493,
-32504,
-32523,
-32541,
-32549,
-32555,
-32548,
-32537,
-32504,
-32446,
-32359,
-32272,
-32183,
-32136,
-32094,
-32103,
-32123,
-32193,
-32291,
-32410,
-32534,
-32633,
-32718,
-32774,
-32832,
-32865,
-32893,
-32901,
-32908,
-32924,
-32957,
-32983,
-33010,
-33000,
-32992,
-32960,
-32935,
-32887,
-32824,
-32746,
-32670,
-32607,
-32556,
-32508,
-32447,
-32385,
-32335,
-32295,
-32280,
-32265,
-32255,
-32270,
-32306,
-32388,
-32482,
-32589,
-32687,
-32791,
-32903,
-33017,
-33124,
-33201,
-33258,
-33305,
-33347,
-33387,
-33389,
-33365,
-33293,
-33214,
-33116,
-33010,
-32884,
-32740,
-32608,
-32506,
-32450,
-32437,
-32443,
-32476,
-32537,
-32634,
-32759,
-32886,
-32991,
-33081,
-33151,
-33228,
-33288,
-33323,
-33315,
-33280,
-33229,
-33182,
-33121,
-33052,
-32946,
-32856,
-32778,
-32743,
-32724,
-32711,
-32703,
-32710,
-32750,
-32815,
-32872,
-32919,
-32943,
-32970,
-33012,
-33054,
-33079,
-33072,
-33043,
-33006,
-32979,
-32936,
-32872,
-32773,
-32671,
-32586,
-32542,
-32511,
-32500,
-32485,
-32513,
-32577,
-32677,
-32781,
-32863,
-32920,
-32975,
-33031,
-33084,
-33107,
-33087,
-33050,
-33015,
-33002,
-32989,
-32966,
-32909,
-32868,
-32829,
-32829,
-32821,
-32791,
-32746,
-32691,
-32660,
-32640,
-32598,
-32537,
-32434,
-32358,
-32288,
-32248,
-32194,
-32128,
-32072,
-32043,
-32069,
-32114,
-32163,
-32209,
-32267,
-32370,
-32510,
-32667,
-32809,
-32941,
-33074,
-33236,
-33394,
-33527,
-33597,
-33607,
-33592,
-33554,
-33491,
-33368,
-33193,
-32987,
-32793,
-32638,
-32495,
-32359,
-32220,
-32110,
-32059,
-32059,
-32084,
-32096,
-32108,
-32132,
-32194,
-32276,
-32344,
-32376,
-32386,
-32404,
-32447,
-32495,
-32526,
-32521,
-32520,
-32540,
-32607,
-32684,
-32748,
-32803,
-32860,
-32964,
-33095,
-33230,
-33333,
-33410,
-33487,
-33579,
-33673,
-33724,
-33714,
-33650,
-33568,
-33485,
-33380,
-33232,
-33030,
-32818,
-32627,
-32485,
-32361,
-32234,
-32110,
-32009,
-31975,
-31987,
-32016,
-32034,
-32039,
-32069,
-32143,
-32238,
-32329,
-32377,
-32420,
-32478,
-32575,
-32680,
-32772,
-32828,
-32897,
-32992,
-33141,
-33294,
-33426,
-33533,
-33632,
-33758,
-33887,
-33973,
-34000,
-33956,
-33893,
-33822,
-33732,
-33593,
-33391,
-33153,
-32922,
-32714,
-32520,
-32298,
-32063,
-31847,
-31687,
-31610,
-31569,
-31558,
-31562,
-31631,
-31764,
-31968,
-32173,
-32357,
-32516,
-32670,
-32850,
-33010,
-33136,
-33187,
-33212,
-33235,
-33276,
-33316,
-33311,
-33277,
-33223,
-33206,
-33218,
-33232,
-33217,
-33178,
-33154,
-33162,
-33196,
-33208,
-33170,
-33094,
-33012,
-32941,
-32868,
-32748,
-32591,
-32408,
-32262,
-32163,
-32082,
-32004,
-31910,
-31847,
-31840,
-31893,
-31962,
-32031,
-32090,
-32190,
-32334,
-32527,
-32705,
-32850,
-32968,
-33077,
-33203,
-33305,
-33353,
-33338,
-33280,
-33238,
-33212,
-33197,
-33148,
-33080,
-33020,
-32994,
-33004,
-33001,
-32961,
-32881,
-32810,
-32752,
-32717,
-32652,
-32552,
-32431,
-32330,
-32259,
-32213,
-32137,
-32044,
-31953,
-31903,
-31923,
-31972,
-32032,
-32101,
-32210,
-32383,
-32616,
-32845,
-33059,
-33225,
-33397,
-33564,
-33722,
-33830,
-33850,
-33827,
-33771,
-33714,
-33636,
-33493,
-33298,
-33070,
-32862,
-32685,
-32523,
-32353,
-32186,
-32057,
-32001,
-32011,
-32044,
-32076,
-32092,
-32141,
-32210,
-32310,
-32373,
-32409,
-32413,
-32444,
-32509,
-32586,
-32646,
-32680,
-32706,
-32772,
-32867,
-32973,
-33056,
-33116,
-33191,
-33306,
-33456,
-33595,
-33705,
-33761,
-33825,
-33873,
-33911,
-33884,
-33777,
-33621,
-33446,
-33285,
-33119,
-32930,
-32702,
-32498,
-32323,
-32213,
-32124,
-32030,
-31942,
-31879,
-31884,
-31941,
-32019,
-32086,
-32150,
-32242,
-32371,
-32522,
-32645,
-32723,
-32777,
-32838,
-32926,
-33020,
-33089,
-33132,
-33176,
-33255,
-33367,
-33486,
-33560,
-33608,
-33630,
-33676,
-33715,
-33720,
-33669,
-33560,
-33446,
-33334,
-33215,
-33060,
-32840,
-32601,
-32360,
-32166,
-31972,
-31786,
-31580,
-31419,
-31318,
-31302,
-31327,
-31370,
-31419,
-31506,
-31650,
-31829,
-32009,
-32150,
-32266,
-32388,
-32529,
-32679,
-32791,
-32859,
-32902,
-32949,
-33028,
-33101,
-33148,
-33155,
-33163,
-33192,
-33262,
-33323,
-33352,
-33347,
-33331,
-33343,
-33345,
-33328,
-33243,
-33122,
-32991,
-32886,
-32781,
-32662,
-32502,
-32350,
-32227,
-32165,
-32135,
-32106,
-32076,
-32078,
-32139,
-32264,
-32415,
-32554,
-32690,
-32827,
-33011,
-33198,
-33364,
-33464,
-33520,
-33553,
-33599,
-33626,
-33613,
-33546,
-33458,
-33390,
-33357,
-33335,
-33300,
-33236,
-33189,
-33168,
-33189,
-33205,
-33188,
-33135,
-33082,
-33047,
-33022,
-32968,
-32868,
-32732,
-32604,
-32503,
-32413,
-32311,
-32178,
-32051,
-31964,
-31936,
-31936,
-31941,
-31938,
-31965,
-32046,
-32173,
-32316,
-32430,
-32526,
-32623,
-32738,
-32861,
-32944,
-32971,
-32954,
-32923,
-32908,
-32885,
-32830,
-32734,
-32631,
-32554,
-32520,
-32503,
-32478,
-32432,
-32413,
-32420,
-32476,
-32524,
-32542,
-32538,
-32538,
-32555,
-32598,
-32607,
-32592,
-32553,
-32535,
-32555,
-32590,
-32622,
-32627,
-32645,
-32692,
-32784,
-32881,
-32962,
-33023,
-33077,
-33168,
-33265,
-33350,
-33396,
-33401,
-33400,
-33405,
-33407,
-33372,
-33295,
-33189,
-33088,
-33022,
-32956,
-32895,
-32814,
-32752,
-32733,
-32757,
-32808,
-32840,
-32872,
-32902,
-32964,
-33035,
-33092,
-33112,
-33098,
-33081,
-33072,
-33066,
-33032,
-32966,
-32887,
-32826,
-32794,
-32779,
-32762,
-32737,
-32736,
-32765,
-32836,
-32914,
-32974,
-33022,
-33060,
-33110,
-33155,
-33171,
-33146,
-33086,
-33016,
-32951,
-32881,
-32792,
-32674,
-32558,
-32450,
-32376,
-32314,
-32253,
-32197,
-32163,
-32167,
-32214,
-32271,
-32333,
-32392,
-32458,
-32541,
-32616,
-32673,
-32688,
-32679,
-32658,
-32629,
-32595,
-32536,
-32462,
-32389,
-32330,
-32296,
-32267,
-32242,
-32217,
-32210,
-32224,
-32249,
-32281,
-32292,
-32307,
-32311,
-32322,
-32319,
-32294,
-32249,
-32186,
-32131,
-32071,
-32020,
-31963,
-31917,
-31891,
-31900,
-31928,
-31983,
-32043,
-32135,
-32236,
-32372,
-32505,
-32647,
-32782,
-32920,
-33054,
-33185,
-33292,
-33372,
-33436,
-33473,
-33505,
-33517,
-33505,
-33491,
-33472,
-33471,
-33487,
-33506,
-33544,
-33579,
-33644,
-33714,
-33794,
-33858,
-33906,
-33948,
-33981,
-34012,
-34023,
-34000,
-33973,
-33923,
-33894,
-33850,
-33801,
-33736,
-33676,
-33632,
-33619,
-33609,
-33611,
-33605,
-33618,
-33653,
-33700,
-33740,
-33746,
-33733,
-33710,
-33680,
-33637,
-33553,
-33433,
-33286,
-33142,
-32999,
-32854,
-32680,
-32495,
-32304,
-32157,
-32021,
-31906,
-31776,
-31646,
-31548,
-31475,
-31436,
-31379,
-31296,
-31206,
-31118,
-31054,
-30986,
-30894,
-30771,
-30659,
-30570,
-30540,
-30509,
-30493,
-30466,
-30488,
-30559,
-30683,
-30818,
-30940,
-31072,
-31219,
-31423,
-31629,
-31820,
-31958,
-32076,
-32198,
-32330,
-32442,
-32502,
-32509,
-32506,
-32527,
-32586,
-32636,
-32678,
-32695,
-32759,
-32877,
-33045,
-33213,
-33355,
-33488,
-33656,
-33862,
-34088,
-34269,
-34403,
-34508,
-34633,
-34770,
-34893,
-34945,
-34943,
-34921,
-34931,
-34963,
-34986,
-34957,
-34912,
-34885,
-34919,
-34988,
-35030,
-35027,
-34995,
-34983,
-35003,
-35016,
-34968,
-34842,
-34688,
-34545,
-34427,
-34281,
-34072,
-33798,
-33526,
-33292,
-33101,
-32892,
-32643,
-32377,
-32150,
-32009,
-31903,
-31799,
-31646,
-31492,
-31387,
-31336,
-31298,
-31207,
-31058,
-30904,
-30792,
-30732,
-30662,
-30540,
-30387,
-30255,
-30212,
-30216,
-30219,
-30173,
-30110,
-30096,
-30172,
-30285,
-30387,
-30421,
-30457,
-30529,
-30662,
-30799,
-30862,
-30871,
-30863,
-30921,
-31028,
-31136,
-31188,
-31201,
-31260,
-31394,
-31607,
-31815,
-31979,
-32148,
-32369,
-32682,
-33031,
-33336,
-33580,
-33800,
-34064,
-34369,
-34659,
-34853,
-34964,
-35042,
-35166,
-35307,
-35416,
-35429,
-35387,
-35369,
-35421,
-35522,
-35586,
-35578,
-35541,
-35543,
-35621,
-35700,
-35715,
-35617,
-35496,
-35408,
-35382,
-35343,
-35224,
-35025,
-34812,
-34644,
-34508,
-34338,
-34088,
-33793,
-33545,
-33394,
-33302,
-33199,
-33030,
-32856,
-32741,
-32707,
-32693,
-32617,
-32466,
-32302,
-32198,
-32143,
-32056,
-31880,
-31617,
-31374,
-31212,
-31122,
-31021,
-30843,
-30634,
-30462,
-30389,
-30368,
-30312,
-30202,
-30070,
-30014,
-30044,
-30108,
-30125,
-30083,
-30051,
-30080,
-30176,
-30242,
-30228,
-30157,
-30114,
-30186,
-30341,
-30509,
-30644,
-30768,
-30966,
-31253,
-31582,
-31867,
-32077,
-32293,
-32563,
-32919,
-33257,
-33492,
-33630,
-33723,
-33862,
-34032,
-34157,
-34184,
-34148,
-34135,
-34209,
-34323,
-34383,
-34346,
-34258,
-34240,
-34339,
-34518,
-34682,
-34783,
-34855,
-34956,
-35098,
-35222,
-35270,
-35244,
-35193,
-35177,
-35163,
-35095,
-34932,
-34717,
-34539,
-34437,
-34359,
-34234,
-34016,
-33796,
-33637,
-33600,
-33591,
-33544,
-33418,
-33283,
-33203,
-33182,
-33138,
-33013,
-32809,
-32611,
-32493,
-32426,
-32338,
-32163,
-31908,
-31665,
-31463,
-31306,
-31103,
-30868,
-30633,
-30492,
-30467,
-30488,
-30473,
-30389,
-30281,
-30238,
-30279,
-30390,
-30483,
-30562,
-30628,
-30718,
-30828,
-30930,
-31028,
-31163,
-31377,
-31659,
-31956,
-32182,
-32342,
-32480,
-32648,
-32865,
-33025,
-33097,
-33053,
-33000,
-33001,
-33073,
-33138,
-33131,
-33031,
-32918,
-32841,
-32827,
-32831,
-32802,
-32766,
-32762,
-32861,
-33053,
-33301,
-33556,
-33818,
-34089,
-34382,
-34657,
-34863,
-34996,
-35071,
-35141,
-35221,
-35272,
-35257,
-35155,
-34995,
-34822,
-34680,
-34558,
-34458,
-34367,
-34258,
-34150,
-34003,
-33848,
-33720,
-33668,
-33706,
-33799,
-33855,
-33841,
-33754,
-33669,
-33621,
-33567,
-33441,
-33160,
-32763,
-32345,
-32005,
-31777,
-31585,
-31365,
-31091,
-30800,
-30586,
-30442,
-30370,
-30290,
-30213,
-30161,
-30182,
-30294,
-30467,
-30668,
-30890,
-31110,
-31340,
-31545,
-31715,
-31847,
-31980,
-32108,
-32246,
-32340,
-32384,
-32379,
-32342,
-32319,
-32258,
-32207,
-32131,
-32091,
-32065,
-32005,
-31857,
-31608,
-31349,
-31205,
-31212,
-31331,
-31404,
-31399,
-31347,
-31428,
-31689,
-32094,
-32471,
-32727,
-32870,
-33052,
-33351,
-33765,
-34173,
-34484,
-34697,
-34878,
-35051,
-35198,
-35239,
-35168,
-35043,
-34920,
-34825,
-34716,
-34568,
-34410,
-34304,
-34246,
-34193,
-34059,
-33875,
-33756,
-33800,
-34006,
-34224,
-34318,
-34254,
-34142,
-34065,
-34035,
-33937,
-33713,
-33438,
-33239,
-33186,
-33154,
-32970,
-32574,
-32101,
-31799,
-31760,
-31874,
-31929,
-31822,
-31681,
-31694,
-31930,
-32268,
-32523,
-32644,
-32750,
-32984,
-33331,
-33638,
-33752,
-33685,
-33596,
-33583,
-33605,
-33486,
-33158,
-32725,
-32384,
-32225,
-32141,
-31955,
-31611,
-31242,
-31009,
-30915,
-30794,
-30488,
-30044,
-29695,
-29658,
-29908,
-30245,
-30441,
-30503,
-30560,
-30753,
-31028,
-31246,
-31362,
-31478,
-31779,
-32265,
-32781,
-33098,
-33209,
-33261,
-33474,
-33837,
-34182,
-34327,
-34294,
-34236,
-34278,
-34322,
-34169,
-33749,
-33239,
-32948,
-33010,
-33271,
-33410,
-33266,
-32952,
-32743,
-32764,
-32891,
-32883,
-32642,
-32327,
-32179,
-32308,
-32578,
-32779,
-32798,
-32726,
-32692,
-32734,
-32757,
-32659,
-32455,
-32276,
-32226,
-32321,
-32491,
-32670,
-32883,
-33139,
-33429,
-33691,
-33898,
-34116,
-34419,
-34801,
-35121,
-35230,
-35104,
-34896,
-34790,
-34827,
-34867,
-34737,
-34428,
-34092,
-33938,
-33922,
-33866,
-33490,
-32809,
-32048,
-31555,
-31480,
-31687,
-31901,
-31905,
-31741,
-31572,
-31594,
-31782,
-32021,
-32131,
-32077,
-31952,
-31899,
-32027,
-32294,
-32554,
-32682,
-32626,
-32503,
-32472,
-32635,
-32946,
-33223,
-33355,
-33301,
-33213,
-33173,
-33209,
-33161,
-32960,
-32618,
-32334,
-32260,
-32401,
-32547,
-32498,
-32168,
-31704,
-31311,
-31124,
-31082,
-31053,
-30913,
-30714,
-30563,
-30605,
-30831,
-31148,
-31404,
-31496,
-31460,
-31437,
-31569,
-31919,
-32342,
-32623,
-32597,
-32334,
-32084,
-32105,
-32447,
-32903,
-33186,
-33204,
-33090,
-33125,
-33386,
-33733,
-33857,
-33639,
-33220,
-32912,
-32906,
-33144,
-33382,
-33469,
-33427,
-33417,
-33494,
-33576,
-33470,
-33152,
-32757,
-32545,
-32624,
-32928,
-33246,
-33428,
-33478,
-33513,
-33644,
-33927,
-34288,
-34676,
-34982,
-35159,
-35181,
-35106,
-35021,
-35021,
-35099,
-35173,
-35186,
-35165,
-35237,
-35473,
-35782,
-35929,
-35728,
-35227,
-34667,
-34339,
-34294,
-34385,
-34359,
-34163,
-33898,
-33746,
-33727,
-33699,
-33470,
-33032,
-32507,
-32094,
-31825,
-31611,
-31335,
-31019,
-30804,
-30824,
-31064,
-31367,
-31561,
-31621,
-31654,
-31823,
-32180,
-32636,
-33031,
-33246,
-33262,
-33197,
-33175,
-33309,
-33590,
-33925,
-34179,
-34247,
-34131,
-33893,
-33609,
-33283,
-32878,
-32380,
-31889,
-31539,
-31435,
-31503,
-31563,
-31448,
-31151,
-30828,
-30662,
-30687,
-30814,
-30888,
-30874,
-30866,
-30978,
-31238,
-31544,
-31771,
-31906,
-32062,
-32377,
-32892,
-33493,
-33977,
-34228,
-34220,
-34122,
-34060,
-34147,
-34330,
-34510,
-34590,
-34572,
-34575,
-34713,
-35034,
-35403,
-35624,
-35563,
-35287,
-35028,
-34987,
-35189,
-35449,
-35542,
-35409,
-35173,
-35036,
-35013,
-34988,
-34722,
-34209,
-33572,
-33074,
-32758,
-32497,
-32065,
-31387,
-30653,
-30138,
-30024,
-30251,
-30585,
-30854,
-31025,
-31234,
-31564,
-32001,
-32414,
-32671,
-32765,
-32784,
-32875,
-33109,
-33472,
-33819,
-33984,
-33841,
-33374,
-32717,
-32039,
-31458,
-30957,
-30409,
-29737,
-28998,
-28367,
-27988,
-27849,
-27781,
-27612,
-27351,
-27134,
-27141,
-27350,
-27568,
-27597,
-27367,
-27065,
-26902,
-26975,
-27191,
-27381,
-27486,
-27589,
-27806,
-28136,
-28420,
-28476,
-28266,
-27945,
-27753,
-27843,
-28173,
-28596,
-28960,
-29218,
-29430,
-29648,
-29896,
-30139,
-30312,
-30383,
-30348,
-30252,
-30166,
-30162,
-30287,
-30499,
-30726,
-30890,
-30987,
-31083,
-31248,
-31489,
-31731,
-31879,
-31894,
-31812,
-31709,
-31611,
-31522,
-31430,
-31399,
-31484,
-31727,
-32045,
-32305,
-32440,
-32462,
-32507,
-32666,
-32937,
-33272,
-33612,
-34035,
-34606,
-35367,
-36197,
-36909,
-37365,
-37580,
-37671,
-37762,
-37872,
-37896,
-37769,
-37445,
-36991,
-36468,
-35902,
-35293,
-34679,
-34119,
-33709,
-33444,
-33277,
-33085,
-32834,
-32531,
-32293,
-32194,
-32281,
-32517,
-32853,
-33215,
-33587,
-33944,
-34312,
-34701,
-35050,
-35307,
-35335,
-35170,
-34882,
-34667,
-34638,
-34751,
-34857,
-34782,
-34552,
-34313,
-34276,
-34457,
-34711,
-34826,
-34723,
-34533,
-34472,
-34621,
-34888,
-35045,
-34999,
-34832,
-34759,
-34921,
-35261,
-35578,
-35711,
-35642,
-35487,
-35363,
-35268,
-35121,
-34875,
-34592,
-34426,
-34517,
-34848,
-35289,
-35628,
-35752,
-35666,
-35529,
-35485,
-35652,
-35976,
-36350,
-36627,
-36798,
-36956,
-37280,
-37854,
-38584,
-39277,
-39747,
-40013,
-40232,
-40587,
-41059,
-41480,
-41602,
-41409,
-41064,
-40859,
-40891,
-41059,
-41081,
-40810,
-40281,
-39698,
-39197,
-38744,
-38185,
-37427,
-36559,
-35813,
-35388,
-35301,
-35393,
-35481,
-35461,
-35405,
-35404,
-35522,
-35691,
-35812,
-35807,
-35710,
-35625,
-35655,
-35817,
-36008,
-36063,
-35871,
-35438,
-34926,
-34501,
-34243,
-34037,
-33694,
-33071,
-32243,
-31423,
-30851,
-30586,
-30497,
-30410,
-30230,
-30045,
-29971,
-30051,
-30155,
-30125,
-29866,
-29466,
-29089,
-28826,
-28662,
-28480,
-28200,
-27829,
-27439,
-27058,
-26666,
-26183,
-25578,
-24914,
-24299,
-23846,
-23601,
-23508,
-23508,
-23512,
-23511,
-23553,
-23708,
-24065,
-24588,
-25199,
-25746,
-26152,
-26436,
-26692,
-26991,
-27312,
-27548,
-27644,
-27629,
-27661,
-27831,
-28140,
-28398,
-28480,
-28301,
-28012,
-27747,
-27622,
-27605,
-27619,
-27627,
-27643,
-27705,
-27805,
-27898,
-27952,
-27987,
-28061,
-28195,
-28337,
-28420,
-28392,
-28341,
-28340,
-28471,
-28681,
-28916,
-29110,
-29311,
-29557,
-29903,
-30303,
-30704,
-31041,
-31309,
-31471,
-31534,
-31464,
-31320,
-31181,
-31162,
-31264,
-31432,
-31513,
-31453,
-31241,
-30984,
-30738,
-30541,
-30376,
-30250,
-30194,
-30260,
-30445,
-30706,
-30987,
-31250,
-31498,
-31729,
-31923,
-32053,
-32108,
-32115,
-32087,
-31999,
-31777,
-31392,
-30873,
-30394,
-30070,
-29976,
-30008,
-30023,
-29921,
-29731,
-29558,
-29512,
-29611,
-29815,
-30084,
-30429,
-30878,
-31464,
-32127,
-32801,
-33397,
-33887,
-34264,
-34555,
-34725,
-34805,
-34774,
-34699,
-34619,
-34567,
-34550,
-34534,
-34500,
-34432,
-34356,
-34303,
-34327,
-34450,
-34668,
-34930,
-35184,
-35405,
-35629,
-35918,
-36321,
-36810,
-37317,
-37768,
-38152,
-38521,
-38912,
-39295,
-39600,
-39707,
-39638,
-39472,
-39363,
-39416,
-39607,
-39858,
-40022,
-40065,
-39968,
-39828,
-39680,
-39595,
-39580,
-39629,
-39736,
-39853,
-39956,
-40029,
-40069,
-40112,
-40185,
-40310,
-40505,
-40738,
-40982,
-41163,
-41237,
-41200,
-41072,
-40932,
-40800,
-40663,
-40475,
-40200,
-39875,
-39565,
-39317,
-39104,
-38841,
-38466,
-37992,
-37530,
-37172,
-36959,
-36835,
-36725,
-36601,
-36503,
-36494,
-36570,
-36703,
-36781,
-36793,
-36733,
-36656,
-36590,
-36523,
-36426,
-36281,
-36058,
-35772,
-35405,
-35002,
-34614,
-34320,
-34150,
-34066,
-33981,
-33809,
-33524,
-33179,
-32843,
-32565,
-32385,
-32294,
-32304,
-32398,
-32498,
-32527,
-32403,
-32158,
-31871,
-31647,
-31511,
-31399,
-31234,
-30984,
-30715,
-30515,
-30422,
-30407,
-30390,
-30346,
-30299,
-30291,
-30352,
-30421,
-30461,
-30424,
-30339,
-30222,
-30098,
-29959,
-29835,
-29744,
-29726,
-29750,
-29766,
-29696,
-29544,
-29348,
-29190,
-29077,
-28987,
-28872,
-28745,
-28668,
-28689,
-28824,
-28961,
-29031,
-28952,
-28766,
-28510,
-28261,
-27997,
-27729,
-27449,
-27152,
-26865,
-26560,
-26242,
-25927,
-25674,
-25532,
-25545,
-25670,
-25857,
-26040,
-26198,
-26318,
-26433,
-26536,
-26674,
-26869,
-27114,
-27393,
-27621,
-27755,
-27786,
-27755,
-27715,
-27661,
-27550,
-27321,
-27001,
-26678,
-26463,
-26404,
-26447,
-26480,
-26447,
-26373,
-26362,
-26491,
-26752,
-27036,
-27248,
-27323,
-27317,
-27297,
-27313,
-27347,
-27343,
-27277,
-27170,
-27098,
-27115,
-27219,
-27358,
-27464,
-27507,
-27514,
-27522,
-27585,
-27698,
-27854,
-28046,
-28285,
-28612,
-29014,
-29455,
-29856,
-30148,
-30333,
-30448,
-30588,
-30760,
-30963,
-31108,
-31157,
-31117,
-31075,
-31108,
-31272,
-31531,
-31812,
-32064,
-32282,
-32506,
-32778,
-33066,
-33317,
-33462,
-33498,
-33487,
-33517,
-33635,
-33815,
-33990,
-34094,
-34131,
-34127,
-34131,
-34134,
-34102,
-34021,
-33910,
-33835,
-33840,
-33936,
-34082,
-34247,
-34429,
-34674,
-34991,
-35373,
-35739,
-36035,
-36265,
-36470,
-36716,
-37000,
-37275,
-37476,
-37589,
-37668,
-37781,
-37990,
-38279,
-38601,
-38914,
-39170,
-39385,
-39527,
-39603,
-39614,
-39587,
-39592,
-39653,
-39779,
-39926,
-40038,
-40104,
-40121,
-40132,
-40116,
-40076,
-39976,
-39821,
-39649,
-39482,
-39352,
-39235,
-39118,
-38983,
-38861,
-38760,
-38716,
-38709,
-38739,
-38768,
-38794,
-38786,
-38743,
-38663,
-38584,
-38548,
-38591,
-38720,
-38907,
-39123,
-39366,
-39633,
-39925,
-40210,
-40417,
-40519,
-40515,
-40471,
-40454,
-40488,
-40538,
-40561,
-40513,
-40396,
-40214,
-39951,
-39591,
-39133,
-38625,
-38156,
-37761,
-37445,
-37117,
-36716,
-36246,
-35779,
-35415,
-35198,
-35090,
-35020,
-34939,
-34834,
-34739,
-34654,
-34554,
-34420,
-34248,
-34089,
-34002,
-34000,
-34072,
-34160,
-34225,
-34244,
-34188,
-34059,
-33853,
-33616,
-33425,
-33322,
-33331,
-33376,
-33389,
-33334,
-33231,
-33125,
-33032,
-32914,
-32719,
-32458,
-32170,
-31928,
-31738,
-31532,
-31256,
-30887,
-30498,
-30181,
-29970,
-29822,
-29669,
-29473,
-29274,
-29111,
-28975,
-28776,
-28462,
-28020,
-27624,
-27371,
-27369,
-27503,
-27650,
-27701,
-27658,
-27591,
-27542,
-27482,
-27363,
-27187,
-27017,
-26966,
-27041,
-27193,
-27298,
-27311,
-27258,
-27227,
-27254,
-27313,
-27324,
-27249,
-27110,
-26947,
-26768,
-26535,
-26202,
-25818,
-25477,
-25319,
-25377,
-25590,
-25835,
-26007,
-26077,
-26072,
-26002,
-25886,
-25730,
-25579,
-25525,
-25598,
-25819,
-26083,
-26334,
-26513,
-26651,
-26759,
-26835,
-26830,
-26718,
-26529,
-26333,
-26199,
-26129,
-26078,
-25999,
-25904,
-25874,
-25974,
-26224,
-26554,
-26855,
-27055,
-27132,
-27110,
-27034,
-26925,
-26817,
-26759,
-26811,
-27037,
-27435,
-27953,
-28506,
-28993,
-29351,
-29546,
-29602,
-29571,
-29539,
-29571,
-29686,
-29867,
-30050,
-30223,
-30392,
-30600,
-30847,
-31070,
-31209,
-31224,
-31186,
-31184,
-31250,
-31320,
-31258,
-31038,
-30759,
-30662,
-30905,
-31459,
-32112,
-32607,
-32859,
-32965,
-33087,
-33303,
-33482,
-33484,
-33275,
-33010,
-32975,
-33253,
-33790,
-34289,
-34603,
-34713,
-34802,
-35012,
-35329,
-35634,
-35790,
-35821,
-35868,
-36018,
-36305,
-36576,
-36773,
-36895,
-37062,
-37353,
-37716,
-38036,
-38181,
-38151,
-38001,
-37802,
-37537,
-37202,
-36824,
-36545,
-36494,
-36705,
-37049,
-37366,
-37562,
-37690,
-37853,
-38082,
-38293,
-38367,
-38293,
-38214,
-38285,
-38590,
-38974,
-39256,
-39317,
-39237,
-39228,
-39410,
-39744,
-40017,
-40037,
-39779,
-39391,
-39071,
-38924,
-38908,
-38889,
-38791,
-38641,
-38566,
-38660,
-38925,
-39216,
-39336,
-39144,
-38687,
-38125,
-37729,
-37578,
-37637,
-37687,
-37590,
-37367,
-37202,
-37281,
-37585,
-37918,
-38002,
-37798,
-37490,
-37404,
-37678,
-38146,
-38483,
-38449,
-38166,
-37937,
-38058,
-38458,
-38841,
-38853,
-38462,
-37922,
-37547,
-37435,
-37383,
-37101,
-36517,
-35832,
-35384,
-35312,
-35471,
-35529,
-35288,
-34791,
-34307,
-34021,
-33942,
-33905,
-33780,
-33571,
-33432,
-33446,
-33589,
-33700,
-33687,
-33550,
-33408,
-33334,
-33300,
-33225,
-33070,
-32905,
-32833,
-32895,
-32989,
-33012,
-32882,
-32729,
-32648,
-32727,
-32837,
-32826,
-32597,
-32241,
-31951,
-31843,
-31897,
-31916,
-31768,
-31456,
-31136,
-30957,
-30937,
-30895,
-30676,
-30166,
-29535,
-28963,
-28632,
-28504,
-28426,
-28237,
-27903,
-27536,
-27307,
-27273,
-27360,
-27374,
-27198,
-26873,
-26586,
-26573,
-26881,
-27386,
-27819,
-28007,
-27983,
-27986,
-28214,
-28690,
-29163,
-29328,
-29062,
-28523,
-28058,
-27881,
-27957,
-27994,
-27772,
-27314,
-26892,
-26787,
-27010,
-27306,
-27357,
-27059,
-26604,
-26311,
-26318,
-26533,
-26696,
-26685,
-26590,
-26645,
-26970,
-27478,
-27942,
-28199,
-28239,
-28188,
-28095,
-27951,
-27654,
-27242,
-26816,
-26538,
-26426,
-26425,
-26430,
-26498,
-26729,
-27200,
-27791,
-28293,
-28549,
-28622,
-28721,
-28998,
-29372,
-29627,
-29606,
-29432,
-29423,
-29819,
-30557,
-31285,
-31640,
-31572,
-31304,
-31195,
-31321,
-31509,
-31441,
-31023,
-30446,
-30103,
-30219,
-30750,
-31390,
-31865,
-32098,
-32251,
-32546,
-33054,
-33646,
-34075,
-34164,
-33962,
-33696,
-33642,
-33916,
-34389,
-34807,
-34943,
-34836,
-34718,
-34831,
-35221,
-35617,
-35696,
-35313,
-34699,
-34277,
-34336,
-34786,
-35224,
-35305,
-35026,
-34752,
-34886,
-35472,
-36172,
-36502,
-36299,
-35854,
-35706,
-36169,
-37103,
-38006,
-38452,
-38434,
-38337,
-38598,
-39304,
-40146,
-40634,
-40541,
-40045,
-39568,
-39457,
-39662,
-39869,
-39727,
-39167,
-38459,
-37943,
-37815,
-37910,
-37907,
-37558,
-36895,
-36201,
-35765,
-35701,
-35842,
-35969,
-35915,
-35774,
-35707,
-35872,
-36232,
-36635,
-36902,
-36984,
-36951,
-36926,
-36983,
-37067,
-37107,
-36996,
-36763,
-36487,
-36274,
-36210,
-36278,
-36411,
-36539,
-36609,
-36674,
-36773,
-36942,
-37121,
-37205,
-37096,
-36818,
-36476,
-36208,
-36087,
-36049,
-35983,
-35795,
-35487,
-35130,
-34802,
-34480,
-34120,
-33601,
-32934,
-32134,
-31317,
-30569,
-29954,
-29500,
-29189,
-28993,
-28879,
-28854,
-28943,
-29193,
-29567,
-29986,
-30315,
-30510,
-30661,
-30930,
-31462,
-32217,
-33003,
-33599,
-33897,
-34008,
-34095,
-34249,
-34370,
-34251,
-33736,
-32896,
-31928,
-31085,
-30422,
-29851,
-29168,
-28315,
-27372,
-26544,
-25979,
-25668,
-25472,
-25263,
-25032,
-24915,
-25091,
-25605,
-26359,
-27127,
-27765,
-28239,
-28683,
-29179,
-29728,
-30173,
-30374,
-30266,
-29973,
-29651,
-29404,
-29219,
-28997,
-28653,
-28205,
-27716,
-27276,
-26932,
-26705,
-26608,
-26661,
-26851,
-27166,
-27554,
-28013,
-28527,
-29074,
-29551,
-29855,
-29914,
-29825,
-29731,
-29750,
-29845,
-29834,
-29604,
-29181,
-28780,
-28577,
-28570,
-28564,
-28330,
-27858,
-27356,
-27101,
-27222,
-27614,
-28069,
-28519,
-29051,
-29846,
-30929,
-32124,
-33152,
-33861,
-34284,
-34605,
-34921,
-35204,
-35319,
-35179,
-34853,
-34494,
-34226,
-34079,
-33946,
-33731,
-33373,
-32897,
-32403,
-31975,
-31691,
-31548,
-31476,
-31391,
-31254,
-31176,
-31312,
-31776,
-32498,
-33239,
-33819,
-34231,
-34707,
-35482,
-36551,
-37629,
-38322,
-38467,
-38266,
-38103,
-38242,
-38571,
-38751,
-38517,
-37938,
-37368,
-37131,
-37261,
-37495,
-37486,
-37122,
-36525,
-35970,
-35617,
-35438,
-35303,
-35145,
-34997,
-35001,
-35215,
-35644,
-36202,
-36804,
-37328,
-37660,
-37678,
-37373,
-36877,
-36409,
-36157,
-36142,
-36240,
-36292,
-36260,
-36229,
-36343,
-36595,
-36815,
-36734,
-36212,
-35343,
-34440,
-33841,
-33733,
-34095,
-34760,
-35533,
-36304,
-37036,
-37740,
-38370,
-38780,
-38762,
-38166,
-37041,
-35644,
-34399,
-33630,
-33487,
-33806,
-34314,
-34742,
-35063,
-35351,
-35697,
-35942,
-35772,
-34908,
-33388,
-31614,
-30167,
-29478,
-29608,
-30297,
-31182,
-32067,
-32967,
-33962,
-34969,
-35695,
-35779,
-35109,
-33870,
-32504,
-31387,
-30693,
-30424,
-30450,
-30769,
-31332,
-32135,
-33008,
-33730,
-34071,
-33950,
-33408,
-32573,
-31567,
-30496,
-29525,
-28828,
-28549,
-28677,
-29096,
-29645,
-30211,
-30753,
-31207,
-31500,
-31550,
-31309,
-30847,
-30285,
-29762,
-29380,
-29142,
-29050,
-29074,
-29206,
-29384,
-29521,
-29569,
-29574,
-29617,
-29708,
-29721,
-29527,
-29121,
-28695,
-28455,
-28447,
-28521,
-28443,
-28215,
-28016,
-28173,
-28743,
-29493,
-29988,
-30024,
-29763,
-29642,
-29898,
-30362,
-30568,
-30220,
-29462,
-28765,
-28507,
-28678,
-28956,
-29015,
-28856,
-28733,
-28925,
-29418,
-29950,
-30221,
-30207,
-30098,
-30095,
-30174,
-30166,
-30000,
-29838,
-29957,
-30427,
-31039,
-31466,
-31569,
-31528,
-31649,
-32071,
-32595,
-32840,
-32549,
-31867,
-31221,
-31002,
-31246,
-31642,
-31853,
-31769,
-31623,
-31683,
-32122,
-32807,
-33490,
-33855,
-33767,
-33275,
-32654,
-32230,
-32195,
-32517,
-32931,
-33197,
-33230,
-33210,
-33460,
-34124,
-35060,
-35772,
-35884,
-35376,
-34696,
-34363,
-34590,
-35106,
-35498,
-35533,
-35394,
-35471,
-36006,
-36890,
-37699,
-38038,
-37819,
-37277,
-36763,
-36437,
-36231,
-36032,
-35847,
-35805,
-35968,
-36264,
-36532,
-36721,
-36870,
-37066,
-37237,
-37238,
-36914,
-36355,
-35855,
-35759,
-36151,
-36763,
-37177,
-37205,
-37071,
-37177,
-37704,
-38377,
-38714,
-38460,
-37815,
-37289,
-37252,
-37655,
-38101,
-38199,
-37918,
-37565,
-37516,
-37824,
-38188,
-38279,
-37982,
-37561,
-37263,
-37178,
-37153,
-37076,
-36971,
-36967,
-37087,
-37200,
-37121,
-36834,
-36505,
-36366,
-36473,
-36613,
-36510,
-36077,
-35569,
-35335,
-35478,
-35734,
-35697,
-35277,
-34715,
-34441,
-34583,
-34934,
-35139,
-35016,
-34677,
-34396,
-34289,
-34293,
-34195,
-33918,
-33608,
-33466,
-33549,
-33695,
-33706,
-33592,
-33528,
-33643,
-33793,
-33697,
-33160,
-32317,
-31477,
-30913,
-30649,
-30545,
-30449,
-30353,
-30383,
-30609,
-30974,
-31266,
-31308,
-31094,
-30697,
-30174,
-29507,
-28728,
-28068,
-27810,
-28072,
-28635,
-29130,
-29355,
-29429,
-29592,
-29941,
-30198,
-29962,
-29022,
-27633,
-26406,
-25854,
-26012,
-26461,
-26697,
-26649,
-26625,
-26993,
-27728,
-28406,
-28545,
-27996,
-27029,
-26088,
-25520,
-25327,
-25332,
-25322,
-25314,
-25480,
-25972,
-26723,
-27439,
-27850,
-27828,
-27478,
-26970,
-26480,
-26110,
-25859,
-25695,
-25521,
-25393,
-25401,
-25662,
-26111,
-26587,
-26890,
-26971,
-26850,
-26654,
-26446,
-26316,
-26255,
-26244,
-26255,
-26297,
-26423,
-26646,
-26938,
-27290,
-27681,
-28092,
-28402,
-28531,
-28494,
-28471,
-28587,
-28813,
-28971,
-28900,
-28651,
-28407,
-28373,
-28622,
-29035,
-29424,
-29635,
-29695,
-29794,
-30071,
-30529,
-30961,
-31217,
-31267,
-31209,
-31125,
-31068,
-31063,
-31199,
-31484,
-31849,
-32157,
-32366,
-32525,
-32763,
-33115,
-33522,
-33821,
-33881,
-33686,
-33405,
-33284,
-33450,
-33804,
-34130,
-34345,
-34551,
-34948,
-35559,
-36241,
-36797,
-37143,
-37288,
-37297,
-37217,
-37106,
-37012,
-36962,
-36969,
-37032,
-37152,
-37292,
-37468,
-37706,
-38099,
-38555,
-38891,
-38873,
-38526,
-38083,
-37825,
-37794,
-37868,
-37867,
-37828,
-37874,
-38174,
-38727,
-39399,
-39950,
-40209,
-40179,
-40024,
-39926,
-39899,
-39840,
-39681,
-39500,
-39429,
-39550,
-39808,
-40156,
-40554,
-40928,
-41165,
-41123,
-40815,
-40354,
-39912,
-39584,
-39390,
-39273,
-39164,
-39023,
-38943,
-39054,
-39416,
-39855,
-40091,
-39952,
-39508,
-38998,
-38580,
-38318,
-38151,
-38031,
-37929,
-37843,
-37850,
-38023,
-38361,
-38686,
-38787,
-38555,
-38061,
-37500,
-37008,
-36668,
-36466,
-36354,
-36232,
-36095,
-36013,
-36115,
-36378,
-36632,
-36650,
-36383,
-35935,
-35439,
-34951,
-34468,
-34027,
-33676,
-33479,
-33427,
-33515,
-33660,
-33775,
-33748,
-33605,
-33409,
-33220,
-32952,
-32519,
-31955,
-31429,
-31111,
-31004,
-31013,
-31054,
-31098,
-31150,
-31175,
-31161,
-31080,
-30904,
-30585,
-30145,
-29668,
-29263,
-28961,
-28717,
-28538,
-28494,
-28595,
-28765,
-28844,
-28781,
-28643,
-28524,
-28406,
-28240,
-27945,
-27553,
-27100,
-26720,
-26528,
-26609,
-26865,
-27100,
-27188,
-27159,
-27149,
-27205,
-27247,
-27180,
-26987,
-26735,
-26478,
-26267,
-26150,
-26156,
-26265,
-26388,
-26511,
-26633,
-26772,
-26852,
-26799,
-26615,
-26385,
-26160,
-25926,
-25695,
-25510,
-25471,
-25580,
-25769,
-25991,
-26232,
-26478,
-26675,
-26761,
-26760,
-26703,
-26638,
-26525,
-26411,
-26347,
-26378,
-26504,
-26691,
-26971,
-27353,
-27763,
-28055,
-28141,
-28092,
-28015,
-27985,
-27941,
-27860,
-27747,
-27666,
-27668,
-27794,
-28069,
-28442,
-28802,
-29052,
-29195,
-29330,
-29479,
-29577,
-29537,
-29399,
-29304,
-29358,
-29553,
-29810,
-30082,
-30334,
-30576,
-30787,
-31004,
-31215,
-31371,
-31408,
-31345,
-31300,
-31379,
-31556,
-31760,
-31951,
-32201,
-32544,
-32954,
-33305,
-33568,
-33721,
-33834,
-33904,
-33986,
-34073,
-34166,
-34205,
-34215,
-34277,
-34459,
-34705,
-34878,
-34893,
-34833,
-34832,
-34948,
-35115,
-35266,
-35372,
-35481,
-35664,
-35956,
-36382,
-36839,
-37213,
-37400,
-37457,
-37511,
-37625,
-37739,
-37785,
-37765,
-37790,
-37934,
-38160,
-38423,
-38668,
-38863,
-39015,
-39082,
-39104,
-39098,
-39042,
-38925,
-38752,
-38611,
-38564,
-38604,
-38692,
-38826,
-39018,
-39256,
-39424,
-39483,
-39441,
-39417,
-39450,
-39510,
-39554,
-39563,
-39569,
-39620,
-39749,
-39986,
-40283,
-40531,
-40602,
-40511,
-40330,
-40195,
-40078,
-39938,
-39722,
-39467,
-39245,
-39097,
-39080,
-39203,
-39433,
-39651,
-39761,
-39748,
-39704,
-39700,
-39743,
-39752,
-39684,
-39512,
-39265,
-38980,
-38734,
-38560,
-38453,
-38317,
-38097,
-37812,
-37525,
-37256,
-37000,
-36731,
-36511,
-36386,
-36341,
-36337,
-36320,
-36336,
-36415,
-36565,
-36750,
-36902,
-36943,
-36832,
-36586,
-36293,
-36069,
-35902,
-35730,
-35459,
-35122,
-34842,
-34689,
-34683,
-34724,
-34723,
-34600,
-34321,
-33923,
-33513,
-33162,
-32862,
-32534,
-32088,
-31586,
-31131,
-30848,
-30757,
-30793,
-30824,
-30755,
-30560,
-30324,
-30177,
-30138,
-30121,
-29996,
-29753,
-29546,
-29515,
-29700,
-29938,
-30070,
-29999,
-29776,
-29512,
-29271,
-29030,
-28683,
-28167,
-27524,
-26929,
-26538,
-26388,
-26391,
-26442,
-26508,
-26630,
-26778,
-26925,
-26977,
-26936,
-26802,
-26601,
-26323,
-25982,
-25617,
-25291,
-25053,
-24907,
-24779,
-24599,
-24298,
-23954,
-23661,
-23501,
-23410,
-23266,
-23023,
-22780,
-22715,
-22911,
-23286,
-23684,
-23960,
-24123,
-24233,
-24358,
-24491,
-24548,
-24465,
-24274,
-24080,
-24007,
-24059,
-24175,
-24269,
-24354,
-24471,
-24627,
-24764,
-24768,
-24646,
-24408,
-24165,
-23917,
-23669,
-23417,
-23197,
-23089,
-23152,
-23342,
-23566,
-23711,
-23770,
-23868,
-24104,
-24512,
-24929,
-25248,
-25440,
-25668,
-26077,
-26717,
-27423,
-28007,
-28338,
-28446,
-28482,
-28545,
-28642,
-28642,
-28445,
-28066,
-27671,
-27459,
-27532,
-27850,
-28302,
-28766,
-29194,
-29601,
-30045,
-30583,
-31210,
-31822,
-32280,
-32498,
-32512,
-32491,
-32597,
-32881,
-33260,
-33514,
-33556,
-33412,
-33300,
-33401,
-33719,
-34078,
-34253,
-34230,
-34175,
-34366,
-34872,
-35596,
-36263,
-36741,
-37064,
-37409,
-37900,
-38505,
-39033,
-39337,
-39413,
-39402,
-39471,
-39667,
-39927,
-40168,
-40371,
-40591,
-40829,
-41082,
-41259,
-41369,
-41423,
-41477,
-41490,
-41423,
-41219,
-40955,
-40757,
-40745,
-40897,
-41093,
-41192,
-41209,
-41283,
-41571,
-42071,
-42622,
-43033,
-43266,
-43445,
-43772,
-44292,
-44913,
-45399,
-45644,
-45647,
-45557,
-45472,
-45384,
-45194,
-44831,
-44310,
-43749,
-43252,
-42874,
-42622,
-42491,
-42495,
-42608,
-42787,
-42941,
-43069,
-43179,
-43331,
-43501,
-43596,
-43529,
-43280,
-42960,
-42699,
-42573,
-42485,
-42309,
-41943,
-41474,
-41050,
-40799,
-40671,
-40534,
-40271,
-39920,
-39622,
-39514,
-39607,
-39794,
-39935,
-39972,
-39923,
-39879,
-39851,
-39810,
-39676,
-39392,
-38988,
-38531,
-38081,
-37696,
-37359,
-37074,
-36783,
-36467,
-36103,
-35741,
-35427,
-35176,
-34917,
-34529,
-33958,
-33248,
-32553,
-32011,
-31624,
-31300,
-30883,
-30351,
-29824,
-29486,
-29420,
-29544,
-29638,
-29587,
-29426,
-29319,
-29396,
-29603,
-29791,
-29792,
-29603,
-29305,
-29050,
-28849,
-28645,
-28291,
-27762,
-27112,
-26480,
-25934,
-25452,
-25000,
-24547,
-24148,
-23830,
-23608,
-23453,
-23351,
-23300,
-23301,
-23331,
-23343,
-23260,
-23077,
-22809,
-22553,
-22328,
-22107,
-21807,
-21407,
-20991,
-20674,
-20509,
-20459,
-20416,
-20333,
-20230,
-20204,
-20331,
-20589,
-20885,
-21074,
-21142,
-21155,
-21231,
-21415,
-21635,
-21781,
-21792,
-21671,
-21506,
-21389,
-21369,
-21434,
-21506,
-21510,
-21465,
-21416,
-21468,
-21617,
-21843,
-22041,
-22125,
-22056,
-21892,
-21764,
-21769,
-21871,
-21958,
-21905,
-21761,
-21657,
-21757,
-22110,
-22623,
-23131,
-23486,
-23731,
-24006,
-24487,
-25179,
-25910,
-26497,
-26866,
-27099,
-27352,
-27683,
-28087,
-28438,
-28620,
-28601,
-28456,
-28345,
-28368,
-28517,
-28721,
-28898,
-29046,
-29200,
-29428,
-29808,
-30341,
-30960,
-31499,
-31866,
-32082,
-32287,
-32597,
-33018,
-33456,
-33759,
-33875,
-33835,
-33813,
-33945,
-34249,
-34601,
-34850,
-34976,
-35107,
-35379,
-35841,
-36424,
-37020,
-37542,
-37982,
-38360,
-38742,
-39129,
-39487,
-39766,
-39947,
-40085,
-40187,
-40293,
-40399,
-40575,
-40818,
-41116,
-41363,
-41510,
-41590,
-41663,
-41811,
-42023,
-42243,
-42372,
-42370,
-42299,
-42272,
-42389,
-42592,
-42769,
-42804,
-42729,
-42624,
-42609,
-42706,
-42895,
-43095,
-43263,
-43415,
-43618,
-43935,
-44340,
-44737,
-45043,
-45221,
-45292,
-45310,
-45297,
-45290,
-45248,
-45135,
-44926,
-44648,
-44397,
-44220,
-44105,
-43998,
-43843,
-43639,
-43416,
-43240,
-43167,
-43193,
-43261,
-43287,
-43262,
-43220,
-43202,
-43198,
-43121,
-42956,
-42668,
-42314,
-41938,
-41570,
-41274,
-41004,
-40778,
-40553,
-40374,
-40247,
-40181,
-40119,
-40064,
-39973,
-39862,
-39694,
-39486,
-39279,
-39114,
-39004,
-38894,
-38756,
-38544,
-38292,
-37998,
-37695,
-37382,
-37043,
-36663,
-36241,
-35826,
-35476,
-35212,
-35005,
-34807,
-34583,
-34348,
-34098,
-33826,
-33512,
-33140,
-32716,
-32272,
-31834,
-31440,
-31107,
-30832,
-30619,
-30443,
-30310,
-30209,
-30107,
-29975,
-29807,
-29614,
-29441,
-29276,
-29109,
-28920,
-28719,
-28524,
-28336,
-28156,
-27974,
-27770,
-27517,
-27176,
-26791,
-26389,
-26036,
-25721,
-25433,
-25182,
-24982,
-24831,
-24717,
-24630,
-24566,
-24507,
-24418,
-24290,
-24151,
-24030,
-23889,
-23708,
-23492,
-23293,
-23161,
-23050,
-22942,
-22801,
-22648,
-22505,
-22397,
-22356,
-22375,
-22389,
-22337,
-22242,
-22216,
-22317,
-22506,
-22647,
-22669,
-22589,
-22473,
-22404,
-22418,
-22496,
-22554,
-22498,
-22333,
-22198,
-22194,
-22330,
-22497,
-22602,
-22637,
-22630,
-22611,
-22628,
-22708,
-22846,
-22970,
-23017,
-23028,
-23051,
-23138,
-23267,
-23435,
-23644,
-23856,
-24012,
-24084,
-24168,
-24343,
-24620,
-24925,
-25180,
-25376,
-25524,
-25656,
-25845,
-26158,
-26560,
-26932,
-27133,
-27223,
-27291,
-27443,
-27661,
-27898,
-28114,
-28239,
-28247,
-28177,
-28185,
-28363,
-28664,
-28950,
-29160,
-29334,
-29540,
-29805,
-30153,
-30606,
-31094,
-31491,
-31713,
-31849,
-32039,
-32329,
-32636,
-32893,
-33106,
-33283,
-33420,
-33549,
-33770,
-34147,
-34567,
-34894,
-35082,
-35235,
-35422,
-35634,
-35853,
-36120,
-36439,
-36691,
-36836,
-36935,
-37157,
-37526,
-37889,
-38167,
-38351,
-38482,
-38539,
-38529,
-38560,
-38722,
-38928,
-39040,
-39054,
-39143,
-39397,
-39760,
-40087,
-40376,
-40631,
-40808,
-40860,
-40872,
-40986,
-41185,
-41314,
-41302,
-41280,
-41405,
-41628,
-41836,
-41989,
-42171,
-42348,
-42432,
-42409,
-42414,
-42518,
-42641,
-42685,
-42734,
-42888,
-43110,
-43224,
-43212,
-43201,
-43249,
-43230,
-42989,
-42623,
-42289,
-42055,
-41867,
-41732,
-41731,
-41832,
-41895,
-41893,
-41977,
-42253,
-42546,
-42592,
-42374,
-42104,
-41944,
-41871,
-41790,
-41746,
-41734,
-41660,
-41475,
-41289,
-41263,
-41334,
-41243,
-40890,
-40455,
-40114,
-39885,
-39678,
-39514,
-39497,
-39544,
-39519,
-39390,
-39303,
-39324,
-39308,
-39089,
-38694,
-38280,
-37864,
-37427,
-37024,
-36807,
-36795,
-36774,
-36602,
-36355,
-36218,
-36188,
-36124,
-35942,
-35706,
-35433,
-35084,
-34670,
-34366,
-34280,
-34312,
-34226,
-33981,
-33667,
-33404,
-33123,
-32799,
-32483,
-32208,
-31912,
-31507,
-31111,
-30932,
-31015,
-31202,
-31291,
-31259,
-31151,
-30976,
-30721,
-30429,
-30167,
-29890,
-29451,
-28849,
-28254,
-27865,
-27697,
-27626,
-27546,
-27453,
-27324,
-27140,
-26927,
-26806,
-26818,
-26863,
-26794,
-26599,
-26407,
-26297,
-26250,
-26216,
-26193,
-26175,
-26082,
-25806,
-25413,
-25068,
-24881,
-24827,
-24735,
-24557,
-24311,
-24060,
-23901,
-23903,
-24081,
-24280,
-24269,
-23980,
-23617,
-23445,
-23542,
-23687,
-23696,
-23513,
-23283,
-23100,
-23032,
-23097,
-23270,
-23416,
-23408,
-23276,
-23196,
-23317,
-23546,
-23766,
-23896,
-24010,
-24092,
-24088,
-24021,
-24021,
-24128,
-24217,
-24097,
-23843,
-23646,
-23634,
-23716,
-23821,
-23952,
-24132,
-24286,
-24361,
-24489,
-24803,
-25246,
-25568,
-25664,
-25693,
-25795,
-25966,
-26063,
-26125,
-26217,
-26304,
-26242,
-26072,
-26030,
-26225,
-26514,
-26668,
-26746,
-26941,
-27293,
-27674,
-28023,
-28443,
-28936,
-29313,
-29449,
-29515,
-29767,
-30174,
-30481,
-30566,
-30589,
-30690,
-30814,
-30887,
-31009,
-31270,
-31526,
-31540,
-31400,
-31392,
-31694,
-32054,
-32254,
-32376,
-32613,
-32972,
-33247,
-33435,
-33712,
-34118,
-34435,
-34508,
-34489,
-34622,
-34885,
-35112,
-35310,
-35630,
-36061,
-36381,
-36506,
-36708,
-37184,
-37761,
-38074,
-38064,
-38025,
-38126,
-38273,
-38330,
-38401,
-38572,
-38720,
-38633,
-38440,
-38411,
-38633,
-38845,
-38850,
-38774,
-38795,
-38903,
-38999,
-39163,
-39573,
-40080,
-40392,
-40383,
-40363,
-40614,
-40973,
-41126,
-40964,
-40742,
-40613,
-40533,
-40431,
-40444,
-40635,
-40857,
-40937,
-40942,
-41104,
-41424,
-41669,
-41737,
-41783,
-41940,
-42084,
-42028,
-41868,
-41857,
-42029,
-42111,
-41941,
-41651,
-41440,
-41272,
-40971,
-40564,
-40222,
-39993,
-39731,
-39375,
-39095,
-39056,
-39171,
-39235,
-39227,
-39268,
-39378,
-39411,
-39326,
-39293,
-39428,
-39570,
-39499,
-39267,
-39168,
-39304,
-39485,
-39484,
-39345,
-39226,
-39136,
-38948,
-38674,
-38461,
-38338,
-38168,
-37836,
-37489,
-37308,
-37235,
-37086,
-36794,
-36481,
-36203,
-35829,
-35323,
-34846,
-34568,
-34389,
-34062,
-33602,
-33285,
-33294,
-33457,
-33513,
-33417,
-33324,
-33277,
-33176,
-33004,
-32894,
-32858,
-32754,
-32462,
-32168,
-32075,
-32177,
-32202,
-32066,
-31907,
-31828,
-31728,
-31492,
-31241,
-31165,
-31190,
-31060,
-30737,
-30470,
-30450,
-30555,
-30514,
-30297,
-30044,
-29758,
-29360,
-28855,
-28459,
-28221,
-27932,
-27429,
-26856,
-26545,
-26503,
-26501,
-26364,
-26199,
-26130,
-26077,
-25979,
-25962,
-26168,
-26489,
-26633,
-26632,
-26745,
-27175,
-27668,
-27930,
-27943,
-27937,
-27969,
-27896,
-27670,
-27431,
-27293,
-27122,
-26828,
-26533,
-26446,
-26480,
-26405,
-26169,
-25982,
-25930,
-25836,
-25541,
-25195,
-25059,
-25105,
-25085,
-24950,
-24916,
-25135,
-25424,
-25562,
-25596,
-25707,
-25883,
-25937,
-25833,
-25795,
-25936,
-26144,
-26260,
-26366,
-26636,
-26984,
-27244,
-27392,
-27623,
-27958,
-28148,
-28045,
-27879,
-27961,
-28273,
-28491,
-28487,
-28461,
-28617,
-28853,
-28977,
-28992,
-29007,
-29003,
-28824,
-28507,
-28294,
-28296,
-28378,
-28362,
-28323,
-28407,
-28572,
-28660,
-28711,
-28918,
-29273,
-29470,
-29313,
-29077,
-29209,
-29769,
-30391,
-30761,
-30962,
-31264,
-31762,
-32358,
-32964,
-33489,
-33801,
-33808,
-33695,
-33782,
-34141,
-34474,
-34498,
-34308,
-34202,
-34264,
-34291,
-34188,
-34077,
-34075,
-34019,
-33739,
-33344,
-33191,
-33395,
-33744,
-33964,
-34059,
-34156,
-34354,
-34627,
-35026,
-35514,
-35920,
-36017,
-35892,
-35896,
-36293,
-36845,
-37208,
-37242,
-37212,
-37306,
-37503,
-37678,
-37842,
-38035,
-38151,
-38108,
-38005,
-38118,
-38495,
-38912,
-39122,
-39174,
-39220,
-39330,
-39402,
-39388,
-39380,
-39346,
-39187,
-38861,
-38548,
-38427,
-38452,
-38405,
-38208,
-38002,
-37896,
-37854,
-37776,
-37732,
-37782,
-37901,
-37933,
-37911,
-38003,
-38295,
-38642,
-38840,
-38918,
-39035,
-39270,
-39487,
-39586,
-39584,
-39617,
-39703,
-39809,
-39897,
-39938,
-39885,
-39704,
-39492,
-39382,
-39350,
-39206,
-38806,
-38289,
-37920,
-37795,
-37745,
-37561,
-37252,
-36943,
-36723,
-36552,
-36382,
-36215,
-36085,
-35952,
-35810,
-35662,
-35578,
-35609,
-35782,
-36041,
-36269,
-36301,
-36121,
-35895,
-35858,
-36036,
-36166,
-35991,
-35513,
-35062,
-34920,
-35091,
-35291,
-35257,
-34969,
-34609,
-34381,
-34309,
-34288,
-34173,
-33949,
-33691,
-33490,
-33334,
-33223,
-33155,
-33155,
-33164,
-33027,
-32651,
-32098,
-31582,
-31273,
-31139,
-30998,
-30653,
-30155,
-29724,
-29612,
-29840,
-30163,
-30280,
-30129,
-29851,
-29706,
-29746,
-29895,
-30033,
-30109,
-30114,
-30087,
-30060,
-30159,
-30392,
-30665,
-30783,
-30595,
-30170,
-29663,
-29290,
-29116,
-29062,
-28941,
-28601,
-28129,
-27773,
-27746,
-27970,
-28168,
-28101,
-27788,
-27403,
-27108,
-26967,
-26985,
-27113,
-27213,
-27154,
-26951,
-26834,
-27002,
-27419,
-27778,
-27836,
-27569,
-27226,
-27048,
-27159,
-27463,
-27731,
-27801,
-27663,
-27579,
-27737,
-28135,
-28496,
-28589,
-28403,
-28119,
-27883,
-27759,
-27736,
-27825,
-27960,
-28015,
-27940,
-27851,
-27924,
-28218,
-28540,
-28654,
-28458,
-28077,
-27749,
-27687,
-27887,
-28174,
-28263,
-28112,
-27925,
-28032,
-28466,
-28947,
-29110,
-28922,
-28641,
-28570,
-28730,
-28974,
-29161,
-29298,
-29484,
-29770,
-30166,
-30605,
-31007,
-31290,
-31440,
-31479,
-31463,
-31401,
-31316,
-31229,
-31174,
-31130,
-31094,
-31074,
-31147,
-31287,
-31415,
-31420,
-31321,
-31225,
-31221,
-31301,
-31406,
-31487,
-31579,
-31709,
-31942,
-32288,
-32736,
-33147,
-33386,
-33375,
-33252,
-33196,
-33321,
-33518,
-33588,
-33449,
-33200,
-33106,
-33330,
-33801,
-34262,
-34449,
-34341,
-34145,
-34127,
-34340,
-34623,
-34728,
-34581,
-34343,
-34244,
-34409,
-34729,
-35023,
-35165,
-35172,
-35128,
-35075,
-35023,
-35006,
-35043,
-35131,
-35135,
-34995,
-34780,
-34762,
-35094,
-35638,
-36012,
-35940,
-35569,
-35320,
-35510,
-35969,
-36221,
-35960,
-35366,
-34986,
-35160,
-35702,
-36108,
-36052,
-35726,
-35553,
-35760,
-36125,
-36304,
-36165,
-35926,
-35811,
-35863,
-35880,
-35775,
-35639,
-35660,
-35879,
-36060,
-35989,
-35661,
-35376,
-35442,
-35828,
-36146,
-36033,
-35522,
-35107,
-35223,
-35815,
-36361,
-36396,
-35979,
-35607,
-35704,
-36149,
-36489,
-36338,
-35815,
-35331,
-35200,
-35326,
-35383,
-35153,
-34787,
-34573,
-34659,
-34875,
-34974,
-34890,
-34785,
-34813,
-34931,
-34994,
-34940,
-34867,
-34889,
-34981,
-35039,
-35025,
-35022,
-35129,
-35331,
-35484,
-35464,
-35243,
-34941,
-34726,
-34677,
-34737,
-34714,
-34484,
-34117,
-33856,
-33908,
-34254,
-34628,
-34754,
-34532,
-34126,
-33809,
-33744,
-33878,
-33992,
-33881,
-33532,
-33139,
-32963,
-33142,
-33597,
-34054,
-34234,
-34022,
-33581,
-33234,
-33261,
-33584,
-33893,
-33816,
-33384,
-32903,
-32822,
-33243,
-33889,
-34331,
-34256,
-33767,
-33187,
-32891,
-32981,
-33216,
-33255,
-32886,
-32299,
-31890,
-31977,
-32484,
-33040,
-33239,
-32987,
-32496,
-32077,
-31904,
-31934,
-32017,
-31998,
-31797,
-31434,
-31102,
-31091,
-31578,
-32377,
-32942,
-32814,
-32028,
-31232,
-31088,
-31695,
-32433,
-32529,
-31805,
-30881,
-30612,
-31334,
-32504,
-33197,
-32869,
-31828,
-30868,
-30626,
-31021,
-31443,
-31320,
-30595,
-29764,
-29383,
-29696,
-30413,
-31026,
-31160,
-30790,
-30221,
-29803,
-29754,
-30018,
-30344,
-30425,
-30137,
-29658,
-29446,
-29817,
-30693,
-31459,
-31523,
-30825,
-29956,
-29650,
-30067,
-30662,
-30729,
-30103,
-29326,
-29126,
-29714,
-30624,
-31137,
-30915,
-30238,
-29674,
-29582,
-29865,
-30109,
-29978,
-29494,
-28970,
-28798,
-29119,
-29751,
-30296,
-30404,
-30064,
-29551,
-29296,
-29453,
-29851,
-30092,
-29956,
-29560,
-29298,
-29477,
-30116,
-30876,
-31332,
-31265,
-30798,
-30341,
-30264,
-30583,
-30972,
-31019,
-30643,
-30180,
-30064,
-30479,
-31154,
-31653,
-31698,
-31353,
-30936,
-30748,
-30870,
-31156,
-31311,
-31212,
-30937,
-30789,
-31010,
-31541,
-32102,
-32342,
-32211,
-31923,
-31799,
-31920,
-32157,
-32261,
-32206,
-32144,
-32261,
-32563,
-32902,
-33144,
-33293,
-33423,
-33515,
-33485,
-33302,
-33091,
-33032,
-33172,
-33353,
-33427,
-33380,
-33392,
-33590,
-33939,
-34226,
-34295,
-34131,
-33922,
-33844,
-33998,
-34253,
-34460,
-34500,
-34478,
-34582,
-34933,
-35400,
-35702,
-35661,
-35374,
-35129,
-35150,
-35352,
-35510,
-35436,
-35223,
-35100,
-35247,
-35587,
-35922,
-36049,
-35957,
-35743,
-35559,
-35480,
-35514,
-35616,
-35716,
-35715,
-35630,
-35511,
-35563,
-35830,
-36233,
-36506,
-36462,
-36125,
-35743,
-35592,
-35795,
-36199,
-36530,
-36531,
-36231,
-35917,
-35979,
-36504,
-37183,
-37459,
-37100,
-36347,
-35812,
-35860,
-36367,
-36821,
-36789,
-36270,
-35649,
-35368,
-35584,
-36070,
-36396,
-36258,
-35659,
-34957,
-34561,
-34704,
-35214,
-35647,
-35624,
-35113,
-34546,
-34401,
-34870,
-35576,
-35968,
-35715,
-35035,
-34480,
-34458,
-34974,
-35587,
-35826,
-35525,
-34919,
-34505,
-34580,
-35052,
-35488,
-35453,
-34910,
-34198,
-33765,
-33808,
-34138,
-34384,
-34267,
-33810,
-33257,
-32896,
-32891,
-33113,
-33327,
-33236,
-32805,
-32248,
-31923,
-32043,
-32474,
-32832,
-32801,
-32409,
-32003,
-31909,
-32160,
-32493,
-32606,
-32430,
-32128,
-31933,
-31936,
-32083,
-32223,
-32267,
-32186,
-32041,
-31880,
-31738,
-31639,
-31555,
-31524,
-31482,
-31418,
-31244,
-30997,
-30761,
-30660,
-30719,
-30801,
-30701,
-30344,
-29860,
-29539,
-29537,
-29733,
-29847,
-29670,
-29340,
-29107,
-29177,
-29439,
-29666,
-29681,
-29548,
-29408,
-29406,
-29522,
-29711,
-29885,
-30015,
-30071,
-30067,
-30048,
-30065,
-30152,
-30230,
-30226,
-30049,
-29760,
-29481,
-29337,
-29343,
-29384,
-29311,
-29088,
-28826,
-28678,
-28725,
-28836,
-28841,
-28651,
-28370,
-28221,
-28302,
-28534,
-28711,
-28739,
-28698,
-28778,
-29001,
-29269,
-29389,
-29368,
-29324,
-29403,
-29565,
-29665,
-29624,
-29516,
-29508,
-29670,
-29888,
-30002,
-29957,
-29841,
-29774,
-29804,
-29869,
-29912,
-29894,
-29845,
-29787,
-29763,
-29813,
-29964,
-30192,
-30399,
-30474,
-30387,
-30213,
-30117,
-30220,
-30481,
-30725,
-30748,
-30517,
-30225,
-30153,
-30440,
-30934,
-31286,
-31245,
-30880,
-30537,
-30584,
-31050,
-31648,
-31974,
-31880,
-31597,
-31502,
-31839,
-32474,
-33082,
-33338,
-33217,
-32921,
-32756,
-32886,
-33254,
-33612,
-33734,
-33549,
-33212,
-32967,
-32986,
-33225,
-33499,
-33578,
-33378,
-33005,
-32702,
-32686,
-33008,
-33471,
-33787,
-33787,
-33575,
-33486,
-33790,
-34434,
-35076,
-35340,
-35189,
-34918,
-34932,
-35323,
-35870,
-36197,
-36163,
-35932,
-35789,
-35904,
-36173,
-36368,
-36341,
-36113,
-35844,
-35683,
-35671,
-35778,
-35914,
-36016,
-36039,
-35986,
-35931,
-35980,
-36186,
-36503,
-36772,
-36853,
-36737,
-36581,
-36586,
-36845,
-37240,
-37523,
-37505,
-37243,
-36968,
-36956,
-37185,
-37460,
-37478,
-37180,
-36743,
-36442,
-36445,
-36681,
-36976,
-37123,
-37066,
-36882,
-36739,
-36787,
-37030,
-37363,
-37592,
-37622,
-37475,
-37337,
-37348,
-37585,
-37882,
-38072,
-37998,
-37715,
-37406,
-37203,
-37162,
-37127,
-36998,
-36674,
-36265,
-35871,
-35644,
-35578,
-35611,
-35615,
-35544,
-35425,
-35318,
-35252,
-35220,
-35228,
-35303,
-35459,
-35643,
-35762,
-35775,
-35741,
-35766,
-35890,
-36042,
-36090,
-35954,
-35686,
-35378,
-35151,
-34986,
-34842,
-34635,
-34384,
-34093,
-33826,
-33578,
-33393,
-33280,
-33240,
-33209,
-33070,
-32787,
-32447,
-32222,
-32252,
-32485,
-32740,
-32789,
-32579,
-32239,
-32019,
-32052,
-32253,
-32365,
-32182,
-31732,
-31239,
-30952,
-30945,
-31039,
-31042,
-30809,
-30423,
-30065,
-29901,
-29971,
-30155,
-30279,
-30207,
-29943,
-29655,
-29517,
-29671,
-30018,
-30362,
-30475,
-30313,
-30032,
-29861,
-29906,
-30057,
-30081,
-29853,
-29421,
-29006,
-28753,
-28674,
-28604,
-28382,
-27973,
-27518,
-27216,
-27157,
-27235,
-27264,
-27132,
-26914,
-26806,
-26920,
-27217,
-27530,
-27729,
-27842,
-27965,
-28224,
-28582,
-28932,
-29134,
-29141,
-29032,
-28923,
-28945,
-29087,
-29280,
-29354,
-29184,
-28769,
-28273,
-27956,
-27951,
-28167,
-28323,
-28166,
-27729,
-27260,
-27099,
-27334,
-27797,
-28144,
-28173,
-27943,
-27746,
-27865,
-28333,
-28927,
-29318,
-29351,
-29135,
-28947,
-29020,
-29398,
-29905,
-30307,
-30407,
-30205,
-29870,
-29677,
-29791,
-30199,
-30668,
-30920,
-30834,
-30561,
-30382,
-30541,
-30984,
-31457,
-31685,
-31626,
-31488,
-31489,
-31742,
-32082,
-32344,
-32414,
-32345,
-32254,
-32235,
-32285,
-32376,
-32458,
-32495,
-32476,
-32371,
-32213,
-32050,
-32010,
-32151,
-32458,
-32794,
-33007,
-33071,
-33075,
-33207,
-33538,
-34013,
-34477,
-34797,
-35005,
-35206,
-35498,
-35855,
-36156,
-36329,
-36377,
-36422,
-36509,
-36618,
-36656,
-36560,
-36354,
-36113,
-35902,
-35739,
-35610,
-35508,
-35435,
-35395,
-35391,
-35378,
-35374,
-35375,
-35438,
-35566,
-35750,
-35935,
-36131,
-36344,
-36639,
-36964,
-37273,
-37454,
-37506,
-37518,
-37613,
-37848,
-38136,
-38302,
-38244,
-37989,
-37714,
-37568,
-37590,
-37706,
-37794,
-37778,
-37654,
-37462,
-37276,
-37179,
-37190,
-37283,
-37341,
-37307,
-37168,
-37065,
-37082,
-37264,
-37465,
-37534,
-37390,
-37121,
-36921,
-36901,
-37020,
-37107,
-37013,
-36734,
-36403,
-36161,
-36086,
-36116,
-36154,
-36135,
-36077,
-36006,
-35981,
-35941,
-35884,
-35819,
-35806,
-35904,
-36081,
-36251,
-36326,
-36298,
-36208,
-36128,
-36082,
-36043,
-35996,
-35871,
-35677,
-35390,
-35070,
-34756,
-34499,
-34281,
-34054,
-33758,
-33413,
-33094,
-32898,
-32843,
-32842,
-32761,
-32529,
-32212,
-31975,
-31963,
-32178,
-32495,
-32717,
-32737,
-32579,
-32384,
-32299,
-32372,
-32508,
-32580,
-32476,
-32255,
-32002,
-31821,
-31715,
-31617,
-31456,
-31196,
-30899,
-30638,
-30495,
-30457,
-30443,
-30335,
-30100,
-29782,
-29542,
-29480,
-29600,
-29797,
-29889,
-29839,
-29657,
-29509,
-29448,
-29464,
-29447,
-29327,
-29136,
-28964,
-28889,
-28883,
-28849,
-28691,
-28414,
-28098,
-27911,
-27891,
-28000,
-28098,
-28078,
-27969,
-27869,
-27881,
-28029,
-28236,
-28435,
-28580,
-28698,
-28838,
-29009,
-29200,
-29339,
-29373,
-29303,
-29171,
-29086,
-29109,
-29221,
-29302,
-29208,
-28885,
-28438,
-28077,
-27965,
-28062,
-28178,
-28114,
-27839,
-27531,
-27422,
-27601,
-27970,
-28278,
-28374,
-28270,
-28203,
-28369,
-28846,
-29436,
-29873,
-29998,
-29876,
-29746,
-29863,
-30269,
-30826,
-31238,
-31314,
-31036,
-30659,
-30452,
-30613,
-31008,
-31373,
-31419,
-31125,
-30738,
-30564,
-30781,
-31215,
-31550,
-31541,
-31252,
-30976,
-30985,
-31321,
-31753,
-32029,
-32021,
-31867,
-31750,
-31838,
-32076,
-32360,
-32522,
-32534,
-32439,
-32342,
-32317,
-32393,
-32556,
-32775,
-33001,
-33194,
-33325,
-33425,
-33555,
-33747,
-34015,
-34289,
-34543,
-34760,
-34973,
-35206,
-35436,
-35616,
-35711,
-35745,
-35797,
-35889,
-36003,
-36021,
-35892,
-35638,
-35359,
-35146,
-35000,
-34889,
-34739,
-34586,
-34455,
-34415,
-34459,
-34531,
-34575,
-34568,
-34547,
-34608,
-34787,
-35106,
-35491,
-35890,
-36229,
-36489,
-36669,
-36803,
-36955,
-37175,
-37456,
-37738,
-37914,
-37931,
-37798,
-37619,
-37467,
-37388,
-37324,
-37246,
-37137,
-37016,
-36909,
-36769,
-36566,
-36320,
-36093,
-35954,
-35917,
-35906,
-35886,
-35854,
-35868,
-35955,
-36063,
-36108,
-36047,
-35936,
-35892,
-35986,
-36175,
-36346,
-36381,
-36290,
-36157,
-36074,
-36074,
-36115,
-36154,
-36185,
-36228,
-36273,
-36288,
-36215,
-36065,
-35918,
-35862,
-35948,
-36114,
-36250,
-36269,
-36148,
-35964,
-35774,
-35659,
-35595,
-35560,
-35481,
-35295,
-35006,
-34661,
-34357,
-34148,
-33978,
-33779,
-33469,
-33118,
-32816,
-32678,
-32683,
-32715,
-32664,
-32468,
-32232,
-32072,
-32113,
-32333,
-32664,
-32960,
-33124,
-33124,
-32990,
-32861,
-32823,
-32957,
-33165,
-33333,
-33325,
-33127,
-32830,
-32539,
-32332,
-32187,
-32009,
-31775,
-31454,
-31158,
-30920,
-30751,
-30583,
-30344,
-30035,
-29712,
-29476,
-29365,
-29384,
-29445,
-29485,
-29446,
-29334,
-29189,
-29067,
-28989,
-28991,
-29046,
-29160,
-29284,
-29373,
-29395,
-29325,
-29199,
-29074,
-29011,
-29062,
-29210,
-29378,
-29500,
-29496,
-29405,
-29292,
-29242,
-29313,
-29474,
-29649,
-29753,
-29747,
-29673,
-29622,
-29646,
-29714,
-29727,
-29620,
-29420,
-29242,
-29194,
-29260,
-29348,
-29287,
-29055,
-28710,
-28423,
-28295,
-28338,
-28457,
-28564,
-28608,
-28628,
-28662,
-28773,
-28951,
-29189,
-29440,
-29689,
-29962,
-30277,
-30645,
-31014,
-31319,
-31514,
-31663,
-31827,
-32115,
-32453,
-32742,
-32843,
-32732,
-32545,
-32427,
-32465,
-32572,
-32564,
-32363,
-31999,
-31689,
-31586,
-31702,
-31888,
-31901,
-31669,
-31271,
-30957,
-30911,
-31140,
-31474,
-31705,
-31726,
-31630,
-31603,
-31801,
-32216,
-32677,
-32990,
-33070,
-33026,
-33065,
-33320,
-33766,
-34221,
-34507,
-34591,
-34573,
-34607,
-34771,
-35011,
-35220,
-35305,
-35275,
-35192,
-35119,
-35056,
-34955,
-34787,
-34561,
-34339,
-34187,
-34120,
-34087,
-33999,
-33775,
-33420,
-33022,
-32714,
-32559,
-32524,
-32505,
-32433,
-32330,
-32288,
-32381,
-32599,
-32835,
-32968,
-32958,
-32904,
-32968,
-33281,
-33818,
-34392,
-34792,
-34904,
-34805,
-34714,
-34818,
-35170,
-35619,
-35925,
-35914,
-35626,
-35239,
-34991,
-34918,
-34902,
-34721,
-34283,
-33685,
-33187,
-32955,
-32976,
-33004,
-32779,
-32205,
-31487,
-30932,
-30793,
-31017,
-31365,
-31541,
-31462,
-31245,
-31144,
-31341,
-31781,
-32283,
-32605,
-32701,
-32727,
-32913,
-33391,
-34034,
-34575,
-34779,
-34651,
-34429,
-34405,
-34734,
-35251,
-35648,
-35634,
-35213,
-34646,
-34283,
-34274,
-34486,
-34575,
-34294,
-33658,
-32968,
-32571,
-32602,
-32855,
-32955,
-32644,
-32001,
-31391,
-31191,
-31494,
-32043,
-32419,
-32379,
-32022,
-31732,
-31871,
-32498,
-33331,
-33937,
-34093,
-33915,
-33788,
-34054,
-34743,
-35569,
-36140,
-36231,
-35981,
-35718,
-35754,
-36130,
-36597,
-36825,
-36655,
-36181,
-35720,
-35519,
-35591,
-35711,
-35590,
-35082,
-34354,
-33697,
-33402,
-33474,
-33703,
-33757,
-33472,
-32931,
-32407,
-32182,
-32325,
-32693,
-33011,
-33112,
-33023,
-32934,
-33063,
-33448,
-33963,
-34378,
-34557,
-34542,
-34517,
-34691,
-35099,
-35606,
-35969,
-36007,
-35729,
-35337,
-35085,
-35120,
-35365,
-35574,
-35505,
-35081,
-34464,
-33900,
-33576,
-33449,
-33347,
-33062,
-32576,
-32005,
-31567,
-31367,
-31355,
-31338,
-31159,
-30797,
-30387,
-30122,
-30095,
-30278,
-30500,
-30630,
-30604,
-30514,
-30499,
-30665,
-30978,
-31325,
-31542,
-31601,
-31538,
-31506,
-31583,
-31766,
-31976,
-32077,
-32051,
-31892,
-31721,
-31557,
-31435,
-31288,
-31109,
-30878,
-30649,
-30420,
-30211,
-29980,
-29709,
-29369,
-28990,
-28631,
-28380,
-28285,
-28328,
-28406,
-28399,
-28237,
-27964,
-27695,
-27580,
-27678,
-27943,
-28253,
-28512,
-28704,
-28875,
-29064,
-29254,
-29399,
-29462,
-29495,
-29586,
-29836,
-30247,
-30724,
-31092,
-31231,
-31091,
-30806,
-30529,
-30436,
-30595,
-30925,
-31274,
-31433,
-31327,
-30994,
-30610,
-30334,
-30240,
-30275,
-30339,
-30361,
-30351,
-30376,
-30453,
-30524,
-30502,
-30323,
-30083,
-29949,
-30071,
-30487,
-31057,
-31587,
-31905,
-31984,
-31912,
-31866,
-31979,
-32315,
-32826,
-33404,
-33946,
-34370,
-34635,
-34774,
-34809,
-34816,
-34853,
-34965,
-35181,
-35449,
-35697,
-35819,
-35775,
-35611,
-35401,
-35243,
-35124,
-35048,
-34965,
-34916,
-34916,
-34986,
-35056,
-35033,
-34864,
-34588,
-34366,
-34345,
-34588,
-34994,
-35386,
-35627,
-35676,
-35645,
-35656,
-35794,
-36061,
-36372,
-36633,
-36826,
-36962,
-37118,
-37311,
-37509,
-37648,
-37680,
-37623,
-37541,
-37519,
-37573,
-37661,
-37682,
-37585,
-37368,
-37143,
-36965,
-36890,
-36833,
-36742,
-36531,
-36261,
-35956,
-35743,
-35592,
-35483,
-35313,
-35064,
-34776,
-34568,
-34506,
-34574,
-34659,
-34640,
-34471,
-34246,
-34089,
-34116,
-34296,
-34501,
-34602,
-34557,
-34460,
-34467,
-34663,
-35015,
-35353,
-35495,
-35358,
-35033,
-34702,
-34547,
-34566,
-34635,
-34537,
-34188,
-33667,
-33183,
-32919,
-32885,
-32899,
-32741,
-32279,
-31621,
-30993,
-30625,
-30540,
-30591,
-30538,
-30281,
-29891,
-29597,
-29572,
-29840,
-30198,
-30428,
-30382,
-30152,
-29971,
-30028,
-30353,
-30755,
-30980,
-30911,
-30638,
-30388,
-30384,
-30599,
-30884,
-30984,
-30823,
-30505,
-30248,
-30196,
-30322,
-30437,
-30365,
-30059,
-29664,
-29381,
-29345,
-29489,
-29613,
-29528,
-29199,
-28801,
-28576,
-28668,
-28995,
-29325,
-29416,
-29212,
-28851,
-28566,
-28514,
-28665,
-28850,
-28916,
-28845,
-28784,
-28918,
-29323,
-29888,
-30392,
-30627,
-30572,
-30400,
-30365,
-30645,
-31173,
-31741,
-32077,
-32115,
-31945,
-31799,
-31847,
-32086,
-32380,
-32542,
-32474,
-32256,
-32036,
-31981,
-32083,
-32252,
-32278,
-32089,
-31713,
-31349,
-31223,
-31419,
-31833,
-32212,
-32345,
-32230,
-32091,
-32191,
-32640,
-33282,
-33816,
-34012,
-33894,
-33692,
-33686,
-33963,
-34384,
-34721,
-34828,
-34766,
-34750,
-34928,
-35348,
-35817,
-36121,
-36093,
-35792,
-35416,
-35252,
-35383,
-35737,
-36032,
-36098,
-35922,
-35726,
-35737,
-36024,
-36420,
-36635,
-36528,
-36151,
-35802,
-35669,
-35800,
-35976,
-35956,
-35647,
-35150,
-34727,
-34561,
-34675,
-34905,
-35043,
-34963,
-34741,
-34558,
-34600,
-34883,
-35267,
-35524,
-35530,
-35335,
-35143,
-35153,
-35410,
-35784,
-36069,
-36154,
-36082,
-36037,
-36111,
-36305,
-36436,
-36365,
-35988,
-35409,
-34776,
-34274,
-33980,
-33856,
-33802,
-33678,
-33451,
-33150,
-32871,
-32699,
-32595,
-32497,
-32281,
-31957,
-31601,
-31356,
-31286,
-31364,
-31452,
-31464,
-31338,
-31170,
-31041,
-31047,
-31182,
-31346,
-31426,
-31321,
-31057,
-30746,
-30530,
-30485,
-30571,
-30668,
-30706,
-30672,
-30678,
-30789,
-30990,
-31155,
-31153,
-30929,
-30596,
-30298,
-30157,
-30160,
-30204,
-30147,
-29956,
-29641,
-29334,
-29098,
-28951,
-28819,
-28601,
-28248,
-27805,
-27386,
-27120,
-27021,
-27062,
-27108,
-27160,
-27230,
-27450,
-27843,
-28366,
-28847,
-29166,
-29297,
-29321,
-29382,
-29548,
-29831,
-30174,
-30509,
-30795,
-31016,
-31188,
-31339,
-31464,
-31558,
-31557,
-31422,
-31131,
-30743,
-30352,
-30042,
-29850,
-29748,
-29709,
-29745,
-29881,
-30169,
-30577,
-31052,
-31456,
-31700,
-31714,
-31516,
-31243,
-31030,
-31060,
-31359,
-31883,
-32482,
-33048,
-33535,
-33967,
-34376,
-34684,
-34812,
-34660,
-34319,
-33959,
-33818,
-34012,
-34478,
-35065,
-35558,
-35897,
-36085,
-36211,
-36339,
-36448,
-36478,
-36363,
-36137,
-35911,
-35852,
-36045,
-36453,
-36881,
-37122,
-37057,
-36738,
-36335,
-35995,
-35750,
-35543,
-35309,
-35121,
-35116,
-35464,
-36146,
-37022,
-37790,
-38234,
-38269,
-37998,
-37632,
-37350,
-37234,
-37279,
-37432,
-37701,
-38131,
-38764,
-39537,
-40247,
-40624,
-40473,
-39784,
-38768,
-37698,
-36790,
-36095,
-35573,
-35149,
-34872,
-34795,
-34993,
-35394,
-35842,
-36124,
-36085,
-35720,
-35141,
-34535,
-34057,
-33764,
-33648,
-33647,
-33752,
-34012,
-34471,
-35140,
-35856,
-36413,
-36609,
-36410,
-35951,
-35421,
-34983,
-34635,
-34306,
-33904,
-33433,
-32969,
-32665,
-32586,
-32723,
-32969,
-33166,
-33223,
-33104,
-32850,
-32520,
-32089,
-31530,
-30749,
-29841,
-28964,
-28417,
-28369,
-28795,
-29462,
-30041,
-30310,
-30213,
-29841,
-29325,
-28746,
-28137,
-27520,
-26976,
-26654,
-26697,
-27165,
-27967,
-28889,
-29655,
-30087,
-30148,
-29967,
-29745,
-29584,
-29493,
-29370,
-29176,
-28986,
-28960,
-29204,
-29655,
-30092,
-30242,
-29970,
-29307,
-28459,
-27625,
-26945,
-26434,
-26073,
-25839,
-25791,
-25958,
-26365,
-26893,
-27372,
-27586,
-27449,
-27030,
-26576,
-26320,
-26426,
-26844,
-27427,
-28058,
-28688,
-29375,
-30111,
-30819,
-31309,
-31458,
-31240,
-30820,
-30397,
-30161,
-30138,
-30275,
-30463,
-30644,
-30811,
-31024,
-31285,
-31583,
-31801,
-31856,
-31713,
-31475,
-31285,
-31264,
-31394,
-31562,
-31622,
-31535,
-31360,
-31234,
-31245,
-31393,
-31621,
-31876,
-32151,
-32467,
-32843,
-33212,
-33520,
-33646,
-33559,
-33261,
-32848,
-32480,
-32342,
-32569,
-33177,
-34088,
-35140,
-36197,
-37151,
-37928,
-38429,
-38559,
-38268,
-37597,
-36722,
-35870,
-35257,
-35037,
-35224,
-35758,
-36475,
-37184,
-37723,
-37965,
-37895,
-37533,
-36921,
-36114,
-35204,
-34341,
-33768,
-33648,
-34042,
-34823,
-35759,
-36651,
-37354,
-37869,
-38187,
-38333,
-38275,
-38055,
-37728,
-37413,
-37227,
-37209,
-37377,
-37621,
-37848,
-37943,
-37853,
-37647,
-37404,
-37248,
-37183,
-37157,
-37098,
-36975,
-36840,
-36717,
-36617,
-36439,
-36132,
-35688,
-35232,
-34916,
-34845,
-35027,
-35381,
-35804,
-36234,
-36604,
-36871,
-36970,
-36822,
-36404,
-35725,
-34880,
-34017,
-33310,
-32922,
-32946,
-33378,
-34110,
-35000,
-35864,
-36588,
-37033,
-37138,
-36830,
-36148,
-35201,
-34183,
-33326,
-32783,
-32634,
-32858,
-33351,
-33976,
-34580,
-35007,
-35161,
-34987,
-34499,
-33733,
-32759,
-31642,
-30497,
-29477,
-28727,
-28368,
-28405,
-28764,
-29307,
-29912,
-30510,
-31058,
-31529,
-31838,
-31906,
-31661,
-31129,
-30441,
-29760,
-29248,
-28943,
-28806,
-28776,
-28793,
-28890,
-29078,
-29356,
-29630,
-29767,
-29642,
-29202,
-28496,
-27626,
-26730,
-25895,
-25186,
-24627,
-24271,
-24190,
-24469,
-25129,
-26093,
-27182,
-28188,
-28957,
-29419,
-29617,
-29574,
-29340,
-28917,
-28356,
-27794,
-27384,
-27311,
-27637,
-28332,
-29310,
-30401,
-31484,
-32402,
-33019,
-33267,
-33075,
-32541,
-31741,
-30870,
-30104,
-29626,
-29593,
-30035,
-30899,
-31985,
-33069,
-33952,
-34491,
-34649,
-34406,
-33808,
-32936,
-31939,
-30977,
-30211,
-29726,
-29548,
-29640,
-29921,
-30297,
-30650,
-30903,
-31033,
-31077,
-31093,
-31104,
-31092,
-31022,
-30936,
-30916,
-31070,
-31399,
-31782,
-32056,
-32097,
-31938,
-31743,
-31648,
-31737,
-31939,
-32129,
-32255,
-32286,
-32291,
-32234,
-32035,
-31542,
-30681,
-29529,
-28357,
-27521,
-27306,
-27804,
-28866,
-30225,
-31616,
-32893,
-34023,
-34948,
-35569,
-35713,
-35324,
-34571,
-33809,
-33466,
-33779,
-34703,
-35973,
-37314,
-38540,
-39675,
-40689,
-41516,
-41930,
-41735,
-40897,
-39643,
-38360,
-37444,
-37097,
-37278,
-37807,
-38483,
-39202,
-39951,
-40704,
-41342,
-41665,
-41504,
-40850,
-39926,
-39071,
-38579,
-38525,
-38723,
-38886,
-38791,
-38416,
-37937,
-37505,
-37206,
-36926,
-36542,
-36034,
-35525,
-35253,
-35319,
-35637,
-35916,
-35882,
-35416,
-34667,
-33911,
-33396,
-33184,
-33159,
-33148,
-33077,
-33032,
-33191,
-33639,
-34282,
-34836,
-34982,
-34589,
-33731,
-32719,
-31799,
-31132,
-30630,
-30202,
-29816,
-29626,
-29830,
-30511,
-31482,
-32386,
-32852,
-32767,
-32294,
-31768,
-31488,
-31531,
-31810,
-32146,
-32472,
-32799,
-33232,
-33760,
-34285,
-34590,
-34503,
-33996,
-33225,
-32479,
-31989,
-31858,
-31935,
-32006,
-31886,
-31595,
-31307,
-31189,
-31256,
-31327,
-31170,
-30677,
-29999,
-29452,
-29321,
-29688,
-30377,
-31125,
-31753,
-32252,
-32746,
-33275,
-33769,
-33967,
-33682,
-32887,
-31824,
-30892,
-30395,
-30419,
-30758,
-31082,
-31173,
-31019,
-30782,
-30607,
-30470,
-30174,
-29555,
-28608,
-27611,
-26900,
-26669,
-26855,
-27173,
-27373,
-27402,
-27384,
-27515,
-27822,
-28183,
-28358,
-28248,
-27891,
-27517,
-27340,
-27479,
-27876,
-28386,
-28853,
-29210,
-29469,
-29677,
-29835,
-29917,
-29841,
-29622,
-29359,
-29229,
-29403,
-29909,
-30632,
-31349,
-31853,
-32056,
-31982,
-31723,
-31358,
-30927,
-30459,
-29997,
-29641,
-29457,
-29491,
-29680,
-29937,
-30139,
-30226,
-30168,
-30006,
-29801,
-29630,
-29567,
-29635,
-29882,
-30285,
-30884,
-31657,
-32582,
-33553,
-34456,
-35165,
-35638,
-35889,
-36013,
-36080,
-36184,
-36365,
-36688,
-37184,
-37845,
-38584,
-39243,
-39642,
-39657,
-39259,
-38494,
-37479,
-36315,
-35146,
-34128,
-33400,
-33099,
-33219,
-33677,
-34291,
-34896,
-35349,
-35594,
-35587,
-35311,
-34784,
-34073,
-33317,
-32678,
-32288,
-32251,
-32562,
-33206,
-34098,
-35140,
-36187,
-37097,
-37722,
-37979,
-37852,
-37388,
-36710,
-35951,
-35270,
-34789,
-34591,
-34706,
-35100,
-35684,
-36333,
-36874,
-37195,
-37191,
-36886,
-36343,
-35670,
-34962,
-34277,
-33670,
-33225,
-33024,
-33109,
-33442,
-33874,
-34261,
-34498,
-34603,
-34641,
-34664,
-34656,
-34602,
-34521,
-34526,
-34739,
-35203,
-35838,
-36461,
-36899,
-37057,
-36934,
-36589,
-36068,
-35423,
-34733,
-34112,
-33704,
-33616,
-33851,
-34334,
-34883,
-35309,
-35439,
-35180,
-34487,
-33439,
-32111,
-30684,
-29317,
-28207,
-27535,
-27404,
-27848,
-28756,
-29947,
-31173,
-32228,
-32935,
-33207,
-32998,
-32353,
-31407,
-30374,
-29506,
-29014,
-29014,
-29525,
-30474,
-31739,
-33152,
-34489,
-35532,
-36081,
-36057,
-35507,
-34583,
-33484,
-32384,
-31437,
-30766,
-30464,
-30563,
-31009,
-31651,
-32284,
-32738,
-32875,
-32665,
-32120,
-31319,
-30372,
-29430,
-28643,
-28154,
-28040,
-28307,
-28895,
-29707,
-30607,
-31502,
-32238,
-32762,
-32973,
-32890,
-32541,
-32036,
-31476,
-30971,
-30590,
-30334,
-30236,
-30234,
-30336,
-30480,
-30603,
-30611,
-30405,
-29944,
-29234,
-28384,
-27476,
-26640,
-25904,
-25327,
-24930,
-24781,
-24912,
-25337,
-25988,
-26746,
-27497,
-28136,
-28616,
-28913,
-29028,
-28972,
-28792,
-28560,
-28374,
-28355,
-28577,
-29127,
-30011,
-31208,
-32635,
-34124,
-35525,
-36648,
-37426,
-37825,
-37879,
-37643,
-37133,
-36454,
-35694,
-35075,
-34755,
-34850,
-35351,
-36120,
-37011,
-37901,
-38699,
-39344,
-39727,
-39715,
-39213,
-38214,
-36859,
-35384,
-34056,
-33064,
-32541,
-32480,
-32893,
-33716,
-34892,
-36289,
-37698,
-38878,
-39588,
-39700,
-39208,
-38250,
-36993,
-35637,
-34300,
-33127,
-32200,
-31667,
-31576,
-31952,
-32646,
-33464,
-34146,
-34484,
-34370,
-33769,
-32761,
-31442,
-29971,
-28506,
-27220,
-26298,
-25881,
-26071,
-26844,
-28066,
-29475,
-30807,
-31823,
-32439,
-32641,
-32482,
-32008,
-31249,
-30302,
-29348,
-28642,
-28442,
-28870,
-29890,
-31327,
-32967,
-34633,
-36213,
-37598,
-38665,
-39263,
-39301,
-38787,
-37893,
-36875,
-35995,
-35410,
-35177,
-35227,
-35501,
-35923,
-36450,
-37014,
-37498,
-37773,
-37727,
-37357,
-36755,
-36081,
-35511,
-35133,
-35008,
-35131,
-35493,
-36085,
-36842,
-37668,
-38413,
-38908,
-39059,
-38782,
-38128,
-37132,
-35946,
-34685,
-33520,
-32554,
-31875,
-31493,
-31413,
-31584,
-31983,
-32498,
-33017,
-33372,
-33436,
-33147,
-32527,
-31636,
-30560,
-29328,
-28013,
-26680,
-25492,
-24602,
-24136,
-24120,
-24455,
-25024,
-25678,
-26360,
-27010,
-27572,
-27959,
-28076,
-27903,
-27502,
-27039,
-26675,
-26558,
-26700,
-27125,
-27768,
-28640,
-29702,
-30902,
-32119,
-33194,
-33991,
-34445,
-34592,
-34485,
-34236,
-33878,
-33475,
-33065,
-32726,
-32516,
-32478,
-32587,
-32800,
-33036,
-33288,
-33544,
-33838,
-34170,
-34504,
-34828,
-35092,
-35322,
-35498,
-35618,
-35617,
-35454,
-35102,
-34606,
-34032,
-33473,
-32994,
-32655,
-32512,
-32617,
-33021,
-33720,
-34659,
-35734,
-36798,
-37739,
-38412,
-38755,
-38685,
-38218,
-37372,
-36250,
-34942,
-33568,
-32244,
-31073,
-30151,
-29534,
-29208,
-29122,
-29195,
-29343,
-29520,
-29679,
-29781,
-29779,
-29643,
-29361,
-28975,
-28554,
-28165,
-27855,
-27638,
-27526,
-27505,
-27607,
-27824,
-28178,
-28653,
-29218,
-29845,
-30504,
-31207,
-31947,
-32739,
-33534,
-34286,
-34932,
-35450,
-35850,
-36156,
-36387,
-36513,
-36529,
-36396,
-36162,
-35841,
-35466,
-35022,
-34517,
-33960,
-33432,
-33007,
-32769,
-32746,
-32948,
-33338,
-33915,
-34601,
-35351,
-36020,
-36517,
-36727,
-36641,
-36252,
-35618,
-34794,
-33853,
-32925,
-32156,
-31693,
-31657,
-32056,
-32844,
-33907,
-35135,
-36405,
-37608,
-38598,
-39246,
-39438,
-39149,
-38447,
-37455,
-36305,
-35087,
-33840,
-32612,
-31455,
-30471,
-29740,
-29296,
-29087,
-29041,
-29091,
-29237,
-29499,
-29880,
-30317,
-30695,
-30916,
-30948,
-30842,
-30686,
-30522,
-30348,
-30139,
-29906,
-29745,
-29776,
-30103,
-30720,
-31551,
-32465,
-33402,
-34308,
-35208,
-35997,
-36616,
-36909,
-36848,
-36478,
-35920,
-35307,
-34699,
-34115,
-33521,
-32947,
-32427,
-32026,
-31755,
-31586,
-31472,
-31358,
-31280,
-31248,
-31343,
-31557,
-31887,
-32281,
-32709,
-33136,
-33540,
-33911,
-34186,
-34329,
-34269,
-34004,
-33536,
-32946,
-32295,
-31690,
-31192,
-30879,
-30788,
-30947,
-31344,
-31917,
-32586,
-33251,
-33826,
-34242,
-34449,
-34396,
-34095,
-33557,
-32853,
-32049,
-31189,
-30313,
-29435,
-28612,
-27882,
-27334,
-26977,
-26828,
-26861,
-27046,
-27390,
-27889,
-28533,
-29299,
-30111,
-30937,
-31712,
-32425,
-33067,
-33626,
-34116,
-34529,
-34860,
-35122,
-35321,
-35498,
-35689,
-35906,
-36135,
-36319,
-36392,
-36328,
-36126,
-35837,
-35485,
-35085,
-34632,
-34123,
-33604,
-33134,
-32771,
-32542,
-32412,
-32351,
-32319,
-32332,
-32419,
-32603,
-32872,
-33159,
-33394,
-33499,
-33458,
-33263,
-32963,
-32549,
-32062,
-31490,
-30925,
-30452,
-30212,
-30295,
-30714,
-31432,
-32348,
-33390,
-34472,
-35515,
-36405,
-37000,
-37176,
-36882,
-36141,
-35056,
-33751,
-32345,
-30936,
-29637,
-28549,
-27780,
-27377,
-27344,
-27602,
-28062,
-28633,
-29236,
-29832,
-30359,
-30774,
-31042,
-31162,
-31157,
-31098,
-31021,
-30981,
-30992,
-31079,
-31279,
-31605,
-32076,
-32660,
-33303,
-33946,
-34547,
-35074,
-35546,
-35921,
-36205,
-36369,
-36425,
-36431,
-36422,
-36466,
-36550,
-36657,
-36761,
-36857,
-36959,
-37095,
-37243,
-37380,
-37438,
-37402,
-37265,
-37067,
-36820,
-36526,
-36146,
-35650,
-35036,
-34354,
-33646,
-32973,
-32340,
-31742,
-31215,
-30765,
-30498,
-30421,
-30580,
-30904,
-31356,
-31864,
-32388,
-32892,
-33326,
-33632,
-33767,
-33678,
-33398,
-32942,
-32377,
-31761,
-31129,
-30534,
-30004,
-29575,
-29288,
-29145,
-29184,
-29371,
-29712,
-30151,
-30674,
-31231,
-31796,
-32326,
-32782,
-33119,
-33307,
-33322,
-33160,
-32831,
-32371,
-31804,
-31195,
-30568,
-29989,
-29490,
-29130,
-28971,
-29045,
-29383,
-29950,
-30691,
-31546,
-32441,
-33332,
-34155,
-34843,
-35317,
-35524,
-35472,
-35199,
-34806,
-34356,
-33924,
-33551,
-33291,
-33204,
-33327,
-33694,
-34271,
-35004,
-35799,
-36567,
-37229,
-37717,
-37996,
-38021,
-37803,
-37316,
-36610,
-35718,
-34713,
-33685,
-32698,
-31803,
-31046,
-30431,
-29992,
-29739,
-29675,
-29793,
-30038,
-30363,
-30684,
-30951,
-31105,
-31113,
-30964,
-30657,
-30219,
-29653,
-29026,
-28349,
-27730,
-27211,
-26885,
-26785,
-26928,
-27327,
-27977,
-28886,
-30044,
-31385,
-32824,
-34230,
-35484,
-36503,
-37206,
-37563,
-37505,
-37054,
-36187,
-35021,
-33642,
-32229,
-30915,
-29860,
-29159,
-28901,
-29129,
-29848,
-31005,
-32495,
-34169,
-35836,
-37328,
-38474,
-39170,
-39349,
-39003,
-38161,
-36904,
-35344,
-33639,
-31941,
-30437,
-29240,
-28478,
-28199,
-28419,
-29110,
-30182,
-31547,
-33040,
-34536,
-35861,
-36895,
-37527,
-37707,
-37433,
-36765,
-35792,
-34633,
-33397,
-32221,
-31212,
-30470,
-30060,
-29992,
-30234,
-30719,
-31358,
-32064,
-32751,
-33334,
-33734,
-33909,
-33808,
-33476,
-32921,
-32227,
-31445,
-30623,
-29831,
-29115,
-28562,
-28225,
-28142,
-28317,
-28719,
-29343,
-30158,
-31164,
-32310,
-33526,
-34712,
-35782,
-36672,
-37376,
-37852,
-38096,
-38048,
-37680,
-37009,
-36085,
-35000,
-33849,
-32700,
-31637,
-30746,
-30130,
-29913,
-30154,
-30892,
-32072,
-33605,
-35372,
-37229,
-39033,
-40615,
-41816,
-42476,
-42494,
-41840,
-40540,
-38709,
-36474,
-33994,
-31455,
-29037,
-26944,
-25350,
-24360,
-24031,
-24318,
-25170,
-26489,
-28174,
-30069,
-31995,
-33751,
-35157,
-36106,
-36542,
-36456,
-35873,
-34833,
-33441,
-31843,
-30244,
-28822,
-27729,
-27044,
-26787,
-26946,
-27482,
-28319,
-29365,
-30480,
-31543,
-32434,
-33101,
-33512,
-33698,
-33691,
-33544,
-33299,
-33024,
-32758,
-32592,
-32547,
-32678,
-32965,
-33390,
-33926,
-34535,
-35201,
-35884,
-36540,
-37097,
-37471,
-37614,
-37470,
-37040,
-36317,
-35323,
-34100,
-32719,
-31278,
-29901,
-28707,
-27800,
-27266,
-27144,
-27451,
-28158,
-29207,
-30539,
-32039,
-33642,
-35192,
-36599,
-37721,
-38476,
-38809,
-38681,
-38107,
-37091,
-35685,
-33979,
-32091,
-30181,
-28406,
-26892,
-25766,
-25077,
-24891,
-25206,
-26014,
-27226,
-28748,
-30421,
-32126,
-33732,
-35141,
-36257,
-37015,
-37374,
-37311,
-36883,
-36118,
-35113,
-33918,
-32597,
-31229,
-29896,
-28697,
-27712,
-26994,
-26560,
-26414,
-26559,
-26993,
-27702,
-28650,
-29756,
-30953,
-32172,
-33380,
-34584,
-35744,
-36846,
-37820,
-38621,
-39224,
-39625,
-39831,
-39845,
-39666,
-39276,
-38713,
-38017,
-37268,
-36524,
-35819,
-35144,
-34491,
-33847,
-33231,
-32650,
-32105,
-31569,
-31002,
-30418,
-29841,
-29355,
-29020,
-28870,
-28923,
-29174,
-29640,
-30331,
-31231,
-32281,
-33383,
-34430,
-35341,
-36063,
-36571,
-36826,
-36800,
-36461,
-35816,
-34914,
-33829,
-32646,
-31456,
-30329,
-29371,
-28658,
-28308,
-28375,
-28901,
-29849,
-31165,
-32737,
-34474,
-36251,
-37965,
-39500,
-40748,
-41632,
-42090,
-42127,
-41749,
-41003,
-39919,
-38547,
-36923,
-35131,
-33231,
-31327,
-29474,
-27774,
-26278,
-25079,
-24256,
-23858,
-23948,
-24519,
-25562,
-27032,
-28840,
-30883,
-33033,
-35157,
-37138,
-38875,
-40272,
-41267,
-41810,
-41887,
-41507,
-40724,
-39566,
-38122,
-36434,
-34582,
-32668,
-30783,
-29040,
-27530,
-26317,
-25444,
-24953,
-24837,
-25107,
-25717,
-26617,
-27724,
-28960,
-30254,
-31531,
-32757,
-33858,
-34803,
-35529,
-36021,
-36258,
-36246,
-35998,
-35516,
-34824,
-33938,
-32902,
-31771,
-30597,
-29444,
-28351,
-27369,
-26553,
-25948,
-25610,
-25558,
-25817,
-26379,
-27248,
-28413,
-29840,
-31487,
-33277,
-35113,
-36919,
-38570,
-39990,
-41050,
-41673,
-41765,
-41311,
-40299,
-38797,
-36858,
-34602,
-32125,
-29578,
-27095,
-24833,
-22906,
-21425,
-20415,
-19926,
-19937,
-20439,
-21395,
-22717,
-24317,
-26065,
-27854,
-29579,
-31168,
-32544,
-33639,
-34386,
-34742,
-34689,
-34279,
-33528,
-32518,
-31288,
-29874,
-28376,
-26834,
-25378,
-24067,
-22981,
-22161,
-21654,
-21501,
-21751,
-22430,
-23544,
-25054,
-26893,
-28979,
-31208,
-33505,
-35740,
-37830,
-39643,
-41100,
-42106,
-42630,
-42633,
-42139,
-41151,
-39724,
-37913,
-35808,
-33511,
-31143,
-28843,
-26727,
-24930,
-23529,
-22620,
-22240,
-22427,
-23166,
-24435,
-26158,
-28245,
-30568,
-32989,
-35385,
-37641,
-39658,
-41379,
-42722,
-43665,
-44174,
-44268,
-43988,
-43388,
-42526,
-41456,
-40219,
-38876,
-37505,
-36189,
-35033,
-34086,
-33411,
-32999,
-32886,
-33048,
-33502,
-34218,
-35138,
-36216,
-37329,
-38453,
-39485,
-40430,
-41209,
-41810,
-42153,
-42231,
-42002,
-41504,
-40759,
-39808,
-38698,
-37451,
-36117,
-34746,
-33408,
-32177,
-31130,
-30302,
-29750,
-29467,
-29506,
-29872,
-30604,
-31702,
-33145,
-34878,
-36847,
-38966,
-41176,
-43386,
-45495,
-47374,
-48900,
-49938,
-50427,
-50315,
-49610,
-48350,
-46581,
-44394,
-41890,
-39203,
-36488,
-33881,
-31514,
-29466,
-27814,
-26583,
-25817,
-25520,
-25697,
-26308,
-27284,
-28544,
-29976,
-31497,
-33017,
-34465,
-35752,
-36813,
-37575,
-37999,
-38092,
-37852,
-37337,
-36570,
-35592,
-34461,
-33218,
-31945,
-30710,
-29578,
-28617,
-27850,
-27331,
-27067,
-27071,
-27356,
-27884,
-28646,
-29575,
-30613,
-31702,
-32762,
-33760,
-34643,
-35401,
-35998,
-36438,
-36684,
-36757,
-36643,
-36355,
-35892,
-35245,
-34414,
-33390,
-32202,
-30883,
-29485,
-28081,
-26716,
-25460,
-24351,
-23427,
-22728,
-22262,
-22055,
-22090,
-22354,
-22819,
-23448,
-24229,
-25126,
-26118,
-27165,
-28190,
-29151,
-29977,
-30642,
-31117,
-31397,
-31466,
-31322,
-30990,
-30498,
-29924,
-29324,
-28754,
-28253,
-27834,
-27508,
-27288,
-27169,
-27163,
-27246,
-27407,
-27621,
-27872,
-28154,
-28470,
-28804,
-29145,
-29463,
-29715,
-29880,
-29938,
-29891,
-29759,
-29538,
-29249,
-28891,
-28481,
-28046,
-27601,
-27161,
-26719,
-26272,
-25816,
-25373,
-24979,
-24655,
-24455,
-24380,
-24469,
-24720,
-25148,
-25745,
-26476,
-27312,
-28196,
-29111,
-30019,
-30915,
-31785,
-32618,
-33413,
-34160,
-34858,
-35495,
-36036,
-36462,
-36716,
-36780,
-36635,
-36281,
-35760,
-35078,
-34308,
-33473,
-32643,
-31865,
-31190,
-30651,
-30259,
-30017,
-29908,
-29931,
-30078,
-30349,
-30735,
-31218,
-31771,
-32366,
-32981,
-33601,
-34194,
-34748,
-35218,
-35594,
-35871,
-36054,
-36178,
-36241,
-36268,
-36242,
-36171,
-36041,
-35864,
-35628,
-35341,
-35005,
-34636,
-34278,
-33967,
-33777,
-33741,
-33907,
-34293,
-34885,
-35674,
-36608,
-37633,
-38691,
-39708,
-40633,
-41405,
-41992,
-42374,
-42537,
-42499,
-42253,
-41825,
-41214,
-40443,
-39536,
-38527,
-37459,
-36382,
-35336,
-34380,
-33535,
-32849,
-32327,
-31988,
-31819,
-31805,
-31914,
-32130,
-32416,
-32769,
-33172,
-33618,
-34105,
-34606,
-35110,
-35583,
-36005,
-36348,
-36588,
-36709,
-36695,
-36549,
-36282,
-35924,
-35513,
-35090,
-34692,
-34352,
-34085,
-33913,
-33841,
-33861,
-33987,
-34196,
-34500,
-34882,
-35343,
-35874,
-36460,
-37093,
-37737,
-38356,
-38896,
-39306,
-39531,
-39556,
-39355,
-38943,
-38325,
-37527,
-36587,
-35543,
-34459,
-33373,
-32334,
-31370,
-30503,
-29767,
-29191,
-28811,
-28663,
-28745,
-29072,
-29593,
-30301,
-31123,
-32033,
-32951,
-33826,
-34587,
-35183,
-35580,
-35780,
-35793,
-35645,
-35370,
-34975,
-34505,
-33972,
-33417,
-32874,
-32353,
-31889,
-31473,
-31150,
-30910,
-30813,
-30846,
-31042,
-31369,
-31819,
-32356,
-32935,
-33530,
-34080,
-34572,
-34970,
-35261,
-35442,
-35504,
-35458,
-35302,
-35044,
-34683,
-34217,
-33640,
-32942,
-32138,
-31249,
-30305,
-29361,
-28449,
-27617,
-26889,
-26291,
-25849,
-25555,
-25432,
-25451,
-25606,
-25868,
-26227,
-26675,
-27211,
-27831,
-28522,
-29244,
-29972,
-30649,
-31260,
-31755,
-32133,
-32340,
-32387,
-32249,
-31964,
-31566,
-31106,
-30634,
-30163,
-29727,
-29328,
-28980,
-28703,
-28485,
-28342,
-28244,
-28198,
-28191,
-28233,
-28326,
-28460,
-28632,
-28798,
-28941,
-29027,
-29030,
-28964,
-28801,
-28574,
-28276,
-27931,
-27572,
-27211,
-26891,
-26615,
-26412,
-26259,
-26181,
-26153,
-26212,
-26337,
-26560,
-26874,
-27281,
-27777,
-28359,
-28991,
-29674,
-30358,
-31037,
-31671,
-32263,
-32789,
-33263,
-33679,
-34062,
-34407,
-34740,
-35043,
-35312,
-35525,
-35659,
-35706,
-35646,
-35500,
-35253,
-34942,
-34574,
-34188,
-33814,
-33474,
-33204,
-32994,
-32859,
-32784,
-32766,
-32792,
-32873,
-32984,
-33144,
-33319,
-33504,
-33679,
-33830,
-33943,
-34005,
-34001,
-33919,
-33772,
-33549,
-33314,
-33069,
-32882,
-32742,
-32692,
-32707,
-32804,
-32968,
-33188,
-33450,
-33731,
-34013,
-34302,
-34604,
-34948,
-35344,
-35810,
-36335,
-36916,
-37518,
-38136,
-38723,
-39276,
-39744,
-40127,
-40392,
-40550,
-40597,
-40554,
-40425,
-40215,
-39913,
-39513,
-39001,
-38388,
-37675,
-36890,
-36048,
-35174,
-34297,
-33451,
-32670,
-31979,
-31394,
-30918,
-30541,
-30266,
-30084,
-30009,
-30048,
-30204,
-30491,
-30899,
-31435,
-32067,
-32784,
-33533,
-34284,
-34981,
-35592,
-36086,
-36450,
-36692,
-36821,
-36878,
-36875,
-36856,
-36818,
-36795,
-36763,
-36735,
-36679,
-36586,
-36442,
-36241,
-35990,
-35710,
-35411,
-35125,
-34854,
-34621,
-34420,
-34254,
-34095,
-33947,
-33779,
-33608,
-33415,
-33221,
-33020,
-32821,
-32632,
-32451,
-32278,
-32107,
-31916,
-31701,
-31466,
-31221,
-31004,
-30841,
-30756,
-30785,
-30914,
-31179,
-31544,
-31995,
-32501,
-33002,
-33458,
-33837,
-34104,
-34279,
-34351,
-34361,
-34310,
-34227,
-34121,
-34001,
-33881,
-33757,
-33630,
-33486,
-33321,
-33142,
-32966,
-32825,
-32744,
-32744,
-32830,
-32997,
-33238,
-33523,
-33837,
-34136,
-34394,
-34580,
-34687,
-34700,
-34642,
-34497,
-34297,
-34034,
-33721,
-33363,
-32949,
-32489,
-31971,
-31419,
-30839,
-30272,
-29728,
-29253,
-28831,
-28512,
-28261,
-28113,
-28045,
-28038,
-28095,
-28171,
-28295,
-28456,
-28677,
-28973,
-29347,
-29802,
-30321,
-30877,
-31457,
-32012,
-32529,
-32947,
-33260,
-33418,
-33457,
-33358,
-33167,
-32903,
-32580,
-32211,
-31817,
-31386,
-30967,
-30537,
-30128,
-29724,
-29345,
-28997,
-28702,
-28473,
-28311,
-28215,
-28157,
-28131,
-28101,
-28065,
-27989,
-27878,
-27724,
-27546,
-27368,
-27207,
-27102,
-27061,
-27123,
-27279,
-27554,
-27918,
-28367,
-28877,
-29410,
-29974,
-30530,
-31087,
-31613,
-32096,
-32524,
-32884,
-33184,
-33419,
-33604,
-33723,
-33797,
-33815,
-33802,
-33779,
-33754,
-33754,
-33759,
-33789,
-33813,
-33858,
-33907,
-33975,
-34057,
-34150,
-34243,
-34344,
-34442,
-34555,
-34672,
-34781,
-34878,
-34932,
-34965,
-34963,
-34953,
-34928,
-34913,
-34885,
-34866,
-34823,
-34761,
-34641,
-34453,
-34159,
-33749,
-33212,
-32557,
-31798,
-30976,
-30129,
-29308,
-28570,
-27946,
-27482,
-27195,
-27120,
-27258,
-27632,
-28212,
-28988,
-29927,
-30989,
-32143,
-33342,
-34538,
-35670,
-36675,
-37512,
-38137,
-38554,
-38754,
-38777,
-38634,
-38388,
-38075,
-37748,
-37458,
-37212,
-37032,
-36885,
-36751,
-36592,
-36377,
-36083,
-35697,
-35204,
-34613,
-33926,
-33171,
-32384,
-31585,
-30816,
-30086,
-29433,
-28877,
-28456,
-28184,
-28114,
-28222,
-28556,
-29079,
-29799,
-30678,
-31672,
-32727,
-33770,
-34764,
-35657,
-36436,
-37088,
-37614,
-38033,
-38378,
-38679,
-38970,
-39260,
-39543,
-39800,
-40000,
-40113,
-40122,
-39993,
-39730,
-39308,
-38753,
-38069,
-37289,
-36444,
-35553,
-34635,
-33699,
-32771,
-31859,
-31005,
-30230,
-29566,
-29049,
-28701,
-28539,
-28590,
-28833,
-29259,
-29827,
-30470,
-31158,
-31811,
-32421,
-32929,
-33341,
-33638,
-33836,
-33955,
-34017,
-34043,
-34048,
-34029,
-33976,
-33893,
-33769,
-33607,
-33410,
-33177,
-32929,
-32669,
-32432,
-32219,
-32046,
-31902,
-31775,
-31663,
-31543,
-31428,
-31310,
-31207,
-31126,
-31097,
-31136,
-31274,
-31511,
-31852,
-32268,
-32735,
-33199,
-33642,
-33989,
-34242,
-34348,
-34314,
-34147,
-33851,
-33479,
-33028,
-32555,
-32061,
-31586,
-31134,
-30710,
-30318,
-29945,
-29593,
-29260,
-28937,
-28638,
-28342,
-28059,
-27783,
-27506,
-27243,
-27001,
-26779,
-26606,
-26477,
-26428,
-26476,
-26659,
-26997,
-27504,
-28191,
-29041,
-30037,
-31165,
-32380,
-33652,
-34927,
-36149,
-37280,
-38265,
-39092,
-39717,
-40136,
-40322,
-40276,
-40013,
-39556,
-38937,
-38195,
-37356,
-36465,
-35550,
-34647,
-33785,
-32972,
-32206,
-31492,
-30798,
-30146,
-29500,
-28880,
-28260,
-27657,
-27064,
-26504,
-25996,
-25567,
-25230,
-25015,
-24927,
-24994,
-25223,
-25627,
-26206,
-26953,
-27838,
-28841,
-29908,
-31003,
-32064,
-33038,
-33862,
-34501,
-34922,
-35132,
-35140,
-35003,
-34749,
-34467,
-34199,
-34018,
-33978,
-34084,
-34361,
-34763,
-35269,
-35824,
-36369,
-36869,
-37246,
-37484,
-37533,
-37402,
-37096,
-36635,
-36057,
-35394,
-34696,
-34020,
-33416,
-32939,
-32624,
-32504,
-32591,
-32882,
-33361,
-33986,
-34704,
-35443,
-36140,
-36719,
-37132,
-37338,
-37317,
-37083,
-36655,
-36090,
-35436,
-34744,
-34072,
-33449,
-32910,
-32455,
-32088,
-31779,
-31520,
-31289,
-31069,
-30857,
-30641,
-30430,
-30225,
-30040,
-29878,
-29749,
-29651,
-29601,
-29598,
-29667,
-29808,
-30043,
-30374,
-30834,
-31418,
-32146,
-32978,
-33884,
-34815,
-35707,
-36533,
-37236,
-37784,
-38140,
-38289,
-38248,
-38049,
-37739,
-37357,
-36929,
-36484,
-36031,
-35606,
-35206,
-34846,
-34503,
-34176,
-33855,
-33559,
-33278,
-33023,
-32783,
-32545,
-32312,
-32059,
-31780,
-31458,
-31069,
-30647,
-30186,
-29771,
-29392,
-29143,
-29005,
-29058,
-29294,
-29743,
-30370,
-31141,
-31992,
-32883,
-33757,
-34575,
-35305,
-35888,
-36346,
-36643,
-36813,
-36867,
-36787,
-36624,
-36341,
-35997,
-35568,
-35078,
-34517,
-33910,
-33280,
-32671,
-32095,
-31555,
-31047,
-30546,
-30076,
-29631,
-29220,
-28835,
-28463,
-28132,
-27878,
-27766,
-27836,
-28109,
-28588,
-29272,
-30163,
-31239,
-32460,
-33743,
-35007,
-36175,
-37188,
-38011,
-38602,
-38933,
-39011,
-38840,
-38482,
-37954,
-37296,
-36511,
-35634,
-34709,
-33782,
-32895,
-32052,
-31252,
-30512,
-29832,
-29240,
-28708,
-28200,
-27674,
-27097,
-26478,
-25820,
-25122,
-24401,
-23646,
-22939,
-22317,
-21893,
-21692,
-21786,
-22177,
-22909,
-23970,
-25342,
-26957,
-28741,
-30611,
-32515,
-34397,
-36180,
-37797,
-39166,
-40274,
-41103,
-41689,
-42022,
-42118,
-41989,
-41690,
-41277,
-40809,
-40287,
-39702,
-39046,
-38326,
-37567,
-36773,
-35923,
-34968,
-33916,
-32749,
-31553,
-30327,
-29136,
-27995,
-26978,
-26172,
-25643,
-25445,
-25557,
-25971,
-26661,
-27624,
-28835,
-30229,
-31718,
-33212,
-34641,
-35971,
-37140,
-38102,
-38780,
-39166,
-39274,
-39159,
-38867,
-38408,
-37797,
-37061,
-36248,
-35434,
-34646,
-33895,
-33162,
-32455,
-31780,
-31144,
-30524,
-29870,
-29161,
-28399,
-27640,
-26933,
-26293,
-25752,
-25295,
-25008,
-24908,
-25068,
-25454,
-26076,
-26901,
-27956,
-29227,
-30673,
-32218,
-33762,
-35263,
-36704,
-38081,
-39368,
-40513,
-41472,
-42228,
-42808,
-43214,
-43438,
-43455,
-43245,
-42850,
-42315,
-41683,
-40942,
-40078,
-39069,
-37970,
-36814,
-35654,
-34470,
-33254,
-31991,
-30719,
-29443,
-28195,
-26920,
-25647,
-24400,
-23281,
-22385,
-21750,
-21414,
-21349,
-21612,
-22208,
-23176,
-24448,
-25959,
-27614,
-29357,
-31137,
-32880,
-34482,
-35850,
-36924,
-37719,
-38276,
-38634,
-38781,
-38723,
-38467,
-38075,
-37598,
-37074,
-36501,
-35892,
-35288,
-34741,
-34282,
-33890,
-33510,
-33084,
-32625,
-32149,
-31679,
-31209,
-30704,
-30176,
-29658,
-29229,
-28913,
-28747,
-28714,
-28866,
-29254,
-29917,
-30837,
-31922,
-33063,
-34183,
-35235,
-36199,
-37015,
-37626,
-37981,
-38089,
-38000,
-37747,
-37349,
-36796,
-36123,
-35403,
-34731,
-34176,
-33717,
-33338,
-32977,
-32655,
-32359,
-32075,
-31746,
-31314,
-30759,
-30096,
-29352,
-28514,
-27573,
-26517,
-25417,
-24391,
-23540,
-22940,
-22601,
-22527,
-22748,
-23281,
-24125,
-25216,
-26476,
-27843,
-29295,
-30819,
-32367,
-33850,
-35178,
-36295,
-37234,
-38035,
-38725,
-39316,
-39795,
-40188,
-40553,
-40924,
-41304,
-41661,
-41968,
-42229,
-42478,
-42687,
-42812,
-42737,
-42395,
-41774,
-40901,
-39833,
-38591,
-37224,
-35796,
-34421,
-33198,
-32182,
-31376,
-30755,
-30319,
-30095,
-30099,
-30280,
-30542,
-30793,
-30947,
-31022,
-30983,
-30847,
-30579,
-30185,
-29725,
-29255,
-28829,
-28432,
-28053,
-27686,
-27398,
-27253,
-27310,
-27559,
-27959,
-28496,
-29132,
-29879,
-30663,
-31421,
-32074,
-32595,
-33005,
-33309,
-33496,
-33517,
-33360,
-33049,
-32674,
-32320,
-32029,
-31813,
-31686,
-31650,
-31749,
-31952,
-32228,
-32511,
-32788,
-33081,
-33428,
-33832,
-34254,
-34638,
-34964,
-35241,
-35510,
-35758,
-35991,
-36170,
-36330,
-36481,
-36667,
-36841,
-36986,
-37061,
-37100,
-37162,
-37261,
-37398,
-37481,
-37468,
-37318,
-37022,
-36576,
-35942,
-35110,
-34093,
-32957,
-31772,
-30583,
-29395,
-28222,
-27098,
-26107,
-25313,
-24744,
-24373,
-24151,
-24046,
-24034,
-24090,
-24156,
-24191,
-24160,
-24102,
-24071,
-24104,
-24206,
-24355,
-24562,
-24866,
-25334,
-25999,
-26854,
-27880,
-29036,
-30311,
-31663,
-33029,
-34320,
-35456,
-36422,
-37219,
-37879,
-38389,
-38710,
-38836,
-38783,
-38620,
-38415,
-38204,
-38017,
-37862,
-37791,
-37821,
-37950,
-38119,
-38255,
-38309,
-38264,
-38143,
-37922,
-37578,
-37062,
-36353,
-35492,
-34516,
-33495,
-32465,
-31495,
-30666,
-30060,
-29747,
-29712,
-29931,
-30333,
-30900,
-31600,
-32393,
-33203,
-33941,
-34521,
-34914,
-35092,
-35052,
-34786,
-34297,
-33645,
-32920,
-32215,
-31595,
-31050,
-30586,
-30185,
-29900,
-29748,
-29743,
-29863,
-30057,
-30326,
-30645,
-31016,
-31400,
-31745,
-32024,
-32241,
-32446,
-32657,
-32906,
-33158,
-33419,
-33715,
-34073,
-34539,
-35110,
-35771,
-36521,
-37325,
-38179,
-39010,
-39751,
-40335,
-40733,
-40975,
-41073,
-41059,
-40914,
-40664,
-40321,
-39954,
-39588,
-39240,
-38890,
-38536,
-38188,
-37872,
-37570,
-37237,
-36810,
-36266,
-35615,
-34931,
-34234,
-33552,
-32860,
-32145,
-31425,
-30715,
-30029,
-29358,
-28688,
-28036,
-27438,
-26943,
-26543,
-26246,
-25996,
-25815,
-25701,
-25682,
-25756,
-25918,
-26137,
-26420,
-26742,
-27092,
-27412,
-27684,
-27886,
-28079,
-28285,
-28543,
-28817,
-29094,
-29355,
-29625,
-29934,
-30282,
-30664,
-31049,
-31466,
-31922,
-32449,
-33013,
-33555,
-34033,
-34407,
-34723,
-34981,
-35206,
-35366,
-35436,
-35446,
-35402,
-35350,
-35310,
-35257,
-35229,
-35218,
-35255,
-35327,
-35396,
-35405,
-35336,
-35163,
-34913,
-34559,
-34095,
-33496,
-32780,
-31987,
-31152,
-30292,
-29419,
-28556,
-27756,
-27088,
-26596,
-26256,
-26050,
-25903,
-25851,
-25865,
-25974,
-26118,
-26260,
-26344,
-26379,
-26367,
-26325,
-26244,
-26113,
-25963,
-25857,
-25853,
-26008,
-26285,
-26677,
-27125,
-27636,
-28181,
-28734,
-29263,
-29725,
-30137,
-30502,
-30839,
-31132,
-31362,
-31532,
-31678,
-31853,
-32079,
-32372,
-32683,
-33042,
-33438,
-33904,
-34422,
-34941,
-35424,
-35853,
-36263,
-36661,
-37060,
-37384,
-37615,
-37714,
-37736,
-37694,
-37621,
-37478,
-37279,
-37025,
-36791,
-36595,
-36478,
-36387,
-36322,
-36255,
-36183,
-36108,
-35964,
-35745,
-35410,
-35006,
-34557,
-34102,
-33641,
-33185,
-32755,
-32387,
-32097,
-31873,
-31683,
-31516,
-31399,
-31361,
-31426,
-31530,
-31627,
-31657,
-31655,
-31658,
-31724,
-31849,
-32014,
-32218,
-32475,
-32829,
-33273,
-33764,
-34229,
-34646,
-35025,
-35439,
-35914,
-36454,
-37020,
-37553,
-38062,
-38494,
-38874,
-39155,
-39351,
-39479,
-39555,
-39621,
-39646,
-39625,
-39545,
-39420,
-39273,
-39116,
-38927,
-38728,
-38541,
-38431,
-38432,
-38517,
-38618,
-38697,
-38738,
-38824,
-39009,
-39281,
-39607,
-39899,
-40139,
-40344,
-40498,
-40584,
-40505,
-40202,
-39682,
-39007,
-38257,
-37496,
-36710,
-35908,
-35095,
-34327,
-33637,
-33057,
-32572,
-32164,
-31832,
-31550,
-31307,
-31065,
-30784,
-30458,
-30074,
-29632,
-29118,
-28540,
-27938,
-27397,
-26993,
-26759,
-26667,
-26688,
-26806,
-27085,
-27551,
-28225,
-29017,
-29859,
-30698,
-31552,
-32452,
-33378,
-34238,
-34937,
-35434,
-35759,
-36024,
-36259,
-36496,
-36674,
-36797,
-36875,
-36976,
-37107,
-37268,
-37396,
-37466,
-37465,
-37395,
-37256,
-37022,
-36665,
-36170,
-35528,
-34728,
-33793,
-32747,
-31659,
-30594,
-29580,
-28617,
-27670,
-26742,
-25885,
-25152,
-24580,
-24108,
-23696,
-23285,
-22956,
-22755,
-22745,
-22860,
-23018,
-23147,
-23247,
-23388,
-23589,
-23827,
-24005,
-24059,
-23996,
-23884,
-23776,
-23697,
-23576,
-23400,
-23145,
-22895,
-22698,
-22617,
-22662,
-22823,
-23118,
-23523,
-24051,
-24671,
-25378,
-26148,
-26971,
-27799,
-28608,
-29361,
-30066,
-30749,
-31386,
-31945,
-32335,
-32540,
-32618,
-32675,
-32814,
-33036,
-33290,
-33503,
-33666,
-33830,
-34032,
-34259,
-34424,
-34470,
-34403,
-34306,
-34259,
-34272,
-34274,
-34165,
-33921,
-33570,
-33205,
-32865,
-32552,
-32227,
-31864,
-31462,
-31027,
-30566,
-30066,
-29510,
-28933,
-28341,
-27801,
-27337,
-26998,
-26808,
-26772,
-26859,
-27024,
-27223,
-27500,
-27905,
-28510,
-29306,
-30200,
-31108,
-31950,
-32747,
-33499,
-34197,
-34745,
-35094,
-35223,
-35257,
-35296,
-35406,
-35562,
-35668,
-35713,
-35720,
-35799,
-35999,
-36296,
-36647,
-36951,
-37243,
-37490,
-37747,
-37947,
-38083,
-38115,
-38095,
-38065,
-38115,
-38257,
-38524,
-38885,
-39314,
-39762,
-40185,
-40584,
-40978,
-41414,
-41890,
-42375,
-42804,
-43143,
-43410,
-43619,
-43784,
-43846,
-43747,
-43481,
-43131,
-42790,
-42543,
-42345,
-42126,
-41821,
-41451,
-41080,
-40770,
-40482,
-40151,
-39699,
-39120,
-38447,
-37717,
-36918,
-36012,
-34994,
-33899,
-32837,
-31888,
-31116,
-30510,
-30062,
-29739,
-29517,
-29384,
-29293,
-29258,
-29266,
-29333,
-29458,
-29611,
-29791,
-30006,
-30306,
-30696,
-31160,
-31644,
-32098,
-32555,
-33049,
-33633,
-34256,
-34852,
-35331,
-35712,
-36046,
-36401,
-36768,
-37064,
-37222,
-37223,
-37132,
-37010,
-36876,
-36667,
-36340,
-35886,
-35389,
-34933,
-34565,
-34274,
-34009,
-33773,
-33567,
-33455,
-33410,
-33422,
-33424,
-33390,
-33320,
-33232,
-33146,
-33078,
-33027,
-32995,
-32952,
-32871,
-32716,
-32472,
-32162,
-31794,
-31390,
-30928,
-30414,
-29881,
-29385,
-28998,
-28698,
-28469,
-28238,
-28019,
-27846,
-27775,
-27787,
-27822,
-27764,
-27586,
-27268,
-26885,
-26434,
-25931,
-25348,
-24729,
-24140,
-23682,
-23389,
-23265,
-23264,
-23375,
-23592,
-23957,
-24467,
-25119,
-25874,
-26683,
-27528,
-28322,
-29049,
-29628,
-30059,
-30355,
-30527,
-30621,
-30626,
-30598,
-30571,
-30604,
-30727,
-30908,
-31119,
-31327,
-31564,
-31874,
-32268,
-32719,
-33127,
-33428,
-33590,
-33627,
-33563,
-33377,
-33065,
-32609,
-32101,
-31602,
-31207,
-30922,
-30728,
-30592,
-30515,
-30517,
-30632,
-30862,
-31191,
-31601,
-32072,
-32597,
-33121,
-33626,
-34032,
-34350,
-34578,
-34730,
-34856,
-34943,
-35018,
-35085,
-35149,
-35197,
-35198,
-35139,
-35019,
-34871,
-34747,
-34638,
-34570,
-34484,
-34406,
-34307,
-34198,
-34054,
-33866,
-33648,
-33454,
-33329,
-33301,
-33337,
-33383,
-33408,
-33418,
-33431,
-33465,
-33469,
-33407,
-33265,
-33090,
-32943,
-32855,
-32784,
-32653,
-32431,
-32139,
-31887,
-31726,
-31693,
-31706,
-31734,
-31744,
-31809,
-31954,
-32205,
-32488,
-32732,
-32897,
-33006,
-33119,
-33279,
-33474,
-33651,
-33738,
-33721,
-33616,
-33488,
-33375,
-33295,
-33232,
-33166,
-33112,
-33125,
-33240,
-33504,
-33867,
-34284,
-34698,
-35089,
-35508,
-35976,
-36525,
-37116,
-37677,
-38160,
-38527,
-38788,
-38956,
-39038,
-39025,
-38911,
-38690,
-38397,
-38054,
-37722,
-37407,
-37129,
-36850,
-36550,
-36204,
-35857,
-35551,
-35330,
-35183,
-35012,
-34746,
-34305,
-33742,
-33110,
-32463,
-31804,
-31084,
-30289,
-29480,
-28755,
-28194,
-27789,
-27454,
-27102,
-26725,
-26380,
-26163,
-26088,
-26127,
-26186,
-26239,
-26286,
-26364,
-26473,
-26572,
-26627,
-26636,
-26671,
-26770,
-26986,
-27258,
-27580,
-27923,
-28333,
-28816,
-29363,
-29928,
-30466,
-31014,
-31599,
-32267,
-32950,
-33565,
-34015,
-34295,
-34482,
-34665,
-34916,
-35211,
-35519,
-35819,
-36121,
-36473,
-36870,
-37277,
-37615,
-37829,
-37916,
-37919,
-37903,
-37923,
-37975,
-38029,
-38003,
-37876,
-37631,
-37361,
-37134,
-37011,
-36966,
-36907,
-36779,
-36574,
-36371,
-36246,
-36194,
-36118,
-35905,
-35509,
-35026,
-34581,
-34274,
-34029,
-33703,
-33168,
-32427,
-31642,
-30972,
-30509,
-30198,
-29929,
-29654,
-29408,
-29316,
-29408,
-29652,
-29900,
-30030,
-30028,
-29936,
-29877,
-29883,
-29935,
-29959,
-29875,
-29672,
-29369,
-29050,
-28761,
-28555,
-28419,
-28335,
-28273,
-28260,
-28334,
-28581,
-29004,
-29564,
-30146,
-30666,
-31114,
-31566,
-32092,
-32696,
-33247,
-33597,
-33652,
-33468,
-33205,
-32996,
-32878,
-32779,
-32619,
-32427,
-32313,
-32419,
-32775,
-33286,
-33798,
-34221,
-34597,
-35026,
-35590,
-36250,
-36882,
-37373,
-37684,
-37856,
-37952,
-37967,
-37877,
-37654,
-37326,
-36988,
-36706,
-36507,
-36363,
-36243,
-36172,
-36179,
-36296,
-36474,
-36645,
-36767,
-36850,
-36941,
-37035,
-37047,
-36853,
-36377,
-35680,
-34893,
-34168,
-33538,
-32933,
-32308,
-31624,
-31013,
-30547,
-30268,
-30094,
-29901,
-29643,
-29341,
-29126,
-29031,
-29053,
-29069,
-28972,
-28717,
-28331,
-27901,
-27488,
-27140,
-26836,
-26570,
-26306,
-26077,
-25894,
-25843,
-25924,
-26146,
-26420,
-26694,
-26941,
-27229,
-27626,
-28160,
-28732,
-29200,
-29440,
-29473,
-29441,
-29503,
-29738,
-30069,
-30391,
-30641,
-30886,
-31259,
-31818,
-32528,
-33231,
-33823,
-34274,
-34705,
-35208,
-35831,
-36476,
-37019,
-37361,
-37533,
-37599,
-37690,
-37825,
-38012,
-38182,
-38292,
-38350,
-38379,
-38448,
-38575,
-38745,
-38902,
-38985,
-38990,
-38962,
-38976,
-39053,
-39129,
-39081,
-38791,
-38260,
-37576,
-36883,
-36264,
-35687,
-35105,
-34458,
-33833,
-33315,
-33011,
-32889,
-32851,
-32810,
-32728,
-32683,
-32728,
-32870,
-33020,
-33074,
-32966,
-32729,
-32416,
-32082,
-31707,
-31281,
-30791,
-30297,
-29844,
-29479,
-29168,
-28904,
-28672,
-28539,
-28549,
-28734,
-29027,
-29381,
-29729,
-30096,
-30487,
-30862,
-31147,
-31205,
-31022,
-30641,
-30191,
-29798,
-29455,
-29135,
-28774,
-28413,
-28149,
-28092,
-28257,
-28574,
-28923,
-29259,
-29592,
-30013,
-30531,
-31104,
-31604,
-31938,
-32110,
-32181,
-32253,
-32357,
-32476,
-32552,
-32568,
-32535,
-32514,
-32539,
-32644,
-32831,
-33105,
-33461,
-33898,
-34411,
-34995,
-35651,
-36344,
-37022,
-37586,
-37971,
-38157,
-38215,
-38246,
-38294,
-38361,
-38342,
-38234,
-38054,
-37942,
-37973,
-38147,
-38357,
-38490,
-38517,
-38519,
-38600,
-38779,
-38975,
-39031,
-38883,
-38560,
-38193,
-37875,
-37600,
-37275,
-36792,
-36159,
-35429,
-34733,
-34074,
-33456,
-32788,
-32083,
-31393,
-30807,
-30391,
-30117,
-29907,
-29684,
-29403,
-29078,
-28743,
-28412,
-28077,
-27720,
-27327,
-26923,
-26542,
-26219,
-25971,
-25785,
-25647,
-25547,
-25509,
-25558,
-25723,
-25976,
-26279,
-26587,
-26870,
-27176,
-27520,
-27930,
-28384,
-28831,
-29273,
-29718,
-30225,
-30803,
-31429,
-32017,
-32543,
-33022,
-33541,
-34177,
-34922,
-35701,
-36432,
-37071,
-37680,
-38316,
-38994,
-39640,
-40143,
-40454,
-40620,
-40759,
-40970,
-41237,
-41485,
-41625,
-41674,
-41722,
-41886,
-42193,
-42553,
-42849,
-42995,
-43021,
-43000,
-42976,
-42907,
-42677,
-42225,
-41540,
-40750,
-39937,
-39168,
-38385,
-37544,
-36623,
-35683,
-34793,
-34016,
-33322,
-32691,
-32085,
-31509,
-31004,
-30549,
-30145,
-29715,
-29247,
-28703,
-28091,
-27399,
-26611,
-25767,
-24878,
-24028,
-23210,
-22459,
-21738,
-21102,
-20601,
-20311,
-20245,
-20349,
-20538,
-20763,
-21025,
-21373,
-21796,
-22221,
-22553,
-22735,
-22805,
-22866,
-22975,
-23135,
-23264,
-23328,
-23360,
-23464,
-23717,
-24127,
-24608,
-25106,
-25626,
-26231,
-26999,
-27893,
-28822,
-29678,
-30411,
-31070,
-31690,
-32284,
-32764,
-33078,
-33202,
-33209,
-33211,
-33250,
-33340,
-33426,
-33513,
-33638,
-33877,
-34261,
-34776,
-35348,
-35895,
-36391,
-36786,
-37118,
-37349,
-37474,
-37463,
-37286,
-36944,
-36464,
-35901,
-35320,
-34774,
-34236,
-33696,
-33120,
-32559,
-32109,
-31857,
-31794,
-31848,
-31871,
-31835,
-31763,
-31763,
-31848,
-31932,
-31859,
-31525,
-30977,
-30367,
-29824,
-29373,
-28900,
-28312,
-27638,
-27020,
-26659,
-26620,
-26810,
-27081,
-27309,
-27533,
-27860,
-28331,
-28904,
-29400,
-29688,
-29744,
-29661,
-29556,
-29483,
-29386,
-29193,
-28883,
-28518,
-28206,
-28057,
-28071,
-28241,
-28480,
-28798,
-29187,
-29690,
-30316,
-31024,
-31764,
-32445,
-33020,
-33470,
-33826,
-34123,
-34391,
-34602,
-34734,
-34763,
-34737,
-34755,
-34907,
-35246,
-35724,
-36295,
-36914,
-37618,
-38466,
-39465,
-40557,
-41611,
-42518,
-43273,
-43921,
-44536,
-45100,
-45545,
-45778,
-45818,
-45740,
-45690,
-45706,
-45772,
-45810,
-45813,
-45849,
-46021,
-46372,
-46831,
-47280,
-47627,
-47899,
-48154,
-48460,
-48728,
-48861,
-48747,
-48408,
-47960,
-47490,
-47020,
-46458,
-45739,
-44871,
-44004,
-43254,
-42700,
-42256,
-41825,
-41341,
-40854,
-40456,
-40187,
-39983,
-39705,
-39244,
-38578,
-37783,
-36934,
-36080,
-35154,
-34125,
-32945,
-31694,
-30483,
-29407,
-28530,
-27813,
-27201,
-26626,
-26106,
-25679,
-25415,
-25322,
-25308,
-25277,
-25124,
-24879,
-24640,
-24497,
-24468,
-24442,
-24286,
-23972,
-23586,
-23318,
-23270,
-23434,
-23663,
-23871,
-24058,
-24396,
-24990,
-25877,
-26910,
-27906,
-28793,
-29576,
-30397,
-31266,
-32150,
-32887,
-33403,
-33708,
-33898,
-34126,
-34403,
-34757,
-35112,
-35446,
-35775,
-36117,
-36501,
-36945,
-37418,
-37898,
-38316,
-38618,
-38810,
-38904,
-39008,
-39114,
-39201,
-39133,
-38843,
-38345,
-37760,
-37202,
-36713,
-36165,
-35469,
-34563,
-33601,
-32754,
-32134,
-31688,
-31233,
-30659,
-29960,
-29286,
-28741,
-28311,
-27829,
-27133,
-26175,
-25084,
-24049,
-23157,
-22387,
-21595,
-20731,
-19840,
-19051,
-18467,
-18058,
-17718,
-17335,
-16890,
-16471,
-16163,
-16001,
-15918,
-15848,
-15735,
-15640,
-15606,
-15666,
-15783,
-15868,
-15906,
-15891,
-15903,
-15974,
-16106,
-16267,
-16451,
-16690,
-17079,
-17647,
-18400,
-19254,
-20104,
-20940,
-21746,
-22591,
-23447,
-24278,
-24980,
-25544,
-26004,
-26481,
-27082,
-27795,
-28556,
-29269,
-29874,
-30487,
-31150,
-31984,
-32876,
-33737,
-34424,
-34967,
-35485,
-36131,
-36947,
-37827,
-38600,
-39158,
-39559,
-39953,
-40469,
-41082,
-41598,
-41873,
-41838,
-41695,
-41645,
-41836,
-42189,
-42513,
-42672,
-42702,
-42769,
-43033,
-43463,
-43871,
-44035,
-43875,
-43515,
-43155,
-42944,
-42840,
-42714,
-42447,
-42054,
-41662,
-41390,
-41277,
-41220,
-41111,
-40850,
-40471,
-40036,
-39638,
-39312,
-39033,
-38763,
-38441,
-38052,
-37646,
-37273,
-37018,
-36856,
-36692,
-36413,
-35915,
-35282,
-34637,
-34151,
-33846,
-33630,
-33388,
-33073,
-32809,
-32734,
-32926,
-33262,
-33527,
-33555,
-33355,
-33094,
-32956,
-32983,
-33079,
-33079,
-32953,
-32780,
-32757,
-32984,
-33430,
-33949,
-34395,
-34744,
-35063,
-35465,
-35998,
-36606,
-37200,
-37701,
-38125,
-38563,
-39096,
-39773,
-40527,
-41250,
-41846,
-42269,
-42571,
-42836,
-43122,
-43434,
-43740,
-44002,
-44273,
-44618,
-45128,
-45783,
-46510,
-47182,
-47715,
-48098,
-48363,
-48537,
-48622,
-48572,
-48385,
-48070,
-47693,
-47301,
-46928,
-46574,
-46270,
-46000,
-45792,
-45575,
-45314,
-44944,
-44500,
-44007,
-43524,
-43034,
-42477,
-41830,
-41114,
-40411,
-39806,
-39240,
-38623,
-37789,
-36704,
-35448,
-34167,
-32981,
-31890,
-30812,
-29700,
-28585,
-27606,
-26876,
-26395,
-26050,
-25659,
-25131,
-24463,
-23765,
-23081,
-22425,
-21679,
-20798,
-19756,
-18690,
-17707,
-16940,
-16367,
-15954,
-15597,
-15260,
-14942,
-14688,
-14538,
-14489,
-14514,
-14539,
-14549,
-14550,
-14637,
-14883,
-15319,
-15863,
-16362,
-16677,
-16789,
-16784,
-16830,
-17001,
-17261,
-17484,
-17609,
-17693,
-17957,
-18560,
-19525,
-20678,
-21745,
-22620,
-23331,
-24089,
-24977,
-25940,
-26729,
-27152,
-27209,
-27124,
-27173,
-27508,
-28028,
-28518,
-28819,
-28953,
-29124,
-29475,
-30035,
-30609,
-30994,
-31118,
-31093,
-31168,
-31492,
-32046,
-32633,
-33033,
-33161,
-33091,
-32986,
-32935,
-32890,
-32698,
-32255,
-31581,
-30869,
-30306,
-30025,
-29951,
-29964,
-29947,
-29910,
-29945,
-30134,
-30431,
-30708,
-30785,
-30592,
-30171,
-29639,
-29108,
-28617,
-28165,
-27728,
-27326,
-26989,
-26727,
-26541,
-26390,
-26268,
-26145,
-26029,
-25884,
-25719,
-25582,
-25550,
-25717,
-26049,
-26461,
-26788,
-26966,
-27046,
-27141,
-27339,
-27573,
-27682,
-27570,
-27264,
-26969,
-26921,
-27163,
-27653,
-28155,
-28626,
-29102,
-29760,
-30684,
-31768,
-32780,
-33482,
-33841,
-33999,
-34201,
-34575,
-35092,
-35615,
-36022,
-36343,
-36697,
-37223,
-37922,
-38686,
-39340,
-39807,
-40136,
-40488,
-40994,
-41701,
-42511,
-43307,
-43995,
-44608,
-45212,
-45890,
-46601,
-47260,
-47708,
-47903,
-47841,
-47655,
-47450,
-47310,
-47247,
-47232,
-47262,
-47366,
-47614,
-48031,
-48615,
-49227,
-49747,
-50026,
-50054,
-49887,
-49653,
-49452,
-49298,
-49134,
-48892,
-48570,
-48233,
-47993,
-47884,
-47846,
-47750,
-47492,
-47068,
-46602,
-46232,
-46010,
-45904,
-45778,
-45566,
-45292,
-45061,
-44959,
-44972,
-44967,
-44784,
-44323,
-43595,
-42707,
-41769,
-40850,
-39948,
-39065,
-38208,
-37464,
-36891,
-36548,
-36376,
-36301,
-36165,
-35900,
-35449,
-34867,
-34233,
-33630,
-33086,
-32585,
-32065,
-31508,
-30955,
-30480,
-30164,
-29995,
-29870,
-29661,
-29268,
-28745,
-28218,
-27838,
-27622,
-27493,
-27307,
-27013,
-26721,
-26593,
-26752,
-27116,
-27425,
-27424,
-27010,
-26348,
-25671,
-25159,
-24801,
-24427,
-23903,
-23298,
-22836,
-22788,
-23179,
-23805,
-24316,
-24507,
-24420,
-24310,
-24410,
-24732,
-25075,
-25199,
-25032,
-24769,
-24682,
-24965,
-25532,
-26133,
-26524,
-26673,
-26719,
-26897,
-27263,
-27724,
-28071,
-28185,
-28158,
-28193,
-28511,
-29133,
-29921,
-30631,
-31101,
-31312,
-31369,
-31376,
-31360,
-31244,
-30960,
-30506,
-30009,
-29645,
-29538,
-29723,
-30075,
-30478,
-30814,
-31086,
-31337,
-31620,
-31913,
-32143,
-32222,
-32107,
-31849,
-31552,
-31332,
-31236,
-31250,
-31291,
-31297,
-31247,
-31160,
-31088,
-31023,
-30925,
-30736,
-30408,
-30005,
-29614,
-29361,
-29288,
-29338,
-29401,
-29350,
-29138,
-28776,
-28322,
-27787,
-27187,
-26442,
-25607,
-24694,
-23852,
-23182,
-22739,
-22508,
-22415,
-22387,
-22392,
-22427,
-22521,
-22645,
-22762,
-22782,
-22658,
-22389,
-22036,
-21726,
-21526,
-21502,
-21584,
-21731,
-21862,
-21988,
-22126,
-22321,
-22544,
-22744,
-22850,
-22865,
-22867,
-22992,
-23327,
-23880,
-24538,
-25169,
-25667,
-26056,
-26390,
-26751,
-27108,
-27387,
-27480,
-27411,
-27278,
-27276,
-27517,
-28000,
-28635,
-29276,
-29930,
-30635,
-31509,
-32539,
-33604,
-34512,
-35119,
-35457,
-35668,
-35932,
-36326,
-36791,
-37233,
-37575,
-37871,
-38214,
-38660,
-39173,
-39623,
-39905,
-39999,
-40005,
-40049,
-40224,
-40530,
-40892,
-41232,
-41510,
-41734,
-41942,
-42150,
-42345,
-42451,
-42421,
-42194,
-41811,
-41331,
-40890,
-40539,
-40340,
-40234,
-40209,
-40253,
-40422,
-40747,
-41223,
-41711,
-42070,
-42157,
-41987,
-41657,
-41335,
-41083,
-40901,
-40682,
-40389,
-40027,
-39711,
-39503,
-39432,
-39379,
-39228,
-38913,
-38475,
-38062,
-37779,
-37662,
-37626,
-37537,
-37348,
-37091,
-36908,
-36887,
-36998,
-37100,
-36989,
-36616,
-36021,
-35411,
-34923,
-34575,
-34299,
-33992,
-33682,
-33529,
-33664,
-34153,
-34828,
-35461,
-35875,
-36044,
-36108,
-36204,
-36369,
-36534,
-36563,
-36426,
-36220,
-36089,
-36146,
-36368,
-36636,
-36836,
-36934,
-36990,
-37111,
-37344,
-37666,
-37998,
-38268,
-38485,
-38703,
-39025,
-39473,
-40038,
-40611,
-41107,
-41443,
-41634,
-41702,
-41708,
-41663,
-41570,
-41432,
-41286,
-41218,
-41311,
-41622,
-42120,
-42705,
-43282,
-43727,
-44055,
-44251,
-44369,
-44409,
-44351,
-44162,
-43829,
-43383,
-42882,
-42407,
-41976,
-41589,
-41180,
-40723,
-40197,
-39665,
-39156,
-38702,
-38249,
-37729,
-37113,
-36419,
-35756,
-35209,
-34801,
-34465,
-34060,
-33503,
-32751,
-31865,
-30919,
-29932,
-28913,
-27835,
-26726,
-25695,
-24821,
-24201,
-23784,
-23499,
-23215,
-22890,
-22508,
-22122,
-21768,
-21425,
-21053,
-20571,
-19966,
-19254,
-18527,
-17850,
-17294,
-16836,
-16458,
-16102,
-15769,
-15482,
-15280,
-15172,
-15120,
-15059,
-14954,
-14824,
-14783,
-14922,
-15287,
-15796,
-16301,
-16653,
-16815,
-16863,
-16916,
-17050,
-17236,
-17371,
-17422,
-17425,
-17561,
-17948,
-18613,
-19415,
-20171,
-20790,
-21333,
-21947,
-22744,
-23649,
-24487,
-25048,
-25323,
-25419,
-25589,
-25922,
-26409,
-26863,
-27185,
-27371,
-27570,
-27923,
-28436,
-28981,
-29386,
-29578,
-29658,
-29827,
-30217,
-30838,
-31524,
-32096,
-32459,
-32677,
-32841,
-33058,
-33264,
-33369,
-33293,
-33049,
-32776,
-32601,
-32593,
-32716,
-32859,
-32973,
-33053,
-33189,
-33426,
-33772,
-34127,
-34401,
-34516,
-34475,
-34322,
-34112,
-33887,
-33676,
-33479,
-33306,
-33141,
-32974,
-32806,
-32637,
-32500,
-32362,
-32221,
-32010,
-31766,
-31531,
-31437,
-31520,
-31770,
-32047,
-32210,
-32233,
-32152,
-32116,
-32159,
-32236,
-32210,
-32003,
-31659,
-31336,
-31192,
-31254,
-31443,
-31619,
-31736,
-31875,
-32178,
-32695,
-33370,
-33992,
-34417,
-34595,
-34656,
-34749,
-34993,
-35343,
-35710,
-35998,
-36219,
-36452,
-36787,
-37229,
-37700,
-38082,
-38326,
-38476,
-38658,
-38986,
-39489,
-40109,
-40733,
-41294,
-41796,
-42293,
-42838,
-43418,
-43957,
-44353,
-44551,
-44567,
-44476,
-44376,
-44303,
-44295,
-44312,
-44383,
-44491,
-44723,
-45062,
-45539,
-46052,
-46504,
-46804,
-46896,
-46850,
-46740,
-46675,
-46667,
-46671,
-46621,
-46488,
-46314,
-46202,
-46173,
-46205,
-46170,
-45975,
-45627,
-45218,
-44899,
-44726,
-44667,
-44609,
-44484,
-44312,
-44170,
-44148,
-44214,
-44263,
-44146,
-43783,
-43192,
-42461,
-41684,
-40901,
-40123,
-39337,
-38582,
-37909,
-37386,
-37045,
-36856,
-36742,
-36603,
-36346,
-35938,
-35391,
-34786,
-34206,
-33684,
-33229,
-32762,
-32270,
-31754,
-31300,
-30977,
-30785,
-30628,
-30375,
-29930,
-29356,
-28775,
-28338,
-28085,
-27905,
-27688,
-27359,
-27027,
-26862,
-26973,
-27291,
-27562,
-27534,
-27111,
-26418,
-25713,
-25161,
-24760,
-24330,
-23768,
-23104,
-22614,
-22513,
-22871,
-23461,
-23943,
-24113,
-24006,
-23889,
-23989,
-24327,
-24697,
-24844,
-24707,
-24456,
-24405,
-24735,
-25364,
-26023,
-26467,
-26642,
-26729,
-26934,
-27355,
-27852,
-28234,
-28362,
-28335,
-28396,
-28748,
-29446,
-30303,
-31077,
-31599,
-31849,
-31953,
-32006,
-32021,
-31923,
-31611,
-31115,
-30570,
-30159,
-30031,
-30178,
-30496,
-30837,
-31117,
-31325,
-31530,
-31751,
-31988,
-32141,
-32145,
-31952,
-31627,
-31262,
-30985,
-30832,
-30796,
-30789,
-30741,
-30631,
-30475,
-30326,
-30176,
-29986,
-29677,
-29227,
-28692,
-28198,
-27866,
-27744,
-27759,
-27799,
-27725,
-27506,
-27140,
-26690,
-26133,
-25489,
-24696,
-23797,
-22871,
-22019,
-21364,
-20930,
-20721,
-20669,
-20736,
-20855,
-21025,
-21228,
-21454,
-21685,
-21845,
-21895,
-21791,
-21592,
-21396,
-21338,
-21472,
-21791,
-22172,
-22535,
-22835,
-23123,
-23452,
-23849,
-24214,
-24480,
-24589,
-24659,
-24849,
-25319,
-26066,
-26958,
-27788,
-28442,
-28928,
-29370,
-29846,
-30350,
-30729,
-30873,
-30767,
-30589,
-30555,
-30829,
-31380,
-32059,
-32707,
-33323,
-34017,
-34937,
-36067,
-37247,
-38195,
-38769,
-39012,
-39139,
-39365,
-39759,
-40213,
-40583,
-40809,
-40984,
-41252,
-41677,
-42145,
-42492,
-42555,
-42392,
-42149,
-42022,
-42079,
-42265,
-42464,
-42600,
-42687,
-42788,
-42920,
-43068,
-43122,
-43039,
-42762,
-42340,
-41791,
-41181,
-40548,
-39972,
-39506,
-39212,
-39087,
-39135,
-39334,
-39684,
-40169,
-40693,
-41130,
-41332,
-41245,
-40928,
-40542,
-40213,
-39990,
-39797,
-39539,
-39196,
-38836,
-38589,
-38491,
-38467,
-38364,
-38076,
-37635,
-37201,
-36941,
-36904,
-36991,
-37035,
-36944,
-36781,
-36696,
-36811,
-37084,
-37332,
-37340,
-37024,
-36472,
-35878,
-35388,
-35031,
-34704,
-34371,
-34067,
-33979,
-34263,
-34934,
-35840,
-36721,
-37394,
-37819,
-38113,
-38375,
-38658,
-38880,
-38943,
-38824,
-38603,
-38422,
-38371,
-38452,
-38554,
-38594,
-38519,
-38399,
-38317,
-38344,
-38455,
-38599,
-38697,
-38754,
-38818,
-38961,
-39249,
-39647,
-40113,
-40512,
-40789,
-40872,
-40788,
-40550,
-40206,
-39773,
-39287,
-38777,
-38338,
-38061,
-38052,
-38323,
-38819,
-39386,
-39881,
-40224,
-40414,
-40542,
-40625,
-40672,
-40564,
-40251,
-39724,
-39088,
-38459,
-37895,
-37350,
-36732,
-35998,
-35192,
-34452,
-33855,
-33391,
-32938,
-32353,
-31631,
-30859,
-30208,
-29782,
-29555,
-29407,
-29214,
-28900,
-28486,
-27974,
-27359,
-26575,
-25609,
-24502,
-23388,
-22411,
-21650,
-21122,
-20764,
-20522,
-20352,
-20240,
-20177,
-20160,
-20174,
-20222,
-20276,
-20300,
-20216,
-19970,
-19547,
-19016,
-18467,
-17978,
-17565,
-17205,
-16850,
-16537,
-16267,
-16088,
-15939,
-15768,
-15504,
-15208,
-14983,
-14976,
-15241,
-15702,
-16214,
-16615,
-16859,
-16970,
-17048,
-17121,
-17198,
-17205,
-17133,
-17019,
-16950,
-17004,
-17186,
-17435,
-17672,
-17879,
-18112,
-18492,
-19094,
-19895,
-20769,
-21552,
-22143,
-22550,
-22876,
-23211,
-23599,
-23986,
-24310,
-24567,
-24810,
-25128,
-25546,
-26013,
-26422,
-26734,
-26980,
-27303,
-27807,
-28529,
-29393,
-30273,
-31098,
-31847,
-32569,
-33291,
-34024,
-34731,
-35416,
-36082,
-36745,
-37407,
-38033,
-38597,
-39082,
-39517,
-39917,
-40317,
-40740,
-41230,
-41842,
-42614,
-43508,
-44423,
-45228,
-45868,
-46366,
-46841,
-47328,
-47831,
-48205,
-48403,
-48407,
-48341,
-48286,
-48255,
-48174,
-47947,
-47613,
-47288,
-47124,
-47165,
-47295,
-47353,
-47214,
-46908,
-46543,
-46230,
-45975,
-45728,
-45415,
-45068,
-44721,
-44431,
-44135,
-43741,
-43154,
-42387,
-41525,
-40682,
-39908,
-39224,
-38580,
-38008,
-37516,
-37145,
-36869,
-36648,
-36429,
-36227,
-36043,
-35912,
-35776,
-35556,
-35189,
-34647,
-33996,
-33300,
-32640,
-32027,
-31488,
-31012,
-30635,
-30362,
-30197,
-30102,
-30018,
-29916,
-29773,
-29615,
-29496,
-29455,
-29529,
-29698,
-29894,
-30071,
-30174,
-30230,
-30269,
-30310,
-30321,
-30245,
-30042,
-29771,
-29542,
-29469,
-29599,
-29873,
-30214,
-30597,
-31054,
-31674,
-32451,
-33319,
-34122,
-34769,
-35236,
-35583,
-35864,
-36074,
-36168,
-36119,
-35984,
-35862,
-35859,
-36015,
-36300,
-36671,
-37088,
-37531,
-37973,
-38373,
-38718,
-39027,
-39395,
-39847,
-40401,
-40933,
-41365,
-41659,
-41853,
-42023,
-42144,
-42156,
-41975,
-41654,
-41329,
-41164,
-41190,
-41297,
-41308,
-41167,
-40976,
-40942,
-41191,
-41665,
-42165,
-42490,
-42583,
-42496,
-42302,
-41974,
-41405,
-40521,
-39393,
-38217,
-37199,
-36413,
-35766,
-35121,
-34360,
-33552,
-32751,
-32076,
-31485,
-30965,
-30459,
-29980,
-29525,
-29053,
-28478,
-27740,
-26841,
-25872,
-24936,
-24094,
-23335,
-22606,
-21891,
-21186,
-20517,
-19870,
-19221,
-18580,
-18022,
-17649,
-17566,
-17752,
-18129,
-18537,
-18870,
-19062,
-19127,
-19077,
-18957,
-18764,
-18516,
-18213,
-17872,
-17512,
-17177,
-16910,
-16763,
-16743,
-16864,
-17109,
-17524,
-18129,
-18921,
-19803,
-20612,
-21216,
-21565,
-21770,
-21958,
-22243,
-22591,
-22944,
-23221,
-23474,
-23776,
-24188,
-24656,
-25083,
-25381,
-25591,
-25829,
-26219,
-26795,
-27495,
-28216,
-28911,
-29583,
-30264,
-30936,
-31539,
-32012,
-32322,
-32502,
-32582,
-32541,
-32382,
-32088,
-31740,
-31452,
-31300,
-31321,
-31477,
-31761,
-32202,
-32853,
-33687,
-34570,
-35298,
-35716,
-35857,
-35854,
-35912,
-36075,
-36290,
-36434,
-36495,
-36578,
-36819,
-37262,
-37775,
-38181,
-38379,
-38478,
-38666,
-39101,
-39725,
-40346,
-40778,
-40998,
-41146,
-41393,
-41792,
-42251,
-42592,
-42750,
-42721,
-42583,
-42346,
-41923,
-41253,
-40345,
-39355,
-38500,
-37913,
-37652,
-37615,
-37724,
-37871,
-37988,
-38009,
-37876,
-37574,
-37141,
-36625,
-36075,
-35480,
-34826,
-34120,
-33400,
-32727,
-32123,
-31584,
-31122,
-30754,
-30524,
-30403,
-30288,
-30059,
-29639,
-29105,
-28588,
-28215,
-28013,
-27938,
-27956,
-28082,
-28335,
-28651,
-28843,
-28744,
-28285,
-27634,
-27017,
-26625,
-26445,
-26366,
-26314,
-26365,
-26673,
-27344,
-28283,
-29295,
-30213,
-31016,
-31829,
-32712,
-33616,
-34354,
-34803,
-34979,
-35087,
-35333,
-35817,
-36503,
-37276,
-38044,
-38811,
-39553,
-40274,
-40910,
-41459,
-41920,
-42364,
-42795,
-43242,
-43686,
-44158,
-44682,
-45236,
-45761,
-46116,
-46278,
-46250,
-46157,
-46018,
-45785,
-45323,
-44586,
-43686,
-42878,
-42380,
-42257,
-42389,
-42591,
-42760,
-42954,
-43221,
-43583,
-43849,
-43844,
-43441,
-42745,
-41940,
-41217,
-40602,
-40003,
-39322,
-38573,
-37878,
-37375,
-37082,
-36886,
-36596,
-36106,
-35425,
-34671,
-33976,
-33390,
-32920,
-32556,
-32294,
-32164,
-32127,
-32094,
-31941,
-31564,
-30927,
-30080,
-29088,
-28036,
-27010,
-26070,
-25305,
-24715,
-24314,
-24025,
-23862,
-23832,
-24008,
-24376,
-24862,
-25292,
-25539,
-25556,
-25380,
-25097,
-24714,
-24247,
-23690,
-23121,
-22659,
-22357,
-22207,
-22069,
-21873,
-21592,
-21325,
-21174,
-21185,
-21331,
-21571,
-21884,
-22278,
-22737,
-23201,
-23610,
-23957,
-24311,
-24737,
-25242,
-25704,
-25991,
-26022,
-25880,
-25677,
-25543,
-25489,
-25526,
-25726,
-26223,
-27150,
-28476,
-30001,
-31438,
-32616,
-33535,
-34329,
-35117,
-35861,
-36454,
-36795,
-36913,
-36925,
-36941,
-36964,
-36951,
-36839,
-36706,
-36623,
-36697,
-36900,
-37159,
-37393,
-37572,
-37721,
-37869,
-38037,
-38241,
-38509,
-38837,
-39163,
-39358,
-39273,
-38883,
-38279,
-37612,
-36991,
-36354,
-35618,
-34731,
-33843,
-33114,
-32683,
-32447,
-32254,
-32002,
-31779,
-31798,
-32139,
-32672,
-33063,
-33040,
-32574,
-31871,
-31153,
-30501,
-29788,
-28914,
-27902,
-26970,
-26307,
-25940,
-25726,
-25505,
-25283,
-25206,
-25431,
-25927,
-26518,
-27002,
-27339,
-27660,
-28089,
-28656,
-29229,
-29705,
-30096,
-30531,
-31075,
-31646,
-32017,
-32045,
-31793,
-31537,
-31534,
-31882,
-32448,
-33070,
-33683,
-34401,
-35338,
-36510,
-37745,
-38839,
-39656,
-40232,
-40661,
-40985,
-41151,
-41028,
-40555,
-39787,
-38932,
-38226,
-37868,
-37885,
-38191,
-38560,
-38834,
-38943,
-38960,
-39030,
-39190,
-39389,
-39482,
-39414,
-39283,
-39266,
-39450,
-39706,
-39758,
-39387,
-38634,
-37769,
-37083,
-36638,
-36242,
-35605,
-34639,
-33533,
-32632,
-32177,
-32142,
-32312,
-32473,
-32594,
-32763,
-33047,
-33334,
-33396,
-33014,
-32188,
-31111,
-30049,
-29193,
-28508,
-27901,
-27245,
-26564,
-25984,
-25628,
-25580,
-25782,
-26131,
-26520,
-26880,
-27202,
-27466,
-27653,
-27739,
-27723,
-27682,
-27715,
-27892,
-28217,
-28584,
-28841,
-28887,
-28650,
-28193,
-27595,
-26987,
-26487,
-26193,
-26158,
-26381,
-26809,
-27392,
-28090,
-28853,
-29658,
-30388,
-30968,
-31346,
-31511,
-31518,
-31369,
-31046,
-30572,
-30041,
-29682,
-29671,
-30058,
-30691,
-31339,
-31867,
-32330,
-32837,
-33479,
-34150,
-34729,
-35183,
-35674,
-36399,
-37396,
-38448,
-39226,
-39540,
-39513,
-39452,
-39593,
-39910,
-40160,
-40127,
-39823,
-39453,
-39240,
-39233,
-39314,
-39338,
-39346,
-39474,
-39895,
-40596,
-41396,
-42034,
-42345,
-42291,
-41971,
-41525,
-41060,
-40630,
-40202,
-39694,
-39050,
-38277,
-37542,
-36999,
-36748,
-36665,
-36556,
-36249,
-35823,
-35430,
-35219,
-35078,
-34776,
-34122,
-33234,
-32437,
-32031,
-31999,
-32021,
-31693,
-30858,
-29688,
-28499,
-27480,
-26583,
-25632,
-24582,
-23578,
-22840,
-22494,
-22405,
-22373,
-22229,
-21996,
-21808,
-21776,
-21892,
-22086,
-22232,
-22311,
-22262,
-22129,
-21901,
-21670,
-21522,
-21526,
-21674,
-21872,
-22058,
-22240,
-22523,
-22967,
-23562,
-24170,
-24724,
-25209,
-25761,
-26456,
-27277,
-28081,
-28736,
-29218,
-29650,
-30172,
-30829,
-31549,
-32199,
-32679,
-33014,
-33248,
-33458,
-33664,
-33886,
-34170,
-34561,
-35132,
-35863,
-36724,
-37643,
-38560,
-39445,
-40243,
-40941,
-41493,
-41947,
-42317,
-42661,
-42986,
-43253,
-43440,
-43521,
-43551,
-43593,
-43705,
-43884,
-44068,
-44190,
-44196,
-44137,
-44075,
-44085,
-44147,
-44189,
-44130,
-43956,
-43762,
-43633,
-43619,
-43606,
-43467,
-43099,
-42568,
-41994,
-41490,
-41023,
-40472,
-39718,
-38814,
-37907,
-37207,
-36778,
-36543,
-36378,
-36164,
-35938,
-35734,
-35584,
-35416,
-35104,
-34568,
-33821,
-32950,
-32090,
-31304,
-30623,
-29976,
-29331,
-28617,
-27881,
-27165,
-26535,
-25988,
-25447,
-24824,
-24080,
-23315,
-22663,
-22247,
-22019,
-21856,
-21607,
-21281,
-20978,
-20806,
-20755,
-20651,
-20337,
-19784,
-19120,
-18570,
-18222,
-18037,
-17885,
-17715,
-17603,
-17719,
-18114,
-18768,
-19488,
-20166,
-20755,
-21303,
-21853,
-22382,
-22832,
-23145,
-23339,
-23487,
-23663,
-23946,
-24351,
-24893,
-25543,
-26254,
-26952,
-27608,
-28215,
-28825,
-29453,
-30086,
-30677,
-31239,
-31834,
-32612,
-33618,
-34802,
-35984,
-36984,
-37743,
-38306,
-38777,
-39181,
-39463,
-39561,
-39514,
-39477,
-39679,
-40205,
-41021,
-41946,
-42816,
-43583,
-44294,
-45008,
-45694,
-46234,
-46482,
-46431,
-46147,
-45837,
-45616,
-45514,
-45454,
-45341,
-45150,
-44938,
-44783,
-44690,
-44586,
-44343,
-43917,
-43358,
-42824,
-42446,
-42287,
-42277,
-42312,
-42294,
-42201,
-42053,
-41855,
-41570,
-41129,
-40473,
-39618,
-38628,
-37641,
-36727,
-35974,
-35339,
-34809,
-34349,
-33974,
-33735,
-33648,
-33689,
-33738,
-33659,
-33352,
-32813,
-32132,
-31429,
-30746,
-30086,
-29373,
-28627,
-27896,
-27282,
-26830,
-26468,
-26086,
-25568,
-24926,
-24259,
-23723,
-23392,
-23264,
-23251,
-23257,
-23265,
-23291,
-23389,
-23567,
-23743,
-23825,
-23713,
-23402,
-23003,
-22622,
-22364,
-22183,
-22014,
-21773,
-21531,
-21440,
-21671,
-22246,
-23006,
-23725,
-24222,
-24540,
-24815,
-25195,
-25655,
-26046,
-26231,
-26236,
-26255,
-26513,
-27036,
-27676,
-28148,
-28333,
-28321,
-28378,
-28705,
-29311,
-30007,
-30601,
-31056,
-31515,
-32158,
-33034,
-34013,
-34874,
-35514,
-35990,
-36502,
-37171,
-37967,
-38688,
-39143,
-39294,
-39281,
-39353,
-39639,
-40142,
-40700,
-41173,
-41545,
-41870,
-42297,
-42801,
-43316,
-43670,
-43827,
-43834,
-43878,
-44080,
-44405,
-44720,
-44811,
-44620,
-44241,
-43866,
-43666,
-43638,
-43677,
-43621,
-43434,
-43189,
-42999,
-42904,
-42827,
-42627,
-42255,
-41773,
-41383,
-41216,
-41274,
-41397,
-41366,
-41072,
-40561,
-39985,
-39485,
-39081,
-38694,
-38222,
-37663,
-37085,
-36628,
-36312,
-36082,
-35778,
-35323,
-34716,
-34093,
-33571,
-33204,
-32906,
-32545,
-32040,
-31410,
-30802,
-30308,
-29983,
-29732,
-29462,
-29090,
-28667,
-28248,
-27922,
-27642,
-27375,
-27055,
-26704,
-26426,
-26287,
-26334,
-26484,
-26620,
-26633,
-26487,
-26220,
-25903,
-25638,
-25443,
-25368,
-25377,
-25470,
-25616,
-25798,
-25973,
-26110,
-26153,
-26075,
-25890,
-25661,
-25492,
-25482,
-25655,
-25967,
-26308,
-26566,
-26697,
-26712,
-26679,
-26634,
-26591,
-26510,
-26369,
-26205,
-26071,
-26085,
-26263,
-26573,
-26920,
-27213,
-27459,
-27718,
-28091,
-28551,
-29008,
-29281,
-29281,
-29091,
-28895,
-28901,
-29147,
-29510,
-29793,
-29895,
-29879,
-29895,
-30038,
-30222,
-30285,
-30110,
-29790,
-29582,
-29723,
-30238,
-30919,
-31450,
-31675,
-31650,
-31602,
-31697,
-31891,
-32000,
-31820,
-31359,
-30795,
-30360,
-30137,
-30032,
-29830,
-29473,
-29056,
-28847,
-29035,
-29581,
-30253,
-30741,
-30909,
-30836,
-30725,
-30747,
-30872,
-30951,
-30853,
-30567,
-30283,
-30153,
-30231,
-30355,
-30297,
-29939,
-29378,
-28859,
-28618,
-28706,
-28975,
-29243,
-29397,
-29551,
-29857,
-30426,
-31163,
-31851,
-32264,
-32368,
-32244,
-32102,
-31985,
-31862,
-31571,
-31076,
-30497,
-30087,
-30073,
-30496,
-31199,
-31932,
-32530,
-33002,
-33488,
-34108,
-34853,
-35563,
-36112,
-36452,
-36745,
-37161,
-37776,
-38468,
-39010,
-39227,
-39136,
-38947,
-38875,
-39031,
-39341,
-39636,
-39856,
-40074,
-40472,
-41178,
-42141,
-43180,
-44061,
-44724,
-45218,
-45693,
-46186,
-46617,
-46789,
-46598,
-46076,
-45437,
-44907,
-44604,
-44499,
-44447,
-44370,
-44289,
-44319,
-44566,
-44987,
-45461,
-45802,
-45957,
-45992,
-46048,
-46233,
-46476,
-46642,
-46553,
-46190,
-45647,
-45116,
-44670,
-44306,
-43889,
-43351,
-42703,
-42100,
-41653,
-41413,
-41279,
-41120,
-40885,
-40628,
-40469,
-40480,
-40584,
-40618,
-40401,
-39860,
-39059,
-38120,
-37142,
-36153,
-35140,
-34095,
-33103,
-32255,
-31647,
-31295,
-31113,
-30998,
-30837,
-30595,
-30287,
-29963,
-29662,
-29365,
-29016,
-28538,
-27914,
-27187,
-26474,
-25869,
-25385,
-24930,
-24398,
-23722,
-23001,
-22356,
-21915,
-21627,
-21382,
-21049,
-20685,
-20427,
-20471,
-20799,
-21238,
-21484,
-21361,
-20886,
-20239,
-19592,
-18981,
-18303,
-17474,
-16528,
-15667,
-15114,
-14951,
-15083,
-15293,
-15427,
-15485,
-15602,
-15922,
-16473,
-17140,
-17740,
-18141,
-18360,
-18491,
-18674,
-18931,
-19216,
-19404,
-19468,
-19457,
-19510,
-19742,
-20124,
-20546,
-20871,
-21059,
-21242,
-21594,
-22233,
-23137,
-24125,
-25048,
-25831,
-26548,
-27250,
-27975,
-28570,
-28967,
-29093,
-29074,
-29072,
-29194,
-29458,
-29770,
-30083,
-30420,
-30890,
-31582,
-32525,
-33610,
-34712,
-35711,
-36570,
-37306,
-37950,
-38530,
-39031,
-39455,
-39813,
-40140,
-40493,
-40905,
-41366,
-41818,
-42172,
-42360,
-42407,
-42405,
-42515,
-42847,
-43416,
-44135,
-44889,
-45613,
-46311,
-47054,
-47820,
-48517,
-48982,
-49076,
-48853,
-48444,
-48075,
-47809,
-47602,
-47286,
-46787,
-46180,
-45672,
-45466,
-45574,
-45838,
-46040,
-46059,
-46004,
-46057,
-46350,
-46825,
-47259,
-47445,
-47344,
-47085,
-46868,
-46765,
-46662,
-46366,
-45728,
-44790,
-43725,
-42747,
-41941,
-41267,
-40596,
-39856,
-39081,
-38370,
-37857,
-37545,
-37367,
-37163,
-36826,
-36343,
-35821,
-35361,
-35019,
-34672,
-34157,
-33343,
-32251,
-31051,
-29947,
-29016,
-28217,
-27403,
-26540,
-25682,
-24988,
-24523,
-24206,
-23859,
-23325,
-22629,
-21924,
-21392,
-21105,
-20953,
-20778,
-20451,
-19986,
-19463,
-18963,
-18488,
-17964,
-17352,
-16664,
-16004,
-15522,
-15274,
-15266,
-15356,
-15453,
-15485,
-15521,
-15687,
-16054,
-16598,
-17130,
-17483,
-17568,
-17492,
-17423,
-17481,
-17619,
-17679,
-17575,
-17374,
-17321,
-17577,
-18150,
-18787,
-19245,
-19461,
-19628,
-20062,
-20932,
-22143,
-23411,
-24512,
-25405,
-26271,
-27252,
-28328,
-29286,
-29917,
-30178,
-30284,
-30503,
-31004,
-31677,
-32295,
-32655,
-32786,
-32909,
-33282,
-34025,
-35043,
-36136,
-37172,
-38161,
-39237,
-40474,
-41811,
-43036,
-43976,
-44588,
-45060,
-45624,
-46418,
-47357,
-48176,
-48663,
-48751,
-48627,
-48522,
-48597,
-48830,
-49059,
-49208,
-49298,
-49506,
-49959,
-50627,
-51319,
-51791,
-51935,
-51866,
-51814,
-51998,
-52387,
-52818,
-52980,
-52771,
-52246,
-51658,
-51208,
-50962,
-50786,
-50519,
-50091,
-49583,
-49178,
-48949,
-48838,
-48632,
-48159,
-47401,
-46541,
-45824,
-45406,
-45215,
-45025,
-44547,
-43677,
-42473,
-41209,
-40098,
-39251,
-38567,
-37852,
-36988,
-36020,
-35131,
-34472,
-34032,
-33580,
-32878,
-31839,
-30666,
-29720,
-29217,
-29084,
-28921,
-28319,
-27135,
-25582,
-24097,
-22957,
-22171,
-21471,
-20613,
-19593,
-18639,
-17998,
-17744,
-17642,
-17410,
-16864,
-16126,
-15521,
-15314,
-15567,
-16064,
-16452,
-16520,
-16230,
-15800,
-15452,
-15317,
-15319,
-15286,
-15062,
-14661,
-14226,
-13948,
-13873,
-13921,
-13903,
-13776,
-13626,
-13706,
-14172,
-15005,
-15957,
-16735,
-17204,
-17431,
-17655,
-18046,
-18664,
-19386,
-20115,
-20770,
-21408,
-22028,
-22625,
-23106,
-23413,
-23600,
-23773,
-24107,
-24642,
-25395,
-26234,
-27090,
-27882,
-28599,
-29244,
-29842,
-30433,
-31079,
-31838,
-32737,
-33740,
-34756,
-35662,
-36377,
-36884,
-37254,
-37600,
-38027,
-38574,
-39205,
-39844,
-40421,
-40930,
-41389,
-41821,
-42218,
-42512,
-42694,
-42790,
-42926,
-43198,
-43641,
-44126,
-44493,
-44599,
-44479,
-44303,
-44263,
-44456,
-44789,
-45088,
-45211,
-45163,
-45081,
-45087,
-45226,
-45372,
-45414,
-45322,
-45204,
-45236,
-45462,
-45774,
-45932,
-45758,
-45243,
-44586,
-43999,
-43622,
-43402,
-43205,
-42928,
-42569,
-42197,
-41870,
-41566,
-41207,
-40767,
-40251,
-39798,
-39478,
-39337,
-39317,
-39295,
-39183,
-38916,
-38506,
-38013,
-37508,
-37060,
-36662,
-36289,
-35873,
-35388,
-34864,
-34329,
-33833,
-33326,
-32792,
-32207,
-31665,
-31258,
-31071,
-31060,
-31105,
-31081,
-30955,
-30783,
-30665,
-30656,
-30706,
-30749,
-30701,
-30578,
-30416,
-30266,
-30137,
-29991,
-29791,
-29488,
-29102,
-28654,
-28240,
-27896,
-27642,
-27414,
-27102,
-26684,
-26194,
-25834,
-25725,
-25893,
-26178,
-26360,
-26327,
-26161,
-26052,
-26149,
-26377,
-26528,
-26420,
-26067,
-25726,
-25633,
-25874,
-26232,
-26410,
-26207,
-25746,
-25307,
-25166,
-25342,
-25643,
-25810,
-25775,
-25686,
-25776,
-26167,
-26734,
-27199,
-27365,
-27223,
-27001,
-26952,
-27160,
-27499,
-27725,
-27674,
-27379,
-27042,
-26841,
-26840,
-26914,
-26913,
-26791,
-26657,
-26703,
-27041,
-27605,
-28195,
-28612,
-28789,
-28824,
-28898,
-29110,
-29426,
-29708,
-29838,
-29825,
-29798,
-29908,
-30207,
-30602,
-30926,
-31087,
-31126,
-31222,
-31521,
-32057,
-32695,
-33270,
-33700,
-34075,
-34547,
-35218,
-36003,
-36695,
-37094,
-37137,
-36942,
-36679,
-36466,
-36289,
-36068,
-35773,
-35483,
-35354,
-35519,
-35975,
-36606,
-37223,
-37705,
-38043,
-38337,
-38726,
-39296,
-40027,
-40797,
-41480,
-41973,
-42313,
-42557,
-42769,
-42905,
-42869,
-42576,
-42086,
-41571,
-41253,
-41245,
-41467,
-41737,
-41884,
-41913,
-41943,
-42163,
-42607,
-43198,
-43752,
-44122,
-44309,
-44342,
-44338,
-44257,
-44082,
-43693,
-43098,
-42328,
-41527,
-40823,
-40300,
-39950,
-39664,
-39350,
-38945,
-38539,
-38266,
-38241,
-38438,
-38690,
-38779,
-38585,
-38168,
-37696,
-37331,
-37070,
-36791,
-36330,
-35646,
-34845,
-34088,
-33464,
-32885,
-32185,
-31245,
-30130,
-29103,
-28438,
-28282,
-28520,
-28882,
-29081,
-28997,
-28691,
-28333,
-27979,
-27614,
-27072,
-26318,
-25432,
-24626,
-24078,
-23777,
-23536,
-23147,
-22517,
-21814,
-21246,
-21016,
-21067,
-21250,
-21365,
-21387,
-21384,
-21464,
-21627,
-21781,
-21830,
-21776,
-21701,
-21692,
-21702,
-21597,
-21250,
-20657,
-19999,
-19460,
-19164,
-19042,
-18995,
-18977,
-19082,
-19441,
-20061,
-20778,
-21356,
-21665,
-21855,
-22183,
-22886,
-23872,
-24840,
-25433,
-25543,
-25390,
-25321,
-25581,
-26094,
-26617,
-26944,
-27128,
-27417,
-28017,
-28877,
-29696,
-30129,
-30110,
-29869,
-29850,
-30307,
-31227,
-32269,
-33105,
-33587,
-33811,
-34009,
-34299,
-34660,
-34933,
-35033,
-34993,
-35016,
-35250,
-35774,
-36441,
-37077,
-37533,
-37839,
-38163,
-38688,
-39478,
-40404,
-41242,
-41798,
-42062,
-42191,
-42374,
-42735,
-43208,
-43696,
-44102,
-44457,
-44810,
-45171,
-45440,
-45473,
-45215,
-44733,
-44224,
-43842,
-43655,
-43583,
-43527,
-43390,
-43146,
-42802,
-42382,
-41929,
-41511,
-41204,
-41037,
-40954,
-40865,
-40664,
-40357,
-39981,
-39599,
-39205,
-38799,
-38388,
-38101,
-38050,
-38260,
-38584,
-38775,
-38652,
-38254,
-37785,
-37502,
-37486,
-37667,
-37845,
-37973,
-38060,
-38248,
-38512,
-38732,
-38686,
-38286,
-37593,
-36840,
-36192,
-35663,
-35127,
-34413,
-33491,
-32490,
-31588,
-30953,
-30558,
-30345,
-30163,
-29972,
-29748,
-29520,
-29294,
-29072,
-28860,
-28691,
-28598,
-28618,
-28743,
-28935,
-29134,
-29247,
-29179,
-28888,
-28377,
-27811,
-27363,
-27223,
-27411,
-27821,
-28257,
-28598,
-28839,
-29062,
-29347,
-29642,
-29855,
-29901,
-29815,
-29721,
-29711,
-29725,
-29611,
-29198,
-28475,
-27627,
-26851,
-26312,
-25974,
-25737,
-25522,
-25366,
-25344,
-25531,
-25874,
-26294,
-26723,
-27160,
-27654,
-28187,
-28719,
-29125,
-29376,
-29474,
-29512,
-29545,
-29608,
-29703,
-29817,
-29966,
-30129,
-30275,
-30370,
-30406,
-30449,
-30598,
-30937,
-31473,
-32161,
-32894,
-33593,
-34147,
-34506,
-34598,
-34444,
-34086,
-33622,
-33113,
-32598,
-32064,
-31567,
-31133,
-30834,
-30628,
-30456,
-30229,
-30004,
-29907,
-30102,
-30603,
-31245,
-31793,
-32096,
-32224,
-32374,
-32708,
-33166,
-33528,
-33583,
-33309,
-32918,
-32674,
-32691,
-32824,
-32835,
-32571,
-32144,
-31861,
-31954,
-32448,
-33066,
-33495,
-33568,
-33424,
-33358,
-33602,
-34132,
-34666,
-34903,
-34682,
-34168,
-33610,
-33232,
-32997,
-32714,
-32233,
-31580,
-31030,
-30870,
-31215,
-31885,
-32537,
-32878,
-32863,
-32699,
-32634,
-32817,
-33141,
-33419,
-33473,
-33333,
-33142,
-33063,
-33117,
-33179,
-33064,
-32683,
-32116,
-31550,
-31173,
-31022,
-31022,
-31032,
-31018,
-31036,
-31223,
-31649,
-32242,
-32862,
-33321,
-33580,
-33643,
-33604,
-33491,
-33318,
-33096,
-32888,
-32794,
-32863,
-33054,
-33251,
-33354,
-33361,
-33362,
-33444,
-33632,
-33821,
-33967,
-34049,
-34204,
-34519,
-34977,
-35429,
-35665,
-35641,
-35453,
-35356,
-35471,
-35784,
-36071,
-36149,
-35964,
-35674,
-35492,
-35541,
-35767,
-36012,
-36162,
-36253,
-36427,
-36806,
-37361,
-37902,
-38225,
-38215,
-37998,
-37776,
-37738,
-37915,
-38159,
-38332,
-38349,
-38305,
-38312,
-38484,
-38754,
-39043,
-39226,
-39301,
-39305,
-39302,
-39298,
-39270,
-39192,
-39053,
-38902,
-38753,
-38636,
-38541,
-38475,
-38397,
-38256,
-37963,
-37475,
-36852,
-36266,
-35908,
-35888,
-36120,
-36425,
-36625,
-36689,
-36712,
-36796,
-36938,
-37007,
-36867,
-36529,
-36149,
-35934,
-35973,
-36139,
-36213,
-36017,
-35577,
-35041,
-34622,
-34348,
-34165,
-33904,
-33493,
-32974,
-32446,
-32018,
-31689,
-31394,
-31048,
-30618,
-30125,
-29641,
-29200,
-28800,
-28376,
-27864,
-27259,
-26621,
-26080,
-25743,
-25614,
-25615,
-25596,
-25463,
-25214,
-24926,
-24671,
-24480,
-24291,
-24086,
-23861,
-23697,
-23631,
-23613,
-23546,
-23302,
-22912,
-22474,
-22153,
-22011,
-22014,
-22042,
-22050,
-22046,
-22120,
-22281,
-22464,
-22573,
-22546,
-22490,
-22515,
-22739,
-23068,
-23364,
-23452,
-23323,
-23093,
-22917,
-22889,
-22970,
-23061,
-23130,
-23203,
-23395,
-23740,
-24220,
-24712,
-25159,
-25544,
-25954,
-26484,
-27133,
-27871,
-28562,
-29142,
-29574,
-29919,
-30241,
-30624,
-31064,
-31536,
-31955,
-32264,
-32445,
-32551,
-32645,
-32783,
-32967,
-33174,
-33406,
-33731,
-34213,
-34899,
-35683,
-36401,
-36886,
-37117,
-37229,
-37431,
-37835,
-38428,
-39033,
-39555,
-39968,
-40405,
-40935,
-41556,
-42070,
-42374,
-42433,
-42447,
-42621,
-43033,
-43578,
-44005,
-44180,
-44149,
-44116,
-44279,
-44631,
-45015,
-45215,
-45155,
-44929,
-44705,
-44581,
-44519,
-44389,
-44153,
-43853,
-43669,
-43693,
-43920,
-44181,
-44291,
-44140,
-43756,
-43268,
-42841,
-42552,
-42424,
-42365,
-42284,
-42121,
-41868,
-41592,
-41316,
-41049,
-40699,
-40231,
-39646,
-39084,
-38673,
-38468,
-38352,
-38149,
-37730,
-37154,
-36618,
-36292,
-36221,
-36219,
-36103,
-35756,
-35254,
-34749,
-34311,
-33912,
-33433,
-32842,
-32230,
-31744,
-31472,
-31330,
-31146,
-30760,
-30166,
-29473,
-28850,
-28394,
-28107,
-27946,
-27849,
-27800,
-27782,
-27774,
-27746,
-27677,
-27565,
-27426,
-27288,
-27171,
-27094,
-27050,
-26990,
-26838,
-26520,
-26027,
-25450,
-24928,
-24569,
-24368,
-24236,
-24037,
-23757,
-23412,
-23111,
-22869,
-22669,
-22482,
-22324,
-22297,
-22464,
-22827,
-23239,
-23559,
-23681,
-23654,
-23577,
-23565,
-23628,
-23751,
-23873,
-23990,
-24096,
-24184,
-24218,
-24165,
-24045,
-23922,
-23891,
-24005,
-24240,
-24536,
-24797,
-24977,
-25047,
-25053,
-25021,
-25030,
-25105,
-25274,
-25523,
-25808,
-26101,
-26339,
-26494,
-26513,
-26399,
-26175,
-25970,
-25895,
-26047,
-26407,
-26828,
-27189,
-27378,
-27471,
-27554,
-27737,
-28009,
-28285,
-28502,
-28649,
-28816,
-29082,
-29451,
-29824,
-30082,
-30175,
-30187,
-30272,
-30574,
-31051,
-31574,
-31918,
-31983,
-31820,
-31628,
-31597,
-31812,
-32202,
-32597,
-32902,
-33102,
-33307,
-33563,
-33844,
-33997,
-33921,
-33643,
-33355,
-33329,
-33678,
-34359,
-35105,
-35700,
-36043,
-36250,
-36501,
-36940,
-37532,
-38160,
-38694,
-39120,
-39544,
-40076,
-40748,
-41464,
-42038,
-42399,
-42553,
-42686,
-42927,
-43327,
-43734,
-43982,
-43934,
-43681,
-43414,
-43342,
-43540,
-43911,
-44300,
-44604,
-44852,
-45128,
-45481,
-45844,
-46096,
-46182,
-46161,
-46193,
-46417,
-46838,
-47337,
-47758,
-47978,
-48017,
-47934,
-47821,
-47722,
-47659,
-47629,
-47634,
-47661,
-47699,
-47743,
-47780,
-47827,
-47859,
-47876,
-47859,
-47860,
-47921,
-48085,
-48289,
-48411,
-48321,
-47995,
-47521,
-47048,
-46672,
-46362,
-46025,
-45598,
-45088,
-44599,
-44147,
-43702,
-43158,
-42473,
-41717,
-41023,
-40501,
-40120,
-39786,
-39389,
-38908,
-38413,
-37946,
-37524,
-37073,
-36564,
-36004,
-35452,
-34929,
-34398,
-33759,
-32986,
-32096,
-31216,
-30423,
-29753,
-29153,
-28562,
-27952,
-27309,
-26649,
-25943,
-25168,
-24317,
-23413,
-22522,
-21692,
-20976,
-20376,
-19873,
-19392,
-18856,
-18190,
-17404,
-16571,
-15816,
-15198,
-14704,
-14248,
-13757,
-13278,
-12890,
-12670,
-12571,
-12454,
-12179,
-11745,
-11266,
-10901,
-10703,
-10576,
-10360,
-9964,
-9464,
-9006,
-8748,
-8672,
-8688,
-8645,
-8524,
-8359,
-8286,
-8337,
-8500,
-8686,
-8852,
-8997,
-9216,
-9563,
-10076,
-10680,
-11270,
-11728,
-12026,
-12205,
-12364,
-12593,
-12909,
-13275,
-13627,
-13963,
-14328,
-14798,
-15388,
-16058,
-16684,
-17242,
-17727,
-18275,
-18963,
-19814,
-20746,
-21648,
-22461,
-23206,
-23966,
-24792,
-25676,
-26542,
-27328,
-28006,
-28645,
-29309,
-30060,
-30851,
-31627,
-32311,
-32929,
-33575,
-34363,
-35349,
-36477,
-37620,
-38661,
-39582,
-40458,
-41392,
-42417,
-43465,
-44431,
-45255,
-45995,
-46785,
-47692,
-48706,
-49672,
-50467,
-51037,
-51472,
-51892,
-52400,
-52964,
-53509,
-53948,
-54278,
-54551,
-54865,
-55262,
-55733,
-56221,
-56648,
-56982,
-57237,
-57464,
-57717,
-57997,
-58264,
-58426,
-58470,
-58429,
-58434,
-58603,
-58942,
-59373,
-59720,
-59881,
-59856,
-59736,
-59617,
-59537,
-59446,
-59293,
-59082,
-58858,
-58731,
-58701,
-58725,
-58686,
-58479,
-58082,
-57524,
-56908,
-56294,
-55740,
-55218,
-54707,
-54160,
-53571,
-52977,
-52400,
-51880,
-51384,
-50866,
-50289,
-49633,
-48934,
-48215,
-47486,
-46741,
-45964,
-45178,
-44407,
-43690,
-43017,
-42370,
-41719,
-41031,
-40312,
-39496,
-38571,
-37518,
-36416,
-35383,
-34546,
-33889,
-33352,
-32754,
-32054,
-31250,
-30459,
-29723,
-29010,
-28219,
-27280,
-26231,
-25201,
-24294,
-23520,
-22760,
-21896,
-20854,
-19714,
-18606,
-17647,
-16870,
-16190,
-15510,
-14753,
-13927,
-13101,
-12363,
-11752,
-11262,
-10828,
-10417,
-10028,
-9730,
-9546,
-9463,
-9360,
-9094,
-8632,
-8011,
-7405,
-6921,
-6599,
-6337,
-6057,
-5708,
-5360,
-5091,
-4917,
-4791,
-4646,
-4448,
-4268,
-4154,
-4145,
-4179,
-4198,
-4158,
-4102,
-4099,
-4200,
-4403,
-4686,
-4977,
-5273,
-5504,
-5666,
-5724,
-5703,
-5676,
-5698,
-5858,
-6151,
-6609,
-7201,
-7938,
-8746,
-9540,
-10192,
-10653,
-10980,
-11316,
-11786,
-12436,
-13184,
-13933,
-14637,
-15355,
-16143,
-17040,
-17928,
-18702,
-19297,
-19784,
-20322,
-21036,
-21923,
-22877,
-23751,
-24518,
-25255,
-26116,
-27176,
-28404,
-29635,
-30728,
-31608,
-32354,
-33078,
-33866,
-34718,
-35564,
-36367,
-37166,
-38056,
-39114,
-40316,
-41526,
-42599,
-43450,
-44126,
-44761,
-45462,
-46302,
-47228,
-48204,
-49175,
-50118,
-51014,
-51818,
-52496,
-53060,
-53533,
-53990,
-54447,
-54912,
-55359,
-55802,
-56242,
-56700,
-57131,
-57500,
-57775,
-58033,
-58347,
-58829,
-59441,
-60108,
-60681,
-61121,
-61427,
-61701,
-61973,
-62264,
-62519,
-62730,
-62899,
-63063,
-63238,
-63386,
-63465,
-63432,
-63309,
-63135,
-62963,
-62818,
-62694,
-62577,
-62439,
-62278,
-62086,
-61868,
-61633,
-61400,
-61198,
-61037,
-60909,
-60764,
-60519,
-60109,
-59493,
-58718,
-57872,
-57073,
-56359,
-55739,
-55132,
-54522,
-53888,
-53282,
-52674,
-52003,
-51164,
-50130,
-49000,
-47971,
-47200,
-46707,
-46343,
-45916,
-45319,
-44582,
-43828,
-43106,
-42376,
-41519,
-40486,
-39343,
-38250,
-37306,
-36517,
-35748,
-34884,
-33903,
-32879,
-31924,
-31084,
-30308,
-29520,
-28644,
-27695,
-26714,
-25769,
-24903,
-24124,
-23431,
-22787,
-22169,
-21540,
-20874,
-20168,
-19399,
-18566,
-17662,
-16712,
-15807,
-15040,
-14486,
-14119,
-13850,
-13546,
-13150,
-12655,
-12135,
-11628,
-11160,
-10703,
-10271,
-9894,
-9608,
-9420,
-9258,
-9030,
-8679,
-8204,
-7681,
-7197,
-6794,
-6486,
-6226,
-6006,
-5797,
-5631,
-5504,
-5426,
-5365,
-5313,
-5260,
-5224,
-5253,
-5332,
-5479,
-5600,
-5671,
-5659,
-5621,
-5631,
-5747,
-5957,
-6193,
-6389,
-6529,
-6675,
-6903,
-7262,
-7713,
-8222,
-8739,
-9307,
-9960,
-10746,
-11594,
-12436,
-13140,
-13726,
-14224,
-14771,
-15426,
-16202,
-17017,
-17783,
-18429,
-18976,
-19469,
-19963,
-20473,
-20964,
-21430,
-21888,
-22424,
-23106,
-23955,
-24896,
-25808,
-26603,
-27261,
-27866,
-28487,
-29175,
-29905,
-30643,
-31360,
-32069,
-32785,
-33514,
-34231,
-34922,
-35570,
-36191,
-36788,
-37366,
-37929,
-38502,
-39127,
-39838,
-40603,
-41401,
-42155,
-42901,
-43657,
-44458,
-45288,
-46044,
-46663,
-47129,
-47515,
-47924,
-48425,
-48990,
-49569,
-50109,
-50592,
-51045,
-51456,
-51804,
-52065,
-52234,
-52374,
-52519,
-52731,
-52996,
-53319,
-53683,
-54080,
-54476,
-54815,
-55060,
-55186,
-55251,
-55305,
-55404,
-55550,
-55712,
-55862,
-55998,
-56111,
-56231,
-56336,
-56430,
-56491,
-56512,
-56461,
-56332,
-56141,
-55945,
-55801,
-55737,
-55676,
-55549,
-55284,
-54940,
-54602,
-54349,
-54133,
-53820,
-53311,
-52601,
-51865,
-51247,
-50827,
-50488,
-50075,
-49476,
-48755,
-48046,
-47466,
-46999,
-46529,
-45952,
-45258,
-44538,
-43924,
-43438,
-43051,
-42633,
-42119,
-41490,
-40809,
-40157,
-39569,
-39067,
-38581,
-38081,
-37515,
-36906,
-36285,
-35721,
-35206,
-34733,
-34223,
-33658,
-33052,
-32480,
-31993,
-31590,
-31222,
-30793,
-30296,
-29708,
-29121,
-28523,
-27949,
-27330,
-26666,
-25943,
-25208,
-24501,
-23848,
-23252,
-22684,
-22127,
-21546,
-20958,
-20344,
-19750,
-19161,
-18615,
-18107,
-17672,
-17318,
-17065,
-16869,
-16700,
-16498,
-16256,
-15982,
-15686,
-15378,
-15023,
-14640,
-14253,
-13963,
-13807,
-13791,
-13814,
-13797,
-13691,
-13553,
-13459,
-13446,
-13472,
-13471,
-13395,
-13299,
-13268,
-13370,
-13600,
-13875,
-14115,
-14282,
-14387,
-14484,
-14584,
-14693,
-14797,
-14874,
-14936,
-15022,
-15146,
-15398,
-15761,
-16242,
-16756,
-17218,
-17588,
-17876,
-18169,
-18525,
-18943,
-19384,
-19789,
-20188,
-20630,
-21176,
-21806,
-22446,
-22997,
-23445,
-23823,
-24202,
-24621,
-25063,
-25510,
-25961,
-26421,
-26925,
-27418,
-27901,
-28333,
-28764,
-29215,
-29698,
-30163,
-30561,
-30891,
-31205,
-31555,
-31969,
-32376,
-32749,
-33055,
-33376,
-33762,
-34237,
-34747,
-35224,
-35640,
-36025,
-36427,
-36852,
-37294,
-37699,
-38108,
-38520,
-38970,
-39414,
-39820,
-40166,
-40509,
-40897,
-41357,
-41815,
-42211,
-42491,
-42724,
-42956,
-43246,
-43521,
-43745,
-43868,
-43974,
-44137,
-44418,
-44780,
-45139,
-45413,
-45587,
-45663,
-45683,
-45649,
-45592,
-45545,
-45546,
-45588,
-45649,
-45670,
-45672,
-45672,
-45727,
-45770,
-45735,
-45504,
-45115,
-44679,
-44338,
-44158,
-44053,
-43900,
-43630,
-43285,
-43000,
-42847,
-42791,
-42711,
-42479,
-42090,
-41603,
-41137,
-40745,
-40432,
-40167,
-39917,
-39680,
-39462,
-39275,
-39122,
-38996,
-38862,
-38681,
-38399,
-38019,
-37601,
-37252,
-37053,
-37018,
-37070,
-37105,
-37080,
-36995,
-36909,
-36846,
-36770,
-36640,
-36418,
-36126,
-35801,
-35507,
-35223,
-34980,
-34731,
-34485,
-34231,
-33946,
-33630,
-33273,
-32916,
-32570,
-32244,
-31894,
-31508,
-31063,
-30630,
-30247,
-29977,
-29798,
-29695,
-29596,
-29474,
-29313,
-29127,
-28947,
-28816,
-28732,
-28691,
-28644,
-28580,
-28520,
-28538,
-28673,
-28938,
-29222,
-29468,
-29592,
-29679,
-29782,
-29962,
-30180,
-30337,
-30392,
-30331,
-30260,
-30210,
-30243,
-30299,
-30380,
-30459,
-30543,
-30625,
-30661,
-30642,
-30573,
-30521,
-30510,
-30548,
-30583,
-30603,
-30658,
-30819,
-31144,
-31571,
-32004,
-32325,
-32539,
-32709,
-32923,
-33221,
-33546,
-33846,
-34106,
-34357,
-34670,
-35070,
-35534,
-36030,
-36503,
-36937,
-37302,
-37583,
-37776,
-37894,
-37983,
-38037,
-38073,
-38046,
-37992,
-37933,
-37939,
-37986,
-38042,
-38001,
-37841,
-37586,
-37289,
-37002,
-36711,
-36403,
-36117,
-35889,
-35807,
-35836,
-35930,
-36014,
-36073,
-36162,
-36298,
-36472,
-36594,
-36614,
-36568,
-36556,
-36665,
-36901,
-37161,
-37377,
-37539,
-37714,
-37974,
-38283,
-38541,
-38646,
-38573,
-38406,
-38227,
-38092,
-37949,
-37768,
-37537,
-37294,
-37093,
-36914,
-36710,
-36428,
-36037,
-35560,
-35015,
-34414,
-33772,
-33126,
-32522,
-32000,
-31553,
-31127,
-30700,
-30280,
-29910,
-29619,
-29363,
-29052,
-28650,
-28156,
-27696,
-27317,
-27068,
-26840,
-26608,
-26309,
-26035,
-25831,
-25720,
-25643,
-25498,
-25246,
-24881,
-24484,
-24085,
-23731,
-23386,
-23050,
-22710,
-22379,
-22088,
-21839,
-21625,
-21417,
-21179,
-20885,
-20542,
-20154,
-19770,
-19392,
-19035,
-18700,
-18384,
-18139,
-17959,
-17870,
-17804,
-17745,
-17644,
-17559,
-17498,
-17487,
-17473,
-17402,
-17256,
-17089,
-16997,
-17049,
-17230,
-17446,
-17605,
-17669,
-17687,
-17735,
-17836,
-17951,
-17990,
-17879,
-17651,
-17408,
-17272,
-17320,
-17520,
-17779,
-18004,
-18147,
-18258,
-18400,
-18610,
-18875,
-19089,
-19224,
-19256,
-19284,
-19416,
-19715,
-20172,
-20702,
-21217,
-21687,
-22101,
-22519,
-22944,
-23382,
-23796,
-24177,
-24516,
-24852,
-25214,
-25655,
-26200,
-26864,
-27601,
-28343,
-29022,
-29594,
-30072,
-30510,
-30942,
-31389,
-31835,
-32259,
-32689,
-33159,
-33718,
-34381,
-35126,
-35897,
-36644,
-37313,
-37885,
-38374,
-38815,
-39279,
-39820,
-40428,
-41084,
-41696,
-42263,
-42800,
-43389,
-44067,
-44803,
-45485,
-46007,
-46345,
-46552,
-46768,
-47060,
-47450,
-47846,
-48179,
-48421,
-48638,
-48904,
-49288,
-49742,
-50198,
-50530,
-50697,
-50729,
-50725,
-50794,
-50991,
-51286,
-51598,
-51880,
-52105,
-52366,
-52709,
-53164,
-53671,
-54119,
-54457,
-54682,
-54880,
-55110,
-55406,
-55721,
-56008,
-56256,
-56478,
-56734,
-57018,
-57313,
-57562,
-57737,
-57830,
-57849,
-57782,
-57607,
-57312,
-56935,
-56548,
-56232,
-56002,
-55828,
-55614,
-55327,
-54939,
-54514,
-54070,
-53628,
-53135,
-52553,
-51871,
-51157,
-50483,
-49951,
-49553,
-49276,
-49017,
-48715,
-48364,
-47969,
-47613,
-47284,
-46972,
-46596,
-46111,
-45505,
-44882,
-44322,
-43925,
-43658,
-43446,
-43192,
-42825,
-42370,
-41856,
-41315,
-40720,
-40018,
-39189,
-38278,
-37381,
-36585,
-35924,
-35349,
-34784,
-34170,
-33490,
-32760,
-32000,
-31164,
-30270,
-29282,
-28295,
-27356,
-26537,
-25827,
-25179,
-24556,
-23946,
-23398,
-22943,
-22564,
-22192,
-21732,
-21140,
-20446,
-19750,
-19130,
-18635,
-18221,
-17825,
-17408,
-16973,
-16572,
-16232,
-15931,
-15577,
-15085,
-14413,
-13617,
-12809,
-12101,
-11536,
-11070,
-10628,
-10145,
-9622,
-9102,
-8626,
-8197,
-7770,
-7293,
-6753,
-6177,
-5625,
-5131,
-4707,
-4331,
-4007,
-3731,
-3533,
-3424,
-3382,
-3393,
-3420,
-3467,
-3532,
-3605,
-3680,
-3726,
-3770,
-3825,
-3965,
-4205,
-4563,
-4985,
-5418,
-5801,
-6110,
-6368,
-6615,
-6889,
-7201,
-7512,
-7778,
-7978,
-8145,
-8357,
-8703,
-9189,
-9772,
-10333,
-10801,
-11189,
-11555,
-11998,
-12509,
-13032,
-13452,
-13739,
-13950,
-14231,
-14706,
-15412,
-16267,
-17151,
-17937,
-18615,
-19217,
-19807,
-20433,
-21070,
-21711,
-22322,
-22935,
-23600,
-24371,
-25291,
-26311,
-27399,
-28425,
-29367,
-30184,
-30921,
-31635,
-32363,
-33128,
-33913,
-34711,
-35517,
-36357,
-37249,
-38205,
-39232,
-40285,
-41339,
-42319,
-43175,
-43882,
-44465,
-45027,
-45650,
-46416,
-47290,
-48196,
-49056,
-49835,
-50585,
-51377,
-52206,
-53032,
-53701,
-54172,
-54461,
-54715,
-55095,
-55686,
-56431,
-57202,
-57837,
-58317,
-58687,
-59090,
-59598,
-60203,
-60774,
-61209,
-61452,
-61596,
-61770,
-62091,
-62554,
-63065,
-63500,
-63790,
-63994,
-64186,
-64469,
-64809,
-65133,
-65343,
-65392,
-65341,
-65259,
-65243,
-65292,
-65388,
-65471,
-65495,
-65448,
-65322,
-65141,
-64911,
-64672,
-64419,
-64165,
-63879,
-63525,
-63107,
-62629,
-62134,
-61676,
-61267,
-60907,
-60539,
-60144,
-59692,
-59226,
-58802,
-58427,
-58106,
-57729,
-57246,
-56611,
-55917,
-55269,
-54796,
-54487,
-54243,
-53919,
-53420,
-52772,
-52095,
-51479,
-50942,
-50395,
-49706,
-48864,
-47909,
-47003,
-46227,
-45593,
-44996,
-44320,
-43503,
-42574,
-41615,
-40697,
-39822,
-38932,
-37946,
-36845,
-35662,
-34508,
-33472,
-32580,
-31800,
-31040,
-30240,
-29398,
-28534,
-27688,
-26855,
-25998,
-25111,
-24209,
-23390,
-22689,
-22145,
-21671,
-21213,
-20717,
-20196,
-19686,
-19195,
-18678,
-18094,
-17424,
-16731,
-16094,
-15566,
-15139,
-14726,
-14271,
-13736,
-13183,
-12649,
-12185,
-11743,
-11274,
-10719,
-10076,
-9399,
-8765,
-8220,
-7777,
-7379,
-6984,
-6544,
-6103,
-5681,
-5330,
-5025,
-4711,
-4349,
-3949,
-3583,
-3332,
-3221,
-3200,
-3186,
-3129,
-3041,
-2986,
-2994,
-3060,
-3119,
-3139,
-3150,
-3205,
-3362,
-3592,
-3830,
-3993,
-4061,
-4096,
-4172,
-4345,
-4605,
-4886,
-5143,
-5344,
-5539,
-5764,
-6076,
-6430,
-6799,
-7088,
-7299,
-7465,
-7671,
-7996,
-8435,
-8919,
-9370,
-9723,
-10053,
-10419,
-10910,
-11488,
-12062,
-12550,
-12906,
-13224,
-13588,
-14076,
-14672,
-15316,
-15955,
-16575,
-17198,
-17851,
-18497,
-19119,
-19663,
-20145,
-20606,
-21081,
-21601,
-22165,
-22763,
-23393,
-24071,
-24767,
-25476,
-26123,
-26707,
-27204,
-27670,
-28148,
-28689,
-29290,
-29937,
-30569,
-31166,
-31728,
-32298,
-32937,
-33635,
-34353,
-34974,
-35444,
-35786,
-36102,
-36528,
-37084,
-37715,
-38299,
-38760,
-39167,
-39605,
-40182,
-40848,
-41509,
-42039,
-42434,
-42760,
-43133,
-43627,
-44213,
-44863,
-45492,
-46099,
-46653,
-47180,
-47688,
-48203,
-48753,
-49319,
-49869,
-50362,
-50788,
-51203,
-51653,
-52160,
-52683,
-53143,
-53519,
-53813,
-54094,
-54386,
-54697,
-55004,
-55283,
-55539,
-55757,
-55926,
-56032,
-56093,
-56146,
-56258,
-56397,
-56534,
-56591,
-56568,
-56530,
-56543,
-56655,
-56811,
-56955,
-57021,
-57014,
-56974,
-56935,
-56913,
-56919,
-56940,
-56967,
-56999,
-57004,
-57020,
-57058,
-57167,
-57327,
-57464,
-57501,
-57393,
-57196,
-57022,
-56946,
-56978,
-57039,
-57049,
-56971,
-56844,
-56700,
-56572,
-56408,
-56175,
-55830,
-55377,
-54865,
-54315,
-53796,
-53295,
-52856,
-52416,
-51986,
-51510,
-51009,
-50490,
-49978,
-49491,
-49005,
-48508,
-47966,
-47415,
-46884,
-46435,
-46089,
-45827,
-45599,
-45343,
-45029,
-44658,
-44247,
-43823,
-43366,
-42882,
-42364,
-41848,
-41357,
-40897,
-40453,
-39997,
-39515,
-39016,
-38481,
-37898,
-37225,
-36486,
-35714,
-34979,
-34303,
-33654,
-32988,
-32298,
-31594,
-30955,
-30351,
-29782,
-29191,
-28574,
-27963,
-27369,
-26790,
-26196,
-25598,
-25035,
-24553,
-24136,
-23721,
-23242,
-22718,
-22204,
-21771,
-21377,
-20949,
-20418,
-19838,
-19303,
-18907,
-18598,
-18291,
-17910,
-17481,
-17097,
-16799,
-16543,
-16258,
-15896,
-15526,
-15213,
-14968,
-14725,
-14402,
-13974,
-13517,
-13067,
-12641,
-12187,
-11677,
-11157,
-10687,
-10279,
-9902,
-9488,
-9056,
-8658,
-8345,
-8095,
-7837,
-7525,
-7228,
-7025,
-6977,
-7018,
-7047,
-7009,
-6964,
-6985,
-7115,
-7269,
-7349,
-7323,
-7240,
-7182,
-7179,
-7189,
-7169,
-7131,
-7131,
-7203,
-7318,
-7399,
-7412,
-7365,
-7319,
-7292,
-7268,
-7220,
-7166,
-7163,
-7260,
-7462,
-7717,
-7980,
-8245,
-8518,
-8821,
-9124,
-9414,
-9689,
-9992,
-10362,
-10793,
-11257,
-11719,
-12160,
-12615,
-13080,
-13553,
-13998,
-14370,
-14680,
-14918,
-15156,
-15395,
-15687,
-16027,
-16391,
-16793,
-17187,
-17643,
-18132,
-18693,
-19260,
-19806,
-20312,
-20796,
-21325,
-21897,
-22535,
-23185,
-23847,
-24502,
-25151,
-25760,
-26318,
-26812,
-27291,
-27783,
-28294,
-28790,
-29263,
-29745,
-30300,
-30957,
-31673,
-32376,
-33030,
-33675,
-34383,
-35178,
-36002,
-36800,
-37542,
-38311,
-39136,
-40021,
-40859,
-41599,
-42258,
-42936,
-43663,
-44416,
-45047,
-45558,
-45990,
-46491,
-47096,
-47736,
-48301,
-48754,
-49184,
-49674,
-50249,
-50803,
-51264,
-51638,
-52035,
-52544,
-53130,
-53731,
-54265,
-54805,
-55413,
-56108,
-56798,
-57385,
-57854,
-58312,
-58852,
-59468,
-60070,
-60572,
-60988,
-61417,
-61889,
-62359,
-62704,
-62876,
-62944,
-62999,
-63094,
-63146,
-63104,
-62969,
-62857,
-62854,
-62939,
-63017,
-63004,
-62946,
-62937,
-63041,
-63219,
-63337,
-63381,
-63361,
-63420,
-63564,
-63770,
-63915,
-63994,
-64005,
-64015,
-64004,
-63909,
-63706,
-63402,
-63081,
-62766,
-62460,
-62114,
-61741,
-61379,
-61067,
-60802,
-60496,
-60109,
-59640,
-59145,
-58697,
-58279,
-57852,
-57382,
-56857,
-56335,
-55814,
-55295,
-54728,
-54089,
-53382,
-52622,
-51843,
-51041,
-50230,
-49411,
-48590,
-47773,
-46969,
-46180,
-45404,
-44648,
-43888,
-43112,
-42346,
-41567,
-40829,
-40090,
-39369,
-38650,
-37962,
-37334,
-36758,
-36205,
-35629,
-35017,
-34377,
-33744,
-33099,
-32430,
-31735,
-31015,
-30325,
-29646,
-28950,
-28211,
-27401,
-26576,
-25732,
-24858,
-23907,
-22872,
-21826,
-20852,
-20005,
-19216,
-18429,
-17596,
-16802,
-16120,
-15576,
-15087,
-14566,
-14002,
-13466,
-13047,
-12745,
-12475,
-12162,
-11794,
-11457,
-11176,
-10931,
-10627,
-10218,
-9754,
-9291,
-8878,
-8450,
-7965,
-7434,
-6933,
-6540,
-6232,
-5930,
-5577,
-5204,
-4879,
-4651,
-4455,
-4220,
-3948,
-3694,
-3586,
-3590,
-3642,
-3627,
-3548,
-3493,
-3521,
-3642,
-3731,
-3745,
-3714,
-3752,
-3943,
-4246,
-4570,
-4842,
-5083,
-5371,
-5725,
-6130,
-6500,
-6834,
-7166,
-7549,
-8003,
-8467,
-8936,
-9404,
-9919,
-10490,
-11076,
-11609,
-12103,
-12569,
-13080,
-13620,
-14143,
-14607,
-15029,
-15459,
-15962,
-16504,
-17035,
-17494,
-17880,
-18249,
-18630,
-19031,
-19416,
-19777,
-20136,
-20550,
-21051,
-21641,
-22281,
-22946,
-23616,
-24299,
-25013,
-25752,
-26517,
-27303,
-28094,
-28899,
-29698,
-30505,
-31301,
-32086,
-32828,
-33514,
-34135,
-34700,
-35228,
-35736,
-36238,
-36722,
-37210,
-37680,
-38150,
-38623,
-39099,
-39598,
-40112,
-40627,
-41122,
-41596,
-42057,
-42544,
-43071,
-43616,
-44163,
-44682,
-45205,
-45747,
-46320,
-46873,
-47381,
-47798,
-48190,
-48566,
-48974,
-49367,
-49735,
-50058,
-50382,
-50723,
-51089,
-51400,
-51658,
-51807,
-51935,
-52024,
-52117,
-52165,
-52175,
-52156,
-52136,
-52116,
-52091,
-52030,
-51964,
-51903,
-51873,
-51840,
-51778,
-51672,
-51569,
-51494,
-51453,
-51403,
-51281,
-51110,
-50928,
-50804,
-50737,
-50674,
-50569,
-50420,
-50272,
-50180,
-50119,
-50061,
-49954,
-49820,
-49697,
-49620,
-49563,
-49498,
-49387,
-49278,
-49182,
-49130,
-49074,
-48968,
-48806,
-48586,
-48344,
-48066,
-47718,
-47284,
-46768,
-46217,
-45670,
-45139,
-44615,
-44098,
-43589,
-43106,
-42636,
-42159,
-41658,
-41121,
-40581,
-40060,
-39548,
-39058,
-38556,
-38086,
-37653,
-37282,
-36940,
-36613,
-36265,
-35902,
-35532,
-35145,
-34750,
-34316,
-33864,
-33388,
-32931,
-32468,
-32036,
-31600,
-31208,
-30831,
-30489,
-30135,
-29744,
-29310,
-28834,
-28348,
-27870,
-27390,
-26917,
-26440,
-25990,
-25598,
-25285,
-25040,
-24839,
-24633,
-24438,
-24236,
-24077,
-23936,
-23804,
-23666,
-23495,
-23342,
-23202,
-23110,
-23041,
-22966,
-22891,
-22794,
-22718,
-22621,
-22511,
-22326,
-22099,
-21818,
-21549,
-21298,
-21050,
-20812,
-20562,
-20342,
-20155,
-20002,
-19850,
-19660,
-19417,
-19137,
-18835,
-18546,
-18243,
-17947,
-17634,
-17344,
-17080,
-16857,
-16673,
-16517,
-16385,
-16278,
-16187,
-16131,
-16101,
-16109,
-16155,
-16248,
-16378,
-16572,
-16811,
-17128,
-17486,
-17878,
-18269,
-18669,
-19068,
-19481,
-19881,
-20245,
-20567,
-20861,
-21163,
-21503,
-21853,
-22187,
-22463,
-22693,
-22912,
-23136,
-23367,
-23555,
-23679,
-23743,
-23795,
-23873,
-23990,
-24128,
-24249,
-24373,
-24515,
-24710,
-24959,
-25231,
-25505,
-25761,
-26017,
-26278,
-26546,
-26821,
-27078,
-27348,
-27620,
-27933,
-28259,
-28596,
-28908,
-29193,
-29435,
-29645,
-29814,
-29942,
-30037,
-30097,
-30150,
-30222,
-30340,
-30520,
-30759,
-31050,
-31372,
-31717,
-32086,
-32478,
-32878,
-33273,
-33641,
-33985,
-34330,
-34697,
-35105,
-35550,
-36020,
-36501,
-37007,
-37520,
-38038,
-38520,
-38951,
-39312,
-39645,
-39959,
-40296,
-40636,
-40987,
-41344,
-41749,
-42214,
-42749,
-43308,
-43842,
-44315,
-44731,
-45106,
-45467,
-45794,
-46046,
-46210,
-46274,
-46307,
-46329,
-46372,
-46392,
-46357,
-46253,
-46097,
-45935,
-45764,
-45578,
-45329,
-45017,
-44666,
-44326,
-44044,
-43812,
-43633,
-43490,
-43409,
-43429,
-43553,
-43771,
-44033,
-44309,
-44586,
-44874,
-45176,
-45478,
-45744,
-45963,
-46140,
-46292,
-46466,
-46645,
-46837,
-46998,
-47132,
-47209,
-47250,
-47235,
-47169,
-47030,
-46819,
-46548,
-46251,
-45960,
-45728,
-45549,
-45444,
-45391,
-45381,
-45431,
-45513,
-45621,
-45706,
-45734,
-45699,
-45601,
-45463,
-45270,
-45027,
-44715,
-44354,
-43981,
-43605,
-43240,
-42831,
-42378,
-41870,
-41343,
-40802,
-40260,
-39663,
-39026,
-38349,
-37708,
-37128,
-36635,
-36193,
-35798,
-35441,
-35156,
-34947,
-34791,
-34646,
-34438,
-34171,
-33824,
-33433,
-33007,
-32515,
-31986,
-31398,
-30811,
-30266,
-29783,
-29373,
-29013,
-28664,
-28336,
-28000,
-27688,
-27386,
-27090,
-26793,
-26508,
-26262,
-26105,
-26069,
-26156,
-26340,
-26587,
-26856,
-27148,
-27429,
-27676,
-27829,
-27851,
-27728,
-27492,
-27183,
-26820,
-26422,
-25959,
-25452,
-24918,
-24390,
-23879,
-23356,
-22785,
-22150,
-21474,
-20794,
-20162,
-19579,
-19046,
-18571,
-18165,
-17880,
-17729,
-17704,
-17770,
-17863,
-17984,
-18103,
-18232,
-18352,
-18424,
-18430,
-18365,
-18250,
-18115,
-17969,
-17807,
-17626,
-17433,
-17259,
-17138,
-17061,
-17027,
-17006,
-16994,
-17029,
-17127,
-17307,
-17560,
-17850,
-18188,
-18575,
-19046,
-19602,
-20220,
-20857,
-21461,
-22030,
-22539,
-23008,
-23420,
-23752,
-24000,
-24145,
-24222,
-24252,
-24267,
-24279,
-24285,
-24282,
-24270,
-24263,
-24278,
-24333,
-24422,
-24549,
-24709,
-24916,
-25187,
-25534,
-25947,
-26402,
-26869,
-27337,
-27801,
-28259,
-28690,
-29062,
-29363,
-29591,
-29770,
-29923,
-30047,
-30123,
-30131,
-30074,
-29976,
-29863,
-29740,
-29607,
-29457,
-29322,
-29245,
-29273,
-29424,
-29708,
-30091,
-30596,
-31203,
-31924,
-32721,
-33555,
-34386,
-35197,
-35993,
-36779,
-37542,
-38274,
-38937,
-39542,
-40093,
-40599,
-41043,
-41407,
-41649,
-41778,
-41788,
-41737,
-41622,
-41496,
-41337,
-41189,
-41056,
-40998,
-41028,
-41173,
-41404,
-41704,
-42042,
-42407,
-42804,
-43208,
-43614,
-43976,
-44274,
-44498,
-44661,
-44780,
-44861,
-44890,
-44841,
-44728,
-44542,
-44326,
-44070,
-43776,
-43421,
-43009,
-42570,
-42131,
-41741,
-41407,
-41130,
-40930,
-40813,
-40824,
-40975,
-41252,
-41623,
-42049,
-42491,
-42956,
-43412,
-43855,
-44240,
-44556,
-44789,
-44957,
-45071,
-45152,
-45180,
-45171,
-45091,
-44971,
-44793,
-44571,
-44296,
-43976,
-43621,
-43257,
-42913,
-42607,
-42370,
-42205,
-42132,
-42163,
-42288,
-42508,
-42780,
-43090,
-43405,
-43693,
-43957,
-44151,
-44272,
-44287,
-44206,
-44004,
-43722,
-43327,
-42860,
-42290,
-41651,
-40929,
-40161,
-39349,
-38521,
-37685,
-36850,
-36043,
-35271,
-34578,
-33966,
-33464,
-33056,
-32758,
-32561,
-32475,
-32505,
-32626,
-32812,
-33028,
-33225,
-33418,
-33568,
-33681,
-33726,
-33671,
-33519,
-33276,
-32976,
-32651,
-32311,
-31939,
-31553,
-31140,
-30747,
-30389,
-30075,
-29796,
-29537,
-29306,
-29122,
-29016,
-29003,
-29074,
-29219,
-29426,
-29681,
-30001,
-30337,
-30687,
-30991,
-31226,
-31364,
-31401,
-31315,
-31119,
-30795,
-30359,
-29833,
-29223,
-28561,
-27851,
-27117,
-26363,
-25610,
-24863,
-24136,
-23440,
-22777,
-22175,
-21637,
-21176,
-20804,
-20514,
-20326,
-20223,
-20206,
-20254,
-20349,
-20466,
-20596,
-20705,
-20786,
-20811,
-20776,
-20676,
-20524,
-20324,
-20081,
-19822,
-19548,
-19304,
-19081,
-18919,
-18792,
-18734,
-18735,
-18824,
-19003,
-19265,
-19612,
-20024,
-20517,
-21091,
-21745,
-22457,
-23201,
-23949,
-24689,
-25404,
-26083,
-26698,
-27212,
-27616,
-27885,
-28042,
-28082,
-28021,
-27855,
-27594,
-27257,
-26862,
-26448,
-26012,
-25579,
-25150,
-24733,
-24351,
-24016,
-23742,
-23531,
-23391,
-23308,
-23303,
-23356,
-23484,
-23661,
-23889,
-24136,
-24399,
-24661,
-24915,
-25165,
-25391,
-25601,
-25774,
-25919,
-26041,
-26148,
-26264,
-26373,
-26502,
-26635,
-26799,
-27003,
-27267,
-27598,
-28006,
-28479,
-29032,
-29657,
-30371,
-31148,
-31993,
-32856,
-33741,
-34614,
-35486,
-36327,
-37142,
-37886,
-38577,
-39189,
-39742,
-40224,
-40629,
-40942,
-41162,
-41282,
-41325,
-41292,
-41196,
-41035,
-40834,
-40611,
-40387,
-40195,
-40023,
-39888,
-39791,
-39735,
-39726,
-39749,
-39794,
-39845,
-39899,
-39960,
-40021,
-40088,
-40143,
-40193,
-40234,
-40279,
-40324,
-40362,
-40382,
-40376,
-40343,
-40294,
-40229,
-40152,
-40070,
-39994,
-39944,
-39929,
-39968,
-40053,
-40199,
-40409,
-40679,
-41011,
-41379,
-41789,
-42213,
-42665,
-43124,
-43585,
-44033,
-44456,
-44855,
-45232,
-45578,
-45893,
-46150,
-46354,
-46495,
-46580,
-46592,
-46531,
-46377,
-46144,
-45847,
-45497,
-45113,
-44688,
-44237,
-43769,
-43312,
-42879,
-42476,
-42095,
-41725,
-41353,
-41005,
-40672,
-40359,
-40051,
-39748,
-39438,
-39148,
-38869,
-38618,
-38382,
-38152,
-37917,
-37680,
-37426,
-37162,
-36880,
-36569,
-36232,
-35876,
-35501,
-35140,
-34777,
-34441,
-34124,
-33828,
-33556,
-33315,
-33091,
-32902,
-32719,
-32561,
-32409,
-32272,
-32163,
-32065,
-31999,
-31936,
-31883,
-31828,
-31775,
-31719,
-31654,
-31570,
-31447,
-31289,
-31090,
-30860,
-30608,
-30322,
-30007,
-29657,
-29279,
-28897,
-28499,
-28117,
-27722,
-27328,
-26943,
-26564,
-26223,
-25905,
-25625,
-25367,
-25147,
-24958,
-24803,
-24677,
-24572,
-24486,
-24413,
-24361,
-24314,
-24267,
-24215,
-24142,
-24066,
-23966,
-23847,
-23692,
-23503,
-23277,
-23037,
-22785,
-22535,
-22284,
-22037,
-21802,
-21600,
-21427,
-21299,
-21201,
-21136,
-21113,
-21130,
-21197,
-21306,
-21460,
-21636,
-21858,
-22093,
-22361,
-22631,
-22904,
-23156,
-23387,
-23578,
-23733,
-23843,
-23911,
-23939,
-23925,
-23883,
-23807,
-23727,
-23641,
-23569,
-23511,
-23453,
-23410,
-23388,
-23400,
-23468,
-23583,
-23735,
-23934,
-24176,
-24471,
-24839,
-25246,
-25703,
-26156,
-26632,
-27090,
-27571,
-28024,
-28466,
-28852,
-29204,
-29493,
-29764,
-29990,
-30190,
-30360,
-30499,
-30627,
-30747,
-30866,
-30990,
-31105,
-31232,
-31350,
-31494,
-31644,
-31822,
-32020,
-32250,
-32503,
-32796,
-33115,
-33462,
-33817,
-34174,
-34506,
-34822,
-35088,
-35319,
-35491,
-35610,
-35686,
-35711,
-35718,
-35698,
-35680,
-35664,
-35663,
-35683,
-35725,
-35789,
-35876,
-35985,
-36129,
-36299,
-36529,
-36801,
-37138,
-37532,
-37978,
-38493,
-39053,
-39658,
-40284,
-40893,
-41477,
-42007,
-42486,
-42910,
-43273,
-43563,
-43780,
-43920,
-44009,
-44062,
-44086,
-44099,
-44063,
-44013,
-43919,
-43831,
-43733,
-43642,
-43537,
-43421,
-43305,
-43206,
-43146,
-43125,
-43134,
-43168,
-43221,
-43301,
-43400,
-43506,
-43598,
-43646,
-43649,
-43594,
-43495,
-43349,
-43146,
-42903,
-42605,
-42294,
-41969,
-41655,
-41356,
-41063,
-40788,
-40518,
-40267,
-40029,
-39816,
-39617,
-39448,
-39301,
-39192,
-39141,
-39147,
-39224,
-39361,
-39541,
-39762,
-39992,
-40239,
-40464,
-40659,
-40800,
-40875,
-40895,
-40853,
-40771,
-40632,
-40462,
-40246,
-40023,
-39790,
-39556,
-39308,
-39042,
-38759,
-38464,
-38166,
-37865,
-37551,
-37222,
-36884,
-36561,
-36262,
-35998,
-35749,
-35510,
-35266,
-35032,
-34788,
-34534,
-34235,
-33875,
-33436,
-32935,
-32374,
-31779,
-31148,
-30495,
-29827,
-29173,
-28557,
-28002,
-27514,
-27074,
-26693,
-26326,
-26022,
-25742,
-25525,
-25345,
-25208,
-25114,
-25080,
-25119,
-25247,
-25458,
-25728,
-26029,
-26345,
-26647,
-26937,
-27176,
-27352,
-27441,
-27442,
-27373,
-27251,
-27106,
-26927,
-26728,
-26505,
-26266,
-26038,
-25807,
-25573,
-25311,
-25017,
-24700,
-24385,
-24090,
-23826,
-23589,
-23381,
-23205,
-23089,
-23021,
-23018,
-23019,
-23036,
-23010,
-22973,
-22900,
-22790,
-22642,
-22431,
-22172,
-21880,
-21575,
-21271,
-20973,
-20669,
-20391,
-20132,
-19928,
-19776,
-19660,
-19585,
-19540,
-19547,
-19620,
-19774,
-19990,
-20265,
-20579,
-20951,
-21380,
-21870,
-22402,
-22934,
-23449,
-23921,
-24353,
-24746,
-25095,
-25399,
-25637,
-25827,
-25968,
-26087,
-26208,
-26322,
-26449,
-26558,
-26664,
-26767,
-26883,
-27015,
-27177,
-27351,
-27558,
-27785,
-28057,
-28377,
-28725,
-29101,
-29453,
-29802,
-30110,
-30399,
-30638,
-30819,
-30926,
-30976,
-30970,
-30956,
-30904,
-30830,
-30707,
-30550,
-30370,
-30186,
-30008,
-29824,
-29649,
-29487,
-29389,
-29374,
-29467,
-29674,
-29976,
-30374,
-30880,
-31468,
-32135,
-32835,
-33538,
-34234,
-34914,
-35587,
-36243,
-36865,
-37439,
-37967,
-38450,
-38904,
-39313,
-39667,
-39937,
-40116,
-40223,
-40272,
-40292,
-40287,
-40266,
-40243,
-40231,
-40271,
-40379,
-40570,
-40831,
-41143,
-41477,
-41845,
-42216,
-42598,
-42967,
-43285,
-43543,
-43722,
-43835,
-43904,
-43919,
-43894,
-43795,
-43645,
-43438,
-43206,
-42954,
-42667,
-42345,
-41973,
-41584,
-41197,
-40854,
-40551,
-40316,
-40129,
-40037,
-40048,
-40188,
-40447,
-40793,
-41186,
-41614,
-42043,
-42483,
-42895,
-43266,
-43570,
-43797,
-43970,
-44093,
-44186,
-44242,
-44257,
-44227,
-44156,
-44039,
-43887,
-43690,
-43443,
-43178,
-42890,
-42625,
-42386,
-42206,
-42087,
-42047,
-42097,
-42236,
-42449,
-42721,
-43006,
-43309,
-43574,
-43817,
-43988,
-44085,
-44088,
-43980,
-43780,
-43474,
-43094,
-42614,
-42068,
-41433,
-40743,
-39997,
-39218,
-38426,
-37616,
-36824,
-36038,
-35301,
-34623,
-34031,
-33538,
-33139,
-32839,
-32646,
-32549,
-32576,
-32683,
-32860,
-33055,
-33252,
-33420,
-33567,
-33665,
-33702,
-33646,
-33488,
-33249,
-32951,
-32631,
-32295,
-31936,
-31548,
-31151,
-30754,
-30405,
-30089,
-29812,
-29553,
-29319,
-29133,
-29024,
-29005,
-29076,
-29218,
-29425,
-29685,
-29994,
-30343,
-30683,
-30994,
-31224,
-31364,
-31400,
-31317,
-31116,
-30798,
-30358,
-29833,
-29224,
-28558,
-27856,
-27113,
-26367,
-25606,
-24866,
-24135,
-23438,
-22780,
-22173,
-21639,
-21176,
-20802,
-20517,
-20323,
-20226,
-20205,
-20254,
-20349,
-20465,
-20598,
-20703,
-20789,
-20809,
-20775,
-20678,
-20524,
-20324,
-20081,
-19822,
-19548,
-19302,
-19084,
-18916,
-18795,
-18732,
-18735,
-18826,
-19000,
-19269,
-19609,
-20024,
-20519,
-21090,
-21746,
-22456,
-23202,
-23948,
-24690,
-25403,
-26085,
-26696,
-27215,
-27614,
-27885,
-28043,
-28080,
-28024,
-27853,
-27594,
-27257,
-26862,
-26449,
-26011,
-25580,
-25149,
-24734,
-24352,
-24015,
-23742,
-23532,
-23391,
-23307,
-23305,
-23354,
-23483,
-23665,
-23885,
-24141,
-24398,
-24659,
-24919,
-25161,
-25395,
-25599,
-25773,
-25919,
-26040,
-26151,
-26260,
-26377,
-26497,
-26638,
-26797,
-27005,
-27266,
-27599,
-28005,
-28479,
-29032,
-29658,
-30370,
-31149,
-31992,
-32857,
-33740,
-34617,
-35483,
-36330,
-37139,
-37889,
-38575,
-39188,
-39744,
-40222,
-40630,
-40943,
-41159,
-41285,
-41324,
-41291,
-41196,
-41036,
-40833,
-40613,
-40387,
-40196,
-40020,
-39890,
-39789,
-39736,
-39726,
-39747,
-39798,
-39841,
-39901,
-39959,
-40021,
-40090,
-40141,
-40194,
-40233,
-40280,
-40323,
-40364,
-40381,
-40375,
-40345,
-40291,
-40232,
-40149,
-40071,
-39994,
-39944,
-39929,
-39968,
-40052,
-40202,
-40407,
-40680,
-41009,
-41381,
-41787,
-42215,
-42663,
-43125,
-43585,
-44034,
-44455,
-44855,
-45230,
-45580,
-45891,
-46154,
-46350,
-46498,
-46577,
-46594,
-46530,
-46377,
-46144,
-45846,
-45497,
-45113,
-44690,
-44236,
-43770,
-43312,
-42876,
-42479,
-42083,
-41711,
-41331,
-40976,
-40637,
-40318,
-40010,
-39698,
-39391,
-39091,
-38816,
-38566,
-38330,
-38106,
-37874,
-37639,
-37392,
-37133,
-36854,
-36540,
-36210,
-35840,
-35476,
-35103,
-34745,
-34409,
-34090,
-33806,
-33540,
-33311,
-33102,
-32924,
-32765,
-32618,
-32487,
-32370,
-32274,
-32205,
-32162,
-32131,
-32118,
-32101,
-32090,
-32078,
-32056,
-32015,
-31932,
-31806,
-31629,
-31414,
-31168,
-30885,
-30574,
-30215,
-29830,
-29428,
-29019,
-28612,
-28205,
-27793,
-27384,
-26984,
-26612,
-26273,
-25972,
-25701,
-25466,
-25272,
-25111,
-25007,
-24917,
-24868,
-24829,
-24813,
-24801,
-24795,
-24776,
-24739,
-24686,
-24606,
-24500,
-24363,
-24188,
-23987,
-23761,
-23531,
-23298,
-23067,
-22840,
-22630,
-22444,
-22301,
-22185,
-22116,
-22076,
-22079,
-22131,
-22235,
-22387,
-22582,
-22804,
-23063,
-23338,
-23639,
-23927,
-24207,
-24450,
-24658,
-24817,
-24930,
-24980,
-24982,
-24929,
-24833,
-24710,
-24551,
-24376,
-24196,
-24014,
-23861,
-23716,
-23603,
-23516,
-23475,
-23495,
-23589,
-23751,
-23991,
-24282,
-24651,
-25081,
-25587,
-26132,
-26704,
-27272,
-27833,
-28381,
-28907,
-29407,
-29845,
-30234,
-30549,
-30821,
-31052,
-31233,
-31386,
-31483,
-31559,
-31615,
-31665,
-31729,
-31792,
-31880,
-31976,
-32107,
-32279,
-32489,
-32750,
-33048,
-33381,
-33748,
-34133,
-34526,
-34921,
-35295,
-35640,
-35935,
-36166,
-36331,
-36418,
-36446,
-36404,
-36311,
-36153,
-35964,
-35732,
-35512,
-35283,
-35091,
-34903,
-34763,
-34652,
-34608,
-34628,
-34724,
-34884,
-35129,
-35440,
-35843,
-36325,
-36875,
-37474,
-38102,
-38746,
-39386,
-40011,
-40591,
-41114,
-41561,
-41931,
-42233,
-42468,
-42637,
-42751,
-42804,
-42821,
-42805,
-42775,
-42729,
-42675,
-42611,
-42553,
-42506,
-42477,
-42472,
-42487,
-42530,
-42600,
-42701,
-42828,
-42967,
-43102,
-43222,
-43298,
-43341,
-43312,
-43221,
-43029,
-42754,
-42375,
-41922,
-41398,
-40819,
-40193,
-39535,
-38848,
-38167,
-37495,
-36854,
-36258,
-35704,
-35206,
-34773,
-34406,
-34138,
-33945,
-33864,
-33856,
-33946,
-34102,
-34339,
-34628,
-34965,
-35322,
-35678,
-36015,
-36308,
-36569,
-36761,
-36913,
-36987,
-37015,
-36985,
-36919,
-36834,
-36724,
-36603,
-36469,
-36327,
-36201,
-36078,
-35975,
-35872,
-35770,
-35683,
-35603,
-35555,
-35515,
-35484,
-35443,
-35391,
-35323,
-35231,
-35101,
-34907,
-34634,
-34276,
-33829,
-33302,
-32698,
-32022,
-31285,
-30512,
-29717,
-28937,
-28160,
-27430,
-26724,
-26080,
-25488,
-24964,
-24503,
-24115,
-23794,
-23564,
-23409,
-23358,
-23383,
-23504,
-23699,
-23961,
-24278,
-24625,
-24994,
-25362,
-25715,
-26042,
-26322,
-26561,
-26757,
-26924,
-27079,
-27214,
-27347,
-27466,
-27595,
-27735,
-27893,
-28068,
-28243,
-28413,
-28592,
-28771,
-28974,
-29188,
-29404,
-29635,
-29853,
-30089,
-30308,
-30525,
-30694,
-30823,
-30880,
-30879,
-30798,
-30643,
-30400,
-30072,
-29673,
-29215,
-28720,
-28202,
-27664,
-27139,
-26612,
-26128,
-25675,
-25279,
-24923,
-24617,
-24361,
-24153,
-24015,
-23941,
-23936,
-24003,
-24133,
-24330,
-24595,
-24914,
-25277,
-25671,
-26070,
-26468,
-26847,
-27209,
-27535,
-27843,
-28110,
-28379,
-28629,
-28900,
-29184,
-29487,
-29821,
-30172,
-30552,
-30938,
-31337,
-31721,
-32105,
-32468,
-32831,
-33177,
-33528,
-33867,
-34204,
-34531,
-34827,
-35104,
-35320,
-35488,
-35581,
-35585,
-35508,
-35332,
-35080,
-34760,
-34388,
-33976,
-33535,
-33084,
-32628,
-32199,
-31783,
-31404,
-31042,
-30716,
-30415,
-30162,
-29946,
-29782,
-29655,
-29596,
-29575,
-29641,
-29744,
-29924,
-30136,
-30389,
-30676,
-30970,
-31290,
-31582,
-31882,
-32148,
-32402,
-32641,
-32861,
-33087,
-33310,
-33553,
-33816,
-34107,
-34429,
-34783,
-35166,
-35568,
-35983,
-36393,
-36799,
-37188,
-37569,
-37931,
-38287,
-38624,
-38962,
-39280,
-39594,
-39875,
-40123,
-40308,
-40437,
-40471,
-40440,
-40303,
-40094,
-39807,
-39470,
-39105,
-38731,
-38362,
-38015,
-37689,
-37405,
-37147,
-36924,
-36718,
-36526,
-36352,
-36187,
-36057,
-35943,
-35885,
-35853,
-35894,
-35975,
-36118,
-36302,
-36507,
-36729,
-36937,
-37135,
-37306,
-37450,
-37566,
-37665,
-37753,
-37843,
-37953,
-38084,
-38253,
-38451,
-38686,
-38939,
-39217,
-39498,
-39788,
-40071,
-40348,
-40617,
-40868,
-41109,
-41333,
-41546,
-41754,
-41949,
-42135,
-42274,
-42387,
-42429,
-42420,
-42341,
-42184,
-41946,
-41628,
-41229,
-40787,
-40300,
-39805,
-39299,
-38807,
-38330,
-37880,
-37466,
-37080,
-36714,
-36369,
-36026,
-35704,
-35383,
-35092,
-34815,
-34566,
-34357,
-34184,
-34058,
-33972,
-33910,
-33863,
-33807,
-33726,
-33617,
-33459,
-33269,
-33039,
-32790,
-32527,
-32271,
-32035,
-31842,
-31694,
-31592,
-31526,
-31472,
-31440,
-31396,
-31374,
-31326,
-31287,
-31222,
-31158,
-31098,
-31047,
-31018,
-30986,
-30956,
-30909,
-30838,
-30738,
-30580,
-30367,
-30077,
-29730,
-29332,
-28893,
-28427,
-27938,
-27452,
-26976,
-26537,
-26122,
-25743,
-25379,
-25045,
-24725,
-24435,
-24162,
-23906,
-23664,
-23449,
-23254,
-23094,
-22968,
-22860,
-22794,
-22730,
-22703,
-22665,
-22640,
-22587,
-22527,
-22433,
-22325,
-22187,
-22039,
-21882,
-21741,
-21617,
-21533,
-21483,
-21484,
-21537,
-21639,
-21785,
-21961,
-22155,
-22364,
-22585,
-22826,
-23069,
-23332,
-23579,
-23846,
-24124,
-24414,
-24717,
-25001,
-25262,
-25487,
-25671,
-25818,
-25915,
-25967,
-25960,
-25920,
-25853,
-25791,
-25751,
-25732,
-25745,
-25787,
-25862,
-25982,
-26124,
-26307,
-26485,
-26688,
-26878,
-27090,
-27312,
-27549,
-27806,
-28064,
-28343,
-28625,
-28924,
-29220,
-29499,
-29757,
-29986,
-30189,
-30374,
-30528,
-30663,
-30769,
-30882,
-30994,
-31151,
-31331,
-31552,
-31807,
-32097,
-32427,
-32797,
-33193,
-33612,
-34027,
-34454,
-34868,
-35291,
-35704,
-36115,
-36524,
-36923,
-37316,
-37687,
-38043,
-38365,
-38661,
-38917,
-39129,
-39289,
-39401,
-39475,
-39516,
-39542,
-39556,
-39575,
-39608,
-39673,
-39772,
-39906,
-40060,
-40231,
-40414,
-40611,
-40818,
-41015,
-41192,
-41340,
-41476,
-41602,
-41740,
-41866,
-41970,
-42047,
-42089,
-42118,
-42112,
-42083,
-41999,
-41874,
-41704,
-41514,
-41312,
-41113,
-40928,
-40762,
-40640,
-40563,
-40540,
-40560,
-40625,
-40718,
-40856,
-41005,
-41183,
-41351,
-41522,
-41686,
-41850,
-42017,
-42175,
-42330,
-42463,
-42576,
-42658,
-42701,
-42711,
-42665,
-42587,
-42458,
-42295,
-42090,
-41870,
-41638,
-41423,
-41228,
-41058,
-40912,
-40791,
-40697,
-40635,
-40592,
-40562,
-40534,
-40494,
-40452,
-40397,
-40340,
-40259,
-40166,
-40048,
-39918,
-39769,
-39596,
-39380,
-39125,
-38826,
-38499,
-38146,
-37773,
-37383,
-36979,
-36586,
-36217,
-35888,
-35625,
-35406,
-35243,
-35130,
-35064,
-35055,
-35090,
-35161,
-35261,
-35363,
-35485,
-35595,
-35720,
-35833,
-35937,
-36018,
-36071,
-36092,
-36073,
-36014,
-35903,
-35745,
-35535,
-35287,
-35013,
-34714,
-34417,
-34115,
-33837,
-33587,
-33381,
-33222,
-33105,
-33030,
-32992,
-32984,
-33005,
-33046,
-33097,
-33157,
-33205,
-33249,
-33272,
-33277,
-33255,
-33206,
-33112,
-32982,
-32794,
-32557,
-32275,
-31946,
-31589,
-31199,
-30795,
-30390,
-30002,
-29644,
-29334,
-29067,
-28862,
-28710,
-28629,
-28598,
-28630,
-28692,
-28791,
-28915,
-29060,
-29220,
-29373,
-29519,
-29632,
-29728,
-29791,
-29824,
-29813,
-29751,
-29632,
-29472,
-29265,
-29033,
-28769,
-28485,
-28195,
-27907,
-27657,
-27436,
-27275,
-27155,
-27099,
-27100,
-27161,
-27276,
-27437,
-27621,
-27834,
-28039,
-28258,
-28448,
-28620,
-28752,
-28843,
-28883,
-28875,
-28799,
-28676,
-28483,
-28245,
-27947,
-27610,
-27235,
-26836,
-26433,
-26039,
-25670,
-25345,
-25063,
-24857,
-24708,
-24649,
-24656,
-24737,
-24873,
-25066,
-25292,
-25554,
-25820,
-26090,
-26344,
-26572,
-26769,
-26924,
-27032,
-27089,
-27088,
-27037,
-26941,
-26799,
-26626,
-26412,
-26196,
-25958,
-25745,
-25544,
-25377,
-25256,
-25182,
-25174,
-25228,
-25345,
-25526,
-25753,
-26026,
-26325,
-26645,
-26955,
-27257,
-27515,
-27732,
-27888,
-27987,
-28020,
-27983,
-27887,
-27724,
-27515,
-27267,
-26981,
-26682,
-26362,
-26048,
-25750,
-25472,
-25245,
-25065,
-24955,
-24916,
-24954,
-25076,
-25276,
-25546,
-25879,
-26251,
-26653,
-27063,
-27462,
-27844,
-28174,
-28466,
-28686,
-28851,
-28945,
-28980,
-28952,
-28869,
-28740,
-28567,
-28370,
-28154,
-27924,
-27711,
-27502,
-27336,
-27205,
-27129,
-27114,
-27161,
-27275,
-27449,
-27681,
-27960,
-28272,
-28604,
-28941,
-29264,
-29561,
-29823,
-30030,
-30182,
-30272,
-30295,
-30259,
-30165,
-30021,
-29837,
-29632,
-29400,
-29180,
-28954,
-28768,
-28598,
-28485,
-28418,
-28414,
-28474,
-28604,
-28799,
-29063,
-29386,
-29757,
-30169,
-30603,
-31042,
-31472,
-31867,
-32228,
-32530,
-32764,
-32938,
-33028,
-33058,
-33022,
-32929,
-32792,
-32622,
-32418,
-32217,
-32000,
-31806,
-31625,
-31479,
-31370,
-31311,
-31303,
-31362,
-31480,
-31659,
-31894,
-32168,
-32483,
-32818,
-33162,
-33499,
-33811,
-34086,
-34320,
-34499,
-34639,
-34714,
-34749,
-34733,
-34672,
-34585,
-34469,
-34345,
-34211,
-34088,
-33968,
-33888,
-33830,
-33832,
-33873,
-33979,
-34139,
-34357,
-34635,
-34953,
-35317,
-35699,
-36104,
-36503,
-36895,
-37255,
-37587,
-37865,
-38104,
-38274,
-38400,
-38460,
-38470,
-38433,
-38348,
-38237,
-38092,
-37937,
-37772,
-37619,
-37481,
-37369,
-37292,
-37251,
-37263,
-37324,
-37432,
-37599,
-37797,
-38039,
-38310,
-38598,
-38903,
-39195,
-39479,
-39731,
-39952,
-40131,
-40265,
-40352,
-40387,
-40380,
-40334,
-40248,
-40143,
-40003,
-39859,
-39703,
-39553,
-39420,
-39296,
-39207,
-39139,
-39120,
-39140,
-39211,
-39325,
-39478,
-39666,
-39881,
-40116,
-40363,
-40611,
-40845,
-41056,
-41236,
-41380,
-41494,
-41560,
-41592,
-41578,
-41527,
-41441,
-41330,
-41190,
-41039,
-40866,
-40692,
-40518,
-40354,
-40211,
-40089,
-39995,
-39934,
-39903,
-39911,
-39945,
-40009,
-40081,
-40169,
-40250,
-40332,
-40396,
-40437,
-40451,
-40422,
-40364,
-40253,
-40115,
-39923,
-39700,
-39435,
-39141,
-38822,
-38479,
-38131,
-37774,
-37437,
-37105,
-36809,
-36534,
-36307,
-36121,
-35988,
-35901,
-35861,
-35860,
-35897,
-35962,
-36052,
-36155,
-36259,
-36364,
-36448,
-36526,
-36574,
-36598,
-36580,
-36535,
-36437,
-36322,
-36154,
-35959,
-35724,
-35458,
-35178,
-34881,
-34586,
-34293,
-34002,
-33736,
-33485,
-33273,
-33086,
-32927,
-32793,
-32669,
-32566,
-32467,
-32370,
-32267,
-32154,
-32024,
-31880,
-31711,
-31530,
-31318,
-31088,
-30829,
-30545,
-30238,
-29903,
-29554,
-29185,
-28820,
-28450,
-28096,
-27769,
-27470,
-27223,
-27016,
-26865,
-26767,
-26710,
-26708,
-26731,
-26797,
-26865,
-26956,
-27039,
-27126,
-27203,
-27265,
-27318,
-27338,
-27343,
-27316,
-27263,
-27174,
-27049,
-26884,
-26683,
-26447,
-26194,
-25911,
-25639,
-25352,
-25101,
-24859,
-24670,
-24503,
-24398,
-24307,
-24271,
-24245,
-24252,
-24256,
-24272,
-24276,
-24268,
-24255,
-24214,
-24174,
-24104,
-24025,
-23918,
-23792,
-23645,
-23470,
-23268,
-23038,
-22776,
-22507,
-22223,
-21952,
-21695,
-21468,
-21288,
-21153,
-21088,
-21074,
-21127,
-21219,
-21355,
-21518,
-21701,
-21898,
-22088,
-22283,
-22460,
-22637,
-22796,
-22951,
-23087,
-23215,
-23311,
-23392,
-23434,
-23448,
-23419,
-23367,
-23276,
-23178,
-23062,
-22957,
-22867,
-22813,
-22799,
-22831,
-22904,
-23018,
-23164,
-23330,
-23514,
-23691,
-23864,
-24014,
-24146,
-24259,
-24351,
-24428,
-24483,
-24519,
-24534,
-24536,
-24505,
-24463,
-24375,
-24275,
-24136,
-23993,
-23844,
-23700,
-23583,
-23497,
-23467,
-23489,
-23587,
-23737,
-23958,
-24215,
-24521,
-24843,
-25184,
-25522,
-25850,
-26176,
-26473,
-26773,
-27046,
-27316,
-27568,
-27810,
-28030,
-28240,
-28412,
-28562,
-28681,
-28768,
-28840,
-28894,
-28951,
-29025,
-29121,
-29267,
-29444,
-29694,
-29970,
-30306,
-30661,
-31039,
-31411,
-31778,
-32111,
-32425,
-32692,
-32937,
-33135,
-33313,
-33458,
-33577,
-33679,
-33745,
-33791,
-33790,
-33771,
-33705,
-33625,
-33518,
-33413,
-33311,
-33244,
-33209,
-33241,
-33328,
-33488,
-33712,
-33988,
-34318,
-34670,
-35056,
-35434,
-35819,
-36187,
-36542,
-36894,
-37222,
-37559,
-37874,
-38195,
-38503,
-38802,
-39092,
-39356,
-39607,
-39833,
-40043,
-40237,
-40435,
-40640,
-40867,
-41125,
-41419,
-41756,
-42131,
-42538,
-42962,
-43393,
-43811,
-44197,
-44553,
-44846,
-45090,
-45274,
-45396,
-45469,
-45491,
-45465,
-45409,
-45306,
-45177,
-45016,
-44819,
-44607,
-44367,
-44124,
-43887,
-43665,
-43483,
-43350,
-43279,
-43292,
-43376,
-43545,
-43781,
-44078,
-44424,
-44796,
-45184,
-45572,
-45950,
-46308,
-46646,
-46963,
-47258,
-47530,
-47785,
-48019,
-48226,
-48415,
-48563,
-48691,
-48775,
-48835,
-48870,
-48886,
-48900,
-48921,
-48959,
-49028,
-49125,
-49256,
-49415,
-49585,
-49769,
-49927,
-50072,
-50166,
-50214,
-50208,
-50141,
-50025,
-49858,
-49647,
-49403,
-49130,
-48826,
-48509,
-48160,
-47807,
-47427,
-47052,
-46669,
-46307,
-45976,
-45675,
-45448,
-45271,
-45185,
-45164,
-45222,
-45341,
-45503,
-45704,
-45907,
-46110,
-46291,
-46436,
-46540,
-46597,
-46610,
-46573,
-46502,
-46381,
-46234,
-46041,
-45816,
-45559,
-45264,
-44954,
-44607,
-44271,
-43915,
-43598,
-43294,
-43048,
-42845,
-42710,
-42625,
-42601,
-42609,
-42656,
-42705,
-42752,
-42778,
-42764,
-42709,
-42603,
-42442,
-42239,
-41977,
-41681,
-41342,
-40966,
-40567,
-40129,
-39671,
-39192,
-38691,
-38192,
-37689,
-37208,
-36753,
-36339,
-35982,
-35680,
-35449,
-35270,
-35148,
-35063,
-35005,
-34948,
-34890,
-34796,
-34673,
-34501,
-34280,
-34017,
-33704,
-33362,
-32982,
-32585,
-32166,
-31744,
-31312,
-30881,
-30458,
-30045,
-29657,
-29301,
-28992,
-28740,
-28554,
-28445,
-28409,
-28454,
-28567,
-28729,
-28939,
-29155,
-29370,
-29550,
-29684,
-29754,
-29756,
-29670,
-29511,
-29271,
-28957,
-28587,
-28157,
-27682,
-27167,
-26613,
-26034,
-25433,
-24832,
-24221,
-23641,
-23080,
-22570,
-22125,
-21747,
-21461,
-21250,
-21123,
-21052,
-21049,
-21062,
-21105,
-21127,
-21132,
-21096,
-21016,
-20889,
-20726,
-20523,
-20299,
-20059,
-19809,
-19568,
-19328,
-19104,
-18889,
-18694,
-18512,
-18364,
-18246,
-18176,
-18164,
-18211,
-18339,
-18536,
-18806,
-19136,
-19509,
-19894,
-20279,
-20617,
-20907,
-21109,
-21219,
-21230,
-21139,
-20962,
-20706,
-20390,
-20026,
-19636,
-19219,
-18801,
-18368,
-17946,
-17526,
-17125,
-16746,
-16408,
-16124,
-15915,
-15791,
-15769,
-15845,
-16026,
-16298,
-16642,
-17035,
-17443,
-17841,
-18194,
-18496,
-18719,
-18870,
-18944,
-18952,
-18908,
-18828,
-18731,
-18621,
-18527,
-18427,
-18346,
-18262,
-18203,
-18153,
-18133,
-18153,
-18208,
-18342,
-18542,
-18834,
-19219,
-19681,
-20222,
-20800,
-21404,
-21990,
-22540,
-23019,
-23404,
-23684,
-23866,
-23942,
-23943,
-23862,
-23741,
-23577,
-23399,
-23212,
-23028,
-22845,
-22674,
-22508,
-22364,
-22250,
-22174,
-22162,
-22213,
-22361,
-22586,
-22923,
-23327,
-23827,
-24362,
-24938,
-25499,
-26032,
-26508,
-26907,
-27231,
-27463,
-27625,
-27713,
-27753,
-27761,
-27750,
-27739,
-27737,
-27746,
-27779,
-27841,
-27929,
-28069,
-28233,
-28464,
-28746,
-29106,
-29540,
-30052,
-30626,
-31263,
-31936,
-32632,
-33324,
-33983,
-34579,
-35099,
-35516,
-35834,
-36044,
-36146,
-36163,
-36089,
-35961,
-35777,
-35578,
-35356,
-35151,
-34952,
-34790,
-34666,
-34600,
-34590,
-34653,
-34788,
-35010,
-35307,
-35692,
-36146,
-36669,
-37235,
-37844,
-38456,
-39077,
-39663,
-40214,
-40704,
-41125,
-41470,
-41737,
-41926,
-42056,
-42122,
-42152,
-42150,
-42140,
-42140,
-42162,
-42225,
-42332,
-42491,
-42705,
-42975,
-43296,
-43670,
-44079,
-44521,
-44986,
-45460,
-45943,
-46417,
-46878,
-47303,
-47691,
-48026,
-48291,
-48492,
-48599,
-48625,
-48561,
-48423,
-48219,
-47976,
-47705,
-47441,
-47198,
-47006,
-46880,
-46832,
-46868,
-46984,
-47162,
-47415,
-47694,
-48033,
-48375,
-48743,
-49110,
-49476,
-49839,
-50193,
-50531,
-50844,
-51117,
-51339,
-51491,
-51570,
-51566,
-51478,
-51314,
-51085,
-50821,
-50540,
-50282,
-50060,
-49912,
-49840,
-49865,
-49969,
-50168,
-50411,
-50721,
-51045,
-51387,
-51738,
-52066,
-52402,
-52709,
-53012,
-53294,
-53550,
-53778,
-53948,
-54063,
-54091,
-54029,
-53867,
-53597,
-53243,
-52807,
-52322,
-51815,
-51305,
-50828,
-50397,
-50028,
-49725,
-49479,
-49283,
-49118,
-48971,
-48829,
-48680,
-48518,
-48347,
-48163,
-47984,
-47800,
-47633,
-47456,
-47293,
-47110,
-46919,
-46702,
-46450,
-46166,
-45860,
-45527,
-45216,
-44912,
-44675,
-44487,
-44399,
-44383,
-44475,
-44630,
-44869,
-45136,
-45434,
-45726,
-45995,
-46231,
-46413,
-46543,
-46612,
-46617,
-46558,
-46430,
-46223,
-45944,
-45565,
-45105,
-44540,
-43892,
-43162,
-42370,
-41532,
-40677,
-39829,
-39008,
-38243,
-37536,
-36906,
-36338,
-35845,
-35399,
-35014,
-34654,
-34338,
-34033,
-33753,
-33481,
-33225,
-32974,
-32731,
-32478,
-32219,
-31936,
-31630,
-31297,
-30934,
-30557,
-30164,
-29784,
-29419,
-29098,
-28830,
-28620,
-28480,
-28399,
-28371,
-28394,
-28434,
-28504,
-28564,
-28629,
-28678,
-28716,
-28735,
-28730,
-28698,
-28624,
-28499,
-28310,
-28038,
-27677,
-27220,
-26679,
-26044,
-25363,
-24633,
-23906,
-23196,
-22539,
-21948,
-21429,
-20995,
-20620,
-20310,
-20033,
-19786,
-19547,
-19321,
-19090,
-18875,
-18672,
-18486,
-18328,
-18184,
-18045,
-17902,
-17717,
-17484,
-17181,
-16787,
-16322,
-15776,
-15193,
-14592,
-14022,
-13512,
-13104,
-12810,
-12649,
-12614,
-12686,
-12853,
-13068,
-13327,
-13586,
-13851,
-14106,
-14362,
-14623,
-14901,
-15196,
-15510,
-15827,
-16136,
-16392,
-16585,
-16657,
-16612,
-16423,
-16109,
-15683,
-15188,
-14660,
-14152,
-13704,
-13351,
-13107,
-12983,
-12951,
-13004,
-13096,
-13204,
-13302,
-13365,
-13403,
-13414,
-13419,
-13437,
-13480,
-13566,
-13680,
-13830,
-13965,
-14078,
-14121,
-14070,
-13913,
-13647,
-13291,
-12877,
-12451,
-12062,
-11765,
-11587,
-11569,
-11693,
-11971,
-12356,
-12822,
-13328,
-13837,
-14320,
-14769,
-15183,
-15576,
-15963,
-16366,
-16793,
-17247,
-17724,
-18193,
-18628,
-18991,
-19253,
-19396,
-19412,
-19317,
-19132,
-18907,
-18685,
-18525,
-18463,
-18531,
-18742,
-19078,
-19532,
-20056,
-20622,
-21196,
-21739,
-22245,
-22694,
-23110,
-23492,
-23872,
-24246,
-24630,
-25001,
-25357,
-25662,
-25887,
-26020,
-26018,
-25901,
-25655,
-25326,
-24941,
-24555,
-24213,
-23952,
-23817,
-23810,
-23949,
-24218,
-24591,
-25044,
-25548,
-26080,
-26625,
-27185,
-27743,
-28325,
-28922,
-29550,
-30204,
-30877,
-31546,
-32195,
-32784,
-33307,
-33728,
-34053,
-34277,
-34419,
-34504,
-34565,
-34628,
-34739,
-34896,
-35144,
-35451,
-35840,
-36274,
-36739,
-37225,
-37700,
-38171,
-38620,
-39047,
-39463,
-39858,
-40245,
-40618,
-40963,
-41276,
-41539,
-41739,
-41870,
-41921,
-41899,
-41805,
-41676,
-41514,
-41371,
-41248,
-41189,
-41186,
-41275,
-41434,
-41680,
-41994,
-42360,
-42775,
-43217,
-43691,
-44183,
-44690,
-45206,
-45714,
-46216,
-46690,
-47124,
-47509,
-47813,
-48044,
-48179,
-48233,
-48209,
-48115,
-47983,
-47819,
-47661,
-47515,
-47409,
-47341,
-47334,
-47377,
-47480,
-47635,
-47847,
-48108,
-48424,
-48787,
-49198,
-49649,
-50127,
-50626,
-51126,
-51607,
-52050,
-52432,
-52738,
-52958,
-53092,
-53133,
-53100,
-52990,
-52828,
-52625,
-52397,
-52158,
-51910,
-51669,
-51425,
-51197,
-50973,
-50772,
-50589,
-50430,
-50312,
-50216,
-50174,
-50157,
-50171,
-50206,
-50236,
-50265,
-50256,
-50224,
-50129,
-50005,
-49817,
-49605,
-49352,
-49097,
-48829,
-48578,
-48339,
-48127,
-47944,
-47795,
-47680,
-47606,
-47569,
-47579,
-47628,
-47738,
-47885,
-48090,
-48319,
-48579,
-48844,
-49100,
-49328,
-49503,
-49616,
-49653,
-49603,
-49478,
-49266,
-48990,
-48645,
-48246,
-47802,
-47323,
-46817,
-46287,
-45745,
-45200,
-44660,
-44144,
-43657,
-43222,
-42843,
-42536,
-42298,
-42126,
-42014,
-41950,
-41912,
-41893,
-41863,
-41814,
-41733,
-41615,
-41456,
-41264,
-41037,
-40783,
-40501,
-40201,
-39876,
-39538,
-39175,
-38796,
-38407,
-38008,
-37629,
-37267,
-36952,
-36692,
-36498,
-36382,
-36339,
-36367,
-36444,
-36560,
-36688,
-36810,
-36912,
-36975,
-36999,
-36974,
-36907,
-36801,
-36652,
-36482,
-36263,
-36020,
-35728,
-35403,
-35022,
-34609,
-34153,
-33675,
-33194,
-32721,
-32287,
-31897,
-31581,
-31322,
-31143,
-31007,
-30929,
-30861,
-30809,
-30737,
-30647,
-30520,
-30359,
-30171,
-29950,
-29716,
-29457,
-29188,
-28894,
-28583,
-28244,
-27872,
-27480,
-27055,
-26627,
-26197,
-25801,
-25444,
-25165,
-24957,
-24848,
-24823,
-24878,
-25002,
-25169,
-25356,
-25555,
-25728,
-25889,
-26003,
-26092,
-26132,
-26144,
-26107,
-26031,
-25899,
-25711,
-25454,
-25120,
-24715,
-24239,
-23704,
-23135,
-22552,
-21981,
-21454,
-20980,
-20587,
-20273,
-20043,
-19879,
-19782,
-19716,
-19687,
-19667,
-19661,
-19651,
-19650,
-19643,
-19645,
-19634,
-19623,
-19575,
-19499,
-19366,
-19164,
-18897,
-18550,
-18141,
-17684,
-17201,
-16723,
-16267,
-15866,
-15527,
-15266,
-15070,
-14943,
-14861,
-14816,
-14788,
-14767,
-14751,
-14731,
-14720,
-14709,
-14713,
-14722,
-14737,
-14736,
-14714,
-14644,
-14516,
-14318,
-14038,
-13700,
-13301,
-12882,
-12462,
-12080,
-11757,
-11525,
-11379,
-11343,
-11383,
-11511,
-11685,
-11902,
-12138,
-12385,
-12637,
-12897,
-13162,
-13435,
-13714,
-13991,
-14248,
-14468,
-14624,
-14689,
-14647,
-14483,
-14196,
-13801,
-13315,
-12773,
-12209,
-11663,
-11165,
-10740,
-10401,
-10148,
-9986,
-9889,
-9864,
-9876,
-9940,
-10044,
-10194,
-10401,
-10667,
-11004,
-11402,
-11854,
-12339,
-12835,
-13309,
-13733,
-14088,
-14349,
-14534,
-14631,
-14677,
-14695,
-14715,
-14773,
-14884,
-15070,
-15331,
-15655,
-16049,
-16466,
-16921,
-17375,
-17841,
-18309,
-18782,
-19278,
-19788,
-20327,
-20875,
-21428,
-21959,
-22436,
-22836,
-23128,
-23293,
-23331,
-23245,
-23050,
-22788,
-22479,
-22176,
-21900,
-21688,
-21545,
-21495,
-21511,
-21611,
-21762,
-21973,
-22232,
-22542,
-22913,
-23353,
-23868,
-24474,
-25149,
-25902,
-26695,
-27499,
-28293,
-29017,
-29665,
-30204,
-30628,
-30948,
-31176,
-31339,
-31479,
-31611,
-31777,
-31979,
-32236,
-32543,
-32891,
-33269,
-33672,
-34082,
-34520,
-34963,
-35458,
-35978,
-36568,
-37207,
-37901,
-38627,
-39361,
-40065,
-40704,
-41241,
-41651,
-41916,
-42035,
-42019,
-41897,
-41695,
-41450,
-41195,
-40957,
-40748,
-40578,
-40451,
-40347,
-40280,
-40222,
-40203,
-40198,
-40265,
-40374,
-40589,
-40888,
-41298,
-41802,
-42378,
-43000,
-43622,
-44213,
-44726,
-45142,
-45441,
-45620,
-45698,
-45691,
-45644,
-45571,
-45510,
-45479,
-45480,
-45528,
-45598,
-45690,
-45796,
-45897,
-46017,
-46139,
-46308,
-46517,
-46809,
-47172,
-47626,
-48147,
-48718,
-49298,
-49846,
-50322,
-50680,
-50904,
-50968,
-50884,
-50663,
-50336,
-49932,
-49488,
-49027,
-48582,
-48141,
-47737,
-47334,
-46947,
-46563,
-46180,
-45819,
-45481,
-45204,
-45004,
-44911,
-44932,
-45079,
-45334,
-45676,
-46070,
-46471,
-46834,
-47130,
-47314,
-47393,
-47348,
-47203,
-46986,
-46710,
-46426,
-46134,
-45867,
-45618,
-45398,
-45182,
-44978,
-44769,
-44557,
-44357,
-44172,
-44040,
-43973,
-43996,
-44123,
-44353,
-44676,
-45063,
-45487,
-45892,
-46257,
-46523,
-46684,
-46715,
-46624,
-46421,
-46134,
-45780,
-45401,
-45006,
-44617,
-44244,
-43872,
-43520,
-43156,
-42804,
-42446,
-42115,
-41803,
-41559,
-41380,
-41310,
-41336,
-41477,
-41704,
-42003,
-42335,
-42658,
-42940,
-43140,
-43237,
-43222,
-43088,
-42851,
-42530,
-42142,
-41718,
-41268,
-40818,
-40357,
-39906,
-39451,
-38995,
-38551,
-38114,
-37709,
-37353,
-37066,
-36875,
-36793,
-36832,
-36985,
-37247,
-37588,
-37977,
-38388,
-38773,
-39113,
-39384,
-39571,
-39674,
-39708,
-39669,
-39585,
-39470,
-39321,
-39170,
-38993,
-38810,
-38610,
-38394,
-38171,
-37939,
-37727,
-37535,
-37393,
-37311,
-37293,
-37358,
-37479,
-37656,
-37858,
-38059,
-38225,
-38336,
-38357,
-38287,
-38106,
-37828,
-37451,
-36995,
-36474,
-35895,
-35289,
-34642,
-33989,
-33312,
-32637,
-31973,
-31320,
-30718,
-30163,
-29696,
-29324,
-29065,
-28932,
-28921,
-29026,
-29231,
-29506,
-29842,
-30186,
-30538,
-30856,
-31140,
-31370,
-31549,
-31673,
-31746,
-31779,
-31757,
-31711,
-31617,
-31489,
-31333,
-31142,
-30935,
-30719,
-30507,
-30315,
-30161,
-30050,
-30000,
-30001,
-30060,
-30154,
-30274,
-30395,
-30497,
-30557,
-30559,
-30483,
-30334,
-30091,
-29771,
-29364,
-28883,
-28331,
-27717,
-27050,
-26337,
-25594,
-24825,
-24057,
-23303,
-22582,
-21927,
-21343,
-20857,
-20482,
-20213,
-20071,
-20026,
-20089,
-20225,
-20427,
-20681,
-20948,
-21245,
-21523,
-21802,
-22050,
-22274,
-22455,
-22598,
-22688,
-22726,
-22719,
-22652,
-22551,
-22418,
-22261,
-22114,
-21975,
-21872,
-21815,
-21801,
-21851,
-21945,
-22083,
-22246,
-22430,
-22611,
-22783,
-22932,
-23045,
-23123,
-23152,
-23129,
-23050,
-22901,
-22681,
-22383,
-21998,
-21538,
-20991,
-20390,
-19739,
-19070,
-18407,
-17782,
-17214,
-16736,
-16349,
-16071,
-15893,
-15811,
-15814,
-15885,
-16015,
-16188,
-16398,
-16641,
-16913,
-17205,
-17526,
-17844,
-18177,
-18470,
-18746,
-18951,
-19095,
-19156,
-19138,
-19052,
-18912,
-18750,
-18590,
-18464,
-18395,
-18406,
-18495,
-18674,
-18919,
-19219,
-19556,
-19899,
-20255,
-20582,
-20912,
-21214,
-21516,
-21809,
-22099,
-22376,
-22632,
-22845,
-22996,
-23063,
-23021,
-22868,
-22603,
-22238,
-21801,
-21321,
-20842,
-20405,
-20031,
-19756,
-19578,
-19507,
-19515,
-19598,
-19719,
-19862,
-20023,
-20167,
-20334,
-20498,
-20692,
-20923,
-21187,
-21497,
-21832,
-22171,
-22496,
-22768,
-22976,
-23089,
-23122,
-23067,
-22968,
-22842,
-22740,
-22695,
-22743,
-22899,
-23181,
-23562,
-24042,
-24578,
-25149,
-25720,
-26275,
-26794,
-27287,
-27749,
-28200,
-28647,
-29096,
-29549,
-29988,
-30400,
-30747,
-31013,
-31159,
-31178,
-31059,
-30819,
-30475,
-30073,
-29647,
-29247,
-28911,
-28663,
-28518,
-28484,
-28533,
-28659,
-28830,
-29020,
-29220,
-29411,
-29606,
-29798,
-30025,
-30274,
-30577,
-30925,
-31314,
-31732,
-32148,
-32537,
-32873,
-33134,
-33312,
-33407,
-33436,
-33424,
-33405,
-33409,
-33477,
-33618,
-33858,
-34182,
-34585,
-35045,
-35530,
-36017,
-36486,
-36916,
-37306,
-37660,
-37974,
-38277,
-38556,
-38842,
-39107,
-39364,
-39581,
-39750,
-39848,
-39856,
-39775,
-39594,
-39344,
-39031,
-38693,
-38368,
-38074,
-37859,
-37716,
-37679,
-37723,
-37856,
-38044,
-38279,
-38535,
-38806,
-39066,
-39338,
-39591,
-39868,
-40138,
-40435,
-40737,
-41045,
-41355,
-41635,
-41883,
-42074,
-42199,
-42255,
-42240,
-42168,
-42057,
-41925,
-41803,
-41699,
-41646,
-41639,
-41688,
-41784,
-41921,
-42077,
-42246,
-42408,
-42551,
-42680,
-42781,
-42870,
-42943,
-43003,
-43071,
-43120,
-43179,
-43207,
-43232,
-43208,
-43167,
-43065,
-42938,
-42766,
-42575,
-42376,
-42184,
-42021,
-41896,
-41827,
-41813,
-41859,
-41955,
-42092,
-42264,
-42449,
-42642,
-42828,
-43004,
-43165,
-43313,
-43440,
-43558,
-43654,
-43742,
-43802,
-43842,
-43847,
-43818,
-43747,
-43635,
-43481,
-43292,
-43075,
-42842,
-42609,
-42380,
-42173,
-41997,
-41849,
-41747,
-41668,
-41626,
-41603,
-41596,
-41601,
-41603,
-41605,
-41597,
-41588,
-41565,
-41542,
-41508,
-41473,
-41432,
-41386,
-41333,
-41271,
-41202,
-41120,
-41031,
-40929,
-40827,
-40721,
-40620,
-40536,
-40460,
-40415,
-40391,
-40395,
-40427,
-40480,
-40547,
-40625,
-40700,
-40768,
-40818,
-40846,
-40840,
-40813,
-40749,
-40667,
-40559,
-40433,
-40301,
-40152,
-39998,
-39840,
-39668,
-39492,
-39299,
-39097,
-38885,
-38665,
-38448,
-38232,
-38039,
-37860,
-37715,
-37601,
-37514,
-37457,
-37412,
-37374,
-37340,
-37276,
-37209,
-37102,
-36980,
-36839,
-36685,
-36539,
-36393,
-36276,
-36171,
-36094,
-36031,
-35975,
-35919,
-35855,
-35775,
-35679,
-35566,
-35448,
-35327,
-35228,
-35142,
-35096,
-35072,
-35078,
-35100,
-35120,
-35131,
-35108,
-35052,
-34944,
-34807,
-34623,
-34438,
-34239,
-34064,
-33910,
-33792,
-33707,
-33645,
-33590,
-33534,
-33446,
-33335,
-33171,
-32978,
-32747,
-32505,
-32258,
-32027,
-31825,
-31648,
-31500,
-31365,
-31221,
-31069,
-30863,
-30624,
-30325,
-29987,
-29624,
-29258,
-28914,
-28618,
-28387,
-28222,
-28140,
-28097,
-28111,
-28124,
-28146,
-28127,
-28096,
-28018,
-27935,
-27843,
-27779,
-27745,
-27772,
-27839,
-27964,
-28107,
-28262,
-28393,
-28487,
-28519,
-28504,
-28429,
-28334,
-28227,
-28146,
-28110,
-28135,
-28216,
-28352,
-28509,
-28666,
-28783,
-28837,
-28794,
-28663,
-28430,
-28124,
-27762,
-27371,
-26976,
-26594,
-26233,
-25881,
-25533,
-25162,
-24751,
-24291,
-23774,
-23214,
-22634,
-22067,
-21552,
-21129,
-20828,
-20658,
-20645,
-20739,
-20951,
-21213,
-21516,
-21802,
-22075,
-22304,
-22517,
-22711,
-22923,
-23174,
-23475,
-23848,
-24270,
-24739,
-25215,
-25676,
-26084,
-26428,
-26690,
-26881,
-27022,
-27136,
-27262,
-27423,
-27640,
-27913,
-28233,
-28563,
-28876,
-29112,
-29244,
-29234,
-29069,
-28750,
-28299,
-27738,
-27119,
-26458,
-25807,
-25164,
-24547,
-23944,
-23338,
-22721,
-22077,
-21410,
-20736,
-20071,
-19486,
-18980,
-18650,
-18475,
-18526,
-18755,
-19182,
-19734,
-20396,
-21089,
-21795,
-22460,
-23081,
-23654,
-24192,
-24722,
-25270,
-25851,
-26489,
-27159,
-27866,
-28563,
-29234,
-29834,
-30355,
-30774,
-31111,
-31381,
-31614,
-31852,
-32113,
-32428,
-32787,
-33182,
-33572,
-33921,
-34168,
-34278,
-34215,
-33957,
-33524,
-32920,
-32197,
-31393,
-30556,
-29719,
-28921,
-28154,
-27435,
-26742,
-26074,
-25411,
-24772,
-24158,
-23599,
-23148,
-22824,
-22694,
-22760,
-23053,
-23551,
-24235,
-25049,
-25948,
-26862,
-27755,
-28575,
-29318,
-29968,
-30557,
-31093,
-31625,
-32157,
-32726,
-33313,
-33930,
-34534,
-35115,
-35640,
-36095,
-36475,
-36790,
-37056,
-37311,
-37576,
-37886,
-38245,
-38660,
-39101,
-39537,
-39926,
-40205,
-40347,
-40309,
-40074,
-39662,
-39077,
-38371,
-37583,
-36756,
-35933,
-35140,
-34394,
-33697,
-33046,
-32435,
-31858,
-31324,
-30833,
-30428,
-30119,
-29955,
-29949,
-30129,
-30489,
-31014,
-31677,
-32423,
-33209,
-33977,
-34684,
-35299,
-35814,
-36222,
-36554,
-36819,
-37066,
-37306,
-37571,
-37859,
-38179,
-38506,
-38845,
-39166,
-39469,
-39757,
-40026,
-40314,
-40622,
-40981,
-41397,
-41872,
-42398,
-42940,
-43470,
-43928,
-44292,
-44503,
-44553,
-44417,
-44115,
-43657,
-43088,
-42429,
-41734,
-41020,
-40318,
-39645,
-38994,
-38385,
-37797,
-37251,
-36741,
-36290,
-35918,
-35641,
-35488,
-35469,
-35587,
-35836,
-36190,
-36617,
-37073,
-37524,
-37921,
-38242,
-38474,
-38606,
-38663,
-38654,
-38615,
-38570,
-38543,
-38546,
-38590,
-38672,
-38789,
-38928,
-39098,
-39275,
-39493,
-39740,
-40037,
-40404,
-40830,
-41330,
-41884,
-42460,
-43039,
-43562,
-44009,
-44321,
-44495,
-44491,
-44335,
-44026,
-43592,
-43062,
-42472,
-41841,
-41205,
-40563,
-39938,
-39317,
-38719,
-38132,
-37574,
-37057,
-36588,
-36209,
-35915,
-35739,
-35679,
-35728,
-35869,
-36079,
-36313,
-36545,
-36736,
-36859,
-36903,
-36869,
-36757,
-36606,
-36425,
-36249,
-36099,
-35993,
-35930,
-35925,
-35951,
-36022,
-36113,
-36233,
-36375,
-36554,
-36776,
-37058,
-37403,
-37815,
-38282,
-38786,
-39294,
-39766,
-40176,
-40466,
-40634,
-40642,
-40500,
-40216,
-39816,
-39324,
-38781,
-38200,
-37626,
-37052,
-36503,
-35968,
-35448,
-34938,
-34451,
-33976,
-33548,
-33172,
-32868,
-32667,
-32560,
-32573,
-32669,
-32850,
-33069,
-33304,
-33509,
-33665,
-33752,
-33762,
-33704,
-33601,
-33465,
-33346,
-33246,
-33197,
-33208,
-33266,
-33378,
-33521,
-33677,
-33846,
-34007,
-34176,
-34351,
-34549,
-34781,
-35051,
-35372,
-35715,
-36081,
-36421,
-36712,
-36914,
-36997,
-36949,
-36749,
-36421,
-35975,
-35451,
-34876,
-34289,
-33720,
-33185,
-32698,
-32252,
-31845,
-31468,
-31105,
-30769,
-30444,
-30165,
-29932,
-29780,
-29716,
-29760,
-29903,
-30142,
-30443,
-30784,
-31119,
-31423,
-31662,
-31829,
-31913,
-31942,
-31919,
-31896,
-31882,
-31911,
-32003,
-32139,
-32337,
-32555,
-32787,
-32996,
-33181,
-33315,
-33420,
-33489,
-33556,
-33621,
-33713,
-33828,
-33967,
-34103,
-34219,
-34270,
-34239,
-34083,
-33804,
-33389,
-32873,
-32263,
-31626,
-30975,
-30370,
-29830,
-29371,
-28996,
-28698,
-28452,
-28243,
-28058,
-27875,
-27717,
-27571,
-27482,
-27451,
-27520,
-27682,
-27952,
-28304,
-28716,
-29152,
-29569,
-29930,
-30212,
-30394,
-30490,
-30511,
-30485,
-30458,
-30448,
-30496,
-30599,
-30764,
-30973,
-31193,
-31407,
-31566,
-31675,
-31706,
-31678,
-31603,
-31507,
-31418,
-31354,
-31331,
-31339,
-31369,
-31380,
-31355,
-31243,
-31033,
-30707,
-30267,
-29747,
-29174,
-28595,
-28057,
-27593,
-27229,
-26982,
-26826,
-26763,
-26741,
-26752,
-26754,
-26756,
-26732,
-26728,
-26737,
-26815,
-26957,
-27204,
-27527,
-27934,
-28378,
-28826,
-29240,
-29572,
-29811,
-29942,
-29973,
-29944,
-29869,
-29815,
-29787,
-29840,
-29955,
-30147,
-30378,
-30624,
-30853,
-31032,
-31143,
-31190,
-31173,
-31127,
-31075,
-31045,
-31061,
-31134,
-31243,
-31394,
-31519,
-31620,
-31630,
-31549,
-31360,
-31073,
-30722,
-30331,
-29959,
-29640,
-29401,
-29269,
-29232,
-29286,
-29396,
-29531,
-29667,
-29777,
-29861,
-29918,
-29972,
-30050,
-30173,
-30372,
-30644,
-30996,
-31400,
-31825,
-32235,
-32595,
-32869,
-33049,
-33131,
-33138,
-33093,
-33043,
-33015,
-33044,
-33146,
-33317,
-33553,
-33818,
-34090,
-34336,
-34530,
-34672,
-34753,
-34799,
-34832,
-34871,
-34953,
-35078,
-35255,
-35467,
-35687,
-35890,
-36031,
-36102,
-36071,
-35952,
-35757,
-35510,
-35255,
-35024,
-34849,
-34754,
-34737,
-34800,
-34919,
-35063,
-35220,
-35349,
-35461,
-35536,
-35603,
-35664,
-35764,
-35894,
-36098,
-36345,
-36647,
-36966,
-37276,
-37545,
-37746,
-37861,
-37884,
-37831,
-37709,
-37572,
-37419,
-37314,
-37243,
-37242,
-37282,
-37372,
-37472,
-37570,
-37648,
-37687,
-37705,
-37686,
-37675,
-37669,
-37708,
-37785,
-37920,
-38094,
-38294,
-38498,
-38671,
-38798,
-38857,
-38844,
-38764,
-38630,
-38474,
-38310,
-38178,
-38078,
-38030,
-38032,
-38063,
-38123,
-38169,
-38210,
-38211,
-38186,
-38130,
-38060,
-37983,
-37928,
-37890,
-37889,
-37900,
-37935,
-37949,
-37946,
-37886,
-37768,
-37580,
-37331,
-37028,
-36701,
-36360,
-36048,
-35761,
-35535,
-35355,
-35232,
-35150,
-35100,
-35072,
-35053,
-35047,
-35047,
-35071,
-35115,
-35205,
-35331,
-35505,
-35715,
-35953,
-36200,
-36435,
-36637,
-36791,
-36887,
-36915,
-36888,
-36797,
-36675,
-36521,
-36352,
-36182,
-36001,
-35830,
-35644,
-35459,
-35244,
-35025,
-34769,
-34506,
-34223,
-33939,
-33659,
-33389,
-33139,
-32910,
-32695,
-32498,
-32300,
-32108,
-31900,
-31685,
-31449,
-31208,
-30964,
-30722,
-30501,
-30302,
-30146,
-30031,
-29966,
-29948,
-29985,
-30060,
-30183,
-30334,
-30524,
-30733,
-30969,
-31216,
-31482,
-31750,
-32025,
-32292,
-32542,
-32774,
-32970,
-33122,
-33229,
-33265,
-33250,
-33159,
-33004,
-32789,
-32515,
-32198,
-31844,
-31463,
-31078,
-30681,
-30301,
-29927,
-29579,
-29242,
-28939,
-28640,
-28379,
-28129,
-27904,
-27713,
-27538,
-27412,
-27311,
-27252,
-27230,
-27236,
-27271,
-27325,
-27383,
-27457,
-27521,
-27586,
-27664,
-27732,
-27840,
-27961,
-28125,
-28330,
-28574,
-28859,
-29172,
-29510,
-29837,
-30180,
-30472,
-30769,
-31004,
-31234,
-31415,
-31585,
-31721,
-31841,
-31927,
-31980,
-31987,
-31933,
-31820,
-31630,
-31372,
-31055,
-30686,
-30294,
-29889,
-29507,
-29149,
-28842,
-28578,
-28368,
-28197,
-28054,
-27939,
-27829,
-27739,
-27656,
-27600,
-27574,
-27590,
-27662,
-27783,
-27958,
-28176,
-28416,
-28669,
-28912,
-29126,
-29317,
-29475,
-29615,
-29748,
-29898,
-30074,
-30304,
-30575,
-30906,
-31264,
-31658,
-32039,
-32411,
-32747,
-33040,
-33291,
-33504,
-33692,
-33864,
-34038,
-34207,
-34385,
-34543,
-34681,
-34765,
-34792,
-34734,
-34591,
-34371,
-34080,
-33752,
-33401,
-33068,
-32758,
-32504,
-32294,
-32131,
-32006,
-31884,
-31778,
-31645,
-31511,
-31353,
-31210,
-31076,
-30992,
-30956,
-30990,
-31090,
-31240,
-31436,
-31641,
-31844,
-32019,
-32166,
-32267,
-32367,
-32436,
-32550,
-32687,
-32893,
-33161,
-33494,
-33878,
-34291,
-34710,
-35108,
-35468,
-35781,
-36041,
-36267,
-36455,
-36646,
-36824,
-37023,
-37219,
-37414,
-37579,
-37698,
-37743,
-37695,
-37555,
-37311,
-36997,
-36615,
-36209,
-35797,
-35407,
-35050,
-34726,
-34441,
-34165,
-33897,
-33610,
-33299,
-32966,
-32612,
-32259,
-31929,
-31639,
-31416,
-31265,
-31189,
-31179,
-31220,
-31285,
-31362,
-31420,
-31470,
-31489,
-31510,
-31539,
-31595,
-31709,
-31878,
-32122,
-32424,
-32772,
-33146,
-33517,
-33866,
-34175,
-34435,
-34650,
-34828,
-34980,
-35131,
-35275,
-35435,
-35591,
-35740,
-35856,
-35923,
-35920,
-35827,
-35649,
-35383,
-35049,
-34665,
-34260,
-33849,
-33457,
-33087,
-32742,
-32414,
-32084,
-31750,
-31390,
-31007,
-30601,
-30184,
-29779,
-29401,
-29075,
-28813,
-28623,
-28506,
-28448,
-28435,
-28449,
-28471,
-28498,
-28512,
-28536,
-28567,
-28628,
-28737,
-28903,
-29135,
-29431,
-29784,
-30164,
-30571,
-30960,
-31336,
-31676,
-31981,
-32260,
-32519,
-32771,
-33031,
-33300,
-33578,
-33862,
-34124,
-34360,
-34536,
-34655,
-34685,
-34648,
-34535,
-34371,
-34172,
-33953,
-33735,
-33517,
-33316,
-33111,
-32901,
-32674,
-32415,
-32122,
-31802,
-31451,
-31102,
-30755,
-30447,
-30187,
-29983,
-29851,
-29772,
-29748,
-29760,
-29796,
-29846,
-29909,
-29979,
-30072,
-30200,
-30367,
-30606,
-30896,
-31268,
-31689,
-32164,
-32666,
-33181,
-33688,
-34180,
-34644,
-35086,
-35510,
-35917,
-36331,
-36734,
-37149,
-37554,
-37944,
-38304,
-38614,
-38863,
-39036,
-39130,
-39147,
-39097,
-38985,
-38834,
-38647,
-38443,
-38221,
-37981,
-37721,
-37436,
-37119,
-36764,
-36386,
-35967,
-35555,
-35122,
-34729,
-34353,
-34034,
-33767,
-33555,
-33402,
-33295,
-33233,
-33204,
-33213,
-33246,
-33322,
-33431,
-33594,
-33802,
-34072,
-34392,
-34761,
-35174,
-35607,
-36062,
-36513,
-36956,
-37380,
-37787,
-38164,
-38526,
-38858,
-39174,
-39459,
-39715,
-39934,
-40099,
-40218,
-40260,
-40247,
-40151,
-40000,
-39772,
-39503,
-39174,
-38811,
-38411,
-37979,
-37520,
-37031,
-36518,
-35985,
-35434,
-34872,
-34315,
-33767,
-33242,
-32755,
-32303,
-31907,
-31551,
-31256,
-30994,
-30796,
-30625,
-30511,
-30431,
-30408,
-30425,
-30503,
-30624,
-30803,
-31014,
-31272,
-31543,
-31833,
-32121,
-32402,
-32670,
-32920,
-33152,
-33365,
-33565,
-33746,
-33904,
-34046,
-34141,
-34215,
-34220,
-34183,
-34078,
-33913,
-33695,
-33427,
-33118,
-32786,
-32431,
-32067,
-31694,
-31309,
-30917,
-30508,
-30082,
-29643,
-29191,
-28734,
-28292,
-27864,
-27482,
-27140,
-26858,
-26631,
-26465,
-26343,
-26262,
-26211,
-26184,
-26171,
-26185,
-26212,
-26281,
-26377,
-26527,
-26716,
-26952,
-27225,
-27509,
-27816,
-28094,
-28364,
-28588,
-28782,
-28940,
-29068,
-29184,
-29286,
-29393,
-29500,
-29603,
-29706,
-29781,
-29826,
-29831,
-29778,
-29686,
-29540,
-29371,
-29181,
-29002,
-28831,
-28693,
-28587,
-28503,
-28446,
-28392,
-28335,
-28265,
-28183,
-28079,
-27987,
-27887,
-27835,
-27810,
-27848,
-27935,
-28083,
-28266,
-28481,
-28696,
-28914,
-29107,
-29281,
-29436,
-29580,
-29731,
-29901,
-30098,
-30335,
-30601,
-30890,
-31194,
-31477,
-31739,
-31955,
-32119,
-32235,
-32308,
-32353,
-32390,
-32428,
-32491,
-32568,
-32672,
-32782,
-32889,
-32974,
-33027,
-33031,
-32999,
-32931,
-32837,
-32750,
-32673,
-32641,
-32645,
-32705,
-32799,
-32933,
-33066,
-33204,
-33317,
-33408,
-33471,
-33517,
-33559,
-33614,
-33696,
-33815,
-33979,
-34176,
-34403,
-34633,
-34853,
-35049,
-35198,
-35307,
-35374,
-35410,
-35435,
-35460,
-35509,
-35575,
-35683,
-35798,
-35937,
-36059,
-36161,
-36227,
-36241,
-36216,
-36148,
-36053,
-35954,
-35852,
-35776,
-35716,
-35685,
-35664,
-35648,
-35615,
-35559,
-35465,
-35333,
-35173,
-34988,
-34799,
-34629,
-34477,
-34377,
-34312,
-34292,
-34304,
-34332,
-34369,
-34393,
-34406,
-34397,
-34375,
-34349,
-34329,
-34325,
-34350,
-34399,
-34480,
-34577,
-34677,
-34775,
-34842,
-34882,
-34884,
-34847,
-34786,
-34704,
-34619,
-34537,
-34476,
-34428,
-34398,
-34378,
-34354,
-34320,
-34261,
-34175,
-34053,
-33911,
-33736,
-33560,
-33370,
-33195,
-33017,
-32860,
-32699,
-32538,
-32370,
-32178,
-31971,
-31735,
-31478,
-31217,
-30947,
-30696,
-30461,
-30265,
-30098,
-29978,
-29887,
-29827,
-29791,
-29768,
-29752,
-29753,
-29746,
-29764,
-29782,
-29827,
-29880,
-29962,
-30045,
-30149,
-30243,
-30335,
-30407,
-30458,
-30483,
-30483,
-30460,
-30424,
-30374,
-30328,
-30279,
-30241,
-30209,
-30181,
-30161,
-30135,
-30111,
-30073,
-30036,
-29983,
-29931,
-29871,
-29813,
-29752,
-29692,
-29630,
-29559,
-29486,
-29388,
-29286,
-29157,
-29013,
-28852,
-28683,
-28503,
-28333,
-28157,
-28006,
-27865,
-27745,
-27651,
-27576,
-27523,
-27499,
-27488,
-27512,
-27551,
-27617,
-27709,
-27823,
-27960,
-28118,
-28287,
-28479,
-28669,
-28876,
-29072,
-29277,
-29478,
-29675,
-29878,
-30078,
-30283,
-30493,
-30705,
-30927,
-31149,
-31385,
-31612,
-31851,
-32084,
-32315,
-32546,
-32761,
-32973,
-33165,
-33336,
-33491,
-33605,
-33694,
-33739,
-33742,
-33708,
-33619,
-33503,
-33333,
-33145,
-32913,
-32676,
-32409,
-32150,
-31877,
-31628,
-31381,
-31170,
-30986,
-30841,
-30748,
-30702,
-30720,
-30796,
-30935,
-31136,
-31396,
-31712,
-32073,
-32480,
-32915,
-33383,
-33868,
-34367,
-34872,
-35384,
-35884,
-36390,
-36868,
-37348,
-37787,
-38219,
-38608,
-38976,
-39299,
-39598,
-39847,
-40077,
-40256,
-40412,
-40530,
-40612,
-40667,
-40673,
-40652,
-40581,
-40475,
-40314,
-40122,
-39875,
-39598,
-39283,
-38939,
-38577,
-38198,
-37817,
-37433,
-37066,
-36709,
-36377,
-36078,
-35810,
-35590,
-35413,
-35296,
-35232,
-35235,
-35297,
-35430,
-35615,
-35863,
-36155,
-36490,
-36857,
-37235,
-37634,
-38019,
-38411,
-38771,
-39121,
-39441,
-39731,
-39994,
-40218,
-40411,
-40564,
-40686,
-40763,
-40811,
-40819,
-40797,
-40748,
-40668,
-40579,
-40458,
-40344,
-40198,
-40061,
-39893,
-39726,
-39528,
-39313,
-39066,
-38788,
-38474,
-38127,
-37739,
-37325,
-36877,
-36403,
-35912,
-35403,
-34885,
-34359,
-33839,
-33311,
-32811,
-32310,
-31848,
-31409,
-31013,
-30662,
-30371,
-30128,
-29957,
-29842,
-29785,
-29793,
-29835,
-29933,
-30057,
-30215,
-30386,
-30581,
-30778,
-30996,
-31203,
-31429,
-31640,
-31857,
-32061,
-32253,
-32429,
-32585,
-32711,
-32816,
-32887,
-32932,
-32950,
-32935,
-32896,
-32824,
-32725,
-32590,
-32417,
-32196,
-31932,
-31609,
-31231,
-30796,
-30297,
-29760,
-29157,
-28535,
-27865,
-27192,
-26498,
-25813,
-25135,
-24480,
-23856,
-23270,
-22738,
-22264,
-21860,
-21541,
-21297,
-21163,
-21115,
-21173,
-21324,
-21570,
-21899,
-22302,
-22761,
-23277,
-23819,
-24390,
-24971,
-25549,
-26123,
-26682,
-27213,
-27723,
-28189,
-28619,
-29005,
-29336,
-29620,
-29846,
-30018,
-30138,
-30209,
-30231,
-30220,
-30165,
-30089,
-29980,
-29852,
-29702,
-29527,
-29339,
-29121,
-28891,
-28631,
-28364,
-28073,
-27782,
-27481,
-27187,
-26904,
-26637,
-26396,
-26183,
-26002,
-25868,
-25762,
-25717,
-25708,
-25759,
-25861,
-26022,
-26242,
-26521,
-26859,
-27254,
-27697,
-28181,
-28702,
-29244,
-29798,
-30358,
-30906,
-31442,
-31952,
-32442,
-32898,
-33325,
-33723,
-34084,
-34425,
-34721,
-35000,
-35240,
-35456,
-35645,
-35804,
-35949,
-36068,
-36182,
-36277,
-36375,
-36464,
-36553,
-36637,
-36714,
-36783,
-36836,
-36865,
-36875,
-36849,
-36798,
-36716,
-36602,
-36466,
-36309,
-36133,
-35953,
-35760,
-35574,
-35389,
-35210,
-35048,
-34900,
-34775,
-34681,
-34614,
-34594,
-34618,
-34689,
-34817,
-34993,
-35222,
-35494,
-35806,
-36145,
-36508,
-36882,
-37258,
-37637,
-37999,
-38356,
-38692,
-39016,
-39313,
-39596,
-39845,
-40073,
-40264,
-40424,
-40540,
-40624,
-40656,
-40663,
-40619,
-40553,
-40451,
-40325,
-40178,
-40002,
-39814,
-39594,
-39356,
-39088,
-38793,
-38468,
-38116,
-37738,
-37342,
-36934,
-36521,
-36113,
-35718,
-35337,
-34991,
-34664,
-34382,
-34125,
-33918,
-33741,
-33616,
-33535,
-33502,
-33525,
-33593,
-33724,
-33895,
-34118,
-34370,
-34653,
-34950,
-35244,
-35539,
-35803,
-36044,
-36249,
-36409,
-36533,
-36608,
-36639,
-36629,
-36572,
-36473,
-36326,
-36142,
-35904,
-35639,
-35323,
-34985,
-34616,
-34235,
-33839,
-33455,
-33063,
-32700,
-32337,
-32008,
-31680,
-31382,
-31081,
-30806,
-30530,
-30268,
-30018,
-29781,
-29563,
-29367,
-29196,
-29055,
-28938,
-28851,
-28792,
-28750,
-28741,
-28737,
-28764,
-28801,
-28864,
-28949,
-29052,
-29188,
-29337,
-29516,
-29707,
-29907,
-30113,
-30305,
-30490,
-30647,
-30781,
-30886,
-30954,
-31001,
-31012,
-31004,
-30964,
-30907,
-30824,
-30718,
-30592,
-30437,
-30261,
-30064,
-29843,
-29620,
-29374,
-29142,
-28904,
-28683,
-28478,
-28282,
-28110,
-27947,
-27798,
-27656,
-27521,
-27389,
-27269,
-27145,
-27045,
-26951,
-26886,
-26843,
-26828,
-26845,
-26891,
-26968,
-27073,
-27204,
-27359,
-27544,
-27752,
-27991,
-28261,
-28559,
-28897,
-29259,
-29653,
-30065,
-30491,
-30918,
-31339,
-31737,
-32112,
-32452,
-32748,
-33009,
-33217,
-33388,
-33508,
-33588,
-33619,
-33604,
-33544,
-33429,
-33276,
-33066,
-32827,
-32541,
-32243,
-31918,
-31598,
-31278,
-30979,
-30701,
-30452,
-30238,
-30054,
-29911,
-29794,
-29722,
-29680,
-29677,
-29719,
-29796,
-29931,
-30103,
-30328,
-30595,
-30906,
-31244,
-31619,
-32002,
-32408,
-32812,
-33225,
-33631,
-34043,
-34439,
-34842,
-35228,
-35609,
-35970,
-36306,
-36617,
-36881,
-37111,
-37283,
-37405,
-37476,
-37490,
-37459,
-37386,
-37268,
-37125,
-36941,
-36737,
-36507,
-36251,
-35982,
-35688,
-35396,
-35084,
-34793,
-34500,
-34241,
-34006,
-33809,
-33656,
-33543,
-33479,
-33448,
-33463,
-33498,
-33571,
-33660,
-33771,
-33903,
-34045,
-34207,
-34380,
-34562,
-34754,
-34939,
-35129,
-35296,
-35457,
-35589,
-35702,
-35787,
-35856,
-35897,
-35934,
-35950,
-35968,
-35979,
-35984,
-35996,
-35990,
-35991,
-35971,
-35949,
-35910,
-35865,
-35805,
-35740,
-35666,
-35588,
-35509,
-35417,
-35325,
-35215,
-35098,
-34957,
-34805,
-34629,
-34433,
-34230,
-34005,
-33784,
-33557,
-33336,
-33122,
-32916,
-32726,
-32541,
-32372,
-32212,
-32061,
-31930,
-31804,
-31701,
-31614,
-31551,
-31514,
-31498,
-31507,
-31541,
-31590,
-31660,
-31739,
-31825,
-31929,
-32025,
-32137,
-32251,
-32368,
-32499,
-32624,
-32764,
-32890,
-33026,
-33136,
-33247,
-33329,
-33391,
-33426,
-33433,
-33407,
-33355,
-33271,
-33154,
-33012,
-32832,
-32627,
-32390,
-32121,
-31832,
-31512,
-31182,
-30833,
-30487,
-30143,
-29812,
-29506,
-29223,
-28986,
-28776,
-28622,
-28510,
-28450,
-28439,
-28483,
-28572,
-28722,
-28910,
-29156,
-29432,
-29756,
-30098,
-30470,
-30846,
-31234,
-31605,
-31972,
-32311,
-32630,
-32914,
-33163,
-33376,
-33551,
-33682,
-33773,
-33822,
-33824,
-33789,
-33712,
-33595,
-33448,
-33272,
-33070,
-32854,
-32626,
-32388,
-32156,
-31913,
-31691,
-31463,
-31253,
-31055,
-30868,
-30710,
-30565,
-30454,
-30369,
-30318,
-30303,
-30325,
-30379,
-30473,
-30591,
-30748,
-30926,
-31130,
-31357,
-31603,
-31869,
-32146,
-32438,
-32737,
-33036,
-33338,
-33621,
-33896,
-34144,
-34362,
-34557,
-34705,
-34830,
-34913,
-34967,
-34993,
-34990,
-34961,
-34912,
-34843,
-34753,
-34651,
-34529,
-34400,
-34268,
-34127,
-33996,
-33873,
-33761,
-33671,
-33594,
-33539,
-33497,
-33473,
-33450,
-33442,
-33426,
-33416,
-33399,
-33382,
-33363,
-33343,
-33323,
-33305,
-33290,
-33273,
-33256,
-33238,
-33217,
-33192,
-33167,
-33137,
-33122,
-33102,
-33110,
-33123,
-33165,
-33222,
-33302,
-33398,
-33505,
-33626,
-33738,
-33863,
-33970,
-34079,
-34173,
-34268,
-34344,
-34423,
-34483,
-34537,
-34578,
-34596,
-34595,
-34566,
-34514,
-34429,
-34324,
-34190,
-34044,
-33883,
-33712,
-33544,
-33370,
-33205,
-33035,
-32871,
-32707,
-32540,
-32380,
-32214,
-32062,
-31911,
-31785,
-31669,
-31586,
-31523,
-31496,
-31491,
-31521,
-31566,
-31642,
-31729,
-31839,
-31964,
-32104,
-32266,
-32439,
-32635,
-32843,
-33063,
-33292,
-33518,
-33738,
-33939,
-34115,
-34261,
-34371,
-34442,
-34474,
-34464,
-34418,
-34338,
-34223,
-34076,
-33903,
-33693,
-33466,
-33208,
-32930,
-32642,
-32338,
-32041,
-31751,
-31480,
-31240,
-31031,
-30867,
-30743,
-30668,
-30641,
-30649,
-30709,
-30798,
-30929,
-31093,
-31285,
-31513,
-31761,
-32039,
-32330,
-32642,
-32953,
-33271,
-33576,
-33867,
-34139,
-34380,
-34599,
-34779,
-34937,
-35054,
-35153,
-35210,
-35251,
-35257,
-35235,
-35187,
-35104,
-34998,
-34860,
-34701,
-34515,
-34317,
-34104,
-33884,
-33664,
-33447,
-33231,
-33032,
-32835,
-32660,
-32494,
-32347,
-32220,
-32116,
-32033,
-31985,
-31961,
-31974,
-32017,
-32095,
-32198,
-32339,
-32488,
-32673,
-32858,
-33063,
-33273,
-33479,
-33698,
-33898,
-34107,
-34298,
-34482,
-34648,
-34801,
-34927,
-35035,
-35117,
-35175,
-35209,
-35221,
-35213,
-35186,
-35148,
-35096,
-35034,
-34970,
-34889,
-34818,
-34730,
-34645,
-34556,
-34461,
-34372,
-34274,
-34184,
-34087,
-33998,
-33902,
-33810,
-33713,
-33616,
-33514,
-33405,
-33296,
-33178,
-33064,
-32944,
-32828,
-32715,
-32610,
-32510,
-32424,
-32345,
-32278,
-32230,
-32184,
-32167,
-32148,
-32160,
-32177,
-32216,
-32271,
-32336,
-32421,
-32512,
-32614,
-32722,
-32830,
-32936,
-33044,
-33136,
-33231,
-33306,
-33378,
-33433,
-33479,
-33509,
-33523,
-33526,
-33506,
-33467,
-33414,
-33336,
-33242,
-33135,
-32996,
-32866,
-32693,
-32541,
-32346,
-32174,
-31968,
-31774,
-31562,
-31355,
-31136,
-30928,
-30708,
-30509,
-30305,
-30125,
-29950,
-29800,
-29666,
-29554,
-29469,
-29397,
-29360,
-29338,
-29341,
-29367,
-29411,
-29482,
-29565,
-29672,
-29786,
-29920,
-30055,
-30199,
-30333,
-30472,
-30588,
-30704,
-30790,
-30866,
-30915,
-30947,
-30954,
-30941,
-30905,
-30847,
-30775,
-30671,
-30564,
-30425,
-30285,
-30122,
-29962,
-29784,
-29619,
-29441,
-29286,
-29121,
-28983,
-28842,
-28730,
-28613,
-28527,
-28441,
-28379,
-28325,
-28289,
-28268,
-28260,
-28271,
-28296,
-28337,
-28392,
-28460,
-28541,
-28632,
-28733,
-28840,
-28956,
-29076,
-29203,
-29334,
-29467,
-29607,
-29743,
-29884,
-30017,
-30151,
-30273,
-30394,
-30495,
-30596,
-30672,
-30747,
-30801,
-30847,
-30881,
-30903,
-30916,
-30925,
-30918,
-30913,
-30899,
-30881,
-30866,
-30848,
-30833,
-30823,
-30822,
-30824,
-30848,
-30867,
-30919,
-30966,
-31035,
-31118,
-31205,
-31314,
-31422,
-31549,
-31682,
-31823,
-31973,
-32131,
-32294,
-32468,
-32644,
-32825,
-33016,
-33201,
-33401,
-33592,
-33793,
-33994,
-34191,
-34398,
-34593,
-34801,
-34999,
-35198,
-35395,
-35584,
-35771,
-35948,
-36118,
-36275,
-36426,
-36556,
-36681,
-36787,
-36879,
-36965,
-37023,
-37087,
-37121,
-37157,
-37179,
-37188,
-37200,
-37198,
-37195,
-37194,
-37185,
-37187,
-37187,
-37194,
-37207,
-37231,
-37259,
-37301,
-37350,
-37410,
-37483,
-37556,
-37647,
-37741,
-37843,
-37953,
-38066,
-38187,
-38312,
-38437,
-38571,
-38701,
-38835,
-38968,
-39098,
-39227,
-39351,
-39467,
-39581,
-39678,
-39774,
-39852,
-39923,
-39975,
-40015,
-40035,
-40042,
-40024,
-39988,
-39930,
-39848,
-39744,
-39621,
-39464,
-39307,
-39105,
-38907,
-38680,
-38447,
-38200,
-37946,
-37687,
-37428,
-37167,
-36911,
-36660,
-36418,
-36187,
-35970,
-35765,
-35582,
-35411,
-35262,
-35130,
-35012,
-34922,
-34833,
-34771,
-34711,
-34671,
-34628,
-34603,
-34572,
-34548,
-34526,
-34497,
-34471,
-34432,
-34393,
-34342,
-34278,
-34209,
-34116,
-34015,
-33897,
-33759,
-33606,
-33436,
-33244,
-33042,
-32816,
-32575,
-32320,
-32045,
-31758,
-31458,
-31140,
-30819,
-30481,
-30144,
-29798,
-29454,
-29112,
-28774,
-28445,
-28127,
-27823,
-27533,
-27264,
-27009,
-26779,
-26568,
-26378,
-26218,
-26070,
-25958,
-25856,
-25786,
-25733,
-25700,
-25683,
-25683,
-25694,
-25716,
-25747,
-25781,
-25821,
-25860,
-25903,
-25940,
-25977,
-26012,
-26037,
-26063,
-26079,
-26081,
-26089,
-26072,
-26063,
-26027,
-26001,
-25949,
-25907,
-25846,
-25790,
-25723,
-25659,
-25587,
-25522,
-25448,
-25382,
-25310,
-25246,
-25182,
-25126,
-25075,
-25034,
-25003,
-24986,
-24978,
-24991,
-25016,
-25062,
-25123,
-25207,
-25303,
-25428,
-25567,
-25728,
-25911,
-26115,
-26332,
-26581,
-26828,
-27112,
-27387,
-27691,
-27988,
-28297,
-28605,
-28915,
-29220,
-29521,
-29818,
-30102,
-30388,
-30651,
-30918,
-31161,
-31403,
-31628,
-31845,
-32047,
-32243,
-32421,
-32602,
-32759,
-32924,
-33071,
-33220,
-33361,
-33498,
-33632,
-33762,
-33891,
-34016,
-34144,
-34265,
-34398,
-34523,
-34666,
-34801,
-34962,
-35117,
-35299,
-35481,
-35689,
-35900,
-36135,
-36376,
-36634,
-36904,
-37182,
-37474,
-37770,
-38070,
-38378,
-38677,
-38984,
-39277,
-39564,
-39842,
-40103,
-40350,
-40581,
-40792,
-40985,
-41160,
-41317,
-41453,
-41572,
-41680,
-41758,
-41837,
-41886,
-41928,
-41955,
-41967,
-41968,
-41958,
-41934,
-41909,
-41868,
-41831,
-41780,
-41733,
-41681,
-41631,
-41585,
-41537,
-41501,
-41462,
-41439,
-41418,
-41408,
-41406,
-41414,
-41427,
-41448,
-41475,
-41500,
-41531,
-41551,
-41578,
-41583,
-41591,
-41577,
-41555,
-41517,
-41461,
-41393,
-41304,
-41206,
-41084,
-40958,
-40810,
-40655,
-40486,
-40310,
-40120,
-39928,
-39725,
-39513,
-39303,
-39075,
-38855,
-38615,
-38385,
-38136,
-37890,
-37639,
-37383,
-37129,
-36867,
-36617,
-36356,
-36118,
-35869,
-35641,
-35417,
-35205,
-35006,
-34813,
-34632,
-34461,
-34287,
-34131,
-33958,
-33796,
-33619,
-33437,
-33243,
-33031,
-32810,
-32564,
-32307,
-32028,
-31735,
-31430,
-31108,
-30782,
-30448,
-30114,
-29778,
-29456,
-29129,
-28827,
-28526,
-28248,
-27978,
-27728,
-27484,
-27261,
-27039,
-26835,
-26626,
-26436,
-26236,
-26049,
-25856,
-25671,
-25484,
-25307,
-25125,
-24959,
-24792,
-24639,
-24491,
-24359,
-24229,
-24123,
-24008,
-23920,
-23822,
-23738,
-23648,
-23559,
-23458,
-23355,
-23235,
-23102,
-22956,
-22790,
-22617,
-22422,
-22229,
-22020,
-21816,
-21617,
-21421,
-21244,
-21086,
-20946,
-20834,
-20752,
-20693,
-20670,
-20669,
-20699,
-20751,
-20824,
-20912,
-21018,
-21127,
-21246,
-21363,
-21483,
-21598,
-21709,
-21817,
-21920,
-22024,
-22125,
-22230,
-22337,
-22453,
-22575,
-22707,
-22848,
-22996,
-23157,
-23314,
-23486,
-23647,
-23818,
-23976,
-24131,
-24277,
-24416,
-24543,
-24667,
-24778,
-24892,
-25000,
-25114,
-25242,
-25370,
-25534,
-25702,
-25914,
-26138,
-26409,
-26695,
-27027,
-27369,
-27750,
-28136,
-28544,
-28957,
-29364,
-29780,
-30167,
-30555,
-30917,
-31260,
-31581,
-31886,
-32164,
-32433,
-32684,
-32929,
-33164,
-33406,
-33641,
-33895,
-34147,
-34419,
-34695,
-34991,
-35292,
-35604,
-35921,
-36238,
-36556,
-36867,
-37174,
-37465,
-37754,
-38025,
-38294,
-38549,
-38807,
-39057,
-39320,
-39582,
-39864,
-40151,
-40465,
-40788,
-41137,
-41492,
-41873,
-42249,
-42645,
-43024,
-43405,
-43766,
-44104,
-44416,
-44690,
-44930,
-45130,
-45286,
-45406,
-45486,
-45538,
-45558,
-45564,
-45556,
-45540,
-45533,
-45529,
-45542,
-45572,
-45623,
-45695,
-45791,
-45898,
-46033,
-46162,
-46316,
-46451,
-46598,
-46719,
-46836,
-46926,
-47005,
-47049,
-47081,
-47091,
-47077,
-47059,
-47020,
-46980,
-46933,
-46887,
-46840,
-46795,
-46748,
-46701,
-46649,
-46586,
-46509,
-46414,
-46295,
-46143,
-45964,
-45740,
-45484,
-45187,
-44852,
-44488,
-44089,
-43669,
-43235,
-42791,
-42353,
-41922,
-41511,
-41125,
-40770,
-40451,
-40164,
-39919,
-39701,
-39517,
-39354,
-39208,
-39072,
-38936,
-38793,
-38641,
-38462,
-38265,
-38037,
-37778,
-37494,
-37171,
-36832,
-36458,
-36077,
-35666,
-35261,
-34833,
-34421,
-33992,
-33583,
-33160,
-32755,
-32337,
-31928,
-31506,
-31077,
-30638,
-30182,
-29711,
-29227,
-28719,
-28214,
-27684,
-27164,
-26639,
-26131,
-25633,
-25169,
-24725,
-24329,
-23964,
-23654,
-23385,
-23161,
-22990,
-22847,
-22748,
-22672,
-22614,
-22568,
-22520,
-22468,
-22389,
-22306,
-22172,
-22029,
-21841,
-21626,
-21387,
-21121,
-20839,
-20544,
-20246,
-19946,
-19655,
-19375,
-19108,
-18866,
-18635,
-18436,
-18246,
-18086,
-17931,
-17798,
-17673,
-17552,
-17446,
-17328,
-17228,
-17121,
-17024,
-16936,
-16857,
-16801,
-16763,
-16762,
-16785,
-16856,
-16964,
-17115,
-17307,
-17540,
-17806,
-18105,
-18426,
-18758,
-19103,
-19439,
-19770,
-20081,
-20365,
-20627,
-20845,
-21040,
-21194,
-21319,
-21418,
-21493,
-21554,
-21614,
-21668,
-21743,
-21829,
-21948,
-22089,
-22274,
-22486,
-22739,
-23023,
-23335,
-23676,
-24034,
-24406,
-24790,
-25176,
-25564,
-25948,
-26331,
-26705,
-27081,
-27450,
-27823,
-28196,
-28580,
-28971,
-29384,
-29802,
-30252,
-30707,
-31192,
-31685,
-32191,
-32702,
-33210,
-33711,
-34195,
-34653,
-35085,
-35480,
-35832,
-36151,
-36426,
-36665,
-36873,
-37052,
-37211,
-37367,
-37509,
-37672,
-37839,
-38038,
-38257,
-38523,
-38809,
-39151,
-39512,
-39918,
-40345,
-40795,
-41261,
-41726,
-42198,
-42649,
-43088,
-43503,
-43886,
-44248,
-44572,
-44866,
-45141,
-45383,
-45615,
-45825,
-46030,
-46226,
-46423,
-46612,
-46810,
-46997,
-47190,
-47372,
-47541,
-47704,
-47839,
-47950,
-48037,
-48080,
-48100,
-48074,
-48016,
-47928,
-47805,
-47670,
-47512,
-47352,
-47196,
-47047,
-46923,
-46823,
-46754,
-46720,
-46722,
-46755,
-46828,
-46914,
-47032,
-47148,
-47276,
-47385,
-47485,
-47549,
-47592,
-47575,
-47535,
-47430,
-47289,
-47101,
-46868,
-46606,
-46310,
-45993,
-45661,
-45320,
-44980,
-44636,
-44302,
-43971,
-43648,
-43327,
-43009,
-42686,
-42359,
-42014,
-41658,
-41277,
-40878,
-40453,
-40005,
-39536,
-39055,
-38554,
-38062,
-37559,
-37078,
-36612,
-36171,
-35766,
-35395,
-35065,
-34770,
-34517,
-34293,
-34095,
-33915,
-33743,
-33564,
-33379,
-33168,
-32926,
-32649,
-32324,
-31961,
-31551,
-31093,
-30607,
-30078,
-29534,
-28970,
-28403,
-27841,
-27290,
-26763,
-26255,
-25788,
-25346,
-24938,
-24560,
-24208,
-23874,
-23554,
-23239,
-22924,
-22603,
-22271,
-21921,
-21561,
-21184,
-20797,
-20407,
-20013,
-19633,
-19266,
-18926,
-18619,
-18347,
-18119,
-17940,
-17801,
-17713,
-17658,
-17640,
-17644,
-17667,
-17694,
-17715,
-17724,
-17707,
-17665,
-17586,
-17473,
-17327,
-17150,
-16951,
-16734,
-16517,
-16299,
-16104,
-15932,
-15801,
-15712,
-15674,
-15688,
-15757,
-15874,
-16035,
-16238,
-16467,
-16720,
-16976,
-17237,
-17483,
-17716,
-17925,
-18104,
-18266,
-18394,
-18511,
-18611,
-18705,
-18815,
-18925,
-19076,
-19244,
-19465,
-19719,
-20029,
-20374,
-20769,
-21194,
-21648,
-22124,
-22600,
-23090,
-23550,
-24005,
-24427,
-24818,
-25181,
-25508,
-25815,
-26091,
-26367,
-26627,
-26911,
-27195,
-27530,
-27884,
-28299,
-28750,
-29262,
-29811,
-30420,
-31047,
-31716,
-32387,
-33068,
-33731,
-34377,
-34980,
-35548,
-36056,
-36518,
-36922,
-37273,
-37584,
-37847,
-38095,
-38315,
-38541,
-38764,
-39013,
-39286,
-39591,
-39935,
-40312,
-40732,
-41173,
-41646,
-42127,
-42613,
-43095,
-43558,
-43993,
-44401,
-44766,
-45094,
-45384,
-45635,
-45861,
-46063,
-46256,
-46441,
-46644,
-46854,
-47101,
-47369,
-47680,
-48021,
-48393,
-48795,
-49207,
-49626,
-50037,
-50425,
-50780,
-51080,
-51327,
-51499,
-51601,
-51627,
-51574,
-51454,
-51272,
-51037,
-50766,
-50470,
-50164,
-49863,
-49578,
-49322,
-49100,
-48919,
-48780,
-48678,
-48617,
-48577,
-48561,
-48549,
-48534,
-48504,
-48451,
-48361,
-48241,
-48069,
-47866,
-47620,
-47343,
-47044,
-46731,
-46409,
-46099,
-45803,
-45527,
-45286,
-45071,
-44889,
-44733,
-44600,
-44474,
-44349,
-44215,
-44046,
-43845,
-43583,
-43266,
-42879,
-42414,
-41883,
-41270,
-40608,
-39879,
-39124,
-38333,
-37539,
-36757,
-35992,
-35275,
-34595,
-33992,
-33433,
-32959,
-32533,
-32174,
-31856,
-31581,
-31328,
-31088,
-30853,
-30594,
-30330,
-30023,
-29698,
-29330,
-28940,
-28514,
-28085,
-27631,
-27191,
-26754,
-26341,
-25957,
-25604,
-25294,
-25017,
-24779,
-24565,
-24379,
-24195,
-24019,
-23821,
-23598,
-23339,
-23036,
-22674,
-22268,
-21793,
-21283,
-20718,
-20135,
-19521,
-18921,
-18317,
-17764,
-17238,
-16787,
-16395,
-16090,
-15858,
-15714,
-15647,
-15647,
-15718,
-15827,
-15981,
-16149,
-16331,
-16499,
-16664,
-16789,
-16902,
-16967,
-17013,
-17028,
-17024,
-17009,
-16994,
-16981,
-16993,
-17023,
-17088,
-17191,
-17322,
-17496,
-17694,
-17918,
-18157,
-18398,
-18633,
-18854,
-19045,
-19209,
-19327,
-19411,
-19451,
-19461,
-19434,
-19400,
-19346,
-19311,
-19291,
-19303,
-19369,
-19484,
-19674,
-19927,
-20259,
-20656,
-21128,
-21644,
-22222,
-22820,
-23446,
-24076,
-24697,
-25298,
-25867,
-26401,
-26889,
-27331,
-27735,
-28089,
-28422,
-28720,
-29007,
-29284,
-29568,
-29859,
-30169,
-30501,
-30852,
-31230,
-31625,
-32032,
-32454,
-32863,
-33274,
-33657,
-34020,
-34352,
-34642,
-34901,
-35117,
-35303,
-35462,
-35601,
-35732,
-35866,
-36008,
-36183,
-36385,
-36633,
-36928,
-37273,
-37667,
-38110,
-38593,
-39106,
-39645,
-40184,
-40731,
-41249,
-41748,
-42202,
-42609,
-42963,
-43258,
-43495,
-43679,
-43811,
-43898,
-43951,
-43980,
-43988,
-43999,
-44000,
-44022,
-44051,
-44097,
-44163,
-44242,
-44332,
-44428,
-44522,
-44610,
-44677,
-44727,
-44746,
-44737,
-44690,
-44619,
-44511,
-44383,
-44240,
-44077,
-43930,
-43775,
-43649,
-43542,
-43464,
-43427,
-43421,
-43455,
-43517,
-43611,
-43721,
-43842,
-43967,
-44071,
-44166,
-44215,
-44239,
-44203,
-44123,
-43987,
-43800,
-43563,
-43282,
-42964,
-42617,
-42254,
-41879,
-41505,
-41139,
-40788,
-40454,
-40147,
-39858,
-39595,
-39350,
-39122,
-38901,
-38688,
-38467,
-38243,
-38006,
-37749,
-37479,
-37184,
-36881,
-36554,
-36227,
-35890,
-35558,
-35242,
-34933,
-34656,
-34403,
-34179,
-33991,
-33833,
-33703,
-33599,
-33512,
-33441,
-33368,
-33296,
-33205,
-33100,
-32965,
-32799,
-32600,
-32365,
-32098,
-31795,
-31470,
-31121,
-30763,
-30392,
-30032,
-29671,
-29338,
-29014,
-28731,
-28459,
-28232,
-28022,
-27845,
-27687,
-27547,
-27420,
-27301,
-27185,
-27063,
-26940,
-26809,
-26670,
-26525,
-26371,
-26222,
-26066,
-25928,
-25791,
-25681,
-25583,
-25518,
-25469,
-25464,
-25470,
-25514,
-25573,
-25655,
-25746,
-25848,
-25942,
-26040,
-26119,
-26188,
-26228,
-26256,
-26248,
-26231,
-26182,
-26122,
-26046,
-25965,
-25879,
-25803,
-25725,
-25678,
-25630,
-25623,
-25622,
-25656,
-25703,
-25778,
-25864,
-25968,
-26076,
-26193,
-26310,
-26421,
-26534,
-26632,
-26727,
-26817,
-26893,
-26978,
-27054,
-27137,
-27233,
-27333,
-27459,
-27594,
-27759,
-27939,
-28150,
-28370,
-28618,
-28878,
-29143,
-29424,
-29692,
-29965,
-30223,
-30465,
-30692,
-30894,
-31076,
-31234,
-31370,
-31486,
-31585,
-31669,
-31746,
-31817,
-31885,
-31961,
-32036,
-32126,
-32222,
-32331,
-32450,
-32575,
-32714,
-32849,
-32995,
-33129,
-33271,
-33394,
-33520,
-33629,
-33729,
-33824,
-33906,
-33985,
-34065,
-34137,
-34225,
-34311,
-34415,
-34531,
-34663,
-34816,
-34982,
-35171,
-35369,
-35587,
-35804,
-36037,
-36259,
-36482,
-36693,
-36888,
-37067,
-37220,
-37353,
-37459,
-37538,
-37595,
-37626,
-37640,
-37629,
-37613,
-37581,
-37540,
-37501,
-37454,
-37413,
-37374,
-37338,
-37306,
-37273,
-37247,
-37219,
-37189,
-37158,
-37118,
-37076,
-37022,
-36970,
-36900,
-36837,
-36758,
-36690,
-36616,
-36550,
-36492,
-36444,
-36410,
-36391,
-36388,
-36402,
-36434,
-36478,
-36538,
-36602,
-36682,
-36750,
-36827,
-36889,
-36944,
-36979,
-36996,
-36993,
-36960,
-36911,
-36830,
-36728,
-36609,
-36461,
-36311,
-36136,
-35959,
-35778,
-35589,
-35409,
-35222,
-35049,
-34873,
-34708,
-34545,
-34389,
-34236,
-34085,
-33938,
-33786,
-33640,
-33489,
-33339,
-33189,
-33040,
-32895,
-32753,
-32621,
-32495,
-32387,
-32287,
-32208,
-32144,
-32100,
-32072,
-32061,
-32063,
-32079,
-32102,
-32128,
-32157,
-32181,
-32197,
-32203,
-32194,
-32163,
-32125,
-32054,
-31971,
-31867,
-31744,
-31608,
-31459,
-31301,
-31134,
-30972,
-30800,
-30643,
-30484,
-30338,
-30198,
-30068,
-29950,
-29839,
-29736,
-29639,
-29552,
-29461,
-29383,
-29300,
-29223,
-29154,
-29078,
-29017,
-28957,
-28907,
-28868,
-28840,
-28826,
-28831,
-28846,
-28884,
-28933,
-29001,
-29084,
-29176,
-29278,
-29384,
-29495,
-29601,
-29704,
-29797,
-29875,
-29946,
-29991,
-30031,
-30039,
-30047,
-30027,
-30001,
-29964,
-29918,
-29866,
-29820,
-29763,
-29725,
-29678,
-29647,
-29622,
-29605,
-29598,
-29597,
-29606,
-29618,
-29642,
-29659,
-29693,
-29716,
-29752,
-29783,
-29817,
-29860,
-29896,
-29948,
-30001,
-30064,
-30139,
-30220,
-30319,
-30422,
-30547,
-30673,
-30818,
-30960,
-31117,
-31270,
-31425,
-31578,
-31721,
-31860,
-31984,
-32101,
-32192,
-32286,
-32342,
-32409,
-32440,
-32476,
-32490,
-32506,
-32511,
-32515,
-32519,
-32523,
-32534,
-32545,
-32568,
-32589,
-32626,
-32656,
-32704,
-32747,
-32795,
-32850,
-32898,
-32952,
-33003,
-33057,
-33106,
-33164,
-33212,
-33270,
-33327,
-33388,
-33453,
-33526,
-33598,
-33683,
-33768,
-33862,
-33958,
-34059,
-34159,
-34263,
-34360,
-34456,
-34546,
-34627,
-34700,
-34759,
-34811,
-34846,
-34876,
-34885,
-34893,
-34885,
-34873,
-34855,
-34830,
-34804,
-34781,
-34752,
-34733,
-34711,
-34695,
-34687,
-34677,
-34680,
-34678,
-34689,
-34694,
-34713,
-34719,
-34742,
-34750,
-34769,
-34782,
-34796,
-34810,
-34823,
-34836,
-34849,
-34863,
-34877,
-34895,
-34910,
-34931,
-34946,
-34968,
-34984,
-35003,
-35017,
-35028,
-35037,
-35036,
-35037,
-35021,
-35008,
-34978,
-34947,
-34907,
-34859,
-34804,
-34746,
-34681,
-34613,
-34548,
-34475,
-34408,
-34343,
-34278,
-34220,
-34167,
-34113,
-34078,
-34034,
-34009,
-33977,
-33963,
-33940,
-33933,
-33920,
-33914,
-33911,
-33904,
-33901,
-33897,
-33891,
-33887,
-33876,
-33868,
-33853,
-33839,
-33820,
-33801,
-33769,
-33751,
-33707,
-33682,
-33637,
-33593,
-33548,
-33494,
-33439,
-33380,
-33316,
-33247,
-33180,
-33102,
-33029,
-32950,
-32871,
-32794,
-32714,
-32637,
-32562,
-32493,
-32424,
-32364,
-32306,
-32259,
-32215,
-32182,
-32154,
-32134,
-32124,
-32119,
-32123,
-32131,
-32144,
-32166,
-32184,
-32212,
-32231,
-32259,
-32278,
-32297,
-32312,
-32316,
-32325,
-32314,
-32308,
-32286,
-32260,
-32231,
-32185,
-32146,
-32088,
-32036,
-31972,
-31911,
-31843,
-31775,
-31706,
-31636,
-31571,
-31501,
-31439,
-31374,
-31319,
-31260,
-31212,
-31166,
-31123,
-31091,
-31061,
-31041,
-31028,
-31026,
-31026,
-31045,
-31067,
-31099,
-31146,
-31193,
-31259,
-31324,
-31399,
-31477,
-31561,
-31640,
-31729,
-31805,
-31882,
-31955,
-32016,
-32068,
-32117,
-32142,
-32170,
-32171,
-32174,
-32151,
-32135,
-32092,
-32054,
-32005,
-31945,
-31894,
-31829,
-31771,
-31712,
-31653,
-31600,
-31546,
-31503,
-31459,
-31426,
-31395,
-31374,
-31356,
-31353,
-31348,
-31363,
-31376,
-31406,
-31442,
-31492,
-31549,
-31619,
-31699,
-31789,
-31892,
-32000,
-32119,
-32243,
-32377,
-32505,
-32641,
-32772,
-32896,
-33018,
-33127,
-33223,
-33314,
-33376,
-33438,
-33470,
-33497,
-33498,
-33491,
-33464,
-33428,
-33379,
-33321,
-33256,
-33183,
-33110,
-33032,
-32957,
-32884,
-32809,
-32746,
-32683,
-32626,
-32580,
-32533,
-32501,
-32473,
-32454,
-32443,
-32443,
-32448,
-32472,
-32500,
-32541,
-32600,
-32662,
-32748,
-32834,
-32943,
-33051,
-33182,
-33304,
-33445,
-33580,
-33718,
-33855,
-33982,
-34105,
-34215,
-34310,
-34394,
-34454,
-34500,
-34525,
-34527,
-34513,
-34482,
-34423,
-34365,
-34275,
-34186,
-34084,
-33972,
-33860,
-33740,
-33621,
-33505,
-33387,
-33275,
-33167,
-33062,
-32967,
-32877,
-32790,
-32725,
-32650,
-32602,
-32554,
-32520,
-32500,
-32492,
-32493,
-32520,
-32543,
-32603,
-32653,
-32740,
-32823,
-32926,
-33037,
-33153,
-33278,
-33399,
-33524,
-33640,
-33752,
-33850,
-33935,
-34007,
-34057,
-34091,
-34104,
-34097,
-34066,
-34025,
-33953,
-33876,
-33777,
-33666,
-33544,
-33419,
-33277,
-33145,
-32996,
-32858,
-32718,
-32578,
-32447,
-32317,
-32192,
-32081,
-31966,
-31875,
-31773,
-31703,
-31625,
-31575,
-31526,
-31499,
-31487,
-31484,
-31510,
-31540,
-31596,
-31663,
-31749,
-31843,
-31961,
-32073,
-32205,
-32333,
-32467,
-32599,
-32721,
-32841,
-32944,
-33039,
-33113,
-33174,
-33211,
-33235,
-33236,
-33217,
-33185,
-33127,
-33065,
-32982,
-32891,
-32789,
-32682,
-32567,
-32452,
-32332,
-32212,
-32099,
-31977,
-31870,
-31760,
-31658,
-31561,
-31474,
-31389,
-31323,
-31257,
-31211,
-31172,
-31147,
-31143,
-31144,
-31178,
-31210,
-31274,
-31344,
-31440,
-31542,
-31665,
-31795,
-31934,
-32082,
-32232,
-32381,
-32531,
-32673,
-32804,
-32930,
-33036,
-33130,
-33209,
-33266,
-33308,
-33332,
-33337,
-33328,
-33302,
-33264,
-33213,
-33152,
-33084,
-33004,
-32927,
-32838,
-32753,
-32664,
-32574,
-32489,
-32402,
-32319,
-32242,
-32165,
-32095,
-32035,
-31976,
-31932,
-31894,
-31867,
-31856,
-31853,
-31872,
-31898,
-31946,
-32009,
-32085,
-32179,
-32286,
-32401,
-32532,
-32665,
-32807,
-32947,
-33088,
-33228,
-33354,
-33479,
-33588,
-33684,
-33768,
-33836,
-33885,
-33921,
-33940,
-33946,
-33933,
-33918,
-33877,
-33841,
-33786,
-33732,
-33670,
-33603,
-33536,
-33464,
-33392,
-33318,
-33241,
-33171,
-33091,
-33023,
-32947,
-32879,
-32812,
-32749,
-32699,
-32647,
-32614,
-32581,
-32572,
-32563,
-32580,
-32602,
-32642,
-32699,
-32763,
-32845,
-32933,
-33034,
-33134,
-33245,
-33349,
-33456,
-33553,
-33642,
-33724,
-33787,
-33847,
-33880,
-33908,
-33917,
-33910,
-33899,
-33865,
-33834,
-33785,
-33734,
-33680,
-33619,
-33561,
-33498,
-33438,
-33377,
-33317,
-33259,
-33200,
-33143,
-33086,
-33024,
-32969,
-32907,
-32847,
-32789,
-32729,
-32673,
-32622,
-32572,
-32536,
-32501,
-32483,
-32470,
-32474,
-32486,
-32514,
-32550,
-32598,
-32654,
-32716,
-32784,
-32848,
-32920,
-32978,
-33037,
-33084,
-33120,
-33145,
-33158,
-33156,
-33141,
-33118,
-33077,
-33033,
-32982,
-32923,
-32867,
-32810,
-32752,
-32705,
-32659,
-32621,
-32591,
-32567,
-32545,
-32536,
-32520,
-32517,
-32506,
-32498,
-32487,
-32473,
-32451,
-32434,
-32400,
-32376,
-32341,
-32304,
-32275,
-32239,
-32215,
-32191,
-32178,
-32169,
-32176,
-32184,
-32210,
-32237,
-32274,
-32316,
-32360,
-32404,
-32449,
-32487,
-32521,
-32542,
-32562,
-32564,
-32561,
-32546,
-32523,
-32492,
-32460,
-32418,
-32384,
-32342,
-32315,
-32285,
-32271,
-32262,
-32265,
-32278,
-32300,
-32332,
-32370,
-32413,
-32463,
-32505,
-32554,
-32589,
-32628,
-32650,
-32670,
-32674,
-32673,
-32666,
-32643,
-32628,
-32593,
-32572,
-32541,
-32520,
-32501,
-32488,
-32483,
-32490,
-32498,
-32524,
-32548,
-32580,
-32622,
-32655,
-32699,
-32731,
-32764,
-32792,
-32807,
-32823,
-32821,
-32820,
-32807,
-32792,
-32770,
-32749,
-32730,
-32710,
-32699,
-32693,
-32694,
-32707,
-32725,
-32757,
-32795,
-32841,
-32892,
-32949,
-33002,
-33064,
-33113,
-33163,
-33206,
-33237,
-33265,
-33279,
-33282,
-33286,
-33267,
-33258,
-33231,
-33209,
-33183,
-33156,
-33138,
-33115,
-33104,
-33095,
-33089,
-33096,
-33095,
-33109,
-33115,
-33128,
-33136,
-33143,
-33144,
-33143,
-33131,
-33120,
-33094,
-33073,
-33038,
-33006,
-32970,
-32932,
-32900,
-32866,
-32846,
-32819,
-32816,
-32805,
-32818,
-32832,
-32853,
-32891,
-32922,
-32972,
-33018,
-33066,
-33116,
-33163,
-33204,
-33246,
-33277,
-33301,
-33319,
-33327,
-33329,
-33320,
-33306,
-33284,
-33251,
-33223,
-33176,
-33137,
-33085,
-33034,
-32982,
-32923,
-32868,
-32810,
-32748,
-32694,
-32633,
-32576,
-32520,
-32467,
-32411,
-32367,
-32318,
-32279,
-32246,
-32213,
-32193,
-32174,
-32171,
-32164,
-32179,
-32188,
-32214,
-32243,
-32278,
-32320,
-32369,
-32415,
-32473,
-32523,
-32585,
-32633,
-32693,
-32738,
-32784,
-32829,
-32854,
-32887,
-32897,
-32906,
-32898,
-32885,
-32850,
-32815,
-32758,
-32692,
-32619,
-32529,
-32438,
-32334,
-32228,
-32118,
-32010,
-31905,
-31804,
-31714,
-31632,
-31569,
-31515,
-31486,
-31470,
-31474,
-31500,
-31540,
-31601,
-31675,
-31760,
-31861,
-31962,
-32072,
-32182,
-32287,
-32394,
-32487,
-32579,
-32652,
-32723,
-32775,
-32820,
-32851,
-32874,
-32887,
-32892,
-32888,
-32880,
-32866,
-32849,
-32825,
-32802,
-32765,
-32736,
-32688,
-32648,
-32590,
-32532,
-32466,
-32392,
-32317,
-32233,
-32152,
-32070,
-31991,
-31923,
-31859,
-31820,
-31786,
-31784,
-31798,
-31841,
-31905,
-32001,
-32113,
-32256,
-32410,
-32585,
-32765,
-32949,
-33135,
-33310,
-33473,
-33619,
-33738,
-33837,
-33901,
-33942,
-33948,
-33930,
-33884,
-33817,
-33731,
-33633,
-33525,
-33416,
-33306,
-33203,
-33110,
-33028,
-32960,
-32906,
-32866,
-32844,
-32828,
-32825,
-32830,
-32836,
-32850,
-32860,
-32871,
-32878,
-32887,
-32890,
-32896,
-32908,
-32915,
-32941,
-32970,
-33014,
-33076,
-33148,
-33242,
-33349,
-33469,
-33605,
-33738,
-33889,
-34019,
-34158,
-34268,
-34365,
-34440,
-34474,
-34490,
-34459,
-34402,
-34310,
-34184,
-34037,
-33866,
-33685,
-33493,
-33305,
-33121,
-32957,
-32811,
-32696,
-32604,
-32549,
-32526,
-32533,
-32569,
-32636,
-32711,
-32816,
-32915,
-33029,
-33130,
-33230,
-33313,
-33382,
-33434,
-33465,
-33480,
-33481,
-33465,
-33441,
-33412,
-33379,
-33347,
-33324,
-33302,
-33294,
-33291,
-33299,
-33311,
-33331,
-33344,
-33363,
-33363,
-33360,
-33336,
-33293,
-33233,
-33149,
-33043,
-32924,
-32781,
-32636,
-32480,
-32329,
-32181,
-32052,
-31938,
-31856,
-31797,
-31777,
-31787,
-31833,
-31909,
-32015,
-32142,
-32287,
-32439,
-32597,
-32744,
-32879,
-32995,
-33083,
-33141,
-33169,
-33161,
-33122,
-33050,
-32956,
-32836,
-32705,
-32563,
-32419,
-32281,
-32152,
-32039,
-31944,
-31869,
-31818,
-31788,
-31779,
-31784,
-31807,
-31833,
-31873,
-31903,
-31937,
-31959,
-31977,
-31978,
-31976,
-31956,
-31938,
-31909,
-31884,
-31857,
-31844,
-31838,
-31851,
-31878,
-31925,
-31990,
-32072,
-32171,
-32278,
-32393,
-32510,
-32618,
-32719,
-32801,
-32861,
-32896,
-32901,
-32875,
-32819,
-32736,
-32622,
-32493,
-32340,
-32187,
-32026,
-31876,
-31732,
-31614,
-31512,
-31452,
-31410,
-31412,
-31440,
-31500,
-31591,
-31701,
-31832,
-31973,
-32121,
-32268,
-32409,
-32539,
-32654,
-32752,
-32830,
-32890,
-32929,
-32951,
-32961,
-32955,
-32949,
-32933,
-32917,
-32908,
-32899,
-32900,
-32905,
-32915,
-32936,
-32954,
-32973,
-32993,
-32999,
-33008,
-32993,
-32975,
-32937,
-32888,
-32824,
-32752,
-32667,
-32584,
-32496,
-32418,
-32345,
-32291,
-32252,
-32239,
-32247,
-32286,
-32346,
-32436,
-32544,
-32677,
-32820,
-32974,
-33134,
-33289,
-33437,
-33573,
-33687,
-33784,
-33854,
-33898,
-33917,
-33907,
-33877,
-33824,
-33757,
-33673,
-33585,
-33491,
-33397,
-33309,
-33230,
-33153,
-33103,
-33047,
-33019,
-32997,
-32981,
-32983,
-32985,
-32990,
-33006,
-33012,
-33024,
-33031,
-33038,
-33037,
-33045,
-33042,
-33046,
-33053,
-33061,
-33080,
-33103,
-33134,
-33175,
-33225,
-33281,
-33344,
-33408,
-33475,
-33540,
-33599,
-33654,
-33690,
-33721,
-33731,
-33722,
-33705,
-33657,
-33603,
-33529,
-33441,
-33347,
-33242,
-33141,
-33033,
-32938,
-32843,
-32765,
-32699,
-32648,
-32614,
-32598,
-32594,
-32611,
-32636,
-32680,
-32725,
-32782,
-32837,
-32900,
-32953,
-33013,
-33054,
-33105,
-33127,
-33163,
-33170,
-33186,
-33178,
-33176,
-33157,
-33139,
-33112,
-33082,
-33046,
-33009,
-32968,
-32924,
-32876,
-32828,
-32771,
-32723,
-32660,
-32604,
-32545,
-32482,
-32426,
-32367,
-32316,
-32267,
-32226,
-32193,
-32168,
-32155,
-32153,
-32161,
-32182,
-32214,
-32257,
-32308,
-32368,
-32434,
-32503,
-32577,
-32647,
-32716,
-32780,
-32837,
-32883,
-32924,
-32944,
-32962,
-32958,
-32945,
-32918,
-32877,
-32824,
-32766,
-32689,
-32613,
-32527,
-32430,
-32347,
-32242,
-32158,
-32062,
-31978,
-31899,
-31828,
-31769,
-31719,
-31682,
-31661,
-31653,
-31662,
-31686,
-31728,
-31781,
-31853,
-31938,
-32031,
-32144,
-32252,
-32376,
-32497,
-32620,
-32739,
-32854,
-32955,
-33053,
-33128,
-33197,
-33238,
-33274,
-33277,
-33276,
-33241,
-33205,
-33138,
-33070,
-32977,
-32884,
-32774,
-32667,
-32548,
-32436,
-32316,
-32209,
-32098,
-32001,
-31911,
-31827,
-31765,
-31706,
-31668,
-31646,
-31634,
-31652,
-31677,
-31729,
-31797,
-31881,
-31992,
-32113,
-32252,
-32410,
-32572,
-32748,
-32931,
-33109,
-33295,
-33463,
-33628,
-33775,
-33903,
-34008,
-34090,
-34136,
-34162,
-34148,
-34110,
-34037,
-33938,
-33811,
-33669,
-33496,
-33323,
-33131,
-32937,
-32750,
-32558,
-32383,
-32222,
-32074,
-31953,
-31845,
-31772,
-31713,
-31689,
-31683,
-31705,
-31749,
-31815,
-31902,
-32008,
-32129,
-32270,
-32420,
-32584,
-32756,
-32937,
-33125,
-33311,
-33503,
-33690,
-33870,
-34047,
-34202,
-34353,
-34470,
-34579,
-34648,
-34697,
-34707,
-34684,
-34626,
-34535,
-34403,
-34242,
-34052,
-33829,
-33594,
-33332,
-33070,
-32798,
-32533,
-32280,
-32038,
-31828,
-31640,
-31488,
-31377,
-31296,
-31265,
-31268,
-31315,
-31397,
-31516,
-31661,
-31835,
-32029,
-32240,
-32462,
-32687,
-32916,
-33138,
-33361,
-33560,
-33758,
-33930,
-34089,
-34228,
-34342,
-34437,
-34505,
-34551,
-34570,
-34563,
-34528,
-34468,
-34376,
-34263,
-34115,
-33946,
-33749,
-33531,
-33292,
-33041,
-32768,
-32502,
-32225,
-31956,
-31701,
-31459,
-31248,
-31061,
-30915,
-30804,
-30744,
-30724,
-30753,
-30832,
-30949,
-31117,
-31314,
-31548,
-31805,
-32081,
-32367,
-32659,
-32940,
-33221,
-33472,
-33707,
-33909,
-34082,
-34219,
-34319,
-34382,
-34409,
-34400,
-34361,
-34283,
-34189,
-34053,
-33915,
-33737,
-33562,
-33362,
-33153,
-32943,
-32716,
-32500,
-32271,
-32051,
-31835,
-31624,
-31427,
-31247,
-31076,
-30941,
-30816,
-30733,
-30679,
-30656,
-30678,
-30734,
-30830,
-30971,
-31139,
-31353,
-31588,
-31853,
-32138,
-32430,
-32734,
-33030,
-33317,
-33587,
-33831,
-34045,
-34219,
-34357,
-34445,
-34496,
-34492,
-34451,
-34367,
-34237,
-34086,
-33893,
-33688,
-33458,
-33221,
-32974,
-32736,
-32493,
-32272,
-32053,
-31865,
-31680,
-31535,
-31394,
-31291,
-31200,
-31141,
-31098,
-31087,
-31090,
-31124,
-31179,
-31252,
-31361,
-31476,
-31627,
-31787,
-31975,
-32173,
-32389,
-32612,
-32843,
-33073,
-33303,
-33519,
-33727,
-33911,
-34071,
-34204,
-34302,
-34364,
-34392,
-34377,
-34324,
-34243,
-34113,
-33968,
-33785,
-33589,
-33373,
-33152,
-32926,
-32703,
-32489,
-32289,
-32107,
-31947,
-31809,
-31701,
-31618,
-31564,
-31538,
-31534,
-31562,
-31603,
-31674,
-31752,
-31859,
-31968,
-32094,
-32226,
-32369,
-32512,
-32666,
-32814,
-32969,
-33118,
-33266,
-33407,
-33543,
-33665,
-33781,
-33875,
-33958,
-34019,
-34059,
-34076,
-34074,
-34035,
-33989,
-33900,
-33806,
-33677,
-33542,
-33382,
-33222,
-33046,
-32879,
-32703,
-32544,
-32392,
-32256,
-32142,
-32045,
-31975,
-31926,
-31910,
-31906,
-31941,
-31984,
-32058,
-32140,
-32246,
-32353,
-32478,
-32596,
-32729,
-32848,
-32975,
-33088,
-33198,
-33297,
-33385,
-33465,
-33530,
-33585,
-33625,
-33654,
-33670,
-33673,
-33662,
-33641,
-33600,
-33560,
-33494,
-33423,
-33347,
-33248,
-33160,
-33048,
-32943,
-32829,
-32723,
-32612,
-32514,
-32416,
-32335,
-32262,
-32207,
-32166,
-32144,
-32138,
-32151,
-32184,
-32228,
-32294,
-32369,
-32456,
-32554,
-32652,
-32762,
-32859,
-32967,
-33054,
-33147,
-33219,
-33284,
-33334,
-33367,
-33390,
-33394,
-33383,
-33361,
-33323,
-33275,
-33215,
-33147,
-33071,
-32993,
-32908,
-32823,
-32736,
-32652,
-32569,
-32495,
-32420,
-32360,
-32300,
-32254,
-32217,
-32189,
-32174,
-32169,
-32176,
-32193,
-32225,
-32261,
-32313,
-32371,
-32436,
-32510,
-32586,
-32664,
-32749,
-32821,
-32905,
-32967,
-33040,
-33089,
-33135,
-33171,
-33186,
-33198,
-33187,
-33166,
-33133,
-33082,
-33023,
-32952,
-32872,
-32781,
-32693,
-32590,
-32500,
-32400,
-32309,
-32225,
-32145,
-32080,
-32022,
-31982,
-31952,
-31941,
-31945,
-31957,
-31999,
-32040,
-32106,
-32179,
-32260,
-32359,
-32451,
-32561,
-32662,
-32767,
-32871,
-32962,
-33054,
-33132,
-33197,
-33253,
-33291,
-33315,
-33329,
-33316,
-33300,
-33262,
-33209,
-33152,
-33073,
-32990,
-32900,
-32798,
-32701,
-32593,
-32491,
-32390,
-32292,
-32201,
-32117,
-32046,
-31980,
-31935,
-31897,
-31875,
-31877,
-31882,
-31917,
-31961,
-32021,
-32105,
-32194,
-32306,
-32423,
-32552,
-32691,
-32829,
-32978,
-33117,
-33256,
-33387,
-33504,
-33611,
-33701,
-33766,
-33820,
-33839,
-33848,
-33819,
-33780,
-33705,
-33625,
-33508,
-33394,
-33248,
-33107,
-32954,
-32797,
-32648,
-32496,
-32358,
-32230,
-32115,
-32016,
-31940,
-31876,
-31840,
-31816,
-31823,
-31841,
-31886,
-31943,
-32025,
-32112,
-32230,
-32342,
-32480,
-32621,
-32766,
-32925,
-33079,
-33240,
-33393,
-33550,
-33689,
-33831,
-33949,
-34060,
-34150,
-34215,
-34266,
-34283,
-34279,
-34246,
-34182,
-34092,
-33979,
-33832,
-33674,
-33483,
-33291,
-33072,
-32863,
-32640,
-32431,
-32224,
-32036,
-31866,
-31718,
-31602,
-31509,
-31455,
-31425,
-31438,
-31474,
-31547,
-31645,
-31770,
-31917,
-32082,
-32264,
-32451,
-32650,
-32851,
-33044,
-33245,
-33425,
-33602,
-33766,
-33910,
-34041,
-34152,
-34239,
-34313,
-34351,
-34379,
-34371,
-34344,
-34288,
-34205,
-34101,
-33964,
-33809,
-33627,
-33426,
-33208,
-32973,
-32730,
-32479,
-32232,
-31983,
-31750,
-31531,
-31334,
-31164,
-31028,
-30924,
-30862,
-30843,
-30861,
-30928,
-31030,
-31174,
-31352,
-31561,
-31796,
-32050,
-32315,
-32590,
-32859,
-33130,
-33378,
-33615,
-33825,
-34009,
-34165,
-34285,
-34373,
-34425,
-34445,
-34431,
-34382,
-34305,
-34200,
-34065,
-33914,
-33735,
-33542,
-33332,
-33112,
-32877,
-32645,
-32398,
-32161,
-31922,
-31691,
-31473,
-31267,
-31084,
-30921,
-30787,
-30686,
-30617,
-30587,
-30599,
-30646,
-30743,
-30876,
-31048,
-31260,
-31502,
-31770,
-32066,
-32367,
-32686,
-32996,
-33303,
-33595,
-33860,
-34100,
-34301,
-34466,
-34583,
-34660,
-34685,
-34664,
-34603,
-34491,
-34352,
-34166,
-33964,
-33728,
-33482,
-33220,
-32957,
-32688,
-32432,
-32176,
-31942,
-31720,
-31526,
-31343,
-31200,
-31069,
-30977,
-30908,
-30872,
-30860,
-30888,
-30932,
-31021,
-31127,
-31268,
-31434,
-31621,
-31839,
-32067,
-32320,
-32577,
-32848,
-33115,
-33384,
-33636,
-33881,
-34095,
-34291,
-34447,
-34572,
-34653,
-34692,
-34688,
-34640,
-34546,
-34417,
-34245,
-34044,
-33817,
-33562,
-33306,
-33029,
-32763,
-32497,
-32250,
-32017,
-31812,
-31634,
-31486,
-31375,
-31295,
-31252,
-31240,
-31267,
-31315,
-31399,
-31502,
-31627,
-31773,
-31927,
-32104,
-32273,
-32465,
-32644,
-32832,
-33013,
-33190,
-33360,
-33522,
-33665,
-33805,
-33916,
-34019,
-34096,
-34152,
-34187,
-34192,
-34174,
-34132,
-34058,
-33965,
-33843,
-33703,
-33544,
-33370,
-33181,
-32989,
-32795,
-32602,
-32420,
-32245,
-32094,
-31958,
-31851,
-31767,
-31707,
-31682,
-31678,
-31709,
-31762,
-31844,
-31944,
-32065,
-32200,
-32341,
-32498,
-32649,
-32803,
-32952,
-33090,
-33221,
-33338,
-33438,
-33525,
-33595,
-33646,
-33684,
-33700,
-33706,
-33693,
-33664,
-33626,
-33568,
-33509,
-33428,
-33348,
-33249,
-33151,
-33045,
-32931,
-32822,
-32701,
-32595,
-32481,
-32378,
-32283,
-32194,
-32123,
-32062,
-32018,
-31993,
-31984,
-31994,
-32028,
-32074,
-32142,
-32226,
-32319,
-32431,
-32544,
-32669,
-32789,
-32913,
-33029,
-33140,
-33236,
-33325,
-33390,
-33448,
-33477,
-33498,
-33491,
-33475,
-33436,
-33383,
-33318,
-33240,
-33155,
-33063,
-32965,
-32866,
-32769,
-32671,
-32584,
-32496,
-32422,
-32353,
-32295,
-32248,
-32212,
-32190,
-32174,
-32179,
-32184,
-32213,
-32241,
-32288,
-32341,
-32401,
-32473,
-32546,
-32629,
-32709,
-32799,
-32880,
-32965,
-33045,
-33115,
-33185,
-33236,
-33285,
-33315,
-33335,
-33341,
-33328,
-33307,
-33266,
-33215,
-33149,
-33071,
-32992,
-32895,
-32805,
-32700,
-32608,
-32511,
-32426,
-32344,
-32273,
-32216,
-32169,
-32143,
-32124,
-32126,
-32143,
-32171,
-32216,
-32272,
-32342,
-32416,
-32506,
-32589,
-32689,
-32776,
-32874,
-32959,
-33046,
-33122,
-33187,
-33250,
-33290,
-33332,
-33350,
-33359,
-33357,
-33336,
-33309,
-33268,
-33210,
-33151,
-33074,
-32997,
-32908,
-32818,
-32726,
-32632,
-32540,
-32452,
-32366,
-32295,
-32225,
-32171,
-32125,
-32098,
-32078,
-32082,
-32093,
-32124,
-32172,
-32224,
-32306,
-32381,
-32481,
-32581,
-32687,
-32800,
-32909,
-33022,
-33120,
-33225,
-33306,
-33389,
-33448,
-33497,
-33530,
-33543,
-33544,
-33520,
-33489,
-33430,
-33370,
-33284,
-33197,
-33093,
-32986,
-32874,
-32760,
-32646,
-32535,
-32428,
-32330,
-32238,
-32163,
-32091,
-32045,
-31999,
-31984,
-31970,
-31985,
-32003,
-32049,
-32098,
-32170,
-32248,
-32342,
-32440,
-32552,
-32664,
-32785,
-32905,
-33024,
-33144,
-33253,
-33360,
-33456,
-33539,
-33613,
-33664,
-33708,
-33724,
-33733,
-33712,
-33680,
-33624,
-33551,
-33466,
-33360,
-33242,
-33119,
-32974,
-32840,
-32690,
-32545,
-32406,
-32269,
-32143,
-32029,
-31927,
-31843,
-31777,
-31727,
-31703,
-31691,
-31708,
-31739,
-31792,
-31865,
-31952,
-32054,
-32173,
-32302,
-32439,
-32584,
-32731,
-32885,
-33035,
-33182,
-33325,
-33459,
-33584,
-33695,
-33794,
-33875,
-33938,
-33982,
-34001,
-34006,
-33979,
-33936,
-33866,
-33776,
-33662,
-33528,
-33379,
-33209,
-33029,
-32838,
-32641,
-32438,
-32243,
-32042,
-31860,
-31686,
-31527,
-31397,
-31278,
-31200,
-31135,
-31113,
-31114,
-31152,
-31219,
-31316,
-31443,
-31596,
-31774,
-31971,
-32187,
-32414,
-32655,
-32893,
-33139,
-33374,
-33604,
-33822,
-34015,
-34198,
-34346,
-34472,
-34568,
-34627,
-34658,
-34645,
-34604,
-34522,
-34407,
-34259,
-34075,
-33866,
-33626,
-33371,
-33089,
-32804,
-32498,
-32204,
-31903,
-31618,
-31345,
-31094,
-30871,
-30682,
-30522,
-30417,
-30340,
-30322,
-30347,
-30418,
-30544,
-30709,
-30924,
-31175,
-31465,
-31785,
-32129,
-32495,
-32867,
-33247,
-33620,
-33982,
-34326,
-34640,
-34926,
-35165,
-35368,
-35509,
-35612,
-35645,
-35631,
-35556,
-35425,
-35240,
-35005,
-34722,
-34399,
-34038,
-33653,
-33240,
-32820,
-32390,
-31969,
-31554,
-31165,
-30800,
-30472,
-30185,
-29951,
-29763,
-29642,
-29570,
-29571,
-29630,
-29753,
-29938,
-30183,
-30480,
-30834,
-31227,
-31659,
-32122,
-32603,
-33101,
-33588,
-34080,
-34540,
-34978,
-35372,
-35720,
-36009,
-36238,
-36392,
-36478,
-36487,
-36417,
-36275,
-36057,
-35769,
-35427,
-35009,
-34567,
-34068,
-33554,
-33019,
-32479,
-31948,
-31434,
-30950,
-30505,
-30104,
-29767,
-29478,
-29271,
-29122,
-29053,
-29056,
-29132,
-29278,
-29498,
-29783,
-30124,
-30527,
-30970,
-31456,
-31974,
-32505,
-33053,
-33594,
-34123,
-34629,
-35099,
-35522,
-35896,
-36197,
-36441,
-36592,
-36679,
-36666,
-36587,
-36406,
-36162,
-35826,
-35441,
-34977,
-34486,
-33940,
-33384,
-32810,
-32243,
-31689,
-31173,
-30686,
-30259,
-29881,
-29577,
-29336,
-29176,
-29082,
-29072,
-29132,
-29265,
-29466,
-29737,
-30058,
-30441,
-30859,
-31320,
-31803,
-32308,
-32814,
-33322,
-33814,
-34278,
-34719,
-35107,
-35454,
-35738,
-35957,
-36113,
-36186,
-36192,
-36110,
-35958,
-35726,
-35422,
-35060,
-34628,
-34169,
-33656,
-33143,
-32612,
-32097,
-31601,
-31144,
-30733,
-30380,
-30087,
-29867,
-29713,
-29639,
-29628,
-29690,
-29817,
-30006,
-30248,
-30540,
-30872,
-31242,
-31633,
-32048,
-32461,
-32881,
-33288,
-33675,
-34039,
-34369,
-34659,
-34911,
-35111,
-35267,
-35364,
-35414,
-35404,
-35337,
-35217,
-35030,
-34794,
-34498,
-34155,
-33771,
-33346,
-32910,
-32453,
-32009,
-31579,
-31186,
-30836,
-30548,
-30321,
-30168,
-30089,
-30085,
-30153,
-30287,
-30486,
-30733,
-31037,
-31366,
-31736,
-32114,
-32511,
-32902,
-33290,
-33649,
-33990,
-34281,
-34542,
-34742,
-34894,
-34994,
-35036,
-35032,
-34982,
-34891,
-34762,
-34605,
-34413,
-34205,
-33958,
-33703,
-33409,
-33107,
-32777,
-32433,
-32086,
-31737,
-31402,
-31093,
-30818,
-30596,
-30428,
-30332,
-30303,
-30350,
-30469,
-30649,
-30896,
-31187,
-31523,
-31893,
-32276,
-32682,
-33079,
-33477,
-33853,
-34200,
-34515,
-34777,
-34987,
-35137,
-35209,
-35224,
-35160,
-35035,
-34854,
-34623,
-34357,
-34074,
-33770,
-33478,
-33183,
-32905,
-32642,
-32392,
-32157,
-31933,
-31717,
-31515,
-31321,
-31146,
-30993,
-30872,
-30791,
-30758,
-30775,
-30856,
-30987,
-31177,
-31415,
-31693,
-32003,
-32330,
-32670,
-33011,
-33342,
-33663,
-33956,
-34228,
-34462,
-34660,
-34808,
-34903,
-34938,
-34904,
-34807,
-34631,
-34404,
-34105,
-33779,
-33407,
-33039,
-32667,
-32326,
-32016,
-31754,
-31551,
-31389,
-31292,
-31222,
-31203,
-31204,
-31225,
-31274,
-31320,
-31406,
-31491,
-31613,
-31759,
-31932,
-32142,
-32370,
-32630,
-32893,
-33168,
-33428,
-33676,
-33897,
-34088,
-34244,
-34363,
-34448,
-34490,
-34509,
-34475,
-34415,
-34303,
-34144,
-33941,
-33674,
-33368,
-33006,
-32616,
-32201,
-31786,
-31384,
-31027,
-30720,
-30492,
-30341,
-30283,
-30305,
-30407,
-30571,
-30791,
-31042,
-31323,
-31610,
-31904,
-32201,
-32492,
-32789,
-33081,
-33376,
-33666,
-33955,
-34225,
-34472,
-34690,
-34861,
-34985,
-35054,
-35066,
-35024,
-34937,
-34801,
-34636,
-34441,
-34217,
-33978,
-33706,
-33412,
-33090,
-32726,
-32344,
-31919,
-31488,
-31041,
-30614,
-30220,
-29880,
-29617,
-29449,
-29377,
-29418,
-29556,
-29789,
-30102,
-30469,
-30882,
-31315,
-31760,
-32200,
-32632,
-33053,
-33453,
-33847,
-34216,
-34570,
-34896,
-35190,
-35436,
-35635,
-35765,
-35832,
-35822,
-35745,
-35606,
-35411,
-35175,
-34911,
-34621,
-34328,
-34020,
-33708,
-33382,
-33039,
-32676,
-32284,
-31875,
-31436,
-31002,
-30565,
-30166,
-29810,
-29530,
-29331,
-29236,
-29244,
-29352,
-29555,
-29835,
-30181,
-30567,
-30981,
-31411,
-31838,
-32269,
-32684,
-33102,
-33506,
-33902,
-34292,
-34650,
-34997,
-35290,
-35541,
-35728,
-35847,
-35893,
-35869,
-35778,
-35640,
-35452,
-35245,
-35020,
-34782,
-34549,
-34310,
-34055,
-33797,
-33496,
-33179,
-32814,
-32425,
-31997,
-31571,
-31134,
-30736,
-30373,
-30080,
-29862,
-29731,
-29687,
-29724,
-29834,
-30002,
-30218,
-30461,
-30736,
-31013,
-31319,
-31625,
-31959,
-32302,
-32669,
-33045,
-33439,
-33820,
-34198,
-34537,
-34843,
-35087,
-35279,
-35401,
-35470,
-35485,
-35462,
-35409,
-35342,
-35256,
-35171,
-35072,
-34955,
-34820,
-34633,
-34416,
-34131,
-33802,
-33412,
-32991,
-32542,
-32087,
-31650,
-31250,
-30895,
-30610,
-30385,
-30230,
-30138,
-30093,
-30100,
-30139,
-30210,
-30314,
-30443,
-30614,
-30820,
-31073,
-31375,
-31717,
-32103,
-32512,
-32939,
-33356,
-33757,
-34116,
-34434,
-34688,
-34900,
-35046,
-35160,
-35235,
-35281,
-35315,
-35325,
-35321,
-35292,
-35226,
-35120,
-34949,
-34728,
-34431,
-34078,
-33671,
-33222,
-32758,
-32288,
-31840,
-31425,
-31054,
-30743,
-30480,
-30276,
-30116,
-30001,
-29922,
-29877,
-29871,
-29900,
-29978,
-30105,
-30293,
-30538,
-30846,
-31205,
-31607,
-32033,
-32470,
-32886,
-33286,
-33623,
-33922,
-34151,
-34328,
-34454,
-34528,
-34576,
-34588,
-34579,
-34549,
-34488,
-34400,
-34272,
-34094,
-33872,
-33589,
-33263,
-32896,
-32495,
-32095,
-31689,
-31312,
-30971,
-30672,
-30436,
-30241,
-30105,
-30008,
-29954,
-29927,
-29937,
-29970,
-30042,
-30148,
-30303,
-30501,
-30757,
-31065,
-31416,
-31808,
-32212,
-32625,
-33017,
-33377,
-33684,
-33933,
-34111,
-34228,
-34276,
-34274,
-34228,
-34141,
-34034,
-33894,
-33743,
-33565,
-33366,
-33143,
-32893,
-32624,
-32328,
-32029,
-31728,
-31438,
-31190,
-30961,
-30810,
-30692,
-30654,
-30657,
-30719,
-30820,
-30951,
-31114,
-31284,
-31478,
-31681,
-31903,
-32147,
-32414,
-32711,
-33036,
-33380,
-33747,
-34106,
-34468,
-34785,
-35074,
-35293,
-35453,
-35537,
-35549,
-35493,
-35376,
-35208,
-34998,
-34763,
-34502,
-34230,
-33950,
-33662,
-33369,
-33083,
-32790,
-32520,
-32257,
-32031,
-31833,
-31695,
-31605,
-31584,
-31628,
-31730,
-31900,
-32108,
-32361,
-32630,
-32923,
-33204,
-33501,
-33770,
-34049,
-34309,
-34579,
-34839,
-35107,
-35373,
-35635,
-35889,
-36115,
-36314,
-36465,
-36559,
-36592,
-36550,
-36445,
-36269,
-36035,
-35751,
-35429,
-35076,
-34713,
-34332,
-33964,
-33593,
-33239,
-32900,
-32582,
-32294,
-32035,
-31822,
-31653,
-31542,
-31493,
-31506,
-31584,
-31723,
-31913,
-32146,
-32405,
-32684,
-32958,
-33226,
-33474,
-33694,
-33894,
-34062,
-34214,
-34345,
-34465,
-34574,
-34679,
-34764,
-34842,
-34888,
-34909,
-34883,
-34818,
-34691,
-34521,
-34291,
-34018,
-33704,
-33366,
-33001,
-32635,
-32268,
-31905,
-31568,
-31240,
-30945,
-30673,
-30436,
-30235,
-30071,
-29957,
-29892,
-29882,
-29926,
-30026,
-30174,
-30372,
-30589,
-30837,
-31079,
-31318,
-31530,
-31710,
-31853,
-31956,
-32020,
-32055,
-32063,
-32054,
-32039,
-32016,
-31999,
-31971,
-31953,
-31909,
-31866,
-31788,
-31696,
-31562,
-31415,
-31228,
-31034,
-30822,
-30606,
-30398,
-30203,
-30022,
-29868,
-29734,
-29627,
-29549,
-29493,
-29471,
-29476,
-29516,
-29593,
-29713,
-29867,
-30069,
-30298,
-30559,
-30839,
-31117,
-31389,
-31637,
-31840,
-32009,
-32113,
-32176,
-32185,
-32154,
-32099,
-32015,
-31938,
-31852,
-31783,
-31723,
-31672,
-31641,
-31600,
-31578,
-31530,
-31499,
-31442,
-31396,
-31345,
-31298,
-31270,
-31254,
-31266,
-31300,
-31358,
-31446,
-31550,
-31675,
-31821,
-31977,
-32156,
-32351,
-32564,
-32806,
-33064,
-33351,
-33650,
-33961,
-34269,
-34566,
-34830,
-35054,
-35224,
-35328,
-35374,
-35345,
-35272,
-35138,
-34981,
-34797,
-34606,
-34429,
-34256,
-34113,
-33981,
-33877,
-33788,
-33712,
-33650,
-33597,
-33552,
-33523,
-33508,
-33511,
-33543,
-33595,
-33680,
-33788,
-33920,
-34075,
-34237,
-34418,
-34594,
-34789,
-34970,
-35178,
-35374,
-35597,
-35819,
-36057,
-36295,
-36537,
-36754,
-36952,
-37105,
-37202,
-37243,
-37203,
-37097,
-36921,
-36687,
-36402,
-36086,
-35750,
-35413,
-35085,
-34776,
-34492,
-34235,
-34009,
-33807,
-33634,
-33481,
-33352,
-33247,
-33166,
-33111,
-33089,
-33090,
-33128,
-33185,
-33269,
-33366,
-33473,
-33588,
-33694,
-33801,
-33900,
-33991,
-34088,
-34177,
-34280,
-34380,
-34496,
-34605,
-34712,
-34805,
-34867,
-34896,
-34872,
-34788,
-34648,
-34442,
-34180,
-33871,
-33521,
-33158,
-32777,
-32407,
-32054,
-31720,
-31426,
-31156,
-30930,
-30728,
-30570,
-30432,
-30338,
-30262,
-30231,
-30223,
-30250,
-30305,
-30386,
-30484,
-30597,
-30713,
-30824,
-30932,
-31021,
-31097,
-31155,
-31205,
-31240,
-31282,
-31318,
-31361,
-31409,
-31463,
-31510,
-31555,
-31576,
-31574,
-31537,
-31461,
-31342,
-31183,
-30991,
-30767,
-30530,
-30283,
-30046,
-29820,
-29624,
-29451,
-29318,
-29214,
-29157,
-29125,
-29132,
-29175,
-29239,
-29349,
-29474,
-29631,
-29812,
-30009,
-30215,
-30433,
-30637,
-30837,
-31018,
-31168,
-31303,
-31400,
-31476,
-31533,
-31568,
-31599,
-31621,
-31647,
-31667,
-31703,
-31718,
-31748,
-31756,
-31754,
-31732,
-31687,
-31623,
-31535,
-31440,
-31325,
-31222,
-31115,
-31034,
-30970,
-30938,
-30938,
-30975,
-31048,
-31153,
-31296,
-31470,
-31672,
-31901,
-32152,
-32419,
-32703,
-32992,
-33281,
-33564,
-33829,
-34075,
-34290,
-34470,
-34608,
-34711,
-34772,
-34793,
-34794,
-34754,
-34710,
-34643,
-34573,
-34499,
-34420,
-34346,
-34264,
-34183,
-34096,
-33999,
-33903,
-33789,
-33684,
-33568,
-33462,
-33364,
-33283,
-33224,
-33191,
-33189,
-33222,
-33291,
-33393,
-33534,
-33703,
-33906,
-34130,
-34380,
-34640,
-34910,
-35187,
-35450,
-35711,
-35941,
-36153,
-36322,
-36461,
-36546,
-36591,
-36587,
-36540,
-36449,
-36321,
-36164,
-35979,
-35781,
-35567,
-35349,
-35129,
-34911,
-34696,
-34485,
-34281,
-34082,
-33885,
-33697,
-33520,
-33341,
-33189,
-33042,
-32919,
-32820,
-32747,
-32705,
-32698,
-32723,
-32782,
-32879,
-32997,
-33153,
-33320,
-33511,
-33710,
-33910,
-34115,
-34300,
-34480,
-34628,
-34756,
-34847,
-34902,
-34918,
-34894,
-34824,
-34720,
-34568,
-34395,
-34183,
-33956,
-33706,
-33454,
-33193,
-32941,
-32690,
-32455,
-32229,
-32020,
-31822,
-31640,
-31470,
-31318,
-31170,
-31049,
-30934,
-30842,
-30775,
-30724,
-30709,
-30714,
-30755,
-30819,
-30915,
-31030,
-31167,
-31320,
-31482,
-31646,
-31811,
-31969,
-32116,
-32251,
-32362,
-32458,
-32522,
-32566,
-32577,
-32558,
-32511,
-32430,
-32328,
-32192,
-32044,
-31877,
-31701,
-31527,
-31350,
-31188,
-31040,
-30903,
-30795,
-30694,
-30625,
-30558,
-30519,
-30480,
-30465,
-30453,
-30457,
-30473,
-30502,
-30551,
-30616,
-30703,
-30805,
-30930,
-31066,
-31217,
-31376,
-31535,
-31695,
-31851,
-31993,
-32132,
-32248,
-32352,
-32439,
-32509,
-32559,
-32590,
-32597,
-32585,
-32550,
-32493,
-32415,
-32322,
-32211,
-32100,
-31977,
-31867,
-31759,
-31673,
-31602,
-31554,
-31529,
-31524,
-31540,
-31574,
-31622,
-31682,
-31750,
-31831,
-31918,
-32014,
-32126,
-32239,
-32375,
-32517,
-32671,
-32832,
-32999,
-33163,
-33330,
-33481,
-33626,
-33753,
-33859,
-33956,
-34022,
-34078,
-34112,
-34122,
-34120,
-34091,
-34047,
-33979,
-33890,
-33780,
-33651,
-33510,
-33352,
-33193,
-33030,
-32874,
-32734,
-32608,
-32505,
-32427,
-32367,
-32344,
-32333,
-32348,
-32381,
-32428,
-32498,
-32575,
-32671,
-32782,
-32908,
-33051,
-33208,
-33381,
-33560,
-33750,
-33939,
-34128,
-34306,
-34474,
-34619,
-34752,
-34852,
-34939,
-34995,
-35025,
-35035,
-35014,
-34974,
-34900,
-34805,
-34678,
-34529,
-34349,
-34148,
-33925,
-33693,
-33440,
-33199,
-32945,
-32720,
-32495,
-32300,
-32122,
-31978,
-31850,
-31764,
-31687,
-31655,
-31635,
-31650,
-31692,
-31757,
-31857,
-31983,
-32135,
-32317,
-32516,
-32740,
-32973,
-33219,
-33459,
-33703,
-33928,
-34144,
-34337,
-34506,
-34652,
-34764,
-34855,
-34903,
-34929,
-34912,
-34864,
-34776,
-34655,
-34495,
-34301,
-34077,
-33823,
-33549,
-33259,
-32958,
-32658,
-32361,
-32074,
-31802,
-31554,
-31327,
-31128,
-30957,
-30820,
-30710,
-30645,
-30602,
-30612,
-30646,
-30732,
-30848,
-31003,
-31196,
-31412,
-31663,
-31926,
-32208,
-32494,
-32782,
-33065,
-33336,
-33588,
-33827,
-34027,
-34216,
-34354,
-34475,
-34546,
-34588,
-34580,
-34539,
-34452,
-34327,
-34165,
-33966,
-33740,
-33489,
-33214,
-32934,
-32638,
-32352,
-32063,
-31791,
-31528,
-31290,
-31074,
-30881,
-30729,
-30596,
-30508,
-30453,
-30432,
-30460,
-30515,
-30616,
-30746,
-30911,
-31106,
-31319,
-31558,
-31802,
-32060,
-32318,
-32568,
-32818,
-33047,
-33266,
-33458,
-33629,
-33771,
-33883,
-33966,
-34014,
-34027,
-34007,
-33959,
-33870,
-33767,
-33623,
-33470,
-33291,
-33106,
-32908,
-32708,
-32510,
-32312,
-32129,
-31949,
-31795,
-31648,
-31533,
-31429,
-31359,
-31310,
-31291,
-31295,
-31331,
-31382,
-31470,
-31565,
-31688,
-31820,
-31962,
-32118,
-32268,
-32429,
-32579,
-32728,
-32865,
-32995,
-33103,
-33209,
-33279,
-33346,
-33388,
-33403,
-33412,
-33390,
-33359,
-33312,
-33252,
-33186,
-33109,
-33035,
-32952,
-32883,
-32804,
-32741,
-32679,
-32629,
-32589,
-32558,
-32540,
-32535,
-32541,
-32563,
-32596,
-32640,
-32698,
-32759,
-32832,
-32903,
-32982,
-33050,
-33126,
-33184,
-33245,
-33288,
-33326,
-33350,
-33367,
-33362,
-33358,
-33327,
-33298,
-33243,
-33187,
-33114,
-33041,
-32955,
-32868,
-32784,
-32698,
-32630,
-32563,
-32512,
-32480,
-32458,
-32461,
-32477,
-32513,
-32562,
-32634,
-32710,
-32810,
-32912,
-33031,
-33153,
-33286,
-33418,
-33552,
-33683,
-33806,
-33923,
-34022,
-34103,
-34172,
-34207,
-34232,
-34221,
-34196,
-34137,
-34066,
-33965,
-33852,
-33718,
-33567,
-33407,
-33233,
-33053,
-32870,
-32683,
-32504,
-32330,
-32172,
-32030,
-31910,
-31817,
-31748,
-31717,
-31707,
-31734,
-31790,
-31867,
-31980,
-32107,
-32255,
-32422,
-32599,
-32787,
-32981,
-33177,
-33370,
-33558,
-33737,
-33896,
-34040,
-34160,
-34247,
-34315,
-34340,
-34341,
-34305,
-34238,
-34142,
-34016,
-33866,
-33692,
-33500,
-33286,
-33067,
-32830,
-32597,
-32357,
-32122,
-31902,
-31688,
-31503,
-31339,
-31203,
-31104,
-31034,
-31005,
-31012,
-31052,
-31127,
-31231,
-31364,
-31522,
-31697,
-31888,
-32093,
-32299,
-32516,
-32725,
-32929,
-33125,
-33300,
-33462,
-33594,
-33706,
-33782,
-33834,
-33847,
-33837,
-33790,
-33716,
-33615,
-33488,
-33340,
-33174,
-32991,
-32795,
-32591,
-32381,
-32171,
-31963,
-31764,
-31578,
-31412,
-31266,
-31147,
-31056,
-31003,
-30975,
-30990,
-31027,
-31107,
-31205,
-31338,
-31486,
-31657,
-31839,
-32034,
-32230,
-32434,
-32627,
-32820,
-32995,
-33159,
-33299,
-33422,
-33516,
-33586,
-33626,
-33644,
-33632,
-33597,
-33539,
-33461,
-33369,
-33257,
-33137,
-33002,
-32864,
-32721,
-32572,
-32429,
-32286,
-32151,
-32034,
-31919,
-31836,
-31765,
-31720,
-31704,
-31709,
-31742,
-31803,
-31880,
-31987,
-32106,
-32245,
-32391,
-32552,
-32711,
-32880,
-33040,
-33198,
-33346,
-33478,
-33599,
-33691,
-33771,
-33818,
-33847,
-33845,
-33828,
-33781,
-33722,
-33645,
-33555,
-33458,
-33354,
-33242,
-33136,
-33022,
-32916,
-32806,
-32706,
-32608,
-32521,
-32444,
-32377,
-32328,
-32294,
-32280,
-32285,
-32306,
-32352,
-32409,
-32488,
-32577,
-32678,
-32790,
-32905,
-33029,
-33149,
-33274,
-33392,
-33504,
-33609,
-33697,
-33775,
-33828,
-33867,
-33879,
-33868,
-33835,
-33779,
-33703,
-33612,
-33510,
-33394,
-33281,
-33159,
-33045,
-32927,
-32822,
-32713,
-32623,
-32526,
-32448,
-32365,
-32304,
-32243,
-32201,
-32165,
-32151,
-32141,
-32159,
-32177,
-32222,
-32271,
-32336,
-32405,
-32487,
-32567,
-32666,
-32749,
-32857,
-32943,
-33052,
-33136,
-33234,
-33310,
-33386,
-33439,
-33480,
-33499,
-33500,
-33481,
-33439,
-33384,
-33312,
-33228,
-33142,
-33045,
-32950,
-32860,
-32760,
-32680,
-32583,
-32511,
-32420,
-32352,
-32266,
-32202,
-32130,
-32070,
-32015,
-31970,
-31933,
-31907,
-31888,
-31887,
-31889,
-31904,
-31931,
-31963,
-32011,
-32063,
-32136,
-32211,
-32311,
-32405,
-32524,
-32643,
-32769,
-32895,
-33015,
-33133,
-33232,
-33326,
-33398,
-33452,
-33496,
-33516,
-33529,
-33524,
-33512,
-33490,
-33457,
-33420,
-33370,
-33316,
-33251,
-33173,
-33091,
-32995,
-32891,
-32783,
-32668,
-32548,
-32431,
-32314,
-32198,
-32092,
-31987,
-31895,
-31813,
-31743,
-31686,
-31652,
-31632,
-31644,
-31673,
-31736,
-31821,
-31937,
-32076,
-32235,
-32416,
-32598,
-32799,
-32989,
-33184,
-33362,
-33536,
-33687,
-33827,
-33946,
-34052,
-34130,
-34201,
-34236,
-34267,
-34263,
-34244,
-34196,
-34130,
-34033,
-33923,
-33783,
-33631,
-33456,
-33275,
-33076,
-32876,
-32668,
-32460,
-32254,
-32053,
-31862,
-31682,
-31526,
-31383,
-31277,
-31193,
-31154,
-31143,
-31180,
-31252,
-31362,
-31513,
-31682,
-31894,
-32105,
-32347,
-32579,
-32823,
-33054,
-33279,
-33490,
-33679,
-33855,
-34002,
-34132,
-34226,
-34304,
-34342,
-34359,
-34340,
-34296,
-34221,
-34116,
-33991,
-33839,
-33670,
-33484,
-33278,
-33070,
-32848,
-32622,
-32398,
-32171,
-31953,
-31743,
-31552,
-31375,
-31229,
-31110,
-31024,
-30977,
-30969,
-30999,
-31071,
-31176,
-31315,
-31484,
-31669,
-31878,
-32087,
-32311,
-32524,
-32735,
-32931,
-33118,
-33277,
-33428,
-33539,
-33642,
-33704,
-33755,
-33766,
-33760,
-33729,
-33674,
-33605,
-33514,
-33417,
-33298,
-33186,
-33054,
-32929,
-32791,
-32664,
-32523,
-32402,
-32267,
-32154,
-32041,
-31947,
-31865,
-31806,
-31768,
-31752,
-31766,
-31801,
-31864,
-31949,
-32050,
-32171,
-32297,
-32439,
-32573,
-32709,
-32840,
-32952,
-33065,
-33143,
-33219,
-33264,
-33294,
-33298,
-33288,
-33253,
-33206,
-33145,
-33069,
-32998,
-32913,
-32840,
-32765,
-32704,
-32652,
-32610,
-32583,
-32564,
-32562,
-32562,
-32578,
-32597,
-32626,
-32662,
-32704,
-32756,
-32813,
-32878,
-32952,
-33031,
-33117,
-33207,
-33296,
-33385,
-33472,
-33543,
-33614,
-33666,
-33701,
-33726,
-33720,
-33708,
-33658,
-33604,
-33510,
-33414,
-33286,
-33149,
-32995,
-32838,
-32674,
-32514,
-32364,
-32224,
-32110,
-32013,
-31947,
-31912,
-31900,
-31927,
-31972,
-32050,
-32145,
-32260,
-32390,
-32534,
-32679,
-32843,
-32992,
-33158,
-33309,
-33465,
-33605,
-33743,
-33857,
-33970,
-34049,
-34122,
-34162,
-34184,
-34179,
-34153,
-34096,
-34019,
-33913,
-33789,
-33636,
-33467,
-33277,
-33069,
-32853,
-32626,
-32392,
-32171,
-31948,
-31749,
-31569,
-31419,
-31299,
-31219,
-31173,
-31170,
-31206,
-31273,
-31377,
-31507,
-31661,
-31838,
-32022,
-32224,
-32423,
-32627,
-32826,
-33017,
-33200,
-33359,
-33513,
-33632,
-33741,
-33814,
-33866,
-33890,
-33888,
-33857,
-33806,
-33725,
-33629,
-33506,
-33370,
-33214,
-33045,
-32861,
-32670,
-32465,
-32266,
-32061,
-31866,
-31682,
-31514,
-31371,
-31254,
-31169,
-31121,
-31103,
-31131,
-31180,
-31277,
-31391,
-31538,
-31696,
-31882,
-32060,
-32264,
-32449,
-32643,
-32820,
-32989,
-33140,
-33273,
-33383,
-33468,
-33530,
-33564,
-33575,
-33559,
-33523,
-33463,
-33392,
-33298,
-33202,
-33084,
-32973,
-32845,
-32721,
-32592,
-32463,
-32339,
-32214,
-32102,
-31997,
-31906,
-31833,
-31780,
-31751,
-31747,
-31772,
-31822,
-31898,
-32000,
-32123,
-32263,
-32420,
-32578,
-32750,
-32919,
-33078,
-33237,
-33377,
-33502,
-33612,
-33690,
-33755,
-33789,
-33795,
-33778,
-33735,
-33669,
-33584,
-33479,
-33366,
-33239,
-33115,
-32979,
-32860,
-32730,
-32625,
-32512,
-32425,
-32339,
-32270,
-32216,
-32170,
-32149,
-32137,
-32150,
-32178,
-32228,
-32300,
-32389,
-32500,
-32624,
-32766,
-32915,
-33075,
-33236,
-33393,
-33550,
-33690,
-33826,
-33935,
-34032,
-34100,
-34145,
-34164,
-34153,
-34114,
-34047,
-33954,
-33831,
-33697,
-33535,
-33368,
-33191,
-33010,
-32833,
-32667,
-32501,
-32364,
-32231,
-32124,
-32035,
-31965,
-31914,
-31893,
-31877,
-31899,
-31923,
-31984,
-32053,
-32146,
-32255,
-32378,
-32518,
-32665,
-32822,
-32984,
-33142,
-33303,
-33450,
-33592,
-33716,
-33826,
-33911,
-33977,
-34017,
-34027,
-34017,
-33965,
-33901,
-33795,
-33670,
-33525,
-33351,
-33174,
-32980,
-32782,
-32588,
-32397,
-32218,
-32055,
-31909,
-31783,
-31684,
-31602,
-31547,
-31520,
-31506,
-31525,
-31558,
-31614,
-31689,
-31782,
-31887,
-32010,
-32141,
-32283,
-32431,
-32579,
-32730,
-32878,
-33016,
-33153,
-33267,
-33375,
-33461,
-33532,
-33580,
-33606,
-33609,
-33587,
-33541,
-33471,
-33378,
-33264,
-33132,
-32982,
-32828,
-32658,
-32497,
-32327,
-32178,
-32033,
-31910,
-31807,
-31717,
-31661,
-31615,
-31602,
-31602,
-31629,
-31670,
-31728,
-31807,
-31891,
-31992,
-32098,
-32215,
-32330,
-32455,
-32570,
-32694,
-32803,
-32916,
-33013,
-33103,
-33186,
-33250,
-33307,
-33346,
-33372,
-33380,
-33377,
-33348,
-33315,
-33254,
-33186,
-33100,
-33004,
-32900,
-32788,
-32677,
-32559,
-32458,
-32353,
-32268,
-32196,
-32135,
-32101,
-32078,
-32079,
-32096,
-32133,
-32184,
-32249,
-32330,
-32412,
-32513,
-32609,
-32711,
-32815,
-32914,
-33011,
-33101,
-33182,
-33262,
-33320,
-33383,
-33418,
-33461,
-33474,
-33490,
-33485,
-33476,
-33448,
-33416,
-33362,
-33312,
-33236,
-33165,
-33073,
-32987,
-32880,
-32793,
-32686,
-32597,
-32505,
-32431,
-32359,
-32314,
-32276,
-32260,
-32264,
-32279,
-32326,
-32373,
-32455,
-32529,
-32633,
-32729,
-32840,
-32948,
-33057,
-33160,
-33259,
-33347,
-33427,
-33491,
-33549,
-33584,
-33613,
-33626,
-33623,
-33609,
-33583,
-33543,
-33495,
-33433,
-33364,
-33285,
-33199,
-33104,
-33006,
-32897,
-32793,
-32679,
-32572,
-32465,
-32360,
-32270,
-32183,
-32114,
-32058,
-32019,
-32002,
-32000,
-32020,
-32060,
-32118,
-32197,
-32284,
-32391,
-32502,
-32622,
-32745,
-32864,
-32986,
-33092,
-33199,
-33281,
-33363,
-33420,
-33464,
-33493,
-33500,
-33499,
-33472,
-33442,
-33389,
-33330,
-33258,
-33174,
-33085,
-32988,
-32884,
-32778,
-32663,
-32553,
-32439,
-32328,
-32219,
-32118,
-32023,
-31941,
-31871,
-31814,
-31777,
-31756,
-31756,
-31779,
-31818,
-31879,
-31958,
-32053,
-32164,
-32284,
-32415,
-32542,
-32684,
-32805,
-32940,
-33047,
-33155,
-33240,
-33313,
-33367,
-33401,
-33423,
-33416,
-33403,
-33364,
-33316,
-33256,
-33182,
-33097,
-33010,
-32912,
-32815,
-32712,
-32612,
-32507,
-32409,
-32315,
-32222,
-32146,
-32067,
-32009,
-31959,
-31926,
-31909,
-31907,
-31929,
-31962,
-32021,
-32092,
-32186,
-32286,
-32408,
-32528,
-32666,
-32798,
-32934,
-33059,
-33187,
-33288,
-33391,
-33464,
-33529,
-33567,
-33588,
-33588,
-33565,
-33530,
-33470,
-33403,
-33316,
-33225,
-33121,
-33021,
-32907,
-32807,
-32695,
-32599,
-32501,
-32416,
-32336,
-32267,
-32210,
-32166,
-32134,
-32119,
-32117,
-32134,
-32167,
-32216,
-32282,
-32365,
-32462,
-32571,
-32692,
-32820,
-32950,
-33089,
-33215,
-33348,
-33460,
-33568,
-33657,
-33731,
-33780,
-33813,
-33816,
-33804,
-33762,
-33702,
-33622,
-33521,
-33411,
-33281,
-33153,
-33011,
-32876,
-32737,
-32607,
-32484,
-32370,
-32268,
-32184,
-32110,
-32051,
-32016,
-31986,
-31988,
-31993,
-32029,
-32070,
-32141,
-32215,
-32317,
-32421,
-32545,
-32672,
-32811,
-32948,
-33092,
-33223,
-33361,
-33475,
-33586,
-33679,
-33748,
-33805,
-33829,
-33839,
-33816,
-33771,
-33705,
-33606,
-33502,
-33362,
-33225,
-33066,
-32906,
-32741,
-32580,
-32424,
-32280,
-32143,
-32028,
-31921,
-31843,
-31773,
-31734,
-31705,
-31705,
-31715,
-31755,
-31801,
-31878,
-31959,
-32062,
-32175,
-32298,
-32435,
-32567,
-32715,
-32850,
-32994,
-33123,
-33247,
-33360,
-33453,
-33538,
-33593,
-33639,
-33649,
-33650,
-33613,
-33566,
-33484,
-33392,
-33271,
-33145,
-32998,
-32848,
-32692,
-32537,
-32388,
-32244,
-32113,
-32001,
-31901,
-31821,
-31764,
-31722,
-31708,
-31704,
-31732,
-31764,
-31826,
-31897,
-31978,
-32082,
-32184,
-32304,
-32424,
-32549,
-32674,
-32800,
-32919,
-33035,
-33141,
-33236,
-33320,
-33389,
-33442,
-33480,
-33499,
-33499,
-33479,
-33444,
-33385,
-33313,
-33226,
-33120,
-33010,
-32889,
-32764,
-32643,
-32519,
-32410,
-32304,
-32220,
-32145,
-32090,
-32057,
-32036,
-32043,
-32059,
-32100,
-32150,
-32220,
-32295,
-32387,
-32479,
-32581,
-32684,
-32787,
-32891,
-32987,
-33081,
-33164,
-33243,
-33307,
-33364,
-33405,
-33439,
-33454,
-33463,
-33450,
-33433,
-33396,
-33352,
-33290,
-33222,
-33141,
-33056,
-32958,
-32864,
-32763,
-32668,
-32576,
-32492,
-32419,
-32360,
-32315,
-32289,
-32276,
-32286,
-32310,
-32351,
-32411,
-32478,
-32563,
-32649,
-32750,
-32846,
-32949,
-33049,
-33137,
-33232,
-33301,
-33371,
-33426,
-33463,
-33493,
-33502,
-33501,
-33489,
-33458,
-33421,
-33372,
-33312,
-33246,
-33171,
-33090,
-33005,
-32915,
-32820,
-32728,
-32632,
-32543,
-32456,
-32374,
-32307,
-32244,
-32201,
-32166,
-32152,
-32154,
-32170,
-32206,
-32255,
-32323,
-32398,
-32493,
-32585,
-32698,
-32800,
-32915,
-33018,
-33122,
-33218,
-33294,
-33372,
-33417,
-33464,
-33481,
-33485,
-33476,
-33443,
-33406,
-33347,
-33280,
-33210,
-33118,
-33038,
-32937,
-32843,
-32745,
-32643,
-32546,
-32448,
-32358,
-32267,
-32191,
-32115,
-32058,
-32005,
-31973,
-31949,
-31944,
-31953,
-31981,
-32015,
-32078,
-32142,
-32225,
-32320,
-32418,
-32530,
-32643,
-32759,
-32872,
-32982,
-33087,
-33173,
-33263,
-33320,
-33373,
-33402,
-33420,
-33414,
-33398,
-33361,
-33316,
-33256,
-33188,
-33111,
-33029,
-32940,
-32850,
-32754,
-32664,
-32567,
-32477,
-32387,
-32305,
-32227,
-32159,
-32100,
-32049,
-32016,
-31991,
-31982,
-31987,
-32002,
-32040,
-32081,
-32145,
-32216,
-32302,
-32392,
-32500,
-32603,
-32720,
-32831,
-32943,
-33048,
-33149,
-33234,
-33310,
-33369,
-33410,
-33440,
-33445,
-33440,
-33418,
-33376,
-33332,
-33264,
-33201,
-33119,
-33034,
-32951,
-32852,
-32765,
-32669,
-32578,
-32494,
-32406,
-32336,
-32261,
-32211,
-32155,
-32128,
-32097,
-32093,
-32096,
-32114,
-32149,
-32189,
-32253,
-32320,
-32405,
-32496,
-32596,
-32702,
-32812,
-32923,
-33031,
-33134,
-33231,
-33313,
-33389,
-33438,
-33484,
-33497,
-33508,
-33490,
-33460,
-33414,
-33355,
-33282,
-33202,
-33111,
-33014,
-32918,
-32812,
-32712,
-32611,
-32512,
-32425,
-32338,
-32263,
-32201,
-32145,
-32109,
-32081,
-32071,
-32077,
-32095,
-32128,
-32176,
-32240,
-32314,
-32405,
-32499,
-32606,
-32721,
-32836,
-32957,
-33076,
-33185,
-33296,
-33385,
-33472,
-33534,
-33584,
-33613,
-33621,
-33612,
-33577,
-33533,
-33462,
-33385,
-33288,
-33184,
-33071,
-32952,
-32831,
-32710,
-32590,
-32474,
-32369,
-32265,
-32183,
-32102,
-32042,
-31997,
-31966,
-31952,
-31960,
-31974,
-32021,
-32069,
-32144,
-32226,
-32327,
-32434,
-32556,
-32683,
-32813,
-32951,
-33080,
-33212,
-33333,
-33442,
-33544,
-33621,
-33687,
-33729,
-33748,
-33747,
-33725,
-33677,
-33615,
-33528,
-33430,
-33317,
-33188,
-33062,
-32921,
-32786,
-32648,
-32516,
-32391,
-32276,
-32174,
-32081,
-32011,
-31947,
-31912,
-31885,
-31883,
-31894,
-31927,
-31975,
-32039,
-32120,
-32214,
-32321,
-32440,
-32564,
-32697,
-32833,
-32966,
-33102,
-33225,
-33347,
-33450,
-33546,
-33615,
-33673,
-33707,
-33717,
-33713,
-33674,
-33630,
-33552,
-33467,
-33361,
-33243,
-33120,
-32985,
-32854,
-32717,
-32591,
-32464,
-32355,
-32248,
-32164,
-32086,
-32034,
-31988,
-31968,
-31957,
-31968,
-31990,
-32031,
-32083,
-32151,
-32228,
-32316,
-32417,
-32515,
-32629,
-32740,
-32851,
-32965,
-33066,
-33172,
-33253,
-33339,
-33396,
-33449,
-33476,
-33492,
-33484,
-33462,
-33420,
-33359,
-33289,
-33197,
-33102,
-32996,
-32883,
-32775,
-32659,
-32557,
-32455,
-32371,
-32293,
-32231,
-32185,
-32152,
-32137,
-32137,
-32151,
-32176,
-32217,
-32267,
-32324,
-32393,
-32463,
-32543,
-32620,
-32704,
-32784,
-32865,
-32943,
-33014,
-33079,
-33138,
-33185,
-33223,
-33252,
-33258,
-33264,
-33244,
-33220,
-33175,
-33121,
-33055,
-32976,
-32894,
-32798,
-32704,
-32607,
-32513,
-32423,
-32343,
-32271,
-32215,
-32173,
-32149,
-32140,
-32153,
-32176,
-32225,
-32277,
-32354,
-32427,
-32520,
-32609,
-32708,
-32799,
-32896,
-32981,
-33067,
-33137,
-33208,
-33256,
-33304,
-33332,
-33352,
-33352,
-33349,
-33320,
-33289,
-33238,
-33179,
-33107,
-33025,
-32936,
-32835,
-32735,
-32626,
-32519,
-32410,
-32310,
-32211,
-32125,
-32052,
-31991,
-31951,
-31930,
-31927,
-31951,
-31992,
-32058,
-32142,
-32243,
-32361,
-32488,
-32627,
-32765,
-32912,
-33045,
-33183,
-33304,
-33415,
-33511,
-33590,
-33648,
-33691,
-33709,
-33709,
-33691,
-33645,
-33595,
-33512,
-33428,
-33320,
-33208,
-33083,
-32951,
-32816,
-32679,
-32538,
-32407,
-32270,
-32157,
-32034,
-31944,
-31855,
-31793,
-31749,
-31725,
-31731,
-31756,
-31810,
-31890,
-31987,
-32114,
-32251,
-32411,
-32577,
-32756,
-32930,
-33112,
-33275,
-33442,
-33583,
-33710,
-33818,
-33897,
-33955,
-33987,
-33987,
-33968,
-33915,
-33845,
-33748,
-33638,
-33505,
-33364,
-33209,
-33050,
-32885,
-32721,
-32559,
-32403,
-32253,
-32115,
-31990,
-31878,
-31789,
-31712,
-31665,
-31633,
-31633,
-31651,
-31701,
-31772,
-31867,
-31984,
-32124,
-32280,
-32447,
-32628,
-32809,
-32996,
-33175,
-33350,
-33509,
-33653,
-33772,
-33873,
-33944,
-33988,
-34005,
-33987,
-33948,
-33873,
-33786,
-33665,
-33531,
-33386,
-33218,
-33059,
-32883,
-32717,
-32550,
-32391,
-32242,
-32108,
-31986,
-31881,
-31795,
-31728,
-31681,
-31658,
-31656,
-31675,
-31717,
-31782,
-31865,
-31972,
-32090,
-32226,
-32376,
-32533,
-32694,
-32862,
-33022,
-33180,
-33331,
-33458,
-33583,
-33672,
-33752,
-33795,
-33823,
-33812,
-33786,
-33722,
-33648,
-33535,
-33423,
-33277,
-33136,
-32977,
-32824,
-32667,
-32516,
-32375,
-32244,
-32128,
-32026,
-31944,
-31877,
-31833,
-31804,
-31799,
-31810,
-31840,
-31889,
-31950,
-32035,
-32122,
-32231,
-32343,
-32467,
-32592,
-32724,
-32850,
-32984,
-33102,
-33220,
-33322,
-33416,
-33492,
-33549,
-33591,
-33606,
-33606,
-33581,
-33533,
-33468,
-33381,
-33281,
-33168,
-33043,
-32912,
-32780,
-32653,
-32523,
-32413,
-32303,
-32215,
-32139,
-32081,
-32042,
-32019,
-32014,
-32028,
-32058,
-32101,
-32160,
-32226,
-32310,
-32392,
-32487,
-32581,
-32680,
-32779,
-32872,
-32965,
-33052,
-33131,
-33206,
-33267,
-33322,
-33363,
-33394,
-33408,
-33412,
-33400,
-33373,
-33330,
-33277,
-33206,
-33133,
-33035,
-32950,
-32841,
-32749,
-32645,
-32555,
-32468,
-32391,
-32334,
-32278,
-32251,
-32227,
-32229,
-32243,
-32270,
-32315,
-32364,
-32434,
-32498,
-32583,
-32655,
-32745,
-32819,
-32898,
-32967,
-33035,
-33087,
-33140,
-33175,
-33204,
-33226,
-33234,
-33237,
-33227,
-33212,
-33188,
-33155,
-33117,
-33068,
-33017,
-32958,
-32896,
-32828,
-32762,
-32691,
-32627,
-32562,
-32505,
-32453,
-32412,
-32381,
-32362,
-32355,
-32361,
-32380,
-32411,
-32454,
-32508,
-32570,
-32635,
-32714,
-32784,
-32864,
-32933,
-33001,
-33065,
-33113,
-33157,
-33185,
-33204,
-33210,
-33202,
-33185,
-33157,
-33117,
-33074,
-33021,
-32966,
-32907,
-32842,
-32785,
-32715,
-32664,
-32598,
-32547,
-32496,
-32449,
-32411,
-32378,
-32352,
-32337,
-32329,
-32330,
-32345,
-32366,
-32401,
-32442,
-32497,
-32555,
-32628,
-32694,
-32780,
-32850,
-32939,
-33006,
-33086,
-33144,
-33203,
-33244,
-33278,
-33293,
-33297,
-33281,
-33258,
-33212,
-33163,
-33092,
-33024,
-32938,
-32855,
-32765,
-32679,
-32593,
-32514,
-32433,
-32371,
-32309,
-32259,
-32227,
-32188,
-32180,
-32171,
-32178,
-32197,
-32226,
-32263,
-32316,
-32370,
-32441,
-32511,
-32596,
-32677,
-32768,
-32857,
-32947,
-33038,
-33115,
-33200,
-33262,
-33327,
-33370,
-33402,
-33423,
-33419,
-33408,
-33375,
-33325,
-33267,
-33184,
-33101,
-32999,
-32899,
-32787,
-32682,
-32570,
-32471,
-32372,
-32289,
-32209,
-32150,
-32098,
-32067,
-32046,
-32043,
-32054,
-32082,
-32120,
-32173,
-32239,
-32309,
-32397,
-32481,
-32583,
-32676,
-32781,
-32881,
-32981,
-33081,
-33170,
-33256,
-33334,
-33398,
-33453,
-33494,
-33516,
-33528,
-33519,
-33491,
-33455,
-33389,
-33321,
-33231,
-33131,
-33024,
-32905,
-32792,
-32664,
-32553,
-32436,
-32330,
-32242,
-32151,
-32093,
-32036,
-32007,
-31988,
-31991,
-32011,
-32046,
-32096,
-32163,
-32237,
-32329,
-32421,
-32526,
-32631,
-32740,
-32849,
-32957,
-33059,
-33159,
-33248,
-33334,
-33404,
-33466,
-33511,
-33547,
-33562,
-33567,
-33547,
-33524,
-33467,
-33413,
-33327,
-33243,
-33136,
-33031,
-32905,
-32793,
-32661,
-32551,
-32428,
-32327,
-32228,
-32144,
-32080,
-32024,
-31995,
-31977,
-31983,
-32005,
-32044,
-32101,
-32170,
-32253,
-32346,
-32447,
-32554,
-32664,
-32775,
-32885,
-32991,
-33094,
-33186,
-33273,
-33349,
-33411,
-33467,
-33501,
-33529,
-33536,
-33534,
-33509,
-33479,
-33423,
-33364,
-33283,
-33196,
-33098,
-32992,
-32880,
-32766,
-32647,
-32536,
-32428,
-32323,
-32237,
-32153,
-32093,
-32041,
-32013,
-31996,
-32007,
-32027,
-32068,
-32126,
-32191,
-32280,
-32367,
-32470,
-32572,
-32681,
-32787,
-32890,
-32992,
-33084,
-33169,
-33246,
-33311,
-33365,
-33403,
-33435,
-33444,
-33449,
-33435,
-33409,
-33371,
-33320,
-33257,
-33188,
-33106,
-33013,
-32927,
-32819,
-32728,
-32618,
-32527,
-32429,
-32341,
-32265,
-32194,
-32144,
-32099,
-32077,
-32068,
-32073,
-32101,
-32135,
-32194,
-32255,
-32336,
-32416,
-32514,
-32604,
-32702,
-32799,
-32889,
-32978,
-33058,
-33126,
-33193,
-33238,
-33282,
-33305,
-33323,
-33328,
-33314,
-33301,
-33266,
-33228,
-33182,
-33118,
-33063,
-32987,
-32917,
-32840,
-32760,
-32680,
-32602,
-32526,
-32454,
-32389,
-32328,
-32281,
-32242,
-32214,
-32199,
-32198,
-32209,
-32236,
-32273,
-32323,
-32383,
-32450,
-32529,
-32604,
-32688,
-32771,
-32849,
-32928,
-32995,
-33060,
-33112,
-33159,
-33190,
-33216,
-33223,
-33228,
-33216,
-33198,
-33169,
-33135,
-33087,
-33046,
-32984,
-32936,
-32871,
-32816,
-32752,
-32694,
-32637,
-32582,
-32530,
-32485,
-32441,
-32407,
-32381,
-32357,
-32354,
-32345,
-32361,
-32376,
-32408,
-32444,
-32493,
-32547,
-32606,
-32674,
-32738,
-32806,
-32874,
-32936,
-32995,
-33050,
-33090,
-33131,
-33153,
-33172,
-33177,
-33172,
-33159,
-33137,
-33103,
-33068,
-33022,
-32975,
-32924,
-32870,
-32820,
-32765,
-32719,
-32668,
-32627,
-32586,
-32552,
-32521,
-32496,
-32477,
-32461,
-32456,
-32452,
-32463,
-32467,
-32492,
-32514,
-32549,
-32587,
-32629,
-32677,
-32728,
-32782,
-32837,
-32890,
-32941,
-32989,
-33033,
-33070,
-33098,
-33123,
-33131,
-33140,
-33131,
-33117,
-33096,
-33062,
-33029,
-32981,
-32940,
-32884,
-32840,
-32783,
-32738,
-32689,
-32646,
-32610,
-32575,
-32546,
-32527,
-32507,
-32497,
-32491,
-32489,
-32495,
-32502,
-32516,
-32533,
-32555,
-32581,
-32611,
-32642,
-32682,
-32715,
-32760,
-32799,
-32839,
-32882,
-32921,
-32951,
-32994,
-33011,
-33042,
-33052,
-33066,
-33064,
-33063,
-33048,
-33030,
-33005,
-32972,
-32939,
-32895,
-32858,
-32809,
-32771,
-32726,
-32687,
-32650,
-32617,
-32591,
-32565,
-32548,
-32532,
-32524,
-32518,
-32519,
-32519,
-32529,
-32533,
-32551,
-32558,
-32583,
-32596,
-32621,
-32643,
-32671,
-32693,
-32729,
-32754,
-32787,
-32819,
-32847,
-32881,
-32906,
-32934,
-32955,
-32975,
-32988,
-32998,
-33003,
-33000,
-32996,
-32981,
-32965,
-32943,
-32916,
-32891,
-32855,
-32826,
-32793,
-32758,
-32730,
-32695,
-32673,
-32643,
-32623,
-32604,
-32582,
-32572,
-32557,
-32549,
-32542,
-32537,
-32536,
-32535,
-32542,
-32542,
-32560,
-32564,
-32589,
-32603,
-32630,
-32659,
-32685,
-32724,
-32757,
-32797,
-32834,
-32876,
-32908,
-32952,
-32977,
-33010,
-33034,
-33049,
-33067,
-33067,
-33069,
-33061,
-33045,
-33029,
-32999,
-32973,
-32936,
-32900,
-32863,
-32816,
-32782,
-32735,
-32696,
-32660,
-32618,
-32588,
-32553,
-32524,
-32500,
-32481,
-32463,
-32450,
-32449,
-32441,
-32454,
-32460,
-32479,
-32507,
-32533,
-32576,
-32613,
-32665,
-32714,
-32773,
-32827,
-32886,
-32941,
-32996,
-33045,
-33094,
-33128,
-33161,
-33183,
-33196,
-33198,
-33195,
-33173,
-33154,
-33117,
-33075,
-33030,
-32973,
-32919,
-32857,
-32797,
-32735,
-32674,
-32618,
-32563,
-32515,
-32470,
-32434,
-32399,
-32378,
-32360,
-32350,
-32352,
-32358,
-32372,
-32400,
-32426,
-32472,
-32511,
-32568,
-32624,
-32686,
-32753,
-32817,
-32883,
-32952,
-33008,
-33071,
-33117,
-33163,
-33195,
-33220,
-33232,
-33236,
-33225,
-33205,
-33176,
-33132,
-33086,
-33026,
-32965,
-32898,
-32830,
-32757,
-32693,
-32622,
-32563,
-32509,
-32456,
-32420,
-32381,
-32361,
-32344,
-32339,
-32342,
-32351,
-32373,
-32399,
-32436,
-32473,
-32522,
-32573,
-32627,
-32686,
-32742,
-32805,
-32859,
-32921,
-32967,
-33020,
-33058,
-33095,
-33121,
-33137,
-33149,
-33144,
-33138,
-33111,
-33089,
-33044,
-33005,
-32949,
-32897,
-32836,
-32776,
-32716,
-32659,
-32605,
-32558,
-32515,
-32482,
-32457,
-32439,
-32432,
-32437,
-32442,
-32464,
-32490,
-32517,
-32561,
-32594,
-32643,
-32685,
-32732,
-32779,
-32818,
-32864,
-32898,
-32934,
-32964,
-32982,
-33008,
-33010,
-33024,
-33017,
-33013,
-32997,
-32977,
-32951,
-32922,
-32887,
-32846,
-32807,
-32763,
-32719,
-32679,
-32637,
-32601,
-32570,
-32543,
-32526,
-32512,
-32511,
-32518,
-32528,
-32556,
-32582,
-32622,
-32663,
-32711,
-32757,
-32813,
-32857,
-32910,
-32950,
-32992,
-33023,
-33052,
-33067,
-33083,
-33076,
-33079,
-33056,
-33040,
-33007,
-32971,
-32932,
-32885,
-32838,
-32787,
-32737,
-32686,
-32638,
-32590,
-32548,
-32511,
-32476,
-32453,
-32430,
-32421,
-32417,
-32419,
-32440,
-32454,
-32494,
-32528,
-32578,
-32634,
-32692,
-32759,
-32823,
-32894,
-32959,
-33024,
-33084,
-33137,
-33183,
-33216,
-33243,
-33253,
-33257,
-33244,
-33219,
-33184,
-33138,
-33081,
-33016,
-32947,
-32867,
-32791,
-32712,
-32629,
-32559,
-32482,
-32423,
-32360,
-32317,
-32275,
-32251,
-32233,
-32230,
-32234,
-32254,
-32283,
-32321,
-32374,
-32428,
-32497,
-32571,
-32645,
-32731,
-32809,
-32900,
-32974,
-33060,
-33125,
-33199,
-33246,
-33302,
-33324,
-33355,
-33355,
-33350,
-33327,
-33291,
-33242,
-33181,
-33108,
-33028,
-32939,
-32846,
-32754,
-32653,
-32567,
-32473,
-32398,
-32319,
-32264,
-32207,
-32177,
-32148,
-32138,
-32145,
-32155,
-32191,
-32228,
-32280,
-32346,
-32409,
-32491,
-32569,
-32657,
-32739,
-32831,
-32909,
-32994,
-33069,
-33139,
-33199,
-33252,
-33290,
-33321,
-33338,
-33340,
-33332,
-33311,
-33273,
-33229,
-33171,
-33101,
-33031,
-32946,
-32862,
-32776,
-32686,
-32606,
-32522,
-32452,
-32384,
-32332,
-32287,
-32258,
-32234,
-32233,
-32236,
-32257,
-32286,
-32324,
-32377,
-32431,
-32493,
-32562,
-32630,
-32704,
-32773,
-32843,
-32909,
-32972,
-33026,
-33079,
-33118,
-33156,
-33181,
-33197,
-33208,
-33205,
-33194,
-33179,
-33146,
-33118,
-33070,
-33027,
-32972,
-32916,
-32858,
-32797,
-32742,
-32681,
-32629,
-32583,
-32536,
-32507,
-32477,
-32458,
-32452,
-32446,
-32460,
-32471,
-32498,
-32526,
-32560,
-32602,
-32639,
-32687,
-32725,
-32771,
-32810,
-32845,
-32883,
-32905,
-32936,
-32949,
-32967,
-32971,
-32979,
-32975,
-32969,
-32960,
-32948,
-32931,
-32913,
-32893,
-32869,
-32850,
-32825,
-32802,
-32781,
-32757,
-32740,
-32723,
-32706,
-32695,
-32686,
-32679,
-32681,
-32678,
-32689,
-32692,
-32709,
-32719,
-32736,
-32754,
-32769,
-32787,
-32802,
-32814,
-32825,
-32833,
-32833,
-32836,
-32828,
-32823,
-32807,
-32795,
-32775,
-32754,
-32737,
-32711,
-32694,
-32673,
-32656,
-32643,
-32631,
-32627,
-32621,
-32628,
-32629,
-32646,
-32656,
-32677,
-32695,
-32722,
-32745,
-32775,
-32800,
-32829,
-32855,
-32881,
-32905,
-32927,
-32942,
-32963,
-32966,
-32979,
-32975,
-32975,
-32961,
-32951,
-32927,
-32903,
-32870,
-32836,
-32796,
-32756,
-32707,
-32666,
-32616,
-32577,
-32530,
-32497,
-32459,
-32435,
-32415,
-32403,
-32397,
-32408,
-32415,
-32444,
-32471,
-32514,
-32558,
-32608,
-32666,
-32725,
-32783,
-32848,
-32902,
-32965,
-33013,
-33063,
-33103,
-33137,
-33162,
-33180,
-33186,
-33187,
-33174,
-33152,
-33128,
-33083,
-33044,
-32986,
-32929,
-32866,
-32795,
-32731,
-32656,
-32589,
-32523,
-32456,
-32403,
-32351,
-32309,
-32278,
-32256,
-32245,
-32249,
-32258,
-32292,
-32321,
-32380,
-32430,
-32505,
-32575,
-32659,
-32741,
-32828,
-32912,
-32995,
-33072,
-33145,
-33206,
-33263,
-33301,
-33339,
-33351,
-33361,
-33352,
-33331,
-33301,
-33253,
-33200,
-33134,
-33061,
-32980,
-32897,
-32805,
-32719,
-32630,
-32542,
-32461,
-32384,
-32318,
-32258,
-32212,
-32175,
-32155,
-32143,
-32153,
-32170,
-32207,
-32251,
-32315,
-32385,
-32467,
-32555,
-32653,
-32750,
-32852,
-32950,
-33048,
-33135,
-33225,
-33287,
-33359,
-33400,
-33437,
-33456,
-33458,
-33448,
-33422,
-33378,
-33328,
-33255,
-33181,
-33092,
-32997,
-32903,
-32795,
-32697,
-32595,
-32496,
-32411,
-32320,
-32253,
-32188,
-32140,
-32102,
-32084,
-32074,
-32088,
-32112,
-32148,
-32207,
-32271,
-32353,
-32438,
-32540,
-32636,
-32748,
-32853,
-32959,
-33062,
-33155,
-33245,
-33318,
-33386,
-33430,
-33469,
-33485,
-33486,
-33473,
-33441,
-33393,
-33337,
-33256,
-33178,
-33079,
-32979,
-32876,
-32762,
-32662,
-32549,
-32455,
-32359,
-32275,
-32203,
-32141,
-32097,
-32063,
-32046,
-32046,
-32061,
-32089,
-32140,
-32191,
-32271,
-32349,
-32443,
-32543,
-32645,
-32756,
-32861,
-32969,
-33066,
-33163,
-33245,
-33322,
-33378,
-33429,
-33453,
-33475,
-33465,
-33452,
-33413,
-33366,
-33299,
-33225,
-33132,
-33045,
-32932,
-32836,
-32721,
-32620,
-32513,
-32419,
-32329,
-32253,
-32185,
-32132,
-32094,
-32070,
-32064,
-32069,
-32095,
-32130,
-32185,
-32246,
-32326,
-32408,
-32504,
-32602,
-32702,
-32811,
-32906,
-33011,
-33099,
-33186,
-33264,
-33322,
-33378,
-33410,
-33433,
-33439,
-33428,
-33403,
-33361,
-33309,
-33237,
-33164,
-33070,
-32982,
-32876,
-32778,
-32674,
-32576,
-32481,
-32395,
-32315,
-32252,
-32193,
-32158,
-32129,
-32119,
-32124,
-32144,
-32178,
-32223,
-32287,
-32353,
-32436,
-32520,
-32616,
-32709,
-32807,
-32900,
-32996,
-33080,
-33161,
-33230,
-33292,
-33340,
-33373,
-33395,
-33403,
-33393,
-33374,
-33336,
-33287,
-33227,
-33157,
-33073,
-32990,
-32893,
-32802,
-32703,
-32613,
-32519,
-32439,
-32361,
-32296,
-32245,
-32201,
-32178,
-32161,
-32168,
-32181,
-32215,
-32257,
-32314,
-32381,
-32454,
-32540,
-32623,
-32720,
-32808,
-32900,
-32987,
-33069,
-33146,
-33211,
-33270,
-33311,
-33348,
-33364,
-33374,
-33364,
-33343,
-33312,
-33264,
-33208,
-33140,
-33068,
-32982,
-32900,
-32806,
-32717,
-32628,
-32539,
-32460,
-32386,
-32318,
-32267,
-32221,
-32192,
-32177,
-32171,
-32186,
-32208,
-32250,
-32297,
-32362,
-32427,
-32512,
-32590,
-32681,
-32772,
-32856,
-32948,
-33026,
-33104,
-33174,
-33226,
-33283,
-33308,
-33341,
-33344,
-33345,
-33328,
-33301,
-33260,
-33207,
-33149,
-33077,
-33004,
-32920,
-32836,
-32750,
-32661,
-32580,
-32498,
-32425,
-32357,
-32298,
-32250,
-32216,
-32189,
-32180,
-32183,
-32193,
-32227,
-32263,
-32317,
-32376,
-32451,
-32520,
-32612,
-32689,
-32781,
-32863,
-32950,
-33026,
-33099,
-33166,
-33215,
-33267,
-33289,
-33320,
-33321,
-33320,
-33301,
-33271,
-33234,
-33181,
-33123,
-33054,
-32983,
-32903,
-32826,
-32741,
-32662,
-32583,
-32508,
-32440,
-32374,
-32327,
-32278,
-32247,
-32226,
-32211,
-32219,
-32228,
-32256,
-32293,
-32339,
-32396,
-32462,
-32532,
-32607,
-32690,
-32766,
-32854,
-32924,
-33005,
-33069,
-33133,
-33185,
-33228,
-33261,
-33282,
-33294,
-33286,
-33280,
-33247,
-33218,
-33168,
-33120,
-33051,
-32994,
-32914,
-32846,
-32770,
-32693,
-32625,
-32552,
-32492,
-32431,
-32384,
-32341,
-32309,
-32288,
-32276,
-32276,
-32285,
-32306,
-32338,
-32376,
-32427,
-32482,
-32543,
-32611,
-32681,
-32755,
-32824,
-32899,
-32961,
-33030,
-33081,
-33138,
-33172,
-33209,
-33229,
-33242,
-33242,
-33235,
-33212,
-33187,
-33145,
-33103,
-33047,
-32992,
-32924,
-32866,
-32792,
-32730,
-32662,
-32601,
-32544,
-32491,
-32444,
-32408,
-32375,
-32356,
-32342,
-32341,
-32347,
-32363,
-32387,
-32421,
-32460,
-32507,
-32562,
-32616,
-32679,
-32738,
-32802,
-32863,
-32924,
-32977,
-33028,
-33073,
-33110,
-33142,
-33159,
-33175,
-33177,
-33170,
-33158,
-33130,
-33103,
-33061,
-33018,
-32969,
-32911,
-32858,
-32798,
-32741,
-32684,
-32629,
-32578,
-32534,
-32490,
-32459,
-32430,
-32412,
-32401,
-32397,
-32401,
-32419,
-32433,
-32465,
-32497,
-32539,
-32581,
-32633,
-32678,
-32736,
-32788,
-32837,
-32892,
-32935,
-32981,
-33020,
-33048,
-33079,
-33093,
-33108,
-33106,
-33106,
-33090,
-33073,
-33045,
-33012,
-32974,
-32931,
-32885,
-32837,
-32786,
-32737,
-32690,
-32639,
-32602,
-32556,
-32528,
-32495,
-32475,
-32457,
-32452,
-32446,
-32455,
-32464,
-32485,
-32507,
-32540,
-32572,
-32613,
-32654,
-32696,
-32746,
-32783,
-32838,
-32871,
-32917,
-32950,
-32984,
-33009,
-33032,
-33044,
-33057,
-33055,
-33053,
-33040,
-33024,
-33000,
-32972,
-32940,
-32901,
-32863,
-32819,
-32780,
-32735,
-32694,
-32654,
-32618,
-32583,
-32558,
-32530,
-32515,
-32500,
-32494,
-32495,
-32500,
-32512,
-32528,
-32552,
-32576,
-32611,
-32642,
-32679,
-32718,
-32755,
-32798,
-32831,
-32872,
-32900,
-32936,
-32960,
-32983,
-33004,
-33009,
-33024,
-33018,
-33020,
-33003,
-32996,
-32968,
-32949,
-32918,
-32885,
-32855,
-32814,
-32783,
-32740,
-32711,
-32669,
-32645,
-32609,
-32592,
-32563,
-32553,
-32540,
-32533,
-32537,
-32537,
-32550,
-32564,
-32583,
-32604,
-32634,
-32658,
-32695,
-32723,
-32761,
-32788,
-32828,
-32851,
-32887,
-32908,
-32933,
-32954,
-32965,
-32982,
-32983,
-32988,
-32981,
-32976,
-32964,
-32945,
-32928,
-32901,
-32876,
-32849,
-32817,
-32786,
-32757,
-32723,
-32696,
-32669,
-32640,
-32623,
-32601,
-32587,
-32578,
-32568,
-32569,
-32573,
-32575,
-32593,
-32601,
-32622,
-32646,
-32663,
-32696,
-32716,
-32749,
-32771,
-32802,
-32828,
-32849,
-32878,
-32889,
-32913,
-32922,
-32934,
-32942,
-32940,
-32944,
-32934,
-32928,
-32916,
-32901,
-32881,
-32864,
-32839,
-32817,
-32791,
-32769,
-32739,
-32722,
-32690,
-32678,
-32653,
-32640,
-32627,
-32614,
-32612,
-32607,
-32609,
-32613,
-32619,
-32631,
-32643,
-32663,
-32676,
-32700,
-32717,
-32740,
-32763,
-32783,
-32803,
-32823,
-32840,
-32856,
-32870,
-32880,
-32888,
-32895,
-32894,
-32898,
-32891,
-32888,
-32880,
-32867,
-32856,
-32841,
-32826,
-32807,
-32794,
-32772,
-32757,
-32740,
-32721,
-32709,
-32694,
-32681,
-32676,
-32662,
-32664,
-32656,
-32661,
-32659,
-32668,
-32671,
-32684,
-32693,
-32705,
-32719,
-32733,
-32747,
-32763,
-32775,
-32791,
-32802,
-32815,
-32825,
-32833,
-32839,
-32847,
-32846,
-32852,
-32846,
-32850,
-32841,
-32839,
-32830,
-32823,
-32816,
-32803,
-32794,
-32787,
-32773,
-32765,
-32755,
-32742,
-32739,
-32728,
-32722,
-32718,
-32713,
-32709,
-32712,
-32706,
-32713,
-32712,
-32719,
-32722,
-32732,
-32732,
-32746,
-32749,
-32758,
-32769,
-32770,
-32783,
-32786,
-32792,
-32798,
-32800,
-32804,
-32805,
-32805,
-32807,
-32802,
-32804,
-32798,
-32797,
-32793,
-32785,
-32787,
-32778,
-32777,
-32770,
-32768,
-32761,
-32764,
-32754,
-32757,
-32749,
-32752,
-32748,
-32749,
-32748,
-32746,
-32751,
-32747,
-32752,
-32751,
-32755,
-32757,
-32758,
-32763,
-32762,
-32768,
-32766,
-32770,
-32772,
-32772,
-32775,
-32772,
-32776,
-32773,
-32775,
-32768,
-32772,
-32769,
-32768,
-32766,
-32765,
-32761,
-32763,
-32761,
-32759,
-32763,
-32758,
-32762,
-32762,
-32761,
-32766,
-32765,
-32768,
-32769,
-32771,
-32772,
-32774,
-32774,
-32775,
-32776,
-32776,
-32775,
-32778,
-32772,
-32778,
-32769,
-32775,
-32767,
-32772,
-32764,
-32768,
-32759,
-32766,
-32754,
-32761,
-32754,
-32753,
-32755,
-32750,
-32751,
-32750,
-32749,
-32750,
-32752,
-32750,
-32755,
-32753,
-32760,
-32759,
-32764,
-32768,
-32768,
-32777,
-32775,
-32784,
-32782,
-32788,
-32788,
-32791,
-32792,
-32791,
-32793,
-32787,
-32794,
-32782,
-32787,
-32779,
-32779,
-32771,
-32773,
-32762,
-32767,
-32755,
-32758,
-32754,
-32747,
-32751,
-32746,
-32745,
-32746,
-32744,
-32746,
-32748,
-32745,
-32753,
-32749,
-32758,
-32756,
-32761,
-32767,
-32766,
-32775,
-32774,
-32781,
-32782,
-32789,
-32786,
-32795,
-32792,
-32796,
-32796,
-32795,
-32794,
-32794,
-32788,
-32790,
-32781,
-32782,
-32773,
-32772,
-32763,
-32765,
-32753,
-32755,
-32747,
-32748,
-32742,
-32743,
-32739,
-32742,
-32741,
-32742,
-32745,
-32747,
-32748,
-32754,
-32756,
-32759,
-32766,
-32765,
-32774,
-32773,
-32780,
-32782,
-32785,
-32789,
-32788,
-32793,
-32791,
-32794,
-32791,
-32792,
-32789,
-32789,
-32784,
-32782,
-32777,
-32775,
-32768,
-32767,
-32757,
-32758,
-32749,
-32747,
-32741,
-32740,
-32736,
-32737,
-32734,
-32735,
-32738,
-32736,
-32742,
-32743,
-32750,
-32752,
-32759,
-32762,
-32768,
-32775
+static const uint8_t powerUp48k_wav_data[30240] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+16,11,155,187,201,177,179,179,50,75,8,178,178,186,188,251,
+202,187,204,202,186,186,170,155,160,5,83,114,49,52,67,67,
+51,67,51,67,50,67,50,51,67,67,67,51,53,67,66,49,
+33,2,160,249,218,219,188,204,203,203,203,187,187,188,171,171,
+155,137,16,66,83,52,67,67,50,50,34,17,137,186,189,189,
+202,154,137,48,85,68,53,68,67,52,67,51,36,35,35,18,
+1,169,219,189,204,219,186,172,187,187,187,170,138,24,49,68,
+36,37,35,35,18,0,186,205,189,189,188,188,203,171,171,154,
+137,33,83,68,68,51,68,50,67,34,34,18,1,152,170,189,
+203,172,172,170,153,9,33,83,53,68,67,51,52,50,51,34,
+32,137,171,190,188,204,187,187,188,185,186,169,168,168,169,188,
+205,220,219,203,219,187,188,188,203,186,170,170,153,0,50,68,
+68,67,51,52,51,51,51,35,35,34,51,53,54,69,83,52,
+68,67,67,51,52,36,50,34,18,129,168,204,235,203,203,203,
+203,186,187,172,170,170,153,137,136,8,136,168,202,205,219,204,
+187,189,203,187,187,187,153,24,83,84,68,67,52,52,67,67,
+50,51,50,35,18,1,136,170,219,187,204,170,171,154,137,24,
+34,68,51,36,18,128,219,206,188,190,188,188,173,203,186,172,
+186,170,154,153,8,33,67,68,67,67,67,35,36,50,35,35,
+51,50,50,51,52,67,36,52,67,36,67,50,50,35,19,1,
+160,218,219,219,203,187,173,187,187,172,171,187,172,203,187,189,
+188,204,203,187,173,187,172,171,170,152,17,83,84,67,52,52,
+67,51,51,51,18,129,169,220,219,203,203,171,187,170,153,32,
+68,68,68,51,37,51,36,34,1,128,185,220,219,203,203,187,
+203,170,154,137,16,67,53,53,52,67,51,67,18,17,144,185,
+204,204,203,203,187,187,187,170,137,32,83,68,67,52,67,50,
+50,33,128,168,204,204,188,188,203,187,187,171,170,136,33,53,
+54,52,53,51,68,50,50,35,35,34,1,128,153,187,204,203,
+203,186,171,187,170,153,137,0,17,18,18,160,220,206,220,188,
+189,189,188,204,187,188,188,187,172,171,155,154,0,50,85,83,
+52,52,52,52,67,50,51,36,18,18,1,128,152,186,202,187,
+187,170,137,33,53,69,51,37,34,2,168,220,205,204,219,203,
+203,172,187,172,187,171,171,153,8,48,83,68,67,52,51,52,
+67,34,35,33,17,1,0,128,8,16,66,68,68,68,67,67,
+67,51,51,51,35,1,169,204,205,188,189,219,187,203,203,186,
+186,170,170,153,136,17,50,68,67,51,67,50,18,2,128,169,
+203,188,188,186,154,24,115,68,68,68,67,67,36,51,52,50,
+35,19,2,144,186,205,204,203,187,188,203,186,170,153,9,16,
+51,53,52,52,50,18,128,202,205,204,204,187,188,188,187,187,
+186,137,40,82,68,52,53,67,51,52,35,35,34,1,136,186,
+219,203,187,172,169,8,49,84,68,52,67,67,50,34,2,144,
+218,204,188,189,188,188,187,172,171,155,154,8,17,83,67,52,
+36,51,51,35,18,144,169,204,219,186,187,170,8,82,84,68,
+67,52,52,67,35,51,34,2,144,202,204,188,189,203,203,171,
+187,171,170,153,0,49,52,53,67,51,51,35,0,168,204,189,
+204,187,188,186,171,137,16,99,68,83,83,66,50,51,36,34,
+18,1,152,202,204,188,188,188,203,186,186,154,138,0,66,83,
+52,68,66,50,50,50,33,0,168,203,189,189,188,203,187,187,
+171,169,8,49,68,52,68,50,51,35,18,152,219,204,204,203,
+187,188,186,170,9,32,68,69,83,51,53,51,52,50,50,18,
+1,153,202,204,203,172,172,186,186,170,153,137,16,33,34,18,
+128,219,221,204,188,204,187,188,187,186,154,9,50,70,52,69,
+51,52,67,35,51,34,17,136,185,188,205,187,203,187,170,137,
+16,67,53,53,52,36,51,34,1,152,219,189,189,189,203,187,
+203,186,154,153,8,34,68,52,52,67,35,35,18,129,169,204,
+204,203,187,203,170,138,8,65,99,83,67,36,36,51,35,51,
+18,2,152,186,204,188,188,172,171,170,153,8,33,67,83,35,
+51,17,160,220,205,188,189,188,188,203,187,187,171,171,137,8,
+50,68,52,52,52,67,50,51,51,67,50,52,67,83,67,67,
+52,52,67,67,35,36,34,33,1,144,185,189,189,189,203,172,
+203,186,203,186,186,187,187,203,186,172,203,186,203,186,187,187,
+170,137,33,85,68,83,52,83,51,52,51,52,50,35,35,17,
+1,128,153,186,186,186,152,33,85,68,68,67,67,51,67,35,
+35,18,128,185,220,188,205,187,189,203,172,172,187,187,188,203,
+186,187,187,172,171,187,171,187,170,154,137,16,67,69,84,67,
+83,83,51,53,83,51,52,52,67,67,50,36,35,51,34,34,
+16,168,202,204,188,189,203,172,187,203,186,170,170,170,153,153,
+169,186,220,235,203,219,203,203,187,203,186,170,137,24,66,53,
+69,67,67,51,52,51,51,51,50,17,128,152,171,188,187,172,
+154,9,33,84,83,67,36,67,34,50,17,136,202,205,188,189,
+189,203,203,186,172,170,154,138,8,33,67,52,52,51,35,18,
+152,204,204,188,188,172,170,137,16,99,52,69,51,37,51,36,
+34,18,1,136,154,203,187,188,171,171,153,153,152,170,205,205,
+204,219,203,203,187,203,170,153,8,33,68,52,53,67,51,51,
+51,51,34,35,50,67,68,83,67,67,35,51,34,136,235,189,
+190,204,187,173,187,187,187,154,153,17,50,53,52,36,35,19,
+17,136,185,202,186,169,16,68,54,69,51,53,51,51,51,35,
+34,1,1,17,35,69,52,68,51,50,2,168,221,220,219,187,
+188,172,186,153,136,34,83,52,36,35,18,152,205,204,189,219,
+187,172,171,170,137,24,51,54,68,66,50,35,35,18,17,0,
+8,8,33,68,84,67,52,52,67,50,34,17,1,137,171,188,
+188,172,187,172,188,203,204,188,189,188,173,172,187,171,171,154,
+136,34,68,52,67,51,51,17,128,185,219,187,171,24,100,84,
+68,83,51,52,51,35,18,129,169,220,203,188,187,172,155,154,
+8,33,51,53,52,50,18,1,169,219,204,187,188,203,170,171,
+170,154,187,219,203,203,203,187,171,154,16,99,68,68,51,52,
+36,34,17,1,152,168,137,24,99,69,53,53,52,52,51,35,
+18,144,202,205,219,203,187,187,172,170,153,137,8,0,128,152,
+203,204,188,188,171,155,24,83,69,52,53,51,36,35,17,128,
+169,202,203,170,137,49,70,68,52,67,51,34,17,153,204,204,
+219,202,170,170,153,9,17,50,52,51,19,144,219,205,188,188,
+172,171,153,8,48,83,67,51,35,18,128,169,172,171,24,116,
+84,68,83,51,52,51,34,2,144,203,204,188,188,171,187,153,
+9,33,66,51,35,129,218,220,204,188,203,171,187,154,137,24,
+50,67,67,18,2,128,153,137,48,102,84,68,83,67,51,52,
+50,34,1,152,187,190,188,172,187,186,153,9,0,18,33,136,
+219,205,204,188,203,187,171,170,8,49,84,67,51,36,34,17,
+128,169,187,203,154,0,83,69,83,51,51,35,2,152,219,188,
+188,171,9,65,69,53,68,51,52,34,18,144,185,205,203,188,
+203,186,186,154,154,153,168,170,204,219,188,203,187,187,154,40,
+99,68,52,68,50,51,35,18,1,144,169,185,169,24,83,69,
+68,51,52,50,18,129,184,235,203,203,187,186,154,137,0,17,
+17,144,219,221,188,189,219,186,187,186,186,170,185,202,219,219,
+203,203,203,170,137,32,84,53,54,83,67,50,36,34,34,17,
+128,136,154,187,186,187,170,153,169,186,205,205,188,189,188,188,
+187,186,170,154,136,152,184,235,189,190,188,188,172,170,138,16,
+83,68,68,51,52,51,50,19,18,1,0,16,66,99,67,68,
+50,51,34,0,202,205,204,203,203,187,186,171,169,152,128,0,
+128,152,202,219,203,187,154,25,98,68,83,67,51,35,34,128,
+169,188,189,186,138,32,100,68,52,37,67,34,19,18,128,169,
+203,188,188,203,171,171,170,171,186,219,203,219,203,187,188,172,
+170,154,137,0,66,67,52,52,52,51,67,51,51,37,67,51,
+68,66,35,36,51,51,50,17,152,218,204,204,203,203,187,171,
+187,154,136,17,51,37,51,17,168,221,189,189,188,188,186,171,
+138,9,33,83,51,67,35,18,1,1,50,85,85,83,68,67,
+67,51,51,50,17,152,202,189,204,187,172,171,170,153,128,16,
+0,144,201,205,188,189,188,186,171,138,16,83,68,67,67,50,
+34,17,128,153,187,203,170,9,49,70,52,52,51,35,1,169,
+205,188,203,170,138,33,85,52,53,52,67,34,17,136,185,205,
+203,203,187,172,170,153,153,152,136,169,203,204,204,187,203,186,
+153,16,83,53,53,52,36,35,35,18,0,152,153,170,136,48,
+85,52,53,52,51,51,17,144,218,219,203,172,171,170,154,9,
+0,17,1,152,235,220,219,203,187,188,186,171,170,170,186,188,
+189,189,188,188,172,154,8,66,69,69,67,52,67,51,36,34,
+18,16,136,153,170,187,171,171,154,154,169,219,220,204,219,203,
+203,187,171,171,170,137,136,137,202,220,220,203,219,186,187,170,
+9,49,85,52,53,52,51,51,51,34,17,0,16,32,82,68,
+52,68,50,35,18,152,204,189,205,187,188,187,186,171,153,136,
+128,0,128,169,204,203,203,170,137,33,85,52,68,51,51,34,
+1,169,204,188,187,170,24,115,68,68,67,51,67,50,18,1,
+152,185,188,219,186,187,172,186,203,203,188,204,203,187,188,203,
+170,169,136,24,34,52,52,67,36,35,67,51,68,67,67,36,
+36,51,35,35,17,144,186,205,219,186,172,171,171,170,170,170,
+186,203,203,187,187,154,24,98,99,51,52,51,17,168,220,204,
+188,203,170,154,8,50,69,83,50,51,18,1,153,187,203,153,
+65,70,69,67,52,51,51,18,128,219,189,189,188,203,170,155,
+154,8,0,17,18,1,153,219,219,187,171,9,81,69,53,53,
+67,36,50,33,1,144,169,188,188,203,154,153,16,49,52,36,
+34,144,234,204,204,203,187,187,171,136,50,69,68,51,36,35,
+17,152,202,188,173,187,171,137,32,68,53,36,36,18,129,168,
+219,204,203,187,186,170,8,48,68,52,52,67,34,18,2,1,
+1,49,99,99,67,67,67,34,2,144,219,205,188,204,203,186,
+187,186,153,9,17,51,53,67,34,34,17,0,16,49,70,84,
+83,67,67,35,35,18,136,202,204,203,172,171,170,137,17,51,
+53,36,34,129,185,220,204,202,170,154,137,32,66,67,51,18,
+128,204,189,205,187,187,187,137,48,84,68,83,51,51,36,34,
+34,1,0,0,0,16,35,52,52,50,1,217,221,205,219,219,
+187,188,172,171,170,137,8,50,53,53,52,51,51,50,33,0,
+136,136,16,83,68,68,67,35,35,1,185,220,189,188,203,186,
+153,9,49,83,52,51,34,129,201,220,219,203,186,187,154,137,
+17,67,68,51,51,36,34,17,17,17,34,83,83,67,67,35,
+35,18,0,170,220,219,203,203,187,188,187,187,187,155,9,49,
+85,83,67,50,35,2,152,220,219,172,172,171,169,8,33,83,
+52,67,34,34,129,128,137,8,67,85,68,67,67,50,18,129,
+185,205,219,187,203,186,154,154,136,136,136,169,186,188,170,137,
+98,84,83,67,35,19,1,184,235,203,186,170,8,67,69,67,
+36,18,129,169,220,203,187,171,137,49,85,68,51,67,34,129,
+168,219,188,188,172,170,137,0,33,50,51,1,169,221,203,187,
+171,24,99,69,83,51,67,34,1,152,202,219,203,186,187,171,
+171,186,186,188,188,187,155,48,86,85,67,52,52,51,51,33,
+128,169,203,203,187,171,155,171,203,205,220,219,203,187,172,170,
+136,17,68,52,52,36,35,17,129,136,169,153,24,65,99,67,
+35,35,0,185,205,188,188,186,154,8,33,50,34,145,251,204,
+204,187,187,171,153,16,51,53,52,35,51,67,67,68,68,67,
+51,52,34,1,169,220,219,187,172,171,154,136,24,16,17,128,
+152,170,137,98,85,84,67,67,50,34,128,185,205,188,188,172,
+171,170,153,137,152,153,169,171,138,64,86,69,68,67,67,35,
+35,18,128,168,187,189,187,172,186,186,204,219,219,203,203,187,
+170,138,32,99,52,53,51,51,35,18,0,137,152,0,33,67,
+50,128,251,206,188,189,187,172,153,24,50,84,51,52,35,18,
+0,137,154,153,0,66,52,36,2,201,221,204,188,172,187,155,
+153,32,66,68,66,50,34,35,33,34,66,51,53,67,35,34,
+144,218,220,188,188,203,187,171,171,154,137,137,8,17,50,70,
+68,83,52,67,51,36,18,1,152,186,204,203,187,203,186,186,
+187,188,203,187,186,137,49,70,53,53,51,36,34,18,16,128,
+16,33,67,67,18,184,207,205,188,188,187,171,9,49,84,51,
+36,2,160,219,188,188,154,8,83,69,67,50,19,1,168,188,
+188,172,137,32,83,67,51,2,184,206,204,187,203,153,8,49,
+68,67,34,18,128,169,171,139,56,85,53,52,35,2,185,206,
+204,203,171,171,153,0,50,67,36,35,33,17,33,67,69,68,
+67,51,36,1,144,202,204,188,203,171,171,171,154,170,169,153,
+153,32,69,69,68,52,67,50,34,2,144,185,219,203,186,171,
+187,186,188,204,187,188,171,137,50,71,53,52,36,35,19,129,
+168,202,203,187,187,203,186,203,188,188,188,172,154,25,65,69,
+52,52,52,34,34,1,136,168,169,170,171,203,204,204,219,203,
+203,186,154,137,32,83,83,51,67,50,34,17,17,0,16,8,
+136,186,190,205,187,172,171,137,33,68,83,51,51,18,128,169,
+203,172,171,187,187,205,204,219,188,203,186,153,24,82,84,67,
+51,52,35,34,18,128,168,202,204,204,203,188,188,187,171,138,
+40,69,68,52,52,36,35,18,17,0,144,152,169,219,235,219,
+204,203,188,203,186,170,153,16,66,68,51,68,50,67,35,52,
+51,52,35,34,152,219,221,203,203,187,186,154,9,16,34,34,
+34,17,16,51,71,84,83,51,51,35,1,202,220,203,172,187,
+170,154,137,136,128,8,8,32,85,84,52,53,51,36,18,129,
+185,219,188,187,187,171,170,170,187,204,188,187,154,24,85,68,
+68,66,34,18,17,128,153,170,170,170,187,204,204,188,189,203,
+171,170,8,65,52,53,52,35,35,17,128,136,169,169,170,203,
+203,188,188,187,155,9,66,69,52,36,51,34,18,18,50,83,
+66,18,152,221,190,205,188,187,172,155,138,0,49,83,51,52,
+51,37,52,67,67,51,35,34,144,202,204,203,171,171,137,0,
+18,18,128,218,204,188,188,170,153,8,17,17,144,219,205,188,
+188,171,170,8,65,84,52,53,68,51,52,52,50,34,1,168,
+219,204,203,187,172,186,170,169,154,170,169,153,24,83,85,83,
+67,51,35,19,129,168,219,203,203,187,187,188,219,202,170,155,
+137,66,85,83,52,67,50,18,1,152,186,189,203,186,187,203,
+187,188,204,186,170,136,49,70,68,67,51,51,35,19,2,17,
+128,144,201,220,220,188,204,187,187,186,137,16,67,67,36,50,
+33,33,17,34,51,67,34,168,236,204,188,186,154,16,68,53,
+52,36,51,50,50,67,67,36,51,18,185,222,189,189,188,172,
+186,169,137,8,0,17,33,67,52,69,52,83,50,51,18,129,
+168,187,189,203,170,169,169,185,186,188,171,8,84,85,83,51,
+36,19,1,168,203,204,203,202,186,187,188,172,187,187,153,16,
+99,52,68,50,35,18,2,17,17,50,53,52,50,18,152,187,
+189,154,56,101,52,53,35,35,0,169,204,204,187,188,188,204,
+203,203,187,172,154,9,32,68,83,51,51,51,35,18,1,1,
+128,152,202,204,189,188,187,154,24,84,68,52,52,51,51,36,
+34,35,34,18,144,205,206,188,189,204,186,186,154,137,8,34,
+52,52,52,67,51,67,35,34,18,136,202,204,188,203,186,170,
+137,16,50,84,67,67,67,67,35,36,18,2,152,235,219,204,
+187,204,186,171,171,154,9,49,69,68,83,51,67,51,35,19,
+1,153,203,204,188,188,188,187,172,170,154,8,33,68,68,67,
+67,50,51,50,17,128,169,205,219,188,188,172,172,170,170,137,
+16,66,53,53,52,52,51,51,35,18,136,186,205,188,204,187,
+188,187,187,186,154,24,65,99,67,52,83,50,50,35,18,1,
+152,203,204,203,188,187,172,186,153,136,17,67,52,52,36,51,
+51,34,1,152,204,204,204,187,203,171,170,9,32,68,83,67,
+67,50,51,35,34,17,152,202,205,203,188,203,171,170,137,24,
+51,54,68,51,52,50,35,1,153,189,190,189,203,203,170,154,
+137,16,50,69,67,52,52,36,51,35,18,128,201,189,189,189,
+187,188,186,170,153,8,33,68,68,52,52,52,51,35,19,128,
+186,206,188,204,186,187,186,154,136,49,99,68,67,52,51,52,
+34,18,0,169,219,204,203,188,203,187,203,170,138,8,49,69,
+52,52,52,51,51,51,34,1,169,220,189,204,203,187,172,170,
+154,136,32,67,68,52,52,67,35,51,34,16,153,202,204,203,
+187,188,187,187,187,154,0,82,99,67,67,51,67,34,34,1,
+152,218,204,189,219,187,187,171,138,8,49,68,52,68,67,52,
+66,34,34,0,168,203,188,188,187,188,202,186,186,171,137,33,
+69,52,52,51,51,50,50,51,52,51,129,251,204,204,187,171,
+155,137,8,0,16,33,99,68,83,51,36,17,128,169,187,172,
+170,169,169,203,204,203,187,170,154,152,169,187,188,155,82,86,
+84,67,67,51,52,50,51,34,128,202,221,203,203,187,187,187,
+203,187,172,154,9,50,70,67,36,51,51,67,67,66,18,1,
+201,204,204,171,187,153,8,16,33,49,67,85,83,52,51,35,
+129,202,204,188,187,187,187,188,188,188,155,25,99,68,52,51,
+35,17,0,33,50,53,51,128,205,190,189,186,155,137,0,0,
+128,137,25,98,69,68,51,34,128,186,205,186,155,138,136,136,
+170,219,154,56,101,68,51,36,17,128,152,153,8,0,128,234,
+205,188,188,170,138,8,17,0,152,170,9,100,69,52,51,19,
+129,169,187,155,10,136,168,205,204,170,8,115,83,51,51,1,
+152,185,169,136,136,201,221,189,173,171,170,137,152,186,220,203,
+171,9,66,69,67,51,51,51,52,54,52,67,34,128,201,219,
+203,186,170,154,187,189,204,171,154,16,68,68,50,34,1,0,
+17,68,83,35,145,234,189,189,171,170,8,32,17,16,8,65,
+85,69,52,51,19,144,186,189,187,155,154,186,221,188,189,170,
+8,49,54,67,34,2,0,24,33,83,35,1,234,204,188,187,
+153,16,66,50,34,0,0,66,69,69,35,35,145,202,205,188,
+187,170,154,137,153,170,170,137,98,85,68,51,51,18,152,170,
+187,137,33,52,1,234,205,172,170,40,83,52,51,129,201,219,
+186,138,24,16,168,221,204,187,155,16,68,52,67,33,16,0,
+49,53,53,35,1,202,189,204,170,137,136,128,144,153,170,24,
+84,69,51,34,144,202,204,186,153,136,152,202,205,203,154,24,
+99,52,52,34,17,16,49,84,67,51,1,201,205,203,171,153,
+8,136,186,205,204,170,136,50,84,35,19,129,152,9,49,55,
+53,34,129,185,189,171,137,33,51,2,251,189,189,171,137,49,
+52,36,18,128,170,153,48,70,52,34,128,235,204,186,154,8,
+50,35,18,185,189,155,81,70,68,50,17,168,187,188,154,16,
+34,128,221,205,187,171,9,67,52,51,1,144,8,82,54,53,
+34,145,202,189,187,154,8,1,144,219,189,171,8,83,53,51,
+3,144,170,137,82,69,51,2,184,205,171,155,8,17,145,235,
+205,187,155,16,68,67,34,17,8,24,67,54,36,18,168,204,
+188,172,137,8,0,152,187,188,138,82,69,52,35,1,144,169,
+136,49,51,129,252,205,203,171,138,8,33,33,0,0,48,86,
+68,52,35,18,152,202,172,170,153,8,168,234,219,187,139,32,
+85,67,35,129,170,188,171,24,83,51,145,220,204,171,24,98,
+83,34,128,201,187,155,40,69,51,18,184,189,172,24,99,67,
+18,168,189,189,155,137,17,34,144,204,203,138,50,71,36,35,
+2,128,8,24,50,35,145,252,204,203,170,154,153,152,154,186,
+137,65,85,67,51,51,50,50,67,51,18,184,222,188,187,170,
+136,0,144,201,186,10,98,84,35,18,169,189,173,154,24,49,
+35,130,185,172,9,100,53,52,18,152,203,188,170,137,33,35,
+19,152,203,137,115,69,52,34,145,234,204,187,156,153,128,0,
+152,202,170,40,101,68,67,34,1,152,153,8,49,51,146,237,
+205,203,154,137,33,50,18,129,153,40,115,68,51,2,184,205,
+172,155,138,128,144,168,187,137,99,70,52,67,34,17,1,0,
+144,186,191,205,187,187,154,8,1,17,0,17,84,68,52,35,
+128,185,173,155,16,51,20,160,206,187,154,81,68,36,18,136,
+170,154,8,50,19,217,191,189,170,136,33,19,129,201,188,154,
+32,53,37,33,0,33,99,52,36,2,168,187,171,40,68,34,
+176,207,204,170,154,128,144,185,205,171,25,84,69,51,35,2,
+168,186,170,9,16,168,237,189,189,171,9,49,69,51,35,17,
+16,82,68,52,18,168,206,188,172,154,8,16,1,152,170,8,
+115,68,36,34,144,169,171,136,49,19,160,222,188,170,25,66,
+67,18,0,8,48,68,51,145,237,188,172,153,0,33,1,153,
+171,40,86,53,36,2,152,186,154,24,50,145,237,205,187,170,
+16,67,52,51,34,50,52,38,35,1,219,220,187,187,171,169,
+186,187,171,56,86,53,52,35,18,34,34,52,20,145,235,220,
+171,171,137,17,17,144,187,173,9,98,52,35,129,203,173,139,
+48,70,51,18,168,203,171,25,83,52,19,185,221,187,155,9,
+17,130,201,220,186,8,99,68,67,18,1,128,136,128,0,168,
+205,189,173,187,170,169,136,8,66,84,68,36,51,35,34,16,
+128,168,205,220,203,187,171,154,136,0,0,17,82,68,68,51,
+35,35,18,18,18,144,235,205,203,172,170,169,154,170,154,24,
+84,84,51,50,17,1,16,34,51,146,252,220,187,171,154,0,
+18,17,33,66,85,83,50,18,144,202,187,186,169,186,204,204,
+170,137,33,67,2,160,154,72,71,69,51,18,144,186,203,153,
+128,160,251,190,188,170,8,67,68,34,2,128,8,50,54,52,
+2,202,190,173,155,137,0,1,152,169,9,114,84,67,34,1,
+152,154,137,0,1,184,206,204,186,154,153,153,171,172,9,82,
+69,52,67,50,51,51,51,1,201,205,188,187,187,188,219,171,
+171,8,49,53,51,34,51,69,53,36,34,144,153,138,32,67,
+19,200,205,188,187,186,203,205,219,186,138,8,50,68,67,67,
+83,51,36,18,129,136,8,8,144,219,190,189,187,171,153,153,
+219,203,170,8,68,52,37,34,34,50,51,52,51,17,168,220,
+219,188,203,187,186,154,170,170,170,40,101,52,52,34,128,137,
+24,66,52,2,218,204,155,9,50,35,168,189,138,101,69,67,
+18,1,152,128,17,129,251,205,204,170,153,128,0,152,154,137,
+99,68,36,18,136,153,137,33,51,2,234,188,171,25,65,18,
+168,205,188,170,152,136,153,137,81,86,52,68,34,35,51,67,
+35,129,219,189,188,187,186,170,188,188,170,24,67,37,19,129,
+168,153,137,168,204,190,187,138,65,83,67,34,51,68,67,19,
+145,235,188,171,154,136,168,170,155,96,70,68,34,2,144,152,
+8,1,129,218,189,187,24,85,67,35,129,152,154,153,185,222,
+221,203,186,154,9,16,18,33,67,84,83,50,18,129,169,186,
+170,169,186,204,171,9,82,69,50,34,129,128,152,168,235,204,
+187,170,16,68,83,50,67,67,67,35,130,202,205,187,171,170,
+169,202,171,139,81,69,51,18,152,204,203,187,187,189,188,172,
+137,33,69,52,52,51,68,50,18,129,185,189,188,187,187,203,
+203,154,24,68,53,36,18,0,0,16,17,1,202,220,170,9,
+83,52,35,129,185,203,186,188,206,205,203,171,170,8,32,67,
+67,67,83,51,51,19,129,186,189,188,172,187,170,136,65,68,
+52,52,50,50,34,17,160,235,189,188,187,154,9,8,128,1,
+51,54,37,2,168,189,188,170,136,17,17,17,82,85,68,50,
+18,185,221,188,203,187,187,187,172,137,33,70,68,52,67,51,
+35,34,0,152,202,203,204,203,187,188,170,137,0,34,35,34,
+33,66,68,67,34,0,152,8,67,69,51,18,168,219,187,203,
+204,204,219,187,170,9,49,83,51,52,68,67,35,18,152,218,
+203,172,171,187,187,170,48,71,68,51,50,17,17,16,0,184,
+222,204,188,170,153,0,1,17,8,16,82,52,53,50,17,8,
+136,17,83,52,68,34,34,145,202,206,188,189,203,202,186,171,
+170,24,99,68,67,67,34,35,33,1,144,201,188,173,171,170,
+154,153,169,136,48,69,51,1,203,190,172,137,32,67,35,50,
+99,68,68,36,34,129,169,204,203,187,172,187,186,138,16,52,
+54,51,36,34,0,168,204,205,187,187,154,24,66,52,53,52,
+68,35,35,2,153,203,188,188,203,203,172,170,137,33,67,35,
+18,128,136,16,66,34,129,154,57,119,54,53,51,35,0,185,
+220,188,189,188,187,187,171,137,33,99,68,83,51,35,19,129,
+152,186,187,203,203,203,203,154,24,66,52,36,18,144,186,188,
+204,186,187,170,8,83,69,83,51,52,50,17,152,204,220,187,
+203,170,137,16,49,83,67,35,51,34,128,202,220,219,187,187,
+171,24,82,53,53,51,35,51,34,18,144,235,205,219,186,170,
+153,16,50,83,51,51,51,2,160,205,220,202,170,154,9,33,
+68,68,51,36,34,128,186,221,203,187,172,155,138,16,50,84,
+67,67,36,51,35,1,185,204,187,171,153,128,1,0,1,50,
+69,67,2,234,205,189,172,171,154,16,50,69,52,51,51,51,
+18,1,169,236,204,203,187,154,24,67,67,35,2,128,152,170,
+219,219,188,187,155,40,84,69,67,52,51,35,18,152,218,188,
+188,172,187,187,171,171,137,49,69,51,19,144,218,203,171,154,
+32,84,69,52,52,51,51,34,1,152,251,204,188,188,170,153,
+16,34,52,67,50,18,18,0,153,235,219,186,155,24,66,53,
+83,51,51,18,201,206,189,188,186,171,170,170,137,65,84,52,
+52,51,51,35,0,169,171,139,49,70,52,51,51,35,35,1,
+185,223,204,189,189,187,154,24,66,51,36,17,18,35,18,168,
+221,188,188,172,171,137,16,68,52,36,18,0,153,185,203,204,
+187,172,170,9,49,71,68,67,51,35,18,16,8,153,186,204,
+170,9,32,33,144,202,187,235,204,206,188,189,186,154,8,33,
+68,83,51,51,35,35,17,152,235,204,188,187,171,170,8,33,
+69,51,51,17,128,16,50,69,34,2,33,99,84,67,51,35,
+128,217,204,204,203,171,155,138,0,50,68,67,67,35,35,18,
+160,220,205,203,187,154,8,17,34,34,51,52,36,35,18,1,
+136,186,187,57,119,53,52,20,2,168,219,188,188,188,171,170,
+154,24,66,70,52,37,35,2,129,169,187,205,203,203,170,137,
+8,32,66,66,35,35,18,136,170,203,203,171,10,114,84,67,
+50,1,144,202,219,204,187,203,154,137,0,67,69,68,67,35,
+17,144,185,219,187,173,187,171,170,137,0,51,55,52,35,2,
+153,187,172,153,24,65,68,68,34,18,144,168,186,235,220,203,
+172,170,9,48,69,52,37,51,17,128,185,187,188,188,188,188,
+203,169,8,48,68,52,51,18,152,203,170,24,68,67,35,18,
+1,136,153,203,219,204,204,204,203,154,8,50,84,51,67,50,
+17,129,169,186,171,203,203,172,155,9,34,67,83,50,35,160,
+221,204,155,137,50,68,52,51,34,144,203,189,187,203,188,205,
+187,170,16,84,52,37,51,34,0,170,203,170,170,170,188,187,
+10,82,68,67,50,18,160,221,189,203,138,8,33,67,67,83,
+51,35,34,16,136,219,206,203,187,138,16,67,51,52,35,18,
+169,205,188,171,172,204,187,170,16,69,68,51,67,18,1,185,
+188,172,153,153,169,186,155,81,69,67,51,20,1,169,205,188,
+170,8,34,51,52,67,50,35,18,136,187,221,221,219,171,155,
+9,49,68,67,50,35,129,153,154,171,188,219,203,188,170,137,
+24,83,69,35,19,0,185,203,10,65,50,68,51,19,128,32,
+51,99,68,3,217,189,188,187,155,25,33,50,84,18,144,137,
+50,18,168,237,206,204,170,170,170,24,52,52,51,51,35,52,
+69,18,144,152,170,204,187,154,32,84,52,1,169,170,136,154,
+9,83,68,52,51,18,83,55,52,1,201,204,188,188,172,187,
+154,8,1,8,16,83,53,53,34,18,17,144,218,203,170,0,
+18,130,202,188,154,128,0,82,70,52,67,33,17,67,69,35,
+18,1,144,219,189,205,171,171,170,186,188,154,136,17,68,83,
+67,36,19,144,170,186,202,187,171,171,172,153,168,170,96,55,
+52,50,50,34,50,84,67,67,52,36,2,169,187,189,173,187,
+203,186,155,137,136,64,85,67,35,34,1,186,219,203,204,171,
+171,187,189,171,155,137,66,68,52,67,67,35,51,53,67,34,
+18,128,186,189,188,187,171,136,153,219,172,138,24,66,53,53,
+37,36,1,128,136,128,185,223,204,203,172,187,172,154,9,34,
+51,67,67,52,36,35,17,17,17,128,202,188,154,32,50,1,
+202,204,203,188,189,170,49,70,52,50,67,67,67,18,129,169,
+188,220,219,172,155,138,128,1,0,16,34,35,1,0,66,52,
+2,202,172,25,99,51,18,152,152,152,219,187,64,103,67,34,
+1,16,66,36,51,50,52,52,130,186,189,137,17,145,203,173,
+137,136,32,100,85,52,34,128,169,203,187,189,170,138,137,153,
+171,138,82,84,67,50,34,152,205,188,171,138,137,137,170,203,
+204,204,170,8,18,130,185,205,187,172,154,40,84,52,35,1,
+185,204,189,204,203,203,203,186,154,9,33,69,83,51,35,129,
+152,153,153,169,170,137,33,130,250,204,170,154,235,204,172,155,
+8,49,84,83,51,51,18,136,137,32,68,52,51,34,34,18,
+169,190,173,171,204,219,171,41,85,53,36,51,51,19,128,186,
+154,49,54,52,50,52,36,19,152,203,202,235,219,172,171,8,
+33,68,67,51,35,129,185,188,171,154,137,136,144,169,189,204,
+188,204,203,187,188,186,154,32,100,52,35,18,128,169,220,187,
+171,25,49,36,17,17,1,201,206,204,170,186,186,187,137,49,
+38,2,144,185,221,220,203,187,154,9,0,33,67,51,19,1,
+169,188,207,204,188,189,203,186,154,153,136,17,66,51,52,67,
+52,52,51,33,17,49,52,67,51,36,161,237,189,173,187,154,
+136,50,54,53,36,51,36,35,35,17,128,136,137,8,33,68,
+67,35,144,235,188,155,48,86,68,52,37,51,34,1,128,169,
+187,205,186,170,153,8,33,52,52,18,144,153,170,25,117,69,
+68,51,50,18,144,235,204,203,186,187,187,155,9,33,34,50,
+52,20,145,203,171,137,32,50,68,52,145,222,205,188,188,187,
+172,170,137,128,17,34,51,51,18,152,235,204,188,186,153,137,
+153,219,220,204,204,187,187,154,137,32,67,53,52,52,50,34,
+34,0,169,203,154,24,50,53,52,1,202,207,203,171,153,16,
+83,68,68,51,51,67,34,34,16,152,169,137,16,83,69,51,
+36,1,168,203,203,153,48,70,53,52,52,35,35,1,144,170,
+219,187,187,139,32,54,53,36,35,1,152,186,171,32,87,68,
+67,51,51,1,185,221,203,188,187,203,170,152,16,50,51,36,
+19,152,204,204,186,137,40,50,52,20,176,222,204,188,188,187,
+187,170,137,24,50,68,51,34,144,219,220,203,187,170,136,8,
+128,169,220,205,219,186,170,153,8,34,69,67,67,50,35,17,
+144,203,204,170,154,16,66,67,18,145,202,189,172,154,32,99,
+52,53,52,67,50,18,18,0,169,186,155,32,69,54,68,50,
+18,0,153,170,171,154,48,55,37,35,50,67,35,1,137,8,
+18,1,33,119,68,36,35,34,34,0,201,187,155,9,128,136,
+33,35,216,206,186,152,152,187,138,82,51,18,83,55,20,168,
+220,188,188,189,188,153,136,0,136,137,128,201,204,172,170,186,
+205,187,171,154,153,153,169,235,222,204,187,172,154,9,48,67,
+36,35,18,1,136,169,187,205,187,188,154,16,50,51,161,239,
+205,203,187,153,32,84,52,52,35,18,0,136,169,187,186,169,
+152,0,99,68,35,144,251,188,189,171,137,83,70,67,67,34,
+17,136,169,187,187,187,153,9,34,52,50,17,169,222,188,173,
+137,49,87,83,52,51,51,18,152,185,188,187,171,9,33,51,
+34,0,186,221,204,172,154,24,83,69,68,67,35,2,152,218,
+219,188,187,170,153,136,136,136,185,220,219,171,170,153,24,50,
+71,67,51,35,2,168,236,188,188,170,153,16,66,67,36,17,
+136,137,137,136,0,82,84,51,51,33,17,176,238,189,189,186,
+171,155,8,67,36,19,128,152,186,188,173,137,33,34,1,17,
+50,145,223,204,186,203,203,138,65,54,53,67,50,35,17,152,
+153,8,33,33,50,52,20,144,219,203,187,189,188,170,40,83,
+69,83,50,35,1,184,219,188,187,170,154,9,136,152,203,205,
+202,170,154,9,66,85,67,52,67,35,35,0,168,170,188,187,
+154,65,68,35,19,129,201,205,187,155,24,83,53,68,50,18,
+17,152,187,189,204,186,171,138,49,68,51,35,144,220,188,170,
+8,82,69,67,18,128,153,187,189,170,8,33,18,66,51,19,
+176,221,220,204,219,170,138,16,66,52,34,1,202,205,203,170,
+137,0,17,34,17,185,205,188,188,188,203,169,136,16,67,52,
+35,1,185,205,188,154,32,53,53,51,35,144,206,204,188,187,
+172,138,8,34,52,52,36,1,0,152,170,170,153,16,50,68,
+52,35,18,201,221,188,188,171,9,99,68,52,67,50,35,34,
+34,67,67,34,33,34,2,128,8,1,251,205,187,171,154,81,
+87,67,51,51,51,1,169,171,154,203,172,10,0,0,16,83,
+19,251,189,187,203,154,81,69,52,35,35,18,168,204,170,169,
+186,188,153,169,204,172,170,185,204,171,137,33,52,55,53,35,
+129,185,220,204,203,170,169,153,137,136,169,204,187,172,186,187,
+25,69,51,50,67,51,160,205,187,188,204,188,170,154,187,187,
+169,185,206,186,136,16,67,71,52,36,17,0,152,219,171,138,
+153,153,153,136,201,187,24,54,53,68,83,50,36,52,67,51,
+51,19,2,152,137,32,67,51,35,144,204,189,137,84,70,52,
+68,50,34,18,18,17,0,17,1,152,153,136,184,221,187,203,
+220,187,25,84,52,69,67,51,1,128,144,186,188,138,8,152,
+170,153,250,220,171,171,203,186,9,50,53,83,67,51,129,202,
+219,235,203,172,171,187,203,187,186,204,203,171,170,170,137,33,
+51,35,18,145,220,205,188,204,203,203,172,171,171,169,137,0,
+1,152,137,16,51,71,85,51,51,33,1,168,204,186,186,188,
+188,186,187,155,64,69,83,67,36,35,50,53,51,36,50,35,
+184,204,154,186,188,25,34,168,156,65,37,50,87,53,51,50,
+52,51,1,16,35,130,154,48,51,152,57,87,2,136,49,69,
+67,85,68,36,51,51,34,129,152,169,187,155,9,1,16,50,
+177,207,172,170,203,10,115,67,67,67,35,128,203,203,189,205,
+170,154,186,171,154,201,188,172,170,203,187,40,34,17,83,51,
+216,190,203,203,188,187,154,202,203,170,169,188,170,0,0,153,
+16,35,144,155,32,177,255,173,187,204,171,171,170,203,219,203,
+171,155,9,81,84,51,51,18,1,168,219,154,24,0,8,82,
+52,1,32,69,34,0,98,68,52,83,68,67,18,34,33,129,
+136,16,51,52,52,69,51,35,50,52,35,50,99,51,67,68,
+83,35,51,51,1,169,188,188,204,153,32,51,68,52,20,129,
+169,185,204,203,137,17,17,33,35,232,206,187,204,187,187,9,
+16,33,83,35,160,204,187,220,172,138,17,0,16,17,248,205,
+187,170,172,139,33,19,128,32,130,206,156,8,152,203,136,177,
+238,187,170,203,173,10,136,168,137,34,200,204,154,185,190,138,
+50,18,0,52,178,255,186,153,186,138,82,52,18,34,51,184,
+173,40,51,51,103,36,19,16,17,129,187,9,66,34,84,54,
+36,33,33,18,144,25,82,67,50,53,37,0,153,137,169,156,
+56,55,35,51,52,2,219,155,0,153,41,103,19,129,16,129,
+250,172,137,144,153,65,38,2,16,50,160,189,11,128,187,57,
+103,1,8,0,184,207,170,152,170,10,82,18,128,16,145,222,
+171,153,185,172,8,145,218,155,170,206,172,170,187,188,153,8,
+144,0,18,160,205,203,186,188,170,0,128,154,138,202,205,171,
+25,0,17,69,52,19,67,69,34,34,52,20,1,33,51,17,
+49,69,17,8,99,67,34,84,52,19,32,34,129,138,81,67,
+33,99,35,129,153,0,184,156,98,52,35,100,67,17,0,33,
+145,172,25,19,152,112,68,17,136,33,145,204,9,34,2,99,
+70,18,0,17,145,204,138,17,184,10,67,208,190,138,169,204,
+9,50,145,154,33,208,207,137,0,186,9,50,176,174,137,250,
+204,170,185,202,138,17,1,136,17,184,239,138,8,152,49,70,
+19,129,1,168,206,156,138,154,138,49,36,128,32,18,251,139,
+65,18,66,70,35,0,0,145,219,170,8,201,170,0,176,190,
+9,129,202,72,54,18,66,38,2,153,0,185,189,24,50,0,
+17,130,254,172,154,136,24,85,52,34,33,18,168,187,137,185,
+10,116,35,33,51,19,219,173,171,170,24,102,67,50,34,130,
+202,188,171,187,10,67,34,16,35,234,189,153,170,140,81,36,
+17,66,2,251,172,153,203,171,49,3,186,56,132,223,138,34,
+145,24,87,1,137,40,129,189,139,0,217,139,50,3,187,81,
+131,221,138,34,145,56,87,18,137,8,160,205,154,8,152,138,
+33,2,219,9,1,201,138,68,19,16,69,19,152,153,185,190,
+171,154,136,16,0,0,17,0,115,70,52,67,51,67,17,136,
+8,168,205,10,1,152,56,55,145,140,32,129,25,119,36,34,
+49,2,184,188,171,186,155,40,35,201,172,186,205,155,17,18,
+99,68,34,50,51,160,187,205,190,172,153,153,138,0,217,220,
+170,186,170,41,84,35,34,17,192,205,171,169,169,40,51,129,
+203,220,205,172,153,153,24,50,35,1,152,204,203,154,9,81,
+68,67,51,50,18,200,188,203,187,156,64,37,34,50,3,251,
+187,9,17,115,54,37,34,16,1,168,171,40,50,34,100,35,
+160,186,136,203,157,49,38,34,84,67,18,16,18,145,171,10,
+2,152,80,52,200,189,186,205,172,9,17,33,82,34,168,188,
+203,219,170,24,33,128,152,218,191,188,170,187,138,8,152,171,
+202,220,188,171,187,188,170,136,152,16,51,129,190,188,204,188,
+10,34,35,67,3,250,174,187,186,154,49,69,34,35,34,128,
+8,65,53,52,53,67,33,17,34,129,32,17,171,141,33,34,
+117,53,36,17,34,129,170,65,54,52,84,51,2,8,128,152,
+155,114,52,18,50,36,184,172,8,145,154,116,36,1,50,53,
+2,8,66,128,172,24,3,169,48,5,252,188,186,189,172,137,
+17,0,33,3,235,188,171,172,171,16,19,152,187,222,205,203,
+170,170,153,0,128,153,186,188,190,171,153,9,16,66,18,129,
+185,236,204,171,171,154,48,69,50,129,185,207,204,154,8,34,
+69,67,18,1,128,136,9,69,38,51,67,18,128,154,169,186,
+138,99,51,67,69,35,18,50,67,16,65,54,36,51,37,1,
+170,188,204,172,137,16,49,83,51,2,152,136,0,0,102,68,
+18,17,1,217,189,170,187,172,25,16,128,16,1,185,172,9,
+128,153,139,169,255,175,171,219,172,171,169,186,138,0,169,155,
+8,202,171,82,68,51,68,18,184,220,203,187,155,40,84,83,
+51,36,34,16,0,16,49,53,53,52,34,129,169,220,204,170,
+154,138,17,67,51,51,34,129,169,171,202,203,171,219,203,187,
+188,154,153,40,98,66,66,52,53,99,67,52,52,67,34,17,
+128,186,204,171,187,171,16,17,17,35,248,220,186,189,188,154,
+153,137,33,130,185,236,220,204,187,187,155,137,33,52,52,35,
+17,136,170,9,115,84,99,51,52,50,34,18,17,17,33,16,
+32,18,169,10,52,50,101,37,144,186,220,205,171,138,136,48,
+68,2,169,236,204,203,171,154,8,33,34,67,2,169,9,128,
+170,115,37,1,66,36,2,82,36,1,0,160,236,170,136,9,
+82,37,18,17,168,207,170,187,187,25,17,153,32,192,207,153,
+160,170,40,130,204,138,185,189,56,68,49,68,2,201,171,203,
+155,114,53,68,67,18,129,136,186,172,0,33,65,37,146,170,
+170,220,170,32,18,49,36,145,153,16,1,115,36,144,188,222,
+188,172,153,153,33,50,18,16,144,203,138,49,85,53,36,35,
+1,169,172,187,172,138,144,185,170,219,172,64,85,83,52,51,
+16,153,204,187,138,16,98,51,130,201,220,173,171,136,32,84,
+51,18,2,152,187,137,1,64,52,146,235,203,204,170,0,34,
+67,36,144,169,187,173,49,55,67,52,2,186,189,204,187,137,
+8,16,49,168,188,203,189,10,50,35,84,19,201,171,202,172,
+41,36,1,8,251,191,156,154,137,82,51,34,3,200,189,138,
+9,98,68,35,17,128,203,171,136,32,84,51,0,169,218,187,
+40,84,67,52,18,128,152,154,24,70,67,67,34,144,170,187,
+189,138,1,17,49,146,221,170,186,139,115,36,50,36,144,187,
+153,169,88,54,3,170,220,206,187,170,137,40,35,144,188,220,
+203,10,33,67,67,18,186,173,203,170,16,18,160,235,221,188,
+170,137,24,50,35,144,170,203,155,114,53,52,51,3,160,170,
+186,138,81,51,19,129,235,189,138,16,100,68,67,34,34,1,
+8,33,68,68,52,34,129,169,205,187,138,24,66,37,2,144,
+187,189,10,82,68,68,18,129,153,187,172,25,49,51,35,234,
+206,187,172,137,50,67,36,130,201,188,187,154,66,53,51,1,
+234,189,188,170,9,33,35,1,202,206,172,154,24,49,53,17,
+169,204,189,170,24,33,83,19,184,204,219,171,8,50,68,51,
+2,170,203,188,137,82,51,52,35,168,203,170,154,98,69,34,
+35,130,185,171,153,72,71,36,34,2,184,189,170,137,80,53,
+51,33,144,251,170,136,40,115,35,1,136,218,172,137,16,66,
+67,130,169,219,188,154,33,99,67,18,128,186,189,155,25,66,
+53,20,17,168,203,171,136,49,55,20,17,152,219,170,8,33,
+70,35,128,185,205,172,9,32,83,36,128,169,235,172,137,0,
+33,51,160,205,188,188,138,17,17,2,234,188,188,171,32,83,
+34,3,217,189,171,171,32,53,1,0,250,188,138,136,32,54,
+129,153,169,190,25,52,51,70,2,170,170,188,140,50,36,50,
+19,251,171,170,154,97,36,18,33,169,189,9,16,84,68,2,
+128,185,204,170,24,66,68,34,145,201,171,171,40,86,51,51,
+2,185,172,137,48,71,52,17,128,218,187,138,33,115,52,2,
+136,185,205,137,33,51,54,3,168,187,204,155,48,67,50,2,
+236,188,187,154,48,53,19,128,251,188,156,137,16,67,18,160,
+235,219,171,136,17,35,19,200,205,203,154,24,67,51,18,200,
+205,171,138,32,69,35,1,168,204,171,9,66,52,37,129,153,
+187,155,56,55,52,51,145,218,171,155,64,84,51,35,128,203,
+188,138,32,69,51,19,168,204,187,137,65,68,35,1,202,189,
+186,25,82,52,51,129,218,188,155,9,83,52,35,128,203,204,
+154,0,67,52,17,168,220,187,154,48,99,51,1,202,205,187,
+154,40,66,36,129,203,204,187,138,33,67,51,128,220,203,154,
+25,68,67,18,144,218,187,153,65,68,52,18,136,186,187,25,
+99,68,50,1,169,187,155,32,69,52,17,185,205,203,153,32,
+50,36,145,218,219,186,137,32,51,34,144,221,171,154,40,68,
+51,1,202,189,172,8,67,68,20,1,170,219,171,25,65,67,
+18,184,205,188,155,9,49,35,176,207,204,171,138,33,52,34,
+160,190,173,155,24,83,36,18,144,187,171,56,86,68,50,1,
+136,153,24,84,53,52,34,128,153,154,40,84,52,35,1,170,
+188,155,16,68,35,129,235,204,171,154,16,34,1,218,205,188,
+171,153,16,17,129,203,204,172,139,24,33,51,130,203,189,187,
+9,83,68,34,130,201,219,170,137,65,83,18,128,219,188,172,
+137,0,18,160,236,204,187,154,8,34,1,201,205,188,154,16,
+82,51,18,152,187,155,114,84,51,35,129,136,25,115,68,52,
+50,1,136,8,49,86,67,34,17,152,153,0,83,37,19,129,
+203,188,154,24,67,35,144,221,204,170,153,16,34,129,202,189,
+173,138,16,50,18,160,251,203,170,24,65,52,17,152,234,203,
+153,9,50,52,2,169,206,172,170,24,65,18,145,220,205,170,
+138,16,51,3,184,223,172,155,9,49,36,2,185,206,170,137,
+82,83,18,1,170,187,25,115,68,36,17,136,170,137,48,69,
+52,34,128,185,171,8,99,52,34,152,203,188,154,33,67,20,
+176,235,203,171,8,17,18,160,205,203,170,25,34,34,128,220,
+172,138,40,69,51,34,128,170,9,66,86,67,18,17,152,9,
+49,68,52,35,136,203,204,154,128,49,35,184,206,220,171,154,
+136,16,129,202,235,188,154,137,16,19,176,220,189,172,137,32,
+68,34,0,185,204,154,33,84,52,18,128,170,171,65,85,67,
+19,144,202,203,138,48,83,35,144,205,188,171,24,50,36,146,
+220,204,170,10,49,35,3,218,205,186,9,82,67,34,128,203,
+187,139,65,69,35,2,168,187,9,84,69,51,18,160,203,170,
+16,69,52,18,128,186,171,41,84,68,18,152,188,173,154,16,
+67,35,129,219,188,171,16,68,51,130,234,204,186,137,49,52,
+34,152,204,172,137,50,68,19,160,220,188,170,24,67,51,18,
+185,220,154,9,51,36,145,251,204,170,137,32,67,18,128,187,
+173,137,16,51,131,234,204,187,138,49,68,51,18,128,153,24,
+67,52,35,144,203,169,33,87,68,50,52,50,51,52,34,34,
+136,169,137,41,68,52,52,50,66,67,52,51,129,251,188,189,
+170,137,9,1,144,171,203,186,136,144,234,236,188,188,172,155,
+153,8,16,2,18,18,137,137,186,138,144,221,205,190,188,138,
+56,85,51,35,144,220,187,171,136,1,184,238,219,171,10,33,
+53,34,168,220,172,154,16,51,36,144,219,172,25,115,52,35,
+2,169,187,10,115,53,51,2,168,187,25,101,68,51,17,152,
+171,154,49,55,36,1,201,203,155,24,68,51,1,202,205,171,
+137,17,51,1,219,189,172,137,34,67,18,168,205,187,154,32,
+67,35,144,188,188,155,40,67,34,1,201,188,170,170,153,186,
+172,154,156,170,237,204,187,156,24,18,18,233,207,203,170,137,
+50,67,18,201,204,171,25,115,51,35,145,219,171,24,100,68,
+34,2,152,171,137,66,54,36,18,168,186,171,48,85,67,1,
+152,203,156,9,33,51,3,235,188,173,138,16,34,19,185,190,
+172,155,17,35,18,200,205,171,9,66,69,34,1,168,170,8,
+83,69,51,18,128,153,32,83,53,37,129,152,219,171,136,16,
+50,130,234,204,204,154,152,0,17,169,203,205,187,138,8,49,
+130,219,220,188,155,0,66,52,18,152,235,171,24,66,69,35,
+1,168,186,26,84,53,52,1,169,204,170,8,66,67,2,201,
+189,188,153,33,51,35,217,205,172,154,24,51,50,160,221,172,
+155,32,53,36,2,184,188,187,24,84,52,34,128,186,155,64,
+85,52,35,1,186,172,10,50,71,34,2,153,187,138,65,84,
+51,129,186,191,171,136,50,68,2,168,204,187,10,65,52,35,
+168,206,172,155,24,51,52,130,201,204,154,24,52,52,1,202,
+205,171,138,49,52,35,145,219,187,154,48,53,19,201,206,203,
+154,8,51,51,2,185,189,156,8,50,51,168,206,188,171,16,
+67,53,18,129,137,137,50,53,51,145,234,171,10,82,69,36,
+51,34,33,67,67,50,2,168,188,172,10,66,99,51,34,19,
+35,34,20,145,250,235,187,172,153,25,17,34,35,18,8,168,
+206,219,219,203,187,203,186,186,137,48,115,51,19,145,218,188,
+171,153,137,185,222,187,171,48,87,67,34,129,186,188,171,9,
+1,168,221,204,154,16,84,67,18,144,203,172,138,32,51,130,
+234,188,155,65,85,67,18,152,203,171,8,82,36,18,169,204,
+170,48,85,52,18,144,203,171,25,82,52,2,184,205,171,8,
+83,52,18,160,204,172,153,33,67,2,185,221,186,9,50,53,
+19,176,220,187,138,33,37,18,184,205,187,9,66,68,18,144,
+188,203,9,65,51,35,185,221,171,9,67,53,18,144,203,172,
+9,50,68,1,184,205,171,8,82,52,34,144,187,172,9,67,
+37,2,185,205,155,24,83,52,19,144,203,187,9,82,67,17,
+186,205,154,24,84,67,18,144,187,173,137,32,50,145,235,189,
+171,24,99,67,34,144,202,187,154,33,67,18,202,205,171,8,
+68,52,35,152,235,203,154,0,50,34,152,203,171,49,103,51,
+35,144,219,188,171,8,33,17,184,205,170,41,85,67,19,144,
+219,203,138,16,67,34,144,203,171,41,85,67,18,185,190,173,
+153,32,66,34,129,169,154,81,69,67,2,168,189,172,138,16,
+50,19,169,189,171,48,101,35,2,201,188,172,8,66,67,2,
+152,203,154,32,68,35,176,237,187,156,24,50,67,1,168,186,
+24,100,52,35,161,235,203,154,32,66,18,144,188,188,9,67,
+53,18,160,204,171,9,83,68,18,144,185,170,24,52,37,128,
+204,204,170,136,34,51,1,185,203,8,100,52,51,145,202,203,
+138,32,51,1,251,189,187,9,65,51,3,201,204,170,16,68,
+36,2,169,203,138,64,52,36,144,235,203,155,9,32,1,185,
+189,156,24,69,52,50,0,152,153,32,52,35,200,221,188,154,
+8,49,35,128,202,155,56,86,67,18,128,186,187,32,85,52,
+34,129,169,171,154,0,144,251,189,189,170,24,99,67,51,51,
+33,34,34,35,130,251,205,203,171,154,128,1,152,185,171,64,
+85,52,18,184,205,187,138,49,53,2,185,191,171,24,83,35,
+168,207,204,170,8,33,36,18,129,137,48,69,37,34,168,204,
+188,155,137,17,16,152,154,25,85,68,51,17,152,170,136,66,
+67,2,168,188,139,65,69,35,129,219,188,155,9,34,34,0,
+138,48,119,52,52,35,2,152,185,203,219,219,187,188,154,8,
+34,36,34,16,16,82,83,50,144,220,204,170,8,49,51,129,
+221,188,172,137,33,34,160,236,203,154,40,68,36,17,152,170,
+136,83,52,35,184,191,173,154,16,33,18,152,203,9,115,68,
+51,2,169,204,154,16,52,34,144,204,187,8,84,52,19,144,
+204,187,137,49,53,18,184,219,155,56,85,51,18,168,219,171,
+137,33,34,144,204,188,10,82,53,36,129,169,172,155,137,128,
+217,220,172,170,32,84,35,19,152,203,154,16,51,130,236,190,
+203,137,33,52,19,160,235,171,136,66,35,130,203,188,26,115,
+52,20,1,169,171,10,33,19,201,222,187,138,49,84,50,1,
+152,8,99,68,35,1,185,173,155,8,18,1,203,189,171,40,
+53,36,128,186,187,26,69,68,18,0,8,32,68,35,145,206,
+189,203,154,137,136,152,154,9,98,68,51,34,128,169,137,16,
+1,216,236,203,171,153,137,169,188,173,154,48,68,36,17,136,
+136,49,85,50,18,128,154,137,17,130,250,206,188,171,138,32,
+82,66,51,53,68,51,35,1,169,172,171,154,153,186,187,156,
+40,69,36,3,128,170,9,84,53,36,18,128,137,8,18,18,
+217,221,188,187,154,9,137,219,204,187,153,66,54,68,18,2,
+152,169,170,203,220,204,188,187,154,32,83,51,18,152,186,138,
+32,35,192,238,187,154,65,69,50,128,202,188,154,32,51,19,
+217,188,139,98,69,35,1,170,187,25,84,52,3,184,190,154,
+40,68,35,128,186,171,81,70,36,1,185,189,155,25,66,34,
+160,202,154,98,68,36,129,185,188,171,24,51,19,201,205,154,
+40,52,20,144,204,187,138,49,53,2,186,190,154,32,52,18,
+184,206,170,9,34,18,218,190,173,155,8,33,34,17,33,84,
+83,35,130,201,188,188,155,154,170,186,138,98,85,67,34,0,
+153,154,16,50,35,184,191,171,48,71,67,34,0,136,0,51,
+36,145,236,203,170,9,34,36,51,68,68,53,35,18,185,190,
+188,171,170,153,154,10,81,85,52,51,18,153,188,188,187,219,
+187,173,154,24,83,67,34,1,152,137,136,168,236,189,189,171,
+137,16,51,51,35,35,52,67,18,200,221,204,203,171,170,24,
+81,99,51,36,19,2,0,153,187,221,203,187,170,24,68,68,
+67,50,34,17,0,152,202,203,203,154,9,16,51,54,68,67,
+35,34,128,185,188,189,187,188,187,171,16,84,68,50,35,35,
+34,2,202,223,188,188,170,9,32,35,35,18,50,68,51,145,
+252,204,203,170,153,0,17,18,51,53,67,18,144,203,188,186,
+170,203,204,187,138,81,69,51,19,129,137,9,33,34,168,207,
+172,155,32,53,68,34,34,34,51,18,200,205,188,155,9,49,
+67,35,51,85,83,51,19,144,219,188,187,171,153,136,24,66,
+99,51,35,17,0,16,18,184,255,189,203,154,16,66,35,1,
+153,170,24,65,18,201,191,189,170,137,16,34,51,52,52,20,
+145,220,188,172,154,0,128,184,188,156,49,87,67,34,1,153,
+154,153,152,185,206,203,187,153,0,18,50,84,69,52,51,3,
+185,205,170,9,49,34,144,189,172,25,83,37,18,152,203,171,
+10,49,51,67,50,99,52,50,0,185,138,98,68,18,218,191,
+189,170,8,33,51,18,17,66,85,52,51,2,185,190,173,171,
+171,171,154,24,83,68,50,2,128,136,40,50,19,233,221,187,
+171,24,67,50,0,185,172,153,16,18,153,205,188,188,186,170,
+40,86,70,67,51,2,168,188,189,187,187,188,187,172,25,99,
+84,67,51,35,1,144,185,204,187,203,154,138,136,128,128,33,
+69,69,51,51,0,169,172,155,8,16,1,168,169,17,86,52,
+51,2,201,221,204,188,188,170,137,65,68,52,67,34,18,0,
+152,202,204,204,187,172,170,136,33,52,52,51,51,17,1,152,
+153,186,219,188,204,186,170,137,33,68,52,50,129,201,188,188,
+170,136,1,128,0,83,103,83,36,35,129,185,220,187,172,170,
+154,137,32,84,52,52,51,34,1,0,152,202,189,189,172,137,
+16,51,35,1,152,9,82,68,51,1,169,203,170,168,184,218,
+187,136,53,54,17,186,191,188,153,0,144,217,219,154,65,70,
+67,19,129,185,188,187,186,186,188,188,187,9,49,68,51,66,
+66,51,52,18,144,201,169,152,145,250,205,189,171,138,33,68,
+50,19,17,17,17,19,0,154,171,96,115,52,51,18,1,128,
+169,220,205,204,187,138,32,68,52,36,33,17,34,51,36,2,
+168,220,188,187,172,186,170,170,137,17,53,53,53,51,36,18,
+136,189,205,187,171,138,17,20,19,1,169,171,188,203,204,204,
+187,187,8,68,68,51,18,145,184,187,203,186,188,204,186,153,
+10,137,138,155,73,117,53,53,51,35,18,128,153,251,235,203,
+203,154,24,66,83,51,51,36,34,35,0,185,220,203,153,8,
+33,33,0,152,24,34,51,177,223,188,154,1,52,51,0,137,
+81,71,53,36,17,168,219,203,172,188,188,173,186,137,49,53,
+53,51,51,18,2,185,220,219,187,171,137,16,34,17,0,33,
+17,128,234,222,187,170,16,100,83,34,17,17,0,16,18,136,
+171,221,188,186,202,171,154,137,49,103,35,52,67,18,18,1,
+201,188,189,173,170,128,33,68,36,34,18,1,170,187,221,186,
+137,136,32,52,19,50,20,168,172,251,189,170,137,24,84,36,
+33,33,145,169,137,218,186,144,202,157,185,252,170,153,171,25,
+66,50,87,51,67,36,19,128,168,205,173,171,186,154,24,0,
+48,36,17,48,35,136,114,36,35,70,51,50,67,129,202,203,
+221,187,171,187,139,16,0,65,52,34,98,51,34,69,52,34,
+36,18,169,187,207,188,203,187,172,137,8,49,54,51,67,51,
+16,16,129,169,9,145,155,48,193,207,186,206,172,154,185,137,
+34,35,85,68,18,50,18,168,137,169,187,9,184,191,170,235,
+188,154,187,172,17,67,85,53,20,35,35,136,153,218,189,172,
+186,187,9,1,32,67,18,16,52,35,65,69,19,83,52,19,
+33,145,221,203,203,188,170,169,169,16,35,67,53,20,33,50,
+19,66,53,18,17,130,250,187,220,204,171,187,172,138,16,33,
+53,37,49,66,18,16,34,1,16,67,129,25,152,207,188,202,
+188,155,152,9,98,52,66,52,35,1,1,168,187,154,217,138,
+1,201,171,217,221,187,187,189,154,128,16,115,36,34,67,2,
+136,137,218,187,153,169,9,37,0,24,19,201,42,52,16,102,
+36,34,83,18,0,8,202,174,170,202,153,33,33,65,36,129,
+137,184,206,154,137,137,98,51,35,51,161,206,187,205,172,170,
+154,137,50,52,83,51,128,169,218,188,155,154,138,33,19,18,
+129,237,173,187,188,25,81,99,83,67,67,50,35,2,1,136,
+9,17,51,70,51,35,34,161,234,185,204,171,136,136,49,38,
+144,185,252,220,187,188,204,170,186,186,153,186,188,170,220,171,
+152,152,49,55,52,99,51,35,51,19,0,48,34,80,85,36,
+66,83,18,34,34,1,136,17,169,41,36,168,24,192,239,171,
+235,188,171,219,171,170,185,171,153,234,171,153,219,139,8,169,
+56,53,17,114,19,8,65,19,32,101,51,83,68,35,51,68,
+17,17,18,128,8,19,136,56,4,204,154,201,206,170,203,173,
+154,169,171,9,202,172,168,205,156,153,187,140,152,186,9,2,
+153,81,130,171,100,36,67,54,20,35,53,18,17,19,128,40,
+34,185,72,54,18,51,20,152,137,250,173,154,202,172,136,184,
+155,153,236,155,169,220,187,186,189,137,8,170,25,51,51,68,
+51,85,69,18,33,35,129,9,33,184,172,9,153,104,70,52,
+67,51,17,17,129,218,187,186,186,204,187,26,35,200,171,234,
+239,171,170,186,187,154,154,9,99,83,66,34,33,50,17,136,
+169,185,154,251,207,9,1,144,82,54,18,50,69,18,18,1,
+168,154,186,187,153,205,10,69,128,169,152,190,139,185,223,138,
+1,153,32,53,16,83,19,137,8,234,173,137,202,171,152,220,
+138,50,2,48,52,17,86,35,1,65,19,136,0,250,172,32,
+145,187,32,200,172,50,3,137,1,235,155,66,83,83,35,82,
+67,128,154,0,234,155,136,222,172,8,1,153,16,19,153,40,
+53,146,138,115,19,152,8,200,190,24,130,206,155,8,170,9,
+99,18,136,97,36,168,11,84,1,9,51,161,174,40,18,136,
+17,249,156,48,35,0,82,68,18,128,9,16,128,97,20,250,
+171,8,160,155,136,251,173,153,170,10,50,3,48,71,19,128,
+24,52,19,202,219,204,171,9,145,188,9,17,136,98,51,34,
+86,36,1,136,16,18,136,98,51,185,140,51,161,172,136,238,
+188,169,219,172,24,33,17,67,35,129,49,53,162,222,187,187,
+205,170,136,153,137,34,176,156,48,34,65,38,160,156,64,52,
+34,50,35,128,169,48,54,35,65,53,130,153,170,154,115,38,
+1,16,68,83,84,51,18,0,129,184,205,203,203,154,152,170,
+138,48,68,51,68,34,160,171,24,146,204,40,20,185,40,38,
+169,40,55,128,169,169,204,26,69,3,152,40,84,18,65,69,
+51,17,51,20,186,9,1,236,172,203,204,170,8,0,136,17,
+129,152,32,19,252,188,154,235,189,138,152,152,8,0,219,171,
+169,219,203,203,204,171,138,128,0,65,54,51,33,51,18,8,
+98,18,202,155,128,0,17,18,33,53,146,9,116,51,52,54,
+52,18,128,170,16,19,217,204,170,153,49,54,67,35,17,136,
+217,222,155,9,144,154,25,52,69,69,35,35,17,129,137,136,
+136,153,8,99,52,67,99,52,51,36,51,128,154,49,36,144,
+171,138,49,52,18,49,101,52,19,184,187,204,205,187,203,220,
+171,153,153,9,32,1,153,154,219,221,188,172,153,168,219,187,
+154,16,1,234,203,153,202,187,137,152,136,33,145,235,203,170,
+25,160,207,170,169,171,65,35,250,188,188,219,186,188,155,16,
+51,35,35,68,69,18,128,152,202,190,138,0,152,56,54,19,
+128,24,152,187,80,36,129,32,84,68,69,67,18,16,34,2,
+152,64,68,51,67,36,130,0,50,51,0,8,185,173,72,68,
+68,53,52,34,66,35,17,65,52,37,18,0,136,33,51,1,
+128,201,190,187,187,188,155,24,17,184,204,25,71,68,83,34,
+1,9,0,128,219,221,204,186,170,188,172,153,136,153,152,186,
+171,16,19,161,222,203,9,0,169,186,251,204,170,187,206,154,
+153,170,170,219,189,138,33,128,137,185,219,24,35,144,9,18,
+220,204,220,203,9,50,2,144,186,155,113,52,18,18,168,204,
+154,168,153,115,53,2,136,154,25,101,53,51,1,136,16,35,
+51,84,34,136,16,145,206,57,87,18,0,17,144,139,115,35,
+16,49,35,0,82,51,33,85,18,152,202,219,138,66,34,33,
+35,145,25,71,3,9,66,3,251,154,128,153,25,68,161,206,
+154,0,168,26,83,161,140,98,130,170,81,2,235,138,152,205,
+10,0,201,155,136,169,9,17,160,155,153,204,25,2,188,42,
+131,255,154,0,201,171,136,252,172,138,152,187,138,1,219,139,
+100,18,128,66,20,202,155,0,218,139,49,176,174,16,1,9,
+85,35,136,152,204,171,137,16,115,52,2,32,36,152,88,54,
+1,138,17,185,159,48,36,2,66,36,144,153,67,19,152,81,
+19,236,10,35,161,27,55,146,155,100,20,136,49,36,184,138,
+17,217,172,9,160,190,138,1,136,41,52,18,136,17,160,205,
+154,33,18,33,68,161,206,154,152,218,188,187,191,189,172,169,
+136,8,50,51,34,115,69,18,0,0,200,205,171,186,204,170,
+153,152,25,68,36,34,51,19,169,171,186,205,188,170,8,50,
+54,68,34,144,8,128,234,155,128,234,171,49,53,115,68,34,
+1,17,128,154,154,168,219,172,138,137,137,97,69,34,66,53,
+2,136,16,145,204,25,129,218,171,137,153,32,69,52,130,202,
+155,24,128,24,67,249,190,139,50,53,67,34,184,207,155,8,
+18,17,17,232,206,154,16,34,51,36,160,190,170,9,33,83,
+18,168,204,172,154,32,34,51,1,201,188,155,136,33,17,8,
+130,252,171,24,185,42,119,2,153,34,161,190,9,2,153,66,
+21,136,24,152,26,55,3,0,84,161,204,8,18,136,48,55,
+130,203,138,50,1,32,103,2,186,25,35,144,80,53,146,187,
+154,153,24,67,33,50,232,189,57,38,136,64,20,185,140,35,
+161,139,67,193,187,9,153,40,146,207,8,129,206,25,129,235,
+9,19,185,154,136,204,25,1,138,49,250,255,137,136,128,17,
+1,185,235,187,42,67,1,33,179,255,171,32,128,16,36,160,
+205,137,136,0,67,20,160,186,155,153,9,98,20,128,169,137,
+8,32,68,68,35,129,16,35,201,140,115,19,16,98,19,128,
+136,24,84,34,33,68,2,185,41,53,34,101,51,2,128,137,
+9,17,50,116,35,176,173,0,136,64,70,19,152,136,152,138,
+65,68,19,184,205,154,152,137,81,20,201,187,155,153,136,99,
+19,251,187,170,152,153,65,2,251,188,187,170,24,17,168,187,
+222,173,138,8,0,128,169,221,187,171,138,49,128,171,218,221,
+203,25,34,128,0,144,219,172,137,18,35,35,218,189,188,138,
+65,83,50,129,137,171,9,84,69,36,129,137,152,153,56,86,
+35,33,17,168,9,69,67,35,51,3,153,82,52,84,52,18,
+1,1,2,16,68,3,137,67,35,83,70,52,1,16,1,8,
+82,67,18,1,136,203,154,33,99,36,129,8,17,128,66,87,
+2,184,169,202,188,137,66,35,152,16,152,222,172,154,186,189,
+172,187,153,128,16,68,18,234,172,170,188,156,8,160,221,187,
+187,205,171,8,144,186,138,176,189,56,21,200,187,220,220,171,
+136,16,16,2,168,219,188,172,153,201,172,138,185,140,82,36,
+17,17,128,187,26,35,50,38,176,190,188,172,9,67,2,66,
+55,18,82,53,35,0,16,168,204,9,83,51,52,68,51,1,
+24,66,2,153,81,35,136,114,54,33,49,52,1,0,49,34,
+51,36,17,129,201,189,32,35,40,103,36,17,66,36,130,136,
+153,220,187,171,136,33,33,34,35,234,173,153,218,173,154,184,
+203,8,34,144,136,185,223,203,171,171,188,203,170,220,204,154,
+169,203,137,0,152,25,34,176,189,186,222,188,186,187,187,154,
+137,8,144,220,171,219,204,154,136,152,24,68,2,16,66,2,
+186,139,34,152,42,87,3,184,11,34,217,42,119,20,33,83,
+51,34,49,51,130,169,48,36,35,101,68,35,17,66,35,129,
+24,68,18,49,70,36,34,35,35,18,17,33,53,35,17,67,
+20,144,40,37,145,138,82,36,51,71,51,1,128,128,202,188,
+155,186,204,154,16,128,152,176,238,204,171,186,170,138,153,185,
+204,172,169,218,219,203,203,172,171,170,186,188,204,219,171,171,
+154,138,154,203,186,203,203,187,203,205,219,186,170,154,138,153,
+185,171,204,188,170,186,188,154,0,186,89,38,144,155,32,162,
+175,56,36,0,8,82,19,16,83,69,51,32,84,52,18,50,
+85,19,1,49,67,1,9,99,51,50,69,68,19,17,51,50,
+34,82,53,35,34,51,53,20,33,54,18,17,8,66,1,81,
+53,50,17,40,51,136,99,51,51,130,48,20,81,37,136,129,
+238,170,154,16,0,81,4,202,153,152,144,188,16,250,189,169,
+137,129,154,128,252,203,187,10,168,171,136,188,205,172,9,184,
+188,203,187,220,170,17,129,169,204,187,237,155,137,152,168,154,
+0,185,156,137,136,250,174,137,169,186,138,67,216,172,33,168,
+172,25,51,184,58,55,34,1,10,35,252,138,17,51,20,114,
+37,129,33,16,17,185,89,36,49,70,66,51,1,83,2,16,
+17,65,3,10,85,17,67,34,99,2,24,35,67,53,32,69,
+130,24,1,32,146,139,52,144,32,82,87,130,40,19,185,153,
+9,83,129,99,18,32,130,139,20,251,170,204,171,203,138,1,
+0,17,138,67,233,25,132,170,201,173,185,205,137,201,171,205,
+171,169,173,16,144,152,169,137,234,140,129,169,153,189,9,234,
+139,146,203,220,172,170,204,138,144,137,152,56,21,16,70,1,
+8,168,155,203,156,145,187,153,191,9,168,72,20,17,18,138,
+83,34,85,34,82,129,26,36,136,66,1,128,251,10,0,25,
+35,80,22,169,113,20,33,67,36,130,8,35,144,9,144,138,
+248,156,65,2,33,68,52,128,72,37,128,32,33,18,168,114,
+20,0,1,8,184,205,9,168,155,153,25,19,57,119,2,33,
+19,8,33,2,217,156,184,239,138,152,186,154,170,169,186,9,
+100,2,186,73,161,223,25,129,186,154,152,219,170,153,128,250,
+175,138,169,188,24,19,201,9,18,1,152,98,35,251,188,136,
+185,174,16,129,203,154,40,145,171,115,5,186,25,51,161,41,
+71,144,171,136,32,145,26,71,144,188,40,19,186,113,21,169,
+24,34,33,84,67,18,8,137,137,137,40,51,176,12,50,67,
+116,84,35,152,24,18,202,57,87,128,9,33,145,155,82,35,
+136,137,8,2,220,104,53,169,26,37,234,9,51,184,41,20,
+169,9,144,11,37,232,27,52,233,27,53,168,27,36,217,139,
+1,202,9,18,153,32,128,26,18,136,100,131,205,139,129,220,
+27,52,161,174,24,145,204,25,53,161,172,32,131,205,56,37,
+184,172,17,176,174,48,20,201,154,0,152,188,80,38,200,139,
+82,176,156,83,146,172,25,130,188,42,67,144,172,16,2,218,
+57,54,176,157,49,176,157,83,129,171,24,129,188,41,38,144,
+171,49,146,172,113,20,176,138,50,176,141,98,2,170,9,19,
+185,41,71,129,138,32,145,24,53,34,17,184,140,50,146,80,
+39,161,154,66,3,24,71,130,170,32,129,171,114,19,184,154,
+32,1,186,113,39,184,171,83,131,187,112,21,202,10,50,200,
+171,65,130,205,26,50,184,141,82,129,172,56,19,202,11,52,
+200,173,32,145,203,138,33,216,172,49,2,188,41,20,186,10,
+33,161,202,155,138,169,222,155,17,250,173,16,144,187,49,132,
+169,40,52,18,144,33,2,239,155,24,201,156,16,176,158,48,
+3,41,84,129,24,34,184,64,37,169,9,18,168,138,114,38,
+145,155,113,2,203,56,39,176,11,69,130,138,114,18,152,25,
+50,161,187,72,19,235,139,84,130,153,115,19,168,48,21,160,
+8,19,176,172,16,18,128,9,86,3,169,64,38,168,11,51,
+208,173,40,35,169,10,69,131,169,64,36,201,187,136,234,204,
+137,128,152,153,8,49,36,144,49,5,251,187,170,188,189,186,
+137,184,206,10,51,176,174,32,161,207,137,129,186,156,32,145,
+188,25,54,161,171,32,192,191,138,168,205,137,0,185,24,52,
+19,66,69,129,152,16,19,251,173,16,145,204,41,36,152,26,
+85,1,153,48,37,144,170,65,36,184,25,54,129,9,66,3,
+152,8,33,128,218,139,115,36,0,81,53,18,34,36,2,16,
+1,201,172,170,154,136,8,40,85,51,69,52,17,24,52,147,
+204,137,18,168,188,10,18,201,10,69,161,174,24,145,205,139,
+0,152,137,152,138,115,19,168,154,168,236,205,171,171,189,171,
+9,201,173,32,36,160,155,49,161,190,171,201,204,171,136,217,
+172,41,18,184,155,144,251,154,136,220,172,24,130,170,48,54,
+18,51,37,144,155,48,178,255,141,16,168,155,66,19,153,115,
+52,128,25,68,3,202,25,36,160,156,81,130,170,48,37,152,
+25,67,130,153,24,68,51,18,67,69,50,50,36,1,17,2,
+251,172,153,170,139,17,129,40,87,53,35,18,50,52,3,202,
+154,153,186,219,204,171,136,152,48,19,218,57,39,161,170,24,
+17,33,192,190,58,53,176,190,153,153,221,188,154,203,188,137,
+128,203,10,84,19,160,138,66,131,204,172,169,188,188,169,219,
+156,137,1,168,170,137,49,36,160,188,26,54,3,187,58,55,
+130,153,32,192,191,24,145,222,170,17,1,0,67,68,67,52,
+36,18,66,67,128,170,32,200,174,25,2,204,139,82,1,136,
+98,36,128,32,53,2,128,50,19,152,154,218,204,153,152,236,
+187,138,144,153,66,36,136,97,55,2,136,64,51,184,188,136,
+234,173,10,160,205,139,33,129,138,97,35,129,82,37,129,10,
+82,130,218,10,1,234,171,16,160,190,24,20,160,10,70,18,
+137,81,20,128,137,35,146,204,25,144,220,171,16,160,204,25,
+34,145,24,85,18,136,66,36,160,156,16,130,221,171,136,203,
+172,137,152,219,137,33,129,9,82,36,128,24,51,146,203,172,
+202,188,203,203,189,187,9,1,219,140,64,51,34,51,19,32,
+103,51,145,187,41,69,145,219,138,0,128,16,0,204,42,87,
+19,128,24,99,67,18,129,0,48,51,129,203,170,169,136,34,
+233,174,56,39,2,8,65,51,34,50,36,144,137,33,176,207,
+139,169,220,187,154,219,187,25,129,235,10,67,145,9,116,19,
+201,155,24,233,173,138,144,205,171,9,168,187,56,22,168,9,
+68,130,187,48,20,218,139,18,217,173,24,129,220,9,51,177,
+188,24,19,153,114,55,129,137,82,35,144,9,66,129,171,25,
+3,236,140,65,19,153,97,52,129,137,67,19,9,98,20,176,
+155,65,3,170,64,37,201,155,33,208,173,9,18,169,10,84,
+2,170,48,38,129,25,19,248,190,170,136,153,187,154,185,190,
+139,16,160,171,72,35,251,172,8,17,9,82,2,236,154,8,
+184,204,155,185,206,171,8,0,49,86,34,1,16,67,51,34,
+34,1,251,188,171,137,32,85,36,130,185,10,100,67,35,34,
+145,203,41,69,35,17,16,144,187,73,54,130,188,187,186,138,
+118,52,1,169,153,16,66,85,18,184,190,171,170,137,33,35,
+192,189,155,9,48,85,51,145,203,171,187,189,138,33,2,201,
+204,220,188,11,50,20,153,188,219,154,32,54,35,144,153,152,
+153,40,54,161,207,171,170,137,49,52,129,188,26,68,37,52,
+35,144,186,138,33,34,67,36,160,187,32,19,218,10,99,52,
+68,51,145,204,155,114,69,51,35,144,204,171,25,67,51,129,
+218,204,187,40,68,36,17,128,153,154,16,34,128,187,139,152,
+187,172,252,204,138,34,37,35,144,236,204,154,16,52,52,1,
+201,204,170,24,50,35,145,220,189,188,138,24,35,36,18,144,
+204,187,153,8,17,51,145,223,189,186,155,24,69,52,19,0,
+169,172,138,82,53,52,2,168,204,170,32,68,36,17,169,204,
+171,153,16,34,17,128,0,153,32,85,2,154,25,50,2,144,
+253,223,171,24,68,36,35,1,169,155,81,53,67,34,129,219,
+156,9,33,51,51,146,220,171,24,128,186,172,185,189,9,34,
+224,204,138,136,128,64,52,177,206,187,169,138,65,69,129,154,
+137,18,34,52,20,184,175,138,128,152,154,16,234,188,57,53,
+36,50,19,250,188,9,17,144,153,168,222,171,9,2,128,33,
+35,201,156,65,52,34,18,128,203,41,87,35,129,185,203,187,
+9,49,19,185,203,25,86,69,68,34,18,0,0,66,52,20,
+160,220,188,187,8,49,20,1,186,205,170,16,68,68,34,128,
+185,188,153,32,68,18,160,219,172,171,9,50,35,1,128,152,
+72,87,35,145,202,204,155,24,67,2,233,205,203,155,24,83,
+51,17,184,204,170,32,84,67,18,160,203,187,154,16,52,2,
+201,204,172,137,48,68,35,2,160,203,170,138,24,17,176,223,
+219,171,170,8,82,67,34,17,152,154,32,86,69,67,34,0,
+153,186,155,48,69,51,35,184,207,172,154,24,82,67,19,144,
+219,203,171,137,49,51,129,251,204,187,138,32,53,36,17,153,
+202,187,24,70,83,50,18,160,202,154,9,17,51,34,184,205,
+171,24,82,68,34,144,235,204,170,154,24,33,34,160,236,219,
+203,186,136,33,50,51,2,185,172,25,100,68,67,35,2,152,
+169,171,137,33,50,67,52,51,35,2,251,205,187,138,64,85,
+67,35,129,202,189,204,170,153,128,1,0,144,185,203,154,9,
+48,84,68,67,67,51,20,18,17,136,186,219,188,187,138,66,
+69,36,3,168,220,203,170,16,68,68,50,1,184,188,189,203,
+170,137,8,16,34,34,136,169,170,187,112,85,52,67,34,1,
+186,219,186,187,170,153,152,24,83,68,51,51,129,220,204,171,
+138,49,69,51,18,168,236,203,187,188,154,8,32,68,83,51,
+51,51,34,34,33,50,19,201,189,205,203,186,153,8,24,66,
+51,129,235,189,189,170,49,86,67,51,2,200,189,189,186,154,
+0,34,51,51,17,144,136,0,99,69,67,35,35,18,0,8,
+17,18,34,36,129,204,204,205,188,173,187,171,138,49,68,36,
+19,129,203,204,172,171,153,16,67,53,51,51,1,201,189,189,
+187,154,48,70,52,36,19,129,169,187,171,24,100,52,52,33,
+152,219,204,172,171,170,137,17,34,18,152,204,189,188,155,25,
+99,69,83,35,35,128,185,190,188,155,25,82,68,51,19,144,
+218,188,188,170,8,50,54,51,35,144,202,189,187,154,8,51,
+52,20,145,201,188,188,187,138,49,85,83,67,35,18,0,186,
+205,203,187,153,49,70,68,50,18,160,235,188,188,171,138,32,
+83,67,51,17,152,219,219,170,137,16,51,52,35,2,144,153,
+154,24,83,68,52,51,2,185,207,204,187,172,9,32,68,52,
+36,34,128,185,190,189,171,170,24,66,68,51,36,1,144,202,
+203,203,171,154,8,50,69,67,51,67,50,33,0,169,219,203,
+186,203,171,187,188,187,139,32,85,84,51,35,18,152,220,219,
+187,171,9,82,53,53,51,35,129,169,205,219,203,171,171,154,
+32,99,52,52,36,18,1,153,219,219,187,187,171,9,32,52,
+53,36,51,33,0,169,204,188,188,203,154,137,33,69,52,53,
+67,34,1,185,205,188,188,187,155,137,49,68,52,51,51,17,
+160,203,189,173,187,171,137,48,85,83,52,51,35,18,144,219,
+204,188,187,187,153,32,68,53,52,51,35,18,136,170,204,203,
+187,170,137,32,52,69,50,35,18,128,219,188,189,188,187,170,
+136,50,86,83,67,51,51,18,168,251,219,187,188,170,154,8,
+33,52,52,51,35,130,168,204,188,188,187,170,9,49,84,67,
+67,34,18,1,168,202,205,219,187,188,171,154,136,33,83,52,
+52,51,34,1,168,219,203,170,154,136,17,50,83,67,50,1,
+168,219,204,203,203,187,203,154,8,83,69,83,51,52,66,34,
+35,18,144,202,189,188,172,170,137,16,49,53,52,52,50,34,
+17,0,136,186,204,188,188,137,82,85,52,52,51,18,129,185,
+220,188,188,172,171,153,9,16,49,67,67,67,34,2,160,202,
+188,172,154,9,49,84,83,52,67,34,1,185,206,188,188,172,
+171,154,9,50,53,53,51,34,1,169,203,188,172,171,155,9,
+66,68,52,67,18,1,152,202,204,189,188,188,187,170,138,0,
+50,53,53,52,36,18,1,168,203,172,187,186,169,152,0,49,
+67,34,152,236,188,204,170,154,137,32,68,69,52,68,50,35,
+51,50,35,35,2,169,205,188,203,170,153,0,32,67,51,35,
+130,218,205,171,154,32,99,52,83,51,53,69,66,50,34,2,
+0,169,204,204,188,204,187,187,186,154,153,32,67,54,68,51,
+35,34,0,128,136,136,168,218,219,187,203,170,170,187,188,188,
+187,172,188,204,170,9,82,69,52,50,18,0,152,169,170,186,
+204,171,10,66,70,51,51,1,169,205,204,219,203,172,187,186,
+153,9,16,49,99,68,52,52,35,18,144,185,189,188,188,187,
+172,171,153,136,152,169,219,187,138,81,85,52,53,67,50,35,
+34,18,0,136,8,24,16,33,51,53,67,67,19,129,152,152,
+185,252,206,206,188,189,187,187,137,48,85,52,53,51,36,17,
+129,152,169,169,153,153,202,220,219,203,187,188,170,137,33,84,
+52,53,35,51,18,34,33,34,18,152,220,220,203,188,203,187,
+187,170,9,50,69,67,50,18,17,128,128,152,169,188,188,203,
+154,170,170,171,138,81,86,68,51,34,129,186,206,187,188,171,
+172,171,187,203,171,203,169,8,115,84,53,68,51,52,50,18,
+128,169,219,188,188,187,203,171,203,186,203,170,154,8,65,69,
+68,51,52,35,17,144,169,153,8,83,68,50,19,144,219,204,
+203,186,137,32,99,36,36,1,144,187,189,188,170,170,154,170,
+170,186,170,138,24,100,84,84,67,67,35,18,129,169,202,202,
+170,171,187,187,172,187,203,189,204,186,138,32,85,68,67,50,
+34,17,144,168,219,203,219,186,187,187,172,187,186,8,115,69,
+68,51,36,34,129,152,187,189,173,187,172,186,170,187,204,187,
+188,171,9,99,69,68,51,52,51,34,2,128,153,186,188,188,
+188,189,188,188,187,170,8,65,53,53,52,51,34,1,152,186,
+189,172,203,186,186,188,188,187,171,138,49,55,54,53,36,51,
+67,18,2,129,168,186,189,189,188,188,203,203,202,186,154,9,
+48,84,52,52,52,34,33,0,136,169,187,203,187,170,188,203,
+187,173,171,136,49,87,52,67,34,18,128,168,188,188,186,170,
+170,186,205,204,203,188,172,153,8,67,68,52,52,36,34,34,
+17,18,33,33,33,17,185,223,204,203,187,171,154,9,16,17,
+128,184,204,203,186,186,9,83,69,83,50,34,17,144,202,170,
+154,24,67,51,53,68,35,50,34,35,50,51,17,49,37,216,
+237,205,204,203,187,187,171,138,9,0,128,136,16,65,84,69,
+68,52,51,36,34,17,0,153,152,137,24,18,128,201,221,205,
+203,172,155,137,17,67,52,36,1,160,218,187,172,170,153,24,
+34,83,35,35,50,67,83,83,68,52,52,35,18,128,168,203,
+186,172,187,203,220,203,172,203,187,187,173,171,154,154,136,17,
+66,67,51,34,67,52,66,67,52,83,67,51,35,34,2,128,
+137,137,24,34,168,223,205,204,204,202,186,170,137,137,0,17,
+1,136,169,170,72,85,68,51,52,50,50,18,34,67,68,83,
+67,35,51,36,17,128,153,203,187,153,153,154,220,190,189,187,
+188,154,154,137,16,2,8,65,52,70,68,51,51,69,51,51,
+35,33,0,0,170,187,189,156,40,33,33,86,67,35,17,217,
+222,203,187,188,187,171,154,170,187,220,203,172,154,136,33,100,
+83,50,52,51,18,17,18,16,16,18,129,169,221,205,189,204,
+187,187,188,170,170,170,9,16,17,49,35,145,170,186,206,172,
+8,82,69,68,67,36,51,66,18,1,0,33,18,34,50,144,
+138,128,251,205,186,203,203,188,188,188,171,9,16,50,101,52,
+52,36,34,2,128,1,1,24,66,36,35,35,2,136,49,71,
+68,50,67,67,35,34,1,185,189,171,218,203,171,204,204,188,
+204,187,172,154,153,136,8,0,33,50,69,36,67,67,51,50,
+50,35,152,169,204,190,187,186,170,153,0,153,170,153,153,220,
+206,188,189,188,170,154,170,136,145,235,204,188,188,155,137,33,
+68,69,67,35,35,17,128,128,0,50,51,70,67,18,144,201,
+204,156,154,152,16,66,52,53,51,34,17,17,16,0,185,203,
+154,171,203,205,203,138,1,0,16,176,206,170,185,207,170,8,
+0,48,70,34,17,51,35,184,203,154,154,64,119,51,83,67,
+67,34,2,129,169,219,186,187,204,187,154,202,221,203,203,203,
+187,169,170,170,8,16,0,18,1,48,70,68,83,52,51,68,
+36,18,16,33,35,51,53,35,0,8,1,168,206,154,152,201,
+170,153,252,188,154,219,205,170,153,153,8,34,129,152,0,144,
+220,188,169,152,24,101,52,36,66,51,2,169,154,168,155,113,
+53,50,83,52,19,1,144,201,171,170,137,40,67,18,33,208,
+255,203,170,187,187,153,169,171,9,152,236,203,170,171,170,24,
+83,51,84,68,18,128,32,67,34,84,52,20,50,52,19,1,
+16,18,17,0,50,20,136,32,146,255,175,170,187,187,138,136,
+136,16,18,202,205,203,188,187,171,154,56,84,51,68,17,186,
+189,186,172,154,50,53,67,53,51,1,16,17,136,24,81,84,
+52,69,51,35,1,8,129,169,10,67,2,16,68,160,206,171,
+235,204,187,188,203,170,153,169,186,203,203,187,171,170,137,48,
+54,52,52,68,67,51,53,36,35,53,52,50,52,35,18,32,
+34,1,32,69,18,0,152,251,206,187,203,188,187,187,203,170,
+171,188,204,203,188,186,172,138,8,17,49,52,18,1,17,18,
+16,86,52,52,69,36,50,34,19,0,8,1,17,83,69,35,
+35,2,160,204,189,203,202,186,137,0,136,24,128,222,203,186,
+188,156,8,18,50,84,34,144,136,153,188,156,16,67,84,83,
+67,34,17,18,0,8,65,69,67,68,52,50,34,50,0,136,
+0,128,17,54,52,33,51,145,205,188,204,204,170,154,186,154,
+170,220,188,188,204,172,171,170,170,153,136,152,169,137,168,220,
+138,34,34,101,69,51,66,66,18,1,17,34,49,50,53,51,
+35,16,17,217,206,171,204,188,172,169,186,172,170,205,203,171,
+187,188,170,169,171,154,152,152,8,18,128,32,83,68,70,69,
+51,52,67,35,49,67,36,51,99,51,50,50,69,34,33,50,
+35,152,16,36,2,48,39,145,187,154,201,189,154,152,235,203,
+170,186,188,172,153,235,204,154,168,169,24,51,176,171,16,176,
+140,117,36,50,67,53,34,67,68,35,18,18,34,50,68,53,
+36,18,1,152,203,187,187,187,203,205,203,203,188,188,202,235,
+203,187,203,187,170,153,202,187,188,189,188,170,154,169,137,136,
+0,24,99,37,2,128,34,18,65,87,37,19,51,36,130,128,
+50,35,32,99,51,0,48,54,3,136,136,234,205,154,128,8,
+40,50,160,206,187,187,172,154,153,154,170,138,115,37,17,32,
+34,218,139,115,67,67,69,35,1,17,51,35,82,68,34,18,
+83,36,51,66,51,3,136,154,136,16,84,53,35,152,154,154,
+219,171,137,186,207,170,152,170,155,128,251,207,187,188,187,154,
+137,168,204,203,186,187,188,138,169,235,171,138,170,171,98,130,
+251,172,153,203,138,67,18,136,48,19,186,73,71,2,16,66,
+2,8,115,52,2,0,136,187,173,25,67,35,50,51,161,204,
+155,0,128,154,170,238,188,138,0,184,206,188,205,203,154,136,
+136,0,1,144,218,154,8,18,18,52,19,0,114,71,35,18,
+35,2,152,56,71,52,83,52,35,1,33,51,34,67,52,2,
+0,65,67,34,34,34,200,206,171,153,0,81,52,3,185,172,
+170,204,170,137,217,188,139,152,202,138,18,250,205,170,169,154,
+81,37,18,0,17,152,154,49,36,17,66,69,34,50,70,36,
+17,0,152,168,24,100,52,34,17,128,202,204,187,203,203,203,
+171,204,203,170,185,235,219,187,188,172,154,152,169,170,170,204,
+188,187,171,186,170,152,152,138,114,38,18,0,17,1,32,102,
+52,50,83,36,18,16,49,35,17,68,51,17,65,54,35,17,
+33,145,187,138,50,18,84,53,19,168,203,187,187,203,187,187,
+206,155,81,35,136,25,129,237,155,32,34,98,70,35,129,17,
+67,34,50,69,34,17,83,53,35,52,51,19,128,153,0,32,
+100,68,34,128,136,136,152,171,24,217,206,170,136,169,10,16,
+250,207,187,188,172,154,137,152,219,187,172,187,203,154,169,220,
+171,154,185,155,65,131,222,187,171,204,154,66,3,136,48,19,
+185,88,55,18,16,52,3,24,115,38,17,0,136,201,186,8,
+51,34,50,51,184,207,154,8,152,170,187,207,173,138,8,168,
+204,204,188,173,154,137,16,16,33,1,184,138,97,36,51,83,
+35,16,98,85,50,33,50,2,152,56,70,51,84,52,19,1,
+17,19,18,65,51,144,170,33,35,34,66,161,223,204,172,154,
+9,49,68,18,168,172,169,202,171,9,201,174,138,0,168,24,
+52,208,206,170,169,138,114,52,19,17,18,128,170,24,1,169,
+9,51,19,98,86,67,2,184,219,188,171,40,54,51,17,0,
+201,206,187,203,188,172,170,203,188,153,152,186,204,220,203,170,
+154,137,136,128,0,144,218,204,186,170,186,153,186,173,48,70,
+18,1,0,144,137,48,53,51,87,68,35,18,49,34,34,82,
+51,35,68,85,35,67,50,51,52,51,67,34,50,68,68,36,
+18,34,34,1,137,144,202,155,16,161,190,172,186,188,203,251,
+188,188,186,171,170,153,170,153,234,204,188,187,170,154,137,153,
+154,25,83,18,1,1,234,188,41,69,52,70,67,34,17,1,
+152,136,49,53,52,51,67,68,35,34,17,168,188,10,1,202,
+72,55,18,153,220,221,187,186,202,202,170,170,170,187,190,189,
+186,187,203,187,187,139,50,36,17,152,187,205,187,170,40,115,
+85,51,19,1,34,35,51,53,36,33,84,52,67,51,51,17,
+129,186,172,10,66,101,83,18,129,0,17,0,66,52,1,66,
+53,19,32,83,18,152,202,222,187,154,8,1,144,218,203,219,
+187,188,170,170,152,201,204,138,136,33,19,232,189,138,9,56,
+71,36,51,83,18,0,33,52,52,67,34,35,50,67,67,35,
+129,152,219,206,171,8,17,17,35,192,191,187,203,188,154,168,
+219,172,171,154,136,152,251,204,188,186,154,137,24,50,20,144,
+187,205,187,154,169,187,9,66,84,83,34,66,51,2,169,137,
+48,119,54,51,50,50,18,0,8,136,137,32,36,18,50,83,
+68,129,236,187,204,203,155,137,154,32,37,184,205,186,189,187,
+153,153,24,68,19,50,53,35,67,36,152,10,83,68,67,53,
+36,17,1,168,188,156,16,18,0,0,2,152,56,4,238,172,
+154,235,187,137,16,0,34,176,239,186,169,186,155,24,50,35,
+19,129,8,99,36,160,206,187,137,65,68,52,51,2,144,202,
+172,32,69,34,51,37,50,84,36,128,0,17,152,155,0,128,
+97,69,34,168,186,187,205,188,154,136,170,171,185,223,171,128,
+217,189,187,188,187,9,152,137,8,18,128,201,170,32,51,84,
+85,51,52,68,51,34,67,52,34,17,17,51,55,53,52,35,
+35,33,34,1,0,33,19,144,9,2,233,172,128,251,175,187,
+235,188,154,153,152,153,185,221,188,187,203,187,188,186,188,173,
+153,152,170,137,184,206,155,153,152,49,71,50,50,51,34,17,
+67,54,37,51,67,51,67,53,53,51,18,18,128,40,84,52,
+67,50,18,152,170,136,169,170,168,236,173,139,8,136,185,251,
+220,219,170,170,169,137,0,168,205,203,187,204,154,154,203,187,
+153,128,0,32,18,218,189,154,170,155,115,55,18,33,50,129,
+32,70,2,0,82,36,34,84,51,34,51,53,2,8,66,51,
+50,52,36,1,16,36,161,204,137,128,186,155,185,223,155,1,
+184,206,170,187,189,170,170,204,172,154,187,189,171,170,203,187,
+186,188,155,32,2,235,172,138,24,50,36,144,204,138,99,36,
+129,136,152,186,11,85,52,50,69,35,160,10,83,3,0,49,
+193,173,98,53,0,8,2,217,188,137,170,157,81,51,129,9,
+1,200,155,17,248,204,9,34,32,114,67,2,137,152,202,188,
+48,69,35,66,36,19,49,52,4,136,8,35,34,116,53,35,
+18,35,128,204,170,136,136,32,68,18,0,50,146,222,187,186,
+205,171,153,168,154,24,176,255,187,173,203,170,152,136,153,154,
+186,220,203,171,186,189,171,154,186,10,52,147,206,172,188,188,
+154,1,1,48,84,35,1,33,34,0,48,70,18,65,85,36,
+35,51,35,0,24,50,67,100,68,67,34,34,18,18,50,51,
+35,128,66,71,67,66,35,2,169,170,185,205,154,16,2,25,
+99,19,184,138,217,222,188,171,202,186,154,153,186,173,170,251,
+204,186,186,187,171,170,219,187,138,185,188,188,204,203,138,8,
+0,16,68,51,128,25,1,185,88,71,18,48,71,67,34,51,
+36,0,33,51,2,49,86,52,66,83,34,17,34,36,1,136,
+16,17,16,84,51,128,40,67,161,205,154,169,203,171,168,237,
+187,154,185,222,172,154,186,172,170,185,190,155,136,235,204,154,
+169,187,138,152,202,139,33,3,202,154,8,203,172,9,144,26,
+103,36,18,32,67,36,51,51,18,33,70,52,51,51,52,68,
+52,35,18,34,67,67,34,35,18,17,98,35,145,137,66,19,
+152,32,18,186,113,36,250,173,154,153,186,187,188,174,138,136,
+168,189,188,187,219,203,187,204,170,9,8,153,137,0,168,187,
+202,236,219,187,154,188,173,25,19,152,26,36,218,140,66,161,
+189,41,34,152,97,53,145,138,66,129,202,138,129,169,97,70,
+2,0,33,19,136,65,37,1,49,71,35,50,69,34,144,153,
+169,186,41,70,36,18,67,68,50,17,1,168,204,137,33,1,
+32,86,34,129,128,201,205,172,154,169,186,137,49,160,205,171,
+202,190,172,187,205,171,25,17,168,170,219,220,170,153,201,171,
+137,17,8,32,1,152,128,250,191,155,137,0,84,36,17,66,
+54,1,136,49,35,33,70,35,152,48,55,35,1,33,2,8,
+98,52,34,50,55,20,1,17,50,35,51,2,235,172,137,152,
+186,205,170,138,168,188,204,202,137,49,145,220,137,17,17,50,
+147,239,187,187,205,172,154,137,153,153,169,137,16,50,145,253,
+187,25,52,19,50,20,145,137,160,255,203,154,152,136,33,67,
+67,67,34,0,0,17,33,34,16,115,71,51,35,145,203,188,
+203,170,153,170,40,86,19,16,66,2,202,137,1,219,26,84,
+2,136,81,19,201,187,170,205,139,66,36,152,24,35,144,154,
+1,249,174,154,128,128,82,68,18,128,153,169,25,50,1,40,
+52,35,116,68,129,137,49,19,203,27,67,18,115,53,2,154,
+24,35,144,48,54,18,128,144,185,173,171,169,252,206,171,40,
+18,0,17,161,206,9,1,218,173,154,186,205,154,170,188,203,
+186,204,172,153,128,168,186,169,187,154,152,222,172,9,128,0,
+50,130,9,86,18,185,138,17,33,116,53,51,68,52,36,34,
+34,67,34,17,17,34,83,85,52,18,0,67,36,50,83,18,
+0,49,37,129,16,67,146,170,138,202,172,48,20,234,188,154,
+152,185,188,188,206,171,153,185,190,10,152,218,172,186,204,154,
+137,219,172,170,136,136,136,152,169,169,152,251,191,171,153,185,
+203,170,170,56,70,3,136,24,33,18,2,185,140,115,52,18,
+128,24,84,52,34,160,203,41,71,34,0,50,67,33,68,20,
+1,48,55,2,153,40,68,34,49,35,201,140,85,52,17,49,
+68,34,51,53,20,16,33,35,184,154,83,36,34,52,18,8,
+115,36,1,152,137,8,0,16,16,144,32,70,146,223,171,171,
+189,203,203,204,170,170,186,203,187,188,188,188,189,188,171,187,
+188,188,189,187,187,171,188,189,172,154,171,154,137,218,171,153,
+202,173,138,128,153,9,50,35,85,69,51,17,33,67,51,68,
+68,51,51,69,52,51,67,36,51,51,52,52,50,53,53,51,
+67,36,51,51,52,52,18,34,51,35,34,68,51,34,35,51,
+3,136,100,52,129,153,153,202,155,9,216,222,188,202,186,203,
+187,203,219,187,188,188,172,187,187,189,204,203,170,169,187,188,
+203,188,188,186,219,203,171,170,203,171,171,171,170,137,185,221,
+187,170,170,172,153,169,154,8,144,9,99,53,36,2,8,56,
+71,69,36,35,33,82,67,66,66,51,34,66,52,36,51,69,
+51,50,50,52,67,67,68,34,33,50,52,52,50,35,50,50,
+67,51,51,35,84,52,36,17,34,33,33,18,129,186,203,170,
+203,204,203,170,170,221,206,203,170,187,203,187,190,188,155,169,
+203,203,187,190,187,187,188,173,171,187,189,187,187,187,188,188,
+204,187,187,153,170,188,187,188,170,154,202,189,172,154,154,153,
+137,137,8,49,35,152,80,54,36,50,71,52,83,52,52,34,
+66,67,51,50,51,67,67,68,52,35,51,83,51,67,67,50,
+51,36,67,83,51,51,53,35,34,51,52,36,35,19,18,33,
+83,83,50,18,0,33,50,34,51,34,160,237,171,153,250,188,
+171,236,204,170,169,219,187,186,204,187,170,187,190,187,187,219,
+203,186,187,204,186,170,203,188,172,188,203,187,203,186,188,187,
+172,171,169,169,186,188,204,171,137,128,169,137,0,186,56,103,
+18,17,33,33,32,115,69,36,35,50,52,36,52,53,35,35,
+36,36,67,66,34,51,52,34,67,51,51,69,51,36,51,52,
+51,53,50,51,53,20,18,50,18,49,84,35,2,128,152,0,
+1,128,18,249,239,153,152,186,155,152,235,173,171,154,171,154,
+170,234,204,154,8,128,153,152,218,204,171,187,188,219,203,187,
+188,188,172,137,153,169,155,138,153,9,116,51,18,65,51,144,
+153,17,51,51,146,172,57,18,116,119,20,17,33,51,50,68,
+68,50,35,17,16,128,153,16,145,236,188,203,187,8,17,17,
+83,2,137,115,51,50,69,19,169,171,187,190,171,204,220,219,
+187,172,171,171,187,186,205,171,170,186,171,153,219,220,186,187,
+188,186,170,188,189,188,187,187,138,153,169,137,168,205,25,68,
+18,0,50,177,207,26,82,34,33,68,18,16,82,70,51,51,
+52,51,67,67,84,67,50,34,50,67,66,67,68,50,50,34,
+52,52,51,52,37,19,17,49,51,34,83,52,19,8,48,68,
+34,83,52,36,33,49,67,34,51,37,2,144,218,189,170,170,
+204,188,219,219,187,171,169,186,188,186,220,203,171,154,186,204,
+188,204,188,171,186,203,188,188,188,172,170,171,171,170,188,189,
+171,186,187,172,186,205,189,186,170,187,172,187,188,173,171,186,
+154,137,0,16,17,1,65,86,83,34,34,50,36,34,67,70,
+35,35,52,36,18,66,69,36,35,50,52,51,52,54,67,35,
+51,67,51,68,51,68,50,51,34,67,52,36,51,52,34,17,
+66,52,20,18,67,50,1,33,68,34,33,50,51,144,9,32,
+2,201,205,203,203,204,188,187,172,203,203,170,203,189,172,153,
+201,203,187,219,219,187,186,203,204,171,188,219,186,171,187,188,
+203,203,187,170,171,187,172,188,188,172,170,202,187,202,202,203,
+187,171,187,188,171,203,203,153,136,136,9,1,0,65,54,18,
+16,115,35,35,68,52,50,49,84,52,50,83,83,34,33,52,
+53,66,51,51,51,52,68,51,53,50,35,67,52,67,50,52,
+52,18,50,68,50,50,68,51,34,66,52,52,51,67,67,35,
+51,83,51,34,35,36,35,35,1,33,50,129,8,68,20,136,
+137,24,32,24,114,53,160,174,9,129,201,187,205,206,219,171,
+187,188,203,172,187,188,172,154,169,187,189,219,187,172,187,188,
+188,189,188,187,203,172,171,172,187,172,172,170,187,203,187,219,
+203,154,170,172,170,202,171,186,235,203,202,187,187,188,187,187,
+187,173,24,136,8,50,130,170,128,152,72,37,161,138,185,139,
+119,52,52,52,67,67,53,51,52,52,50,34,50,53,52,52,
+53,51,52,83,67,51,51,51,68,50,67,52,52,67,67,67,
+66,51,50,36,36,18,51,36,35,67,51,51,53,52,67,52,
+50,66,67,34,50,36,0,16,128,169,16,129,9,82,18,24,
+68,19,0,184,223,203,187,173,171,188,189,187,188,204,186,188,
+189,203,203,187,188,187,219,187,187,188,172,186,203,187,188,188,
+203,203,187,189,203,172,171,187,172,170,186,156,154,170,171,202,
+219,171,188,188,170,186,172,170,186,155,24,152,9,51,144,113,
+55,51,99,51,67,67,52,67,52,51,83,66,34,50,52,51,
+51,52,51,84,67,52,67,67,51,68,50,51,36,50,50,67,
+35,52,51,68,50,51,53,51,52,36,35,51,67,50,67,50,
+17,17,0,136,136,154,154,185,189,171,249,188,155,185,204,154,
+185,188,154,202,187,170,221,189,220,188,189,187,188,187,188,188,
+203,187,203,170,187,203,203,203,172,187,172,171,203,203,188,187,
+172,187,169,170,171,185,186,172,154,170,171,219,205,189,186,188,
+186,170,204,203,172,172,171,171,170,169,137,16,82,84,68,67,
+51,52,51,67,67,35,50,66,18,16,33,35,67,69,67,51,
+52,67,51,53,67,35,34,18,16,49,84,68,67,67,51,36,
+67,52,67,67,51,34,51,52,67,68,67,50,34,19,2,0,
+0,168,203,203,220,203,170,154,136,66,83,51,52,35,35,51,
+52,18,129,202,221,203,170,153,0,33,18,185,205,205,188,203,
+188,188,188,204,187,171,187,171,154,185,235,219,203,203,171,171,
+187,187,172,203,154,8,67,67,67,1,186,205,219,203,187,188,
+204,187,187,187,154,0,17,33,18,152,187,189,204,170,153,136,
+49,86,52,69,83,51,67,34,34,1,128,0,136,128,33,83,
+68,84,67,51,67,35,18,17,1,153,170,203,155,64,71,53,
+69,51,67,67,50,50,35,34,0,152,169,170,8,83,53,53,
+67,35,34,17,136,186,220,219,219,171,171,153,40,68,68,51,
+51,51,33,0,144,203,204,204,187,187,154,32,53,53,50,19,
+144,204,205,204,188,203,172,187,187,171,154,8,17,35,35,17,
+185,191,189,203,172,187,186,170,10,48,84,83,51,18,144,234,
+204,204,187,173,203,186,170,171,153,137,16,33,17,144,201,188,
+189,187,155,137,82,84,68,52,53,51,52,51,18,1,152,203,
+188,188,203,186,170,153,0,50,68,67,51,51,51,34,51,52,
+53,70,68,83,83,51,52,36,51,51,51,34,18,128,169,187,
+188,170,138,8,17,34,50,50,50,51,130,204,205,187,139,98,
+70,69,83,51,52,52,50,51,35,17,144,219,204,188,188,188,
+186,203,171,187,188,187,187,188,203,203,188,188,203,187,187,187,
+171,187,156,154,154,169,170,220,204,188,189,204,187,188,203,187,
+186,187,186,154,154,153,169,186,189,190,189,188,188,171,171,153,
+136,50,54,53,68,50,51,18,17,152,170,187,170,154,65,71,
+68,68,68,51,52,51,36,34,34,18,18,34,35,67,52,68,
+83,67,36,51,35,34,1,136,136,0,33,68,52,55,68,68,
+67,67,35,51,34,18,1,8,136,154,186,202,171,138,16,66,
+52,20,160,220,205,219,187,172,187,203,170,171,153,16,52,54,
+51,20,1,168,203,204,203,203,203,187,204,202,170,170,187,203,
+204,188,189,188,203,187,187,186,186,170,169,24,66,53,52,36,
+2,144,170,203,188,188,203,188,172,187,170,154,128,128,169,235,
+220,203,203,186,187,154,153,32,115,83,83,83,35,36,34,18,
+18,17,33,17,34,67,52,53,53,52,67,34,18,128,136,185,
+219,187,188,155,40,86,68,53,52,67,51,51,36,35,35,1,
+129,128,136,33,84,52,53,51,36,17,129,152,202,188,204,203,
+172,170,138,16,68,52,52,51,35,18,17,136,169,204,204,203,
+170,137,32,68,52,51,18,160,220,189,205,203,188,187,188,187,
+170,154,136,33,34,34,2,185,191,204,203,187,203,170,155,10,
+48,68,52,52,34,144,235,204,204,187,204,186,187,172,170,153,
+136,16,32,17,136,185,205,203,171,155,9,65,85,83,52,53,
+67,50,51,34,0,152,203,219,187,188,187,170,153,24,65,83,
+51,67,51,50,34,50,83,83,68,84,67,52,68,51,67,51,
+51,50,35,17,128,169,202,171,171,153,8,17,34,51,50,50,
+51,129,251,219,203,137,65,86,68,68,51,52,52,50,51,35,
+17,144,203,190,204,203,187,187,203,203,186,202,186,186,186,188,
+188,188,189,187,172,187,170,171,186,170,153,137,136,152,218,221,
+204,188,204,187,188,188,187,187,187,171,169,137,136,136,169,235,
+235,219,187,203,187,170,153,16,99,83,52,52,51,35,17,144,
+187,189,173,171,155,9,83,70,52,69,51,52,51,51,50,34,
+33,16,17,33,66,84,83,52,83,50,51,34,1,153,203,188,
+203,170,138,32,84,84,52,53,67,51,51,50,33,1,8,152,
+152,153,9,16,67,53,52,17,184,223,189,189,204,187,172,187,
+187,170,138,0,50,53,37,51,50,17,128,169,186,219,186,171,
+187,171,153,186,205,221,205,204,204,203,187,188,187,187,187,170,
+137,40,66,68,51,52,50,34,18,35,50,68,51,67,52,52,
+52,66,18,129,185,206,204,188,203,187,187,187,171,153,24,66,
+69,67,36,51,36,34,51,52,52,52,52,67,50,36,51,51,
+35,1,201,220,219,187,188,172,186,170,155,138,24,50,69,52,
+67,51,67,50,67,67,52,68,51,67,51,67,35,36,34,1,
+168,235,219,187,187,172,170,171,170,154,8,82,52,52,36,34,
+33,34,68,83,52,52,51,52,51,51,52,34,0,202,206,204,
+203,172,187,186,172,171,187,187,187,154,153,169,219,189,189,187,
+171,154,137,153,153,186,187,169,202,236,205,205,188,173,172,186,
+171,187,187,203,186,154,154,137,152,169,219,188,188,170,137,50,
+55,68,51,68,51,52,52,51,34,2,144,169,137,16,68,53,
+53,67,67,52,67,36,51,51,50,34,35,53,53,53,53,36,
+36,67,50,51,52,50,35,18,1,0,0,50,68,52,53,50,
+51,66,50,17,129,185,206,204,186,171,137,16,83,83,51,67,
+51,67,18,1,169,205,189,203,186,170,154,137,153,169,203,235,
+203,204,204,203,188,203,187,170,154,136,16,34,51,52,50,17,
+169,206,205,219,202,170,170,137,9,0,17,17,129,168,205,190,
+205,219,202,170,171,154,136,0,34,66,51,34,2,176,236,188,
+189,188,171,170,9,33,53,52,36,35,1,160,235,204,204,187,
+188,186,170,8,33,83,52,67,50,18,129,169,219,188,188,187,
+154,24,99,68,67,67,34,18,128,186,204,204,187,203,170,137,
+32,68,68,67,67,34,18,1,152,186,188,188,187,154,24,83,
+69,52,67,35,19,1,168,218,203,187,203,153,0,83,69,83,
+51,52,50,18,1,152,202,187,188,187,154,16,68,69,52,67,
+51,50,17,128,168,187,173,155,10,65,69,69,67,52,66,34,
+18,1,128,169,187,203,171,154,32,84,68,52,52,67,34,17,
+128,168,186,204,186,171,137,32,69,68,52,67,35,34,1,152,
+202,203,188,188,170,170,8,33,66,51,35,144,236,220,204,203,
+188,187,188,171,170,137,8,34,50,36,18,129,218,220,219,188,
+188,203,171,171,171,170,170,187,189,204,219,203,188,219,187,187,
+172,170,152,0,16,34,35,33,129,169,206,205,219,187,188,187,
+170,137,9,0,8,168,202,219,189,220,203,203,203,170,153,0,
+34,52,68,50,51,51,35,34,144,218,219,170,138,49,69,53,
+51,36,34,18,1,144,202,220,203,171,154,49,70,53,68,51,
+67,50,51,36,35,34,17,33,49,69,53,69,66,50,50,34,
+34,18,17,136,170,203,171,25,100,69,83,67,51,67,51,67,
+51,51,36,35,67,67,52,53,52,51,36,18,1,128,152,187,
+189,188,188,170,9,65,69,83,51,36,51,51,36,34,34,17,
+0,0,33,68,52,52,35,129,201,205,188,189,203,188,187,172,
+170,9,32,66,51,36,17,144,185,205,188,189,188,188,186,170,
+136,24,16,0,186,191,205,219,203,203,203,187,187,187,170,153,
+152,153,203,205,219,203,203,187,188,187,186,154,8,50,68,51,
+18,168,220,220,203,188,188,188,202,170,170,153,136,0,128,152,
+186,189,204,171,172,186,154,10,64,68,69,51,51,18,144,219,
+204,203,203,187,172,171,154,24,66,53,52,51,34,0,153,169,
+186,170,154,25,115,85,53,69,66,34,18,1,144,168,170,186,
+187,186,137,81,85,53,53,51,36,18,17,128,8,8,16,65,
+67,69,53,68,67,51,51,35,17,136,185,202,186,170,137,65,
+69,84,67,52,51,36,35,18,16,128,8,0,50,69,53,52,
+68,50,36,50,18,129,152,203,203,171,153,32,68,68,67,67,
+35,36,34,17,136,203,219,171,138,16,68,52,52,52,66,34,
+34,1,184,221,219,203,171,171,170,169,169,186,172,187,188,203,
+188,189,188,171,139,24,83,52,36,35,18,152,218,220,204,204,
+187,173,187,172,170,170,169,170,171,186,203,203,219,187,172,187,
+169,9,24,17,17,0,144,235,205,190,205,203,203,186,170,170,
+170,169,171,186,170,187,204,205,204,203,187,171,9,16,51,83,
+50,67,52,51,20,129,219,220,187,187,138,8,17,17,0,8,
+49,99,35,145,237,204,203,154,16,82,52,67,51,51,52,68,
+50,19,1,153,187,139,65,70,68,51,67,34,51,51,52,18,
+152,188,174,171,137,50,54,53,67,36,36,67,51,51,35,17,
+1,16,66,68,52,52,67,35,36,50,35,18,0,170,171,155,
+56,101,68,83,51,68,50,51,51,18,128,169,171,187,137,65,
+84,68,52,53,67,67,18,2,0,169,202,186,188,186,187,187,
+138,8,16,129,217,221,219,203,187,171,171,137,24,52,70,67,
+35,19,128,219,204,189,188,188,203,187,187,171,153,137,136,168,
+202,204,188,188,188,204,171,187,171,137,40,49,35,17,169,220,
+204,204,219,203,203,187,187,170,137,137,169,202,219,203,188,219,
+203,203,187,171,154,8,50,67,51,34,1,185,221,220,204,203,
+172,187,170,154,152,128,136,128,128,152,202,206,189,189,203,186,
+169,137,136,136,8,136,0,144,234,236,219,203,171,154,8,34,
+83,66,50,52,51,35,145,251,204,188,188,170,153,137,0,18,
+52,69,83,35,51,34,16,8,17,68,68,52,83,50,52,67,
+67,50,17,144,185,203,171,138,16,67,53,69,52,53,52,36,
+35,18,17,1,33,51,53,52,52,52,53,83,51,51,18,129,
+153,187,171,171,154,137,32,115,70,68,67,35,34,1,128,137,
+8,16,33,50,52,70,84,67,36,19,2,153,219,187,188,172,
+187,187,172,138,40,68,83,34,2,152,203,203,186,187,187,188,
+187,9,115,68,52,50,1,185,204,219,186,172,187,187,172,138,
+16,68,67,19,129,201,204,188,203,172,187,172,171,137,16,83,
+52,67,18,129,136,170,186,188,173,172,170,137,33,53,51,2,
+217,206,204,203,203,203,187,187,187,154,16,50,53,52,34,18,
+1,136,186,235,203,171,171,136,49,67,19,176,238,204,204,188,
+188,188,203,186,170,153,0,17,51,67,67,34,17,0,169,203,
+187,170,40,99,52,52,34,2,168,221,205,204,219,187,187,156,
+154,8,16,49,51,53,52,51,35,128,185,188,154,32,85,53,
+83,50,51,67,35,35,145,234,220,187,203,169,8,16,34,50,
+67,68,67,52,34,1,168,154,25,100,84,83,50,67,34,51,
+52,35,18,144,219,188,172,138,8,33,50,36,67,83,52,52,
+36,18,129,128,0,82,68,68,35,67,34,34,35,51,18,144,
+204,189,203,154,24,49,68,51,52,67,67,67,50,18,129,169,
+171,155,40,99,83,35,50,18,34,34,1,169,207,204,203,170,
+137,33,99,67,50,51,51,50,18,144,220,204,204,187,187,170,
+154,136,0,8,137,170,186,204,188,204,188,203,171,153,16,67,
+52,35,129,202,221,203,188,219,187,189,203,171,187,170,153,153,
+170,205,219,186,171,170,169,187,205,187,172,153,16,0,200,221,
+188,173,170,153,153,187,190,205,186,187,170,187,190,189,189,186,
+170,137,128,128,152,171,154,33,55,52,17,168,203,154,48,55,
+51,146,221,205,203,187,203,203,188,188,188,170,9,32,51,52,
+50,50,53,69,67,51,34,18,17,50,69,51,19,176,237,219,
+203,186,172,203,187,203,170,8,49,69,67,51,51,36,52,52,
+67,50,18,18,34,51,53,35,129,204,190,189,203,186,187,188,
+171,171,8,82,84,67,51,50,51,51,68,51,67,34,18,34,
+67,52,51,19,184,206,205,187,203,171,187,203,154,9,49,69,
+68,50,35,34,33,34,50,52,36,51,67,52,53,52,51,1,
+185,206,203,172,203,170,171,171,154,24,67,68,50,19,1,128,
+136,24,33,52,68,68,68,83,51,67,17,144,203,204,203,203,
+186,187,172,170,137,16,50,35,2,168,188,172,154,0,34,68,
+68,53,69,67,50,18,152,218,204,187,188,187,172,187,187,138,
+24,51,52,18,144,186,172,9,50,54,52,67,52,69,67,35,
+18,184,221,188,188,187,187,172,171,171,138,32,84,51,36,2,
+128,8,16,83,52,51,35,17,50,99,50,145,252,205,204,186,
+187,170,169,154,154,137,48,70,52,52,33,0,136,0,50,68,
+35,17,153,170,154,16,144,254,236,203,172,170,154,8,8,8,
+8,33,85,52,52,34,1,136,137,33,68,67,18,129,153,8,
+50,53,2,250,220,203,170,137,16,34,18,17,65,100,83,67,
+34,2,128,137,32,83,52,35,34,0,33,99,67,51,145,218,
+204,170,137,32,67,34,18,34,85,52,53,35,1,169,186,170,
+16,66,35,2,137,32,101,84,50,18,168,203,172,154,0,18,
+1,185,219,170,0,18,216,223,204,188,203,154,138,152,128,24,
+48,115,67,67,19,2,168,203,203,203,187,189,188,188,188,186,
+187,203,203,203,187,172,170,136,32,67,68,52,83,51,51,35,
+2,168,220,204,188,188,203,186,187,187,187,171,154,136,33,50,
+50,37,68,69,52,53,67,51,35,35,34,18,160,251,204,188,
+188,187,186,154,170,153,153,32,69,68,51,67,34,34,68,52,
+69,50,35,35,35,50,51,20,144,251,188,188,187,171,154,186,
+203,187,153,49,70,67,35,18,34,84,68,68,51,51,50,34,
+51,52,35,128,220,189,189,187,171,203,187,189,203,170,153,0,
+1,17,0,32,68,70,52,67,35,34,33,50,51,18,176,222,
+204,188,187,187,188,188,188,172,171,138,9,8,0,16,49,85,
+68,52,67,50,50,51,52,36,35,1,168,219,203,187,203,188,
+204,203,171,171,138,136,1,33,66,84,84,67,52,51,52,51,
+67,67,35,35,2,128,170,188,219,203,188,204,187,203,186,169,
+152,8,16,66,68,68,83,51,67,51,51,51,51,19,129,202,
+220,188,189,219,187,188,188,187,187,187,170,170,137,32,82,83,
+52,51,52,51,51,35,34,144,204,205,204,187,188,188,188,172,
+172,186,154,154,136,136,0,33,99,83,67,51,35,35,34,34,
+51,34,168,236,188,188,170,154,169,186,188,156,25,84,68,67,
+35,35,67,52,53,52,51,18,17,0,34,51,52,1,185,189,
+154,56,70,67,34,18,33,99,68,52,67,18,1,0,33,67,
+36,19,128,202,203,170,137,153,235,220,203,187,169,8,17,0,
+136,138,24,100,67,20,1,185,203,156,154,152,186,222,219,203,
+187,172,203,203,219,187,172,171,169,137,136,128,0,34,52,53,
+35,18,152,186,203,170,155,186,204,188,189,187,189,235,203,204,
+203,202,170,170,153,9,16,67,68,68,51,37,67,51,67,51,
+53,51,52,52,51,51,51,18,136,188,206,203,188,203,171,186,
+137,16,68,84,83,51,53,51,68,50,35,67,34,34,18,17,
+129,152,202,204,204,203,203,187,203,170,155,138,24,66,53,68,
+67,51,36,51,50,34,18,0,152,186,188,188,189,204,219,203,
+188,188,188,188,203,187,172,186,170,153,136,32,34,52,52,52,
+67,50,51,35,17,128,185,220,220,188,205,188,188,188,188,203,
+186,187,170,154,24,49,69,83,67,51,52,51,36,50,18,18,
+0,136,169,187,189,188,189,188,203,187,187,170,154,16,82,69,
+68,67,52,52,51,52,35,36,34,50,34,33,18,34,34,34,
+18,1,169,221,188,189,203,187,172,170,137,32,84,68,68,51,
+68,50,51,51,51,35,34,0,169,219,188,189,204,203,188,188,
+188,187,187,172,170,153,8,49,99,52,52,51,36,18,1,136,
+202,204,188,189,188,203,202,170,171,187,172,171,187,170,153,137,
+0,49,99,83,52,52,51,36,33,0,136,186,220,219,203,188,
+203,186,187,187,187,172,187,171,137,32,84,68,52,53,53,52,
+52,52,51,51,51,34,1,152,203,205,219,187,172,187,171,170,
+137,24,66,84,52,53,52,67,67,51,51,52,51,34,17,128,
+185,235,203,219,187,188,203,170,154,137,0,34,67,83,67,51,
+52,51,34,17,17,0,0,8,169,219,188,189,219,203,188,204,
+188,188,203,187,203,186,186,171,170,137,16,66,83,67,67,67,
+67,51,51,35,1,185,221,204,188,189,173,172,187,172,170,169,
+136,17,67,53,53,52,52,51,67,34,18,17,136,170,188,189,
+188,188,203,186,171,171,153,8,65,99,67,68,51,68,66,34,
+35,34,18,1,136,169,187,205,187,172,187,154,153,137,136,153,
+169,154,170,186,204,187,187,49,119,52,68,67,35,51,51,35,
+18,168,220,205,188,188,172,203,202,186,186,187,170,136,33,52,
+69,83,67,52,67,51,35,19,128,169,220,219,188,188,188,203,
+170,170,137,16,50,84,83,67,51,37,51,50,50,33,1,128,
+185,204,204,203,172,203,186,186,171,170,137,16,67,54,52,53,
+51,52,67,50,34,18,0,136,185,202,203,203,203,203,186,188,
+202,187,188,188,188,187,187,187,186,152,16,99,52,53,52,52,
+66,33,34,16,152,186,206,235,202,203,203,187,188,188,187,172,
+171,170,153,136,33,67,68,83,51,51,51,35,1,169,235,204,
+219,203,187,173,171,171,171,155,154,137,32,66,68,52,52,37,
+36,67,51,51,36,35,34,18,16,128,152,153,170,9,64,115,
+68,68,67,52,52,37,36,67,51,83,50,36,36,51,51,52,
+50,51,51,35,18,18,0,128,136,8,32,68,68,53,68,52,
+83,51,52,52,51,52,67,50,34,18,0,168,220,188,190,188,
+189,203,203,187,203,187,187,187,187,186,185,153,169,153,170,203,
+204,204,188,189,189,188,189,203,219,202,186,203,187,187,188,171,
+187,171,171,153,137,8,17,34,51,66,34,18,16,154,174,174,
+203,172,172,172,171,187,187,154,41,98,68,69,83,67,52,68,
+51,52,36,36,51,51,52,51,51,52,35,36,51,51,67,67,
+66,50,52,83,67,67,36,52,67,51,52,36,51,51,36,50,
+34,18,18,1,0,152,169,202,187,172,187,171,154,16,49,38,
+51,19,177,236,205,189,204,188,188,188,188,188,203,203,203,187,
+172,172,187,187,203,186,203,171,188,188,188,204,187,204,202,186,
+187,203,171,187,172,187,203,187,203,187,203,171,171,187,187,188,
+188,188,189,204,187,188,203,170,154,153,0,50,83,67,67,35,
+36,51,67,52,83,51,68,50,36,51,50,67,50,52,53,53,
+68,67,52,67,67,66,34,50,50,51,67,51,68,51,52,52,
+51,52,36,51,51,68,66,51,52,68,50,36,35,35,34,17,
+129,128,128,8,33,67,53,68,51,51,35,18,136,184,186,188,
+203,203,188,190,190,189,205,203,203,187,188,187,171,187,186,170,
+187,204,203,204,203,188,203,203,187,172,172,203,202,186,188,203,
+187,188,186,171,171,154,153,137,153,170,188,190,204,203,187,188,
+187,187,187,187,187,203,187,187,156,137,49,86,68,52,68,51,
+67,50,50,33,18,17,17,67,68,68,83,67,67,51,52,51,
+52,52,67,67,67,67,51,52,50,67,34,33,18,34,50,52,
+53,53,52,52,52,51,52,50,35,51,51,67,51,83,50,34,
+19,1,168,219,188,188,172,154,9,33,83,67,35,18,168,236,
+204,219,203,203,187,203,187,188,188,219,187,204,187,203,187,187,
+187,187,171,187,204,219,203,204,203,187,173,187,172,186,171,187,
+203,187,204,187,219,186,187,171,170,153,128,16,0,153,219,220,
+203,172,171,155,8,49,69,68,51,67,50,34,34,34,83,99,
+67,68,67,36,67,50,35,51,51,67,83,67,83,67,67,67,
+51,67,34,50,18,34,35,67,83,67,52,67,51,67,50,50,
+34,50,51,53,53,52,68,50,50,34,0,168,203,204,187,188,
+170,154,137,136,136,186,220,220,203,203,187,187,186,171,186,219,
+204,204,204,188,188,188,172,187,187,186,186,170,171,203,188,188,
+188,188,172,187,186,170,171,187,204,204,219,203,188,187,188,170,
+170,137,24,33,50,67,18,2,0,152,8,50,85,68,52,52,
+51,35,17,136,153,153,64,116,68,68,52,68,50,67,50,50,
+50,50,66,66,66,51,52,52,66,34,34,33,18,34,83,83,
+83,52,83,51,67,50,34,18,2,0,0,8,17,33,67,50,
+19,129,203,205,204,187,186,154,16,66,68,51,34,144,220,205,
+188,189,188,187,203,186,187,187,188,219,203,203,187,188,187,187,
+187,170,154,170,203,204,204,188,189,203,187,188,186,186,170,171,
+186,202,187,204,186,172,170,169,0,33,52,52,36,18,129,184,
+219,188,187,186,8,50,71,67,36,67,50,50,51,83,83,83,
+83,67,67,51,52,51,51,51,34,35,34,51,53,68,51,53,
+51,67,35,51,51,67,83,52,68,67,52,36,67,34,35,33,
+1,128,152,169,170,170,186,170,203,188,189,189,203,187,172,153,
+0,51,54,52,36,34,0,202,205,204,219,187,188,203,187,203,
+186,188,202,187,187,188,187,187,154,137,24,33,34,17,201,252,
+219,188,204,187,188,187,172,171,187,187,203,171,187,172,169,8,
+49,84,68,67,67,35,35,18,0,153,187,189,187,172,153,9,
+17,35,38,51,84,66,67,68,67,37,52,67,67,50,51,50,
+49,32,0,0,0,1,35,37,53,83,50,52,66,51,52,52,
+68,67,67,51,36,51,51,34,1,145,168,186,219,185,153,9,
+40,65,81,49,50,51,67,51,38,36,51,36,34,8,173,190,
+205,219,203,202,171,187,172,170,170,153,153,136,137,152,169,218,
+203,251,201,202,203,203,188,172,188,172,203,187,202,170,171,169,
+153,8,17,35,37,35,51,32,155,206,235,219,202,203,187,188,
+187,188,171,187,171,154,136,51,86,83,67,83,50,67,50,34,
+17,0,154,188,220,202,186,187,203,170,170,137,40,81,99,83,
+83,67,52,36,36,51,51,35,18,1,168,202,188,189,203,187,
+187,187,172,153,9,32,99,68,68,67,52,52,67,51,35,35,
+18,136,202,219,188,204,187,203,187,172,187,186,170,153,136,34,
+54,53,53,52,52,67,34,34,16,168,202,204,219,203,203,186,
+188,186,203,186,170,154,137,24,66,68,68,67,67,51,51,35,
+19,1,169,189,204,188,188,188,202,187,187,187,187,186,137,48,
+115,99,67,83,51,52,51,36,34,18,0,152,186,204,203,203,
+203,187,203,186,171,186,153,16,83,53,54,52,68,51,67,50,
+35,18,2,144,184,202,188,188,188,188,203,202,186,186,170,138,
+41,81,68,52,53,36,67,34,34,17,128,168,202,203,188,187,
+188,188,187,188,188,187,172,171,155,9,49,85,67,36,36,35,
+17,129,168,204,203,172,187,187,170,154,137,154,170,173,174,203,
+187,171,154,33,53,54,52,36,34,1,152,219,203,203,186,153,
+17,83,68,36,51,19,2,136,156,173,186,154,24,81,83,36,
+36,35,33,136,185,188,187,155,64,84,69,67,67,51,34,18,
+0,154,172,203,186,154,41,56,65,18,0,173,191,188,189,187,
+186,152,34,100,83,51,52,51,35,18,144,187,191,188,189,219,
+186,188,187,172,172,170,186,153,152,18,52,53,53,37,51,36,
+51,49,16,153,189,221,203,188,204,186,187,171,154,9,49,69,
+68,51,52,36,35,35,33,16,128,152,170,219,218,203,219,203,
+203,187,186,170,24,99,69,52,68,67,50,50,18,1,153,187,
+205,187,203,170,154,137,8,16,16,16,24,17,53,86,99,67,
+52,67,51,34,1,169,205,204,203,203,170,170,137,24,50,52,
+37,35,34,1,144,169,170,170,137,33,35,132,216,206,221,203,
+188,203,171,154,8,49,69,83,35,51,19,129,186,220,188,203,
+187,170,138,136,17,19,19,130,168,202,203,137,65,70,53,53,
+67,35,18,152,218,204,188,203,187,154,137,33,68,68,51,67,
+50,18,17,128,152,152,8,0,19,51,32,203,207,204,188,203,
+170,138,32,84,68,52,67,51,35,34,128,185,219,188,203,186,
+170,153,9,0,1,17,0,145,17,82,84,68,83,67,35,35,
+2,152,189,206,203,187,172,171,154,9,32,51,38,36,35,19,
+2,146,168,202,219,203,188,219,202,187,172,187,172,169,136,32,
+99,83,67,51,52,50,18,129,169,205,219,188,172,172,172,170,
+170,153,8,34,69,52,53,67,36,51,50,34,1,168,218,235,
+202,187,188,172,171,171,170,137,17,68,84,67,52,68,66,34,
+50,18,1,144,203,204,188,188,188,171,187,155,138,8,50,69,
+83,52,67,36,36,51,51,50,17,128,202,205,204,203,203,187,
+172,170,154,8,17,52,68,52,67,51,52,50,34,34,16,152,
+218,219,204,203,188,203,187,203,170,153,8,50,84,52,52,52,
+51,51,35,18,129,185,235,203,188,188,188,172,187,172,171,154,
+137,16,99,83,52,52,52,36,50,34,1,136,186,204,204,187,
+188,187,203,170,154,153,8,17,83,99,67,67,67,67,35,51,
+34,1,152,203,205,203,203,187,172,171,169,137,24,33,83,83,
+51,68,50,36,51,51,51,18,129,186,190,190,188,188,172,187,
+170,154,136,33,83,52,52,52,36,35,35,50,17,129,152,172,
+189,189,204,202,186,203,170,153,137,17,67,68,67,52,35,36,
+18,17,144,184,219,188,188,188,172,187,186,170,154,8,50,100,
+67,83,66,50,66,33,1,145,169,204,188,189,203,203,186,170,
+169,8,49,99,83,36,52,51,67,50,18,1,152,218,219,203,
+188,203,187,203,170,154,9,32,83,68,68,67,67,50,36,34,
+18,0,168,188,189,189,188,188,186,171,170,138,0,51,69,37,
+52,52,52,51,67,51,18,2,160,219,204,204,219,186,203,186,
+170,154,8,48,83,68,67,67,51,36,51,50,18,17,152,202,
+220,219,219,187,188,203,171,171,138,136,50,69,68,51,53,51,
+51,51,34,1,152,203,189,189,188,188,188,172,187,186,170,153,
+16,99,83,52,68,51,67,35,35,18,144,169,204,204,187,204,
+186,187,187,171,170,136,32,83,84,67,83,51,52,51,36,34,
+1,144,202,204,219,187,188,187,187,171,153,24,49,68,68,51,
+37,36,35,51,51,35,2,128,202,220,219,203,203,187,187,171,
+170,136,33,68,68,67,51,52,35,35,19,17,144,185,188,190,
+188,188,188,203,187,186,170,137,33,83,53,53,52,51,52,34,
+18,0,169,188,189,204,187,172,187,186,154,153,0,50,69,83,
+67,67,67,50,34,19,1,153,188,190,204,203,187,187,187,154,
+9,33,84,52,68,51,52,51,50,35,1,152,203,190,188,204,
+187,188,187,171,155,9,33,53,39,52,67,36,51,51,34,1,
+160,202,220,203,188,203,187,203,170,169,152,17,51,54,53,37,
+36,51,36,35,34,2,144,186,190,205,203,187,188,172,171,170,
+153,8,34,53,69,67,51,53,66,34,35,34,1,144,186,206,
+219,188,203,172,187,203,170,153,136,33,99,83,67,52,67,51,
+51,36,18,17,152,202,204,204,203,203,203,186,187,170,154,8,
+50,85,83,67,52,51,52,51,50,33,128,185,205,204,203,188,
+203,171,172,170,153,9,32,83,52,53,37,36,51,51,35,19,
+1,169,189,205,188,188,203,187,187,187,154,136,33,84,83,52,
+83,51,67,50,35,18,0,185,235,188,189,188,203,186,171,170,
+138,8,50,69,83,67,67,51,67,34,34,17,152,201,204,188,
+188,188,187,203,169,137,8,34,68,83,51,52,52,50,35,34,
+17,152,218,235,203,188,203,187,187,170,136,33,68,52,68,51,
+52,35,35,33,128,168,203,188,189,204,187,173,187,171,154,8,
+66,68,68,51,52,51,36,18,0,153,219,203,172,187,172,187,
+187,187,187,153,48,85,68,83,51,67,50,35,18,128,201,205,
+203,188,186,171,154,137,0,1,35,68,68,83,51,52,50,34,
+17,144,185,206,204,188,188,172,170,153,16,66,67,67,51,52,
+67,51,51,35,129,168,204,219,219,187,189,173,172,186,154,8,
+49,53,53,67,51,52,50,67,18,17,152,186,204,188,188,203,
+203,188,203,187,154,9,33,53,53,52,67,51,67,51,50,18,
+128,185,219,188,187,189,188,204,203,187,187,154,8,49,68,67,
+52,67,67,36,51,35,34,0,136,154,186,219,204,189,189,188,
+172,171,153,137,24,32,66,83,52,53,52,51,35,19,17,1,
+128,168,235,220,188,204,187,203,154,154,153,8,16,66,68,68,
+67,51,51,34,17,0,136,169,204,204,189,188,203,186,170,153,
+136,24,33,68,84,67,52,51,50,18,0,153,186,204,203,188,
+189,187,187,170,136,49,83,52,52,68,83,51,52,51,34,129,
+168,219,188,188,188,203,171,187,154,24,66,84,51,68,50,51,
+52,67,51,34,2,169,220,204,203,203,171,172,186,154,138,16,
+66,68,51,52,35,35,50,34,35,1,184,207,204,204,187,188,
+203,186,170,154,137,33,83,52,52,35,19,17,8,137,152,168,
+218,204,220,187,188,172,170,154,153,16,82,68,68,51,52,34,
+18,136,169,170,170,154,154,155,173,186,154,49,86,68,83,67,
+52,68,51,52,51,34,128,185,204,203,170,171,169,154,153,8,
+49,69,53,68,67,66,66,51,83,50,33,128,187,191,204,202,
+170,186,170,154,154,137,24,34,52,52,51,67,67,67,51,35,
+128,236,205,204,187,188,187,187,171,170,137,8,49,52,52,51,
+35,18,34,51,37,19,184,223,220,203,172,187,170,154,8,32,
+52,69,67,67,50,35,18,17,16,16,1,2,152,204,189,189,
+187,154,16,84,84,83,67,51,37,51,50,18,1,136,169,186,
+187,188,204,202,187,172,171,136,65,84,52,69,51,52,51,51,
+19,129,169,189,189,204,186,172,187,203,186,187,171,154,24,66,
+69,83,51,52,35,19,17,169,204,189,189,219,186,187,187,172,
+171,171,170,137,40,82,68,67,67,51,51,34,1,168,204,189,
+189,187,188,186,170,153,138,8,17,83,68,53,83,51,67,35,
+35,18,1,168,203,205,187,188,186,153,0,34,68,83,67,83,
+67,67,51,52,34,34,17,0,169,204,204,219,187,172,171,169,
+136,16,66,67,68,83,67,51,52,51,35,19,1,153,204,204,
+204,203,172,172,186,170,154,138,8,33,99,83,83,51,52,51,
+51,51,18,128,186,206,204,219,187,188,203,186,170,170,137,0,
+66,68,83,83,50,67,50,35,34,1,136,202,204,204,187,204,
+186,187,187,186,153,8,50,69,68,67,67,66,34,35,18,2,
+128,185,219,204,187,173,187,172,170,170,137,16,50,84,67,36,
+36,35,51,19,19,0,153,203,219,203,186,187,186,153,8,50,
+85,83,51,67,51,34,17,136,187,191,204,203,203,170,154,9,
+33,68,68,83,51,68,50,35,50,1,152,203,205,219,203,172,
+203,186,186,154,9,32,83,68,67,83,50,67,34,34,1,144,
+186,190,204,188,172,172,187,171,171,137,24,67,68,83,51,68,
+50,50,34,18,128,170,220,203,188,188,188,187,171,171,153,16,
+52,69,67,52,67,51,35,35,18,128,185,188,205,203,203,187,
+187,172,153,9,49,99,52,68,51,52,35,51,18,1,169,219,
+219,203,187,203,203,170,154,138,16,51,70,67,52,67,35,36,
+18,1,152,203,204,203,203,171,172,186,170,170,138,24,49,69,
+83,67,66,51,67,35,34,0,185,204,204,187,188,203,186,203,
+186,186,170,154,128,34,84,99,67,52,68,50,36,18,18,16,
+136,169,202,203,189,188,188,173,187,203,170,171,137,32,99,68,
+68,67,51,67,50,34,18,17,136,186,190,189,189,219,187,203,
+187,186,155,137,33,69,68,67,67,51,51,36,18,2,128,185,
+235,203,204,202,187,203,187,186,170,137,33,68,68,52,51,37,
+50,34,18,1,152,185,188,189,188,188,203,171,187,171,137,32,
+99,52,53,67,51,35,18,1,168,202,188,173,171,170,153,128,
+33,66,68,67,68,51,52,36,19,18,152,203,190,189,204,187,
+203,170,138,24,49,68,68,51,52,52,50,51,35,1,144,219,
+204,189,188,204,187,187,172,154,136,17,83,83,67,51,52,35,
+20,18,17,152,185,204,188,204,203,203,186,171,170,137,32,83,
+68,67,67,35,36,34,17,129,136,186,204,203,172,203,187,187,
+171,154,24,83,69,83,51,52,51,51,34,1,153,204,188,204,
+187,187,172,171,169,152,17,99,83,68,51,52,36,35,19,17,
+168,218,204,219,187,172,187,187,170,153,24,49,84,83,83,66,
+50,51,51,35,1,168,220,219,188,173,187,172,171,169,153,0,
+33,67,53,68,51,52,51,51,35,18,144,219,204,204,203,187,
+203,186,154,137,24,50,68,83,51,37,51,67,34,34,2,0,
+170,204,189,188,188,187,187,155,9,48,68,53,52,52,67,50,
+35,34,2,129,184,219,204,204,202,187,203,171,154,8,48,115,
+67,67,67,51,50,35,33,128,168,188,205,219,187,189,203,202,
+170,154,153,0,66,52,53,68,50,51,51,18,130,160,202,204,
+219,203,203,187,188,187,171,155,9,33,85,83,67,67,51,51,
+35,18,129,184,219,204,203,203,187,188,171,187,170,136,49,85,
+83,52,67,36,35,35,18,129,153,188,189,173,172,187,187,187,
+171,154,16,83,84,83,67,67,51,51,51,33,136,202,205,203,
+188,203,187,187,186,170,9,32,99,83,52,52,52,67,35,35,
+17,144,202,204,204,187,173,187,187,171,154,9,32,82,68,67,
+52,67,51,36,35,17,0,170,204,189,188,188,172,171,155,154,
+136,17,52,68,83,51,52,67,50,34,18,129,169,235,219,219,
+186,172,171,154,153,16,34,53,53,52,67,51,51,35,34,1,
+153,188,190,189,188,172,187,187,154,8,50,69,68,51,37,51,
+50,34,17,152,186,205,219,203,203,203,186,171,171,138,0,83,
+52,54,67,67,35,51,33,0,168,203,189,188,189,203,187,203,
+186,170,153,8,50,69,68,67,36,67,34,35,17,129,169,203,
+204,203,203,187,188,187,187,170,153,16,52,54,53,53,67,51,
+51,51,33,128,186,220,203,188,188,203,187,202,169,169,128,49,
+99,83,67,52,51,52,35,34,0,168,188,205,203,203,187,172,
+187,170,154,8,33,84,52,53,52,67,51,67,33,0,152,202,
+204,219,187,219,186,186,170,154,8,48,68,68,52,52,52,51,
+67,18,2,136,202,188,189,204,186,172,171,170,154,137,32,67,
+68,68,51,37,51,36,34,17,128,169,204,188,189,203,186,203,
+154,154,136,0,50,53,53,52,52,51,52,34,18,0,170,189,
+205,203,202,186,186,170,137,0,49,68,52,52,67,67,50,34,
+34,0,170,204,189,204,203,186,187,170,153,17,68,52,53,67,
+51,36,34,18,129,152,203,189,189,188,204,186,171,171,138,24,
+67,69,68,51,52,67,34,34,1,144,170,189,205,187,204,171,
+172,171,154,138,0,67,69,67,52,52,51,67,18,17,136,185,
+189,204,188,203,187,187,172,170,153,24,50,85,83,51,53,66,
+34,34,2,128,169,204,188,188,188,172,187,186,170,137,24,65,
+99,67,52,52,67,50,35,33,128,169,220,203,188,203,187,172,
+170,153,137,16,51,53,69,51,52,36,51,35,18,129,185,220,
+188,204,187,203,170,155,153,24,33,68,67,52,52,51,36,35,
+34,17,144,186,206,219,203,202,186,170,154,136,17,67,53,52,
+36,51,36,18,17,129,152,202,219,219,187,204,186,171,170,153,
+32,99,83,67,67,51,35,19,1,152,219,219,203,172,187,172,
+187,170,154,9,34,69,53,52,53,51,36,34,2,144,201,204,
+219,203,202,170,186,154,138,8,49,99,83,67,67,67,51,51,
+35,18,152,219,251,187,204,187,203,186,170,137,8,34,53,53,
+68,66,35,36,50,34,2,145,185,205,188,189,219,186,171,171,
+154,9,48,99,83,67,51,68,50,50,50,33,0,153,189,189,
+189,173,187,172,171,170,137,24,51,69,52,52,52,67,50,34,
+18,1,160,202,220,203,203,188,187,187,172,153,8,33,52,54,
+83,51,67,50,35,19,2,144,186,205,204,203,187,173,187,187,
+185,136,40,83,68,67,67,67,50,50,34,16,144,184,204,188,
+204,187,188,203,186,170,153,24,66,68,83,67,51,51,36,34,
+1,144,185,204,219,202,187,172,187,187,171,138,41,82,68,52,
+53,67,50,35,19,17,153,218,203,188,188,172,187,186,171,154,
+137,2,53,69,67,52,36,51,36,33,16,153,203,204,203,203,
+187,187,171,170,153,24,49,68,68,83,67,50,52,66,33,17,
+136,170,204,204,202,202,170,170,170,153,136,32,64,81,65,66,
+66,51,52,51,36,18,2,152,187,206,219,186,172,156,171,185,
+169,153,137,40,80,97,65,67,52,52,51,37,34,33,0,185,
+235,203,203,188,203,186,187,172,169,137,41,65,68,52,38,36,
+67,50,35,18,1,168,219,204,219,187,203,203,170,170,169,8,
+16,52,53,38,52,51,52,51,35,2,144,202,204,189,203,172,
+187,187,186,153,9,49,68,68,67,67,67,35,35,35,17,137,
+187,191,189,203,203,186,170,169,8,48,67,53,52,52,51,67,
+18,3,145,168,188,205,203,188,202,170,154,137,17,52,69,67,
+67,35,51,18,146,176,235,188,188,188,188,187,187,170,137,48,
+115,83,52,52,52,51,51,34,129,185,220,204,219,187,203,171,
+171,155,137,32,83,68,83,67,66,50,51,50,33,128,202,204,
+188,189,203,187,203,170,153,8,33,67,53,53,67,51,36,51,
+34,17,128,186,205,173,188,188,202,170,170,153,128,49,83,52,
+52,52,36,35,35,19,17,152,217,218,203,203,187,188,186,171,
+137,41,65,83,67,36,36,34,50,17,16,152,185,203,204,202,
+186,187,203,169,9,56,96,65,35,36,34,130,177,233,202,172,
+172,187,186,152,17,37,53,37,52,67,50,35,19,146,192,218,
+204,188,204,187,219,185,169,152,17,36,54,83,51,37,51,50,
+34,17,152,187,191,189,188,188,203,171,171,154,9,49,100,67,
+83,51,52,51,51,50,16,169,235,219,188,188,203,203,170,155,
+154,8,49,84,83,67,67,51,67,34,33,0,168,203,189,189,
+219,186,172,170,155,138,8,49,53,69,67,51,52,67,34,17,
+129,168,203,189,204,203,202,170,171,170,137,24,65,83,52,52,
+37,51,51,35,19,145,184,205,235,202,202,186,187,186,170,137,
+32,67,69,67,52,67,51,51,50,33,144,186,206,219,187,204,
+186,187,186,153,136,34,84,83,67,51,52,51,51,19,2,153,
+204,204,203,188,172,187,187,171,153,1,67,53,53,68,50,67,
+34,34,2,128,185,204,188,189,188,203,186,170,170,136,17,52,
+69,36,52,67,50,35,18,2,160,202,204,188,188,188,172,171,
+171,154,8,48,99,52,68,67,50,67,34,2,130,144,187,205,
+188,188,203,203,170,186,153,25,32,68,83,52,67,51,52,50,
+34,1,136,187,175,188,188,188,187,172,170,154,9,32,83,68,
+67,67,67,50,51,49,17,136,187,205,188,173,172,187,187,171,
+155,137,32,68,99,51,53,67,51,35,35,18,144,201,235,203,
+188,203,187,187,172,154,136,16,82,83,67,67,51,36,51,50,
+17,128,186,205,219,203,203,187,187,187,170,136,17,37,53,53,
+67,67,50,51,50,17,144,186,205,204,203,202,186,187,186,170,
+8,48,99,83,67,67,51,36,51,34,48,9,156,173,188,204,
+202,186,202,169,153,8,40,51,69,83,66,50,51,51,35,3,
+144,201,188,175,203,187,172,187,187,154,10,16,21,53,99,50,
+67,35,20,3,18,24,154,219,188,188,188,172,156,171,169,152,
+0,50,84,67,67,51,52,51,34,18,16,155,235,203,188,219,
+187,187,203,185,161,145,4,37,67,67,51,36,51,34,147,179,
+211,185,187,175,202,170,140,171,153,42,75,56,98,64,33,4,
+19,35,32,0,177,177,185,13,155,155,28,29,27,26,169,163,
+3,19,49,49,48,17,162,163,177,145,169,185,145,41,43,144,
+3,18,17,2,17,144,178,211,178,194,177,243,161,8,9,9,
+16,57,73,40,3,133,131,147,18,25,59,30,10,11,29,28,
+185,178,0,25,145,164,149,34,72,56,64,73,41,152,9,11,
+13,12,11,14,10,9,42,25,19,65,17,19,5,18,33,57,
+41,26,10,171,171,140,13,155,138,27,26,146,19,21,18,51
 };
+
+static const imaAdpcm_state_t powerUp48k_wav_index[60] __attribute__((section(".rodata.sounds"), aligned(4))) = {
+{-1, 0},
+{795, 50},
+{-2595, 42},
+{2433, 37},
+{-4267, 44},
+{5641, 44},
+{-3634, 42},
+{5195, 43},
+{365, 52},
+{1670, 33},
+{1771, 41},
+{-2787, 47},
+{2645, 46},
+{1318, 40},
+{11360, 51},
+{-4963, 41},
+{-2802, 38},
+{1653, 24},
+{3324, 39},
+{-1611, 35},
+{-38, 36},
+{-1008, 38},
+{453, 26},
+{387, 38},
+{613, 28},
+{-1034, 43},
+{7629, 39},
+{-4756, 47},
+{-10263, 26},
+{1528, 46},
+{3344, 29},
+{-597, 38},
+{-1042, 49},
+{-1262, 53},
+{173, 44},
+{3789, 37},
+{7677, 46},
+{-7217, 44},
+{-6535, 42},
+{-9931, 47},
+{-26924, 33},
+{-22985, 47},
+{-14480, 43},
+{-10123, 33},
+{-6632, 44},
+{2277, 36},
+{-3816, 50},
+{5859, 37},
+{-3860, 37},
+{1767, 23},
+{-13292, 40},
+{751, 23},
+{-479, 32},
+{1818, 35},
+{-1176, 43},
+{124, 35},
+{-668, 26},
+{-213, 23},
+{161, 12},
+{23, 0}
+};
+
+const imaAdpcm_clip_t powerUp48k_wav_clip = {powerUp48k_wav_data, powerUp48k_wav_index, 60480};
@@ -5,6 +5,10 @@
 #include <string.h>
 #include <ctype.h>
 
+#include "../imaAdpcm.h"
+
+// Build with the IMA-ADPCM encoder: gcc wav2c.c ../imaAdpcm.c ../benchmark.c -lm -o wav2c
+// wav2c file.wav writes 16-bit samples; wav2c -a file.wav writes an IMA-ADPCM clip (4 bits per sample, see imaAdpcm.h).
 
 // Leave the following line uncommented unless you want to generate a simple tone.
 //#define GENERATE_TONE
@@ -14,7 +18,11 @@
 #define H_FILE_SUFFIX ".h"      // .h files have this suffix.
 #define C_FILE_SUFFIX ".c"      // .c files have this suffix.
 #define EXTERN_STATEMENT "extern"  // Just the C extern statement.
-#define C_DATA_TYPE "uint16_t"  // Type for data in the .c file
+#define C_DATA_TYPE "const uint16_t"  // Type for data in the .c file. Const, so it is never written or copied.
+#define SECTION_ATTRIBUTE "__attribute__((section(\".rodata.sounds\"), aligned(4)))"  // Read-only section the linker script places with .rodata.
+#define ADPCM_OPTION "-a"       // Command-line option for IMA-ADPCM output.
+#define ADPCM_INCLUDE "../imaAdpcm.h"  // Included by the .h file of an ADPCM clip.
+#define ADPCM_BYTES_PER_LINE 16 // Bytes of ADPCM data per line in the .c file.
 #define SUPPORTED_WAVE_DATA_BIT_SIZE 16  // Program can only handle this size of data for now.
 
 // Header-specific defines. All sizes are numbered in bytes.
@@ -124,14 +132,58 @@ const char *get_filename_extension(const char* fileName) {
   return dot + 1;                            // Advance to the string that follows "."
 }
 
+// Reads all samples and writes them to the .c and .h files as an IMA-ADPCM clip: the data, the index table and
+// an imaAdpcm_clip_t named <arrayName>_clip.
+void writeAdpcmClip(FILE* inputFileFp, waveFileHeader_t* header, FILE* hFileFp, FILE* cFileFp,
+                    const char* inputFileName, const char* arrayName, const char* arrayNameUpperCase) {
+  uint32_t sampleCount = header->subchunk2Size/2;  // Wave file is counted by bytes, samples are 16 bits.
+  int16_t* samples = malloc(sampleCount * sizeof(int16_t));
+  uint32_t dataSize = imaAdpcm_getDataSize(sampleCount);
+  uint8_t* data = malloc(dataSize);
+  uint32_t indexCount = imaAdpcm_getIndexCount(sampleCount);
+  imaAdpcm_state_t* index = malloc(indexCount * sizeof(imaAdpcm_state_t));
+  if (!samples || !data || !index || sampleCount == 0) {
+    fprintf(stderr, "ERROR: no samples, or out of memory.\n");
+    exit(-1);
+  }
+  if (fread(samples, sizeof(int16_t), sampleCount, inputFileFp) != sampleCount) {  // PCM data is signed.
+    fprintf(stderr, "ERROR: %s ends before its last sample.\n", inputFileName);
+    exit(-1);
+  }
+  imaAdpcm_encode(samples, sampleCount, data, index);
+  // .h file: the clip and its sizes.
+  fprintf(hFileFp, "// This file was generated by executing this statement: wav2c %s %s\n", ADPCM_OPTION, inputFileName);
+  fprintf(hFileFp, "#include \"%s\"\n", ADPCM_INCLUDE);
+  fprintf(hFileFp, "%s const imaAdpcm_clip_t %s_clip;\n", EXTERN_STATEMENT, arrayName);
+  fprintf(hFileFp, "#define %s_SAMPLE_RATE %d\n", arrayNameUpperCase, header->sampleRate);
+  fprintf(hFileFp, "#define %s_BITS_PER_SAMPLE %d\n", arrayNameUpperCase, header->bitsPerSample);
+  fprintf(hFileFp, "#define %s_NUMBER_OF_SAMPLES %d\n", arrayNameUpperCase, sampleCount);
+  // .c file: two samples per byte, then the decoder state every IMA_ADPCM_INDEX_INTERVAL samples.
+  fprintf(cFileFp, "// This file was generated by executing this statement: wav2c %s %s\n", ADPCM_OPTION, inputFileName);
+  fprintf(cFileFp, "\n#include \"%s.h\"\n\n", inputFileName);
+  fprintf(cFileFp, "static const uint8_t %s_data[%d] %s = {\n", arrayName, dataSize, SECTION_ATTRIBUTE);
+  for (uint32_t i=0; i<dataSize; i++)
+    fprintf(cFileFp, "%d%s", data[i], i == dataSize-1 ? "\n" : (i % ADPCM_BYTES_PER_LINE == ADPCM_BYTES_PER_LINE-1) ? ",\n" : ",");
+  fprintf(cFileFp, "};\n\n");
+  fprintf(cFileFp, "static const imaAdpcm_state_t %s_index[%d] %s = {\n", arrayName, indexCount, SECTION_ATTRIBUTE);
+  for (uint32_t i=0; i<indexCount; i++)
+    fprintf(cFileFp, "{%d, %d}%s\n", index[i].predictor, index[i].stepIndex, i == indexCount-1 ? "" : ",");
+  fprintf(cFileFp, "};\n\n");
+  fprintf(cFileFp, "const imaAdpcm_clip_t %s_clip = {%s_data, %s_index, %d};\n", arrayName, arrayName, arrayName, sampleCount);
+  free(samples);
+  free(data);
+  free(index);
+}
+
 int main(int argc, char* argv[]) {
   // Print a helpful error message and exit if a file-name was not provided on the command line.
-  if (argc != 2) {
-    fprintf(stderr, "Usage: wav2c filename.wav\n");
+  bool adpcm = argc == 3 && !strcmp(argv[1], ADPCM_OPTION);  // Write an IMA-ADPCM clip instead of 16-bit samples.
+  if (argc != 2 && !adpcm) {
+    fprintf(stderr, "Usage: wav2c [%s] filename.wav\n", ADPCM_OPTION);
     exit(-1);
   }
   char inputFileName[MAX_FILENAME_LENGTH];         // Create a working buffer.
-  strncpy(inputFileName, argv[1], MAX_FILENAME_LENGTH);  // Copy the argv[1] filename into the working buffer.
+  strncpy(inputFileName, argv[argc-1], MAX_FILENAME_LENGTH);  // Copy the filename into the working buffer.
   // Make sure that the file-name has a .wav suffix.
   const char* extension = get_filename_extension(inputFileName);  // Get the suffix.
   // Compare the suffix and generate an error message if it is incorrect.
@@ -143,7 +195,7 @@ int main(int argc, char* argv[]) {
   // Try to open the file.
   FILE* inputFileFp = fopen(inputFileName, "rb");
   if (inputFileFp == NULL) {
-    printf("unable to find file:%s\n", argv[1]);
+    printf("unable to find file:%s\n", argv[argc-1]);
     exit(-1);
   }
   // File is present and has correct extension if you get this far.
@@ -206,10 +258,17 @@ int main(int argc, char* argv[]) {
   }
   arrayNameUpperCase[i+1] = '\0';  // Make sure to terminate the string.
  
+  if (adpcm) {
+    writeAdpcmClip(inputFileFp, &header, hFileFp, cFileFp, inputFileName, arrayName, arrayNameUpperCase);
+    fclose(hFileFp);
+    fclose(cFileFp);
+    fclose(inputFileFp);
+    return 0;
+  }
   // .h file just needs a comment and an extern statement.
   fprintf(hFileFp, "// This file was generated by executing this statement: wav2c %s\n", inputFileName);
-  fprintf(hFileFp, "%s uint16_t %s[];\n", EXTERN_STATEMENT, arrayName);
-  fprintf(hFileFp, "#define %s_SAMPLE_RATE %d\n", arrayNameUpperCase, header.sampleRate*10);
+  fprintf(hFileFp, "%s %s %s[];\n", EXTERN_STATEMENT, C_DATA_TYPE, arrayName);
+  fprintf(hFileFp, "#define %s_SAMPLE_RATE %d\n", arrayNameUpperCase, header.sampleRate);
   fprintf(hFileFp, "#define %s_BITS_PER_SAMPLE %d\n", arrayNameUpperCase, header.bitsPerSample);
   fprintf(hFileFp, "#define %s_NUMBER_OF_SAMPLES %d\n", arrayNameUpperCase, header.subchunk2Size/2);
   fclose(hFileFp);
@@ -218,7 +277,7 @@ int main(int argc, char* argv[]) {
   // Write some helpful comments to the .c file.
   fprintf(cFileFp, "// This file was generated by executing this statement: wav2c %s\n", inputFileName);
   fprintf(cFileFp, "\n#include <stdint.h>\n\n");
-  fprintf(cFileFp, "%s %s[%d] = {\n", C_DATA_TYPE, arrayName, arraySize);
+  fprintf(cFileFp, "%s %s[%d] %s = {\n", C_DATA_TYPE, arrayName, arraySize, SECTION_ATTRIBUTE);
   // File pointer to the input file should be pointing at the first value after the header is read, so just start from there.
   for (i=0; i<header.subchunk2Size/2; i++) {
     int16_t data;  // Program only handles 16-bit PCM data for now. PCM data is signed.
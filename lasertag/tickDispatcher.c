@@ -0,0 +1,343 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "benchmark.h"
+#include "tickDispatcher.h"
+
+#define TICK_DISPATCHER_WHEEL_MASK (TICK_DISPATCHER_WHEEL_SIZE - 1)
+#define TICK_DISPATCHER_NONE 0 // Links hold id + 1, so 0 is the end of a list.
+
+typedef struct {
+  const char *name;
+  tickDispatcher_tickFunction_t tick;
+  bool armed;        // In the wheel (ISR only).
+  uint32_t dueTick;  // Tick count at which it is called (ISR only).
+  uint8_t next;      // Next module in the same slot, id + 1.
+  uint8_t previous;  // Previous module in the same slot, id + 1.
+  uint32_t callCount;
+  // Latest request, applied by the ISR when the pending bit is set.
+  volatile bool requestArmed;
+  volatile uint32_t requestDueTick;
+} tickDispatcher_module_t;
+
+static tickDispatcher_module_t
+    tickDispatcher_modules[TICK_DISPATCHER_MAX_MODULE_COUNT];
+static uint16_t tickDispatcher_moduleCount;
+static uint8_t tickDispatcher_wheel[TICK_DISPATCHER_WHEEL_SIZE]; // id + 1.
+static volatile uint32_t tickDispatcher_tickCount;
+static _Atomic uint32_t tickDispatcher_pendingMask; // Bit id: new request.
+static bool tickDispatcher_dispatching;             // Calling tick functions.
+
+// Removes all modules and sets the tick count to 0.
+void tickDispatcher_init() {
+  tickDispatcher_moduleCount = 0;
+  for (uint16_t slot = 0; slot < TICK_DISPATCHER_WHEEL_SIZE; slot++)
+    tickDispatcher_wheel[slot] = TICK_DISPATCHER_NONE;
+  tickDispatcher_tickCount = 0;
+  atomic_store(&tickDispatcher_pendingMask, 0);
+}
+
+// Registers a module that is not armed, or returns the id it already has.
+tickDispatcher_id_t
+tickDispatcher_register(const char *name, tickDispatcher_tickFunction_t tick) {
+  for (uint16_t id = 0; id < tickDispatcher_moduleCount; id++)
+    if (tickDispatcher_modules[id].tick == tick)
+      return id;
+  if (tickDispatcher_moduleCount >= TICK_DISPATCHER_MAX_MODULE_COUNT) {
+    printf("tickDispatcher_register(): no room for module %s.\n", name);
+    return -1;
+  }
+  tickDispatcher_module_t *module =
+      &tickDispatcher_modules[tickDispatcher_moduleCount];
+  module->name = name;
+  module->tick = tick;
+  module->armed = false;
+  module->callCount = 0;
+  module->requestArmed = false;
+  return tickDispatcher_moduleCount++;
+}
+
+// Adds a module to the wheel slot of its due tick.
+static void tickDispatcher_link(tickDispatcher_id_t id) {
+  tickDispatcher_module_t *module = &tickDispatcher_modules[id];
+  uint32_t slot = module->dueTick & TICK_DISPATCHER_WHEEL_MASK;
+  module->previous = TICK_DISPATCHER_NONE;
+  module->next = tickDispatcher_wheel[slot];
+  if (module->next != TICK_DISPATCHER_NONE)
+    tickDispatcher_modules[module->next - 1].previous = id + 1;
+  tickDispatcher_wheel[slot] = id + 1;
+  module->armed = true;
+}
+
+// Removes a module from its wheel slot.
+static void tickDispatcher_unlink(tickDispatcher_id_t id) {
+  tickDispatcher_module_t *module = &tickDispatcher_modules[id];
+  if (module->previous != TICK_DISPATCHER_NONE)
+    tickDispatcher_modules[module->previous - 1].next = module->next;
+  else
+    tickDispatcher_wheel[module->dueTick & TICK_DISPATCHER_WHEEL_MASK] =
+        module->next;
+  if (module->next != TICK_DISPATCHER_NONE)
+    tickDispatcher_modules[module->next - 1].previous = module->previous;
+  module->armed = false;
+}
+
+// Records the request, then sets the pending bit, so that the ISR never sees
+// the bit without the request. From a tick function, the ISR is already
+// running, so the wheel is changed right away.
+static void tickDispatcher_request(tickDispatcher_id_t id, bool armed,
+                                   uint32_t dueTick) {
+  if (id < 0)
+    return; // The module could not register.
+  if (tickDispatcher_dispatching) {
+    if (tickDispatcher_modules[id].armed)
+      tickDispatcher_unlink(id);
+    tickDispatcher_modules[id].dueTick = dueTick;
+    if (armed)
+      tickDispatcher_link(id);
+    return;
+  }
+  tickDispatcher_modules[id].requestDueTick = dueTick;
+  tickDispatcher_modules[id].requestArmed = armed;
+  atomic_fetch_or_explicit(&tickDispatcher_pendingMask, 1 << id,
+                           memory_order_release);
+}
+
+// Calls the module's tick function delayTicks ticks from now, once.
+void tickDispatcher_arm(tickDispatcher_id_t id, uint32_t delayTicks) {
+  if (delayTicks == 0)
+    delayTicks = 1;
+  tickDispatcher_request(id, true, tickDispatcher_tickCount + delayTicks);
+}
+
+// Cancels the arming of a module.
+void tickDispatcher_disarm(tickDispatcher_id_t id) {
+  tickDispatcher_request(id, false, 0);
+}
+
+// Moves the modules with a pending request in or out of the wheel. A due tick
+// that has already passed (the request came in late) becomes now.
+static void tickDispatcher_applyRequests(uint32_t now) {
+  uint32_t pending = atomic_exchange_explicit(&tickDispatcher_pendingMask, 0,
+                                              memory_order_acquire);
+  while (pending) {
+    tickDispatcher_id_t id = __builtin_ctz(pending);
+    pending &= pending - 1;
+    tickDispatcher_module_t *module = &tickDispatcher_modules[id];
+    if (module->armed)
+      tickDispatcher_unlink(id);
+    if (module->requestArmed) {
+      module->dueTick = module->requestDueTick;
+      if ((int32_t)(module->dueTick - now) < 0)
+        module->dueTick = now;
+      tickDispatcher_link(id);
+    }
+  }
+}
+
+// Advances the tick count, applies the requests and calls the modules that
+// are due. The due modules are taken out of the wheel first, so their tick
+// functions can arm and disarm anything.
+void tickDispatcher_tick() {
+  uint32_t now = tickDispatcher_tickCount + 1;
+  tickDispatcher_tickCount = now;
+  if (atomic_load_explicit(&tickDispatcher_pendingMask, memory_order_relaxed))
+    tickDispatcher_applyRequests(now);
+  uint8_t link = tickDispatcher_wheel[now & TICK_DISPATCHER_WHEEL_MASK];
+  if (link == TICK_DISPATCHER_NONE)
+    return;
+  tickDispatcher_id_t due[TICK_DISPATCHER_MAX_MODULE_COUNT];
+  uint16_t dueCount = 0;
+  while (link != TICK_DISPATCHER_NONE) {
+    tickDispatcher_id_t id = link - 1;
+    link = tickDispatcher_modules[id].next;
+    if (tickDispatcher_modules[id].dueTick == now) { // Not a later lap.
+      tickDispatcher_unlink(id);
+      due[dueCount++] = id;
+    }
+  }
+  tickDispatcher_dispatching = true;
+  for (uint16_t i = 0; i < dueCount; i++) {
+    tickDispatcher_modules[due[i]].callCount++;
+    tickDispatcher_modules[due[i]].tick();
+  }
+  tickDispatcher_dispatching = false;
+}
+
+// Returns the number of ticks since tickDispatcher_init().
+uint32_t tickDispatcher_getTickCount() { return tickDispatcher_tickCount; }
+
+// Returns how many times a module's tick function was called.
+uint32_t tickDispatcher_getCallCount(tickDispatcher_id_t id) {
+  return tickDispatcher_modules[id].callCount;
+}
+
+/*******************************************************
+ ****************** Test Routines **********************
+ ******************************************************/
+
+#define TICK_DISPATCHER_TEST_TICK_COUNT 10000
+#define TICK_DISPATCHER_TEST_PERIOD 7 // Re-arms itself every 7 ticks.
+#define TICK_DISPATCHER_TEST_LONG_DELAY                                        \
+  (3 * TICK_DISPATCHER_WHEEL_SIZE + 5) // Laps the wheel 3 times.
+
+static tickDispatcher_id_t tickDispatcher_testPeriodicId;
+static uint32_t tickDispatcher_testPeriodicErrors; // Called at a wrong tick.
+static uint32_t tickDispatcher_testLongCallTick;   // When the long one ran.
+
+// Re-arms itself and checks that it is called every
+// TICK_DISPATCHER_TEST_PERIOD ticks.
+static void tickDispatcher_testPeriodicTick() {
+  if (tickDispatcher_getTickCount() % TICK_DISPATCHER_TEST_PERIOD)
+    tickDispatcher_testPeriodicErrors++;
+  tickDispatcher_arm(tickDispatcher_testPeriodicId,
+                     TICK_DISPATCHER_TEST_PERIOD);
+}
+
+static void tickDispatcher_testLongTick() {
+  tickDispatcher_testLongCallTick = tickDispatcher_getTickCount();
+}
+
+static void tickDispatcher_testNeverTick() {}
+
+// Runs a module that re-arms itself every TICK_DISPATCHER_TEST_PERIOD ticks,
+// a one-shot module with a delay that laps the wheel, and a module that is
+// armed and then disarmed.
+bool tickDispatcher_runTest() {
+  tickDispatcher_init();
+  tickDispatcher_testPeriodicErrors = 0;
+  tickDispatcher_testLongCallTick = 0;
+  tickDispatcher_testPeriodicId =
+      tickDispatcher_register("periodic", tickDispatcher_testPeriodicTick);
+  tickDispatcher_id_t longId =
+      tickDispatcher_register("long", tickDispatcher_testLongTick);
+  tickDispatcher_id_t neverId =
+      tickDispatcher_register("never", tickDispatcher_testNeverTick);
+  tickDispatcher_arm(tickDispatcher_testPeriodicId,
+                     TICK_DISPATCHER_TEST_PERIOD);
+  tickDispatcher_arm(longId, TICK_DISPATCHER_TEST_LONG_DELAY);
+  tickDispatcher_arm(neverId, 1);
+  tickDispatcher_disarm(neverId);
+  for (uint32_t i = 0; i < TICK_DISPATCHER_TEST_TICK_COUNT; i++)
+    tickDispatcher_tick();
+  bool success = true;
+  uint32_t periodicCalls =
+      TICK_DISPATCHER_TEST_TICK_COUNT / TICK_DISPATCHER_TEST_PERIOD;
+  if (tickDispatcher_getCallCount(tickDispatcher_testPeriodicId) !=
+          periodicCalls ||
+      tickDispatcher_testPeriodicErrors) {
+    printf("* Error: periodic module called %u times (%u at a wrong tick), "
+           "should be %u.\n",
+           tickDispatcher_getCallCount(tickDispatcher_testPeriodicId),
+           tickDispatcher_testPeriodicErrors, periodicCalls);
+    success = false;
+  }
+  if (tickDispatcher_getCallCount(longId) != 1 ||
+      tickDispatcher_testLongCallTick != TICK_DISPATCHER_TEST_LONG_DELAY) {
+    printf("* Error: long module called %u times, at tick %u, should be once "
+           "at tick %u.\n",
+           tickDispatcher_getCallCount(longId),
+           tickDispatcher_testLongCallTick, TICK_DISPATCHER_TEST_LONG_DELAY);
+    success = false;
+  }
+  if (tickDispatcher_getCallCount(neverId) != 0) {
+    printf("* Error: disarmed module was called.\n");
+    success = false;
+  }
+  printf("=== Tick dispatcher test %s.\n", success ? "passed" : "failed");
+  return success;
+}
+
+#define TICK_DISPATCHER_BENCHMARK_MODULE_COUNT 7 // The lasertag state machines.
+#define TICK_DISPATCHER_BENCHMARK_TICK_COUNT 1000000
+
+// Stands in for an idle lasertag state machine: a switch on a volatile state
+// with nothing to do, like the tick functions called from isr_function().
+typedef enum {
+  tickDispatcher_benchmarkIdle_st,
+  tickDispatcher_benchmarkBusy_st
+} tickDispatcher_benchmarkState_t;
+static volatile tickDispatcher_benchmarkState_t
+    tickDispatcher_benchmarkStates[TICK_DISPATCHER_BENCHMARK_MODULE_COUNT];
+static tickDispatcher_id_t
+    tickDispatcher_benchmarkIds[TICK_DISPATCHER_BENCHMARK_MODULE_COUNT];
+
+// Runs one state machine. A busy one re-arms itself for the next tick.
+static void tickDispatcher_benchmarkTick(uint16_t module) {
+  switch (tickDispatcher_benchmarkStates[module]) {
+  case tickDispatcher_benchmarkIdle_st:
+    break;
+  case tickDispatcher_benchmarkBusy_st:
+    tickDispatcher_arm(tickDispatcher_benchmarkIds[module], 1);
+    break;
+  }
+}
+
+static void tickDispatcher_benchmarkTick0() { tickDispatcher_benchmarkTick(0); }
+static void tickDispatcher_benchmarkTick1() { tickDispatcher_benchmarkTick(1); }
+static void tickDispatcher_benchmarkTick2() { tickDispatcher_benchmarkTick(2); }
+static void tickDispatcher_benchmarkTick3() { tickDispatcher_benchmarkTick(3); }
+static void tickDispatcher_benchmarkTick4() { tickDispatcher_benchmarkTick(4); }
+static void tickDispatcher_benchmarkTick5() { tickDispatcher_benchmarkTick(5); }
+static void tickDispatcher_benchmarkTick6() { tickDispatcher_benchmarkTick(6); }
+
+static const tickDispatcher_tickFunction_t
+    tickDispatcher_benchmarkTicks[TICK_DISPATCHER_BENCHMARK_MODULE_COUNT] = {
+        tickDispatcher_benchmarkTick0, tickDispatcher_benchmarkTick1,
+        tickDispatcher_benchmarkTick2, tickDispatcher_benchmarkTick3,
+        tickDispatcher_benchmarkTick4, tickDispatcher_benchmarkTick5,
+        tickDispatcher_benchmarkTick6};
+
+// Returns the nanoseconds per tick of calling every state machine.
+static double tickDispatcher_benchmarkDirect() {
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t i = 0; i < TICK_DISPATCHER_BENCHMARK_TICK_COUNT; i++)
+    for (uint16_t m = 0; m < TICK_DISPATCHER_BENCHMARK_MODULE_COUNT; m++)
+      tickDispatcher_benchmarkTicks[m]();
+  return benchmark_elapsedNanoseconds(start, benchmark_now()) /
+         TICK_DISPATCHER_BENCHMARK_TICK_COUNT;
+}
+
+// Returns the nanoseconds per tick of dispatching the state machines with the
+// first busyCount of them busy.
+static double tickDispatcher_benchmarkDispatched(uint16_t busyCount) {
+  tickDispatcher_init();
+  for (uint16_t m = 0; m < TICK_DISPATCHER_BENCHMARK_MODULE_COUNT; m++) {
+    tickDispatcher_benchmarkIds[m] =
+        tickDispatcher_register("benchmark", tickDispatcher_benchmarkTicks[m]);
+    tickDispatcher_benchmarkStates[m] = m < busyCount
+                                            ? tickDispatcher_benchmarkBusy_st
+                                            : tickDispatcher_benchmarkIdle_st;
+    if (m < busyCount)
+      tickDispatcher_arm(tickDispatcher_benchmarkIds[m], 1);
+  }
+  benchmark_timestamp_t start = benchmark_now();
+  for (uint32_t i = 0; i < TICK_DISPATCHER_BENCHMARK_TICK_COUNT; i++)
+    tickDispatcher_tick();
+  return benchmark_elapsedNanoseconds(start, benchmark_now()) /
+         TICK_DISPATCHER_BENCHMARK_TICK_COUNT;
+}
+
+// Prints the time per tick of both approaches.
+void tickDispatcher_runBenchmark() {
+  printf("Nanoseconds per 100 kHz tick for %d state machines:\n",
+         TICK_DISPATCHER_BENCHMARK_MODULE_COUNT);
+  for (uint16_t m = 0; m < TICK_DISPATCHER_BENCHMARK_MODULE_COUNT; m++)
+    tickDispatcher_benchmarkStates[m] = tickDispatcher_benchmarkIdle_st;
+  printf("  all called every tick:    %7.1lf\n",
+         tickDispatcher_benchmarkDirect());
+  const uint16_t busyCounts[] = {0, 1, TICK_DISPATCHER_BENCHMARK_MODULE_COUNT};
+  for (uint16_t i = 0; i < sizeof(busyCounts) / sizeof(busyCounts[0]); i++)
+    printf("  dispatched, %u busy:       %7.1lf\n", busyCounts[i],
+           tickDispatcher_benchmarkDispatched(busyCounts[i]));
+  tickDispatcher_init();
+}
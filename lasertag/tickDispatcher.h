@@ -0,0 +1,94 @@
+/*
+This software is provided for student assignment use in the Department of
+Electrical and Computer Engineering, Brigham Young University, Utah, USA.
+Users agree to not re-host, or redistribute the software, in source or binary
+form, to other persons or other institutions. Users may modify and use the
+source code for personal or educational use.
+For questions, contact Brad Hutchings or Jeff Goeders, https://ece.byu.edu/
+*/
+
+#ifndef TICKDISPATCHER_H_
+#define TICKDISPATCHER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Calls the tick functions of the lasertag state machines only when they are
+// due, instead of calling every one of them from isr_function() on every
+// 100 kHz tick, idle or not.
+//
+// A module registers its tick function once (in its init function) and then
+// arms itself with the number of ticks until it next needs to run, e.g., in
+// its start function or from its own tick function. Arming is one-shot: a
+// module that was called is disarmed and must arm itself again to be called
+// again. A module that is busy every tick re-arms with a delay of 1; a timer
+// can arm once with its full duration.
+//
+// isr_function() calls tickDispatcher_tick() once per tick in place of the
+// individual _tick() functions, and isr_init() calls tickDispatcher_init()
+// before the module inits. Modules can be moved over one at a time: a tick
+// function that is still called directly does no harm, since the state
+// machines already expect to be ticked when there is nothing to do.
+//
+// The armed modules are kept in a hashed timer wheel of
+// TICK_DISPATCHER_WHEEL_SIZE slots, indexed by the low bits of the tick count
+// at which they are due. Longer delays wrap around the wheel and are skipped
+// until their tick comes. A tick with nothing due costs an increment and a
+// slot check.
+//
+// tickDispatcher_arm() and tickDispatcher_disarm() may be called from the
+// main loop or from a tick function. From the main loop they only record a
+// request and set a bit in a pending mask (with an atomic OR); the ISR applies
+// the requests at the start of the next tick. From a tick function they
+// change the wheel directly. So the wheel is only ever modified by the ISR and
+// no interrupts need to be disabled. The modules due at the same tick are
+// taken out of the wheel before any of them is called, so disarming one of
+// them from another's tick function has no effect until the next arming.
+
+#define TICK_DISPATCHER_MAX_MODULE_COUNT 16 // Bits of the pending mask.
+#define TICK_DISPATCHER_WHEEL_SIZE 256      // Power of two, 2.56 ms.
+
+typedef int16_t tickDispatcher_id_t; // -1 if a module could not register.
+
+typedef void (*tickDispatcher_tickFunction_t)();
+
+// Removes all modules and sets the tick count to 0. Call before the modules
+// register and before interrupts are enabled.
+void tickDispatcher_init();
+
+// Registers a module. It is not armed. Returns its id, or -1 if
+// TICK_DISPATCHER_MAX_MODULE_COUNT modules are already registered. A tick
+// function that is already registered keeps its id, so inits can be called
+// again.
+tickDispatcher_id_t tickDispatcher_register(const char *name,
+                                            tickDispatcher_tickFunction_t tick);
+
+// Calls the module's tick function delayTicks ticks from now (at least 1),
+// once. Replaces an earlier arming of the same module. Does nothing for an id
+// of -1.
+void tickDispatcher_arm(tickDispatcher_id_t id, uint32_t delayTicks);
+
+// Cancels the arming of a module.
+void tickDispatcher_disarm(tickDispatcher_id_t id);
+
+// ISR only. Advances the tick count, applies the pending arm and disarm
+// requests and calls the modules that are due.
+void tickDispatcher_tick();
+
+// Returns the number of ticks since tickDispatcher_init().
+uint32_t tickDispatcher_getTickCount();
+
+// Returns how many times a module's tick function was called.
+uint32_t tickDispatcher_getCallCount(tickDispatcher_id_t id);
+
+// Checks one-shot and repeated arming, long delays that wrap the wheel,
+// re-arming and disarming, against the tick count. Returns true if the test
+// passes.
+bool tickDispatcher_runTest();
+
+// Compares the time per tick of calling 7 idle state machines unconditionally
+// (as isr_function() does) with dispatching them, with 0, 1 and all 7 of them
+// busy every tick, and prints the results.
+void tickDispatcher_runBenchmark();
+
+#endif /* TICKDISPATCHER_H_ */